@@ -26,12 +26,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -285,10 +292,32 @@ struct TracingVendorHalCategory {
           : name(std::move(name)), description(std::move(description)), enabled(enabled) {}
 };
 
+/* Extra per-CPU trace buffer space for categories with a high event rate, added with
+ * --size_by_categories */
+struct TracingCategoryBufferHint {
+    const char* name;
+    int extraBufferSizeKB;
+};
+
+static const TracingCategoryBufferHint k_categoryBufferHints[] = {
+    { "sched",          4096 },
+    { "irq",            2048 },
+    { "binder_driver",  2048 },
+    { "workq",          2048 },
+    { "freq",           1024 },
+    { "gfx",            1024 },
+    { "input",          512 },
+    { "memreclaim",     512 },
+};
+
+/* The largest buffer size the category hints add up to, per CPU */
+static const int k_maxHintedTraceBufferSizeKB = 32 * 1024;
+
 /* Command line options */
 static int g_traceDurationSeconds = 5;
 static bool g_traceOverwrite = false;
 static int g_traceBufferSizeKB = 2048;
+static bool g_traceBufferSizeByCategories = false;
 static bool g_compress = false;
 static bool g_nohup = false;
 static int g_initialSleepSecs = 0;
@@ -858,6 +887,24 @@ static void cleanUpUserspaceTracing()
 }
 
 
+// Get the per-CPU trace buffer size to use: the one given with -b, plus the
+// hints of the enabled categories with --size_by_categories.
+static int getTraceBufferSizeKB()
+{
+    if (!g_traceBufferSizeByCategories) {
+        return g_traceBufferSizeKB;
+    }
+    int size = g_traceBufferSizeKB;
+    for (const TracingCategoryBufferHint& hint : k_categoryBufferHints) {
+        for (size_t i = 0; i < arraysize(k_categories); i++) {
+            if (g_categoryEnables[i] && strcmp(hint.name, k_categories[i].name) == 0) {
+                size += hint.extraBufferSizeKB;
+            }
+        }
+    }
+    return std::min(size, std::max(g_traceBufferSizeKB, k_maxHintedTraceBufferSizeKB));
+}
+
 // Set all the kernel tracing settings to the desired state for this trace
 // capture.
 static bool setUpKernelTracing()
@@ -869,7 +916,7 @@ static bool setUpKernelTracing()
     // Set up the tracing options.
     ok &= setCategoriesEnableFromFile(g_categoriesFile);
     ok &= setTraceOverwriteEnable(g_traceOverwrite);
-    ok &= setTraceBufferSizeKB(g_traceBufferSizeKB);
+    ok &= setTraceBufferSizeKB(getTraceBufferSizeKB());
     // TODO: Re-enable after stabilization
     //ok &= setCmdlineSize();
     ok &= setClock();
@@ -938,21 +985,204 @@ static void stopTrace()
     setTracingEnabled(false);
 }
 
-// Read data from the tracing pipe and forward to stdout
-static void streamTrace()
+// Move data from the tracing pipe to outFd within the kernel, without copying
+// it through userspace. Returns false if splice is not supported for these
+// files, in which case no data was moved.
+static bool spliceTrace(int traceFD, int outFd)
+{
+    // One end of a splice must be a pipe. When outFd is one, e.g. with adb
+    // shell, trace data goes straight to it.
+    struct stat st;
+    const bool outIsPipe = fstat(outFd, &st) == 0 && S_ISFIFO(st.st_mode);
+    int pipeFds[2] = { -1, -1 };
+    if (!outIsPipe && pipe2(pipeFds, O_CLOEXEC) == -1) {
+        return false;
+    }
+    const int spliceFd = outIsPipe ? outFd : pipeFds[1];
+
+    bool moved = false;
+    bool supported = true;
+    bool spliceOut = true;
+    while (!g_traceAborted) {
+        ssize_t bytes = splice(traceFD, nullptr, spliceFd, nullptr, 64 * 1024, SPLICE_F_MOVE);
+        if (bytes <= 0) {
+            if (bytes < 0 && !moved && errno == EINVAL) {
+                supported = false;
+            } else if (!g_traceAborted) {
+                fprintf(stderr, "splice returned %zd bytes err %d (%s)\n",
+                        bytes, errno, strerror(errno));
+            }
+            break;
+        }
+        moved = true;
+        while (!outIsPipe && bytes > 0) {
+            ssize_t written = -1;
+            if (spliceOut) {
+                written = splice(pipeFds[0], nullptr, outFd, nullptr, bytes, SPLICE_F_MOVE);
+                // Not every output supports splice, e.g. a tty. Copy the data
+                // out of the pipe for those.
+                spliceOut = written != -1 || errno != EINVAL;
+            }
+            if (!spliceOut) {
+                char buf[4096];
+                written = read(pipeFds[0], buf, std::min<size_t>(bytes, sizeof(buf)));
+                if (written > 0 && !android::base::WriteFully(outFd, buf, written)) {
+                    written = -1;
+                }
+            }
+            if (written <= 0) {
+                fprintf(stderr, "error writing trace: %s\n", strerror(errno));
+                g_traceAborted = true;
+                break;
+            }
+            bytes -= written;
+        }
+    }
+
+    if (!outIsPipe) {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+    }
+    return supported;
+}
+
+// The most chunks of trace data waiting to be compressed. Past that, reading
+// the tracing pipe waits for compression and the kernel buffer takes the slack.
+static const size_t k_maxQueuedTraceChunks = 64;
+
+// Trace data read from the tracing pipe, waiting to be compressed.
+struct TraceChunkQueue {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable spaceCondition;
+    std::deque<std::vector<char>> chunks;
+    bool done = false;
+    bool failed = false;
+};
+
+// Deflate the chunks of queue to outFd until the queue is done, so that the
+// thread reading the tracing pipe never waits for compression.
+static void deflateTraceChunks(TraceChunkQueue* queue, int outFd)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int result = deflateInit(&zs, Z_DEFAULT_COMPRESSION);
+    if (result != Z_OK) {
+        fprintf(stderr, "error initializing zlib: %d\n", result);
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->failed = true;
+        queue->spaceCondition.notify_one();
+        return;
+    }
+
+    std::vector<uint8_t> out(64 * 1024);
+    bool finish = false;
+    while (!finish) {
+        std::vector<char> chunk;
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->condition.wait(lock, [queue] { return queue->done || !queue->chunks.empty(); });
+            if (!queue->chunks.empty()) {
+                chunk = std::move(queue->chunks.front());
+                queue->chunks.pop_front();
+                queue->spaceCondition.notify_one();
+            }
+            finish = queue->done && queue->chunks.empty();
+        }
+
+        zs.next_in = reinterpret_cast<Bytef*>(chunk.data());
+        zs.avail_in = chunk.size();
+        do {
+            zs.next_out = out.data();
+            zs.avail_out = out.size();
+            result = deflate(&zs, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (result == Z_STREAM_ERROR) {
+                fprintf(stderr, "error deflating trace: %s\n", zs.msg);
+                finish = true;
+                break;
+            }
+            const size_t bytes = out.size() - zs.avail_out;
+            if (bytes > 0 && !android::base::WriteFully(outFd, out.data(), bytes)) {
+                fprintf(stderr, "error writing deflated trace: %s (%d)\n",
+                        strerror(errno), errno);
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->failed = true;
+                queue->spaceCondition.notify_one();
+                finish = true;
+                break;
+            }
+        } while (zs.avail_out == 0);
+    }
+
+    result = deflateEnd(&zs);
+    if (result != Z_OK && result != Z_DATA_ERROR) {
+        fprintf(stderr, "error cleaning up zlib: %d\n", result);
+    }
+}
+
+// Read data from the tracing pipe and forward it to outFd, compressed on a
+// background thread. Reading only waits for compression once
+// k_maxQueuedTraceChunks are pending.
+static void streamCompressedTrace(int traceFD, int outFd)
+{
+    TraceChunkQueue queue;
+    std::thread deflater(deflateTraceChunks, &queue, outFd);
+    while (!g_traceAborted) {
+        std::vector<char> chunk(64 * 1024);
+        ssize_t bytes_read = read(traceFD, chunk.data(), chunk.size());
+        if (bytes_read <= 0) {
+            if (!g_traceAborted) {
+                fprintf(stderr, "read returned %zd bytes err %d (%s)\n",
+                        bytes_read, errno, strerror(errno));
+            }
+            break;
+        }
+        chunk.resize(bytes_read);
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.spaceCondition.wait(lock, [&queue] {
+            return queue.failed || queue.chunks.size() < k_maxQueuedTraceChunks;
+        });
+        if (queue.failed) {
+            break;
+        }
+        queue.chunks.push_back(std::move(chunk));
+        queue.condition.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.done = true;
+        queue.condition.notify_one();
+    }
+    deflater.join();
+}
+
+// Read data from the tracing pipe and forward to outFd
+static void streamTrace(int outFd)
 {
-    char trace_data[4096];
     int traceFD = open((g_traceFolder + k_traceStreamPath).c_str(), O_RDWR);
     if (traceFD == -1) {
         fprintf(stderr, "error opening %s: %s (%d)\n", k_traceStreamPath,
                 strerror(errno), errno);
         return;
     }
+    if (g_compress) {
+        streamCompressedTrace(traceFD, outFd);
+        close(traceFD);
+        return;
+    }
+    if (spliceTrace(traceFD, outFd)) {
+        close(traceFD);
+        return;
+    }
+
+    char trace_data[4096];
     while (!g_traceAborted) {
         ssize_t bytes_read = read(traceFD, trace_data, 4096);
         if (bytes_read > 0) {
-            write(STDOUT_FILENO, trace_data, bytes_read);
-            fflush(stdout);
+            if (!android::base::WriteFully(outFd, trace_data, bytes_read)) {
+                fprintf(stderr, "error writing trace: %s\n", strerror(errno));
+                break;
+            }
         } else {
             if (!g_traceAborted) {
                 fprintf(stderr, "read returned %zd bytes err %d (%s)\n",
@@ -961,6 +1191,7 @@ static void streamTrace()
             break;
         }
     }
+    close(traceFD);
 }
 
 // Read the current kernel trace and write it to stdout.
@@ -1109,7 +1340,7 @@ static void showHelp(const char *cmd)
     fprintf(stderr, "options include:\n"
                     "  -a appname      enable app-level tracing for a comma "
                         "separated list of cmdlines; * is a wildcard matching any process\n"
-                    "  -b N            use a trace buffer size of N KB\n"
+                    "  -b N            use a trace buffer size of N KB per CPU [default: 2048]\n"
                     "  -c              trace into a circular buffer\n"
                     "  -f filename     use the categories written in a file as space-separated\n"
                     "                    values in a line\n"
@@ -1117,12 +1348,16 @@ static void showHelp(const char *cmd)
                     "  -n              ignore signals\n"
                     "  -s N            sleep for N seconds before tracing [default 0]\n"
                     "  -t N            trace for N seconds [default 5]\n"
-                    "  -z              compress the trace dump\n"
+                    "  -z              compress the trace dump, or the stream\n"
                     "  --async_start   start circular trace and return immediately\n"
                     "  --async_dump    dump the current contents of circular trace buffer\n"
                     "  --async_stop    stop tracing and dump the current contents of circular\n"
                     "                    trace buffer\n"
-                    "  --stream        stream trace to stdout as it enters the trace buffer\n"
+                    "  --size_by_categories\n"
+                    "                  add trace buffer space for each enabled category with\n"
+                    "                    many events, up to 32 MB per CPU\n"
+                    "  --stream        stream trace to stdout, or the file given with -o, as it\n"
+                    "                    enters the trace buffer\n"
                     "                    Note: this can take significant CPU time, and is best\n"
                     "                    used for measuring things that are not affected by\n"
                     "                    CPU performance, like pagecache usage.\n"
@@ -1296,6 +1531,7 @@ int main(int argc, char **argv)
             {"only_userspace",    no_argument, nullptr,  0 },
             {"list_categories",   no_argument, nullptr,  0 },
             {"stream",            no_argument, nullptr,  0 },
+            {"size_by_categories", no_argument, nullptr, 0 },
             {nullptr,                       0, nullptr,  0 }
         };
 
@@ -1368,6 +1604,8 @@ int main(int argc, char **argv)
                 } else if (!strcmp(long_options[option_index].name, "stream")) {
                     traceStream = true;
                     traceDump = false;
+                } else if (!strcmp(long_options[option_index].name, "size_by_categories")) {
+                    g_traceBufferSizeByCategories = true;
                 } else if (!strcmp(long_options[option_index].name, "list_categories")) {
                     listSupportedCategories();
                     exit(0);
@@ -1437,7 +1675,18 @@ int main(int argc, char **argv)
         }
 
         if (traceStream) {
-            streamTrace();
+            int outFd = STDOUT_FILENO;
+            if (g_outputFile) {
+                outFd = open(g_outputFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            }
+            if (outFd == -1) {
+                fprintf(stderr, "Failed to open '%s', err=%d\n", g_outputFile, errno);
+            } else {
+                streamTrace(outFd);
+                if (g_outputFile) {
+                    close(outFd);
+                }
+            }
         }
     }
 
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "dumpstate"
+
+#include "SectionScheduler.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <android-base/unique_fd.h>
+#include <log/log.h>
+
+#include "DumpPool.h"
+#include "dumpstate.h"
+#include "DumpstateInternal.h"
+#include "DumpstateUtil.h"
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+const std::array<int, SectionScheduler::RESOURCE_COUNT> SectionScheduler::DEFAULT_LIMITS = {
+    2,  // CPU
+    2,  // IO
+    2,  // BINDER
+};
+
+static size_t ResourceIndex(SectionScheduler::Resource resource) {
+    return static_cast<size_t>(resource);
+}
+
+SectionScheduler::SectionScheduler(const std::string& tmp_root,
+                                   const std::array<int, RESOURCE_COUNT>& limits)
+    : tmp_root_(tmp_root), limits_(limits), running_{}, started_(false), shutdown_(false) {
+    for (int& limit : limits_) {
+        if (limit < 1) {
+            limit = 1;
+        }
+    }
+}
+
+SectionScheduler::~SectionScheduler() {
+    std::unique_lock lock(lock_);
+    shutdown_ = true;
+    condition_variable_.notify_all();
+    lock.unlock();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+    for (const auto& section : sections_) {
+        if (!section->tmp_path.empty() && unlink(section->tmp_path.c_str())) {
+            MYLOGE("Failed to unlink (%s): %s\n", section->tmp_path.c_str(), strerror(errno));
+        }
+    }
+}
+
+void SectionScheduler::add(const std::string& title, Resource resource,
+                           std::chrono::milliseconds timeout, std::function<void(int)> dump_func,
+                           const std::vector<std::string>& depends_on) {
+    std::unique_lock lock(lock_);
+    assert(!started_);
+    if (section_indices_.count(title)) {
+        MYLOGE("Section %s added twice\n", title.c_str());
+        return;
+    }
+    auto section = std::make_unique<Section>();
+    section->title = title;
+    section->resource = resource;
+    section->timeout = timeout;
+    section->dump_func = std::move(dump_func);
+    for (const std::string& dependency : depends_on) {
+        auto it = section_indices_.find(dependency);
+        if (it == section_indices_.end()) {
+            MYLOGE("Section %s depends on unknown section %s\n", title.c_str(),
+                   dependency.c_str());
+            continue;
+        }
+        section->depends_on.push_back(it->second);
+    }
+    section_indices_[title] = sections_.size();
+    sections_.push_back(std::move(section));
+}
+
+void SectionScheduler::start() {
+    std::unique_lock lock(lock_);
+    assert(!started_);
+    if (tmp_root_.empty()) {
+        MYLOGE("No temporary folder, running sections serially\n");
+        return;
+    }
+    started_ = true;
+    int thread_counts = 0;
+    for (int limit : limits_) {
+        thread_counts += limit;
+    }
+    MYLOGI("Start section scheduler:%d\n", thread_counts);
+    for (int i = 0; i < thread_counts; i++) {
+        startThreadLocked();
+    }
+}
+
+void SectionScheduler::writeSection(const std::string& title, int out_fd) {
+    std::unique_lock lock(lock_);
+    auto it = section_indices_.find(title);
+    if (it == section_indices_.end()) {
+        MYLOGE("Unknown section %s\n", title.c_str());
+        return;
+    }
+    Section* section = sections_[it->second].get();
+
+    if (!started_) {
+        if (section->state != State::PENDING) {
+            MYLOGE("Section %s written twice\n", title.c_str());
+            return;
+        }
+        section->state = State::WRITTEN;
+        lock.unlock();
+        std::invoke(section->dump_func, out_fd);
+        return;
+    }
+
+    DurationReporter duration_reporter("Wait for " + title, true);
+    while (true) {
+        switch (section->state) {
+            case State::PENDING:
+                condition_variable_.wait(lock);
+                continue;
+            case State::RUNNING:
+                if (condition_variable_.wait_until(lock, section->start_time + section->timeout) ==
+                            std::cv_status::timeout &&
+                    section->state == State::RUNNING) {
+                    timeOutLocked(section);
+                }
+                continue;
+            case State::DONE:
+                break;
+            case State::TIMED_OUT:
+                dprintf(out_fd, "*** %s: timed out after %.3fs, output dropped\n", title.c_str(),
+                        section->timeout.count() / 1000.0f);
+                return;
+            case State::SKIPPED:
+                dprintf(out_fd, "*** %s: skipped, a section it depends on did not finish\n",
+                        title.c_str());
+                return;
+            case State::WRITTEN:
+                MYLOGE("Section %s written twice\n", title.c_str());
+                return;
+        }
+        break;
+    }
+
+    section->state = State::WRITTEN;
+    std::string path = std::move(section->tmp_path);
+    section->tmp_path.clear();
+    lock.unlock();
+
+    if (path.empty()) {
+        return;
+    }
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (fd.get() < 0) {
+        dprintf(out_fd, "*** Error dumping %s: %s\n", title.c_str(), strerror(errno));
+    } else {
+        // The section already honored dry runs when it ran.
+        DumpFileFromFdToFd("", path, fd.get(), out_fd, /* dry_run = */ false);
+    }
+    if (unlink(path.c_str())) {
+        MYLOGE("Failed to unlink (%s): %s\n", path.c_str(), strerror(errno));
+    }
+}
+
+SectionScheduler::Section* SectionScheduler::nextRunnableLocked() {
+    if (shutdown_) {
+        return nullptr;
+    }
+    for (const auto& section : sections_) {
+        if (section->state != State::PENDING) {
+            continue;
+        }
+        bool ready = true;
+        for (size_t dependency : section->depends_on) {
+            State state = sections_[dependency]->state;
+            if (state == State::TIMED_OUT || state == State::SKIPPED) {
+                section->state = State::SKIPPED;
+                condition_variable_.notify_all();
+                ready = false;
+                break;
+            }
+            if (state != State::DONE && state != State::WRITTEN) {
+                ready = false;
+            }
+        }
+        if (ready && running_[ResourceIndex(section->resource)] <
+                limits_[ResourceIndex(section->resource)]) {
+            return section.get();
+        }
+    }
+    return nullptr;
+}
+
+bool SectionScheduler::hasPendingLocked() const {
+    for (const auto& section : sections_) {
+        if (section->state == State::PENDING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SectionScheduler::timeOutLocked(Section* section) {
+    MYLOGE("Section %s timed out after %lldms\n", section->title.c_str(),
+           static_cast<long long>(section->timeout.count()));
+    section->state = State::TIMED_OUT;
+    // The thread running it stays busy until it returns. Give its slot to the next section, on a
+    // new thread, so that the rest of the bugreport doesn't wait for it.
+    running_[ResourceIndex(section->resource)]--;
+    startThreadLocked();
+    condition_variable_.notify_all();
+}
+
+std::string SectionScheduler::runSection(const Section& section) {
+    std::string path = tmp_root_ + "/" + DumpPool::PREFIX_TMPFILE_NAME + "XXXXXX";
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(mkostemp(path.data(), O_CLOEXEC)));
+    if (fd.get() == -1) {
+        MYLOGE("open(%s, %s)\n", path.c_str(), strerror(errno));
+        return "";
+    }
+    std::invoke(section.dump_func, fd.get());
+    fsync(fd.get());
+    return path;
+}
+
+void SectionScheduler::startThreadLocked() {
+    int id = threads_.size() + 1;
+    threads_.emplace_back([this, id]() {
+        std::array<char, 15> name;
+        snprintf(name.data(), name.size(), "dumpsection_%d", id);
+        pthread_setname_np(pthread_self(), name.data());
+        loop();
+    });
+}
+
+void SectionScheduler::loop() {
+    std::unique_lock lock(lock_);
+    while (true) {
+        Section* section = nextRunnableLocked();
+        if (section == nullptr) {
+            if (shutdown_ || !hasPendingLocked()) {
+                return;
+            }
+            condition_variable_.wait(lock);
+            continue;
+        }
+        section->state = State::RUNNING;
+        section->start_time = std::chrono::steady_clock::now();
+        running_[ResourceIndex(section->resource)]++;
+        lock.unlock();
+
+        std::string path = runSection(*section);
+
+        lock.lock();
+        if (section->state == State::TIMED_OUT) {
+            if (!path.empty() && unlink(path.c_str())) {
+                MYLOGE("Failed to unlink (%s): %s\n", path.c_str(), strerror(errno));
+            }
+            // Once another thread took over its slot, this one is surplus.
+            return;
+        }
+        section->state = State::DONE;
+        section->tmp_path = std::move(path);
+        running_[ResourceIndex(section->resource)]--;
+        condition_variable_.notify_all();
+    }
+}
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORK_NATIVE_CMD_SECTIONSCHEDULER_H_
+#define FRAMEWORK_NATIVE_CMD_SECTIONSCHEDULER_H_
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+/*
+ * Runs bugreport sections concurrently, while their output is still written to
+ * the bugreport in the order dumpstate asks for it. Each section declares the
+ * resource it mostly uses, and at most a fixed number of sections of each
+ * resource run at the same time, so that e.g. several binder-heavy dumpsys
+ * calls don't slow each other down. A section can depend on sections added
+ * before it, and only starts once they have finished.
+ *
+ * void DumpFoo(int out_fd) {
+ *     dprintf(out_fd, "Dump result to out_fd ...");
+ * }
+ * ...
+ * SectionScheduler scheduler(tmp_root);
+ * scheduler.add("FOO", SectionScheduler::Resource::IO, 10s, &DumpFoo);
+ * scheduler.start();
+ * ...
+ * scheduler.writeSection("FOO", STDOUT_FILENO);
+ *
+ * Sections run in the background into temporary files once start() is called.
+ * Without start(), writeSection() runs the section on the calling thread, which
+ * is how the same code runs serially when parallel runs are disabled.
+ */
+class SectionScheduler {
+  public:
+    enum class Resource {
+        CPU,
+        IO,
+        BINDER,
+    };
+    static const size_t RESOURCE_COUNT = 3;
+
+    /*
+     * The default number of sections of each resource that run at the same
+     * time, indexed by Resource.
+     */
+    static const std::array<int, RESOURCE_COUNT> DEFAULT_LIMITS;
+
+    /*
+     * |tmp_root| A path to a temporary folder to write the sections to.
+     * |limits| The number of sections of each resource that run at the same
+     * time, indexed by Resource.
+     */
+    explicit SectionScheduler(const std::string& tmp_root,
+                              const std::array<int, RESOURCE_COUNT>& limits = DEFAULT_LIMITS);
+
+    /*
+     * Cancels sections which have not started, and waits for the running ones
+     * to return.
+     */
+    ~SectionScheduler();
+
+    /*
+     * Adds a section. Must be called before start().
+     *
+     * |title| The name of the section, unique within this scheduler.
+     * |resource| What the section mostly uses.
+     * |timeout| How long writeSection() waits for the section once it started
+     * running. The output of a section which takes longer is dropped.
+     * |dump_func| Writes the section to the fd it is given.
+     * |depends_on| Titles of previously added sections which must finish before
+     * this one starts. The section is skipped if one of them timed out.
+     */
+    void add(const std::string& title, Resource resource, std::chrono::milliseconds timeout,
+             std::function<void(int)> dump_func, const std::vector<std::string>& depends_on = {});
+
+    /*
+     * Starts running the added sections in the background. Does nothing if
+     * there is no temporary folder.
+     */
+    void start();
+
+    /*
+     * Waits until the section is done and writes its output to out_fd, or runs
+     * it on out_fd if start() was not called. Each section is written once.
+     */
+    void writeSection(const std::string& title, int out_fd);
+
+  private:
+    enum class State {
+        PENDING,
+        RUNNING,
+        DONE,
+        TIMED_OUT,
+        SKIPPED,
+        WRITTEN,
+    };
+
+    struct Section {
+        std::string title;
+        Resource resource;
+        std::chrono::milliseconds timeout;
+        std::function<void(int)> dump_func;
+        std::vector<size_t> depends_on;
+        State state = State::PENDING;
+        std::chrono::steady_clock::time_point start_time;
+        std::string tmp_path;
+    };
+
+    Section* nextRunnableLocked();
+    bool hasPendingLocked() const;
+    void timeOutLocked(Section* section);
+    std::string runSection(const Section& section);
+    void startThreadLocked();
+    void loop();
+
+    std::string tmp_root_;
+    std::array<int, RESOURCE_COUNT> limits_;
+    std::array<int, RESOURCE_COUNT> running_;
+    bool started_;
+    bool shutdown_;
+    std::mutex lock_;  // A lock for sections_ and running_.
+    std::condition_variable condition_variable_;
+
+    std::vector<std::unique_ptr<Section>> sections_;
+    std::map<std::string, size_t> section_indices_;
+    std::vector<std::thread> threads_;
+
+    DISALLOW_COPY_AND_ASSIGN(SectionScheduler);
+};
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
+
+#endif //FRAMEWORK_NATIVE_CMD_SECTIONSCHEDULER_H_
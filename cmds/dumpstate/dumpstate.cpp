@@ -55,6 +55,7 @@
 #include <regex>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -94,6 +95,7 @@
 #include <vintf/VintfObject.h>
 #include "DumpstateInternal.h"
 #include "DumpstateService.h"
+#include "SectionScheduler.h"
 #include "dumpstate.h"
 
 namespace dumpstate_hal_hidl_1_0 = android::hardware::dumpstate::V1_0;
@@ -123,6 +125,7 @@ using android::os::dumpstate::CommandOptions;
 using android::os::dumpstate::DumpFileToFd;
 using android::os::dumpstate::DumpPool;
 using android::os::dumpstate::PropertiesHelper;
+using android::os::dumpstate::SectionScheduler;
 using android::os::dumpstate::TaskQueue;
 using android::os::dumpstate::WaitForTask;
 
@@ -360,8 +363,9 @@ static void RunDumpsys(const std::string& title, const std::vector<std::string>&
                        int out_fd) {
     return ds.RunDumpsys(title, dumpsysArgs, Dumpstate::DEFAULT_DUMPSYS, 0, out_fd);
 }
-static int DumpFile(const std::string& title, const std::string& path) {
-    return ds.DumpFile(title, path);
+static int DumpFile(const std::string& title, const std::string& path,
+                    int out_fd = STDOUT_FILENO) {
+    return ds.DumpFile(title, path, out_fd);
 }
 
 // Relative directory (inside the zip) for all files copied as-is into the bugreport.
@@ -837,7 +841,8 @@ static const std::set<std::string> PROBLEMATIC_FILE_EXTENSIONS = {
 };
 
 status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
-                                      std::chrono::milliseconds timeout = 0ms) {
+                                      std::chrono::milliseconds timeout = 0ms,
+                                      bool skip_if_empty) {
     std::string valid_name = entry_name;
 
     // Rename extension if necessary.
@@ -853,17 +858,27 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
 
     // Logging statement  below is useful to time how long each entry takes, but it's too verbose.
     // MYLOGD("Adding zip entry %s\n", entry_name.c_str());
-    size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
-    int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), flags,
-                                                  get_mtime(fd, ds.now_));
-    if (err != 0) {
-        MYLOGE("zip_writer_->StartEntryWithTime(%s): %s\n", valid_name.c_str(),
-               ZipWriter::ErrorCodeString(err));
+    bool started_entry = false;
+    auto start_entry = [this, &valid_name, &started_entry, fd] {
+        size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
+        int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), flags,
+                                                      get_mtime(fd, ds.now_));
+        if (err != 0) {
+            MYLOGE("zip_writer_->StartEntryWithTime(%s): %s\n", valid_name.c_str(),
+                   ZipWriter::ErrorCodeString(err));
+            return false;
+        }
+        started_entry = true;
+        return true;
+    };
+    // Empty entries are only skipped if nothing has been added yet when the fd reaches its end,
+    // so the entry starts with the first bytes read.
+    if (!skip_if_empty && !start_entry()) {
         return UNKNOWN_ERROR;
     }
     bool finished_entry = false;
-    auto finish_entry = [this, &finished_entry] {
-        if (!finished_entry) {
+    auto finish_entry = [this, &started_entry, &finished_entry] {
+        if (started_entry && !finished_entry) {
             // This should only be called when we're going to return an earlier error,
             // which would've been logged. This may imply the file is already corrupt
             // and any further logging from FinishEntry is more likely to mislead than
@@ -905,14 +920,20 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
             MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
             return -errno;
         }
-        err = zip_writer_->WriteBytes(buffer.data(), bytes_read);
+        if (!started_entry && !start_entry()) {
+            return UNKNOWN_ERROR;
+        }
+        int32_t err = zip_writer_->WriteBytes(buffer.data(), bytes_read);
         if (err) {
             MYLOGE("zip_writer_->WriteBytes(): %s\n", ZipWriter::ErrorCodeString(err));
             return UNKNOWN_ERROR;
         }
     }
 
-    err = zip_writer_->FinishEntry();
+    if (!started_entry) {
+        return NOT_ENOUGH_DATA;
+    }
+    int32_t err = zip_writer_->FinishEntry();
     finished_entry = true;
     if (err != 0) {
         MYLOGE("zip_writer_->FinishEntry(): %s\n", ZipWriter::ErrorCodeString(err));
@@ -922,6 +943,30 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
     return OK;
 }
 
+status_t Dumpstate::AddZipEntryFromDumpFunc(const std::string& entry_name,
+                                            std::function<void(int)> dump_func,
+                                            std::chrono::milliseconds timeout) {
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+        MYLOGE("pipe2(%s): %s\n", entry_name.c_str(), strerror(errno));
+        return -errno;
+    }
+    android::base::unique_fd read_fd(pipe_fds[0]);
+    android::base::unique_fd write_fd(pipe_fds[1]);
+
+    // The entry is compressed on this thread while dump_func is still producing it; the read end
+    // is closed before joining, so a dump_func that outlives the timeout gets EPIPE and returns.
+    std::thread producer([&dump_func, write_fd = std::move(write_fd)]() mutable {
+        std::invoke(dump_func, write_fd.get());
+        write_fd.reset();
+    });
+    status_t status = AddZipEntryFromFd(entry_name, read_fd.get(), timeout,
+                                        /* skip_if_empty = */ true);
+    read_fd.reset();
+    producer.join();
+    return status;
+}
+
 bool Dumpstate::AddZipEntry(const std::string& entry_name, const std::string& entry_path) {
     android::base::unique_fd fd(
         TEMP_FAILURE_RETRY(open(entry_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC)));
@@ -1038,45 +1083,21 @@ static void DoLogcat() {
 }
 
 static void DumpIncidentReport() {
-    const std::string path = ds.bugreport_internal_dir_ + "/tmp_incident_report";
-    auto fd = android::base::unique_fd(TEMP_FAILURE_RETRY(open(path.c_str(),
-                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
-                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
-    if (fd < 0) {
-        MYLOGE("Could not open %s to dump incident report.\n", path.c_str());
-        return;
-    }
-    RunCommandToFd(fd, "", {"incident", "-u"}, CommandOptions::WithTimeout(20).Build());
-    bool empty = 0 == lseek(fd, 0, SEEK_END);
-    if (!empty) {
-        // Use a different name from "incident.proto"
-        // /proto/incident.proto is reserved for incident service dump
-        // i.e. metadata for debugging.
-        ds.EnqueueAddZipEntryAndCleanupIfNeeded(kProtoPath + "incident_report" + kProtoExt,
-                path);
-    } else {
-        unlink(path.c_str());
-    }
+    // Use a different name from "incident.proto"
+    // /proto/incident.proto is reserved for incident service dump
+    // i.e. metadata for debugging.
+    ds.AddZipEntryFromDumpFuncOrEnqueue(kProtoPath + "incident_report" + kProtoExt,
+            ds.bugreport_internal_dir_ + "/tmp_incident_report", [](int fd) {
+        RunCommandToFd(fd, "", {"incident", "-u"}, CommandOptions::WithTimeout(20).Build());
+    });
 }
 
 static void DumpNetstatsProto() {
-    const std::string path = ds.bugreport_internal_dir_ + "/tmp_netstats_proto";
-    auto fd = android::base::unique_fd(TEMP_FAILURE_RETRY(open(path.c_str(),
-                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
-                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
-    if (fd < 0) {
-        MYLOGE("Could not open %s to dump netstats proto.\n", path.c_str());
-        return;
-    }
-    RunCommandToFd(fd, "", {"dumpsys", "netstats", "--proto"},
-            CommandOptions::WithTimeout(5).Build());
-    bool empty = 0 == lseek(fd, 0, SEEK_END);
-    if (!empty) {
-        ds.EnqueueAddZipEntryAndCleanupIfNeeded(kProtoPath + "netstats" + kProtoExt,
-                path);
-    } else {
-        unlink(path.c_str());
-    }
+    ds.AddZipEntryFromDumpFuncOrEnqueue(kProtoPath + "netstats" + kProtoExt,
+            ds.bugreport_internal_dir_ + "/tmp_netstats_proto", [](int fd) {
+        RunCommandToFd(fd, "", {"dumpsys", "netstats", "--proto"},
+                CommandOptions::WithTimeout(5).Build());
+    });
 }
 
 static void MaybeAddSystemTraceToZip() {
@@ -1095,23 +1116,14 @@ static void MaybeAddSystemTraceToZip() {
 
 static void DumpVisibleWindowViews() {
     DurationReporter duration_reporter("VISIBLE WINDOW VIEWS");
-    const std::string path = ds.bugreport_internal_dir_ + "/tmp_visible_window_views";
-    auto fd = android::base::unique_fd(TEMP_FAILURE_RETRY(open(path.c_str(),
-                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
-                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
-    if (fd < 0) {
-        MYLOGE("Could not open %s to dump visible views.\n", path.c_str());
-        return;
-    }
-    RunCommandToFd(fd, "", {"cmd", "window", "dump-visible-window-views"},
-                   CommandOptions::WithTimeout(10).Build());
-    bool empty = 0 == lseek(fd, 0, SEEK_END);
-    if (!empty) {
-        ds.AddZipEntry("visible_windows.zip", path);
-    } else {
+    // Always runs on the main thread, so stream it straight into the zip file.
+    status_t status = ds.AddZipEntryFromDumpFunc("visible_windows.zip", [](int fd) {
+        RunCommandToFd(fd, "", {"cmd", "window", "dump-visible-window-views"},
+                       CommandOptions::WithTimeout(10).Build());
+    }, /* timeout = */ 0ms);
+    if (status != OK) {
         MYLOGW("Failed to dump visible windows\n");
     }
-    unlink(path.c_str());
 }
 
 static void DumpIpTablesAsRoot() {
@@ -1423,30 +1435,13 @@ static void DumpHals(int out_fd = STDOUT_FILENO) {
                                     std::string("@-_:.").find(c) == std::string::npos;
                             }, '_');
             const std::string path = ds.bugreport_internal_dir_ + "/lshal_debug_" + cleanName;
-
-            bool empty = false;
-            {
-                auto fd = android::base::unique_fd(
-                    TEMP_FAILURE_RETRY(open(path.c_str(),
-                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
-                    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
-                if (fd < 0) {
-                    MYLOGE("Could not open %s to dump additional hal information.\n", path.c_str());
-                    continue;
-                }
+            ds.AddZipEntryFromDumpFuncOrEnqueue("lshal-debug/" + cleanName + ".txt", path,
+                    [&interface](int fd) {
                 RunCommandToFd(fd,
                         "",
                         {"lshal", "debug", "-E", interface},
                         CommandOptions::WithTimeout(2).AsRootIfAvailable().Build());
-
-                empty = 0 == lseek(fd, 0, SEEK_END);
-            }
-            if (!empty) {
-                ds.EnqueueAddZipEntryAndCleanupIfNeeded("lshal-debug/" + cleanName + ".txt",
-                        path);
-            } else {
-                unlink(path.c_str());
-            }
+            });
         }
     });
 
@@ -1621,6 +1616,81 @@ static void DumpAppInfos(int out_fd = STDOUT_FILENO) {
             DUMPSYS_COMPONENTS_OPTIONS, 0, out_fd);
 }
 
+// How much longer than its own timeout a section may take, e.g. for a command that ignores SIGTERM.
+static const auto SECTION_TIMEOUT_SLACK = 10s;
+
+// DumpFileFromFdToFd gives up on a file after 30s without data.
+static const auto DUMP_FILE_SECTION_TIMEOUT = 30s + SECTION_TIMEOUT_SLACK;
+
+// Sections of dumpstate() which only read kernel state, or run a standalone command, into the fd
+// they are given. When parallel runs are enabled they all start in the background up front, and
+// dumpstate() writes each one out where it used to run it, so the bugreport keeps its layout.
+static void AddDumpstateSections(SectionScheduler* sections) {
+    using Resource = SectionScheduler::Resource;
+    auto add_command = [sections](const std::string& title, Resource resource,
+                                  const std::vector<std::string>& full_command,
+                                  const CommandOptions& options = CommandOptions::DEFAULT) {
+        sections->add(title, resource,
+                      std::chrono::milliseconds(options.TimeoutInMs()) + SECTION_TIMEOUT_SLACK,
+                      [title, full_command, options](int out_fd) {
+                          RunCommand(title, full_command, options, false, out_fd);
+                      });
+    };
+    auto add_file = [sections](const std::string& title, const std::string& path,
+                               const std::vector<std::string>& depends_on = {}) {
+        sections->add(title, Resource::IO, DUMP_FILE_SECTION_TIMEOUT,
+                      [title, path](int out_fd) { DumpFile(title, path, out_fd); }, depends_on);
+    };
+    auto add_dumpsys = [sections](const std::string& title,
+                                  const std::vector<std::string>& dumpsys_args,
+                                  const CommandOptions& options = Dumpstate::DEFAULT_DUMPSYS) {
+        sections->add(title, Resource::BINDER,
+                      std::chrono::milliseconds(options.TimeoutInMs()) + SECTION_TIMEOUT_SLACK,
+                      [title, dumpsys_args, options](int out_fd) {
+                          RunDumpsys(title, dumpsys_args, options, 0, out_fd);
+                      });
+    };
+
+    add_command("UPTIME", Resource::CPU, {"uptime"});
+    add_file("MEMORY INFO", "/proc/meminfo");
+    add_command("CPU INFO", Resource::CPU, {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
+                                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"});
+    add_file("VIRTUAL MEMORY STATS", "/proc/vmstat");
+    add_file("VMALLOC INFO", "/proc/vmallocinfo");
+    add_file("SLAB INFO", "/proc/slabinfo");
+    add_file("ZONEINFO", "/proc/zoneinfo");
+    add_file("PAGETYPEINFO", "/proc/pagetypeinfo");
+    add_file("BUDDYINFO", "/proc/buddyinfo");
+    add_file("KERNEL CPUFREQ", "/sys/devices/system/cpu/cpu0/cpufreq/stats/time_in_state");
+    add_command("PROCESSES AND THREADS", Resource::CPU,
+                {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"});
+    add_command("PRINTENV", Resource::CPU, {"printenv"});
+    add_command("NETSTAT", Resource::IO, {"netstat", "-nW"});
+    add_command("LIST OF OPEN FILES", Resource::IO, {"lsof"}, CommandOptions::AS_ROOT);
+    add_dumpsys("EBPF MAP STATS", {"connectivity", "trafficcontroller"});
+    add_command("ARP CACHE", Resource::CPU, {"ip", "-4", "neigh", "show"});
+    add_command("IPv6 ND CACHE", Resource::CPU, {"ip", "-6", "neigh", "show"});
+    add_command("MULTICAST ADDRESSES", Resource::CPU, {"ip", "maddr"});
+    add_dumpsys("SERVICE HIGH connectivity", {"connectivity", "--dump-priority", "HIGH"},
+                CommandOptions::WithTimeout(10).Build());
+    add_command("SYSTEM PROPERTIES", Resource::CPU, {"getprop"});
+    add_command("STORAGED IO INFO", Resource::BINDER, {"storaged", "-u", "-p"});
+    add_command("FILESYSTEMS & FREE SPACE", Resource::IO, {"df"});
+
+    /* Binder state is expensive to look at as it uses a lot of memory, so only one of these
+     * runs at a time. */
+    std::string binder_logs_dir = access("/dev/binderfs/binder_logs", R_OK) ?
+            "/sys/kernel/debug/binder" : "/dev/binderfs/binder_logs";
+
+    add_file("BINDER FAILED TRANSACTION LOG", binder_logs_dir + "/failed_transaction_log");
+    add_file("BINDER TRANSACTION LOG", binder_logs_dir + "/transaction_log",
+             {"BINDER FAILED TRANSACTION LOG"});
+    add_file("BINDER TRANSACTIONS", binder_logs_dir + "/transactions",
+             {"BINDER TRANSACTION LOG"});
+    add_file("BINDER STATS", binder_logs_dir + "/stats", {"BINDER TRANSACTIONS"});
+    add_file("BINDER STATE", binder_logs_dir + "/state", {"BINDER STATS"});
+}
+
 // Dumps various things. Returns early with status USER_CONSENT_DENIED if user denies consent
 // via the consent they are shown. Ignores other errors that occur while running various
 // commands. The consent checking is currently done around long running tasks, which happen to
@@ -1628,6 +1698,12 @@ static void DumpAppInfos(int out_fd = STDOUT_FILENO) {
 Dumpstate::RunStatus Dumpstate::dumpstate() {
     DurationReporter duration_reporter("DUMPSTATE");
 
+    SectionScheduler sections(ds.bugreport_internal_dir_);
+    AddDumpstateSections(&sections);
+    if (ds.dump_pool_) {
+        sections.start();
+    }
+
     // Enqueue slow functions into the thread pool, if the parallel run is enabled.
     std::future<std::string> dump_hals, dump_incident_report, dump_board, dump_checkins,
             dump_netstats_report, post_process_ui_traces;
@@ -1652,29 +1728,27 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
     // check intermittently (if it's intrerruptable like a foreach on pids) and/or should be wrapped
     // in a consent check (via RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK).
     dump_dev_files("TRUSTY VERSION", "/sys/bus/platform/drivers/trusty", "trusty_version");
-    RunCommand("UPTIME", {"uptime"});
+    sections.writeSection("UPTIME", STDOUT_FILENO);
     DumpBlockStatFiles();
-    DumpFile("MEMORY INFO", "/proc/meminfo");
-    RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
-                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"});
+    sections.writeSection("MEMORY INFO", STDOUT_FILENO);
+    sections.writeSection("CPU INFO", STDOUT_FILENO);
 
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunCommand, "BUGREPORT_PROCDUMP", {"bugreport_procdump"},
                                          CommandOptions::AS_ROOT);
 
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(DumpVisibleWindowViews);
 
-    DumpFile("VIRTUAL MEMORY STATS", "/proc/vmstat");
-    DumpFile("VMALLOC INFO", "/proc/vmallocinfo");
-    DumpFile("SLAB INFO", "/proc/slabinfo");
-    DumpFile("ZONEINFO", "/proc/zoneinfo");
-    DumpFile("PAGETYPEINFO", "/proc/pagetypeinfo");
-    DumpFile("BUDDYINFO", "/proc/buddyinfo");
+    sections.writeSection("VIRTUAL MEMORY STATS", STDOUT_FILENO);
+    sections.writeSection("VMALLOC INFO", STDOUT_FILENO);
+    sections.writeSection("SLAB INFO", STDOUT_FILENO);
+    sections.writeSection("ZONEINFO", STDOUT_FILENO);
+    sections.writeSection("PAGETYPEINFO", STDOUT_FILENO);
+    sections.writeSection("BUDDYINFO", STDOUT_FILENO);
     DumpExternalFragmentationInfo();
 
-    DumpFile("KERNEL CPUFREQ", "/sys/devices/system/cpu/cpu0/cpufreq/stats/time_in_state");
+    sections.writeSection("KERNEL CPUFREQ", STDOUT_FILENO);
 
-    RunCommand("PROCESSES AND THREADS",
-               {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"});
+    sections.writeSection("PROCESSES AND THREADS", STDOUT_FILENO);
 
     if (ds.dump_pool_) {
         WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_hals));
@@ -1682,8 +1756,8 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
         RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_HALS_TASK, DumpHals);
     }
 
-    RunCommand("PRINTENV", {"printenv"});
-    RunCommand("NETSTAT", {"netstat", "-nW"});
+    sections.writeSection("PRINTENV", STDOUT_FILENO);
+    sections.writeSection("NETSTAT", STDOUT_FILENO);
     struct stat s;
     if (stat("/proc/modules", &s) != 0) {
         MYLOGD("Skipping 'lsmod' because /proc/modules does not exist\n");
@@ -1703,7 +1777,7 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     DumpVintf();
 
-    RunCommand("LIST OF OPEN FILES", {"lsof"}, CommandOptions::AS_ROOT);
+    sections.writeSection("LIST OF OPEN FILES", STDOUT_FILENO);
 
     for_each_tid(show_wchan, "BLOCKED PROCESS WAIT-CHANNELS");
     for_each_pid(show_showtime, "PROCESS TIMES (pid cmd user system iowait+percentage)");
@@ -1730,7 +1804,7 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     DumpPacketStats();
 
-    RunDumpsys("EBPF MAP STATS", {"connectivity", "trafficcontroller"});
+    sections.writeSection("EBPF MAP STATS", STDOUT_FILENO);
 
     DoKmsg();
 
@@ -1740,33 +1814,28 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     dump_route_tables();
 
-    RunCommand("ARP CACHE", {"ip", "-4", "neigh", "show"});
-    RunCommand("IPv6 ND CACHE", {"ip", "-6", "neigh", "show"});
-    RunCommand("MULTICAST ADDRESSES", {"ip", "maddr"});
+    sections.writeSection("ARP CACHE", STDOUT_FILENO);
+    sections.writeSection("IPv6 ND CACHE", STDOUT_FILENO);
+    sections.writeSection("MULTICAST ADDRESSES", STDOUT_FILENO);
 
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunDumpsysHigh);
 
     // The dump mechanism in connectivity is refactored due to modularization work. Connectivity can
     // only register with a default priority(NORMAL priority). Dumpstate has to call connectivity
     // dump with priority parameters to dump high priority information.
-    RunDumpsys("SERVICE HIGH connectivity", {"connectivity", "--dump-priority", "HIGH"},
-                   CommandOptions::WithTimeout(10).Build());
-
-    RunCommand("SYSTEM PROPERTIES", {"getprop"});
+    sections.writeSection("SERVICE HIGH connectivity", STDOUT_FILENO);
 
-    RunCommand("STORAGED IO INFO", {"storaged", "-u", "-p"});
+    sections.writeSection("SYSTEM PROPERTIES", STDOUT_FILENO);
 
-    RunCommand("FILESYSTEMS & FREE SPACE", {"df"});
+    sections.writeSection("STORAGED IO INFO", STDOUT_FILENO);
 
-    /* Binder state is expensive to look at as it uses a lot of memory. */
-    std::string binder_logs_dir = access("/dev/binderfs/binder_logs", R_OK) ?
-            "/sys/kernel/debug/binder" : "/dev/binderfs/binder_logs";
+    sections.writeSection("FILESYSTEMS & FREE SPACE", STDOUT_FILENO);
 
-    DumpFile("BINDER FAILED TRANSACTION LOG", binder_logs_dir + "/failed_transaction_log");
-    DumpFile("BINDER TRANSACTION LOG", binder_logs_dir + "/transaction_log");
-    DumpFile("BINDER TRANSACTIONS", binder_logs_dir + "/transactions");
-    DumpFile("BINDER STATS", binder_logs_dir + "/stats");
-    DumpFile("BINDER STATE", binder_logs_dir + "/state");
+    sections.writeSection("BINDER FAILED TRANSACTION LOG", STDOUT_FILENO);
+    sections.writeSection("BINDER TRANSACTION LOG", STDOUT_FILENO);
+    sections.writeSection("BINDER TRANSACTIONS", STDOUT_FILENO);
+    sections.writeSection("BINDER STATS", STDOUT_FILENO);
+    sections.writeSection("BINDER STATE", STDOUT_FILENO);
 
     ds.AddDir(SNAPSHOTCTL_LOG_DIR, false);
 
@@ -3505,6 +3574,32 @@ void Dumpstate::EnqueueAddZipEntryAndCleanupIfNeeded(const std::string& entry_na
     }
 }
 
+void Dumpstate::AddZipEntryFromDumpFuncOrEnqueue(const std::string& entry_name,
+        const std::string& entry_path, std::function<void(int)> dump_func) {
+    if (!zip_entry_tasks_) {
+        // Only the thread writing the zip file gets here, so skip the temporary file.
+        AddZipEntryFromDumpFunc(entry_name, std::move(dump_func), /* timeout = */ 0ms);
+        return;
+    }
+    bool empty = false;
+    {
+        auto fd = android::base::unique_fd(TEMP_FAILURE_RETRY(open(entry_path.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
+        if (fd < 0) {
+            MYLOGE("Could not open %s to dump %s.\n", entry_path.c_str(), entry_name.c_str());
+            return;
+        }
+        std::invoke(dump_func, fd.get());
+        empty = 0 == lseek(fd, 0, SEEK_END);
+    }
+    if (!empty) {
+        EnqueueAddZipEntryAndCleanupIfNeeded(entry_name, entry_path);
+    } else {
+        unlink(entry_path.c_str());
+    }
+}
+
 Dumpstate::RunStatus Dumpstate::HandleUserConsentDenied() {
     MYLOGD("User denied consent; deleting files and returning\n");
     CleanupTmpFiles();
@@ -4105,10 +4200,11 @@ void do_dmesg() {
     return;
 }
 
-int Dumpstate::DumpFile(const std::string& title, const std::string& path) {
-    DurationReporter duration_reporter(title);
+int Dumpstate::DumpFile(const std::string& title, const std::string& path, int out_fd) {
+    DurationReporter duration_reporter(title, false /* logcat_only */, false /* verbose */,
+                                       out_fd);
 
-    int status = DumpFileToFd(STDOUT_FILENO, title, path);
+    int status = DumpFileToFd(out_fd, title, path);
 
     UpdateProgress(WEIGHT_FILE);
 
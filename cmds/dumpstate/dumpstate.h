@@ -22,6 +22,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -259,8 +261,10 @@ class Dumpstate {
      * |title| description of the command printed on `stdout` (or empty to skip
      * description).
      * |path| location of the file to be dumped.
+     * |out_fd| A fd to support the SectionScheduler to output results to a
+     * temporary file.
      */
-    int DumpFile(const std::string& title, const std::string& path);
+    int DumpFile(const std::string& title, const std::string& path, int out_fd = STDOUT_FILENO);
 
     /*
      * Adds a new entry to the existing zip file.
@@ -274,9 +278,29 @@ class Dumpstate {
      * |fd| file descriptor to read from.
      * |timeout| timeout to terminate the read if not completed. Set
      * value of 0s (default) to disable timeout.
+     * |skip_if_empty| if true, no entry is added when fd has nothing to read,
+     * and NOT_ENOUGH_DATA is returned.
      */
     android::status_t AddZipEntryFromFd(const std::string& entry_name, int fd,
-                                        std::chrono::milliseconds timeout);
+                                        std::chrono::milliseconds timeout,
+                                        bool skip_if_empty = false);
+
+    /*
+     * Adds a new entry to the existing zip file with what dump_func writes to
+     * the fd it is given, compressing it while it is produced instead of
+     * writing it to a temporary file first. No entry is added, and
+     * NOT_ENOUGH_DATA is returned, if dump_func writes nothing.
+     *
+     * dump_func runs on its own thread while the calling thread writes the zip
+     * file, so this must not be called from a DumpPool task; use
+     * AddZipEntryFromDumpFuncOrEnqueue there.
+     *
+     * |timeout| timeout to stop adding to the entry if dump_func is not done.
+     * Set value of 0s to disable timeout.
+     */
+    android::status_t AddZipEntryFromDumpFunc(const std::string& entry_name,
+                                              std::function<void(int)> dump_func,
+                                              std::chrono::milliseconds timeout);
 
     /*
      * Adds a text entry to the existing zip file.
@@ -396,6 +420,16 @@ class Dumpstate {
     void EnqueueAddZipEntryAndCleanupIfNeeded(const std::string& entry_name,
             const std::string& entry_path);
 
+    /*
+     * Adds what dump_func writes to the fd it is given as a zip file entry
+     * with name entry_name, unless it writes nothing. Without the parallel
+     * run, it is streamed into the zip file by AddZipEntryFromDumpFunc.
+     * Otherwise this may run in a DumpPool task, so dump_func writes to
+     * entry_path, which is then added by EnqueueAddZipEntryAndCleanupIfNeeded.
+     */
+    void AddZipEntryFromDumpFuncOrEnqueue(const std::string& entry_name,
+            const std::string& entry_path, std::function<void(int)> dump_func);
+
     /*
      * Structure to hold options that determine the behavior of dumpstate.
      */
@@ -21,6 +21,7 @@
 #include "android/os/BnDumpstate.h"
 #include "dumpstate.h"
 #include "DumpPool.h"
+#include "SectionScheduler.h"
 
 #include <gmock/gmock.h>
 #include <gmock/gmock-matchers.h>
@@ -31,6 +32,7 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <atomic>
 #include <filesystem>
 #include <thread>
 
@@ -64,6 +66,7 @@ using ::testing::internal::CaptureStderr;
 using ::testing::internal::CaptureStdout;
 using ::testing::internal::GetCapturedStderr;
 using ::testing::internal::GetCapturedStdout;
+using namespace std::chrono_literals;
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -1079,6 +1082,34 @@ TEST_F(ZippedBugReportStreamTest, DISABLED_StreamLimitedOnlyReport) {
     VerifyEntry(handle_, bugreport_txt_name, &entry);
 }
 
+TEST_F(ZippedBugReportStreamTest, AddZipEntryFromDumpFunc) {
+    std::string out_path = kTestDataPath + "AddZipEntryFromDumpFuncOut.zip";
+    ds_.zip_file.reset(fopen(out_path.c_str(), "wb"));
+    ASSERT_NE(nullptr, ds_.zip_file.get());
+    ds_.zip_writer_.reset(new ZipWriter(ds_.zip_file.get()));
+
+    EXPECT_EQ(OK, ds_.AddZipEntryFromDumpFunc("streamed.txt", [](int fd) {
+        dprintf(fd, "streamed ");
+        dprintf(fd, "content\n");
+    }, 0ms));
+    EXPECT_EQ(NOT_ENOUGH_DATA,
+              ds_.AddZipEntryFromDumpFunc("empty.txt", [](int) {}, 0ms));
+    EXPECT_EQ(0, ds_.zip_writer_->Finish());
+    ds_.zip_writer_.reset();
+    ds_.zip_file.reset();
+
+    OpenArchive(out_path.c_str(), &handle_);
+    ZipEntry entry;
+    VerifyEntry(handle_, "streamed.txt", &entry);
+    std::string content;
+    content.resize(entry.uncompressed_length);
+    ExtractToMemory(handle_, &entry, reinterpret_cast<uint8_t*>(content.data()),
+                    entry.uncompressed_length);
+    EXPECT_THAT(content, StrEq("streamed content\n"));
+    EXPECT_NE(0, FindEntry(handle_, "empty.txt", &entry));
+    android::base::RemoveFileIfExists(out_path);
+}
+
 class ProgressTest : public DumpstateBaseTest {
   public:
     Progress GetInstance(int32_t max, double growth_factor, const std::string& path = "") {
@@ -1830,6 +1861,112 @@ TEST_F(TaskQueueTest, runTask_withCancelled) {
     EXPECT_TRUE(is_task2_cancelled);
 }
 
+class SectionSchedulerTest : public DumpPoolTest {
+  public:
+    using Resource = SectionScheduler::Resource;
+
+    std::string readOutput() {
+        std::string result;
+        ReadFileToString(out_path_, &result);
+        return result;
+    }
+};
+
+TEST_F(SectionSchedulerTest, WriteSection_inOrder) {
+    SectionScheduler scheduler(kTestDataPath);
+    scheduler.add("A", Resource::CPU, 10s, [](int out_fd) {
+        sleep(1);
+        dprintf(out_fd, "A");
+    });
+    scheduler.add("B", Resource::IO, 10s, [](int out_fd) { dprintf(out_fd, "B"); });
+    scheduler.add("C", Resource::BINDER, 10s, [](int out_fd) { dprintf(out_fd, "C"); });
+    scheduler.start();
+
+    scheduler.writeSection("A", out_fd_.get());
+    scheduler.writeSection("B", out_fd_.get());
+    scheduler.writeSection("C", out_fd_.get());
+
+    EXPECT_THAT(readOutput(), StrEq("A\nB\nC\n"));
+    EXPECT_THAT(getTempFileCounts(kTestDataPath), Eq(0));
+}
+
+TEST_F(SectionSchedulerTest, WriteSection_withoutStart_runsInline) {
+    SectionScheduler scheduler(kTestDataPath);
+    std::thread::id section_thread;
+    scheduler.add("A", Resource::CPU, 10s, [&](int out_fd) {
+        section_thread = std::this_thread::get_id();
+        dprintf(out_fd, "A\n");
+    });
+
+    scheduler.writeSection("A", out_fd_.get());
+
+    EXPECT_THAT(section_thread, Eq(std::this_thread::get_id()));
+    EXPECT_THAT(readOutput(), StrEq("A\n"));
+}
+
+TEST_F(SectionSchedulerTest, Start_respectsResourceLimits) {
+    SectionScheduler scheduler(kTestDataPath, {1, 2, 2});
+    std::atomic<int> running = 0;
+    std::atomic<int> max_running = 0;
+    auto section = [&](int) {
+        int now = ++running;
+        int max = max_running;
+        while (now > max && !max_running.compare_exchange_weak(max, now)) {
+        }
+        usleep(100 * 1000);
+        running--;
+    };
+    scheduler.add("A", Resource::CPU, 10s, section);
+    scheduler.add("B", Resource::CPU, 10s, section);
+    scheduler.add("C", Resource::CPU, 10s, section);
+    scheduler.start();
+
+    scheduler.writeSection("A", out_fd_.get());
+    scheduler.writeSection("B", out_fd_.get());
+    scheduler.writeSection("C", out_fd_.get());
+
+    EXPECT_THAT(max_running.load(), Eq(1));
+}
+
+TEST_F(SectionSchedulerTest, Start_waitsForDependencies) {
+    SectionScheduler scheduler(kTestDataPath);
+    std::atomic<bool> a_done = false;
+    bool a_done_before_b = false;
+    scheduler.add("A", Resource::IO, 10s, [&](int) {
+        usleep(200 * 1000);
+        a_done = true;
+    });
+    scheduler.add("B", Resource::CPU, 10s, [&](int) { a_done_before_b = a_done; }, {"A"});
+    scheduler.start();
+
+    scheduler.writeSection("B", out_fd_.get());
+    scheduler.writeSection("A", out_fd_.get());
+
+    EXPECT_TRUE(a_done_before_b);
+}
+
+TEST_F(SectionSchedulerTest, WriteSection_dropsTimedOutSection) {
+    SectionScheduler scheduler(kTestDataPath, {1, 1, 1});
+    bool dependent_run = false;
+    scheduler.add("SLOW", Resource::CPU, 100ms, [](int out_fd) {
+        sleep(1);
+        dprintf(out_fd, "SLOW");
+    });
+    scheduler.add("DEPENDENT", Resource::IO, 10s, [&](int) { dependent_run = true; }, {"SLOW"});
+    scheduler.add("NEXT", Resource::CPU, 10s, [](int out_fd) { dprintf(out_fd, "NEXT"); });
+    scheduler.start();
+
+    scheduler.writeSection("SLOW", out_fd_.get());
+    scheduler.writeSection("DEPENDENT", out_fd_.get());
+    scheduler.writeSection("NEXT", out_fd_.get());
+
+    EXPECT_FALSE(dependent_run);
+    EXPECT_THAT(readOutput(),
+                StrEq("*** SLOW: timed out after 0.100s, output dropped\n"
+                      "*** DEPENDENT: skipped, a section it depends on did not finish\n"
+                      "NEXT\n"));
+}
+
 
 }  // namespace dumpstate
 }  // namespace os
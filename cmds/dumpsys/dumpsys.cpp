@@ -16,7 +16,9 @@
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <iomanip>
+#include <mutex>
 #include <thread>
 
 #include <android-base/file.h>
@@ -65,16 +67,20 @@ static void usage() {
         "usage: dumpsys\n"
         "         To dump all services.\n"
         "or:\n"
-        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--clients] [--dump] [--pid] [--thread] "
-        "[--help | "
+        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--binder-latency] [--clients] [--dump] "
+        "[--pid] [--thread] [--parallel N] [--help | "
         "-l | --skip SERVICES "
         "| SERVICE [ARGS]]\n"
         "         --help: shows this help\n"
         "         -l: only list services, do not dump them\n"
         "         -t TIMEOUT_SEC: TIMEOUT to use in seconds instead of default 10 seconds\n"
         "         -T TIMEOUT_MS: TIMEOUT to use in milliseconds instead of default 10 seconds\n"
+        "         --binder-latency: start profiling binder transaction latency in the service\n"
+        "               host process if needed, and dump its histograms instead of usual dump\n"
         "         --clients: dump client PIDs instead of usual dump\n"
         "         --dump: ask the service to dump itself (this is the default)\n"
+        "         --parallel N: when dumping several services, dump up to N of them at the\n"
+        "               same time. Output is still written one service after another\n"
         "         --pid: dump PID instead of usual dump\n"
         "         --proto: filter services that support dumping data in proto format. Dumps\n"
         "               will be in proto format.\n"
@@ -135,13 +141,15 @@ int Dumpsys::main(int argc, char* const argv[]) {
     bool asProto = false;
     int dumpTypeFlags = 0;
     int timeoutArgMs = 10000;
+    int parallelism = 1;
     int priorityFlags = IServiceManager::DUMP_FLAG_PRIORITY_ALL;
     static struct option longOptions[] = {
         {"help", no_argument, 0, 0},           {"clients", no_argument, 0, 0},
         {"dump", no_argument, 0, 0},           {"pid", no_argument, 0, 0},
         {"priority", required_argument, 0, 0}, {"proto", no_argument, 0, 0},
         {"skip", no_argument, 0, 0},           {"stability", no_argument, 0, 0},
-        {"thread", no_argument, 0, 0},         {0, 0, 0, 0}};
+        {"thread", no_argument, 0, 0},         {"binder-latency", no_argument, 0, 0},
+        {"parallel", required_argument, 0, 0}, {0, 0, 0, 0}};
 
     // Must reset optind, otherwise subsequent calls will fail (wouldn't happen on main.cpp, but
     // happens on test cases).
@@ -182,6 +190,15 @@ int Dumpsys::main(int argc, char* const argv[]) {
                 dumpTypeFlags |= TYPE_THREAD;
             } else if (!strcmp(longOptions[optionIndex].name, "clients")) {
                 dumpTypeFlags |= TYPE_CLIENTS;
+            } else if (!strcmp(longOptions[optionIndex].name, "binder-latency")) {
+                dumpTypeFlags |= TYPE_LATENCY;
+            } else if (!strcmp(longOptions[optionIndex].name, "parallel")) {
+                char* endptr;
+                parallelism = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || parallelism <= 0) {
+                    fprintf(stderr, "Error: invalid parallel dump count: '%s'\n", optarg);
+                    return -1;
+                }
             }
             break;
 
@@ -271,6 +288,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
         return 0;
     }
 
+    if (N > 1 && parallelism > 1) {
+        Vector<String16> dumpedServices;
+        for (const String16& serviceName : services) {
+            if (!IsSkipped(skippedServices, serviceName)) {
+                dumpedServices.add(serviceName);
+            }
+        }
+        writeDumpsInParallel(STDOUT_FILENO, dumpedServices, dumpTypeFlags, args, priorityFlags,
+                             std::chrono::milliseconds(timeoutArgMs), asProto, parallelism);
+        return 0;
+    }
+
     for (size_t i = 0; i < N; i++) {
         const String16& serviceName = services[i];
         if (IsSkipped(skippedServices, serviceName)) continue;
@@ -415,6 +444,12 @@ static void reportDumpError(const String16& serviceName, status_t error, const c
 
 status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName,
                                   const Vector<String16>& args) {
+    return startDumpThread(dumpTypeFlags, serviceName, args, &activeThread_, &redirectFd_);
+}
+
+status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName,
+                                  const Vector<String16>& args, std::thread* thread,
+                                  unique_fd* redirectFd) {
     sp<IBinder> service = sm_->checkService(serviceName);
     if (service == nullptr) {
         std::cerr << "Can't find service: " << serviceName << std::endl;
@@ -428,12 +463,12 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
         return -errno;
     }
 
-    redirectFd_ = unique_fd(sfd[0]);
+    *redirectFd = unique_fd(sfd[0]);
     unique_fd remote_end(sfd[1]);
     sfd[0] = sfd[1] = -1;
 
     // dump blocks until completion, so spawn a thread..
-    activeThread_ = std::thread([=, remote_end{std::move(remote_end)}]() mutable {
+    *thread = std::thread([=, remote_end{std::move(remote_end)}]() mutable {
         if (dumpTypeFlags & TYPE_PID) {
             status_t err = dumpPidToFd(service, remote_end, dumpTypeFlags == TYPE_PID);
             reportDumpError(serviceName, err, "dumping PID");
@@ -450,6 +485,10 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
             status_t err = dumpClientsToFd(service, remote_end);
             reportDumpError(serviceName, err, "dumping clients info");
         }
+        if (dumpTypeFlags & TYPE_LATENCY) {
+            status_t err = service->dumpLatencyProfile(remote_end.get());
+            reportDumpError(serviceName, err, "dumping binder latency");
+        }
 
         // other types always act as a header, this is usually longer
         if (dumpTypeFlags & TYPE_DUMP) {
@@ -470,6 +509,205 @@ void Dumpsys::stopDumpThread(bool dumpComplete) {
     redirectFd_.reset();
 }
 
+namespace {
+
+// A service dumped by Dumpsys::writeDumpsInParallel.
+struct ParallelDump {
+    enum class State {
+        PENDING,
+        STARTING,
+        NOT_FOUND,
+        RUNNING,
+        DONE,
+    };
+
+    // Services are started in this order of priority.
+    enum Rank {
+        RANK_CRITICAL,
+        RANK_HIGH,
+        RANK_NORMAL,
+    };
+
+    String16 serviceName;
+    Rank rank = RANK_NORMAL;
+    State state = State::PENDING;
+    // Output which was not written yet.
+    std::string output;
+    status_t status = OK;
+    std::chrono::duration<double> elapsedDuration{0};
+};
+
+// How many services, per thread, NORMAL priority dumps may run ahead of the one being written.
+// This bounds how much output is buffered while a slow service holds up the others.
+constexpr size_t kParallelDumpLookaheadPerThread = 4;
+
+}  // namespace
+
+void Dumpsys::writeDumpsInParallel(int fd, const Vector<String16>& services, int dumpTypeFlags,
+                                   const Vector<String16>& args, int priorityFlags,
+                                   std::chrono::milliseconds timeout, bool asProto,
+                                   int parallelism) {
+    std::vector<ParallelDump> dumps(services.size());
+    Vector<String16> criticalServices;
+    Vector<String16> highServices;
+    if (priorityFlags == IServiceManager::DUMP_FLAG_PRIORITY_ALL) {
+        // Services registered with several priorities count as the most urgent one.
+        criticalServices = sm_->listServices(IServiceManager::DUMP_FLAG_PRIORITY_CRITICAL);
+        highServices = sm_->listServices(IServiceManager::DUMP_FLAG_PRIORITY_HIGH);
+    }
+    for (size_t i = 0; i < services.size(); i++) {
+        ParallelDump& dump = dumps[i];
+        dump.serviceName = services[i];
+        if (priorityFlags == IServiceManager::DUMP_FLAG_PRIORITY_CRITICAL ||
+            std::find(criticalServices.begin(), criticalServices.end(), dump.serviceName) !=
+                    criticalServices.end()) {
+            dump.rank = ParallelDump::RANK_CRITICAL;
+        } else if (priorityFlags == IServiceManager::DUMP_FLAG_PRIORITY_HIGH ||
+                   std::find(highServices.begin(), highServices.end(), dump.serviceName) !=
+                           highServices.end()) {
+            dump.rank = ParallelDump::RANK_HIGH;
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable condition;
+    size_t nextToWrite = 0;
+    const size_t lookahead = kParallelDumpLookaheadPerThread * parallelism;
+
+    // Returns the most urgent pending service, the earliest one first.
+    auto nextRunnableLocked = [&]() -> ParallelDump* {
+        ParallelDump* next = nullptr;
+        for (size_t i = nextToWrite; i < dumps.size(); i++) {
+            ParallelDump& dump = dumps[i];
+            if (dump.state != ParallelDump::State::PENDING ||
+                (dump.rank == ParallelDump::RANK_NORMAL && i >= nextToWrite + lookahead)) {
+                continue;
+            }
+            if (next == nullptr || dump.rank < next->rank) {
+                next = &dump;
+            }
+        }
+        return next;
+    };
+    auto hasPendingLocked = [&]() {
+        for (size_t i = nextToWrite; i < dumps.size(); i++) {
+            if (dumps[i].state == ParallelDump::State::PENDING) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto dumpLoop = [&]() {
+        std::unique_lock guard(lock);
+        while (true) {
+            ParallelDump* dump = nextRunnableLocked();
+            if (dump == nullptr) {
+                if (!hasPendingLocked()) {
+                    return;
+                }
+                condition.wait(guard);
+                continue;
+            }
+            dump->state = ParallelDump::State::STARTING;
+            guard.unlock();
+
+            std::thread dumpThread;
+            unique_fd redirectFd;
+            status_t status = startDumpThread(dumpTypeFlags, dump->serviceName, args, &dumpThread,
+                                              &redirectFd);
+            const bool started = (status == OK);
+            std::chrono::duration<double> elapsedDuration(0);
+            if (started) {
+                guard.lock();
+                dump->state = ParallelDump::State::RUNNING;
+                condition.notify_all();
+                guard.unlock();
+
+                size_t bytesWritten = 0;
+                status = copyDump(
+                        redirectFd.get(), dump->serviceName, timeout, asProto,
+                        [&](const char* buf, size_t size) {
+                            std::lock_guard bufferGuard(lock);
+                            dump->output.append(buf, size);
+                            condition.notify_all();
+                            return true;
+                        },
+                        elapsedDuration, bytesWritten);
+                if (status == OK) {
+                    dumpThread.join();
+                } else {
+                    dumpThread.detach();
+                }
+                redirectFd.reset();
+            }
+
+            guard.lock();
+            dump->state = started ? ParallelDump::State::DONE : ParallelDump::State::NOT_FOUND;
+            dump->status = status;
+            dump->elapsedDuration = elapsedDuration;
+            condition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t threadCount = std::min<size_t>(parallelism, dumps.size());
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(dumpLoop);
+    }
+
+    std::unique_lock guard(lock);
+    for (size_t i = 0; i < dumps.size(); i++) {
+        ParallelDump& dump = dumps[i];
+        condition.wait(guard, [&dump]() {
+            return dump.state != ParallelDump::State::PENDING &&
+                    dump.state != ParallelDump::State::STARTING;
+        });
+        if (dump.state != ParallelDump::State::NOT_FOUND) {
+            guard.unlock();
+            writeDumpHeader(fd, dump.serviceName, priorityFlags);
+            guard.lock();
+            while (true) {
+                condition.wait(guard, [&dump]() {
+                    return !dump.output.empty() || dump.state == ParallelDump::State::DONE;
+                });
+                std::string output = std::move(dump.output);
+                dump.output.clear();
+                const bool done = (dump.state == ParallelDump::State::DONE);
+                guard.unlock();
+                if (!output.empty() && !WriteFully(fd, output.data(), output.size())) {
+                    std::cerr << "Failed to write while dumping service " << dump.serviceName
+                              << ": " << strerror(errno) << std::endl;
+                }
+                guard.lock();
+                if (done) {
+                    break;
+                }
+            }
+            const status_t status = dump.status;
+            const std::chrono::duration<double> elapsedDuration = dump.elapsedDuration;
+            guard.unlock();
+
+            if (status == TIMED_OUT) {
+                WriteStringToFd(StringPrintf("\n*** SERVICE '%s' DUMP TIMEOUT (%llums) EXPIRED "
+                                             "***\n\n",
+                                             String8(dump.serviceName).string(),
+                                             timeout.count()),
+                                fd);
+            }
+            writeDumpFooter(fd, dump.serviceName, elapsedDuration);
+            guard.lock();
+        }
+        nextToWrite = i + 1;
+        condition.notify_all();
+    }
+    guard.unlock();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
 void Dumpsys::writeDumpHeader(int fd, const String16& serviceName, int priorityFlags) const {
     std::string msg(
         "----------------------------------------"
@@ -489,16 +727,26 @@ void Dumpsys::writeDumpHeader(int fd, const String16& serviceName, int priorityF
 status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::milliseconds timeout,
                             bool asProto, std::chrono::duration<double>& elapsedDuration,
                             size_t& bytesWritten) const {
-    status_t status = OK;
-    size_t totalBytes = 0;
-    auto start = std::chrono::steady_clock::now();
-    auto end = start + timeout;
-
     int serviceDumpFd = redirectFd_.get();
     if (serviceDumpFd == -1) {
         return INVALID_OPERATION;
     }
 
+    return copyDump(
+            serviceDumpFd, serviceName, timeout, asProto,
+            [fd](const char* buf, size_t size) { return WriteFully(fd, buf, size); },
+            elapsedDuration, bytesWritten);
+}
+
+status_t Dumpsys::copyDump(int serviceDumpFd, const String16& serviceName,
+                           std::chrono::milliseconds timeout, bool asProto,
+                           const std::function<bool(const char*, size_t)>& write,
+                           std::chrono::duration<double>& elapsedDuration, size_t& bytesWritten) {
+    status_t status = OK;
+    size_t totalBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + timeout;
+
     struct pollfd pfd = {.fd = serviceDumpFd, .events = POLLIN};
 
     while (true) {
@@ -521,7 +769,7 @@ status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::mi
         }
 
         char buf[4096];
-        rc = TEMP_FAILURE_RETRY(read(redirectFd_.get(), buf, sizeof(buf)));
+        rc = TEMP_FAILURE_RETRY(read(serviceDumpFd, buf, sizeof(buf)));
         if (rc < 0) {
             std::cerr << "Failed to read while dumping service " << serviceName << ": "
                  << strerror(errno) << std::endl;
@@ -532,7 +780,7 @@ status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::mi
             break;
         }
 
-        if (!WriteFully(fd, buf, rc)) {
+        if (!write(buf, rc)) {
             std::cerr << "Failed to write while dumping service " << serviceName << ": "
                  << strerror(errno) << std::endl;
             status = -errno;
@@ -544,7 +792,7 @@ status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::mi
     if ((status == TIMED_OUT) && (!asProto)) {
         std::string msg = StringPrintf("\n*** SERVICE '%s' DUMP TIMEOUT (%llums) EXPIRED ***\n\n",
                                        String8(serviceName).string(), timeout.count());
-        WriteStringToFd(msg, fd);
+        write(msg.data(), msg.size());
     }
 
     elapsedDuration = std::chrono::steady_clock::now() - start;
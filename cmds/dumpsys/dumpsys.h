@@ -17,6 +17,7 @@
 #ifndef FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 #define FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 
+#include <functional>
 #include <thread>
 
 #include <android-base/unique_fd.h>
@@ -57,6 +58,7 @@ class Dumpsys {
         TYPE_STABILITY = 0x4,  // dump stability information of server
         TYPE_THREAD = 0x8,     // dump thread usage of server only
         TYPE_CLIENTS = 0x10,   // dump pid of clients
+        TYPE_LATENCY = 0x20,   // dump transaction latency profile of server
     };
 
     /**
@@ -73,6 +75,26 @@ class Dumpsys {
     status_t startDumpThread(int dumpTypeFlags, const String16& serviceName,
                              const Vector<String16>& args);
 
+    /**
+     * Dumps services concurrently, on at most {@code parallelism} threads, while their output is
+     * still written to {@code fd} in the order of {@code services}, each with a header and a
+     * footer. The output of the service being written is streamed as it comes, the others are
+     * buffered until their turn. CRITICAL and HIGH priority services start first, while NORMAL
+     * ones only start a few services ahead of the one being written, to bound the buffering.
+     * @param fd file descriptor to write data
+     * @param services services to dump, in output order
+     * @param dumpTypeFlags operations to perform
+     * @param args list of arguments to pass to service dump method.
+     * @param priorityFlags dump priority specified
+     * @param timeout timeout to terminate each dump if not completed
+     * @param asProto used to supresses additional output to the fd such as timeout
+     * error messages
+     * @param parallelism maximum number of services dumped at the same time
+     */
+    void writeDumpsInParallel(int fd, const Vector<String16>& services, int dumpTypeFlags,
+                              const Vector<String16>& args, int priorityFlags,
+                              std::chrono::milliseconds timeout, bool asProto, int parallelism);
+
     /**
      * Writes a section header to a file descriptor.
      * @param fd file descriptor to write data
@@ -126,6 +148,16 @@ class Dumpsys {
     }
 
   private:
+    status_t startDumpThread(int dumpTypeFlags, const String16& serviceName,
+                             const Vector<String16>& args, std::thread* thread,
+                             android::base::unique_fd* redirectFd);
+
+    static status_t copyDump(int serviceDumpFd, const String16& serviceName,
+                             std::chrono::milliseconds timeout, bool asProto,
+                             const std::function<bool(const char*, size_t)>& write,
+                             std::chrono::duration<double>& elapsedDuration,
+                             size_t& bytesWritten);
+
     android::IServiceManager* sm_;
     std::thread activeThread_;
     mutable android::base::unique_fd redirectFd_;
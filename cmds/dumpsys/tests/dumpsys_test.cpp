@@ -454,6 +454,45 @@ TEST_F(DumpsysTest, DumpMultipleServices) {
     AssertDumped("running3", "dump3");
 }
 
+// Tests 'dumpsys --parallel 2', which should still write services in order
+TEST_F(DumpsysTest, DumpMultipleServicesInParallel) {
+    ExpectListServices({"running1", "stopped2", "running3", "running4"});
+    ExpectListServicesWithPriority({"running4"}, IServiceManager::DUMP_FLAG_PRIORITY_CRITICAL);
+    ExpectListServicesWithPriority({}, IServiceManager::DUMP_FLAG_PRIORITY_HIGH);
+    ExpectDump("running1", "dump1");
+    ExpectCheckService("stopped2", false);
+    ExpectDump("running3", "dump3");
+    ExpectDump("running4", "dump4");
+
+    CallMain({"--parallel", "2"});
+
+    AssertRunningServices({"running1", "running3", "running4"});
+    AssertDumped("running1", "dump1");
+    AssertStopped("stopped2");
+    AssertDumped("running3", "dump3");
+    AssertDumped("running4", "dump4");
+    AssertOutputFormat("(.|\n)*dump1(.|\n)*dump3(.|\n)*dump4(.|\n)*");
+}
+
+// Tests 'dumpsys -t 1 --parallel 2' where the first service times out after 2s
+TEST_F(DumpsysTest, DumpInParallelWithTimeout) {
+    ExpectListServices({"hanging1", "running2"});
+    ExpectListServicesWithPriority({}, IServiceManager::DUMP_FLAG_PRIORITY_CRITICAL);
+    ExpectListServicesWithPriority({}, IServiceManager::DUMP_FLAG_PRIORITY_HIGH);
+    sp<BinderMock> binder_mock = ExpectDumpAndHang("hanging1", 2, "Here's your car");
+    ExpectDump("running2", "dump2");
+
+    CallMain({"-t", "1", "--parallel", "2"});
+
+    AssertOutputContains("SERVICE 'hanging1' DUMP TIMEOUT (1000ms) EXPIRED");
+    AssertNotDumped("Here's your car");
+    AssertDumped("running2", "dump2");
+    AssertOutputFormat("(.|\n)*DUMP OF SERVICE hanging1:(.|\n)*DUMP OF SERVICE running2:(.|\n)*");
+
+    // TODO(b/65056227): BinderMock is not destructed because thread is detached on dumpsys.cpp
+    Mock::AllowLeak(binder_mock.get());
+}
+
 // Tests 'dumpsys --skip skipped3 skipped5', which should skip these services
 TEST_F(DumpsysTest, DumpWithSkip) {
     ExpectListServices({"running1", "stopped2", "skipped3", "running4", "skipped5"});
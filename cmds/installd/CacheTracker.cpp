@@ -57,10 +57,11 @@ void CacheTracker::addDataPath(const std::string& dataPath) {
 void CacheTracker::loadStats() {
     ATRACE_BEGIN("loadStats quota");
     cacheUsed = 0;
-    if (loadQuotaStats()) {
+    const bool statsFromQuota = loadQuotaStats(&cacheUsed);
+    ATRACE_END();
+    if (statsFromQuota) {
         return;
     }
-    ATRACE_END();
 
     ATRACE_BEGIN("loadStats tree");
     cacheUsed = 0;
@@ -73,18 +74,18 @@ void CacheTracker::loadStats() {
     ATRACE_END();
 }
 
-bool CacheTracker::loadQuotaStats() {
+bool CacheTracker::loadQuotaStats(int64_t* used) {
     int cacheGid = multiuser_get_cache_gid(mUserId, mAppId);
     if (IsQuotaSupported(mUuid) && cacheGid != -1) {
         int64_t space;
         if ((space = GetOccupiedSpaceForGid(mUuid, cacheGid)) != -1) {
-            cacheUsed += space;
+            *used += space;
         } else {
             return false;
         }
 
         if ((space = get_occupied_app_cache_space_external(mUuid, mUserId, mAppId)) != -1) {
-            cacheUsed += space;
+            *used += space;
         } else {
             return false;
         }
@@ -196,6 +197,68 @@ void CacheTracker::ensureItems() {
     }
 }
 
+uint64_t CacheTracker::loadTreeSignature() {
+    ATRACE_BEGIN("loadTreeSignature");
+    // Mixes each value into the signature in the way of FNV-1a.
+    uint64_t signature = 14695981039346656037ULL;
+    auto mix = [&signature](uint64_t value) {
+        signature = (signature ^ value) * 1099511628211ULL;
+    };
+    for (const auto& path : mDataPaths) {
+        for (const auto& cachePath : { read_path_inode(path, "cache", kXattrInodeCache),
+                read_path_inode(path, "code_cache", kXattrInodeCodeCache) }) {
+            FTS *fts;
+            FTSENT *p;
+            char *argv[] = { (char*) cachePath.c_str(), nullptr };
+            if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
+                mix(0);
+                continue;
+            }
+            while ((p = fts_read(fts)) != nullptr) {
+                switch (p->fts_info) {
+                case FTS_D:
+                case FTS_DEFAULT:
+                case FTS_F:
+                case FTS_SL:
+                case FTS_SLNONE:
+                    mix(p->fts_level);
+                    mix(p->fts_statp->st_ino);
+                    mix(p->fts_statp->st_ctim.tv_sec);
+                    mix(p->fts_statp->st_ctim.tv_nsec);
+                }
+            }
+            fts_close(fts);
+        }
+    }
+    ATRACE_END();
+    return signature;
+}
+
+bool CacheTracker::restoreItems(const Inventory& inventory) {
+    // Creating, deleting, renaming, writing or touching an entry, and changing its xattrs, all
+    // update a ctime somewhere in the tree, so any change to what loadItems() would find changes
+    // the signature. Checking it only needs a stat of each entry, without the xattr reads and
+    // sorting of a full load.
+    if (inventory.uuid != mUuid || inventory.signature != loadTreeSignature()) {
+        return false;
+    }
+    items = inventory.items;
+    mItemsLoaded = true;
+    return true;
+}
+
+std::shared_ptr<CacheTracker::Inventory> CacheTracker::saveItems() {
+    if (!mItemsLoaded) {
+        return nullptr;
+    }
+    // Purging changed the tree, so sign it again now that it's done.
+    auto inventory = std::make_shared<Inventory>();
+    inventory->uuid = mUuid;
+    inventory->signature = loadTreeSignature();
+    inventory->items = items;
+    return inventory;
+}
+
 int CacheTracker::getCacheRatio() {
     if (cacheQuota == 0) {
         return 0;
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <queue>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -39,6 +40,17 @@ namespace installd {
  */
 class CacheTracker {
 public:
+    /**
+     * Items left over from an earlier run, along with what the cache looked
+     * like when they were saved, so that they can be reused as long as the
+     * cache hasn't changed since.
+     */
+    struct Inventory {
+        std::string uuid;
+        uint64_t signature;
+        std::vector<std::shared_ptr<CacheItem>> items;
+    };
+
     CacheTracker(userid_t userId, appid_t appId, const std::string& uuid);
     ~CacheTracker();
 
@@ -50,6 +62,20 @@ public:
     void loadItems();
 
     void ensureItems();
+    bool hasItems() const { return mItemsLoaded; }
+
+    /**
+     * Uses the items of the inventory instead of loading them again, if
+     * nothing under the cache directories has changed since it was saved.
+     * Returns whether the items were reused.
+     */
+    bool restoreItems(const Inventory& inventory);
+
+    /**
+     * Returns the remaining items, to be restored by a later tracker for the
+     * same UID, or nullptr if the items weren't loaded.
+     */
+    std::shared_ptr<Inventory> saveItems();
 
     int getCacheRatio();
 
@@ -66,7 +92,8 @@ private:
 
     std::vector<std::string> mDataPaths;
 
-    bool loadQuotaStats();
+    bool loadQuotaStats(int64_t* used);
+    uint64_t loadTreeSignature();
     void loadItemsFrom(const std::string& path);
 
     DISALLOW_COPY_AND_ASSIGN(CacheTracker);
@@ -16,7 +16,9 @@
 
 #include "InstalldNativeService.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fts.h>
 #include <inttypes.h>
 #include <stdio.h>
@@ -35,10 +37,12 @@
 #include <sys/xattr.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <regex>
+#include <thread>
 #include <unordered_set>
 
 #include <android-base/file.h>
@@ -51,11 +55,12 @@
 #include <android-base/unique_fd.h>
 #include <cutils/ashmem.h>
 #include <cutils/fs.h>
+#include <cutils/iosched_policy.h>
 #include <cutils/properties.h>
 #include <cutils/sched_policy.h>
+#include <linux/fs.h>
 #include <linux/quota.h>
 #include <log/log.h>               // TODO: Move everything to base/logging.
-#include <logwrap/logwrap.h>
 #include <private/android_filesystem_config.h>
 #include <private/android_projectid_config.h>
 #include <selinux/android.h>
@@ -94,7 +99,6 @@ static constexpr const char* kTestUuid = "TEST";
 
 static constexpr const mode_t kRollbackFolderMode = 0700;
 
-static constexpr const char* kCpPath = "/system/bin/cp";
 static constexpr const char* kXattrDefault = "user.default";
 
 static constexpr const char* kDataMirrorCePath = "/data_mirror/data_ce";
@@ -371,6 +375,52 @@ using PackageLockGuard = std::lock_guard<PackageLock>;
 
 #endif // GRANULAR_LOCKS
 
+// Calls func(0) to func(count - 1), spread across up to maxThreads threads, including the
+// calling one.
+void forEachInParallel(size_t count, size_t maxThreads,
+                       const std::function<void(size_t)>& func) {
+    std::atomic<size_t> next = 0;
+    auto loop = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            func(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(count, maxThreads); i++) {
+        threads.emplace_back(loop);
+    }
+    loop();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Number of threads creating app data at once; each one mostly waits on the filesystem.
+constexpr size_t kCreateAppDataThreads = 4;
+
+// Number of directories deleted in the background at once.
+constexpr size_t kBackgroundDeletionThreads = 2;
+
+// Number of dexopt that dexoptBatched runs at once. Unless set explicitly, that's as many
+// dex2oat as fit on the CPUs they are pinned to, given how many threads each one uses.
+size_t getDexoptBatchJobs() {
+    int jobs = android::base::GetIntProperty("dalvik.vm.dex2oat-batch-jobs", 0);
+    if (jobs > 0) {
+        return jobs;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const std::string cpuSet = android::base::GetProperty("dalvik.vm.dex2oat-cpu-set", "");
+    if (!cpuSet.empty()) {
+        cpus = Split(cpuSet, ",").size();
+    }
+    int threads = android::base::GetIntProperty("dalvik.vm.dex2oat-threads", 0);
+    if (threads <= 0) {
+        // dex2oat uses every CPU it may run on by default.
+        return 1;
+    }
+    return std::max(1L, cpus / threads);
+}
+
 }  // namespace
 
 status_t InstalldNativeService::start() {
@@ -387,6 +437,17 @@ status_t InstalldNativeService::start() {
     return android::OK;
 }
 
+InstalldNativeService::~InstalldNativeService() {
+    {
+        std::lock_guard<std::mutex> lock(mDeletionLock);
+        mStopDeletions = true;
+    }
+    mDeletionCondition.notify_all();
+    if (mDeletionThread.joinable()) {
+        mDeletionThread.join();
+    }
+}
+
 status_t InstalldNativeService::dump(int fd, const Vector<String16>& /* args */) {
     {
         std::lock_guard<std::recursive_mutex> lock(mMountsLock);
@@ -839,13 +900,12 @@ binder::Status InstalldNativeService::createAppDataBatched(
     ENFORCE_UID(AID_SYSTEM);
     // Locking is performed depeer in the callstack.
 
-    std::vector<android::os::CreateAppDataResult> results;
-    for (const auto &arg : args) {
-        android::os::CreateAppDataResult result;
-        createAppData(arg, &result);
-        results.push_back(result);
-    }
-    *_aidl_return = results;
+    // Packages are locked one by one, so different ones are created at the same time.
+    std::vector<android::os::CreateAppDataResult> results(args.size());
+    forEachInParallel(args.size(), kCreateAppDataThreads, [&](size_t i) {
+        createAppData(args[i], &results[i]);
+    });
+    *_aidl_return = std::move(results);
     return ok();
 }
 
@@ -1198,6 +1258,86 @@ binder::Status InstalldNativeService::deleteReferenceProfile(const std::string&
     return ok();
 }
 
+// Renames the directory out of the way so that the caller doesn't wait for it to be deleted,
+// and queues it for deletion. If installd stops first, the renamed directory is deleted when the
+// user's storage is next prepared.
+int InstalldNativeService::deleteDirInBackground(const std::string& path) {
+    std::string renamedPath;
+    if (rename_dir_for_deletion(path, &renamedPath) != 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        PLOG(WARNING) << "Failed to rename " << path << ", deleting it in place";
+        return delete_dir_contents_and_dir(path, true /* ignore_if_missing */);
+    }
+
+    std::lock_guard<std::mutex> lock(mDeletionLock);
+    mPendingDeletions.push_back(std::move(renamedPath));
+    mDeletionsInFlight++;
+    if (!mDeletionThread.joinable()) {
+        mDeletionThread = std::thread(&InstalldNativeService::runBackgroundDeletions, this);
+    }
+    mDeletionCondition.notify_all();
+    return 0;
+}
+
+void InstalldNativeService::runBackgroundDeletions() {
+    // Deleting competes with app startup and installs for the disk, so keep out of their way.
+    android_set_ioprio(0, IoSchedClass_IDLE, 7);
+
+    std::unique_lock<std::mutex> lock(mDeletionLock);
+    while (true) {
+        mDeletionCondition.wait(lock,
+                                [this] { return mStopDeletions || !mPendingDeletions.empty(); });
+        if (mPendingDeletions.empty()) {
+            return;
+        }
+
+        std::vector<std::string> paths;
+        paths.swap(mPendingDeletions);
+        mActiveDeletions = paths;
+        lock.unlock();
+
+        forEachInParallel(paths.size(), kBackgroundDeletionThreads, [&paths](size_t i) {
+            if (delete_dir_contents_and_dir(paths[i], true /* ignore_if_missing */) != 0) {
+                LOG(WARNING) << "Failed to delete " << paths[i];
+            }
+        });
+
+        lock.lock();
+        mActiveDeletions.clear();
+        mDeletionsInFlight -= paths.size();
+        mDeletionCondition.notify_all();
+    }
+}
+
+void InstalldNativeService::waitForBackgroundDeletions() {
+    std::unique_lock<std::mutex> lock(mDeletionLock);
+    mDeletionCondition.wait(lock, [this] { return mDeletionsInFlight == 0; });
+}
+
+void InstalldNativeService::dropBackgroundDeletionsUnder(const std::vector<std::string>& roots) {
+    const auto isUnderRoots = [&roots](const std::string& path) {
+        return std::any_of(roots.begin(), roots.end(), [&path](const std::string& root) {
+            return path.size() > root.size() && path.compare(0, root.size(), root) == 0 &&
+                    path[root.size()] == '/';
+        });
+    };
+
+    std::unique_lock<std::mutex> lock(mDeletionLock);
+    // The renamed directories stay behind, for the caller or the next storage preparation to
+    // delete along with the rest of the tree.
+    const auto dropped =
+            std::remove_if(mPendingDeletions.begin(), mPendingDeletions.end(), isUnderRoots);
+    mDeletionsInFlight -= std::distance(dropped, mPendingDeletions.end());
+    mPendingDeletions.erase(dropped, mPendingDeletions.end());
+    mDeletionCondition.notify_all();
+
+    mDeletionCondition.wait(lock, [&] {
+        return std::none_of(mActiveDeletions.begin(), mActiveDeletions.end(), isUnderRoots);
+    });
+}
+
 binder::Status InstalldNativeService::destroyAppData(const std::optional<std::string>& uuid,
         const std::string& packageName, int32_t userId, int32_t flags, int64_t ceDataInode) {
     ENFORCE_UID(AID_SYSTEM);
@@ -1211,13 +1351,13 @@ binder::Status InstalldNativeService::destroyAppData(const std::optional<std::st
     binder::Status res = ok();
     if (flags & FLAG_STORAGE_CE) {
         auto path = create_data_user_ce_package_path(uuid_, userId, pkgname, ceDataInode);
-        if (rename_delete_dir_contents_and_dir(path) != 0) {
+        if (deleteDirInBackground(path) != 0) {
             res = error("Failed to delete " + path);
         }
     }
     if (flags & FLAG_STORAGE_DE) {
         auto path = create_data_user_de_package_path(uuid_, userId, pkgname);
-        if (rename_delete_dir_contents_and_dir(path) != 0) {
+        if (deleteDirInBackground(path) != 0) {
             res = error("Failed to delete " + path);
         }
         if ((flags & FLAG_CLEAR_APP_DATA_KEEP_ART_PROFILES) == 0) {
@@ -1283,7 +1423,7 @@ binder::Status InstalldNativeService::destroySdkSandboxDataPackageDirectory(
         }
         bool isCeData = (currentFlag == FLAG_STORAGE_CE);
         auto appPath = create_data_misc_sdk_sandbox_package_path(uuid_, isCeData, userId, pkgname);
-        if (rename_delete_dir_contents_and_dir(appPath) != 0) {
+        if (deleteDirInBackground(appPath) != 0) {
             res = error("Failed to delete " + appPath);
         }
     }
@@ -1398,19 +1538,264 @@ binder::Status InstalldNativeService::fixupAppData(const std::optional<std::stri
     return ok();
 }
 
+// Number of threads copying the top-level entries of a tree at once; each one mostly waits on
+// the filesystem.
+constexpr size_t kCopyTreeThreads = 4;
+
+// How many bytes copy_directory_recursive copies between two progress logs.
+constexpr uint64_t kCopyTreeProgressBytes = 256 * 1024 * 1024;
+
+// Counters of one copy_directory_recursive, shared by the threads copying the tree.
+struct CopyTreeStats {
+    std::atomic<uint64_t> entries = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> clonedBytes = 0;
+
+    void addBytes(uint64_t count, bool cloned, const char* from) {
+        if (cloned) clonedBytes += count;
+        const uint64_t total = bytes.fetch_add(count) + count;
+        if (total / kCopyTreeProgressBytes != (total - count) / kCopyTreeProgressBytes) {
+            LOG(INFO) << "Copying " << from << ": " << entries << " entries, " << total
+                      << " bytes so far";
+        }
+    }
+};
+
+// Copies the contents of a regular file, sharing its extents with FICLONE where the filesystem
+// supports it, and otherwise with copy_file_range so the data does not go through userspace.
+static bool copy_file_data(int srcFd, int dstFd, uint64_t size, const char* from,
+                           CopyTreeStats* stats) {
+    if (ioctl(dstFd, FICLONE, srcFd) == 0) {
+        stats->addBytes(size, true /* cloned */, from);
+        return true;
+    }
+
+    bool useCopyFileRange = true;
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t copied;
+        if (useCopyFileRange) {
+            copied = copy_file_range(srcFd, nullptr, dstFd, nullptr, 1024 * 1024 * 1024, 0);
+            if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                               errno == EINVAL)) {
+                // Not supported between these files; fall back from wherever it stopped.
+                useCopyFileRange = false;
+                continue;
+            }
+        } else {
+            copied = TEMP_FAILURE_RETRY(read(srcFd, buf, sizeof(buf)));
+            if (copied > 0 && !android::base::WriteFully(dstFd, buf, copied)) {
+                copied = -1;
+            }
+        }
+        if (copied < 0) return false;
+        if (copied == 0) return true;
+        stats->addBytes(copied, false /* cloned */, from);
+    }
+}
+
+// Copies ownership, permissions, timestamps and extended attributes like cp --preserve does.
+static bool copy_metadata(int srcFd, int dstFd, const struct stat& st) {
+    if (fchown(dstFd, st.st_uid, st.st_gid) != 0 || fchmod(dstFd, st.st_mode & 07777) != 0) {
+        return false;
+    }
+
+    ssize_t listSize = flistxattr(srcFd, nullptr, 0);
+    if (listSize < 0) return false;
+    std::vector<char> names(listSize);
+    listSize = flistxattr(srcFd, names.data(), names.size());
+    if (listSize < 0) return false;
+    std::vector<char> value;
+    for (const char* name = names.data(); name < names.data() + listSize;
+         name += strlen(name) + 1) {
+        const ssize_t valueSize = fgetxattr(srcFd, name, nullptr, 0);
+        if (valueSize < 0) return false;
+        value.resize(valueSize);
+        if (fgetxattr(srcFd, name, value.data(), value.size()) != valueSize ||
+            fsetxattr(dstFd, name, value.data(), value.size(), 0) != 0) {
+            return false;
+        }
+    }
+
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    return futimens(dstFd, times) == 0;
+}
+
+static bool copy_entry(int srcDirFd, int dstDirFd, const char* name, const std::string& from,
+                       CopyTreeStats* stats);
+
+// Copies the contents of a directory, then its metadata so that its timestamps stay intact.
+static bool copy_directory_contents(int srcFd, int dstFd, const struct stat& st,
+                                    const std::string& from, CopyTreeStats* stats) {
+    const int dupFd = fcntl(srcFd, F_DUPFD_CLOEXEC, 0);
+    std::unique_ptr<DIR, decltype(&closedir)> dir(dupFd < 0 ? nullptr : fdopendir(dupFd),
+                                                  closedir);
+    if (!dir) {
+        if (dupFd >= 0) close(dupFd);
+        PLOG(ERROR) << "Failed to open " << from;
+        return false;
+    }
+
+    struct dirent* de;
+    while ((de = readdir(dir.get())) != nullptr) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+        if (!copy_entry(srcFd, dstFd, de->d_name, from + "/" + de->d_name, stats)) {
+            return false;
+        }
+    }
+
+    if (!copy_metadata(srcFd, dstFd, st)) {
+        PLOG(ERROR) << "Failed to copy attributes of " << from;
+        return false;
+    }
+    return true;
+}
+
+// Creates the directory name in dstDirFd unless it exists, and opens it.
+static android::base::unique_fd make_directory_at(int dstDirFd, const char* name) {
+    if (mkdirat(dstDirFd, name, 0700) != 0 && errno != EEXIST) {
+        return {};
+    }
+    return android::base::unique_fd(
+            openat(dstDirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+}
+
+static bool copy_entry(int srcDirFd, int dstDirFd, const char* name, const std::string& from,
+                       CopyTreeStats* stats) {
+    struct stat st;
+    if (fstatat(srcDirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        PLOG(ERROR) << "Failed to stat " << from;
+        return false;
+    }
+    stats->entries++;
+
+    if (S_ISDIR(st.st_mode)) {
+        android::base::unique_fd srcFd(
+                openat(srcDirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        android::base::unique_fd dstFd(make_directory_at(dstDirFd, name));
+        if (srcFd < 0 || dstFd < 0) {
+            PLOG(ERROR) << "Failed to open or create directory for " << from;
+            return false;
+        }
+        return copy_directory_contents(srcFd, dstFd, st, from, stats);
+    }
+
+    // Like cp -F, replace whatever is in the way.
+    if (unlinkat(dstDirFd, name, 0) != 0 && errno != ENOENT) {
+        PLOG(ERROR) << "Failed to remove existing destination of " << from;
+        return false;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+        android::base::unique_fd srcFd(openat(srcDirFd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+        android::base::unique_fd dstFd(openat(dstDirFd, name,
+                                              O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                                              0600));
+        if (srcFd < 0 || dstFd < 0) {
+            PLOG(ERROR) << "Failed to open or create file for " << from;
+            return false;
+        }
+        if (!copy_file_data(srcFd, dstFd, st.st_size, from.c_str(), stats)) {
+            PLOG(ERROR) << "Failed to copy " << from;
+            return false;
+        }
+        if (!copy_metadata(srcFd, dstFd, st)) {
+            PLOG(ERROR) << "Failed to copy attributes of " << from;
+            return false;
+        }
+        return true;
+    }
+
+    if (S_ISLNK(st.st_mode)) {
+        std::string target;
+        if (!android::base::Readlink(from, &target) ||
+            symlinkat(target.c_str(), dstDirFd, name) != 0) {
+            PLOG(ERROR) << "Failed to copy symlink " << from;
+            return false;
+        }
+    } else if (mknodat(dstDirFd, name, st.st_mode, st.st_rdev) != 0) {
+        PLOG(ERROR) << "Failed to copy special file " << from;
+        return false;
+    }
+
+    // Neither symlinks nor special files can be opened to copy their attributes through a fd.
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    if (fchownat(dstDirFd, name, st.st_uid, st.st_gid, AT_SYMLINK_NOFOLLOW) != 0 ||
+        utimensat(dstDirFd, name, times, AT_SYMLINK_NOFOLLOW) != 0) {
+        PLOG(ERROR) << "Failed to copy attributes of " << from;
+        return false;
+    }
+    return true;
+}
+
+// Copies the tree at from into the directory to, or to to itself if it does not exist, like
+// cp -R does, preserving attributes. The top-level entries are copied in parallel.
 static int32_t copy_directory_recursive(const char* from, const char* to) {
-    char* argv[] =
-            {(char*)kCpPath,
-             (char*)"-F", /* delete any existing destination file first (--remove-destination) */
-             (char*)"--preserve=mode,ownership,timestamps,xattr", /* preserve properties */
-             (char*)"-R", /* recurse into subdirectories (DEST must be a directory) */
-             (char*)"-P", /* Do not follow symlinks [default] */
-             (char*)"-d", /* don't dereference symlinks */
-             (char*)from,
-             (char*)to};
+    std::string dstParent(to);
+    std::string dstName = android::base::Basename(from);
+    struct stat toSt;
+    if (stat(to, &toSt) != 0 || !S_ISDIR(toSt.st_mode)) {
+        dstParent = android::base::Dirname(to);
+        dstName = android::base::Basename(to);
+    }
+
+    LOG(DEBUG) << "Copying " << from << " to " << dstParent << "/" << dstName;
+    const auto start = std::chrono::steady_clock::now();
+    CopyTreeStats stats;
+
+    struct stat st;
+    android::base::unique_fd srcFd(
+            open(from, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    android::base::unique_fd dstParentFd(
+            open(dstParent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (srcFd < 0 || dstParentFd < 0 || fstat(srcFd, &st) != 0) {
+        PLOG(ERROR) << "Failed to open " << from << " or " << dstParent;
+        return -1;
+    }
+    android::base::unique_fd dstFd(make_directory_at(dstParentFd, dstName.c_str()));
+    if (dstFd < 0) {
+        PLOG(ERROR) << "Failed to create " << dstParent << "/" << dstName;
+        return -1;
+    }
+
+    std::vector<std::string> names;
+    {
+        const int dupFd = fcntl(srcFd, F_DUPFD_CLOEXEC, 0);
+        std::unique_ptr<DIR, decltype(&closedir)> dir(dupFd < 0 ? nullptr : fdopendir(dupFd),
+                                                      closedir);
+        if (!dir) {
+            if (dupFd >= 0) close(dupFd);
+            PLOG(ERROR) << "Failed to open " << from;
+            return -1;
+        }
+        struct dirent* de;
+        while ((de = readdir(dir.get())) != nullptr) {
+            if (strcmp(de->d_name, ".") && strcmp(de->d_name, "..")) {
+                names.emplace_back(de->d_name);
+            }
+        }
+    }
+
+    std::atomic<bool> ok = true;
+    forEachInParallel(names.size(), kCopyTreeThreads, [&](size_t i) {
+        if (!ok) return;
+        if (!copy_entry(srcFd, dstFd, names[i].c_str(), std::string(from) + "/" + names[i],
+                        &stats)) {
+            ok = false;
+        }
+    });
+    if (!ok) return -1;
 
-    LOG(DEBUG) << "Copying " << from << " to " << to;
-    return logwrap_fork_execvp(ARRAY_SIZE(argv), argv, nullptr, false, LOG_ALOG, false, nullptr);
+    if (!copy_metadata(srcFd, dstFd, st)) {
+        PLOG(ERROR) << "Failed to copy attributes of " << from;
+        return -1;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+    LOG(INFO) << "Copied " << from << ": " << stats.entries << " entries, " << stats.bytes
+              << " bytes (" << stats.clonedBytes << " cloned) in " << elapsed.count() << "ms";
+    return 0;
 }
 
 binder::Status InstalldNativeService::snapshotAppData(const std::optional<std::string>& volumeUuid,
@@ -1862,6 +2247,21 @@ binder::Status InstalldNativeService::createUserData(const std::optional<std::st
     return ok();
 }
 
+// The trees of a user that deleteDirInBackground may have queued directories in.
+static std::vector<std::string> getUserDataRoots(const char* uuid, int32_t userId,
+                                                 int32_t flags) {
+    std::vector<std::string> roots;
+    if (flags & FLAG_STORAGE_CE) {
+        roots.push_back(create_data_user_ce_path(uuid, userId));
+        roots.push_back(create_data_misc_sdk_sandbox_path(uuid, /*isCeData=*/true, userId));
+    }
+    if (flags & FLAG_STORAGE_DE) {
+        roots.push_back(create_data_user_de_path(uuid, userId));
+        roots.push_back(create_data_misc_sdk_sandbox_path(uuid, /*isCeData=*/false, userId));
+    }
+    return roots;
+}
+
 binder::Status InstalldNativeService::destroyUserData(const std::optional<std::string>& uuid,
         int32_t userId, int32_t flags) {
     ENFORCE_UID(AID_SYSTEM);
@@ -1869,6 +2269,8 @@ binder::Status InstalldNativeService::destroyUserData(const std::optional<std::s
     LOCK_USER();
 
     const char* uuid_ = uuid ? uuid->c_str() : nullptr;
+    dropBackgroundDeletionsUnder(getUserDataRoots(uuid_, userId, flags));
+
     binder::Status res = ok();
     if (flags & FLAG_STORAGE_DE) {
         auto path = create_data_user_de_path(uuid_, userId);
@@ -1912,6 +2314,12 @@ binder::Status InstalldNativeService::destroyUserData(const std::optional<std::s
     return res;
 }
 
+// Number of threads crawling cache directories at once; the crawl mostly waits on the filesystem.
+static constexpr size_t kCacheLoadThreads = 4;
+
+// Number of cache items that freeCache keeps for reuse by the next call, across all UIDs.
+static constexpr size_t kMaxCacheInventoryItems = 100000;
+
 binder::Status InstalldNativeService::freeCache(const std::optional<std::string>& uuid,
         int64_t targetFreeBytes, int32_t flags) {
     ENFORCE_UID(AID_SYSTEM);
@@ -2029,16 +2437,38 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         }
         atrace_pm_end();
 
-        // 2. Populate tracker stats and insert into priority queue
+        // 2. Populate tracker stats, reusing the items left over from the last
+        // time if the cache hasn't changed since, and insert into priority queue
         atrace_pm_begin("populate");
+        std::vector<std::shared_ptr<CacheTracker>> trackerList;
+        std::vector<std::shared_ptr<CacheTracker::Inventory>> inventories;
+        trackerList.reserve(trackers.size());
+        inventories.reserve(trackers.size());
+        {
+            std::lock_guard<std::mutex> lock(mCacheInventoryLock);
+            for (const auto& it : trackers) {
+                trackerList.push_back(it.second);
+                auto search = mCacheInventory.find(it.first);
+                inventories.push_back(search != mCacheInventory.end() ? search->second : nullptr);
+            }
+        }
+        std::atomic<size_t> restored = 0;
+        forEachInParallel(trackerList.size(), kCacheLoadThreads, [&](size_t i) {
+            trackerList[i]->loadStats();
+            if (inventories[i] && trackerList[i]->restoreItems(*inventories[i])) {
+                restored++;
+            }
+        });
+        LOG(DEBUG) << "Reusing cache items of " << restored.load() << " of " << trackerList.size()
+                << " UIDs";
+
         auto cmp = [](std::shared_ptr<CacheTracker> left, std::shared_ptr<CacheTracker> right) {
             return (left->getCacheRatio() < right->getCacheRatio());
         };
         std::priority_queue<std::shared_ptr<CacheTracker>,
                 std::vector<std::shared_ptr<CacheTracker>>, decltype(cmp)> queue(cmp);
-        for (const auto& it : trackers) {
-            it.second->loadStats();
-            queue.push(it.second);
+        for (const auto& tracker : trackerList) {
+            queue.push(tracker);
         }
         atrace_pm_end();
 
@@ -2066,7 +2496,28 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                     queue.push(active);
                 }
                 active = queue.top(); queue.pop();
-                active->ensureItems();
+                if (!active->hasItems()) {
+                    // Crawl the trackers likely to be needed next along with this one
+                    std::vector<std::shared_ptr<CacheTracker>> batch = {active};
+                    std::vector<std::shared_ptr<CacheTracker>> peeked;
+                    while (batch.size() < kCacheLoadThreads && !queue.empty()) {
+                        auto next = queue.top(); queue.pop();
+                        peeked.push_back(next);
+                        if (next->getCacheRatio() < 10000
+                                && !(flags & FLAG_FREE_CACHE_V2_DEFY_QUOTA)) {
+                            break;
+                        }
+                        if (!next->hasItems()) {
+                            batch.push_back(next);
+                        }
+                    }
+                    for (const auto& tracker : peeked) {
+                        queue.push(tracker);
+                    }
+                    forEachInParallel(batch.size(), kCacheLoadThreads, [&batch](size_t i) {
+                        batch[i]->ensureItems();
+                    });
+                }
                 continue;
             }
 
@@ -2102,6 +2553,29 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         }
         atrace_pm_end();
 
+        // 4. Keep the items that are left, so the next call doesn't have to
+        // crawl caches which haven't changed since. The items of trackers
+        // that didn't reuse theirs are out of date, so only the items loaded
+        // by this call are kept, up to kMaxCacheInventoryItems in all.
+        atrace_pm_begin("save");
+        std::unordered_map<uid_t, std::shared_ptr<CacheTracker::Inventory>> cacheInventory;
+        size_t savedItems = 0;
+        for (const auto& it : trackers) {
+            // Without purging, the items popped above are still on disk
+            if (noop || !it.second->hasItems()
+                    || savedItems + it.second->items.size() > kMaxCacheInventoryItems) {
+                continue;
+            }
+            auto inventory = it.second->saveItems();
+            savedItems += inventory->items.size();
+            cacheInventory[it.first] = std::move(inventory);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mCacheInventoryLock);
+            mCacheInventory = std::move(cacheInventory);
+        }
+        atrace_pm_end();
+
     } else {
         return error("Legacy cache logic no longer supported");
     }
@@ -3126,6 +3600,30 @@ binder::Status InstalldNativeService::dexopt(
     return res ? error(res, error_msg) : ok();
 }
 
+binder::Status InstalldNativeService::dexoptBatched(
+        const std::vector<android::os::DexoptArgs>& args,
+        std::vector<android::os::DexoptResult>* _aidl_return) {
+    ENFORCE_UID(AID_SYSTEM);
+    // Locking is performed depeer in the callstack.
+
+    const size_t jobs = getDexoptBatchJobs();
+    LOG(DEBUG) << "Running " << args.size() << " dexopt, " << jobs << " at a time";
+    std::vector<android::os::DexoptResult> results(args.size());
+    forEachInParallel(args.size(), jobs, [&](size_t i) {
+        const auto& arg = args[i];
+        bool completed = false;
+        auto status = dexopt(arg.apkPath, arg.uid, arg.packageName, arg.instructionSet,
+                arg.dexoptNeeded, arg.outputPath, arg.dexFlags, arg.compilerFilter, arg.uuid,
+                arg.sharedLibraries, arg.seInfo, arg.downgrade, arg.targetSdkVersion,
+                arg.profileName, arg.dexMetadataPath, arg.compilationReason, &completed);
+        results[i].completed = completed;
+        results[i].exceptionCode = status.exceptionCode();
+        results[i].exceptionMessage = status.exceptionMessage();
+    });
+    *_aidl_return = std::move(results);
+    return ok();
+}
+
 binder::Status InstalldNativeService::controlDexOptBlocking(bool block) {
     android::installd::control_dexopt_blocking(block);
     return ok();
@@ -3641,6 +4139,10 @@ binder::Status InstalldNativeService::onPrivateVolumeRemoved(
         const std::optional<std::string>& uuid) {
     ENFORCE_UID(AID_SYSTEM);
     CHECK_ARGUMENT_UUID(uuid);
+    if (uuid) {
+        // The volume is gone, along with the directories queued for deletion on it.
+        dropBackgroundDeletionsUnder({create_data_path(uuid->c_str())});
+    }
     if (!sAppDataIsolationEnabled) {
         return ok();
     }
@@ -3753,6 +4255,8 @@ binder::Status InstalldNativeService::migrateLegacyObbData() {
 binder::Status InstalldNativeService::cleanupInvalidPackageDirs(
         const std::optional<std::string>& uuid, int32_t userId, int32_t flags) {
     const char* uuid_cstr = uuid ? uuid->c_str() : nullptr;
+    // The directories queued for deletion look invalid too.
+    dropBackgroundDeletionsUnder(getUserDataRoots(uuid_cstr, userId, flags));
 
     if (flags & FLAG_STORAGE_CE) {
         auto ce_path = create_data_user_ce_path(uuid_cstr, userId);
@@ -21,7 +21,11 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +33,7 @@
 #include <binder/BinderService.h>
 #include <cutils/multiuser.h>
 
+#include "CacheTracker.h"
 #include "android/os/BnInstalld.h"
 #include "installd_constants.h"
 
@@ -39,6 +44,7 @@ class InstalldNativeService : public BinderService<InstalldNativeService>, publi
 public:
     static status_t start();
     static char const* getServiceName() { return "installd"; }
+    ~InstalldNativeService();
     virtual status_t dump(int fd, const Vector<String16> &args) override;
 
     binder::Status createUserData(const std::optional<std::string>& uuid, int32_t userId,
@@ -123,6 +129,8 @@ public:
                           int32_t targetSdkVersion, const std::optional<std::string>& profileName,
                           const std::optional<std::string>& dexMetadataPath,
                           const std::optional<std::string>& compilationReason, bool* aidl_return);
+    binder::Status dexoptBatched(const std::vector<android::os::DexoptArgs>& args,
+                                 std::vector<android::os::DexoptResult>* _aidl_return);
 
     binder::Status controlDexOptBlocking(bool block);
 
@@ -192,6 +200,12 @@ public:
                                      const std::optional<std::string>& outputPath,
                                      int32_t* _aidl_return);
 
+    // Blocks until the directories handed to deleteDirInBackground so far are deleted.
+    void waitForBackgroundDeletions();
+    // Drops the queued deletions of directories under any of roots, and blocks until those
+    // already being deleted are gone, so that the caller can delete or clean up the trees.
+    void dropBackgroundDeletionsUnder(const std::vector<std::string>& roots);
+
 private:
     std::recursive_mutex mLock;
     std::unordered_map<userid_t, std::weak_ptr<std::shared_mutex>> mUserIdLock;
@@ -206,6 +220,28 @@ private:
     /* Map from UID to cache quota size */
     std::unordered_map<uid_t, int64_t> mCacheQuotas;
 
+    std::mutex mCacheInventoryLock;
+
+    /* Map from UID to the cache items that freeCache left behind */
+    std::unordered_map<uid_t, std::shared_ptr<CacheTracker::Inventory>> mCacheInventory;
+
+    std::mutex mDeletionLock;
+    std::condition_variable mDeletionCondition;
+
+    /* Directories renamed out of the way, waiting to be deleted by mDeletionThread */
+    std::vector<std::string> mPendingDeletions;
+
+    /* Directories mDeletionThread is deleting right now */
+    std::vector<std::string> mActiveDeletions;
+
+    /* Number of directories queued or being deleted */
+    size_t mDeletionsInFlight = 0;
+    bool mStopDeletions = false;
+    std::thread mDeletionThread;
+
+    int deleteDirInBackground(const std::string& path);
+    void runBackgroundDeletions();
+
     std::string findDataMediaPath(const std::optional<std::string>& uuid, userid_t userid);
 
     binder::Status createAppDataLocked(const std::optional<std::string>& uuid,
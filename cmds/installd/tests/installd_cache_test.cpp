@@ -237,6 +237,131 @@ TEST_F(CacheTest, FreeCache_Age) {
     EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
 }
 
+TEST_F(CacheTest, FreeCache_MultipleApps) {
+    LOG(INFO) << "FreeCache_MultipleApps";
+
+    for (int i = 0; i < 6; i++) {
+        const std::string app = StringPrintf("com.example%d", i);
+        mkdir(app.c_str());
+        mkdir((app + "/cache").c_str());
+        touch((app + "/cache/one").c_str(), kMbInBytes, 60);
+        touch((app + "/cache/two").c_str(), kMbInBytes, 120);
+    }
+
+    service->freeCache(testUuid, kTbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    for (int i = 0; i < 6; i++) {
+        const std::string app = StringPrintf("com.example%d", i);
+        EXPECT_EQ(-1, exists((app + "/cache/one").c_str()));
+        EXPECT_EQ(-1, exists((app + "/cache/two").c_str()));
+    }
+}
+
+TEST_F(CacheTest, FreeCache_ChangedSinceLastCall) {
+    LOG(INFO) << "FreeCache_ChangedSinceLastCall";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 120);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+
+    // Items left over from the last call must not hide the newer, older-looking file
+    mkdir("com.example/cache/bar");
+    touch("com.example/cache/bar/three", kMbInBytes, 30);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/bar/three"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+}
+
+TEST_F(CacheTest, FreeCache_ReusesUnchangedItems) {
+    LOG(INFO) << "FreeCache_ReusesUnchangedItems";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 120);
+    touch("com.example/cache/foo/three", kMbInBytes, 180);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+
+    // Nothing changed, so the items left over from the last call are still right
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/three"));
+}
+
+TEST_F(CacheTest, FreeCache_TouchedSinceLastCall) {
+    LOG(INFO) << "FreeCache_TouchedSinceLastCall";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 120);
+    touch("com.example/cache/foo/three", kMbInBytes, 180);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+
+    // Using a file deep in the tree changes neither the cache usage nor the
+    // directories, but makes it the most recently used
+    touch("com.example/cache/foo/two", kMbInBytes, 240);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(-1, exists("com.example/cache/foo/three"));
+}
+
+TEST_F(CacheTest, FreeCache_GroupedSinceLastCall) {
+    LOG(INFO) << "FreeCache_GroupedSinceLastCall";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 90);
+    touch("com.example/cache/foo/three", kMbInBytes, 100);
+    touch("com.example/cache/four", kMbInBytes, 180);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+
+    // Marking the directory as a group only changes its xattrs, and makes
+    // the rest of it go at once
+    setxattr("com.example/cache/foo", "user.cache_group");
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(-1, exists("com.example/cache/foo/three"));
+    EXPECT_EQ(0, exists("com.example/cache/four"));
+}
+
 TEST_F(CacheTest, FreeCache_Tombstone) {
     LOG(INFO) << "FreeCache_Tombstone";
 
@@ -811,6 +811,43 @@ TEST_F(DexoptTest, DexoptPrimaryFailedInvalidFilter) {
                  "/data/app/com.installd.test.dexopt/base.jar failed: dex2oat error'");
 }
 
+TEST_F(DexoptTest, DexoptBatched) {
+    LOG(INFO) << "DexoptBatched";
+    android::os::DexoptArgs args;
+    args.apkPath = apk_path_;
+    args.uid = kTestAppGid;
+    args.packageName = package_name_;
+    args.instructionSet = kRuntimeIsa;
+    args.dexoptNeeded = DEX2OAT_FROM_SCRATCH;
+    args.outputPath = app_oat_dir_;
+    args.dexFlags = DEXOPT_BOOTCOMPLETE | DEXOPT_PUBLIC;
+    args.compilerFilter = "verify";
+    args.uuid = volume_uuid_;
+    args.sharedLibraries = "PCL[]";
+    args.seInfo = se_info_;
+    args.compilationReason = "test-reason";
+
+    // An invalid package fails on its own without affecting the others, and each result stays
+    // at the index of its arguments.
+    android::os::DexoptArgs invalidArgs = args;
+    invalidArgs.packageName = "com/bar";
+
+    std::vector<android::os::DexoptResult> results;
+    ASSERT_BINDER_SUCCESS(service_->dexoptBatched({invalidArgs, args}, &results));
+    ASSERT_EQ(2u, results.size());
+
+    EXPECT_EQ(binder::Status::EX_ILLEGAL_ARGUMENT, results[0].exceptionCode);
+    EXPECT_FALSE(results[0].completed);
+    EXPECT_EQ(binder::Status::EX_NONE, results[1].exceptionCode) << results[1].exceptionMessage;
+    EXPECT_TRUE(results[1].completed);
+
+    mode_t mode = S_IFREG | 0644;
+    CheckFileAccess(GetPrimaryDexArtifact(app_oat_dir_.c_str(), apk_path_, "odex"), kSystemUid,
+                    kTestAppGid, mode);
+    CheckFileAccess(GetPrimaryDexArtifact(app_oat_dir_.c_str(), apk_path_, "vdex"), kSystemUid,
+                    kTestAppGid, mode);
+}
+
 TEST_F(DexoptTest, DexoptPrimaryProfileNonPublic) {
     LOG(INFO) << "DexoptPrimaryProfileNonPublic";
     CompilePrimaryDexOk("speed-profile",
@@ -292,14 +292,34 @@ TEST_F(ServiceTest, DestroyAppData) {
 
     service->destroyAppData(testUuid, "com.example", 0, FLAG_STORAGE_DE | FLAG_STORAGE_CE, 0);
 
+    // The app data is moved out of the way right away, and deleted in the background.
     EXPECT_FALSE(exists("user/0/com.example/foo"));
     EXPECT_FALSE(exists("user/0/com.example/foo/file"));
     EXPECT_FALSE(exists("user/0/com.example/bar"));
     EXPECT_FALSE(exists("user/0/com.example/bar/file"));
 
+    service->waitForBackgroundDeletions();
     EXPECT_FALSE(exists_renamed_deleted_dir("/user/0"));
 }
 
+TEST_F(ServiceTest, DestroyUserDataAfterDestroyAppData) {
+    LOG(INFO) << "DestroyUserDataAfterDestroyAppData";
+
+    mkdir("user/0/com.example", 10000, 10000, 0700);
+    mkdir("user/0/com.example/foo", 10000, 10000, 0700);
+    touch("user/0/com.example/foo/file", 10000, 20000, 0700);
+
+    service->destroyAppData(testUuid, "com.example", 0, FLAG_STORAGE_DE | FLAG_STORAGE_CE, 0);
+    // Whether the app data is still queued or being deleted, the user's data is deleted without
+    // racing with it.
+    ASSERT_BINDER_SUCCESS(service->destroyUserData(testUuid, 0, FLAG_STORAGE_DE | FLAG_STORAGE_CE));
+    EXPECT_FALSE(exists("user/0/com.example"));
+    EXPECT_FALSE(exists_renamed_deleted_dir("/user/0"));
+
+    // Dropped deletions don't count as in flight anymore.
+    service->waitForBackgroundDeletions();
+}
+
 TEST_F(ServiceTest, CleanupInvalidPackageDirs) {
     LOG(INFO) << "CleanupInvalidPackageDirs";
 
@@ -654,6 +674,34 @@ TEST_F(AppDataSnapshotTest, CreateAppDataSnapshot) {
   ASSERT_EQ("TEST_CONTENT_DE_MODIFIED", de_content);
 }
 
+TEST_F(AppDataSnapshotTest, CreateAppDataSnapshot_PreservesTree) {
+  auto rollback_de_dir = create_data_misc_de_rollback_path("TEST", 0, 41);
+
+  ASSERT_TRUE(mkdirs(fake_package_de_path + "/dir/subdir/", 0700));
+  ASSERT_TRUE(android::base::WriteStringToFile(
+          "TEST_CONTENT_DE", fake_package_de_path + "/dir/subdir/file1",
+          0640, 10000, 20000, false /* follow_symlinks */));
+  ASSERT_EQ(0, symlink("dir/subdir/file1", (fake_package_de_path + "/link").c_str()));
+
+  ASSERT_BINDER_SUCCESS(service->snapshotAppData(std::make_optional<std::string>("TEST"),
+          "com.foo", 0, 41, FLAG_STORAGE_DE, nullptr));
+
+  std::string de_content;
+  ASSERT_TRUE(android::base::ReadFileToString(
+      rollback_de_dir + "/com.foo/dir/subdir/file1", &de_content, false /* follow_symlinks */));
+  ASSERT_EQ("TEST_CONTENT_DE", de_content);
+
+  struct stat buf;
+  ASSERT_EQ(0, stat((rollback_de_dir + "/com.foo/dir/subdir/file1").c_str(), &buf));
+  ASSERT_EQ(0640u, buf.st_mode & 07777);
+  ASSERT_EQ(10000u, buf.st_uid);
+  ASSERT_EQ(20000u, buf.st_gid);
+
+  std::string target;
+  ASSERT_TRUE(android::base::Readlink(rollback_de_dir + "/com.foo/link", &target));
+  ASSERT_EQ("dir/subdir/file1", target);
+}
+
 TEST_F(AppDataSnapshotTest, CreateAppDataSnapshot_TwoSnapshotsWithTheSameId) {
   auto rollback_ce_dir = create_data_misc_ce_rollback_path("TEST", 0, 67);
   auto rollback_de_dir = create_data_misc_de_rollback_path("TEST", 0, 67);
@@ -1059,6 +1107,26 @@ TEST_F(SdkSandboxDataTest, CreateAppData_CreatesSdkPackageData) {
     CheckFileAccess(fooDePath, kSystemUid, kSystemUid, S_IFDIR | 0751);
 }
 
+TEST_F(SdkSandboxDataTest, CreateAppDataBatched_CreatesEveryPackage) {
+    std::vector<android::os::CreateAppDataArgs> args;
+    for (int i = 0; i < 10; i++) {
+        args.push_back(createAppDataArgs(StringPrintf("com.foo%d", i)));
+    }
+    // An invalid package fails on its own without affecting the others.
+    args.push_back(createAppDataArgs("com/bar"));
+
+    std::vector<android::os::CreateAppDataResult> results;
+    ASSERT_BINDER_SUCCESS(service->createAppDataBatched(args, &results));
+    ASSERT_EQ(args.size(), results.size());
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(binder::Status::EX_NONE, results[i].exceptionCode) << results[i].exceptionMessage;
+        CheckFileAccess(StringPrintf("misc_ce/0/sdksandbox/com.foo%d", i), kSystemUid,
+                        kSystemUid, S_IFDIR | 0751);
+    }
+    EXPECT_NE(binder::Status::EX_NONE, results[10].exceptionCode);
+}
+
 TEST_F(SdkSandboxDataTest, CreateAppData_CreatesSdkPackageData_WithoutSdkFlag) {
     android::os::CreateAppDataResult result;
     android::os::CreateAppDataArgs args = createAppDataArgs("com.foo");
@@ -698,23 +698,31 @@ static std::string make_unique_name(std::string_view suffix) {
     return name;
 }
 
-static int rename_delete_dir_contents(const std::string& pathname,
-                                      int (*exclusion_predicate)(const char*, const int),
-                                      bool ignore_if_missing) {
+int rename_dir_for_deletion(const std::string& pathname, std::string* renamed_path) {
     auto temp_dir_name = make_unique_name(deletedSuffix);
     auto temp_dir_path =
             base::StringPrintf("%s/%s", Dirname(pathname).c_str(), temp_dir_name.c_str());
 
-    auto dir_to_delete = temp_dir_path.c_str();
-    if (::rename(pathname.c_str(), dir_to_delete)) {
+    if (::rename(pathname.c_str(), temp_dir_path.c_str())) {
+        return -1;
+    }
+    *renamed_path = std::move(temp_dir_path);
+    return 0;
+}
+
+static int rename_delete_dir_contents(const std::string& pathname,
+                                      int (*exclusion_predicate)(const char*, const int),
+                                      bool ignore_if_missing) {
+    std::string dir_to_delete;
+    if (rename_dir_for_deletion(pathname, &dir_to_delete) != 0) {
         if (ignore_if_missing && (errno == ENOENT)) {
             return 0;
         }
-        ALOGE("Couldn't rename %s -> %s: %s \n", pathname.c_str(), dir_to_delete, strerror(errno));
-        dir_to_delete = pathname.c_str();
+        ALOGE("Couldn't rename %s: %s \n", pathname.c_str(), strerror(errno));
+        dir_to_delete = pathname;
     }
 
-    return delete_dir_contents(dir_to_delete, 1, exclusion_predicate, ignore_if_missing);
+    return delete_dir_contents(dir_to_delete.c_str(), 1, exclusion_predicate, ignore_if_missing);
 }
 
 bool is_renamed_deleted_dir(const std::string& path) {
@@ -130,6 +130,9 @@ int delete_dir_contents(const std::string& pathname, bool ignore_if_missing = fa
 int delete_dir_contents_and_dir(const std::string& pathname, bool ignore_if_missing = false);
 
 bool is_renamed_deleted_dir(const std::string& path);
+// Atomically moves the directory to a unique name next to it, which is recognized by
+// is_renamed_deleted_dir. Returns 0 and the new path on success, or -1 with errno set.
+int rename_dir_for_deletion(const std::string& pathname, std::string* renamed_path);
 int rename_delete_dir_contents_and_dir(const std::string& pathname, bool ignore_if_missing = true);
 
 int foreach_subdir(const std::string& pathname, std::function<void(const std::string&)> fn);
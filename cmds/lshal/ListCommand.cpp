@@ -19,6 +19,7 @@
 #include <getopt.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iomanip>
@@ -26,6 +27,7 @@
 #include <map>
 #include <regex>
 #include <sstream>
+#include <thread>
 
 #include <android-base/file.h>
 #include <android-base/hex.h>
@@ -197,10 +199,25 @@ VintfInfo ListCommand::getVintfInfo(const std::string& fqInstanceName,
         return VINTF_INFO_EMPTY;
     }
 
-    return lshal::getVintfInfo(getDeviceManifest(), fqInstance, ta, DEVICE_MANIFEST) |
-            lshal::getVintfInfo(getFrameworkManifest(), fqInstance, ta, FRAMEWORK_MANIFEST) |
-            lshal::getVintfInfo(getDeviceMatrix(), fqInstance, ta, DEVICE_MATRIX) |
-            lshal::getVintfInfo(getFrameworkMatrix(), fqInstance, ta, FRAMEWORK_MATRIX);
+    const VintfObjects& vintfObjects = getVintfObjectsCached();
+    return lshal::getVintfInfo(vintfObjects.deviceManifest, fqInstance, ta, DEVICE_MANIFEST) |
+            lshal::getVintfInfo(vintfObjects.frameworkManifest, fqInstance, ta,
+                                FRAMEWORK_MANIFEST) |
+            lshal::getVintfInfo(vintfObjects.deviceMatrix, fqInstance, ta, DEVICE_MATRIX) |
+            lshal::getVintfInfo(vintfObjects.frameworkMatrix, fqInstance, ta, FRAMEWORK_MATRIX);
+}
+
+const ListCommand::VintfObjects& ListCommand::getVintfObjectsCached() const {
+    // Only called from the main thread.
+    if (!mVintfObjects) {
+        mVintfObjects = VintfObjects{
+                .deviceManifest = getDeviceManifest(),
+                .deviceMatrix = getDeviceMatrix(),
+                .frameworkManifest = getFrameworkManifest(),
+                .frameworkMatrix = getFrameworkMatrix(),
+        };
+    }
+    return *mVintfObjects;
 }
 
 bool ListCommand::getPidInfo(
@@ -210,12 +227,24 @@ bool ListCommand::getPidInfo(
 }
 
 const BinderPidInfo* ListCommand::getPidInfoCached(pid_t serverPid) {
-    auto pair = mCachedPidInfos.insert({serverPid, BinderPidInfo{}});
-    if (pair.second /* did insertion take place? */) {
-        if (!getPidInfo(serverPid, &pair.first->second)) {
-            return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mCachedPidInfosLock);
+        auto it = mCachedPidInfos.find(serverPid);
+        if (it != mCachedPidInfos.end()) {
+            return &it->second;
         }
     }
+
+    // Parse outside of the lock so that other PIDs can be looked up meanwhile. If another thread
+    // parsed the same PID in the meantime, its result is kept.
+    BinderPidInfo pidInfo;
+    const bool success = getPidInfo(serverPid, &pidInfo);
+
+    std::lock_guard<std::mutex> lock(mCachedPidInfosLock);
+    auto pair = mCachedPidInfos.emplace(serverPid, std::move(pidInfo));
+    if (pair.second /* did insertion take place? */ && !success) {
+        return nullptr;
+    }
     return &pair.first->second;
 }
 
@@ -594,7 +623,6 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
         return DUMP_BINDERIZED_ERROR;
     }
 
-    Status status = OK;
     std::map<std::string, TableEntry> allTableEntries;
     for (const auto &fqInstanceName : fqInstanceNames) {
         // create entry and default assign all fields.
@@ -602,8 +630,35 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
         entry.interfaceName = fqInstanceName;
         entry.transport = mode;
         entry.serviceStatus = ServiceStatus::NON_RESPONSIVE;
+    }
+
+    // Each entry takes a few IPCs, each with its own timeout, so query several HALs at a time.
+    // Warnings are buffered per entry and printed in order afterwards.
+    std::vector<TableEntry*> entries;
+    for (auto& pair : allTableEntries) {
+        entries.push_back(&pair.second);
+    }
+    std::vector<Status> statuses(entries.size(), OK);
+    std::vector<std::stringstream> warnings(entries.size());
+    std::atomic<size_t> next{0};
+    const auto work = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < entries.size();) {
+            statuses[i] = fetchBinderizedEntry(manager, entries[i], warnings[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(mJobs, entries.size()); ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-        status |= fetchBinderizedEntry(manager, &entry);
+    Status status = OK;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        err() << warnings[i].str();
+        status |= statuses[i];
     }
 
     for (auto& pair : allTableEntries) {
@@ -613,10 +668,10 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
 }
 
 Status ListCommand::fetchBinderizedEntry(const sp<IServiceManager> &manager,
-                                         TableEntry *entry) {
+                                         TableEntry *entry, std::ostream &warnings) {
     Status status = OK;
     const auto handleError = [&](Status additionalError, const std::string& msg) {
-        err() << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
+        warnings << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
         status |= DUMP_BINDERIZED_ERROR | additionalError;
     };
 
@@ -716,7 +771,8 @@ Status ListCommand::fetchManifestHals() {
     if (!shouldFetchHalType(HalType::VINTF_MANIFEST)) { return OK; }
     Status status = OK;
 
-    for (auto manifest : {getDeviceManifest(), getFrameworkManifest()}) {
+    const VintfObjects& vintfObjects = getVintfObjectsCached();
+    for (auto manifest : {vintfObjects.deviceManifest, vintfObjects.frameworkManifest}) {
         if (manifest == nullptr) {
             status |= VINTF_ERROR;
             continue;
@@ -802,6 +858,7 @@ bool ListCommand::hasPassthroughEntry(const TableEntry& entry) const {
 
 Status ListCommand::fetch() {
     Status status = OK;
+    mVintfObjects.reset();
     auto bManager = mLshal.serviceManager();
     if (bManager == nullptr) {
         err() << "Failed to get defaultServiceManager()!" << std::endl;
@@ -964,6 +1021,17 @@ void ListCommand::registerAllOptions() {
         thiz->mNeat = true;
         return OK;
     }, "output is machine parsable (no explanatory text).\nCannot be used with --debug."});
+    mOptions.push_back({'\0', "jobs", required_argument, v++, [](ListCommand* thiz, const char* arg) {
+        char* end;
+        const unsigned long jobs = strtoul(arg, &end, 10);
+        if (*arg == '\0' || *end != '\0' || jobs == 0) {
+            thiz->err() << "Invalid number of jobs: " << arg << std::endl;
+            return USAGE;
+        }
+        thiz->mJobs = jobs;
+        return OK;
+    }, "number of binderized HALs to query concurrently.\nDefault is " +
+       std::to_string(kDefaultJobs) + "; 1 queries them one at a time."});
     mOptions.push_back(
             {'\0', "types", required_argument, v++,
              [](ListCommand* thiz, const char* arg) {
@@ -20,6 +20,8 @@
 #include <stdint.h>
 
 #include <fstream>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -85,6 +87,8 @@ public:
 
     static std::string INIT_VINTF_NOTES;
 
+    static constexpr size_t kDefaultJobs = 8;
+
 protected:
     Status parseArgs(const Arg &arg);
     // Retrieve first-hand information
@@ -99,8 +103,10 @@ protected:
     Status fetchManifestHals();
     Status fetchLazyHals();
 
+    // Warnings are written to |warnings| rather than err(), since entries may be fetched
+    // concurrently.
     Status fetchBinderizedEntry(const sp<::android::hidl::manager::V1_0::IServiceManager> &manager,
-                                TableEntry *entry);
+                                TableEntry *entry, std::ostream &warnings);
 
     // Get relevant information for a PID by parsing files under
     // /dev/binderfs/binder_logs or /d/binder.
@@ -134,6 +140,15 @@ protected:
     virtual std::shared_ptr<const vintf::HalManifest> getFrameworkManifest() const;
     virtual std::shared_ptr<const vintf::CompatibilityMatrix> getFrameworkMatrix() const;
 
+    struct VintfObjects {
+        std::shared_ptr<const vintf::HalManifest> deviceManifest;
+        std::shared_ptr<const vintf::CompatibilityMatrix> deviceMatrix;
+        std::shared_ptr<const vintf::HalManifest> frameworkManifest;
+        std::shared_ptr<const vintf::CompatibilityMatrix> frameworkMatrix;
+    };
+    // Retrieve from mVintfObjects and call the getters above if necessary.
+    const VintfObjects& getVintfObjectsCached() const;
+
     void forEachTable(const std::function<void(Table &)> &f);
     void forEachTable(const std::function<void(const Table &)> &f) const;
     Table* tableForType(HalType type);
@@ -186,8 +201,15 @@ protected:
     std::map<pid_t, std::string> mCmdlines;
 
     // Cache for getPidInfo.
+    std::mutex mCachedPidInfosLock;
     std::map<pid_t, BinderPidInfo> mCachedPidInfos;
 
+    // Cache for getVintfObjectsCached, reset by fetch.
+    mutable std::optional<VintfObjects> mVintfObjects;
+
+    // Number of binderized HALs to query concurrently.
+    size_t mJobs = kDefaultJobs;
+
     // Cache for getPartition.
     std::map<pid_t, Partition> mPartitions;
 
@@ -308,6 +308,11 @@ TEST_F(ListParseArgsTest, DebugAndNeat) {
     EXPECT_THAT(err.str(), HasSubstr("--neat should not be used with --debug."));
 }
 
+TEST_F(ListParseArgsTest, InvalidJobs) {
+    EXPECT_NE(0u, mockList->parseArgs(createArg({"lshal", "--jobs=0"})));
+    EXPECT_THAT(err.str(), HasSubstr("Invalid number of jobs: 0"));
+}
+
 /// Fetch Test
 
 // A set of deterministic functions to generate fake debug infos.
@@ -555,6 +560,20 @@ TEST_F(ListTest, DumpDefault) {
     EXPECT_EQ("", err.str());
 }
 
+TEST_F(ListTest, DumpOneJob) {
+    const std::string expected =
+        "[fake description 0]\n"
+        "VINTF R Interface            Thread Use Server Clients\n"
+        "X     N a.h.foo1@1.0::IFoo/1 11/21      1      2 4\n"
+        "X     Y a.h.foo2@2.0::IFoo/2 12/22      2      3 5\n"
+        "\n";
+
+    optind = 1; // mimic Lshal::parseArg()
+    EXPECT_EQ(0u, mockList->main(createArg({"lshal", "--types=b", "--jobs=1"})));
+    EXPECT_EQ(expected, out.str());
+    EXPECT_EQ("", err.str());
+}
+
 TEST_F(ListTest, DumpHash) {
     const std::string expected =
         "[fake description 0]\n"
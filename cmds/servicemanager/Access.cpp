@@ -44,6 +44,9 @@ static std::string getPidcon(pid_t pid) {
     return result;
 }
 
+// Bounds mAllowedLookups, which is simply dropped once it grows past this.
+constexpr size_t kMaxAllowedLookups = 4096;
+
 static struct selabel_handle* getSehandle() {
     static struct selabel_handle* gSehandle = nullptr;
     if (gSehandle != nullptr && selinux_status_updated()) {
@@ -153,6 +156,24 @@ bool Access::actionAllowed(const CallingContext& sctx, const char* tctx, const c
 
 bool Access::actionAllowedFromLookup(const CallingContext& sctx, const std::string& name, const char *perm) {
 #ifdef __ANDROID__
+    // Reading the status page does not consume the update that getSehandle() looks for.
+    int policyLoad = selinux_status_policyload();
+    int enforce = selinux_status_getenforce();
+    if (policyLoad != mAllowedLookupsPolicyLoad || enforce != mAllowedLookupsEnforce) {
+        mAllowedLookups.clear();
+        mAllowedLookupsPolicyLoad = policyLoad;
+        mAllowedLookupsEnforce = enforce;
+    }
+
+    std::string key = sctx.sid;
+    key.push_back('\0');
+    key.append(perm);
+    key.push_back('\0');
+    key.append(name);
+    if (mAllowedLookups.count(key) > 0) {
+        return true;
+    }
+
     char *tctx = nullptr;
     if (selabel_lookup(getSehandle(), &tctx, name.c_str(), SELABEL_CTX_ANDROID_SERVICE) != 0) {
         LOG(ERROR) << "SELinux: No match for " << name << " in service_contexts.\n";
@@ -161,6 +182,11 @@ bool Access::actionAllowedFromLookup(const CallingContext& sctx, const std::stri
 
     bool allowed = actionAllowed(sctx, tctx, perm, name);
     freecon(tctx);
+
+    if (allowed && policyLoad >= 0 && enforce >= 0) {
+        if (mAllowedLookups.size() >= kMaxAllowedLookups) mAllowedLookups.clear();
+        mAllowedLookups.insert(std::move(key));
+    }
     return allowed;
 #else
     (void)sctx;
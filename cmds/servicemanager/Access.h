@@ -18,6 +18,7 @@
 
 #include <string>
 #include <sys/types.h>
+#include <unordered_set>
 
 namespace android {
 
@@ -51,6 +52,12 @@ private:
             const char *perm);
 
     char* mThisProcessContext = nullptr;
+
+    // (sid, perm, name) lookups that were allowed under the current policy. Denials are not
+    // cached so that each one is still audited. Cleared on policy load or enforcing change.
+    std::unordered_set<std::string> mAllowedLookups;
+    int mAllowedLookupsPolicyLoad = -1;
+    int mAllowedLookupsEnforce = -1;
 };
 
 };
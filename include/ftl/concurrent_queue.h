@@ -0,0 +1,143 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include <ftl/details/concurrent_queue.h>
+#include <ftl/optional.h>
+
+namespace android::ftl {
+
+// Lock-free FIFO queue of at most N elements in static storage, for a single producer thread and a
+// single consumer thread. N must be a power of two.
+//
+// The producer and consumer each keep a stale copy of the other's index, so that they only touch
+// each other's cache line when the queue looks full or empty, respectively.
+//
+// Example usage:
+//
+//   ftl::SpscQueue<int, 4> queue;
+//
+//   // Producer thread.
+//   while (!queue.try_push(42)) std::this_thread::yield();
+//
+//   // Consumer thread.
+//   if (const auto value = queue.try_pop()) {
+//     assert(*value == 42);
+//   }
+//
+template <typename T, std::size_t N>
+class SpscQueue final {
+  static_assert(details::is_queue_capacity_v<N>, "Capacity must be a power of two");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  SpscQueue() = default;
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  ~SpscQueue() {
+    while (try_pop());
+  }
+
+  static constexpr size_type capacity() { return N; }
+
+  // Returns the size at some point during the call, so it is only exact on the producer or consumer
+  // thread in the absence of the other.
+  size_type size() const {
+    const size_type head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Constructs an element at the back of the queue, and returns whether it did, i.e. whether the
+  // queue was not full. Must only be called by the producer thread.
+  template <typename... Args>
+  bool try_push(Args&&... args) {
+    const size_type tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == N) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == N) return false;
+    }
+
+    slots_[tail & (N - 1)].construct(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Removes the element at the front of the queue, or returns nullopt if the queue is empty. Must
+  // only be called by the consumer thread.
+  Optional<T> try_pop() {
+    const size_type head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return {};
+    }
+
+    Optional<T> value = slots_[head & (N - 1)].take();
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+ private:
+  // Written by the consumer.
+  alignas(details::kCacheLineSize) std::atomic<size_type> head_{0};
+  size_type tail_cache_ = 0;
+
+  // Written by the producer.
+  alignas(details::kCacheLineSize) std::atomic<size_type> tail_{0};
+  size_type head_cache_ = 0;
+
+  alignas(details::kCacheLineSize) std::array<details::QueueSlot<T>, N> slots_;
+};
+
+// Lock-free FIFO queue of at most N elements in static storage, for any number of producer threads
+// and a single consumer thread. N must be a power of two.
+//
+// The interface is that of SpscQueue, except that try_push may be called concurrently. Pushes are
+// linearizable, so elements pushed by the same producer are popped in order.
+//
+template <typename T, std::size_t N>
+using MpscQueue = details::BoundedQueue<T, N, /*MultiConsumer=*/false>;
+
+// Lock-free FIFO queue of at most N elements in static storage, for any number of producer threads
+// and consumer threads. N must be a power of two.
+//
+// The interface is that of SpscQueue, except that try_push and try_pop may be called concurrently.
+//
+//   ftl::MpmcQueue<std::string, 64> queue;
+//
+//   // Any thread.
+//   queue.try_push("abc");
+//
+//   // Any thread.
+//   if (auto value = queue.try_pop()) {
+//     consume(std::move(*value));
+//   }
+//
+template <typename T, std::size_t N>
+using MpmcQueue = details::BoundedQueue<T, N, /*MultiConsumer=*/true>;
+
+}  // namespace android::ftl
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <ftl/optional.h>
+
+namespace android::ftl::details {
+
+// Conservative size of a cache line, to keep data members written by different threads apart.
+constexpr std::size_t kCacheLineSize = 64;
+
+template <std::size_t N>
+constexpr bool is_queue_capacity_v = N > 0 && (N & (N - 1)) == 0;
+
+// Uninitialized storage for one element.
+template <typename T>
+struct QueueSlot {
+  template <typename... Args>
+  void construct(Args&&... args) {
+    new (bytes) T(std::forward<Args>(args)...);
+  }
+
+  // Moves the element out of the slot, which is left uninitialized.
+  T take() {
+    T* const ptr = std::launder(reinterpret_cast<T*>(bytes));
+    T value = std::move(*ptr);
+    ptr->~T();
+    return value;
+  }
+
+  alignas(T) std::byte bytes[sizeof(T)];
+};
+
+// Bounded queue with a sequence number per cell, after Dmitry Vyukov's MPMC queue. Producers and
+// (if MultiConsumer) consumers claim a cell by bumping the tail or head, respectively, then publish
+// it by bumping the sequence number of the cell. A single consumer bumps the head without a CAS.
+template <typename T, std::size_t N, bool MultiConsumer>
+class BoundedQueue final {
+  static_assert(is_queue_capacity_v<N>, "Capacity must be a power of two");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  BoundedQueue() {
+    for (size_type i = 0; i < N; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  ~BoundedQueue() {
+    while (try_pop());
+  }
+
+  static constexpr size_type capacity() { return N; }
+
+  // Returns the size at some point during the call, so it is only exact in the absence of writers.
+  size_type size() const {
+    const size_type head = head_.load(std::memory_order_acquire);
+    const size_type tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  template <typename... Args>
+  bool try_push(Args&&... args) {
+    size_type pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & (N - 1)];
+      const size_type sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.slot.construct(std::forward<Args>(args)...);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The cell has yet to be popped since the previous lap, so the queue is full.
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Optional<T> try_pop() {
+    size_type pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & (N - 1)];
+      const size_type sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+
+      if (diff < 0) return {};
+
+      if constexpr (MultiConsumer) {
+        if (diff > 0) {
+          pos = head_.load(std::memory_order_relaxed);
+          continue;
+        }
+        if (!head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) continue;
+      } else {
+        head_.store(pos + 1, std::memory_order_relaxed);
+      }
+
+      Optional<T> value = cell.slot.take();
+      cell.sequence.store(pos + N, std::memory_order_release);
+      return value;
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_type> sequence;
+    QueueSlot<T> slot;
+  };
+
+  alignas(kCacheLineSize) std::atomic<size_type> head_{0};
+  alignas(kCacheLineSize) std::atomic<size_type> tail_{0};
+  alignas(kCacheLineSize) std::array<Cell, N> cells_;
+};
+
+}  // namespace android::ftl::details
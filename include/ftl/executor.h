@@ -0,0 +1,200 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <ftl/future.h>
+#include <ftl/optional.h>
+
+namespace android::ftl {
+
+// Pool of worker threads that run tasks with work stealing. Each worker has a deque of tasks, which
+// it runs in LIFO order for locality. Idle workers steal the oldest task of other workers before
+// going to sleep. Tasks posted from outside the pool are spread across workers round-robin, whereas
+// tasks posted by a worker go to its own deque.
+//
+// The destructor runs pending tasks, including those that they post, before joining the workers.
+//
+// Example usage:
+//
+//   ftl::Executor executor(4);
+//
+//   executor.post([] { log("fire and forget"); });
+//
+//   ftl::Future<int> future = executor.async([] { return 6 * 7; });
+//   assert(future.get() == 42);
+//
+class Executor final {
+ public:
+  // Starts the given number of workers, or at least one.
+  explicit Executor(std::size_t thread_count = std::thread::hardware_concurrency()) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      workers_.push_back(std::make_unique<Worker>());
+    }
+
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      workers_[i]->thread = std::thread(&Executor::loop, this, i);
+    }
+  }
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  ~Executor() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (const auto& worker : workers_) {
+      worker->thread.join();
+    }
+  }
+
+  std::size_t thread_count() const { return workers_.size(); }
+
+  // Returns whether the calling thread is a worker of this executor.
+  bool is_worker() const { return tls_executor() == this; }
+
+  // Runs a function on a worker, ignoring its result.
+  template <typename F>
+  void post(F&& f) {
+    push(Task(std::forward<F>(f)));
+  }
+
+  // Runs a function on a worker, and returns a future for its result. The function must not return
+  // void, since ftl::Future requires a value.
+  template <typename F, typename R = std::invoke_result_t<F>>
+  Future<R> async(F&& f) {
+    static_assert(!std::is_void_v<R>, "Use post for functions that return void");
+
+    std::packaged_task<R()> task(std::forward<F>(f));
+    Future<R> future = task.get_future();
+    push(Task([task = std::move(task)]() mutable { task(); }));
+    return future;
+  }
+
+ private:
+  using Task = std::packaged_task<void()>;
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  static const Executor*& tls_executor() {
+    static thread_local const Executor* executor = nullptr;
+    return executor;
+  }
+
+  static std::size_t& tls_worker_index() {
+    static thread_local std::size_t index = 0;
+    return index;
+  }
+
+  void push(Task&& task) {
+    const std::size_t index = is_worker()
+            ? tls_worker_index()
+            : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    Worker& worker = *workers_[index];
+    {
+      std::lock_guard lock(worker.mutex);
+      worker.tasks.push_back(std::move(task));
+    }
+
+    // The count is only bumped once the task can be found, so a woken worker does not spin.
+    {
+      std::lock_guard lock(mutex_);
+      ++pending_count_;
+    }
+    condition_.notify_one();
+  }
+
+  // Pops the newest task of the given worker, or steals the oldest task of another worker.
+  Optional<Task> pop(std::size_t index) {
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      const bool own = i == 0;
+      Worker& worker = *workers_[(index + i) % workers_.size()];
+
+      std::lock_guard lock(worker.mutex);
+      if (worker.tasks.empty()) continue;
+
+      Task task;
+      if (own) {
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+      } else {
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+      }
+      return task;
+    }
+    return {};
+  }
+
+  void loop(std::size_t index) {
+    tls_executor() = this;
+    tls_worker_index() = index;
+
+    for (;;) {
+      {
+        std::unique_lock lock(mutex_);
+        condition_.wait(lock, [this] { return stopping_ || pending_count_ > 0; });
+        if (pending_count_ == 0) break;
+        --pending_count_;
+      }
+
+      // The decrement reserved a task, but the scan may miss it if it raced with other workers.
+      Optional<Task> task;
+      while (!(task = pop(index))) {
+        std::this_thread::yield();
+      }
+      (*task)();
+    }
+
+    tls_executor() = nullptr;
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<std::size_t> next_worker_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::size_t pending_count_ = 0;  // Tasks in deques but not reserved by a worker.
+  bool stopping_ = false;
+};
+
+}  // namespace android::ftl
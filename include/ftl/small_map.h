@@ -21,9 +21,12 @@
 #include <ftl/small_vector.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace android::ftl {
 
@@ -36,6 +39,12 @@ namespace android::ftl {
 //
 // SmallMap<K, V, 0> unconditionally allocates on the heap.
 //
+// Lookup is a linear search, which is fastest for the few mappings that fit in static storage. Once
+// the map is dynamic and holds more than kHashThreshold mappings, it also maintains an open
+// addressing hash table of their positions, provided that K has a std::hash specialization and that
+// KeyEqual is the default. The mappings themselves stay in contiguous storage, so iteration order
+// and iterator invalidation are the same either way.
+//
 // Example usage:
 //
 //   ftl::SmallMap<int, std::string, 3> map;
@@ -82,6 +91,10 @@ class SmallMap final {
   using const_reference = typename Map::const_reference;
   using const_iterator = typename Map::const_iterator;
 
+  // Minimum size past which a dynamic map hashes its keys. Below that, a linear search over a few
+  // cache lines beats hashing the key.
+  static constexpr size_type kHashThreshold = 16;
+
   // Creates an empty map.
   SmallMap() = default;
 
@@ -105,7 +118,11 @@ class SmallMap final {
 
   // Copies or moves key-value pairs from a convertible map.
   template <typename Q, typename W, std::size_t M, typename E>
-  SmallMap(SmallMap<Q, W, M, E> other) : map_(std::move(other.map_)) {}
+  SmallMap(SmallMap<Q, W, M, E> other) : map_(std::move(other.map_)) {
+    if constexpr (kHashable) {
+      if (should_hash()) rehash();
+    }
+  }
 
   size_type max_size() const { return map_.max_size(); }
   size_type size() const { return map_.size(); }
@@ -114,6 +131,9 @@ class SmallMap final {
   // Returns whether the map is backed by static or dynamic storage.
   bool dynamic() const { return map_.dynamic(); }
 
+  // Returns whether lookups go through a hash table rather than a linear search.
+  bool hashed() const { return !index_.empty(); }
+
   iterator begin() { return map_.begin(); }
   const_iterator begin() const { return cbegin(); }
   const_iterator cbegin() const { return map_.cbegin(); }
@@ -138,26 +158,30 @@ class SmallMap final {
   //   assert(d == 'D');
   //
   auto get(const key_type& key) const -> Optional<std::reference_wrapper<const mapped_type>> {
-    for (const auto& [k, v] : *this) {
-      if (KeyEqual{}(k, key)) {
-        return std::cref(v);
-      }
+    if (const auto it = find(key); it != end()) {
+      return std::cref(it->second);
     }
     return {};
   }
 
   auto get(const key_type& key) -> Optional<std::reference_wrapper<mapped_type>> {
-    for (auto& [k, v] : *this) {
-      if (KeyEqual{}(k, key)) {
-        return std::ref(v);
-      }
+    if (const auto it = find(key); it != end()) {
+      return std::ref(it->second);
     }
     return {};
   }
 
   // Returns an iterator to an existing mapping for the given key, or the end() iterator otherwise.
   const_iterator find(const key_type& key) const { return const_cast<SmallMap&>(*this).find(key); }
-  iterator find(const key_type& key) { return find(key, begin()); }
+  iterator find(const key_type& key) {
+    if constexpr (kHashable) {
+      if (hashed()) {
+        const size_type pos = index_[find_slot(key)];
+        return pos == kEmptySlot ? end() : begin() + pos;
+      }
+    }
+    return find(key, begin());
+  }
 
   // Inserts a mapping unless it exists. Returns an iterator to the inserted or existing mapping,
   // and whether the mapping was inserted.
@@ -173,6 +197,7 @@ class SmallMap final {
 
     auto& ref = map_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
                                   std::forward_as_tuple(std::forward<Args>(args)...));
+    index_back();
     return {&ref, true};
   }
 
@@ -218,15 +243,114 @@ class SmallMap final {
   //
   // The last() and end() iterators, as well as those to the erased mapping, are invalidated.
   //
-  bool erase(const key_type& key) { return erase(key, begin()); }
+  bool erase(const key_type& key) {
+    if constexpr (kHashable) {
+      if (hashed()) return erase_hashed(key);
+    }
+    return erase(key, begin());
+  }
 
   // Removes all mappings.
   //
   // All iterators are invalidated.
   //
-  void clear() { map_.clear(); }
+  void clear() {
+    map_.clear();
+    index_.clear();
+  }
 
  private:
+  // The hash table holds positions in map_, so it is only consistent with KeyEqual if the latter
+  // is the default.
+  static constexpr bool kHashable = std::is_same_v<KeyEqual, std::equal_to<K>> &&
+                                    std::is_default_constructible_v<std::hash<K>>;
+
+  static constexpr size_type kEmptySlot = std::numeric_limits<size_type>::max();
+
+  bool should_hash() const {
+    if constexpr (kHashable) {
+      return dynamic() && size() > kHashThreshold;
+    } else {
+      return false;
+    }
+  }
+
+  // Returns the first slot probed for the key. Fibonacci hashing mixes all bits of the hash into the
+  // top bits of the product, since std::hash is the identity for integers.
+  size_type home_slot(const key_type& key) const {
+    const auto hash = static_cast<std::uint64_t>(std::hash<K>{}(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_type>(hash >> index_shift_);
+  }
+
+  // Returns the slot holding the position of the key's mapping, or the empty slot ending its probe
+  // sequence if the key is not found.
+  size_type find_slot(const key_type& key) const {
+    const size_type mask = index_.size() - 1;
+    for (size_type slot = home_slot(key);; slot = (slot + 1) & mask) {
+      const size_type pos = index_[slot];
+      if (pos == kEmptySlot || KeyEqual{}(map_[pos].first, key)) return slot;
+    }
+  }
+
+  // Adds the last mapping to the hash table, if the map is or should be hashed.
+  void index_back() {
+    if constexpr (kHashable) {
+      if (!hashed()) {
+        if (should_hash()) rehash();
+      } else if (size() * 2 > index_.size()) {
+        rehash();
+      } else {
+        index_[find_slot(map_.back().first)] = size() - 1;
+      }
+    }
+  }
+
+  // Rebuilds the hash table with a load factor of at most 1/4.
+  void rehash() {
+    size_type capacity = 1;
+    unsigned shift = 64;
+    while (capacity < size() * 4) {
+      capacity *= 2;
+      --shift;
+    }
+
+    index_ = std::vector<size_type>(capacity, kEmptySlot);
+    index_shift_ = shift;
+    for (size_type pos = 0; pos < size(); ++pos) {
+      index_[find_slot(map_[pos].first)] = pos;
+    }
+  }
+
+  bool erase_hashed(const key_type& key) {
+    const size_type slot = find_slot(key);
+    const size_type pos = index_[slot];
+    if (pos == kEmptySlot) return false;
+
+    erase_slot(slot);
+
+    // The last mapping moves to the erased position.
+    if (const size_type last = size() - 1; pos != last) {
+      index_[find_slot(map_[last].first)] = pos;
+    }
+
+    map_.unstable_erase(begin() + pos);
+    return true;
+  }
+
+  // Clears a slot by shifting back the rest of its cluster, so that probing never needs tombstones.
+  void erase_slot(size_type hole) {
+    const size_type mask = index_.size() - 1;
+    for (size_type slot = (hole + 1) & mask; index_[slot] != kEmptySlot; slot = (slot + 1) & mask) {
+      // The position can fill the hole unless the hole is before its home slot, cyclically.
+      const size_type home = home_slot(map_[index_[slot]].first);
+      if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+        index_[hole] = index_[slot];
+        hole = slot;
+      }
+    }
+    index_[hole] = kEmptySlot;
+  }
+
   iterator find(const key_type& key, iterator first) {
     return std::find_if(first, end(),
                         [&key](const auto& pair) { return KeyEqual{}(pair.first, key); });
@@ -248,6 +372,8 @@ class SmallMap final {
   }
 
   Map map_;
+  std::vector<size_type> index_;
+  unsigned index_shift_ = 0;  // Of the hash, to keep log2(index_.size()) bits.
 };
 
 // Deduction guide for in-place constructor.
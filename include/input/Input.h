@@ -849,6 +849,10 @@ public:
             nsecs_t eventTime,
             const PointerCoords* pointerCoords);
 
+    // Make room for sampleCount samples in total, so that appending a known number of
+    // samples does not grow the sample storage one sample at a time.
+    void reserveSamples(size_t sampleCount);
+
     void offsetLocation(float xOffset, float yOffset);
 
     void scale(float globalScaleFactor);
@@ -87,6 +87,8 @@ private:
     std::unique_ptr<TfLiteMotionPredictorModel> mModel;
 
     std::unique_ptr<TfLiteMotionPredictorBuffers> mBuffers;
+    // The buffers' generation that the model's outputs were computed from, if any.
+    std::optional<uint64_t> mModelOutputGeneration;
     std::optional<MotionEvent> mLastEvent;
 };
 
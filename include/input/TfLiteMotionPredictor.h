@@ -81,8 +81,13 @@ public:
     // Returns the timestamp of the last sample.
     int64_t lastTimestamp() const { return mTimestamp; }
 
+    // Returns a value that changes whenever the contents copied by copyTo() or the axis change,
+    // so that a caller can skip re-running the model on inputs it has already seen.
+    uint64_t generation() const { return mGeneration; }
+
 private:
     int64_t mTimestamp = 0;
+    uint64_t mGeneration = 0;
 
     RingBuffer<float> mInputR;
     RingBuffer<float> mInputPhi;
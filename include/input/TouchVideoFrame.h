@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <sys/time.h>
+#include <memory>
 #include <vector>
 
 namespace android {
@@ -28,6 +29,9 @@ namespace android {
  * Represents data from a single scan of the touchscreen device.
  * Similar in concept to a video frame, but the touch strength is used as
  * the values instead.
+ *
+ * The touch strength data is immutable and shared between copies of the frame, so that frames can
+ * be passed through the input pipeline by value without copying the heatmap at every stage.
  */
 class TouchVideoFrame {
 public:
@@ -59,13 +63,14 @@ public:
     /**
      * Rotate the video frame.
      * The rotation value is an enum from ui/Rotation.h
+     * The rotated data is stored in a new buffer, leaving the data of other copies untouched.
      */
     void rotate(ui::Rotation orientation);
 
 private:
     uint32_t mHeight;
     uint32_t mWidth;
-    std::vector<int16_t> mData;
+    std::shared_ptr<const std::vector<int16_t>> mData;
     struct timeval mTimestamp;
 
     /**
@@ -19,7 +19,9 @@
 #include <input/Input.h>
 #include <utils/BitSet.h>
 #include <utils/Timers.h>
+#include <array>
 #include <map>
+#include <optional>
 #include <set>
 
 namespace android {
@@ -146,6 +148,15 @@ private:
     // Note that, only axes that have had MotionEvents (and not all supported axes) will be here.
     std::map<int32_t /*axis*/, std::unique_ptr<VelocityTrackerStrategy>> mConfiguredStrategies;
 
+    // Estimators already computed for each axis since the pointer's last movement. Apps query the
+    // velocity every frame while a strategy refits its whole history for each query, so repeated
+    // queries without new movements are served from here.
+    struct EstimatorCache {
+        BitSet32 validIdBits;
+        std::array<std::optional<Estimator>, MAX_POINTER_ID + 1> estimators;
+    };
+    mutable std::map<int32_t /*axis*/, EstimatorCache> mEstimatorCache;
+
     void configureStrategy(int32_t axis);
 
     // Generates a VelocityTrackerStrategy instance for the given Strategy type.
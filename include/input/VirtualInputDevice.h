@@ -17,6 +17,9 @@
 #pragma once
 
 #include <android-base/unique_fd.h>
+#include <linux/input.h>
+
+#include <vector>
 
 namespace android {
 
@@ -32,14 +35,27 @@ public:
     VirtualInputDevice(android::base::unique_fd fd);
     virtual ~VirtualInputDevice();
 
+    // Buffers the events of the following writes until endBatch(), which writes all of them with
+    // a single syscall. Used to inject a burst of frames from a high-rate synthetic stream.
+    void beginBatch();
+    // Writes the events buffered since beginBatch(). Returns false if the write failed.
+    bool endBatch();
+
 protected:
     const android::base::unique_fd mFd;
+    // Buffers an event. The events of a frame are written together once its SYN_REPORT is
+    // buffered, unless a batch is in progress.
     bool writeInputEvent(uint16_t type, uint16_t code, int32_t value,
                          std::chrono::nanoseconds eventTime);
     bool writeEvKeyEvent(int32_t androidCode, int32_t androidAction,
                          const std::map<int, int>& evKeyCodeMapping,
                          const std::map<int, UinputAction>& actionMapping,
                          std::chrono::nanoseconds eventTime);
+
+private:
+    std::vector<input_event> mPendingEvents;
+    bool mBatching = false;
+    bool flushInputEvents();
 };
 
 class VirtualKeyboard : public VirtualInputDevice {
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *                        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_BUFFEREDPOWERHINTSESSION_H
+#define ANDROID_BUFFEREDPOWERHINTSESSION_H
+
+#include <android-base/thread_annotations.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/WorkDuration.h>
+#include <powermanager/PowerHalWrapper.h>
+
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+// Buffers the work durations that several threads report to a power hint session, and sends them
+// to the HAL in a single call when flushed, typically at the end of each frame. Target duration
+// updates are buffered as well, and only the latest one is sent with the next flush, if it differs
+// from the last one sent. Reporting never makes a binder call, so it is cheap on critical paths.
+class BufferedPowerHintSession {
+public:
+    BufferedPowerHintSession() = default;
+
+    // Replace the session that buffered data is sent to, e.g. after recreating a failed session.
+    // Samples buffered so far are kept. The target passed to createHintSession is considered sent.
+    void setSession(sp<hardware::power::IPowerHintSession> session, int64_t targetDurationNanos);
+
+    // Thread-safe.
+    void addWorkDuration(const hardware::power::WorkDuration& duration);
+    void addWorkDuration(int64_t durationNanos, int64_t timeStampNanos);
+    void updateTargetWorkDuration(int64_t targetDurationNanos);
+
+    // Send the buffered target and work durations. On failure, they are kept to be sent to the
+    // next session. Returns unsupported if there is no session.
+    HalResult<void> flush();
+
+    size_t getBufferedWorkDurationCount();
+
+private:
+    void restoreWorkDurations(std::vector<hardware::power::WorkDuration>&& workDurations);
+
+    // Serializes flushes, so that calls to the session are not reordered.
+    std::mutex mFlushMutex;
+
+    std::mutex mMutex;
+    sp<hardware::power::IPowerHintSession> mSession GUARDED_BY(mMutex);
+    std::vector<hardware::power::WorkDuration> mWorkDurations GUARDED_BY(mMutex);
+    std::optional<int64_t> mTargetDurationNanos GUARDED_BY(mMutex);
+    std::optional<int64_t> mSentTargetDurationNanos GUARDED_BY(mMutex);
+};
+
+// -------------------------------------------------------------------------------------------------
+
+}; // namespace power
+
+}; // namespace android
+
+#endif // ANDROID_BUFFEREDPOWERHINTSESSION_H
@@ -24,6 +24,11 @@
 #include <android/hardware/power/Mode.h>
 #include <powermanager/PowerHalWrapper.h>
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
 namespace android {
 
 namespace power {
@@ -51,10 +56,20 @@ public:
     PowerHalController() : PowerHalController(std::make_unique<HalConnector>()) {}
     explicit PowerHalController(std::unique_ptr<HalConnector> connector)
           : mHalConnector(std::move(connector)) {}
-    virtual ~PowerHalController() = default;
+    virtual ~PowerHalController();
 
     void init();
 
+    // Queue a boost or mode change to be sent to the HAL by a dedicated thread, without waiting
+    // for the HAL. Requests of the same type that are still pending are coalesced: a boost keeps
+    // the longest duration, and a mode its latest state. A mode is not sent if its state matches
+    // the one last sent by this thread.
+    void setBoostAsync(hardware::power::Boost boost, int32_t durationMs);
+    void setModeAsync(hardware::power::Mode mode, bool enabled);
+
+    // Block until the requests queued so far by setBoostAsync and setModeAsync have been sent.
+    void flushAsync();
+
     virtual HalResult<void> setBoost(hardware::power::Boost boost, int32_t durationMs) override;
     virtual HalResult<void> setMode(hardware::power::Mode mode, bool enabled) override;
     virtual HalResult<sp<hardware::power::IPowerHintSession>> createHintSession(
@@ -69,11 +84,32 @@ private:
     // Shared pointers to keep global pointer and allow local copies to be used in
     // different threads
     std::shared_ptr<HalWrapper> mConnectedHal GUARDED_BY(mConnectedHalMutex) = nullptr;
+    // Bumped whenever mConnectedHal is dropped, as the HAL reconnected to next has none of the
+    // modes sent to the previous one.
+    uint64_t mConnectedHalGeneration GUARDED_BY(mConnectedHalMutex) = 0;
     const std::shared_ptr<HalWrapper> mDefaultHal = std::make_shared<EmptyHalWrapper>();
 
+    std::mutex mAsyncMutex;
+    std::condition_variable mAsyncCondition;
+    std::condition_variable mAsyncFlushedCondition;
+    std::map<hardware::power::Boost, int32_t> mPendingBoosts GUARDED_BY(mAsyncMutex);
+    std::map<hardware::power::Mode, bool> mPendingModes GUARDED_BY(mAsyncMutex);
+    // Modes last sent by the async thread. Invalidated by setMode, which bypasses the thread,
+    // and by reconnecting to the HAL.
+    std::map<hardware::power::Mode, bool> mSentModes GUARDED_BY(mAsyncMutex);
+    uint64_t mSentModesHalGeneration GUARDED_BY(mAsyncMutex) = 0;
+    uint64_t mSyncModeCount GUARDED_BY(mAsyncMutex) = 0;
+    bool mAsyncBusy GUARDED_BY(mAsyncMutex) = false;
+    bool mAsyncStopping GUARDED_BY(mAsyncMutex) = false;
+    std::thread mAsyncThread GUARDED_BY(mAsyncMutex);
+
     std::shared_ptr<HalWrapper> initHal();
+    uint64_t getConnectedHalGeneration();
     template <typename T>
     HalResult<T> processHalResult(HalResult<T> result, const char* functionName);
+
+    void startAsyncThreadLocked() REQUIRES(mAsyncMutex);
+    void asyncThreadMain();
 };
 
 // -------------------------------------------------------------------------------------------------
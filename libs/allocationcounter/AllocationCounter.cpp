@@ -0,0 +1,58 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <allocationcounter/AllocationCounter.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local size_t sThreadAllocationCount = 0;
+std::atomic<size_t> sProcessAllocationCount = 0;
+} // namespace
+
+// Replace the global operator new to count allocations. Unlike malloc hooks, this also works
+// with the sanitizers that tests are built with.
+void* operator new(size_t size) {
+    sThreadAllocationCount++;
+    sProcessAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        std::abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace android {
+
+size_t getThreadAllocationCount() {
+    return sThreadAllocationCount;
+}
+
+size_t getProcessAllocationCount() {
+    return sProcessAllocationCount.load(std::memory_order_relaxed);
+}
+
+} // namespace android
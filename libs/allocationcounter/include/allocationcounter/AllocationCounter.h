@@ -0,0 +1,40 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace android {
+
+// The number of heap allocations made through operator new, which liballocationcounter replaces
+// in the binary it is linked into. The process count includes every thread.
+size_t getThreadAllocationCount();
+size_t getProcessAllocationCount();
+
+// Counts the heap allocations that the current thread makes through operator new while in scope.
+// Allocations made by other threads are not counted, and counters may be nested.
+class ScopedAllocationCounter {
+public:
+    ScopedAllocationCounter() : mStart(getThreadAllocationCount()) {}
+
+    size_t count() const { return getThreadAllocationCount() - mStart; }
+
+private:
+    const size_t mStart;
+};
+
+} // namespace android
@@ -26,8 +26,8 @@
 #include <binder/IPCThreadState.h>
 #include <binder/IResultReceiver.h>
 #include <binder/IShellCallback.h>
+#include <binder/LatencyProfile.h>
 #include <binder/Parcel.h>
-#include <binder/RecordedTransaction.h>
 #include <binder/RpcServer.h>
 #include <cutils/compiler.h>
 #include <private/android_filesystem_config.h>
@@ -43,6 +43,9 @@
 
 #include "BuildFlags.h"
 #include "RpcState.h"
+#ifdef BINDER_WITH_KERNEL_IPC
+#include "TransactionRecorder.h"
+#endif // BINDER_WITH_KERNEL_IPC
 
 namespace android {
 
@@ -168,6 +171,29 @@ status_t IBinder::getDebugPid(pid_t* out) {
     return OK;
 }
 
+status_t IBinder::dumpLatencyProfile(int fd) {
+    if (!kEnableKernelIpc) {
+        ALOGW("dumpLatencyProfile disallowed because kernel binder is not enabled");
+        return INVALID_OPERATION;
+    }
+
+    BBinder* local = this->localBinder();
+    if (local != nullptr) {
+#ifdef BINDER_WITH_KERNEL_IPC
+        binder::debug::LatencyProfile::setEnabled(true);
+        return binder::debug::LatencyProfile::dump(fd);
+#endif // BINDER_WITH_KERNEL_IPC
+    }
+
+    BpBinder* proxy = this->remoteBinder();
+    LOG_ALWAYS_FATAL_IF(proxy == nullptr, "binder object must be either local or remote");
+
+    Parcel data;
+    Parcel reply;
+    if (status_t status = data.writeFileDescriptor(fd); status != OK) return status;
+    return transact(LATENCY_PROFILE_TRANSACTION, data, &reply);
+}
+
 status_t IBinder::setRpcClientDebug(android::base::unique_fd socketFd,
                                     const sp<IBinder>& keepAliveBinder) {
     if (!kEnableRpcDevServers) {
@@ -274,7 +300,9 @@ public:
     std::set<sp<RpcServerLink>> mRpcServerLinks;
     BpBinder::ObjectManager mObjects;
 
-    android::base::unique_fd mRecordingFd;
+#ifdef BINDER_WITH_KERNEL_IPC
+    std::shared_ptr<binder::debug::TransactionRecorder> mRecorder;
+#endif // BINDER_WITH_KERNEL_IPC
 };
 
 // ---------------------------------------------------------------------------
@@ -311,10 +339,14 @@ status_t BBinder::startRecordingTransactions(const Parcel& data) {
         LOG(INFO) << "Could not start Binder recording. Another is already in progress.";
         return INVALID_OPERATION;
     } else {
-        status_t readStatus = data.readUniqueFileDescriptor(&(e->mRecordingFd));
+        android::base::unique_fd fd;
+        status_t readStatus = data.readUniqueFileDescriptor(&fd);
         if (readStatus != OK) {
             return readStatus;
         }
+#ifdef BINDER_WITH_KERNEL_IPC
+        e->mRecorder = std::make_shared<binder::debug::TransactionRecorder>(std::move(fd));
+#endif // BINDER_WITH_KERNEL_IPC
         mRecordingOn = true;
         LOG(INFO) << "Started Binder recording.";
         return NO_ERROR;
@@ -336,9 +368,15 @@ status_t BBinder::stopRecordingTransactions() {
         return PERMISSION_DENIED;
     }
     Extras* e = getOrCreateExtras();
+#ifdef BINDER_WITH_KERNEL_IPC
+    // Released after mLock, since it waits for the pending transactions to be written.
+    std::shared_ptr<binder::debug::TransactionRecorder> recorder;
+#endif // BINDER_WITH_KERNEL_IPC
     AutoMutex lock(e->mLock);
     if (mRecordingOn) {
-        e->mRecordingFd.reset();
+#ifdef BINDER_WITH_KERNEL_IPC
+        recorder.swap(e->mRecorder);
+#endif // BINDER_WITH_KERNEL_IPC
         mRecordingOn = false;
         LOG(INFO) << "Stopped Binder recording.";
         return NO_ERROR;
@@ -355,6 +393,27 @@ const String16& BBinder::getInterfaceDescriptor() const
     return sBBinder;
 }
 
+// Handles LATENCY_PROFILE_TRANSACTION on behalf of the whole process.
+static status_t handleLatencyProfileTransaction(const Parcel& data) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    uid_t uid = IPCThreadState::self()->getCallingUid();
+    if (uid != AID_ROOT && uid != AID_SHELL) {
+        ALOGE("%s: not allowed because client %" PRIu32 " is not root or shell",
+              __PRETTY_FUNCTION__, uid);
+        return PERMISSION_DENIED;
+    }
+    android::base::unique_fd fd;
+    if (status_t status = data.readUniqueFileDescriptor(&fd); status != OK) return status;
+
+    binder::debug::LatencyProfile::setEnabled(true);
+    return binder::debug::LatencyProfile::dump(fd.get());
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)data;
+    ALOGW("%s: disallowed because kernel binder is not enabled", __PRETTY_FUNCTION__);
+    return INVALID_OPERATION;
+#endif // BINDER_WITH_KERNEL_IPC
+}
+
 // NOLINTNEXTLINE(google-default-arguments)
 status_t BBinder::transact(
     uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags)
@@ -388,6 +447,9 @@ status_t BBinder::transact(
             err = setRpcClientDebug(data);
             break;
         }
+        case LATENCY_PROFILE_TRANSACTION:
+            err = handleLatencyProfileTransaction(data);
+            break;
         default:
             err = onTransact(code, data, reply, flags);
             break;
@@ -402,25 +464,23 @@ status_t BBinder::transact(
         }
     }
 
-    if (CC_UNLIKELY(kEnableKernelIpc && mRecordingOn && code != START_RECORDING_TRANSACTION)) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (CC_UNLIKELY(mRecordingOn && code != START_RECORDING_TRANSACTION)) {
         Extras* e = mExtras.load(std::memory_order_acquire);
-        AutoMutex lock(e->mLock);
-        if (mRecordingOn) {
+        std::shared_ptr<binder::debug::TransactionRecorder> recorder;
+        {
+            AutoMutex lock(e->mLock);
+            recorder = e->mRecorder;
+        }
+        if (recorder) {
             Parcel emptyReply;
             timespec ts;
             timespec_get(&ts, TIME_UTC);
-            auto transaction = android::binder::debug::RecordedTransaction::
-                    fromDetails(getInterfaceDescriptor(), code, flags, ts, data,
-                                reply ? *reply : emptyReply, err);
-            if (transaction) {
-                if (status_t err = transaction->dumpToFile(e->mRecordingFd); err != NO_ERROR) {
-                    LOG(INFO) << "Failed to dump RecordedTransaction to file with error " << err;
-                }
-            } else {
-                LOG(INFO) << "Failed to create RecordedTransaction object.";
-            }
+            recorder->record(getInterfaceDescriptor(), code, flags, ts, data,
+                             reply ? *reply : emptyReply, err);
         }
     }
+#endif // BINDER_WITH_KERNEL_IPC
 
     return err;
 }
@@ -20,6 +20,7 @@
 
 #include <binder/Binder.h>
 #include <binder/BpBinder.h>
+#include <binder/LatencyProfile.h>
 #include <binder/TextOutput.h>
 
 #include <android-base/macros.h>
@@ -28,6 +29,7 @@
 #include <utils/Log.h>
 #include <utils/SystemClock.h>
 
+#include <algorithm>
 #include <atomic>
 #include <errno.h>
 #include <inttypes.h>
@@ -38,6 +40,7 @@
 #include <sys/ioctl.h>
 #include <sys/resource.h>
 #include <unistd.h>
+#include <utility>
 
 #include "binder_module.h"
 
@@ -114,6 +117,9 @@ static const char *kCommandStrings[] = {
 
 static const int64_t kWorkSourcePropagatedBitIndex = 32;
 
+// Oneway transactions queued by a batch before they are sent regardless.
+static const size_t kMaxBatchedOnewayTransactions = 32;
+
 static const char* getReturnString(uint32_t cmd)
 {
     size_t idx = cmd & _IOC_NRMASK;
@@ -643,22 +649,31 @@ status_t IPCThreadState::getAndExecuteCommand()
 
         pthread_mutex_lock(&mProcess->mThreadCountLock);
         mProcess->mExecutingThreadsCount++;
+        mProcess->mPeakExecutingThreads =
+                std::max(mProcess->mPeakExecutingThreads, mProcess->mExecutingThreadsCount);
         if (mProcess->mExecutingThreadsCount >= mProcess->mMaxThreads &&
                 mProcess->mStarvationStartTimeMs == 0) {
             mProcess->mStarvationStartTimeMs = uptimeMillis();
         }
         pthread_mutex_unlock(&mProcess->mThreadCountLock);
 
+        const nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
         result = executeCommand(cmd);
+        const nsecs_t busyTime = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
 
         pthread_mutex_lock(&mProcess->mThreadCountLock);
         mProcess->mExecutingThreadsCount--;
+        mProcess->mCommandsExecuted++;
+        mProcess->mBusyTime += busyTime;
         if (mProcess->mExecutingThreadsCount < mProcess->mMaxThreads &&
                 mProcess->mStarvationStartTimeMs != 0) {
             int64_t starvationTimeMs = uptimeMillis() - mProcess->mStarvationStartTimeMs;
+            mProcess->mStarvationCount++;
+            mProcess->mStarvedTimeMs += starvationTimeMs;
             if (starvationTimeMs > 100) {
                 ALOGE("binder thread pool (%zu threads) starved for %" PRId64 " ms",
                       mProcess->mMaxThreads, starvationTimeMs);
+                mProcess->growThreadPoolLocked();
             }
             mProcess->mStarvationStartTimeMs = 0;
         }
@@ -824,7 +839,22 @@ status_t IPCThreadState::transact(int32_t handle,
 
     LOG_ONEWAY(">>>> SEND from pid %d uid %d %s", getpid(), getuid(),
         (flags & TF_ONE_WAY) == 0 ? "READ REPLY" : "ONE WAY");
-    err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
+    const bool batched = (flags & TF_ONE_WAY) != 0 && mOnewayBatchDepth > 0;
+    if (batched) {
+        // The driver only reads the transaction buffer when the batch is
+        // flushed, so it must outlive the caller's Parcel.
+        auto copy = std::make_unique<Parcel>();
+        err = copy->appendFrom(&data, 0, data.dataSize());
+        if (err == NO_ERROR) {
+            err = writeTransactionData(BC_TRANSACTION, flags, handle, code, *copy, nullptr);
+        }
+        if (err == NO_ERROR) {
+            mBatchedOnewayData.push_back(std::move(copy));
+        }
+    } else {
+        if ((flags & TF_ONE_WAY) == 0) flushOnewayBatch();
+        err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
+    }
 
     if (err != NO_ERROR) {
         if (reply) reply->setError(err);
@@ -849,12 +879,22 @@ status_t IPCThreadState::transact(int32_t handle,
             ALOGI(">>>>>> CALLING transaction %d", code);
         }
         #endif
+        const bool profiled = binder::debug::LatencyProfile::isEnabled();
+        const nsecs_t start = profiled ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
         if (reply) {
             err = waitForResponse(reply);
         } else {
             Parcel fakeReply;
             err = waitForResponse(&fakeReply);
         }
+        if (profiled) {
+            size_t descriptorLen = 0;
+            const char16_t* descriptor = data.peekInterfaceToken(&descriptorLen);
+            binder::debug::LatencyProfile::record(binder::debug::LatencyProfile::Side::CLIENT,
+                                                  descriptor ? descriptor : u"",
+                                                  descriptor ? descriptorLen : 0, code,
+                                                  systemTime(SYSTEM_TIME_MONOTONIC) - start);
+        }
         #if 0
         if (code == 4) { // relayout
             ALOGI("<<<<<< RETURNING transaction 4");
@@ -874,6 +914,11 @@ status_t IPCThreadState::transact(int32_t handle,
             std::string message = logStream.str();
             ALOGI("%s", message.c_str());
         }
+    } else if (batched) {
+        if (mBatchedOnewayData.size() >= kMaxBatchedOnewayTransactions) {
+            flushOnewayBatch();
+        }
+        err = NO_ERROR;
     } else {
         err = waitForResponse(nullptr, nullptr);
     }
@@ -881,6 +926,33 @@ status_t IPCThreadState::transact(int32_t handle,
     return err;
 }
 
+void IPCThreadState::beginOnewayBatch()
+{
+    mOnewayBatchDepth++;
+}
+
+status_t IPCThreadState::endOnewayBatch()
+{
+    LOG_ALWAYS_FATAL_IF(mOnewayBatchDepth == 0, "endOnewayBatch() without beginOnewayBatch()");
+    if (--mOnewayBatchDepth > 0) return NO_ERROR;
+    flushOnewayBatch();
+    return std::exchange(mOnewayBatchError, NO_ERROR);
+}
+
+void IPCThreadState::flushOnewayBatch()
+{
+    // The first waitForResponse() writes every queued BC_TRANSACTION; the
+    // driver acknowledges each with its own BR_TRANSACTION_COMPLETE, which
+    // the later calls usually find already read into mIn.
+    for (size_t i = 0; i < mBatchedOnewayData.size(); i++) {
+        status_t err = waitForResponse(nullptr, nullptr);
+        if (err != NO_ERROR && mOnewayBatchError == NO_ERROR) {
+            mOnewayBatchError = err;
+        }
+    }
+    mBatchedOnewayData.clear();
+}
+
 void IPCThreadState::incStrongHandle(int32_t handle, BpBinder *proxy)
 {
     LOG_REMOTEREFS("IPCThreadState::incStrongHandle(%d)\n", handle);
@@ -979,7 +1051,9 @@ IPCThreadState::IPCThreadState()
         mIsFlushing(false),
         mStrictModePolicy(0),
         mLastTransactionBinderFlags(0),
-        mCallRestriction(mProcess->mCallRestriction) {
+        mCallRestriction(mProcess->mCallRestriction),
+        mOnewayBatchDepth(0),
+        mOnewayBatchError(NO_ERROR) {
     pthread_setspecific(gTLS, this);
     clearCaller();
     mHasExplicitIdentity = false;
@@ -1419,9 +1493,18 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 // safely acquire a strong reference before doing anything else with it.
                 if (reinterpret_cast<RefBase::weakref_type*>(
                         tr.target.ptr)->attemptIncStrong(this)) {
-                    error = reinterpret_cast<BBinder*>(tr.cookie)->transact(tr.code, buffer,
-                            &reply, tr.flags);
-                    reinterpret_cast<BBinder*>(tr.cookie)->decStrong(this);
+                    BBinder* target = reinterpret_cast<BBinder*>(tr.cookie);
+                    const bool profiled = binder::debug::LatencyProfile::isEnabled();
+                    const nsecs_t start = profiled ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+                    error = target->transact(tr.code, buffer, &reply, tr.flags);
+                    if (profiled) {
+                        const String16& descriptor = target->getInterfaceDescriptor();
+                        binder::debug::LatencyProfile::record(
+                                binder::debug::LatencyProfile::Side::SERVER, descriptor.string(),
+                                descriptor.size(), tr.code,
+                                systemTime(SYSTEM_TIME_MONOTONIC) - start);
+                    }
+                    target->decStrong(this);
                 } else {
                     error = UNKNOWN_TRANSACTION;
                 }
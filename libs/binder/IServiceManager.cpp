@@ -21,6 +21,9 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <set>
+
 #include <android-base/properties.h>
 #include <android/os/BnServiceCallback.h>
 #include <android/os/IServiceManager.h>
@@ -134,8 +137,49 @@ protected:
     virtual Status realGetService(const std::string& name, sp<IBinder>* _aidl_return) {
         return mTheRealServiceManager->getService(name, _aidl_return);
     }
+
+private:
+    // Drops entries of the lookup cache when servicemanager reports a new registration for a
+    // cached name or when a cached service dies.
+    class LookupCacheInvalidator : public android::os::BnServiceCallback,
+                                   public IBinder::DeathRecipient {
+    public:
+        explicit LookupCacheInvalidator(const wp<ServiceManagerShim>& sm) : mSm(sm) {}
+        Status onRegistration(const std::string& name, const sp<IBinder>& binder) override {
+            if (sp<ServiceManagerShim> sm = mSm.promote()) sm->cacheService(name, binder);
+            return Status::ok();
+        }
+        void binderDied(const wp<IBinder>& who) override {
+            if (sp<ServiceManagerShim> sm = mSm.promote()) sm->uncacheService(who);
+        }
+
+    private:
+        wp<ServiceManagerShim> mSm;
+    };
+
+    sp<IBinder> lookupCachedService(const std::string& name) const;
+    void cacheService(const std::string& name, const sp<IBinder>& binder) const;
+    void uncacheService(const wp<IBinder>& binder) const;
+
+    // Results of checkService. Entries are weak so that the cache never keeps a lazy service
+    // running, which means a lookup only hits while the process still holds the service.
+    mutable std::mutex mLookupCacheLock;
+    mutable std::map<std::string, wp<IBinder>> mLookupCache;
+    // Cached names for which a registration callback has been installed.
+    mutable std::set<std::string> mLookupCacheWatchedNames;
+    mutable sp<LookupCacheInvalidator> mLookupCacheInvalidator;
 };
 
+static std::atomic<uint64_t> gLookupCacheHits = 0;
+static std::atomic<uint64_t> gLookupCacheMisses = 0;
+
+ServiceLookupCacheStats getServiceLookupCacheStats() {
+    return ServiceLookupCacheStats{
+            .hits = gLookupCacheHits.load(std::memory_order_relaxed),
+            .misses = gLookupCacheMisses.load(std::memory_order_relaxed),
+    };
+}
+
 [[clang::no_destroy]] static std::once_flag gSmOnce;
 [[clang::no_destroy]] static sp<IServiceManager> gDefaultServiceManager;
 
@@ -317,18 +361,102 @@ sp<IBinder> ServiceManagerShim::getService(const String16& name) const
 
 sp<IBinder> ServiceManagerShim::checkService(const String16& name) const
 {
+    const std::string nameStr = String8(name).c_str();
+    if (sp<IBinder> cached = lookupCachedService(nameStr); cached != nullptr) {
+        return cached;
+    }
+
     sp<IBinder> ret;
-    if (!mTheRealServiceManager->checkService(String8(name).c_str(), &ret).isOk()) {
+    if (!mTheRealServiceManager->checkService(nameStr, &ret).isOk()) {
         return nullptr;
     }
+    cacheService(nameStr, ret);
     return ret;
 }
 
+sp<IBinder> ServiceManagerShim::lookupCachedService(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mLookupCacheLock);
+    auto it = mLookupCache.find(name);
+    if (it != mLookupCache.end()) {
+        // Only remote binders are cached, and BpBinder extends its lifetime to weak, so the
+        // object is still valid here. Once the last strong reference is gone its death
+        // notifications are unlinked and it can't be promoted anymore, so treat it as stale.
+        IBinder* binder = it->second.unsafe_get();
+        if (binder != nullptr && binder->getStrongCount() > 0) {
+            sp<IBinder> promoted = it->second.promote();
+            if (promoted != nullptr && promoted->isBinderAlive()) {
+                gLookupCacheHits.fetch_add(1, std::memory_order_relaxed);
+                return promoted;
+            }
+        }
+        mLookupCache.erase(it);
+    }
+    gLookupCacheMisses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void ServiceManagerShim::cacheService(const std::string& name, const sp<IBinder>& binder) const {
+    // Death and registration notifications arrive on the threadpool. Without one, a cached
+    // service could outlive its registration unnoticed.
+    if (binder == nullptr || binder->remoteBinder() == nullptr ||
+        ProcessState::self()->getThreadPoolMaxTotalThreadCount() == 0) {
+        return;
+    }
+
+    bool watch = false;
+    sp<LookupCacheInvalidator> invalidator;
+    {
+        std::lock_guard<std::mutex> lock(mLookupCacheLock);
+        if (mLookupCacheInvalidator == nullptr) {
+            mLookupCacheInvalidator = sp<LookupCacheInvalidator>::make(
+                    wp<ServiceManagerShim>::fromExisting(const_cast<ServiceManagerShim*>(this)));
+        }
+        invalidator = mLookupCacheInvalidator;
+
+        auto it = mLookupCache.find(name);
+        if (it != mLookupCache.end() && it->second.unsafe_get() == binder.get()) return;
+        watch = mLookupCacheWatchedNames.insert(name).second;
+    }
+
+    if (binder->linkToDeath(invalidator) != OK) return;
+    {
+        std::lock_guard<std::mutex> lock(mLookupCacheLock);
+        mLookupCache[name] = binder;
+    }
+
+    if (watch) {
+        if (Status status = mTheRealServiceManager->registerForNotifications(name, invalidator);
+            !status.isOk()) {
+            ALOGW("Failed to registerForNotifications for lookup cache of %s: %s", name.c_str(),
+                  status.toString8().c_str());
+            std::lock_guard<std::mutex> lock(mLookupCacheLock);
+            mLookupCache.erase(name);
+            mLookupCacheWatchedNames.erase(name);
+        }
+    }
+}
+
+void ServiceManagerShim::uncacheService(const wp<IBinder>& binder) const {
+    std::lock_guard<std::mutex> lock(mLookupCacheLock);
+    for (auto it = mLookupCache.begin(); it != mLookupCache.end();) {
+        if (it->second == binder) {
+            it = mLookupCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 status_t ServiceManagerShim::addService(const String16& name, const sp<IBinder>& service,
                                         bool allowIsolated, int dumpsysPriority)
 {
-    Status status = mTheRealServiceManager->addService(
-        String8(name).c_str(), service, allowIsolated, dumpsysPriority);
+    const std::string nameStr = String8(name).c_str();
+    {
+        std::lock_guard<std::mutex> lock(mLookupCacheLock);
+        mLookupCache.erase(nameStr);
+    }
+    Status status =
+            mTheRealServiceManager->addService(nameStr, service, allowIsolated, dumpsysPriority);
     return status.exceptionCode();
 }
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <binder/LazyServiceRegistrar.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+namespace android {
+namespace binder {
+namespace internal {
+
+/**
+ * Tracks when a lazy service process goes idle and gets a client again, to decide how long to
+ * hold it after it goes idle. See LazyServiceRegistrar::setIdleHold. Not thread safe.
+ */
+class IdleHoldTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void setHold(std::chrono::milliseconds minHold, std::chrono::milliseconds maxHold) {
+        mMinHold = minHold;
+        mMaxHold = maxHold;
+    }
+
+    /**
+     * Records that the services of the process lost their last client.
+     */
+    void onIdle(Clock::time_point now) {
+        mStats.deactivations++;
+        mIdleSince = now;
+    }
+
+    /**
+     * Records that a service of the process got a client, and whether the process was being
+     * held after going idle.
+     */
+    void onActive(Clock::time_point now, bool held) {
+        mStats.activations++;
+        if (held) {
+            mStats.holdsReused++;
+        }
+        if (mIdleSince) {
+            // Weigh recent idle times more, so that the prediction follows changes in usage.
+            const Clock::duration idleTime = now - *mIdleSince;
+            mAverageIdleTime =
+                    mAverageIdleTime ? (*mAverageIdleTime * 3 + idleTime) / 4 : idleTime;
+            mIdleSince.reset();
+        }
+    }
+
+    /**
+     * How long to hold the process after it goes idle.
+     */
+    std::chrono::milliseconds getHold() const {
+        if (mMinHold == mMaxHold) {
+            return mMinHold;
+        }
+        // The process exits at the end of a hold, so an idle time longer than the hold is never
+        // seen. Until some idle time was seen, hold for as long as allowed.
+        if (!mAverageIdleTime) {
+            return mMaxHold;
+        }
+        // Leave some slack, as the idle time is only an average.
+        const auto predicted =
+                std::chrono::duration_cast<std::chrono::milliseconds>(*mAverageIdleTime * 3 / 2);
+        if (predicted > mMaxHold) {
+            return mMinHold;
+        }
+        return std::max(predicted, mMinHold);
+    }
+
+    LazyServiceRegistrar::Stats& stats() { return mStats; }
+
+private:
+    std::chrono::milliseconds mMinHold{0};
+    std::chrono::milliseconds mMaxHold{0};
+
+    // when the process last went idle, and a moving average of how long it stayed idle
+    std::optional<Clock::time_point> mIdleSince;
+    std::optional<Clock::duration> mAverageIdleTime;
+
+    LazyServiceRegistrar::Stats mStats;
+};
+
+} // namespace internal
+} // namespace binder
+} // namespace android
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatencyProfile"
+
+#include <binder/LatencyProfile.h>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <utils/String8.h>
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+namespace android::binder::debug {
+
+using Side = LatencyProfile::Side;
+using Histogram = LatencyProfile::Histogram;
+
+namespace {
+
+struct Entry {
+    Entry(Side side, std::u16string_view descriptor, uint32_t code)
+          : side(side), descriptor(descriptor.data(), descriptor.size()), code(code) {}
+
+    bool matches(Side s, std::u16string_view d, uint32_t c) const {
+        return side == s && code == c &&
+                std::u16string_view(descriptor.string(), descriptor.size()) == d;
+    }
+
+    const Side side;
+    const String16 descriptor;
+    const uint32_t code;
+
+    // Only written by the owning thread, read by snapshot().
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> totalNs = 0;
+    std::atomic<uint64_t> maxNs = 0;
+    std::array<std::atomic<uint64_t>, LatencyProfile::kBucketCount> buckets{};
+};
+
+// Entries recorded by one thread. The owner looks entries up without locking and only takes
+// mLock to insert, which is what snapshot() takes to read the table from another thread.
+class ThreadTable {
+public:
+    Entry* find(size_t hash, Side side, std::u16string_view descriptor, uint32_t code) {
+        auto it = mEntries.find(hash);
+        if (it == mEntries.end()) return nullptr;
+        for (const auto& entry : it->second) {
+            if (entry->matches(side, descriptor, code)) return entry.get();
+        }
+        return nullptr;
+    }
+
+    Entry* insert(size_t hash, Side side, std::u16string_view descriptor, uint32_t code) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto& bucket = mEntries[hash];
+        bucket.push_back(std::make_unique<Entry>(side, descriptor, code));
+        return bucket.back().get();
+    }
+
+    template <typename F>
+    void forEach(F&& f) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const auto& [hash, bucket] : mEntries) {
+            for (const auto& entry : bucket) f(*entry);
+        }
+    }
+
+private:
+    std::mutex mLock;
+    std::unordered_map<size_t, std::vector<std::unique_ptr<Entry>>> mEntries;
+};
+
+using MergeKey = std::tuple<Side, std::u16string, uint32_t>;
+
+void mergeInto(std::map<MergeKey, Histogram>* merged, const Entry& entry) {
+    MergeKey key{entry.side, std::u16string(entry.descriptor.string(), entry.descriptor.size()),
+                 entry.code};
+    auto [it, inserted] = merged->try_emplace(key);
+    Histogram& h = it->second;
+    if (inserted) {
+        h.side = entry.side;
+        h.descriptor = entry.descriptor;
+        h.code = entry.code;
+        h.count = 0;
+        h.totalNs = 0;
+        h.maxNs = 0;
+        h.buckets = {};
+    }
+    h.count += entry.count.load(std::memory_order_relaxed);
+    h.totalNs += entry.totalNs.load(std::memory_order_relaxed);
+    h.maxNs = std::max(h.maxNs, entry.maxNs.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < LatencyProfile::kBucketCount; i++) {
+        h.buckets[i] += entry.buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+// All live thread tables, plus what threads that have exited recorded.
+struct Registry {
+    std::mutex lock;
+    std::vector<ThreadTable*> live;
+    std::map<MergeKey, Histogram> retired;
+};
+
+Registry& registry() {
+    [[clang::no_destroy]] static Registry sRegistry;
+    return sRegistry;
+}
+
+class ThreadTableHolder {
+public:
+    ~ThreadTableHolder() {
+        mDestroyed = true;
+        if (mTable == nullptr) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.lock);
+        r.live.erase(std::remove(r.live.begin(), r.live.end(), mTable.get()), r.live.end());
+        mTable->forEach([&](const Entry& entry) { mergeInto(&r.retired, entry); });
+    }
+
+    // Returns nullptr once the thread is exiting.
+    ThreadTable* get() {
+        if (mDestroyed) return nullptr;
+        if (mTable == nullptr) {
+            mTable = std::make_unique<ThreadTable>();
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.lock);
+            r.live.push_back(mTable.get());
+        }
+        return mTable.get();
+    }
+
+private:
+    std::unique_ptr<ThreadTable> mTable;
+    bool mDestroyed = false;
+};
+
+thread_local ThreadTableHolder gThreadTable;
+
+size_t bucketFor(nsecs_t elapsed) {
+    uint64_t us = static_cast<uint64_t>(std::max<nsecs_t>(elapsed, 0)) / 1000;
+    size_t bucket = 0;
+    while (us > 1 && bucket + 1 < LatencyProfile::kBucketCount) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+uint64_t percentileUs(const Histogram& h, uint64_t permille) {
+    uint64_t target = (h.count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LatencyProfile::kBucketCount; i++) {
+        seen += h.buckets[i];
+        // Report the upper bound of the bucket the percentile falls into.
+        if (seen >= target) return uint64_t{1} << (i + 1);
+    }
+    return uint64_t{1} << LatencyProfile::kBucketCount;
+}
+
+} // namespace
+
+void LatencyProfile::setEnabled(bool enabled) {
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void LatencyProfile::record(Side side, const char16_t* descriptor, size_t descriptorLen,
+                            uint32_t code, nsecs_t elapsed) {
+    std::u16string_view view(descriptor, descriptorLen);
+    size_t hash = std::hash<std::u16string_view>{}(view) ^
+            (static_cast<size_t>(code) * 31 + static_cast<size_t>(side));
+
+    ThreadTable* table = gThreadTable.get();
+    if (table == nullptr) return;
+    Entry* entry = table->find(hash, side, view, code);
+    if (entry == nullptr) entry = table->insert(hash, side, view, code);
+
+    uint64_t ns = static_cast<uint64_t>(std::max<nsecs_t>(elapsed, 0));
+    entry->count.fetch_add(1, std::memory_order_relaxed);
+    entry->totalNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > entry->maxNs.load(std::memory_order_relaxed)) {
+        entry->maxNs.store(ns, std::memory_order_relaxed);
+    }
+    entry->buckets[bucketFor(elapsed)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<Histogram> LatencyProfile::snapshot() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    std::map<MergeKey, Histogram> merged = r.retired;
+    for (ThreadTable* table : r.live) {
+        table->forEach([&](const Entry& entry) { mergeInto(&merged, entry); });
+    }
+
+    std::vector<Histogram> ret;
+    ret.reserve(merged.size());
+    for (auto& [key, histogram] : merged) ret.push_back(std::move(histogram));
+    return ret;
+}
+
+status_t LatencyProfile::dump(int fd) {
+    std::string out = base::StringPrintf("Binder latency profile (%s)\n",
+                                         isEnabled() ? "enabled" : "disabled");
+    for (const Histogram& h : snapshot()) {
+        if (h.count == 0) continue;
+        base::StringAppendF(&out,
+                            "  %s %s code %u: count %" PRIu64 " avg %" PRIu64 "us p50 <%" PRIu64
+                            "us p90 <%" PRIu64 "us p99 <%" PRIu64 "us max %" PRIu64 "us\n",
+                            h.side == Side::CLIENT ? "client" : "server",
+                            h.descriptor.size() == 0 ? "<no descriptor>"
+                                                     : String8(h.descriptor).c_str(),
+                            h.code, h.count, h.totalNs / h.count / 1000, percentileUs(h, 500),
+                            percentileUs(h, 900), percentileUs(h, 990), h.maxNs / 1000);
+    }
+    return base::WriteStringToFd(out, fd) ? OK : -errno;
+}
+
+} // namespace android::binder::debug
@@ -24,11 +24,17 @@
 #include <android/os/IServiceManager.h>
 #include <utils/Log.h>
 
+#include <condition_variable>
+#include <thread>
+
+#include "IdleHoldTracker.h"
+
 namespace android {
 namespace binder {
 namespace internal {
 
 using AidlServiceManager = android::os::IServiceManager;
+using Clock = std::chrono::steady_clock;
 
 class ClientCounterCallbackImpl : public ::android::os::BnClientCallback {
 public:
@@ -44,6 +50,10 @@ public:
 
     void reRegisterLocked();
 
+    void setIdleHold(std::chrono::milliseconds minHold, std::chrono::milliseconds maxHold);
+
+    LazyServiceRegistrar::Stats getStats();
+
 protected:
     Status onClients(const sp<IBinder>& service, bool clients) override;
 
@@ -81,6 +91,11 @@ private:
      */
     void maybeTryShutdownLocked();
 
+    /**
+     * Shuts down once mHoldDeadline is reached, unless a client came back in the meantime.
+     */
+    void holdLoop();
+
     // for below
     std::mutex mMutex;
 
@@ -97,6 +112,14 @@ private:
 
     // Callback used to report if there are services with clients
     std::function<bool(bool)> mActiveServicesCallback;
+
+    // how long the process stayed idle, and the activity stats
+    IdleHoldTracker mIdleHold;
+
+    // when to shut down if the process stays idle, and the thread waiting for it
+    std::optional<Clock::time_point> mHoldDeadline;
+    std::condition_variable mHoldCondition;
+    bool mHoldThreadStarted = false;
 };
 
 class ClientCounterCallback {
@@ -117,6 +140,10 @@ public:
 
     void reRegister();
 
+    void setIdleHold(std::chrono::milliseconds minHold, std::chrono::milliseconds maxHold);
+
+    LazyServiceRegistrar::Stats getStats() const;
+
 private:
     sp<ClientCounterCallbackImpl> mImpl;
 };
@@ -236,10 +263,56 @@ void ClientCounterCallbackImpl::maybeTryShutdownLocked() {
     // client count change event, try to shutdown the process if its services
     // have no clients.
     if (!handledInCallback && mNumConnectedServices == 0) {
+        if (std::chrono::milliseconds hold = mIdleHold.getHold(); hold.count() > 0) {
+            ALOGI("Holding the process for %lld ms before shutting down.",
+                  static_cast<long long>(hold.count()));
+            mHoldDeadline = Clock::now() + hold;
+            if (!mHoldThreadStarted) {
+                std::thread(&ClientCounterCallbackImpl::holdLoop,
+                            sp<ClientCounterCallbackImpl>::fromExisting(this))
+                        .detach();
+                mHoldThreadStarted = true;
+            }
+            mHoldCondition.notify_one();
+            return;
+        }
         tryShutdownLocked();
     }
 }
 
+void ClientCounterCallbackImpl::holdLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        if (!mHoldDeadline) {
+            mHoldCondition.wait(lock);
+            continue;
+        }
+        if (Clock::now() < *mHoldDeadline) {
+            mHoldCondition.wait_until(lock, *mHoldDeadline);
+            continue;
+        }
+        mHoldDeadline.reset();
+        if (mNumConnectedServices == 0 && !mForcePersist) {
+            tryShutdownLocked();
+        }
+    }
+}
+
+void ClientCounterCallbackImpl::setIdleHold(std::chrono::milliseconds minHold,
+                                            std::chrono::milliseconds maxHold) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    LOG_ALWAYS_FATAL_IF(minHold.count() < 0 || maxHold < minHold,
+                        "Invalid idle hold: min %lld ms, max %lld ms",
+                        static_cast<long long>(minHold.count()),
+                        static_cast<long long>(maxHold.count()));
+    mIdleHold.setHold(minHold, maxHold);
+}
+
+LazyServiceRegistrar::Stats ClientCounterCallbackImpl::getStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIdleHold.stats();
+}
+
 Status ClientCounterCallbackImpl::onClients(const sp<IBinder>& service, bool clients) {
     std::lock_guard<std::mutex> lock(mMutex);
     auto & [name, registered] = *assertRegisteredService(service);
@@ -256,6 +329,14 @@ Status ClientCounterCallbackImpl::onClients(const sp<IBinder>& service, bool cli
              (void) name;
              if (registered.clients) numWithClients++;
          }
+         if ((numWithClients == 0) != (mNumConnectedServices == 0)) {
+             if (numWithClients == 0) {
+                 mIdleHold.onIdle(Clock::now());
+             } else {
+                 mIdleHold.onActive(Clock::now(), mHoldDeadline.has_value());
+                 mHoldDeadline.reset();
+             }
+         }
          mNumConnectedServices = numWithClients;
     }
 
@@ -268,12 +349,17 @@ Status ClientCounterCallbackImpl::onClients(const sp<IBinder>& service, bool cli
 
 void ClientCounterCallbackImpl::tryShutdownLocked() {
     ALOGI("Trying to shut down the service. No clients in use for any service in process.");
+    LazyServiceRegistrar::Stats& stats = mIdleHold.stats();
+    stats.shutdownAttempts++;
 
     if (tryUnregisterLocked()) {
-        ALOGI("Unregistered all clients and exiting");
+        ALOGI("Unregistered all clients and exiting after %zu activation(s), %zu reused while "
+              "held, %zu aborted shutdown(s)",
+              stats.activations, stats.holdsReused, stats.shutdownsAborted);
         exit(EXIT_SUCCESS);
     }
 
+    stats.shutdownsAborted++;
     reRegisterLocked();
 }
 
@@ -313,6 +399,15 @@ void ClientCounterCallback::reRegister() {
     mImpl->reRegisterLocked();
 }
 
+void ClientCounterCallback::setIdleHold(std::chrono::milliseconds minHold,
+                                        std::chrono::milliseconds maxHold) {
+    mImpl->setIdleHold(minHold, maxHold);
+}
+
+LazyServiceRegistrar::Stats ClientCounterCallback::getStats() const {
+    return mImpl->getStats();
+}
+
 }  // namespace internal
 
 LazyServiceRegistrar::LazyServiceRegistrar() {
@@ -349,5 +444,14 @@ void LazyServiceRegistrar::reRegister() {
     mClientCC->reRegister();
 }
 
+void LazyServiceRegistrar::setIdleHold(std::chrono::milliseconds minHold,
+                                       std::chrono::milliseconds maxHold) {
+    mClientCC->setIdleHold(minHold, maxHold);
+}
+
+LazyServiceRegistrar::Stats LazyServiceRegistrar::getStats() const {
+    return mClientCC->getStats();
+}
+
 }  // namespace hardware
 }  // namespace android
@@ -24,6 +24,8 @@
 #include <utils/SortedVector.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,75 +39,9 @@
 #include <sys/mman.h>
 #include <sys/file.h>
 
-namespace android {
-// ----------------------------------------------------------------------------
-
-/*
- * A simple templatized doubly linked-list implementation
- */
-
-template <typename NODE>
-class LinkedList
-{
-    NODE*  mFirst;
-    NODE*  mLast;
-
-public:
-                LinkedList() : mFirst(nullptr), mLast(nullptr) { }
-    bool        isEmpty() const { return mFirst == nullptr; }
-    NODE const* head() const { return mFirst; }
-    NODE*       head() { return mFirst; }
-    NODE const* tail() const { return mLast; }
-    NODE*       tail() { return mLast; }
-
-    void insertAfter(NODE* node, NODE* newNode) {
-        newNode->prev = node;
-        newNode->next = node->next;
-        if (node->next == nullptr) mLast = newNode;
-        else                 node->next->prev = newNode;
-        node->next = newNode;
-    }
-
-    void insertBefore(NODE* node, NODE* newNode) {
-         newNode->prev = node->prev;
-         newNode->next = node;
-         if (node->prev == nullptr)   mFirst = newNode;
-         else                   node->prev->next = newNode;
-         node->prev = newNode;
-    }
-
-    void insertHead(NODE* newNode) {
-        if (mFirst == nullptr) {
-            mFirst = mLast = newNode;
-            newNode->prev = newNode->next = nullptr;
-        } else {
-            newNode->prev = nullptr;
-            newNode->next = mFirst;
-            mFirst->prev = newNode;
-            mFirst = newNode;
-        }
-    }
-
-    void insertTail(NODE* newNode) {
-        if (mLast == 0) {
-            insertHead(newNode);
-        } else {
-            newNode->prev = mLast;
-            newNode->next = 0;
-            mLast->next = newNode;
-            mLast = newNode;
-        }
-    }
-
-    NODE* remove(NODE* node) {
-        if (node->prev == nullptr)    mFirst = node->next;
-        else                    node->prev->next = node->next;
-        if (node->next == nullptr)    mLast = node->prev;
-        else                    node->next->prev = node->prev;
-        return node;
-    }
-};
+#include "SimpleBestFitAllocator.h"
 
+namespace android {
 // ----------------------------------------------------------------------------
 
 class Allocation : public MemoryBase {
@@ -119,49 +55,6 @@ private:
 
 // ----------------------------------------------------------------------------
 
-class SimpleBestFitAllocator
-{
-    enum {
-        PAGE_ALIGNED = 0x00000001
-    };
-public:
-    explicit SimpleBestFitAllocator(size_t size);
-    ~SimpleBestFitAllocator();
-
-    size_t      allocate(size_t size, uint32_t flags = 0);
-    status_t    deallocate(size_t offset);
-    size_t      size() const;
-    void        dump(const char* what) const;
-    void        dump(String8& res, const char* what) const;
-
-    static size_t getAllocationAlignment() { return kMemoryAlign; }
-
-private:
-
-    struct chunk_t {
-        chunk_t(size_t start, size_t size)
-        : start(start), size(size), free(1), prev(nullptr), next(nullptr) {
-        }
-        size_t              start;
-        size_t              size : 28;
-        int                 free : 4;
-        mutable chunk_t*    prev;
-        mutable chunk_t*    next;
-    };
-
-    ssize_t  alloc(size_t size, uint32_t flags);
-    chunk_t* dealloc(size_t start);
-    void     dump_l(const char* what) const;
-    void     dump_l(String8& res, const char* what) const;
-
-    static const int    kMemoryAlign;
-    mutable Mutex       mLock;
-    LinkedList<chunk_t> mList;
-    size_t              mHeapSize;
-};
-
-// ----------------------------------------------------------------------------
-
 Allocation::Allocation(
         const sp<MemoryDealer>& dealer,
         const sp<IMemoryHeap>& heap, ssize_t offset, size_t size)
@@ -281,6 +174,9 @@ SimpleBestFitAllocator::SimpleBestFitAllocator(size_t size)
 
     chunk_t* node = new chunk_t(0, mHeapSize / kMemoryAlign);
     mList.insertHead(node);
+    if (node->size) {
+        insertFree(node);
+    }
 }
 
 SimpleBestFitAllocator::~SimpleBestFitAllocator()
@@ -320,102 +216,154 @@ status_t SimpleBestFitAllocator::deallocate(size_t offset)
     return NAME_NOT_FOUND;
 }
 
+size_t SimpleBestFitAllocator::binIndex(size_t size)
+{
+    return kBinCount - 1 - __builtin_clzl(size);
+}
+
+void SimpleBestFitAllocator::insertFree(chunk_t* chunk)
+{
+    const size_t bin = binIndex(chunk->size);
+    chunk->free = 1;
+    chunk->freePrev = nullptr;
+    chunk->freeNext = mBins[bin];
+    if (mBins[bin]) {
+        mBins[bin]->freePrev = chunk;
+    }
+    mBins[bin] = chunk;
+    mBinMask |= size_t(1) << bin;
+}
+
+void SimpleBestFitAllocator::removeFree(chunk_t* chunk)
+{
+    const size_t bin = binIndex(chunk->size);
+    if (chunk->freePrev) {
+        chunk->freePrev->freeNext = chunk->freeNext;
+    } else {
+        mBins[bin] = chunk->freeNext;
+    }
+    if (chunk->freeNext) {
+        chunk->freeNext->freePrev = chunk->freePrev;
+    }
+    chunk->freePrev = chunk->freeNext = nullptr;
+    if (!mBins[bin]) {
+        mBinMask &= ~(size_t(1) << bin);
+    }
+}
+
+size_t SimpleBestFitAllocator::alignmentPadding(const chunk_t* chunk, uint32_t flags) const
+{
+    if (!(flags & PAGE_ALIGNED)) {
+        return 0;
+    }
+    const size_t pagesize = getpagesize();
+    return -chunk->start & ((pagesize/kMemoryAlign)-1);
+}
+
+SimpleBestFitAllocator::chunk_t* SimpleBestFitAllocator::findFree(size_t size,
+        uint32_t flags) const
+{
+    // The bin of the requested size may hold smaller chunks, so look for the
+    // best fit in it. Chunks of any larger bin fit, unless they need padding.
+    const size_t first = binIndex(size);
+    chunk_t* best = nullptr;
+    for (chunk_t* cur = mBins[first]; cur; cur = cur->freeNext) {
+        if (cur->size >= size + alignmentPadding(cur, flags) &&
+                (!best || cur->size < best->size)) {
+            best = cur;
+            if (cur->size == size) break;
+        }
+    }
+    if (best) {
+        return best;
+    }
+
+    size_t mask = first + 1 < kBinCount ? mBinMask & (~size_t(0) << (first + 1)) : 0;
+    while (mask) {
+        const size_t bin = __builtin_ctzl(mask);
+        for (chunk_t* cur = mBins[bin]; cur; cur = cur->freeNext) {
+            if (cur->size >= size + alignmentPadding(cur, flags)) {
+                return cur;
+            }
+        }
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
 ssize_t SimpleBestFitAllocator::alloc(size_t size, uint32_t flags)
 {
     if (size == 0) {
         return 0;
     }
     size = (size + kMemoryAlign-1) / kMemoryAlign;
-    chunk_t* free_chunk = nullptr;
-    chunk_t* cur = mList.head();
 
-    size_t pagesize = getpagesize();
-    while (cur) {
-        int extra = 0;
-        if (flags & PAGE_ALIGNED)
-            extra = ( -cur->start & ((pagesize/kMemoryAlign)-1) ) ;
-
-        // best fit
-        if (cur->free && (cur->size >= (size+extra))) {
-            if ((!free_chunk) || (cur->size < free_chunk->size)) {
-                free_chunk = cur;
-            }
-            if (cur->size == size) {
-                break;
-            }
-        }
-        cur = cur->next;
+    chunk_t* free_chunk = findFree(size, flags);
+    if (!free_chunk) {
+        return NO_MEMORY;
     }
 
-    if (free_chunk) {
-        const size_t free_size = free_chunk->size;
-        free_chunk->free = 0;
-        free_chunk->size = size;
-        if (free_size > size) {
-            int extra = 0;
-            if (flags & PAGE_ALIGNED)
-                extra = ( -free_chunk->start & ((pagesize/kMemoryAlign)-1) ) ;
-            if (extra) {
-                chunk_t* split = new chunk_t(free_chunk->start, extra);
-                free_chunk->start += extra;
-                mList.insertBefore(free_chunk, split);
-            }
+    removeFree(free_chunk);
+    const size_t free_size = free_chunk->size;
+    const size_t extra = alignmentPadding(free_chunk, flags);
+    free_chunk->free = 0;
+    free_chunk->size = size;
+    if (extra) {
+        chunk_t* split = new chunk_t(free_chunk->start, extra);
+        free_chunk->start += extra;
+        mList.insertBefore(free_chunk, split);
+        insertFree(split);
+    }
 
-            ALOGE_IF((flags&PAGE_ALIGNED) && 
-                    ((free_chunk->start*kMemoryAlign)&(pagesize-1)),
-                    "PAGE_ALIGNED requested, but page is not aligned!!!");
+    ALOGE_IF((flags&PAGE_ALIGNED) &&
+            ((free_chunk->start*kMemoryAlign)&(getpagesize()-1)),
+            "PAGE_ALIGNED requested, but page is not aligned!!!");
 
-            const ssize_t tail_free = free_size - (size+extra);
-            if (tail_free > 0) {
-                chunk_t* split = new chunk_t(
-                        free_chunk->start + free_chunk->size, tail_free);
-                mList.insertAfter(free_chunk, split);
-            }
-        }
-        return (free_chunk->start)*kMemoryAlign;
+    const size_t tail_free = free_size - (size+extra);
+    if (tail_free > 0) {
+        chunk_t* split = new chunk_t(free_chunk->start + free_chunk->size, tail_free);
+        mList.insertAfter(free_chunk, split);
+        insertFree(split);
     }
-    return NO_MEMORY;
+
+    mAllocated.emplace(free_chunk->start, free_chunk);
+    return (free_chunk->start)*kMemoryAlign;
 }
 
 SimpleBestFitAllocator::chunk_t* SimpleBestFitAllocator::dealloc(size_t start)
 {
     start = start / kMemoryAlign;
-    chunk_t* cur = mList.head();
-    while (cur) {
-        if (cur->start == start) {
-            LOG_FATAL_IF(cur->free,
-                "block at offset 0x%08lX of size 0x%08X already freed",
+    auto it = mAllocated.find(start);
+    if (it == mAllocated.end()) {
+        // Only walk the heap to tell a double free from a bogus offset.
+        for (chunk_t const* cur = mList.head(); cur; cur = cur->next) {
+            LOG_FATAL_IF(cur->start == start && cur->free,
+                "block at offset 0x%08zX of size 0x%08zX already freed",
                 cur->start*kMemoryAlign, cur->size*kMemoryAlign);
-
-            // merge freed blocks together
-            chunk_t* freed = cur;
-            cur->free = 1;
-            do {
-                chunk_t* const p = cur->prev;
-                chunk_t* const n = cur->next;
-                if (p && (p->free || !cur->size)) {
-                    freed = p;
-                    p->size += cur->size;
-                    mList.remove(cur);
-                    delete cur;
-                }
-                cur = n;
-            } while (cur && cur->free);
-
-            #ifndef NDEBUG
-                if (!freed->free) {
-                    dump_l("dealloc (!freed->free)");
-                }
-            #endif
-            LOG_FATAL_IF(!freed->free,
-                "freed block at offset 0x%08lX of size 0x%08X is not free!",
-                freed->start * kMemoryAlign, freed->size * kMemoryAlign);
-
-            return freed;
         }
-        cur = cur->next;
+        return nullptr;
     }
-    return nullptr;
+    chunk_t* freed = it->second;
+    mAllocated.erase(it);
+
+    // merge freed block with its free neighbors
+    chunk_t* const p = freed->prev;
+    if (p && p->free) {
+        removeFree(p);
+        p->size += freed->size;
+        mList.remove(freed);
+        delete freed;
+        freed = p;
+    }
+    chunk_t* const n = freed->next;
+    if (n && n->free) {
+        removeFree(n);
+        freed->size += n->size;
+        mList.remove(n);
+        delete n;
+    }
+    insertFree(freed);
+    return freed;
 }
 
 void SimpleBestFitAllocator::dump(const char* what) const
@@ -442,6 +390,9 @@ void SimpleBestFitAllocator::dump_l(String8& result,
         const char* what) const
 {
     size_t size = 0;
+    size_t freeSize = 0;
+    size_t largestFree = 0;
+    size_t freeCount = 0;
     int32_t i = 0;
     chunk_t const* cur = mList.head();
     
@@ -466,8 +417,13 @@ void SimpleBestFitAllocator::dump_l(String8& result,
         
         result.append(buffer);
 
-        if (!cur->free)
+        if (!cur->free) {
             size += cur->size*kMemoryAlign;
+        } else {
+            freeSize += cur->size*kMemoryAlign;
+            largestFree = std::max(largestFree, size_t(cur->size*kMemoryAlign));
+            freeCount++;
+        }
 
         i++;
         cur = cur->next;
@@ -475,6 +431,14 @@ void SimpleBestFitAllocator::dump_l(String8& result,
     snprintf(buffer, SIZE,
             "  size allocated: %u (%u KB)\n", int(size), int(size/1024));
     result.append(buffer);
+
+    // Share of the free memory that cannot serve an allocation of the whole free size.
+    const unsigned fragmentation = freeSize ? unsigned(100 - largestFree * 100 / freeSize) : 0;
+    snprintf(buffer, SIZE,
+            "  allocations: %zu, free chunks: %zu, largest free: %zu (%zu KB), "
+            "fragmentation: %u%%\n",
+            mAllocated.size(), freeCount, largestFree, largestFree/1024, fragmentation);
+    result.append(buffer);
 }
 
 
@@ -29,6 +29,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <utility>
 
 #include <binder/Binder.h>
 #include <binder/BpBinder.h>
@@ -39,6 +40,7 @@
 #include <binder/Status.h>
 #include <binder/TextOutput.h>
 
+#include <android-base/file.h>
 #include <android-base/scopeguard.h>
 #include <cutils/ashmem.h>
 #include <cutils/compiler.h>
@@ -69,6 +71,10 @@
 typedef uintptr_t binder_uintptr_t;
 #endif // BINDER_WITH_KERNEL_IPC
 
+#ifdef __BIONIC__
+#include <linux/memfd.h>
+#endif // __BIONIC__
+
 #define LOG_REFS(...)
 // #define LOG_REFS(...) ALOG(LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define LOG_ALLOC(...)
@@ -103,6 +109,78 @@ static_assert(sizeof(Parcel) == 60);
 static std::atomic<size_t> gParcelGlobalAllocCount;
 static std::atomic<size_t> gParcelGlobalAllocSize;
 
+#ifdef BINDER_WITH_KERNEL_IPC
+// Most transactions fit in a few hundred bytes. Rather than going back to
+// malloc for every data/reply Parcel, each thread keeps a couple of freed
+// buffers of this size around and hands them to the next Parcel that starts
+// writing. sizeof(Parcel) is fixed by prebuilts, so the buffer can't live
+// inline in the Parcel itself.
+constexpr size_t kSmallBufferSize = 256;
+
+// The cache itself is trivially destructible, so that Parcels freed by other
+// thread_local destructors can still use it at thread exit. A separate
+// thread_local frees the cached buffers and marks the cache as gone.
+struct SmallBufferCache {
+    uint8_t* buffers[2];
+    bool destroyed;
+};
+
+static thread_local SmallBufferCache gSmallBufferCache;
+
+struct SmallBufferCacheReleaser {
+    bool armed = false;
+    ~SmallBufferCacheReleaser() {
+        for (uint8_t*& buffer : gSmallBufferCache.buffers) {
+            free(std::exchange(buffer, nullptr));
+        }
+        gSmallBufferCache.destroyed = true;
+    }
+};
+
+static thread_local SmallBufferCacheReleaser gSmallBufferCacheReleaser;
+
+static uint8_t* takeSmallBuffer() {
+    for (uint8_t*& buffer : gSmallBufferCache.buffers) {
+        if (buffer != nullptr) return std::exchange(buffer, nullptr);
+    }
+    return nullptr;
+}
+
+static bool putSmallBuffer(uint8_t* data) {
+    if (gSmallBufferCache.destroyed) return false;
+    for (uint8_t*& buffer : gSmallBufferCache.buffers) {
+        if (buffer == nullptr) {
+            // Constructs the releaser, so that the buffers are freed when the thread exits.
+            gSmallBufferCacheReleaser.armed = true;
+            buffer = data;
+            return true;
+        }
+    }
+    return false;
+}
+#endif // BINDER_WITH_KERNEL_IPC
+
+// Returns a buffer of at least *capacity bytes and updates *capacity to the
+// size actually allocated.
+static uint8_t* allocateDataBuffer(size_t* capacity) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (*capacity <= kSmallBufferSize) {
+        *capacity = kSmallBufferSize;
+        if (uint8_t* data = takeSmallBuffer()) return data;
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+    return (uint8_t*)malloc(*capacity);
+}
+
+static void freeDataBuffer(uint8_t* data, size_t capacity) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (capacity == kSmallBufferSize && putSmallBuffer(data)) return;
+#else
+    (void)capacity;
+#endif // BINDER_WITH_KERNEL_IPC
+    free(data);
+}
+
 // Maximum number of file descriptors per Parcel.
 constexpr size_t kMaxFds = 1024;
 
@@ -113,6 +191,7 @@ enum {
     BLOB_INPLACE = 0,
     BLOB_ASHMEM_IMMUTABLE = 1,
     BLOB_ASHMEM_MUTABLE = 2,
+    BLOB_MEMFD_SEALED = 3,
 };
 
 #ifdef BINDER_WITH_KERNEL_IPC
@@ -876,6 +955,29 @@ status_t Parcel::writeInterfaceToken(const char16_t* str, size_t len) {
     return writeString16(str, len);
 }
 
+const char16_t* Parcel::peekInterfaceToken(size_t* outLen) const {
+#ifdef BINDER_WITH_KERNEL_IPC
+    // strict mode policy, work source and header, followed by the descriptor's String16.
+    constexpr size_t kTokenOffset = 3 * sizeof(int32_t);
+    if (maybeKernelFields() == nullptr || mDataSize < kTokenOffset + sizeof(int32_t)) {
+        return nullptr;
+    }
+    int32_t header;
+    memcpy(&header, mData + 2 * sizeof(int32_t), sizeof(header));
+    int32_t len;
+    memcpy(&len, mData + kTokenOffset, sizeof(len));
+    const size_t maxLen = (mDataSize - kTokenOffset - sizeof(int32_t)) / sizeof(char16_t);
+    if (header != kHeader || len < 0 || static_cast<size_t>(len) >= maxLen) {
+        return nullptr;
+    }
+    *outLen = static_cast<size_t>(len);
+    return reinterpret_cast<const char16_t*>(mData + kTokenOffset + sizeof(int32_t));
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)outLen;
+    return nullptr;
+#endif // BINDER_WITH_KERNEL_IPC
+}
+
 bool Parcel::replaceCallingWorkSourceUid(uid_t uid)
 {
     auto* kernelFields = maybeKernelFields();
@@ -1592,6 +1694,46 @@ status_t Parcel::writeDupImmutableBlobFileDescriptor(int fd)
     return writeDupFileDescriptor(fd);
 }
 
+status_t Parcel::writeSealedBlob(const void* data, size_t len)
+{
+    if (len > INT32_MAX) {
+        // don't accept size_t values which may have come from an
+        // inadvertent conversion from a negative int.
+        return BAD_VALUE;
+    }
+
+    status_t status = writeInt32(static_cast<int32_t>(len));
+    if (status) return status;
+
+#ifdef __BIONIC__
+    if (mAllowFds && len > BLOB_INPLACE_LIMIT) {
+        base::unique_fd fd(memfd_create("Parcel Blob", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+        if (fd.ok()) {
+            ALOGV("writeSealedBlob: write to memfd");
+            // Written through the fd rather than a mapping, since F_SEAL_WRITE
+            // can't be applied while a writable shared mapping exists.
+            if (!base::WriteFully(fd, data, len)) return -errno;
+            if (fcntl(fd.get(), F_ADD_SEALS,
+                      F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) < 0) {
+                return -errno;
+            }
+            status = writeInt32(BLOB_MEMFD_SEALED);
+            if (status) return status;
+            return writeUniqueFileDescriptor(fd);
+        }
+        ALOGW("writeSealedBlob: memfd_create failed, falling back to ashmem: %s",
+              strerror(errno));
+    }
+#endif // __BIONIC__
+
+    WritableBlob blob;
+    status = writeBlob(len, false /*mutableCopy*/, &blob);
+    if (status) return status;
+    memcpy(blob.data(), data, len);
+    blob.release();
+    return NO_ERROR;
+}
+
 status_t Parcel::write(const FlattenableHelperInterface& val)
 {
     status_t err;
@@ -2385,6 +2527,49 @@ status_t Parcel::readBlob(size_t len, ReadableBlob* outBlob) const
     return NO_ERROR;
 }
 
+status_t Parcel::readSealedBlob(ReadableBlob* outBlob) const
+{
+    int32_t len;
+    status_t status = readInt32(&len);
+    if (status) return status;
+    if (len < 0) return BAD_VALUE;
+
+    const size_t blobStart = dataPosition();
+    int32_t blobType;
+    status = readInt32(&blobType);
+    if (status) return status;
+    if (blobType != BLOB_MEMFD_SEALED) {
+        setDataPosition(blobStart);
+        return readBlob(len, outBlob);
+    }
+
+#ifdef __BIONIC__
+    ALOGV("readSealedBlob: read from memfd");
+    int fd = readFileDescriptor();
+    if (fd == int(BAD_TYPE)) return BAD_VALUE;
+
+    // The sender must not be able to change the contents after we map them.
+    constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & kRequiredSeals) != kRequiredSeals) {
+        ALOGE("readSealedBlob: memfd is not sealed (seals=%d)", seals);
+        return BAD_VALUE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < len) {
+        ALOGE("request size %d does not match fd size", len);
+        return BAD_VALUE;
+    }
+    void* ptr = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) return NO_MEMORY;
+
+    outBlob->init(fd, ptr, len, false);
+    return NO_ERROR;
+#else  // __BIONIC__
+    return BAD_TYPE;
+#endif // __BIONIC__
+}
+
 status_t Parcel::read(FlattenableHelperInterface& val) const
 {
     // size
@@ -2755,7 +2940,7 @@ void Parcel::freeDataNoInit()
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
             }
-            free(mData);
+            freeDataBuffer(mData, mDataCapacity);
         }
         auto* kernelFields = maybeKernelFields();
         if (kernelFields && kernelFields->mObjects) free(kernelFields->mObjects);
@@ -3021,7 +3206,7 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = allocateDataBuffer(&desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -22,6 +22,7 @@
 #include <binder/IServiceManager.h>
 #include <binder/PermissionCache.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 
 namespace android {
 
@@ -31,47 +32,165 @@ ANDROID_SINGLETON_STATIC_INSTANCE(PermissionCache)
 
 // ----------------------------------------------------------------------------
 
+// Cached results are packed in 64 bits, so that they are read and written
+// atomically: whether the slot holds a result, whether it was granted, the
+// generation of the cache it belongs to, and its expiration in milliseconds
+// since boot, or 0 if it does not expire.
+static constexpr uint64_t kValidBit = 1;
+static constexpr uint64_t kGrantedBit = 1 << 1;
+static constexpr int kGenerationShift = 2;
+static constexpr uint64_t kGenerationMask = (1 << 20) - 1;
+static constexpr int kExpirationShift = 22;
+
+// Denials may be lifted without notice, e.g. when the user grants a runtime
+// permission, so they are only trusted for a short while.
+static constexpr nsecs_t kDeniedTtl = s2ns(5);
+
+static uint64_t packValue(bool granted, uint32_t generation, nsecs_t expiration) {
+    return kValidBit | (granted ? kGrantedBit : 0) |
+            ((generation & kGenerationMask) << kGenerationShift) |
+            (uint64_t(ns2ms(expiration)) << kExpirationShift);
+}
+
+// Whether a packed result can no longer be used, so its slot can be given to
+// another key.
+static bool isStale(uint64_t value, uint32_t generation, nsecs_t now) {
+    if (!(value & kValidBit) ||
+            ((value >> kGenerationShift) & kGenerationMask) != (generation & kGenerationMask)) {
+        return true;
+    }
+    const nsecs_t expiration = ms2ns(nsecs_t(value >> kExpirationShift));
+    return expiration != 0 && now >= expiration;
+}
+
+static size_t slotIndex(uint64_t key, size_t capacity) {
+    // Fibonacci hashing spreads consecutive uids across the table.
+    return size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
 PermissionCache::PermissionCache() {
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+}
+
+ssize_t PermissionCache::findName(const String16& permission) const {
+    const size_t count = mNameCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        if (mNames[i] == permission) {
+            return i;
+        }
+    }
+    return NAME_NOT_FOUND;
 }
 
 status_t PermissionCache::check(bool* granted,
         const String16& permission, uid_t uid) const {
-    Mutex::Autolock _l(mLock);
-    Entry e;
-    e.name = permission;
-    e.uid  = uid;
-    ssize_t index = mCache.indexOf(e);
-    if (index >= 0) {
-        *granted = mCache.itemAt(index).granted;
-        return NO_ERROR;
+    const ssize_t name = findName(permission);
+    if (name < 0) {
+        return NAME_NOT_FOUND;
+    }
+    const uint64_t key = (uint64_t(uid) << 32) | uint64_t(name + 1);
+    const uint32_t generation = mGeneration.load(std::memory_order_acquire);
+
+    size_t index = slotIndex(key, kCapacity);
+    for (size_t probe = 0; probe < kCapacity; probe++) {
+        const Slot& slot = mSlots[index];
+        const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+        if (slotKey == 0) {
+            break;
+        }
+        if (slotKey == key) {
+            const uint64_t value = slot.value.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // The slot is being written, or was given to another key meanwhile.
+            if ((sequence & 1) || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                return NAME_NOT_FOUND;
+            }
+            if (isStale(value, generation, systemTime())) {
+                return NAME_NOT_FOUND;
+            }
+            *granted = value & kGrantedBit;
+            return NO_ERROR;
+        }
+        index = (index + 1) & (kCapacity - 1);
     }
     return NAME_NOT_FOUND;
 }
 
+void PermissionCache::writeSlot(Slot& slot, uint64_t key, uint64_t value) {
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
 void PermissionCache::cache(const String16& permission,
         uid_t uid, bool granted) {
     Mutex::Autolock _l(mLock);
-    Entry e;
-    ssize_t index = mPermissionNamesPool.indexOf(permission);
-    if (index > 0) {
-        e.name = mPermissionNamesPool.itemAt(index);
-    } else {
-        mPermissionNamesPool.add(permission);
-        e.name = permission;
+    ssize_t name = findName(permission);
+    if (name < 0) {
+        const size_t count = mNameCount.load(std::memory_order_relaxed);
+        if (count == kMaxNames) {
+            ALOGW("Too many permission names, not caching %s", String8(permission).c_str());
+            return;
+        }
+        mNames[count] = permission;
+        mNameCount.store(count + 1, std::memory_order_release);
+        name = count;
     }
     // note, we don't need to store the pid, which is not actually used in
     // permission checks
-    e.uid  = uid;
-    e.granted = granted;
-    index = mCache.indexOf(e);
-    if (index < 0) {
-        mCache.add(e);
+    const uint64_t key = (uint64_t(uid) << 32) | uint64_t(name + 1);
+    const nsecs_t now = systemTime();
+    const nsecs_t expiration = granted ? 0 : now + kDeniedTtl;
+    const uint32_t generation = mGeneration.load(std::memory_order_relaxed);
+    const uint64_t value = packValue(granted, generation, expiration);
+
+    // Look for the key until the end of its probe sequence, and remember the
+    // first stale slot on the way, which the key can take over if it is not
+    // in the table yet.
+    Slot* reusable = nullptr;
+    size_t index = slotIndex(key, kCapacity);
+    for (size_t probe = 0; probe < kCapacity; probe++) {
+        Slot& slot = mSlots[index];
+        const uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+        if (slotKey == key) {
+            writeSlot(slot, key, value);
+            return;
+        }
+        if (slotKey == 0) {
+            writeSlot(reusable ? *reusable : slot, key, value);
+            return;
+        }
+        if (!reusable && isStale(slot.value.load(std::memory_order_relaxed), generation, now)) {
+            reusable = &slot;
+        }
+        index = (index + 1) & (kCapacity - 1);
+    }
+    if (reusable) {
+        writeSlot(*reusable, key, value);
+        return;
     }
+    ALOGW("Permission cache is full, not caching %s for uid=%d",
+            String8(permission).c_str(), uid);
 }
 
 void PermissionCache::purge() {
     Mutex::Autolock _l(mLock);
-    mCache.clear();
+    // Every slot becomes stale, and is reused as keys are cached again.
+    mGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void PermissionCache::invalidate(uid_t uid) {
+    Mutex::Autolock _l(mLock);
+    for (Slot& slot : mSlots) {
+        const uint64_t key = slot.key.load(std::memory_order_relaxed);
+        if (key != 0 && uid_t(key >> 32) == uid) {
+            writeSlot(slot, key, 0);
+        }
+    }
 }
 
 bool PermissionCache::checkCallingPermission(const String16& permission) {
@@ -102,7 +221,7 @@ bool PermissionCache::checkPermission(
         granted = android::checkPermission(permission, pid, uid);
         t += systemTime();
         ALOGD("checking %s for uid=%d => %s (%d us)",
-                String8(permission).string(), uid,
+                String8(permission).c_str(), uid,
                 granted?"granted":"denied", (int)ns2us(t));
         pc.cache(permission, uid, granted);
     }
@@ -114,5 +233,10 @@ void PermissionCache::purgeCache() {
     pc.purge();
 }
 
+void PermissionCache::invalidateUid(uid_t uid) {
+    PermissionCache& pc(PermissionCache::getInstance());
+    pc.invalidate(uid);
+}
+
 // ---------------------------------------------------------------------------
 } // namespace android
@@ -45,6 +45,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <mutex>
+#include <new>
 
 #define BINDER_VM_SIZE ((1 * 1024 * 1024) - sysconf(_SC_PAGE_SIZE) * 2)
 #define DEFAULT_MAX_BINDER_THREADS 15
@@ -296,17 +297,32 @@ void ProcessState::setCallRestriction(CallRestriction restriction) {
     mCallRestriction = restriction;
 }
 
+Mutex& ProcessState::handleLock(int32_t handle)
+{
+    return mHandleLocks[static_cast<uint32_t>(handle) % kHandleLockCount].lock;
+}
+
 ProcessState::handle_entry* ProcessState::lookupHandleLocked(int32_t handle)
 {
-    const size_t N=mHandleToObject.size();
-    if (N <= (size_t)handle) {
-        handle_entry e;
-        e.binder = nullptr;
-        e.refs = nullptr;
-        status_t err = mHandleToObject.insertAt(e, N, handle+1-N);
-        if (err < NO_ERROR) return nullptr;
+    if (handle < 0 || static_cast<size_t>(handle) >= kHandleSegmentSize * kHandleSegmentCount) {
+        ALOGE("Binder handle %d is out of range", handle);
+        return nullptr;
     }
-    return &mHandleToObject.editItemAt(handle);
+
+    std::atomic<handle_entry*>& slot = mHandleSegments[handle / kHandleSegmentSize];
+    handle_entry* segment = slot.load(std::memory_order_acquire);
+    if (segment == nullptr) {
+        // Another thread may be allocating the same segment under a different stripe lock.
+        handle_entry* allocated = new (std::nothrow) handle_entry[kHandleSegmentSize]();
+        if (allocated == nullptr) return nullptr;
+        if (slot.compare_exchange_strong(segment, allocated, std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+            segment = allocated;
+        } else {
+            delete[] allocated;
+        }
+    }
+    return &segment[handle % kHandleSegmentSize];
 }
 
 // see b/166779391: cannot change the VNDK interface, so access like this
@@ -316,7 +332,7 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
 {
     sp<IBinder> result;
 
-    AutoMutex _l(mLock);
+    AutoMutex _l(handleLock(handle));
 
     if (handle == 0 && the_context_object != nullptr) return the_context_object;
 
@@ -326,7 +342,7 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
         // We need to create a new BpBinder if there isn't currently one, OR we
         // are unable to acquire a weak reference on this current one.  The
         // attemptIncWeak() is safe because we know the BpBinder destructor will always
-        // call expungeHandle(), which acquires the same lock we are holding now.
+        // call expungeHandle(), which acquires the same handle lock we are holding now.
         // We need to do this because there is a race condition between someone
         // releasing a reference on this BpBinder, and a new reference on its handle
         // arriving from the driver.
@@ -380,7 +396,7 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
 
 void ProcessState::expungeHandle(int32_t handle, IBinder* binder)
 {
-    AutoMutex _l(mLock);
+    AutoMutex _l(handleLock(handle));
 
     handle_entry* e = lookupHandleLocked(handle);
 
@@ -429,6 +445,39 @@ status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
     return result;
 }
 
+void ProcessState::setThreadPoolMaxThreadCountLimit(size_t maxThreads) {
+    pthread_mutex_lock(&mThreadCountLock);
+    mMaxThreadsLimit = maxThreads;
+    pthread_mutex_unlock(&mThreadCountLock);
+}
+
+void ProcessState::growThreadPoolLocked() {
+    if (mMaxThreads >= mMaxThreadsLimit) return;
+    size_t maxThreads = mMaxThreads + 1;
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) == -1) {
+        ALOGE("Binder ioctl to grow max threads failed: %s", strerror(errno));
+        return;
+    }
+    ALOGI("binder thread pool grown to %zu threads", maxThreads);
+    mMaxThreads = maxThreads;
+}
+
+ProcessState::ThreadPoolStats ProcessState::getThreadPoolStats() const {
+    pthread_mutex_lock(&mThreadCountLock);
+    base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
+
+    return {
+            .maxThreads = mMaxThreads,
+            .currentThreads = mCurrentThreads,
+            .executingThreads = mExecutingThreadsCount,
+            .peakExecutingThreads = mPeakExecutingThreads,
+            .commandsExecuted = mCommandsExecuted,
+            .busyTime = mBusyTime,
+            .starvationCount = mStarvationCount,
+            .starvedTimeMs = mStarvedTimeMs,
+    };
+}
+
 size_t ProcessState::getThreadPoolMaxTotalThreadCount() const {
     pthread_mutex_lock(&mThreadCountLock);
     base::ScopeGuard detachGuard = [&]() { pthread_mutex_unlock(&mThreadCountLock); };
@@ -538,6 +587,12 @@ ProcessState::ProcessState(const char* driver)
         mCurrentThreads(0),
         mKernelStartedThreads(0),
         mStarvationStartTimeMs(0),
+        mMaxThreadsLimit(0),
+        mPeakExecutingThreads(0),
+        mCommandsExecuted(0),
+        mBusyTime(0),
+        mStarvationCount(0),
+        mStarvedTimeMs(0),
         mForked(false),
         mThreadPoolStarted(false),
         mThreadPoolSeq(1),
@@ -569,6 +624,9 @@ ProcessState::ProcessState(const char* driver)
 
 ProcessState::~ProcessState()
 {
+    for (auto& segment : mHandleSegments) {
+        delete[] segment.load(std::memory_order_relaxed);
+    }
     if (mDriverFD >= 0) {
         if (mVMStart != MAP_FAILED) {
             munmap(mVMStart, BINDER_VM_SIZE);
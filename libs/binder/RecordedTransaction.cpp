@@ -20,6 +20,7 @@
 #include <android-base/unique_fd.h>
 #include <binder/RecordedTransaction.h>
 #include <sys/mman.h>
+#include <string.h>
 #include <algorithm>
 
 using android::Parcel;
@@ -112,24 +113,42 @@ RecordedTransaction::RecordedTransaction(RecordedTransaction&& t) noexcept {
     mReply.setData(t.getReplyParcel().data(), t.getReplyParcel().dataSize());
 }
 
+RecordedTransaction::TransactionHeader RecordedTransaction::makeHeader(uint32_t code,
+                                                                       uint32_t flags,
+                                                                       timespec timestamp,
+                                                                       const Parcel& dataParcel,
+                                                                       status_t err) {
+    return {code,
+            flags,
+            static_cast<int32_t>(err),
+            dataParcel.isForRpc() ? static_cast<uint32_t>(1) : static_cast<uint32_t>(0),
+            static_cast<int64_t>(timestamp.tv_sec),
+            static_cast<int32_t>(timestamp.tv_nsec),
+            0};
+}
+
+std::optional<std::string> RecordedTransaction::makeInterfaceName(
+        const String16& interfaceName) {
+    std::string name(String8(interfaceName).string());
+    if (interfaceName.size() != name.size()) {
+        LOG(ERROR) << "Interface Name is not valid. Contains characters that aren't single byte "
+                      "utf-8.";
+        return std::nullopt;
+    }
+    return name;
+}
+
 std::optional<RecordedTransaction> RecordedTransaction::fromDetails(
         const String16& interfaceName, uint32_t code, uint32_t flags, timespec timestamp,
         const Parcel& dataParcel, const Parcel& replyParcel, status_t err) {
     RecordedTransaction t;
-    t.mData.mHeader = {code,
-                       flags,
-                       static_cast<int32_t>(err),
-                       dataParcel.isForRpc() ? static_cast<uint32_t>(1) : static_cast<uint32_t>(0),
-                       static_cast<int64_t>(timestamp.tv_sec),
-                       static_cast<int32_t>(timestamp.tv_nsec),
-                       0};
-
-    t.mData.mInterfaceName = std::string(String8(interfaceName).string());
-    if (interfaceName.size() != t.mData.mInterfaceName.size()) {
-        LOG(ERROR) << "Interface Name is not valid. Contains characters that aren't single byte "
-                      "utf-8.";
+    t.mData.mHeader = makeHeader(code, flags, timestamp, dataParcel, err);
+
+    auto name = makeInterfaceName(interfaceName);
+    if (!name) {
         return std::nullopt;
     }
+    t.mData.mInterfaceName = std::move(*name);
 
     if (t.mSent.setData(dataParcel.data(), dataParcel.dataBufferSize()) != android::NO_ERROR) {
         LOG(ERROR) << "Failed to set sent parcel data.";
@@ -144,6 +163,20 @@ std::optional<RecordedTransaction> RecordedTransaction::fromDetails(
     return std::optional<RecordedTransaction>(std::move(t));
 }
 
+android::status_t RecordedTransaction::serializeDetails(const String16& interfaceName,
+                                                        uint32_t code, uint32_t flags,
+                                                        timespec timestamp,
+                                                        const Parcel& dataParcel,
+                                                        const Parcel& replyParcel, status_t err,
+                                                        std::vector<uint8_t>* buffer) {
+    auto name = makeInterfaceName(interfaceName);
+    if (!name) {
+        return BAD_VALUE;
+    }
+    return appendTransaction(makeHeader(code, flags, timestamp, dataParcel, err), *name,
+                             dataParcel, replyParcel, buffer);
+}
+
 enum {
     HEADER_CHUNK = 1,
     DATA_PARCEL_CHUNK = 2,
@@ -297,68 +330,77 @@ std::optional<RecordedTransaction> RecordedTransaction::fromFile(const unique_fd
     return std::optional<RecordedTransaction>(std::move(t));
 }
 
-android::status_t RecordedTransaction::writeChunk(borrowed_fd fd, uint32_t chunkType,
-                                                  size_t byteCount, const uint8_t* data) const {
+// Appends a whole Chunk to buffer, which must end on an 8-byte boundary.
+static android::status_t appendChunk(std::vector<uint8_t>* buffer, uint32_t chunkType,
+                                     size_t byteCount, const uint8_t* data) {
     if (byteCount > kMaxChunkDataSize) {
         LOG(ERROR) << "Chunk data exceeds maximum size";
-        return BAD_VALUE;
+        return android::BAD_VALUE;
     }
     ChunkDescriptor descriptor = {.chunkType = chunkType,
                                   .dataSize = static_cast<uint32_t>(byteCount)};
-    // Prepare Chunk content as byte *
-    const std::byte* descriptorBytes = reinterpret_cast<const std::byte*>(&descriptor);
-    const std::byte* dataBytes = reinterpret_cast<const std::byte*>(data);
-
-    // Add Chunk to intermediate buffer, except checksum
-    std::vector<std::byte> buffer;
-    buffer.insert(buffer.end(), descriptorBytes, descriptorBytes + sizeof(ChunkDescriptor));
-    buffer.insert(buffer.end(), dataBytes, dataBytes + byteCount);
-    std::byte zero{0};
-    buffer.insert(buffer.end(), PADDING8(byteCount), zero);
-
-    // Calculate checksum from buffer
-    transaction_checksum_t* checksumData = reinterpret_cast<transaction_checksum_t*>(buffer.data());
+    const uint8_t* descriptorBytes = reinterpret_cast<const uint8_t*>(&descriptor);
+
+    // Add Chunk to buffer, except checksum
+    const size_t chunkStart = buffer->size();
+    buffer->insert(buffer->end(), descriptorBytes, descriptorBytes + sizeof(ChunkDescriptor));
+    if (byteCount > 0) {
+        buffer->insert(buffer->end(), data, data + byteCount);
+    }
+    buffer->insert(buffer->end(), PADDING8(byteCount), 0);
+
+    // Calculate checksum from the Chunk
     transaction_checksum_t checksumValue = 0;
-    for (size_t idx = 0; idx < (buffer.size() / sizeof(transaction_checksum_t)); idx++) {
-        checksumValue ^= checksumData[idx];
+    for (size_t offset = chunkStart; offset < buffer->size();
+         offset += sizeof(transaction_checksum_t)) {
+        transaction_checksum_t word;
+        memcpy(&word, buffer->data() + offset, sizeof(word));
+        checksumValue ^= word;
     }
 
-    // Write checksum to buffer
-    std::byte* checksumBytes = reinterpret_cast<std::byte*>(&checksumValue);
-    buffer.insert(buffer.end(), checksumBytes, checksumBytes + sizeof(transaction_checksum_t));
+    const uint8_t* checksumBytes = reinterpret_cast<const uint8_t*>(&checksumValue);
+    buffer->insert(buffer->end(), checksumBytes, checksumBytes + sizeof(transaction_checksum_t));
+    return android::NO_ERROR;
+}
 
-    // Write buffer to file
-    if (!android::base::WriteFully(fd, buffer.data(), buffer.size())) {
-        LOG(ERROR) << "Failed to write chunk fd " << fd.get();
-        return UNKNOWN_ERROR;
+android::status_t RecordedTransaction::appendTransaction(const TransactionHeader& header,
+                                                         const std::string& interfaceName,
+                                                         const Parcel& dataParcel,
+                                                         const Parcel& replyParcel,
+                                                         std::vector<uint8_t>* buffer) {
+    const size_t start = buffer->size();
+    buffer->reserve(start + 5 * (sizeof(ChunkDescriptor) + sizeof(transaction_checksum_t) + 8) +
+                    sizeof(TransactionHeader) + interfaceName.size() +
+                    dataParcel.dataBufferSize() + replyParcel.dataBufferSize());
+
+    status_t err;
+    if ((err = appendChunk(buffer, HEADER_CHUNK, sizeof(TransactionHeader),
+                           reinterpret_cast<const uint8_t*>(&header))) != NO_ERROR ||
+        (err = appendChunk(buffer, INTERFACE_NAME_CHUNK, interfaceName.size() * sizeof(uint8_t),
+                           reinterpret_cast<const uint8_t*>(interfaceName.c_str()))) !=
+                NO_ERROR ||
+        (err = appendChunk(buffer, DATA_PARCEL_CHUNK, dataParcel.dataBufferSize(),
+                           dataParcel.data())) != NO_ERROR ||
+        (err = appendChunk(buffer, REPLY_PARCEL_CHUNK, replyParcel.dataBufferSize(),
+                           replyParcel.data())) != NO_ERROR ||
+        (err = appendChunk(buffer, END_CHUNK, 0, nullptr)) != NO_ERROR) {
+        buffer->resize(start);
+        return err;
     }
     return NO_ERROR;
 }
 
 android::status_t RecordedTransaction::dumpToFile(const unique_fd& fd) const {
-    if (NO_ERROR !=
-        writeChunk(fd, HEADER_CHUNK, sizeof(TransactionHeader),
-                   reinterpret_cast<const uint8_t*>(&(mData.mHeader)))) {
-        LOG(ERROR) << "Failed to write transactionHeader to fd " << fd.get();
-        return UNKNOWN_ERROR;
+    // Write the whole transaction at once, so a reader never sees part of it
+    std::vector<uint8_t> buffer;
+    if (status_t err = appendTransaction(mData.mHeader, mData.mInterfaceName, mSent, mReply,
+                                         &buffer);
+        err != NO_ERROR) {
+        LOG(ERROR) << "Failed to serialize transaction for fd " << fd.get();
+        return err;
     }
-    if (NO_ERROR !=
-        writeChunk(fd, INTERFACE_NAME_CHUNK, mData.mInterfaceName.size() * sizeof(uint8_t),
-                   reinterpret_cast<const uint8_t*>(mData.mInterfaceName.c_str()))) {
-        LOG(INFO) << "Failed to write Interface Name Chunk to fd " << fd.get();
-        return UNKNOWN_ERROR;
-    }
-
-    if (NO_ERROR != writeChunk(fd, DATA_PARCEL_CHUNK, mSent.dataBufferSize(), mSent.data())) {
-        LOG(ERROR) << "Failed to write sent Parcel to fd " << fd.get();
-        return UNKNOWN_ERROR;
-    }
-    if (NO_ERROR != writeChunk(fd, REPLY_PARCEL_CHUNK, mReply.dataBufferSize(), mReply.data())) {
-        LOG(ERROR) << "Failed to write reply Parcel to fd " << fd.get();
-        return UNKNOWN_ERROR;
-    }
-    if (NO_ERROR != writeChunk(fd, END_CHUNK, 0, NULL)) {
-        LOG(ERROR) << "Failed to write end chunk to fd " << fd.get();
+    if (!android::base::WriteFully(fd, buffer.data(), buffer.size())) {
+        LOG(ERROR) << "Failed to write transaction to fd " << fd.get();
         return UNKNOWN_ERROR;
     }
     return NO_ERROR;
@@ -98,6 +98,13 @@ void RpcSession::setMaxOutgoingConnections(size_t connections) {
     mMaxOutgoingConnections = connections;
 }
 
+void RpcSession::setOutgoingConnectionsOnDemand(bool onDemand) {
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup,
+                        "Must set on demand outgoing connections before setting up connections");
+    mOutgoingConnectionsOnDemand = onDemand;
+}
+
 size_t RpcSession::getMaxOutgoingThreads() {
     RpcMutexLockGuard _l(mMutex);
     return mMaxOutgoingConnections;
@@ -521,6 +528,8 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
         mProtocolVersion = oldProtocolVersion;
 
         mConnections = {};
+        mConnectOnDemand = nullptr;
+        mMaxOnDemandOutgoing = 0;
 
         // clear mStartedSetup so that we can reuse this RpcSession
         mStartedSetup = false;
@@ -571,11 +580,21 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
     // requested to be set) in order to allow the other side to reliably make
     // any requests at all.
 
+    size_t initialOutgoingConnections = outgoingConnections;
+    {
+        RpcMutexLockGuard _l(mMutex);
+        if (mConnectOnDemand != nullptr) {
+            mMaxOnDemandOutgoing = outgoingConnections;
+            initialOutgoingConnections = std::min<size_t>(outgoingConnections, 1);
+        }
+    }
+
     // we've already setup one client
     LOG_RPC_DETAIL("RpcSession::setupClient() instantiating %zu outgoing connections (server max: "
-                   "%zu) and %zu incoming threads",
-                   outgoingConnections, numThreadsAvailable, mMaxIncomingThreads);
-    for (size_t i = 0; i + 1 < outgoingConnections; i++) {
+                   "%zu, on demand max: %zu) and %zu incoming threads",
+                   initialOutgoingConnections, numThreadsAvailable, mMaxOnDemandOutgoing,
+                   mMaxIncomingThreads);
+    for (size_t i = 0; i + 1 < initialOutgoingConnections; i++) {
         if (status_t status = connectAndInit(mId, false /*incoming*/); status != OK) return status;
     }
 
@@ -589,6 +608,16 @@ status_t RpcSession::setupClient(const std::function<status_t(const std::vector<
 }
 
 status_t RpcSession::setupSocketClient(const RpcSocketAddress& addr) {
+    {
+        RpcMutexLockGuard _l(mMutex);
+        if (mOutgoingConnectionsOnDemand) {
+            // |addr| only lives for the duration of this call
+            auto stored = std::make_shared<StoredSocketAddress>(addr);
+            mConnectOnDemand = [this, stored]() {
+                return setupOneSocketConnection(*stored, mId, false /*incoming*/);
+            };
+        }
+    }
     return setupClient([&](const std::vector<uint8_t>& sessionId, bool incoming) {
         return setupOneSocketConnection(addr, sessionId, incoming);
     });
@@ -952,6 +981,26 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
             return WOULD_BLOCK;
         }
 
+        if (session->mConnectOnDemand != nullptr &&
+            session->mConnections.mOutgoing.size() + session->mConnections.mOutgoingConnecting <
+                    session->mMaxOnDemandOutgoing) {
+            LOG_RPC_DETAIL("No available connections (have %zu clients). Opening another.",
+                           session->mConnections.mOutgoing.size());
+            session->mConnections.mOutgoingConnecting++;
+            _l.unlock();
+            status_t status = session->mConnectOnDemand();
+            _l.lock();
+            session->mConnections.mOutgoingConnecting--;
+            if (status != OK) {
+                ALOGE("Could not open on demand outgoing connection, staying at %zu: %s",
+                      session->mConnections.mOutgoing.size(), statusToString(status).c_str());
+                session->mMaxOnDemandOutgoing = session->mConnections.mOutgoing.size();
+            }
+            // the new connection may already have been taken by another
+            // waiting thread, so look again
+            continue;
+        }
+
         LOG_RPC_DETAIL("No available connections (have %zu clients and %zu servers). Waiting...",
                        session->mConnections.mOutgoing.size(),
                        session->mConnections.mIncoming.size());
@@ -36,6 +36,26 @@ public:
     virtual size_t addrSize() const = 0;
 };
 
+// Copy of another address, for when the original doesn't outlive its use.
+class StoredSocketAddress : public RpcSocketAddress {
+public:
+    explicit StoredSocketAddress(const RpcSocketAddress& other)
+          : mString(other.toString()), mAddrSize(other.addrSize()) {
+        LOG_ALWAYS_FATAL_IF(mAddrSize > sizeof(mAddr), "Socket address is too long: %zu",
+                            mAddrSize);
+        memcpy(&mAddr, other.addr(), mAddrSize);
+    }
+    virtual ~StoredSocketAddress() {}
+    std::string toString() const override { return mString; }
+    const sockaddr* addr() const override { return reinterpret_cast<const sockaddr*>(&mAddr); }
+    size_t addrSize() const override { return mAddrSize; }
+
+private:
+    std::string mString;
+    sockaddr_storage mAddr;
+    size_t mAddrSize;
+};
+
 class UnixSocketAddress : public RpcSocketAddress {
 public:
     explicit UnixSocketAddress(const char* path) : mAddr({.sun_family = AF_UNIX}) {
@@ -18,6 +18,9 @@
 #include <log/log.h>
 
 #include <poll.h>
+#include <string.h>
+
+#include <mutex>
 
 #include <openssl/bn.h>
 #include <openssl/ssl.h>
@@ -330,16 +333,8 @@ status_t RpcTransportTls::interruptableWriteFully(
     // once. The trigger is also checked via triggerablePoll() after every SSL_write().
     if (fdTrigger->isTriggered()) return DEAD_OBJECT;
 
-    size_t size = 0;
-    for (int i = 0; i < niovs; i++) {
-        const iovec& iov = iovs[i];
-        if (iov.iov_len == 0) {
-            continue;
-        }
-        size += iov.iov_len;
-
-        auto buffer = reinterpret_cast<const uint8_t*>(iov.iov_base);
-        const uint8_t* end = buffer + iov.iov_len;
+    auto writeFully = [&](const uint8_t* buffer, size_t len) -> status_t {
+        const uint8_t* end = buffer + len;
         while (buffer < end) {
             size_t todo = std::min<size_t>(end - buffer, std::numeric_limits<int>::max());
             auto [writeSize, errorQueue] = mSsl.call(SSL_write, buffer, todo);
@@ -357,6 +352,40 @@ status_t RpcTransportTls::interruptableWriteFully(
             if (pollStatus != OK) return pollStatus;
             // Do not advance buffer. Try SSL_write() again.
         }
+        return OK;
+    };
+
+    // Each SSL_write() produces at least one TLS record and one send(2), so
+    // small iovecs (headers, small parcels) are gathered into a single write
+    // instead of being written one by one.
+    constexpr size_t kCoalesceSize = 4096;
+    uint8_t coalesced[kCoalesceSize];
+    size_t coalescedSize = 0;
+
+    size_t size = 0;
+    for (int i = 0; i < niovs; i++) {
+        const iovec& iov = iovs[i];
+        if (iov.iov_len == 0) {
+            continue;
+        }
+        size += iov.iov_len;
+
+        if (coalescedSize + iov.iov_len > kCoalesceSize && coalescedSize > 0) {
+            if (status_t status = writeFully(coalesced, coalescedSize); status != OK) {
+                return status;
+            }
+            coalescedSize = 0;
+        }
+        auto buffer = reinterpret_cast<const uint8_t*>(iov.iov_base);
+        if (iov.iov_len < kCoalesceSize) {
+            memcpy(coalesced + coalescedSize, buffer, iov.iov_len);
+            coalescedSize += iov.iov_len;
+        } else if (status_t status = writeFully(buffer, iov.iov_len); status != OK) {
+            return status;
+        }
+    }
+    if (coalescedSize > 0) {
+        if (status_t status = writeFully(coalesced, coalescedSize); status != OK) return status;
     }
     LOG_TLS_DETAIL("TLS: Sent %zu bytes!", size);
     return OK;
@@ -450,9 +479,15 @@ public:
 
 protected:
     static ssl_verify_result_t sslCustomVerify(SSL* ssl, uint8_t* outAlert);
+    static int sslNewSession(SSL* ssl, SSL_SESSION* session);
     virtual void preHandshake(Ssl* ssl) const = 0;
     bssl::UniquePtr<SSL_CTX> mCtx;
     std::shared_ptr<RpcCertificateVerifier> mCertVerifier;
+
+    // Most recent session ticket received by a client connection. Later connections made
+    // through this context offer it so that they resume instead of doing a full handshake.
+    mutable std::mutex mSessionMutex;
+    mutable bssl::UniquePtr<SSL_SESSION> mResumableSession;
 };
 
 std::vector<uint8_t> RpcTransportCtxTls::getCertificate(RpcCertificateFormat format) const {
@@ -481,6 +516,22 @@ ssl_verify_result_t RpcTransportCtxTls::sslCustomVerify(SSL* ssl, uint8_t* outAl
     return ssl_verify_invalid;
 }
 
+// Keep the latest ticket the server hands out to a client connection. Returning 1 takes
+// ownership of |session|.
+int RpcTransportCtxTls::sslNewSession(SSL* ssl, SSL_SESSION* session) {
+    if (SSL_is_server(ssl)) return 0;
+
+    auto ctx = SSL_get_SSL_CTX(ssl); // Does not set error queue
+    LOG_ALWAYS_FATAL_IF(ctx == nullptr);
+    // void* -> RpcTransportCtxTls*
+    auto rpcTransportCtxTls = reinterpret_cast<RpcTransportCtxTls*>(SSL_CTX_get_app_data(ctx));
+    LOG_ALWAYS_FATAL_IF(rpcTransportCtxTls == nullptr);
+
+    std::lock_guard<std::mutex> lock(rpcTransportCtxTls->mSessionMutex);
+    rpcTransportCtxTls->mResumableSession.reset(session);
+    return 1;
+}
+
 // Common implementation for creating server and client contexts. The child class, |Impl|, is
 // provided as a template argument so that this function can initialize an |Impl| object.
 template <typename Impl, typename>
@@ -503,6 +554,16 @@ std::unique_ptr<RpcTransportCtxTls> RpcTransportCtxTls::create(
     // Require at least TLS 1.3
     TEST_AND_RETURN(nullptr, SSL_CTX_set_min_proto_version(ctx.get(), TLS1_3_VERSION));
 
+    // Let additional connections of a session resume with a ticket. Servers issue stateless
+    // tickets, so neither side keeps an internal cache; clients hold on to the newest ticket in
+    // sslNewSession().
+    static constexpr uint8_t kSessionIdContext[] = "binder_rpc";
+    TEST_AND_RETURN(nullptr,
+                    SSL_CTX_set_session_id_context(ctx.get(), kSessionIdContext,
+                                                   sizeof(kSessionIdContext)));
+    SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_BOTH | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx.get(), sslNewSession);
+
     if constexpr (SHOULD_LOG_TLS_DETAIL) { // NOLINT
         SSL_CTX_set_info_callback(ctx.get(), sslDebugLog);
     }
@@ -523,6 +584,23 @@ std::unique_ptr<RpcTransport> RpcTransportCtxTls::newTransport(android::RpcTrans
 
     preHandshake(&wrapped);
     TEST_AND_RETURN(nullptr, setFdAndDoHandshake(&wrapped, socket, fdTrigger));
+
+    // libssl skips the custom verify callback on resumption, but the set of trusted
+    // certificates may have changed since the ticket was issued. Check the peer again.
+    auto [reused, reusedErrorQueue] = wrapped.call(SSL_session_reused);
+    reusedErrorQueue.clear();
+    if (reused) {
+        uint8_t alert = 0;
+        auto [verifyStatus, errorQueue] = wrapped.call(
+                [this](SSL* s, uint8_t* outAlert) { return mCertVerifier->verify(s, outAlert); },
+                &alert);
+        errorQueue.clear();
+        if (verifyStatus != OK) {
+            ALOGE("%s: Peer of resumed session is no longer trusted: %s", __PRETTY_FUNCTION__,
+                  statusToString(verifyStatus).c_str());
+            return nullptr;
+        }
+    }
     return std::make_unique<RpcTransportTls>(std::move(socket), std::move(wrapped));
 }
 
@@ -537,6 +615,11 @@ class RpcTransportCtxTlsClient : public RpcTransportCtxTls {
 protected:
     void preHandshake(Ssl* ssl) const override {
         ssl->call(SSL_set_connect_state).errorQueue.clear();
+
+        std::lock_guard<std::mutex> lock(mSessionMutex);
+        if (mResumableSession != nullptr && SSL_SESSION_is_resumable(mResumableSession.get())) {
+            ssl->call(SSL_set_session, mResumableSession.get()).errorQueue.clear();
+        }
     }
 };
 
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2007 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <unordered_map>
+
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+#include <utils/String8.h>
+
+namespace android {
+// ----------------------------------------------------------------------------
+
+/*
+ * A simple templatized doubly linked-list implementation
+ */
+
+template <typename NODE>
+class LinkedList
+{
+    NODE*  mFirst;
+    NODE*  mLast;
+
+public:
+                LinkedList() : mFirst(nullptr), mLast(nullptr) { }
+    bool        isEmpty() const { return mFirst == nullptr; }
+    NODE const* head() const { return mFirst; }
+    NODE*       head() { return mFirst; }
+    NODE const* tail() const { return mLast; }
+    NODE*       tail() { return mLast; }
+
+    void insertAfter(NODE* node, NODE* newNode) {
+        newNode->prev = node;
+        newNode->next = node->next;
+        if (node->next == nullptr) mLast = newNode;
+        else                 node->next->prev = newNode;
+        node->next = newNode;
+    }
+
+    void insertBefore(NODE* node, NODE* newNode) {
+         newNode->prev = node->prev;
+         newNode->next = node;
+         if (node->prev == nullptr)   mFirst = newNode;
+         else                   node->prev->next = newNode;
+         node->prev = newNode;
+    }
+
+    void insertHead(NODE* newNode) {
+        if (mFirst == nullptr) {
+            mFirst = mLast = newNode;
+            newNode->prev = newNode->next = nullptr;
+        } else {
+            newNode->prev = nullptr;
+            newNode->next = mFirst;
+            mFirst->prev = newNode;
+            mFirst = newNode;
+        }
+    }
+
+    void insertTail(NODE* newNode) {
+        if (mLast == 0) {
+            insertHead(newNode);
+        } else {
+            newNode->prev = mLast;
+            newNode->next = 0;
+            mLast->next = newNode;
+            mLast = newNode;
+        }
+    }
+
+    NODE* remove(NODE* node) {
+        if (node->prev == nullptr)    mFirst = node->next;
+        else                    node->prev->next = node->next;
+        if (node->next == nullptr)    mLast = node->prev;
+        else                    node->next->prev = node->prev;
+        return node;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Segregated-fit allocator. Free chunks are kept in bins by size class, where
+ * bin i holds the chunks of [2^i, 2^(i+1)) units, and a bitmap tracks the
+ * non-empty bins. All chunks are also kept in address order, so that a freed
+ * chunk is merged with its free neighbors in constant time, and allocated
+ * chunks are indexed by offset, so that deallocate does not walk the heap.
+ */
+class SimpleBestFitAllocator
+{
+public:
+    enum {
+        PAGE_ALIGNED = 0x00000001
+    };
+
+    explicit SimpleBestFitAllocator(size_t size);
+    ~SimpleBestFitAllocator();
+
+    size_t      allocate(size_t size, uint32_t flags = 0);
+    status_t    deallocate(size_t offset);
+    size_t      size() const;
+    void        dump(const char* what) const;
+    void        dump(String8& res, const char* what) const;
+
+    static size_t getAllocationAlignment() { return kMemoryAlign; }
+
+private:
+
+    struct chunk_t {
+        chunk_t(size_t start, size_t size)
+        : start(start), size(size), free(1), prev(nullptr), next(nullptr),
+          freePrev(nullptr), freeNext(nullptr) {
+        }
+        size_t              start;
+        size_t              size;
+        int                 free;
+        // Neighbors in address order.
+        mutable chunk_t*    prev;
+        mutable chunk_t*    next;
+        // Neighbors in the bin, if free.
+        chunk_t*            freePrev;
+        chunk_t*            freeNext;
+    };
+
+    static constexpr size_t kBinCount = sizeof(size_t) * 8;
+
+    ssize_t  alloc(size_t size, uint32_t flags);
+    chunk_t* dealloc(size_t start);
+    void     dump_l(const char* what) const;
+    void     dump_l(String8& res, const char* what) const;
+
+    static size_t binIndex(size_t size);
+    void     insertFree(chunk_t* chunk);
+    void     removeFree(chunk_t* chunk);
+    size_t   alignmentPadding(const chunk_t* chunk, uint32_t flags) const;
+    chunk_t* findFree(size_t size, uint32_t flags) const;
+
+    static const int    kMemoryAlign;
+    mutable Mutex       mLock;
+    LinkedList<chunk_t> mList;
+    size_t              mHeapSize;
+    chunk_t*            mBins[kBinCount] = {};
+    size_t              mBinMask = 0;
+    std::unordered_map<size_t, chunk_t*> mAllocated;
+};
+
+// ----------------------------------------------------------------------------
+} // namespace android
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionRecorder"
+
+#include "TransactionRecorder.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <binder/RecordedTransaction.h>
+
+namespace android::binder::debug {
+
+TransactionRecorder::TransactionRecorder(base::unique_fd fd)
+      : mFd(std::move(fd)), mWriter(&TransactionRecorder::writeLoop, this) {}
+
+TransactionRecorder::~TransactionRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+    }
+    mCondition.notify_one();
+    mWriter.join();
+}
+
+void TransactionRecorder::record(const String16& interfaceName, uint32_t code, uint32_t flags,
+                                 timespec timestamp, const Parcel& data, const Parcel& reply,
+                                 status_t err) {
+    // Reused across transactions, so that a busy thread doesn't allocate for each of them.
+    thread_local std::vector<uint8_t> tBuffer;
+    tBuffer.clear();
+    if (RecordedTransaction::serializeDetails(interfaceName, code, flags, timestamp, data, reply,
+                                              err, &tBuffer) != NO_ERROR) {
+        LOG(INFO) << "Failed to serialize RecordedTransaction.";
+        return;
+    }
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mPending.size() + tBuffer.size() > kMaxPendingBytes) {
+            mDropped++;
+        } else {
+            mPending.insert(mPending.end(), tBuffer.begin(), tBuffer.end());
+            queued = true;
+        }
+    }
+    // Don't keep the memory of a large transaction on every thread that recorded one, as the
+    // buffer outlives the recording.
+    if (tBuffer.capacity() > kMaxRetainedBufferBytes) {
+        std::vector<uint8_t>().swap(tBuffer);
+    }
+    if (queued) {
+        mCondition.notify_one();
+    }
+}
+
+size_t TransactionRecorder::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mDropped;
+}
+
+void TransactionRecorder::writeLoop() {
+    // Swapped with mPending, so that both keep their capacity.
+    std::vector<uint8_t> writing;
+    bool stopping = false;
+    bool failed = false;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mCondition.wait(lock, [this] { return mStopping || !mPending.empty(); });
+            writing.swap(mPending);
+            stopping = mStopping;
+        }
+
+        if (!failed && !writing.empty() &&
+            !base::WriteFully(mFd, writing.data(), writing.size())) {
+            PLOG(INFO) << "Failed to write recorded transactions to fd " << mFd.get();
+            failed = true;
+        }
+        writing.clear();
+    }
+
+    if (const size_t dropped = getDroppedCount(); dropped > 0) {
+        LOG(INFO) << "Dropped " << dropped << " transactions while the recording fell behind.";
+    }
+}
+
+} // namespace android::binder::debug
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <binder/Parcel.h>
+#include <utils/Errors.h>
+#include <utils/String16.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::binder::debug {
+
+// Records the transactions of a BBinder to a file, in the RecordedTransaction format. Each
+// transaction is serialized by the thread that handled it, into a buffer of that thread, and
+// appended to a pending buffer that a writer thread flushes to the file. The binder threads
+// therefore never wait on the file, and only contend for as long as it takes to copy a
+// transaction. If the writer falls behind by more than kMaxPendingBytes, transactions are
+// dropped instead of growing the backlog without bound.
+class TransactionRecorder {
+public:
+    explicit TransactionRecorder(base::unique_fd fd);
+    // Flushes the pending transactions.
+    ~TransactionRecorder();
+
+    void record(const String16& interfaceName, uint32_t code, uint32_t flags, timespec timestamp,
+                const Parcel& data, const Parcel& reply, status_t err);
+
+    // Returns how many transactions were dropped because the writer fell behind.
+    size_t getDroppedCount() const;
+
+private:
+    static constexpr size_t kMaxPendingBytes = 16 * 1024 * 1024;
+    // The largest buffer a thread keeps for serializing its next transaction.
+    static constexpr size_t kMaxRetainedBufferBytes = 64 * 1024;
+
+    void writeLoop();
+
+    const base::unique_fd mFd;
+
+    mutable std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<uint8_t> mPending;
+    size_t mDropped = 0;
+    bool mStopping = false;
+
+    std::thread mWriter;
+};
+
+} // namespace android::binder::debug
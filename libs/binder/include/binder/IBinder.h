@@ -65,6 +65,7 @@ public:
         EXTENSION_TRANSACTION = B_PACK_CHARS('_', 'E', 'X', 'T'),
         DEBUG_PID_TRANSACTION = B_PACK_CHARS('_', 'P', 'I', 'D'),
         SET_RPC_CLIENT_TRANSACTION = B_PACK_CHARS('_', 'R', 'P', 'C'),
+        LATENCY_PROFILE_TRANSACTION = B_PACK_CHARS('_', 'L', 'A', 'T'),
 
         // See android.os.IBinder.TWEET_TRANSACTION
         // Most importantly, messages can be anything not exceeding 130 UTF-8
@@ -157,6 +158,13 @@ public:
      */
     status_t                getDebugPid(pid_t* outPid);
 
+    /**
+     * Enable the transaction latency profile of the process hosting this binder, if it is not
+     * already, and write its histograms to @a fd as text. Only root and shell may call this.
+     * See binder::debug::LatencyProfile.
+     */
+    status_t                dumpLatencyProfile(int fd);
+
     /**
      * Set the RPC client fd to this binder service, for debugging. This is only available on
      * debuggable builds.
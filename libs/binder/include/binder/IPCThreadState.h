@@ -21,6 +21,9 @@
 #include <binder/ProcessState.h>
 #include <utils/Vector.h>
 
+#include <memory>
+#include <vector>
+
 #if defined(_WIN32)
 typedef  int  uid_t;
 #endif
@@ -157,6 +160,14 @@ public:
                                          uint32_t code, const Parcel& data,
                                          Parcel* reply, uint32_t flags);
 
+            // Between these calls, oneway transactions made on this thread
+            // are queued and sent to the driver together, in a single
+            // BINDER_WRITE_READ, when the outermost batch ends. A synchronous
+            // transaction inside the batch sends the queued ones first.
+            // endOnewayBatch() returns the first error any of them hit.
+            void                beginOnewayBatch();
+            status_t            endOnewayBatch();
+
             void                incStrongHandle(int32_t handle, BpBinder *proxy);
             void                decStrongHandle(int32_t handle);
             void                incWeakHandle(int32_t handle, BpBinder *proxy);
@@ -216,6 +227,7 @@ private:
             status_t            executeCommand(int32_t command);
             void                processPendingDerefs();
             void                processPostWriteDerefs();
+            void                flushOnewayBatch();
 
             void                clearCaller();
 
@@ -248,6 +260,12 @@ private:
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
+            // Nesting depth of beginOnewayBatch() calls.
+            size_t              mOnewayBatchDepth;
+            // Copies of the oneway transactions queued in mOut, which the
+            // driver reads from when the batch is flushed.
+            std::vector<std::unique_ptr<Parcel>> mBatchedOnewayData;
+            status_t            mOnewayBatchError;
 };
 
 } // namespace android
@@ -151,6 +151,17 @@ public:
 
 sp<IServiceManager> defaultServiceManager();
 
+/**
+ * Counters of the process-local cache behind checkService() and getService() of
+ * defaultServiceManager(). A lookup hits while this process still holds the service and it is
+ * alive. Services can report these counters from their dump() so that they show up in dumpsys.
+ */
+struct ServiceLookupCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+};
+ServiceLookupCacheStats getServiceLookupCacheStats();
+
 /**
  * Directly set the default service manager. Only used for testing.
  * Note that the caller is responsible for caling this method
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utils/Errors.h>
+#include <utils/String16.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace android {
+
+namespace binder::debug {
+
+// Opt-in latency histograms of kernel binder transactions, kept per interface descriptor and
+// transaction code. Client samples time synchronous IPCThreadState::transact calls, server
+// samples time BBinder::transact on binder threads. Each thread records into its own table
+// with relaxed atomics, so an enabled profile does not add contention between threads.
+class LatencyProfile {
+public:
+    enum class Side : uint8_t {
+        CLIENT,
+        SERVER,
+    };
+
+    // Bucket i counts samples in [2^i, 2^(i+1)) microseconds. The last bucket is open ended.
+    static constexpr size_t kBucketCount = 24;
+
+    struct Histogram {
+        Side side;
+        String16 descriptor;
+        uint32_t code;
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t maxNs;
+        std::array<uint64_t, kBucketCount> buckets;
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // Histograms merged over all threads, including threads that have exited. Sorted by side,
+    // descriptor and code.
+    static std::vector<Histogram> snapshot();
+
+    // Writes snapshot() as text, one line per descriptor and code.
+    static status_t dump(int fd);
+
+    static void record(Side side, const char16_t* descriptor, size_t descriptorLen, uint32_t code,
+                       nsecs_t elapsed);
+
+private:
+    static inline std::atomic<bool> sEnabled = false;
+};
+
+} // namespace binder::debug
+
+} // namespace android
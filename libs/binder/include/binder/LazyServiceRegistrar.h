@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 
 #include <binder/IServiceManager.h>
@@ -93,6 +94,39 @@ class LazyServiceRegistrar {
       */
      void reRegister();
 
+     /**
+      * Keep the process alive for a while after its services lose their last client, so that
+      * clients coming back shortly after do not pay for a process restart.
+      *
+      * If minHold and maxHold are equal, the process is held for that long. Otherwise, the hold
+      * is predicted from the observed times between the services going idle and getting a
+      * client again: if the next client is expected within maxHold, the process is held long
+      * enough to serve it, otherwise it is held for minHold only. Until a client came back once,
+      * the process is held for maxHold.
+      *
+      * The hold only applies when shutdown is not handled by the active services callback.
+      * Both are 0 by default, i.e. the process shuts down as soon as it has no clients.
+      *
+      * This method should be called before 'registerService' to avoid races.
+      */
+     void setIdleHold(std::chrono::milliseconds minHold, std::chrono::milliseconds maxHold);
+
+     struct Stats {
+         // Times the process went from no services with clients to some, and back.
+         size_t activations = 0;
+         size_t deactivations = 0;
+         // Times a client came back while the process was held after going idle.
+         size_t holdsReused = 0;
+         // Attempts to shut down, and those aborted as some service could not be unregistered.
+         size_t shutdownAttempts = 0;
+         size_t shutdownsAborted = 0;
+     };
+
+     /**
+      * Returns counters of the client activity and shutdown attempts of this process.
+      */
+     Stats getStats() const;
+
    private:
      std::shared_ptr<internal::ClientCounterCallback> mClientCC;
      LazyServiceRegistrar();
@@ -370,6 +370,12 @@ public:
     // as long as it keeps a dup of the blob file descriptor handy for later.
     status_t            writeDupImmutableBlobFileDescriptor(int fd);
 
+    // Writes the size and contents of a read-only payload. Payloads too large
+    // to store in-place are copied into a sealed memfd (or an immutable ashmem
+    // region where memfd is unavailable), so the receiver maps them instead of
+    // copying them out of the transaction buffer. Read with readSealedBlob().
+    status_t            writeSealedBlob(const void* data, size_t len);
+
     status_t            writeObject(const flat_binder_object& val, bool nullMetaData);
 
     // Like Parcel.java's writeNoException().  Just writes a zero int32.
@@ -585,6 +591,10 @@ public:
     // The caller should call release() on the blob after reading its contents.
     status_t            readBlob(size_t len, ReadableBlob* outBlob) const;
 
+    // Reads a payload written by writeSealedBlob(). Large payloads are mapped
+    // read-only. The caller should call release() on the blob when done.
+    status_t            readSealedBlob(ReadableBlob* outBlob) const;
+
     const flat_binder_object* readObject(bool nullMetaData) const;
 
     // Explicitly close all file descriptors in the parcel.
@@ -638,6 +648,9 @@ private:
     status_t            validateReadData(size_t len) const;
 
     void                updateWorkSourceRequestHeaderPosition() const;
+    // Interface descriptor written by writeInterfaceToken(), or nullptr if the data does not
+    // start with one. Leaves the data position alone.
+    const char16_t*     peekInterfaceToken(size_t* outLen) const;
 
     status_t            finishFlattenBinder(const sp<IBinder>& binder);
     status_t            finishUnflattenBinder(const sp<IBinder>& binder, sp<IBinder>* out) const;
@@ -859,7 +872,7 @@ private:
             || std::is_same_v<T, uint64_t>
             || std::is_same_v<T, int64_t>
             || std::is_same_v<T, double>
-            || (std::is_enum_v<T> && (sizeof(T) == 1 || sizeof(T) == 4)); // size check not type
+            || (std::is_enum_v<T> && (sizeof(T) == 1 || sizeof(T) == 4 || sizeof(T) == 8)); // size check not type
 
     // allowed "nullable" types
     // These are nonintrusive containers std::optional, std::unique_ptr, std::shared_ptr.
@@ -1032,6 +1045,15 @@ private:
         if constexpr (is_pointer_equivalent_array_v<T>) {
             static_assert(N <= std::numeric_limits<size_t>::max() / sizeof(T));
             return write(val.data(), val.size() * sizeof(T));
+        } else if constexpr (std::is_same_v<T, bool>
+                || std::is_same_v<T, char16_t>) {
+            static_assert(N <= std::numeric_limits<size_t>::max() / sizeof(int32_t));
+            auto data = reinterpret_cast<int32_t*>(writeInplace(N * sizeof(int32_t)));
+            if (data == nullptr) return BAD_VALUE;
+            for (const auto t : val) {
+                *data++ = static_cast<int32_t>(t);
+            }
+            return OK;
         } else /* constexpr */ {
             for (const auto& t : val) {
                 status = writeData(t);
@@ -1246,6 +1268,13 @@ private:
             auto data = reinterpret_cast<const T*>(readInplace(N * sizeof(T)));
             if (data == nullptr) return BAD_VALUE;
             memcpy(val->data(), data, N * sizeof(T));
+        } else if constexpr (std::is_same_v<T, bool>
+                || std::is_same_v<T, char16_t>) {
+            auto data = reinterpret_cast<const int32_t*>(readInplace(N * sizeof(int32_t)));
+            if (data == nullptr) return BAD_VALUE;
+            for (auto& t : *val) {
+                t = static_cast<T>(*data++);
+            }
         } else if constexpr (is_specialization_v<T, sp>) {
             for (auto& t : *val) {
                 if (readFlags & READ_FLAG_SP_NULLABLE) {
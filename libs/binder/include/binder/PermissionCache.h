@@ -21,9 +21,12 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <array>
+#include <atomic>
+
+#include <utils/Mutex.h>
 #include <utils/String16.h>
 #include <utils/Singleton.h>
-#include <utils/SortedVector.h>
 
 namespace android {
 // ---------------------------------------------------------------------------
@@ -31,38 +34,62 @@ namespace android {
 /*
  * PermissionCache caches permission checks for a given uid.
  *
- * Currently the cache is not updated when there is a permission change,
- * for instance when an application is uninstalled.
+ * Granted permissions are cached until the cache is purged or the uid is
+ * invalidated, denied permissions for a few seconds, so that a permission
+ * granted later is eventually seen. Services that are notified of package or
+ * permission changes should call invalidateUid or purgeCache.
+ *
+ * IMPORTANT: since grants are not revoked otherwise, only system permissions
+ * are safe to cache.
  *
- * IMPORTANT: for the reason stated above, only system permissions are safe
- * to cache. This restriction may be lifted at a later time.
+ * Lookups do not take locks: entries live in a fixed-size table, and each
+ * slot has a sequence number that tells readers when it changed under them.
+ * Slots of stale entries are reused, so the table does not fill up with uids
+ * that are long gone.
  *
  */
 
 class PermissionCache : Singleton<PermissionCache> {
-    struct Entry {
-        String16    name;
-        uid_t       uid;
-        bool        granted;
-        inline bool operator < (const Entry& e) const {
-            return (uid == e.uid) ? (name < e.name) : (uid < e.uid);
-        }
+    // we pool all the permission names we see, as many permissions checks
+    // will have identical names. Names are only ever appended.
+    static constexpr size_t kMaxNames = 64;
+    static constexpr size_t kCapacity = 4096;
+
+    struct Slot {
+        // Odd while a writer changes the slot, and bumped again once it's done.
+        std::atomic<uint32_t> sequence{0};
+        // (uid << 32) | (name index + 1), or 0 if unassigned. Once assigned, a
+        // slot is never unassigned, so that probing stays correct.
+        std::atomic<uint64_t> key{0};
+        // Packed result, see PermissionCache.cpp.
+        std::atomic<uint64_t> value{0};
     };
+
+    // Serializes writers.
     mutable Mutex mLock;
-    // we pool all the permission names we see, as many permissions checks
-    // will have identical names
-    SortedVector< String16 > mPermissionNamesPool;
-    // this is our cache per say. it stores pooled names.
-    SortedVector< Entry > mCache;
+    std::array<String16, kMaxNames> mNames;
+    std::atomic<size_t> mNameCount{0};
+    std::array<Slot, kCapacity> mSlots;
+    // Bumped by purge, which makes all values stale.
+    std::atomic<uint32_t> mGeneration{0};
 
     // free the whole cache, but keep the permission name pool
     void purge();
 
+    void invalidate(uid_t uid);
+
     status_t check(bool* granted,
             const String16& permission, uid_t uid) const;
 
     void cache(const String16& permission, uid_t uid, bool granted);
 
+    // Changes a slot under mLock, so that concurrent lookups notice.
+    static void writeSlot(Slot& slot, uint64_t key, uint64_t value);
+
+    ssize_t findName(const String16& permission) const;
+
+    friend class PermissionCacheTest;
+
 public:
     PermissionCache();
 
@@ -75,6 +102,10 @@ public:
             pid_t pid, uid_t uid);
 
     static void purgeCache();
+
+    // Drops the cached results of the given uid, e.g. when its package or
+    // permissions change.
+    static void invalidateUid(uid_t uid);
 };
 
 // ---------------------------------------------------------------------------
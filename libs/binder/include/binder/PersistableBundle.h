@@ -16,8 +16,9 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
 #include <set>
+#include <variant>
 #include <vector>
 
 #include <binder/Parcelable.h>
@@ -31,6 +32,9 @@ namespace os {
 /*
  * C++ implementation of PersistableBundle, a mapping from String values to
  * various types that can be saved to persistent and later restored.
+ *
+ * All values live in a single vector sorted by key, so that lookups are a
+ * binary search, and parceling walks one contiguous table.
  */
 class PersistableBundle : public Parcelable {
 public:
@@ -92,16 +96,7 @@ public:
     std::set<String16> getStringVectorKeys() const;
     std::set<String16> getPersistableBundleKeys() const;
 
-    friend bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs) {
-        return (lhs.mBoolMap == rhs.mBoolMap && lhs.mIntMap == rhs.mIntMap &&
-                lhs.mLongMap == rhs.mLongMap && lhs.mDoubleMap == rhs.mDoubleMap &&
-                lhs.mStringMap == rhs.mStringMap && lhs.mBoolVectorMap == rhs.mBoolVectorMap &&
-                lhs.mIntVectorMap == rhs.mIntVectorMap &&
-                lhs.mLongVectorMap == rhs.mLongVectorMap &&
-                lhs.mDoubleVectorMap == rhs.mDoubleVectorMap &&
-                lhs.mStringVectorMap == rhs.mStringVectorMap &&
-                lhs.mPersistableBundleMap == rhs.mPersistableBundleMap);
-    }
+    friend bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs);
 
     friend bool operator!=(const PersistableBundle& lhs, const PersistableBundle& rhs) {
         return !(lhs == rhs);
@@ -111,17 +106,27 @@ private:
     status_t writeToParcelInner(Parcel* parcel) const;
     status_t readFromParcelInner(const Parcel* parcel, size_t length);
 
-    std::map<String16, bool> mBoolMap;
-    std::map<String16, int32_t> mIntMap;
-    std::map<String16, int64_t> mLongMap;
-    std::map<String16, double> mDoubleMap;
-    std::map<String16, String16> mStringMap;
-    std::map<String16, std::vector<bool>> mBoolVectorMap;
-    std::map<String16, std::vector<int32_t>> mIntVectorMap;
-    std::map<String16, std::vector<int64_t>> mLongVectorMap;
-    std::map<String16, std::vector<double>> mDoubleVectorMap;
-    std::map<String16, std::vector<String16>> mStringVectorMap;
-    std::map<String16, PersistableBundle> mPersistableBundleMap;
+    // Nested bundles are shared between copies, and never modified once stored.
+    using Value = std::variant<bool, int32_t, int64_t, double, String16, std::vector<bool>,
+                               std::vector<int32_t>, std::vector<int64_t>, std::vector<double>,
+                               std::vector<String16>, std::shared_ptr<const PersistableBundle>>;
+
+    struct Entry {
+        String16 key;
+        Value value;
+    };
+
+    template <typename T>
+    void putValue(const String16& key, T&& value);
+    template <typename T>
+    bool getValue(const String16& key, T* out) const;
+    template <typename T>
+    std::set<String16> getKeys() const;
+
+    std::vector<Entry>::const_iterator find(const String16& key) const;
+
+    /* Sorted by key, and keys are unique */
+    std::vector<Entry> mEntries;
 };
 
 }  // namespace os
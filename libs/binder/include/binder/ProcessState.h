@@ -21,9 +21,12 @@
 #include <utils/Mutex.h>
 #include <utils/String16.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 
 #include <pthread.h>
 
+#include <atomic>
+
 // ---------------------------------------------------------------------------
 namespace android {
 
@@ -109,6 +112,29 @@ public:
      */
     bool isThreadPoolStarted() const;
 
+    /**
+     * Allow the kernel thread pool ceiling to grow past the value given to
+     * setThreadPoolMaxThreadCount(), one thread at a time and never beyond
+     * maxThreads, each time every pool thread was busy for longer than a
+     * short starvation threshold. 0 (the default) keeps the ceiling fixed.
+     */
+    void setThreadPoolMaxThreadCountLimit(size_t maxThreads);
+
+    struct ThreadPoolStats {
+        size_t maxThreads;
+        size_t currentThreads;
+        size_t executingThreads;
+        // Most threads that were executing a command at the same time.
+        size_t peakExecutingThreads;
+        uint64_t commandsExecuted;
+        // Time spent executing commands, summed over all pool threads.
+        nsecs_t busyTime;
+        // Number of times and total time every pool thread was busy.
+        uint64_t starvationCount;
+        int64_t starvedTimeMs;
+    };
+    ThreadPoolStats getThreadPoolStats() const;
+
     enum class DriverFeature {
         ONEWAY_SPAM_DETECTION,
         EXTENDED_ERROR,
@@ -132,12 +158,29 @@ private:
     ProcessState(const ProcessState& o);
     ProcessState& operator=(const ProcessState& o);
     String8 makeBinderThreadName();
+    // Raise the kernel thread pool ceiling by one, up to mMaxThreadsLimit.
+    // Called with mThreadCountLock held.
+    void growThreadPoolLocked();
 
     struct handle_entry {
         IBinder* binder;
         RefBase::weakref_type* refs;
     };
 
+    // Handles are mapped to proxies in segments of kHandleSegmentSize entries. Segments are
+    // published with a CAS on first use and never moved nor freed while the process state lives,
+    // so finding an entry takes no lock. Entries are guarded by one of kHandleLockCount striped
+    // locks instead of mLock, so that threads resolving different handles do not contend.
+    static constexpr size_t kHandleSegmentSize = 256;
+    static constexpr size_t kHandleSegmentCount = 1024;
+    static constexpr size_t kHandleLockCount = 16;
+
+    struct alignas(64) handle_lock {
+        Mutex lock;
+    };
+
+    Mutex& handleLock(int32_t handle);
+    // Must be called with handleLock(handle) held.
     handle_entry* lookupHandleLocked(int32_t handle);
 
     String8 mDriverName;
@@ -160,11 +203,20 @@ private:
     size_t mKernelStartedThreads;
     // Time when thread pool was emptied
     int64_t mStarvationStartTimeMs;
+    // Upper bound for growing mMaxThreads on starvation, 0 if disabled.
+    size_t mMaxThreadsLimit;
+    // Statistics reported by getThreadPoolStats().
+    size_t mPeakExecutingThreads;
+    uint64_t mCommandsExecuted;
+    nsecs_t mBusyTime;
+    uint64_t mStarvationCount;
+    int64_t mStarvedTimeMs;
+
+    handle_lock mHandleLocks[kHandleLockCount];
+    std::atomic<handle_entry*> mHandleSegments[kHandleSegmentCount] = {};
 
     mutable Mutex mLock; // protects everything below.
 
-    Vector<handle_entry> mHandleToObject;
-
     bool mForked;
     bool mThreadPoolStarted;
     volatile int32_t mThreadPoolSeq;
@@ -19,6 +19,9 @@
 #include <android-base/unique_fd.h>
 #include <binder/Parcel.h>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace android {
 
@@ -37,6 +40,12 @@ public:
                                                           uint32_t code, uint32_t flags,
                                                           timespec timestamp, const Parcel& data,
                                                           const Parcel& reply, status_t err);
+    // Appends the transaction described by the arguments to buffer, in the format that
+    // dumpToFile writes, without copying the parcels into a RecordedTransaction first.
+    [[nodiscard]] static status_t serializeDetails(const String16& interfaceName, uint32_t code,
+                                                   uint32_t flags, timespec timestamp,
+                                                   const Parcel& data, const Parcel& reply,
+                                                   status_t err, std::vector<uint8_t>* buffer);
     RecordedTransaction(RecordedTransaction&& t) noexcept;
 
     [[nodiscard]] status_t dumpToFile(const android::base::unique_fd& fd) const;
@@ -53,9 +62,6 @@ public:
 private:
     RecordedTransaction() = default;
 
-    android::status_t writeChunk(const android::base::borrowed_fd, uint32_t chunkType,
-                                 size_t byteCount, const uint8_t* data) const;
-
 #pragma clang diagnostic push
 #pragma clang diagnostic error "-Wpadded"
     struct TransactionHeader {
@@ -71,6 +77,15 @@ private:
     static_assert(sizeof(TransactionHeader) == 32);
     static_assert(sizeof(TransactionHeader) % 8 == 0);
 
+    static TransactionHeader makeHeader(uint32_t code, uint32_t flags, timespec timestamp,
+                                        const Parcel& data, status_t err);
+    static std::optional<std::string> makeInterfaceName(const String16& interfaceName);
+    [[nodiscard]] static android::status_t appendTransaction(const TransactionHeader& header,
+                                                             const std::string& interfaceName,
+                                                             const Parcel& data,
+                                                             const Parcel& reply,
+                                                             std::vector<uint8_t>* buffer);
+
     struct MovableData { // movable
         TransactionHeader mHeader;
         std::string mInterfaceName;
@@ -94,6 +94,16 @@ public:
     void setMaxOutgoingConnections(size_t connections);
     size_t getMaxOutgoingThreads();
 
+    /**
+     * If enabled, a socket client (unix domain, vsock or inet) only opens its
+     * first outgoing connection during setup. The rest, up to the same limit
+     * as above, are opened one at a time when a call finds every existing
+     * connection busy. This avoids paying for connections (and transport
+     * handshakes) a session never uses concurrently. This must be called
+     * before setting up this connection as a client.
+     */
+    void setOutgoingConnectionsOnDemand(bool onDemand);
+
     /**
      * By default, the minimum of the supported versions of the client and the
      * server will be used. Usually, this API should only be used for debugging.
@@ -376,6 +386,11 @@ private:
     bool mStartedSetup = false;
     size_t mMaxIncomingThreads = 0;
     size_t mMaxOutgoingConnections = kDefaultMaxOutgoingConnections;
+    bool mOutgoingConnectionsOnDemand = false;
+    // Opens one more outgoing connection once setup is done, if on demand
+    // connections are enabled and supported by the client type.
+    std::function<status_t()> mConnectOnDemand;
+    size_t mMaxOnDemandOutgoing = 0;
     std::optional<uint32_t> mProtocolVersion;
     FileDescriptorTransportMode mFileDescriptorTransportMode = FileDescriptorTransportMode::NONE;
 
@@ -388,6 +403,8 @@ private:
         // hint index into clients, ++ when sending an async transaction
         size_t mOutgoingOffset = 0;
         std::vector<sp<RpcConnection>> mOutgoing;
+        // outgoing connections being opened by mConnectOnDemand
+        size_t mOutgoingConnecting = 0;
         // max size of mIncoming. Once any thread starts down, no more can be started.
         size_t mMaxIncoming = 0;
         std::vector<sp<RpcConnection>> mIncoming;
@@ -816,3 +816,11 @@ void AIBinder_setInheritRt(AIBinder* binder, bool inheritRt) {
 
     localBinder->setInheritRt(inheritRt);
 }
+
+void AIBinder_beginOnewayBatch() {
+    ::android::IPCThreadState::self()->beginOnewayBatch();
+}
+
+binder_status_t AIBinder_endOnewayBatch() {
+    return PruneStatusT(::android::IPCThreadState::self()->endOnewayBatch());
+}
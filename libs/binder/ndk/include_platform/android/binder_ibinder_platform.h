@@ -80,4 +80,21 @@ void AIBinder_setMinSchedulerPolicy(AIBinder* binder, int policy, int priority)
  */
 void AIBinder_setInheritRt(AIBinder* binder, bool inheritRt) __INTRODUCED_IN(33);
 
+/**
+ * Starts batching oneway transactions made on the calling thread. Until the
+ * matching AIBinder_endOnewayBatch, oneway AIBinder_transact calls are queued
+ * and return STATUS_OK; the outermost AIBinder_endOnewayBatch sends them all
+ * to the kernel at once. A non-oneway transaction in between sends the queued
+ * ones first. Batches may be nested.
+ */
+void AIBinder_beginOnewayBatch();
+
+/**
+ * Ends a batch started by AIBinder_beginOnewayBatch. Aborts if no batch is
+ * active.
+ *
+ * \return the first error hit by a transaction in the batch, or STATUS_OK.
+ */
+binder_status_t AIBinder_endOnewayBatch();
+
 __END_DECLS
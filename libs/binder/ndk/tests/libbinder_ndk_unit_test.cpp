@@ -618,6 +618,40 @@ TEST(NdkBinder, SetInheritRtNonLocal) {
     AIBinder_decStrong(binder);
 }
 
+TEST(NdkBinder, OnewayBatch) {
+    // functional test in binderLibTest
+    ndk::SpAIBinder binder;
+    sp<IFoo> foo = IFoo::getService(IFoo::kSomeInstanceName, binder.getR());
+    ASSERT_NE(nullptr, foo);
+    ASSERT_TRUE(AIBinder_isRemote(binder.get()));
+
+    auto transactOneway = [&binder] {
+        AParcel* in;
+        EXPECT_EQ(STATUS_OK, AIBinder_prepareTransaction(binder.get(), &in));
+        EXPECT_EQ(STATUS_OK, AParcel_writeInt32(in, 1));
+        ndk::ScopedAParcel out;
+        return AIBinder_transact(binder.get(), IFoo::DOFOO, &in, out.getR(), FLAG_ONEWAY);
+    };
+
+    AIBinder_beginOnewayBatch();
+    EXPECT_EQ(STATUS_OK, transactOneway());
+    AIBinder_beginOnewayBatch();
+    EXPECT_EQ(STATUS_OK, transactOneway());
+    EXPECT_EQ(STATUS_OK, AIBinder_endOnewayBatch());
+
+    // sends the queued transactions first
+    int32_t out;
+    EXPECT_EQ(STATUS_OK, foo->doubleNumber(2, &out));
+    EXPECT_EQ(4, out);
+
+    EXPECT_EQ(STATUS_OK, transactOneway());
+    EXPECT_EQ(STATUS_OK, AIBinder_endOnewayBatch());
+}
+
+TEST(NdkBinder, EndOnewayBatchWithoutBatch) {
+    EXPECT_DEATH(AIBinder_endOnewayBatch(), "");
+}
+
 TEST(NdkBinder, AddNullService) {
     EXPECT_EQ(EX_ILLEGAL_ARGUMENT, AServiceManager_addService(nullptr, "any-service-name"));
 }
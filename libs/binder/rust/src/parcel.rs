@@ -454,6 +454,23 @@ impl<'a> BorrowedParcel<'a> {
         x.deserialize_from(self)
     }
 
+    /// Read a non-null array into an existing vector, replacing its contents.
+    ///
+    /// For primitive element types the data is copied straight into the
+    /// vector's allocation, so reusing one vector across reads avoids
+    /// allocating for each array.
+    pub fn read_array_into<D: DeserializeArray>(&self, out: &mut Vec<D>) -> Result<()> {
+        D::deserialize_array_into(self, out)
+    }
+
+    /// Read a non-null array into a slice of exactly the same length.
+    ///
+    /// For primitive element types the data is copied straight into the
+    /// slice without allocating. Returns `BAD_VALUE` if the lengths differ.
+    pub fn read_slice_into<D: DeserializeArray>(&self, out: &mut [D]) -> Result<()> {
+        D::deserialize_slice_into(self, out)
+    }
+
     /// Safely read a sized parcelable.
     ///
     /// Read the size of a parcelable, compute the end position
@@ -588,6 +605,20 @@ impl Parcel {
         self.borrowed_ref().read_onto(x)
     }
 
+    /// Read a non-null array into an existing vector, replacing its contents.
+    ///
+    /// See [`BorrowedParcel::read_array_into`].
+    pub fn read_array_into<D: DeserializeArray>(&self, out: &mut Vec<D>) -> Result<()> {
+        self.borrowed_ref().read_array_into(out)
+    }
+
+    /// Read a non-null array into a slice of exactly the same length.
+    ///
+    /// See [`BorrowedParcel::read_slice_into`].
+    pub fn read_slice_into<D: DeserializeArray>(&self, out: &mut [D]) -> Result<()> {
+        self.borrowed_ref().read_slice_into(out)
+    }
+
     /// Safely read a sized parcelable.
     ///
     /// Read the size of a parcelable, compute the end position
@@ -922,3 +953,42 @@ fn test_append_from() {
     assert_eq!(Err(StatusCode::BAD_VALUE), parcel2.append_from(&parcel1, -1, 4));
     assert_eq!(Err(StatusCode::BAD_VALUE), parcel2.append_from(&parcel1, 2, -1));
 }
+
+#[test]
+fn test_read_array_into() {
+    let mut parcel = Parcel::new();
+    let start = parcel.get_data_position();
+
+    parcel.write(&[1u8, 2, 3][..]).unwrap();
+    parcel.write(&[4u8, 5][..]).unwrap();
+    parcel.write(&[1i64, -2, 3][..]).unwrap();
+    parcel.write(&["a", "b"][..]).unwrap();
+    parcel.write(&None::<Vec<i32>>).unwrap();
+    parcel.write(&[6i32, 7][..]).unwrap();
+
+    unsafe {
+        parcel.set_data_position(start).unwrap();
+    }
+
+    let mut bytes = Vec::with_capacity(16);
+    let capacity = bytes.capacity();
+    assert_eq!(parcel.read_array_into(&mut bytes), Ok(()));
+    assert_eq!(bytes, [1, 2, 3]);
+    assert_eq!(parcel.read_array_into(&mut bytes), Ok(()));
+    assert_eq!(bytes, [4, 5]);
+    assert_eq!(bytes.capacity(), capacity);
+
+    let mut longs = [0i64; 3];
+    assert_eq!(parcel.read_slice_into(&mut longs), Ok(()));
+    assert_eq!(longs, [1, -2, 3]);
+
+    let mut strings = vec!["stale".to_string()];
+    assert_eq!(parcel.read_array_into(&mut strings), Ok(()));
+    assert_eq!(strings, ["a", "b"]);
+
+    let mut ints = vec![];
+    assert_eq!(parcel.read_array_into(&mut ints), Err(StatusCode::UNEXPECTED_NULL));
+
+    let mut too_short = [0i32; 1];
+    assert_eq!(parcel.read_slice_into(&mut too_short), Err(StatusCode::BAD_VALUE));
+}
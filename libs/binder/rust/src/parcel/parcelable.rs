@@ -144,6 +144,36 @@ pub trait DeserializeArray: Deserialize {
         };
         Ok(vec)
     }
+
+    /// Deserialize a non-null array of this type into `out`, replacing its
+    /// contents.
+    ///
+    /// Primitive types override this to read the parcel data directly into
+    /// the existing allocation of `out`, so a caller that reads many arrays
+    /// can reuse one buffer instead of allocating a new vector for each read.
+    /// The contents of `out` are unspecified if this returns an error.
+    fn deserialize_array_into(parcel: &BorrowedParcel<'_>, out: &mut Vec<Self>) -> Result<()> {
+        *out = Self::deserialize_array(parcel)?.ok_or(StatusCode::UNEXPECTED_NULL)?;
+        Ok(())
+    }
+
+    /// Deserialize a non-null array of this type into `out`, which must have
+    /// exactly as many elements as the array in the parcel.
+    ///
+    /// Primitive types override this to copy the parcel data directly into
+    /// `out` without any intermediate allocation. Returns `BAD_VALUE` if the
+    /// length does not match. The contents of `out` are unspecified if this
+    /// returns an error.
+    fn deserialize_slice_into(parcel: &BorrowedParcel<'_>, out: &mut [Self]) -> Result<()> {
+        let vec = Self::deserialize_array(parcel)?.ok_or(StatusCode::UNEXPECTED_NULL)?;
+        if vec.len() != out.len() {
+            return Err(StatusCode::BAD_VALUE);
+        }
+        for (dst, src) in out.iter_mut().zip(vec) {
+            *dst = src;
+        }
+        Ok(())
+    }
 }
 
 /// Callback to deserialize a parcelable element.
@@ -272,6 +302,68 @@ unsafe extern "C" fn allocate_vec<T>(data: *mut c_void, len: i32) -> bool {
     true
 }
 
+/// Callback to reuse an existing vector for parcel array read functions.
+///
+/// Rejects null arrays, which the NDK reports as `UNEXPECTED_NULL`.
+///
+/// # Safety
+///
+/// The opaque data pointer passed to the array read function must be a mutable
+/// pointer to a `Vec<T>`. `buffer` will be assigned a mutable pointer to the
+/// vector data if this function returns true.
+unsafe extern "C" fn reuse_vec_with_buffer<T: Copy + Default>(
+    data: *mut c_void,
+    len: i32,
+    buffer: *mut *mut T,
+) -> bool {
+    if len < 0 {
+        return false;
+    }
+    let vec = &mut *(data as *mut Vec<T>);
+
+    // The elements are initialized here rather than left uninitialized, since
+    // the NDK may still fail to read the data after this returns.
+    vec.clear();
+    vec.resize(len as usize, T::default());
+    *buffer = vec.as_mut_ptr();
+    true
+}
+
+/// Caller-provided destination for parcel array read functions which must
+/// match the array length exactly.
+struct SliceReadTarget<T> {
+    ptr: *mut T,
+    len: usize,
+    len_mismatch: bool,
+}
+
+/// Callback to use a caller-provided slice for parcel array read functions.
+///
+/// Rejects null arrays, which the NDK reports as `UNEXPECTED_NULL`, and arrays
+/// whose length does not match the slice, which are flagged in the target.
+///
+/// # Safety
+///
+/// The opaque data pointer passed to the array read function must be a mutable
+/// pointer to a `SliceReadTarget<T>` describing a valid mutable slice.
+/// `buffer` will be assigned the slice pointer if this function returns true.
+unsafe extern "C" fn use_slice_with_buffer<T>(
+    data: *mut c_void,
+    len: i32,
+    buffer: *mut *mut T,
+) -> bool {
+    if len < 0 {
+        return false;
+    }
+    let target = &mut *(data as *mut SliceReadTarget<T>);
+    if len as usize != target.len {
+        target.len_mismatch = true;
+        return false;
+    }
+    *buffer = target.ptr;
+    true
+}
+
 macro_rules! parcelable_primitives {
     {
         $(
@@ -370,6 +462,52 @@ macro_rules! impl_parcelable {
                 };
                 Ok(vec)
             }
+
+            fn deserialize_array_into(
+                parcel: &BorrowedParcel<'_>,
+                out: &mut Vec<Self>,
+            ) -> Result<()> {
+                let status = unsafe {
+                    // Safety: `Parcel` always contains a valid pointer to an
+                    // `AParcel`. `reuse_vec_with_buffer<T>` expects the opaque
+                    // pointer to be of type `*mut Vec<T>`, so `out` is correct
+                    // for it.
+                    $read_array_fn(
+                        parcel.as_native(),
+                        out as *mut Vec<Self> as *mut c_void,
+                        Some(reuse_vec_with_buffer),
+                    )
+                };
+                status_result(status)
+            }
+
+            fn deserialize_slice_into(
+                parcel: &BorrowedParcel<'_>,
+                out: &mut [Self],
+            ) -> Result<()> {
+                let mut target = SliceReadTarget {
+                    ptr: out.as_mut_ptr(),
+                    len: out.len(),
+                    len_mismatch: false,
+                };
+                let status = unsafe {
+                    // Safety: `Parcel` always contains a valid pointer to an
+                    // `AParcel`. `use_slice_with_buffer<T>` expects the opaque
+                    // pointer to be of type `*mut SliceReadTarget<T>`, and
+                    // `target` describes the mutable slice `out`, which
+                    // outlives the call. The NDK only writes through the
+                    // pointer after the callback has checked the length.
+                    $read_array_fn(
+                        parcel.as_native(),
+                        &mut target as *mut _ as *mut c_void,
+                        Some(use_slice_with_buffer),
+                    )
+                };
+                if target.len_mismatch {
+                    return Err(StatusCode::BAD_VALUE);
+                }
+                status_result(status)
+            }
         }
     };
 }
@@ -382,7 +520,8 @@ parcelable_primitives! {
     impl Deserialize for bool = sys::AParcel_readBool;
 
     // This is only safe because `Option<Vec<u8>>` is interchangeable with
-    // `Option<Vec<i8>>` (what the allocator function actually allocates.
+    // `Option<Vec<i8>>` (what the allocator function actually allocates. The
+    // same holds for `Vec<u8>` and `SliceReadTarget<u8>` in the `_into` reads.
     impl DeserializeArray for u8 = sys::AParcel_readByteArray;
 
     impl Serialize for i8 = sys::AParcel_writeByte;
@@ -396,7 +535,8 @@ parcelable_primitives! {
     impl DeserializeArray for u16 = sys::AParcel_readCharArray;
 
     // This is only safe because `Option<Vec<i16>>` is interchangeable with
-    // `Option<Vec<u16>>` (what the allocator function actually allocates.
+    // `Option<Vec<u16>>` (what the allocator function actually allocates. The
+    // same holds for `Vec<i16>` and `SliceReadTarget<i16>` in the `_into` reads.
     impl DeserializeArray for i16 = sys::AParcel_readCharArray;
 
     impl Serialize for u32 = sys::AParcel_writeUint32;
@@ -26,6 +26,7 @@
 
 #include <malloc.h>
 #include <functional>
+#include <thread>
 #include <vector>
 
 static android::String8 gEmpty(""); // make sure first allocation from optimization runs
@@ -197,16 +198,34 @@ TEST(BinderAllocation, InterfaceDescriptorTransaction) {
 TEST(BinderAllocation, SmallTransaction) {
     String16 empty_descriptor = String16("");
     sp<IServiceManager> manager = defaultServiceManager();
+    sp<IBinder> a_binder = GetRemoteBinder();
 
-    size_t mallocs = 0;
-    const auto on_malloc = OnMalloc([&](size_t bytes) {
-        mallocs++;
-        // Parcel should allocate a small amount by default
-        EXPECT_EQ(bytes, 128);
-    });
-    manager->checkService(empty_descriptor);
+    // On a new thread, whose Parcel buffer cache is still empty.
+    std::thread([&] {
+        // Sets up the thread's IPCThreadState, without using a Parcel buffer.
+        a_binder->pingBinder();
 
-    EXPECT_EQ(mallocs, 1);
+        size_t mallocs = 0;
+        const auto on_malloc = OnMalloc([&](size_t bytes) {
+            mallocs++;
+            // Parcel should allocate a small amount by default
+            EXPECT_EQ(bytes, 256);
+        });
+        manager->checkService(empty_descriptor);
+
+        EXPECT_EQ(mallocs, 1);
+    }).join();
+}
+
+TEST(BinderAllocation, RepeatedSmallTransaction) {
+    String16 empty_descriptor = String16("");
+    sp<IServiceManager> manager = defaultServiceManager();
+    manager->checkService(empty_descriptor); // first call may alloc
+
+    // The Parcel buffer from the previous transaction is reused
+    const auto m = ScopeDisallowMalloc();
+    manager->checkService(empty_descriptor);
+    manager->checkService(empty_descriptor);
 }
 
 TEST(RpcBinderAllocation, SetupRpcServer) {
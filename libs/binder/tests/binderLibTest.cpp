@@ -27,6 +27,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
 #include <android-base/result-gmock.h>
 #include <android-base/result.h>
@@ -38,6 +39,8 @@
 #include <binder/IBinder.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
+#include <binder/LatencyProfile.h>
+#include <binder/PermissionCache.h>
 #include <binder/RpcServer.h>
 #include <binder/RpcSession.h>
 
@@ -47,6 +50,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 
+#include "../IdleHoldTracker.h"
 #include "../binder_module.h"
 #include "binderAbiHelper.h"
 
@@ -59,6 +63,7 @@ using android::base::testing::HasValue;
 using android::base::testing::Ok;
 using testing::ExplainMatchResult;
 using testing::Matcher;
+using testing::HasSubstr;
 using testing::Not;
 using testing::WithParamInterface;
 
@@ -124,7 +129,8 @@ enum BinderLibTestTranscationCode {
     BINDER_LIB_TEST_LOCK_UNLOCK,
     BINDER_LIB_TEST_PROCESS_LOCK,
     BINDER_LIB_TEST_UNLOCK_AFTER_MS,
-    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK
+    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK,
+    BINDER_LIB_TEST_GET_COMMANDS_EXECUTED,
 };
 
 pid_t start_server_process(int arg2, bool usePoll = false)
@@ -476,6 +482,25 @@ TEST_F(BinderLibTest, NopTransactionOneway) {
                 StatusEq(NO_ERROR));
 }
 
+TEST_F(BinderLibTest, NopTransactionOnewayBatch) {
+    IPCThreadState* ipc = IPCThreadState::self();
+    ipc->beginOnewayBatch();
+    for (int i = 0; i < 100; i++) {
+        // the batch must not depend on the caller's Parcel staying alive
+        Parcel data;
+        data.writeInt32(i);
+        EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, nullptr,
+                                       TF_ONE_WAY),
+                    StatusEq(NO_ERROR));
+    }
+    EXPECT_THAT(ipc->endOnewayBatch(), StatusEq(NO_ERROR));
+
+    // nothing should be left over to confuse a synchronous call
+    Parcel data, reply;
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+}
+
 TEST_F(BinderLibTest, NopTransactionClear) {
     Parcel data, reply;
     // make sure it accepts the transaction flag
@@ -1351,6 +1376,246 @@ TEST(ServiceNotifications, Unregister) {
     EXPECT_EQ(sm->unregisterForNotifications(String16("RogerRafa"), cb), OK);
 }
 
+TEST(ServiceLookupCache, RepeatedCheckServiceHits) {
+    auto sm = defaultServiceManager();
+    sp<IBinder> first = sm->checkService(binderLibTestServiceName);
+    ASSERT_NE(nullptr, first);
+
+    ServiceLookupCacheStats before = getServiceLookupCacheStats();
+    sp<IBinder> second = sm->checkService(binderLibTestServiceName);
+    ServiceLookupCacheStats after = getServiceLookupCacheStats();
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(before.hits + 1, after.hits);
+    EXPECT_EQ(before.misses, after.misses);
+}
+
+namespace android {
+
+class PermissionCacheTest : public ::testing::Test {
+protected:
+    static constexpr size_t kCapacity = PermissionCache::kCapacity;
+
+    void cache(const String16& permission, uid_t uid, bool granted) {
+        mCache->cache(permission, uid, granted);
+    }
+    status_t check(bool* granted, const String16& permission, uid_t uid) const {
+        return mCache->check(granted, permission, uid);
+    }
+    void purge() { mCache->purge(); }
+    void invalidate(uid_t uid) { mCache->invalidate(uid); }
+
+    const String16 mPermission{"android.permission.DUMP"};
+
+private:
+    std::unique_ptr<PermissionCache> mCache = std::make_unique<PermissionCache>();
+};
+
+} // namespace android
+
+TEST_F(PermissionCacheTest, CachesGrantsAndDenials) {
+    bool granted = false;
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, 1000));
+
+    cache(mPermission, 1000, true);
+    cache(mPermission, 1001, false);
+    ASSERT_EQ(NO_ERROR, check(&granted, mPermission, 1000));
+    EXPECT_TRUE(granted);
+    ASSERT_EQ(NO_ERROR, check(&granted, mPermission, 1001));
+    EXPECT_FALSE(granted);
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, String16("android.permission.INTERNET"), 1000));
+
+    cache(mPermission, 1001, true);
+    ASSERT_EQ(NO_ERROR, check(&granted, mPermission, 1001));
+    EXPECT_TRUE(granted);
+}
+
+TEST_F(PermissionCacheTest, PurgeAndInvalidateDropEntries) {
+    bool granted = false;
+    cache(mPermission, 1000, true);
+    cache(mPermission, 1001, true);
+
+    invalidate(1000);
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, 1000));
+    EXPECT_EQ(NO_ERROR, check(&granted, mPermission, 1001));
+
+    purge();
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, 1001));
+}
+
+TEST_F(PermissionCacheTest, FullTableDoesNotCache) {
+    for (uid_t uid = 0; uid < kCapacity; uid++) {
+        cache(mPermission, uid, true);
+    }
+    bool granted = false;
+    cache(mPermission, kCapacity, true);
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, kCapacity));
+    for (uid_t uid = 0; uid < kCapacity; uid++) {
+        ASSERT_EQ(NO_ERROR, check(&granted, mPermission, uid)) << "uid " << uid;
+    }
+}
+
+TEST_F(PermissionCacheTest, ReusesInvalidatedSlots) {
+    for (uid_t uid = 0; uid < kCapacity; uid++) {
+        cache(mPermission, uid, true);
+    }
+    invalidate(7);
+
+    bool granted = false;
+    cache(mPermission, kCapacity, true);
+    ASSERT_EQ(NO_ERROR, check(&granted, mPermission, kCapacity));
+    EXPECT_TRUE(granted);
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, 7));
+    for (uid_t uid = 0; uid < kCapacity; uid++) {
+        if (uid != 7) {
+            ASSERT_EQ(NO_ERROR, check(&granted, mPermission, uid)) << "uid " << uid;
+        }
+    }
+}
+
+TEST_F(PermissionCacheTest, ReusesPurgedSlots) {
+    for (uid_t uid = 0; uid < kCapacity; uid++) {
+        cache(mPermission, uid, true);
+    }
+    purge();
+
+    // A whole new set of uids fits once the old entries are stale.
+    for (uid_t uid = kCapacity; uid < 2 * kCapacity; uid++) {
+        cache(mPermission, uid, uid % 2 == 0);
+    }
+    bool granted = false;
+    for (uid_t uid = kCapacity; uid < 2 * kCapacity; uid++) {
+        ASSERT_EQ(NO_ERROR, check(&granted, mPermission, uid)) << "uid " << uid;
+        EXPECT_EQ(uid % 2 == 0, granted);
+    }
+    EXPECT_EQ(NAME_NOT_FOUND, check(&granted, mPermission, 0));
+}
+
+TEST(IdleHoldTrackerTest, FixedHold) {
+    binder::internal::IdleHoldTracker tracker;
+    tracker.setHold(100ms, 100ms);
+    EXPECT_EQ(100ms, tracker.getHold());
+
+    const auto start = binder::internal::IdleHoldTracker::Clock::now();
+    tracker.onIdle(start);
+    tracker.onActive(start + 10ms, true);
+    EXPECT_EQ(100ms, tracker.getHold());
+}
+
+TEST(IdleHoldTrackerTest, HoldsForMaxUntilIdleTimeIsSeen) {
+    binder::internal::IdleHoldTracker tracker;
+    tracker.setHold(50ms, 1000ms);
+    EXPECT_EQ(1000ms, tracker.getHold());
+
+    // A client which was there from the start says nothing about idle times.
+    const auto start = binder::internal::IdleHoldTracker::Clock::now();
+    tracker.onActive(start, false);
+    EXPECT_EQ(1000ms, tracker.getHold());
+
+    // An idle time longer than minHold is learned, as the process was held for maxHold.
+    tracker.onIdle(start + 100ms);
+    tracker.onActive(start + 500ms, true);
+    EXPECT_EQ(600ms, tracker.getHold());
+}
+
+TEST(IdleHoldTrackerTest, PredictionFollowsRecentIdleTimes) {
+    binder::internal::IdleHoldTracker tracker;
+    tracker.setHold(50ms, 1000ms);
+
+    const auto start = binder::internal::IdleHoldTracker::Clock::now();
+    tracker.onIdle(start);
+    tracker.onActive(start + 400ms, true);
+    tracker.onIdle(start + 500ms);
+    tracker.onActive(start + 1300ms, true);
+    // The average is (400 * 3 + 800) / 4 = 500ms, held with 50% slack.
+    EXPECT_EQ(750ms, tracker.getHold());
+
+    // Short idle times never hold for less than minHold.
+    for (int i = 0; i < 20; i++) {
+        const auto idle = start + 2s + i * 10ms;
+        tracker.onIdle(idle);
+        tracker.onActive(idle + 1ms, true);
+    }
+    EXPECT_EQ(50ms, tracker.getHold());
+}
+
+TEST(IdleHoldTrackerTest, LongIdleTimesOnlyHoldForMin) {
+    binder::internal::IdleHoldTracker tracker;
+    tracker.setHold(50ms, 1000ms);
+
+    const auto start = binder::internal::IdleHoldTracker::Clock::now();
+    tracker.onIdle(start);
+    tracker.onActive(start + 900ms, true);
+    EXPECT_EQ(50ms, tracker.getHold());
+}
+
+TEST(IdleHoldTrackerTest, Stats) {
+    binder::internal::IdleHoldTracker tracker;
+    tracker.setHold(50ms, 1000ms);
+
+    const auto start = binder::internal::IdleHoldTracker::Clock::now();
+    tracker.onActive(start, false);
+    tracker.onIdle(start + 10ms);
+    tracker.onActive(start + 20ms, true);
+    tracker.onIdle(start + 30ms);
+    tracker.onActive(start + 40ms, false);
+    tracker.onIdle(start + 50ms);
+
+    const binder::LazyServiceRegistrar::Stats& stats = tracker.stats();
+    EXPECT_EQ(3u, stats.activations);
+    EXPECT_EQ(3u, stats.deactivations);
+    EXPECT_EQ(1u, stats.holdsReused);
+    EXPECT_EQ(0u, stats.shutdownAttempts);
+    EXPECT_EQ(0u, stats.shutdownsAborted);
+}
+
+TEST_F(BinderLibTest, LatencyProfileRecordsClientTransactions) {
+    using binder::debug::LatencyProfile;
+    LatencyProfile::setEnabled(true);
+    auto disable = base::make_scope_guard([] { LatencyProfile::setEnabled(false); });
+
+    auto countNops = [] {
+        for (const LatencyProfile::Histogram& h : LatencyProfile::snapshot()) {
+            if (h.side == LatencyProfile::Side::CLIENT &&
+                h.code == BINDER_LIB_TEST_NOP_TRANSACTION &&
+                h.descriptor == binderLibTestServiceName) {
+                return h.count;
+            }
+        }
+        return uint64_t{0};
+    };
+    uint64_t before = countNops();
+
+    constexpr size_t kTransactions = 10;
+    for (size_t i = 0; i < kTransactions; i++) {
+        Parcel data, reply;
+        ASSERT_THAT(data.writeInterfaceToken(binderLibTestServiceName), StatusEq(NO_ERROR));
+        EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                    StatusEq(NO_ERROR));
+    }
+    EXPECT_EQ(before + kTransactions, countNops());
+}
+
+TEST_F(BinderLibTest, LatencyProfileDumpsServerTransactions) {
+    Parcel data, reply;
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+
+    // The first dump only turns profiling on in the server process.
+    int pipefd[2];
+    ASSERT_EQ(0, pipe(pipefd));
+    base::unique_fd readEnd(pipefd[0]), writeEnd(pipefd[1]);
+    EXPECT_THAT(m_server->dumpLatencyProfile(writeEnd.get()), StatusEq(NO_ERROR));
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+    EXPECT_THAT(m_server->dumpLatencyProfile(writeEnd.get()), StatusEq(NO_ERROR));
+    writeEnd.reset();
+
+    std::string dump;
+    ASSERT_TRUE(base::ReadFdToString(readEnd, &dump));
+    EXPECT_THAT(dump, HasSubstr("server <no descriptor> code " +
+                                std::to_string(BINDER_LIB_TEST_NOP_TRANSACTION)));
+}
+
 TEST_F(BinderLibTest, ThreadPoolAvailableThreads) {
     Parcel data, reply;
     sp<IBinder> server = addServer();
@@ -1390,6 +1655,25 @@ TEST_F(BinderLibTest, ThreadPoolAvailableThreads) {
     EXPECT_EQ(replyi, kKernelThreads + 1);
 }
 
+TEST_F(BinderLibTest, ThreadPoolStatsCountCommands) {
+    Parcel data, reply;
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+    EXPECT_THAT(server->transact(BINDER_LIB_TEST_GET_COMMANDS_EXECUTED, data, &reply),
+                StatusEq(NO_ERROR));
+    const uint64_t before = reply.readUint64();
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_THAT(server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                    StatusEq(NO_ERROR));
+    }
+
+    EXPECT_THAT(server->transact(BINDER_LIB_TEST_GET_COMMANDS_EXECUTED, data, &reply),
+                StatusEq(NO_ERROR));
+    // the stats request itself is still executing, so it is not counted yet
+    EXPECT_GE(reply.readUint64(), before + 4);
+}
+
 TEST_F(BinderLibTest, ThreadPoolStarted) {
     Parcel data, reply;
     sp<IBinder> server = addServer();
@@ -1866,6 +2150,10 @@ public:
                 reply->writeInt32(ProcessState::self()->getThreadPoolMaxTotalThreadCount());
                 return NO_ERROR;
             }
+            case BINDER_LIB_TEST_GET_COMMANDS_EXECUTED: {
+                reply->writeUint64(ProcessState::self()->getThreadPoolStats().commandsExecuted);
+                return NO_ERROR;
+            }
             case BINDER_LIB_TEST_IS_THREADPOOL_STARTED: {
                 reply->writeBool(ProcessState::self()->isThreadPoolStarted());
                 return NO_ERROR;
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../SimpleBestFitAllocator.h"
+
+using namespace android;
+
+static bool failed(size_t offset) {
+    return static_cast<ssize_t>(offset) < 0;
+}
+
+TEST(SimpleBestFitAllocator, RoundsUpToAlignment) {
+    SimpleBestFitAllocator allocator(1);
+    const size_t align = SimpleBestFitAllocator::getAllocationAlignment();
+    EXPECT_EQ(static_cast<size_t>(getpagesize()), allocator.size());
+
+    EXPECT_EQ(0u, allocator.allocate(1));
+    EXPECT_EQ(align, allocator.allocate(align));
+    EXPECT_EQ(2 * align, allocator.allocate(1));
+}
+
+TEST(SimpleBestFitAllocator, FailsWhenFull) {
+    const size_t quarter = getpagesize() / 4;
+    SimpleBestFitAllocator allocator(getpagesize());
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(i * quarter, allocator.allocate(quarter));
+    }
+    EXPECT_TRUE(failed(allocator.allocate(1)));
+
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(quarter));
+    EXPECT_EQ(quarter, allocator.allocate(1));
+}
+
+TEST(SimpleBestFitAllocator, CoalescesFreedNeighbors) {
+    const size_t quarter = getpagesize() / 4;
+    SimpleBestFitAllocator allocator(getpagesize());
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_EQ(i * quarter, allocator.allocate(quarter));
+    }
+
+    // Merged with the free chunk after it.
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(2 * quarter));
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(quarter));
+    EXPECT_EQ(quarter, allocator.allocate(2 * quarter));
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(quarter));
+
+    // Merged with the free chunks on both sides.
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(0));
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(3 * quarter));
+    EXPECT_EQ(0u, allocator.allocate(getpagesize()));
+}
+
+TEST(SimpleBestFitAllocator, BestFitInSizeClassThenFirstLargerClass) {
+    SimpleBestFitAllocator allocator(getpagesize());
+    ASSERT_EQ(0u, allocator.allocate(512));
+    ASSERT_EQ(512u, allocator.allocate(32));
+    ASSERT_EQ(544u, allocator.allocate(128));
+    ASSERT_EQ(672u, allocator.allocate(32));
+    ASSERT_EQ(NO_ERROR, allocator.deallocate(0));
+    ASSERT_EQ(NO_ERROR, allocator.deallocate(544));
+
+    // The exact fit, rather than the larger hole before it.
+    EXPECT_EQ(544u, allocator.allocate(128));
+
+    // No chunk of this size class is free, so the smallest larger class serves it, which is the
+    // 512 byte hole rather than the rest of the heap.
+    EXPECT_EQ(0u, allocator.allocate(96));
+    EXPECT_EQ(96u, allocator.allocate(416));
+    EXPECT_EQ(704u, allocator.allocate(32));
+}
+
+TEST(SimpleBestFitAllocator, PageAligned) {
+    const size_t pagesize = getpagesize();
+    SimpleBestFitAllocator allocator(3 * pagesize);
+    ASSERT_EQ(0u, allocator.allocate(32));
+
+    EXPECT_EQ(pagesize, allocator.allocate(64, SimpleBestFitAllocator::PAGE_ALIGNED));
+    // The padding before the aligned block is still free.
+    EXPECT_EQ(32u, allocator.allocate(pagesize - 32));
+    EXPECT_EQ(pagesize + 64, allocator.allocate(32));
+
+    // Already aligned chunks need no padding.
+    EXPECT_EQ(2 * pagesize, allocator.allocate(32, SimpleBestFitAllocator::PAGE_ALIGNED));
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(pagesize));
+    EXPECT_EQ(pagesize, allocator.allocate(64, SimpleBestFitAllocator::PAGE_ALIGNED));
+}
+
+TEST(SimpleBestFitAllocator, DeallocateUnknownOffset) {
+    SimpleBestFitAllocator allocator(getpagesize());
+    ASSERT_EQ(0u, allocator.allocate(128));
+
+    EXPECT_EQ(NAME_NOT_FOUND, allocator.deallocate(64));
+    EXPECT_EQ(NO_ERROR, allocator.deallocate(0));
+}
@@ -15,6 +15,7 @@
  */
 
 #include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
 #include <benchmark/benchmark.h>
 
 // Usage: atest binderParcelBenchmark
@@ -169,4 +170,67 @@ BENCHMARK(BM_CharVector)->Apply(VectorArgs);
 BENCHMARK(BM_Int32Vector)->Apply(VectorArgs);
 BENCHMARK(BM_Int64Vector)->Apply(VectorArgs);
 
+// A bundle with |entries| values, cycling through the common scalar and string types, like the
+// metrics bundles that native services exchange.
+static android::os::PersistableBundle makeBundle(size_t entries) {
+    android::os::PersistableBundle bundle;
+    for (size_t i = 0; i < entries; ++i) {
+        const android::String16 key(("android.media.metrics.key" + std::to_string(i)).c_str());
+        switch (i % 4) {
+            case 0:
+                bundle.putInt(key, static_cast<int32_t>(i));
+                break;
+            case 1:
+                bundle.putLong(key, static_cast<int64_t>(i));
+                break;
+            case 2:
+                bundle.putDouble(key, static_cast<double>(i));
+                break;
+            default:
+                bundle.putString(key, android::String16("value"));
+                break;
+        }
+    }
+    return bundle;
+}
+
+// Parcels a bundle then reads it back into a new one.
+static void BM_PersistableBundleParcel(benchmark::State& state) {
+    const size_t entries = state.range(0);
+    const android::os::PersistableBundle bundle = makeBundle(entries);
+    android::Parcel p;
+    while (state.KeepRunning()) {
+        p.setDataPosition(0);
+        bundle.writeToParcel(&p);
+
+        p.setDataPosition(0);
+        android::os::PersistableBundle read;
+        read.readFromParcel(&p);
+
+        benchmark::DoNotOptimize(read);
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(entries);
+}
+
+// Looks up every key of a bundle.
+static void BM_PersistableBundleGet(benchmark::State& state) {
+    const size_t entries = state.range(0);
+    const android::os::PersistableBundle bundle = makeBundle(entries);
+    std::vector<android::String16> keys;
+    for (size_t i = 0; i < entries; ++i) {
+        keys.emplace_back(("android.media.metrics.key" + std::to_string(i)).c_str());
+    }
+    while (state.KeepRunning()) {
+        for (const auto& key : keys) {
+            int32_t value;
+            benchmark::DoNotOptimize(bundle.getInt(key, &value));
+        }
+    }
+    state.SetComplexityN(entries);
+}
+
+BENCHMARK(BM_PersistableBundleParcel)->Apply(VectorArgs);
+BENCHMARK(BM_PersistableBundleGet)->Apply(VectorArgs);
+
 BENCHMARK_MAIN();
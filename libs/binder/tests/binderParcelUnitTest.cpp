@@ -16,6 +16,7 @@
 
 #include <binder/IPCThreadState.h>
 #include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
 #include <binder/Status.h>
 #include <cutils/ashmem.h>
 #include <gtest/gtest.h>
@@ -30,6 +31,7 @@ using android::status_t;
 using android::String16;
 using android::String8;
 using android::binder::Status;
+using android::os::PersistableBundle;
 
 TEST(Parcel, NonNullTerminatedString8) {
     String8 kTestString = String8("test-is-good");
@@ -200,6 +202,63 @@ TEST_READ_WRITE_INVERSE(int8_t, Byte, {-1, 0, 1});
 TEST_READ_WRITE_INVERSE(String8, String8, {String8(), String8("a"), String8("asdf")});
 TEST_READ_WRITE_INVERSE(String16, String16, {String16(), String16("a"), String16("asdf")});
 
+// Bulk array paths must produce the same bytes as writing each element.
+TEST(Parcel, BulkArraysMatchElementWiseWrites) {
+    enum class LongEnum : int64_t { A = -1, B = 1LL << 40 };
+    const std::array<bool, 3> bools = {true, false, true};
+    const std::array<char16_t, 3> chars = {u'a', u'\0', u'\xffff'};
+    const std::vector<LongEnum> enums = {LongEnum::A, LongEnum::B};
+
+    Parcel bulk;
+    ASSERT_EQ(OK, bulk.writeFixedArray(bools));
+    ASSERT_EQ(OK, bulk.writeFixedArray(chars));
+    ASSERT_EQ(OK, bulk.writeEnumVector(enums));
+
+    Parcel elementWise;
+    elementWise.writeInt32(bools.size());
+    for (bool b : bools) elementWise.writeBool(b);
+    elementWise.writeInt32(chars.size());
+    for (char16_t c : chars) elementWise.writeChar(c);
+    elementWise.writeInt32(enums.size());
+    for (LongEnum e : enums) elementWise.writeInt64(static_cast<int64_t>(e));
+
+    ASSERT_EQ(elementWise.dataSize(), bulk.dataSize());
+    EXPECT_EQ(0, memcmp(elementWise.data(), bulk.data(), bulk.dataSize()));
+
+    bulk.setDataPosition(0);
+    std::array<bool, 3> readBools;
+    std::array<char16_t, 3> readChars;
+    std::vector<LongEnum> readEnums;
+    EXPECT_EQ(OK, bulk.readFixedArray(&readBools));
+    EXPECT_EQ(OK, bulk.readFixedArray(&readChars));
+    EXPECT_EQ(OK, bulk.readEnumVector(&readEnums));
+    EXPECT_EQ(bools, readBools);
+    EXPECT_EQ(chars, readChars);
+    EXPECT_EQ(enums, readEnums);
+}
+
+TEST(Parcel, SealedBlobRoundTrip) {
+    for (size_t size : {size_t{16}, size_t{256 * 1024}}) {
+        std::vector<uint8_t> payload(size);
+        for (size_t i = 0; i < size; i++) payload[i] = static_cast<uint8_t>(i * 31);
+
+        Parcel p;
+        ASSERT_EQ(OK, p.writeSealedBlob(payload.data(), payload.size()));
+        if (size > 16 * 1024) {
+            // large payloads travel as a file descriptor, not in the parcel itself
+            EXPECT_TRUE(p.hasFileDescriptors());
+            EXPECT_LT(p.dataSize(), size);
+        }
+
+        p.setDataPosition(0);
+        Parcel::ReadableBlob blob;
+        ASSERT_EQ(OK, p.readSealedBlob(&blob));
+        ASSERT_EQ(size, blob.size());
+        EXPECT_EQ(0, memcmp(payload.data(), blob.data(), size));
+        blob.release();
+    }
+}
+
 TEST(Parcel, GetOpenAshmemSize) {
     constexpr size_t kSize = 1024;
     constexpr size_t kCount = 3;
@@ -214,3 +273,111 @@ TEST(Parcel, GetOpenAshmemSize) {
         ASSERT_EQ((kSize * (i + 1)), p.getOpenAshmemSize());
     }
 }
+
+TEST(PersistableBundle, PutGetErase) {
+    PersistableBundle bundle;
+    bundle.putInt(String16("b"), 1);
+    bundle.putString(String16("a"), String16("value"));
+    bundle.putLong(String16("c"), 2);
+    EXPECT_EQ(3u, bundle.size());
+
+    int32_t intValue;
+    String16 stringValue;
+    int64_t longValue;
+    EXPECT_TRUE(bundle.getInt(String16("b"), &intValue));
+    EXPECT_EQ(1, intValue);
+    EXPECT_TRUE(bundle.getString(String16("a"), &stringValue));
+    EXPECT_EQ(String16("value"), stringValue);
+    EXPECT_TRUE(bundle.getLong(String16("c"), &longValue));
+    EXPECT_EQ(2, longValue);
+    EXPECT_FALSE(bundle.getInt(String16("missing"), &intValue));
+
+    EXPECT_EQ(1u, bundle.erase(String16("b")));
+    EXPECT_EQ(0u, bundle.erase(String16("b")));
+    EXPECT_FALSE(bundle.getInt(String16("b"), &intValue));
+    EXPECT_EQ(2u, bundle.size());
+}
+
+TEST(PersistableBundle, PutOverwritesType) {
+    PersistableBundle bundle;
+    bundle.putInt(String16("key"), 1);
+    bundle.putString(String16("key"), String16("value"));
+    EXPECT_EQ(1u, bundle.size());
+
+    int32_t intValue;
+    String16 stringValue;
+    EXPECT_FALSE(bundle.getInt(String16("key"), &intValue));
+    EXPECT_TRUE(bundle.getString(String16("key"), &stringValue));
+    EXPECT_EQ(String16("value"), stringValue);
+    EXPECT_TRUE(bundle.getIntKeys().empty());
+    EXPECT_EQ(1u, bundle.getStringKeys().size());
+}
+
+TEST(PersistableBundle, ParcelRoundTrip) {
+    PersistableBundle nested;
+    nested.putBoolean(String16("bool"), true);
+
+    PersistableBundle bundle;
+    bundle.putInt(String16("int"), 1);
+    bundle.putDouble(String16("double"), 2.5);
+    bundle.putStringVector(String16("strings"), {String16("a"), String16("b")});
+    bundle.putPersistableBundle(String16("nested"), nested);
+
+    Parcel p;
+    ASSERT_EQ(OK, bundle.writeToParcel(&p));
+    p.setDataPosition(0);
+    PersistableBundle read;
+    ASSERT_EQ(OK, read.readFromParcel(&p));
+    EXPECT_EQ(bundle, read);
+}
+
+// BAD! assumption of wire format for the following tests, which write bundles by hand.
+constexpr int32_t kBundleMagicNative = 0x4C444E44;
+constexpr int32_t kValString = 0;
+constexpr int32_t kValInteger = 1;
+
+TEST(PersistableBundle, ReadDuplicateKeyKeepsLastValue) {
+    Parcel p;
+    p.writeInt32(1); // length, only checked for being non-zero
+    p.writeInt32(kBundleMagicNative);
+    p.writeInt32(2);
+    p.writeString16(String16("key"));
+    p.writeInt32(kValInteger);
+    p.writeInt32(1);
+    p.writeString16(String16("key"));
+    p.writeInt32(kValString);
+    p.writeString16(String16("last"));
+
+    p.setDataPosition(0);
+    PersistableBundle bundle;
+    ASSERT_EQ(OK, bundle.readFromParcel(&p));
+    EXPECT_EQ(1u, bundle.size());
+
+    String16 value;
+    EXPECT_TRUE(bundle.getString(String16("key"), &value));
+    EXPECT_EQ(String16("last"), value);
+}
+
+TEST(PersistableBundle, FailedReadLeavesBundleUnchanged) {
+    Parcel p;
+    p.writeInt32(1); // length, only checked for being non-zero
+    p.writeInt32(kBundleMagicNative);
+    p.writeInt32(2);
+    p.writeString16(String16("a"));
+    p.writeInt32(kValInteger);
+    p.writeInt32(1);
+    p.writeString16(String16("b"));
+    p.writeInt32(-100); // unknown type
+
+    PersistableBundle bundle;
+    bundle.putInt(String16("existing"), 2);
+
+    p.setDataPosition(0);
+    EXPECT_NE(OK, bundle.readFromParcel(&p));
+    EXPECT_EQ(1u, bundle.size());
+
+    int32_t value;
+    EXPECT_FALSE(bundle.getInt(String16("a"), &value));
+    EXPECT_TRUE(bundle.getInt(String16("existing"), &value));
+    EXPECT_EQ(2, value);
+}
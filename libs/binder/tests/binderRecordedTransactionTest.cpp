@@ -14,14 +14,38 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <binder/RecordedTransaction.h>
 #include <gtest/gtest.h>
 #include <utils/Errors.h>
 
+#include <algorithm>
+#include <thread>
+
+#include "../TransactionRecorder.h"
+
 using android::Parcel;
 using android::status_t;
 using android::base::unique_fd;
 using android::binder::debug::RecordedTransaction;
+using android::binder::debug::TransactionRecorder;
+
+// Reads all transactions from the start of fd, and returns their codes.
+static std::vector<uint32_t> readCodes(const unique_fd& fd) {
+    std::vector<uint32_t> codes;
+    struct stat fileStat;
+    if (fstat(fd.get(), &fileStat) != 0 || lseek(fd.get(), 0, SEEK_SET) != 0) {
+        return codes;
+    }
+    while (lseek(fd.get(), 0, SEEK_CUR) < fileStat.st_size) {
+        auto transaction = RecordedTransaction::fromFile(fd);
+        if (!transaction.has_value()) {
+            break;
+        }
+        codes.push_back(transaction->getCode());
+    }
+    return codes;
+}
 
 TEST(BinderRecordedTransaction, RoundTripEncoding) {
     android::String16 interfaceName("SampleInterface");
@@ -138,3 +162,110 @@ TEST(BinderRecordedTransaction, PayloadsExceedPageBoundaries) {
         EXPECT_EQ(retrievedTransaction->getReplyParcel().readInt32(), 99);
     }
 }
+
+TEST(BinderRecordedTransaction, SerializeDetailsMatchesDumpToFile) {
+    android::String16 interfaceName("SampleInterface");
+    Parcel d;
+    d.writeInt32(12);
+    d.writeInt64(2);
+    Parcel r;
+    r.writeInt32(99);
+    timespec ts = {1232456, 567890};
+
+    auto transaction = RecordedTransaction::fromDetails(interfaceName, 1, 42, ts, d, r, 0);
+    ASSERT_TRUE(transaction.has_value());
+
+    auto file = std::tmpfile();
+    auto fd = unique_fd(fcntl(fileno(file), F_DUPFD, 1));
+    ASSERT_EQ(android::NO_ERROR, transaction->dumpToFile(fd));
+
+    std::vector<uint8_t> buffer;
+    ASSERT_EQ(android::NO_ERROR,
+              RecordedTransaction::serializeDetails(interfaceName, 1, 42, ts, d, r, 0, &buffer));
+    // Serializing appends, so a second transaction follows the first.
+    ASSERT_EQ(android::NO_ERROR,
+              RecordedTransaction::serializeDetails(interfaceName, 1, 42, ts, d, r, 0, &buffer));
+
+    std::rewind(file);
+    std::string dumped;
+    ASSERT_TRUE(android::base::ReadFdToString(fd, &dumped));
+    ASSERT_EQ(dumped.size() * 2, buffer.size());
+    EXPECT_EQ(0, memcmp(dumped.data(), buffer.data(), dumped.size()));
+    EXPECT_EQ(0, memcmp(dumped.data(), buffer.data() + dumped.size(), dumped.size()));
+}
+
+TEST(BinderTransactionRecorder, KeepsTheOrderOfEachThread) {
+    constexpr uint32_t kThreads = 4;
+    constexpr uint32_t kTransactionsPerThread = 100;
+    android::String16 interfaceName("SampleInterface");
+    Parcel d;
+    d.writeInt32(12);
+    Parcel r;
+    timespec ts = {1232456, 567890};
+
+    auto file = std::tmpfile();
+    auto fd = unique_fd(fcntl(fileno(file), F_DUPFD, 1));
+    {
+        TransactionRecorder recorder(unique_fd(dup(fd.get())));
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreads; t++) {
+            threads.emplace_back([&, t] {
+                for (uint32_t i = 0; i < kTransactionsPerThread; i++) {
+                    recorder.record(interfaceName, t * kTransactionsPerThread + i, 0, ts, d, r, 0);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(0u, recorder.getDroppedCount());
+    }
+
+    std::vector<uint32_t> next(kThreads, 0);
+    for (uint32_t code : readCodes(fd)) {
+        const uint32_t thread = code / kTransactionsPerThread;
+        ASSERT_LT(thread, kThreads);
+        EXPECT_EQ(next[thread]++, code % kTransactionsPerThread);
+    }
+    for (uint32_t t = 0; t < kThreads; t++) {
+        EXPECT_EQ(kTransactionsPerThread, next[t]);
+    }
+}
+
+TEST(BinderTransactionRecorder, DropsTransactionsWhileTheWriterIsBehind) {
+    // With the writer stuck on a full pipe, the pending transactions and those it is writing add
+    // up to at most twice the pending limit of 16MiB, so some of these are dropped.
+    constexpr uint32_t kTransactions = 48;
+    android::String16 interfaceName("SampleInterface");
+    Parcel d;
+    d.writeByteVector(std::vector<uint8_t>(1024 * 1024, 0xaa));
+    Parcel r;
+    timespec ts = {1232456, 567890};
+
+    int pipeFds[2];
+    ASSERT_EQ(0, pipe(pipeFds));
+    unique_fd readEnd(pipeFds[0]);
+    std::string recorded;
+    std::thread reader;
+    size_t dropped;
+    {
+        TransactionRecorder recorder((unique_fd(pipeFds[1])));
+        for (uint32_t i = 0; i < kTransactions; i++) {
+            recorder.record(interfaceName, i, 0, ts, d, r, 0);
+        }
+        dropped = recorder.getDroppedCount();
+        EXPECT_GT(dropped, 0u);
+
+        // Let the writer catch up, so that the recorder can flush and stop.
+        reader = std::thread([&] { android::base::ReadFdToString(readEnd, &recorded); });
+    }
+    // The recorder closed the write end of the pipe.
+    reader.join();
+
+    auto file = std::tmpfile();
+    auto fd = unique_fd(fcntl(fileno(file), F_DUPFD, 1));
+    ASSERT_TRUE(android::base::WriteStringToFd(recorded, fd));
+    std::vector<uint32_t> codes = readCodes(fd);
+    EXPECT_EQ(kTransactions, codes.size() + dropped);
+    EXPECT_TRUE(std::is_sorted(codes.begin(), codes.end()));
+}
@@ -16,6 +16,7 @@
 
 #include <BnBinderRpcBenchmark.h>
 #include <android-base/logging.h>
+#include <android-base/unique_fd.h>
 #include <benchmark/benchmark.h>
 #include <binder/Binder.h>
 #include <binder/IPCThreadState.h>
@@ -33,6 +34,8 @@
 
 #include <thread>
 
+#include <fcntl.h>
+#include <linux/vm_sockets.h>
 #include <signal.h>
 #include <sys/prctl.h>
 #include <sys/types.h>
@@ -41,6 +44,7 @@
 using android::BBinder;
 using android::defaultServiceManager;
 using android::IBinder;
+using android::IInterface;
 using android::interface_cast;
 using android::IPCThreadState;
 using android::IServiceManager;
@@ -59,7 +63,9 @@ using android::sp;
 using android::status_t;
 using android::statusToString;
 using android::String16;
+using android::base::unique_fd;
 using android::binder::Status;
+using android::os::ParcelFileDescriptor;
 
 class MyBinderRpcBenchmark : public BnBinderRpcBenchmark {
     Status repeatString(const std::string& str, std::string* out) override {
@@ -74,12 +80,30 @@ class MyBinderRpcBenchmark : public BnBinderRpcBenchmark {
         *out = bytes;
         return Status::ok();
     }
+    Status repeatBinders(const std::vector<sp<IBinder>>& binders,
+                         std::vector<sp<IBinder>>* out) override {
+        *out = binders;
+        return Status::ok();
+    }
+    Status repeatFds(const std::vector<ParcelFileDescriptor>& fds,
+                     std::vector<ParcelFileDescriptor>* out) override {
+        out->clear();
+        out->reserve(fds.size());
+        for (const ParcelFileDescriptor& fd : fds) {
+            out->emplace_back(unique_fd(dup(fd.get())));
+        }
+        return Status::ok();
+    }
+    Status sendBytesOneway(const std::vector<uint8_t>& /*bytes*/) override {
+        return Status::ok();
+    }
 };
 
 enum Transport {
     KERNEL,
     RPC,
     RPC_TLS,
+    RPC_VSOCK,
 };
 
 static const std::initializer_list<int64_t> kTransportList = {
@@ -88,8 +112,37 @@ static const std::initializer_list<int64_t> kTransportList = {
 #endif
         Transport::RPC,
         Transport::RPC_TLS,
+        Transport::RPC_VSOCK,
 };
 
+// Transports which can carry file descriptors.
+static const std::initializer_list<int64_t> kFdTransportList = {
+#ifdef __BIONIC__
+        Transport::KERNEL,
+#endif
+        Transport::RPC,
+};
+
+// Threads in each server, and so the most client threads that can be in a call at once.
+constexpr size_t kServerThreads = 8;
+
+// Kernel binder transactions have to fit in the 1MB - 8KB buffer of the receiving process.
+constexpr int64_t kMaxKernelPayload = 512 * 1024;
+
+static const char* transportName(Transport transport) {
+    switch (transport) {
+        case KERNEL:
+            return "kernel";
+        case RPC:
+            return "rpc_unix";
+        case RPC_TLS:
+            return "rpc_tls";
+        case RPC_VSOCK:
+            return "rpc_vsock";
+    }
+    return "unknown";
+}
+
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
     auto pkey = android::makeKeyPairForSelfSignedCert();
     CHECK_NE(pkey.get(), nullptr);
@@ -107,30 +160,54 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+static sp<RpcSession> gSessionVsock = RpcSession::make();
+// Stays null if the kernel has no vsock loopback.
+static sp<IBinder> gRpcVsockBinder;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
 #endif
 
+// Labels the run with the transport, so that machine-readable output (--benchmark_format=json)
+// can be grouped without decoding the argument. Skips the run if the transport isn't available.
 static sp<IBinder> getBinderForOptions(benchmark::State& state) {
     Transport transport = static_cast<Transport>(state.range(0));
+    state.SetLabel(transportName(transport));
+    sp<IBinder> binder;
     switch (transport) {
 #ifdef __BIONIC__
         case KERNEL:
-            return gKernelBinder;
+            binder = gKernelBinder;
+            break;
 #endif
         case RPC:
-            return gRpcBinder;
+            binder = gRpcBinder;
+            break;
         case RPC_TLS:
-            return gRpcTlsBinder;
+            binder = gRpcTlsBinder;
+            break;
+        case RPC_VSOCK:
+            binder = gRpcVsockBinder;
+            break;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
             return nullptr;
     }
+    if (binder == nullptr) state.SkipWithError("transport not available");
+    return binder;
+}
+
+static sp<IBinderRpcBenchmark> getInterfaceForOptions(benchmark::State& state) {
+    sp<IBinder> binder = getBinderForOptions(state);
+    if (binder == nullptr) return nullptr;
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+    return iface;
 }
 
 void BM_pingTransaction(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
+    if (binder == nullptr) return;
 
     while (state.KeepRunning()) {
         CHECK_EQ(OK, binder->pingBinder());
@@ -139,10 +216,8 @@ void BM_pingTransaction(benchmark::State& state) {
 BENCHMARK(BM_pingTransaction)->ArgsProduct({kTransportList});
 
 void BM_repeatTwoPageString(benchmark::State& state) {
-    sp<IBinder> binder = getBinderForOptions(state);
-
-    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
-    CHECK(iface != nullptr);
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
 
     // Googlers might see go/another-look-at-aidl-hidl-perf
     //
@@ -168,9 +243,12 @@ void BM_repeatTwoPageString(benchmark::State& state) {
 BENCHMARK(BM_repeatTwoPageString)->ArgsProduct({kTransportList});
 
 void BM_throughputForTransportAndBytes(benchmark::State& state) {
-    sp<IBinder> binder = getBinderForOptions(state);
-    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
-    CHECK(iface != nullptr);
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
+    if (state.range(0) == Transport::KERNEL && state.range(1) > kMaxKernelPayload) {
+        state.SkipWithError("payload exceeds the kernel binder buffer");
+        return;
+    }
 
     std::vector<uint8_t> bytes = std::vector<uint8_t>(state.range(1));
     for (size_t i = 0; i < bytes.size(); i++) {
@@ -182,16 +260,35 @@ void BM_throughputForTransportAndBytes(benchmark::State& state) {
         Status ret = iface->repeatBytes(bytes, &out);
         CHECK(ret.isOk()) << ret;
     }
+    state.SetBytesProcessed(state.iterations() * bytes.size() * 2);
 }
 BENCHMARK(BM_throughputForTransportAndBytes)
         ->ArgsProduct({kTransportList,
-                       {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537}});
+                       {0, 64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537, 262144,
+                        1048576}});
+
+void BM_onewayThroughput(benchmark::State& state) {
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
+
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(state.range(1));
+    size_t sent = 0;
+    while (state.KeepRunning()) {
+        Status ret = iface->sendBytesOneway(bytes);
+        CHECK(ret.isOk()) << ret;
+        // Kernel binder fails oneway transactions once the server's async buffer is full, so
+        // stop every so often for a synchronous call, which the server has to get to first.
+        if (++sent % 32 == 0) {
+            CHECK_EQ(OK, IInterface::asBinder(iface)->pingBinder());
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_onewayThroughput)->ArgsProduct({kTransportList, {0, 1024, 4096}});
 
 void BM_repeatBinder(benchmark::State& state) {
-    sp<IBinder> binder = getBinderForOptions(state);
-    CHECK(binder != nullptr);
-    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
-    CHECK(iface != nullptr);
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
 
     while (state.KeepRunning()) {
         // force creation of a new address
@@ -204,16 +301,79 @@ void BM_repeatBinder(benchmark::State& state) {
 }
 BENCHMARK(BM_repeatBinder)->ArgsProduct({kTransportList});
 
+void BM_repeatBinders(benchmark::State& state) {
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
+
+    std::vector<sp<IBinder>> binders;
+    for (int64_t i = 0; i < state.range(1); i++) {
+        binders.push_back(sp<BBinder>::make());
+    }
+
+    while (state.KeepRunning()) {
+        std::vector<sp<IBinder>> out;
+        Status ret = iface->repeatBinders(binders, &out);
+        CHECK(ret.isOk()) << ret;
+    }
+    state.SetItemsProcessed(state.iterations() * binders.size());
+}
+BENCHMARK(BM_repeatBinders)->ArgsProduct({kTransportList, {1, 8, 64}});
+
+void BM_repeatFds(benchmark::State& state) {
+    sp<IBinderRpcBenchmark> iface = getInterfaceForOptions(state);
+    if (iface == nullptr) return;
+
+    std::vector<ParcelFileDescriptor> fds;
+    for (int64_t i = 0; i < state.range(1); i++) {
+        unique_fd fd(TEMP_FAILURE_RETRY(open("/dev/null", O_RDWR | O_CLOEXEC)));
+        CHECK(fd.ok());
+        fds.emplace_back(std::move(fd));
+    }
+
+    while (state.KeepRunning()) {
+        std::vector<ParcelFileDescriptor> out;
+        Status ret = iface->repeatFds(fds, &out);
+        CHECK(ret.isOk()) << ret;
+    }
+    state.SetItemsProcessed(state.iterations() * fds.size());
+}
+BENCHMARK(BM_repeatFds)->ArgsProduct({kFdTransportList, {1, 8, 64}});
+
+// Several client threads calling into the same server at once.
+void BM_contendedPing(benchmark::State& state) {
+    sp<IBinder> binder = getBinderForOptions(state);
+    if (binder == nullptr) return;
+
+    while (state.KeepRunning()) {
+        CHECK_EQ(OK, binder->pingBinder());
+    }
+}
+BENCHMARK(BM_contendedPing)->ArgsProduct({kTransportList})->ThreadRange(1, kServerThreads);
+
 void forkRpcServer(const char* addr, const sp<RpcServer>& server) {
     if (0 == fork()) {
         prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
         server->setRootObject(sp<MyBinderRpcBenchmark>::make());
+        server->setMaxThreads(kServerThreads);
         CHECK_EQ(OK, server->setupUnixDomainServer(addr));
         server->join();
         exit(1);
     }
 }
 
+void forkRpcVsockServer(unsigned int port) {
+    if (0 == fork()) {
+        prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
+        sp<RpcServer> server = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+        server->setRootObject(sp<MyBinderRpcBenchmark>::make());
+        server->setMaxThreads(kServerThreads);
+        // No vsock loopback: the client fails to connect and skips these benchmarks.
+        if (server->setupVsockServer(VMADDR_CID_LOCAL, port) != OK) exit(0);
+        server->join();
+        exit(1);
+    }
+}
+
 void setupClient(const sp<RpcSession>& session, const char* addr) {
     status_t status;
     for (size_t tries = 0; tries < 5; tries++) {
@@ -224,6 +384,15 @@ void setupClient(const sp<RpcSession>& session, const char* addr) {
     CHECK_EQ(status, OK) << "Could not connect: " << addr << ": " << statusToString(status).c_str();
 }
 
+bool setupVsockClient(const sp<RpcSession>& session, unsigned int port) {
+    for (size_t tries = 0; tries < 5; tries++) {
+        usleep(10000);
+        if (session->setupVsockClient(VMADDR_CID_LOCAL, port) == OK) return true;
+    }
+    std::cerr << "vsock loopback not available, skipping RPC_VSOCK" << std::endl;
+    return false;
+}
+
 int main(int argc, char** argv) {
     ::benchmark::Initialize(&argc, argv);
     if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
@@ -232,6 +401,10 @@ int main(int argc, char** argv) {
     std::cerr << "\t.../" << Transport::KERNEL << " is KERNEL" << std::endl;
     std::cerr << "\t.../" << Transport::RPC << " is RPC" << std::endl;
     std::cerr << "\t.../" << Transport::RPC_TLS << " is RPC with TLS" << std::endl;
+    std::cerr << "\t.../" << Transport::RPC_VSOCK << " is RPC over vsock" << std::endl;
+    std::cerr << "Use --benchmark_format=json or --benchmark_out=FILE for machine-readable "
+                 "results; each run is labeled with its transport."
+              << std::endl;
 
 #ifdef __BIONIC__
     if (0 == fork()) {
@@ -239,6 +412,8 @@ int main(int argc, char** argv) {
         CHECK_EQ(OK,
                  defaultServiceManager()->addService(kKernelBinderInstance,
                                                      sp<MyBinderRpcBenchmark>::make()));
+        ProcessState::self()->setThreadPoolMaxThreadCount(kServerThreads - 1);
+        ProcessState::self()->startThreadPool();
         IPCThreadState::self()->joinThreadPool();
         exit(1);
     }
@@ -254,7 +429,11 @@ int main(int argc, char** argv) {
 
     std::string addr = tmp + "/binderRpcBenchmark";
     (void)unlink(addr.c_str());
-    forkRpcServer(addr.c_str(), RpcServer::make(RpcTransportCtxFactoryRaw::make()));
+    sp<RpcServer> server = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+    server->setSupportedFileDescriptorTransportModes(
+            {RpcSession::FileDescriptorTransportMode::UNIX});
+    forkRpcServer(addr.c_str(), server);
+    gSession->setFileDescriptorTransportMode(RpcSession::FileDescriptorTransportMode::UNIX);
     setupClient(gSession, addr.c_str());
     gRpcBinder = gSession->getRootObject();
 
@@ -264,6 +443,12 @@ int main(int argc, char** argv) {
     setupClient(gSessionTls, tlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
 
+    unsigned int vsockPort = 5000 + getpid() % 10000;
+    forkRpcVsockServer(vsockPort);
+    if (setupVsockClient(gSessionVsock, vsockPort)) {
+        gRpcVsockBinder = gSessionVsock->getRootObject();
+    }
+
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
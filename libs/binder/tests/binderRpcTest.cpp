@@ -356,6 +356,7 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
         CHECK(session->setProtocolVersion(clientVersion));
         session->setMaxIncomingThreads(numIncoming);
         session->setMaxOutgoingConnections(options.numOutgoingConnections);
+        session->setOutgoingConnectionsOnDemand(options.outgoingConnectionsOnDemand);
         session->setFileDescriptorTransportMode(options.clientFileDescriptorTransportMode);
 
         switch (socketType) {
@@ -493,6 +494,20 @@ TEST_P(BinderRpc, ThreadPoolLimitOutgoing) {
     testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 500 /*ms*/);
 }
 
+TEST_P(BinderRpc, ThreadPoolOnDemandOutgoing) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumThreads = 10;
+    constexpr size_t kNumCalls = kNumThreads + 3;
+    auto proc = createRpcTestSocketServerProcess(
+            {.numThreads = kNumThreads, .outgoingConnectionsOnDemand = true});
+
+    // calls must still run in parallel once the extra connections are opened
+    testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 500 /*ms*/);
+}
+
 TEST_P(BinderRpc, ThreadingStressTest) {
     if (clientOrServerSingleThreaded()) {
         GTEST_SKIP() << "This test requires multiple threads";
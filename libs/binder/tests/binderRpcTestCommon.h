@@ -132,6 +132,7 @@ struct BinderRpcOptions {
     // options can all be specified per session
     std::vector<size_t> numIncomingConnectionsBySession = {};
     size_t numOutgoingConnections = SIZE_MAX;
+    bool outgoingConnectionsOnDemand = false;
     RpcSession::FileDescriptorTransportMode clientFileDescriptorTransportMode =
             RpcSession::FileDescriptorTransportMode::NONE;
     std::vector<RpcSession::FileDescriptorTransportMode>
@@ -14,13 +14,15 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
-#include <android-base/parseint.h>
 #include <android-base/strings.h>
 #include <binder/Binder.h>
 #include <sys/types.h>
-#include <fstream>
-#include <regex>
+
+#include <charconv>
+#include <functional>
+#include <string_view>
 
 #include <binderdebug/BinderDebug.h>
 
@@ -39,27 +41,82 @@ static std::string contextToString(BinderDebugContext context) {
     }
 }
 
-static status_t scanBinderContext(pid_t pid, const std::string& contextName,
-                                  std::function<void(const std::string&)> eachLine) {
-    std::ifstream ifs("/dev/binderfs/binder_logs/proc/" + std::to_string(pid));
-    if (!ifs.is_open()) {
-        ifs.open("/d/binder/proc/" + std::to_string(pid));
-        if (!ifs.is_open()) {
-            return -errno;
+// Splits a line into space-separated tokens, as views into the line.
+class Tokenizer {
+public:
+    explicit Tokenizer(std::string_view line) : mRemaining(line) {}
+
+    // Returns false once there are no tokens left.
+    bool next(std::string_view* token) {
+        const size_t start = mRemaining.find_first_not_of(' ');
+        if (start == std::string_view::npos) {
+            mRemaining = {};
+            return false;
+        }
+        mRemaining.remove_prefix(start);
+        const size_t end = std::min(mRemaining.find(' '), mRemaining.size());
+        *token = mRemaining.substr(0, end);
+        mRemaining.remove_prefix(end);
+        return true;
+    }
+
+    // Skips up to count tokens, and returns how many were skipped.
+    size_t skip(size_t count) {
+        std::string_view token;
+        size_t skipped = 0;
+        while (skipped < count && next(&token)) {
+            skipped++;
         }
+        return skipped;
+    }
+
+private:
+    std::string_view mRemaining;
+};
+
+template <typename T>
+static bool parseNumber(std::string_view token, T* out, int base = 10) {
+    const char* end = token.data() + token.size();
+    const auto [ptr, ec] = std::from_chars(token.data(), end, *out, base);
+    return ec == std::errc() && ptr == end;
+}
+
+// Reads a binder log in one go, and calls eachLine with the lines of the given context. Both the
+// per-process logs and the state log of all processes list the entries of a process under
+// "proc <pid>" and "context <name>" headers, and eachLine is given the pid of the entries. The
+// matching "context" header itself is passed on as well, so that callers see every process that
+// uses the context even if it has no entries.
+static status_t scanBinderContext(const std::string& logName, const std::string& contextName,
+                                  const std::function<void(pid_t, std::string_view)>& eachLine) {
+    std::string content;
+    if (!base::ReadFileToString("/dev/binderfs/binder_logs/" + logName, &content) &&
+        !base::ReadFileToString("/d/binder/" + logName, &content)) {
+        return -errno;
     }
 
+    pid_t pid = -1;
     bool isDesiredContext = false;
-    std::string line;
-    while (getline(ifs, line)) {
-        if (base::StartsWith(line, "context")) {
-            isDesiredContext = base::Split(line, " ").back() == contextName;
+    std::string_view remaining = content;
+    while (!remaining.empty()) {
+        const size_t end = std::min(remaining.find('\n'), remaining.size());
+        const std::string_view line = remaining.substr(0, end);
+        remaining.remove_prefix(std::min(end + 1, remaining.size()));
+
+        constexpr std::string_view kProcPrefix = "proc ";
+        if (base::StartsWith(line, kProcPrefix)) {
+            if (!parseNumber(line.substr(kProcPrefix.size()), &pid)) {
+                pid = -1;
+            }
+            isDesiredContext = false;
             continue;
         }
+        if (base::StartsWith(line, "context")) {
+            isDesiredContext = line.substr(line.rfind(' ') + 1) == contextName;
+        }
         if (!isDesiredContext) {
             continue;
         }
-        eachLine(line);
+        eachLine(pid, line);
     }
     return OK;
 }
@@ -67,64 +124,78 @@ static status_t scanBinderContext(pid_t pid, const std::string& contextName,
 // Examples of what we are looking at:
 // node 66730: u00007590061890e0 c0000759036130950 pri 0:120 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 2300 1790
 // thread 2999: l 00 need_return 1 tr 0
-status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
-    std::smatch match;
-    static const std::regex kReferencePrefix("^\\s*node \\d+:\\s+u([0-9a-f]+)\\s+c([0-9a-f]+)\\s+");
-    static const std::regex kThreadPrefix("^\\s*thread \\d+:\\s+l\\s+(\\d)(\\d)");
-    std::string contextStr = contextToString(context);
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (base::StartsWith(line, "  node")) {
-            std::vector<std::string> splitString = base::Tokenize(line, " ");
-            bool pids = false;
-            uint64_t ptr = 0;
-            for (const auto& token : splitString) {
-                if (base::StartsWith(token, "u")) {
-                    const std::string ptrString = "0x" + token.substr(1);
-                    if (!::android::base::ParseUint(ptrString.c_str(), &ptr)) {
-                        LOG(ERROR) << "Failed to parse pointer: " << ptrString;
+// pending transaction 1234: 0000000000000000 from 0:0 to 2300:0 code 1 flags 10 pri 0:120 r1
+static void parseBinderPidInfoLine(std::string_view line, BinderPidInfo* pidInfo) {
+    if (base::StartsWith(line, "  node")) {
+        Tokenizer tokenizer(line);
+        std::string_view token;
+        bool pids = false;
+        uint64_t ptr = 0;
+        while (tokenizer.next(&token)) {
+            if (base::StartsWith(token, "u")) {
+                if (!parseNumber(token.substr(1), &ptr, 16)) {
+                    LOG(ERROR) << "Failed to parse pointer: " << token;
+                    return;
+                }
+            } else {
+                // The last numbers in the line after "proc" are all client PIDs
+                if (token == "proc") {
+                    pids = true;
+                } else if (pids) {
+                    int32_t pid;
+                    if (!parseNumber(token, &pid)) {
+                        LOG(ERROR) << "Failed to parse pid int: " << token;
                         return;
                     }
-                } else {
-                    // The last numbers in the line after "proc" are all client PIDs
-                    if (token == "proc") {
-                        pids = true;
-                    } else if (pids) {
-                        int32_t pid;
-                        if (!::android::base::ParseInt(token, &pid)) {
-                            LOG(ERROR) << "Failed to parse pid int: " << token;
-                            return;
-                        }
-                        if (ptr == 0) {
-                            LOG(ERROR) << "We failed to parse the pointer, so we can't add the refPids";
-                            return;
-                        }
-                        pidInfo->refPids[ptr].push_back(pid);
+                    if (ptr == 0) {
+                        LOG(ERROR) << "We failed to parse the pointer, so we can't add the refPids";
+                        return;
                     }
+                    pidInfo->refPids[ptr].push_back(pid);
                 }
             }
-        } else if (base::StartsWith(line, "  thread")) {
-            auto pos = line.find("l ");
-            if (pos != std::string::npos) {
-                // "1" is waiting in binder driver
-                // "2" is poll. It's impossible to tell if these are in use.
-                //     and HIDL default code doesn't use it.
-                bool isInUse = line.at(pos + 2) != '1';
-                // "0" is a thread that has called into binder
-                // "1" is looper thread
-                // "2" is main looper thread
-                bool isBinderThread = line.at(pos + 3) != '0';
-                if (!isBinderThread) {
-                    return;
-                }
-                if (isInUse) {
-                    pidInfo->threadUsage++;
-                }
-
-                pidInfo->threadCount++;
+        }
+    } else if (base::StartsWith(line, "  thread")) {
+        auto pos = line.find("l ");
+        if (pos != std::string_view::npos && pos + 3 < line.size()) {
+            // "1" is waiting in binder driver
+            // "2" is poll. It's impossible to tell if these are in use.
+            //     and HIDL default code doesn't use it.
+            bool isInUse = line[pos + 2] != '1';
+            // "0" is a thread that has called into binder
+            // "1" is looper thread
+            // "2" is main looper thread
+            bool isBinderThread = line[pos + 3] != '0';
+            if (!isBinderThread) {
+                return;
+            }
+            if (isInUse) {
+                pidInfo->threadUsage++;
             }
+
+            pidInfo->threadCount++;
         }
-    });
-    return ret;
+    } else if (base::StartsWith(line, "  pending transaction")) {
+        // Work queued on the process rather than on one of its threads, which has to wait for a
+        // thread to become free. Transactions pending on a thread are indented further.
+        pidInfo->pendingTransactions++;
+    }
+}
+
+status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
+    return scanBinderContext("proc/" + std::to_string(pid), contextToString(context),
+                             [&](pid_t, std::string_view line) {
+                                 parseBinderPidInfoLine(line, pidInfo);
+                             });
+}
+
+status_t getAllBinderPidInfos(BinderDebugContext context,
+                              std::map<pid_t, BinderPidInfo>* pidInfos) {
+    return scanBinderContext("state", contextToString(context),
+                             [&](pid_t pid, std::string_view line) {
+                                 if (pid < 0) return;
+                                 parseBinderPidInfoLine(line, &(*pidInfos)[pid]);
+                             });
 }
 
 // Examples of what we are looking at:
@@ -132,28 +203,33 @@ status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo*
 // node 29413: u00007803fc982e80 c000078042c982210 pri 0:139 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 488 683
 status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servicePid,
                              int32_t handle, std::vector<pid_t>* pids) {
-    std::smatch match;
-    static const std::regex kNodeNumber("^\\s+ref \\d+:\\s+desc\\s+(\\d+)\\s+node\\s+(\\d+).*");
     std::string contextStr = contextToString(context);
-    int32_t node;
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
+    int32_t node = -1;
+    status_t ret = scanBinderContext("proc/" + std::to_string(pid), contextStr,
+                                     [&](pid_t, std::string_view line) {
         if (!base::StartsWith(line, "  ref")) return;
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
-        if (splitString.size() < 12) {
-            LOG(ERROR) << "Failed to parse binder_logs ref entry. Expecting size greater than 11, but got: " << splitString.size();
+        // Tokens 3 and 5 are the desc and node numbers, out of at least 12.
+        Tokenizer tokenizer(line);
+        std::string_view descString;
+        std::string_view nodeString;
+        const bool hasFields = tokenizer.skip(3) == 3 && tokenizer.next(&descString) &&
+                tokenizer.skip(1) == 1 && tokenizer.next(&nodeString);
+        const size_t tokenCount = hasFields ? 6 + tokenizer.skip(6) : 0;
+        if (tokenCount < 12) {
+            LOG(ERROR) << "Failed to parse binder_logs ref entry. Expecting size greater than 11, but got: " << tokenCount;
             return;
         }
         int32_t desc;
-        if (!::android::base::ParseInt(splitString[3].c_str(), &desc)) {
-            LOG(ERROR) << "Failed to parse desc int: " << splitString[3];
+        if (!parseNumber(descString, &desc)) {
+            LOG(ERROR) << "Failed to parse desc int: " << descString;
             return;
         }
         if (handle != desc) {
             return;
         }
-        if (!::android::base::ParseInt(splitString[5].c_str(), &node)) {
-            LOG(ERROR) << "Failed to parse node int: " << splitString[5];
+        if (!parseNumber(nodeString, &node)) {
+            LOG(ERROR) << "Failed to parse node int: " << nodeString;
             return;
         }
         LOG(INFO) << "Parsed the node: " << node;
@@ -162,19 +238,21 @@ status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servic
         return ret;
     }
 
-    ret = scanBinderContext(servicePid, contextStr, [&](const std::string& line) {
+    ret = scanBinderContext("proc/" + std::to_string(servicePid), contextStr,
+                            [&](pid_t, std::string_view line) {
         if (!base::StartsWith(line, "  node")) return;
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
-        if (splitString.size() < 21) {
-            LOG(ERROR) << "Failed to parse binder_logs node entry. Expecting size greater than 20, but got: " << splitString.size();
+        Tokenizer tokenizer(line);
+        std::string_view nodeToken;
+        if (tokenizer.skip(1) != 1 || !tokenizer.next(&nodeToken)) {
+            LOG(ERROR) << "Failed to parse binder_logs node entry: " << line;
             return;
         }
 
         // remove the colon
-        const std::string nodeString = splitString[1].substr(0, splitString[1].size() - 1);
+        const std::string_view nodeString = nodeToken.substr(0, nodeToken.size() - 1);
         int32_t matchedNode;
-        if (!::android::base::ParseInt(nodeString.c_str(), &matchedNode)) {
+        if (!parseNumber(nodeString, &matchedNode)) {
             LOG(ERROR) << "Failed to parse node int: " << nodeString;
             return;
         }
@@ -182,19 +260,29 @@ status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servic
         if (node != matchedNode) {
             return;
         }
+
+        // The node line has at least 21 tokens, the client PIDs being the ones after "proc".
+        std::string_view token;
+        size_t tokenCount = 2;
+        const size_t pidsStart = pids->size();
         bool pidsSection = false;
-        for (const auto& token : splitString) {
+        while (tokenizer.next(&token)) {
+            tokenCount++;
             if (token == "proc") {
                 pidsSection = true;
             } else if (pidsSection == true) {
                 int32_t pid;
-                if (!::android::base::ParseInt(token.c_str(), &pid)) {
+                if (!parseNumber(token, &pid)) {
                     LOG(ERROR) << "Failed to parse PID int: " << token;
                     return;
                 }
                 pids->push_back(pid);
             }
         }
+        if (tokenCount < 21) {
+            pids->resize(pidsStart);
+            LOG(ERROR) << "Failed to parse binder_logs node entry. Expecting size greater than 20, but got: " << tokenCount;
+        }
     });
     return ret;
 }
@@ -24,8 +24,14 @@ namespace android {
 
 struct BinderPidInfo {
     std::map<uint64_t, std::vector<pid_t>> refPids; // cookie -> processes which hold binder
-    uint32_t threadUsage;                           // number of threads in use
-    uint32_t threadCount;                           // number of threads total
+    uint32_t threadUsage = 0;                       // number of threads in use
+    uint32_t threadCount = 0;                       // number of threads total
+    uint32_t pendingTransactions = 0;               // transactions waiting for a free thread
+
+    // Whether every binder thread is busy while transactions are still waiting for one.
+    bool isThreadPoolSaturated() const {
+        return threadUsage >= threadCount && pendingTransactions > 0;
+    }
 };
 
 enum class BinderDebugContext {
@@ -38,6 +44,11 @@ enum class BinderDebugContext {
  * pid is the pid of the service
  */
 status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo);
+/**
+ * Fills pidInfos with the info of every process using the context, reading the binder state of all
+ * processes at once. This is much cheaper than calling getBinderPidInfo for each of them.
+ */
+status_t getAllBinderPidInfos(BinderDebugContext context, std::map<pid_t, BinderPidInfo>* pidInfos);
 /**
  * pid is typically the pid of this process that is making the query
  */
@@ -31,6 +31,12 @@ extern "C" int main() {
     // the name is coming from another process
     printf("name,binder_threads_in_use,binder_threads_started,client_count\n");
 
+    // Without a readable binder state, every process is read on its own below.
+    std::map<pid_t, BinderPidInfo> pidInfos;
+    if (getAllBinderPidInfos(BinderDebugContext::BINDER, &pidInfos) != OK) {
+        pidInfos.clear();
+    }
+
     for (const String16& name : defaultServiceManager()->listServices()) {
         sp<IBinder> binder = defaultServiceManager()->checkService(name);
         if (binder == nullptr) {
@@ -46,7 +52,12 @@ extern "C" int main() {
         CHECK_EQ(OK, binder->getDebugPid(&pid));
 
         BinderPidInfo info;
-        CHECK_EQ(OK, getBinderPidInfo(BinderDebugContext::BINDER, pid, &info));
+        if (const auto it = pidInfos.find(pid); it != pidInfos.end()) {
+            info = it->second;
+        } else {
+            // The state could not be read, or the service started after it was read.
+            CHECK_EQ(OK, getBinderPidInfo(BinderDebugContext::BINDER, pid, &info));
+        }
 
         std::vector<pid_t> clientPids;
         CHECK_EQ(OK,
@@ -60,6 +60,18 @@ TEST(BinderDebugTests, BinderThreads) {
     EXPECT_GE(pidInfo.threadCount, 1);
 }
 
+TEST(BinderDebugTests, AllBinderPidInfos) {
+    std::map<pid_t, BinderPidInfo> pidInfos;
+    const auto& status = getAllBinderPidInfos(BinderDebugContext::BINDER, &pidInfos);
+    ASSERT_EQ(status, OK);
+    const auto it = pidInfos.find(getpid());
+    ASSERT_NE(it, pidInfos.end());
+    const BinderPidInfo& pidInfo = it->second;
+    EXPECT_TRUE(!pidInfo.refPids.empty());
+    EXPECT_TRUE(pidInfo.threadUsage <= pidInfo.threadCount);
+    EXPECT_GE(pidInfo.threadCount, 1);
+}
+
 extern "C" {
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -22,7 +22,10 @@
 #include <dirent.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <linux/bpf.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
+#include <unistd.h>
 
 #include <mutex>
 #include <numeric>
@@ -337,18 +340,106 @@ std::optional<std::vector<std::vector<uint64_t>>> getUidCpuFreqTimes(uint32_t ui
     return out;
 }
 
-static std::optional<bool> uidUpdatedSince(uint32_t uid, uint64_t lastUpdate,
-                                           uint64_t *newLastUpdate) {
-    uint64_t uidLastUpdate;
-    if (findMapEntry(gUidLastUpdateMapFd, &uid, &uidLastUpdate)) return {};
-    // Updates that occurred during the previous read may have been missed. To mitigate
-    // this, don't ignore entries updated up to 1s before *lastUpdate
-    constexpr uint64_t NSEC_PER_SEC = 1000000000;
-    if (uidLastUpdate + NSEC_PER_SEC < lastUpdate) return false;
-    if (uidLastUpdate > *newLastUpdate) *newLastUpdate = uidLastUpdate;
-    return true;
+// Number of entries read per BPF_MAP_LOOKUP_BATCH syscall.
+constexpr uint32_t kMapBatchSize = 256;
+
+// Reads up to *count entries following the position held by the batch token, or from the start of
+// the map if token is null. On return, *count holds the number of entries read and nextToken the
+// position to resume from. Fails with ENOENT once the end of the map is reached, in which case the
+// entries read so far are still valid.
+template <typename Key>
+static int lookupMapBatch(const unique_fd &mapFd, const Key *token, Key *nextToken, Key *keys,
+                          void *values, uint32_t *count) {
+    // Hash maps use a 32-bit bucket index as the token, and other maps a key.
+    static_assert(sizeof(Key) >= sizeof(uint32_t));
+
+    union bpf_attr attr = {};
+    attr.batch.in_batch = reinterpret_cast<uint64_t>(token);
+    attr.batch.out_batch = reinterpret_cast<uint64_t>(nextToken);
+    attr.batch.keys = reinterpret_cast<uint64_t>(keys);
+    attr.batch.values = reinterpret_cast<uint64_t>(values);
+    attr.batch.count = *count;
+    attr.batch.map_fd = static_cast<uint32_t>(mapFd.get());
+
+    const int ret = syscall(__NR_bpf, BPF_MAP_LOOKUP_BATCH, &attr, sizeof(attr));
+    *count = attr.batch.count;
+    return ret;
 }
 
+// Invokes visitor(key, values) for each entry of a map whose value is an array of valuesPerKey
+// elements of type Value, e.g. one per CPU for per-CPU maps. Entries are read in batches, falling
+// back to a lookup per key on kernels without BPF_MAP_LOOKUP_BATCH. Returns false on error, or if
+// the visitor returns false, possibly after visiting some of the entries.
+template <typename Key, typename Value, typename Visitor>
+static bool forEachMapEntry(const unique_fd &mapFd, uint32_t valuesPerKey, Visitor &&visitor) {
+    std::vector<Key> keys(kMapBatchSize);
+    std::vector<Value> values(kMapBatchSize * valuesPerKey);
+    Key token, nextToken;
+    bool first = true;
+
+    for (;;) {
+        uint32_t count = kMapBatchSize;
+        const int ret = lookupMapBatch(mapFd, first ? nullptr : &token, &nextToken, keys.data(),
+                                       values.data(), &count);
+        if (ret && errno != ENOENT) {
+            // Kernels before 5.6 fail with EINVAL, and maps without batch support with the
+            // kernel-internal ENOTSUPP, which userspace headers do not define.
+            constexpr int ENOTSUPP = 524;
+            if (first && (errno == EINVAL || errno == ENOTSUPP || errno == EOPNOTSUPP)) break;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!visitor(keys[i], &values[i * valuesPerKey])) return false;
+        }
+        if (ret) return true;
+
+        token = nextToken;
+        first = false;
+    }
+
+    Key key, prevKey;
+    if (getFirstMapKey(mapFd, &key)) return errno == ENOENT;
+    do {
+        if (findMapEntry(mapFd, &key, values.data())) return false;
+        if (!visitor(key, values.data())) return false;
+    } while (prevKey = key, !getNextMapKey(mapFd, &prevKey, &key));
+    return errno == ENOENT;
+}
+
+// Snapshot of the time at which each UID last ran, to filter UIDs without a syscall per key.
+class UidLastUpdates {
+public:
+    bool read() {
+        return forEachMapEntry<uint32_t, uint64_t>(gUidLastUpdateMapFd, 1,
+                                                   [this](uint32_t uid, const uint64_t *time) {
+                                                       mTimes[uid] = *time;
+                                                       return true;
+                                                   });
+    }
+
+    // Returns whether the UID ran since lastUpdate, raising *newLastUpdate to the time it last ran.
+    // UIDs that first ran after the snapshot are looked up individually.
+    std::optional<bool> updatedSince(uint32_t uid, uint64_t lastUpdate,
+                                     uint64_t *newLastUpdate) const {
+        uint64_t uidLastUpdate;
+        if (const auto it = mTimes.find(uid); it != mTimes.end()) {
+            uidLastUpdate = it->second;
+        } else if (findMapEntry(gUidLastUpdateMapFd, &uid, &uidLastUpdate)) {
+            return {};
+        }
+        // Updates that occurred during the previous read may have been missed. To mitigate
+        // this, don't ignore entries updated up to 1s before *lastUpdate
+        constexpr uint64_t NSEC_PER_SEC = 1000000000;
+        if (uidLastUpdate + NSEC_PER_SEC < lastUpdate) return false;
+        if (uidLastUpdate > *newLastUpdate) *newLastUpdate = uidLastUpdate;
+        return true;
+    }
+
+private:
+    std::unordered_map<uint32_t, uint64_t> mTimes;
+};
+
 // Retrieve the times in ns that each uid spent running at each CPU freq.
 // Return contains no value on error, otherwise it contains a map from uids to vectors of vectors
 // using the format:
@@ -366,42 +457,38 @@ getUidsCpuFreqTimes() {
 std::optional<std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>>>
 getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate) {
     if (!gInitialized && !initGlobals()) return {};
-    time_key_t key, prevKey;
     std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>> map;
-    if (getFirstMapKey(gTisMapFd, &key)) {
-        if (errno == ENOENT) return map;
-        return std::nullopt;
-    }
+
+    UidLastUpdates uidLastUpdates;
+    if (lastUpdate && !uidLastUpdates.read()) return {};
 
     std::vector<std::vector<uint64_t>> mapFormat;
     for (const auto &freqList : gPolicyFreqs) mapFormat.emplace_back(freqList.size(), 0);
 
     uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
-    std::vector<tis_val_t> vals(gNCpus);
-    do {
+    const auto visitor = [&](const time_key_t &key, const tis_val_t *vals) {
         if (lastUpdate) {
-            auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
-            if (!uidUpdated.has_value()) return {};
-            if (!*uidUpdated) continue;
+            auto uidUpdated = uidLastUpdates.updatedSince(key.uid, *lastUpdate, &newLastUpdate);
+            if (!uidUpdated.has_value()) return false;
+            if (!*uidUpdated) return true;
         }
-        if (findMapEntry(gTisMapFd, &key, vals.data())) return {};
-        if (map.find(key.uid) == map.end()) map.emplace(key.uid, mapFormat);
+        auto &uidTimes = map.try_emplace(key.uid, mapFormat).first->second;
 
         auto offset = key.bucket * FREQS_PER_ENTRY;
         auto nextOffset = (key.bucket + 1) * FREQS_PER_ENTRY;
         for (uint32_t i = 0; i < gNPolicies; ++i) {
             if (offset >= gPolicyFreqs[i].size()) continue;
-            auto begin = map[key.uid][i].begin() + offset;
+            auto begin = uidTimes[i].begin() + offset;
             auto end = nextOffset < gPolicyFreqs[i].size() ? begin + FREQS_PER_ENTRY :
-                map[key.uid][i].end();
+                uidTimes[i].end();
             for (const auto &cpu : gPolicyCpus[i]) {
                 std::transform(begin, end, std::begin(vals[gCpuIndexMap[cpu]].ar), begin,
                                std::plus<uint64_t>());
             }
         }
-        prevKey = key;
-    } while (prevKey = key, !getNextMapKey(gTisMapFd, &prevKey, &key));
-    if (errno != ENOENT) return {};
+        return true;
+    };
+    if (!forEachMapEntry<time_key_t, tis_val_t>(gTisMapFd, gNCpus, visitor)) return {};
     if (lastUpdate && newLastUpdate > *lastUpdate) *lastUpdate = newLastUpdate;
     return map;
 }
@@ -478,35 +565,29 @@ std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsConcurrent
 std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsUpdatedConcurrentTimes(
         uint64_t *lastUpdate) {
     if (!gInitialized && !initGlobals()) return {};
-    time_key_t key, prevKey;
     std::unordered_map<uint32_t, concurrent_time_t> ret;
-    if (getFirstMapKey(gConcurrentMapFd, &key)) {
-        if (errno == ENOENT) return ret;
-        return {};
-    }
+
+    UidLastUpdates uidLastUpdates;
+    if (lastUpdate && !uidLastUpdates.read()) return {};
 
     concurrent_time_t retFormat = {.active = std::vector<uint64_t>(gNCpus, 0)};
     for (const auto &cpuList : gPolicyCpus) retFormat.policy.emplace_back(cpuList.size(), 0);
 
-    std::vector<concurrent_val_t> vals(gNCpus);
-    std::vector<uint64_t>::iterator activeBegin, activeEnd, policyBegin, policyEnd;
-
     uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
-    do {
-        if (key.bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return {};
+    const auto visitor = [&](const time_key_t &key, const concurrent_val_t *vals) {
+        if (key.bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return false;
         if (lastUpdate) {
-            auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
-            if (!uidUpdated.has_value()) return {};
-            if (!*uidUpdated) continue;
+            auto uidUpdated = uidLastUpdates.updatedSince(key.uid, *lastUpdate, &newLastUpdate);
+            if (!uidUpdated.has_value()) return false;
+            if (!*uidUpdated) return true;
         }
-        if (findMapEntry(gConcurrentMapFd, &key, vals.data())) return {};
-        if (ret.find(key.uid) == ret.end()) ret.emplace(key.uid, retFormat);
+        auto &uidTimes = ret.try_emplace(key.uid, retFormat).first->second;
 
         auto offset = key.bucket * CPUS_PER_ENTRY;
         auto nextOffset = (key.bucket + 1) * CPUS_PER_ENTRY;
 
-        activeBegin = ret[key.uid].active.begin();
-        activeEnd = nextOffset < gNCpus ? activeBegin + CPUS_PER_ENTRY : ret[key.uid].active.end();
+        auto activeBegin = uidTimes.active.begin();
+        auto activeEnd = nextOffset < gNCpus ? activeBegin + CPUS_PER_ENTRY : uidTimes.active.end();
 
         for (uint32_t cpu = 0; cpu < gNCpus; ++cpu) {
             std::transform(activeBegin, activeEnd, std::begin(vals[cpu].active), activeBegin,
@@ -515,17 +596,21 @@ std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsUpdatedCon
 
         for (uint32_t policy = 0; policy < gNPolicies; ++policy) {
             if (offset >= gPolicyCpus[policy].size()) continue;
-            policyBegin = ret[key.uid].policy[policy].begin() + offset;
-            policyEnd = nextOffset < gPolicyCpus[policy].size() ? policyBegin + CPUS_PER_ENTRY
-                                                                : ret[key.uid].policy[policy].end();
+            auto policyBegin = uidTimes.policy[policy].begin() + offset;
+            auto policyEnd = nextOffset < gPolicyCpus[policy].size()
+                    ? policyBegin + CPUS_PER_ENTRY
+                    : uidTimes.policy[policy].end();
 
             for (const auto &cpu : gPolicyCpus[policy]) {
                 std::transform(policyBegin, policyEnd, std::begin(vals[gCpuIndexMap[cpu]].policy),
                                policyBegin, std::plus<uint64_t>());
             }
         }
-    } while (prevKey = key, !getNextMapKey(gConcurrentMapFd, &prevKey, &key));
-    if (errno != ENOENT) return {};
+        return true;
+    };
+    if (!forEachMapEntry<time_key_t, concurrent_val_t>(gConcurrentMapFd, gNCpus, visitor)) {
+        return {};
+    }
     for (const auto &[key, value] : ret) {
         if (!verifyConcurrentTimes(value)) {
             auto val = getUidConcurrentTimes(key, false);
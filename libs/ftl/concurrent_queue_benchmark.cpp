@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+#include <ftl/concurrent_queue.h>
+#include <ftl/executor.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace android::test {
+namespace {
+
+constexpr std::size_t kCapacity = 1024;
+
+template <typename Queue>
+void push(Queue& queue, std::int64_t value) {
+  while (!queue.try_push(value)) std::this_thread::yield();
+}
+
+template <typename Queue>
+std::int64_t pop(Queue& queue) {
+  for (;;) {
+    if (const auto value = queue.try_pop()) return *value;
+    std::this_thread::yield();
+  }
+}
+
+// Pushes and pops on the same thread, which is the lower bound of the cost of a hand-off.
+template <typename Queue>
+void BM_ConcurrentQueue_uncontended(benchmark::State& state) {
+  Queue queue;
+  for (auto _ : state) {
+    push(queue, 0);
+    benchmark::DoNotOptimize(pop(queue));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Hands off values between the first thread and the others, which are the producers if
+// MultiProducer, or the consumers otherwise.
+template <typename Queue, bool MultiProducer>
+void BM_ConcurrentQueue_handOff(benchmark::State& state) {
+  static Queue* queue;
+
+  constexpr std::int64_t kBatchSize = 64;
+
+  if (state.thread_index() == 0) {
+    queue = new Queue;
+  }
+
+  const bool producer = MultiProducer ? state.thread_index() != 0 : state.thread_index() == 0;
+  const std::int64_t peer_count = state.threads() - 1;
+
+  for (auto _ : state) {
+    if (producer) {
+      const std::int64_t count = MultiProducer ? kBatchSize : kBatchSize * peer_count;
+      for (std::int64_t i = 0; i < count; ++i) push(*queue, i);
+    } else {
+      const std::int64_t count = MultiProducer ? kBatchSize * peer_count : kBatchSize;
+      for (std::int64_t i = 0; i < count; ++i) benchmark::DoNotOptimize(pop(*queue));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+
+  if (state.thread_index() == 0) {
+    delete queue;
+  }
+}
+
+using Spsc = ftl::SpscQueue<std::int64_t, kCapacity>;
+using Mpsc = ftl::MpscQueue<std::int64_t, kCapacity>;
+using Mpmc = ftl::MpmcQueue<std::int64_t, kCapacity>;
+
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_uncontended, Spsc);
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_uncontended, Mpsc);
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_uncontended, Mpmc);
+
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_handOff, Spsc, false)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_handOff, Mpsc, true)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_handOff, Mpmc, true)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentQueue_handOff, Mpmc, false)->ThreadRange(2, 8)->UseRealTime();
+
+// Round trip of a task through the executor, from posting to getting its result.
+void BM_Executor_async(benchmark::State& state) {
+  ftl::Executor executor(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(executor.async([] { return 0; }).get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Throughput of fanning out tasks, then waiting for all of them.
+void BM_Executor_fanOut(benchmark::State& state) {
+  constexpr int kTaskCount = 256;
+
+  ftl::Executor executor(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    std::atomic<int> count = 0;
+    for (int i = 0; i < kTaskCount; ++i) {
+      executor.post([&count] { count.fetch_add(1, std::memory_order_release); });
+    }
+    while (count.load(std::memory_order_acquire) < kTaskCount) std::this_thread::yield();
+  }
+  state.SetItemsProcessed(state.iterations() * kTaskCount);
+}
+
+BENCHMARK(BM_Executor_async)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_Executor_fanOut)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+}  // namespace
+}  // namespace android::test
+
+BENCHMARK_MAIN();
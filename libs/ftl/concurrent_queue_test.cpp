@@ -0,0 +1,193 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <ftl/concurrent_queue.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace android::test {
+
+// Keep in sync with example usage in header file.
+TEST(ConcurrentQueue, Example) {
+  {
+    ftl::SpscQueue<int, 4> queue;
+    while (!queue.try_push(42)) std::this_thread::yield();
+
+    const auto value = queue.try_pop();
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, 42);
+  }
+  {
+    ftl::MpmcQueue<std::string, 64> queue;
+    EXPECT_TRUE(queue.try_push("abc"));
+
+    auto value = queue.try_pop();
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, "abc"s);
+  }
+}
+
+template <typename Queue>
+class ConcurrentQueueTest : public testing::Test {};
+
+using Queues = testing::Types<ftl::SpscQueue<std::unique_ptr<int>, 4>,
+                              ftl::MpscQueue<std::unique_ptr<int>, 4>,
+                              ftl::MpmcQueue<std::unique_ptr<int>, 4>>;
+
+TYPED_TEST_SUITE(ConcurrentQueueTest, Queues);
+
+TYPED_TEST(ConcurrentQueueTest, Fifo) {
+  TypeParam queue;
+  static_assert(TypeParam::capacity() == 4);
+
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.try_pop());
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push(std::make_unique<int>(i)));
+  }
+
+  EXPECT_EQ(queue.size(), 4u);
+  EXPECT_FALSE(queue.try_push(std::make_unique<int>(4)));
+
+  // Wrap around.
+  for (int i = 0; i < 10; ++i) {
+    auto value = queue.try_pop();
+    ASSERT_TRUE(value);
+    EXPECT_EQ(**value, i);
+    EXPECT_TRUE(queue.try_push(std::make_unique<int>(i + 4)));
+  }
+
+  EXPECT_EQ(queue.size(), 4u);
+}
+
+TEST(ConcurrentQueue, Destroy) {
+  const auto counter = std::make_shared<int>(0);
+  {
+    ftl::SpscQueue<std::shared_ptr<int>, 8> spsc;
+    ftl::MpmcQueue<std::shared_ptr<int>, 8> mpmc;
+    EXPECT_TRUE(spsc.try_push(counter));
+    EXPECT_TRUE(mpmc.try_push(counter));
+    EXPECT_TRUE(mpmc.try_push(counter));
+    EXPECT_EQ(counter.use_count(), 4);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+namespace {
+
+constexpr int kProducerCount = 4;
+constexpr int kConsumerCount = 4;
+constexpr int kValueCount = 10'000;
+
+// Pushes kValueCount values from each producer, which encode the producer and the value index.
+template <typename Queue>
+void produce(Queue& queue, int producer) {
+  for (int i = 0; i < kValueCount; ++i) {
+    while (!queue.try_push(producer * kValueCount + i)) std::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+TEST(ConcurrentQueue, Spsc) {
+  ftl::SpscQueue<int, 64> queue;
+  std::thread producer([&queue] { produce(queue, 0); });
+
+  for (int i = 0; i < kValueCount;) {
+    if (const auto value = queue.try_pop()) {
+      ASSERT_EQ(*value, i++);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(ConcurrentQueue, Mpsc) {
+  ftl::MpscQueue<int, 64> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducerCount; ++p) {
+    producers.emplace_back([&queue, p] { produce(queue, p); });
+  }
+
+  // Values from each producer are popped in order.
+  std::vector<int> next(kProducerCount, 0);
+  for (int count = 0; count < kProducerCount * kValueCount;) {
+    if (const auto value = queue.try_pop()) {
+      const int producer = *value / kValueCount;
+      ASSERT_EQ(*value % kValueCount, next[producer]++);
+      ++count;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto& producer : producers) producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(ConcurrentQueue, Mpmc) {
+  ftl::MpmcQueue<int, 64> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducerCount; ++p) {
+    producers.emplace_back([&queue, p] { produce(queue, p); });
+  }
+
+  std::atomic<int> count = 0;
+  std::vector<std::vector<bool>> popped(kConsumerCount,
+                                        std::vector<bool>(kProducerCount * kValueCount));
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumerCount; ++c) {
+    consumers.emplace_back([&, c] {
+      while (count < kProducerCount * kValueCount) {
+        if (const auto value = queue.try_pop()) {
+          popped[c][*value] = true;
+          ++count;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto& producer : producers) producer.join();
+  for (auto& consumer : consumers) consumer.join();
+
+  // Every value is popped exactly once.
+  for (int value = 0; value < kProducerCount * kValueCount; ++value) {
+    int times = 0;
+    for (const auto& values : popped) times += values[value];
+    ASSERT_EQ(times, 1) << value;
+  }
+
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace android::test
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <ftl/executor.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace android::test {
+
+// Keep in sync with example usage in header file.
+TEST(Executor, Example) {
+  ftl::Executor executor(4);
+
+  std::promise<void> promise;
+  executor.post([&promise] { promise.set_value(); });
+  promise.get_future().wait();
+
+  ftl::Future<int> future = executor.async([] { return 6 * 7; });
+  EXPECT_EQ(future.get(), 42);
+}
+
+TEST(Executor, ThreadCount) {
+  EXPECT_EQ(ftl::Executor(3).thread_count(), 3u);
+  EXPECT_EQ(ftl::Executor(0).thread_count(), 1u);
+  EXPECT_GE(ftl::Executor().thread_count(), 1u);
+}
+
+TEST(Executor, IsWorker) {
+  ftl::Executor executor(2);
+  ftl::Executor other(1);
+
+  EXPECT_FALSE(executor.is_worker());
+  EXPECT_TRUE(executor.async([&] { return executor.is_worker(); }).get());
+  EXPECT_FALSE(executor.async([&] { return other.is_worker(); }).get());
+}
+
+TEST(Executor, Then) {
+  ftl::Executor executor(2);
+
+  const std::string result = executor.async([] { return 123; })
+                                 .then([](int x) { return std::to_string(x); })
+                                 .then([&executor](std::string str) {
+                                   return executor.async([str] { return str + "!"; });
+                                 })
+                                 .get();
+
+  EXPECT_EQ(result, "123!"s);
+}
+
+TEST(Executor, MoveOnly) {
+  ftl::Executor executor(1);
+
+  auto ptr = std::make_unique<char>('?');
+  auto future = executor.async([ptr = std::move(ptr)]() mutable { return std::move(ptr); });
+  EXPECT_EQ(*future.get(), '?');
+}
+
+// Tasks that post tasks keep workers busy, so the others need to steal them.
+TEST(Executor, Nested) {
+  constexpr int kBranchCount = 8;
+  constexpr int kDepth = 4;
+
+  std::atomic<int> count = 0;
+  std::function<void(int)> branch;
+  {
+    ftl::Executor executor(4);
+
+    branch = [&](int depth) {
+      ++count;
+      if (depth == kDepth) return;
+      for (int i = 0; i < kBranchCount; ++i) {
+        executor.post([&branch, depth] { branch(depth + 1); });
+      }
+    };
+
+    executor.post([&branch] { branch(0); });
+
+    // The destructor runs pending tasks, including nested ones.
+  }
+
+  int expected = 0;
+  for (int depth = 0, width = 1; depth <= kDepth; ++depth, width *= kBranchCount) {
+    expected += width;
+  }
+  EXPECT_EQ(count, expected);
+}
+
+TEST(Executor, ManyFutures) {
+  ftl::Executor executor(4);
+
+  std::vector<ftl::Future<int>> futures;
+  for (int i = 0; i < 1000; ++i) {
+    futures.push_back(executor.async([i] { return i * i; }));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(futures[i].get(), i * i);
+  }
+}
+
+}  // namespace android::test
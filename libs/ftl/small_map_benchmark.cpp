@@ -0,0 +1,99 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/small_map.h>
+
+#include <cstdint>
+#include <functional>
+
+namespace android::test {
+namespace {
+
+// A KeyEqual other than the default to keep the map searching linearly at any size.
+struct LinearKeyEqual : std::equal_to<std::uint64_t> {};
+
+using HashedMap = ftl::SmallMap<std::uint64_t, int, 4>;
+using LinearMap = ftl::SmallMap<std::uint64_t, int, 4, LinearKeyEqual>;
+
+// Spread out keys like the display IDs and binder addresses that SurfaceFlinger maps.
+std::uint64_t key(std::int64_t i) {
+  return static_cast<std::uint64_t>(i) * 0x100000001b3ull;
+}
+
+template <typename Map>
+Map makeMap(std::int64_t size) {
+  Map map;
+  for (std::int64_t i = 0; i < size; ++i) {
+    map.try_emplace(key(i), static_cast<int>(i));
+  }
+  return map;
+}
+
+// Looks up every key, and as many missing keys.
+template <typename Map>
+void BM_SmallMap_get(benchmark::State& state) {
+  const auto size = state.range(0);
+  const Map map = makeMap<Map>(size);
+  for (auto _ : state) {
+    for (std::int64_t i = 0; i < 2 * size; ++i) {
+      benchmark::DoNotOptimize(map.get(key(i)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * size);
+}
+
+template <typename Map>
+void BM_SmallMap_tryEmplace(benchmark::State& state) {
+  const auto size = state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(makeMap<Map>(size));
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Erases and reinserts every key.
+template <typename Map>
+void BM_SmallMap_erase(benchmark::State& state) {
+  const auto size = state.range(0);
+  Map map = makeMap<Map>(size);
+  for (auto _ : state) {
+    for (std::int64_t i = 0; i < size; ++i) {
+      map.erase(key(i));
+      map.try_emplace(key(i), static_cast<int>(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Sizes around HashedMap::kHashThreshold, where the hashed and linear maps part ways.
+void crossover(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t size : {4, 8, 12, 16, 17, 24, 32, 64, 256}) {
+    benchmark->Arg(size);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_SmallMap_get, HashedMap)->Apply(crossover);
+BENCHMARK_TEMPLATE(BM_SmallMap_get, LinearMap)->Apply(crossover);
+BENCHMARK_TEMPLATE(BM_SmallMap_tryEmplace, HashedMap)->Apply(crossover);
+BENCHMARK_TEMPLATE(BM_SmallMap_tryEmplace, LinearMap)->Apply(crossover);
+BENCHMARK_TEMPLATE(BM_SmallMap_erase, HashedMap)->Apply(crossover);
+BENCHMARK_TEMPLATE(BM_SmallMap_erase, LinearMap)->Apply(crossover);
+
+}  // namespace
+}  // namespace android::test
+
+BENCHMARK_MAIN();
@@ -19,8 +19,10 @@
 #include <gtest/gtest.h>
 
 #include <cctype>
+#include <random>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
 using namespace std::string_literals;
 using namespace std::string_view_literals;
@@ -376,6 +378,82 @@ TEST(SmallMap, Erase) {
   }
 }
 
+TEST(SmallMap, Hashed) {
+  using Map = SmallMap<int, std::string, 3>;
+  Map map;
+
+  // Keys with the same low bits must not collide.
+  constexpr auto kKey = [](Map::size_type i) { return static_cast<int>(i) << 16; };
+
+  for (Map::size_type i = 0; i < Map::kHashThreshold; ++i) {
+    EXPECT_TRUE(map.try_emplace(kKey(i), std::to_string(i)).second);
+  }
+
+  EXPECT_TRUE(map.dynamic());
+  EXPECT_FALSE(map.hashed());
+
+  const auto [it, ok] = map.try_emplace(kKey(Map::kHashThreshold), "last"s);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(it, std::prev(map.end()));
+  EXPECT_TRUE(map.hashed());
+
+  EXPECT_FALSE(map.try_emplace(kKey(0), "zero"s).second);
+  EXPECT_EQ(map.get(kKey(0))->get(), "0"s);
+  EXPECT_EQ(map.get(kKey(Map::kHashThreshold))->get(), "last"s);
+  EXPECT_FALSE(map.contains(1));
+
+  // Iteration order is unaffected.
+  Map::size_type i = 0;
+  for (const auto& [k, v] : map) {
+    EXPECT_EQ(k, kKey(i++));
+  }
+
+  EXPECT_EQ(map.try_replace(kKey(1), "one"s), map.begin() + 1);
+  EXPECT_EQ(map.get(kKey(1))->get(), "one"s);
+
+  // A converted map is hashed as well.
+  const SmallMap<int, std::string, 5> copy = map;
+  EXPECT_TRUE(copy.hashed());
+  EXPECT_EQ(copy, map);
+
+  map.clear();
+  EXPECT_FALSE(map.hashed());
+  EXPECT_FALSE(map.contains(kKey(0)));
+}
+
+TEST(SmallMap, HashedErase) {
+  SmallMap<int, int, 4> map;
+  std::unordered_map<int, int> reference;
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> keys(0, 255);
+
+  for (int i = 0; i < 10'000; ++i) {
+    const int key = keys(generator);
+    if (i % 3 == 0) {
+      EXPECT_EQ(map.erase(key), reference.erase(key) == 1);
+    } else {
+      EXPECT_EQ(map.try_emplace(key, i).second, reference.try_emplace(key, i).second);
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    if (map.size() > decltype(map)::kHashThreshold) {
+      EXPECT_TRUE(map.hashed());
+    }
+  }
+
+  EXPECT_TRUE(map.hashed());
+
+  for (int key = 0; key <= 255; ++key) {
+    const auto it = reference.find(key);
+    if (it == reference.end()) {
+      EXPECT_FALSE(map.contains(key));
+    } else {
+      EXPECT_EQ(map.get(key), it->second);
+    }
+  }
+}
+
 TEST(SmallMap, Clear) {
   SmallMap map = ftl::init::map(1, '1')(2, '2')(3, '3');
 
@@ -413,4 +491,39 @@ TEST(SmallMap, KeyEqual) {
   EXPECT_EQ(map, SmallMap(ftl::init::map<int, char, KeyEqual>(1, '1')(2, '2')));
 }
 
+TEST(SmallMap, KeyEqualNotHashed) {
+  struct KeyEqual {
+    bool operator()(int lhs, int rhs) const { return lhs == rhs; }
+  };
+
+  // Keys are never hashed, since std::hash may not be consistent with KeyEqual.
+  SmallMap<int, char, 1, KeyEqual> map;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(map.try_emplace(i, '?').second);
+  }
+
+  EXPECT_FALSE(map.hashed());
+  EXPECT_TRUE(map.contains(99));
+  EXPECT_TRUE(map.erase(0));
+  EXPECT_FALSE(map.contains(0));
+}
+
+// There is no std::hash specialization for this key.
+struct UnhashableKey {
+  int value;
+  bool operator==(const UnhashableKey& other) const { return value == other.value; }
+};
+
+TEST(SmallMap, ConvertUnhashable) {
+  SmallMap<UnhashableKey, char, 1> map;
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_TRUE(map.try_emplace(UnhashableKey{i}, '?').second);
+  }
+
+  const SmallMap<UnhashableKey, char, 2> copy = map;
+  EXPECT_FALSE(copy.hashed());
+  EXPECT_EQ(copy.size(), 20u);
+  EXPECT_TRUE(copy.contains(UnhashableKey{19}));
+}
+
 }  // namespace android::test
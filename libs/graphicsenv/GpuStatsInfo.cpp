@@ -96,6 +96,14 @@ status_t GpuStatsAppInfo::writeToParcel(Parcel* parcel) const {
     if ((status = parcel->writeUint64(vulkanDeviceFeaturesEnabled)) != OK) return status;
     if ((status = parcel->writeInt32Vector(vulkanInstanceExtensions)) != OK) return status;
     if ((status = parcel->writeInt32Vector(vulkanDeviceExtensions)) != OK) return status;
+    if ((status = parcel->writeUint64(glShaderCacheHits)) != OK) return status;
+    if ((status = parcel->writeUint64(glShaderCacheMisses)) != OK) return status;
+    if ((status = parcel->writeUint64(glShaderCacheLoadedBytes)) != OK) return status;
+    if ((status = parcel->writeUint64(glShaderCompileTimeNs)) != OK) return status;
+    if ((status = parcel->writeUint64(vkPipelineCacheHits)) != OK) return status;
+    if ((status = parcel->writeUint64(vkPipelineCacheMisses)) != OK) return status;
+    if ((status = parcel->writeUint64(vkPipelineCacheLoadedBytes)) != OK) return status;
+    if ((status = parcel->writeUint64(vkPipelineCompileTimeNs)) != OK) return status;
 
     return OK;
 }
@@ -118,6 +126,14 @@ status_t GpuStatsAppInfo::readFromParcel(const Parcel* parcel) {
     if ((status = parcel->readUint64(&vulkanDeviceFeaturesEnabled)) != OK) return status;
     if ((status = parcel->readInt32Vector(&vulkanInstanceExtensions)) != OK) return status;
     if ((status = parcel->readInt32Vector(&vulkanDeviceExtensions)) != OK) return status;
+    if ((status = parcel->readUint64(&glShaderCacheHits)) != OK) return status;
+    if ((status = parcel->readUint64(&glShaderCacheMisses)) != OK) return status;
+    if ((status = parcel->readUint64(&glShaderCacheLoadedBytes)) != OK) return status;
+    if ((status = parcel->readUint64(&glShaderCompileTimeNs)) != OK) return status;
+    if ((status = parcel->readUint64(&vkPipelineCacheHits)) != OK) return status;
+    if ((status = parcel->readUint64(&vkPipelineCacheMisses)) != OK) return status;
+    if ((status = parcel->readUint64(&vkPipelineCacheLoadedBytes)) != OK) return status;
+    if ((status = parcel->readUint64(&vkPipelineCompileTimeNs)) != OK) return status;
 
     return OK;
 }
@@ -136,6 +152,15 @@ std::string GpuStatsAppInfo::toString() const {
     StringAppendF(&result, "vulkanApiVersion = 0x%" PRIx32 "\n", vulkanApiVersion);
     StringAppendF(&result, "vulkanDeviceFeaturesEnabled = 0x%" PRIx64 "\n",
                   vulkanDeviceFeaturesEnabled);
+    StringAppendF(&result, "glShaderCacheHits = %" PRIu64 "\n", glShaderCacheHits);
+    StringAppendF(&result, "glShaderCacheMisses = %" PRIu64 "\n", glShaderCacheMisses);
+    StringAppendF(&result, "glShaderCacheLoadedBytes = %" PRIu64 "\n", glShaderCacheLoadedBytes);
+    StringAppendF(&result, "glShaderCompileTimeNs = %" PRIu64 "\n", glShaderCompileTimeNs);
+    StringAppendF(&result, "vkPipelineCacheHits = %" PRIu64 "\n", vkPipelineCacheHits);
+    StringAppendF(&result, "vkPipelineCacheMisses = %" PRIu64 "\n", vkPipelineCacheMisses);
+    StringAppendF(&result, "vkPipelineCacheLoadedBytes = %" PRIu64 "\n",
+                  vkPipelineCacheLoadedBytes);
+    StringAppendF(&result, "vkPipelineCompileTimeNs = %" PRIu64 "\n", vkPipelineCompileTimeNs);
     result.append("glDriverLoadingTime:");
     for (int32_t loadingTime : glDriverLoadingTime) {
         StringAppendF(&result, " %d", loadingTime);
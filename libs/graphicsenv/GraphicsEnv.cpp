@@ -28,6 +28,7 @@
 #include <android-base/properties.h>
 #include <android-base/strings.h>
 #include <android/dlext.h>
+#include <binder/Binder.h>
 #include <binder/IServiceManager.h>
 #include <graphicsenv/IGpuService.h>
 #include <log/log.h>
@@ -344,6 +345,38 @@ void GraphicsEnv::setTargetStatsArray(const GpuStatsInfo::Stats stats, const uin
     }
 }
 
+// The time in seconds to wait before sending newly added shader cache stats.
+static const unsigned int kDeferredShaderCacheStatsSendDelay = 5;
+
+void GraphicsEnv::addShaderCacheStats(const GpuStatsInfo::Stats stats, const uint64_t value) {
+    if (value == 0) return;
+
+    {
+        // Don't start a thread for stats that would be dropped anyway, e.g. in the zygote.
+        std::lock_guard<std::mutex> lock(mStatsLock);
+        if (!readyToSendGpuStatsLocked()) return;
+    }
+
+    std::lock_guard<std::mutex> lock(mShaderCacheStatsLock);
+    mPendingShaderCacheStats[stats] += value;
+    if (mShaderCacheStatsSendPending) return;
+
+    mShaderCacheStatsSendPending = true;
+    std::thread deferredSendThread([this]() {
+        sleep(kDeferredShaderCacheStatsSendDelay);
+        std::map<GpuStatsInfo::Stats, uint64_t> pendingStats;
+        {
+            std::lock_guard<std::mutex> lock(mShaderCacheStatsLock);
+            pendingStats.swap(mPendingShaderCacheStats);
+            mShaderCacheStatsSendPending = false;
+        }
+        for (const auto& [pendingStat, pendingValue] : pendingStats) {
+            setTargetStats(pendingStat, pendingValue);
+        }
+    });
+    deferredSendThread.detach();
+}
+
 void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
                                      int64_t driverLoadingTime) {
     ATRACE_CALL();
@@ -642,4 +675,24 @@ void GraphicsEnv::nativeToggleAngleAsSystemDriver(bool enabled) {
     gpuService->toggleAngleAsSystemDriver(enabled);
 }
 
+void GraphicsEnv::setShaderCacheSegment(const std::string& cacheId, int fd) {
+    const sp<IGpuService> gpuService = getGpuService();
+    if (!gpuService) {
+        ALOGE("No GPU service");
+        return;
+    }
+    // Lives as long as the process, so that gpuservice can tell when it's gone
+    static const sp<IBinder> token = sp<BBinder>::make();
+    gpuService->setShaderCacheSegment(cacheId, fd, token);
+}
+
+int GraphicsEnv::getShaderCacheSegment(const std::string& cacheId) {
+    const sp<IGpuService> gpuService = getGpuService();
+    if (!gpuService) {
+        ALOGE("No GPU service");
+        return -1;
+    }
+    return gpuService->getShaderCacheSegment(cacheId);
+}
+
 } // namespace android
@@ -20,6 +20,7 @@
 
 #include <binder/IResultReceiver.h>
 #include <binder/Parcel.h>
+#include <fcntl.h>
 
 namespace android {
 
@@ -98,6 +99,33 @@ public:
         }
         return driverPath;
     }
+
+    void setShaderCacheSegment(const std::string& cacheId, int fd,
+                               const sp<IBinder>& token) override {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGpuService::getInterfaceDescriptor());
+        data.writeUtf8AsUtf16(cacheId);
+        data.writeFileDescriptor(fd);
+        data.writeStrongBinder(token);
+
+        remote()->transact(BnGpuService::SET_SHADER_CACHE_SEGMENT, data, &reply,
+                           IBinder::FLAG_ONEWAY);
+    }
+
+    int getShaderCacheSegment(const std::string& cacheId) override {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGpuService::getInterfaceDescriptor());
+        data.writeUtf8AsUtf16(cacheId);
+
+        status_t error = remote()->transact(BnGpuService::GET_SHADER_CACHE_SEGMENT, data, &reply);
+        bool hasSegment = false;
+        if (error != OK || reply.readBool(&hasSegment) != OK || !hasSegment) {
+            return -1;
+        }
+        // The parcel owns the fd it read, so hand out a copy.
+        int fd = reply.readFileDescriptor();
+        return fd < 0 ? -1 : fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    }
 };
 
 IMPLEMENT_META_INTERFACE(GpuService, "android.graphicsenv.IGpuService");
@@ -207,6 +235,31 @@ status_t BnGpuService::onTransact(uint32_t code, const Parcel& data, Parcel* rep
             toggleAngleAsSystemDriver(enableAngleAsSystemDriver);
             return OK;
         }
+        case SET_SHADER_CACHE_SEGMENT: {
+            CHECK_INTERFACE(IGpuService, data, reply);
+
+            std::string cacheId;
+            if ((status = data.readUtf8FromUtf16(&cacheId)) != OK) return status;
+
+            int fd = data.readFileDescriptor();
+            if (fd < 0) return BAD_VALUE;
+
+            sp<IBinder> token;
+            if ((status = data.readStrongBinder(&token)) != OK) return status;
+
+            setShaderCacheSegment(cacheId, fd, token);
+            return OK;
+        }
+        case GET_SHADER_CACHE_SEGMENT: {
+            CHECK_INTERFACE(IGpuService, data, reply);
+
+            std::string cacheId;
+            if ((status = data.readUtf8FromUtf16(&cacheId)) != OK) return status;
+
+            int fd = getShaderCacheSegment(cacheId);
+            if ((status = reply->writeBool(fd >= 0)) != OK || fd < 0) return status;
+            return reply->writeFileDescriptor(fd, /* takeOwnership = */ true);
+        }
         default:
             return BBinder::onTransact(code, data, reply, flags);
     }
@@ -84,6 +84,14 @@ public:
     uint64_t vulkanDeviceFeaturesEnabled = 0;
     std::vector<int32_t> vulkanInstanceExtensions = {};
     std::vector<int32_t> vulkanDeviceExtensions = {};
+    uint64_t glShaderCacheHits = 0;
+    uint64_t glShaderCacheMisses = 0;
+    uint64_t glShaderCacheLoadedBytes = 0;
+    uint64_t glShaderCompileTimeNs = 0;
+    uint64_t vkPipelineCacheHits = 0;
+    uint64_t vkPipelineCacheMisses = 0;
+    uint64_t vkPipelineCacheLoadedBytes = 0;
+    uint64_t vkPipelineCompileTimeNs = 0;
 
     std::chrono::time_point<std::chrono::system_clock> lastAccessTime;
 };
@@ -118,6 +126,15 @@ public:
         VULKAN_DEVICE_FEATURES_ENABLED = 7,
         VULKAN_INSTANCE_EXTENSION = 8,
         VULKAN_DEVICE_EXTENSION = 9,
+        // The cache stats below are amounts added to the app's totals.
+        GL_SHADER_CACHE_HITS = 10,
+        GL_SHADER_CACHE_MISSES = 11,
+        GL_SHADER_CACHE_LOADED_BYTES = 12,
+        GL_SHADER_COMPILE_TIME = 13,
+        VULKAN_PIPELINE_CACHE_HITS = 14,
+        VULKAN_PIPELINE_CACHE_MISSES = 15,
+        VULKAN_PIPELINE_CACHE_LOADED_BYTES = 16,
+        VULKAN_PIPELINE_COMPILE_TIME = 17,
     };
 
     GpuStatsInfo() = default;
@@ -19,6 +19,7 @@
 
 #include <graphicsenv/GpuStatsInfo.h>
 
+#include <map>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -84,6 +85,9 @@ public:
     // Set which device extensions are enabled for the app.
     void setVulkanDeviceExtensions(uint32_t enabledExtensionCount,
                                    const char* const* ppEnabledExtensionNames);
+    // Add to a shader or pipeline cache stat, e.g. GL_SHADER_CACHE_HITS. Additions are summed up
+    // and sent a few seconds later, so that a cache lookup doesn't cost a binder call.
+    void addShaderCacheStats(const GpuStatsInfo::Stats stats, const uint64_t value);
 
     /*
      * Api for Vk/GL layer injection.  Presently, drivers enable certain
@@ -133,6 +137,10 @@ public:
     const std::string& getDebugLayersGLES();
     // Set the persist.graphics.egl system property value.
     void nativeToggleAngleAsSystemDriver(bool enabled);
+    // Share a sealed memfd of serialized shader blobs with other processes of this app.
+    void setShaderCacheSegment(const std::string& cacheId, int fd);
+    // Get a new fd of the shader blobs shared by this app for cacheId, or -1.
+    int getShaderCacheSegment(const std::string& cacheId);
 
 private:
     enum UseAngle { UNKNOWN, YES, NO };
@@ -159,6 +167,10 @@ private:
     bool mActivityLaunched = false;
     // Information bookkept for GpuStats.
     GpuStatsInfo mGpuStats;
+    // This mutex protects the shader cache stats which were not sent yet.
+    std::mutex mShaderCacheStatsLock;
+    bool mShaderCacheStatsSendPending = false;
+    std::map<GpuStatsInfo::Stats, uint64_t> mPendingShaderCacheStats;
     // Path to ANGLE libs.
     std::string mAnglePath;
     // This App's name.
@@ -53,6 +53,15 @@ public:
 
     // sets ANGLE as system GLES driver if enabled==true by setting persist.graphics.egl to true.
     virtual void toggleAngleAsSystemDriver(bool enabled) = 0;
+
+    // share a sealed memfd of serialized shader blobs with the other processes of the caller's
+    // uid which use the same cacheId. replaces the segment shared before. fd is not taken over.
+    // token identifies the calling process: the segments of a uid are dropped once the tokens of
+    // all its processes which shared one have died.
+    virtual void setShaderCacheSegment(const std::string& cacheId, int fd,
+                                       const sp<IBinder>& token) = 0;
+    // get a new fd of the segment shared by the caller's uid for cacheId, or -1 if there is none.
+    virtual int getShaderCacheSegment(const std::string& cacheId) = 0;
 };
 
 class BnGpuService : public BnInterface<IGpuService> {
@@ -63,6 +72,8 @@ public:
         SET_UPDATABLE_DRIVER_PATH,
         GET_UPDATABLE_DRIVER_PATH,
         TOGGLE_ANGLE_AS_SYSTEM_DRIVER,
+        SET_SHADER_CACHE_SEGMENT,
+        GET_SHADER_CACHE_SEGMENT,
         // Always append new enum to the end.
     };
 
@@ -393,13 +393,13 @@ void BLASTBufferQueue::transactionCallback(nsecs_t /*latchTime*/, const sp<Fence
                         staleReleases.push_back(key);
                     }
                 }
-                for (const auto& staleRelease : staleReleases) {
-                    releaseBufferCallbackLocked(staleRelease,
-                                                stat.previousReleaseFence
-                                                        ? stat.previousReleaseFence
-                                                        : Fence::NO_FENCE,
-                                                stat.currentMaxAcquiredBufferCount,
-                                                true /* fakeRelease */);
+                if (!staleReleases.empty()) {
+                    releaseBufferCallbacksLocked(staleReleases,
+                                                 stat.previousReleaseFence
+                                                         ? stat.previousReleaseFence
+                                                         : Fence::NO_FENCE,
+                                                 stat.currentMaxAcquiredBufferCount,
+                                                 true /* fakeRelease */);
                 }
             } else {
                 BQA_LOGE("Failed to find matching SurfaceControl in transactionCallback");
@@ -450,6 +450,26 @@ void BLASTBufferQueue::releaseBufferCallbackLocked(
         const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
         std::optional<uint32_t> currentMaxAcquiredBufferCount, bool fakeRelease) {
     ATRACE_CALL();
+    releasePendingBuffersLocked(
+            addPendingReleaseLocked(id, releaseFence, currentMaxAcquiredBufferCount, fakeRelease));
+}
+
+void BLASTBufferQueue::releaseBufferCallbacksLocked(
+        const std::vector<ReleaseCallbackId>& ids, const sp<Fence>& releaseFence,
+        std::optional<uint32_t> currentMaxAcquiredBufferCount, bool fakeRelease) {
+    ATRACE_CALL();
+    uint32_t numPendingBuffersToHold = 0;
+    for (const auto& id : ids) {
+        numPendingBuffersToHold = addPendingReleaseLocked(id, releaseFence,
+                                                          currentMaxAcquiredBufferCount,
+                                                          fakeRelease);
+    }
+    releasePendingBuffersLocked(numPendingBuffersToHold);
+}
+
+uint32_t BLASTBufferQueue::addPendingReleaseLocked(
+        const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
+        std::optional<uint32_t> currentMaxAcquiredBufferCount, bool fakeRelease) {
     BQA_LOGV("releaseBufferCallback %s", id.to_string().c_str());
 
     // Calculate how many buffers we need to hold before we release them back
@@ -475,7 +495,10 @@ void BLASTBufferQueue::releaseBufferCallbackLocked(
             BBQ_TRACE("FakeReleaseCallback");
         }
     }
+    return numPendingBuffersToHold;
+}
 
+void BLASTBufferQueue::releasePendingBuffersLocked(uint32_t numPendingBuffersToHold) {
     // Release all buffers that are beyond the ones that we need to hold
     while (mPendingRelease.size() > numPendingBuffersToHold) {
         const auto releasedBuffer = mPendingRelease.front();
@@ -696,13 +696,18 @@ status_t BufferQueueConsumer::setMaxAcquiredBufferCount(
             return BAD_VALUE;
         }
 
-        int delta = maxAcquiredBuffers - mCore->mMaxAcquiredBufferCount;
+        // Compare the resulting buffer counts rather than the acquired counts,
+        // since a slot added in adaptive buffer count mode may be clamped away.
+        const int oldMaxAcquiredBuffers = mCore->mMaxAcquiredBufferCount;
+        const int oldMaxBufferCount = mCore->getMaxBufferCountLocked();
+        mCore->mMaxAcquiredBufferCount = maxAcquiredBuffers;
+        int delta = mCore->getMaxBufferCountLocked() - oldMaxBufferCount;
         if (!mCore->adjustAvailableSlotsLocked(delta)) {
+            mCore->mMaxAcquiredBufferCount = oldMaxAcquiredBuffers;
             return BAD_VALUE;
         }
 
         BQ_LOGV("setMaxAcquiredBufferCount: %d", maxAcquiredBuffers);
-        mCore->mMaxAcquiredBufferCount = maxAcquiredBuffers;
         VALIDATE_CONSISTENCY();
         if (delta < 0 && mCore->mBufferReleasedCbEnabled) {
             listener = mCore->mConsumerListener;
@@ -836,4 +841,11 @@ void BufferQueueConsumer::setAllowExtraAcquire(bool allow) {
     mCore->mAllowExtraAcquire = allow;
 }
 
+void BufferQueueConsumer::setAdaptiveBufferCountEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    mCore->mAdaptiveBufferCountEnabled = enabled;
+    mCore->mAdaptiveBlockedDequeues = 0;
+    mCore->mAdaptiveFramesSinceBlocked = 0;
+}
+
 } // namespace android
@@ -159,6 +159,15 @@ void BufferQueueCore::dumpState(const String8& prefix, String8* outResult) const
                             mTransformHint, mFrameCounter);
     outResult->appendFormat("%s  mTransformHintInUse=%02x mAutoPrerotation=%d\n", prefix.string(),
                             mTransformHintInUse, mAutoPrerotation);
+    if (mAdaptiveBufferCountEnabled) {
+        outResult->appendFormat("%s  adaptive-buffer-count: extra=%d grow-after=%u/%u frames "
+                                "shrink-after=%u frames blocked=%u idle=%u grown=%u shrunk=%u\n",
+                                prefix.string(), mAdaptiveExtraBufferCount,
+                                kAdaptiveGrowAfterBlockedDequeues,
+                                kAdaptiveBlockedDequeueWindowFrames, kAdaptiveShrinkAfterFrames,
+                                mAdaptiveBlockedDequeues, mAdaptiveFramesSinceBlocked,
+                                mAdaptiveGrowCount, mAdaptiveShrinkCount);
+    }
 
     outResult->appendFormat("%sFIFO(%zu):\n", prefix.string(), mQueue.size());
 
@@ -238,14 +247,16 @@ int BufferQueueCore::getMinMaxBufferCountLocked() const {
 int BufferQueueCore::getMaxBufferCountLocked(bool asyncMode,
         bool dequeueBufferCannotBlock, int maxBufferCount) const {
     int maxCount = mMaxAcquiredBufferCount + mMaxDequeuedBufferCount +
-            ((asyncMode || dequeueBufferCannotBlock) ? 1 : 0);
+            ((asyncMode || dequeueBufferCannotBlock) ? 1 : 0) +
+            mAdaptiveExtraBufferCount;
     maxCount = std::min(maxBufferCount, maxCount);
     return maxCount;
 }
 
 int BufferQueueCore::getMaxBufferCountLocked() const {
     int maxBufferCount = mMaxAcquiredBufferCount + mMaxDequeuedBufferCount +
-            ((mAsyncMode || mDequeueBufferCannotBlock) ? 1 : 0);
+            ((mAsyncMode || mDequeueBufferCannotBlock) ? 1 : 0) +
+            mAdaptiveExtraBufferCount;
 
     // limit maxBufferCount by mMaxBufferCount always
     maxBufferCount = std::min(mMaxBufferCount, maxBufferCount);
@@ -364,6 +375,62 @@ bool BufferQueueCore::adjustAvailableSlotsLocked(int delta) {
     return true;
 }
 
+bool BufferQueueCore::onDequeueBlockedLocked() {
+    if (!mAdaptiveBufferCountEnabled || mSharedBufferMode || !mAllowAllocation) {
+        return false;
+    }
+    mAdaptiveFramesSinceBlocked = 0;
+    if (++mAdaptiveBlockedDequeues < kAdaptiveGrowAfterBlockedDequeues ||
+        mAdaptiveExtraBufferCount >= kAdaptiveMaxExtraBuffers) {
+        return false;
+    }
+    // Adding a slot would be clamped away by mMaxBufferCount.
+    if (getMaxBufferCountLocked() >= mMaxBufferCount) {
+        return false;
+    }
+    if (!setAdaptiveExtraBufferCountLocked(mAdaptiveExtraBufferCount + 1)) {
+        return false;
+    }
+    mAdaptiveBlockedDequeues = 0;
+    mAdaptiveGrowCount++;
+    BQ_LOGV("onDequeueBlockedLocked: growing to %d buffers", getMaxBufferCountLocked());
+    return true;
+}
+
+bool BufferQueueCore::onBufferQueuedLocked() {
+    if (!mAdaptiveBufferCountEnabled) {
+        // Give back a slot added before the mode was turned off once one is free.
+        return mAdaptiveExtraBufferCount > 0 && setAdaptiveExtraBufferCountLocked(0);
+    }
+    mAdaptiveFramesSinceBlocked++;
+    if (mAdaptiveFramesSinceBlocked > kAdaptiveBlockedDequeueWindowFrames) {
+        mAdaptiveBlockedDequeues = 0;
+    }
+    if (mAdaptiveExtraBufferCount == 0 ||
+        mAdaptiveFramesSinceBlocked < kAdaptiveShrinkAfterFrames) {
+        return false;
+    }
+    // Retry on the next queued buffer if every slot is still in use.
+    if (!setAdaptiveExtraBufferCountLocked(mAdaptiveExtraBufferCount - 1)) {
+        return false;
+    }
+    mAdaptiveFramesSinceBlocked = 0;
+    mAdaptiveShrinkCount++;
+    BQ_LOGV("onBufferQueuedLocked: shrinking to %d buffers", getMaxBufferCountLocked());
+    return true;
+}
+
+bool BufferQueueCore::setAdaptiveExtraBufferCountLocked(int extraBufferCount) {
+    const int oldExtraBufferCount = mAdaptiveExtraBufferCount;
+    const int oldMaxBufferCount = getMaxBufferCountLocked();
+    mAdaptiveExtraBufferCount = extraBufferCount;
+    if (!adjustAvailableSlotsLocked(getMaxBufferCountLocked() - oldMaxBufferCount)) {
+        mAdaptiveExtraBufferCount = oldExtraBufferCount;
+        return false;
+    }
+    return true;
+}
+
 void BufferQueueCore::waitWhileAllocatingLocked(std::unique_lock<std::mutex>& lock) const {
     ATRACE_CALL();
     while (mIsAllocating) {
@@ -112,7 +112,24 @@ status_t BufferQueueProducer::requestBuffer(int slot, sp<GraphicBuffer>* buf) {
     ATRACE_CALL();
     BQ_LOGV("requestBuffer: slot %d", slot);
     std::lock_guard<std::mutex> lock(mCore->mMutex);
+    return requestBufferLocked(slot, buf);
+}
+
+status_t BufferQueueProducer::requestBuffers(const std::vector<int32_t>& slots,
+                                             std::vector<RequestBufferOutput>* outputs) {
+    ATRACE_CALL();
+    outputs->clear();
+    outputs->reserve(slots.size());
 
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    for (int32_t slot : slots) {
+        RequestBufferOutput& output = outputs->emplace_back();
+        output.result = requestBufferLocked(static_cast<int>(slot), &output.buffer);
+    }
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::requestBufferLocked(int slot, sp<GraphicBuffer>* buf) {
     if (mCore->mIsAbandoned) {
         BQ_LOGE("requestBuffer: BufferQueue has been abandoned");
         return NO_INIT;
@@ -208,11 +225,16 @@ status_t BufferQueueProducer::setMaxDequeuedBufferCount(int maxDequeuedBuffers,
             return BAD_VALUE;
         }
 
-        int delta = maxDequeuedBuffers - mCore->mMaxDequeuedBufferCount;
+        // Compare the resulting buffer counts rather than the dequeued counts,
+        // since a slot added in adaptive buffer count mode may be clamped away.
+        const int oldMaxDequeuedBuffers = mCore->mMaxDequeuedBufferCount;
+        const int oldMaxBufferCount = mCore->getMaxBufferCountLocked();
+        mCore->mMaxDequeuedBufferCount = maxDequeuedBuffers;
+        int delta = mCore->getMaxBufferCountLocked() - oldMaxBufferCount;
         if (!mCore->adjustAvailableSlotsLocked(delta)) {
+            mCore->mMaxDequeuedBufferCount = oldMaxDequeuedBuffers;
             return BAD_VALUE;
         }
-        mCore->mMaxDequeuedBufferCount = maxDequeuedBuffers;
         *maxBufferCount = mCore->getMaxBufferCountLocked();
         VALIDATE_CONSISTENCY();
         if (delta < 0) {
@@ -392,6 +414,12 @@ status_t BufferQueueProducer::waitForFreeSlotThenRelock(FreeSlotCaller caller,
                     (acquiredCount <= mCore->mMaxAcquiredBufferCount)) {
                 return WOULD_BLOCK;
             }
+            // In adaptive buffer count mode a producer that keeps blocking
+            // here may be given another slot instead of waiting.
+            if (caller == FreeSlotCaller::Dequeue && !tooManyBuffers &&
+                    mCore->onDequeueBlockedLocked()) {
+                continue;
+            }
             if (mDequeueTimeout >= 0) {
                 std::cv_status result = mCore->mDequeueCondition.wait_for(lock,
                         std::chrono::nanoseconds(mDequeueTimeout));
@@ -898,6 +926,7 @@ status_t BufferQueueProducer::queueBuffer(int slot,
 
     sp<IConsumerListener> frameAvailableListener;
     sp<IConsumerListener> frameReplacedListener;
+    sp<IConsumerListener> buffersReleasedListener;
     int callbackTicket = 0;
     uint64_t currentFrameNumber = 0;
     BufferItem item;
@@ -1067,6 +1096,10 @@ status_t BufferQueueProducer::queueBuffer(int slot,
 #ifndef NO_BINDER
         mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
+        if (mCore->onBufferQueuedLocked()) {
+            buffersReleasedListener = mCore->mConsumerListener;
+        }
+
         // Take a ticket for the callback functions
         callbackTicket = mNextCallbackTicket++;
 
@@ -1120,6 +1153,10 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         mCallbackCondition.notify_all();
     }
 
+    if (buffersReleasedListener != nullptr) {
+        buffersReleasedListener->onBuffersReleased();
+    }
+
     // Wait without lock held
     if (connectedApi == NATIVE_WINDOW_API_EGL) {
         // Waiting here allows for two full buffers to be queued but not a
@@ -1136,6 +1173,38 @@ status_t BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
     BQ_LOGV("cancelBuffer: slot %d", slot);
     std::lock_guard<std::mutex> lock(mCore->mMutex);
 
+    status_t result = cancelBufferLocked(slot, fence);
+    if (result == NO_ERROR) {
+        mCore->mDequeueCondition.notify_all();
+        VALIDATE_CONSISTENCY();
+    }
+    return result;
+}
+
+status_t BufferQueueProducer::cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                                            std::vector<status_t>* results) {
+    ATRACE_CALL();
+    results->clear();
+    results->reserve(inputs.size());
+
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    bool anyCancelled = false;
+    for (const CancelBufferInput& input : inputs) {
+        BQ_LOGV("cancelBuffers: slot %d", input.slot);
+        status_t result = cancelBufferLocked(input.slot, input.fence);
+        anyCancelled |= result == NO_ERROR;
+        results->push_back(result);
+    }
+
+    // Wake up blocked dequeuers once for the whole batch.
+    if (anyCancelled) {
+        mCore->mDequeueCondition.notify_all();
+        VALIDATE_CONSISTENCY();
+    }
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::cancelBufferLocked(int slot, const sp<Fence>& fence) {
     if (mCore->mIsAbandoned) {
         BQ_LOGE("cancelBuffer: BufferQueue has been abandoned");
         return NO_INIT;
@@ -1183,8 +1252,6 @@ status_t BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
         mCore->mConsumerListener->onFrameCancelled(gb->getId());
     }
     mSlots[slot].mFence = fence;
-    mCore->mDequeueCondition.notify_all();
-    VALIDATE_CONSISTENCY();
 
     return NO_ERROR;
 }
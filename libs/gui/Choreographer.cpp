@@ -20,6 +20,13 @@
 #include <gui/Choreographer.h>
 #include <gui/TraceUtils.h>
 #include <jni.h>
+#include <utils/AndroidThreads.h>
+#include <utils/ThreadDefs.h>
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstdlib>
 
 #undef LOG_TAG
 #define LOG_TAG "AChoreographer"
@@ -71,6 +78,93 @@ Choreographer::Context Choreographer::gChoreographers;
 
 static thread_local Choreographer* gChoreographer;
 
+// Number of threads that have created a Choreographer through getForThread().
+static std::atomic<size_t> gThreadChoreographerCount = 0;
+
+// Owns the Choreographer of the thread if it uses the shared vsync source, since its looper does
+// not hold it through an fd callback. It goes away with the thread.
+static thread_local sp<Choreographer> gSharedVsyncChoreographer;
+
+// Connection to SurfaceFlinger shared by the per-thread Choreographers of the process, so that
+// threads waiting for the same vsync cost SurfaceFlinger one event rather than one per thread. It
+// runs on its own looper thread, and hands each vsync over to the loopers of the Choreographers
+// that requested it. It is only used once a second thread creates a Choreographer, so that the
+// common single-threaded case does not go through the extra thread.
+class Choreographer::SharedVsyncSource : public DisplayEventDispatcher {
+public:
+    // Returns the source of the process, or nullptr if it could not connect to SurfaceFlinger.
+    static SharedVsyncSource* getInstance() {
+        static SharedVsyncSource* const sInstance = [] {
+            const sp<Looper> looper = sp<Looper>::make(/*allowNonCallbacks=*/false);
+            const sp<SharedVsyncSource> source = sp<SharedVsyncSource>::make(looper);
+            // The looper holds the strong reference to the source through its fd callback.
+            if (source->initialize() != OK) {
+                ALOGW("Failed to initialize shared vsync source");
+                return static_cast<SharedVsyncSource*>(nullptr);
+            }
+            std::thread([looper] {
+                pthread_setname_np(pthread_self(), "AChoreographer");
+                androidSetThreadPriority(0, ANDROID_PRIORITY_DISPLAY);
+                for (;;) {
+                    looper->pollOnce(-1);
+                }
+            }).detach();
+            return source.get();
+        }();
+        return sInstance;
+    }
+
+    explicit SharedVsyncSource(const sp<Looper>& looper) : DisplayEventDispatcher(looper) {}
+
+    // May be called on any thread. Requests of several Choreographers for the same vsync are
+    // coalesced into one request to SurfaceFlinger.
+    void requestVsync(Choreographer* choreographer) {
+        std::scoped_lock _l(mLock);
+        if (std::none_of(mWaiters.begin(), mWaiters.end(),
+                         [choreographer](const wp<Choreographer>& waiter) {
+                             return waiter.unsafe_get() == choreographer;
+                         })) {
+            mWaiters.emplace_back(choreographer);
+        }
+        scheduleVsync();
+    }
+
+    int handleEvent(int receiveFd, int events, void* data) override {
+        std::scoped_lock _l(mLock);
+        return DisplayEventDispatcher::handleEvent(receiveFd, events, data);
+    }
+
+private:
+    // Called from handleEvent() with mLock held.
+    void dispatchVsync(nsecs_t timestamp, PhysicalDisplayId displayId, uint32_t count,
+                       VsyncEventData vsyncEventData) override REQUIRES(mLock) {
+        // Choreographers whose thread has exited since their request are skipped.
+        for (const wp<Choreographer>& waiter : mWaiters) {
+            if (const sp<Choreographer> choreographer = waiter.promote()) {
+                choreographer->postSharedVsync({timestamp, displayId, count, vsyncEventData});
+            }
+        }
+        mWaiters.clear();
+    }
+
+    void dispatchHotplug(nsecs_t, PhysicalDisplayId, bool) override {}
+
+    void dispatchModeChanged(nsecs_t, PhysicalDisplayId, int32_t, nsecs_t) override {
+        LOG_ALWAYS_FATAL("dispatchModeChanged was called but was never registered");
+    }
+
+    void dispatchNullEvent(nsecs_t, PhysicalDisplayId) override {}
+
+    void dispatchFrameRateOverrides(nsecs_t, PhysicalDisplayId,
+                                    std::vector<FrameRateOverride>) override {
+        LOG_ALWAYS_FATAL("dispatchFrameRateOverrides was called but was never registered");
+    }
+
+    // Serializes the dispatcher state between the source thread and the requesting threads.
+    std::mutex mLock;
+    std::vector<wp<Choreographer>> mWaiters GUARDED_BY(mLock);
+};
+
 void Choreographer::initJVM(JNIEnv* env) {
     env->GetJavaVM(&gJni.jvm);
     // Now we need to find the java classes.
@@ -93,6 +187,14 @@ Choreographer* Choreographer::getForThread() {
             ALOGW("No looper prepared for thread");
             return nullptr;
         }
+        // The first thread keeps a connection of its own.
+        SharedVsyncSource* source =
+                gThreadChoreographerCount++ > 0 ? SharedVsyncSource::getInstance() : nullptr;
+        if (source != nullptr) {
+            gSharedVsyncChoreographer = sp<Choreographer>(new Choreographer(looper, source));
+            gChoreographer = gSharedVsyncChoreographer.get();
+            return gChoreographer;
+        }
         gChoreographer = new Choreographer(looper);
         status_t result = gChoreographer->initialize();
         if (result != OK) {
@@ -112,6 +214,15 @@ Choreographer::Choreographer(const sp<Looper>& looper, const sp<IBinder>& layerH
     gChoreographers.ptrs.push_back(this);
 }
 
+Choreographer::Choreographer(const sp<Looper>& looper, SharedVsyncSource* sharedVsyncSource)
+      : DisplayEventDispatcher(looper, NoConnection{}),
+        mLooper(looper),
+        mThreadId(std::this_thread::get_id()),
+        mSharedVsyncSource(sharedVsyncSource) {
+    std::lock_guard<std::mutex> _l(gChoreographers.lock);
+    gChoreographers.ptrs.push_back(this);
+}
+
 Choreographer::~Choreographer() {
     std::lock_guard<std::mutex> _l(gChoreographers.lock);
     gChoreographers.ptrs.erase(std::remove_if(gChoreographers.ptrs.begin(),
@@ -151,7 +262,7 @@ void Choreographer::postFrameCallbackDelayed(AChoreographer_frameCallback cb,
         mFrameCallbacks.push(callback);
     }
     if (callback.dueTime <= now) {
-        if (std::this_thread::get_id() != mThreadId) {
+        if (std::this_thread::get_id() != mThreadId && mSharedVsyncSource == nullptr) {
             if (mLooper != nullptr) {
                 Message m{MSG_SCHEDULE_VSYNC};
                 mLooper->sendMessage(this, m);
@@ -159,7 +270,7 @@ void Choreographer::postFrameCallbackDelayed(AChoreographer_frameCallback cb,
                 scheduleVsync();
             }
         } else {
-            scheduleVsync();
+            requestVsync();
         }
     } else {
         if (mLooper != nullptr) {
@@ -258,11 +369,29 @@ void Choreographer::scheduleCallbacks() {
 
     if (dueTime <= now) {
         ALOGV("choreographer %p ~ scheduling vsync", this);
-        scheduleVsync();
+        requestVsync();
         return;
     }
 }
 
+void Choreographer::requestVsync() {
+    if (mSharedVsyncSource != nullptr) {
+        mSharedVsyncSource->requestVsync(this);
+    } else {
+        scheduleVsync();
+    }
+}
+
+void Choreographer::postSharedVsync(const SharedVsyncEvent& event) {
+    {
+        std::lock_guard<std::mutex> _l{mLock};
+        // Only the latest vsync matters if this thread has not caught up with the previous one.
+        mPendingSharedVsync = event;
+    }
+    Message m{MSG_DISPATCH_SHARED_VSYNC};
+    mLooper->sendMessage(this, m);
+}
+
 void Choreographer::handleRefreshRateUpdates() {
     std::vector<RefreshRateCallback> callbacks{};
     const nsecs_t pendingPeriod = gChoreographers.mLastKnownVsync.load();
@@ -295,6 +424,7 @@ void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t
             callbacks.push_back(mFrameCallbacks.top());
             mFrameCallbacks.pop();
         }
+        updatePredictionStatsLocked(vsyncEventData);
     }
     mLastVsyncEventData = vsyncEventData;
     for (const auto& cb : callbacks) {
@@ -317,6 +447,46 @@ void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t
             cb.callback(timestamp, cb.data);
         }
     }
+
+    if (!callbacks.empty()) {
+        const bool pastDeadline =
+                systemTime(SYSTEM_TIME_MONOTONIC) > vsyncEventData.preferredDeadlineTimestamp();
+        std::lock_guard<std::mutex> _l{mLock};
+        mFrameTimelineStats.framesDispatched++;
+        if (pastDeadline) {
+            mFrameTimelineStats.framesPastDeadline++;
+        }
+        // Counters, so that traces show when an app started missing the preferred timeline.
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT64("AChoreographer_framesPastDeadline",
+                         static_cast<int64_t>(mFrameTimelineStats.framesPastDeadline));
+            ATRACE_INT64("AChoreographer_maxPredictionDrift",
+                         mFrameTimelineStats.maxPredictionDrift);
+        }
+    }
+}
+
+void Choreographer::updatePredictionStatsLocked(const VsyncEventData& vsyncEventData) {
+    if (vsyncEventData.preferredFrameTimelineIndex >= vsyncEventData.frameTimelinesLength) {
+        return;
+    }
+    const auto& preferred =
+            vsyncEventData.frameTimelines[vsyncEventData.preferredFrameTimelineIndex];
+    // Timelines of consecutive vsync events overlap, so the previous event has usually already
+    // predicted a presentation time for the vsync the platform prefers now.
+    for (uint32_t i = 0; i < mLastVsyncEventData.frameTimelinesLength; i++) {
+        const auto& previous = mLastVsyncEventData.frameTimelines[i];
+        if (previous.vsyncId != preferred.vsyncId) {
+            continue;
+        }
+        const nsecs_t drift =
+                std::abs(preferred.expectedPresentationTime - previous.expectedPresentationTime);
+        mFrameTimelineStats.predictionsCompared++;
+        mFrameTimelineStats.totalPredictionDrift += drift;
+        mFrameTimelineStats.maxPredictionDrift =
+                std::max(mFrameTimelineStats.maxPredictionDrift, drift);
+        break;
+    }
 }
 
 void Choreographer::dispatchHotplug(nsecs_t, PhysicalDisplayId displayId, bool connected) {
@@ -344,11 +514,23 @@ void Choreographer::handleMessage(const Message& message) {
             scheduleCallbacks();
             break;
         case MSG_SCHEDULE_VSYNC:
-            scheduleVsync();
+            requestVsync();
             break;
         case MSG_HANDLE_REFRESH_RATE_UPDATES:
             handleRefreshRateUpdates();
             break;
+        case MSG_DISPATCH_SHARED_VSYNC: {
+            std::optional<SharedVsyncEvent> event;
+            {
+                std::lock_guard<std::mutex> _l{mLock};
+                event = std::exchange(mPendingSharedVsync, std::nullopt);
+            }
+            if (event) {
+                dispatchVsync(event->timestamp, event->displayId, event->count,
+                              event->vsyncEventData);
+            }
+            break;
+        }
     }
 }
 
@@ -360,6 +542,11 @@ bool Choreographer::inCallback() const {
     return mInCallback;
 }
 
+Choreographer::FrameTimelineStats Choreographer::getFrameTimelineStats() const {
+    std::lock_guard<std::mutex> _l{mLock};
+    return mFrameTimelineStats;
+}
+
 ChoreographerFrameCallbackDataImpl Choreographer::createFrameCallbackData(nsecs_t timestamp) const {
     return {.frameTimeNanos = timestamp,
             .vsyncEventData = mLastVsyncEventData,
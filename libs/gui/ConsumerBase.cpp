@@ -360,6 +360,7 @@ status_t ConsumerBase::discardFreeBuffers() {
             freeBufferLocked(i);
         }
     }
+    discardFreeBuffersLocked();
     return OK;
 }
 
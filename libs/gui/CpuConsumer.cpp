@@ -150,12 +150,37 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
 }
 
 status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
-    status_t err;
-
     if (!nativeBuffer) return BAD_VALUE;
 
     Mutex::Autolock _l(mMutex);
 
+    return lockNextBufferLocked(nativeBuffer);
+}
+
+status_t CpuConsumer::lockNextBuffers(LockedBuffer *nativeBuffers, size_t maxBuffers,
+        size_t *outCount) {
+    if (!nativeBuffers || maxBuffers == 0 || !outCount) return BAD_VALUE;
+
+    Mutex::Autolock _l(mMutex);
+
+    // The first attempt reports why nothing could be locked, if that is the case
+    size_t count = 0;
+    status_t err;
+    do {
+        err = lockNextBufferLocked(&nativeBuffers[count]);
+        if (err != OK) {
+            break;
+        }
+        count++;
+    } while (count < maxBuffers && mCurrentLockedBuffers < mMaxLockedBuffers);
+
+    *outCount = count;
+    return count > 0 ? OK : err;
+}
+
+status_t CpuConsumer::lockNextBufferLocked(LockedBuffer *nativeBuffer) {
+    status_t err;
+
     if (mCurrentLockedBuffers == mMaxLockedBuffers) {
         CC_LOGW("Max buffers have been locked (%zd), cannot lock anymore.",
                 mMaxLockedBuffers);
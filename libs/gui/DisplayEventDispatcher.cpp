@@ -40,22 +40,31 @@ DisplayEventDispatcher::DisplayEventDispatcher(const sp<Looper>& looper,
                                                EventRegistrationFlags eventRegistration,
                                                const sp<IBinder>& layerHandle)
       : mLooper(looper),
-        mReceiver(vsyncSource, eventRegistration, layerHandle),
+        mReceiver(std::in_place, vsyncSource, eventRegistration, layerHandle),
         mWaitingForVsync(false),
         mLastVsyncCount(0),
         mLastScheduleVsyncTime(0) {
     ALOGV("dispatcher %p ~ Initializing display event dispatcher.", this);
 }
 
+DisplayEventDispatcher::DisplayEventDispatcher(const sp<Looper>& looper, NoConnection)
+      : mLooper(looper), mWaitingForVsync(false), mLastVsyncCount(0), mLastScheduleVsyncTime(0) {
+    ALOGV("dispatcher %p ~ Initializing display event dispatcher without a connection.", this);
+}
+
 status_t DisplayEventDispatcher::initialize() {
-    status_t result = mReceiver.initCheck();
+    if (!mReceiver) {
+        return OK;
+    }
+
+    status_t result = mReceiver->initCheck();
     if (result) {
         ALOGW("Failed to initialize display event receiver, status=%d", result);
         return result;
     }
 
     if (mLooper != nullptr) {
-        int rc = mLooper->addFd(mReceiver.getFd(), 0, Looper::EVENT_INPUT, this, NULL);
+        int rc = mLooper->addFd(mReceiver->getFd(), 0, Looper::EVENT_INPUT, this, NULL);
         if (rc < 0) {
             return UNKNOWN_ERROR;
         }
@@ -67,12 +76,16 @@ status_t DisplayEventDispatcher::initialize() {
 void DisplayEventDispatcher::dispose() {
     ALOGV("dispatcher %p ~ Disposing display event dispatcher.", this);
 
-    if (!mReceiver.initCheck() && mLooper != nullptr) {
-        mLooper->removeFd(mReceiver.getFd());
+    if (mReceiver && !mReceiver->initCheck() && mLooper != nullptr) {
+        mLooper->removeFd(mReceiver->getFd());
     }
 }
 
 status_t DisplayEventDispatcher::scheduleVsync() {
+    if (!mReceiver) {
+        return INVALID_OPERATION;
+    }
+
     if (!mWaitingForVsync) {
         ALOGV("dispatcher %p ~ Scheduling vsync.", this);
 
@@ -86,7 +99,7 @@ status_t DisplayEventDispatcher::scheduleVsync() {
                   ns2ms(static_cast<nsecs_t>(vsyncTimestamp)));
         }
 
-        status_t status = mReceiver.requestNextVsync();
+        status_t status = mReceiver->requestNextVsync();
         if (status) {
             ALOGW("Failed to request next vsync, status=%d", status);
             return status;
@@ -99,11 +112,13 @@ status_t DisplayEventDispatcher::scheduleVsync() {
 }
 
 void DisplayEventDispatcher::injectEvent(const DisplayEventReceiver::Event& event) {
-    mReceiver.sendEvents(&event, 1);
+    if (mReceiver) {
+        mReceiver->sendEvents(&event, 1);
+    }
 }
 
 int DisplayEventDispatcher::getFd() const {
-    return mReceiver.getFd();
+    return mReceiver ? mReceiver->getFd() : NO_INIT;
 }
 
 int DisplayEventDispatcher::handleEvent(int, int events, void*) {
@@ -154,10 +169,14 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
                                                   PhysicalDisplayId* outDisplayId,
                                                   uint32_t* outCount,
                                                   VsyncEventData* outVsyncEventData) {
+    if (!mReceiver) {
+        return false;
+    }
+
     bool gotVsync = false;
     DisplayEventReceiver::Event buf[EVENT_BUFFER_SIZE];
     ssize_t n;
-    while ((n = mReceiver.getEvents(buf, EVENT_BUFFER_SIZE)) > 0) {
+    while ((n = mReceiver->getEvents(buf, EVENT_BUFFER_SIZE)) > 0) {
         ALOGV("dispatcher %p ~ Read %d events.", this, int(n));
         mFrameRateOverrides.reserve(n);
         for (ssize_t i = 0; i < n; i++) {
@@ -203,7 +222,7 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
 
 status_t DisplayEventDispatcher::getLatestVsyncEventData(
         ParcelableVsyncEventData* outVsyncEventData) const {
-    return mReceiver.getLatestVsyncEventData(outVsyncEventData);
+    return mReceiver ? mReceiver->getLatestVsyncEventData(outVsyncEventData) : NO_INIT;
 }
 
 } // namespace android
@@ -320,10 +320,8 @@ void ProducerFrameEventHistory::applyDelta(
 }
 
 void ProducerFrameEventHistory::updateSignalTimes() {
-    mAcquireTimeline.updateSignalTimes();
-    mGpuCompositionDoneTimeline.updateSignalTimes();
-    mPresentTimeline.updateSignalTimes();
-    mReleaseTimeline.updateSignalTimes();
+    FenceTimeline::updateSignalTimes({&mAcquireTimeline, &mGpuCompositionDoneTimeline,
+                                      &mPresentTimeline, &mReleaseTimeline});
 }
 
 void ProducerFrameEventHistory::applyFenceDelta(FenceTimeline* timeline,
@@ -329,12 +329,18 @@ status_t GLConsumer::acquireBufferLocked(BufferItem *item,
         return err;
     }
 
+    mEglImageCache.onBufferAcquired();
+
     // If item->mGraphicBuffer is not null, this buffer has not been acquired
     // before, so any prior EglImage created is using a stale buffer. This
     // replaces any old EglImage with a new one (using the new buffer).
     if (item->mGraphicBuffer != nullptr) {
         int slot = item->mSlot;
-        mEglSlots[slot].mEglImage = new EglImage(item->mGraphicBuffer);
+        mEglImageCache.add(mEglSlots[slot].mEglImage);
+        mEglSlots[slot].mEglImage = mEglImageCache.take(item->mGraphicBuffer);
+        if (mEglSlots[slot].mEglImage == nullptr) {
+            mEglSlots[slot].mEglImage = new EglImage(item->mGraphicBuffer);
+        }
     }
 
     return NO_ERROR;
@@ -907,6 +913,7 @@ void GLConsumer::freeBufferLocked(int slotIndex) {
     if (slotIndex == mCurrentTexture) {
         mCurrentTexture = BufferQueue::INVALID_BUFFER_SLOT;
     }
+    mEglImageCache.add(mEglSlots[slotIndex].mEglImage);
     mEglSlots[slotIndex].mEglImage.clear();
     ConsumerBase::freeBufferLocked(slotIndex);
 }
@@ -915,6 +922,16 @@ void GLConsumer::abandonLocked() {
     GLC_LOGV("abandonLocked");
     mCurrentTextureImage.clear();
     ConsumerBase::abandonLocked();
+
+    // ConsumerBase::abandonLocked frees all the slots, which caches their
+    // images, so this must come after it.
+    mEglImageCache.clear();
+}
+
+void GLConsumer::discardFreeBuffersLocked() {
+    // The application discards free buffers to save memory, so don't keep
+    // them alive in the cache either.
+    mEglImageCache.clear();
 }
 
 status_t GLConsumer::setConsumerUsageBits(uint64_t usage) {
@@ -929,6 +946,7 @@ void GLConsumer::dumpLocked(String8& result, const char* prefix) const
        prefix, mTexName, mCurrentTexture, prefix, mCurrentCrop.left,
        mCurrentCrop.top, mCurrentCrop.right, mCurrentCrop.bottom,
        mCurrentTransform);
+    mEglImageCache.dump(result, prefix);
 
     ConsumerBase::dumpLocked(result, prefix);
 }
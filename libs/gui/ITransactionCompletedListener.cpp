@@ -243,6 +243,32 @@ status_t TransactionStats::readFromParcel(const Parcel* input) {
     return input->readParcelableVector(&surfaceStats);
 }
 
+status_t ReleasedBufferStats::writeToParcel(Parcel* output) const {
+    SAFE_PARCEL(output->writeParcelable, callbackId);
+    if (releaseFence) {
+        SAFE_PARCEL(output->writeBool, true);
+        SAFE_PARCEL(output->write, *releaseFence);
+    } else {
+        SAFE_PARCEL(output->writeBool, false);
+    }
+    SAFE_PARCEL(output->writeUint32, currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
+status_t ReleasedBufferStats::readFromParcel(const Parcel* input) {
+    SAFE_PARCEL(input->readParcelable, &callbackId);
+    bool hasFence = false;
+    SAFE_PARCEL(input->readBool, &hasFence);
+    if (hasFence) {
+        releaseFence = sp<Fence>::make();
+        SAFE_PARCEL(input->read, *releaseFence);
+    } else {
+        releaseFence = Fence::NO_FENCE;
+    }
+    SAFE_PARCEL(input->readUint32, &currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
 status_t ListenerStats::writeToParcel(Parcel* output) const {
     status_t err = output->writeInt32(static_cast<int32_t>(transactionStats.size()));
     if (err != NO_ERROR) {
@@ -254,7 +280,7 @@ status_t ListenerStats::writeToParcel(Parcel* output) const {
             return err;
         }
     }
-    return NO_ERROR;
+    return output->writeParcelableVector(releasedBuffers);
 }
 
 status_t ListenerStats::readFromParcel(const Parcel* input) {
@@ -266,9 +292,9 @@ status_t ListenerStats::readFromParcel(const Parcel* input) {
         if (err != NO_ERROR) {
             return err;
         }
-        transactionStats.push_back(stats);
+        transactionStats.push_back(std::move(stats));
     }
-    return NO_ERROR;
+    return input->readParcelableVector(&releasedBuffers);
 }
 
 ListenerStats ListenerStats::createEmpty(
@@ -95,6 +95,9 @@ layer_state_t::layer_state_t()
     hdrMetadata.validTypes = 0;
 }
 
+// The largest fields are only meaningful when their what bit is set, since merge() and
+// SurfaceFlinger ignore them otherwise, so they are left out of the parcel entirely when
+// the bit is clear. read() leaves them at their defaults in that case.
 status_t layer_state_t::write(Parcel& output) const
 {
     SAFE_PARCEL(output.writeStrongBinder, surface);
@@ -114,7 +117,9 @@ status_t layer_state_t::write(Parcel& output) const
     SAFE_PARCEL(output.writeFloat, color.g);
     SAFE_PARCEL(output.writeFloat, color.b);
     SAFE_PARCEL(output.writeFloat, color.a);
-    SAFE_PARCEL(windowInfoHandle->writeToParcel, &output);
+    if (what & eInputInfoChanged) {
+        SAFE_PARCEL(windowInfoHandle->writeToParcel, &output);
+    }
     SAFE_PARCEL(output.write, transparentRegion);
     SAFE_PARCEL(output.writeUint32, bufferTransform);
     SAFE_PARCEL(output.writeBool, transformToDisplayInverse);
@@ -136,10 +141,14 @@ status_t layer_state_t::write(Parcel& output) const
         SAFE_PARCEL(output.writeBool, false);
     }
 
-    SAFE_PARCEL(output.write, colorTransform.asArray(), 16 * sizeof(float));
+    if (what & eColorTransformChanged) {
+        SAFE_PARCEL(output.write, colorTransform.asArray(), 16 * sizeof(float));
+    }
     SAFE_PARCEL(output.writeFloat, cornerRadius);
     SAFE_PARCEL(output.writeUint32, backgroundBlurRadius);
-    SAFE_PARCEL(output.writeParcelable, metadata);
+    if (what & eMetadataChanged) {
+        SAFE_PARCEL(output.writeParcelable, metadata);
+    }
     SAFE_PARCEL(output.writeFloat, bgColor.r);
     SAFE_PARCEL(output.writeFloat, bgColor.g);
     SAFE_PARCEL(output.writeFloat, bgColor.b);
@@ -162,8 +171,11 @@ status_t layer_state_t::write(Parcel& output) const
     SAFE_PARCEL(output.writeBool, autoRefresh);
     SAFE_PARCEL(output.writeBool, dimmingEnabled);
 
-    SAFE_PARCEL(output.writeUint32, blurRegions.size());
-    for (auto region : blurRegions) {
+    const auto numBlurRegions =
+            static_cast<uint32_t>((what & eBlurRegionsChanged) ? blurRegions.size() : 0);
+    SAFE_PARCEL(output.writeUint32, numBlurRegions);
+    for (uint32_t i = 0; i < numBlurRegions; i++) {
+        const auto& region = blurRegions[i];
         SAFE_PARCEL(output.writeUint32, region.blurRadius);
         SAFE_PARCEL(output.writeFloat, region.cornerRadiusTL);
         SAFE_PARCEL(output.writeFloat, region.cornerRadiusTR);
@@ -226,7 +238,9 @@ status_t layer_state_t::read(const Parcel& input)
     SAFE_PARCEL(input.readFloat, &tmpFloat);
     color.a = tmpFloat;
 
-    SAFE_PARCEL(windowInfoHandle->readFromParcel, &input);
+    if (what & eInputInfoChanged) {
+        SAFE_PARCEL(windowInfoHandle->readFromParcel, &input);
+    }
 
     SAFE_PARCEL(input.read, transparentRegion);
     SAFE_PARCEL(input.readUint32, &bufferTransform);
@@ -257,10 +271,14 @@ status_t layer_state_t::read(const Parcel& input)
         sidebandStream = NativeHandle::create(input.readNativeHandle(), true);
     }
 
-    SAFE_PARCEL(input.read, &colorTransform, 16 * sizeof(float));
+    if (what & eColorTransformChanged) {
+        SAFE_PARCEL(input.read, &colorTransform, 16 * sizeof(float));
+    }
     SAFE_PARCEL(input.readFloat, &cornerRadius);
     SAFE_PARCEL(input.readUint32, &backgroundBlurRadius);
-    SAFE_PARCEL(input.readParcelable, &metadata);
+    if (what & eMetadataChanged) {
+        SAFE_PARCEL(input.readParcelable, &metadata);
+    }
 
     SAFE_PARCEL(input.readFloat, &tmpFloat);
     bgColor.r = tmpFloat;
@@ -902,6 +920,12 @@ status_t CaptureArgs::writeToParcel(Parcel* output) const {
         SAFE_PARCEL(output->writeStrongBinder, excludeHandle);
     }
     SAFE_PARCEL(output->writeBool, hintForSeamlessTransition);
+    if (captureBuffer != nullptr) {
+        SAFE_PARCEL(output->writeBool, true);
+        SAFE_PARCEL(output->write, *captureBuffer);
+    } else {
+        SAFE_PARCEL(output->writeBool, false);
+    }
     return NO_ERROR;
 }
 
@@ -927,6 +951,12 @@ status_t CaptureArgs::readFromParcel(const Parcel* input) {
         excludeHandles.emplace(binder);
     }
     SAFE_PARCEL(input->readBool, &hintForSeamlessTransition);
+    bool hasCaptureBuffer;
+    SAFE_PARCEL(input->readBool, &hasCaptureBuffer);
+    if (hasCaptureBuffer) {
+        captureBuffer = new GraphicBuffer();
+        SAFE_PARCEL(input->read, *captureBuffer);
+    }
     return NO_ERROR;
 }
 
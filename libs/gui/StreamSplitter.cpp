@@ -58,13 +58,12 @@ status_t StreamSplitter::createSplitter(
 
 StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
       : mIsAbandoned(false), mMutex(), mReleaseCondition(),
-        mOutstandingBuffers(0), mInput(inputQueue), mOutputs(), mBuffers() {}
+        mInput(inputQueue), mOutputs(), mBuffers() {}
 
 StreamSplitter::~StreamSplitter() {
     mInput->consumerDisconnect();
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
-        (*output)->disconnect(NATIVE_WINDOW_API_CPU);
+    for (const Output& output : mOutputs) {
+        output.queue->disconnect(NATIVE_WINDOW_API_CPU);
     }
 
     if (mBuffers.size() > 0) {
@@ -73,7 +72,7 @@ StreamSplitter::~StreamSplitter() {
 }
 
 status_t StreamSplitter::addOutput(
-        const sp<IGraphicBufferProducer>& outputQueue) {
+        const sp<IGraphicBufferProducer>& outputQueue, OutputPolicy policy) {
     if (outputQueue == nullptr) {
         ALOGE("addOutput: outputQueue must not be NULL");
         return BAD_VALUE;
@@ -82,7 +81,7 @@ status_t StreamSplitter::addOutput(
     Mutex::Autolock lock(mMutex);
 
     IGraphicBufferProducer::QueueBufferOutput queueBufferOutput;
-    sp<OutputListener> listener(new OutputListener(this, outputQueue));
+    sp<OutputListener> listener(new OutputListener(this, mOutputs.size()));
     IInterface::asBinder(outputQueue)->linkToDeath(listener);
     status_t status = outputQueue->connect(listener, NATIVE_WINDOW_API_CPU,
             /* producerControlledByApp */ false, &queueBufferOutput);
@@ -91,7 +90,7 @@ status_t StreamSplitter::addOutput(
         return status;
     }
 
-    mOutputs.push_back(outputQueue);
+    mOutputs.push_back({outputQueue, policy, /* outstandingBuffers */ 0});
 
     return NO_ERROR;
 }
@@ -105,14 +104,15 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     ATRACE_CALL();
     Mutex::Autolock lock(mMutex);
 
-    // The current policy is that if any one consumer is consuming buffers too
-    // slowly, the splitter will stall the rest of the outputs by not acquiring
-    // any more buffers from the input. This will cause back pressure on the
-    // input queue, slowing down its producer.
+    // If a BLOCK output is consuming buffers too slowly, the splitter stalls
+    // the rest of the outputs by not acquiring any more buffers from the
+    // input. This will cause back pressure on the input queue, slowing down
+    // its producer. DROP outputs never stall the splitter, they skip the
+    // buffers that arrive while they are behind instead.
 
-    // If there are too many outstanding buffers, we block until a buffer is
-    // released back to the input in onBufferReleased
-    while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+    // If a BLOCK output has too many outstanding buffers, we block until it
+    // releases one in onBufferReleasedByOutput
+    while (isBlockedLocked()) {
         mReleaseCondition.wait(mMutex);
 
         // If the splitter is abandoned while we are waiting, the release
@@ -123,7 +123,6 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             return;
         }
     }
-    ++mOutstandingBuffers;
 
     // Acquire and detach the buffer from the input
     BufferItem bufferItem;
@@ -138,9 +137,10 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "detaching buffer from input failed (%d)", status);
 
-    // Initialize our reference count for this buffer
-    mBuffers.add(bufferItem.mGraphicBuffer->getId(),
-            new BufferTracker(bufferItem.mGraphicBuffer));
+    // Start tracking which outputs hold this buffer
+    sp<BufferTracker> tracker(
+            new BufferTracker(bufferItem.mGraphicBuffer, mOutputs.size()));
+    mBuffers.add(bufferItem.mGraphicBuffer->getId(), tracker);
 
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
@@ -149,17 +149,22 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             bufferItem.mTransform, bufferItem.mFence);
 
     // Attach and queue the buffer to each of the outputs
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
+    for (size_t index = 0; index < mOutputs.size(); ++index) {
+        Output& output = mOutputs[index];
+
+        if (output.policy == OutputPolicy::DROP &&
+                output.outstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+            ALOGV("dropped buffer %#" PRIx64 " for output %p",
+                    bufferItem.mGraphicBuffer->getId(), output.queue.get());
+            continue;
+        }
+
+        // If we discover that an output has been abandoned, note that, and
+        // move on to the next output without marking the buffer as held by it
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
+        status = output.queue->attachBuffer(&slot, bufferItem.mGraphicBuffer);
         if (status == NO_INIT) {
-            // If we just discovered that this output has been abandoned, note
-            // that, increment the release count so that we still release this
-            // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -167,33 +172,41 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
         }
 
         IGraphicBufferProducer::QueueBufferOutput queueOutput;
-        status = (*output)->queueBuffer(slot, queueInput, &queueOutput);
+        status = output.queue->queueBuffer(slot, queueInput, &queueOutput);
         if (status == NO_INIT) {
-            // If we just discovered that this output has been abandoned, note
-            // that, increment the release count so that we still release this
-            // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
                     "queueing buffer to output failed (%d)", status);
         }
 
+        tracker->setHeldByOutputLocked(index);
+        ++output.outstandingBuffers;
+
         ALOGV("queued buffer %#" PRIx64 " to output %p",
-                bufferItem.mGraphicBuffer->getId(), output->get());
+                bufferItem.mGraphicBuffer->getId(), output.queue.get());
+    }
+
+    // If every output dropped the buffer, return it to the input right away
+    if (!tracker->isHeldLocked()) {
+        if (mIsAbandoned) {
+            mBuffers.removeItem(bufferItem.mGraphicBuffer->getId());
+        } else {
+            releaseToInputLocked(tracker);
+        }
     }
 }
 
-void StreamSplitter::onBufferReleasedByOutput(
-        const sp<IGraphicBufferProducer>& from) {
+void StreamSplitter::onBufferReleasedByOutput(size_t outputIndex) {
     ATRACE_CALL();
     Mutex::Autolock lock(mMutex);
 
+    Output& output = mOutputs[outputIndex];
+
     sp<GraphicBuffer> buffer;
     sp<Fence> fence;
-    status_t status = from->detachNextBuffer(&buffer, &fence);
+    status_t status = output.queue->detachNextBuffer(&buffer, &fence);
     if (status == NO_INIT) {
         // If we just discovered that this output has been abandoned, note that,
         // but we can't do anything else, since buffer is invalid
@@ -205,19 +218,26 @@ void StreamSplitter::onBufferReleasedByOutput(
     }
 
     ALOGV("detached buffer %#" PRIx64 " from output %p",
-          buffer->getId(), from.get());
+          buffer->getId(), output.queue.get());
 
-    const sp<BufferTracker>& tracker = mBuffers.editValueFor(buffer->getId());
+    const sp<BufferTracker> tracker = mBuffers.valueFor(buffer->getId());
+    if (!tracker->releaseByOutputLocked(outputIndex)) {
+        ALOGE("output %p released buffer %#" PRIx64 " that it does not hold",
+                output.queue.get(), buffer->getId());
+        return;
+    }
+
+    // The output has room for another buffer, so let a waiting
+    // onFrameAvailable call proceed if this output was the one blocking it
+    --output.outstandingBuffers;
+    mReleaseCondition.signal();
 
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
     tracker->mergeFence(fence);
 
-    // Check to see if this is the last outstanding reference to this buffer
-    size_t releaseCount = tracker->incrementReleaseCountLocked();
-    ALOGV("buffer %#" PRIx64 " reference count %zu (of %zu)", buffer->getId(),
-            releaseCount, mOutputs.size());
-    if (releaseCount < mOutputs.size()) {
+    // Check to see if this was the last output holding the buffer
+    if (tracker->isHeldLocked()) {
         return;
     }
 
@@ -228,9 +248,15 @@ void StreamSplitter::onBufferReleasedByOutput(
         return;
     }
 
+    releaseToInputLocked(tracker);
+}
+
+void StreamSplitter::releaseToInputLocked(const sp<BufferTracker>& tracker) {
+    const uint64_t bufferId = tracker->getBuffer()->getId();
+
     // Attach and release the buffer back to the input
     int consumerSlot;
-    status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
+    status_t status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "attaching buffer to input failed (%d)", status);
 
@@ -239,15 +265,21 @@ void StreamSplitter::onBufferReleasedByOutput(
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "releasing buffer to input failed (%d)", status);
 
-    ALOGV("released buffer %#" PRIx64 " to input", buffer->getId());
+    ALOGV("released buffer %#" PRIx64 " to input", bufferId);
 
     // We no longer need to track the buffer once it has been returned to the
     // input
-    mBuffers.removeItem(buffer->getId());
+    mBuffers.removeItem(bufferId);
+}
 
-    // Notify any waiting onFrameAvailable calls
-    --mOutstandingBuffers;
-    mReleaseCondition.signal();
+bool StreamSplitter::isBlockedLocked() const {
+    for (const Output& output : mOutputs) {
+        if (output.policy == OutputPolicy::BLOCK &&
+                output.outstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void StreamSplitter::onAbandonedLocked() {
@@ -260,14 +292,13 @@ void StreamSplitter::onAbandonedLocked() {
 }
 
 StreamSplitter::OutputListener::OutputListener(
-        const sp<StreamSplitter>& splitter,
-        const sp<IGraphicBufferProducer>& output)
-      : mSplitter(splitter), mOutput(output) {}
+        const sp<StreamSplitter>& splitter, size_t outputIndex)
+      : mSplitter(splitter), mOutputIndex(outputIndex) {}
 
 StreamSplitter::OutputListener::~OutputListener() {}
 
 void StreamSplitter::OutputListener::onBufferReleased() {
-    mSplitter->onBufferReleasedByOutput(mOutput);
+    mSplitter->onBufferReleasedByOutput(mOutputIndex);
 }
 
 void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
@@ -275,8 +306,10 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
     mSplitter->onAbandonedLocked();
 }
 
-StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer,
+        size_t outputCount)
+      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE),
+        mHeldByOutput(outputCount, false), mHolderCount(0) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
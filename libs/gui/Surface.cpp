@@ -122,6 +122,7 @@ Surface::Surface(const sp<IGraphicBufferProducer>& bufferProducer, bool controll
     mConnectedToCpu = false;
     mProducerControlledByApp = controlledByApp;
     mSwapIntervalZero = false;
+    mAsyncMode = false;
     mMaxBufferCount = NUM_BUFFER_SLOTS;
     mSurfaceControlHandle = surfaceControlHandle;
 
@@ -136,6 +137,7 @@ Surface::~Surface() {
     if (mConnectedToCpu) {
         Surface::disconnect(NATIVE_WINDOW_API_CPU);
     }
+    stopDequeueAhead();
 }
 
 sp<ISurfaceComposer> Surface::composerService() const {
@@ -546,7 +548,9 @@ int Surface::setSwapInterval(int interval) {
     mSwapIntervalZero = (interval == 0);
 
     if (mSwapIntervalZero != wasSwapIntervalZero) {
-        mGraphicBufferProducer->setAsyncMode(mSwapIntervalZero);
+        if (mGraphicBufferProducer->setAsyncMode(mSwapIntervalZero) == NO_ERROR) {
+            mAsyncMode = mSwapIntervalZero;
+        }
     }
 
     return NO_ERROR;
@@ -594,11 +598,22 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     nsecs_t startTime = systemTime();
 
     FrameEventHistoryDelta frameTimestamps;
-    status_t result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width,
-                                                            dqInput.height, dqInput.format,
-                                                            dqInput.usage, &mBufferAge,
-                                                            dqInput.getTimestamps ?
-                                                                    &frameTimestamps : nullptr);
+    status_t result;
+    IGraphicBufferProducer::DequeueBufferOutput prefetched;
+    if (takePrefetchedBuffer(dqInput, &prefetched)) {
+        result = prefetched.result;
+        buf = prefetched.slot;
+        fence = std::move(prefetched.fence);
+        mBufferAge = prefetched.bufferAge;
+        if (prefetched.timestamps) {
+            frameTimestamps = std::move(*prefetched.timestamps);
+        }
+    } else {
+        result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width, dqInput.height,
+                                                       dqInput.format, dqInput.usage, &mBufferAge,
+                                                       dqInput.getTimestamps ? &frameTimestamps
+                                                                             : nullptr);
+    }
     mLastDequeueDuration = systemTime() - startTime;
 
     if (result < 0) {
@@ -1140,6 +1155,12 @@ int Surface::queueBuffer(android_native_buffer_t* buffer, int fenceFd) {
     }
 
     onBufferQueuedLocked(i, fence, output);
+
+    if (err == OK && !mSharedBufferMode) {
+        IGraphicBufferProducer::DequeueBufferInput dqInput;
+        getDequeueBufferInputLocked(&dqInput);
+        requestDequeueAhead(dqInput);
+    }
     return err;
 }
 
@@ -1229,8 +1250,13 @@ int Surface::query(int what, int* value) const {
                 }
                 break;
             case NATIVE_WINDOW_QUEUES_TO_WINDOW_COMPOSER: {
+                if (mQueuesToWindowComposer) {
+                    *value = *mQueuesToWindowComposer;
+                    return NO_ERROR;
+                }
                 status_t err = mGraphicBufferProducer->query(what, value);
                 if (err == NO_ERROR) {
+                    mQueuesToWindowComposer = *value;
                     return NO_ERROR;
                 }
                 sp<gui::ISurfaceComposer> surfaceComposer = composerServiceAIDL();
@@ -1239,6 +1265,12 @@ int Surface::query(int what, int* value) const {
                 }
                 // ISurfaceComposer no longer supports authenticateSurfaceTexture
                 *value = 0;
+                // BAD_VALUE means the producer does not know this query at all,
+                // which will not change; anything else (e.g. an abandoned
+                // queue) is worth asking again next time.
+                if (err == BAD_VALUE) {
+                    mQueuesToWindowComposer = 0;
+                }
                 return NO_ERROR;
             }
             case NATIVE_WINDOW_CONCRETE_TYPE:
@@ -1463,6 +1495,9 @@ int Surface::perform(int operation, va_list args)
     case NATIVE_WINDOW_SET_FRAME_TIMELINE_INFO:
         res = dispatchSetFrameTimelineInfo(args);
         break;
+    case NATIVE_WINDOW_SET_FRAME_STATE:
+        res = dispatchSetFrameState(args);
+        break;
     default:
         res = NAME_NOT_FOUND;
         break;
@@ -1820,6 +1855,14 @@ int Surface::dispatchSetFrameTimelineInfo(va_list args) {
     return setFrameTimelineInfo(frameNumber, ftlInfo);
 }
 
+int Surface::dispatchSetFrameState(va_list args) {
+    const auto* state = va_arg(args, const ANativeWindowFrameState*);
+    if (state == nullptr) {
+        return BAD_VALUE;
+    }
+    return setFrameState(*state);
+}
+
 bool Surface::transformToDisplayInverse() const {
     return (mTransform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) ==
             NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY;
@@ -1887,6 +1930,9 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
     mSharedBufferHasBeenQueued = false;
     freeAllBuffers();
     int err = mGraphicBufferProducer->disconnect(api, mode);
+    // Disconnecting unblocks a pending prefetch and returns its buffer to the queue, so the
+    // prefetched buffer can simply be dropped.
+    stopDequeueAhead();
     if (!err) {
         mReqFormat = 0;
         mReqWidth = 0;
@@ -1908,6 +1954,157 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
     return err;
 }
 
+void Surface::setDequeueAheadEnabled(bool enabled) {
+    if (!enabled) {
+        std::optional<PrefetchedBuffer> prefetched = stopDequeueAhead();
+        if (prefetched && prefetched->output.result >= 0) {
+            Mutex::Autolock lock(mMutex);
+            discardPrefetchedBufferLocked(prefetched->output);
+        }
+        return;
+    }
+
+    std::lock_guard lock(mDequeueAheadMutex);
+    if (mDequeueAheadEnabled) {
+        return;
+    }
+    mDequeueAheadEnabled = true;
+    mDequeueAheadThread = std::thread(&Surface::dequeueAheadThreadMain, this);
+}
+
+void Surface::dequeueAheadThreadMain() {
+    std::unique_lock lock(mDequeueAheadMutex);
+    while (true) {
+        mDequeueAheadCondition.wait(lock, [this] {
+            return mDequeueAheadRequested || !mDequeueAheadEnabled;
+        });
+        if (!mDequeueAheadEnabled) {
+            break;
+        }
+        mDequeueAheadRequested = false;
+        mDequeueAheadInFlight = true;
+        PrefetchedBuffer prefetched;
+        prefetched.input = mDequeueAheadInput;
+        lock.unlock();
+
+        ATRACE_NAME("dequeueAhead");
+        const auto& input = prefetched.input;
+        auto& output = prefetched.output;
+        output.result = mGraphicBufferProducer->dequeueBuffer(&output.slot, &output.fence,
+                                                              input.width, input.height,
+                                                              input.format, input.usage,
+                                                              &output.bufferAge,
+                                                              input.getTimestamps
+                                                                      ? &output.timestamps.emplace()
+                                                                      : nullptr);
+
+        lock.lock();
+        mDequeueAheadInFlight = false;
+        mPrefetchedBuffer = std::move(prefetched);
+        mDequeueAheadCondition.notify_all();
+    }
+}
+
+void Surface::requestDequeueAhead(const IGraphicBufferProducer::DequeueBufferInput& input) {
+    std::lock_guard lock(mDequeueAheadMutex);
+    if (!mDequeueAheadEnabled || mDequeueAheadRequested || mDequeueAheadInFlight ||
+        mPrefetchedBuffer) {
+        return;
+    }
+    mDequeueAheadInput = input;
+    mDequeueAheadRequested = true;
+    mDequeueAheadCondition.notify_all();
+}
+
+bool Surface::takePrefetchedBuffer(const IGraphicBufferProducer::DequeueBufferInput& input,
+                                   IGraphicBufferProducer::DequeueBufferOutput* output) {
+    std::optional<PrefetchedBuffer> prefetched;
+    {
+        std::unique_lock lock(mDequeueAheadMutex);
+        if (!mDequeueAheadEnabled) {
+            return false;
+        }
+        // A prefetch that is still running is the dequeue we would make now, so wait for it
+        // instead of racing it for a slot.
+        mDequeueAheadCondition.wait(lock, [this] {
+            return !mDequeueAheadRequested && !mDequeueAheadInFlight;
+        });
+        prefetched = std::move(mPrefetchedBuffer);
+        mPrefetchedBuffer.reset();
+    }
+
+    if (!prefetched || prefetched->output.result < 0) {
+        return false;
+    }
+
+    const auto& prefetchedInput = prefetched->input;
+    if (prefetchedInput.width == input.width && prefetchedInput.height == input.height &&
+        prefetchedInput.format == input.format && prefetchedInput.usage == input.usage &&
+        prefetchedInput.getTimestamps == input.getTimestamps) {
+        *output = std::move(prefetched->output);
+        return true;
+    }
+
+    ALOGV("takePrefetchedBuffer: dequeue input changed, cancelling slot %d",
+          prefetched->output.slot);
+    Mutex::Autolock lock(mMutex);
+    discardPrefetchedBufferLocked(prefetched->output);
+    return false;
+}
+
+std::optional<Surface::PrefetchedBuffer> Surface::stopDequeueAhead() {
+    bool inFlight;
+    {
+        std::lock_guard lock(mDequeueAheadMutex);
+        if (!mDequeueAheadEnabled) {
+            return std::nullopt;
+        }
+        mDequeueAheadEnabled = false;
+        mDequeueAheadRequested = false;
+        inFlight = mDequeueAheadInFlight;
+        mDequeueAheadCondition.notify_all();
+    }
+
+    // A prefetch may be blocked waiting for a free slot, which might never come once nobody
+    // queues buffers anymore. Switching the producer to async mode wakes it up, and makes it
+    // return WOULD_BLOCK rather than wait again.
+    if (inFlight) {
+        status_t err = mGraphicBufferProducer->setAsyncMode(true);
+        ALOGE_IF(err, "stopDequeueAhead: setAsyncMode(true) returned %s, waiting for the prefetch",
+                 strerror(-err));
+        mDequeueAheadThread.join();
+        if (err == NO_ERROR && !mAsyncMode) {
+            mGraphicBufferProducer->setAsyncMode(false);
+        }
+    } else {
+        mDequeueAheadThread.join();
+    }
+
+    std::lock_guard lock(mDequeueAheadMutex);
+    std::optional<PrefetchedBuffer> prefetched = std::move(mPrefetchedBuffer);
+    mPrefetchedBuffer.reset();
+    return prefetched;
+}
+
+void Surface::discardPrefetchedBufferLocked(IGraphicBufferProducer::DequeueBufferOutput& output) {
+    if (output.result & IGraphicBufferProducer::RELEASE_ALL_BUFFERS) {
+        freeAllBuffers();
+    }
+    if (output.slot >= 0 && output.slot < NUM_BUFFER_SLOTS &&
+        (output.result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION)) {
+        // The slot now holds a buffer we never requested; forget the stale one so the next
+        // dequeue of this slot calls requestBuffer.
+        if (mReportRemovedBuffers && mSlots[output.slot].buffer != nullptr) {
+            mRemovedBuffers.push_back(mSlots[output.slot].buffer);
+        }
+        mSlots[output.slot].buffer = nullptr;
+    }
+    if (output.timestamps) {
+        mFrameEventHistory->applyDelta(*output.timestamps);
+    }
+    mGraphicBufferProducer->cancelBuffer(output.slot, output.fence);
+}
+
 int Surface::detachNextBuffer(sp<GraphicBuffer>* outBuffer,
         sp<Fence>* outFence) {
     ATRACE_CALL();
@@ -2055,6 +2252,9 @@ int Surface::setAsyncMode(bool async) {
     status_t err = mGraphicBufferProducer->setAsyncMode(async);
     ALOGE_IF(err, "IGraphicBufferProducer::setAsyncMode(%d) returned %s",
             async, strerror(-err));
+    if (err == NO_ERROR) {
+        mAsyncMode = async;
+    }
 
     return err;
 }
@@ -2197,6 +2397,47 @@ int Surface::setBuffersDataSpace(Dataspace dataSpace)
     return NO_ERROR;
 }
 
+int Surface::setFrameState(const ANativeWindowFrameState& state) {
+    ATRACE_CALL();
+    ALOGV("Surface::setFrameState fields=%#x", state.fields);
+
+    // Go through the virtual setters, so that subclasses see the same calls as when each field
+    // is set on its own.
+    if (state.fields & ANATIVEWINDOW_FRAME_STATE_DATASPACE) {
+        int err = setBuffersDataSpace(static_cast<Dataspace>(state.dataSpace));
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
+    if (state.fields & ANATIVEWINDOW_FRAME_STATE_CROP) {
+        int err = setCrop(reinterpret_cast<const Rect*>(&state.crop));
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
+    if (state.fields & ANATIVEWINDOW_FRAME_STATE_TRANSFORM) {
+        int err = setBuffersTransform(static_cast<uint32_t>(state.transform));
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
+    if (state.fields & ANATIVEWINDOW_FRAME_STATE_FRAME_TIMELINE) {
+        FrameTimelineInfo ftlInfo;
+        ftlInfo.vsyncId = state.frameTimelineVsyncId;
+        ftlInfo.inputEventId = state.inputEventId;
+        ftlInfo.startTimeNanos = state.startTimeNanos;
+        ftlInfo.useForRefreshRateSelection = state.useForRefreshRateSelection != 0;
+        status_t err = setFrameTimelineInfo(state.frameNumber, ftlInfo);
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
+    if (state.fields & ANATIVEWINDOW_FRAME_STATE_FRAME_RATE) {
+        return setFrameRate(state.frameRate, state.compatibility, state.changeFrameRateStrategy);
+    }
+    return NO_ERROR;
+}
+
 int Surface::setBuffersSmpte2086Metadata(const android_smpte2086_metadata* metadata) {
     ALOGV("Surface::setBuffersSmpte2086Metadata");
     Mutex::Autolock lock(mMutex);
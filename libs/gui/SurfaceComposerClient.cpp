@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <algorithm>
+
 #include <android/gui/BnWindowInfosReportedListener.h>
 #include <android/gui/DisplayState.h>
 #include <android/gui/ISurfaceComposerClient.h>
@@ -345,6 +347,14 @@ void TransactionCompletedListener::addSurfaceControlToCallbacks(
 }
 
 void TransactionCompletedListener::onTransactionCompleted(ListenerStats listenerStats) {
+    for (const auto& releasedBuffer : listenerStats.releasedBuffers) {
+        onReleaseBuffer(releasedBuffer.callbackId, releasedBuffer.releaseFence,
+                        releasedBuffer.currentMaxAcquiredBufferCount);
+    }
+    if (listenerStats.transactionStats.empty()) {
+        return;
+    }
+
     std::unordered_map<CallbackId, CallbackTranslation, CallbackIdHash> callbacksMap;
     std::multimap<int32_t, sp<JankDataListener>> jankListenersMap;
     {
@@ -369,6 +379,13 @@ void TransactionCompletedListener::onTransactionCompleted(ListenerStats listener
             }
         }
     }
+
+    // Release buffers before running any commit or complete callback. Those run app code that
+    // can be slow, and every BLAST queue in the process waits on its releases to dequeue.
+    for (const auto& transactionStats : listenerStats.transactionStats) {
+        releasePreviousBuffers(transactionStats);
+    }
+
     for (const auto& transactionStats : listenerStats.transactionStats) {
         // handle on commit callbacks
         for (auto callbackId : transactionStats.callbackIds) {
@@ -422,25 +439,6 @@ void TransactionCompletedListener::onTransactionCompleted(ListenerStats listener
                             .surfaceControls[surfaceStats.surfaceControl]
                             ->setTransformHint(*surfaceStats.transformHint);
                 }
-                // If there is buffer id set, we look up any pending client release buffer callbacks
-                // and call them. This is a performance optimization when we have a transaction
-                // callback and a release buffer callback happening at the same time to avoid an
-                // additional ipc call from the server.
-                if (surfaceStats.previousReleaseCallbackId != ReleaseCallbackId::INVALID_ID) {
-                    ReleaseBufferCallback callback;
-                    {
-                        std::scoped_lock<std::mutex> lock(mMutex);
-                        callback = popReleaseBufferCallbackLocked(
-                                surfaceStats.previousReleaseCallbackId);
-                    }
-                    if (callback) {
-                        callback(surfaceStats.previousReleaseCallbackId,
-                                 surfaceStats.previousReleaseFence
-                                         ? surfaceStats.previousReleaseFence
-                                         : Fence::NO_FENCE,
-                                 surfaceStats.currentMaxAcquiredBufferCount);
-                    }
-                }
             }
 
             callbackFunction(transactionStats.latchTime, transactionStats.presentFence,
@@ -486,6 +484,39 @@ void TransactionCompletedListener::onTransactionCompleted(ListenerStats listener
     }
 }
 
+void TransactionCompletedListener::releasePreviousBuffers(const TransactionStats& transactionStats) {
+    // Buffers are only released here for transactions that carry an on complete callback.
+    const bool hasCompleteCallback =
+            std::any_of(transactionStats.callbackIds.begin(), transactionStats.callbackIds.end(),
+                        [](const CallbackId& callbackId) {
+                            return callbackId.type == CallbackId::Type::ON_COMPLETE;
+                        });
+    if (!hasCompleteCallback) {
+        return;
+    }
+
+    for (const auto& surfaceStats : transactionStats.surfaceStats) {
+        // If there is buffer id set, we look up any pending client release buffer callbacks
+        // and call them. This is a performance optimization when we have a transaction
+        // callback and a release buffer callback happening at the same time to avoid an
+        // additional ipc call from the server.
+        if (surfaceStats.previousReleaseCallbackId == ReleaseCallbackId::INVALID_ID) {
+            continue;
+        }
+        ReleaseBufferCallback callback;
+        {
+            std::scoped_lock<std::mutex> lock(mMutex);
+            callback = popReleaseBufferCallbackLocked(surfaceStats.previousReleaseCallbackId);
+        }
+        if (callback) {
+            callback(surfaceStats.previousReleaseCallbackId,
+                     surfaceStats.previousReleaseFence ? surfaceStats.previousReleaseFence
+                                                       : Fence::NO_FENCE,
+                     surfaceStats.currentMaxAcquiredBufferCount);
+        }
+    }
+}
+
 void TransactionCompletedListener::onTransactionQueueStalled(const String8& reason) {
     std::unordered_map<void*, std::function<void(const std::string&)>> callbackCopy;
     {
@@ -1162,6 +1193,7 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
 
     bool hasListenerCallbacks = !mListenerCallbacks.empty();
     std::vector<ListenerCallbacks> listenerCallbacks;
+    listenerCallbacks.reserve(mListenerCallbacks.size());
     // For every listener with registered callbacks
     for (const auto& [listener, callbackInfo] : mListenerCallbacks) {
         auto& [callbackIds, surfaceControls] = callbackInfo;
@@ -1193,6 +1225,7 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
     Vector<DisplayState> displayStates;
     uint32_t flags = 0;
 
+    composerStates.setCapacity(mComposerStates.size());
     for (auto const& kv : mComposerStates) {
         composerStates.add(kv.second);
     }
@@ -1317,17 +1350,15 @@ void SurfaceComposerClient::Transaction::setEarlyWakeupEnd() {
 layer_state_t* SurfaceComposerClient::Transaction::getLayerState(const sp<SurfaceControl>& sc) {
     auto handle = sc->getLayerStateHandle();
 
-    if (mComposerStates.count(handle) == 0) {
-        // we don't have it, add an initialized layer_state to our list
-        ComposerState s;
-
-        s.state.surface = handle;
-        s.state.layerId = sc->getLayerId();
-
-        mComposerStates[handle] = s;
+    // Look the layer up once and, if we don't have it yet, build its layer_state in place
+    // rather than copying in an initialized temporary.
+    auto [it, inserted] = mComposerStates.try_emplace(handle);
+    if (inserted) {
+        it->second.state.surface = handle;
+        it->second.state.layerId = sc->getLayerId();
     }
 
-    return &(mComposerStates[handle].state);
+    return &(it->second.state);
 }
 
 void SurfaceComposerClient::Transaction::registerSurfaceControlForCallback(
@@ -2436,6 +2467,47 @@ status_t SurfaceComposerClient::createSurfaceChecked(const String8& name, uint32
     return err;
 }
 
+status_t SurfaceComposerClient::createSurfacesChecked(std::vector<SurfaceCreationArgs> args,
+                                                      std::vector<sp<SurfaceControl>>* outSurfaces) {
+    if (mStatus != NO_ERROR) {
+        return mStatus;
+    }
+
+    std::vector<gui::CreateSurfaceArgs> surfaceArgs;
+    surfaceArgs.reserve(args.size());
+    for (auto& arg : args) {
+        gui::CreateSurfaceArgs& surfaceArg = surfaceArgs.emplace_back();
+        surfaceArg.name = std::string(arg.name.string());
+        surfaceArg.flags = arg.flags;
+        surfaceArg.parent = arg.parentHandle;
+        surfaceArg.metadata = std::move(arg.metadata);
+    }
+
+    std::vector<gui::CreateSurfaceResult> results;
+    const binder::Status status = mClient->createSurfaces(surfaceArgs, &results);
+    const status_t err = statusTFromBinderStatus(status);
+    ALOGE_IF(err, "SurfaceComposerClient::createSurfaces error %s", strerror(-err));
+    if (err != NO_ERROR) {
+        return err;
+    }
+    if (results.size() != args.size()) {
+        ALOGE("SurfaceComposerClient::createSurfaces returned %zu surfaces for %zu requests",
+              results.size(), args.size());
+        return BAD_VALUE;
+    }
+
+    outSurfaces->clear();
+    outSurfaces->reserve(results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        outSurfaces->push_back(new SurfaceControl(this, result.handle, result.layerId,
+                                                  toString(result.layerName), args[i].w, args[i].h,
+                                                  args[i].format, result.transformHint,
+                                                  args[i].flags));
+    }
+    return NO_ERROR;
+}
+
 sp<SurfaceControl> SurfaceComposerClient::mirrorSurface(SurfaceControl* mirrorFromSurface) {
     if (mirrorFromSurface == nullptr) {
         return nullptr;
@@ -17,8 +17,11 @@
 #include <android/gui/ISurfaceComposer.h>
 #include <gui/AidlStatusUtil.h>
 #include <gui/WindowInfosListenerReporter.h>
+#include <log/log.h>
 #include "gui/WindowInfosUpdate.h"
 
+#include <cinttypes>
+
 namespace android {
 
 using gui::DisplayInfo;
@@ -40,7 +43,9 @@ status_t WindowInfosListenerReporter::addWindowInfosListener(
         std::scoped_lock lock(mListenersMutex);
         if (mWindowInfosListeners.empty()) {
             gui::WindowInfosListenerInfo listenerInfo;
-            binder::Status s = surfaceComposer->addWindowInfosListener(this, &listenerInfo);
+            binder::Status s = surfaceComposer->addWindowInfosListener(this,
+                                                                       /*supportsDeltaUpdates=*/true,
+                                                                       &listenerInfo);
             status = statusTFromBinderStatus(s);
             if (status == OK) {
                 mWindowInfosPublisher = std::move(listenerInfo.windowInfosPublisher);
@@ -78,6 +83,7 @@ status_t WindowInfosListenerReporter::removeWindowInfosListener(
             // stale values
             mLastWindowInfos.clear();
             mLastDisplayInfos.clear();
+            mLastVsyncId.reset();
         }
 
         if (status == OK) {
@@ -92,19 +98,40 @@ binder::Status WindowInfosListenerReporter::onWindowInfosChanged(
         const gui::WindowInfosUpdate& update) {
     std::unordered_set<sp<WindowInfosListener>, gui::SpHash<WindowInfosListener>>
             windowInfosListeners;
+    std::optional<gui::WindowInfosUpdate> fullUpdate;
 
     {
         std::scoped_lock lock(mListenersMutex);
-        for (auto listener : mWindowInfosListeners) {
-            windowInfosListeners.insert(listener);
+        if (update.isDelta) {
+            // Expand the delta so that local listeners always see the complete list of windows.
+            std::vector<gui::WindowInfo> windowInfos;
+            if (mLastVsyncId != update.baseVsyncId ||
+                update.applyDelta(mLastWindowInfos, &windowInfos) != OK) {
+                // The stored state no longer matches what SurfaceFlinger bases its deltas on, so
+                // drop every delta until the next complete update replaces it.
+                ALOGE("Dropping window infos delta for vsync %" PRId64 " based on %" PRId64,
+                      update.vsyncId, update.baseVsyncId);
+                mLastVsyncId.reset();
+            } else {
+                mLastWindowInfos = std::move(windowInfos);
+                mLastDisplayInfos = update.displayInfos;
+                mLastVsyncId = update.vsyncId;
+                fullUpdate.emplace(mLastWindowInfos, mLastDisplayInfos, update.vsyncId,
+                                   update.timestamp);
+                windowInfosListeners.insert(mWindowInfosListeners.begin(),
+                                            mWindowInfosListeners.end());
+            }
+        } else {
+            mLastWindowInfos = update.windowInfos;
+            mLastDisplayInfos = update.displayInfos;
+            mLastVsyncId = update.vsyncId;
+            windowInfosListeners.insert(mWindowInfosListeners.begin(),
+                                        mWindowInfosListeners.end());
         }
-
-        mLastWindowInfos = update.windowInfos;
-        mLastDisplayInfos = update.displayInfos;
     }
 
     for (auto listener : windowInfosListeners) {
-        listener->onWindowInfosChanged(update);
+        listener->onWindowInfosChanged(fullUpdate ? *fullUpdate : update);
     }
 
     mWindowInfosPublisher->ackWindowInfosReceived(update.vsyncId, mListenerId);
@@ -116,7 +143,8 @@ void WindowInfosListenerReporter::reconnect(const sp<gui::ISurfaceComposer>& com
     std::scoped_lock lock(mListenersMutex);
     if (!mWindowInfosListeners.empty()) {
         gui::WindowInfosListenerInfo listenerInfo;
-        composerService->addWindowInfosListener(this, &listenerInfo);
+        composerService->addWindowInfosListener(this, /*supportsDeltaUpdates=*/true,
+                                                &listenerInfo);
         mWindowInfosPublisher = std::move(listenerInfo.windowInfosPublisher);
         mListenerId = listenerInfo.listenerId;
     }
@@ -15,10 +15,70 @@
  */
 
 #include <gui/WindowInfosUpdate.h>
+#include <log/log.h>
 #include <private/gui/ParcelUtils.h>
 
+#include <cinttypes>
+#include <unordered_map>
+
 namespace android::gui {
 
+WindowInfosUpdate WindowInfosUpdate::createDelta(const std::vector<WindowInfo>& baseWindowInfos,
+                                                 int64_t baseVsyncId,
+                                                 const WindowInfosUpdate& update) {
+    std::unordered_map<int32_t, const WindowInfo*> baseWindowsById;
+    baseWindowsById.reserve(baseWindowInfos.size());
+    for (const auto& windowInfo : baseWindowInfos) {
+        baseWindowsById.emplace(windowInfo.id, &windowInfo);
+    }
+
+    WindowInfosUpdate delta{{}, update.displayInfos, update.vsyncId, update.timestamp};
+    delta.isDelta = true;
+    delta.baseVsyncId = baseVsyncId;
+    delta.windowIds.reserve(update.windowInfos.size());
+    for (const auto& windowInfo : update.windowInfos) {
+        delta.windowIds.push_back(windowInfo.id);
+        const auto it = baseWindowsById.find(windowInfo.id);
+        if (it == baseWindowsById.end() || !(*it->second == windowInfo)) {
+            delta.windowInfos.push_back(windowInfo);
+        }
+    }
+    return delta;
+}
+
+status_t WindowInfosUpdate::applyDelta(const std::vector<WindowInfo>& baseWindowInfos,
+                                       std::vector<WindowInfo>* outWindowInfos) const {
+    if (!isDelta) {
+        *outWindowInfos = windowInfos;
+        return OK;
+    }
+
+    std::unordered_map<int32_t, const WindowInfo*> baseWindowsById;
+    baseWindowsById.reserve(baseWindowInfos.size());
+    for (const auto& windowInfo : baseWindowInfos) {
+        baseWindowsById.emplace(windowInfo.id, &windowInfo);
+    }
+
+    std::vector<WindowInfo> result;
+    result.reserve(windowIds.size());
+    // Changed windows are stored in the same relative order as windowIds.
+    auto changed = windowInfos.begin();
+    for (int32_t id : windowIds) {
+        if (changed != windowInfos.end() && changed->id == id) {
+            result.push_back(*changed++);
+            continue;
+        }
+        const auto it = baseWindowsById.find(id);
+        if (it == baseWindowsById.end()) {
+            ALOGE("%s: window %d is not in the base update %" PRId64, __func__, id, baseVsyncId);
+            return BAD_VALUE;
+        }
+        result.push_back(*it->second);
+    }
+    *outWindowInfos = std::move(result);
+    return OK;
+}
+
 status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
     if (parcel == nullptr) {
         ALOGE("%s: Null parcel", __func__);
@@ -44,6 +104,12 @@ status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
     SAFE_PARCEL(parcel->readInt64, &vsyncId);
     SAFE_PARCEL(parcel->readInt64, &timestamp);
 
+    SAFE_PARCEL(parcel->readBool, &isDelta);
+    if (isDelta) {
+        SAFE_PARCEL(parcel->readInt64, &baseVsyncId);
+        SAFE_PARCEL(parcel->readInt32Vector, &windowIds);
+    }
+
     return OK;
 }
 
@@ -66,6 +132,12 @@ status_t WindowInfosUpdate::writeToParcel(android::Parcel* parcel) const {
     SAFE_PARCEL(parcel->writeInt64, vsyncId);
     SAFE_PARCEL(parcel->writeInt64, timestamp);
 
+    SAFE_PARCEL(parcel->writeBool, isDelta);
+    if (isDelta) {
+        SAFE_PARCEL(parcel->writeInt64, baseVsyncId);
+        SAFE_PARCEL(parcel->writeInt32Vector, windowIds);
+    }
+
     return OK;
 }
 
@@ -82,6 +82,14 @@ bool h2b(HQueueBufferOutput const& from, BQueueBufferOutput* to) {
 
 status_t H2BGraphicBufferProducer::requestBuffer(int slot,
                                                  sp<GraphicBuffer>* bBuffer) {
+    if (slot >= 0 && slot < BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        std::lock_guard<std::mutex> lock(mCachedBuffersMutex);
+        if (mCachedBuffers[slot]) {
+            *bBuffer = mCachedBuffers[slot];
+            return OK;
+        }
+    }
+
     bool converted{};
     status_t bStatus{};
     Return<void> transResult = mBase->requestBuffer(slot,
@@ -104,6 +112,9 @@ status_t H2BGraphicBufferProducer::requestBuffer(int slot,
         LOG(ERROR) << "requestBuffer: corrupted transaction.";
         return FAILED_TRANSACTION;
     }
+    if (bStatus == OK) {
+        cacheBuffer(slot, *bBuffer);
+    }
     return bStatus;
 }
 
@@ -173,10 +184,20 @@ status_t H2BGraphicBufferProducer::dequeueBuffer(
         LOG(ERROR) << "dequeueBuffer: corrupted transaction.";
         return FAILED_TRANSACTION;
     }
+    if (bStatus < 0) {
+        return bStatus;
+    }
+    if (bStatus & RELEASE_ALL_BUFFERS) {
+        clearCachedBuffers();
+    } else if (bStatus & BUFFER_NEEDS_REALLOCATION) {
+        clearCachedBuffer(*slot);
+    }
     return bStatus;
 }
 
 status_t H2BGraphicBufferProducer::detachBuffer(int slot) {
+    clearCachedBuffer(slot);
+
     status_t bStatus{};
     Return<HStatus> transResult = mBase->detachBuffer(
             static_cast<int32_t>(slot));
@@ -193,6 +214,9 @@ status_t H2BGraphicBufferProducer::detachBuffer(int slot) {
 
 status_t H2BGraphicBufferProducer::detachNextBuffer(
         sp<GraphicBuffer>* outBuffer, sp<BFence>* outFence) {
+    // The slot that the buffer is detached from is not returned.
+    clearCachedBuffers();
+
     bool converted{};
     status_t bStatus{};
     Return<void> transResult = mBase->detachNextBuffer(
@@ -243,6 +267,12 @@ status_t H2BGraphicBufferProducer::attachBuffer(
         LOG(ERROR) << "attachBuffer: corrupted transaction.";
         return FAILED_TRANSACTION;
     }
+    if (bStatus == IGraphicBufferProducer::RELEASE_ALL_BUFFERS) {
+        clearCachedBuffers();
+    }
+    if (bStatus == OK || bStatus == IGraphicBufferProducer::RELEASE_ALL_BUFFERS) {
+        cacheBuffer(*outSlot, buffer);
+    }
     return bStatus;
 }
 
@@ -318,6 +348,8 @@ int H2BGraphicBufferProducer::query(int what, int* value) {
 status_t H2BGraphicBufferProducer::connect(
         sp<IProducerListener> const& listener, int api,
         bool producerControlledByApp, QueueBufferOutput* output) {
+    clearCachedBuffers();
+
     HConnectionType hConnectionType;
     if (!b2h(api, &hConnectionType)) {
         LOG(ERROR) << "connect: corrupted input connection type.";
@@ -356,6 +388,8 @@ status_t H2BGraphicBufferProducer::connect(
 }
 
 status_t H2BGraphicBufferProducer::disconnect(int api, DisconnectMode mode) {
+    clearCachedBuffers();
+
     HConnectionType hConnectionType;
     if (mode == DisconnectMode::AllLocal) {
         hConnectionType = HConnectionType::CURRENTLY_CONNECTED;
@@ -389,6 +423,9 @@ status_t H2BGraphicBufferProducer::setSidebandStream(
 void H2BGraphicBufferProducer::allocateBuffers(
         uint32_t width, uint32_t height,
         PixelFormat format, uint64_t usage) {
+    // Preallocation fills free slots without reporting which ones.
+    clearCachedBuffers();
+
     status_t bStatus{};
     Return<HStatus> transResult = mBase->allocateBuffers(
             width, height, static_cast<uint32_t>(format), usage);
@@ -418,6 +455,8 @@ status_t H2BGraphicBufferProducer::allowAllocation(bool allow) {
 
 status_t H2BGraphicBufferProducer::setGenerationNumber(
         uint32_t generationNumber) {
+    clearCachedBuffers();
+
     status_t bStatus{};
     Return<HStatus> transResult = mBase->setGenerationNumber(generationNumber);
     if (!transResult.isOk()) {
@@ -498,6 +537,25 @@ status_t H2BGraphicBufferProducer::getConsumerUsage(uint64_t*) const {
     return INVALID_OPERATION;
 }
 
+void H2BGraphicBufferProducer::cacheBuffer(int slot, sp<GraphicBuffer> const& buffer) {
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mCachedBuffersMutex);
+    mCachedBuffers[slot] = buffer;
+}
+
+void H2BGraphicBufferProducer::clearCachedBuffer(int slot) {
+    cacheBuffer(slot, nullptr);
+}
+
+void H2BGraphicBufferProducer::clearCachedBuffers() {
+    std::lock_guard<std::mutex> lock(mCachedBuffersMutex);
+    for (sp<GraphicBuffer>& buffer : mCachedBuffers) {
+        buffer.clear();
+    }
+}
+
 }  // namespace utils
 }  // namespace V2_0
 }  // namespace bufferqueue
@@ -154,7 +154,8 @@ public:
     MOCK_METHOD(binder::Status, getGpuContextPriority, (int32_t*), (override));
     MOCK_METHOD(binder::Status, getMaxAcquiredBufferCount, (int32_t*), (override));
     MOCK_METHOD(binder::Status, addWindowInfosListener,
-                (const sp<gui::IWindowInfosListener>&, gui::WindowInfosListenerInfo*), (override));
+                (const sp<gui::IWindowInfosListener>&, bool, gui::WindowInfosListenerInfo*),
+                (override));
     MOCK_METHOD(binder::Status, removeWindowInfosListener, (const sp<gui::IWindowInfosListener>&),
                 (override));
     MOCK_METHOD(binder::Status, getOverlaySupport, (gui::OverlayProperties*), (override));
@@ -167,6 +168,11 @@ public:
                  const gui::LayerMetadata& metadata, gui::CreateSurfaceResult* outResult),
                 (override));
 
+    MOCK_METHOD(binder::Status, createSurfaces,
+                (const std::vector<gui::CreateSurfaceArgs>& args,
+                 std::vector<gui::CreateSurfaceResult>* outResults),
+                (override));
+
     MOCK_METHOD(binder::Status, clearLayerFrameStats, (const sp<IBinder>& handle), (override));
 
     MOCK_METHOD(binder::Status, getLayerFrameStats,
@@ -123,6 +123,12 @@ public:
     void releaseBufferCallbackLocked(const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
                                      std::optional<uint32_t> currentMaxAcquiredBufferCount,
                                      bool fakeRelease) REQUIRES(mMutex);
+    // Adds a batch of released buffers to mPendingRelease and then returns the ones that no
+    // longer need to be held to the BufferQueue, waking up waiters once for the whole batch.
+    void releaseBufferCallbacksLocked(const std::vector<ReleaseCallbackId>& ids,
+                                      const sp<Fence>& releaseFence,
+                                      std::optional<uint32_t> currentMaxAcquiredBufferCount,
+                                      bool fakeRelease) REQUIRES(mMutex);
     bool syncNextTransaction(std::function<void(SurfaceComposerClient::Transaction*)> callback,
                              bool acquireSingleBuffer = true);
     void stopContinuousSyncTransaction();
@@ -227,6 +233,13 @@ private:
     };
     std::deque<ReleasedBuffer> mPendingRelease GUARDED_BY(mMutex);
 
+    // Records a release in mPendingRelease and returns how many pending releases must be held
+    // back from the BufferQueue afterwards.
+    uint32_t addPendingReleaseLocked(const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
+                                     std::optional<uint32_t> currentMaxAcquiredBufferCount,
+                                     bool fakeRelease) REQUIRES(mMutex);
+    void releasePendingBuffersLocked(uint32_t numPendingBuffersToHold) REQUIRES(mMutex);
+
     ui::Size mSize GUARDED_BY(mMutex);
     ui::Size mRequestedSize GUARDED_BY(mMutex);
     int32_t mFormat GUARDED_BY(mMutex);
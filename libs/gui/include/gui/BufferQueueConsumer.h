@@ -178,6 +178,12 @@ public:
     // will eventually be released or acquired by the consumer.
     void setAllowExtraAcquire(bool /* allow */);
 
+    // Lets the BufferQueue add a slot on top of the configured buffer count
+    // while the producer keeps blocking in dequeueBuffer, and take it back
+    // once the producer stops blocking. Thresholds and decisions are shown in
+    // dumpState.
+    void setAdaptiveBufferCountEnabled(bool /* enabled */);
+
 private:
     sp<BufferQueueCore> mCore;
 
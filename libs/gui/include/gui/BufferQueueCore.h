@@ -99,6 +99,7 @@ private:
     //     mMaxBufferCount
     //     mAsyncMode
     //     mDequeueBufferCannotBlock
+    //     mAdaptiveExtraBufferCount
     //
     // Any time one of these member variables is changed while a producer is
     // connected, mDequeueCondition must be broadcast.
@@ -127,6 +128,20 @@ private:
     // away slots. Returns false if the request can't be met.
     bool adjustAvailableSlotsLocked(int delta);
 
+    // In adaptive buffer count mode, onDequeueBlockedLocked is called when a
+    // dequeue is about to wait for a free buffer, and returns true if it made
+    // another slot available instead. onBufferQueuedLocked is called for every
+    // queued buffer, and returns true if it took the adaptive slot back
+    // because the producer has not blocked for a while, in which case the
+    // consumer must be told its buffers were released.
+    bool onDequeueBlockedLocked();
+    bool onBufferQueuedLocked();
+
+    // setAdaptiveExtraBufferCountLocked changes the number of slots added on
+    // top of getMaxBufferCountLocked by adaptive buffer count mode. Returns
+    // false, leaving the count unchanged, if the slots can't be adjusted.
+    bool setAdaptiveExtraBufferCountLocked(int extraBufferCount);
+
     // waitWhileAllocatingLocked blocks until mIsAllocating is false.
     void waitWhileAllocatingLocked(std::unique_lock<std::mutex>& lock) const;
 
@@ -202,7 +217,7 @@ private:
 
     // mFreeSlots contains all of the slots which are FREE and do not currently
     // have a buffer attached.
-    std::set<int> mFreeSlots;
+    BufferQueueDefs::SlotSet mFreeSlots;
 
     // mFreeBuffers contains all of the slots which are FREE and currently have
     // a buffer attached.
@@ -213,7 +228,7 @@ private:
     std::list<int> mUnusedSlots;
 
     // mActiveBuffers contains all slots which have a non-FREE buffer attached.
-    std::set<int> mActiveBuffers;
+    BufferQueueDefs::SlotSet mActiveBuffers;
 
     // mDequeueCondition is a condition variable used for dequeueBuffer in
     // synchronous mode.
@@ -357,6 +372,23 @@ private:
     // This allows the consumer to acquire an additional buffer if that buffer is not droppable and
     // will eventually be released or acquired by the consumer.
     bool mAllowExtraAcquire = false;
+
+    // Adaptive buffer count mode, enabled by the consumer, adds a slot when
+    // the producer keeps blocking in dequeueBuffer and takes it back once it
+    // hasn't blocked for kAdaptiveShrinkAfterFrames queued buffers.
+    static constexpr int kAdaptiveMaxExtraBuffers = 1;
+    static constexpr uint32_t kAdaptiveGrowAfterBlockedDequeues = 3;
+    static constexpr uint32_t kAdaptiveBlockedDequeueWindowFrames = 60;
+    static constexpr uint32_t kAdaptiveShrinkAfterFrames = 300;
+    bool mAdaptiveBufferCountEnabled = false;
+    // The number of slots currently added on top of the configured count.
+    int mAdaptiveExtraBufferCount = 0;
+    // Blocked dequeues since the last one more than
+    // kAdaptiveBlockedDequeueWindowFrames queued buffers ago.
+    uint32_t mAdaptiveBlockedDequeues = 0;
+    uint32_t mAdaptiveFramesSinceBlocked = 0;
+    uint32_t mAdaptiveGrowCount = 0;
+    uint32_t mAdaptiveShrinkCount = 0;
 }; // class BufferQueueCore
 
 } // namespace android
@@ -20,11 +20,65 @@
 #include <gui/BufferSlot.h>
 #include <ui/BufferQueueDefs.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace android {
     class BufferQueueCore;
 
     namespace BufferQueueDefs {
         typedef BufferSlot SlotsType[NUM_BUFFER_SLOTS];
+
+        // A set of slot indices stored as a bitmap. It provides the subset of
+        // the std::set<int> interface that BufferQueue uses, but insert, erase
+        // and finding the lowest slot are single bit operations. Iteration
+        // visits slots in increasing order, like std::set<int>.
+        class SlotSet {
+        public:
+            static_assert(NUM_BUFFER_SLOTS <= 64, "SlotSet only holds 64 slots");
+
+            class const_iterator {
+            public:
+                int operator*() const { return __builtin_ctzll(mBits); }
+                const_iterator& operator++() {
+                    mBits &= mBits - 1;
+                    return *this;
+                }
+                bool operator==(const const_iterator& other) const {
+                    return mBits == other.mBits;
+                }
+                bool operator!=(const const_iterator& other) const {
+                    return mBits != other.mBits;
+                }
+
+            private:
+                friend class SlotSet;
+                explicit const_iterator(uint64_t bits) : mBits(bits) {}
+                uint64_t mBits;
+            };
+            using iterator = const_iterator;
+
+            const_iterator begin() const { return const_iterator(mBits); }
+            const_iterator end() const { return const_iterator(0); }
+
+            bool empty() const { return mBits == 0; }
+            size_t size() const { return static_cast<size_t>(__builtin_popcountll(mBits)); }
+            size_t count(int slot) const { return (mBits >> slot) & 1; }
+
+            void insert(int slot) { mBits |= bit(slot); }
+            size_t erase(int slot) {
+                const size_t erased = count(slot);
+                mBits &= ~bit(slot);
+                return erased;
+            }
+            void erase(const_iterator it) { erase(*it); }
+            void clear() { mBits = 0; }
+
+        private:
+            static uint64_t bit(int slot) { return uint64_t{1} << slot; }
+
+            uint64_t mBits = 0;
+        };
     } // namespace BufferQueueDefs
 } // namespace android
 
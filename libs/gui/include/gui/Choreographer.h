@@ -22,6 +22,7 @@
 #include <utils/Looper.h>
 
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 
@@ -73,6 +74,21 @@ public:
     };
     static Context gChoreographers;
 
+    // How well the frame timelines handed to callbacks held up, accumulated over the lifetime
+    // of this Choreographer.
+    struct FrameTimelineStats {
+        // Vsync events that ran at least one frame callback.
+        size_t framesDispatched = 0;
+        // Of those, the frames whose callbacks returned after the preferred timeline's
+        // deadline, leaving no time to render before it.
+        size_t framesPastDeadline = 0;
+        // Preferred timelines whose vsync id was also predicted by the previous vsync event,
+        // and how far the expected presentation time moved between the two predictions.
+        size_t predictionsCompared = 0;
+        nsecs_t totalPredictionDrift = 0;
+        nsecs_t maxPredictionDrift = 0;
+    };
+
     explicit Choreographer(const sp<Looper>& looper, const sp<IBinder>& layerHandle = nullptr)
             EXCLUDES(gChoreographers.lock);
     void postFrameCallbackDelayed(AChoreographer_frameCallback cb,
@@ -93,6 +109,7 @@ public:
         MSG_SCHEDULE_CALLBACKS = 0,
         MSG_SCHEDULE_VSYNC = 1,
         MSG_HANDLE_REFRESH_RATE_UPDATES = 2,
+        MSG_DISPATCH_SHARED_VSYNC = 3,
     };
     virtual void handleMessage(const Message& message) override;
 
@@ -103,8 +120,21 @@ public:
     virtual ~Choreographer() override EXCLUDES(gChoreographers.lock);
     int64_t getFrameInterval() const;
     bool inCallback() const;
+    FrameTimelineStats getFrameTimelineStats() const;
 
 private:
+    class SharedVsyncSource;
+
+    // A vsync event received by the shared source, waiting to be dispatched on this thread.
+    struct SharedVsyncEvent {
+        nsecs_t timestamp;
+        PhysicalDisplayId displayId;
+        uint32_t count;
+        VsyncEventData vsyncEventData;
+    };
+
+    // Creates a Choreographer that receives its vsync events from the given shared source.
+    Choreographer(const sp<Looper>& looper, SharedVsyncSource* sharedVsyncSource);
     Choreographer(const Choreographer&) = delete;
 
     void dispatchVsync(nsecs_t timestamp, PhysicalDisplayId displayId, uint32_t count,
@@ -117,21 +147,32 @@ private:
                                     std::vector<FrameRateOverride> overrides) override;
 
     void scheduleCallbacks();
+    // Requests the next vsync from the shared source if this Choreographer uses it, or from its
+    // own connection otherwise.
+    void requestVsync();
+    // Called by the shared source on its thread to hand over a vsync event.
+    void postSharedVsync(const SharedVsyncEvent& event);
 
     ChoreographerFrameCallbackDataImpl createFrameCallbackData(nsecs_t timestamp) const;
     void registerStartTime() const;
+    void updatePredictionStatsLocked(const VsyncEventData& vsyncEventData) REQUIRES(mLock);
 
-    std::mutex mLock;
+    mutable std::mutex mLock;
     // Protected by mLock
     std::priority_queue<FrameCallback> mFrameCallbacks;
     std::vector<RefreshRateCallback> mRefreshRateCallbacks;
+    FrameTimelineStats mFrameTimelineStats GUARDED_BY(mLock);
+    std::optional<SharedVsyncEvent> mPendingSharedVsync GUARDED_BY(mLock);
 
     nsecs_t mLatestVsyncPeriod = -1;
-    VsyncEventData mLastVsyncEventData;
+    VsyncEventData mLastVsyncEventData{};
     bool mInCallback = false;
 
     const sp<Looper> mLooper;
     const std::thread::id mThreadId;
+    // Set for the per-thread Choreographers of every thread but the first, which share one
+    // connection to SurfaceFlinger.
+    SharedVsyncSource* const mSharedVsyncSource = nullptr;
 
     // Approximation of num_threads_using_choreographer * num_frames_of_history with leeway.
     static constexpr size_t kMaxStartTimes = 250;
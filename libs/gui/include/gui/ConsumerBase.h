@@ -173,6 +173,14 @@ protected:
     // This method must be called with mMutex locked.
     virtual void abandonLocked();
 
+    // discardFreeBuffersLocked is called by discardFreeBuffers after it has
+    // freed the free slots. Derived classes that keep freed buffers alive
+    // outside of their slots should release them here. The ConsumerBase
+    // version does nothing.
+    //
+    // This method must be called with mMutex locked.
+    virtual void discardFreeBuffersLocked() {}
+
     // dumpLocked dumps the current state of the ConsumerBase object to the
     // result string.  Each line is prefixed with the string pointed to by the
     // prefix argument.  The buffer argument points to a buffer that may be
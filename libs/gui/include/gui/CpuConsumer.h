@@ -105,6 +105,19 @@ class CpuConsumer : public ConsumerBase
     // by calling unlockBuffer before more buffers can be acquired.
     status_t lockNextBuffer(LockedBuffer *nativeBuffer);
 
+    // Locks up to maxBuffers of the graphics buffers queued by the producer,
+    // oldest first, filling out one locked buffer structure for each. The number
+    // of buffers locked is returned in outCount. This is equivalent to calling
+    // lockNextBuffer repeatedly, except that the consumer lock is taken only once,
+    // so a reader that falls behind can catch up on a batch of frames at once.
+    //
+    // Returns BAD_VALUE if no new buffer is available, and NOT_ENOUGH_DATA if the
+    // maximum number of buffers is already locked. Otherwise, locking stops at
+    // the first buffer that cannot be locked, and OK is returned if at least one
+    // buffer was locked.
+    status_t lockNextBuffers(LockedBuffer *nativeBuffers, size_t maxBuffers,
+            size_t *outCount);
+
     // Returns a locked buffer to the queue, allowing it to be reused. Since
     // only a fixed number of buffers may be locked at a time, old buffers must
     // be released by calling unlockBuffer to ensure new buffers can be acquired by
@@ -142,6 +155,8 @@ class CpuConsumer : public ConsumerBase
 
     status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
 
+    status_t lockNextBufferLocked(LockedBuffer* nativeBuffer);
+
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
     // Count of currently locked buffers
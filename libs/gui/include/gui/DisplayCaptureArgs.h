@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 #include <binder/Parcelable.h>
 #include <gui/SpHash.h>
+#include <ui/GraphicBuffer.h>
 #include <ui/GraphicTypes.h>
 #include <ui/PixelFormat.h>
 #include <ui/Rect.h>
@@ -68,6 +69,12 @@ struct CaptureArgs : public Parcelable {
     // Note that if the caller is requesting a specific dataspace, this hint does nothing.
     bool hintForSeamlessTransition = false;
 
+    // Buffer to render the capture into. If it matches the size and format of the capture, it is
+    // used instead of allocating a new buffer, so clients that capture continuously can cycle
+    // through a fixed set of buffers. The client must not read the buffer until the capture
+    // completes.
+    sp<GraphicBuffer> captureBuffer;
+
     virtual status_t writeToParcel(Parcel* output) const;
     virtual status_t readFromParcel(const Parcel* input);
 };
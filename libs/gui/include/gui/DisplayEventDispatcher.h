@@ -18,6 +18,8 @@
 #include <utils/Log.h>
 #include <utils/Looper.h>
 
+#include <optional>
+
 namespace android {
 using FrameRateOverride = DisplayEventReceiver::Event::FrameRateOverride;
 
@@ -38,11 +40,17 @@ public:
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
 protected:
+    struct NoConnection {};
+
+    // Creates a dispatcher without its own connection to SurfaceFlinger, for subclasses that are
+    // handed their vsync events by another dispatcher. It has no fd, and cannot schedule vsync.
+    DisplayEventDispatcher(const sp<Looper>& looper, NoConnection);
+
     virtual ~DisplayEventDispatcher() = default;
 
 private:
     sp<Looper> mLooper;
-    DisplayEventReceiver mReceiver;
+    std::optional<DisplayEventReceiver> mReceiver;
     bool mWaitingForVsync;
     uint32_t mLastVsyncCount;
     nsecs_t mLastScheduleVsyncTime;
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/BufferQueueDefs.h>
+#include <ui/GraphicBuffer.h>
+#include <ui/PixelFormat.h>
+#include <utils/String8.h>
+
+#include <cinttypes>
+#include <vector>
+
+namespace android {
+
+// EglImageCache holds the images of buffers that left their consumer slot, so
+// that a buffer coming back into any slot reuses its EGLImage instead of
+// creating a new one. This happens when a producer cycles between buffer sets.
+//
+// Cached images keep their buffers alive, so the cache is bounded both by the
+// estimated memory of those buffers and by age: an image is evicted once the
+// consumer has acquired maxAge buffers since it was cached.
+//
+// Image is the EglImage class of the consumer, which must provide
+// graphicBuffer(). EglImageCache is not thread safe; consumers use it with
+// their own mutex held.
+template <typename Image>
+class EglImageCache {
+public:
+    static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+    static constexpr uint64_t kDefaultMaxAge = 2 * BufferQueueDefs::NUM_BUFFER_SLOTS;
+
+    explicit EglImageCache(size_t maxBytes = kDefaultMaxBytes, uint64_t maxAge = kDefaultMaxAge)
+          : mMaxBytes(maxBytes), mMaxAge(maxAge) {}
+
+    // Must be called for every buffer the consumer acquires, to age the cache.
+    void onBufferAcquired() {
+        mAcquireCount++;
+        while (!mEntries.empty() && mAcquireCount - mEntries.front().acquireCount > mMaxAge) {
+            evictOldest();
+        }
+    }
+
+    // Removes the image created from buffer from the cache and returns it, or
+    // returns nullptr if the cache does not have one.
+    sp<Image> take(const sp<GraphicBuffer>& buffer) {
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+        const uint64_t id = buffer->getId();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->image->graphicBuffer()->getId() == id) {
+                sp<Image> image = std::move(it->image);
+                mBytes -= it->bytes;
+                mEntries.erase(it);
+                mHits++;
+                return image;
+            }
+        }
+        mMisses++;
+        return nullptr;
+    }
+
+    // Adds the image of a buffer that is leaving its slot, evicting the least
+    // recently cached images if that takes the cache over its memory bound.
+    void add(const sp<Image>& image) {
+        if (image == nullptr || image->graphicBuffer() == nullptr) {
+            return;
+        }
+        const size_t bytes = estimateBufferBytes(image->graphicBuffer());
+        if (bytes > mMaxBytes) {
+            return;
+        }
+        mEntries.push_back({image, bytes, mAcquireCount});
+        mBytes += bytes;
+        while (mBytes > mMaxBytes) {
+            evictOldest();
+        }
+    }
+
+    // Releases every cached image, e.g. when the consumer is abandoned or
+    // asked to discard its free buffers.
+    void clear() {
+        mEntries.clear();
+        mBytes = 0;
+    }
+
+    size_t size() const { return mEntries.size(); }
+    size_t bytes() const { return mBytes; }
+
+    void dump(String8& result, const char* prefix) const {
+        result.appendFormat("%sEGLImage cache: %zu images, %zu bytes, hits=%" PRIu64
+                            " misses=%" PRIu64 " evictions=%" PRIu64 "\n",
+                            prefix, mEntries.size(), mBytes, mHits, mMisses, mEvictions);
+    }
+
+    // Estimates the memory used by a buffer. YUV formats do not have a fixed
+    // number of bytes per pixel, so assume 4:2:0 subsampling for them.
+    static size_t estimateBufferBytes(const sp<GraphicBuffer>& buffer) {
+        const size_t pixels = static_cast<size_t>(buffer->getStride()) * buffer->getHeight() *
+                buffer->getLayerCount();
+        const uint32_t bpp = bytesPerPixel(buffer->getPixelFormat());
+        return bpp > 0 ? pixels * bpp : pixels * 3 / 2;
+    }
+
+private:
+    struct Entry {
+        sp<Image> image;
+        size_t bytes;
+        // The value of mAcquireCount when the image was cached.
+        uint64_t acquireCount;
+    };
+
+    void evictOldest() {
+        mBytes -= mEntries.front().bytes;
+        mEntries.erase(mEntries.begin());
+        mEvictions++;
+    }
+
+    const size_t mMaxBytes;
+    const uint64_t mMaxAge;
+
+    // Ordered from least to most recently cached.
+    std::vector<Entry> mEntries;
+    size_t mBytes = 0;
+    uint64_t mAcquireCount = 0;
+
+    // Counters of lookups and evictions, for dump.
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+    uint64_t mEvictions = 0;
+};
+
+} // namespace android
@@ -22,6 +22,7 @@
 
 #include <gui/BufferQueueDefs.h>
 #include <gui/ConsumerBase.h>
+#include <gui/EglImageCache.h>
 
 #include <ui/FenceTime.h>
 #include <ui/GraphicBuffer.h>
@@ -240,9 +241,14 @@ public:
 protected:
 
     // abandonLocked overrides the ConsumerBase method to clear
-    // mCurrentTextureImage in addition to the ConsumerBase behavior.
+    // mCurrentTextureImage and mEglImageCache in addition to the ConsumerBase
+    // behavior.
     virtual void abandonLocked();
 
+    // discardFreeBuffersLocked overrides the ConsumerBase method to clear
+    // mEglImageCache.
+    virtual void discardFreeBuffersLocked();
+
     // dumpLocked overrides the ConsumerBase method to dump GLConsumer-
     // specific info in addition to the ConsumerBase behavior.
     virtual void dumpLocked(String8& result, const char* prefix) const;
@@ -507,6 +513,10 @@ private:
     // mode and releaseTexImage() has been called
     static sp<GraphicBuffer> sReleasedTexImageBuffer;
     sp<EglImage> mReleasedTexImage;
+
+    // mEglImageCache holds the images of buffers that were freed from their
+    // slot, so that a buffer coming back into any slot reuses its EGLImage.
+    EglImageCache<EglImage> mEglImageCache;
 };
 
 // ----------------------------------------------------------------------------
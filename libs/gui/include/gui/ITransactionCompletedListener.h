@@ -178,6 +178,24 @@ public:
     std::vector<SurfaceStats> surfaceStats;
 };
 
+// A buffer released outside of a transaction callback, e.g. because it was dropped.
+class ReleasedBufferStats : public Parcelable {
+public:
+    status_t writeToParcel(Parcel* output) const override;
+    status_t readFromParcel(const Parcel* input) override;
+
+    ReleasedBufferStats() = default;
+    ReleasedBufferStats(const ReleaseCallbackId& callbackId, const sp<Fence>& releaseFence,
+                        uint32_t currentMaxAcquiredBufferCount)
+          : callbackId(callbackId),
+            releaseFence(releaseFence),
+            currentMaxAcquiredBufferCount(currentMaxAcquiredBufferCount) {}
+
+    ReleaseCallbackId callbackId;
+    sp<Fence> releaseFence;
+    uint32_t currentMaxAcquiredBufferCount = 0;
+};
+
 class ListenerStats : public Parcelable {
 public:
     status_t writeToParcel(Parcel* output) const override;
@@ -189,6 +207,9 @@ public:
 
     sp<IBinder> listener;
     std::vector<TransactionStats> transactionStats;
+    // Delivered with the transaction stats so that a listener gets one call per frame, these are
+    // handled as if passed to onReleaseBuffer, before the transaction callbacks.
+    std::vector<ReleasedBufferStats> releasedBuffers;
 };
 
 class ITransactionCompletedListener : public IInterface {
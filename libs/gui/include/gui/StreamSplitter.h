@@ -25,6 +25,8 @@
 #include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
 
+#include <vector>
+
 namespace android {
 
 class GraphicBuffer;
@@ -39,6 +41,17 @@ class IGraphicBufferProducer;
 // again only once all of the outputs have released it.
 class StreamSplitter : public BnConsumerListener {
 public:
+    // OutputPolicy determines what happens to a buffer queued to the input while
+    // an output still holds MAX_OUTSTANDING_BUFFERS buffers.
+    enum class OutputPolicy {
+        // Wait for the output to release a buffer. This applies back pressure to
+        // the input, and so stalls the other outputs as well.
+        BLOCK,
+        // Do not queue the buffer to the output, which then skips that frame.
+        // The input and the other outputs keep running at their own pace.
+        DROP,
+    };
+
     // createSplitter creates a new splitter, outSplitter, using inputQueue as
     // the input BufferQueue. Output BufferQueues must be added using addOutput
     // before queueing any buffers to the input.
@@ -57,11 +70,17 @@ public:
     // output is abandoned by its consumer, the splitter will abandon its input
     // queue (see onAbandoned).
     //
+    // The policy determines how the splitter handles the output falling behind
+    // the input (see OutputPolicy). Outputs that feed consumers which can
+    // tolerate skipped frames should use DROP so that they cannot stall the
+    // rest of the outputs.
+    //
     // A return value other than NO_ERROR means that an error has occurred and
     // outputQueue has not been added to the splitter. BAD_VALUE is returned if
     // outputQueue is NULL. See IGraphicBufferProducer::connect for explanations
     // of other error codes.
-    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue);
+    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue,
+            OutputPolicy policy = OutputPolicy::BLOCK);
 
     // setName sets the consumer name of the input queue
     void setName(const String8& name);
@@ -70,10 +89,10 @@ private:
     // From IConsumerListener
     //
     // During this callback, we store some tracking information, detach the
-    // buffer from the input, and attach it to each of the outputs. This call
-    // can block if there are too many outstanding buffers. If it blocks, it
-    // will resume when onBufferReleasedByOutput releases a buffer back to the
-    // input.
+    // buffer from the input, and attach it to each of the outputs that is not
+    // dropping it. This call can block if a BLOCK output has too many
+    // outstanding buffers. If it blocks, it will resume when that output
+    // releases one in onBufferReleasedByOutput.
     virtual void onFrameAvailable(const BufferItem& item);
 
     // From IConsumerListener
@@ -88,14 +107,16 @@ private:
 
     // This is the implementation of the onBufferReleased callback from
     // IProducerListener. It gets called from an OutputListener (see below), and
-    // 'from' is which producer interface from which the callback was received.
+    // 'outputIndex' is the index in mOutputs of the output from which the
+    // callback was received.
     //
     // During this callback, we detach the buffer from the output queue that
     // generated the callback, update our state tracking to see if this is the
-    // last output releasing the buffer, and if so, release it to the input.
-    // If we release the buffer to the input, we allow a blocked
-    // onFrameAvailable call to proceed.
-    void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
+    // last output holding the buffer, and if so, release it to the input.
+    // Since the output has one fewer outstanding buffer, we also allow a
+    // blocked onFrameAvailable call to proceed.
+    void onBufferReleasedByOutput(size_t outputIndex);
+
 
     // When this is called, the splitter disconnects from (i.e., abandons) its
     // input queue and signals any waiting onFrameAvailable calls to wake up.
@@ -106,13 +127,12 @@ private:
 
     // This is a thin wrapper class that lets us determine which BufferQueue
     // the IProducerListener::onBufferReleased callback is associated with. We
-    // create one of these per output BufferQueue, and then pass the producer
-    // into onBufferReleasedByOutput above.
+    // create one of these per output BufferQueue, and then pass the index of
+    // the output into onBufferReleasedByOutput above.
     class OutputListener : public BnProducerListener,
                            public IBinder::DeathRecipient {
     public:
-        OutputListener(const sp<StreamSplitter>& splitter,
-                const sp<IGraphicBufferProducer>& output);
+        OutputListener(const sp<StreamSplitter>& splitter, size_t outputIndex);
         virtual ~OutputListener();
 
         // From IProducerListener
@@ -123,21 +143,49 @@ private:
 
     private:
         sp<StreamSplitter> mSplitter;
-        sp<IGraphicBufferProducer> mOutput;
+        size_t mOutputIndex;
+    };
+
+    struct Output {
+        sp<IGraphicBufferProducer> queue;
+        OutputPolicy policy;
+
+        // Number of buffers queued to the output and not yet released by it
+        int outstandingBuffers;
     };
 
+    // Tracks which outputs hold a buffer that was detached from the input, so
+    // that it is returned to the input once the last of them releases it.
     class BufferTracker : public LightRefBase<BufferTracker> {
     public:
-        explicit BufferTracker(const sp<GraphicBuffer>& buffer);
+        BufferTracker(const sp<GraphicBuffer>& buffer, size_t outputCount);
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
         const sp<Fence>& getMergedFence() const { return mMergedFence; }
 
         void mergeFence(const sp<Fence>& with);
 
-        // Returns the new value
         // Only called while mMutex is held
-        size_t incrementReleaseCountLocked() { return ++mReleaseCount; }
+        void setHeldByOutputLocked(size_t outputIndex) {
+            if (!mHeldByOutput[outputIndex]) {
+                mHeldByOutput[outputIndex] = true;
+                ++mHolderCount;
+            }
+        }
+
+        // Returns whether the output held the buffer
+        // Only called while mMutex is held
+        bool releaseByOutputLocked(size_t outputIndex) {
+            if (!mHeldByOutput[outputIndex]) {
+                return false;
+            }
+            mHeldByOutput[outputIndex] = false;
+            --mHolderCount;
+            return true;
+        }
+
+        // Only called while mMutex is held
+        bool isHeldLocked() const { return mHolderCount > 0; }
 
     private:
         // Only destroy through LightRefBase
@@ -150,15 +198,28 @@ private:
 
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
         sp<Fence> mMergedFence;
-        size_t mReleaseCount;
+        std::vector<bool> mHeldByOutput;
+        size_t mHolderCount;
     };
 
+    // Attaches the buffer of the tracker to the input, releases it with the
+    // merged fence of the outputs, and stops tracking it. This must be called
+    // with mMutex locked.
+    void releaseToInputLocked(const sp<BufferTracker>& tracker);
+
+    // Returns whether a BLOCK output has MAX_OUTSTANDING_BUFFERS buffers, i.e.
+    // whether the next buffer must wait for a release. This must be called
+    // with mMutex locked.
+    bool isBlockedLocked() const;
+
     // Only called from createSplitter
     explicit StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue);
 
     // Must be accessed through RefBase
     virtual ~StreamSplitter();
 
+    // Maximum number of buffers queued to, and not yet released by, a single
+    // output
     static const int MAX_OUTSTANDING_BUFFERS = 2;
 
     // mIsAbandoned is set to true when an output dies. Once the StreamSplitter
@@ -169,12 +230,13 @@ private:
 
     Mutex mMutex;
     Condition mReleaseCondition;
-    int mOutstandingBuffers;
     sp<IGraphicBufferConsumer> mInput;
-    Vector<sp<IGraphicBufferProducer> > mOutputs;
+
+    // Outputs are never removed, so indices into this are stable
+    std::vector<Output> mOutputs;
 
     // Map of GraphicBuffer IDs (GraphicBuffer::getId()) to buffer tracking
-    // objects (which are mostly for counting how many outputs have released the
+    // objects (which are mostly for tracking which outputs still hold the
     // buffer, but also contain merged release fences).
     KeyedVector<uint64_t, sp<BufferTracker> > mBuffers;
 };
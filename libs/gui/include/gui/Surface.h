@@ -30,7 +30,11 @@
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <unordered_set>
 
 /* QTI_BEGIN */
@@ -317,6 +321,7 @@ private:
     int dispatchGetLastQueuedBuffer(va_list args);
     int dispatchGetLastQueuedBuffer2(va_list args);
     int dispatchSetFrameTimelineInfo(va_list args);
+    int dispatchSetFrameState(va_list args);
 
     std::mutex mNameMutex;
     std::string mName;
@@ -339,6 +344,7 @@ protected:
     virtual int setBuffersStickyTransform(uint32_t transform);
     virtual int setBuffersTimestamp(int64_t timestamp);
     virtual int setBuffersDataSpace(ui::Dataspace dataSpace);
+    virtual int setFrameState(const ANativeWindowFrameState& state);
     virtual int setBuffersSmpte2086Metadata(const android_smpte2086_metadata* metadata);
     virtual int setBuffersCta8613Metadata(const android_cta861_3_metadata* metadata);
     virtual int setBuffersHdr10PlusMetadata(const size_t size, const uint8_t* metadata);
@@ -408,6 +414,14 @@ public:
     virtual int queueBuffers(
             const std::vector<BatchQueuedBuffer>& buffers);
 
+    // Opt-in dequeue-ahead mode. While enabled, every successful queueBuffer starts dequeuing the
+    // next buffer on a background thread, so the following dequeueBuffer can usually be served
+    // without blocking in IGraphicBufferProducer::dequeueBuffer. The prefetched buffer counts
+    // against the producer's dequeued buffer limit while it is held. If the next dequeueBuffer
+    // asks for a different size, format or usage, the prefetched buffer is cancelled. The mode is
+    // turned off by disconnect(). It is not supported in shared buffer mode.
+    void setDequeueAheadEnabled(bool enabled);
+
 protected:
     enum { NUM_BUFFER_SLOTS = BufferQueueDefs::NUM_BUFFER_SLOTS };
     enum { DEFAULT_FORMAT = PIXEL_FORMAT_RGBA_8888 };
@@ -556,6 +570,10 @@ protected:
     // achieve an asynchronous swap interval
     bool mSwapIntervalZero;
 
+    // mAsyncMode is the async mode last set on the producer, restored after
+    // stopDequeueAhead() switches it on to interrupt a blocked prefetch.
+    bool mAsyncMode;
+
     // mConsumerRunningBehind whether the consumer is running more than
     // one buffer behind the producer.
     mutable bool mConsumerRunningBehind;
@@ -630,6 +648,11 @@ protected:
     mutable bool mQueriedSupportedTimestamps;
     mutable bool mFrameTimestampsSupportsPresent;
 
+    // The answer to NATIVE_WINDOW_QUEUES_TO_WINDOW_COMPOSER cannot change for
+    // the lifetime of mGraphicBufferProducer, so it is fetched once rather
+    // than costing a binder round trip on every query.
+    mutable std::optional<int> mQueuesToWindowComposer;
+
     // A cached copy of the FrameEventHistory maintained by the consumer.
     bool mEnableFrameTimestamps = false;
     std::unique_ptr<ProducerFrameEventHistory> mFrameEventHistory;
@@ -653,6 +676,38 @@ protected:
 
     // Buffers that are successfully dequeued/attached and handed to clients
     std::unordered_set<int> mDequeuedSlots;
+
+private:
+    struct PrefetchedBuffer {
+        IGraphicBufferProducer::DequeueBufferInput input;
+        IGraphicBufferProducer::DequeueBufferOutput output;
+    };
+
+    void dequeueAheadThreadMain();
+    // Asks the dequeue-ahead thread to prefetch a buffer for the given input, if the mode is
+    // enabled and no buffer is already prefetched or being prefetched.
+    void requestDequeueAhead(const IGraphicBufferProducer::DequeueBufferInput& input);
+    // Hands out the prefetched buffer if it was dequeued with the same input. Returns false if
+    // the caller has to dequeue from the producer itself.
+    bool takePrefetchedBuffer(const IGraphicBufferProducer::DequeueBufferInput& input,
+                              IGraphicBufferProducer::DequeueBufferOutput* output);
+    // Stops the dequeue-ahead thread and returns the buffer it was holding, if any. A prefetch
+    // that is blocked in the producer is interrupted rather than waited for.
+    std::optional<PrefetchedBuffer> stopDequeueAhead();
+    // Returns a prefetched buffer that will not be used to the producer, applying any
+    // reallocation flags it carried so the slot cache stays in sync.
+    void discardPrefetchedBufferLocked(IGraphicBufferProducer::DequeueBufferOutput& output);
+
+    // Guards the dequeue-ahead state below. May be acquired while holding mMutex, never the
+    // other way around; the dequeue-ahead thread never takes mMutex.
+    std::mutex mDequeueAheadMutex;
+    std::condition_variable mDequeueAheadCondition;
+    std::thread mDequeueAheadThread;
+    bool mDequeueAheadEnabled = false;
+    bool mDequeueAheadRequested = false;
+    bool mDequeueAheadInFlight = false;
+    IGraphicBufferProducer::DequeueBufferInput mDequeueAheadInput;
+    std::optional<PrefetchedBuffer> mPrefetchedBuffer;
 };
 
 } // namespace android
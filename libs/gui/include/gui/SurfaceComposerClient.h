@@ -345,6 +345,24 @@ public:
                                   LayerMetadata metadata = LayerMetadata(),  // metadata
                                   uint32_t* outTransformHint = nullptr);
 
+    // The arguments of createSurfaceChecked, for creating several surfaces at once.
+    struct SurfaceCreationArgs {
+        String8 name;
+        uint32_t w = 0;
+        uint32_t h = 0;
+        PixelFormat format = PIXEL_FORMAT_NONE;
+        int32_t flags = 0;
+        sp<IBinder> parentHandle;
+        LayerMetadata metadata;
+    };
+
+    // Creates a surface for each of the given arguments in a single call to SurfaceFlinger, which
+    // lowers the latency of creating many surfaces in a burst, e.g. when launching an app. Either
+    // all surfaces are created in the order of the arguments, or none are returned and the layers
+    // created before the failure are destroyed, like layers whose last handle is released.
+    status_t createSurfacesChecked(std::vector<SurfaceCreationArgs> args,
+                                   std::vector<sp<SurfaceControl>>* outSurfaces);
+
     // Creates a mirrored hierarchy for the mirrorFromSurface. This returns a SurfaceControl
     // which is a parent of the root of the mirrored hierarchy.
     //
@@ -941,6 +959,7 @@ public:
 
 private:
     ReleaseBufferCallback popReleaseBufferCallbackLocked(const ReleaseCallbackId&) REQUIRES(mMutex);
+    void releasePreviousBuffers(const TransactionStats&) EXCLUDES(mMutex);
     static sp<TransactionCompletedListener> sInstance;
 };
 
@@ -37,6 +37,23 @@ struct WindowInfosUpdate : public Parcelable {
     int64_t vsyncId;
     int64_t timestamp;
 
+    // If true, windowInfos only contains the windows that were added or changed since the update
+    // sent for baseVsyncId, and windowIds contains the ids of every window in z-order. Use
+    // applyDelta to reconstruct the complete list of windows.
+    bool isDelta = false;
+    int64_t baseVsyncId = 0;
+    std::vector<int32_t> windowIds;
+
+    // Returns a delta update that transforms baseWindowInfos, sent for baseVsyncId, into the
+    // windows of update.
+    static WindowInfosUpdate createDelta(const std::vector<WindowInfo>& baseWindowInfos,
+                                         int64_t baseVsyncId, const WindowInfosUpdate& update);
+
+    // Reconstructs the complete list of windows of a delta update from the windows of the update
+    // it is based on. Returns BAD_VALUE if the delta refers to a window missing from the base.
+    status_t applyDelta(const std::vector<WindowInfo>& baseWindowInfos,
+                        std::vector<WindowInfo>* outWindowInfos) const;
+
     status_t writeToParcel(android::Parcel*) const override;
     status_t readFromParcel(const android::Parcel*) override;
 };
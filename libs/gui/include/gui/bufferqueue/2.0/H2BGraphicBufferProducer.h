@@ -17,6 +17,7 @@
 #ifndef ANDROID_HARDWARE_GRAPHICS_BUFFERQUEUE_V2_0_H2BGRAPHICBUFFERPRODUCER_H
 #define ANDROID_HARDWARE_GRAPHICS_BUFFERQUEUE_V2_0_H2BGRAPHICBUFFERPRODUCER_H
 
+#include <gui/BufferQueueDefs.h>
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/IProducerListener.h>
 #include <hidl/HybridInterface.h>
@@ -24,6 +25,8 @@
 
 #include <android/hardware/graphics/bufferqueue/2.0/IGraphicBufferProducer.h>
 
+#include <mutex>
+
 namespace android {
 namespace hardware {
 namespace graphics {
@@ -95,6 +98,20 @@ struct H2BGraphicBufferProducer
     virtual void getFrameTimestamps(FrameEventHistoryDelta* outDelta) override;
     virtual status_t getUniqueId(uint64_t* outId) const override;
     virtual status_t getConsumerUsage(uint64_t* outUsage) const override;
+
+private:
+    void cacheBuffer(int slot, sp<GraphicBuffer> const& buffer);
+    void clearCachedBuffer(int slot);
+    void clearCachedBuffers();
+
+    // Buffers returned by requestBuffer and attachBuffer, indexed by slot.
+    // Converting a buffer from HIDL clones and imports its handle, so a repeated
+    // requestBuffer for a slot returns the cached buffer instead. An entry is
+    // dropped whenever the remote queue may have replaced the buffer in its
+    // slot: on reallocation, detach, reconnection, preallocation and changes
+    // of the generation number.
+    std::mutex mCachedBuffersMutex;
+    sp<GraphicBuffer> mCachedBuffers[BufferQueueDefs::NUM_BUFFER_SLOTS];
 };
 
 }  // namespace utils
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BatchBufferOpsBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BufferItemConsumer.h>
+#include <gui/BufferQueue.h>
+#include <gui/IProducerListener.h>
+#include <gui/Surface.h>
+
+#include <vector>
+
+namespace android {
+namespace {
+
+constexpr int kBufferCount = 16;
+
+// A BufferQueue with a Surface on the producer side and a BufferItemConsumer
+// that can drain whatever the benchmark queues. All buffers are allocated up
+// front so the timed loops only measure the BufferQueue bookkeeping.
+class BatchFixture {
+public:
+    explicit BatchFixture(size_t batchSize) {
+        sp<IGraphicBufferProducer> producer;
+        sp<IGraphicBufferConsumer> consumer;
+        BufferQueue::createBufferQueue(&producer, &consumer);
+        mConsumer = sp<BufferItemConsumer>::make(consumer, GRALLOC_USAGE_SW_READ_OFTEN,
+                                                 static_cast<int>(batchSize));
+        mSurface = sp<Surface>::make(producer);
+        mSurface->connect(NATIVE_WINDOW_API_CPU, sp<StubProducerListener>::make(),
+                          /*reportBufferRemoval*/ false);
+        native_window_set_buffer_count(mSurface.get(), kBufferCount);
+
+        std::vector<Surface::BatchBuffer> buffers(batchSize);
+        mSurface->dequeueBuffers(&buffers);
+        mSurface->cancelBuffers(buffers);
+    }
+
+    ~BatchFixture() { mSurface->disconnect(NATIVE_WINDOW_API_CPU); }
+
+    Surface& surface() { return *mSurface; }
+
+    void drain(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            BufferItem item;
+            if (mConsumer->acquireBuffer(&item, 0) != NO_ERROR) {
+                return;
+            }
+            mConsumer->releaseBuffer(item);
+        }
+    }
+
+private:
+    sp<BufferItemConsumer> mConsumer;
+    sp<Surface> mSurface;
+};
+
+void BM_dequeueCancelBatched(benchmark::State& state) {
+    const size_t batchSize = static_cast<size_t>(state.range());
+    BatchFixture fixture(batchSize);
+    std::vector<Surface::BatchBuffer> buffers(batchSize);
+    for (auto _ : state) {
+        if (fixture.surface().dequeueBuffers(&buffers) != NO_ERROR) {
+            state.SkipWithError("dequeueBuffers failed");
+            break;
+        }
+        fixture.surface().cancelBuffers(buffers);
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_dequeueCancelBatched)->Arg(1)->Arg(4)->Arg(8);
+
+void BM_dequeueCancelSingle(benchmark::State& state) {
+    const size_t batchSize = static_cast<size_t>(state.range());
+    BatchFixture fixture(batchSize);
+    ANativeWindow* window = &fixture.surface();
+    std::vector<Surface::BatchBuffer> buffers(batchSize);
+    for (auto _ : state) {
+        for (auto& buffer : buffers) {
+            window->dequeueBuffer(window, &buffer.buffer, &buffer.fenceFd);
+        }
+        for (auto& buffer : buffers) {
+            window->cancelBuffer(window, buffer.buffer, buffer.fenceFd);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_dequeueCancelSingle)->Arg(1)->Arg(4)->Arg(8);
+
+void BM_dequeueQueueBatched(benchmark::State& state) {
+    const size_t batchSize = static_cast<size_t>(state.range());
+    BatchFixture fixture(batchSize);
+    std::vector<Surface::BatchBuffer> buffers(batchSize);
+    std::vector<Surface::BatchQueuedBuffer> queuedBuffers(batchSize);
+    for (auto _ : state) {
+        if (fixture.surface().dequeueBuffers(&buffers) != NO_ERROR) {
+            state.SkipWithError("dequeueBuffers failed");
+            break;
+        }
+        for (size_t i = 0; i < batchSize; i++) {
+            queuedBuffers[i].buffer = buffers[i].buffer;
+            queuedBuffers[i].fenceFd = buffers[i].fenceFd;
+        }
+        fixture.surface().queueBuffers(queuedBuffers);
+        fixture.drain(batchSize);
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_dequeueQueueBatched)->Arg(1)->Arg(4)->Arg(8);
+
+void BM_dequeueQueueSingle(benchmark::State& state) {
+    const size_t batchSize = static_cast<size_t>(state.range());
+    BatchFixture fixture(batchSize);
+    ANativeWindow* window = &fixture.surface();
+    std::vector<Surface::BatchBuffer> buffers(batchSize);
+    for (auto _ : state) {
+        for (auto& buffer : buffers) {
+            window->dequeueBuffer(window, &buffer.buffer, &buffer.fenceFd);
+        }
+        for (auto& buffer : buffers) {
+            window->queueBuffer(window, buffer.buffer, buffer.fenceFd);
+        }
+        fixture.drain(batchSize);
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_dequeueQueueSingle)->Arg(1)->Arg(4)->Arg(8);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -21,6 +21,7 @@
 
 #include <gui/BufferItem.h>
 #include <gui/BufferQueue.h>
+#include <gui/BufferQueueConsumer.h>
 #include <gui/IProducerListener.h>
 
 #include <ui/GraphicBuffer.h>
@@ -1224,4 +1225,93 @@ TEST_F(BufferQueueTest, TestProducerConnectDisconnect) {
     ASSERT_EQ(NO_INIT, mProducer->disconnect(NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(BufferQueueTest, AdaptiveBufferCountGrowsWhenBlockedAndShrinksWhenIdle) {
+    createBufferQueue();
+    sp<MockConsumer> mc(new MockConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(mc, false));
+    static_cast<BufferQueueConsumer*>(mConsumer.get())->setAdaptiveBufferCountEnabled(true);
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+              mProducer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false, &output));
+    // With a zero timeout a dequeue that would block fails right away.
+    ASSERT_EQ(OK, mProducer->setDequeueTimeout(0));
+
+    IGraphicBufferProducer::QueueBufferInput input(0ull, true, HAL_DATASPACE_UNKNOWN,
+                                                   Rect::INVALID_RECT,
+                                                   NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                   Fence::NO_FENCE);
+    auto dequeueAndQueue = [&]() {
+        int slot = BufferQueue::INVALID_BUFFER_SLOT;
+        sp<Fence> fence;
+        status_t result = mProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, 0, nullptr, nullptr);
+        if (result < 0) {
+            return result;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            EXPECT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+        }
+        return mProducer->queueBuffer(slot, input, &output);
+    };
+    auto acquireAndRelease = [&]() {
+        BufferItem item;
+        ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 0));
+        ASSERT_EQ(OK,
+                  mConsumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                           EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+    };
+
+    // Double buffering: two queued buffers and nothing left to dequeue.
+    ASSERT_EQ(OK, dequeueAndQueue());
+    ASSERT_EQ(OK, dequeueAndQueue());
+    ASSERT_EQ(TIMED_OUT, dequeueAndQueue());
+    ASSERT_EQ(TIMED_OUT, dequeueAndQueue());
+
+    // The third blocked dequeue gets a third buffer instead of waiting.
+    ASSERT_EQ(OK, dequeueAndQueue());
+    ASSERT_EQ(TIMED_OUT, dequeueAndQueue());
+
+    // Once the consumer keeps up, the extra buffer is taken back.
+    for (int i = 0; i < 3; i++) {
+        acquireAndRelease();
+    }
+    for (int i = 0; i < 300; i++) {
+        ASSERT_EQ(OK, dequeueAndQueue());
+        acquireAndRelease();
+    }
+    ASSERT_EQ(OK, dequeueAndQueue());
+    ASSERT_EQ(OK, dequeueAndQueue());
+    ASSERT_EQ(TIMED_OUT, dequeueAndQueue());
+}
+
+TEST(BufferQueueSlotSetTest, BehavesLikeOrderedSet) {
+    BufferQueueDefs::SlotSet slots;
+    EXPECT_TRUE(slots.empty());
+
+    slots.insert(BufferQueueDefs::NUM_BUFFER_SLOTS - 1);
+    slots.insert(5);
+    slots.insert(0);
+    slots.insert(5);
+    EXPECT_EQ(3u, slots.size());
+    EXPECT_EQ(1u, slots.count(5));
+    EXPECT_EQ(0u, slots.count(6));
+    EXPECT_EQ(0, *slots.begin());
+
+    std::vector<int> visited;
+    for (int slot : slots) {
+        visited.push_back(slot);
+    }
+    EXPECT_EQ((std::vector<int>{0, 5, BufferQueueDefs::NUM_BUFFER_SLOTS - 1}), visited);
+
+    slots.erase(slots.begin());
+    EXPECT_EQ(5, *slots.begin());
+    EXPECT_EQ(1u, slots.erase(5));
+    EXPECT_EQ(0u, slots.erase(5));
+    EXPECT_EQ(BufferQueueDefs::NUM_BUFFER_SLOTS - 1, *slots.begin());
+
+    slots.clear();
+    EXPECT_TRUE(slots.empty());
+    EXPECT_EQ(slots.begin(), slots.end());
+}
+
 } // namespace android
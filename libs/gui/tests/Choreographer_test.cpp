@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gui/Choreographer.h>
+#include <utils/Looper.h>
+#include <utils/Timers.h>
+
+#include <thread>
+
+namespace android {
+namespace test {
+
+namespace {
+
+struct ThreadChoreographer {
+    bool hasOwnConnection = false;
+    bool receivedFrame = false;
+    wp<Choreographer> choreographer;
+};
+
+// Creates the Choreographer of a new thread, and waits on that thread for one frame callback.
+ThreadChoreographer runChoreographerThread() {
+    ThreadChoreographer result;
+    std::thread([&result] {
+        Looper::prepare(0);
+        Choreographer* choreographer = Choreographer::getForThread();
+        if (choreographer == nullptr) return;
+
+        result.hasOwnConnection = choreographer->getFd() >= 0;
+        result.choreographer = choreographer;
+
+        bool receivedFrame = false;
+        choreographer->postFrameCallbackDelayed(
+                nullptr,
+                [](int64_t, void* data) { *static_cast<bool*>(data) = true; }, nullptr,
+                &receivedFrame, 0);
+        const nsecs_t deadline = systemTime() + s2ns(1);
+        while (!receivedFrame && systemTime() < deadline) {
+            Looper::getForThread()->pollOnce(100);
+        }
+        result.receivedFrame = receivedFrame;
+    }).join();
+    return result;
+}
+
+} // namespace
+
+TEST(ChoreographerTest, LaterThreadsShareVsyncConnection) {
+    const ThreadChoreographer first = runChoreographerThread();
+    ASSERT_TRUE(first.receivedFrame);
+
+    // Whichever thread came first, this one is not the first thread of the process.
+    const ThreadChoreographer second = runChoreographerThread();
+    ASSERT_TRUE(second.receivedFrame);
+    EXPECT_FALSE(second.hasOwnConnection);
+}
+
+TEST(ChoreographerTest, SharedVsyncChoreographerGoesAwayWithThread) {
+    runChoreographerThread();
+    const ThreadChoreographer thread = runChoreographerThread();
+    ASSERT_TRUE(thread.receivedFrame);
+    ASSERT_FALSE(thread.hasOwnConnection);
+
+    // The shared source may briefly hold the Choreographer while handing over the last vsync.
+    const nsecs_t deadline = systemTime() + s2ns(1);
+    while (thread.choreographer.promote() != nullptr && systemTime() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(nullptr, thread.choreographer.promote());
+}
+
+TEST(ChoreographerTest, FrameTimelineStatsCountFramesPastDeadline) {
+    constexpr int kFrames = 3;
+    Choreographer::FrameTimelineStats stats;
+    bool receivedFrames = false;
+    std::thread([&stats, &receivedFrames] {
+        Looper::prepare(0);
+        Choreographer* choreographer = Choreographer::getForThread();
+        if (choreographer == nullptr) return;
+
+        // The first frame overruns the deadline of its preferred timeline, the others return
+        // right away.
+        int frames = 0;
+        const nsecs_t deadline = systemTime() + s2ns(1);
+        while (frames < kFrames && systemTime() < deadline) {
+            const int posted = frames;
+            choreographer->postFrameCallbackDelayed(
+                    nullptr, nullptr,
+                    [](const AChoreographerFrameCallbackData* data, void* counter) {
+                        int& count = *static_cast<int*>(counter);
+                        if (count++ == 0) {
+                            const auto* impl =
+                                    reinterpret_cast<const ChoreographerFrameCallbackDataImpl*>(
+                                            data);
+                            const nsecs_t delay =
+                                    impl->vsyncEventData.preferredDeadlineTimestamp() -
+                                    systemTime(SYSTEM_TIME_MONOTONIC);
+                            if (delay >= 0) {
+                                std::this_thread::sleep_for(
+                                        std::chrono::nanoseconds(delay + ms2ns(1)));
+                            }
+                        }
+                    },
+                    &frames, 0);
+            while (frames == posted && systemTime() < deadline) {
+                Looper::getForThread()->pollOnce(100);
+            }
+        }
+        receivedFrames = frames == kFrames;
+        stats = choreographer->getFrameTimelineStats();
+    }).join();
+    ASSERT_TRUE(receivedFrames);
+
+    EXPECT_EQ(static_cast<size_t>(kFrames), stats.framesDispatched);
+    EXPECT_GE(stats.framesPastDeadline, 1u);
+    EXPECT_LE(stats.framesPastDeadline, stats.framesDispatched);
+    EXPECT_LE(stats.maxPredictionDrift, stats.totalPredictionDrift);
+}
+
+} // namespace test
+} // namespace android
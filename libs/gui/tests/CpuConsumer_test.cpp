@@ -682,6 +682,69 @@ TEST_P(CpuConsumerTest, FromCpuLockMax) {
     }
 }
 
+TEST_P(CpuConsumerTest, FromCpuLockBatch) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    // Set up
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, params.maxLockedBuffers + 1));
+
+    // Produce
+
+    const int64_t time = 1234L;
+    uint32_t stride;
+
+    for (int i = 0; i < params.maxLockedBuffers + 1; i++) {
+        ALOGD("Producing frame %d", i);
+        ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, time,
+                        &stride));
+    }
+
+    // Consume
+
+    ALOGD("Locking a batch of frames");
+    std::vector<CpuConsumer::LockedBuffer> b(params.maxLockedBuffers + 1);
+    size_t count = 0;
+    err = mCC->lockNextBuffers(b.data(), b.size(), &count);
+    ASSERT_NO_ERROR(err, "lockNextBuffers error: ");
+    ASSERT_EQ(static_cast<size_t>(params.maxLockedBuffers), count)
+            << "Batch should stop at the maximum number of locked buffers";
+
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_TRUE(b[i].data != nullptr);
+        EXPECT_EQ(params.width,  b[i].width);
+        EXPECT_EQ(params.height, b[i].height);
+        EXPECT_EQ(params.format, b[i].format);
+        EXPECT_EQ(stride, b[i].stride);
+        EXPECT_EQ(time, b[i].timestamp);
+
+        checkAnyBuffer(b[i], GetParam().format);
+    }
+
+    ALOGD("Locking a batch of frames (too many)");
+    size_t countTooMuch = 0;
+    err = mCC->lockNextBuffers(&b[count], 1, &countTooMuch);
+    ASSERT_TRUE(err == NOT_ENOUGH_DATA) << "Allowing too many locks";
+    EXPECT_EQ(0u, countTooMuch);
+
+    for (size_t i = 0; i < count; i++) {
+        err = mCC->unlockBuffer(b[i]);
+        ASSERT_NO_ERROR(err, "Could not unlock buffer: ");
+    }
+
+    ALOGD("Locking a batch of frames (only one left)");
+    err = mCC->lockNextBuffers(b.data(), b.size(), &count);
+    ASSERT_NO_ERROR(err, "lockNextBuffers error: ");
+    ASSERT_EQ(1u, count);
+    mCC->unlockBuffer(b[0]);
+
+    ALOGD("Locking a batch of frames (no more available)");
+    err = mCC->lockNextBuffers(b.data(), b.size(), &count);
+    ASSERT_EQ(BAD_VALUE, err) << "Not out of buffers somehow";
+    EXPECT_EQ(0u, count);
+}
+
 TEST_P(CpuConsumerTest, FromCpuInvalid) {
     status_t err = mCC->lockNextBuffer(nullptr);
     ASSERT_EQ(BAD_VALUE, err) << "lockNextBuffer did not fail";
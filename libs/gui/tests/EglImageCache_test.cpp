@@ -0,0 +1,104 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "EglImageCache_test"
+
+#include <gtest/gtest.h>
+#include <gui/EglImageCache.h>
+
+namespace android {
+
+namespace {
+
+class FakeImage : public LightRefBase<FakeImage> {
+public:
+    explicit FakeImage(sp<GraphicBuffer> buffer) : mGraphicBuffer(std::move(buffer)) {}
+    const sp<GraphicBuffer>& graphicBuffer() { return mGraphicBuffer; }
+
+private:
+    sp<GraphicBuffer> mGraphicBuffer;
+};
+
+sp<FakeImage> makeImage() {
+    return sp<FakeImage>::make(sp<GraphicBuffer>::make(64u, 64u, PIXEL_FORMAT_RGBA_8888, 1u,
+                                                       GraphicBuffer::USAGE_HW_TEXTURE,
+                                                       "EglImageCache_test"));
+}
+
+} // namespace
+
+TEST(EglImageCacheTest, ReturnsCachedImageOfBuffer) {
+    EglImageCache<FakeImage> cache;
+    const sp<FakeImage> image = makeImage();
+    const sp<FakeImage> other = makeImage();
+
+    cache.add(image);
+    cache.add(other);
+    EXPECT_EQ(image, cache.take(image->graphicBuffer()));
+    EXPECT_EQ(1u, cache.size());
+
+    // The image left the cache with the first take.
+    EXPECT_EQ(nullptr, cache.take(image->graphicBuffer()));
+}
+
+TEST(EglImageCacheTest, EvictsLeastRecentlyCachedImagesOverMemoryBound) {
+    const sp<FakeImage> first = makeImage();
+    const sp<FakeImage> second = makeImage();
+    const sp<FakeImage> third = makeImage();
+    const size_t bytes = EglImageCache<FakeImage>::estimateBufferBytes(first->graphicBuffer());
+    EglImageCache<FakeImage> cache(2 * bytes);
+
+    cache.add(first);
+    cache.add(second);
+    cache.add(third);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(2 * bytes, cache.bytes());
+    EXPECT_EQ(nullptr, cache.take(first->graphicBuffer()));
+    EXPECT_EQ(second, cache.take(second->graphicBuffer()));
+    EXPECT_EQ(third, cache.take(third->graphicBuffer()));
+    EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(EglImageCacheTest, EvictsImagesAfterMaxAgeAcquires) {
+    EglImageCache<FakeImage> cache(EglImageCache<FakeImage>::kDefaultMaxBytes, /*maxAge=*/2);
+    const sp<FakeImage> image = makeImage();
+
+    cache.add(image);
+    cache.onBufferAcquired();
+    cache.onBufferAcquired();
+    EXPECT_EQ(1u, cache.size());
+
+    cache.onBufferAcquired();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(nullptr, cache.take(image->graphicBuffer()));
+}
+
+TEST(EglImageCacheTest, ClearReleasesBuffers) {
+    EglImageCache<FakeImage> cache;
+    wp<GraphicBuffer> buffer;
+    {
+        const sp<FakeImage> image = makeImage();
+        buffer = image->graphicBuffer();
+        cache.add(image);
+    }
+    EXPECT_NE(nullptr, buffer.promote());
+
+    cache.clear();
+    EXPECT_EQ(nullptr, buffer.promote());
+    EXPECT_EQ(0u, cache.bytes());
+}
+
+} // namespace android
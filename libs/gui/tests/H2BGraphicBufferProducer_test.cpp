@@ -0,0 +1,152 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockConsumer.h"
+
+#include <gtest/gtest.h>
+
+#include <gui/BufferQueueConsumer.h>
+#include <gui/BufferQueueCore.h>
+#include <gui/BufferQueueProducer.h>
+#include <gui/bufferqueue/2.0/B2HGraphicBufferProducer.h>
+#include <gui/bufferqueue/2.0/H2BGraphicBufferProducer.h>
+#include <system/window.h>
+#include <ui/GraphicBuffer.h>
+
+namespace android {
+namespace test {
+
+using H2BGraphicBufferProducer =
+        ::android::hardware::graphics::bufferqueue::V2_0::utils::H2BGraphicBufferProducer;
+using B2HGraphicBufferProducer =
+        ::android::hardware::graphics::bufferqueue::V2_0::utils::B2HGraphicBufferProducer;
+
+namespace {
+
+// Reports the reallocation of a dequeued buffer with other flags, so that a test can tell which
+// flag or call dropped the buffer cached by the H2B wrapper.
+class ReportingProducer : public BufferQueueProducer {
+public:
+    explicit ReportingProducer(const sp<BufferQueueCore>& core) : BufferQueueProducer(core) {}
+
+    void reportReallocationAs(int flags) { mReallocationFlags = flags; }
+
+    status_t dequeueBuffer(int* slot, sp<Fence>* fence, uint32_t width, uint32_t height,
+                           PixelFormat format, uint64_t usage, uint64_t* outBufferAge,
+                           FrameEventHistoryDelta* outTimestamps) override {
+        status_t result =
+                BufferQueueProducer::dequeueBuffer(slot, fence, width, height, format, usage,
+                                                   outBufferAge, outTimestamps);
+        if (result >= 0 && (result & BUFFER_NEEDS_REALLOCATION)) {
+            result = (result & ~BUFFER_NEEDS_REALLOCATION) | mReallocationFlags;
+        }
+        return result;
+    }
+
+private:
+    int mReallocationFlags = BUFFER_NEEDS_REALLOCATION;
+};
+
+} // namespace
+
+class H2BGraphicBufferProducerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sp<BufferQueueCore> core = sp<BufferQueueCore>::make();
+        mBase = sp<ReportingProducer>::make(core);
+        mConsumer = sp<BufferQueueConsumer>::make(core);
+        mProducer = sp<H2BGraphicBufferProducer>::make(
+                sp<B2HGraphicBufferProducer>::make(mBase));
+
+        ASSERT_EQ(OK, mConsumer->consumerConnect(sp<MockConsumer>::make(), false));
+        IGraphicBufferProducer::QueueBufferOutput output;
+        ASSERT_EQ(OK, mProducer->connect(nullptr, NATIVE_WINDOW_API_CPU, false, &output));
+    }
+
+    status_t dequeueBuffer(uint32_t size, int* slot) {
+        sp<Fence> fence;
+        return mProducer->dequeueBuffer(slot, &fence, size, size, HAL_PIXEL_FORMAT_RGBA_8888, 0,
+                                        nullptr, nullptr);
+    }
+
+    // Dequeues a buffer of the given size, requests it and gives it back.
+    sp<GraphicBuffer> requestAndCancelBuffer(uint32_t size, int* slot) {
+        sp<GraphicBuffer> buffer;
+        EXPECT_LE(0, dequeueBuffer(size, slot));
+        EXPECT_EQ(OK, mProducer->requestBuffer(*slot, &buffer));
+        EXPECT_EQ(OK, mProducer->cancelBuffer(*slot, Fence::NO_FENCE));
+        return buffer;
+    }
+
+    sp<ReportingProducer> mBase;
+    sp<BufferQueueConsumer> mConsumer;
+    sp<IGraphicBufferProducer> mProducer;
+};
+
+TEST_F(H2BGraphicBufferProducerTest, RepeatedRequestReturnsCachedBuffer) {
+    int slot;
+    ASSERT_LE(0, dequeueBuffer(1, &slot));
+    sp<GraphicBuffer> first;
+    sp<GraphicBuffer> second;
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &first));
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &second));
+    EXPECT_EQ(first, second);
+}
+
+TEST_F(H2BGraphicBufferProducerTest, RequestAfterReallocationReturnsNewBuffer) {
+    int slot;
+    const sp<GraphicBuffer> oldBuffer = requestAndCancelBuffer(1, &slot);
+    ASSERT_NE(nullptr, oldBuffer);
+
+    int newSlot;
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION, dequeueBuffer(2, &newSlot));
+    ASSERT_EQ(slot, newSlot);
+    sp<GraphicBuffer> buffer;
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    EXPECT_EQ(2u, buffer->getWidth());
+}
+
+TEST_F(H2BGraphicBufferProducerTest, RequestAfterReleaseAllBuffersReturnsNewBuffer) {
+    int slot;
+    ASSERT_NE(nullptr, requestAndCancelBuffer(1, &slot));
+
+    mBase->reportReallocationAs(IGraphicBufferProducer::RELEASE_ALL_BUFFERS);
+    int newSlot;
+    ASSERT_EQ(IGraphicBufferProducer::RELEASE_ALL_BUFFERS, dequeueBuffer(2, &newSlot));
+    ASSERT_EQ(slot, newSlot);
+    sp<GraphicBuffer> buffer;
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    EXPECT_EQ(2u, buffer->getWidth());
+}
+
+TEST_F(H2BGraphicBufferProducerTest, RequestAfterDetachReturnsNewBuffer) {
+    int slot;
+    ASSERT_LE(0, dequeueBuffer(1, &slot));
+    sp<GraphicBuffer> buffer;
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    ASSERT_EQ(OK, mProducer->detachBuffer(slot));
+
+    // Only the detach can have dropped the cached buffer.
+    mBase->reportReallocationAs(0);
+    int newSlot;
+    ASSERT_EQ(OK, dequeueBuffer(2, &newSlot));
+    ASSERT_EQ(slot, newSlot);
+    ASSERT_EQ(OK, mProducer->requestBuffer(slot, &buffer));
+    EXPECT_EQ(2u, buffer->getWidth());
+}
+
+} // namespace test
+} // namespace android
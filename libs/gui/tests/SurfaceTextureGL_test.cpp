@@ -734,4 +734,25 @@ TEST_F(SurfaceTextureGLTest, InvalidWidthOrHeightFails) {
     ASSERT_NE(NO_ERROR, mST->updateTexImage());
 }
 
+TEST_F(SurfaceTextureGLTest, DiscardFreeBuffersDoesNotCacheEglImages) {
+    ASSERT_EQ(NO_ERROR, native_window_api_connect(mANW.get(),
+            NATIVE_WINDOW_API_CPU));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_format(mANW.get(),
+            HAL_PIXEL_FORMAT_RGBA_8888));
+    ASSERT_EQ(NO_ERROR, native_window_set_usage(mANW.get(),
+            GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN));
+
+    // Latching the second frame releases the buffer of the first one, which
+    // discardFreeBuffers then frees.
+    ASSERT_NO_FATAL_FAILURE(produceOneRGBA8Frame(mANW));
+    ASSERT_EQ(NO_ERROR, mST->updateTexImage());
+    ASSERT_NO_FATAL_FAILURE(produceOneRGBA8Frame(mANW));
+    ASSERT_EQ(NO_ERROR, mST->updateTexImage());
+    ASSERT_EQ(NO_ERROR, mST->discardFreeBuffers());
+
+    String8 dump;
+    mST->dumpState(dump);
+    EXPECT_NE(nullptr, strstr(dump.c_str(), "EGLImage cache: 0 images"));
+}
+
 } // namespace android
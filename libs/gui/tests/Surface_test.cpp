@@ -999,7 +999,7 @@ public:
 
     binder::Status addWindowInfosListener(
             const sp<gui::IWindowInfosListener>& /*windowInfosListener*/,
-            gui::WindowInfosListenerInfo* /*outInfo*/) override {
+            bool /*supportsDeltaUpdates*/, gui::WindowInfosListenerInfo* /*outInfo*/) override {
         return binder::Status::ok();
     }
 
@@ -2235,4 +2235,153 @@ TEST_F(SurfaceTest, BatchIllegalOperations) {
     ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(SurfaceTest, DequeueAheadServesNextDequeue) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<BufferItemConsumer> itemConsumer =
+            new BufferItemConsumer(consumer, GRALLOC_USAGE_SW_READ_OFTEN, 1);
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, new StubProducerListener(), false));
+    surface->setDequeueAheadEnabled(true);
+
+    for (int frame = 0; frame < 4; frame++) {
+        ANativeWindowBuffer* buffer;
+        int fence;
+        ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+        ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+
+        BufferItem item;
+        ASSERT_EQ(NO_ERROR, itemConsumer->acquireBuffer(&item, 0));
+        ASSERT_EQ(NO_ERROR, itemConsumer->releaseBuffer(item));
+    }
+
+    // Changing the requested size must not hand out the buffer prefetched for the old size.
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(window.get(), 64, 32));
+    ANativeWindowBuffer* buffer;
+    int fence;
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    EXPECT_EQ(64, buffer->width);
+    EXPECT_EQ(32, buffer->height);
+    ASSERT_EQ(NO_ERROR, window->cancelBuffer(window.get(), buffer, fence));
+
+    surface->setDequeueAheadEnabled(false);
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
+TEST_F(SurfaceTest, DisablingDequeueAheadInterruptsBlockedPrefetch) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<BufferItemConsumer> itemConsumer =
+            new BufferItemConsumer(consumer, GRALLOC_USAGE_SW_READ_OFTEN, 1);
+    ASSERT_EQ(NO_ERROR, producer->setMaxDequeuedBufferCount(1));
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, new StubProducerListener(), false));
+    surface->setDequeueAheadEnabled(true);
+
+    // The consumer holds the first buffer and the second one stays queued, so the prefetch
+    // started by the second queue has no free slot to wait for.
+    ANativeWindowBuffer* buffer;
+    int fence;
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+    BufferItem item;
+    ASSERT_EQ(NO_ERROR, itemConsumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+
+    surface->setDequeueAheadEnabled(false);
+
+    // The prefetched buffer went back to the queue, which keeps working as before.
+    ASSERT_EQ(NO_ERROR, itemConsumer->releaseBuffer(item));
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    ASSERT_EQ(NO_ERROR, window->cancelBuffer(window.get(), buffer, fence));
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
+TEST_F(SurfaceTest, FrameStateAppliesToNextQueuedBuffer) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<BufferItemConsumer> itemConsumer =
+            new BufferItemConsumer(consumer, GRALLOC_USAGE_SW_READ_OFTEN, 1);
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, new StubProducerListener(), false));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(window.get(), 64, 32));
+
+    ANativeWindowFrameState state = {};
+    state.fields = ANATIVEWINDOW_FRAME_STATE_DATASPACE | ANATIVEWINDOW_FRAME_STATE_CROP |
+            ANATIVEWINDOW_FRAME_STATE_TRANSFORM;
+    state.dataSpace = HAL_DATASPACE_DISPLAY_P3;
+    state.crop = {.left = 0, .top = 0, .right = 32, .bottom = 16};
+    state.transform = NATIVE_WINDOW_TRANSFORM_ROT_90;
+    ASSERT_EQ(NO_ERROR, ANativeWindow_setFrameState(window.get(), &state));
+
+    ANativeWindowBuffer* buffer;
+    int fence;
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+
+    BufferItem item;
+    ASSERT_EQ(NO_ERROR, itemConsumer->acquireBuffer(&item, 0));
+    EXPECT_EQ(HAL_DATASPACE_DISPLAY_P3, item.mDataSpace);
+    EXPECT_EQ(Rect(0, 0, 32, 16), item.mCrop);
+    EXPECT_EQ(static_cast<uint32_t>(NATIVE_WINDOW_TRANSFORM_ROT_90), item.mTransform);
+    ASSERT_EQ(NO_ERROR, itemConsumer->releaseBuffer(item));
+
+    // Unknown fields are rejected.
+    state.fields = 1u << 31;
+    EXPECT_EQ(-EINVAL, ANativeWindow_setFrameState(window.get(), &state));
+
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
+TEST_F(SurfaceTest, FrameStateGoesThroughVirtualSetters) {
+    class RecordingSurface : public Surface {
+    public:
+        explicit RecordingSurface(const sp<IGraphicBufferProducer>& producer)
+              : Surface(producer) {}
+
+        int setBuffersDataSpace(ui::Dataspace dataSpace) override {
+            mDataSpaceCalls++;
+            return Surface::setBuffersDataSpace(dataSpace);
+        }
+        int setCrop(Rect const* rect) override {
+            mCropCalls++;
+            return Surface::setCrop(rect);
+        }
+        int setBuffersTransform(uint32_t transform) override {
+            mTransformCalls++;
+            return Surface::setBuffersTransform(transform);
+        }
+
+        int mDataSpaceCalls = 0;
+        int mCropCalls = 0;
+        int mTransformCalls = 0;
+    };
+
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    sp<RecordingSurface> surface = new RecordingSurface(producer);
+    sp<ANativeWindow> window(surface);
+
+    ANativeWindowFrameState state = {};
+    state.fields = ANATIVEWINDOW_FRAME_STATE_DATASPACE | ANATIVEWINDOW_FRAME_STATE_CROP;
+    state.dataSpace = HAL_DATASPACE_DISPLAY_P3;
+    state.crop = {.left = 0, .top = 0, .right = 32, .bottom = 16};
+    ASSERT_EQ(NO_ERROR, ANativeWindow_setFrameState(window.get(), &state));
+
+    EXPECT_EQ(1, surface->mDataSpaceCalls);
+    EXPECT_EQ(1, surface->mCropCalls);
+    EXPECT_EQ(0, surface->mTransformCalls);
+}
+
 } // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionBuildBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <allocationcounter/AllocationCounter.h>
+#include <binder/Binder.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+
+#include <vector>
+
+namespace android {
+namespace {
+
+// SurfaceControls that are never sent to SurfaceFlinger, so that the benchmarks only measure
+// the client side cost of building a transaction.
+std::vector<sp<SurfaceControl>> makeLayers(size_t count) {
+    std::vector<sp<SurfaceControl>> layers;
+    layers.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        layers.push_back(sp<SurfaceControl>::make(nullptr, sp<BBinder>::make(),
+                                                  static_cast<int32_t>(i), "benchmark"));
+    }
+    return layers;
+}
+
+void buildTransaction(SurfaceComposerClient::Transaction& t,
+                      const std::vector<sp<SurfaceControl>>& layers, float offset) {
+    for (const auto& layer : layers) {
+        t.setPosition(layer, offset, offset);
+        t.setAlpha(layer, 0.5f);
+        t.setCornerRadius(layer, 4.0f);
+    }
+}
+
+void reportAllocations(benchmark::State& state, size_t allocations) {
+    state.counters["allocs/txn"] =
+            benchmark::Counter(static_cast<double>(allocations),
+                               benchmark::Counter::kAvgIterations);
+}
+
+// A fresh Transaction per frame, the way most animation code uses the API.
+void BM_buildFreshTransaction(benchmark::State& state) {
+    const auto layers = makeLayers(static_cast<size_t>(state.range()));
+    size_t allocations = 0;
+    float offset = 0;
+    for (auto _ : state) {
+        const size_t before = getProcessAllocationCount();
+        {
+            SurfaceComposerClient::Transaction t;
+            buildTransaction(t, layers, offset++);
+            benchmark::DoNotOptimize(t);
+        }
+        allocations += getProcessAllocationCount() - before;
+    }
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_buildFreshTransaction)->Arg(1)->Arg(16)->Arg(64);
+
+// One Transaction cleared and rebuilt every frame, which keeps its hash table buckets.
+void BM_buildReusedTransaction(benchmark::State& state) {
+    const auto layers = makeLayers(static_cast<size_t>(state.range()));
+    SurfaceComposerClient::Transaction t;
+    size_t allocations = 0;
+    float offset = 0;
+    for (auto _ : state) {
+        const size_t before = getProcessAllocationCount();
+        buildTransaction(t, layers, offset++);
+        t.clear();
+        allocations += getProcessAllocationCount() - before;
+    }
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_buildReusedTransaction)->Arg(1)->Arg(16)->Arg(64);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
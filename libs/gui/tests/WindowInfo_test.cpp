@@ -20,6 +20,7 @@
 #include <binder/Parcel.h>
 
 #include <gui/WindowInfo.h>
+#include <gui/WindowInfosUpdate.h>
 
 using std::chrono_literals::operator""s;
 
@@ -28,6 +29,7 @@ namespace android {
 using gui::InputApplicationInfo;
 using gui::TouchOcclusionMode;
 using gui::WindowInfo;
+using gui::WindowInfosUpdate;
 
 namespace test {
 
@@ -119,5 +121,45 @@ TEST(InputApplicationInfo, Parcelling) {
     ASSERT_EQ(i, i2);
 }
 
+TEST(WindowInfosUpdate, DeltaParcellingAndApply) {
+    std::vector<WindowInfo> base(3);
+    for (int32_t i = 0; i < 3; i++) {
+        base[i].id = i;
+        base[i].name = "window" + std::to_string(i);
+    }
+
+    // Drop window 0, change window 2 and add window 3 in front.
+    WindowInfosUpdate update{{}, {}, /*vsyncId=*/2, /*timestamp=*/0};
+    update.windowInfos.resize(3);
+    update.windowInfos[0].id = 3;
+    update.windowInfos[1] = base[1];
+    update.windowInfos[2] = base[2];
+    update.windowInfos[2].alpha = 0.5f;
+
+    WindowInfosUpdate delta = WindowInfosUpdate::createDelta(base, /*baseVsyncId=*/1, update);
+    ASSERT_TRUE(delta.isDelta);
+    ASSERT_EQ(1, delta.baseVsyncId);
+    ASSERT_EQ((std::vector<int32_t>{3, 1, 2}), delta.windowIds);
+    ASSERT_EQ(2u, delta.windowInfos.size());
+
+    Parcel p;
+    ASSERT_EQ(OK, delta.writeToParcel(&p));
+    p.setDataPosition(0);
+    WindowInfosUpdate delta2;
+    ASSERT_EQ(OK, delta2.readFromParcel(&p));
+    ASSERT_TRUE(delta2.isDelta);
+    ASSERT_EQ(delta.baseVsyncId, delta2.baseVsyncId);
+    ASSERT_EQ(delta.windowIds, delta2.windowIds);
+
+    std::vector<WindowInfo> windowInfos;
+    ASSERT_EQ(OK, delta2.applyDelta(base, &windowInfos));
+    ASSERT_EQ(update.windowInfos, windowInfos);
+
+    // A delta can't be applied to a base that is missing an unchanged window.
+    base.pop_back();
+    base.erase(base.begin() + 1);
+    ASSERT_EQ(BAD_VALUE, delta2.applyDelta(base, &windowInfos));
+}
+
 } // namespace test
 } // namespace android
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace android {
+
+// Identifies the version of a file on disk, so that a map cached from it is dropped when the file
+// is replaced (e.g. pushed over adb while iterating on a layout).
+struct FileStamp {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    int64_t mtimeNs;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+// Returns the stamp of the file, or nullopt if it cannot be stat'ed.
+std::optional<FileStamp> stampFile(const std::string& filename);
+
+} // namespace android
@@ -587,6 +587,11 @@ void MotionEvent::addSample(
                                 &pointerCoords[getPointerCount()]);
 }
 
+void MotionEvent::reserveSamples(size_t sampleCount) {
+    mSampleEventTimes.reserve(sampleCount);
+    mSamplePointerCoords.reserve(sampleCount * getPointerCount());
+}
+
 std::optional<ui::Rotation> MotionEvent::getSurfaceRotation() const {
     // The surface rotation is the rotation from the window's coordinate space to that of the
     // display. Since the event's transform takes display space coordinates to window space, the
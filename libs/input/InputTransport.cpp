@@ -137,6 +137,28 @@ inline static float lerp(float a, float b, float alpha) {
     return a + alpha * (b - a);
 }
 
+/**
+ * Set X and Y of out, which must already be a copy of current, to the interpolation between
+ * current and other.
+ *
+ * X and Y are the two lowest axes, so whenever both are present they sit in values[0] and
+ * values[1] and can be blended in place without the bit scans done by get/setAxisValue.
+ */
+inline static void resampleXY(PointerCoords& out, const PointerCoords& current,
+                              const PointerCoords& other, float alpha) {
+    static_assert(AMOTION_EVENT_AXIS_X == 0 && AMOTION_EVENT_AXIS_Y == 1);
+    const uint64_t xyBits = BitSet64::valueForBit(AMOTION_EVENT_AXIS_X) |
+            BitSet64::valueForBit(AMOTION_EVENT_AXIS_Y);
+    if ((current.bits & xyBits) == xyBits && (other.bits & xyBits) == xyBits) {
+        for (size_t i = 0; i < 2; i++) {
+            out.values[i] = lerp(current.values[i], other.values[i], alpha);
+        }
+        return;
+    }
+    out.setAxisValue(AMOTION_EVENT_AXIS_X, lerp(current.getX(), other.getX(), alpha));
+    out.setAxisValue(AMOTION_EVENT_AXIS_Y, lerp(current.getY(), other.getY(), alpha));
+}
+
 inline static bool isPointerEvent(int32_t source) {
     return (source & AINPUT_SOURCE_CLASS_POINTER) == AINPUT_SOURCE_CLASS_POINTER;
 }
@@ -1031,6 +1053,8 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
             addSample(motionEvent, &msg);
         } else {
             initializeMotionEvent(motionEvent, &msg);
+            // One more sample may be appended by resampling.
+            motionEvent->reserveSamples(count + (mResampleTouch ? 1 : 0));
         }
         chain = msg.header.seq;
     }
@@ -1258,10 +1282,7 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         resampledCoords.copyFrom(currentCoords);
         if (other->idBits.hasBit(id) && shouldResampleTool(event->getToolType(i))) {
             const PointerCoords& otherCoords = other->getPointerById(id);
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X,
-                                         lerp(currentCoords.getX(), otherCoords.getX(), alpha));
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y,
-                                         lerp(currentCoords.getY(), otherCoords.getY(), alpha));
+            resampleXY(resampledCoords, currentCoords, otherCoords, alpha);
             resampledCoords.isResampled = true;
             ALOGD_IF(DEBUG_RESAMPLING,
                      "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
@@ -34,6 +34,13 @@
 #include <utils/Timers.h>
 #include <utils/Tokenizer.h>
 
+#include <android-base/thread_annotations.h>
+#include <map>
+#include <mutex>
+#include <optional>
+
+#include "FileStamp.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -82,6 +89,27 @@ static String8 toString(const char16_t* chars, size_t numChars) {
 }
 #endif
 
+namespace {
+
+// Maps successfully parsed from files by this process. A key character map can be modified by
+// combine(), so callers get their own copy of the cached map; copying the parsed tables is much
+// cheaper than tokenizing the file again each time a keyboard is added.
+struct CharacterMapCache {
+    struct Entry {
+        FileStamp stamp;
+        std::shared_ptr<const KeyCharacterMap> map;
+    };
+
+    std::mutex lock;
+    std::map<std::pair<std::string, KeyCharacterMap::Format>, Entry> entries GUARDED_BY(lock);
+};
+
+CharacterMapCache& characterMapCache() {
+    static CharacterMapCache* cache = new CharacterMapCache();
+    return *cache;
+}
+
+} // namespace
 
 // --- KeyCharacterMap ---
 
@@ -89,6 +117,16 @@ KeyCharacterMap::KeyCharacterMap(const std::string& filename) : mLoadFileName(fi
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::string& filename,
                                                                      Format format) {
+    const std::optional<FileStamp> stamp = stampFile(filename);
+    if (stamp) {
+        CharacterMapCache& cache = characterMapCache();
+        std::scoped_lock lock(cache.lock);
+        auto it = cache.entries.find({filename, format});
+        if (it != cache.entries.end() && it->second.stamp == *stamp) {
+            return std::make_shared<KeyCharacterMap>(*it->second.map);
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
     if (status) {
@@ -103,6 +141,13 @@ base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::
     std::unique_ptr<Tokenizer> t(tokenizer);
     status = map->load(t.get(), format);
     if (status == OK) {
+        if (stamp) {
+            auto cached = std::make_shared<const KeyCharacterMap>(*map);
+            CharacterMapCache& cache = characterMapCache();
+            std::scoped_lock lock(cache.lock);
+            cache.entries.insert_or_assign({filename, format},
+                                           CharacterMapCache::Entry{*stamp, std::move(cached)});
+        }
         return map;
     }
     return Errorf("Load KeyCharacterMap failed {}.", status);
@@ -17,6 +17,7 @@
 #define LOG_TAG "KeyLayoutMap"
 
 #include <android-base/logging.h>
+#include <android-base/thread_annotations.h>
 #include <android/keycodes.h>
 #include <ftl/enum.h>
 #include <input/InputEventLabels.h>
@@ -32,9 +33,13 @@
 #endif
 
 #include <cstdlib>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 
+#include "FileStamp.h"
+
 /**
  * Log debug output for the parser.
  * Enable this via "adb shell setprop log.tag.KeyLayoutMapParser DEBUG" (requires restart)
@@ -124,6 +129,24 @@ bool kernelConfigsArePresent(const std::set<std::string>& configs) {
 #endif
 }
 
+// Layouts successfully parsed from files by this process. Key layout maps are immutable, so every
+// device that uses the same layout file shares a single instance instead of tokenizing the file
+// again on each hotplug. The cache is bounded by the number of layout files on the system.
+struct LayoutCache {
+    struct Entry {
+        FileStamp stamp;
+        std::shared_ptr<KeyLayoutMap> map;
+    };
+
+    std::mutex lock;
+    std::unordered_map<std::string, Entry> entries GUARDED_BY(lock);
+};
+
+LayoutCache& layoutCache() {
+    static LayoutCache* cache = new LayoutCache();
+    return *cache;
+}
+
 } // namespace
 
 KeyLayoutMap::KeyLayoutMap() = default;
@@ -136,6 +159,19 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::loadContents(const std
 
 base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string& filename,
                                                                const char* contents) {
+    std::optional<FileStamp> stamp;
+    if (contents == nullptr) {
+        stamp = stampFile(filename);
+        if (stamp) {
+            LayoutCache& cache = layoutCache();
+            std::scoped_lock lock(cache.lock);
+            auto it = cache.entries.find(filename);
+            if (it != cache.entries.end() && it->second.stamp == *stamp) {
+                return it->second.map;
+            }
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status;
     if (contents == nullptr) {
@@ -159,6 +195,11 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string
         return Errorf("Missing kernel config");
     }
     map->mLoadFileName = filename;
+    if (stamp) {
+        LayoutCache& cache = layoutCache();
+        std::scoped_lock lock(cache.lock);
+        cache.entries.insert_or_assign(filename, LayoutCache::Entry{*stamp, map});
+    }
     return ret;
 }
 
@@ -145,8 +145,13 @@ std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
     }
 
     LOG_ALWAYS_FATAL_IF(!mModel);
-    mBuffers->copyTo(*mModel);
-    LOG_ALWAYS_FATAL_IF(!mModel->invoke());
+    // Apps typically ask for a prediction every frame. When no new sample has been recorded since
+    // the last call, the model's outputs are still those for the current inputs.
+    if (mModelOutputGeneration != mBuffers->generation()) {
+        mBuffers->copyTo(*mModel);
+        LOG_ALWAYS_FATAL_IF(!mModel->invoke());
+        mModelOutputGeneration = mBuffers->generation();
+    }
 
     // Read out the predictions.
     const std::span<const float> predictedR = mModel->outputR();
@@ -156,6 +156,7 @@ void TfLiteMotionPredictorBuffers::reset() {
     std::fill(mInputOrientation.begin(), mInputOrientation.end(), 0);
     mAxisFrom.reset();
     mAxisTo.reset();
+    ++mGeneration;
 }
 
 void TfLiteMotionPredictorBuffers::copyTo(TfLiteMotionPredictorModel& model) const {
@@ -180,6 +181,7 @@ void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
 
     if (!mAxisTo) { // First point.
         mAxisTo = sample;
+        ++mGeneration;
         return;
     }
 
@@ -226,6 +228,7 @@ void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
     mInputPressure.pushBack(sample.pressure);
     mInputTilt.pushBack(sample.tilt);
     mInputOrientation.pushBack(orientation);
+    ++mGeneration;
 }
 
 std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create() {
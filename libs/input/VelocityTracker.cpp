@@ -166,6 +166,7 @@ void VelocityTracker::configureStrategy(int32_t axis) {
     LOG_ALWAYS_FATAL_IF(createdStrategy == nullptr,
                         "Could not create velocity tracker strategy for axis '%" PRId32 "'!", axis);
     mConfiguredStrategies[axis] = std::move(createdStrategy);
+    mEstimatorCache.erase(axis);
 }
 
 std::unique_ptr<VelocityTrackerStrategy> VelocityTracker::createStrategy(
@@ -220,6 +221,7 @@ void VelocityTracker::clear() {
     mCurrentPointerIdBits.clear();
     mActivePointerId = std::nullopt;
     mConfiguredStrategies.clear();
+    mEstimatorCache.clear();
 }
 
 void VelocityTracker::clearPointer(int32_t pointerId) {
@@ -237,6 +239,9 @@ void VelocityTracker::clearPointer(int32_t pointerId) {
     for (const auto& [_, strategy] : mConfiguredStrategies) {
         strategy->clearPointer(pointerId);
     }
+    for (auto& [_, cache] : mEstimatorCache) {
+        cache.validIdBits.clearBit(pointerId);
+    }
 }
 
 void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t axis,
@@ -249,6 +254,7 @@ void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t
         // We have not received any movements for too long.  Assume that all pointers
         // have stopped.
         mConfiguredStrategies.clear();
+        mEstimatorCache.clear();
     }
     mLastEventTime = eventTime;
 
@@ -262,6 +268,9 @@ void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t
         configureStrategy(axis);
     }
     mConfiguredStrategies[axis]->addMovement(eventTime, pointerId, position);
+    if (auto cacheIt = mEstimatorCache.find(axis); cacheIt != mEstimatorCache.end()) {
+        cacheIt->second.validIdBits.clearBit(pointerId);
+    }
 
     if (DEBUG_VELOCITY) {
         ALOGD("VelocityTracker: addMovement eventTime=%" PRId64 ", pointerId=%" PRId32
@@ -312,6 +321,7 @@ void VelocityTracker::addMovement(const MotionEvent* event) {
                 // have stopped.
                 for (int32_t axis : PLANAR_AXES) {
                     mConfiguredStrategies.erase(axis);
+                    mEstimatorCache.erase(axis);
                 }
             }
             // These actions because they do not convey any new information about
@@ -380,7 +390,16 @@ std::optional<VelocityTracker::Estimator> VelocityTracker::getEstimator(int32_t
     if (it == mConfiguredStrategies.end()) {
         return std::nullopt;
     }
-    return it->second->getEstimator(pointerId);
+    if (pointerId < 0 || pointerId > MAX_POINTER_ID) {
+        return it->second->getEstimator(pointerId);
+    }
+
+    EstimatorCache& cache = mEstimatorCache[axis];
+    if (!cache.validIdBits.hasBit(pointerId)) {
+        cache.estimators[pointerId] = it->second->getEstimator(pointerId);
+        cache.validIdBits.markBit(pointerId);
+    }
+    return cache.estimators[pointerId];
 }
 
 // --- LeastSquaresVelocityTrackerStrategy ---
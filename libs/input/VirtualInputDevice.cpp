@@ -53,7 +53,33 @@ bool VirtualInputDevice::writeInputEvent(uint16_t type, uint16_t code, int32_t v
     ev.input_event_sec = static_cast<decltype(ev.input_event_sec)>(seconds.count());
     ev.input_event_usec = static_cast<decltype(ev.input_event_usec)>(microseconds.count());
 
-    return TEMP_FAILURE_RETRY(write(mFd, &ev, sizeof(struct input_event))) == sizeof(ev);
+    // If a frame is abandoned halfway, its events are written with the next frame. That matches
+    // writing them right away, as the kernel does not report events before their SYN_REPORT.
+    mPendingEvents.push_back(ev);
+    if (type == EV_SYN && code == SYN_REPORT && !mBatching) {
+        return flushInputEvents();
+    }
+    return true;
+}
+
+void VirtualInputDevice::beginBatch() {
+    mBatching = true;
+}
+
+bool VirtualInputDevice::endBatch() {
+    mBatching = false;
+    return flushInputEvents();
+}
+
+bool VirtualInputDevice::flushInputEvents() {
+    if (mPendingEvents.empty()) {
+        return true;
+    }
+    // uinput accepts any number of events per write, so each frame or batch costs one syscall.
+    const size_t size = mPendingEvents.size() * sizeof(struct input_event);
+    const ssize_t written = TEMP_FAILURE_RETRY(write(mFd, mPendingEvents.data(), size));
+    mPendingEvents.clear();
+    return written == static_cast<ssize_t>(size);
 }
 
 /** Utility method to write keyboard key events or mouse button events. */
@@ -147,6 +147,26 @@ TEST_F(InputDeviceKeyMapTest, keyCharacteMapBadLedLabel) {
     ASSERT_FALSE(ret.ok()) << "Should not be able to load KeyLayout at " << klPath;
 }
 
+TEST(InputDeviceKeyLayoutTest, ReusesLayoutUntilFileChanges) {
+    TemporaryFile klFile;
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\n", klFile.path));
+
+    base::Result<std::shared_ptr<KeyLayoutMap>> first = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(first.ok()) << "Cannot load KeyLayout at " << klFile.path;
+    base::Result<std::shared_ptr<KeyLayoutMap>> second = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(second.ok()) << "Cannot load KeyLayout at " << klFile.path;
+    EXPECT_EQ(*first, *second);
+
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\nkey 2 1\n", klFile.path));
+    base::Result<std::shared_ptr<KeyLayoutMap>> updated = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(updated.ok()) << "Cannot load KeyLayout at " << klFile.path;
+    EXPECT_NE(*first, *updated);
+    int32_t keyCode;
+    uint32_t flags;
+    ASSERT_EQ(OK, (*updated)->mapKey(/*scanCode=*/2, /*usageCode=*/0, &keyCode, &flags));
+    EXPECT_EQ(AKEYCODE_1, keyCode);
+}
+
 TEST(InputDeviceKeyLayoutTest, DoesNotLoadWhenRequiredKernelConfigIsMissing) {
 #if !defined(__ANDROID__)
     GTEST_SKIP() << "Can't check kernel configs on host";
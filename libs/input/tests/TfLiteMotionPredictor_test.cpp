@@ -50,6 +50,26 @@ TEST(TfLiteMotionPredictorTest, BuffersReadiness) {
     ASSERT_FALSE(buffers.isReady());
 }
 
+TEST(TfLiteMotionPredictorTest, BuffersGenerationTracksInputs) {
+    TfLiteMotionPredictorBuffers buffers(/*inputLength=*/5);
+    uint64_t generation = buffers.generation();
+
+    buffers.pushSample(/*timestamp=*/0, {.position = {.x = 100, .y = 100}});
+    EXPECT_NE(generation, buffers.generation());
+    generation = buffers.generation();
+
+    // A sample without movement is dropped, so the model inputs are unchanged.
+    buffers.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 100}});
+    EXPECT_EQ(generation, buffers.generation());
+
+    buffers.pushSample(/*timestamp=*/2, {.position = {.x = 100, .y = 110}});
+    EXPECT_NE(generation, buffers.generation());
+    generation = buffers.generation();
+
+    buffers.reset();
+    EXPECT_NE(generation, buffers.generation());
+}
+
 TEST(TfLiteMotionPredictorTest, BuffersRecentData) {
     TfLiteMotionPredictorBuffers buffers(/*inputLength=*/5);
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <attestation/HmacKeyManager.h>
+#include <input/Input.h>
+#include <input/InputTransport.h>
+
+#include <vector>
+
+namespace android {
+namespace {
+
+// Touch devices commonly report at 240Hz while the app draws at 60Hz, so each
+// frame batches several samples that are then resampled to the frame time.
+constexpr nsecs_t kSampleInterval = 4'166'667;
+// Far enough past the last sample that the consumer's resampling latency still
+// takes every sample of the frame, and extrapolates the resampled one.
+constexpr nsecs_t kFrameDelay = 7'000'000;
+
+class ResamplingFixture {
+public:
+    explicit ResamplingFixture(size_t pointerCount) : mPointerCount(pointerCount) {
+        std::unique_ptr<InputChannel> serverChannel, clientChannel;
+        InputChannel::openInputChannelPair("resampling benchmark", serverChannel, clientChannel);
+        mPublisher = std::make_unique<InputPublisher>(std::move(serverChannel));
+        mConsumer = std::make_unique<InputConsumer>(std::move(clientChannel),
+                                                    /*enableTouchResampling=*/true);
+
+        mProperties.resize(pointerCount);
+        mCoords.resize(pointerCount);
+        for (size_t i = 0; i < pointerCount; i++) {
+            mProperties[i].clear();
+            mProperties[i].id = static_cast<int32_t>(i);
+            mProperties[i].toolType = ToolType::FINGER;
+            mCoords[i].clear();
+        }
+
+        // Put every pointer down, one at a time, the way a real gesture would.
+        publish(AMOTION_EVENT_ACTION_DOWN, 1);
+        consumeFrame(mEventTime);
+        for (size_t i = 1; i < pointerCount; i++) {
+            publish(AMOTION_EVENT_ACTION_POINTER_DOWN |
+                            (i << AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT),
+                    i + 1);
+            consumeFrame(mEventTime);
+        }
+    }
+
+    void publishMoves(size_t sampleCount) {
+        for (size_t i = 0; i < sampleCount; i++) {
+            publish(AMOTION_EVENT_ACTION_MOVE, mPointerCount);
+        }
+    }
+
+    bool consumeFrame(nsecs_t frameTime) {
+        uint32_t seq;
+        InputEvent* event;
+        if (mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, frameTime, &seq, &event) !=
+            OK) {
+            return false;
+        }
+        benchmark::DoNotOptimize(event);
+        mConsumer->sendFinishedSignal(seq, /*handled=*/true);
+        while (mPublisher->receiveConsumerResponse().ok()) {
+        }
+        return true;
+    }
+
+    nsecs_t lastEventTime() const { return mEventTime; }
+
+private:
+    void publish(int32_t action, size_t pointerCount) {
+        mEventTime += kSampleInterval;
+        for (size_t i = 0; i < pointerCount; i++) {
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, (mEventTime / 1'000'000) + i * 50.f);
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, (mEventTime / 2'000'000) + i * 50.f);
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, 0.5f);
+            mCoords[i].setAxisValue(AMOTION_EVENT_AXIS_SIZE, 0.1f);
+        }
+        const ui::Transform identityTransform;
+        mPublisher->publishMotionEvent(mSeq++, InputEvent::nextId(), /*deviceId=*/1,
+                                       AINPUT_SOURCE_TOUCHSCREEN, /*displayId=*/0, INVALID_HMAC,
+                                       action, /*actionButton=*/0, /*flags=*/0, /*edgeFlags=*/0,
+                                       AMETA_NONE, /*buttonState=*/0, MotionClassification::NONE,
+                                       identityTransform, /*xPrecision=*/0, /*yPrecision=*/0,
+                                       AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                       AMOTION_EVENT_INVALID_CURSOR_POSITION, identityTransform,
+                                       /*downTime=*/kSampleInterval, mEventTime, pointerCount,
+                                       mProperties.data(), mCoords.data());
+    }
+
+    const size_t mPointerCount;
+    std::unique_ptr<InputPublisher> mPublisher;
+    std::unique_ptr<InputConsumer> mConsumer;
+    PreallocatedInputEventFactory mEventFactory;
+    std::vector<PointerProperties> mProperties;
+    std::vector<PointerCoords> mCoords;
+    nsecs_t mEventTime = 0;
+    uint32_t mSeq = 1;
+};
+
+// Measures one frame: a batch of MOVE samples consumed and resampled into a
+// single MotionEvent. range(0) is the pointer count, range(1) the samples per frame.
+void BM_consumeResampledBatch(benchmark::State& state) {
+    const size_t pointerCount = static_cast<size_t>(state.range(0));
+    const size_t samplesPerFrame = static_cast<size_t>(state.range(1));
+    ResamplingFixture fixture(pointerCount);
+    for (auto _ : state) {
+        state.PauseTiming();
+        fixture.publishMoves(samplesPerFrame);
+        state.ResumeTiming();
+        if (!fixture.consumeFrame(fixture.lastEventTime() + kFrameDelay)) {
+            state.SkipWithError("consume failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * samplesPerFrame);
+}
+BENCHMARK(BM_consumeResampledBatch)->Args({1, 4})->Args({10, 1})->Args({10, 4})->Args({10, 8});
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -193,5 +193,16 @@ TEST(TouchVideoFrame, Rotate270_3x2_4times) {
     ASSERT_EQ(frame, frameOriginal);
 }
 
+TEST(TouchVideoFrame, CopiesShareDataUntilRotated) {
+    TouchVideoFrame frame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP);
+    TouchVideoFrame copy = frame;
+    ASSERT_EQ(&frame.getData(), &copy.getData());
+
+    copy.rotate(ui::ROTATION_180);
+    ASSERT_NE(&frame.getData(), &copy.getData());
+    ASSERT_EQ(frame, TouchVideoFrame(3, 2, {1, 2, 3, 4, 5, 6}, TIMESTAMP));
+    ASSERT_EQ(copy, TouchVideoFrame(3, 2, {6, 5, 4, 3, 2, 1}, TIMESTAMP));
+}
+
 } // namespace test
 } // namespace android
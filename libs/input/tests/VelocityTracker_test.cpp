@@ -476,6 +476,27 @@ TEST_F(VelocityTrackerTest, TestApiInteractionsWithNoMotionEvents) {
     vt.clear();
 }
 
+TEST_F(VelocityTrackerTest, CachedEstimatorIsRefreshedByNewMovements) {
+    VelocityTracker vt(VelocityTracker::Strategy::LSQ2);
+    vt.addMovement(0, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 0);
+    vt.addMovement(10'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 10);
+    vt.addMovement(20'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 20);
+
+    std::optional<float> velocity = vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+    ASSERT_TRUE(velocity);
+    EXPECT_EQ(velocity, vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+
+    // A faster movement must not be answered with the previously computed estimate.
+    vt.addMovement(30'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 60);
+    std::optional<float> updatedVelocity =
+            vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+    ASSERT_TRUE(updatedVelocity);
+    EXPECT_GT(*updatedVelocity, *velocity);
+
+    vt.clearPointer(DEFAULT_POINTER_ID);
+    EXPECT_FALSE(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+}
+
 TEST_F(VelocityTrackerTest, ThreePointsPositiveVelocityTest) {
     // Same coordinate is reported 2 times in a row
     // It is difficult to determine the correct answer here, but at least the direction
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+
+#include <cmath>
+#include <utility>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATH_SIMD_NEON 1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define MATH_SIMD_SSE 1
+#endif
+
+// The SIMD code can't run in constant expressions, so it is only used when the compiler can tell
+// whether it is evaluating one.
+#if (defined(MATH_SIMD_NEON) || defined(MATH_SIMD_SSE)) && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MATH_HAVE_SIMD 1
+#endif
+#endif
+
+namespace android {
+namespace details {
+// -------------------------------------------------------------------------------------
+
+/*
+ * No user serviceable parts here.
+ *
+ * Don't use this file directly, instead include math/mat4.h
+ */
+
+#if MATH_HAVE_SIMD
+
+namespace simd {
+
+/*
+ * 4x4 float matrix operations on column-major arrays of 16 floats, one column of 4 floats at a
+ * time. They perform the same arithmetic, in the same order, as the generic scalar code in
+ * TMatHelpers.h and mat4.h, so results only differ where the compiler fuses the scalar code's
+ * multiplies and adds.
+ */
+
+#if MATH_SIMD_NEON
+typedef float32x4_t float4;
+inline float4 load(const float* p)            { return vld1q_f32(p); }
+inline void   store(float* p, float4 v)       { vst1q_f32(p, v); }
+inline float4 splat(float v)                  { return vdupq_n_f32(v); }
+inline float4 add(float4 a, float4 b)         { return vaddq_f32(a, b); }
+inline float4 sub(float4 a, float4 b)         { return vsubq_f32(a, b); }
+inline float4 mul(float4 a, float4 b)         { return vmulq_f32(a, b); }
+#if defined(__aarch64__)
+inline float4 div(float4 a, float4 b)         { return vdivq_f32(a, b); }
+#else
+// ARMv7 NEON has no division, and multiplying by a reciprocal estimate isn't exact.
+inline float4 div(float4 a, float4 b) {
+    float x[4], y[4];
+    vst1q_f32(x, a);
+    vst1q_f32(y, b);
+    for (size_t i = 0; i < 4; ++i) {
+        x[i] /= y[i];
+    }
+    return vld1q_f32(x);
+}
+#endif
+#else
+typedef __m128 float4;
+inline float4 load(const float* p)            { return _mm_loadu_ps(p); }
+inline void   store(float* p, float4 v)       { _mm_storeu_ps(p, v); }
+inline float4 splat(float v)                  { return _mm_set1_ps(v); }
+inline float4 add(float4 a, float4 b)         { return _mm_add_ps(a, b); }
+inline float4 sub(float4 a, float4 b)         { return _mm_sub_ps(a, b); }
+inline float4 mul(float4 a, float4 b)         { return _mm_mul_ps(a, b); }
+inline float4 div(float4 a, float4 b)         { return _mm_div_ps(a, b); }
+#endif
+
+// out = lhs * rhs, where rhs is a column vector
+inline void mat4MulVec4(const float* lhs, const float* rhs, float* out) {
+    float4 result = mul(load(lhs), splat(rhs[0]));
+    result = add(result, mul(load(lhs + 4), splat(rhs[1])));
+    result = add(result, mul(load(lhs + 8), splat(rhs[2])));
+    result = add(result, mul(load(lhs + 12), splat(rhs[3])));
+    store(out, result);
+}
+
+// out = lhs * rhs. out may not alias lhs or rhs.
+inline void mat4MulMat4(const float* lhs, const float* rhs, float* out) {
+    const float4 c0 = load(lhs);
+    const float4 c1 = load(lhs + 4);
+    const float4 c2 = load(lhs + 8);
+    const float4 c3 = load(lhs + 12);
+    for (size_t col = 0; col < 4; ++col) {
+        const float* r = rhs + col * 4;
+        float4 result = mul(c0, splat(r[0]));
+        result = add(result, mul(c1, splat(r[1])));
+        result = add(result, mul(c2, splat(r[2])));
+        result = add(result, mul(c3, splat(r[3])));
+        store(out + col * 4, result);
+    }
+}
+
+// Same as matrix::gaussJordanInverse, with each column operation done at once.
+inline void mat4Inverse(const float* src, float* out) {
+    // The columns are kept in registers for the arithmetic, and in memory to pick the pivots.
+    float4 tmp[4];
+    float4 inverted[4];
+    float column[4][4];
+    for (size_t i = 0; i < 4; ++i) {
+        tmp[i] = load(src + i * 4);
+        store(column[i], tmp[i]);
+        float identity[4] = { 0, 0, 0, 0 };
+        identity[i] = 1;
+        inverted[i] = load(identity);
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        // look for largest element in i'th column
+        size_t swap = i;
+        float t = std::abs(column[i][i]);
+        for (size_t j = i + 1; j < 4; ++j) {
+            const float t2 = std::abs(column[j][i]);
+            if (t2 > t) {
+                swap = j;
+                t = t2;
+            }
+        }
+
+        if (swap != i) {
+            // swap columns.
+            std::swap(tmp[i], tmp[swap]);
+            std::swap(inverted[i], inverted[swap]);
+            std::swap(column[i], column[swap]);
+        }
+
+        const float4 denom = splat(column[i][i]);
+        tmp[i] = div(tmp[i], denom);
+        inverted[i] = div(inverted[i], denom);
+        store(column[i], tmp[i]);
+
+        // Factor out the lower triangle
+        for (size_t j = 0; j < 4; ++j) {
+            if (j != i) {
+                const float4 d = splat(column[j][i]);
+                tmp[j] = sub(tmp[j], mul(tmp[i], d));
+                inverted[j] = sub(inverted[j], mul(inverted[i], d));
+                store(column[j], tmp[j]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        store(out + i * 4, inverted[i]);
+    }
+}
+
+}  // namespace simd
+
+#endif  // MATH_HAVE_SIMD
+
+// -------------------------------------------------------------------------------------
+}  // namespace details
+}  // namespace android
@@ -19,6 +19,7 @@
 #include <math/mat3.h>
 #include <math/quat.h>
 #include <math/TMatHelpers.h>
+#include <math/TMatSimd.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 
@@ -571,6 +572,54 @@ typename TMat44<T>::col_type PURE diag(const TMat44<T>& m) {
     return matrix::diag(m);
 }
 
+// ----------------------------------------------------------------------------------------
+// SIMD specializations for float, see TMatSimd.h. They fall back to the generic code in
+// constant expressions.
+// ----------------------------------------------------------------------------------------
+
+#if MATH_HAVE_SIMD
+
+template <>
+inline CONSTEXPR TMat44<float>::col_type PURE operator *(const TMat44<float>& lhs,
+                                                         const TVec4<float>& rhs) {
+    typename TMat44<float>::col_type result;
+    if (__builtin_is_constant_evaluated()) {
+        for (size_t col = 0; col < TMat44<float>::NUM_COLS; ++col) {
+            result += lhs[col] * rhs[col];
+        }
+    } else {
+        simd::mat4MulVec4(lhs.asArray(), &rhs[0], &result[0]);
+    }
+    return result;
+}
+
+namespace matrix {
+
+template <>
+inline CONSTEXPR TMat44<float> PURE multiply<TMat44<float>>(const TMat44<float>& lhs,
+                                                            const TMat44<float>& rhs) {
+    TMat44<float> res(TMat44<float>::NO_INIT);
+    if (__builtin_is_constant_evaluated()) {
+        for (size_t col = 0; col < TMat44<float>::NUM_COLS; ++col) {
+            res[col] = lhs * rhs[col];
+        }
+    } else {
+        simd::mat4MulMat4(lhs.asArray(), rhs.asArray(), &res[0][0]);
+    }
+    return res;
+}
+
+template <>
+inline TMat44<float> PURE gaussJordanInverse<TMat44<float>>(const TMat44<float>& src) {
+    TMat44<float> inverted(TMat44<float>::NO_INIT);
+    simd::mat4Inverse(src.asArray(), &inverted[0][0]);
+    return inverted;
+}
+
+}  // namespace matrix
+
+#endif  // MATH_HAVE_SIMD
+
 } // namespace details
 
 // ----------------------------------------------------------------------------------------
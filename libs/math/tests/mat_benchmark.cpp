@@ -0,0 +1,84 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MatBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <math/mat4.h>
+
+namespace android {
+namespace {
+
+// mat4 uses the SIMD specializations where available, mat4d the generic code, which gives a
+// baseline to compare them against.
+
+template <typename MATRIX>
+MATRIX makeMatrix() {
+    return MATRIX::translate(typename MATRIX::col_type(1, 2, 3, 1)) *
+            MATRIX::rotate(0.5, typename MATRIX::col_type(0, 0, 1, 0).xyz) *
+            MATRIX::scale(typename MATRIX::col_type(2, 3, 4, 1));
+}
+
+template <typename MATRIX>
+void BM_mat4_multiply(benchmark::State& state) {
+    const MATRIX a = makeMatrix<MATRIX>();
+    MATRIX b = transpose(a);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b = a * b);
+    }
+}
+BENCHMARK_TEMPLATE(BM_mat4_multiply, mat4);
+BENCHMARK_TEMPLATE(BM_mat4_multiply, mat4d);
+
+template <typename MATRIX>
+void BM_mat4_multiplyVector(benchmark::State& state) {
+    const MATRIX a = makeMatrix<MATRIX>();
+    typename MATRIX::col_type v(1, 2, 3, 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v = a * v);
+    }
+}
+BENCHMARK_TEMPLATE(BM_mat4_multiplyVector, mat4);
+BENCHMARK_TEMPLATE(BM_mat4_multiplyVector, mat4d);
+
+template <typename MATRIX>
+void BM_mat4_inverse(benchmark::State& state) {
+    MATRIX a = makeMatrix<MATRIX>();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a = inverse(a));
+    }
+}
+BENCHMARK_TEMPLATE(BM_mat4_inverse, mat4);
+BENCHMARK_TEMPLATE(BM_mat4_inverse, mat4d);
+
+// Color matrices in RenderEngine are built up from a few products, then applied to colors.
+void BM_mat4_colorTransform(benchmark::State& state) {
+    const mat4 saturation = makeMatrix<mat4>();
+    const mat4 colorTransform = transpose(saturation);
+    const mat4 dataspaceTransform = inverse(saturation);
+    vec4 color(0.25f, 0.5f, 0.75f, 1.0f);
+    for (auto _ : state) {
+        const mat4 m = dataspaceTransform * colorTransform * saturation;
+        benchmark::DoNotOptimize(color = m * color);
+    }
+}
+BENCHMARK(BM_mat4_colorTransform);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -150,6 +150,45 @@ TEST_F(MatTest, MiscOps) {
     }
 }
 
+TEST_F(MatTest, FloatOpsMatchDouble) {
+    // mat4 multiplies and inverts with SIMD where available, mat4d never does.
+    std::default_random_engine engine(42);
+    std::uniform_real_distribution<float> distribution(-10, 10);
+    for (int i = 0; i < 100; i++) {
+        mat4 m0, m1;
+        vec4 v;
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                m0[c][r] = distribution(engine);
+                m1[c][r] = distribution(engine);
+            }
+            // Keep m0 well conditioned, so that its inverse is accurate in float.
+            m0[c][c] += 50;
+            v[c] = distribution(engine);
+        }
+        const mat4d m0d(m0);
+        const mat4d m1d(m1);
+
+        const mat4 product = m0 * m1;
+        const mat4d productd = m0d * m1d;
+        const vec4 transformed = m0 * v;
+        const double4 transformedd = m0d * double4(v);
+        const mat4 inverted = inverse(m0);
+        const mat4d invertedd = inverse(m0d);
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                EXPECT_NEAR(productd[c][r], product[c][r], 1e-3);
+                EXPECT_NEAR(invertedd[c][r], inverted[c][r], 1e-6);
+            }
+            EXPECT_NEAR(transformedd[c], transformed[c], 1e-3);
+        }
+
+        mat4 m2(m0);
+        m2 *= m1;
+        EXPECT_EQ(product, m2);
+    }
+}
+
 TEST_F(MatTest, ElementAccess) {
     mat4 m(vec4(1, 2, 3, 4), vec4(5, 6, 7, 8), vec4(9, 10, 11, 12), vec4(13, 14, 15, 16));
     for (size_t c=0 ; c<4 ; c++) {
@@ -19,9 +19,11 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <gui/BufferQueueDefs.h>
+#include <gui/EglImageCache.h>
 #include <ui/FenceTime.h>
 #include <ui/GraphicBuffer.h>
 #include <utils/Mutex.h>
+#include <utils/String8.h>
 
 namespace android {
 
@@ -114,10 +116,23 @@ public:
 
     /**
      * onAbandonLocked amends the ConsumerBase method to clear
-     * mCurrentTextureImage in addition to the ConsumerBase behavior.
+     * mCurrentTextureImage and mEglImageCache in addition to the ConsumerBase
+     * behavior.
      */
     void onAbandonLocked();
 
+    /**
+     * onDiscardFreeBuffersLocked clears mEglImageCache after the free slots
+     * were discarded, so that their buffers are actually released.
+     */
+    void onDiscardFreeBuffersLocked();
+
+    /**
+     * dumpLocked amends the ConsumerBase method to dump the state of
+     * mEglImageCache.
+     */
+    void dumpLocked(String8& result, const char* prefix) const;
+
 protected:
     struct PendingRelease {
         PendingRelease()
@@ -316,6 +331,12 @@ protected:
     static sp<GraphicBuffer> sReleasedTexImageBuffer;
     sp<EglImage> mReleasedTexImage;
 
+    /**
+     * mEglImageCache holds the images of buffers that were freed from their
+     * slot, so that a buffer coming back into any slot reuses its EGLImage.
+     */
+    EglImageCache<EglImage> mEglImageCache;
+
     /* QTI_BEGIN */
     friend class android::libnativedisplay::QtiEglImageExtension;
     /* QTI_END */
@@ -297,6 +297,12 @@ protected:
      */
     virtual void abandonLocked();
 
+    /**
+     * discardFreeBuffersLocked overrides the ConsumerBase method to clear the
+     * EGLImage cache of mEGLConsumer.
+     */
+    virtual void discardFreeBuffersLocked() override;
+
     /**
      * dumpLocked overrides the ConsumerBase method to dump SurfaceTexture-
      * specific info in addition to the ConsumerBase behavior.
@@ -216,12 +216,18 @@ sp<GraphicBuffer> EGLConsumer::getDebugTexImageBuffer() {
 }
 
 void EGLConsumer::onAcquireBufferLocked(BufferItem* item, SurfaceTexture& st) {
+    mEglImageCache.onBufferAcquired();
+
     // If item->mGraphicBuffer is not null, this buffer has not been acquired
     // before, so any prior EglImage created is using a stale buffer. This
     // replaces any old EglImage with a new one (using the new buffer).
     int slot = item->mSlot;
     if (item->mGraphicBuffer != nullptr || mEglSlots[slot].mEglImage.get() == nullptr) {
-        mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+        mEglImageCache.add(mEglSlots[slot].mEglImage);
+        mEglSlots[slot].mEglImage = mEglImageCache.take(st.mSlots[slot].mGraphicBuffer);
+        if (mEglSlots[slot].mEglImage == nullptr) {
+            mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+        }
     }
 }
 
@@ -601,11 +607,21 @@ void EGLConsumer::onFreeBufferLocked(int slotIndex) {
         mEglSlots[slotIndex].mEglImage == mCurrentTextureImage) {
         mCurrentTextureImage.clear();
     }
+    mEglImageCache.add(mEglSlots[slotIndex].mEglImage);
     mEglSlots[slotIndex].mEglImage.clear();
 }
 
 void EGLConsumer::onAbandonLocked() {
     mCurrentTextureImage.clear();
+    mEglImageCache.clear();
+}
+
+void EGLConsumer::onDiscardFreeBuffersLocked() {
+    mEglImageCache.clear();
+}
+
+void EGLConsumer::dumpLocked(String8& result, const char* prefix) const {
+    mEglImageCache.dump(result, prefix);
 }
 
 EGLConsumer::EglImage::EglImage(sp<GraphicBuffer> graphicBuffer)
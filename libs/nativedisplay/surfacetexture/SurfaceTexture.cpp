@@ -445,8 +445,14 @@ void SurfaceTexture::freeBufferLocked(int slotIndex) {
 
 void SurfaceTexture::abandonLocked() {
     SFT_LOGV("abandonLocked");
-    mEGLConsumer.onAbandonLocked();
+    // ConsumerBase::abandonLocked frees all the slots, which caches their
+    // images in mEGLConsumer, so it must be called first.
     ConsumerBase::abandonLocked();
+    mEGLConsumer.onAbandonLocked();
+}
+
+void SurfaceTexture::discardFreeBuffersLocked() {
+    mEGLConsumer.onDiscardFreeBuffersLocked();
 }
 
 status_t SurfaceTexture::setConsumerUsageBits(uint64_t usage) {
@@ -459,6 +465,7 @@ void SurfaceTexture::dumpLocked(String8& result, const char* prefix) const {
                         prefix, mTexName, mCurrentTexture, prefix, mCurrentCrop.left,
                         mCurrentCrop.top, mCurrentCrop.right, mCurrentCrop.bottom,
                         mCurrentTransform);
+    mEGLConsumer.dumpLocked(result, prefix);
 
     ConsumerBase::dumpLocked(result, prefix);
 }
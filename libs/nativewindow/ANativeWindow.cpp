@@ -130,18 +130,19 @@ int32_t ANativeWindow_unlockAndPost(ANativeWindow* window) {
     return window->perform(window, NATIVE_WINDOW_UNLOCK_AND_POST);
 }
 
+static constexpr int32_t kAllTransformBits =
+        ANATIVEWINDOW_TRANSFORM_MIRROR_HORIZONTAL |
+        ANATIVEWINDOW_TRANSFORM_MIRROR_VERTICAL |
+        ANATIVEWINDOW_TRANSFORM_ROTATE_90 |
+        // We don't expose INVERSE_DISPLAY as an NDK constant, but someone could have read it
+        // from a buffer already set by Camera framework, so we allow it to be forwarded.
+        NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY;
+
 int32_t ANativeWindow_setBuffersTransform(ANativeWindow* window, int32_t transform) {
     static_assert(ANATIVEWINDOW_TRANSFORM_MIRROR_HORIZONTAL == NATIVE_WINDOW_TRANSFORM_FLIP_H);
     static_assert(ANATIVEWINDOW_TRANSFORM_MIRROR_VERTICAL == NATIVE_WINDOW_TRANSFORM_FLIP_V);
     static_assert(ANATIVEWINDOW_TRANSFORM_ROTATE_90 == NATIVE_WINDOW_TRANSFORM_ROT_90);
 
-    constexpr int32_t kAllTransformBits =
-            ANATIVEWINDOW_TRANSFORM_MIRROR_HORIZONTAL |
-            ANATIVEWINDOW_TRANSFORM_MIRROR_VERTICAL |
-            ANATIVEWINDOW_TRANSFORM_ROTATE_90 |
-            // We don't expose INVERSE_DISPLAY as an NDK constant, but someone could have read it
-            // from a buffer already set by Camera framework, so we allow it to be forwarded.
-            NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY;
     if (!window || !query(window, NATIVE_WINDOW_IS_VALID))
         return -EINVAL;
     if ((transform & ~kAllTransformBits) != 0)
@@ -401,6 +402,23 @@ int ANativeWindow_setDequeueTimeout(ANativeWindow* window, int64_t timeout) {
     return window->perform(window, NATIVE_WINDOW_SET_DEQUEUE_TIMEOUT, timeout);
 }
 
+int ANativeWindow_setFrameState(ANativeWindow* window, const ANativeWindowFrameState* state) {
+    constexpr uint32_t kAllFields = ANATIVEWINDOW_FRAME_STATE_DATASPACE |
+            ANATIVEWINDOW_FRAME_STATE_CROP | ANATIVEWINDOW_FRAME_STATE_TRANSFORM |
+            ANATIVEWINDOW_FRAME_STATE_FRAME_TIMELINE | ANATIVEWINDOW_FRAME_STATE_FRAME_RATE;
+    if (!window || !state || !query(window, NATIVE_WINDOW_IS_VALID)) {
+        return -EINVAL;
+    }
+    if ((state->fields & ~kAllFields) != 0) {
+        return -EINVAL;
+    }
+    if ((state->fields & ANATIVEWINDOW_FRAME_STATE_TRANSFORM) &&
+        (state->transform & ~kAllTransformBits) != 0) {
+        return -EINVAL;
+    }
+    return native_window_set_frame_state(window, state);
+}
+
 int ANativeWindow_setCancelBufferInterceptor(ANativeWindow* window,
                                              ANativeWindow_cancelBufferInterceptor interceptor,
                                              void* data) {
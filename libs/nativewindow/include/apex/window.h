@@ -207,4 +207,53 @@ int64_t ANativeWindow_getLastDequeueStartTime(ANativeWindow* window);
  */
 int ANativeWindow_setDequeueTimeout(ANativeWindow* window, int64_t timeout);
 
+/**
+ * Fields of ANativeWindowFrameState to apply, see ANativeWindow_setFrameState.
+ */
+enum ANativeWindowFrameStateField {
+    ANATIVEWINDOW_FRAME_STATE_DATASPACE = 1 << 0,
+    ANATIVEWINDOW_FRAME_STATE_CROP = 1 << 1,
+    ANATIVEWINDOW_FRAME_STATE_TRANSFORM = 1 << 2,
+    ANATIVEWINDOW_FRAME_STATE_FRAME_TIMELINE = 1 << 3,
+    ANATIVEWINDOW_FRAME_STATE_FRAME_RATE = 1 << 4,
+};
+
+/**
+ * State of the next frame, set in one call instead of one ANativeWindow_perform call per field.
+ */
+typedef struct ANativeWindowFrameState {
+    /** Bitmask of ANativeWindowFrameStateField, for the fields below to apply. */
+    uint32_t fields;
+
+    /** See ANativeWindow_setBuffersDataSpace. */
+    int32_t dataSpace;
+    /** See native_window_set_crop. An empty crop resets the crop. */
+    ARect crop;
+    /** See ANativeWindow_setBuffersTransform. */
+    int32_t transform;
+
+    /** See native_window_set_frame_timeline_info. */
+    uint64_t frameNumber;
+    int64_t frameTimelineVsyncId;
+    int32_t inputEventId;
+    int64_t startTimeNanos;
+    int32_t useForRefreshRateSelection;
+
+    /** See ANativeWindow_setFrameRateWithChangeStrategy. */
+    float frameRate;
+    int8_t compatibility;
+    int8_t changeFrameRateStrategy;
+} ANativeWindowFrameState;
+
+/**
+ * Sets the state of the next frame. The dataspace, crop and transform are updated together, so
+ * that the next queued buffer sees either all or none of them. The frame timeline info applies to
+ * the frame with the given frame number, and the frame rate applies immediately, as if they were
+ * set separately.
+ *
+ * \return NO_ERROR on success
+ * \return -EINVAL if the window is invalid, or the state has unknown fields or transform bits.
+ */
+int ANativeWindow_setFrameState(ANativeWindow* window, const ANativeWindowFrameState* state);
+
 __END_DECLS
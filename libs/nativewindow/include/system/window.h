@@ -257,6 +257,7 @@ enum {
     NATIVE_WINDOW_SET_QUERY_INTERCEPTOR           = 47,    /* private */
     NATIVE_WINDOW_SET_FRAME_TIMELINE_INFO         = 48,    /* private */
     NATIVE_WINDOW_GET_LAST_QUEUED_BUFFER2         = 49,    /* private */
+    NATIVE_WINDOW_SET_FRAME_STATE                 = 50,    /* private */
     // clang-format on
 };
 
@@ -1074,6 +1075,11 @@ static inline int native_window_set_frame_timeline_info(
                            useForRefreshRateSelection);
 }
 
+static inline int native_window_set_frame_state(struct ANativeWindow* window,
+                                                const ANativeWindowFrameState* state) {
+    return window->perform(window, NATIVE_WINDOW_SET_FRAME_STATE, state);
+}
+
 // ------------------------------------------------------------------------------------------------
 // Candidates for APEX visibility
 // These functions are planned to be made stable for APEX modules, but have not
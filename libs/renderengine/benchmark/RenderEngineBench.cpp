@@ -23,7 +23,9 @@
 #include <renderengine/LayerSettings.h>
 #include <renderengine/RenderEngine.h>
 #include <renderengine/impl/ExternalTexture.h>
+#include <utils/Timers.h>
 
+#include <algorithm>
 #include <mutex>
 
 using namespace android;
@@ -73,6 +75,22 @@ static void RunSkiaGLThreaded(benchmark::internal::Benchmark* b) {
     AddRenderEngineType(b, RenderEngine::RenderEngineType::SKIA_GL_THREADED);
 }
 
+/**
+ * Run a benchmark once using SKIA_VK_THREADED.
+ */
+static void RunSkiaVkThreaded(benchmark::internal::Benchmark* b) {
+    AddRenderEngineType(b, RenderEngine::RenderEngineType::SKIA_VK_THREADED);
+}
+
+/**
+ * Run a benchmark once per Skia backend, so that the backends can be compared
+ * on the same scene.
+ */
+static void RunSkiaBackends(benchmark::internal::Benchmark* b) {
+    RunSkiaGLThreaded(b);
+    RunSkiaVkThreaded(b);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //  Helpers for calling drawLayers
 ///////////////////////////////////////////////////////////////////////////////
@@ -181,36 +199,53 @@ static std::shared_ptr<ExternalTexture> copyBuffer(RenderEngine& re,
     return texture;
 }
 
+static DisplaySettings defaultDisplaySettings() {
+    auto [width, height] = getDisplaySize();
+    const Rect displayRect(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
+    return DisplaySettings{
+            .physicalDisplay = displayRect,
+            .clip = displayRect,
+            .maxLuminance = 500,
+    };
+}
+
 /**
  * Helper for timing calls to drawLayers.
  *
- * Caller needs to create RenderEngine and the LayerSettings, and this takes
- * care of setting up the display, starting and stopping the timer, calling
- * drawLayers, and saving (if --save is used).
+ * Caller needs to create RenderEngine, the DisplaySettings and the
+ * LayerSettings, and this takes care of starting and stopping the timer,
+ * calling drawLayers, and saving (if --save is used).
  *
  * This times both the CPU and GPU work initiated by drawLayers. All work done
  * outside of the for loop is excluded from the timing measurements.
+ *
+ * It also reports gpu_wait_us, the average time between drawLayers returning
+ * and its fence signaling. That is GPU work which did not overlap with the
+ * CPU side of the draw, so it is the number to watch when comparing shaders.
  */
-static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>& layers,
+static void benchDrawLayers(RenderEngine& re, const DisplaySettings& display,
+                            const std::vector<LayerSettings>& layers,
                             benchmark::State& benchState, const char* saveFileName) {
-    auto [width, height] = getDisplaySize();
-    auto outputBuffer = allocateBuffer(re, width, height);
-
-    const Rect displayRect(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
-    DisplaySettings display{
-            .physicalDisplay = displayRect,
-            .clip = displayRect,
-            .maxLuminance = 500,
-    };
+    auto outputBuffer = allocateBuffer(re, static_cast<uint32_t>(display.physicalDisplay.width()),
+                                       static_cast<uint32_t>(display.physicalDisplay.height()));
 
+    nsecs_t gpuWaitTime = 0;
     // This loop starts and stops the timer.
     for (auto _ : benchState) {
         sp<Fence> waitFence = re.drawLayers(display, layers, outputBuffer, kUseFrameBufferCache,
                                             base::unique_fd())
                                       .get()
                                       .value();
+        const nsecs_t submitTime = systemTime();
         waitFence->waitForever(LOG_TAG);
+        const nsecs_t signalTime = waitFence->getSignalTime();
+        if (signalTime != Fence::SIGNAL_TIME_INVALID) {
+            gpuWaitTime += std::max<nsecs_t>(0, signalTime - submitTime);
+        }
     }
+    benchState.counters["gpu_wait_us"] =
+            benchmark::Counter(static_cast<double>(ns2us(gpuWaitTime)),
+                               benchmark::Counter::kAvgIterations);
 
     if (renderenginebench::save() && saveFileName) {
         // Copy to a CPU-accessible buffer so we can encode it.
@@ -224,41 +259,116 @@ static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>&
     }
 }
 
-///////////////////////////////////////////////////////////////////////////////
-//  Benchmarks
-///////////////////////////////////////////////////////////////////////////////
-
-void BM_blur(benchmark::State& benchState) {
-    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>& layers,
+                            benchmark::State& benchState, const char* saveFileName) {
+    benchDrawLayers(re, defaultDisplaySettings(), layers, benchState, saveFileName);
+}
 
+/**
+ * Decode resources/homescreen.png into a GPU-only buffer the size of the
+ * display.
+ */
+static std::shared_ptr<ExternalTexture> loadHomescreen(RenderEngine& re) {
     // Initially use cpu access so we can decode into it with AImageDecoder.
     auto [width, height] = getDisplaySize();
     auto srcBuffer =
-            allocateBuffer(*re, width, height, GRALLOC_USAGE_SW_WRITE_OFTEN, "decoded_source");
-    {
-        std::string srcImage = base::GetExecutableDirectory();
-        srcImage.append("/resources/homescreen.png");
-        renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
-
-        // Now copy into GPU-only buffer for more realistic timing.
-        srcBuffer = copyBuffer(*re, srcBuffer, 0, "source");
+            allocateBuffer(re, width, height, GRALLOC_USAGE_SW_WRITE_OFTEN, "decoded_source");
+    std::string srcImage = base::GetExecutableDirectory();
+    srcImage.append("/resources/homescreen.png");
+    renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
+
+    // Now copy into GPU-only buffer for more realistic timing.
+    return copyBuffer(re, srcBuffer, 0, "source");
+}
+
+/**
+ * Allocate a YCbCr 4:2:0 buffer the size of the display, as a video decoder or
+ * camera would produce, and fill it with gradients.
+ */
+static std::shared_ptr<ExternalTexture> allocateYuvBuffer(RenderEngine& re) {
+    auto [width, height] = getDisplaySize();
+    auto buffer = sp<GraphicBuffer>::make(width, height, HAL_PIXEL_FORMAT_YCBCR_420_888, 1u,
+                                          GRALLOC_USAGE_HW_TEXTURE | GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                          "yuv_source");
+    android_ycbcr ycbcr;
+    LOG_ALWAYS_FATAL_IF(buffer->lockYCbCr(GRALLOC_USAGE_SW_WRITE_OFTEN, &ycbcr) != OK,
+                        "Failed to lock YUV buffer!");
+    for (uint32_t y = 0; y < height; y++) {
+        auto* row = static_cast<uint8_t*>(ycbcr.y) + y * ycbcr.ystride;
+        for (uint32_t x = 0; x < width; x++) {
+            row[x] = static_cast<uint8_t>((x + y) & 0xff);
+        }
+    }
+    for (uint32_t y = 0; y < height / 2; y++) {
+        auto* cb = static_cast<uint8_t*>(ycbcr.cb) + y * ycbcr.cstride;
+        auto* cr = static_cast<uint8_t*>(ycbcr.cr) + y * ycbcr.cstride;
+        for (uint32_t x = 0; x < width / 2; x++) {
+            cb[x * ycbcr.chroma_step] = static_cast<uint8_t>(x & 0xff);
+            cr[x * ycbcr.chroma_step] = static_cast<uint8_t>(y & 0xff);
+        }
     }
+    buffer->unlock();
+    return std::make_shared<impl::ExternalTexture>(buffer, re,
+                                                   impl::ExternalTexture::Usage::READABLE);
+}
 
-    const FloatRect layerRect(0, 0, width, height);
-    LayerSettings layer{
+static LayerSettings imageLayer(std::shared_ptr<ExternalTexture> buffer, FloatRect bounds) {
+    return LayerSettings{
             .geometry =
                     Geometry{
-                            .boundaries = layerRect,
+                            .boundaries = bounds,
                     },
             .source =
                     PixelSource{
                             .buffer =
                                     Buffer{
-                                            .buffer = srcBuffer,
+                                            .buffer = std::move(buffer),
                                     },
                     },
             .alpha = half(1.0f),
     };
+}
+
+/**
+ * A window the way SurfaceFlinger sends it on a device with rounded screen
+ * corners and elevation shadows: an opaque solid color card with rounded
+ * corners, casting a shadow.
+ */
+static LayerSettings windowLayer(FloatRect bounds, float cornerRadius, half3 color) {
+    return LayerSettings{
+            .geometry =
+                    Geometry{
+                            .boundaries = bounds,
+                            .roundedCornersRadius = {cornerRadius, cornerRadius},
+                            .roundedCornersCrop = bounds,
+                    },
+            .source =
+                    PixelSource{
+                            .solidColor = color,
+                    },
+            .alpha = half(1.0f),
+            .shadow =
+                    ShadowSettings{
+                            .boundaries = bounds,
+                            .ambientColor = vec4(0, 0, 0, 0.039f),
+                            .spotColor = vec4(0, 0, 0, 0.19f),
+                            .lightPos = vec3(bounds.getWidth() / 2, -1500.f, 1500.f),
+                            .lightRadius = 2500.0f,
+                            .length = 24.f,
+                    },
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Benchmarks
+///////////////////////////////////////////////////////////////////////////////
+
+void BM_blur(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+    auto srcBuffer = loadHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    const FloatRect layerRect(0, 0, width, height);
     LayerSettings blurLayer{
             .geometry =
                     Geometry{
@@ -269,8 +379,119 @@ void BM_blur(benchmark::State& benchState) {
             .backgroundBlurRadius = 60,
     };
 
-    auto layers = std::vector<LayerSettings>{layer, blurLayer};
+    auto layers = std::vector<LayerSettings>{imageLayer(srcBuffer, layerRect), blurLayer};
     benchDrawLayers(*re, layers, benchState, "blurred");
 }
 
-BENCHMARK(BM_blur)->Apply(RunSkiaGLThreaded);
+BENCHMARK(BM_blur)->Apply(RunSkiaBackends);
+
+void BM_roundedCorners(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+    auto srcBuffer = loadHomescreen(*re);
+
+    // A picture-in-picture sized window of the homescreen on top of itself.
+    auto [width, height] = getDisplaySize();
+    const FloatRect layerRect(0, 0, width, height);
+    const FloatRect pipRect(width / 2, height / 2, width - 40, height - 40);
+    LayerSettings pipLayer = imageLayer(srcBuffer, layerRect);
+    pipLayer.geometry.positionTransform =
+            mat4::translate(vec4(pipRect.left, pipRect.top, 0, 0)) *
+            mat4::scale(vec4(pipRect.getWidth() / width, pipRect.getHeight() / height, 1, 1));
+    pipLayer.geometry.roundedCornersRadius = {50.f, 50.f};
+    pipLayer.geometry.roundedCornersCrop = layerRect;
+
+    auto layers = std::vector<LayerSettings>{imageLayer(srcBuffer, layerRect), pipLayer};
+    benchDrawLayers(*re, layers, benchState, "rounded_corners");
+}
+
+BENCHMARK(BM_roundedCorners)->Apply(RunSkiaBackends);
+
+void BM_shadows(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+
+    // A stack of cards, as in recents or a notification list.
+    auto [width, height] = getDisplaySize();
+    std::vector<LayerSettings> layers;
+    const float cardHeight = height / 5.f;
+    for (int i = 0; i < 4; i++) {
+        const float top = 40.f + i * (cardHeight + 40.f);
+        layers.push_back(windowLayer(FloatRect(40.f, top, width - 40.f, top + cardHeight), 28.f,
+                                     half3(0.9f, 0.9f, 0.95f)));
+    }
+    benchDrawLayers(*re, layers, benchState, "shadows");
+}
+
+BENCHMARK(BM_shadows)->Apply(RunSkiaBackends);
+
+void BM_hdrToneMapping(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+    auto srcBuffer = loadHomescreen(*re);
+
+    // Full screen PQ video on an SDR display, which has to be tone mapped down.
+    auto [width, height] = getDisplaySize();
+    LayerSettings hdrLayer = imageLayer(srcBuffer, FloatRect(0, 0, width, height));
+    hdrLayer.sourceDataspace = ui::Dataspace::BT2020_ITU_PQ;
+    hdrLayer.source.buffer.maxLuminanceNits = 1000.f;
+    hdrLayer.source.buffer.isOpaque = true;
+
+    DisplaySettings display = defaultDisplaySettings();
+    display.outputDataspace = ui::Dataspace::DISPLAY_P3;
+    display.targetLuminanceNits = 500.f;
+
+    auto layers = std::vector<LayerSettings>{hdrLayer};
+    benchDrawLayers(*re, display, layers, benchState, "hdr_tone_mapped");
+}
+
+BENCHMARK(BM_hdrToneMapping)->Apply(RunSkiaBackends);
+
+void BM_yuv(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+    auto srcBuffer = allocateYuvBuffer(*re);
+
+    auto [width, height] = getDisplaySize();
+    LayerSettings videoLayer = imageLayer(srcBuffer, FloatRect(0, 0, width, height));
+    videoLayer.sourceDataspace = ui::Dataspace::BT709;
+    videoLayer.source.buffer.isOpaque = true;
+    videoLayer.source.buffer.useTextureFiltering = true;
+
+    auto layers = std::vector<LayerSettings>{videoLayer};
+    benchDrawLayers(*re, layers, benchState, "yuv");
+}
+
+BENCHMARK(BM_yuv)->Apply(RunSkiaBackends);
+
+/**
+ * The notification shade pulled down over the homescreen: status bar and
+ * shade over a blurred wallpaper, which combines most of the effects above in
+ * one draw.
+ */
+void BM_notificationShade(benchmark::State& benchState) {
+    auto re = createRenderEngine(static_cast<RenderEngine::RenderEngineType>(benchState.range()));
+    auto srcBuffer = loadHomescreen(*re);
+
+    auto [width, height] = getDisplaySize();
+    const FloatRect layerRect(0, 0, width, height);
+    std::vector<LayerSettings> layers{imageLayer(srcBuffer, layerRect)};
+    LayerSettings scrim{
+            .geometry =
+                    Geometry{
+                            .boundaries = layerRect,
+                    },
+            .source =
+                    PixelSource{
+                            .solidColor = half3(0.0f, 0.0f, 0.0f),
+                    },
+            .alpha = half(0.4f),
+            .backgroundBlurRadius = 80,
+    };
+    layers.push_back(scrim);
+    const float cardHeight = height / 8.f;
+    for (int i = 0; i < 5; i++) {
+        const float top = 200.f + i * (cardHeight + 16.f);
+        layers.push_back(windowLayer(FloatRect(24.f, top, width - 24.f, top + cardHeight), 28.f,
+                                     half3(0.16f, 0.16f, 0.18f)));
+    }
+    benchDrawLayers(*re, layers, benchState, "notification_shade");
+}
+
+BENCHMARK(BM_notificationShade)->Apply(RunSkiaBackends);
@@ -51,6 +51,12 @@ struct DisplaySettings {
     // z=1.
     Rect clip = Rect::INVALID_RECT;
 
+    // Rectangle of the output buffer, in the same coordinates as physicalDisplay, to which
+    // drawing may be limited. It is set when the output buffer already holds the contents of the
+    // frame outside of it, so implementations are free to draw the entire buffer anyway. An
+    // invalid rectangle means that the entire buffer is drawn.
+    Rect scissor = Rect::INVALID_RECT;
+
     // Maximum luminance pulled from the display's HDR capabilities.
     float maxLuminance = 1.0f;
 
@@ -89,11 +95,16 @@ struct DisplaySettings {
             aidl::android::hardware::graphics::composer3::RenderIntent::TONE_MAP_COLORIMETRIC;
 
     std::vector<renderengine::BorderRenderInfo> borderInfoList;
+
+    // Whether no frame is waiting on this draw, as with screenshots and region sampling. A
+    // threaded RenderEngine runs such draws after the other work it has queued.
+    bool lowPriority = false;
 };
 
 static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings& rhs) {
     return lhs.namePlusId == rhs.namePlusId && lhs.physicalDisplay == rhs.physicalDisplay &&
-            lhs.clip == rhs.clip && lhs.maxLuminance == rhs.maxLuminance &&
+            lhs.clip == rhs.clip && lhs.scissor == rhs.scissor &&
+            lhs.maxLuminance == rhs.maxLuminance &&
             lhs.currentLuminanceNits == rhs.currentLuminanceNits &&
             lhs.outputDataspace == rhs.outputDataspace &&
             lhs.colorTransform == rhs.colorTransform &&
@@ -101,7 +112,7 @@ static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings&
             lhs.orientation == rhs.orientation &&
             lhs.targetLuminanceNits == rhs.targetLuminanceNits &&
             lhs.dimmingStage == rhs.dimmingStage && lhs.renderIntent == rhs.renderIntent &&
-            lhs.borderInfoList == rhs.borderInfoList;
+            lhs.borderInfoList == rhs.borderInfoList && lhs.lowPriority == rhs.lowPriority;
 }
 
 static const char* orientation_to_string(uint32_t orientation) {
@@ -133,6 +144,8 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
     PrintTo(settings.physicalDisplay, os);
     *os << "\n    .clip = ";
     PrintTo(settings.clip, os);
+    *os << "\n    .scissor = ";
+    PrintTo(settings.scissor, os);
     *os << "\n    .maxLuminance = " << settings.maxLuminance;
     *os << "\n    .currentLuminanceNits = " << settings.currentLuminanceNits;
     *os << "\n    .outputDataspace = ";
@@ -146,6 +159,7 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
         << aidl::android::hardware::graphics::composer3::toString(settings.dimmingStage).c_str();
     *os << "\n    .renderIntent = "
         << aidl::android::hardware::graphics::composer3::toString(settings.renderIntent).c_str();
+    *os << "\n    .lowPriority = " << settings.lowPriority;
     *os << "\n}";
 }
 
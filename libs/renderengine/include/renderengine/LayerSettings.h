@@ -68,6 +68,11 @@ struct Buffer {
     bool isY410BT2020 = false;
 
     float maxLuminanceNits = 0.0;
+
+    // Frame number of the content of the buffer, which changes whenever the buffer is redrawn,
+    // even if it is the same buffer. 0 if unknown, in which case RenderEngine does not assume
+    // that the content is unchanged between draws.
+    uint64_t frameNumber = 0;
 };
 
 // Metadata describing the layer geometry.
@@ -190,7 +195,7 @@ static inline bool operator==(const Buffer& lhs, const Buffer& rhs) {
             lhs.textureTransform == rhs.textureTransform &&
             lhs.usePremultipliedAlpha == rhs.usePremultipliedAlpha &&
             lhs.isOpaque == rhs.isOpaque && lhs.isY410BT2020 == rhs.isY410BT2020 &&
-            lhs.maxLuminanceNits == rhs.maxLuminanceNits;
+            lhs.maxLuminanceNits == rhs.maxLuminanceNits && lhs.frameNumber == rhs.frameNumber;
 }
 
 static inline bool operator==(const Geometry& lhs, const Geometry& rhs) {
@@ -249,6 +254,7 @@ static inline void PrintTo(const Buffer& settings, ::std::ostream* os) {
     *os << "\n    .isOpaque = " << settings.isOpaque;
     *os << "\n    .isY410BT2020 = " << settings.isY410BT2020;
     *os << "\n    .maxLuminanceNits = " << settings.maxLuminanceNits;
+    *os << "\n    .frameNumber = " << settings.frameNumber;
     *os << "\n}";
 }
 
@@ -51,6 +51,10 @@ const auto kFlip = mat4(1.1f, -0.1f,  0.f, 0.f,
 // a color correction effect is added to the shader.
 constexpr auto kDestDataSpace = ui::Dataspace::SRGB;
 constexpr auto kOtherDataSpace = ui::Dataspace::DISPLAY_P3;
+// HDR video is tone mapped with a LinearEffect built for each pair of source and destination
+// dataspaces, so warm up the ones playback commonly needs.
+constexpr ui::Dataspace kHdrDataSpaces[] = {ui::Dataspace::BT2020_ITU_PQ,
+                                            ui::Dataspace::BT2020_ITU_HLG};
 } // namespace
 
 static void drawShadowLayers(SkiaRenderEngine* renderengine, const DisplaySettings& display,
@@ -162,6 +166,40 @@ static void drawImageLayers(SkiaRenderEngine* renderengine, const DisplaySetting
     }
 }
 
+static void drawHdrImageLayers(SkiaRenderEngine* renderengine,
+                               const std::vector<DisplaySettings>& displays,
+                               const std::shared_ptr<ExternalTexture>& dstTexture,
+                               const std::shared_ptr<ExternalTexture>& srcTexture) {
+    const Rect& displayRect = displays.front().physicalDisplay;
+    FloatRect rect(0, 0, displayRect.width(), displayRect.height());
+    LayerSettings layer{
+            .geometry =
+                    Geometry{
+                            .boundaries = rect,
+                            .roundedCornersCrop = rect,
+                    },
+            .source = PixelSource{.buffer =
+                                          Buffer{
+                                                  .buffer = srcTexture,
+                                                  .maxLuminanceNits = 1000.f,
+                                          }},
+            .alpha = 1.f,
+    };
+
+    for (const auto& display : displays) {
+        for (auto dataspace : kHdrDataSpaces) {
+            layer.sourceDataspace = dataspace;
+            // Translucent layers also undo premultiplied alpha, which is a separate effect.
+            for (bool isOpaque : {true, false}) {
+                layer.source.buffer.isOpaque = isOpaque;
+                auto layers = std::vector<LayerSettings>{layer};
+                renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
+                                         base::unique_fd());
+            }
+        }
+    }
+}
+
 static void drawSolidLayers(SkiaRenderEngine* renderengine, const DisplaySettings& display,
                             const std::shared_ptr<ExternalTexture>& dstTexture) {
     const Rect& displayRect = display.physicalDisplay;
@@ -429,6 +467,7 @@ void Cache::primeShaderCache(SkiaRenderEngine* renderengine) {
         }
 
         drawPIPImageLayer(renderengine, display, dstTexture, externalTexture);
+        drawHdrImageLayers(renderengine, {display, p3Display}, dstTexture, externalTexture);
 
         // draw one final layer synchronously to force GL submit
         LayerSettings layer{
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "PersistentShaderCache.h"
+
+#include <FileBlobCache.h>
+#include <log/log.h>
+#include <pthread.h>
+#include <utils/Trace.h>
+
+#include <vector>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+PersistentShaderCache::PersistentShaderCache(const std::string& path) {
+    {
+        std::scoped_lock lock(mMutex);
+        mBlobCache = std::make_unique<FileBlobCache>(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                                     path);
+        ALOGD("Loaded %zu bytes of shaders from %s", mBlobCache->getSize(), path.c_str());
+    }
+    mWriteThread = std::thread(&PersistentShaderCache::writeLoop, this);
+    pthread_setname_np(mWriteThread.native_handle(), "REShaderCache");
+}
+
+PersistentShaderCache::~PersistentShaderCache() {
+    {
+        std::scoped_lock lock(mMutex);
+        mDone = true;
+    }
+    mCondition.notify_all();
+    mWriteThread.join();
+}
+
+sk_sp<SkData> PersistentShaderCache::load(const SkData& key) {
+    std::scoped_lock lock(mMutex);
+    const size_t size = mBlobCache->get(key.data(), key.size(), nullptr, 0);
+    if (size == 0) {
+        mMissCount++;
+        return nullptr;
+    }
+    sk_sp<SkData> data = SkData::MakeUninitialized(size);
+    if (mBlobCache->get(key.data(), key.size(), data->writable_data(), size) != size) {
+        mMissCount++;
+        return nullptr;
+    }
+    mHitCount++;
+    return data;
+}
+
+void PersistentShaderCache::store(const SkData& key, const SkData& data) {
+    {
+        std::scoped_lock lock(mMutex);
+        mBlobCache->set(key.data(), key.size(), data.data(), data.size());
+        mDirty = true;
+    }
+    mCondition.notify_all();
+}
+
+int PersistentShaderCache::hitCount() const {
+    std::scoped_lock lock(mMutex);
+    return mHitCount;
+}
+
+int PersistentShaderCache::missCount() const {
+    std::scoped_lock lock(mMutex);
+    return mMissCount;
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void PersistentShaderCache::writeLoop() NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock(mMutex);
+    while (!mDone) {
+        if (!mDirty) {
+            mCondition.wait(lock);
+            continue;
+        }
+        // Wait for a quiet period, restarting it whenever another entry is stored.
+        mDirty = false;
+        if (mCondition.wait_for(lock, kWriteDelay) == std::cv_status::no_timeout && !mDone) {
+            mDirty = true;
+            continue;
+        }
+        ATRACE_NAME("PersistentShaderCache::write");
+        // Only serialize the cache under the lock, so that loads and stores are not blocked on the
+        // disk. mBlobCache is only ever written by this thread, and its file name never changes.
+        const std::vector<uint8_t> contents = mBlobCache->getFileContents();
+        lock.unlock();
+        mBlobCache->writeFileContents(contents);
+        lock.lock();
+    }
+    if (mDirty) {
+        mBlobCache->writeToFile();
+    }
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
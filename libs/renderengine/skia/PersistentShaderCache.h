@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <SkData.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace android {
+
+class FileBlobCache;
+
+namespace renderengine {
+namespace skia {
+
+/**
+ * Backs Skia's PersistentCache with a file, so that the shaders and pipelines compiled in one run
+ * of SurfaceFlinger only need to be loaded in the next one. New entries are written back from a
+ * background thread shortly after they are stored, so that disk writes never happen while
+ * rendering. The file is discarded by FileBlobCache when the build changes.
+ */
+class PersistentShaderCache {
+public:
+    explicit PersistentShaderCache(const std::string& path);
+    ~PersistentShaderCache();
+
+    sk_sp<SkData> load(const SkData& key) EXCLUDES(mMutex);
+    void store(const SkData& key, const SkData& data) EXCLUDES(mMutex);
+
+    // The number of cache lookups that were answered from the cache, and the number that were not.
+    int hitCount() const EXCLUDES(mMutex);
+    int missCount() const EXCLUDES(mMutex);
+
+private:
+    static constexpr size_t kMaxKeySize = 1024;
+    static constexpr size_t kMaxValueSize = 2 * 1024 * 1024;
+    static constexpr size_t kMaxTotalSize = 4 * 1024 * 1024;
+    // Shaders tend to be compiled in bursts, e.g. when a new kind of layer first comes on screen,
+    // so the cache is only written once no new entries have been stored for this long.
+    static constexpr std::chrono::seconds kWriteDelay{4};
+
+    void writeLoop() EXCLUDES(mMutex);
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::unique_ptr<FileBlobCache> mBlobCache GUARDED_BY(mMutex);
+    bool mDirty GUARDED_BY(mMutex) = false;
+    bool mDone GUARDED_BY(mMutex) = false;
+    int mHitCount GUARDED_BY(mMutex) = 0;
+    int mMissCount GUARDED_BY(mMutex) = 0;
+    std::thread mWriteThread;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
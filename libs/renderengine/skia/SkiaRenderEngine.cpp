@@ -63,6 +63,7 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <deque>
@@ -243,12 +244,23 @@ using base::StringAppendF;
 
 std::future<void> SkiaRenderEngine::primeCache() {
     Cache::primeShaderCache(this);
+    if (mSkSLCacheMonitor.getPersistentCache()) {
+        // Vulkan pipelines are only handed to the persistent cache on request. This is a no-op
+        // for GL, whose programs are stored as they are compiled.
+        mGrContext->storeVkPipelineCacheData();
+        if (mProtectedGrContext) {
+            mProtectedGrContext->storeVkPipelineCacheData();
+        }
+    }
     return {};
 }
 
 sk_sp<SkData> SkiaRenderEngine::SkSLCacheMonitor::load(const SkData& key) {
-    // This "cache" does not actually cache anything. It just allows us to
-    // monitor Skia's internal cache. So this method always returns null.
+    // Without a persistent cache, this "cache" does not actually cache anything.
+    // It just allows us to monitor Skia's internal cache.
+    if (mPersistentCache) {
+        return mPersistentCache->load(key);
+    }
     return nullptr;
 }
 
@@ -257,6 +269,9 @@ void SkiaRenderEngine::SkSLCacheMonitor::store(const SkData& key, const SkData&
     mShadersCachedSinceLastCall++;
     mTotalShadersCompiled++;
     ATRACE_FORMAT("SF cache: %i shaders", mTotalShadersCompiled);
+    if (mPersistentCache) {
+        mPersistentCache->store(key, data);
+    }
 }
 
 int SkiaRenderEngine::reportShadersCompiled() {
@@ -268,7 +283,8 @@ void SkiaRenderEngine::setEnableTracing(bool tracingEnabled) {
 }
 
 SkiaRenderEngine::SkiaRenderEngine(RenderEngineType type, PixelFormat pixelFormat,
-                                   bool useColorManagement, bool supportsBackgroundBlur)
+                                   bool useColorManagement, bool supportsBackgroundBlur,
+                                   const std::string& shaderCachePath)
       : RenderEngine(type),
         mDefaultPixelFormat(pixelFormat),
         mUseColorManagement(useColorManagement) {
@@ -276,6 +292,10 @@ SkiaRenderEngine::SkiaRenderEngine(RenderEngineType type, PixelFormat pixelForma
         ALOGD("Background Blurs Enabled");
         mBlurFilter = new KawaseBlurFilter();
     }
+    if (!shaderCachePath.empty()) {
+        mSkSLCacheMonitor.setPersistentCache(
+                std::make_unique<PersistentShaderCache>(shaderCachePath));
+    }
     mCapture = std::make_unique<SkiaCapture>();
 }
 
@@ -288,6 +308,7 @@ void SkiaRenderEngine::finishRenderingAndAbandonContext() {
     if (mBlurFilter) {
         delete mBlurFilter;
     }
+    mCachedBlurs.clear();
 
     if (mGrContext) {
         mGrContext->flushAndSubmit(true);
@@ -644,6 +665,73 @@ private:
     AutoBackendTexture::CleanupManager& mMgr;
 };
 
+// Whether a layer's content only changes along with its LayerSettings. Producers redraw the same
+// buffers every frame, so a buffer is only tracked through its frame number.
+static bool hasTrackableContent(const LayerSettings& layer) {
+    const auto& buffer = layer.source.buffer;
+    return buffer.buffer == nullptr || buffer.frameNumber != 0;
+}
+
+static std::pair<uint64_t, uint64_t> getBufferFrame(const LayerSettings& layer) {
+    const auto& buffer = layer.source.buffer;
+    return {buffer.buffer ? buffer.buffer->getId() : 0, buffer.frameNumber};
+}
+
+SkiaRenderEngine::CachedBlur* SkiaRenderEngine::getCachedBlur(
+        GrDirectContext* context, const DisplaySettings& display, float displayDimmingRatio,
+        const std::vector<LayerSettings>& layers, size_t layerIndex, const SkRect& blurRect) {
+    if (!std::all_of(layers.begin(), layers.begin() + layerIndex, hasTrackableContent)) {
+        return nullptr;
+    }
+
+    DisplaySettings displayWithoutScissor = display;
+    displayWithoutScissor.scissor = Rect::INVALID_RECT;
+
+    const auto matches = [&](const CachedBlur& cached) {
+        if (cached.context != context || cached.displayDimmingRatio != displayDimmingRatio ||
+            cached.blurRect != blurRect || cached.layersBelow.size() != layerIndex ||
+            !(cached.display == displayWithoutScissor)) {
+            return false;
+        }
+        for (size_t i = 0; i < layerIndex; i++) {
+            if (cached.buffersBelow[i] != getBufferFrame(layers[i])) {
+                return false;
+            }
+            LayerSettings layerWithoutBuffer = layers[i];
+            layerWithoutBuffer.source.buffer.buffer = nullptr;
+            if (!(cached.layersBelow[i] == layerWithoutBuffer)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (auto it = std::find_if(mCachedBlurs.begin(), mCachedBlurs.end(), matches);
+        it != mCachedBlurs.end()) {
+        mCachedBlurs.splice(mCachedBlurs.begin(), mCachedBlurs, it);
+        return &mCachedBlurs.front();
+    }
+
+    CachedBlur cached{
+            .context = context,
+            .display = std::move(displayWithoutScissor),
+            .displayDimmingRatio = displayDimmingRatio,
+            .blurRect = blurRect,
+    };
+    cached.layersBelow.reserve(layerIndex);
+    cached.buffersBelow.reserve(layerIndex);
+    for (size_t i = 0; i < layerIndex; i++) {
+        cached.buffersBelow.push_back(getBufferFrame(layers[i]));
+        cached.layersBelow.push_back(layers[i]);
+        cached.layersBelow.back().source.buffer.buffer = nullptr;
+    }
+    mCachedBlurs.push_front(std::move(cached));
+    if (mCachedBlurs.size() > kMaxCachedBlurs) {
+        mCachedBlurs.pop_back();
+    }
+    return &mCachedBlurs.front();
+}
+
 void SkiaRenderEngine::drawLayersInternal(
         const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
         const DisplaySettings& display, const std::vector<LayerSettings>& layers,
@@ -736,6 +824,11 @@ void SkiaRenderEngine::drawLayersInternal(
     }
 
     AutoSaveRestore surfaceAutoSaveRestore(canvas);
+    // The scissor cannot be honored when composing into an offscreen buffer, as that gets blitted
+    // over the entire output buffer.
+    if (display.scissor.isValid() && canvas == dstCanvas) {
+        canvas->clipRect(getSkRect(display.scissor));
+    }
     // Clear the entire canvas with a transparent black to prevent ghost images.
     canvas->clear(SK_ColorTRANSPARENT);
     initCanvas(canvas, display);
@@ -806,8 +899,6 @@ void SkiaRenderEngine::drawLayersInternal(
                                  layer.geometry.roundedCornersRadius);
         // TODO (b/270314344): Enable blurs in protected context.
         if (mBlurFilter && layerHasBlur(layer, ctModifiesAlpha) && !mInProtectedContext) {
-            std::unordered_map<uint32_t, sk_sp<SkImage>> cachedBlurs;
-
             // if multiple layers have blur, then we need to take a snapshot now because
             // only the lowest layer will have blurImage populated earlier
             if (!blurInput) {
@@ -837,12 +928,19 @@ void SkiaRenderEngine::drawLayersInternal(
 
             // TODO(b/182216890): Filter out empty layers earlier
             if (blurRect.width() > 0 && blurRect.height() > 0) {
-                if (layer.backgroundBlurRadius > 0) {
-                    ATRACE_NAME("BackgroundBlur");
-                    auto blurredImage = mBlurFilter->generate(grContext, layer.backgroundBlurRadius,
-                                                              blurInput, blurRect);
+                std::unordered_map<uint32_t, sk_sp<SkImage>> uncachedBlurs;
+                CachedBlur* cachedBlur =
+                        getCachedBlur(grContext, display, displayDimmingRatio, layers,
+                                      static_cast<size_t>(&layer - layers.data()), blurRect);
+                auto& cachedBlurs = cachedBlur ? cachedBlur->blurs : uncachedBlurs;
 
-                    cachedBlurs[layer.backgroundBlurRadius] = blurredImage;
+                if (layer.backgroundBlurRadius > 0) {
+                    auto& blurredImage = cachedBlurs[layer.backgroundBlurRadius];
+                    if (blurredImage == nullptr) {
+                        ATRACE_NAME("BackgroundBlur");
+                        blurredImage = mBlurFilter->generate(grContext, layer.backgroundBlurRadius,
+                                                             blurInput, blurRect);
+                    }
 
                     mBlurFilter->drawBlurRegion(canvas, bounds, layer.backgroundBlurRadius, 1.0f,
                                                 blurRect, blurredImage, blurInput);
@@ -1212,6 +1310,10 @@ void SkiaRenderEngine::dump(std::string& result) {
     StringAppendF(&result, "RenderEngine is in protected context: %d\n", mInProtectedContext);
     StringAppendF(&result, "RenderEngine shaders cached since last dump/primeCache: %d\n",
                   mSkSLCacheMonitor.shadersCachedSinceLastCall());
+    if (const auto* persistentCache = mSkSLCacheMonitor.getPersistentCache()) {
+        StringAppendF(&result, "RenderEngine persistent shader cache hits: %d, misses: %d\n",
+                      persistentCache->hitCount(), persistentCache->missCount());
+    }
 
     std::vector<ResourcePair> cpuResourceMap = {
             {"skia/sk_resource_cache/bitmap_", "Bitmaps"},
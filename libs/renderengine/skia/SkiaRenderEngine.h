@@ -28,11 +28,13 @@
 #include <renderengine/RenderEngine.h>
 #include <sys/types.h>
 
+#include <list>
 #include <mutex>
 #include <unordered_map>
 
 #include "AutoBackendTexture.h"
 #include "GrContextOptions.h"
+#include "PersistentShaderCache.h"
 #include "SkImageInfo.h"
 #include "SkiaRenderEngine.h"
 #include "android-base/macros.h"
@@ -62,7 +64,8 @@ public:
     SkiaRenderEngine(RenderEngineType type,
                      PixelFormat pixelFormat,
                      bool useColorManagement,
-                     bool supportsBackgroundBlur);
+                     bool supportsBackgroundBlur,
+                     const std::string& shaderCachePath);
     ~SkiaRenderEngine() override;
 
     std::future<void> primeCache() override final;
@@ -109,12 +112,17 @@ protected:
     bool isProtected() const { return mInProtectedContext; }
 
     // Implements PersistentCache as a way to monitor what SkSL shaders Skia has
-    // cached.
+    // cached. Also keeps them on disk when given a PersistentShaderCache.
     class SkSLCacheMonitor : public GrContextOptions::PersistentCache {
     public:
         SkSLCacheMonitor() = default;
         ~SkSLCacheMonitor() override = default;
 
+        void setPersistentCache(std::unique_ptr<PersistentShaderCache> persistentCache) {
+            mPersistentCache = std::move(persistentCache);
+        }
+        PersistentShaderCache* getPersistentCache() const { return mPersistentCache.get(); }
+
         sk_sp<SkData> load(const SkData& key) override;
 
         void store(const SkData& key, const SkData& data, const SkString& description) override;
@@ -130,6 +138,7 @@ protected:
     private:
         int mShadersCachedSinceLastCall = 0;
         int mTotalShadersCompiled = 0;
+        std::unique_ptr<PersistentShaderCache> mPersistentCache;
     };
 
 private:
@@ -165,6 +174,29 @@ private:
     };
     sk_sp<SkShader> createRuntimeEffectShader(const RuntimeEffectShaderParameters&);
 
+    // Blurs generated by a previous draw, reused while everything drawn behind the blurring layer
+    // is unchanged, e.g. a static wallpaper behind the notification shade.
+    struct CachedBlur {
+        GrDirectContext* context;
+        // The display, without its scissor, which does not change what is drawn behind a blur.
+        DisplaySettings display;
+        float displayDimmingRatio;
+        // The layers drawn behind the blur. Their buffers are only referenced by id and frame
+        // number, so that the cache does not keep them alive.
+        std::vector<LayerSettings> layersBelow;
+        std::vector<std::pair<uint64_t, uint64_t>> buffersBelow;
+        SkRect blurRect;
+        // Blurred images, keyed by blur radius.
+        std::unordered_map<uint32_t, sk_sp<SkImage>> blurs;
+    };
+    static constexpr size_t kMaxCachedBlurs = 4;
+
+    // Returns the cached blurs for the layer at layerIndex, which are empty if its backdrop
+    // changed since the last draw, or nullptr if the backdrop cannot be tracked.
+    CachedBlur* getCachedBlur(GrDirectContext* context, const DisplaySettings& display,
+                              float displayDimmingRatio, const std::vector<LayerSettings>& layers,
+                              size_t layerIndex, const SkRect& blurRect);
+
     const PixelFormat mDefaultPixelFormat;
     const bool mUseColorManagement;
 
@@ -188,6 +220,8 @@ private:
 
     sp<Fence> mLastDrawFence;
     BlurFilter* mBlurFilter = nullptr;
+    // Most recently used first.
+    std::list<CachedBlur> mCachedBlurs;
 
     // Object to capture commands send to Skia.
     std::unique_ptr<SkiaCapture> mCapture;
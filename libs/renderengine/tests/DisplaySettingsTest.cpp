@@ -22,6 +22,24 @@
 
 namespace android::renderengine {
 
+TEST(DisplaySettingsTest, scissor) {
+    DisplaySettings a, b;
+    ASSERT_EQ(a, b);
+
+    a.scissor = Rect(0, 0, 10, 10);
+
+    ASSERT_FALSE(a == b);
+}
+
+TEST(DisplaySettingsTest, lowPriority) {
+    DisplaySettings a, b;
+    ASSERT_EQ(a, b);
+
+    a.lowPriority = true;
+
+    ASSERT_FALSE(a == b);
+}
+
 TEST(DisplaySettingsTest, currentLuminanceNits) {
     DisplaySettings a, b;
     ASSERT_EQ(a, b);
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "PersistentShaderCacheTest"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../skia/PersistentShaderCache.h"
+
+namespace android::renderengine::skia {
+namespace {
+
+sk_sp<SkData> makeData(const std::string& string) {
+    return SkData::MakeWithCopy(string.data(), string.size());
+}
+
+struct PersistentShaderCacheTest : public testing::Test {
+    TemporaryDir mDir;
+    const std::string mPath = std::string(mDir.path) + "/shader_cache";
+    const sk_sp<SkData> mKey = makeData("key");
+    const sk_sp<SkData> mValue = makeData("value");
+};
+
+TEST_F(PersistentShaderCacheTest, loadsStoredEntry) {
+    PersistentShaderCache cache(mPath);
+
+    EXPECT_EQ(nullptr, cache.load(*mKey));
+    cache.store(*mKey, *mValue);
+    const sk_sp<SkData> value = cache.load(*mKey);
+    ASSERT_NE(nullptr, value);
+    EXPECT_TRUE(value->equals(mValue.get()));
+
+    EXPECT_EQ(1, cache.hitCount());
+    EXPECT_EQ(1, cache.missCount());
+}
+
+TEST_F(PersistentShaderCacheTest, keepsEntriesAcrossInstances) {
+    {
+        PersistentShaderCache cache(mPath);
+        cache.store(*mKey, *mValue);
+    }
+
+    PersistentShaderCache cache(mPath);
+    const sk_sp<SkData> value = cache.load(*mKey);
+    ASSERT_NE(nullptr, value);
+    EXPECT_TRUE(value->equals(mValue.get()));
+}
+
+TEST_F(PersistentShaderCacheTest, startsEmptyWithoutFile) {
+    PersistentShaderCache cache(mPath);
+    EXPECT_EQ(nullptr, cache.load(*mKey));
+}
+
+} // namespace
+} // namespace android::renderengine::skia
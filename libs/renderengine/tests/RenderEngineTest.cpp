@@ -1796,6 +1796,97 @@ TEST_P(RenderEngineTest, drawLayers_fillSmallLayerAndBlurBackground_colorSource)
     fillSmallLayerAndBlurBackground<ColorSourceVariant>();
 }
 
+TEST_P(RenderEngineTest, drawLayers_blurFollowsChangedBackground) {
+    if (!GetParam()->typeSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine();
+    if (!mRE->supportsBackgroundBlur()) {
+        GTEST_SKIP();
+    }
+
+    renderengine::DisplaySettings settings;
+    settings.outputDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    settings.physicalDisplay = fullscreenRect();
+    settings.clip = fullscreenRect();
+
+    renderengine::LayerSettings backgroundLayer;
+    backgroundLayer.sourceDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    backgroundLayer.geometry.boundaries = fullscreenRect().toFloatRect();
+    backgroundLayer.source.solidColor = half3(0.0f, 1.0f, 0.0f);
+    backgroundLayer.alpha = 1.0f;
+
+    renderengine::LayerSettings blurLayer;
+    blurLayer.sourceDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    blurLayer.geometry.boundaries = fullscreenRect().toFloatRect();
+    blurLayer.backgroundBlurRadius = 50;
+    blurLayer.alpha = 0;
+
+    const auto center = DEFAULT_DISPLAY_WIDTH / 2;
+    const Rect centerRect(center - 1, center - 5, center + 1, center + 5);
+
+    // Drawing the same backdrop again may reuse the blur...
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    expectBufferColor(centerRect, 0, 255, 0, 255, 2 /* tolerance */);
+
+    // ...but not once the backdrop changes.
+    backgroundLayer.source.solidColor = half3(1.0f, 0.0f, 0.0f);
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    expectBufferColor(centerRect, 255, 0, 0, 255, 2 /* tolerance */);
+}
+
+TEST_P(RenderEngineTest, drawLayers_blurFollowsRedrawnBackgroundBuffer) {
+    if (!GetParam()->typeSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine();
+    if (!mRE->supportsBackgroundBlur()) {
+        GTEST_SKIP();
+    }
+
+    renderengine::DisplaySettings settings;
+    settings.outputDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    settings.physicalDisplay = fullscreenRect();
+    settings.clip = fullscreenRect();
+
+    const auto buffer = allocateAndFillSourceBuffer(1, 1, ubyte4(0, 255, 0, 255));
+    renderengine::LayerSettings backgroundLayer;
+    backgroundLayer.sourceDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    backgroundLayer.geometry.boundaries = fullscreenRect().toFloatRect();
+    backgroundLayer.source.buffer.buffer = buffer;
+    backgroundLayer.source.buffer.isOpaque = true;
+    backgroundLayer.source.buffer.frameNumber = 1;
+    backgroundLayer.alpha = 1.0f;
+
+    renderengine::LayerSettings blurLayer;
+    blurLayer.sourceDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    blurLayer.geometry.boundaries = fullscreenRect().toFloatRect();
+    blurLayer.backgroundBlurRadius = 50;
+    blurLayer.alpha = 0;
+
+    const auto center = DEFAULT_DISPLAY_WIDTH / 2;
+    const Rect centerRect(center - 1, center - 5, center + 1, center + 5);
+
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    expectBufferColor(centerRect, 0, 255, 0, 255, 2 /* tolerance */);
+
+    // Producers redraw the same buffers, so only the frame number tells the content apart.
+    uint8_t* pixels;
+    buffer->getBuffer()->lock(GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN,
+                              reinterpret_cast<void**>(&pixels));
+    pixels[0] = 255;
+    pixels[1] = 0;
+    pixels[2] = 0;
+    pixels[3] = 255;
+    buffer->getBuffer()->unlock();
+    backgroundLayer.source.buffer.frameNumber = 2;
+
+    invokeDraw(settings, {backgroundLayer, blurLayer});
+    expectBufferColor(centerRect, 255, 0, 0, 255, 2 /* tolerance */);
+}
+
 TEST_P(RenderEngineTest, drawLayers_overlayCorners_colorSource) {
     if (!GetParam()->typeSupported()) {
         GTEST_SKIP();
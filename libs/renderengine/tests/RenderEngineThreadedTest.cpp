@@ -226,4 +226,50 @@ TEST_F(RenderEngineThreadedTest, drawLayers_protectedOutputBuffer) {
     ASSERT_TRUE(result.ok());
 }
 
+TEST_F(RenderEngineThreadedTest, drawLayers_lowPriorityRunsAfterQueuedWork) {
+    renderengine::DisplaySettings blockingSettings{.namePlusId = "blocking"};
+    renderengine::DisplaySettings lowPrioritySettings{.namePlusId = "lowPriority",
+                                                      .lowPriority = true};
+    renderengine::DisplaySettings settings{.namePlusId = "normal"};
+    std::vector<renderengine::LayerSettings> layers;
+    std::shared_ptr<renderengine::ExternalTexture> buffer = std::make_shared<
+            renderengine::impl::
+                    ExternalTexture>(sp<GraphicBuffer>::make(), *mRenderEngine,
+                                     renderengine::impl::ExternalTexture::Usage::READABLE |
+                                             renderengine::impl::ExternalTexture::Usage::WRITEABLE);
+
+    // Hold the RenderEngine thread in the first draw until the other two are queued.
+    std::promise<void> unblock;
+    std::shared_future<void> unblocked = unblock.get_future().share();
+    std::vector<std::string> drawOrder;
+
+    EXPECT_CALL(*mRenderEngine, useProtectedContext(false)).Times(3);
+    EXPECT_CALL(*mRenderEngine, drawLayersInternal)
+            .Times(3)
+            .WillRepeatedly([&](const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
+                                const renderengine::DisplaySettings& display,
+                                const std::vector<renderengine::LayerSettings>&,
+                                const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                                base::unique_fd&&) {
+                if (display.namePlusId == "blocking") {
+                    unblocked.wait();
+                }
+                drawOrder.push_back(display.namePlusId);
+                resultPromise->set_value(Fence::NO_FENCE);
+            });
+
+    ftl::Future<FenceResult> blockingFuture =
+            mThreadedRE->drawLayers(blockingSettings, layers, buffer, false, base::unique_fd());
+    ftl::Future<FenceResult> lowPriorityFuture =
+            mThreadedRE->drawLayers(lowPrioritySettings, layers, buffer, false, base::unique_fd());
+    ftl::Future<FenceResult> future =
+            mThreadedRE->drawLayers(settings, layers, buffer, false, base::unique_fd());
+    unblock.set_value();
+
+    ASSERT_TRUE(blockingFuture.get().ok());
+    ASSERT_TRUE(future.get().ok());
+    ASSERT_TRUE(lowPriorityFuture.get().ok());
+    EXPECT_THAT(drawOrder, testing::ElementsAre("blocking", "normal", "lowPriority"));
+}
+
 } // namespace android
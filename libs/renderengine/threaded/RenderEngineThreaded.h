@@ -34,6 +34,9 @@ using CreateInstanceFactory = std::function<std::unique_ptr<renderengine::Render
  * This class extends a basic RenderEngine class. It contains a thread. Each time a function of
  * this class is called, we create a lambda function that is put on a queue. The main thread then
  * executes the functions in order.
+ *
+ * Work that no frame is waiting on (low priority draws, texture mapping and cache priming) goes
+ * on a second queue, which only runs when the first one is empty. Each queue keeps its own order.
  */
 class RenderEngineThreaded : public RenderEngine {
 public:
@@ -100,6 +103,7 @@ private:
 
     using Work = std::function<void(renderengine::RenderEngine&)>;
     mutable std::queue<Work> mFunctionCalls GUARDED_BY(mThreadMutex);
+    mutable std::queue<Work> mLowPriorityFunctionCalls GUARDED_BY(mThreadMutex);
     mutable std::condition_variable mCondition;
 
     // Used to allow select thread safe methods to be accessed without requiring the
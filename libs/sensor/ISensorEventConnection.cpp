@@ -27,6 +27,7 @@
 #include <binder/IInterface.h>
 
 #include <sensor/BitTube.h>
+#include <sensor/SensorEventRing.h>
 
 namespace android {
 // ----------------------------------------------------------------------------
@@ -38,6 +39,7 @@ enum {
     FLUSH_SENSOR,
     CONFIGURE_CHANNEL,
     DESTROY,
+    GET_SENSOR_EVENT_RING,
 };
 
 class BpSensorEventConnection : public BpInterface<ISensorEventConnection>
@@ -98,6 +100,17 @@ public:
         return reply.readInt32();
     }
 
+    virtual sp<SensorEventRing> getSensorEventRing() {
+        Parcel data, reply;
+        data.writeInterfaceToken(ISensorEventConnection::getInterfaceDescriptor());
+        status_t err = remote()->transact(GET_SENSOR_EVENT_RING, data, &reply);
+        if (err != NO_ERROR || reply.readInt32() == 0) {
+            return nullptr;
+        }
+        sp<SensorEventRing> ring = new SensorEventRing(reply);
+        return ring->initCheck() == NO_ERROR ? ring : nullptr;
+    }
+
     virtual void onLastStrongRef(const void* id) {
         destroy();
         BpInterface<ISensorEventConnection>::onLastStrongRef(id);
@@ -166,6 +179,15 @@ status_t BnSensorEventConnection::onTransact(
             destroy();
             return NO_ERROR;
         }
+        case GET_SENSOR_EVENT_RING: {
+            CHECK_INTERFACE(ISensorEventConnection, data, reply);
+            sp<SensorEventRing> ring(getSensorEventRing());
+            reply->writeInt32(ring != nullptr);
+            if (ring != nullptr) {
+                ring->writeToParcel(reply);
+            }
+            return NO_ERROR;
+        }
 
     }
     return BBinder::onTransact(code, data, reply, flags);
@@ -50,6 +50,7 @@ SensorEventQueue::~SensorEventQueue() {
 void SensorEventQueue::onFirstRef()
 {
     mSensorChannel = mSensorEventConnection->getSensorChannel();
+    mSensorEventRing = mSensorEventConnection->getSensorEventRing();
 }
 
 int SensorEventQueue::getFd() const
@@ -64,6 +65,9 @@ ssize_t SensorEventQueue::write(const sp<BitTube>& tube,
 }
 
 ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
+    if (mSensorEventRing != nullptr) {
+        return readFromRing(events, numEvents);
+    }
     if (mAvailable == 0) {
         ssize_t err = BitTube::recvObjects(mSensorChannel,
                 mRecBuffer, MAX_RECEIVE_BUFFER_EVENT_COUNT);
@@ -80,6 +84,30 @@ ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     return static_cast<ssize_t>(count);
 }
 
+ssize_t SensorEventQueue::readFromRing(ASensorEvent* events, size_t numEvents) {
+    size_t count = mSensorEventRing->read(events, numEvents);
+    if (count < numEvents) {
+        // The ring is empty. Consume the wakeups before going idle, so that one sent for events
+        // written after the ring was found empty keeps the fd readable.
+        SensorEventRing::WakeMessage message;
+        while (::recv(getFd(), &message, sizeof(message), MSG_DONTWAIT) > 0) {
+        }
+        if (!mSensorEventRing->markReaderIdle()) {
+            count += mSensorEventRing->read(events + count, numEvents - count);
+        }
+    } else {
+        // Events may remain. Keep the pending wakeup, so that the fd stays readable, and ask for
+        // another one in case the caller read without being woken up.
+        mSensorEventRing->markReaderIdle();
+    }
+    if (count > 0 && mSensorEventRing->takeWriterBlocked()) {
+        SensorEventRing::WakeMessage message = SensorEventRing::kWakeMessage;
+        ssize_t size = ::send(getFd(), &message, sizeof(message), MSG_DONTWAIT | MSG_NOSIGNAL);
+        ALOGE_IF(size < 0, "readFromRing: wakeup failure %zd", size);
+    }
+    return static_cast<ssize_t>(count);
+}
+
 sp<Looper> SensorEventQueue::getLooper() const
 {
     Mutex::Autolock _l(mLock);
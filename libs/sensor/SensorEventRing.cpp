@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sensor/SensorEventRing.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <android/sensor.h>
+#include <binder/Parcel.h>
+#include <log/log.h>
+
+namespace android {
+// ----------------------------------------------------------------------------
+
+// Lives at the start of the shared memory, followed by the events. The indices count events
+// and wrap around at 2^32, which is why the capacity is a power of two. Each one is only written
+// by one side and kept on its own cache line.
+struct SensorEventRing::Header {
+    alignas(64) std::atomic<uint32_t> writeIndex;
+    std::atomic<uint32_t> readerIdle;
+    alignas(64) std::atomic<uint32_t> readIndex;
+    std::atomic<uint32_t> writerBlocked;
+};
+
+SensorEventRing::SensorEventRing(size_t capacity)
+    : mFd(-1), mHeader(nullptr), mEvents(nullptr), mMappedSize(0), mCapacity(0), mIndex(0)
+{
+    if (capacity == 0 || capacity > UINT32_MAX / 2) {
+        mFd = -EINVAL;
+        return;
+    }
+    while ((capacity & (capacity - 1)) != 0) {
+        capacity += capacity & -capacity;
+    }
+    const size_t size = sizeof(Header) + capacity * sizeof(ASensorEvent);
+    mFd = memfd_create("sensor_event_ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mFd < 0) {
+        mFd = -errno;
+        ALOGE("SensorEventRing: memfd_create failed (%s)", strerror(-mFd));
+        return;
+    }
+    // The reader must not be able to resize the ring under the writer.
+    if (ftruncate(mFd, size) != 0 ||
+        fcntl(mFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        int err = -errno;
+        ALOGE("SensorEventRing: can't size ring (%s)", strerror(-err));
+        close(mFd);
+        mFd = err;
+        return;
+    }
+    status_t err = map(size);
+    if (err != NO_ERROR) {
+        close(mFd);
+        mFd = err;
+        return;
+    }
+    // The reader starts out waiting for the first events.
+    mHeader->readerIdle.store(1, std::memory_order_relaxed);
+}
+
+SensorEventRing::SensorEventRing(const Parcel& data)
+    : mFd(-1), mHeader(nullptr), mEvents(nullptr), mMappedSize(0), mCapacity(0), mIndex(0)
+{
+    mFd = fcntl(data.readFileDescriptor(), F_DUPFD_CLOEXEC, 0);
+    if (mFd < 0) {
+        mFd = -errno;
+        ALOGE("SensorEventRing(Parcel): can't dup filedescriptor (%s)", strerror(-mFd));
+        return;
+    }
+    struct stat st;
+    if (fstat(mFd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header)) ||
+        (st.st_size - sizeof(Header)) % sizeof(ASensorEvent) != 0) {
+        ALOGE("SensorEventRing(Parcel): bad ring");
+        close(mFd);
+        mFd = BAD_VALUE;
+        return;
+    }
+    status_t err = map(st.st_size);
+    if (err != NO_ERROR) {
+        close(mFd);
+        mFd = err;
+        return;
+    }
+    mIndex = mHeader->readIndex.load(std::memory_order_relaxed);
+}
+
+SensorEventRing::~SensorEventRing()
+{
+    if (mHeader != nullptr)
+        munmap(mHeader, mMappedSize);
+
+    if (mFd >= 0)
+        close(mFd);
+}
+
+status_t SensorEventRing::map(size_t size)
+{
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+    static_assert(sizeof(Header) % alignof(ASensorEvent) == 0);
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (addr == MAP_FAILED) {
+        status_t err = -errno;
+        ALOGE("SensorEventRing: mmap failed (%s)", strerror(-err));
+        return err;
+    }
+    mHeader = static_cast<Header*>(addr);
+    mEvents = reinterpret_cast<ASensorEvent*>(static_cast<char*>(addr) + sizeof(Header));
+    mMappedSize = size;
+    mCapacity = (size - sizeof(Header)) / sizeof(ASensorEvent);
+    if (mCapacity == 0 || (mCapacity & (mCapacity - 1)) != 0) {
+        ALOGE("SensorEventRing: capacity %u is not a power of two", mCapacity);
+        return BAD_VALUE;
+    }
+    return NO_ERROR;
+}
+
+status_t SensorEventRing::initCheck() const
+{
+    if (mFd < 0) {
+        return status_t(mFd);
+    }
+    return mCapacity > 0 ? NO_ERROR : BAD_VALUE;
+}
+
+size_t SensorEventRing::getCapacity() const
+{
+    return mCapacity;
+}
+
+ssize_t SensorEventRing::write(ASensorEvent const* events, size_t count, bool* wakeReader)
+{
+    *wakeReader = false;
+    if (count > mCapacity) {
+        return -EAGAIN;
+    }
+    // A used count larger than the ring means the reader scribbled over its index, which only
+    // hurts the reader, so just treat the ring as full.
+    uint32_t used = mIndex - mHeader->readIndex.load(std::memory_order_acquire);
+    if (used > mCapacity || count > mCapacity - used) {
+        // Ask the reader to signal once it makes room, then check again in case it just did.
+        mHeader->writerBlocked.store(1, std::memory_order_seq_cst);
+        used = mIndex - mHeader->readIndex.load(std::memory_order_seq_cst);
+        if (used > mCapacity || count > mCapacity - used) {
+            return -EAGAIN;
+        }
+    }
+
+    const size_t offset = mIndex % mCapacity;
+    const size_t first = std::min<size_t>(count, mCapacity - offset);
+    memcpy(mEvents + offset, events, first * sizeof(ASensorEvent));
+    memcpy(mEvents, events + first, (count - first) * sizeof(ASensorEvent));
+    mIndex += count;
+    mHeader->writeIndex.store(mIndex, std::memory_order_seq_cst);
+
+    *wakeReader = mHeader->readerIdle.exchange(0, std::memory_order_seq_cst) != 0;
+    return count;
+}
+
+size_t SensorEventRing::read(ASensorEvent* events, size_t count)
+{
+    uint32_t available = mHeader->writeIndex.load(std::memory_order_acquire) - mIndex;
+    if (available > mCapacity) {
+        ALOGE("SensorEventRing: write index out of range");
+        return 0;
+    }
+    count = std::min<size_t>(count, available);
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t offset = mIndex % mCapacity;
+    const size_t first = std::min<size_t>(count, mCapacity - offset);
+    memcpy(events, mEvents + offset, first * sizeof(ASensorEvent));
+    memcpy(events + first, mEvents, (count - first) * sizeof(ASensorEvent));
+    mIndex += count;
+    mHeader->readIndex.store(mIndex, std::memory_order_seq_cst);
+    return count;
+}
+
+bool SensorEventRing::markReaderIdle()
+{
+    mHeader->readerIdle.store(1, std::memory_order_seq_cst);
+    return mHeader->writeIndex.load(std::memory_order_seq_cst) == mIndex;
+}
+
+bool SensorEventRing::takeWriterBlocked()
+{
+    if (mHeader->writerBlocked.load(std::memory_order_seq_cst) == 0) {
+        return false;
+    }
+    return mHeader->writerBlocked.exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+status_t SensorEventRing::writeToParcel(Parcel* reply) const
+{
+    if (mFd < 0)
+        return -EINVAL;
+
+    return reply->writeDupFileDescriptor(mFd);
+}
+
+// ----------------------------------------------------------------------------
+}; // namespace android
@@ -25,6 +25,7 @@
 #include <utils/Mutex.h>
 
 #include <sensor/BitTube.h>
+#include <sensor/SensorEventRing.h>
 
 // ----------------------------------------------------------------------------
 #define WAKE_UP_SENSOR_EVENT_NEEDS_ACK (1U << 31)
@@ -102,8 +103,11 @@ public:
 
 private:
     sp<Looper> getLooper() const;
+    ssize_t readFromRing(ASensorEvent* events, size_t numEvents);
     sp<ISensorEventConnection> mSensorEventConnection;
     sp<BitTube> mSensorChannel;
+    // If set, events arrive through this rather than mSensorChannel.
+    sp<SensorEventRing> mSensorEventRing;
     mutable Mutex mLock;
     mutable sp<Looper> mLooper;
     ASensorEvent* mRecBuffer;
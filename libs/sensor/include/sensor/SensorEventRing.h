@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+
+struct ASensorEvent;
+
+namespace android {
+// ----------------------------------------------------------------------------
+class Parcel;
+
+// A single producer, single consumer ring of sensor events in shared memory, written by
+// sensorservice and read by a SensorEventQueue. The BitTube of the connection is only used to
+// wake the other side up: the writer signals it when the reader has gone idle, and the reader
+// signals back when the writer found the ring full. Both signals are a kWakeMessage.
+class SensorEventRing : public RefBase
+{
+public:
+    typedef uint64_t WakeMessage;
+    static constexpr WakeMessage kWakeMessage = 1;
+
+    // creates a ring holding at least capacity events, for the writer
+    explicit SensorEventRing(size_t capacity);
+
+    // maps the ring parceled by writeToParcel, for the reader
+    explicit SensorEventRing(const Parcel& data);
+    virtual ~SensorEventRing();
+
+    // check state after construction
+    status_t initCheck() const;
+
+    size_t getCapacity() const;
+
+    // Writes all of events, or fails with -EAGAIN if they don't fit. After a failure, the reader
+    // signals the writer once it has made room. Sets wakeReader if the reader went idle and must
+    // be signaled.
+    ssize_t write(ASensorEvent const* events, size_t count, bool* wakeReader);
+
+    // Reads at most count events, and returns how many were read.
+    size_t read(ASensorEvent* events, size_t count);
+
+    // To be called before waiting for the writer's signal, which is then sent on the next write.
+    // The reader starts out idle. Returns false if events have been written meanwhile, in which
+    // case the reader must not wait.
+    bool markReaderIdle();
+
+    // Returns true, once, if the writer found the ring full and needs to be signaled now that
+    // read() made room.
+    bool takeWriterBlocked();
+
+    // parcels this ring
+    status_t writeToParcel(Parcel* reply) const;
+
+private:
+    struct Header;
+
+    status_t map(size_t size);
+
+    int mFd;
+    Header* mHeader;
+    ASensorEvent* mEvents;
+    size_t mMappedSize;
+    uint32_t mCapacity;
+    // Each side only trusts its own index, never the copy the other side can modify.
+    uint32_t mIndex;
+};
+
+// ----------------------------------------------------------------------------
+}; // namespace android
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <gtest/gtest.h>
+
+#include <android/sensor.h>
+#include <binder/Parcel.h>
+#include <sensor/BitTube.h>
+#include <sensor/ISensorEventConnection.h>
+#include <sensor/SensorEventQueue.h>
+#include <sensor/SensorEventRing.h>
+
+#include <vector>
+
+namespace android {
+
+class SensorEventRingTest : public ::testing::Test {
+protected:
+    static constexpr size_t kCapacity = 4;
+
+    virtual void SetUp() override {
+        mWriter = new SensorEventRing(kCapacity);
+        ASSERT_EQ(NO_ERROR, mWriter->initCheck());
+        Parcel parcel;
+        ASSERT_EQ(NO_ERROR, mWriter->writeToParcel(&parcel));
+        parcel.setDataPosition(0);
+        mReader = new SensorEventRing(parcel);
+        ASSERT_EQ(NO_ERROR, mReader->initCheck());
+    }
+
+    ssize_t write(int64_t firstTimestamp, size_t count, bool* wakeReader) {
+        std::vector<ASensorEvent> events(count);
+        for (size_t i = 0; i < count; i++) {
+            events[i].timestamp = firstTimestamp + i;
+        }
+        return mWriter->write(events.data(), count, wakeReader);
+    }
+
+    std::vector<int64_t> read(size_t count) {
+        std::vector<ASensorEvent> events(count);
+        std::vector<int64_t> timestamps;
+        size_t read = mReader->read(events.data(), count);
+        for (size_t i = 0; i < read; i++) {
+            timestamps.push_back(events[i].timestamp);
+        }
+        return timestamps;
+    }
+
+    sp<SensorEventRing> mWriter;
+    sp<SensorEventRing> mReader;
+};
+
+TEST_F(SensorEventRingTest, RoundsCapacityUpToPowerOfTwo) {
+    sp<SensorEventRing> ring = new SensorEventRing(5);
+    ASSERT_EQ(NO_ERROR, ring->initCheck());
+    EXPECT_EQ(8u, ring->getCapacity());
+    EXPECT_EQ(kCapacity, mReader->getCapacity());
+}
+
+TEST_F(SensorEventRingTest, ReadsEventsInOrderAcrossWrapAround) {
+    bool wakeReader;
+    ASSERT_EQ(3, write(0, 3, &wakeReader));
+    EXPECT_EQ((std::vector<int64_t>{0, 1}), read(2));
+    ASSERT_EQ(3, write(3, 3, &wakeReader));
+    EXPECT_EQ((std::vector<int64_t>{2, 3, 4, 5}), read(8));
+    EXPECT_TRUE(read(8).empty());
+}
+
+TEST_F(SensorEventRingTest, WakesReaderOnlyWhenIdle) {
+    // The reader starts out idle.
+    bool wakeReader;
+    ASSERT_EQ(1, write(0, 1, &wakeReader));
+    EXPECT_TRUE(wakeReader);
+    ASSERT_EQ(1, write(1, 1, &wakeReader));
+    EXPECT_FALSE(wakeReader);
+
+    EXPECT_EQ(2u, read(8).size());
+    EXPECT_TRUE(mReader->markReaderIdle());
+    ASSERT_EQ(1, write(2, 1, &wakeReader));
+    EXPECT_TRUE(wakeReader);
+    ASSERT_EQ(1, write(3, 1, &wakeReader));
+    EXPECT_FALSE(wakeReader);
+
+    // Events written before the reader waits must not be missed.
+    EXPECT_FALSE(mReader->markReaderIdle());
+}
+
+TEST_F(SensorEventRingTest, FullRingAsksReaderForWakeup) {
+    bool wakeReader;
+    ASSERT_EQ(static_cast<ssize_t>(kCapacity), write(0, kCapacity, &wakeReader));
+    EXPECT_FALSE(mReader->takeWriterBlocked());
+    EXPECT_EQ(-EAGAIN, write(kCapacity, 1, &wakeReader));
+
+    EXPECT_EQ(1u, read(1).size());
+    EXPECT_TRUE(mReader->takeWriterBlocked());
+    EXPECT_FALSE(mReader->takeWriterBlocked());
+    EXPECT_EQ(1, write(kCapacity, 1, &wakeReader));
+}
+
+// Delivers events to a SensorEventQueue through a ring, the way sensorservice does.
+class FakeSensorEventConnection : public BnSensorEventConnection {
+public:
+    static constexpr size_t kCapacity = 8;
+
+    FakeSensorEventConnection() : mChannel(new BitTube()), mWriter(new SensorEventRing(kCapacity)) {
+        Parcel parcel;
+        mWriter->writeToParcel(&parcel);
+        parcel.setDataPosition(0);
+        mReader = new SensorEventRing(parcel);
+    }
+
+    ssize_t write(int64_t firstTimestamp, size_t count) {
+        std::vector<ASensorEvent> events(count);
+        for (size_t i = 0; i < count; i++) {
+            events[i].timestamp = firstTimestamp + i;
+        }
+        bool wakeReader = false;
+        ssize_t size = mWriter->write(events.data(), count, &wakeReader);
+        if (wakeReader) {
+            SensorEventRing::WakeMessage message = SensorEventRing::kWakeMessage;
+            ::send(mChannel->getSendFd(), &message, sizeof(message), MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+        return size;
+    }
+
+    sp<BitTube> getSensorChannel() const override { return mChannel; }
+    status_t enableDisable(int, bool, nsecs_t, nsecs_t, int) override { return NO_ERROR; }
+    status_t setEventRate(int, nsecs_t) override { return NO_ERROR; }
+    status_t flush() override { return NO_ERROR; }
+    int32_t configureChannel(int32_t, int32_t) override { return NO_ERROR; }
+    sp<SensorEventRing> getSensorEventRing() override { return mReader; }
+
+protected:
+    void destroy() override {}
+
+private:
+    sp<BitTube> mChannel;
+    sp<SensorEventRing> mWriter;
+    sp<SensorEventRing> mReader;
+};
+
+class SensorEventQueueRingTest : public ::testing::Test {
+protected:
+    virtual void SetUp() override {
+        mConnection = new FakeSensorEventConnection();
+        mQueue = new SensorEventQueue(mConnection);
+    }
+
+    bool isReadable() const {
+        struct pollfd fd = {.fd = mQueue->getFd(), .events = POLLIN};
+        return poll(&fd, 1, 0) == 1 && (fd.revents & POLLIN);
+    }
+
+    std::vector<int64_t> read(size_t count) {
+        std::vector<ASensorEvent> events(count);
+        std::vector<int64_t> timestamps;
+        ssize_t read = mQueue->read(events.data(), count);
+        for (ssize_t i = 0; i < read; i++) {
+            timestamps.push_back(events[i].timestamp);
+        }
+        return timestamps;
+    }
+
+    sp<FakeSensorEventConnection> mConnection;
+    sp<SensorEventQueue> mQueue;
+};
+
+TEST_F(SensorEventQueueRingTest, FirstEventWakesQueue) {
+    EXPECT_FALSE(isReadable());
+    ASSERT_EQ(1, mConnection->write(0, 1));
+    EXPECT_TRUE(isReadable());
+
+    EXPECT_EQ((std::vector<int64_t>{0}), read(8));
+    EXPECT_TRUE(read(8).empty());
+    EXPECT_FALSE(isReadable());
+
+    ASSERT_EQ(1, mConnection->write(1, 1));
+    EXPECT_TRUE(isReadable());
+    EXPECT_EQ((std::vector<int64_t>{1}), read(8));
+}
+
+TEST_F(SensorEventQueueRingTest, StaysReadableAfterPartialRead) {
+    ASSERT_EQ(3, mConnection->write(0, 3));
+    EXPECT_EQ((std::vector<int64_t>{0}), read(1));
+    EXPECT_TRUE(isReadable());
+    EXPECT_EQ((std::vector<int64_t>{1}), read(1));
+    EXPECT_TRUE(isReadable());
+
+    // Events written after a partial read still wake the queue up.
+    ASSERT_EQ(1, mConnection->write(3, 1));
+    EXPECT_EQ((std::vector<int64_t>{2, 3}), read(8));
+    EXPECT_TRUE(read(8).empty());
+    EXPECT_FALSE(isReadable());
+
+    ASSERT_EQ(1, mConnection->write(4, 1));
+    EXPECT_TRUE(isReadable());
+    EXPECT_EQ((std::vector<int64_t>{4}), read(8));
+}
+
+} // namespace android
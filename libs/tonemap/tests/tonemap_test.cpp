@@ -61,6 +61,25 @@ TEST_F(TonemapTest, generateShaderSkSLUniforms_containsDefaultUniforms) {
     EXPECT_GT(contentLumFloat, 0);
 }
 
+TEST_F(TonemapTest, generateShaderSkSLUniforms_containsPrecomputedCurve) {
+    tonemap::Metadata metadata{.displayMaxLuminance = 500.f, .contentMaxLuminance = 4000.f};
+    const auto uniforms = tonemap::getToneMapper()->generateShaderSkSLUniforms(metadata);
+
+    // The uniforms the PQ shader reads instead of evaluating the curve's knees for every pixel.
+    for (const char* name : {"in_libtonemap_greyNorm2", "in_libtonemap_greyNorm3",
+                             "in_libtonemap_slope2", "in_libtonemap_slope3"}) {
+        const auto uniform =
+                std::find_if(uniforms.cbegin(), uniforms.cend(),
+                             [name](const auto& data) { return data.name == name; });
+        ASSERT_NE(uniforms.cend(), uniform) << name;
+
+        float value = 0.f;
+        std::memcpy(&value, uniform->value.data(), uniform->value.size());
+        EXPECT_FALSE(std::isnan(value)) << name;
+        EXPECT_GT(value, 0) << name;
+    }
+}
+
 TEST_F(TonemapTest, generateTonemapGainShaderSkSL_containsEntryPointForPQ) {
     const auto shader =
             tonemap::getToneMapper()
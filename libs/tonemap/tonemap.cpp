@@ -457,6 +457,46 @@ private:
         return nits <= 1.0 / 12.0 ? std::sqrt(3.0 * nits) : a * std::log(12.0 * nits - b) + c;
     }
 
+    // Hardcode the max content luminance to a "reasonable" level
+    static const constexpr double kContentMaxLuminance = 4000.0;
+
+    // Knee points of the curve tone mapping PQ down to SDR. They only depend on the luminance
+    // ranges, so they are computed once rather than for every pixel.
+    struct PQToSdrCurve {
+        double x1;
+        double y2;
+        double y3;
+        double greyNorm2;
+        double greyNorm3;
+        double slope2;
+        double slope3;
+    };
+
+    PQToSdrCurve computePQToSdrCurve(double maxOutLumi) {
+        const double maxInLumi = kContentMaxLuminance;
+
+        const double x1 = maxOutLumi * 0.65;
+        const double y1 = x1;
+
+        const double x3 = maxInLumi;
+        const double y3 = maxOutLumi;
+
+        const double x2 = x1 + (x3 - x1) * 4.0 / 17.0;
+        const double y2 = maxOutLumi * 0.9;
+
+        const double greyNorm1 = OETF_ST2084(x1);
+        const double greyNorm2 = OETF_ST2084(x2);
+        const double greyNorm3 = OETF_ST2084(x3);
+
+        return {.x1 = x1,
+                .y2 = y2,
+                .y3 = y3,
+                .greyNorm2 = greyNorm2,
+                .greyNorm3 = greyNorm3,
+                .slope2 = (y2 - y1) / (greyNorm2 - greyNorm1),
+                .slope3 = (y3 - y2) / (greyNorm3 - greyNorm2)};
+    }
+
 public:
     std::string generateTonemapGainShaderSkSL(
             aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
@@ -470,6 +510,10 @@ public:
                 uniform float in_libtonemap_displayMaxLuminance;
                 uniform float in_libtonemap_inputMaxLuminance;
                 uniform float in_libtonemap_hlgGamma;
+                uniform float in_libtonemap_greyNorm2;
+                uniform float in_libtonemap_greyNorm3;
+                uniform float in_libtonemap_slope2;
+                uniform float in_libtonemap_slope3;
             )");
         switch (sourceDataspaceInt & kTransferMask) {
             case kTransferST2084:
@@ -517,21 +561,8 @@ public:
                                     float nits = maxRGB;
 
                                     float x1 = maxOutLumi * 0.65;
-                                    float y1 = x1;
-
-                                    float x3 = maxInLumi;
-                                    float y3 = maxOutLumi;
-
-                                    float x2 = x1 + (x3 - x1) * 4.0 / 17.0;
                                     float y2 = maxOutLumi * 0.9;
-
-                                    float greyNorm1 = libtonemap_OETFTone(x1);
-                                    float greyNorm2 = libtonemap_OETFTone(x2);
-                                    float greyNorm3 = libtonemap_OETFTone(x3);
-
-                                    float slope1 = 0;
-                                    float slope2 = (y2 - y1) / (greyNorm2 - greyNorm1);
-                                    float slope3 = (y3 - y2 ) / (greyNorm3 - greyNorm2);
+                                    float y3 = maxOutLumi;
 
                                     if (nits < x1) {
                                         return nits;
@@ -543,10 +574,12 @@ public:
 
                                     float greyNits = libtonemap_OETFTone(nits);
 
-                                    if (greyNits <= greyNorm2) {
-                                        nits = (greyNits - greyNorm2) * slope2 + y2;
-                                    } else if (greyNits <= greyNorm3) {
-                                        nits = (greyNits - greyNorm3) * slope3 + y3;
+                                    if (greyNits <= in_libtonemap_greyNorm2) {
+                                        nits = (greyNits - in_libtonemap_greyNorm2)
+                                                * in_libtonemap_slope2 + y2;
+                                    } else if (greyNits <= in_libtonemap_greyNorm3) {
+                                        nits = (greyNits - in_libtonemap_greyNorm3)
+                                                * in_libtonemap_slope3 + y3;
                                     } else {
                                         nits = maxOutLumi;
                                     }
@@ -612,10 +645,9 @@ public:
     }
 
     std::vector<ShaderUniform> generateShaderSkSLUniforms(const Metadata& metadata) override {
-        // Hardcode the max content luminance to a "reasonable" level
-        static const constexpr float kContentMaxLuminance = 4000.f;
+        const auto curve = computePQToSdrCurve(metadata.displayMaxLuminance);
         std::vector<ShaderUniform> uniforms;
-        uniforms.reserve(3);
+        uniforms.reserve(7);
         uniforms.push_back({.name = "in_libtonemap_displayMaxLuminance",
                             .value = buildUniformValue<float>(metadata.displayMaxLuminance)});
         uniforms.push_back({.name = "in_libtonemap_inputMaxLuminance",
@@ -623,6 +655,14 @@ public:
         uniforms.push_back({.name = "in_libtonemap_hlgGamma",
                             .value = buildUniformValue<float>(
                                     computeHlgGamma(metadata.currentDisplayLuminance))});
+        uniforms.push_back({.name = "in_libtonemap_greyNorm2",
+                            .value = buildUniformValue<float>(curve.greyNorm2)});
+        uniforms.push_back({.name = "in_libtonemap_greyNorm3",
+                            .value = buildUniformValue<float>(curve.greyNorm3)});
+        uniforms.push_back({.name = "in_libtonemap_slope2",
+                            .value = buildUniformValue<float>(curve.slope2)});
+        uniforms.push_back({.name = "in_libtonemap_slope3",
+                            .value = buildUniformValue<float>(curve.slope3)});
         return uniforms;
     }
 
@@ -634,24 +674,10 @@ public:
         gains.reserve(colors.size());
 
         // Precompute constants for HDR->SDR tonemapping parameters
-        constexpr double maxInLumi = 4000;
+        constexpr double maxInLumi = kContentMaxLuminance;
         const double maxOutLumi = metadata.displayMaxLuminance;
-
-        const double x1 = maxOutLumi * 0.65;
-        const double y1 = x1;
-
-        const double x3 = maxInLumi;
-        const double y3 = maxOutLumi;
-
-        const double x2 = x1 + (x3 - x1) * 4.0 / 17.0;
-        const double y2 = maxOutLumi * 0.9;
-
-        const double greyNorm1 = OETF_ST2084(x1);
-        const double greyNorm2 = OETF_ST2084(x2);
-        const double greyNorm3 = OETF_ST2084(x3);
-
-        const double slope2 = (y2 - y1) / (greyNorm2 - greyNorm1);
-        const double slope3 = (y3 - y2) / (greyNorm3 - greyNorm2);
+        const auto [x1, y2, y3, greyNorm2, greyNorm3, slope2, slope3] =
+                computePQToSdrCurve(maxOutLumi);
 
         const double hlgGamma = computeHlgGamma(metadata.currentDisplayLuminance);
 
@@ -37,6 +37,15 @@ namespace android {
 
 const sp<Fence> Fence::NO_FENCE = sp<Fence>(new Fence);
 
+namespace {
+
+std::atomic<uint64_t> sMergeCount{0};
+std::atomic<uint64_t> sMergeElidedInvalidCount{0};
+std::atomic<uint64_t> sMergeElidedSignaledCount{0};
+std::atomic<uint64_t> sMergeFailedCount{0};
+
+} // namespace
+
 Fence::Fence(int fenceFd) :
     mFenceFd(fenceFd) {
 }
@@ -51,7 +60,11 @@ status_t Fence::wait(int timeout) {
         return NO_ERROR;
     }
     int err = sync_wait(mFenceFd, timeout);
-    return err < 0 ? -errno : status_t(NO_ERROR);
+    if (err < 0) {
+        return -errno;
+    }
+    mKnownSignaled.store(true, std::memory_order_relaxed);
+    return NO_ERROR;
 }
 
 status_t Fence::waitForever(const char* logname) {
@@ -84,32 +97,43 @@ status_t Fence::waitForever(const char* logname) {
 
         err = sync_wait(mFenceFd, TIMEOUT_NEVER);
     }
-    return err < 0 ? -errno : status_t(NO_ERROR);
+    if (err < 0) {
+        return -errno;
+    }
+    mKnownSignaled.store(true, std::memory_order_relaxed);
+    return NO_ERROR;
 }
 
 sp<Fence> Fence::merge(const char* name, const sp<Fence>& f1,
         const sp<Fence>& f2) {
     ATRACE_CALL();
-    int result;
-    // Merge the two fences.  In the case where one of the fences is not a
-    // valid fence (e.g. NO_FENCE) we merge the one valid fence with itself so
-    // that a new fence with the given name is created.
-    if (f1->isValid() && f2->isValid()) {
-        result = sync_merge(name, f1->mFenceFd, f2->mFenceFd);
-    } else if (f1->isValid()) {
-        result = sync_merge(name, f1->mFenceFd, f1->mFenceFd);
-    } else if (f2->isValid()) {
-        result = sync_merge(name, f2->mFenceFd, f2->mFenceFd);
-    } else {
-        return NO_FENCE;
+    // A fence that is invalid (e.g. NO_FENCE) or known to have signaled does
+    // not constrain the result, so hand back the other fence without asking
+    // the kernel for a new one. Fences are immutable once created, so sharing
+    // the input is safe.
+    if (!f1->isValid() || !f2->isValid()) {
+        sMergeElidedInvalidCount++;
+        return f1->isValid() ? f1 : f2->isValid() ? f2 : NO_FENCE;
+    }
+    if (f1->isKnownSignaled()) {
+        sMergeElidedSignaledCount++;
+        return f2;
+    }
+    if (f2->isKnownSignaled()) {
+        sMergeElidedSignaledCount++;
+        return f1;
     }
+
+    int result = sync_merge(name, f1->mFenceFd, f2->mFenceFd);
     if (result == -1) {
         status_t err = -errno;
         ALOGE("merge: sync_merge(\"%s\", %d, %d) returned an error: %s (%d)",
                 name, f1->mFenceFd.get(), f2->mFenceFd.get(),
                 strerror(-err), err);
+        sMergeFailedCount++;
         return NO_FENCE;
     }
+    sMergeCount++;
     return sp<Fence>(new Fence(result));
 }
 
@@ -150,9 +174,19 @@ nsecs_t Fence::getSignalTime() const {
     }
 
     sync_file_info_free(finfo);
+    mKnownSignaled.store(true, std::memory_order_relaxed);
     return nsecs_t(timestamp);
 }
 
+Fence::MergeStats Fence::getMergeStats() {
+    MergeStats stats;
+    stats.merged = sMergeCount;
+    stats.elidedInvalid = sMergeElidedInvalidCount;
+    stats.elidedSignaled = sMergeElidedSignaledCount;
+    stats.failed = sMergeFailedCount;
+    return stats;
+}
+
 size_t Fence::getFlattenedSize() const {
     return 4;
 }
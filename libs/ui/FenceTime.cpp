@@ -21,9 +21,11 @@
 #include <cutils/compiler.h>  // For CC_[UN]LIKELY
 #include <utils/Log.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdlib.h>
 
 #include <memory>
+#include <vector>
 
 namespace android {
 
@@ -203,6 +205,14 @@ FenceTime::FenceTime(const sp<Fence>& fence, bool forceValidForTest)
             Fence::SIGNAL_TIME_INVALID : Fence::SIGNAL_TIME_PENDING) {
 }
 
+sp<Fence> FenceTime::getPendingFence() const {
+    if (mSignalTime.load(std::memory_order_relaxed) != Fence::SIGNAL_TIME_PENDING) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFence;
+}
+
 void FenceTime::signalForTest(nsecs_t signalTime) {
     // To be realistic, this should really set a hidden value that
     // gets picked up in the next call to getSignalTime, but this should
@@ -306,8 +316,7 @@ void FenceTimeline::push(const std::shared_ptr<FenceTime>& fence) {
     mQueue.push(fence);
 }
 
-void FenceTimeline::updateSignalTimes() {
-    std::lock_guard<std::mutex> lock(mMutex);
+std::shared_ptr<FenceTime> FenceTimeline::popSignaledLocked() {
     while (!mQueue.empty()) {
         std::shared_ptr<FenceTime> fence = mQueue.front().lock();
         if (!fence) {
@@ -315,14 +324,73 @@ void FenceTimeline::updateSignalTimes() {
             // timestamp anymore.
             mQueue.pop();
             continue;
-        } else if (fence->getSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+        } else if (fence->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+            // Another timeline or caller already fetched the signal time.
+            mQueue.pop();
+            continue;
+        }
+        return fence;
+    }
+    return nullptr;
+}
+
+void FenceTimeline::updateSignalTimes() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    while (std::shared_ptr<FenceTime> fence = popSignaledLocked()) {
+        if (fence->getSignalTime() != Fence::SIGNAL_TIME_PENDING) {
             // The fence has signaled and we've removed the sp<Fence> ref.
             mQueue.pop();
             continue;
-        } else {
-            // The fence didn't signal yet. Break since the later ones
-            // shouldn't have signaled either.
-            break;
+        }
+        // The fence didn't signal yet. Break since the later ones
+        // shouldn't have signaled either.
+        break;
+    }
+}
+
+void FenceTimeline::updateSignalTimes(std::initializer_list<FenceTimeline*> timelines) {
+    // Hold the fences so their fds stay open while polling.
+    std::vector<FenceTimeline*> polledTimelines;
+    std::vector<sp<Fence>> fences;
+    std::vector<pollfd> fds;
+    polledTimelines.reserve(timelines.size());
+    fences.reserve(timelines.size());
+    fds.reserve(timelines.size());
+
+    for (FenceTimeline* timeline : timelines) {
+        std::shared_ptr<FenceTime> front;
+        {
+            std::lock_guard<std::mutex> lock(timeline->mMutex);
+            front = timeline->popSignaledLocked();
+        }
+        if (!front) {
+            continue;
+        }
+        sp<Fence> fence = front->getPendingFence();
+        if (!fence || fence->get() < 0) {
+            // Nothing to poll; let the regular path sort it out.
+            timeline->updateSignalTimes();
+            continue;
+        }
+        polledTimelines.push_back(timeline);
+        fds.push_back({.fd = fence->get(), .events = POLLIN, .revents = 0});
+        fences.push_back(std::move(fence));
+    }
+
+    if (fds.empty()) {
+        return;
+    }
+
+    int ret = poll(fds.data(), fds.size(), 0);
+    if (ret == 0) {
+        // Nothing signaled since the last update.
+        return;
+    }
+
+    for (size_t i = 0; i < fds.size(); i++) {
+        // On a poll error query every timeline so no signal is missed.
+        if (ret < 0 || fds[i].revents != 0) {
+            polledTimelines[i]->updateSignalTimes();
         }
     }
 }
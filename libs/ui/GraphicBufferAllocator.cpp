@@ -115,10 +115,15 @@ void GraphicBufferAllocator::dumpToSystemLog(bool less) {
 
 status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height, PixelFormat format,
                                                 uint32_t layerCount, uint64_t usage,
-                                                buffer_handle_t* handle, uint32_t* stride,
-                                                std::string requestorName, bool importBuffer) {
+                                                uint32_t bufferCount, buffer_handle_t* handles,
+                                                uint32_t* stride, std::string requestorName,
+                                                bool importBuffer) {
     ATRACE_CALL();
 
+    if (bufferCount < 1) {
+        return BAD_VALUE;
+    }
+
     // make sure to not allocate a N x 0 or 0 x N buffer, since this is
     // allowed from an API stand-point allocate a 1x1 buffer instead.
     if (!width || !height)
@@ -141,11 +146,11 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     usage &= ~static_cast<uint64_t>((1 << 10) | (1 << 13));
 
     status_t error = mAllocator->allocate(requestorName, width, height, format, layerCount, usage,
-                                          1, stride, handle, importBuffer);
+                                          bufferCount, stride, handles, importBuffer);
     if (error != NO_ERROR) {
-        ALOGE("Failed to allocate (%u x %u) layerCount %u format %d "
+        ALOGE("Failed to allocate %u x (%u x %u) layerCount %u format %d "
               "usage %" PRIx64 ": %d",
-              width, height, layerCount, format, usage, error);
+              bufferCount, width, height, layerCount, format, usage, error);
         return error;
     }
 
@@ -174,7 +179,10 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     rec.usage = usage;
     rec.size = bufSize;
     rec.requestorName = std::move(requestorName);
-    list.add(*handle, rec);
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        list.add(handles[i], rec);
+        mMapper.trackImportedBuffer(handles[i]);
+    }
 
     return NO_ERROR;
 }
@@ -182,16 +190,24 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::allocateRawHandle(uint32_t width, uint32_t height,
                                                    PixelFormat format, uint32_t layerCount,
                                                    uint64_t usage, buffer_handle_t* handle,
                                                    uint32_t* stride, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          false);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, false);
+}
+
+status_t GraphicBufferAllocator::allocateN(uint32_t width, uint32_t height, PixelFormat format,
+                                           uint32_t layerCount, uint64_t usage,
+                                           uint32_t bufferCount, buffer_handle_t* handles,
+                                           uint32_t* stride, std::string requestorName) {
+    return allocateHelper(width, height, format, layerCount, usage, bufferCount, handles, stride,
+                          requestorName, true);
 }
 
 // DEPRECATED
@@ -199,8 +215,8 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           uint64_t /*graphicBufferId*/, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::free(buffer_handle_t handle)
@@ -111,13 +111,74 @@ status_t GraphicBufferMapper::importBuffer(const native_handle_t* rawHandle, uin
     }
 
     *outHandle = bufferHandle;
+    trackImportedBuffer(bufferHandle);
 
     return NO_ERROR;
 }
 
 status_t GraphicBufferMapper::importBufferNoValidate(const native_handle_t* rawHandle,
                                                      buffer_handle_t* outHandle) {
-    return mMapper->importBuffer(rawHandle, outHandle);
+    status_t error = mMapper->importBuffer(rawHandle, outHandle);
+    if (error == NO_ERROR) {
+        trackImportedBuffer(*outHandle);
+    }
+    return error;
+}
+
+void GraphicBufferMapper::trackImportedBuffer(buffer_handle_t bufferHandle) {
+    std::lock_guard lock(mMetadataCacheMutex);
+    CachedMetadata& metadata = mMetadataCache[bufferHandle];
+    metadata = {};
+    metadata.importId = ++mNextImportId;
+}
+
+template <typename T, typename Query>
+status_t GraphicBufferMapper::getCachedMetadata(buffer_handle_t bufferHandle,
+                                                std::optional<T> CachedMetadata::*field,
+                                                T* outValue, Query query) {
+    uint64_t importId = 0;
+    {
+        std::lock_guard lock(mMetadataCacheMutex);
+        const auto it = mMetadataCache.find(bufferHandle);
+        if (it != mMetadataCache.end()) {
+            if (const auto& cached = it->second.*field) {
+                mMetadataCacheHits++;
+                *outValue = *cached;
+                return NO_ERROR;
+            }
+            importId = it->second.importId;
+        }
+    }
+    if (importId == 0) {
+        return query(outValue);
+    }
+
+    // Query without holding the lock so a slow HAL call does not serialize other buffers.
+    mMetadataCacheMisses++;
+    T value;
+    status_t error = query(&value);
+    if (error != NO_ERROR) {
+        return error;
+    }
+
+    {
+        std::lock_guard lock(mMetadataCacheMutex);
+        const auto it = mMetadataCache.find(bufferHandle);
+        if (it != mMetadataCache.end() && it->second.importId == importId) {
+            it->second.*field = value;
+        }
+    }
+    *outValue = std::move(value);
+    return NO_ERROR;
+}
+
+GraphicBufferMapper::MetadataCacheStats GraphicBufferMapper::getMetadataCacheStats() const {
+    MetadataCacheStats stats;
+    stats.hits = mMetadataCacheHits;
+    stats.misses = mMetadataCacheMisses;
+    std::lock_guard lock(mMetadataCacheMutex);
+    stats.cachedBuffers = mMetadataCache.size();
+    return stats;
 }
 
 void GraphicBufferMapper::getTransportSize(buffer_handle_t handle,
@@ -130,6 +191,10 @@ status_t GraphicBufferMapper::freeBuffer(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    {
+        std::lock_guard lock(mMetadataCacheMutex);
+        mMetadataCache.erase(handle);
+    }
     mMapper->freeBuffer(handle);
 
     return NO_ERROR;
@@ -201,7 +266,8 @@ status_t GraphicBufferMapper::isSupported(uint32_t width, uint32_t height,
 }
 
 status_t GraphicBufferMapper::getBufferId(buffer_handle_t bufferHandle, uint64_t* outBufferId) {
-    return mMapper->getBufferId(bufferHandle, outBufferId);
+    return getCachedMetadata(bufferHandle, &CachedMetadata::bufferId, outBufferId,
+                             [&](uint64_t* out) { return mMapper->getBufferId(bufferHandle, out); });
 }
 
 status_t GraphicBufferMapper::getName(buffer_handle_t bufferHandle, std::string* outName) {
@@ -227,12 +293,18 @@ status_t GraphicBufferMapper::getPixelFormatRequested(buffer_handle_t bufferHand
 
 status_t GraphicBufferMapper::getPixelFormatFourCC(buffer_handle_t bufferHandle,
                                                    uint32_t* outPixelFormatFourCC) {
-    return mMapper->getPixelFormatFourCC(bufferHandle, outPixelFormatFourCC);
+    return getCachedMetadata(bufferHandle, &CachedMetadata::pixelFormatFourCC,
+                             outPixelFormatFourCC, [&](uint32_t* out) {
+                                 return mMapper->getPixelFormatFourCC(bufferHandle, out);
+                             });
 }
 
 status_t GraphicBufferMapper::getPixelFormatModifier(buffer_handle_t bufferHandle,
                                                      uint64_t* outPixelFormatModifier) {
-    return mMapper->getPixelFormatModifier(bufferHandle, outPixelFormatModifier);
+    return getCachedMetadata(bufferHandle, &CachedMetadata::pixelFormatModifier,
+                             outPixelFormatModifier, [&](uint64_t* out) {
+                                 return mMapper->getPixelFormatModifier(bufferHandle, out);
+                             });
 }
 
 status_t GraphicBufferMapper::getUsage(buffer_handle_t bufferHandle, uint64_t* outUsage) {
@@ -241,7 +313,10 @@ status_t GraphicBufferMapper::getUsage(buffer_handle_t bufferHandle, uint64_t* o
 
 status_t GraphicBufferMapper::getAllocationSize(buffer_handle_t bufferHandle,
                                                 uint64_t* outAllocationSize) {
-    return mMapper->getAllocationSize(bufferHandle, outAllocationSize);
+    return getCachedMetadata(bufferHandle, &CachedMetadata::allocationSize, outAllocationSize,
+                             [&](uint64_t* out) {
+                                 return mMapper->getAllocationSize(bufferHandle, out);
+                             });
 }
 
 status_t GraphicBufferMapper::getProtectedContent(buffer_handle_t bufferHandle,
@@ -284,7 +359,10 @@ status_t GraphicBufferMapper::getChromaSiting(buffer_handle_t bufferHandle,
 
 status_t GraphicBufferMapper::getPlaneLayouts(buffer_handle_t bufferHandle,
                                               std::vector<ui::PlaneLayout>* outPlaneLayouts) {
-    return mMapper->getPlaneLayouts(bufferHandle, outPlaneLayouts);
+    return getCachedMetadata(bufferHandle, &CachedMetadata::planeLayouts, outPlaneLayouts,
+                             [&](std::vector<ui::PlaneLayout>* out) {
+                                 return mMapper->getPlaneLayouts(bufferHandle, out);
+                             });
 }
 
 status_t GraphicBufferMapper::getDataspace(buffer_handle_t bufferHandle,
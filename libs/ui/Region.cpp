@@ -19,6 +19,8 @@
 #include <inttypes.h>
 #include <limits.h>
 
+#include <algorithm>
+
 #include <android-base/stringprintf.h>
 
 #include <utils/Log.h>
@@ -329,6 +331,9 @@ Region& Region::subtractSelf(const Rect& r) {
     return operationSelf(r, op_nand);
 }
 Region& Region::operationSelf(const Rect& r, uint32_t op) {
+    if (trivial_operation(op, *this, *this, r, true)) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, r);
     return *this;
@@ -353,6 +358,9 @@ Region& Region::subtractSelf(const Region& rhs) {
     return operationSelf(rhs, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, uint32_t op) {
+    if (trivial_operation(op, *this, *this, rhs.getBounds(), rhs.isRect())) {
+        return *this;
+    }
     Region lhs(*this);
     boolean_operation(op, *this, lhs, rhs);
     return *this;
@@ -393,6 +401,9 @@ const Region Region::subtract(const Rect& rhs) const {
 }
 const Region Region::operation(const Rect& rhs, uint32_t op) const {
     Region result;
+    if (trivial_operation(op, result, *this, rhs, true)) {
+        return result;
+    }
     boolean_operation(op, result, *this, rhs);
     return result;
 }
@@ -413,6 +424,9 @@ const Region Region::subtract(const Region& rhs) const {
 }
 const Region Region::operation(const Region& rhs, uint32_t op) const {
     Region result;
+    if (trivial_operation(op, result, *this, rhs.getBounds(), rhs.isRect())) {
+        return result;
+    }
     boolean_operation(op, result, *this, rhs);
     return result;
 }
@@ -643,6 +657,119 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
     return result;
 }
 
+static inline bool rectContains(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right &&
+            outer.bottom >= inner.bottom;
+}
+
+bool Region::trivial_operation(uint32_t op, Region& dst, const Region& lhs,
+                               const Rect& rhsBounds, bool rhsIsRect) {
+#if VALIDATE_WITH_CORECG || defined(VALIDATE_REGIONS)
+    return false;
+#else
+    // Most operations done by SurfaceFlinger involve a handful of rects that are either disjoint or
+    // nested, and can be decided from the bounds alone. This avoids copying the operands and
+    // running the rasterizer in those cases. Both operands being canonical, a result that is one of
+    // the operands is also canonical.
+    const Rect lhsBounds = lhs.getBounds();
+    if (lhs.isEmpty() || !lhsBounds.isValid() || !rhsBounds.isValid()) {
+        return false;
+    }
+
+    Rect intersection;
+    if (rhsBounds.isEmpty() || !lhsBounds.intersect(rhsBounds, &intersection)) {
+        switch (op) {
+            case op_and:
+                dst.clear();
+                return true;
+            case op_nand:
+                dst = lhs;
+                return true;
+            case op_or:
+                if (rhsBounds.isEmpty()) {
+                    dst = lhs;
+                    return true;
+                }
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    if (!rhsIsRect) {
+        return false;
+    }
+
+    if (rectContains(rhsBounds, lhsBounds)) {
+        switch (op) {
+            case op_and:
+                dst = lhs;
+                return true;
+            case op_nand:
+                dst.clear();
+                return true;
+            case op_or:
+                dst.set(rhsBounds);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    if (!lhs.isRect()) {
+        return false;
+    }
+
+    // Both operands are overlapping rects, and the rhs does not cover the lhs.
+    switch (op) {
+        case op_and:
+            dst.set(intersection);
+            return true;
+        case op_or:
+            if (rectContains(lhsBounds, rhsBounds)) {
+                dst = lhs;
+                return true;
+            }
+            if ((lhsBounds.top == rhsBounds.top && lhsBounds.bottom == rhsBounds.bottom) ||
+                (lhsBounds.left == rhsBounds.left && lhsBounds.right == rhsBounds.right)) {
+                dst.set(Rect(std::min(lhsBounds.left, rhsBounds.left),
+                             std::min(lhsBounds.top, rhsBounds.top),
+                             std::max(lhsBounds.right, rhsBounds.right),
+                             std::max(lhsBounds.bottom, rhsBounds.bottom)));
+                return true;
+            }
+            return false;
+        case op_nand: {
+            // The rhs cuts off one side of the lhs if it spans it entirely in one direction.
+            Rect result = lhsBounds;
+            if (rhsBounds.left <= lhsBounds.left && rhsBounds.right >= lhsBounds.right) {
+                if (rhsBounds.top <= lhsBounds.top) {
+                    result.top = rhsBounds.bottom;
+                } else if (rhsBounds.bottom >= lhsBounds.bottom) {
+                    result.bottom = rhsBounds.top;
+                } else {
+                    return false;
+                }
+            } else if (rhsBounds.top <= lhsBounds.top && rhsBounds.bottom >= lhsBounds.bottom) {
+                if (rhsBounds.left <= lhsBounds.left) {
+                    result.left = rhsBounds.right;
+                } else if (rhsBounds.right >= lhsBounds.right) {
+                    result.right = rhsBounds.left;
+                } else {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+            dst.set(result);
+            return true;
+        }
+        default:
+            return false;
+    }
+#endif
+}
+
 void Region::boolean_operation(uint32_t op, Region& dst,
         const Region& lhs,
         const Region& rhs, int dx, int dy)
@@ -32,10 +32,11 @@ Transform::Transform() {
 }
 
 Transform::Transform(const Transform&  other)
-    : mMatrix(other.mMatrix), mType(other.mType) {
+    : mMatrix(other.mMatrix), mType(other.mType),
+      mInverseMatrix(other.mInverseMatrix), mInverseType(other.mInverseType) {
 }
 
-Transform::Transform(uint32_t orientation, int w, int h) {
+Transform::Transform(uint32_t orientation, int w, int h) : mInverseType(NO_INVERSE) {
     set(orientation, w, h);
 }
 
@@ -51,6 +52,10 @@ bool Transform::absIsOne(float f) {
     return isZero(fabs(f) - 1.0f);
 }
 
+bool Transform::isAffine() const {
+    return mMatrix[0][2] == 0.0f && mMatrix[1][2] == 0.0f && mMatrix[2][2] == 1.0f;
+}
+
 bool Transform::operator==(const Transform& other) const {
     return mMatrix[0][0] == other.mMatrix[0][0] && mMatrix[0][1] == other.mMatrix[0][1] &&
             mMatrix[0][2] == other.mMatrix[0][2] && mMatrix[1][0] == other.mMatrix[1][0] &&
@@ -66,24 +71,53 @@ Transform Transform::operator*(const Transform& rhs) const {
     Transform r(*this);
     if (rhs.mType == IDENTITY)
         return r;
+    r.mInverseType = NO_INVERSE;
 
-    // TODO: we could use mType to optimize the matrix multiply
     const mat33& A(mMatrix);
     const mat33& B(rhs.mMatrix);
           mat33& D(r.mMatrix);
-    for (size_t i = 0; i < 3; i++) {
-        const float v0 = A[0][i];
-        const float v1 = A[1][i];
-        const float v2 = A[2][i];
-        D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
-        D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
-        D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+    if (CC_UNLIKELY(!isAffine() || !rhs.isAffine())) {
+        for (size_t i = 0; i < 3; i++) {
+            const float v0 = A[0][i];
+            const float v1 = A[1][i];
+            const float v2 = A[2][i];
+            D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
+            D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
+            D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+        }
+        r.mType = UNKNOWN_TYPE;
+        return r;
     }
-    r.mType |= rhs.mType;
 
-    // TODO: we could recompute this value from r and rhs
-    r.mType &= 0xFF;
-    r.mType |= UNKNOWN_TYPE;
+    // Both are a 2x2 transformation followed by a translation, so only those need combining.
+    // The results are the same as with the full 3x3 multiply above. When one side only
+    // translates, the other side's type tells what the product is, if it is known.
+    const auto translatedType = [&D](uint32_t type) {
+        if (type & UNKNOWN_TYPE) {
+            return type;
+        }
+        return (isZero(D[2][0]) && isZero(D[2][1])) ? (type & ~TRANSLATE) : (type | TRANSLATE);
+    };
+    if (mType <= TRANSLATE) {
+        D[0] = B[0];
+        D[1] = B[1];
+        D[2][0] = B[2][0] + A[2][0];
+        D[2][1] = B[2][1] + A[2][1];
+        r.mType = translatedType(rhs.mType);
+    } else if (rhs.mType <= TRANSLATE) {
+        D[2][0] = A[0][0]*B[2][0] + A[1][0]*B[2][1] + A[2][0];
+        D[2][1] = A[0][1]*B[2][0] + A[1][1]*B[2][1] + A[2][1];
+        r.mType = translatedType(mType);
+    } else {
+        for (size_t i = 0; i < 2; i++) {
+            const float v0 = A[0][i];
+            const float v1 = A[1][i];
+            D[0][i] = v0*B[0][0] + v1*B[0][1];
+            D[1][i] = v0*B[1][0] + v1*B[1][1];
+            D[2][i] = v0*B[2][0] + v1*B[2][1] + A[2][i];
+        }
+        r.mType = UNKNOWN_TYPE;
+    }
     return r;
 }
 
@@ -96,6 +130,7 @@ Transform Transform::operator * (float value) const {
             R[i][j] = M[i][j] * value;
         }
     }
+    r.mInverseType = NO_INVERSE;
     r.type();
     return r;
 }
@@ -103,6 +138,8 @@ Transform Transform::operator * (float value) const {
 Transform& Transform::operator=(const Transform& other) {
     mMatrix = other.mMatrix;
     mType = other.mType;
+    mInverseMatrix = other.mInverseMatrix;
+    mInverseType = other.mInverseType;
     return *this;
 }
 
@@ -148,6 +185,7 @@ float Transform::getScaleY() const {
 
 void Transform::reset() {
     mType = IDENTITY;
+    mInverseType = NO_INVERSE;
     for(size_t i = 0; i < 3; i++) {
         vec3& v(mMatrix[i]);
         for (size_t j = 0; j < 3; j++)
@@ -159,6 +197,7 @@ void Transform::set(float tx, float ty) {
     mMatrix[2][0] = tx;
     mMatrix[2][1] = ty;
     mMatrix[2][2] = 1.0f;
+    mInverseType = NO_INVERSE;
 
     if (isZero(tx) && isZero(ty)) {
         mType &= ~TRANSLATE;
@@ -173,6 +212,7 @@ void Transform::set(float a, float b, float c, float d) {
     M[0][1] = c;    M[1][1] = d;
     M[0][2] = 0;    M[1][2] = 0;
     mType = UNKNOWN_TYPE;
+    mInverseType = NO_INVERSE;
 }
 
 status_t Transform::set(uint32_t flags, float w, float h) {
@@ -223,6 +263,7 @@ void Transform::set(const std::array<float, 9>& matrix) {
     M[0][1] = matrix[3];  M[1][1] = matrix[4];  M[2][1] = matrix[5];
     M[0][2] = matrix[6];  M[1][2] = matrix[7];  M[2][2] = matrix[8];
     mType = UNKNOWN_TYPE;
+    mInverseType = NO_INVERSE;
     type();
 }
 
@@ -371,6 +412,13 @@ uint32_t Transform::type() const {
 }
 
 Transform Transform::inverse() const {
+    if (mInverseType != NO_INVERSE) {
+        Transform result;
+        result.mMatrix = mInverseMatrix;
+        result.mType = mInverseType;
+        return result;
+    }
+
     // our 3x3 matrix is always of the form of a 2x2 transformation
     // followed by a translation: T*M, therefore:
     // (T*M)^-1 = M^-1 * T^-1
@@ -411,6 +459,9 @@ Transform Transform::inverse() const {
         result.mMatrix[2][0] = T[0];
         result.mMatrix[2][1] = T[1];
     }
+    result.mInverseType = NO_INVERSE;
+    mInverseMatrix = result.mMatrix;
+    mInverseType = result.mType;
     return result;
 }
 
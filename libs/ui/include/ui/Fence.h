@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
 #include <android-base/unique_fd.h>
 #include <utils/Flattenable.h>
 #include <utils/RefBase.h>
@@ -92,6 +94,9 @@ public:
     // becomes signaled when both f1 and f2 are signaled (even if f1 or f2 is
     // destroyed before it becomes signaled).  The name argument specifies the
     // human-readable name to associated with the new Fence object.
+    //
+    // If one of the fences is invalid or already known to have signaled, the
+    // other fence is returned as is and no new fence is created.
     static sp<Fence> merge(const char* name, const sp<Fence>& f1,
             const sp<Fence>& f2);
 
@@ -139,6 +144,15 @@ public:
         }
     }
 
+    // Outcome counters for merge(), accumulated over the whole process.
+    struct MergeStats {
+        uint64_t merged = 0;         // A new fence was created by the kernel.
+        uint64_t elidedInvalid = 0;  // At least one input was invalid.
+        uint64_t elidedSignaled = 0; // At least one input was known signaled.
+        uint64_t failed = 0;         // sync_merge returned an error.
+    };
+    static MergeStats getMergeStats();
+
     // Flattenable interface
     size_t getFlattenedSize() const;
     size_t getFdCount() const;
@@ -153,7 +167,17 @@ private:
     // Allow mocking for unit testing
     friend class mock::MockFence;
 
+    // Returns true if the fence has no fd or a previous wait or signal time
+    // query observed it signaled. Never makes a syscall.
+    bool isKnownSignaled() const {
+        return !isValid() || mKnownSignaled.load(std::memory_order_relaxed);
+    }
+
     base::unique_fd mFenceFd;
+
+    // Fences never unsignal, so once a query sees the fence signaled the
+    // result is cached here for merge().
+    mutable std::atomic<bool> mKnownSignaled{false};
 };
 
 }; // namespace android
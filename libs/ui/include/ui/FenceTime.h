@@ -23,6 +23,7 @@
 #include <utils/Timers.h>
 
 #include <atomic>
+#include <initializer_list>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
@@ -36,6 +37,7 @@ class FenceToFenceTimeMap;
 // time is known.
 class FenceTime {
 friend class FenceToFenceTimeMap;
+friend class FenceTimeline;
 public:
     // An atomic snapshot of the FenceTime that is flattenable.
     //
@@ -126,6 +128,10 @@ private:
     // never return SIGNAL_TIME_INVALID and isValid will always return true.
     FenceTime(const sp<Fence>& fence, bool forceValidForTest);
 
+    // Returns the underlying fence if the signal time is still pending, or
+    // nullptr if it is already known.
+    sp<Fence> getPendingFence() const;
+
     enum class State {
         VALID,
         INVALID,
@@ -165,7 +171,16 @@ public:
     void push(const std::shared_ptr<FenceTime>& fence);
     void updateSignalTimes();
 
+    // Updates several timelines at once. The oldest pending fence of every
+    // timeline is polled in a single syscall, and only the timelines whose
+    // fence has signaled pay for the signal time queries.
+    static void updateSignalTimes(std::initializer_list<FenceTimeline*> timelines);
+
 private:
+    // Drops entries whose signal time is already known and returns the oldest
+    // entry that is still pending, if any.
+    std::shared_ptr<FenceTime> popSignaledLocked() REQUIRES(mMutex);
+
     mutable std::mutex mMutex;
     std::queue<std::weak_ptr<FenceTime>> mQueue GUARDED_BY(mMutex);
 };
@@ -62,6 +62,17 @@ public:
                                uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
                                std::string requestorName);
 
+    /**
+     * Allocates and imports bufferCount identical gralloc buffers with a single allocator call.
+     * handles must have room for at least bufferCount entries. All buffers share the returned
+     * stride. On failure no buffers are allocated.
+     *
+     * Each handle must be freed with GraphicBufferAllocator::free() when no longer needed.
+     */
+    status_t allocateN(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
+                       uint64_t usage, uint32_t bufferCount, buffer_handle_t* handles,
+                       uint32_t* stride, std::string requestorName);
+
     /**
      * DEPRECATED: GraphicBufferAllocator does not use the graphicBufferId.
      */
@@ -90,8 +101,8 @@ protected:
     };
 
     status_t allocateHelper(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
-                            uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
-                            std::string requestorName, bool importBuffer);
+                            uint64_t usage, uint32_t bufferCount, buffer_handle_t* handles,
+                            uint32_t* stride, std::string requestorName, bool importBuffer);
 
     static Mutex sLock;
     static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
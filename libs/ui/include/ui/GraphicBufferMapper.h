@@ -20,7 +20,12 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include <ui/GraphicTypes.h>
 #include <ui/PixelFormat.h>
@@ -138,6 +143,18 @@ public:
     status_t setSmpte2094_10(buffer_handle_t bufferHandle,
                              std::optional<std::vector<uint8_t>> smpte2094_10);
 
+    /**
+     * Hit statistics for the cache of immutable buffer metadata (buffer id, plane layouts,
+     * fourcc, modifier and allocation size). Only buffers imported or allocated in this process
+     * are cached; entries are dropped in freeBuffer.
+     */
+    struct MetadataCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t cachedBuffers = 0;
+    };
+    MetadataCacheStats getMetadataCacheStats() const;
+
     const GrallocMapper& getGrallocMapper() const {
         return reinterpret_cast<const GrallocMapper&>(*mMapper);
     }
@@ -146,12 +163,40 @@ public:
 
 private:
     friend class Singleton<GraphicBufferMapper>;
+    friend class GraphicBufferAllocator;
 
     GraphicBufferMapper();
 
+    struct CachedMetadata {
+        // Tells apart imports that got the same handle, so that a query that raced with
+        // freeBuffer and a new import is not cached for the new buffer.
+        uint64_t importId = 0;
+        std::optional<uint64_t> bufferId;
+        std::optional<uint32_t> pixelFormatFourCC;
+        std::optional<uint64_t> pixelFormatModifier;
+        std::optional<uint64_t> allocationSize;
+        std::optional<std::vector<ui::PlaneLayout>> planeLayouts;
+    };
+
+    // Starts caching immutable metadata for a handle imported by this process.
+    void trackImportedBuffer(buffer_handle_t bufferHandle);
+
+    // Returns the cached field for the handle, or queries the mapper and caches the result on
+    // success. Handles that were not imported through this process are never cached. The mapper
+    // is queried without holding mMetadataCacheMutex.
+    template <typename T, typename Query>
+    status_t getCachedMetadata(buffer_handle_t bufferHandle,
+                               std::optional<T> CachedMetadata::*field, T* outValue, Query query);
+
     std::unique_ptr<const GrallocMapper> mMapper;
 
     Version mMapperVersion;
+
+    mutable std::mutex mMetadataCacheMutex;
+    std::unordered_map<buffer_handle_t, CachedMetadata> mMetadataCache;
+    uint64_t mNextImportId = 0;
+    std::atomic<uint64_t> mMetadataCacheHits = 0;
+    std::atomic<uint64_t> mMetadataCacheMisses = 0;
 };
 
 // ---------------------------------------------------------------------------
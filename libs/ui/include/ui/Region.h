@@ -161,6 +161,11 @@ private:
     const Region operation(const Region& rhs, uint32_t op) const;
     const Region operation(const Region& rhs, int dx, int dy, uint32_t op) const;
 
+    // Computes the result of a boolean operation without going through the rasterizer, when the
+    // bounds of the operands decide it. Returns false if the general path must be taken.
+    static bool trivial_operation(uint32_t op, Region& dst,
+            const Region& lhs, const Rect& rhsBounds, bool rhsIsRect);
+
     static void boolean_operation(uint32_t op, Region& dst,
             const Region& lhs, const Region& rhs, int dx, int dy);
     static void boolean_operation(uint32_t op, Region& dst,
@@ -122,14 +122,21 @@ private:
         inline vec3& operator [] (size_t i) { return v[i]; }
     };
 
-    enum { UNKNOWN_TYPE = 0x80000000 };
+    enum { UNKNOWN_TYPE = 0x80000000, NO_INVERSE = 0x40000000 };
 
     uint32_t type() const;
+    // Whether the last row is < 0 , 0 , 1 >, i.e. this is a 2x2 transformation followed by a
+    // translation.
+    bool isAffine() const;
     static bool absIsOne(float f);
     static bool isZero(float f);
 
     mat33               mMatrix;
     mutable uint32_t    mType;
+    // The result of the last inverse(), reset whenever mMatrix changes. The same transforms get
+    // inverted over and over, e.g. for input. mInverseType is NO_INVERSE if there is none.
+    mutable mat33       mInverseMatrix;
+    mutable uint32_t    mInverseType;
 };
 
 inline void PrintTo(const Transform& t, ::std::ostream* os) {
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/Fence.h>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace android {
+
+namespace {
+
+// sync_wait only polls the fd, so the read end of a pipe with pending data
+// behaves like a signaled fence for wait(). sync_merge would reject it, so
+// these tests only pass if merge() never reaches the kernel.
+sp<Fence> makeSignaledFence() {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return nullptr;
+    }
+    const char byte = 0;
+    EXPECT_EQ(1, write(fds[1], &byte, 1));
+    close(fds[1]);
+    return sp<Fence>::make(fds[0]);
+}
+
+} // namespace
+
+TEST(FenceTest, mergeOfInvalidFencesIsNoFence) {
+    const auto before = Fence::getMergeStats();
+    EXPECT_EQ(Fence::NO_FENCE, Fence::merge("test", Fence::NO_FENCE, Fence::NO_FENCE));
+    EXPECT_EQ(before.elidedInvalid + 1, Fence::getMergeStats().elidedInvalid);
+}
+
+TEST(FenceTest, mergeWithInvalidFenceReturnsOtherFence) {
+    sp<Fence> fence = makeSignaledFence();
+    ASSERT_NE(nullptr, fence);
+
+    const auto before = Fence::getMergeStats();
+    EXPECT_EQ(fence, Fence::merge("test", fence, Fence::NO_FENCE));
+    EXPECT_EQ(fence, Fence::merge("test", Fence::NO_FENCE, fence));
+    const auto after = Fence::getMergeStats();
+    EXPECT_EQ(before.elidedInvalid + 2, after.elidedInvalid);
+    EXPECT_EQ(before.merged, after.merged);
+}
+
+TEST(FenceTest, mergeWithSignaledFenceReturnsOtherFence) {
+    sp<Fence> signaled = makeSignaledFence();
+    sp<Fence> other = makeSignaledFence();
+    ASSERT_NE(nullptr, signaled);
+    ASSERT_NE(nullptr, other);
+    ASSERT_EQ(Fence::Status::Signaled, signaled->getStatus());
+
+    const auto before = Fence::getMergeStats();
+    EXPECT_EQ(other, Fence::merge("test", signaled, other));
+    EXPECT_EQ(other, Fence::merge("test", other, signaled));
+    const auto after = Fence::getMergeStats();
+    EXPECT_EQ(before.elidedSignaled + 2, after.elidedSignaled);
+    EXPECT_EQ(before.merged, after.merged);
+}
+
+} // namespace android
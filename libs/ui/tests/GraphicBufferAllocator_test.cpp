@@ -38,6 +38,7 @@ constexpr uint64_t kTestUsage = GraphicBuffer::USAGE_SW_WRITE_OFTEN;
 
 } // namespace
 
+using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Return;
 using ::testing::SetArgPointee;
@@ -53,6 +54,11 @@ public:
                     allocate)
                 .WillOnce(DoAll(SetArgPointee<7>(stride), Return(err)));
     }
+    void setUpAllocateNExpectations(uint32_t bufferCount, uint32_t stride) {
+        EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(mAllocator.get())),
+                    allocate(_, _, _, _, _, _, bufferCount, _, _, true))
+                .WillOnce(DoAll(SetArgPointee<7>(stride), Return(NO_ERROR)));
+    }
     std::unique_ptr<const GrallocAllocator>& getAllocator() { return mAllocator; }
 };
 
@@ -113,4 +119,25 @@ TEST_F(GraphicBufferAllocatorTest, AllocateLargeStride) {
     ASSERT_EQ(NO_ERROR, err);
     ASSERT_EQ(expectedStride, stride);
 }
+
+TEST_F(GraphicBufferAllocatorTest, AllocateNUsesSingleAllocatorCall) {
+    constexpr uint32_t kBufferCount = 3;
+    mAllocator.setUpAllocateNExpectations(kBufferCount, kTestWidth);
+    uint32_t stride = 0;
+    buffer_handle_t handles[kBufferCount] = {};
+    status_t err = mAllocator.allocateN(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                        kTestLayerCount, kTestUsage, kBufferCount, handles, &stride,
+                                        "GraphicBufferAllocatorTest");
+    ASSERT_EQ(NO_ERROR, err);
+    ASSERT_EQ(kTestWidth, stride);
+}
+
+TEST_F(GraphicBufferAllocatorTest, AllocateNRejectsZeroCount) {
+    uint32_t stride = 0;
+    buffer_handle_t handle;
+    status_t err = mAllocator.allocateN(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                        kTestLayerCount, kTestUsage, 0, &handle, &stride,
+                                        "GraphicBufferAllocatorTest");
+    ASSERT_EQ(BAD_VALUE, err);
+}
 } // namespace android
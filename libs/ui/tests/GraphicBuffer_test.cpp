@@ -17,6 +17,7 @@
 #define LOG_TAG "GraphicBufferTest"
 
 #include <ui/GraphicBuffer.h>
+#include <ui/GraphicBufferMapper.h>
 
 #include <gtest/gtest.h>
 
@@ -66,4 +67,27 @@ TEST_F(GraphicBufferTest, AllocateBadDimensions) {
     ASSERT_EQ(BAD_VALUE, gb2->initCheck());
 }
 
+TEST_F(GraphicBufferTest, PlaneLayoutsAreCachedPerBuffer) {
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    if (mapper.getMapperVersion() < GraphicBufferMapper::GRALLOC_4) {
+        GTEST_SKIP() << "Buffer metadata requires gralloc 4.0+";
+    }
+
+    sp<GraphicBuffer> gb(new GraphicBuffer(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                           kTestLayerCount, kTestUsage, std::string("test")));
+    ASSERT_EQ(NO_ERROR, gb->initCheck());
+
+    std::vector<ui::PlaneLayout> first;
+    ASSERT_EQ(NO_ERROR, mapper.getPlaneLayouts(gb->getNativeBuffer()->handle, &first));
+    const auto statsBefore = mapper.getMetadataCacheStats();
+
+    std::vector<ui::PlaneLayout> second;
+    ASSERT_EQ(NO_ERROR, mapper.getPlaneLayouts(gb->getNativeBuffer()->handle, &second));
+    const auto statsAfter = mapper.getMetadataCacheStats();
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(statsBefore.hits + 1, statsAfter.hits);
+    EXPECT_EQ(statsBefore.misses, statsAfter.misses);
+}
+
 } // namespace android
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RegionBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+#include <array>
+
+namespace android {
+namespace {
+
+const Rect kDisplay(0, 0, 1080, 2400);
+
+// The layer bounds of a typical phone composition, from top to bottom of the z-order: status bar,
+// navigation bar, an app window, its dim layer, a dialog, and the wallpaper.
+const std::array<Rect, 6> kLayerStack = {
+        Rect(0, 0, 1080, 80),      Rect(0, 2280, 1080, 2400), Rect(100, 900, 980, 1500),
+        Rect(0, 0, 1080, 2400),    Rect(0, 80, 1080, 2280),   Rect(0, 0, 1080, 2400),
+};
+
+// Mirrors the visible region walk that SurfaceFlinger performs on every geometry change.
+void BM_Region_visibleRegionWalk(benchmark::State& state) {
+    for (auto _ : state) {
+        Region aboveOpaqueLayers;
+        Region aboveCoveredLayers;
+        for (const Rect& bounds : kLayerStack) {
+            Region visibleRegion(bounds);
+            visibleRegion.andSelf(kDisplay);
+            const Region coveredRegion = aboveCoveredLayers.intersect(visibleRegion);
+            aboveCoveredLayers.orSelf(visibleRegion);
+            visibleRegion.subtractSelf(aboveOpaqueLayers);
+            aboveOpaqueLayers.orSelf(bounds);
+            benchmark::DoNotOptimize(visibleRegion);
+            benchmark::DoNotOptimize(coveredRegion);
+        }
+    }
+}
+BENCHMARK(BM_Region_visibleRegionWalk);
+
+void BM_Region_subtractCoveringRect(benchmark::State& state) {
+    const Region region(kLayerStack[2]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(kDisplay));
+    }
+}
+BENCHMARK(BM_Region_subtractCoveringRect);
+
+void BM_Region_subtractDisjointRect(benchmark::State& state) {
+    const Region region(kLayerStack[0]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(kLayerStack[1]));
+    }
+}
+BENCHMARK(BM_Region_subtractDisjointRect);
+
+void BM_Region_intersectRect(benchmark::State& state) {
+    const Region region(kLayerStack[2]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.intersect(kLayerStack[4]));
+    }
+}
+BENCHMARK(BM_Region_intersectRect);
+
+// Punches a hole in a rect, which always takes the general path.
+void BM_Region_subtractNestedRect(benchmark::State& state) {
+    const Region region(kDisplay);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(kLayerStack[2]));
+    }
+}
+BENCHMARK(BM_Region_subtractNestedRect);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
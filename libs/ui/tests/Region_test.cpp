@@ -179,5 +179,78 @@ TEST_F(RegionTest, RegionHash) {
     EXPECT_NE(std::hash<Region>{}(region1), std::hash<Region>{}(region2));
 }
 
+TEST_F(RegionTest, RectOperations) {
+    const auto expectRect = [](const Region& region, const Rect& rect) {
+        EXPECT_TRUE(region.isRect());
+        EXPECT_EQ(rect, region.getBounds());
+    };
+    const Rect bounds(0, 0, 100, 100);
+    const Region r(bounds);
+
+    // Disjoint operands
+    EXPECT_TRUE(r.intersect(Rect(200, 0, 300, 100)).isEmpty());
+    expectRect(r.subtract(Rect(200, 0, 300, 100)), bounds);
+    expectRect(r.merge(Rect::EMPTY_RECT), bounds);
+
+    // Nested operands
+    expectRect(r.intersect(Rect(-10, -10, 110, 110)), bounds);
+    EXPECT_TRUE(r.subtract(Rect(-10, -10, 110, 110)).isEmpty());
+    expectRect(r.merge(Rect(-10, -10, 110, 110)), Rect(-10, -10, 110, 110));
+    expectRect(r.merge(Rect(10, 10, 20, 20)), bounds);
+
+    // Operations whose result is a single rect
+    expectRect(r.intersect(Rect(50, 50, 150, 150)), Rect(50, 50, 100, 100));
+    expectRect(r.merge(Rect(50, 0, 150, 100)), Rect(0, 0, 150, 100));
+    expectRect(r.merge(Rect(0, 100, 100, 150)), Rect(0, 0, 100, 150));
+    expectRect(r.subtract(Rect(-10, -10, 110, 20)), Rect(0, 20, 100, 100));
+    expectRect(r.subtract(Rect(80, -10, 110, 110)), Rect(0, 0, 80, 100));
+
+    // Operations whose result is not a single rect
+    const Region hole = r.subtract(Rect(10, 10, 20, 20));
+    EXPECT_EQ(4, hole.end() - hole.begin());
+    EXPECT_FALSE(hole.contains(15, 15));
+    const Region corner = r.merge(Rect(50, 50, 150, 150));
+    EXPECT_EQ(3, corner.end() - corner.begin());
+    EXPECT_EQ(Rect(0, 0, 150, 150), corner.getBounds());
+}
+
+TEST_F(RegionTest, RandomOperationsMatchCoverage) {
+    constexpr int SIZE = 8;
+    const auto randomRect = [] {
+        const int left = random() % SIZE;
+        const int top = random() % SIZE;
+        return Rect(left, top, left + random() % (SIZE - left + 1),
+                    top + random() % (SIZE - top + 1));
+    };
+    const auto randomRegion = [&randomRect] {
+        Region region;
+        for (int i = random() % 3; i >= 0; i--) {
+            region.orSelf(randomRect());
+        }
+        return region;
+    };
+
+    srandom(12345);
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        const Region lhs = randomRegion();
+        const Region rhs = (iteration % 2) ? randomRegion() : Region(randomRect());
+
+        const Region intersection = lhs.intersect(rhs);
+        const Region difference = lhs.subtract(rhs);
+        const Region merged = lhs.merge(rhs);
+        for (int x = 0; x < SIZE; x++) {
+            for (int y = 0; y < SIZE; y++) {
+                const bool inLhs = lhs.contains(x, y);
+                const bool inRhs = rhs.contains(x, y);
+                EXPECT_EQ(inLhs && inRhs, intersection.contains(x, y));
+                EXPECT_EQ(inLhs && !inRhs, difference.contains(x, y));
+                EXPECT_EQ(inLhs || inRhs, merged.contains(x, y));
+            }
+        }
+        EXPECT_TRUE((intersection ^ (lhs - (lhs - rhs))).isEmpty());
+        EXPECT_TRUE((merged ^ (difference | rhs)).isEmpty());
+    }
+}
+
 }; // namespace android
 
@@ -46,4 +46,59 @@ TEST(TransformTest, inverseRotation_hasCorrectType) {
     testRotationFlagsForInverse(Transform::FLIP_V, Transform::FLIP_V, false);
 }
 
+TEST(TransformTest, multiply_matchesFullMatrixMultiply) {
+    std::vector<Transform> transforms(8);
+    transforms[1].set(10, 20);
+    transforms[2].set(2, 0, 0, 3);
+    transforms[3].set(2, 0, 0, 3);
+    transforms[3].set(-5, 7);
+    transforms[4] = Transform(Transform::ROT_90, 100, 200);
+    transforms[5] = Transform(Transform::FLIP_H | Transform::FLIP_V, 100, 200);
+    transforms[6].set(0.5f, 0.25f, -0.75f, 2);
+    transforms[6].set(3, 4);
+    transforms[7].set({1, 2, 3, 4, 5, 6, 0.5f, 0.25f, 1});
+
+    for (const Transform& lhs : transforms) {
+        for (const Transform& rhs : transforms) {
+            const Transform product = lhs * rhs;
+
+            std::array<float, 9> expected;
+            for (size_t row = 0; row < 3; row++) {
+                for (size_t col = 0; col < 3; col++) {
+                    expected[row * 3 + col] = lhs[0][row] * rhs[col][0] +
+                            lhs[1][row] * rhs[col][1] + lhs[2][row] * rhs[col][2];
+                }
+            }
+            Transform expectedProduct;
+            expectedProduct.set(expected);
+
+            EXPECT_EQ(expectedProduct, product);
+            EXPECT_EQ(expectedProduct.getType(), product.getType());
+            EXPECT_EQ(expectedProduct.getOrientation(), product.getOrientation());
+        }
+    }
+}
+
+TEST(TransformTest, inverse_isUpdatedWithTheTransform) {
+    Transform t(Transform::ROT_90, 100, 200);
+    const Transform inverse = t.inverse();
+    EXPECT_EQ(Transform(), t * inverse);
+    EXPECT_EQ(inverse, t.inverse());
+    EXPECT_EQ(inverse.getOrientation(), t.inverse().getOrientation());
+
+    t.set(10, 20);
+    EXPECT_EQ(vec2(0, 0), t.inverse().transform(t.transform(0, 0)));
+    EXPECT_FALSE(inverse == t.inverse());
+
+    t.reset();
+    EXPECT_EQ(Transform(), t.inverse());
+
+    Transform translate;
+    translate.set(5, 5);
+    const Transform copy(translate);
+    translate.set(1, 2);
+    EXPECT_EQ(vec2(-5, -5), copy.inverse().transform(0, 0));
+    EXPECT_EQ(vec2(-1, -2), translate.inverse().transform(0, 0));
+}
+
 } // namespace android::ui
@@ -21,6 +21,12 @@
 #include "jpegrerrorcode.h"
 #include "ultrahdr.h"
 
+#include <functional>
+
+#ifdef __ANDROID__
+#include <android/hardware_buffer.h>
+#endif
+
 #ifndef FLT_MAX
 #define FLT_MAX 0x1.fffffep127f
 #endif
@@ -91,6 +97,13 @@ typedef struct jpegr_compressed_struct* jr_compressed_ptr;
 typedef struct jpegr_exif_struct* jr_exif_ptr;
 typedef struct jpegr_info_struct* jr_info_ptr;
 
+/*
+ * Receives one band of rows decoded by JpegR::decodeJPEGRInBands(). band holds band->height rows
+ * of band->width pixels, which are only valid during the call, and first_row is the row of the
+ * full image the band starts at. Returning anything but NO_ERROR stops decoding.
+ */
+typedef std::function<status_t(jr_uncompressed_ptr band, size_t first_row)> jr_band_callback;
+
 class JpegR {
 public:
     /*
@@ -119,6 +132,31 @@ public:
                          int quality,
                          jr_exif_ptr exif);
 
+#ifdef __ANDROID__
+    /*
+     * Experimental only
+     *
+     * Encode API-0 from a hardware buffer
+     * Same as encode API-0, but reads the HDR image straight out of a P010 hardware buffer, such
+     * as one from the camera, using its plane strides instead of copying it into linear memory
+     * first. The buffer is locked for CPU reads for the duration of the call.
+     * @param p010_buffer HDR image in a buffer of format AHARDWAREBUFFER_FORMAT_YCbCr_P010
+     * @param p010_color_gamut color gamut of the HDR image
+     * @param hdr_tf transfer function of the HDR image
+     * @param dest destination of the compressed JPEGR image, as for encode API-0.
+     * @param quality target quality of the JPEG encoding, must be in range of 0-100 where 100 is
+     *                the highest quality
+     * @param exif pointer to the exif metadata.
+     * @return NO_ERROR if encoding succeeds, error code if error occurs.
+     */
+    status_t encodeJPEGR(AHardwareBuffer* p010_buffer,
+                         ultrahdr_color_gamut p010_color_gamut,
+                         ultrahdr_transfer_function hdr_tf,
+                         jr_compressed_ptr dest,
+                         int quality,
+                         jr_exif_ptr exif);
+#endif
+
     /*
      * Encode API-1
      * Compress JPEGR image from 10-bit HDR YUV and 8-bit SDR YUV.
@@ -266,6 +304,29 @@ public:
                          jr_uncompressed_ptr gain_map = nullptr,
                          ultrahdr_metadata_ptr metadata = nullptr);
 
+    /*
+     * Decompress JPEGR image, handing the output to band_callback one band of rows at a time.
+     *
+     * Unlike decodeJPEGR(), the output image is never held in memory as a whole, only one band
+     * of it is, which bounds the memory used to decode large images. The primary image and the
+     * gain map are still decoded in full.
+     *
+     * @param compressed_jpegr_image compressed JPEGR image.
+     * @param band_height number of rows in each band, except for the last one, which may be
+     *                    shorter. Bands of a few hundred rows keep the gain map workers busy.
+     * @param band_callback called for each band, from the top of the image down.
+     * @param max_display_boost (optional) the maximum available boost supported by a display,
+     *                          the value must be greater than or equal to 1.0.
+     * @param output_format flag for setting output color format, as for decodeJPEGR().
+     * @return NO_ERROR if decoding succeeds, the error returned by band_callback if it stopped
+     *         decoding, error code if another error occurs.
+     */
+    status_t decodeJPEGRInBands(jr_compressed_ptr compressed_jpegr_image,
+                                size_t band_height,
+                                const jr_band_callback& band_callback,
+                                float max_display_boost = FLT_MAX,
+                                ultrahdr_output_format output_format = ULTRAHDR_OUTPUT_HDR_LINEAR);
+
     /*
     * Gets Info from JPEGR file without decoding it.
     *
@@ -327,6 +388,19 @@ protected:
                           jr_uncompressed_ptr dest);
 
 private:
+    /*
+     * Same as applyGainMap(), but only recovers rows [row_start, row_end) of the image, which
+     * dest holds from its first row.
+     */
+    status_t applyGainMapToRows(jr_uncompressed_ptr uncompressed_yuv_420_image,
+                                jr_uncompressed_ptr uncompressed_gain_map,
+                                ultrahdr_metadata_ptr metadata,
+                                ultrahdr_output_format output_format,
+                                float max_display_boost,
+                                size_t row_start,
+                                size_t row_end,
+                                jr_uncompressed_ptr dest);
+
     /*
      * This method is called in the encoding pipeline. It will encode the gain map.
      *
@@ -29,15 +29,18 @@
 #include <image_io/base/data_segment_data_source.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <cmath>
 #include <condition_variable>
+#include <cstdio>
 #include <deque>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <unistd.h>
 
 using namespace std;
@@ -96,6 +99,37 @@ int GetCPUCoreCount() {
   return cpuCoreCount;
 }
 
+// Gain map jobs are cut small enough that the cores running them should all be about as fast,
+// otherwise the image waits on whichever core picked up the last job. On devices that report core
+// capacities, use every core that is at least half as fast as the fastest one. Elsewhere fall back
+// to a few of the online cores.
+static const int kMaxThreadsWithoutCapacity = 4;
+int GetWorkerThreadCount() {
+  const int cpuCoreCount = GetCPUCoreCount();
+#if CONFIG_MULTITHREAD
+  std::vector<int> capacities;
+  for (int cpu = 0; cpu < cpuCoreCount; cpu++) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+      break;
+    }
+    int capacity = 0;
+    if (fscanf(file, "%d", &capacity) == 1 && capacity > 0) {
+      capacities.push_back(capacity);
+    }
+    fclose(file);
+  }
+  if (!capacities.empty() && static_cast<int>(capacities.size()) == cpuCoreCount) {
+    const int maxCapacity = *std::max_element(capacities.begin(), capacities.end());
+    return std::count_if(capacities.begin(), capacities.end(),
+                         [maxCapacity](int capacity) { return capacity * 2 >= maxCapacity; });
+  }
+#endif
+  return std::clamp(cpuCoreCount, 1, kMaxThreadsWithoutCapacity);
+}
+
 status_t JpegR::areInputArgumentsValid(jr_uncompressed_ptr uncompressed_p010_image,
                                        jr_uncompressed_ptr uncompressed_yuv_420_image,
                                        ultrahdr_transfer_function hdr_tf,
@@ -280,6 +314,61 @@ status_t JpegR::encodeJPEGR(jr_uncompressed_ptr uncompressed_p010_image,
   return NO_ERROR;
 }
 
+#ifdef __ANDROID__
+/* Encode API-0 from a hardware buffer */
+status_t JpegR::encodeJPEGR(AHardwareBuffer* p010_buffer,
+                            ultrahdr_color_gamut p010_color_gamut,
+                            ultrahdr_transfer_function hdr_tf,
+                            jr_compressed_ptr dest,
+                            int quality,
+                            jr_exif_ptr exif) {
+  if (p010_buffer == nullptr) {
+    ALOGE("received nullptr for p010 buffer");
+    return ERROR_JPEGR_INVALID_NULL_PTR;
+  }
+
+  AHardwareBuffer_Desc desc;
+  AHardwareBuffer_describe(p010_buffer, &desc);
+  if (desc.format != AHARDWAREBUFFER_FORMAT_YCbCr_P010) {
+    ALOGE("received buffer of format %u, expected P010", desc.format);
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
+  AHardwareBuffer_Planes planes;
+  if (AHardwareBuffer_lockPlanes(p010_buffer, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, -1, nullptr,
+                                 &planes) != 0) {
+    ALOGE("failed to lock p010 buffer");
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
+  // The gain map math reads P010 as a luma plane followed by interleaved 16-bit U and V samples,
+  // each plane with its own row stride.
+  const auto& luma = planes.planes[0];
+  const auto& cb = planes.planes[1];
+  const auto& cr = planes.planes[2];
+  status_t ret = NO_ERROR;
+  if (planes.planeCount != 3 || luma.pixelStride != 2 || cb.pixelStride != 4
+   || cr.pixelStride != 4 || static_cast<uint8_t*>(cr.data) != static_cast<uint8_t*>(cb.data) + 2
+   || luma.rowStride % 2 != 0 || cb.rowStride % 2 != 0) {
+    ALOGE("p010 buffer planes are not laid out as P010");
+    ret = ERROR_JPEGR_INVALID_INPUT_TYPE;
+  } else {
+    jpegr_uncompressed_struct uncompressed_p010_image;
+    uncompressed_p010_image.data = luma.data;
+    uncompressed_p010_image.width = desc.width;
+    uncompressed_p010_image.height = desc.height;
+    uncompressed_p010_image.colorGamut = p010_color_gamut;
+    uncompressed_p010_image.luma_stride = luma.rowStride / 2;
+    uncompressed_p010_image.chroma_data = cb.data;
+    uncompressed_p010_image.chroma_stride = cb.rowStride / 2;
+    ret = encodeJPEGR(&uncompressed_p010_image, hdr_tf, dest, quality, exif);
+  }
+
+  AHardwareBuffer_unlock(p010_buffer, nullptr);
+  return ret;
+}
+#endif
+
 /* Encode API-1 */
 status_t JpegR::encodeJPEGR(jr_uncompressed_ptr uncompressed_p010_image,
                             jr_uncompressed_ptr uncompressed_yuv_420_image,
@@ -700,6 +789,110 @@ status_t JpegR::decodeJPEGR(jr_compressed_ptr compressed_jpegr_image,
   return NO_ERROR;
 }
 
+status_t JpegR::decodeJPEGRInBands(jr_compressed_ptr compressed_jpegr_image,
+                                   size_t band_height,
+                                   const jr_band_callback& band_callback,
+                                   float max_display_boost,
+                                   ultrahdr_output_format output_format) {
+  if (compressed_jpegr_image == nullptr || compressed_jpegr_image->data == nullptr) {
+    ALOGE("received nullptr for compressed jpegr image");
+    return ERROR_JPEGR_INVALID_NULL_PTR;
+  }
+
+  if (band_height == 0 || !band_callback) {
+    ALOGE("received bad band height %zu or no band callback", band_height);
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
+  if (max_display_boost < 1.0f) {
+    ALOGE("received bad value for max_display_boost %f", max_display_boost);
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
+  if (output_format <= ULTRAHDR_OUTPUT_UNSPECIFIED || output_format > ULTRAHDR_OUTPUT_MAX) {
+    ALOGE("received bad value for output format %d", output_format);
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
+  if (output_format == ULTRAHDR_OUTPUT_SDR) {
+    // The decoder hands back the whole RGBA image, so just pass it on in bands.
+    JpegDecoderHelper jpeg_decoder;
+    if (!jpeg_decoder.decompressImage(compressed_jpegr_image->data, compressed_jpegr_image->length,
+                                      true)) {
+      return ERROR_JPEGR_DECODE_ERROR;
+    }
+    const size_t width = jpeg_decoder.getDecompressedImageWidth();
+    const size_t height = jpeg_decoder.getDecompressedImageHeight();
+    for (size_t row = 0; row < height; row += band_height) {
+      jpegr_uncompressed_struct band;
+      band.data = static_cast<uint8_t*>(jpeg_decoder.getDecompressedImagePtr()) + row * width * 4;
+      band.width = width;
+      band.height = std::min(band_height, height - row);
+      JPEGR_CHECK(band_callback(&band, row));
+    }
+    return NO_ERROR;
+  }
+
+  jpegr_compressed_struct compressed_map;
+  JPEGR_CHECK(extractGainMap(compressed_jpegr_image, &compressed_map));
+
+  JpegDecoderHelper gain_map_decoder;
+  if (!gain_map_decoder.decompressImage(compressed_map.data, compressed_map.length)) {
+    return ERROR_JPEGR_DECODE_ERROR;
+  }
+  if ((gain_map_decoder.getDecompressedImageWidth() *
+       gain_map_decoder.getDecompressedImageHeight()) >
+      gain_map_decoder.getDecompressedImageSize()) {
+    return ERROR_JPEGR_CALCULATION_ERROR;
+  }
+
+  ultrahdr_metadata_struct uhdr_metadata;
+  if (!getMetadataFromXMP(static_cast<uint8_t*>(gain_map_decoder.getXMPPtr()),
+                          gain_map_decoder.getXMPSize(), &uhdr_metadata)) {
+    return ERROR_JPEGR_INVALID_METADATA;
+  }
+
+  JpegDecoderHelper jpeg_decoder;
+  if (!jpeg_decoder.decompressImage(compressed_jpegr_image->data, compressed_jpegr_image->length)) {
+    return ERROR_JPEGR_DECODE_ERROR;
+  }
+  if ((jpeg_decoder.getDecompressedImageWidth() *
+       jpeg_decoder.getDecompressedImageHeight() * 3 / 2) >
+      jpeg_decoder.getDecompressedImageSize()) {
+    return ERROR_JPEGR_CALCULATION_ERROR;
+  }
+
+  jpegr_uncompressed_struct map;
+  map.data = gain_map_decoder.getDecompressedImagePtr();
+  map.width = gain_map_decoder.getDecompressedImageWidth();
+  map.height = gain_map_decoder.getDecompressedImageHeight();
+
+  jpegr_uncompressed_struct uncompressed_yuv_420_image;
+  uncompressed_yuv_420_image.data = jpeg_decoder.getDecompressedImagePtr();
+  uncompressed_yuv_420_image.width = jpeg_decoder.getDecompressedImageWidth();
+  uncompressed_yuv_420_image.height = jpeg_decoder.getDecompressedImageHeight();
+  uncompressed_yuv_420_image.colorGamut = IccHelper::readIccColorGamut(
+      jpeg_decoder.getICCPtr(), jpeg_decoder.getICCSize());
+
+  // RGBA_F16 for linear output, RGBA_1010102 otherwise.
+  const size_t bytes_per_pixel = output_format == ULTRAHDR_OUTPUT_HDR_LINEAR ? 8 : 4;
+  const size_t width = uncompressed_yuv_420_image.width;
+  const size_t height = uncompressed_yuv_420_image.height;
+  band_height = std::min(band_height, height);
+  std::unique_ptr<uint8_t[]> band_data =
+      std::make_unique<uint8_t[]>(width * band_height * bytes_per_pixel);
+
+  for (size_t row = 0; row < height; row += band_height) {
+    jpegr_uncompressed_struct band;
+    band.data = band_data.get();
+    JPEGR_CHECK(applyGainMapToRows(&uncompressed_yuv_420_image, &map, &uhdr_metadata,
+                                   output_format, max_display_boost, row,
+                                   std::min(row + band_height, height), &band));
+    JPEGR_CHECK(band_callback(&band, row));
+  }
+  return NO_ERROR;
+}
+
 status_t JpegR::compressGainMap(jr_uncompressed_ptr uncompressed_gain_map,
                                 JpegEncoderHelper* jpeg_encoder) {
   if (uncompressed_gain_map == nullptr || jpeg_encoder == nullptr) {
@@ -897,7 +1090,7 @@ status_t JpegR::generateGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
   }
 
   std::mutex mutex;
-  const int threads = std::clamp(GetCPUCoreCount(), 1, 4);
+  const int threads = GetWorkerThreadCount();
   size_t rowStep = threads == 1 ? image_height : kJobSzInRows;
   JobQueue jobQueue;
 
@@ -962,6 +1155,22 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
                              ultrahdr_output_format output_format,
                              float max_display_boost,
                              jr_uncompressed_ptr dest) {
+  if (uncompressed_yuv_420_image == nullptr) {
+    return ERROR_JPEGR_INVALID_NULL_PTR;
+  }
+  return applyGainMapToRows(uncompressed_yuv_420_image, uncompressed_gain_map, metadata,
+                            output_format, max_display_boost, 0,
+                            uncompressed_yuv_420_image->height, dest);
+}
+
+status_t JpegR::applyGainMapToRows(jr_uncompressed_ptr uncompressed_yuv_420_image,
+                                   jr_uncompressed_ptr uncompressed_gain_map,
+                                   ultrahdr_metadata_ptr metadata,
+                                   ultrahdr_output_format output_format,
+                                   float max_display_boost,
+                                   size_t row_start,
+                                   size_t row_end,
+                                   jr_uncompressed_ptr dest) {
   if (uncompressed_yuv_420_image == nullptr
    || uncompressed_gain_map == nullptr
    || metadata == nullptr
@@ -1003,8 +1212,13 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
     return ERROR_JPEGR_INVALID_INPUT_TYPE;
   }
 
+  if (row_start > row_end
+   || row_end > static_cast<size_t>(uncompressed_yuv_420_image->height)) {
+    return ERROR_JPEGR_INVALID_INPUT_TYPE;
+  }
+
   dest->width = uncompressed_yuv_420_image->width;
-  dest->height = uncompressed_yuv_420_image->height;
+  dest->height = row_end - row_start;
   ShepardsIDW idwTable(kMapDimensionScaleFactor);
   float display_boost = std::min(max_display_boost, metadata->maxContentBoost);
   GainLUT gainLUT(metadata, display_boost);
@@ -1012,7 +1226,7 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
   JobQueue jobQueue;
   std::function<void()> applyRecMap = [uncompressed_yuv_420_image, uncompressed_gain_map,
                                        metadata, dest, &jobQueue, &idwTable, output_format,
-                                       &gainLUT, display_boost]() -> void {
+                                       &gainLUT, display_boost, row_start]() -> void {
     size_t width = uncompressed_yuv_420_image->width;
     size_t height = uncompressed_yuv_420_image->height;
 
@@ -1047,7 +1261,7 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
           Color rgb_hdr = applyGain(rgb_sdr, gain, metadata, display_boost);
 #endif
           rgb_hdr = rgb_hdr / display_boost;
-          size_t pixel_idx = x + y * width;
+          size_t pixel_idx = x + (y - row_start) * width;
 
           switch (output_format) {
             case ULTRAHDR_OUTPUT_HDR_LINEAR:
@@ -1070,7 +1284,7 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
             }
             case ULTRAHDR_OUTPUT_HDR_PQ:
             {
-#if USE_HLG_OETF_LUT
+#if USE_PQ_OETF_LUT
               ColorTransformFn hdrOetf = pqOetfLUT;
 #else
               ColorTransformFn hdrOetf = pqOetf;
@@ -1089,14 +1303,14 @@ status_t JpegR::applyGainMap(jr_uncompressed_ptr uncompressed_yuv_420_image,
     }
   };
 
-  const int threads = std::clamp(GetCPUCoreCount(), 1, 4);
+  const int threads = GetWorkerThreadCount();
   std::vector<std::thread> workers;
   for (int th = 0; th < threads - 1; th++) {
     workers.push_back(std::thread(applyRecMap));
   }
-  const int rowStep = threads == 1 ? uncompressed_yuv_420_image->height : kJobSzInRows;
-  for (int rowStart = 0; rowStart < uncompressed_yuv_420_image->height;) {
-    int rowEnd = std::min(rowStart + rowStep, uncompressed_yuv_420_image->height);
+  const size_t rowStep = threads == 1 ? row_end - row_start : kJobSzInRows;
+  for (size_t rowStart = row_start; rowStart < row_end;) {
+    size_t rowEnd = std::min(rowStart + rowStep, row_end);
     jobQueue.enqueueJob(rowStart, rowEnd);
     rowStart = rowEnd;
   }
@@ -1069,6 +1069,137 @@ TEST_F(JpegRTest, encodeFromP010ThenDecode) {
   free(decodedJpegR.data);
 }
 
+/* Test Encode API-0 from a hardware buffer */
+TEST_F(JpegRTest, encodeFromP010HardwareBuffer) {
+  int ret;
+
+  // Load input files.
+  if (!loadFile(RAW_P010_IMAGE, mRawP010Image.data, nullptr)) {
+    FAIL() << "Load file " << RAW_P010_IMAGE << " failed";
+  }
+  mRawP010Image.width = TEST_IMAGE_WIDTH;
+  mRawP010Image.height = TEST_IMAGE_HEIGHT;
+  mRawP010Image.colorGamut = ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100;
+
+  AHardwareBuffer_Desc desc = {
+      .width = TEST_IMAGE_WIDTH,
+      .height = TEST_IMAGE_HEIGHT,
+      .layers = 1,
+      .format = AHARDWAREBUFFER_FORMAT_YCbCr_P010,
+      .usage = AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN | AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN,
+  };
+  AHardwareBuffer* buffer = nullptr;
+  if (AHardwareBuffer_allocate(&desc, &buffer) != 0) {
+    GTEST_SKIP() << "P010 hardware buffers are not supported";
+  }
+
+  // Copy the raw image into the buffer's own, possibly padded, layout.
+  AHardwareBuffer_Planes planes;
+  ASSERT_EQ(0, AHardwareBuffer_lockPlanes(buffer, AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, -1,
+                                          nullptr, &planes));
+  const uint8_t* src = static_cast<uint8_t*>(mRawP010Image.data);
+  for (int y = 0; y < TEST_IMAGE_HEIGHT; y++) {
+    memcpy(static_cast<uint8_t*>(planes.planes[0].data) + y * planes.planes[0].rowStride,
+           src + y * TEST_IMAGE_WIDTH * 2, TEST_IMAGE_WIDTH * 2);
+  }
+  src += TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * 2;
+  for (int y = 0; y < TEST_IMAGE_HEIGHT / 2; y++) {
+    memcpy(static_cast<uint8_t*>(planes.planes[1].data) + y * planes.planes[1].rowStride,
+           src + y * TEST_IMAGE_WIDTH * 2, TEST_IMAGE_WIDTH * 2);
+  }
+  ASSERT_EQ(0, AHardwareBuffer_unlock(buffer, nullptr));
+
+  JpegR jpegRCodec;
+
+  jpegr_compressed_struct jpegR;
+  jpegR.maxLength = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * sizeof(uint8_t);
+  jpegR.data = malloc(jpegR.maxLength);
+  ret = jpegRCodec.encodeJPEGR(
+      &mRawP010Image, ultrahdr_transfer_function::ULTRAHDR_TF_HLG, &jpegR, DEFAULT_JPEG_QUALITY,
+      nullptr);
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+
+  jpegr_compressed_struct jpegRFromBuffer;
+  jpegRFromBuffer.maxLength = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * sizeof(uint8_t);
+  jpegRFromBuffer.data = malloc(jpegRFromBuffer.maxLength);
+  ret = jpegRCodec.encodeJPEGR(
+      buffer, ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100,
+      ultrahdr_transfer_function::ULTRAHDR_TF_HLG, &jpegRFromBuffer, DEFAULT_JPEG_QUALITY,
+      nullptr);
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+
+  ASSERT_EQ(jpegR.length, jpegRFromBuffer.length)
+      << "Hardware buffer input is yielding different output";
+  ASSERT_EQ(0, memcmp(jpegR.data, jpegRFromBuffer.data, jpegR.length))
+      << "Hardware buffer input is yielding different output";
+
+  AHardwareBuffer_release(buffer);
+  free(jpegR.data);
+  free(jpegRFromBuffer.data);
+}
+
+/* Test Encode API-0 and decode in bands */
+TEST_F(JpegRTest, encodeFromP010ThenDecodeInBands) {
+  int ret;
+
+  // Load input files.
+  if (!loadFile(RAW_P010_IMAGE, mRawP010Image.data, nullptr)) {
+    FAIL() << "Load file " << RAW_P010_IMAGE << " failed";
+  }
+  mRawP010Image.width = TEST_IMAGE_WIDTH;
+  mRawP010Image.height = TEST_IMAGE_HEIGHT;
+  mRawP010Image.colorGamut = ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100;
+
+  JpegR jpegRCodec;
+
+  jpegr_compressed_struct jpegR;
+  jpegR.maxLength = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * sizeof(uint8_t);
+  jpegR.data = malloc(jpegR.maxLength);
+  ret = jpegRCodec.encodeJPEGR(
+      &mRawP010Image, ultrahdr_transfer_function::ULTRAHDR_TF_HLG, &jpegR, DEFAULT_JPEG_QUALITY,
+      nullptr);
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+
+  jpegr_uncompressed_struct decodedJpegR;
+  int decodedJpegRSize = TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * 8;
+  decodedJpegR.data = malloc(decodedJpegRSize);
+  ret = jpegRCodec.decodeJPEGR(&jpegR, &decodedJpegR);
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+
+  // A band height that does not divide the image, so that the last band is shorter.
+  const size_t bandHeight = 100;
+  std::vector<uint8_t> bandedJpegR;
+  size_t nextRow = 0;
+  ret = jpegRCodec.decodeJPEGRInBands(
+      &jpegR, bandHeight, [&](jr_uncompressed_ptr band, size_t firstRow) -> status_t {
+        EXPECT_EQ(nextRow, firstRow);
+        EXPECT_EQ(TEST_IMAGE_WIDTH, band->width);
+        EXPECT_EQ(static_cast<int>(std::min(bandHeight, TEST_IMAGE_HEIGHT - firstRow)),
+                  band->height);
+        const uint8_t* data = static_cast<uint8_t*>(band->data);
+        bandedJpegR.insert(bandedJpegR.end(), data, data + band->width * band->height * 8);
+        nextRow += band->height;
+        return NO_ERROR;
+      });
+  if (ret != OK) {
+    FAIL() << "Error code is " << ret;
+  }
+  ASSERT_EQ(static_cast<size_t>(decodedJpegRSize), bandedJpegR.size());
+  EXPECT_EQ(0, memcmp(decodedJpegR.data, bandedJpegR.data(), decodedJpegRSize))
+      << "Decoding in bands is yielding different output";
+
+  free(jpegR.data);
+  free(decodedJpegR.data);
+}
+
 /* Test Encode API-0 (with stride) and decode */
 TEST_F(JpegRTest, encodeFromP010WithStrideThenDecode) {
   int ret;
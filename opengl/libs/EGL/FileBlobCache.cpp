@@ -125,71 +125,72 @@ void FileBlobCache::writeToFile() {
     ATRACE_CALL();
 
     if (mFilename.length() > 0) {
-        size_t cacheSize = getFlattenedSize();
-        size_t headerSize = cacheFileHeaderSize;
-        const char* fname = mFilename.c_str();
+        writeFileContents(getFileContents());
+    }
+}
 
-        // Try to create the file with no permissions so we can write it
-        // without anyone trying to read it.
-        int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
-        if (fd == -1) {
-            if (errno == EEXIST) {
-                // The file exists, delete it and try again.
-                if (unlink(fname) == -1) {
-                    // No point in retrying if the unlink failed.
-                    ALOGE("error unlinking cache file %s: %s (%d)", fname,
-                            strerror(errno), errno);
-                    return;
-                }
-                // Retry now that we've unlinked the file.
-                fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
-            }
-            if (fd == -1) {
-                ALOGE("error creating cache file %s: %s (%d)", fname,
-                        strerror(errno), errno);
-                return;
-            }
-        }
+std::vector<uint8_t> FileBlobCache::getFileContents() const {
+    ATRACE_CALL();
 
-        size_t fileSize = headerSize + cacheSize;
+    size_t cacheSize = getFlattenedSize();
+    size_t headerSize = cacheFileHeaderSize;
+    std::vector<uint8_t> contents(headerSize + cacheSize);
+    uint8_t* buf = contents.data();
 
-        uint8_t* buf = new uint8_t [fileSize];
-        if (!buf) {
-            ALOGE("error allocating buffer for cache contents: %s (%d)",
-                    strerror(errno), errno);
-            close(fd);
-            unlink(fname);
-            return;
-        }
+    int err = flatten(buf + headerSize, cacheSize);
+    if (err < 0) {
+        ALOGE("error writing cache contents: %s (%d)", strerror(-err),
+                -err);
+        return {};
+    }
 
-        int err = flatten(buf + headerSize, cacheSize);
-        if (err < 0) {
-            ALOGE("error writing cache contents: %s (%d)", strerror(-err),
-                    -err);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
-            return;
-        }
+    // Write the file magic and CRC
+    memcpy(buf, cacheFileMagic, 4);
+    uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
+    *crc = crc32c(buf + headerSize, cacheSize);
+    return contents;
+}
 
-        // Write the file magic and CRC
-        memcpy(buf, cacheFileMagic, 4);
-        uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
-        *crc = crc32c(buf + headerSize, cacheSize);
+void FileBlobCache::writeFileContents(const std::vector<uint8_t>& contents) const {
+    ATRACE_CALL();
 
-        if (write(fd, buf, fileSize) == -1) {
-            ALOGE("error writing cache file: %s (%d)", strerror(errno),
-                    errno);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
+    if (mFilename.length() == 0 || contents.empty()) {
+        return;
+    }
+    const char* fname = mFilename.c_str();
+
+    // Try to create the file with no permissions so we can write it
+    // without anyone trying to read it.
+    int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+    if (fd == -1) {
+        if (errno == EEXIST) {
+            // The file exists, delete it and try again.
+            if (unlink(fname) == -1) {
+                // No point in retrying if the unlink failed.
+                ALOGE("error unlinking cache file %s: %s (%d)", fname,
+                        strerror(errno), errno);
+                return;
+            }
+            // Retry now that we've unlinked the file.
+            fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+        }
+        if (fd == -1) {
+            ALOGE("error creating cache file %s: %s (%d)", fname,
+                    strerror(errno), errno);
             return;
         }
+    }
 
-        delete [] buf;
-        fchmod(fd, S_IRUSR);
+    if (write(fd, contents.data(), contents.size()) == -1) {
+        ALOGE("error writing cache file: %s (%d)", strerror(errno),
+                errno);
         close(fd);
+        unlink(fname);
+        return;
     }
+
+    fchmod(fd, S_IRUSR);
+    close(fd);
 }
 
 size_t FileBlobCache::getSize() {
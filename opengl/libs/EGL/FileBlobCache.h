@@ -19,6 +19,7 @@
 
 #include "BlobCache.h"
 #include <string>
+#include <vector>
 
 namespace android {
 
@@ -35,6 +36,14 @@ public:
     // disk.
     void writeToFile();
 
+    // getFileContents returns what writeToFile would write to disk, or an
+    // empty vector on failure. Along with writeFileContents, this allows the
+    // cache to be modified while its contents are written out.
+    std::vector<uint8_t> getFileContents() const;
+
+    // writeFileContents saves contents returned by getFileContents to disk.
+    void writeFileContents(const std::vector<uint8_t>& contents) const;
+
     // Return the total size of the cache
     size_t getSize();
 
@@ -391,6 +391,25 @@ void Loader::init_api(void* dso,
     }
 }
 
+// Fills curr like init_api(dso, api, ref_api, ...) would, from ref, which init_api already filled
+// for ref_api from the same dso.
+void Loader::copy_api(char const* const* api, char const* const* ref_api,
+                      __eglMustCastToProperFunctionPointerType const* ref,
+                      __eglMustCastToProperFunctionPointerType* curr) {
+    ATRACE_CALL();
+
+    while (*api) {
+        if (std::strcmp(*api, *ref_api) != 0) {
+            *curr++ = nullptr;
+        } else {
+            *curr++ = *ref;
+            api++;
+        }
+        ref++;
+        ref_api++;
+    }
+}
+
 static void* load_system_driver(const char* kind, const char* suffix, const bool exact) {
     ATRACE_CALL();
     class MatchFile {
@@ -659,19 +678,29 @@ void Loader::initialize_api(void* dso, egl_connection_t* cnx, uint32_t mask) {
         }
     }
 
-    if (mask & GLESv1_CM) {
-        init_api(dso, gl_names_1, gl_names,
-            (__eglMustCastToProperFunctionPointerType*)
-                &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
-            getProcAddress);
-    }
-
     if (mask & GLESv2) {
         init_api(dso, gl_names, nullptr,
             (__eglMustCastToProperFunctionPointerType*)
                 &cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl,
             getProcAddress);
     }
+
+    if (mask & GLESv1_CM) {
+        if (mask & GLESv2) {
+            // Both come from the same library, and every GLESv1_CM entry point is also a GLESv2
+            // one, so reuse what was just resolved rather than looking it all up again.
+            copy_api(gl_names_1, gl_names,
+                (__eglMustCastToProperFunctionPointerType*)
+                    &cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl,
+                (__eglMustCastToProperFunctionPointerType*)
+                    &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl);
+        } else {
+            init_api(dso, gl_names_1, gl_names,
+                (__eglMustCastToProperFunctionPointerType*)
+                    &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
+                getProcAddress);
+        }
+    }
 }
 
 } // namespace android
@@ -34,6 +34,7 @@
 #include <chrono>
 #include <limits>
 #include <locale>
+#include <vector>
 
 #include <utils/JenkinsHash.h>
 
@@ -44,18 +45,12 @@ constexpr uint32_t kCrcPlaceholder = 0;
 
 namespace {
 
-// Helper function to close entries or free them
-void freeHotCacheEntry(android::MultifileHotCache& entry) {
-    if (entry.entryFd != -1) {
-        // If we have an fd, then this entry was added to hot cache via INIT or GET
-        // We need to unmap and close the entry
-        munmap(entry.entryBuffer, entry.entrySize);
-        close(entry.entryFd);
-    } else {
-        // Otherwise, this was added to hot cache during SET, so it was never mapped
-        // and fd was only on the deferred thread.
-        delete[] entry.entryBuffer;
-    }
+// Wraps an mmapped entry file so it is unmapped and closed along with its last reference
+std::shared_ptr<uint8_t> wrapMappedEntry(int fd, uint8_t* mappedEntry, size_t fileSize) {
+    return std::shared_ptr<uint8_t>(mappedEntry, [fd, fileSize](uint8_t* entry) {
+        munmap(entry, fileSize);
+        close(fd);
+    });
 }
 
 } // namespace
@@ -71,6 +66,10 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
         mTotalCacheSize(0),
         mHotCacheLimit(0),
         mHotCacheSize(0),
+        mHits(0),
+        mMisses(0),
+        mHotCacheHits(0),
+        mEvictions(0),
         mWorkerThreadIdle(true) {
     if (baseDir.empty()) {
         ALOGV("INIT: no baseDir provided in MultifileBlobCache constructor, returning early.");
@@ -203,12 +202,7 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                           fd, mappedEntry, entryHash);
 
                     // Track the details of the preload so they can be retrieved later
-                    if (!addToHotCache(entryHash, fd, mappedEntry, fileSize)) {
-                        ALOGE("INIT Failed to add %u to hot cache", entryHash);
-                        munmap(mappedEntry, fileSize);
-                        close(fd);
-                        return;
-                    }
+                    addToHotCache(entryHash, wrapMappedEntry(fd, mappedEntry, fileSize), fileSize);
                 } else {
                     // If we're not keeping it in hot cache, unmap it now
                     munmap(mappedEntry, fileSize);
@@ -272,22 +266,23 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
         trimCache();
     }
 
+    // Hold off trimming until the entry is tracked and its write is queued
+    std::shared_lock<std::shared_mutex> cacheLock(mCacheLock);
+
     ALOGV("SET: Add %u to cache", entryHash);
 
-    uint8_t* buffer = new uint8_t[fileSize];
+    std::shared_ptr<uint8_t> buffer(new uint8_t[fileSize], std::default_delete<uint8_t[]>());
 
     // Write placeholders for magic and CRC until deferred thread completes the write
     android::MultifileHeader header = {kMultifileMagic, kCrcPlaceholder, keySize, valueSize};
-    memcpy(static_cast<void*>(buffer), static_cast<const void*>(&header),
+    memcpy(static_cast<void*>(buffer.get()), static_cast<const void*>(&header),
            sizeof(android::MultifileHeader));
     // Write the key and value after the header
-    memcpy(static_cast<void*>(buffer + sizeof(MultifileHeader)), static_cast<const void*>(key),
-           keySize);
-    memcpy(static_cast<void*>(buffer + sizeof(MultifileHeader) + keySize),
+    memcpy(static_cast<void*>(buffer.get() + sizeof(MultifileHeader)),
+           static_cast<const void*>(key), keySize);
+    memcpy(static_cast<void*>(buffer.get() + sizeof(MultifileHeader) + keySize),
            static_cast<const void*>(value), valueSize);
 
-    std::string fullPath = mMultifileDirName + "/" + std::to_string(entryHash);
-
     // Track the size and access time for quick recall
     trackEntry(entryHash, valueSize, fileSize, time(0));
 
@@ -296,27 +291,19 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
 
     // Keep the entry in hot cache for quick retrieval
     ALOGV("SET: Adding %u to hot cache.", entryHash);
+    addToHotCache(entryHash, buffer, fileSize);
 
-    // Sending -1 as the fd indicates we don't have an fd for this
-    if (!addToHotCache(entryHash, -1, buffer, fileSize)) {
-        ALOGE("SET: Failed to add %u to hot cache", entryHash);
-        delete[] buffer;
-        return;
-    }
-
-    // Track that we're creating a pending write for this entry
-    // Include the buffer to handle the case when multiple writes are pending for an entry
+    // Track that we're creating a pending write for this entry, replacing any older one that
+    // hasn't been written yet
     {
         // Synchronize access to deferred write status
         std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
-        mDeferredWrites.insert(std::make_pair(entryHash, buffer));
+        mDeferredWrites[entryHash] = {std::move(buffer), fileSize};
     }
 
     // Create deferred task to write to storage
     ALOGV("SET: Adding task to queue.");
-    DeferredTask task(TaskCommand::WriteToDisk);
-    task.initWriteToDisk(entryHash, fullPath, buffer, fileSize);
-    queueTask(std::move(task));
+    queueTask(DeferredTask(TaskCommand::WriteToDisk));
 }
 
 // Get will check the hot cache, then load it from disk if needed
@@ -336,15 +323,17 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
     // Generate a hash of the key and use it to track this entry
     uint32_t entryHash = android::JenkinsHashMixBytes(0, static_cast<const uint8_t*>(key), keySize);
 
-    // See if we have this file
-    if (!contains(entryHash)) {
+    // Keep the entry from being evicted while we read it
+    std::shared_lock<std::shared_mutex> cacheLock(mCacheLock);
+
+    // See if we have this file, and look up the data for it
+    MultifileEntryStats entryStats;
+    if (!getEntryStats(entryHash, &entryStats)) {
         ALOGV("GET: Cache MISS - cache does not contain entry: %u", entryHash);
+        mMisses++;
         return 0;
     }
 
-    // Look up the data for this entry
-    MultifileEntryStats entryStats = getEntryStats(entryHash);
-
     size_t cachedValueSize = entryStats.valueSize;
     if (cachedValueSize > valueSize) {
         ALOGV("GET: Cache MISS - valueSize not large enough (%lu) for entry %u, returning required"
@@ -362,82 +351,85 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
         ALOGW("keySize (%lu) is larger than entrySize (%zu). This is a hash collision or modified "
               "file",
               keySize, fileSize);
+        mMisses++;
         return 0;
     }
 
     std::string fullPath = mMultifileDirName + "/" + std::to_string(entryHash);
 
-    // Open the hashed filename path
-    uint8_t* cacheEntry = 0;
+    // Hold a reference to the entry, so it stays valid if another thread drops it from hot cache
+    std::shared_ptr<uint8_t> cacheEntry;
 
     // Check hot cache
-    if (mHotCache.find(entryHash) != mHotCache.end()) {
+    {
+        IndexShard& shard = getShard(entryHash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto hotCacheIter = shard.hotCache.find(entryHash);
+        if (hotCacheIter != shard.hotCache.end()) {
+            cacheEntry = hotCacheIter->second.entryBuffer;
+        }
+    }
+
+    if (cacheEntry) {
         ALOGV("GET: HotCache HIT for entry %u", entryHash);
-        cacheEntry = mHotCache[entryHash].entryBuffer;
+        mHotCacheHits++;
     } else {
         ALOGV("GET: HotCache MISS for entry: %u", entryHash);
 
-        // Wait for writes to complete if there is an outstanding write for this entry
-        bool wait = false;
-        {
-            // Synchronize access to deferred write status
-            std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
-            wait = mDeferredWrites.find(entryHash) != mDeferredWrites.end();
-        }
-
-        if (wait) {
-            ALOGV("GET: Waiting for write to complete for %u", entryHash);
-            waitForWorkComplete();
-        }
+        // If the entry is still waiting to be written, use the pending contents
+        cacheEntry = getDeferredWrite(entryHash);
+    }
 
+    if (!cacheEntry) {
         // Open the entry file
         int fd = open(fullPath.c_str(), O_RDONLY);
         if (fd == -1) {
             ALOGE("Cache error - failed to open fullPath: %s, error: %s", fullPath.c_str(),
                   std::strerror(errno));
+            mMisses++;
             return 0;
         }
 
         // Memory map the file
-        cacheEntry =
+        uint8_t* mappedEntry =
                 reinterpret_cast<uint8_t*>(mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0));
-        if (cacheEntry == MAP_FAILED) {
+        if (mappedEntry == MAP_FAILED) {
             ALOGE("Failed to mmap cacheEntry, error: %s", std::strerror(errno));
             close(fd);
+            mMisses++;
             return 0;
         }
+        cacheEntry = wrapMappedEntry(fd, mappedEntry, fileSize);
 
         ALOGV("GET: Adding %u to hot cache", entryHash);
-        if (!addToHotCache(entryHash, fd, cacheEntry, fileSize)) {
-            ALOGE("GET: Failed to add %u to hot cache", entryHash);
-            return 0;
-        }
-
-        cacheEntry = mHotCache[entryHash].entryBuffer;
+        addToHotCache(entryHash, cacheEntry, fileSize);
     }
 
     // Ensure the header matches
-    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(cacheEntry);
+    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(cacheEntry.get());
     if (header->keySize != keySize || header->valueSize != valueSize) {
         ALOGW("Mismatch on keySize(%ld vs. cached %ld) or valueSize(%ld vs. cached %ld) compared "
               "to cache header values for fullPath: %s",
               keySize, header->keySize, valueSize, header->valueSize, fullPath.c_str());
         removeFromHotCache(entryHash);
+        mMisses++;
         return 0;
     }
 
     // Compare the incoming key with our stored version (the beginning of the entry)
-    uint8_t* cachedKey = cacheEntry + sizeof(MultifileHeader);
+    uint8_t* cachedKey = cacheEntry.get() + sizeof(MultifileHeader);
     int compare = memcmp(cachedKey, key, keySize);
     if (compare != 0) {
         ALOGW("Cached key and new key do not match! This is a hash collision or modified file");
         removeFromHotCache(entryHash);
+        mMisses++;
         return 0;
     }
 
     // Remaining entry following the key is the value
-    uint8_t* cachedValue = cacheEntry + (keySize + sizeof(MultifileHeader));
+    uint8_t* cachedValue = cacheEntry.get() + (keySize + sizeof(MultifileHeader));
     memcpy(value, cachedValue, cachedValueSize);
+    mHits++;
 
     return cachedValueSize;
 }
@@ -447,34 +439,48 @@ void MultifileBlobCache::finish() {
         return;
     }
 
+    std::unique_lock<std::shared_mutex> cacheLock(mCacheLock);
+
     // Wait for all deferred writes to complete
     ALOGV("FINISH: Waiting for work to complete.");
     waitForWorkComplete();
 
     // Close all entries in the hot cache
-    for (auto hotCacheIter = mHotCache.begin(); hotCacheIter != mHotCache.end();) {
-        uint32_t entryHash = hotCacheIter->first;
-        MultifileHotCache entry = hotCacheIter->second;
-
-        ALOGV("FINISH: Closing hot cache entry for %u", entryHash);
-        freeHotCacheEntry(entry);
-
-        mHotCache.erase(hotCacheIter++);
+    for (IndexShard& shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto hotCacheIter = shard.hotCache.begin(); hotCacheIter != shard.hotCache.end();) {
+            ALOGV("FINISH: Closing hot cache entry for %u", hotCacheIter->first);
+            mHotCacheSize -= hotCacheIter->second.entrySize;
+            hotCacheIter = shard.hotCache.erase(hotCacheIter);
+        }
     }
 }
 
-void MultifileBlobCache::trackEntry(uint32_t entryHash, EGLsizeiANDROID valueSize, size_t fileSize,
-                                    time_t accessTime) {
-    mEntries.insert(entryHash);
-    mEntryStats[entryHash] = {valueSize, fileSize, accessTime};
+MultifileCacheStats MultifileBlobCache::getStats() const {
+    return {mHits.load(), mMisses.load(), mHotCacheHits.load(), mEvictions.load()};
 }
 
-bool MultifileBlobCache::contains(uint32_t hashEntry) const {
-    return mEntries.find(hashEntry) != mEntries.end();
+void MultifileBlobCache::trackEntry(uint32_t entryHash, EGLsizeiANDROID valueSize, size_t fileSize,
+                                    time_t accessTime) {
+    IndexShard& shard = getShard(entryHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto entryIter = shard.entryStats.find(entryHash);
+    if (entryIter != shard.entryStats.end()) {
+        // The entry is being replaced, so its old file no longer counts towards the total
+        decreaseTotalCacheSize(entryIter->second.fileSize);
+    }
+    shard.entryStats[entryHash] = {valueSize, fileSize, accessTime};
 }
 
-MultifileEntryStats MultifileBlobCache::getEntryStats(uint32_t entryHash) {
-    return mEntryStats[entryHash];
+bool MultifileBlobCache::getEntryStats(uint32_t entryHash, MultifileEntryStats* entryStats) {
+    IndexShard& shard = getShard(entryHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto entryIter = shard.entryStats.find(entryHash);
+    if (entryIter == shard.entryStats.end()) {
+        return false;
+    }
+    *entryStats = entryIter->second;
+    return true;
 }
 
 void MultifileBlobCache::increaseTotalCacheSize(size_t fileSize) {
@@ -485,7 +491,8 @@ void MultifileBlobCache::decreaseTotalCacheSize(size_t fileSize) {
     mTotalCacheSize -= fileSize;
 }
 
-bool MultifileBlobCache::addToHotCache(uint32_t newEntryHash, int newFd, uint8_t* newEntryBuffer,
+void MultifileBlobCache::addToHotCache(uint32_t newEntryHash,
+                                       std::shared_ptr<uint8_t> newEntryBuffer,
                                        size_t newEntrySize) {
     ALOGV("HOTCACHE(ADD): Adding %u to hot cache", newEntryHash);
 
@@ -494,100 +501,95 @@ bool MultifileBlobCache::addToHotCache(uint32_t newEntryHash, int newFd, uint8_t
         ALOGV("HOTCACHE(ADD): mHotCacheSize (%zu) + newEntrySize (%zu) is to big for "
               "mHotCacheLimit "
               "(%zu), freeing up space for %u",
-              mHotCacheSize, newEntrySize, mHotCacheLimit, newEntryHash);
+              mHotCacheSize.load(), newEntrySize, mHotCacheLimit, newEntryHash);
+        freeHotCacheSpace(newEntrySize);
+    }
 
-        // Wait for all the files to complete writing so our hot cache is accurate
-        ALOGV("HOTCACHE(ADD): Waiting for work to complete for %u", newEntryHash);
-        waitForWorkComplete();
+    // Track it, replacing an older copy of the same entry
+    IndexShard& shard = getShard(newEntryHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    removeFromHotCacheLocked(shard, newEntryHash);
+    shard.hotCache[newEntryHash] = {std::move(newEntryBuffer), newEntrySize};
+    mHotCacheSize += newEntrySize;
 
-        // Free up old entries until under the limit
-        for (auto hotCacheIter = mHotCache.begin(); hotCacheIter != mHotCache.end();) {
-            uint32_t oldEntryHash = hotCacheIter->first;
-            MultifileHotCache oldEntry = hotCacheIter->second;
+    ALOGV("HOTCACHE(ADD): New hot cache size: %zu", mHotCacheSize.load());
+}
 
-            // Move our iterator before deleting the entry
-            hotCacheIter++;
-            if (!removeFromHotCache(oldEntryHash)) {
-                ALOGE("HOTCACHE(ADD): Unable to remove entry %u", oldEntryHash);
-                return false;
-            }
+// Free up old entries until at least half the hot cache can be used for the new entry. Entries
+// that are still being written stay alive until their write is done, so this never needs to
+// wait for the worker thread.
+void MultifileBlobCache::freeHotCacheSpace(size_t newEntrySize) {
+    for (IndexShard& shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto hotCacheIter = shard.hotCache.begin(); hotCacheIter != shard.hotCache.end();) {
+            ALOGV("HOTCACHE(ADD): Closing hot cache entry for %u", hotCacheIter->first);
+            mHotCacheSize -= hotCacheIter->second.entrySize;
+            hotCacheIter = shard.hotCache.erase(hotCacheIter);
 
             // Clear at least half the hot cache
             if ((mHotCacheSize + newEntrySize) <= mHotCacheLimit / 2) {
-                ALOGV("HOTCACHE(ADD): Freed enough space for %zu", mHotCacheSize);
-                break;
+                ALOGV("HOTCACHE(ADD): Freed enough space for %zu", mHotCacheSize.load());
+                return;
             }
         }
     }
-
-    // Track it
-    mHotCache[newEntryHash] = {newFd, newEntryBuffer, newEntrySize};
-    mHotCacheSize += newEntrySize;
-
-    ALOGV("HOTCACHE(ADD): New hot cache size: %zu", mHotCacheSize);
-
-    return true;
 }
 
 bool MultifileBlobCache::removeFromHotCache(uint32_t entryHash) {
-    if (mHotCache.find(entryHash) != mHotCache.end()) {
-        ALOGV("HOTCACHE(REMOVE): Removing %u from hot cache", entryHash);
-
-        // Wait for all the files to complete writing so our hot cache is accurate
-        ALOGV("HOTCACHE(REMOVE): Waiting for work to complete for %u", entryHash);
-        waitForWorkComplete();
+    IndexShard& shard = getShard(entryHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return removeFromHotCacheLocked(shard, entryHash);
+}
 
-        ALOGV("HOTCACHE(REMOVE): Closing hot cache entry for %u", entryHash);
-        MultifileHotCache entry = mHotCache[entryHash];
-        freeHotCacheEntry(entry);
+bool MultifileBlobCache::removeFromHotCacheLocked(IndexShard& shard, uint32_t entryHash) {
+    auto hotCacheIter = shard.hotCache.find(entryHash);
+    if (hotCacheIter == shard.hotCache.end()) {
+        return false;
+    }
 
-        // Delete the entry from our tracking
-        mHotCacheSize -= entry.entrySize;
-        mHotCache.erase(entryHash);
+    ALOGV("HOTCACHE(REMOVE): Closing hot cache entry for %u", entryHash);
 
-        return true;
-    }
+    // Delete the entry from our tracking, the buffer goes away with its last reference
+    mHotCacheSize -= hotCacheIter->second.entrySize;
+    shard.hotCache.erase(hotCacheIter);
 
-    return false;
+    return true;
 }
 
 bool MultifileBlobCache::applyLRU(size_t cacheLimit) {
     // Walk through our map of sorted last access times and remove files until under the limit
-    for (auto cacheEntryIter = mEntryStats.begin(); cacheEntryIter != mEntryStats.end();) {
-        uint32_t entryHash = cacheEntryIter->first;
+    for (IndexShard& shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto cacheEntryIter = shard.entryStats.begin();
+             cacheEntryIter != shard.entryStats.end();) {
+            uint32_t entryHash = cacheEntryIter->first;
 
-        ALOGV("LRU: Removing entryHash %u", entryHash);
+            ALOGV("LRU: Removing entryHash %u", entryHash);
 
-        // Track the overall size
-        MultifileEntryStats entryStats = getEntryStats(entryHash);
-        decreaseTotalCacheSize(entryStats.fileSize);
+            // Track the overall size
+            decreaseTotalCacheSize(cacheEntryIter->second.fileSize);
 
-        // Remove it from hot cache if present
-        removeFromHotCache(entryHash);
-
-        // Remove it from the system
-        std::string entryPath = mMultifileDirName + "/" + std::to_string(entryHash);
-        if (remove(entryPath.c_str()) != 0) {
-            ALOGE("LRU: Error removing %s: %s", entryPath.c_str(), std::strerror(errno));
-            return false;
-        }
+            // Remove it from hot cache if present
+            removeFromHotCacheLocked(shard, entryHash);
 
-        // Increment the iterator before clearing the entry
-        cacheEntryIter++;
+            // Remove it from the system
+            std::string entryPath = mMultifileDirName + "/" + std::to_string(entryHash);
+            if (remove(entryPath.c_str()) != 0) {
+                ALOGE("LRU: Error removing %s: %s", entryPath.c_str(), std::strerror(errno));
+                return false;
+            }
 
-        // Delete the entry from our tracking
-        size_t count = mEntryStats.erase(entryHash);
-        if (count != 1) {
-            ALOGE("LRU: Failed to remove entryHash (%u) from mEntryStats", entryHash);
-            return false;
-        }
+            // Delete the entry from our tracking
+            cacheEntryIter = shard.entryStats.erase(cacheEntryIter);
+            mEvictions++;
 
-        // See if it has been reduced enough
-        size_t totalCacheSize = getTotalSize();
-        if (totalCacheSize <= cacheLimit) {
-            // Success
-            ALOGV("LRU: Reduced cache to %zu", totalCacheSize);
-            return true;
+            // See if it has been reduced enough
+            size_t totalCacheSize = getTotalSize();
+            if (totalCacheSize <= cacheLimit) {
+                // Success
+                ALOGV("LRU: Reduced cache to %zu", totalCacheSize);
+                return true;
+            }
         }
     }
 
@@ -601,7 +603,16 @@ constexpr uint32_t kCacheLimitDivisor = 2;
 
 // Calculate the cache size and remove old entries until under the limit
 void MultifileBlobCache::trimCache() {
-    // Wait for all deferred writes to complete
+    // Keep other threads out until the evicted entries are gone from both the index and disk
+    std::unique_lock<std::shared_mutex> cacheLock(mCacheLock);
+
+    // Another thread may have trimmed the cache while we waited for the lock
+    if (getTotalSize() <= mMaxTotalSize / kCacheLimitDivisor) {
+        ALOGV("TRIM: Cache was already reduced to %zu", getTotalSize());
+        return;
+    }
+
+    // Wait for all deferred writes to complete. No new ones can be queued while we hold the lock.
     ALOGV("TRIM: Waiting for work to complete.");
     waitForWorkComplete();
 
@@ -612,72 +623,74 @@ void MultifileBlobCache::trimCache() {
     }
 }
 
-// This function performs a task.  It only knows how to write files to disk,
-// but it could be expanded if needed.
-void MultifileBlobCache::processTask(DeferredTask& task) {
-    switch (task.getTaskCommand()) {
-        case TaskCommand::Exit: {
-            ALOGV("DEFERRED: Shutting down");
-            return;
-        }
-        case TaskCommand::WriteToDisk: {
-            uint32_t entryHash = task.getEntryHash();
-            std::string& fullPath = task.getFullPath();
-            uint8_t* buffer = task.getBuffer();
-            size_t bufferSize = task.getBufferSize();
-
-            // Create the file or reset it if already present, read+write for user only
-            int fd = open(fullPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-            if (fd == -1) {
-                ALOGE("Cache error in SET - failed to open fullPath: %s, error: %s",
-                      fullPath.c_str(), std::strerror(errno));
-                return;
-            }
+std::shared_ptr<uint8_t> MultifileBlobCache::getDeferredWrite(uint32_t entryHash) {
+    std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
+    auto deferredWriteIter = mDeferredWrites.find(entryHash);
+    if (deferredWriteIter == mDeferredWrites.end()) {
+        return nullptr;
+    }
+    return deferredWriteIter->second.buffer;
+}
 
-            ALOGV("DEFERRED: Opened fd %i from %s", fd, fullPath.c_str());
+// Write every pending entry in one pass. Entries stay in mDeferredWrites until they are on disk,
+// unless they were set again meanwhile, in which case the newer contents get written next time.
+void MultifileBlobCache::flushDeferredWrites() {
+    std::vector<std::pair<uint32_t, DeferredWrite>> batch;
+    {
+        // Synchronize access to deferred write status
+        std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
+        batch.assign(mDeferredWrites.begin(), mDeferredWrites.end());
+    }
 
-            // Add CRC check to the header (always do this last!)
-            MultifileHeader* header = reinterpret_cast<MultifileHeader*>(buffer);
-            header->crc =
-                    crc32c(buffer + sizeof(MultifileHeader), bufferSize - sizeof(MultifileHeader));
+    ALOGV("DEFERRED: Writing a batch of %zu entries", batch.size());
+    for (const auto& [entryHash, deferredWrite] : batch) {
+        writeEntry(entryHash, deferredWrite.buffer.get(), deferredWrite.bufferSize);
+    }
 
-            ssize_t result = write(fd, buffer, bufferSize);
-            if (result != bufferSize) {
-                ALOGE("Error writing fileSize to cache entry (%s): %s", fullPath.c_str(),
-                      std::strerror(errno));
-                return;
-            }
+    // Synchronize access to deferred write status
+    std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
+    for (const auto& [entryHash, deferredWrite] : batch) {
+        auto deferredWriteIter = mDeferredWrites.find(entryHash);
+        if (deferredWriteIter != mDeferredWrites.end() &&
+            deferredWriteIter->second.buffer == deferredWrite.buffer) {
+            ALOGV("DEFERRED: Marking write complete for %u at %p", entryHash,
+                  deferredWrite.buffer.get());
+            mDeferredWrites.erase(deferredWriteIter);
+        }
+    }
+}
 
-            ALOGV("DEFERRED: Completed write for: %s", fullPath.c_str());
-            close(fd);
+void MultifileBlobCache::writeEntry(uint32_t entryHash, uint8_t* buffer, size_t bufferSize) {
+    std::string fullPath = mMultifileDirName + "/" + std::to_string(entryHash);
 
-            // Erase the entry from mDeferredWrites
-            // Since there could be multiple outstanding writes for an entry, find the matching one
-            {
-                // Synchronize access to deferred write status
-                std::lock_guard<std::mutex> lock(mDeferredWriteStatusMutex);
-                typedef std::multimap<uint32_t, uint8_t*>::iterator entryIter;
-                std::pair<entryIter, entryIter> iterPair = mDeferredWrites.equal_range(entryHash);
-                for (entryIter it = iterPair.first; it != iterPair.second; ++it) {
-                    if (it->second == buffer) {
-                        ALOGV("DEFERRED: Marking write complete for %u at %p", it->first,
-                              it->second);
-                        mDeferredWrites.erase(it);
-                        break;
-                    }
-                }
-            }
+    // Create the file or reset it if already present, read+write for user only
+    int fd = open(fullPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        ALOGE("Cache error in SET - failed to open fullPath: %s, error: %s", fullPath.c_str(),
+              std::strerror(errno));
+        return;
+    }
 
-            return;
-        }
-        default: {
-            ALOGE("DEFERRED: Unhandled task type");
-            return;
-        }
+    ALOGV("DEFERRED: Opened fd %i from %s", fd, fullPath.c_str());
+
+    // Add CRC check to the header (always do this last!)
+    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(buffer);
+    header->crc = crc32c(buffer + sizeof(MultifileHeader), bufferSize - sizeof(MultifileHeader));
+
+    ssize_t result = write(fd, buffer, bufferSize);
+    if (result != bufferSize) {
+        ALOGE("Error writing fileSize to cache entry (%s): %s", fullPath.c_str(),
+              std::strerror(errno));
+        close(fd);
+        return;
     }
+
+    ALOGV("DEFERRED: Completed write for: %s", fullPath.c_str());
+    close(fd);
 }
 
-// This function will wait until tasks arrive, then execute them
+// This function will wait until tasks arrive, then execute them. All tasks queued by the time
+// the worker wakes up are handled together, so a burst of sets turns into one batch of writes.
 // If the exit command is submitted, the loop will terminate
 void MultifileBlobCache::processTasksImpl(bool* exitThread) {
     while (true) {
@@ -692,19 +705,36 @@ void MultifileBlobCache::processTasksImpl(bool* exitThread) {
 
         ALOGV("WORKER: Task available, waking up.");
         mWorkerThreadIdle = false;
-        DeferredTask task = std::move(mTasks.front());
-        mTasks.pop();
+        bool writeToDisk = false;
+        bool exit = false;
+        while (!mTasks.empty()) {
+            switch (mTasks.front().getTaskCommand()) {
+                case TaskCommand::WriteToDisk:
+                    writeToDisk = true;
+                    break;
+                case TaskCommand::Exit:
+                    exit = true;
+                    break;
+                default:
+                    ALOGE("DEFERRED: Unhandled task type");
+                    break;
+            }
+            mTasks.pop();
+        }
+
+        lock.unlock();
+        if (writeToDisk) {
+            flushDeferredWrites();
+        }
 
-        if (task.getTaskCommand() == TaskCommand::Exit) {
+        if (exit) {
             ALOGV("WORKER: Exiting work loop.");
+            lock.lock();
             *exitThread = true;
             mWorkerThreadIdle = true;
             mWorkerIdleCondition.notify_one();
             return;
         }
-
-        lock.unlock();
-        processTask(task);
     }
 }
 
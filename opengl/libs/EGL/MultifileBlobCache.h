@@ -21,13 +21,16 @@
 #include <EGL/eglext.h>
 
 #include <android-base/thread_annotations.h>
+#include <array>
+#include <atomic>
 #include <future>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
-#include <unordered_set>
 
 #include "FileBlobCache.h"
 
@@ -46,12 +49,20 @@ struct MultifileEntryStats {
     time_t accessTime;
 };
 
+// The buffer either holds an mmapped entry file or an entry created by SET, and is released
+// once the hot cache and any pending write are both done with it.
 struct MultifileHotCache {
-    int entryFd;
-    uint8_t* entryBuffer;
+    std::shared_ptr<uint8_t> entryBuffer;
     size_t entrySize;
 };
 
+struct MultifileCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t hotCacheHits;
+    uint64_t evictions;
+};
+
 enum class TaskCommand {
     Invalid = 0,
     WriteToDisk,
@@ -60,33 +71,12 @@ enum class TaskCommand {
 
 class DeferredTask {
 public:
-    DeferredTask(TaskCommand command)
-          : mCommand(command), mEntryHash(0), mBuffer(nullptr), mBufferSize(0) {}
+    DeferredTask(TaskCommand command) : mCommand(command) {}
 
     TaskCommand getTaskCommand() { return mCommand; }
 
-    void initWriteToDisk(uint32_t entryHash, std::string fullPath, uint8_t* buffer,
-                         size_t bufferSize) {
-        mCommand = TaskCommand::WriteToDisk;
-        mEntryHash = entryHash;
-        mFullPath = std::move(fullPath);
-        mBuffer = buffer;
-        mBufferSize = bufferSize;
-    }
-
-    uint32_t getEntryHash() { return mEntryHash; }
-    std::string& getFullPath() { return mFullPath; }
-    uint8_t* getBuffer() { return mBuffer; }
-    size_t getBufferSize() { return mBufferSize; };
-
 private:
     TaskCommand mCommand;
-
-    // Parameters for WriteToDisk
-    uint32_t mEntryHash;
-    std::string mFullPath;
-    uint8_t* mBuffer;
-    size_t mBufferSize;
 };
 
 class MultifileBlobCache {
@@ -104,21 +94,32 @@ public:
 
     size_t getTotalSize() const { return mTotalCacheSize; }
 
+    MultifileCacheStats getStats() const;
+
 private:
+    // The index is split by entryHash into shards with their own lock, so that threads setting
+    // and getting different entries rarely wait for each other.
+    static constexpr size_t kIndexShardCount = 16;
+
+    struct IndexShard {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, MultifileEntryStats> entryStats GUARDED_BY(mutex);
+        std::unordered_map<uint32_t, MultifileHotCache> hotCache GUARDED_BY(mutex);
+    };
+
+    IndexShard& getShard(uint32_t entryHash) { return mShards[entryHash % kIndexShardCount]; }
+
     void trackEntry(uint32_t entryHash, EGLsizeiANDROID valueSize, size_t fileSize,
                     time_t accessTime);
-    bool contains(uint32_t entryHash) const;
-    bool removeEntry(uint32_t entryHash);
-    MultifileEntryStats getEntryStats(uint32_t entryHash);
-
-    size_t getFileSize(uint32_t entryHash);
-    size_t getValueSize(uint32_t entryHash);
+    bool getEntryStats(uint32_t entryHash, MultifileEntryStats* entryStats);
 
     void increaseTotalCacheSize(size_t fileSize);
     void decreaseTotalCacheSize(size_t fileSize);
 
-    bool addToHotCache(uint32_t entryHash, int fd, uint8_t* entryBufer, size_t entrySize);
+    void addToHotCache(uint32_t entryHash, std::shared_ptr<uint8_t> entryBuffer, size_t entrySize);
     bool removeFromHotCache(uint32_t entryHash);
+    bool removeFromHotCacheLocked(IndexShard& shard, uint32_t entryHash) REQUIRES(shard.mutex);
+    void freeHotCacheSpace(size_t entrySize);
 
     void trimCache();
     bool applyLRU(size_t cacheLimit);
@@ -126,28 +127,45 @@ private:
     bool mInitialized;
     std::string mMultifileDirName;
 
-    std::unordered_set<uint32_t> mEntries;
-    std::unordered_map<uint32_t, MultifileEntryStats> mEntryStats;
-    std::unordered_map<uint32_t, MultifileHotCache> mHotCache;
+    std::array<IndexShard, kIndexShardCount> mShards;
+
+    // Held shared by SET and GET, and exclusively while trimming or finishing, so that evicting
+    // entries never overlaps with another thread tracking, reading or writing them
+    std::shared_mutex mCacheLock;
 
     size_t mMaxKeySize;
     size_t mMaxValueSize;
     size_t mMaxTotalSize;
-    size_t mTotalCacheSize;
+    std::atomic<size_t> mTotalCacheSize;
     size_t mHotCacheLimit;
     size_t mHotCacheEntryLimit;
-    size_t mHotCacheSize;
+    std::atomic<size_t> mHotCacheSize;
+
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
+    std::atomic<uint64_t> mHotCacheHits;
+    std::atomic<uint64_t> mEvictions;
 
     // Below are the components used for deferred writes
 
-    // Track whether we have pending writes for an entry
+    // The latest contents of each entry that still has to be written to disk. Sets of the same
+    // entry before the worker gets to it only write the last one, and GET reads entries from
+    // here until they are on disk.
+    struct DeferredWrite {
+        std::shared_ptr<uint8_t> buffer;
+        size_t bufferSize;
+    };
     std::mutex mDeferredWriteStatusMutex;
-    std::multimap<uint32_t, uint8_t*> mDeferredWrites GUARDED_BY(mDeferredWriteStatusMutex);
+    std::unordered_map<uint32_t, DeferredWrite> mDeferredWrites
+            GUARDED_BY(mDeferredWriteStatusMutex);
+
+    std::shared_ptr<uint8_t> getDeferredWrite(uint32_t entryHash);
 
     // Functions to work through tasks in the queue
     void processTasks();
     void processTasksImpl(bool* exitThread);
-    void processTask(DeferredTask& task);
+    void flushDeferredWrites();
+    void writeEntry(uint32_t entryHash, uint8_t* buffer, size_t bufferSize);
 
     // Used by main thread to create work for the worker thread
     void queueTask(DeferredTask&& task);
@@ -20,8 +20,12 @@
 #include <fcntl.h>
 #include <gtest/gtest.h>
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace android {
 
@@ -216,4 +220,97 @@ TEST_F(MultifileBlobCacheTest, CacheMinKeyAndValueSizeSucceeds) {
     ASSERT_EQ('y', buf[0]);
 }
 
+TEST_F(MultifileBlobCacheTest, StatsCountHitsAndMisses) {
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    mMBC->set("abcd", 4, "efgh", 4);
+    ASSERT_EQ(size_t(4), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ(size_t(0), mMBC->get("ijkl", 4, buf, 4));
+    MultifileCacheStats stats = mMBC->getStats();
+    ASSERT_EQ(uint64_t(1), stats.hits);
+    ASSERT_EQ(uint64_t(1), stats.hotCacheHits);
+    ASSERT_EQ(uint64_t(1), stats.misses);
+    ASSERT_EQ(uint64_t(0), stats.evictions);
+}
+
+TEST_F(MultifileBlobCacheTest, StatsCountEvictions) {
+    char key[kMaxKeySize];
+    char buf[kMaxValueSize];
+    memset(buf, 'b', kMaxValueSize);
+    // Fill the cache beyond its limit, which trims older entries
+    for (int i = 0; i < 8; i++) {
+        memset(key, 'a' + i, kMaxKeySize);
+        mMBC->set(key, kMaxKeySize, buf, kMaxValueSize);
+    }
+    ASSERT_LE(mMBC->getTotalSize(), kMaxTotalSize);
+    ASSERT_GT(mMBC->getStats().evictions, uint64_t(0));
+}
+
+TEST_F(MultifileBlobCacheTest, GetFromDiskAfterReload) {
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(size_t(4), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ('f', buf[1]);
+    ASSERT_EQ('g', buf[2]);
+    ASSERT_EQ('h', buf[3]);
+}
+
+TEST_F(MultifileBlobCacheTest, ConcurrentSetsAndGetsSucceed) {
+    constexpr int kThreadCount = 4;
+    constexpr int kEntriesPerThread = 64;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; t++) {
+        threads.emplace_back([this, t] {
+            for (int i = 0; i < kEntriesPerThread; i++) {
+                int key[2] = {t, i};
+                int value = t * kEntriesPerThread + i;
+                mMBC->set(key, sizeof(key), &value, sizeof(value));
+                int cached = -1;
+                ASSERT_EQ(sizeof(value), mMBC->get(key, sizeof(key), &cached, sizeof(cached)));
+                ASSERT_EQ(value, cached);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(uint64_t(kThreadCount * kEntriesPerThread), mMBC->getStats().hits);
+}
+
+TEST_F(MultifileBlobCacheTest, ConcurrentSetsWithEvictionsKeepDiskInSync) {
+    constexpr int kThreadCount = 4;
+    constexpr int kEntriesPerThread = 16;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; t++) {
+        threads.emplace_back([this, t] {
+            std::vector<char> value(kMaxValueSize / 2);
+            std::vector<char> cached(value.size());
+            for (int i = 0; i < kEntriesPerThread; i++) {
+                int key[2] = {t, i};
+                std::fill(value.begin(), value.end(), static_cast<char>('a' + i));
+                mMBC->set(key, sizeof(key), value.data(), value.size());
+                // Another thread may have evicted it already, but never leaves it half gone
+                if (mMBC->get(key, sizeof(key), cached.data(), cached.size()) != 0) {
+                    ASSERT_EQ(value, cached);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_GT(mMBC->getStats().evictions, uint64_t(0));
+
+    // Every tracked entry is on disk, and every entry on disk is tracked
+    size_t totalSize = mMBC->getTotalSize();
+    ASSERT_LE(totalSize, kMaxTotalSize);
+    mMBC->finish();
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(totalSize, mMBC->getTotalSize());
+}
+
 } // namespace android
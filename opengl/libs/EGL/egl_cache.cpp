@@ -19,12 +19,20 @@
 #include "egl_cache.h"
 
 #include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <graphicsenv/GraphicsEnv.h>
 #include <inttypes.h>
 #include <log/log.h>
 #include <private/EGL/cache.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <functional>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include "../egl_impl.h"
 #include "egl_display.h"
@@ -37,11 +45,23 @@ static const size_t kMaxMonolithicTotalSize = 2 * 1024 * 1024;
 // The time in seconds to wait before saving newly inserted monolithic cache entries.
 static const unsigned int kDeferredMonolithicSaveDelay = 4;
 
+// Size limit of the cache shared with the other processes of an app, and the time in seconds to
+// wait before sharing newly inserted entries.
+static const size_t kMaxSharedTotalSize = 2 * 1024 * 1024;
+static const unsigned int kDeferredSharedPublishDelay = 4;
+
+// The number of this process's keys that are shared with the other processes of the app.
+static const size_t kMaxSharedKeys = 1024;
+
 // Multifile cache size limits
 constexpr uint32_t kMaxMultifileKeySize = 1 * 1024 * 1024;
 constexpr uint32_t kMaxMultifileValueSize = 8 * 1024 * 1024;
 constexpr uint32_t kMaxMultifileTotalSize = 32 * 1024 * 1024;
 
+// The number of missed keys remembered to measure shader compile times. Keys the driver never
+// sets don't accumulate past this.
+static const size_t kMaxPendingCompiles = 64;
+
 namespace android {
 
 #define BC_EXT_STR "EGL_ANDROID_blob_cache"
@@ -68,7 +88,12 @@ static EGLsizeiANDROID getBlob(const void* key, EGLsizeiANDROID keySize, void* v
 // egl_cache_t definition
 //
 egl_cache_t::egl_cache_t()
-      : mInitialized(false), mMultifileMode(false), mCacheByteLimit(kMaxMonolithicTotalSize) {}
+      : mInitialized(false),
+        mSharedLoadStarted(false),
+        mSharedPublishPending(false),
+        mMultifileMode(false),
+        mSharedMode(false),
+        mCacheByteLimit(kMaxMonolithicTotalSize) {}
 
 egl_cache_t::~egl_cache_t() {}
 
@@ -124,24 +149,39 @@ void egl_cache_t::terminate() {
         mMultifileBlobCache->finish();
     }
     mMultifileBlobCache = nullptr;
+    mSharedBlobCache = nullptr;
+    mSharedLoadStarted = false;
+    mSharedKeys.clear();
     mInitialized = false;
 }
 
 void egl_cache_t::setBlob(const void* key, EGLsizeiANDROID keySize, const void* value,
                           EGLsizeiANDROID valueSize) {
-    std::lock_guard<std::mutex> lock(mMutex);
-
-    if (keySize < 0 || valueSize < 0) {
-        ALOGW("EGL_ANDROID_blob_cache set: negative sizes are not allowed");
-        return;
+    if (keySize > 0) {
+        recordCompile(key, keySize);
     }
 
-    updateMode();
+    std::shared_ptr<MultifileBlobCache> mbc;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (keySize < 0 || valueSize < 0) {
+            ALOGW("EGL_ANDROID_blob_cache set: negative sizes are not allowed");
+            return;
+        }
+
+        updateMode();
+
+        if (!mInitialized) {
+            return;
+        }
+
+        if (mSharedMode) {
+            addSharedKeyLocked(key, keySize);
+        }
 
-    if (mInitialized) {
         if (mMultifileMode) {
-            MultifileBlobCache* mbc = getMultifileBlobCacheLocked();
-            mbc->set(key, keySize, value, valueSize);
+            mbc = getMultifileBlobCacheLocked();
         } else {
             BlobCache* bc = getBlobCacheLocked();
             bc->set(key, keySize, value, valueSize);
@@ -158,32 +198,103 @@ void egl_cache_t::setBlob(const void* key, EGLsizeiANDROID keySize, const void*
                 });
                 deferredSaveThread.detach();
             }
+            return;
         }
     }
+
+    // The multifile cache does its own locking, so threads compiling shaders at the same time
+    // don't wait for each other here
+    mbc->set(key, keySize, value, valueSize);
 }
 
 EGLsizeiANDROID egl_cache_t::getBlob(const void* key, EGLsizeiANDROID keySize, void* value,
                                      EGLsizeiANDROID valueSize) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    EGLsizeiANDROID size = lookupBlob(key, keySize, value, valueSize);
+    GraphicsEnv& graphicsEnv = GraphicsEnv::getInstance();
+    if (size == 0) {
+        if (keySize > 0) {
+            graphicsEnv.addShaderCacheStats(GpuStatsInfo::Stats::GL_SHADER_CACHE_MISSES, 1);
+            recordMiss(key, keySize);
+        }
+    } else if (size <= valueSize) {
+        // Drivers may ask for the size first, only count the lookup which returns the value.
+        graphicsEnv.addShaderCacheStats(GpuStatsInfo::Stats::GL_SHADER_CACHE_HITS, 1);
+        graphicsEnv.addShaderCacheStats(GpuStatsInfo::Stats::GL_SHADER_CACHE_LOADED_BYTES, size);
+    }
+    return size;
+}
+
+static size_t hashKey(const void* key, EGLsizeiANDROID keySize) {
+    return std::hash<std::string_view>()(
+            std::string_view(static_cast<const char*>(key), static_cast<size_t>(keySize)));
+}
 
-    if (keySize < 0 || valueSize < 0) {
-        ALOGW("EGL_ANDROID_blob_cache get: negative sizes are not allowed");
-        return 0;
+void egl_cache_t::recordMiss(const void* key, EGLsizeiANDROID keySize) {
+    const size_t hash = hashKey(key, keySize);
+    std::lock_guard<std::mutex> lock(mMissTimesMutex);
+    if (mMissTimes.size() >= kMaxPendingCompiles) {
+        mMissTimes.clear();
     }
+    mMissTimes.emplace(hash, std::chrono::steady_clock::now());
+}
 
-    updateMode();
+void egl_cache_t::recordCompile(const void* key, EGLsizeiANDROID keySize) {
+    const size_t hash = hashKey(key, keySize);
+    std::chrono::steady_clock::time_point missTime;
+    {
+        std::lock_guard<std::mutex> lock(mMissTimesMutex);
+        auto it = mMissTimes.find(hash);
+        if (it == mMissTimes.end()) {
+            return;
+        }
+        missTime = it->second;
+        mMissTimes.erase(it);
+    }
+    const auto compileTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - missTime);
+    GraphicsEnv::getInstance().addShaderCacheStats(GpuStatsInfo::Stats::GL_SHADER_COMPILE_TIME,
+                                                   compileTime.count());
+}
 
-    if (mInitialized) {
-        if (mMultifileMode) {
-            MultifileBlobCache* mbc = getMultifileBlobCacheLocked();
-            return mbc->get(key, keySize, value, valueSize);
-        } else {
+EGLsizeiANDROID egl_cache_t::lookupBlob(const void* key, EGLsizeiANDROID keySize, void* value,
+                                        EGLsizeiANDROID valueSize) {
+    loadSharedBlobCache();
+
+    std::shared_ptr<MultifileBlobCache> mbc;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (keySize < 0 || valueSize < 0) {
+            ALOGW("EGL_ANDROID_blob_cache get: negative sizes are not allowed");
+            return 0;
+        }
+
+        updateMode();
+
+        if (!mInitialized) {
+            return 0;
+        }
+
+        if (!mMultifileMode) {
             BlobCache* bc = getBlobCacheLocked();
-            return bc->get(key, keySize, value, valueSize);
+            EGLsizeiANDROID size = bc->get(key, keySize, value, valueSize);
+            if (size == 0 && mSharedBlobCache) {
+                size = mSharedBlobCache->get(key, keySize, value, valueSize);
+            }
+            return size;
         }
+
+        mbc = getMultifileBlobCacheLocked();
     }
 
-    return 0;
+    EGLsizeiANDROID size = mbc->get(key, keySize, value, valueSize);
+    if (size == 0) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mInitialized && mSharedBlobCache) {
+            size = mSharedBlobCache->get(key, keySize, value, valueSize);
+        }
+    }
+    return size;
 }
 
 void egl_cache_t::setCacheMode(EGLCacheMode cacheMode) {
@@ -238,6 +349,13 @@ void egl_cache_t::updateMode() {
         ALOGV("Using multifile EGL blobcache");
     }
 
+    // Check whether blobs are also shared with the other processes of the app
+    mSharedMode = base::GetBoolProperty("debug.egl.blobcache.shared",
+                                        base::GetBoolProperty("ro.egl.blobcache.shared", false));
+    if (mSharedMode) {
+        ALOGV("Sharing EGL blobcache with the other processes of the app");
+    }
+
     // Allow forcing the mode for debug purposes
     std::string mode = base::GetProperty("debug.egl.blobcache.multifile", "");
     if (mode == "true") {
@@ -273,13 +391,158 @@ BlobCache* egl_cache_t::getBlobCacheLocked() {
     return mBlobCache.get();
 }
 
-MultifileBlobCache* egl_cache_t::getMultifileBlobCacheLocked() {
+std::shared_ptr<MultifileBlobCache> egl_cache_t::getMultifileBlobCacheLocked() {
     if (mMultifileBlobCache == nullptr) {
         mMultifileBlobCache.reset(new MultifileBlobCache(kMaxMultifileKeySize,
                                                          kMaxMultifileValueSize, mCacheByteLimit,
                                                          mFilename));
     }
-    return mMultifileBlobCache.get();
+    return mMultifileBlobCache;
+}
+
+void egl_cache_t::loadSharedBlobCache() {
+    std::string cacheId;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        updateMode();
+        if (!mInitialized || !mSharedMode || mSharedLoadStarted) {
+            return;
+        }
+        mSharedLoadStarted = true;
+
+        // Blobs are only good for the driver that produced them, so segments are kept apart by
+        // the build and the driver in use
+        GraphicsEnv& env = GraphicsEnv::getInstance();
+        mSharedCacheId = base::GetProperty("ro.build.fingerprint", "") + ":" +
+                (env.shouldUseAngle() ? "angle" : "native") + ":" + env.getDriverPath();
+        cacheId = mSharedCacheId;
+    }
+
+    // Ask gpuservice without holding mMutex, so that the other threads keep using the local cache
+    // meanwhile. They miss the shared cache until it's loaded.
+    auto cache = std::make_unique<BlobCache>(kMaxMonolithicKeySize, kMaxMonolithicValueSize,
+                                             kMaxSharedTotalSize);
+    base::unique_fd fd(GraphicsEnv::getInstance().getShaderCacheSegment(cacheId));
+    struct stat st;
+    if (fd.get() >= 0 && fstat(fd.get(), &st) == 0 && st.st_size > 0) {
+        void* buf = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+        if (buf == MAP_FAILED) {
+            ALOGE("error mmaping shared cache segment: %s (%d)", strerror(errno), errno);
+        } else {
+            int err = cache->unflatten(buf, st.st_size);
+            if (err != 0) {
+                ALOGE("error reading shared cache segment: %s (%d)", strerror(-err), -err);
+                cache->clear();
+            }
+            munmap(buf, st.st_size);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mInitialized && mSharedLoadStarted) {
+        mSharedBlobCache = std::move(cache);
+    }
+}
+
+void egl_cache_t::addSharedKeyLocked(const void* key, EGLsizeiANDROID keySize) {
+    if (mSharedKeys.size() < kMaxSharedKeys) {
+        mSharedKeys.emplace(static_cast<const char*>(key), static_cast<size_t>(keySize));
+    }
+
+    if (!mSharedPublishPending) {
+        mSharedPublishPending = true;
+        std::thread deferredPublishThread([this]() {
+            sleep(kDeferredSharedPublishDelay);
+            publishSharedBlobCache();
+        });
+        deferredPublishThread.detach();
+    }
+}
+
+// Copies the value of key from one cache to another, if the first has it.
+template <typename Cache>
+static void copyBlob(Cache* from, BlobCache* to, const std::string& key) {
+    const size_t size = static_cast<size_t>(from->get(key.data(), key.size(), nullptr, 0));
+    if (size == 0) {
+        return;
+    }
+    std::vector<uint8_t> value(size);
+    if (static_cast<size_t>(from->get(key.data(), key.size(), value.data(), size)) == size) {
+        to->set(key.data(), key.size(), value.data(), size);
+    }
+}
+
+void egl_cache_t::publishSharedBlobCache() {
+    // Keep what the other processes shared, even if this process never looked anything up
+    loadSharedBlobCache();
+
+    // The segment is built from what the other processes shared, and the values of this
+    // process's keys, which are read back from the local cache rather than kept twice in memory
+    BlobCache segment(kMaxMonolithicKeySize, kMaxMonolithicValueSize, kMaxSharedTotalSize);
+    std::shared_ptr<MultifileBlobCache> mbc;
+    std::vector<std::string> keys;
+    std::string cacheId;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSharedPublishPending = false;
+        if (!mInitialized) {
+            return;
+        }
+        cacheId = mSharedCacheId;
+        if (mSharedBlobCache) {
+            std::vector<uint8_t> buf(mSharedBlobCache->getFlattenedSize());
+            if (mSharedBlobCache->flatten(buf.data(), buf.size()) == 0) {
+                segment.unflatten(buf.data(), buf.size());
+            }
+        }
+        if (mMultifileMode) {
+            mbc = getMultifileBlobCacheLocked();
+            keys.assign(mSharedKeys.begin(), mSharedKeys.end());
+        } else {
+            for (const auto& key : mSharedKeys) {
+                copyBlob(getBlobCacheLocked(), &segment, key);
+            }
+        }
+    }
+
+    // Like setBlob and getBlob, use the multifile cache without holding mMutex
+    for (const auto& key : keys) {
+        copyBlob(mbc.get(), &segment, key);
+    }
+
+    base::unique_fd fd = flattenSharedSegment(segment);
+    if (fd.get() >= 0) {
+        GraphicsEnv::getInstance().setShaderCacheSegment(cacheId, fd.get());
+    }
+}
+
+base::unique_fd egl_cache_t::flattenSharedSegment(const BlobCache& cache) {
+    size_t size = cache.getFlattenedSize();
+    base::unique_fd fd(memfd_create("egl_blob_cache", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd.get() < 0 || ftruncate(fd.get(), size) != 0) {
+        ALOGE("error creating shared cache segment: %s (%d)", strerror(errno), errno);
+        return {};
+    }
+
+    void* buf = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (buf == MAP_FAILED) {
+        ALOGE("error mmaping shared cache segment: %s (%d)", strerror(errno), errno);
+        return {};
+    }
+    int err = cache.flatten(buf, size);
+    munmap(buf, size);
+    if (err != 0) {
+        ALOGE("error writing shared cache segment: %s (%d)", strerror(-err), -err);
+        return {};
+    }
+
+    // gpuservice only accepts segments that can't change once other processes map them
+    if (fcntl(fd.get(), F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) !=
+        0) {
+        ALOGE("error sealing shared cache segment: %s (%d)", strerror(errno), errno);
+        return {};
+    }
+    return fd;
 }
 
 }; // namespace android
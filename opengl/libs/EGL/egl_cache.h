@@ -20,9 +20,14 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <android-base/unique_fd.h>
+
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
 
 #include "FileBlobCache.h"
 #include "MultifileBlobCache.h"
@@ -97,8 +102,37 @@ private:
     // possible.
     BlobCache* getBlobCacheLocked();
 
-    // Get or create the multifile blobcache
-    MultifileBlobCache* getMultifileBlobCacheLocked();
+    // Get or create the multifile blobcache. Callers may keep using it after releasing mMutex,
+    // it stays alive until the last of them is done even if terminate() drops it meanwhile.
+    std::shared_ptr<MultifileBlobCache> getMultifileBlobCacheLocked();
+
+    // loadSharedBlobCache loads what the other processes of this app shared
+    // through gpuservice into mSharedBlobCache, the first time it's called.
+    // It must be called without holding mMutex.
+    void loadSharedBlobCache();
+
+    // addSharedKeyLocked adds a key that this process set to the ones it
+    // shares, and initiates a deferred share if one is not pending.
+    void addSharedKeyLocked(const void* key, EGLsizeiANDROID keySize);
+
+    // publishSharedBlobCache hands what the other processes shared, along
+    // with the blobs of mSharedKeys, to gpuservice as a new segment. It must
+    // be called without holding mMutex.
+    void publishSharedBlobCache();
+
+    // flattenSharedSegment serializes a cache into a sealed memfd that can be
+    // handed to gpuservice.
+    static base::unique_fd flattenSharedSegment(const BlobCache& cache);
+
+    // lookupBlob does the work of getBlob, which also reports the lookup to
+    // GpuStats.
+    EGLsizeiANDROID lookupBlob(const void* key, EGLsizeiANDROID keySize, void* value,
+                               EGLsizeiANDROID valueSize);
+
+    // recordMiss remembers when a key missed, and recordCompile reports the
+    // time since then as shader compile time once the driver sets that key.
+    void recordMiss(const void* key, EGLsizeiANDROID keySize);
+    void recordCompile(const void* key, EGLsizeiANDROID keySize);
 
     // mInitialized indicates whether the egl_cache_t is in the initialized
     // state.  It is initialized to false at construction time, and gets set to
@@ -114,7 +148,20 @@ private:
     std::unique_ptr<FileBlobCache> mBlobCache;
 
     // The multifile version of blobcache allowing larger contents to be stored
-    std::unique_ptr<MultifileBlobCache> mMultifileBlobCache;
+    std::shared_ptr<MultifileBlobCache> mMultifileBlobCache;
+
+    // mSharedBlobCache holds the blobs that the other processes of this app
+    // shared, keyed in gpuservice by mSharedCacheId. It is only used when
+    // mSharedMode is set, and is looked up when the local cache misses.
+    // mSharedLoadStarted tells whether it is being or has been loaded.
+    std::unique_ptr<BlobCache> mSharedBlobCache;
+    std::string mSharedCacheId;
+    bool mSharedLoadStarted;
+
+    // mSharedKeys holds the keys this process set while sharing, at most
+    // kMaxSharedKeys of them. Their values stay in the local cache only and
+    // are read from it when sharing.
+    std::set<std::string> mSharedKeys;
 
     // mFilename is the name of the file for storing cache contents in between
     // program invocations.  It is initialized to an empty string at
@@ -130,6 +177,10 @@ private:
     // contents to disk.
     bool mSavePending;
 
+    // mSharedPublishPending indicates whether or not a deferred share of the
+    // shared cache contents with gpuservice is pending.
+    bool mSharedPublishPending;
+
     // mMutex is the mutex used to prevent concurrent access to the member
     // variables. It must be locked whenever the member variables are accessed.
     mutable std::mutex mMutex;
@@ -140,8 +191,18 @@ private:
     // Whether to use multiple files to store cache entries
     bool mMultifileMode;
 
+    // Whether to share cache entries with the other processes of the app, set
+    // by ro.egl.blobcache.shared or debug.egl.blobcache.shared
+    bool mSharedMode;
+
     // Cache limit
     size_t mCacheByteLimit;
+
+    // mMissTimes maps the hashes of keys which missed recently to the time
+    // they missed. It is protected by mMissTimesMutex, so that reporting stats
+    // doesn't serialize multifile cache lookups on mMutex.
+    std::mutex mMissTimesMutex;
+    std::unordered_map<size_t, std::chrono::steady_clock::time_point> mMissTimes;
 };
 
 }; // namespace android
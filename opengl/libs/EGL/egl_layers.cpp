@@ -152,7 +152,7 @@ void SetupFuncMaps(FunctionTable& functions, char const* const* entries, EGLFunc
 }
 
 LayerLoader& LayerLoader::getInstance() {
-    // This function is mutex protected in egl_init_drivers_locked and eglGetProcAddressImpl
+    // This function is mutex protected in egl_init_drivers_locked
     static LayerLoader layer_loader;
 
     if (!layer_loader.layers_loaded_) layer_loader.LoadLayers();
@@ -160,6 +160,11 @@ LayerLoader& LayerLoader::getInstance() {
     return layer_loader;
 }
 
+LayerLoader& LayerLoader::peekInstance() {
+    static LayerLoader& layer_loader = getInstance();
+    return layer_loader;
+}
+
 const char kSystemLayerLibraryDir[] = "/data/local/debug/gles";
 
 std::string LayerLoader::GetDebugLayers() {
@@ -169,12 +174,30 @@ std::string LayerLoader::GetDebugLayers() {
 
     if (debug_layers.empty()) {
         // Only check system properties if Java settings are empty
-        debug_layers = base::GetProperty("debug.gles.layers", "");
+        debug_layers = GetDebugLayersProperty();
     }
 
     return debug_layers;
 }
 
+std::string LayerLoader::GetDebugLayersProperty() {
+    static constexpr char kDebugLayersProperty[] = "debug.gles.layers";
+
+    if (!debug_layers_prop_) {
+        // The property does not exist on most devices, so keep looking it up until it is set
+        debug_layers_prop_ = __system_property_find(kDebugLayersProperty);
+        if (!debug_layers_prop_) return {};
+    }
+
+    const uint32_t serial = __system_property_serial(debug_layers_prop_);
+    if (serial != debug_layers_prop_serial_) {
+        debug_layers_prop_serial_ = serial;
+        debug_layers_prop_value_ = base::GetProperty(kDebugLayersProperty, "");
+    }
+
+    return debug_layers_prop_value_;
+}
+
 EGLFuncPointer LayerLoader::ApplyLayer(layer_setup_func layer_setup, const char* name,
                                        EGLFuncPointer next) {
     // Walk through our list of LayerSetup functions (they will already be in reverse order) to
@@ -22,6 +22,7 @@
 #include <dlfcn.h>
 #include <nativebridge/native_bridge.h>
 #include <nativeloader/native_loader.h>
+#include <sys/system_properties.h>
 
 #include <string>
 #include <unordered_map>
@@ -36,6 +37,9 @@ namespace android {
 class LayerLoader {
 public:
     static LayerLoader& getInstance();
+    // Returns the instance without looking for newly enabled layers. Only meant for callers that
+    // have just been through egl_init_drivers, which already did.
+    static LayerLoader& peekInstance();
     ~LayerLoader(){};
 
     typedef void* (*PFNEGLGETNEXTLAYERPROCADDRESSPROC)(void*, const char*);
@@ -63,13 +67,23 @@ private:
             initialized_(false),
             current_layer_(0),
             dlhandle_(nullptr),
-            native_bridge_(false){};
+            native_bridge_(false),
+            debug_layers_prop_(nullptr),
+            debug_layers_prop_serial_(0){};
+    std::string GetDebugLayersProperty();
+
     bool layers_loaded_;
     bool initialized_;
     unsigned current_layer_;
     void* dlhandle_;
     bool native_bridge_;
 
+    // debug.gles.layers is checked on every driver initialization until layers are found, so its
+    // value is only read again when the property serial changes.
+    const prop_info* debug_layers_prop_;
+    uint32_t debug_layers_prop_serial_;
+    std::string debug_layers_prop_value_;
+
     template <typename Func = void*>
     Func GetTrampoline(const char* name) const {
         if (native_bridge_) {
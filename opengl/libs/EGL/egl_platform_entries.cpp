@@ -1184,7 +1184,7 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddressImpl(const char* procn
     auto& extensionMap = sGLExtensionMap;
     auto& extensionSlotMap = sGLExtensionSlotMap;
     egl_connection_t* const cnx = &gEGLImpl;
-    LayerLoader& layer_loader(LayerLoader::getInstance());
+    LayerLoader& layer_loader(LayerLoader::peekInstance());
 
     // See if we've already looked up this extension
     auto pos = extensionMap.find(name);
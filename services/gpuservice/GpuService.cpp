@@ -25,15 +25,18 @@
 #include <binder/Parcel.h>
 #include <binder/PermissionCache.h>
 #include <cutils/properties.h>
+#include <fcntl.h>
 #include <gpumem/GpuMem.h>
 #include <gpuwork/GpuWork.h>
 #include <gpustats/GpuStats.h>
 #include <private/android_filesystem_config.h>
+#include <sys/stat.h>
 #include <tracing/GpuMemTracer.h>
 #include <utils/String8.h>
 #include <utils/Trace.h>
 #include <vkjson.h>
 
+#include <algorithm>
 #include <thread>
 #include <memory>
 
@@ -53,6 +56,12 @@ const std::string sAngleGlesDriverSuffix = "angle";
 
 const char* const GpuService::SERVICE_NAME = "gpu";
 
+// Shared shader cache segments are kept in memory, so bound how much of it apps can claim.
+constexpr off_t kMaxShaderCacheSegmentSize = 4 * 1024 * 1024;
+constexpr size_t kMaxShaderCacheSegments = 32;
+constexpr size_t kMaxShaderCacheSegmentsPerUid = 4;
+constexpr size_t kMaxShaderCacheIdLength = 1024;
+
 GpuService::GpuService()
       : mGpuMem(std::make_shared<GpuMem>()),
         mGpuWork(std::make_shared<gpuwork::GpuWork>()),
@@ -138,6 +147,108 @@ std::string GpuService::getUpdatableDriverPath() {
     return mDeveloperDriverPath;
 }
 
+void GpuService::setShaderCacheSegment(const std::string& cacheId, int fd,
+                                       const sp<IBinder>& token) {
+    ATRACE_CALL();
+
+    IPCThreadState* ipc = IPCThreadState::self();
+    const int pid = ipc->getCallingPid();
+    const uid_t uid = ipc->getCallingUid();
+
+    // Other processes map the segment as it is, so it must not change after it was shared.
+    const int requiredSeals = F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+    const int seals = fcntl(fd, F_GET_SEALS);
+    struct stat st;
+    if (cacheId.size() > kMaxShaderCacheIdLength || token == nullptr || seals < 0 ||
+        (seals & requiredSeals) != requiredSeals || fstat(fd, &st) != 0 || st.st_size <= 0 ||
+        st.st_size > kMaxShaderCacheSegmentSize) {
+        ALOGE("Rejecting shader cache segment from pid=%d, uid=%d\n", pid, uid);
+        return;
+    }
+
+    base::unique_fd segment(fcntl(fd, F_DUPFD_CLOEXEC, 0));
+    if (segment.get() < 0) {
+        ALOGE("Failed to dup shader cache segment: %s", strerror(errno));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mShaderCacheLock);
+    if (mShaderCacheClients.count(token) == 0) {
+        // A local token is one of our own, which lives as long as this service.
+        if (token->remoteBinder() != nullptr &&
+            token->linkToDeath(sp<DeathRecipient>::fromExisting(this)) != OK) {
+            // The process is already gone.
+            return;
+        }
+        mShaderCacheClients.emplace(token, uid);
+    }
+
+    const auto key = std::make_pair(uid, cacheId);
+    if (mShaderCacheSegments.count(key) == 0) {
+        const size_t uidSegments =
+                std::count_if(mShaderCacheSegments.begin(), mShaderCacheSegments.end(),
+                              [uid](const auto& entry) { return entry.first.first == uid; });
+        if (uidSegments >= kMaxShaderCacheSegmentsPerUid) {
+            eraseOldestShaderCacheSegmentLocked(uid);
+        } else if (mShaderCacheSegments.size() >= kMaxShaderCacheSegments) {
+            eraseOldestShaderCacheSegmentLocked(std::nullopt);
+        }
+    }
+    mShaderCacheSegments[key] = {std::move(segment), ++mShaderCacheGeneration};
+}
+
+void GpuService::eraseOldestShaderCacheSegmentLocked(std::optional<uid_t> uid) {
+    auto oldest = mShaderCacheSegments.end();
+    for (auto it = mShaderCacheSegments.begin(); it != mShaderCacheSegments.end(); ++it) {
+        if (uid && it->first.first != *uid) {
+            continue;
+        }
+        if (oldest == mShaderCacheSegments.end() ||
+            it->second.generation < oldest->second.generation) {
+            oldest = it;
+        }
+    }
+    if (oldest != mShaderCacheSegments.end()) {
+        mShaderCacheSegments.erase(oldest);
+    }
+}
+
+int GpuService::getShaderCacheSegment(const std::string& cacheId) {
+    ATRACE_CALL();
+
+    if (cacheId.size() > kMaxShaderCacheIdLength) {
+        return -1;
+    }
+    const uid_t uid = IPCThreadState::self()->getCallingUid();
+
+    std::lock_guard<std::mutex> lock(mShaderCacheLock);
+    auto it = mShaderCacheSegments.find(std::make_pair(uid, cacheId));
+    if (it == mShaderCacheSegments.end()) {
+        return -1;
+    }
+    return fcntl(it->second.fd.get(), F_DUPFD_CLOEXEC, 0);
+}
+
+void GpuService::binderDied(const wp<IBinder>& who) {
+    std::lock_guard<std::mutex> lock(mShaderCacheLock);
+    auto client = mShaderCacheClients.find(who);
+    if (client == mShaderCacheClients.end()) {
+        return;
+    }
+    const uid_t uid = client->second;
+    mShaderCacheClients.erase(client);
+
+    // The segments of the uid stay around while any of its processes which shared one is alive.
+    for (const auto& [_, clientUid] : mShaderCacheClients) {
+        if (clientUid == uid) {
+            return;
+        }
+    }
+    for (auto it = mShaderCacheSegments.begin(); it != mShaderCacheSegments.end();) {
+        it = it->first.first == uid ? mShaderCacheSegments.erase(it) : std::next(it);
+    }
+}
+
 status_t GpuService::shellCommand(int /*in*/, int out, int err, std::vector<String16>& args) {
     ATRACE_CALL();
 
@@ -22,6 +22,12 @@
  */
 #define GPU_MEM_TOTAL_MAP_SIZE 1024
 
+/*
+ * The number of most recent total changes kept in gpu_mem_change_map. Must be
+ * a power of two, and match GpuMem::kGpuMemChangeMapSize.
+ */
+#define GPU_MEM_CHANGE_MAP_SIZE 256
+
 /*
  * This map maintains the global and per process gpu memory total counters.
  *
@@ -32,6 +38,39 @@
 DEFINE_BPF_MAP_GRO(gpu_mem_total_map, HASH, uint64_t, uint64_t, GPU_MEM_TOTAL_MAP_SIZE,
                    AID_GRAPHICS);
 
+/*
+ * A recorded change of a total in gpu_mem_total_map. Must match
+ * GpuMem::GpuMemChange.
+ */
+struct gpu_mem_change {
+    uint64_t key;
+    uint64_t size;
+    /* CLOCK_MONOTONIC time of the change */
+    uint64_t timestamp_ns;
+    /* One more than the number of changes recorded before, 0 if never written */
+    uint64_t sequence;
+};
+
+/*
+ * A ring of the most recent total changes, so that gpuservice can follow the
+ * totals without reading all of gpu_mem_total_map. A change goes to index
+ * (count % GPU_MEM_CHANGE_MAP_SIZE), where count is the single entry of
+ * gpu_mem_change_count_map.
+ */
+DEFINE_BPF_MAP_GRO(gpu_mem_change_map, ARRAY, uint32_t, struct gpu_mem_change,
+                   GPU_MEM_CHANGE_MAP_SIZE, AID_GRAPHICS);
+DEFINE_BPF_MAP_GRO(gpu_mem_change_count_map, ARRAY, uint32_t, uint64_t, 1, AID_GRAPHICS);
+
+/*
+ * The last recorded size of each total. A total is only recorded again once it
+ * changed from that by at least the threshold in gpu_mem_change_config_map.
+ */
+DEFINE_BPF_MAP_GRO(gpu_mem_recorded_map, HASH, uint64_t, uint64_t, GPU_MEM_TOTAL_MAP_SIZE,
+                   AID_GRAPHICS);
+
+/* Contains a single entry, the recording threshold in bytes, set by gpuservice */
+DEFINE_BPF_MAP_GRW(gpu_mem_change_config_map, ARRAY, uint32_t, uint64_t, 1, AID_GRAPHICS);
+
 /* This struct aligns with the fields offsets of the raw tracepoint format */
 struct gpu_mem_total_args {
     uint64_t ignore;
@@ -41,6 +80,27 @@ struct gpu_mem_total_args {
     uint64_t size;
 };
 
+static inline void record_change(uint64_t key, uint64_t size) {
+    const uint32_t zero = 0;
+    uint64_t* count = bpf_gpu_mem_change_count_map_lookup_elem(&zero);
+    if (!count) return;
+
+    /*
+     * Tracepoints of different processes run concurrently, so claim the slot
+     * with an atomic fetch-and-add. gpuservice skips a slot that is counted
+     * but not written yet, and picks it up on its next read.
+     */
+    const uint64_t sequence = __sync_fetch_and_add(count, 1);
+
+    const uint32_t index = sequence & (GPU_MEM_CHANGE_MAP_SIZE - 1);
+    struct gpu_mem_change* change = bpf_gpu_mem_change_map_lookup_elem(&index);
+    if (!change) return;
+    change->key = key;
+    change->size = size;
+    change->timestamp_ns = bpf_ktime_get_ns();
+    change->sequence = sequence + 1;
+}
+
 /*
  * This program parses the gpu_mem/gpu_mem_total tracepoint's data into
  * {KEY, VAL} pair used to update the corresponding bpf map.
@@ -60,6 +120,8 @@ DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_g
 
     if (!cur_val) {
         bpf_gpu_mem_total_map_delete_elem(&key);
+        bpf_gpu_mem_recorded_map_delete_elem(&key);
+        record_change(key, 0);
         return 0;
     }
 
@@ -69,6 +131,21 @@ DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_g
     } else {
         bpf_gpu_mem_total_map_update_elem(&key, &cur_val, BPF_NOEXIST);
     }
+
+    const uint32_t zero = 0;
+    const uint64_t* threshold = bpf_gpu_mem_change_config_map_lookup_elem(&zero);
+    uint64_t* recorded_val = bpf_gpu_mem_recorded_map_lookup_elem(&key);
+    if (!recorded_val) {
+        bpf_gpu_mem_recorded_map_update_elem(&key, &cur_val, BPF_NOEXIST);
+        record_change(key, cur_val);
+    } else {
+        const uint64_t delta =
+                cur_val > *recorded_val ? cur_val - *recorded_val : *recorded_val - cur_val;
+        if (!threshold || delta >= *threshold) {
+            *recorded_val = cur_val;
+            record_change(key, cur_val);
+        }
+    }
     return 0;
 }
 
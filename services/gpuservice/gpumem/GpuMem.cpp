@@ -20,6 +20,7 @@
 
 #include "gpumem/GpuMem.h"
 
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <libbpf.h>
 #include <bpf/WaitForProgsLoaded.h>
@@ -74,6 +75,22 @@ void GpuMem::initialize() {
     }
     setGpuMemTotalMap(map);
 
+    // The change maps are optional, the tracer falls back to reading all totals without them.
+    auto changeMap = bpf::BpfMapRO<uint32_t, GpuMemChange>(kGpuMemChangeMapPath);
+    auto changeCountMap = bpf::BpfMapRO<uint32_t, uint64_t>(kGpuMemChangeCountMapPath);
+    auto changeConfigMap = bpf::BpfMap<uint32_t, uint64_t>(kGpuMemChangeConfigMapPath);
+    if (changeMap.isValid() && changeCountMap.isValid() && changeConfigMap.isValid()) {
+        const uint64_t threshold = base::GetUintProperty<uint64_t>(kGpuMemChangeThresholdProperty,
+                                                                  kDefaultGpuMemChangeThreshold);
+        if (auto res = changeConfigMap.writeValue(0, threshold, BPF_ANY); !res.ok()) {
+            ALOGW("Failed to set GPU memory change threshold: %s",
+                  res.error().message().c_str());
+        }
+        setGpuMemChangeMaps(changeMap, changeCountMap);
+    } else {
+        ALOGW("Failed to get GPU memory change maps, totals will be read in full");
+    }
+
     mInitialized.store(true);
 }
 
@@ -81,6 +98,12 @@ void GpuMem::setGpuMemTotalMap(bpf::BpfMap<uint64_t, uint64_t>& map) {
     mGpuMemTotalMap = std::move(map);
 }
 
+void GpuMem::setGpuMemChangeMaps(bpf::BpfMap<uint32_t, GpuMemChange>& changeMap,
+                                 bpf::BpfMap<uint32_t, uint64_t>& changeCountMap) {
+    mGpuMemChangeMap = std::move(changeMap);
+    mGpuMemChangeCountMap = std::move(changeCountMap);
+}
+
 // Dump the snapshots of global and per process memory usage on all gpus
 void GpuMem::dump(const Vector<String16>& /* args */, std::string* result) {
     ATRACE_CALL();
@@ -154,4 +177,50 @@ void GpuMem::traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t
     }
 }
 
+bool GpuMem::hasGpuMemChanges() {
+    return mGpuMemChangeMap.isValid() && mGpuMemChangeCountMap.isValid();
+}
+
+uint64_t GpuMem::getGpuMemChangeSequence() {
+    auto res = mGpuMemChangeCountMap.readValue(0);
+    return res.ok() ? res.value() : 0;
+}
+
+bool GpuMem::traverseGpuMemChanges(
+        uint64_t* sequence,
+        const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid, uint64_t size)>&
+                callback) {
+    ATRACE_CALL();
+
+    auto res = mGpuMemChangeCountMap.readValue(0);
+    if (!res.ok()) return false;
+    const uint64_t end = res.value();
+
+    bool complete = true;
+    uint64_t next = *sequence;
+    if (end < next || end - next > kGpuMemChangeMapSize) {
+        // The ring has wrapped around since the last call.
+        next = end > kGpuMemChangeMapSize ? end - kGpuMemChangeMapSize : 0;
+        complete = false;
+    }
+    for (; next < end; next++) {
+        auto change = mGpuMemChangeMap.readValue(next % kGpuMemChangeMapSize);
+        if (!change.ok()) {
+            complete = false;
+            continue;
+        }
+        // The bpf program counts a change before it writes it, so stop at one that may still be
+        // being written and pick it up next time.
+        if (change.value().sequence <= next && end - next <= kMaxPendingGpuMemChanges) break;
+        if (change.value().sequence != next + 1) {
+            complete = false;
+            continue;
+        }
+        callback(static_cast<int64_t>(change.value().timestampNs), change.value().key >> 32,
+                 static_cast<uint32_t>(change.value().key), change.value().size);
+    }
+    *sequence = next;
+    return complete;
+}
+
 } // namespace android
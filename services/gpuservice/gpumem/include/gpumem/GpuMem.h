@@ -39,17 +39,46 @@ public:
     void traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid,
                                                        uint64_t size)>& callback);
 
+    // A change of a gpu memory total, as recorded by the bpf program. Must match struct
+    // gpu_mem_change in gpuMem.c.
+    struct GpuMemChange {
+        uint64_t key;
+        uint64_t size;
+        uint64_t timestampNs;
+        uint64_t sequence;
+    };
+
+    // Whether total changes are recorded, so that traverseGpuMemChanges can be used.
+    bool hasGpuMemChanges();
+    // The sequence number of the next recorded change, to pass to traverseGpuMemChanges.
+    uint64_t getGpuMemChangeSequence();
+    // Feed the callback the total changes recorded from |*sequence| on, oldest first, and
+    // advance |*sequence| past them. Returns false if some of them were overwritten before they
+    // were read, in which case the totals should be traversed again.
+    bool traverseGpuMemChanges(uint64_t* sequence,
+                               const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid,
+                                                        uint64_t size)>& callback);
+
+    // The ring size of the gpu memory change map, must match gpuMem.c.
+    static constexpr uint32_t kGpuMemChangeMapSize = 256;
+
 private:
     // Friend class for testing.
     friend class TestableGpuMem;
 
     // set gpu memory total map
     void setGpuMemTotalMap(bpf::BpfMap<uint64_t, uint64_t>& map);
+    // set gpu memory change maps
+    void setGpuMemChangeMaps(bpf::BpfMap<uint32_t, GpuMemChange>& changeMap,
+                             bpf::BpfMap<uint32_t, uint64_t>& changeCountMap);
 
     // indicate whether ebpf has been initialized
     std::atomic<bool> mInitialized = false;
     // bpf map for GPU memory total data
     android::bpf::BpfMap<uint64_t, uint64_t> mGpuMemTotalMap;
+    // bpf maps for the ring of recent total changes and its count
+    android::bpf::BpfMap<uint32_t, GpuMemChange> mGpuMemChangeMap;
+    android::bpf::BpfMap<uint32_t, uint64_t> mGpuMemChangeCountMap;
 
     // gpu memory tracepoint event category
     static constexpr char kGpuMemTraceGroup[] = "gpu_mem";
@@ -60,6 +89,18 @@ private:
             "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total";
     // pinned gpu memory total bpf map path in bpf sysfs
     static constexpr char kGpuMemTotalMapPath[] = "/sys/fs/bpf/map_gpuMem_gpu_mem_total_map";
+    // pinned gpu memory change bpf map paths in bpf sysfs
+    static constexpr char kGpuMemChangeMapPath[] = "/sys/fs/bpf/map_gpuMem_gpu_mem_change_map";
+    static constexpr char kGpuMemChangeCountMapPath[] =
+            "/sys/fs/bpf/map_gpuMem_gpu_mem_change_count_map";
+    static constexpr char kGpuMemChangeConfigMapPath[] =
+            "/sys/fs/bpf/map_gpuMem_gpu_mem_change_config_map";
+    // property for how much a total must change to be recorded again, and its default
+    static constexpr char kGpuMemChangeThresholdProperty[] =
+            "debug.graphics.gpu_mem.change_threshold_bytes";
+    static constexpr uint64_t kDefaultGpuMemChangeThreshold = 1024 * 1024;
+    // how many of the most recently counted changes may still be being written
+    static constexpr uint64_t kMaxPendingGpuMemChanges = 8;
     // 30 seconds timeout for trying to attach bpf program to tracepoint
     static constexpr int kGpuWaitTimeout = 30;
 };
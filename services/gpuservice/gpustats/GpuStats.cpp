@@ -248,6 +248,30 @@ void GpuStats::insertTargetStatsArray(const std::string& appPackageName,
                     // Merge all requested feature bits together for this app
                     targetAppStats.vulkanDeviceFeaturesEnabled |= value;
                     break;
+                case GpuStatsInfo::Stats::GL_SHADER_CACHE_HITS:
+                    targetAppStats.glShaderCacheHits += value;
+                    break;
+                case GpuStatsInfo::Stats::GL_SHADER_CACHE_MISSES:
+                    targetAppStats.glShaderCacheMisses += value;
+                    break;
+                case GpuStatsInfo::Stats::GL_SHADER_CACHE_LOADED_BYTES:
+                    targetAppStats.glShaderCacheLoadedBytes += value;
+                    break;
+                case GpuStatsInfo::Stats::GL_SHADER_COMPILE_TIME:
+                    targetAppStats.glShaderCompileTimeNs += value;
+                    break;
+                case GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_HITS:
+                    targetAppStats.vkPipelineCacheHits += value;
+                    break;
+                case GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_MISSES:
+                    targetAppStats.vkPipelineCacheMisses += value;
+                    break;
+                case GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_LOADED_BYTES:
+                    targetAppStats.vkPipelineCacheLoadedBytes += value;
+                    break;
+                case GpuStatsInfo::Stats::VULKAN_PIPELINE_COMPILE_TIME:
+                    targetAppStats.vkPipelineCompileTimeNs += value;
+                    break;
                 default:
                     break;
             }
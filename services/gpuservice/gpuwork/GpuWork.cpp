@@ -32,6 +32,7 @@
 #include <utils/Timers.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <bit>
 #include <chrono>
 #include <cstdint>
@@ -136,6 +137,9 @@ void GpuWork::initialize() {
             return;
         }
 
+        // Recent GPU work is optional; the rest works without it.
+        getBpfMap("/sys/fs/bpf/map_gpuWork_gpu_work_samples", &mGpuWorkSamplesMap);
+
         mPreviousMapClearTimePoint = std::chrono::steady_clock::now();
     }
 
@@ -221,6 +225,87 @@ void GpuWork::dump(const Vector<String16>& /* args */, std::string* result) {
                       idToUidInfo.second.total_active_duration_ns,
                       idToUidInfo.second.total_inactive_duration_ns);
     }
+
+    // Dump the number of periods per amount of GPU work in them.
+    // E.g.
+    // GPU work periods by active duration.
+    // gpu_id uid <1ms <2ms <4ms ... >=1024ms
+    // 0 1003 10 52 3 ... 0
+    result->append("GPU work periods by active duration.\ngpu_id uid <1ms");
+    for (uint32_t bucket = 1; bucket < kNumActiveDurationBuckets - 1; ++bucket) {
+        StringAppendF(result, " <%" PRIu32 "ms", uint32_t{1} << bucket);
+    }
+    StringAppendF(result, " >=%" PRIu32 "ms\n", uint32_t{1} << (kNumActiveDurationBuckets - 2));
+
+    for (const auto& idToUidInfo : dumpMap) {
+        StringAppendF(result, "%" PRIu32 " %" PRIu32, idToUidInfo.first.gpu_id,
+                      idToUidInfo.first.uid);
+        for (uint32_t count : idToUidInfo.second.active_duration_histogram) {
+            StringAppendF(result, " %" PRIu32, count);
+        }
+        result->append("\n");
+    }
+
+    // Dump the busiest UIDs right now.
+    // E.g.
+    // Recent GPU work (1000 ms).
+    // gpu_id uid active_duration_ns
+    // 0 1003 612345678
+    StringAppendF(result, "Recent GPU work (%lld ms).\ngpu_id uid active_duration_ns\n",
+                  static_cast<long long>(
+                          std::chrono::duration_cast<std::chrono::milliseconds>(kRecentWorkWindow)
+                                  .count()));
+    for (const RecentWork& work : getRecentWork(kRecentWorkWindow)) {
+        StringAppendF(result, "%" PRIu32 " %" PRIu32 " %" PRIu64 "\n", work.gpuId, work.uid,
+                      work.activeDurationNs);
+    }
+}
+
+std::vector<GpuWork::RecentWork> GpuWork::getRecentWork(std::chrono::nanoseconds window) {
+    ATRACE_CALL();
+
+    std::vector<RecentWork> recentWork;
+    if (!mInitialized.load() || !mGpuWorkSamplesMap.isValid()) {
+        return recentWork;
+    }
+
+    // The BPF program keeps writing samples while we read them. A sample that
+    // is overwritten meanwhile is just newer, which is fine here.
+    std::vector<GpuWorkSample> samples;
+    samples.reserve(kNumGpuWorkSamples);
+    uint64_t latestSequence = 0;
+    uint64_t latestEndTimeNs = 0;
+    for (uint32_t i = 0; i < kNumGpuWorkSamples; ++i) {
+        base::Result<GpuWorkSample> sample = mGpuWorkSamplesMap.readValue(i);
+        if (!sample.ok() || sample.value().sequence == 0) {
+            continue;
+        }
+        latestSequence = std::max(latestSequence, sample.value().sequence);
+        latestEndTimeNs = std::max(latestEndTimeNs, sample.value().end_time_ns);
+        samples.push_back(sample.value());
+    }
+
+    std::unordered_map<GpuIdUid, uint64_t, decltype(hashGpuIdUid)*, decltype(equalGpuIdUid)*>
+            activeDurations(32, &hashGpuIdUid, &equalGpuIdUid);
+    const uint64_t windowNs = static_cast<uint64_t>(window.count());
+    for (const GpuWorkSample& sample : samples) {
+        // Skip samples from previous rounds of the ring, which can be left when
+        // two samples raced for a slot.
+        if (sample.sequence + kNumGpuWorkSamples <= latestSequence ||
+            sample.end_time_ns + windowNs < latestEndTimeNs) {
+            continue;
+        }
+        activeDurations[GpuIdUid{sample.gpu_id, sample.uid}] += sample.total_active_duration_ns;
+    }
+
+    recentWork.reserve(activeDurations.size());
+    for (const auto& [gpuIdUid, activeDurationNs] : activeDurations) {
+        recentWork.push_back(RecentWork{gpuIdUid.gpu_id, gpuIdUid.uid, activeDurationNs});
+    }
+    std::sort(recentWork.begin(), recentWork.end(), [](const RecentWork& l, const RecentWork& r) {
+        return l.activeDurationNs > r.activeDurationNs;
+    });
+    return recentWork;
 }
 
 bool GpuWork::attachTracepoint(const char* programPath, const char* tracepointGroup,
@@ -27,6 +27,7 @@
 #endif
 
 #define S_IN_NS (1000000000)
+#define MS_IN_NS (1000000)
 #define SMALL_TIME_GAP_LIMIT_NS (S_IN_NS)
 
 // A map from GpuIdUid (GPU ID and application UID) to |UidTrackingInfo|.
@@ -36,6 +37,53 @@ DEFINE_BPF_MAP_GRW(gpu_work_map, HASH, GpuIdUid, UidTrackingInfo, kMaxTrackedGpu
 // A map containing a single entry of |GlobalData|.
 DEFINE_BPF_MAP_GRW(gpu_work_global_data, ARRAY, uint32_t, GlobalData, 1, AID_GRAPHICS);
 
+// A ring of the most recent periods with GPU work, indexed by
+// |GlobalData.num_samples|. Lets userspace see current GPU work without
+// having to clear |gpu_work_map|.
+DEFINE_BPF_MAP_GRW(gpu_work_samples, ARRAY, uint32_t, GpuWorkSample, kNumGpuWorkSamples,
+                   AID_GRAPHICS);
+
+// Gets the bucket of |UidTrackingInfo.active_duration_histogram| for a period
+// with |active_duration_ns| of GPU work.
+static inline uint32_t active_duration_bucket(uint64_t active_duration_ns) {
+    uint32_t bucket = 0;
+    uint64_t limit_ns = MS_IN_NS;
+#pragma unroll
+    for (int i = 0; i < kNumActiveDurationBuckets - 1; i++) {
+        if (active_duration_ns < limit_ns) {
+            break;
+        }
+        bucket++;
+        limit_ns *= 2;
+    }
+    return bucket;
+}
+
+// Adds |period| to the |gpu_work_samples| ring.
+static inline void add_sample(const GpuWorkPeriodEvent* const period) {
+    const uint32_t zero = 0;
+    GlobalData* global_data = bpf_gpu_work_global_data_lookup_elem(&zero);
+    if (!global_data) {
+        return;
+    }
+    // Periods of different UIDs may be emitted concurrently, in which case one
+    // of them may overwrite the other. An atomic fetch-and-add would need a
+    // newer kernel, and losing the odd sample is fine.
+    const uint64_t num_samples = global_data->num_samples;
+    global_data->num_samples = num_samples + 1;
+
+    const uint32_t index = num_samples & (kNumGpuWorkSamples - 1);
+    GpuWorkSample* sample = bpf_gpu_work_samples_lookup_elem(&index);
+    if (!sample) {
+        return;
+    }
+    sample->gpu_id = period->gpu_id;
+    sample->uid = period->uid;
+    sample->end_time_ns = period->end_time_ns;
+    sample->total_active_duration_ns = period->total_active_duration_ns;
+    sample->sequence = num_samples + 1;
+}
+
 // Defines the structure of the kernel tracepoint:
 //
 //  /sys/kernel/tracing/events/power/gpu_work_period/
@@ -236,6 +284,11 @@ DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_g
     __sync_fetch_and_add(&uid_tracking_info->total_active_duration_ns,
                          period->total_active_duration_ns);
 
+    __sync_fetch_and_add(&uid_tracking_info->active_duration_histogram[active_duration_bucket(
+                                 period->total_active_duration_ns)],
+                         1);
+    add_sample(period);
+
     // |small_gap_time_ns| is the time gap between the current and previous
     // active period, which could be 0. If the gap is more than
     // |SMALL_TIME_GAP_LIMIT_NS| then |small_gap_time_ns| will be set to 0
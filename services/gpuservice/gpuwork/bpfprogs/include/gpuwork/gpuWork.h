@@ -30,6 +30,12 @@ typedef struct  {
     uint32_t uid;
 } GpuIdUid;
 
+// The number of buckets in |UidTrackingInfo.active_duration_histogram|. Bucket
+// 0 counts periods with less than 1 ms of GPU work, bucket i counts periods
+// with at least 2^(i-1) ms and less than 2^i ms, and the last bucket counts
+// periods with more.
+enum { kNumActiveDurationBuckets = 12 };
+
 typedef struct {
     // The end time of the previous period where the GPU was active for the UID,
     // in nanoseconds.
@@ -51,18 +57,44 @@ typedef struct {
 
     // Needed to make 32-bit arch struct size match 64-bit BPF arch struct size.
     uint32_t padding0;
+
+    // The number of periods for the UID, by how much GPU work each of them
+    // had, see |kNumActiveDurationBuckets|. Periods without GPU work are not
+    // counted.
+    uint32_t active_duration_histogram[kNumActiveDurationBuckets];
 } UidTrackingInfo;
 
+// A single period of GPU work for a UID, as emitted by the driver.
+typedef struct {
+    uint32_t gpu_id;
+    uint32_t uid;
+    uint64_t end_time_ns;
+    uint64_t total_active_duration_ns;
+
+    // One more than the number of samples written before this one, or 0 if
+    // the slot was never written. Written last, so readers can tell which
+    // samples belong to the current round of the ring.
+    uint64_t sequence;
+} GpuWorkSample;
+
 typedef struct {
     // We cannot query the number of entries in BPF map |gpu_work_map|. We track
     // the number of entries (approximately) using a counter so we can check if
     // the map is nearly full.
     uint64_t num_map_entries;
+
+    // The number of samples written to |gpu_work_samples| so far. The next
+    // sample goes to index |num_samples| % |kNumGpuWorkSamples|.
+    uint64_t num_samples;
 } GlobalData;
 
 // The maximum number of tracked GPU ID and UID pairs (|GpuIdUid|).
 static const uint32_t kMaxTrackedGpuIdUids = 512;
 
+// The number of most recent periods kept in |gpu_work_samples|. Must be a
+// power of two.
+static const uint32_t kNumGpuWorkSamples = 256;
+
 #ifdef __cplusplus
 } // namespace gpuwork
 } // namespace android
@@ -22,10 +22,12 @@
 #include <utils/String16.h>
 #include <utils/Vector.h>
 
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <thread>
+#include <vector>
 
 #include "gpuwork/gpuWork.h"
 
@@ -44,6 +46,19 @@ public:
     // Dumps the GPU work information.
     void dump(const Vector<String16>& args, std::string* result);
 
+    // The GPU work of a UID on a GPU within a recent time window.
+    struct RecentWork {
+        uint32_t gpuId;
+        Uid uid;
+        uint64_t activeDurationNs;
+    };
+
+    // Gets the GPU work of each UID during |window| before the end of the most
+    // recent period of GPU work, the busiest UID first. This only reads the
+    // ring of recent periods, so unlike |dump| it never waits for |mMutex| and
+    // doesn't depend on when |mGpuWorkMap| was last cleared.
+    std::vector<RecentWork> getRecentWork(std::chrono::nanoseconds window);
+
 private:
     // Attaches tracepoint |tracepoint_group|/|tracepoint_name| to BPF program at path
     // |program_path|. The tracepoint is also enabled.
@@ -93,6 +108,10 @@ private:
     // BPF map containing a single element for global data.
     bpf::BpfMap<uint32_t, GlobalData> mGpuWorkGlobalDataMap GUARDED_BY(mMutex);
 
+    // BPF map with a ring of the most recent periods of GPU work. Only set
+    // before |mInitialized|, so it can be read without |mMutex| after that.
+    bpf::BpfMap<uint32_t, GpuWorkSample> mGpuWorkSamplesMap;
+
     // When true, we are being destructed, so |mMapClearerThread| should stop.
     bool mIsTerminating GUARDED_BY(mMutex);
 
@@ -120,6 +139,9 @@ private:
     // then we don't log any stats.
     static constexpr size_t kNumGpusHardLimit = 32;
 
+    // The time window over which |dump| reports recent GPU work.
+    static constexpr std::chrono::nanoseconds kRecentWorkWindow = std::chrono::seconds(1);
+
     // The minimum GPU time needed to actually log stats for a UID.
     static constexpr uint64_t kMinGpuTimeNanoseconds = 30U * 1000000000U; // 30 seconds.
 
@@ -17,14 +17,18 @@
 #ifndef ANDROID_GPUSERVICE_H
 #define ANDROID_GPUSERVICE_H
 
+#include <android-base/unique_fd.h>
 #include <binder/IInterface.h>
 #include <cutils/compiler.h>
 #include <graphicsenv/GpuStatsInfo.h>
 #include <graphicsenv/IGpuService.h>
 #include <serviceutils/PriorityDumper.h>
 
+#include <map>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace android {
@@ -37,7 +41,7 @@ class GpuMem;
 class GpuStats;
 class GpuMemTracer;
 
-class GpuService : public BnGpuService, public PriorityDumper {
+class GpuService : public BnGpuService, public PriorityDumper, public IBinder::DeathRecipient {
 public:
     static const char* const SERVICE_NAME ANDROID_API;
 
@@ -64,6 +68,14 @@ private:
     void setUpdatableDriverPath(const std::string& driverPath) override;
     std::string getUpdatableDriverPath() override;
     void toggleAngleAsSystemDriver(bool enabled) override;
+    void setShaderCacheSegment(const std::string& cacheId, int fd,
+                               const sp<IBinder>& token) override;
+    int getShaderCacheSegment(const std::string& cacheId) override;
+
+    /*
+     * IBinder::DeathRecipient interface
+     */
+    void binderDied(const wp<IBinder>& who) override;
 
     /*
      * IBinder interface
@@ -94,6 +106,19 @@ private:
     std::string mDeveloperDriverPath;
     std::unique_ptr<std::thread> mGpuMemAsyncInitThread;
     std::unique_ptr<std::thread> mGpuWorkAsyncInitThread;
+
+    // Shader cache segments shared between the processes of an app, by uid and cache id. The
+    // generation tells which segment was shared the longest ago, to drop it first.
+    struct ShaderCacheSegment {
+        base::unique_fd fd;
+        uint64_t generation;
+    };
+    void eraseOldestShaderCacheSegmentLocked(std::optional<uid_t> uid);
+    std::mutex mShaderCacheLock;
+    std::map<std::pair<uid_t, std::string>, ShaderCacheSegment> mShaderCacheSegments;
+    uint64_t mShaderCacheGeneration = 0;
+    // The uid of each process which shared a segment, by its token.
+    std::map<wp<IBinder>, uid_t> mShaderCacheClients;
 };
 
 } // namespace android
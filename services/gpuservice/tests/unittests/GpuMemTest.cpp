@@ -168,5 +168,112 @@ TEST_F(GpuMemTest, traverseGpuMemTotals) {
     EXPECT_EQ(sCount, TEST_KEY_COUNT);
 }
 
+TEST_F(GpuMemTest, traverseGpuMemChanges) {
+    bpf::BpfMap<uint32_t, GpuMem::GpuMemChange> changeMap(BPF_MAP_TYPE_ARRAY,
+                                                         GpuMem::kGpuMemChangeMapSize, 0);
+    bpf::BpfMap<uint32_t, uint64_t> changeCountMap(BPF_MAP_TYPE_ARRAY, 1, 0);
+    ASSERT_TRUE(changeMap.isValid());
+    ASSERT_TRUE(changeCountMap.isValid());
+    ASSERT_RESULT_OK(changeMap.writeValue(0, {TEST_PROC_KEY_1, TEST_PROC_VAL_1, 10, 1}, BPF_ANY));
+    ASSERT_RESULT_OK(changeMap.writeValue(1, {TEST_PROC_KEY_2, TEST_PROC_VAL_2, 20, 2}, BPF_ANY));
+    ASSERT_RESULT_OK(changeMap.writeValue(2, {TEST_PROC_KEY_1, 0, 30, 3}, BPF_ANY));
+    ASSERT_RESULT_OK(changeCountMap.writeValue(0, 3, BPF_ANY));
+    mTestableGpuMem.setGpuMemChangeMaps(changeMap, changeCountMap);
+    ASSERT_TRUE(mGpuMem->hasGpuMemChanges());
+    EXPECT_EQ(mGpuMem->getGpuMemChangeSequence(), 3);
+
+    std::vector<std::pair<uint64_t, uint64_t>> changes;
+    uint64_t sequence = 1;
+    EXPECT_TRUE(mGpuMem->traverseGpuMemChanges(&sequence,
+                                               [&changes](int64_t, uint32_t gpuId, uint32_t pid,
+                                                          uint64_t size) {
+                                                   const uint64_t key =
+                                                           ((uint64_t)gpuId << 32) | pid;
+                                                   changes.emplace_back(key, size);
+                                               }));
+    EXPECT_EQ(sequence, 3);
+    EXPECT_THAT(changes,
+                testing::ElementsAre(std::make_pair(TEST_PROC_KEY_2, TEST_PROC_VAL_2),
+                                     std::make_pair(TEST_PROC_KEY_1, uint64_t{0})));
+}
+
+TEST_F(GpuMemTest, traverseGpuMemChangesAfterWrapAround) {
+    bpf::BpfMap<uint32_t, GpuMem::GpuMemChange> changeMap(BPF_MAP_TYPE_ARRAY,
+                                                         GpuMem::kGpuMemChangeMapSize, 0);
+    bpf::BpfMap<uint32_t, uint64_t> changeCountMap(BPF_MAP_TYPE_ARRAY, 1, 0);
+    ASSERT_TRUE(changeMap.isValid());
+    ASSERT_TRUE(changeCountMap.isValid());
+    // The ring went around twice, so the first half of the changes is gone.
+    const uint64_t count = GpuMem::kGpuMemChangeMapSize * 2;
+    for (uint32_t i = 0; i < GpuMem::kGpuMemChangeMapSize; i++) {
+        const uint64_t sequence = GpuMem::kGpuMemChangeMapSize + i + 1;
+        ASSERT_RESULT_OK(changeMap.writeValue(i, {TEST_PROC_KEY_1, sequence, 10, sequence},
+                                              BPF_ANY));
+    }
+    ASSERT_RESULT_OK(changeCountMap.writeValue(0, count, BPF_ANY));
+    mTestableGpuMem.setGpuMemChangeMaps(changeMap, changeCountMap);
+
+    uint32_t numChanges = 0;
+    uint64_t sequence = 0;
+    EXPECT_FALSE(mGpuMem->traverseGpuMemChanges(&sequence,
+                                                [&numChanges](int64_t, uint32_t, uint32_t,
+                                                              uint64_t) { numChanges++; }));
+    EXPECT_EQ(sequence, count);
+    EXPECT_EQ(numChanges, GpuMem::kGpuMemChangeMapSize);
+}
+
+TEST_F(GpuMemTest, traverseGpuMemChangesStopsAtPendingChange) {
+    bpf::BpfMap<uint32_t, GpuMem::GpuMemChange> changeMap(BPF_MAP_TYPE_ARRAY,
+                                                         GpuMem::kGpuMemChangeMapSize, 0);
+    bpf::BpfMap<uint32_t, uint64_t> changeCountMap(BPF_MAP_TYPE_ARRAY, 1, 0);
+    ASSERT_TRUE(changeMap.isValid());
+    ASSERT_TRUE(changeCountMap.isValid());
+    // Three changes are counted, but the last one is still being written.
+    ASSERT_RESULT_OK(changeMap.writeValue(0, {TEST_PROC_KEY_1, TEST_PROC_VAL_1, 10, 1}, BPF_ANY));
+    ASSERT_RESULT_OK(changeMap.writeValue(1, {TEST_PROC_KEY_2, TEST_PROC_VAL_2, 20, 2}, BPF_ANY));
+    ASSERT_RESULT_OK(changeCountMap.writeValue(0, 3, BPF_ANY));
+    mTestableGpuMem.setGpuMemChangeMaps(changeMap, changeCountMap);
+
+    std::vector<uint64_t> sizes;
+    const auto callback = [&sizes](int64_t, uint32_t, uint32_t, uint64_t size) {
+        sizes.push_back(size);
+    };
+    uint64_t sequence = 0;
+    EXPECT_TRUE(mGpuMem->traverseGpuMemChanges(&sequence, callback));
+    EXPECT_EQ(sequence, 2);
+    EXPECT_THAT(sizes, testing::ElementsAre(TEST_PROC_VAL_1, TEST_PROC_VAL_2));
+
+    // Once written, the change is picked up by the next call.
+    ASSERT_RESULT_OK(changeMap.writeValue(2, {TEST_PROC_KEY_1, 0, 30, 3}, BPF_ANY));
+    sizes.clear();
+    EXPECT_TRUE(mGpuMem->traverseGpuMemChanges(&sequence, callback));
+    EXPECT_EQ(sequence, 3);
+    EXPECT_THAT(sizes, testing::ElementsAre(uint64_t{0}));
+}
+
+TEST_F(GpuMemTest, traverseGpuMemChangesSkipsUnwrittenOldChange) {
+    bpf::BpfMap<uint32_t, GpuMem::GpuMemChange> changeMap(BPF_MAP_TYPE_ARRAY,
+                                                         GpuMem::kGpuMemChangeMapSize, 0);
+    bpf::BpfMap<uint32_t, uint64_t> changeCountMap(BPF_MAP_TYPE_ARRAY, 1, 0);
+    ASSERT_TRUE(changeMap.isValid());
+    ASSERT_TRUE(changeCountMap.isValid());
+    // The first change was never written, and too many changes came after it for it to still be
+    // pending, so it is reported as lost.
+    const uint64_t count = 20;
+    for (uint32_t i = 1; i < count; i++) {
+        ASSERT_RESULT_OK(changeMap.writeValue(i, {TEST_PROC_KEY_1, i, 10, i + 1}, BPF_ANY));
+    }
+    ASSERT_RESULT_OK(changeCountMap.writeValue(0, count, BPF_ANY));
+    mTestableGpuMem.setGpuMemChangeMaps(changeMap, changeCountMap);
+
+    uint32_t numChanges = 0;
+    uint64_t sequence = 0;
+    EXPECT_FALSE(mGpuMem->traverseGpuMemChanges(&sequence,
+                                                [&numChanges](int64_t, uint32_t, uint32_t,
+                                                              uint64_t) { numChanges++; }));
+    EXPECT_EQ(sequence, count);
+    EXPECT_EQ(numChanges, count - 1);
+}
+
 } // namespace
 } // namespace android
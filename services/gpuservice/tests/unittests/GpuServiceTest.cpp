@@ -3,10 +3,16 @@
 
 #include "gpuservice/GpuService.h"
 
+#include <android-base/unique_fd.h>
+#include <binder/Binder.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
 #include <log/log_main.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <chrono>
+#include <string>
 #include <thread>
 
 namespace android {
@@ -48,5 +54,101 @@ TEST_F(GpuServiceTest, onInitializeShouldNotCauseUseAfterFree) {
     EXPECT_TRUE(true);
 }
 
+static base::unique_fd createSegment(const std::string& contents, int seals) {
+    base::unique_fd fd(memfd_create("shader_cache_test", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    const ssize_t size = static_cast<ssize_t>(contents.size());
+    if (fd.get() < 0 || write(fd.get(), contents.data(), contents.size()) != size ||
+        (seals != 0 && fcntl(fd.get(), F_ADD_SEALS, seals) != 0)) {
+        return {};
+    }
+    return fd;
+}
+
+static std::string readSegment(int fd) {
+    std::string contents(64, '\0');
+    ssize_t size = pread(fd, contents.data(), contents.size(), 0);
+    contents.resize(size < 0 ? 0 : size);
+    return contents;
+}
+
+static base::unique_fd createSealedSegment(const std::string& contents) {
+    return createSegment(contents, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+}
+
+TEST_F(GpuServiceTest, shaderCacheSegmentIsSharedByCacheId) {
+    sp<IGpuService> service = new GpuService();
+    EXPECT_EQ(-1, service->getShaderCacheSegment("build"));
+
+    base::unique_fd segment = createSealedSegment("blobs");
+    ASSERT_GE(segment.get(), 0);
+    service->setShaderCacheSegment("build", segment.get(), sp<BBinder>::make());
+
+    base::unique_fd shared(service->getShaderCacheSegment("build"));
+    ASSERT_GE(shared.get(), 0);
+    EXPECT_EQ("blobs", readSegment(shared.get()));
+    EXPECT_EQ(-1, service->getShaderCacheSegment("other build"));
+}
+
+TEST_F(GpuServiceTest, unsealedShaderCacheSegmentIsRejected) {
+    sp<IGpuService> service = new GpuService();
+
+    base::unique_fd segment = createSegment("blobs", 0);
+    ASSERT_GE(segment.get(), 0);
+    service->setShaderCacheSegment("build", segment.get(), sp<BBinder>::make());
+
+    EXPECT_EQ(-1, service->getShaderCacheSegment("build"));
+}
+
+TEST_F(GpuServiceTest, longShaderCacheIdIsRejected) {
+    sp<IGpuService> service = new GpuService();
+    const std::string cacheId(4096, 'x');
+
+    base::unique_fd segment = createSealedSegment("blobs");
+    ASSERT_GE(segment.get(), 0);
+    service->setShaderCacheSegment(cacheId, segment.get(), sp<BBinder>::make());
+
+    EXPECT_EQ(-1, service->getShaderCacheSegment(cacheId));
+}
+
+TEST_F(GpuServiceTest, shaderCacheSegmentsAreLimitedPerUid) {
+    sp<IGpuService> service = new GpuService();
+    const sp<IBinder> token = sp<BBinder>::make();
+
+    // All segments come from the uid of the test
+    for (int i = 0; i < 5; i++) {
+        base::unique_fd segment = createSealedSegment("blobs");
+        ASSERT_GE(segment.get(), 0);
+        service->setShaderCacheSegment(std::to_string(i), segment.get(), token);
+    }
+
+    EXPECT_EQ(-1, service->getShaderCacheSegment("0"));
+    for (int i = 1; i < 5; i++) {
+        base::unique_fd shared(service->getShaderCacheSegment(std::to_string(i)));
+        EXPECT_GE(shared.get(), 0);
+    }
+}
+
+TEST_F(GpuServiceTest, shaderCacheSegmentsAreDroppedWithTheirProcesses) {
+    sp<GpuService> gpuService = new GpuService();
+    sp<IGpuService> service = gpuService;
+    sp<IBinder::DeathRecipient> deathRecipient = gpuService;
+    const sp<IBinder> token = sp<BBinder>::make();
+    const sp<IBinder> otherToken = sp<BBinder>::make();
+
+    base::unique_fd segment = createSealedSegment("blobs");
+    ASSERT_GE(segment.get(), 0);
+    service->setShaderCacheSegment("build", segment.get(), token);
+    service->setShaderCacheSegment("other build", segment.get(), otherToken);
+
+    // Another process of the uid is still alive
+    deathRecipient->binderDied(token);
+    base::unique_fd shared(service->getShaderCacheSegment("build"));
+    EXPECT_GE(shared.get(), 0);
+
+    deathRecipient->binderDied(otherToken);
+    EXPECT_EQ(-1, service->getShaderCacheSegment("build"));
+    EXPECT_EQ(-1, service->getShaderCacheSegment("other build"));
+}
+
 } // namespace
 } // namespace android
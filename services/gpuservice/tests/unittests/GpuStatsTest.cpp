@@ -305,6 +305,42 @@ TEST_F(GpuStatsTest, canInsertTargetStatsAfterProperSetup) {
     EXPECT_THAT(inputCommand(InputCommand::DUMP_APP), HasSubstr(expectedResult.str()));
 }
 
+TEST_F(GpuStatsTest, canAccumulateShaderCacheStats) {
+    mGpuStats->insertDriverStats(BUILTIN_DRIVER_PKG_NAME, BUILTIN_DRIVER_VER_NAME,
+                                 BUILTIN_DRIVER_VER_CODE, BUILTIN_DRIVER_BUILD_TIME, APP_PKG_NAME_1,
+                                 VULKAN_VERSION, GpuStatsInfo::Driver::GL, true,
+                                 DRIVER_LOADING_TIME_1);
+    for (int i = 0; i < 2; i++) {
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::GL_SHADER_CACHE_HITS, 3);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::GL_SHADER_CACHE_MISSES, 1);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::GL_SHADER_CACHE_LOADED_BYTES, 4096);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::GL_SHADER_COMPILE_TIME, 1000);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_HITS, 5);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_MISSES, 2);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_LOADED_BYTES,
+                                     65536);
+        mGpuStats->insertTargetStats(APP_PKG_NAME_1, BUILTIN_DRIVER_VER_CODE,
+                                     GpuStatsInfo::Stats::VULKAN_PIPELINE_COMPILE_TIME, 2000);
+    }
+
+    const std::string dump = inputCommand(InputCommand::DUMP_APP);
+    EXPECT_THAT(dump, HasSubstr("glShaderCacheHits = 6\n"));
+    EXPECT_THAT(dump, HasSubstr("glShaderCacheMisses = 2\n"));
+    EXPECT_THAT(dump, HasSubstr("glShaderCacheLoadedBytes = 8192\n"));
+    EXPECT_THAT(dump, HasSubstr("glShaderCompileTimeNs = 2000\n"));
+    EXPECT_THAT(dump, HasSubstr("vkPipelineCacheHits = 10\n"));
+    EXPECT_THAT(dump, HasSubstr("vkPipelineCacheMisses = 4\n"));
+    EXPECT_THAT(dump, HasSubstr("vkPipelineCacheLoadedBytes = 131072\n"));
+    EXPECT_THAT(dump, HasSubstr("vkPipelineCompileTimeNs = 4000\n"));
+}
+
 // Verify we always have the most recently used apps in mAppStats, even when we fill it.
 TEST_F(GpuStatsTest, canInsertMoreThanMaxNumAppRecords) {
     constexpr int kNumExtraApps = 15;
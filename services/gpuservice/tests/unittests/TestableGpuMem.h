@@ -32,6 +32,11 @@ public:
         mGpuMem->setGpuMemTotalMap(map);
     }
 
+    void setGpuMemChangeMaps(bpf::BpfMap<uint32_t, GpuMem::GpuMemChange>& changeMap,
+                             bpf::BpfMap<uint32_t, uint64_t>& changeCountMap) {
+        mGpuMem->setGpuMemChangeMaps(changeMap, changeCountMap);
+    }
+
     std::string getGpuMemTraceGroup() { return mGpuMem->kGpuMemTraceGroup; }
 
     std::string getGpuMemTotalTracepoint() { return mGpuMem->kGpuMemTotalTracepoint; }
@@ -25,6 +25,7 @@
 #include <unistd.h>
 
 #include <thread>
+#include <utility>
 
 PERFETTO_DEFINE_DATA_SOURCE_STATIC_MEMBERS(android::GpuMemTracer::GpuMemDataSource);
 
@@ -33,6 +34,19 @@ namespace android {
 std::mutex GpuMemTracer::sTraceMutex;
 std::condition_variable GpuMemTracer::sCondition;
 bool GpuMemTracer::sTraceStarted;
+uint32_t GpuMemTracer::sActiveSessions;
+
+static void traceGpuMemTotal(int64_t ts, uint32_t gpuId, uint32_t pid, uint64_t size) {
+    GpuMemTracer::GpuMemDataSource::Trace([&](GpuMemTracer::GpuMemDataSource::TraceContext ctx) {
+        auto packet = ctx.NewTracePacket();
+        packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
+        packet->set_timestamp(ts);
+        auto* event = packet->set_gpu_mem_total_event();
+        event->set_gpu_id(gpuId);
+        event->set_pid(pid);
+        event->set_size(size);
+    });
+}
 
 void GpuMemTracer::initialize(std::shared_ptr<GpuMem> gpuMem) {
     if (!gpuMem->isInitialized()) {
@@ -88,11 +102,17 @@ void GpuMemTracer::threadLoop(bool infiniteLoop) {
             while (!sTraceStarted) {
                 sCondition.wait(lock);
             }
+            // Cleared before tracing, so that a session starting meanwhile is not missed.
+            sTraceStarted = false;
         }
+        // Changes from here on are traced after the initial counters, which may include some of
+        // them already.
+        const bool traceChanges = infiniteLoop && mGpuMem->isInitialized() &&
+                mGpuMem->hasGpuMemChanges();
+        const uint64_t sequence = traceChanges ? mGpuMem->getGpuMemChangeSequence() : 0;
         traceInitialCounters();
-        {
-            std::lock_guard<std::mutex> lock(GpuMemTracer::sTraceMutex);
-            sTraceStarted = false;
+        if (traceChanges) {
+            traceChangedCounters(sequence);
         }
     } while (infiniteLoop);
 
@@ -107,20 +127,36 @@ void GpuMemTracer::traceInitialCounters() {
         ALOGE("Cannot trace without GpuMem initialization");
         return;
     }
-    mGpuMem->traverseGpuMemTotals([](int64_t ts, uint32_t gpuId, uint32_t pid, uint64_t size) {
-        GpuMemDataSource::Trace([&](GpuMemDataSource::TraceContext ctx) {
-            auto packet = ctx.NewTracePacket();
-            packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
-            packet->set_timestamp(ts);
-            auto* event = packet->set_gpu_mem_total_event();
-            event->set_gpu_id(gpuId);
-            event->set_pid(pid);
-            event->set_size(size);
-        });
-    });
+    mGpuMem->traverseGpuMemTotals(&traceGpuMemTotal);
     // Flush the TraceContext. The last packet in the above loop will go
     // missing without this flush.
     GpuMemDataSource::Trace([](GpuMemDataSource::TraceContext ctx) { ctx.Flush(); });
 }
 
+void GpuMemTracer::traceChangedCounters(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
+    while (sActiveSessions > 0) {
+        sCondition.wait_for(lock, kChangedCountersInterval);
+        const bool sessionStarted = std::exchange(sTraceStarted, false);
+        lock.unlock();
+
+        bool traced = false;
+        const bool complete = mGpuMem->traverseGpuMemChanges(
+                &sequence, [&traced](int64_t ts, uint32_t gpuId, uint32_t pid, uint64_t size) {
+                    traceGpuMemTotal(ts, gpuId, pid, size);
+                    traced = true;
+                });
+        if (!complete || sessionStarted) {
+            // Some changes were lost, so the counters may be off until they are all traced again.
+            // A session that just started has none of the counters yet.
+            ALOGW_IF(!complete, "GPU memory changes were lost, tracing all counters");
+            traceInitialCounters();
+        } else if (traced) {
+            GpuMemDataSource::Trace([](GpuMemDataSource::TraceContext ctx) { ctx.Flush(); });
+        }
+
+        lock.lock();
+    }
+}
+
 } // namespace android
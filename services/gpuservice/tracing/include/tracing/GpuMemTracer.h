@@ -18,6 +18,7 @@
 
 #include <perfetto/tracing.h>
 
+#include <chrono>
 #include <mutex>
 
 namespace perfetto::protos {
@@ -35,9 +36,14 @@ public:
         virtual void OnStart(const StartArgs&) override {
             std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
             sTraceStarted = true;
+            sActiveSessions++;
             sCondition.notify_all();
         }
-        virtual void OnStop(const StopArgs&) override{};
+        virtual void OnStop(const StopArgs&) override {
+            std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
+            if (sActiveSessions > 0) sActiveSessions--;
+            sCondition.notify_all();
+        };
     };
 
     ~GpuMemTracer() = default;
@@ -69,7 +75,10 @@ public:
     static constexpr char kGpuMemDataSource[] = "android.gpu.memory";
     static std::condition_variable sCondition;
     static std::mutex sTraceMutex;
+    // Set when a session starts, until the tracer has traced its initial counters.
     static bool sTraceStarted;
+    // Number of sessions started and not stopped yet. Changes are traced while there are any.
+    static uint32_t sActiveSessions;
 
 private:
     // Friend class for testing
@@ -77,6 +86,11 @@ private:
 
     void threadLoop(bool infiniteLoop);
     void traceInitialCounters();
+    // Traces the totals that changed since |sequence|, until all sessions are stopped. Sessions
+    // that start meanwhile get the initial counters too.
+    void traceChangedCounters(uint64_t sequence);
+    // How often changed totals are traced.
+    static constexpr std::chrono::milliseconds kChangedCountersInterval{100};
     std::shared_ptr<GpuMem> mGpuMem;
     // Count of how many tracer threads are currently active. Useful for testing.
     std::atomic<int32_t> tracerThreadCount = 0;
@@ -116,6 +116,32 @@ void QueuedInputListener::notifyPointerCaptureChanged(const NotifyPointerCapture
     mArgsQueue.emplace_back(args);
 }
 
+void QueuedInputListener::notify(NotifyArgs&& generalArgs) {
+    if (ATRACE_ENABLED()) {
+        Visitor v{
+                [](const NotifyInputDevicesChangedArgs& args) {
+                    traceEvent("notifyInputDevicesChanged", args.id);
+                },
+                [](const NotifyConfigurationChangedArgs& args) {
+                    traceEvent("notifyConfigurationChanged", args.id);
+                },
+                [](const NotifyKeyArgs& args) { traceEvent("notifyKey", args.id); },
+                [](const NotifyMotionArgs& args) { traceEvent("notifyMotion", args.id); },
+                [](const NotifySwitchArgs& args) { traceEvent("notifySwitch", args.id); },
+                [](const NotifySensorArgs& args) { traceEvent("notifySensor", args.id); },
+                [](const NotifyVibratorStateArgs& args) {
+                    traceEvent("notifyVibratorState", args.id);
+                },
+                [](const NotifyDeviceResetArgs& args) { traceEvent("notifyDeviceReset", args.id); },
+                [](const NotifyPointerCaptureChangedArgs& args) {
+                    traceEvent("notifyPointerCaptureChanged", args.id);
+                },
+        };
+        std::visit(v, generalArgs);
+    }
+    mArgsQueue.emplace_back(std::move(generalArgs));
+}
+
 void QueuedInputListener::flush() {
     for (const NotifyArgs& args : mArgsQueue) {
         mInnerListener.notify(args);
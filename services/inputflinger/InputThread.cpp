@@ -14,23 +14,61 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "InputThread"
+
 #include "InputThread.h"
 
+#include <android-base/properties.h>
+#include <errno.h>
+#include <log/log.h>
+#include <sched.h>
+#include <string.h>
+
 namespace android {
 
 namespace {
 
+// When set to a value in [1, 99], the input threads run with SCHED_FIFO at that priority instead
+// of as normal threads at ANDROID_PRIORITY_URGENT_DISPLAY. Under load, a normal thread can wait
+// behind other work or be placed on a slow core in the middle of a gesture; a real-time thread
+// preempts normal threads and is kept at the highest frequency by the scheduler.
+constexpr const char* REALTIME_PRIORITY_PROPERTY = "ro.input.realtime_priority";
+
+void applyRealtimePriority(const std::string& name) {
+    const int priority = base::GetIntProperty(REALTIME_PRIORITY_PROPERTY, 0);
+    if (priority <= 0) {
+        return;
+    }
+    if (priority < sched_get_priority_min(SCHED_FIFO) ||
+        priority > sched_get_priority_max(SCHED_FIFO)) {
+        ALOGW("Ignoring %s=%d for %s, it is not a valid SCHED_FIFO priority",
+              REALTIME_PRIORITY_PROPERTY, priority, name.c_str());
+        return;
+    }
+    sched_param param = {.sched_priority = priority};
+    if (sched_setscheduler(/*pid=*/0, SCHED_FIFO | SCHED_RESET_ON_FORK, &param) != 0) {
+        ALOGW("Could not make %s real-time with priority %d: %s", name.c_str(), priority,
+              strerror(errno));
+    }
+}
+
 // Implementation of Thread from libutils.
 class InputThreadImpl : public Thread {
 public:
-    explicit InputThreadImpl(std::function<void()> loop)
-          : Thread(/* canCallJava */ true), mThreadLoop(loop) {}
+    explicit InputThreadImpl(std::string name, std::function<void()> loop)
+          : Thread(/* canCallJava */ true), mName(std::move(name)), mThreadLoop(loop) {}
 
     ~InputThreadImpl() {}
 
 private:
+    const std::string mName;
     std::function<void()> mThreadLoop;
 
+    status_t readyToRun() override {
+        applyRealtimePriority(mName);
+        return OK;
+    }
+
     bool threadLoop() override {
         mThreadLoop();
         return true;
@@ -41,7 +79,7 @@ private:
 
 InputThread::InputThread(std::string name, std::function<void()> loop, std::function<void()> wake)
       : mName(name), mThreadWake(wake) {
-    mThread = sp<InputThreadImpl>::make(loop);
+    mThread = sp<InputThreadImpl>::make(mName, loop);
     mThread->run(mName.c_str(), ANDROID_PRIORITY_URGENT_DISPLAY);
 }
 
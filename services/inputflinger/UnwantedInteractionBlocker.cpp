@@ -71,6 +71,18 @@ static const char* INPUT_NATIVE_BOOT = "input_native_boot";
  * 'true' (not case sensitive) or '1'. To disable, specify any other value.
  */
 static const char* PALM_REJECTION_ENABLED = "palm_rejection_enabled";
+/**
+ * Feature flag name. This flag determines whether the palm rejection model runs on a dedicated
+ * thread, so that touches are not delayed by the model. To enable, specify 'true' (not case
+ * sensitive) or '1'. To disable, specify any other value.
+ */
+static const char* PALM_REJECTION_ASYNC = "palm_rejection_async";
+
+/**
+ * Number of touch events that may be dispatched before the model has classified them, when the
+ * model runs asynchronously. A palm may interact with the app for that long before it is canceled.
+ */
+static constexpr size_t ASYNC_PALM_REJECTION_LOOKAHEAD = 3;
 
 static std::string toLower(std::string s) {
     std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
@@ -99,6 +111,28 @@ static bool isPalmRejectionEnabled() {
     return false;
 }
 
+/**
+ * Return true if the palm rejection model should run asynchronously, as per the server
+ * configurable flags. Return false otherwise.
+ */
+static bool isAsyncPalmRejectionEnabled() {
+    std::string value = toLower(
+            server_configurable_flags::GetServerConfigurableFlag(INPUT_NATIVE_BOOT,
+                                                                 PALM_REJECTION_ASYNC, "0"));
+    return value == "1" || value == "true";
+}
+
+static bool isLiftingPointer(int32_t action) {
+    switch (MotionEvent::getActionMasked(action)) {
+        case AMOTION_EVENT_ACTION_UP:
+        case AMOTION_EVENT_ACTION_POINTER_UP:
+        case AMOTION_EVENT_ACTION_CANCEL:
+            return true;
+        default:
+            return false;
+    }
+}
+
 static int getLinuxToolCode(ToolType toolType) {
     switch (toolType) {
         case ToolType::STYLUS:
@@ -322,11 +356,15 @@ std::vector<NotifyMotionArgs> cancelSuppressedPointers(
 }
 
 UnwantedInteractionBlocker::UnwantedInteractionBlocker(InputListenerInterface& listener)
-      : UnwantedInteractionBlocker(listener, isPalmRejectionEnabled()){};
+      : UnwantedInteractionBlocker(listener, isPalmRejectionEnabled(),
+                                   isAsyncPalmRejectionEnabled()){};
 
 UnwantedInteractionBlocker::UnwantedInteractionBlocker(InputListenerInterface& listener,
-                                                       bool enablePalmRejection)
-      : mQueuedListener(listener), mEnablePalmRejection(enablePalmRejection) {}
+                                                       bool enablePalmRejection,
+                                                       bool enableAsyncPalmRejection)
+      : mQueuedListener(listener),
+        mEnablePalmRejection(enablePalmRejection),
+        mEnableAsyncPalmRejection(enableAsyncPalmRejection) {}
 
 void UnwantedInteractionBlocker::notifyConfigurationChanged(
         const NotifyConfigurationChangedArgs& args) {
@@ -395,7 +433,7 @@ void UnwantedInteractionBlocker::notifyDeviceReset(const NotifyDeviceResetArgs&
             AndroidPalmFilterDeviceInfo info = it->second.getPalmFilterDeviceInfo();
             // Re-create the object instead of resetting it
             mPalmRejectors.erase(it);
-            mPalmRejectors.emplace(args.deviceId, info);
+            createPalmRejectorLocked(args.deviceId, info);
         }
         mQueuedListener.notifyDeviceReset(args);
         mPreferStylusOverTouchBlocker.notifyDeviceReset(args);
@@ -434,11 +472,13 @@ void UnwantedInteractionBlocker::onInputDevicesChanged(
             continue;
         }
 
-        auto [it, emplaced] = mPalmRejectors.try_emplace(device.getId(), *info);
-        if (!emplaced && *info != it->second.getPalmFilterDeviceInfo()) {
+        auto it = mPalmRejectors.find(device.getId());
+        if (it == mPalmRejectors.end()) {
+            createPalmRejectorLocked(device.getId(), *info);
+        } else if (*info != it->second.getPalmFilterDeviceInfo()) {
             // Re-create the PalmRejector because the device info has changed.
             mPalmRejectors.erase(it);
-            mPalmRejectors.emplace(device.getId(), *info);
+            createPalmRejectorLocked(device.getId(), *info);
         }
         devicesToKeep.insert(device.getId());
     }
@@ -450,6 +490,15 @@ void UnwantedInteractionBlocker::onInputDevicesChanged(
     mPreferStylusOverTouchBlocker.notifyInputDevicesChanged(inputDevices);
 }
 
+void UnwantedInteractionBlocker::createPalmRejectorLocked(int32_t deviceId,
+                                                          const AndroidPalmFilterDeviceInfo& info) {
+    const std::optional<size_t> asyncLookahead = mEnableAsyncPalmRejection
+            ? std::make_optional(ASYNC_PALM_REJECTION_LOOKAHEAD)
+            : std::nullopt;
+    mPalmRejectors.emplace(std::piecewise_construct, std::forward_as_tuple(deviceId),
+                           std::forward_as_tuple(info, /*filter=*/nullptr, asyncLookahead));
+}
+
 void UnwantedInteractionBlocker::dump(std::string& dump) {
     std::scoped_lock lock(mLock);
     dump += "UnwantedInteractionBlocker:\n";
@@ -459,6 +508,8 @@ void UnwantedInteractionBlocker::dump(std::string& dump) {
                          std::to_string(mEnablePalmRejection).c_str());
     dump += StringPrintf("  isPalmRejectionEnabled (flag value): %s\n",
                          std::to_string(isPalmRejectionEnabled()).c_str());
+    dump += StringPrintf("  mEnableAsyncPalmRejection: %s\n",
+                         std::to_string(mEnableAsyncPalmRejection).c_str());
     dump += mPalmRejectors.empty() ? "  mPalmRejectors: None\n" : "  mPalmRejectors:\n";
     for (const auto& [deviceId, palmRejector] : mPalmRejectors) {
         dump += StringPrintf("    deviceId = %" PRId32 ":\n", deviceId);
@@ -550,19 +601,31 @@ public:
 };
 
 PalmRejector::PalmRejector(const AndroidPalmFilterDeviceInfo& info,
-                           std::unique_ptr<::ui::PalmDetectionFilter> filter)
-      : mSharedPalmState(std::make_unique<::ui::SharedPalmDetectionFilterState>()),
-        mDeviceInfo(info),
-        mPalmDetectionFilter(std::move(filter)) {
-    if (mPalmDetectionFilter != nullptr) {
-        // This path is used for testing. Non-testing invocations should let this constructor
-        // create a real PalmDetectionFilter
-        return;
+                           std::unique_ptr<::ui::PalmDetectionFilter> filter,
+                           std::optional<size_t> asyncLookahead)
+      : mDeviceInfo(info),
+        mSharedPalmState(std::make_unique<::ui::SharedPalmDetectionFilterState>()),
+        mPalmDetectionFilter(std::move(filter)),
+        mAsyncLookahead(asyncLookahead) {
+    if (mPalmDetectionFilter == nullptr) {
+        // Testing invocations provide their own filter. Otherwise, create a real
+        // PalmDetectionFilter.
+        std::unique_ptr<::ui::NeuralStylusPalmDetectionFilterModel> model =
+                std::make_unique<AndroidPalmRejectionModel>();
+        mPalmDetectionFilter =
+                std::make_unique<PalmFilterImplementation>(mDeviceInfo, std::move(model),
+                                                           mSharedPalmState.get());
+    }
+
+    if (mAsyncLookahead) {
+        mInferenceThread = std::make_unique<InputThread>(
+                "PalmRejector", [this]() { inferenceLoopOnce(); },
+                [this]() {
+                    std::scoped_lock lock(mInferenceLock);
+                    mInferenceStopping = true;
+                    mInferenceCondition.notify_all();
+                });
     }
-    std::unique_ptr<::ui::NeuralStylusPalmDetectionFilterModel> model =
-            std::make_unique<AndroidPalmRejectionModel>();
-    mPalmDetectionFilter = std::make_unique<PalmFilterImplementation>(mDeviceInfo, std::move(model),
-                                                                      mSharedPalmState.get());
 }
 
 std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
@@ -633,6 +696,7 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
 }
 
 std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args) {
+    std::scoped_lock lock(mModelLock);
     std::bitset<::ui::kNumTouchEvdevSlots> slotsToHold;
     std::bitset<::ui::kNumTouchEvdevSlots> slotsToSuppress;
 
@@ -696,7 +760,11 @@ std::vector<NotifyMotionArgs> PalmRejector::processMotion(const NotifyMotionArgs
     std::swap(oldSuppressedIds, mSuppressedPointerIds);
 
     std::optional<NotifyMotionArgs> touchOnlyArgs = removeStylusPointerIds(args);
-    if (touchOnlyArgs) {
+    if (mAsyncLookahead) {
+        // Until an event of this gesture is classified, keep the suppressed pointer ids.
+        mSuppressedPointerIds = detectPalmPointersAsync(args.action, std::move(touchOnlyArgs))
+                                        .value_or(oldSuppressedIds);
+    } else if (touchOnlyArgs) {
         mSuppressedPointerIds = detectPalmPointers(*touchOnlyArgs);
     } else {
         // This is a stylus-only event.
@@ -722,11 +790,63 @@ std::vector<NotifyMotionArgs> PalmRejector::processMotion(const NotifyMotionArgs
     return argsWithoutUnwantedPointers;
 }
 
+std::optional<std::set<int32_t>> PalmRejector::detectPalmPointersAsync(
+        int32_t action, std::optional<NotifyMotionArgs> touchOnlyArgs) {
+    if (action == AMOTION_EVENT_ACTION_DOWN) {
+        mGestureId++;
+    }
+
+    std::unique_lock lock(mInferenceLock);
+    android::base::ScopedLockAssertion assumeLocked(mInferenceLock);
+    if (touchOnlyArgs) {
+        // Stylus-only events are not classified, as in the synchronous mode.
+        mPendingInferences.push_back({mGestureId, std::move(*touchOnlyArgs)});
+        mInferenceCondition.notify_all();
+    }
+
+    // Pointers must be classified before they go up, since they can't be canceled afterwards.
+    const size_t lookahead = isLiftingPointer(action) ? 0 : *mAsyncLookahead;
+    mInferenceCondition.wait(lock, [this, lookahead]() REQUIRES(mInferenceLock) {
+        return mPendingInferences.size() + (mInferenceRunning ? 1 : 0) <= lookahead;
+    });
+
+    if (mInferredGestureId != mGestureId) {
+        return std::nullopt;
+    }
+    return mInferredSuppressedIds;
+}
+
+void PalmRejector::inferenceLoopOnce() {
+    std::optional<InferenceRequest> request;
+    { // acquire lock
+        std::unique_lock lock(mInferenceLock);
+        android::base::ScopedLockAssertion assumeLocked(mInferenceLock);
+        mInferenceCondition.wait(lock, [this]() REQUIRES(mInferenceLock) {
+            return mInferenceStopping || !mPendingInferences.empty();
+        });
+        if (mInferenceStopping) {
+            return;
+        }
+        request = std::move(mPendingInferences.front());
+        mPendingInferences.pop_front();
+        mInferenceRunning = true;
+    } // release lock
+
+    std::set<int32_t> suppressedIds = detectPalmPointers(request->args);
+
+    std::scoped_lock lock(mInferenceLock);
+    mInferenceRunning = false;
+    mInferredGestureId = request->gestureId;
+    mInferredSuppressedIds = std::move(suppressedIds);
+    mInferenceCondition.notify_all();
+}
+
 const AndroidPalmFilterDeviceInfo& PalmRejector::getPalmFilterDeviceInfo() const {
     return mDeviceInfo;
 }
 
 std::string PalmRejector::dump() const {
+    std::scoped_lock lock(mModelLock);
     std::string out;
     out += "mDeviceInfo:\n";
     std::stringstream deviceInfo;
@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <set>
 
 #include <android-base/thread_annotations.h>
@@ -24,6 +27,7 @@
 #include "ui/events/ozone/evdev/touch_filter/neural_stylus_palm_detection_filter_util.h"
 #include "ui/events/ozone/evdev/touch_filter/palm_detection_filter.h"
 
+#include "InputThread.h"
 #include "PreferStylusOverTouchBlocker.h"
 
 namespace android {
@@ -88,7 +92,8 @@ class PalmRejector;
 class UnwantedInteractionBlocker : public UnwantedInteractionBlockerInterface {
 public:
     explicit UnwantedInteractionBlocker(InputListenerInterface& listener);
-    explicit UnwantedInteractionBlocker(InputListenerInterface& listener, bool enablePalmRejection);
+    explicit UnwantedInteractionBlocker(InputListenerInterface& listener, bool enablePalmRejection,
+                                        bool enableAsyncPalmRejection = false);
 
     void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override;
     void notifyConfigurationChanged(const NotifyConfigurationChangedArgs& args) override;
@@ -111,6 +116,8 @@ private:
 
     QueuedInputListener mQueuedListener;
     const bool mEnablePalmRejection;
+    // Whether the palm rejection model runs off the InputReader thread, see PalmRejector.
+    const bool mEnableAsyncPalmRejection;
 
     // When stylus is down, ignore touch
     PreferStylusOverTouchBlocker mPreferStylusOverTouchBlocker GUARDED_BY(mLock);
@@ -125,6 +132,8 @@ private:
     void enqueueOutboundMotionLocked(const NotifyMotionArgs& args) REQUIRES(mLock);
 
     void onInputDevicesChanged(const std::vector<InputDeviceInfo>& inputDevices);
+    void createPalmRejectorLocked(int32_t deviceId, const AndroidPalmFilterDeviceInfo& info)
+            REQUIRES(mLock);
 };
 
 class SlotState {
@@ -161,10 +170,22 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
                                                    const SlotState& oldSlotState,
                                                    const SlotState& newSlotState);
 
+/**
+ * Runs the palm rejection model on the touches of a device, and cancels the pointers that it
+ * classifies as palm.
+ *
+ * By default, the model runs synchronously in processMotion. If 'asyncLookahead' is provided, the
+ * model runs on a dedicated thread instead, and processMotion returns before the event is
+ * classified. A pointer that turns out to be a palm is canceled in the first event processed after
+ * the classification. At most 'asyncLookahead' events may be awaiting classification before
+ * processMotion waits for the model to catch up. Events that lift pointers always wait, so that a
+ * palm can't complete a tap before it is classified.
+ */
 class PalmRejector {
 public:
     explicit PalmRejector(const AndroidPalmFilterDeviceInfo& info,
-                          std::unique_ptr<::ui::PalmDetectionFilter> filter = nullptr);
+                          std::unique_ptr<::ui::PalmDetectionFilter> filter = nullptr,
+                          std::optional<size_t> asyncLookahead = std::nullopt);
     std::vector<NotifyMotionArgs> processMotion(const NotifyMotionArgs& args);
 
     // Get the device info of this device, for comparison purposes
@@ -183,13 +204,50 @@ private:
      * the incoming args! Also, it will call Filter(..), which has side-effects.
      */
     std::set<int32_t> detectPalmPointers(const NotifyMotionArgs& args);
-    std::unique_ptr<::ui::SharedPalmDetectionFilterState> mSharedPalmState;
+
+    /**
+     * Queue the touches of this event for classification on the inference thread, and return the
+     * pointer ids that should be suppressed according to the latest classification of this gesture,
+     * or nullopt if none of its events has been classified yet. Waits until the number of events
+     * awaiting classification is within the lookahead.
+     */
+    std::optional<std::set<int32_t>> detectPalmPointersAsync(
+            int32_t action, std::optional<NotifyMotionArgs> touchOnlyArgs);
+    // Classifies the oldest pending event on the inference thread.
+    void inferenceLoopOnce();
+
     AndroidPalmFilterDeviceInfo mDeviceInfo;
-    std::unique_ptr<::ui::PalmDetectionFilter> mPalmDetectionFilter;
     std::set<int32_t> mSuppressedPointerIds;
 
+    // Held while the model state below is used, since it is used on the inference thread in the
+    // asynchronous mode.
+    mutable std::mutex mModelLock;
+    std::unique_ptr<::ui::SharedPalmDetectionFilterState> mSharedPalmState;
+    std::unique_ptr<::ui::PalmDetectionFilter> mPalmDetectionFilter;
+
     // Used to help convert an Android touch stream to Linux input stream.
     SlotState mSlotState;
+
+    // State of the asynchronous mode. Gestures are numbered so that a classification is only
+    // applied to the gesture that it belongs to.
+    struct InferenceRequest {
+        uint64_t gestureId;
+        NotifyMotionArgs args;
+    };
+
+    const std::optional<size_t> mAsyncLookahead;
+    uint64_t mGestureId = 0;
+
+    std::mutex mInferenceLock;
+    std::condition_variable mInferenceCondition;
+    std::deque<InferenceRequest> mPendingInferences GUARDED_BY(mInferenceLock);
+    bool mInferenceRunning GUARDED_BY(mInferenceLock) = false;
+    bool mInferenceStopping GUARDED_BY(mInferenceLock) = false;
+    uint64_t mInferredGestureId GUARDED_BY(mInferenceLock) = 0;
+    std::set<int32_t> mInferredSuppressedIds GUARDED_BY(mInferenceLock);
+
+    // Declared last, so that the thread stops before the state it uses is destroyed.
+    std::unique_ptr<InputThread> mInferenceThread;
 };
 
 } // namespace android
@@ -16,11 +16,22 @@
 
 #include <benchmark/benchmark.h>
 
+#include <allocationcounter/AllocationCounter.h>
+#include <android-base/file.h>
 #include <android/os/IInputConstants.h>
 #include <binder/Binder.h>
 #include <gui/constants.h>
 #include "../dispatcher/InputDispatcher.h"
 
+#include <linux/input-event-codes.h>
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
 using android::base::Result;
 using android::gui::WindowInfo;
 using android::gui::WindowInfoHandle;
@@ -178,6 +189,11 @@ public:
         mInfo.applicationInfo = *inputApplicationHandle->getInfo();
     }
 
+    void setFrame(const Rect& frame) {
+        mFrame = frame;
+        updateInfo();
+    }
+
     void updateInfo() {
         mInfo.token = mClientChannel->getConnectionToken();
         mInfo.name = "FakeWindowHandle";
@@ -253,6 +269,234 @@ static NotifyMotionArgs generateMotionArgs() {
     return args;
 }
 
+// --- Recorded touch sessions ---
+
+// One raw evdev event from a touchscreen recording.
+struct RecordedEvent {
+    nsecs_t when;
+    int32_t type;
+    int32_t code;
+    int32_t value;
+};
+
+// Parses the output of `getevent -t <device>`, e.g.
+//     [   61390.010486] /dev/input/event2: 0003 0035 000001c2
+// Lines that aren't events (device announcements, names) are skipped.
+static std::vector<RecordedEvent> parseGeteventRecording(const std::string& recording) {
+    std::vector<RecordedEvent> events;
+    std::istringstream lines(recording);
+    std::string line;
+    while (std::getline(lines, line)) {
+        long long seconds, micros;
+        unsigned int type, code, value;
+        if (sscanf(line.c_str(), "[ %lld.%lld] %*[^:]: %x %x %x", &seconds, &micros, &type, &code,
+                   &value) != 5) {
+            continue;
+        }
+        events.push_back({seconds * 1000000000LL + micros * 1000LL, static_cast<int32_t>(type),
+                          static_cast<int32_t>(code), static_cast<int32_t>(value)});
+    }
+    return events;
+}
+
+// Converts multi-touch protocol B events into the motion events the reader would send to the
+// dispatcher. The device coordinates are used as display coordinates, and the slot index is used as
+// the pointer id.
+static std::vector<NotifyMotionArgs> motionArgsFromRecording(
+        const std::vector<RecordedEvent>& events) {
+    struct Slot {
+        int32_t trackingId = -1;
+        float x = 0;
+        float y = 0;
+    };
+    std::array<Slot, MAX_POINTERS> slots;
+    size_t currentSlot = 0;
+    BitSet32 reportedIds;
+    nsecs_t downTime = 0;
+    std::vector<NotifyMotionArgs> out;
+
+    auto emit = [&](nsecs_t when, int32_t action) {
+        PointerProperties pointerProperties[MAX_POINTERS];
+        PointerCoords pointerCoords[MAX_POINTERS];
+        uint32_t pointerCount = 0;
+        for (BitSet32 idBits(reportedIds); !idBits.isEmpty(); pointerCount++) {
+            const uint32_t id = idBits.clearFirstMarkedBit();
+            pointerProperties[pointerCount].clear();
+            pointerProperties[pointerCount].id = id;
+            pointerProperties[pointerCount].toolType = ToolType::FINGER;
+            pointerCoords[pointerCount].clear();
+            pointerCoords[pointerCount].setAxisValue(AMOTION_EVENT_AXIS_X, slots[id].x);
+            pointerCoords[pointerCount].setAxisValue(AMOTION_EVENT_AXIS_Y, slots[id].y);
+        }
+        out.emplace_back(IInputConstants::INVALID_INPUT_EVENT_ID, when, when, DEVICE_ID,
+                         AINPUT_SOURCE_TOUCHSCREEN, ADISPLAY_ID_DEFAULT, POLICY_FLAG_PASS_TO_USER,
+                         action, /* actionButton */ 0, /* flags */ 0, AMETA_NONE,
+                         /* buttonState */ 0, MotionClassification::NONE,
+                         AMOTION_EVENT_EDGE_FLAG_NONE, pointerCount, pointerProperties,
+                         pointerCoords, /* xPrecision */ 0, /* yPrecision */ 0,
+                         AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                         AMOTION_EVENT_INVALID_CURSOR_POSITION, downTime, /* videoFrames */ {});
+    };
+    auto withIndex = [](int32_t action, uint32_t index) -> int32_t {
+        return action | static_cast<int32_t>(index << AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT);
+    };
+
+    for (const RecordedEvent& event : events) {
+        if (event.type == EV_ABS) {
+            if (event.code == ABS_MT_SLOT) {
+                currentSlot = static_cast<size_t>(event.value);
+            } else if (currentSlot >= slots.size()) {
+                continue;
+            } else if (event.code == ABS_MT_TRACKING_ID) {
+                slots[currentSlot].trackingId = event.value;
+            } else if (event.code == ABS_MT_POSITION_X) {
+                slots[currentSlot].x = event.value;
+            } else if (event.code == ABS_MT_POSITION_Y) {
+                slots[currentSlot].y = event.value;
+            }
+            continue;
+        }
+        if (event.type != EV_SYN || event.code != SYN_REPORT) {
+            continue;
+        }
+
+        BitSet32 touchingIds;
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].trackingId >= 0) {
+                touchingIds.markBit(i);
+            }
+        }
+        bool changedPointers = false;
+        for (BitSet32 upIds(reportedIds.value & ~touchingIds.value); !upIds.isEmpty();) {
+            const uint32_t id = upIds.clearFirstMarkedBit();
+            emit(event.when,
+                 reportedIds.count() == 1
+                         ? AMOTION_EVENT_ACTION_UP
+                         : withIndex(AMOTION_EVENT_ACTION_POINTER_UP, reportedIds.getIndexOfBit(id)));
+            reportedIds.clearBit(id);
+            changedPointers = true;
+        }
+        for (BitSet32 downIds(touchingIds.value & ~reportedIds.value); !downIds.isEmpty();) {
+            const uint32_t id = downIds.clearFirstMarkedBit();
+            reportedIds.markBit(id);
+            if (reportedIds.count() == 1) {
+                downTime = event.when;
+                emit(event.when, AMOTION_EVENT_ACTION_DOWN);
+            } else {
+                emit(event.when,
+                     withIndex(AMOTION_EVENT_ACTION_POINTER_DOWN, reportedIds.getIndexOfBit(id)));
+            }
+            changedPointers = true;
+        }
+        if (!changedPointers && !reportedIds.isEmpty()) {
+            emit(event.when, AMOTION_EVENT_ACTION_MOVE);
+        }
+    }
+    return out;
+}
+
+// A two finger pinch reported at 120Hz, used when no recording is provided.
+static std::vector<RecordedEvent> synthesizePinchRecording() {
+    constexpr nsecs_t FRAME_INTERVAL = 8'333'333;
+    constexpr int32_t FRAMES = 120;
+    std::vector<RecordedEvent> events;
+    nsecs_t when = 0;
+    for (int32_t slot = 0; slot < 2; slot++) {
+        events.push_back({when, EV_ABS, ABS_MT_SLOT, slot});
+        events.push_back({when, EV_ABS, ABS_MT_TRACKING_ID, slot});
+    }
+    for (int32_t frame = 0; frame < FRAMES; frame++) {
+        for (int32_t slot = 0; slot < 2; slot++) {
+            const int32_t offset = slot == 0 ? -frame : frame;
+            events.push_back({when, EV_ABS, ABS_MT_SLOT, slot});
+            events.push_back({when, EV_ABS, ABS_MT_POSITION_X, 500 + offset});
+            events.push_back({when, EV_ABS, ABS_MT_POSITION_Y, 1000 + offset});
+        }
+        events.push_back({when, EV_SYN, SYN_REPORT, 0});
+        when += FRAME_INTERVAL;
+    }
+    for (int32_t slot = 0; slot < 2; slot++) {
+        events.push_back({when, EV_ABS, ABS_MT_SLOT, slot});
+        events.push_back({when, EV_ABS, ABS_MT_TRACKING_ID, -1});
+        events.push_back({when, EV_SYN, SYN_REPORT, 0});
+        when += FRAME_INTERVAL;
+    }
+    return events;
+}
+
+// Replays a recorded touchscreen session through the dispatcher to a single window, and reports
+// the process CPU time and the notify-to-consume latency per event. Record a session with
+//     adb shell getevent -t /dev/input/eventN > recording.txt
+// and pass it in INPUT_REPLAY_RECORDING. Events are replayed as fast as possible, unless
+// INPUT_REPLAY_SPEED is set to a speed factor relative to the recording (e.g. 1 for original
+// speed, 4 for 4x).
+static void benchmarkReplayRecordedTouches(benchmark::State& state) {
+    std::vector<RecordedEvent> recording;
+    if (const char* path = getenv("INPUT_REPLAY_RECORDING"); path != nullptr) {
+        std::string contents;
+        if (!base::ReadFileToString(path, &contents)) {
+            state.SkipWithError("Could not read INPUT_REPLAY_RECORDING");
+            return;
+        }
+        recording = parseGeteventRecording(contents);
+    } else {
+        recording = synthesizePinchRecording();
+    }
+    const std::vector<NotifyMotionArgs> trace = motionArgsFromRecording(recording);
+    if (trace.empty()) {
+        state.SkipWithError("The recording contains no touches");
+        return;
+    }
+    const char* speedString = getenv("INPUT_REPLAY_SPEED");
+    const double speed = speedString != nullptr ? atof(speedString) : 0;
+
+    FakeInputDispatcherPolicy fakePolicy;
+    InputDispatcher dispatcher(fakePolicy);
+    dispatcher.setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher.start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window");
+    // Device coordinates are replayed as-is, so cover any touchscreen resolution.
+    window->setFrame(Rect(0, 0, 1 << 16, 1 << 16));
+    dispatcher.setInputWindows({{ADISPLAY_ID_DEFAULT, {window}}});
+
+    nsecs_t totalLatency = 0;
+    nsecs_t maxLatency = 0;
+    nsecs_t totalCpuTime = 0;
+    for (auto _ : state) {
+        const nsecs_t replayStart = now();
+        const nsecs_t recordingStart = trace.front().eventTime;
+        for (const NotifyMotionArgs& recorded : trace) {
+            if (speed > 0) {
+                const auto offset = static_cast<nsecs_t>((recorded.eventTime - recordingStart) / speed);
+                std::this_thread::sleep_for(std::chrono::nanoseconds(replayStart + offset - now()));
+            }
+            NotifyMotionArgs args(recorded);
+            args.eventTime = now();
+            args.downTime = args.eventTime - (recorded.eventTime - recorded.downTime);
+            args.readTime = args.eventTime;
+
+            const nsecs_t cpuStart = systemTime(SYSTEM_TIME_PROCESS);
+            dispatcher.notifyMotion(args);
+            window->consumeEvent();
+            totalCpuTime += systemTime(SYSTEM_TIME_PROCESS) - cpuStart;
+
+            const nsecs_t latency = now() - args.eventTime;
+            totalLatency += latency;
+            maxLatency = std::max(maxLatency, latency);
+        }
+    }
+    dispatcher.stop();
+
+    const double events = static_cast<double>(trace.size() * state.iterations());
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+    state.counters["cpu_us/event"] = benchmark::Counter(totalCpuTime / 1000.0 / events);
+    state.counters["latency_us"] = benchmark::Counter(totalLatency / 1000.0 / events);
+    state.counters["max_latency_us"] = benchmark::Counter(maxLatency / 1000.0);
+}
+
 static void benchmarkNotifyMotion(benchmark::State& state) {
     // Create dispatcher
     FakeInputDispatcherPolicy fakePolicy;
@@ -269,6 +513,7 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
 
     NotifyMotionArgs motionArgs = generateMotionArgs();
 
+    const size_t allocationsBefore = getProcessAllocationCount();
     for (auto _ : state) {
         // Send ACTION_DOWN
         motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
@@ -284,6 +529,10 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
         window->consumeEvent();
         window->consumeEvent();
     }
+    // Includes the dispatcher thread and the window consuming the events.
+    const size_t allocations = getProcessAllocationCount() - allocationsBefore;
+    state.counters["allocs/event"] =
+            benchmark::Counter(static_cast<double>(allocations) / (2 * state.iterations()));
 
     dispatcher.stop();
 }
@@ -351,6 +600,7 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
 BENCHMARK(benchmarkNotifyMotion);
 BENCHMARK(benchmarkInjectMotion);
 BENCHMARK(benchmarkOnWindowInfosChanged);
+BENCHMARK(benchmarkReplayRecordedTouches);
 
 } // namespace android::inputdispatcher
 
@@ -532,9 +532,17 @@ bool windowAcceptsTouchAt(const WindowInfo& windowInfo, int32_t displayId, float
     // "bottom" of the window will be different in the display (un-rotated) space compared to in the
     // logical display in which WM determined the bounds. Perform the hit test in the logical
     // display space to ensure these edges are considered correctly in all orientations.
-    const auto touchableRegion = displayTransform.transform(windowInfo.touchableRegion);
     const auto p = displayTransform.transform(x, y);
-    if (!touchableRegion.contains(std::floor(p.x), std::floor(p.y))) {
+    const int32_t px = static_cast<int32_t>(std::floor(p.x));
+    const int32_t py = static_cast<int32_t>(std::floor(p.y));
+    // Most windows are nowhere near the point, so reject against the transformed bounds before
+    // transforming the whole region. Transforming a region never reaches outside its bounds.
+    const Rect bounds = displayTransform.transform(windowInfo.touchableRegion.getBounds());
+    if (px < bounds.left || px >= bounds.right || py < bounds.top || py >= bounds.bottom) {
+        return false;
+    }
+    const auto touchableRegion = displayTransform.transform(windowInfo.touchableRegion);
+    if (!touchableRegion.contains(px, py)) {
         return false;
     }
     return true;
@@ -708,6 +716,40 @@ void filterUntrustedTargets(TouchState& touchState, std::vector<InputTarget>& ta
     });
 }
 
+// Returns true if 'newEntry' is a hover move that can replace 'queuedEntry', a hover move that is
+// still waiting in the outbound queue for the same target. Hover moves carry no state that the
+// app needs besides the latest location, so a consumer that fell behind only needs the newest one.
+bool canReplaceQueuedHoverMove(const DispatchEntry& queuedEntry, const DispatchEntry& newEntry) {
+    if (queuedEntry.resolvedAction != AMOTION_EVENT_ACTION_HOVER_MOVE ||
+        newEntry.resolvedAction != AMOTION_EVENT_ACTION_HOVER_MOVE ||
+        queuedEntry.eventEntry->type != EventEntry::Type::MOTION ||
+        newEntry.eventEntry->type != EventEntry::Type::MOTION) {
+        return false;
+    }
+    if (queuedEntry.targetFlags != newEntry.targetFlags ||
+        queuedEntry.resolvedFlags != newEntry.resolvedFlags ||
+        queuedEntry.transform != newEntry.transform ||
+        queuedEntry.rawTransform != newEntry.rawTransform ||
+        queuedEntry.globalScaleFactor != newEntry.globalScaleFactor) {
+        return false;
+    }
+    const MotionEntry& queuedMotion = static_cast<const MotionEntry&>(*queuedEntry.eventEntry);
+    const MotionEntry& newMotion = static_cast<const MotionEntry&>(*newEntry.eventEntry);
+    if (queuedMotion.deviceId != newMotion.deviceId || queuedMotion.source != newMotion.source ||
+        queuedMotion.displayId != newMotion.displayId ||
+        queuedMotion.metaState != newMotion.metaState ||
+        queuedMotion.buttonState != newMotion.buttonState ||
+        queuedMotion.pointerCount != newMotion.pointerCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < newMotion.pointerCount; i++) {
+        if (queuedMotion.pointerProperties[i] != newMotion.pointerProperties[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace
 
 // --- InputDispatcher ---
@@ -1247,6 +1289,7 @@ InputDispatcher::findTouchedWindowAtLocked(int32_t displayId, float x, float y,
     // Traverse windows from front to back to find touched window.
     std::vector<InputTarget> outsideTargets;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
+    const ui::Transform displayTransform = getTransformLocked(displayId);
     for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
@@ -1263,7 +1306,7 @@ InputDispatcher::findTouchedWindowAtLocked(int32_t displayId, float x, float y,
 
         const WindowInfo& info = *windowHandle->getInfo();
         if (!info.isSpy() &&
-            windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+            windowAcceptsTouchAt(info, displayId, x, y, isStylus, displayTransform)) {
             return {windowHandle, outsideTargets};
         }
 
@@ -1281,10 +1324,11 @@ std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked
     // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
+    const ui::Transform displayTransform = getTransformLocked(displayId);
     for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
         const WindowInfo& info = *windowHandle->getInfo();
 
-        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, displayTransform)) {
             continue;
         }
         if (!info.isSpy()) {
@@ -1805,14 +1849,38 @@ void InputDispatcher::dispatchSensorLocked(nsecs_t currentTime,
               entry->eventTime, entry->hwTimestamp, entry->deviceId, entry->source,
               ftl::enum_string(entry->sensorType).c_str());
     }
-    auto command = [this, entry]() REQUIRES(mLock) {
+    // Deliver the samples from the same sensor that are queued right behind this one together,
+    // instead of posting a command for each of them.
+    std::vector<SensorSample> samples;
+    samples.push_back({entry->hwTimestamp, entry->values});
+    while (!mInboundQueue.empty() && mInboundQueue.front()->type == EventEntry::Type::SENSOR) {
+        std::shared_ptr<SensorEntry> next =
+                std::static_pointer_cast<SensorEntry>(mInboundQueue.front());
+        if (next->deviceId != entry->deviceId || next->sensorType != entry->sensorType ||
+            next->accuracy != entry->accuracy || next->accuracyChanged) {
+            break;
+        }
+        mInboundQueue.pop_front();
+        samples.push_back({next->hwTimestamp, std::move(next->values)});
+        releaseInboundEventLocked(next);
+    }
+    if (samples.size() > 1) {
+        traceInboundQueueLengthLocked();
+    }
+
+    auto command = [this, entry, samples = std::move(samples)]() REQUIRES(mLock) {
         scoped_unlock unlock(mLock);
 
         if (entry->accuracyChanged) {
             mPolicy.notifySensorAccuracy(entry->deviceId, entry->sensorType, entry->accuracy);
         }
-        mPolicy.notifySensorEvent(entry->deviceId, entry->sensorType, entry->accuracy,
-                                  entry->hwTimestamp, entry->values);
+        if (samples.size() == 1) {
+            mPolicy.notifySensorEvent(entry->deviceId, entry->sensorType, entry->accuracy,
+                                      samples.front().timestamp, samples.front().values);
+        } else {
+            mPolicy.notifySensorEvents(entry->deviceId, entry->sensorType, entry->accuracy,
+                                       samples);
+        }
     };
     postCommandLocked(std::move(command));
 }
@@ -3019,7 +3087,7 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
             break; // All future windows are below us. Exit early.
         }
         const WindowInfo* otherInfo = otherHandle->getInfo();
-        if (canBeObscuredBy(windowHandle, otherHandle) && otherInfo->frameContainsPoint(x, y) &&
+        if (otherInfo->frameContainsPoint(x, y) && canBeObscuredBy(windowHandle, otherHandle) &&
             !haveSameApplicationToken(windowInfo, otherInfo)) {
             if (DEBUG_TOUCH_OCCLUSION) {
                 info.debugInfo.push_back(
@@ -3098,14 +3166,13 @@ bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<WindowInfoHandle>&
         }
         const WindowInfo* otherInfo = otherHandle->getInfo();
 #ifdef DISABLE_DEVICE_INTEGRATION
-        if (canBeObscuredBy(windowHandle, otherHandle) &&
-            otherInfo->frameContainsPoint(x, y)) {
+        if (otherInfo->frameContainsPoint(x, y) && canBeObscuredBy(windowHandle, otherHandle)) {
             return true;
         }
 #else
         bool isBlackScreen = (otherInfo->layoutParamsType == WindowInfo::Type::SYSTEM_BLACKSCREEN_OVERLAY);
-        if (canBeObscuredBy(windowHandle, otherHandle) &&
-            otherInfo->frameContainsPoint(x, y) && !isBlackScreen) {
+        if (otherInfo->frameContainsPoint(x, y) && canBeObscuredBy(windowHandle, otherHandle) &&
+            !isBlackScreen) {
             return true;
         }
 #endif
@@ -3477,6 +3544,19 @@ void InputDispatcher::enqueueDispatchEntryLocked(const std::shared_ptr<Connectio
         incrementPendingForegroundDispatches(newEntry);
     }
 
+    // If the app fell behind, drop the hover move it has not been sent yet rather than letting
+    // stale moves pile up and be replayed once it recovers.
+    if (!connection->outboundQueue.empty() &&
+        canReplaceQueuedHoverMove(*connection->outboundQueue.back(), *dispatchEntry)) {
+        DispatchEntry* staleEntry = connection->outboundQueue.back();
+        if (DEBUG_DISPATCH_CYCLE) {
+            ALOGD("channel '%s' ~ enqueueDispatchEntryLocked: replacing queued hover move",
+                  connection->getInputChannelName().c_str());
+        }
+        connection->outboundQueue.pop_back();
+        releaseDispatchEntry(staleEntry);
+    }
+
     // Enqueue the dispatch entry.
     connection->outboundQueue.push_back(dispatchEntry.release());
     traceOutboundQueueLength(*connection);
@@ -4585,6 +4665,132 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
     }
     nsecs_t endTime = now() + std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
 
+    std::queue<std::unique_ptr<EventEntry>> injectedEntries;
+    if (!createInjectedEntries(*event, policyFlags, injectedEntries)) {
+        return InputEventInjectionResult::FAILED;
+    }
+
+    InjectionState* injectionState = new InjectionState(targetUid);
+    if (syncMode == InputEventInjectionSync::NONE) {
+        injectionState->injectionIsAsync = true;
+    }
+
+    injectionState->refCount += 1;
+    injectedEntries.back()->injectionState = injectionState;
+
+    mLock.lock();
+    const bool needWake = enqueueInjectedEntriesLocked(*event, injectedEntries);
+    mLock.unlock();
+
+    if (needWake) {
+        mLooper->wake();
+    }
+
+    InputEventInjectionResult injectionResult;
+    { // acquire lock
+        std::unique_lock _l(mLock);
+
+        if (syncMode == InputEventInjectionSync::NONE) {
+            injectionResult = InputEventInjectionResult::SUCCEEDED;
+        } else {
+            for (;;) {
+                injectionResult = injectionState->injectionResult;
+                if (injectionResult != InputEventInjectionResult::PENDING) {
+                    break;
+                }
+
+                nsecs_t remainingTimeout = endTime - now();
+                if (remainingTimeout <= 0) {
+                    if (DEBUG_INJECTION) {
+                        ALOGD("injectInputEvent - Timed out waiting for injection result "
+                              "to become available.");
+                    }
+                    injectionResult = InputEventInjectionResult::TIMED_OUT;
+                    break;
+                }
+
+                mInjectionResultAvailable.wait_for(_l, std::chrono::nanoseconds(remainingTimeout));
+            }
+
+            if (injectionResult == InputEventInjectionResult::SUCCEEDED &&
+                syncMode == InputEventInjectionSync::WAIT_FOR_FINISHED) {
+                while (injectionState->pendingForegroundDispatches != 0) {
+                    if (DEBUG_INJECTION) {
+                        ALOGD("injectInputEvent - Waiting for %d pending foreground dispatches.",
+                              injectionState->pendingForegroundDispatches);
+                    }
+                    nsecs_t remainingTimeout = endTime - now();
+                    if (remainingTimeout <= 0) {
+                        if (DEBUG_INJECTION) {
+                            ALOGD("injectInputEvent - Timed out waiting for pending foreground "
+                                  "dispatches to finish.");
+                        }
+                        injectionResult = InputEventInjectionResult::TIMED_OUT;
+                        break;
+                    }
+
+                    mInjectionSyncFinished.wait_for(_l, std::chrono::nanoseconds(remainingTimeout));
+                }
+            }
+        }
+
+        injectionState->release();
+    } // release lock
+
+    if (DEBUG_INJECTION) {
+        LOG(DEBUG) << "injectInputEvent - Finished with result "
+                   << ftl::enum_string(injectionResult);
+    }
+
+    return injectionResult;
+}
+
+InputEventInjectionResult InputDispatcher::injectInputEvents(
+        const std::vector<const InputEvent*>& events, std::optional<int32_t> targetUid,
+        uint32_t policyFlags) {
+    for (const InputEvent* event : events) {
+        Result<void> eventValidation = validateInputEvent(*event);
+        if (!eventValidation.ok()) {
+            LOG(INFO) << "Batch injection failed: invalid event: " << eventValidation.error();
+            return InputEventInjectionResult::FAILED;
+        }
+    }
+
+    if (debugInboundEventDetails()) {
+        LOG(DEBUG) << __func__ << ": targetUid=" << toString(targetUid)
+                   << ", count=" << events.size() << ", policyFlags=0x" << std::hex << policyFlags
+                   << std::dec;
+    }
+
+    // Convert all the events before taking the lock, since the policy is consulted for each one.
+    std::vector<std::queue<std::unique_ptr<EventEntry>>> injectedEntries(events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        if (!createInjectedEntries(*events[i], policyFlags, injectedEntries[i])) {
+            return InputEventInjectionResult::FAILED;
+        }
+
+        // The entry holds the only reference, since nobody waits for the result.
+        InjectionState* injectionState = new InjectionState(targetUid);
+        injectionState->injectionIsAsync = true;
+        injectedEntries[i].back()->injectionState = injectionState;
+    }
+
+    bool needWake = false;
+    { // acquire lock
+        std::scoped_lock _l(mLock);
+        for (size_t i = 0; i < events.size(); i++) {
+            needWake |= enqueueInjectedEntriesLocked(*events[i], injectedEntries[i]);
+        }
+    } // release lock
+
+    if (needWake) {
+        mLooper->wake();
+    }
+    return InputEventInjectionResult::SUCCEEDED;
+}
+
+bool InputDispatcher::createInjectedEntries(const InputEvent& event, uint32_t policyFlags,
+                                            std::queue<std::unique_ptr<EventEntry>>& outEntries) {
     policyFlags |= POLICY_FLAG_INJECTED | POLICY_FLAG_TRUSTED;
 
     // For all injected events, set device id = VIRTUAL_KEYBOARD_ID. The only exception is events
@@ -4595,13 +4801,12 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
     // from events that originate from actual hardware.
     int32_t resolvedDeviceId = VIRTUAL_KEYBOARD_ID;
     if (policyFlags & POLICY_FLAG_FILTERED) {
-        resolvedDeviceId = event->getDeviceId();
+        resolvedDeviceId = event.getDeviceId();
     }
 
-    std::queue<std::unique_ptr<EventEntry>> injectedEntries;
-    switch (event->getType()) {
+    switch (event.getType()) {
         case InputEventType::KEY: {
-            const KeyEvent& incomingKey = static_cast<const KeyEvent&>(*event);
+            const KeyEvent& incomingKey = static_cast<const KeyEvent&>(event);
             const int32_t action = incomingKey.getAction();
             int32_t flags = incomingKey.getFlags();
             if (policyFlags & POLICY_FLAG_INJECTED_FROM_ACCESSIBILITY) {
@@ -4630,7 +4835,6 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                 }
             }
 
-            mLock.lock();
             std::unique_ptr<KeyEntry> injectedEntry =
                     std::make_unique<KeyEntry>(incomingKey.getId(), incomingKey.getEventTime(),
                                                resolvedDeviceId, incomingKey.getSource(),
@@ -4638,18 +4842,18 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                                                flags, keyCode, incomingKey.getScanCode(), metaState,
                                                incomingKey.getRepeatCount(),
                                                incomingKey.getDownTime());
-            injectedEntries.push(std::move(injectedEntry));
+            outEntries.push(std::move(injectedEntry));
             break;
         }
 
         case InputEventType::MOTION: {
-            const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+            const MotionEvent& motionEvent = static_cast<const MotionEvent&>(event);
             const bool isPointerEvent =
-                    isFromSource(event->getSource(), AINPUT_SOURCE_CLASS_POINTER);
+                    isFromSource(event.getSource(), AINPUT_SOURCE_CLASS_POINTER);
             // If a pointer event has no displayId specified, inject it to the default display.
-            const uint32_t displayId = isPointerEvent && (event->getDisplayId() == ADISPLAY_ID_NONE)
+            const uint32_t displayId = isPointerEvent && (event.getDisplayId() == ADISPLAY_ID_NONE)
                     ? ADISPLAY_ID_DEFAULT
-                    : event->getDisplayId();
+                    : event.getDisplayId();
             int32_t flags = motionEvent.getFlags();
 
             if (!(policyFlags & POLICY_FLAG_FILTERED)) {
@@ -4666,7 +4870,6 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                 flags |= AMOTION_EVENT_FLAG_IS_ACCESSIBILITY_EVENT;
             }
 
-            mLock.lock();
             const nsecs_t* sampleEventTimes = motionEvent.getSampleEventTimes();
             const PointerCoords* samplePointerCoords = motionEvent.getSamplePointerCoords();
             std::unique_ptr<MotionEntry> injectedEntry =
@@ -4686,8 +4889,7 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                                                   motionEvent.getPointerCount(),
                                                   motionEvent.getPointerProperties(),
                                                   samplePointerCoords);
-            transformMotionEntryForInjectionLocked(*injectedEntry, motionEvent.getTransform());
-            injectedEntries.push(std::move(injectedEntry));
+            outEntries.push(std::move(injectedEntry));
             for (size_t i = motionEvent.getHistorySize(); i > 0; i--) {
                 sampleEventTimes += 1;
                 samplePointerCoords += motionEvent.getPointerCount();
@@ -4709,98 +4911,35 @@ InputEventInjectionResult InputDispatcher::injectInputEvent(const InputEvent* ev
                                                       motionEvent.getPointerCount(),
                                                       motionEvent.getPointerProperties(),
                                                       samplePointerCoords);
-                transformMotionEntryForInjectionLocked(*nextInjectedEntry,
-                                                       motionEvent.getTransform());
-                injectedEntries.push(std::move(nextInjectedEntry));
+                outEntries.push(std::move(nextInjectedEntry));
             }
             break;
         }
 
         default:
-            LOG(WARNING) << "Cannot inject " << ftl::enum_string(event->getType()) << " events";
-            return InputEventInjectionResult::FAILED;
-    }
-
-    InjectionState* injectionState = new InjectionState(targetUid);
-    if (syncMode == InputEventInjectionSync::NONE) {
-        injectionState->injectionIsAsync = true;
+            LOG(WARNING) << "Cannot inject " << ftl::enum_string(event.getType()) << " events";
+            return false;
     }
+    return true;
+}
 
-    injectionState->refCount += 1;
-    injectedEntries.back()->injectionState = injectionState;
-
+bool InputDispatcher::enqueueInjectedEntriesLocked(
+        const InputEvent& event, std::queue<std::unique_ptr<EventEntry>>& injectedEntries) {
     bool needWake = false;
     while (!injectedEntries.empty()) {
+        std::unique_ptr<EventEntry>& entry = injectedEntries.front();
+        if (entry->type == EventEntry::Type::MOTION) {
+            transformMotionEntryForInjectionLocked(static_cast<MotionEntry&>(*entry),
+                                                   static_cast<const MotionEvent&>(event)
+                                                           .getTransform());
+        }
         if (DEBUG_INJECTION) {
-            LOG(DEBUG) << "Injecting " << injectedEntries.front()->getDescription();
+            LOG(DEBUG) << "Injecting " << entry->getDescription();
         }
-        needWake |= enqueueInboundEventLocked(std::move(injectedEntries.front()));
+        needWake |= enqueueInboundEventLocked(std::move(entry));
         injectedEntries.pop();
     }
-
-    mLock.unlock();
-
-    if (needWake) {
-        mLooper->wake();
-    }
-
-    InputEventInjectionResult injectionResult;
-    { // acquire lock
-        std::unique_lock _l(mLock);
-
-        if (syncMode == InputEventInjectionSync::NONE) {
-            injectionResult = InputEventInjectionResult::SUCCEEDED;
-        } else {
-            for (;;) {
-                injectionResult = injectionState->injectionResult;
-                if (injectionResult != InputEventInjectionResult::PENDING) {
-                    break;
-                }
-
-                nsecs_t remainingTimeout = endTime - now();
-                if (remainingTimeout <= 0) {
-                    if (DEBUG_INJECTION) {
-                        ALOGD("injectInputEvent - Timed out waiting for injection result "
-                              "to become available.");
-                    }
-                    injectionResult = InputEventInjectionResult::TIMED_OUT;
-                    break;
-                }
-
-                mInjectionResultAvailable.wait_for(_l, std::chrono::nanoseconds(remainingTimeout));
-            }
-
-            if (injectionResult == InputEventInjectionResult::SUCCEEDED &&
-                syncMode == InputEventInjectionSync::WAIT_FOR_FINISHED) {
-                while (injectionState->pendingForegroundDispatches != 0) {
-                    if (DEBUG_INJECTION) {
-                        ALOGD("injectInputEvent - Waiting for %d pending foreground dispatches.",
-                              injectionState->pendingForegroundDispatches);
-                    }
-                    nsecs_t remainingTimeout = endTime - now();
-                    if (remainingTimeout <= 0) {
-                        if (DEBUG_INJECTION) {
-                            ALOGD("injectInputEvent - Timed out waiting for pending foreground "
-                                  "dispatches to finish.");
-                        }
-                        injectionResult = InputEventInjectionResult::TIMED_OUT;
-                        break;
-                    }
-
-                    mInjectionSyncFinished.wait_for(_l, std::chrono::nanoseconds(remainingTimeout));
-                }
-            }
-        }
-
-        injectionState->release();
-    } // release lock
-
-    if (DEBUG_INJECTION) {
-        LOG(DEBUG) << "injectInputEvent - Finished with result "
-                   << ftl::enum_string(injectionResult);
-    }
-
-    return injectionResult;
+    return needWake;
 }
 
 std::unique_ptr<VerifiedInputEvent> InputDispatcher::verifyInputEvent(const InputEvent& event) {
@@ -5177,6 +5316,25 @@ void InputDispatcher::setInputWindowsLocked(
 
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
 
+    // Index the windows of every display once. The checks below look up each old window, and
+    // doing that with getWindowHandleLocked() would scan all windows for each of them while
+    // holding the lock that event dispatch is waiting on.
+    std::unordered_multimap<int32_t /*id*/, const sp<WindowInfoHandle>*> currentHandlesById;
+    for (const auto& [_, handles] : mWindowHandlesByDisplay) {
+        for (const sp<WindowInfoHandle>& handle : handles) {
+            currentHandlesById.emplace(handle->getId(), &handle);
+        }
+    }
+    auto findCurrentHandle = [&](const sp<WindowInfoHandle>& windowHandle) -> sp<WindowInfoHandle> {
+        auto [begin, end] = currentHandlesById.equal_range(windowHandle->getId());
+        for (auto it = begin; it != end; ++it) {
+            if ((*it->second)->getToken() == windowHandle->getToken()) {
+                return *it->second;
+            }
+        }
+        return nullptr;
+    };
+
     std::optional<FocusResolver::FocusChanges> changes =
             mFocusResolver.setInputWindows(displayId, windowHandles);
     if (changes) {
@@ -5189,7 +5347,7 @@ void InputDispatcher::setInputWindowsLocked(
         TouchState& state = stateIt->second;
         for (size_t i = 0; i < state.windows.size();) {
             TouchedWindow& touchedWindow = state.windows[i];
-            if (getWindowHandleLocked(touchedWindow.windowHandle) == nullptr) {
+            if (findCurrentHandle(touchedWindow.windowHandle) == nullptr) {
                 if (DEBUG_FOCUS) {
                     ALOGD("Touched window was removed: %s in display %" PRId32,
                           touchedWindow.windowHandle->getName().c_str(), displayId);
@@ -5229,7 +5387,7 @@ void InputDispatcher::setInputWindowsLocked(
     // Determine if the orientation of any of the input windows have changed, and cancel all
     // pointer events if necessary.
     for (const sp<WindowInfoHandle>& oldWindowHandle : oldWindowHandles) {
-        const sp<WindowInfoHandle> newWindowHandle = getWindowHandleLocked(oldWindowHandle);
+        const sp<WindowInfoHandle> newWindowHandle = findCurrentHandle(oldWindowHandle);
         if (newWindowHandle != nullptr &&
             newWindowHandle->getInfo()->transform.getOrientation() !=
                     oldWindowOrientations[oldWindowHandle->getId()]) {
@@ -5248,7 +5406,7 @@ void InputDispatcher::setInputWindowsLocked(
     // Otherwise, they might stick around until the window handle is destroyed
     // which might not happen until the next GC.
     for (const sp<WindowInfoHandle>& oldWindowHandle : oldWindowHandles) {
-        if (getWindowHandleLocked(oldWindowHandle) == nullptr) {
+        if (findCurrentHandle(oldWindowHandle) == nullptr) {
             if (DEBUG_FOCUS) {
                 ALOGD("Window went away: %s", oldWindowHandle->getName().c_str());
             }
@@ -50,6 +50,7 @@
 #include <condition_variable>
 #include <deque>
 #include <optional>
+#include <queue>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -108,6 +109,10 @@ public:
             android::os::InputEventInjectionSync syncMode, std::chrono::milliseconds timeout,
             uint32_t policyFlags) override;
 
+    android::os::InputEventInjectionResult injectInputEvents(
+            const std::vector<const InputEvent*>& events, std::optional<int32_t> targetUid,
+            uint32_t policyFlags) override;
+
     std::unique_ptr<VerifiedInputEvent> verifyInputEvent(const InputEvent& event) override;
 
     void setInputWindows(
@@ -296,6 +301,15 @@ private:
     void transformMotionEntryForInjectionLocked(MotionEntry&,
                                                 const ui::Transform& injectedTransform) const
             REQUIRES(mLock);
+    // Applies the policy to an injected event and converts it to the entries to enqueue. Returns
+    // false if the event cannot be injected. Must be called without the lock held.
+    bool createInjectedEntries(const InputEvent& event, uint32_t policyFlags,
+                               std::queue<std::unique_ptr<EventEntry>>& outEntries);
+    // Transforms the entries created for an injected event and enqueues them. Returns true if
+    // mLooper->wake() should be called.
+    bool enqueueInjectedEntriesLocked(const InputEvent& event,
+                                      std::queue<std::unique_ptr<EventEntry>>& injectedEntries)
+            REQUIRES(mLock);
 
     std::condition_variable mInjectionSyncFinished;
     void incrementPendingForegroundDispatches(EventEntry& entry);
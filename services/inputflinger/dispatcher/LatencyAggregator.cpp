@@ -19,6 +19,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <android-base/stringprintf.h>
 #include <input/Input.h>
 #include <log/log.h>
@@ -121,10 +123,52 @@ AStatsManager_PullAtomCallbackReturn LatencyAggregator::pullAtomCallback(int32_t
 }
 
 void LatencyAggregator::processTimeline(const InputEventTimeline& timeline) {
+    processHistograms(timeline);
     processStatistics(timeline);
     processSlowEvent(timeline);
 }
 
+// Latency of each per-connection stage, indexed by SketchIndex. EVENT_TO_READ is common to all
+// connections and is left as 0.
+static std::array<nsecs_t, SketchIndex::SIZE> getConnectionLatencies(
+        const InputEventTimeline& timeline, const ConnectionTimeline& connectionTimeline) {
+    const nsecs_t gpuCompletedTime =
+            connectionTimeline.graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME];
+    const nsecs_t presentTime = connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+
+    std::array<nsecs_t, SketchIndex::SIZE> latencies{};
+    latencies[SketchIndex::READ_TO_DELIVER] = connectionTimeline.deliveryTime - timeline.readTime;
+    latencies[SketchIndex::DELIVER_TO_CONSUME] =
+            connectionTimeline.consumeTime - connectionTimeline.deliveryTime;
+    latencies[SketchIndex::CONSUME_TO_FINISH] =
+            connectionTimeline.finishTime - connectionTimeline.consumeTime;
+    latencies[SketchIndex::CONSUME_TO_GPU_COMPLETE] =
+            gpuCompletedTime - connectionTimeline.consumeTime;
+    latencies[SketchIndex::GPU_COMPLETE_TO_PRESENT] = presentTime - gpuCompletedTime;
+    latencies[SketchIndex::END_TO_END] = presentTime - timeline.eventTime;
+    return latencies;
+}
+
+static size_t getHistogramBucket(nsecs_t latency) {
+    const auto& bounds = LatencyAggregator::HISTOGRAM_BUCKET_BOUNDS;
+    return std::upper_bound(bounds.begin(), bounds.end(), latency) - bounds.begin();
+}
+
+void LatencyAggregator::processHistograms(const InputEventTimeline& timeline) {
+    const size_t eventToReadBucket = getHistogramBucket(timeline.readTime - timeline.eventTime);
+    mHistograms[SketchIndex::EVENT_TO_READ][eventToReadBucket]++;
+    for (const auto& [connectionToken, connectionTimeline] : timeline.connectionTimelines) {
+        if (!connectionTimeline.isComplete()) {
+            continue;
+        }
+        const std::array<nsecs_t, SketchIndex::SIZE> latencies =
+                getConnectionLatencies(timeline, connectionTimeline);
+        for (size_t i = SketchIndex::READ_TO_DELIVER; i < SketchIndex::SIZE; i++) {
+            mHistograms[i][getHistogramBucket(latencies[i])]++;
+        }
+    }
+}
+
 void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
     // Before we do any processing, check that we have not yet exceeded MAX_SIZE
     if (mNumSketchEventsProcessed >= MAX_EVENTS_FOR_STATISTICS) {
@@ -144,25 +188,11 @@ void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
         if (!connectionTimeline.isComplete()) {
             continue;
         }
-        const nsecs_t readToDeliver = connectionTimeline.deliveryTime - timeline.readTime;
-        const nsecs_t deliverToConsume =
-                connectionTimeline.consumeTime - connectionTimeline.deliveryTime;
-        const nsecs_t consumeToFinish =
-                connectionTimeline.finishTime - connectionTimeline.consumeTime;
-        const nsecs_t gpuCompletedTime =
-                connectionTimeline.graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME];
-        const nsecs_t presentTime =
-                connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
-        const nsecs_t consumeToGpuComplete = gpuCompletedTime - connectionTimeline.consumeTime;
-        const nsecs_t gpuCompleteToPresent = presentTime - gpuCompletedTime;
-        const nsecs_t endToEnd = presentTime - timeline.eventTime;
-
-        sketches[SketchIndex::READ_TO_DELIVER]->Add(ns2hus(readToDeliver));
-        sketches[SketchIndex::DELIVER_TO_CONSUME]->Add(ns2hus(deliverToConsume));
-        sketches[SketchIndex::CONSUME_TO_FINISH]->Add(ns2hus(consumeToFinish));
-        sketches[SketchIndex::CONSUME_TO_GPU_COMPLETE]->Add(ns2hus(consumeToGpuComplete));
-        sketches[SketchIndex::GPU_COMPLETE_TO_PRESENT]->Add(ns2hus(gpuCompleteToPresent));
-        sketches[SketchIndex::END_TO_END]->Add(ns2hus(endToEnd));
+        const std::array<nsecs_t, SketchIndex::SIZE> latencies =
+                getConnectionLatencies(timeline, connectionTimeline);
+        for (size_t i = SketchIndex::READ_TO_DELIVER; i < SketchIndex::SIZE; i++) {
+            sketches[i]->Add(ns2hus(latencies[i]));
+        }
     }
 }
 
@@ -271,7 +301,25 @@ std::string LatencyAggregator::dump(const char* prefix) const {
                              prefix, i, numDown, downBytesKb, i, numMove, moveBytesKb);
     }
 
-    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump +
+    static constexpr std::array<const char*, SketchIndex::SIZE> STAGE_NAMES = {
+            "EVENT_TO_READ",     "READ_TO_DELIVER",         "DELIVER_TO_CONSUME",
+            "CONSUME_TO_FINISH", "CONSUME_TO_GPU_COMPLETE", "GPU_COMPLETE_TO_PRESENT",
+            "END_TO_END",
+    };
+    std::string histogramDump = StringPrintf("%s  Histograms (bucket upper bounds in ms:", prefix);
+    for (nsecs_t bound : HISTOGRAM_BUCKET_BOUNDS) {
+        histogramDump += StringPrintf(" %.2f", bound * 1E-6);
+    }
+    histogramDump += ", inf):\n";
+    for (size_t i = 0; i < SketchIndex::SIZE; i++) {
+        histogramDump += StringPrintf("%s    %s:", prefix, STAGE_NAMES[i]);
+        for (size_t count : mHistograms[i]) {
+            histogramDump += StringPrintf(" %zu", count);
+        }
+        histogramDump += "\n";
+    }
+
+    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump + histogramDump +
             StringPrintf("%s  mNumSketchEventsProcessed=%zu\n", prefix, mNumSketchEventsProcessed) +
             StringPrintf("%s  mLastSlowEventTime=%" PRId64 "\n", prefix, mLastSlowEventTime) +
             StringPrintf("%s  mNumEventsSinceLastSlowEventReport = %zu\n", prefix,
@@ -20,6 +20,8 @@
 #include <statslog.h>
 #include <utils/Timers.h>
 
+#include <array>
+
 #include "InputEventTimeline.h"
 
 namespace android::inputdispatcher {
@@ -60,6 +62,16 @@ public:
 
     ~LatencyAggregator();
 
+    // Upper bounds of the latency histogram buckets. The last bucket holds everything slower.
+    static constexpr std::array<nsecs_t, 10> HISTOGRAM_BUCKET_BOUNDS = {
+            250'000, 500'000, 1'000'000, 2'000'000, 4'000'000, 8'000'000,
+            16'000'000, 32'000'000, 64'000'000, 128'000'000,
+    };
+    static constexpr size_t HISTOGRAM_BUCKET_COUNT = HISTOGRAM_BUCKET_BOUNDS.size() + 1;
+    using Histogram = std::array<size_t, HISTOGRAM_BUCKET_COUNT>;
+
+    const Histogram& getHistogram(SketchIndex stage) const { return mHistograms[stage]; }
+
 private:
     static AStatsManager_PullAtomCallbackReturn pullAtomCallback(int32_t atom_tag,
                                                                  AStatsEventList* data,
@@ -82,6 +94,12 @@ private:
             mMoveSketches;
     // How many events have been processed so far
     size_t mNumSketchEventsProcessed = 0;
+
+    // ---------- Histogram handling ----------
+    // Unlike the sketches, these are never capped or reset by a pull, so that dumpsys always
+    // shows the per-stage distribution since boot.
+    void processHistograms(const InputEventTimeline& timeline);
+    std::array<Histogram, SketchIndex::SIZE> mHistograms{};
 };
 
 } // namespace android::inputdispatcher
@@ -25,6 +25,11 @@
 
 namespace android {
 
+/* One sample of a batch delivered through notifySensorEvents. */
+struct SensorSample {
+    nsecs_t timestamp;
+    std::vector<float> values;
+};
 
 /*
  * Input dispatcher policy interface.
@@ -69,6 +74,15 @@ public:
     virtual void notifySensorEvent(int32_t deviceId, InputDeviceSensorType sensorType,
                                    InputDeviceSensorAccuracy accuracy, nsecs_t timestamp,
                                    const std::vector<float>& values) = 0;
+    /* Notifies the system of several consecutive samples from one sensor, oldest first, so that
+     * high rate sensors don't need a round trip per sample. */
+    virtual void notifySensorEvents(int32_t deviceId, InputDeviceSensorType sensorType,
+                                    InputDeviceSensorAccuracy accuracy,
+                                    const std::vector<SensorSample>& samples) {
+        for (const SensorSample& sample : samples) {
+            notifySensorEvent(deviceId, sensorType, accuracy, sample.timestamp, sample.values);
+        }
+    }
     virtual void notifySensorAccuracy(int32_t deviceId, InputDeviceSensorType sensorType,
                                       InputDeviceSensorAccuracy accuracy) = 0;
     virtual void notifyVibratorState(int32_t deviceId, bool isOn) = 0;
@@ -69,6 +69,10 @@ public:
     void notifyVibratorState(const NotifyVibratorStateArgs& args) override;
     void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs& args) override;
 
+    using InputListenerInterface::notify;
+    // Queue args that the caller no longer needs without copying them.
+    void notify(NotifyArgs&& args);
+
     void flush();
 
 private:
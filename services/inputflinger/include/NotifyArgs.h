@@ -36,7 +36,9 @@ struct NotifyInputDevicesChangedArgs {
     bool operator==(const NotifyInputDevicesChangedArgs& rhs) const = default;
 
     NotifyInputDevicesChangedArgs(const NotifyInputDevicesChangedArgs& other) = default;
+    NotifyInputDevicesChangedArgs(NotifyInputDevicesChangedArgs&& other) = default;
     NotifyInputDevicesChangedArgs& operator=(const NotifyInputDevicesChangedArgs&) = default;
+    NotifyInputDevicesChangedArgs& operator=(NotifyInputDevicesChangedArgs&&) = default;
 };
 
 /* Describes a configuration change event. */
@@ -132,7 +134,9 @@ struct NotifyMotionArgs {
                      const std::vector<TouchVideoFrame>& videoFrames);
 
     NotifyMotionArgs(const NotifyMotionArgs& other);
+    NotifyMotionArgs(NotifyMotionArgs&& other);
     NotifyMotionArgs& operator=(const android::NotifyMotionArgs&) = default;
+    NotifyMotionArgs& operator=(android::NotifyMotionArgs&&) = default;
 
     bool operator==(const NotifyMotionArgs& rhs) const;
 
@@ -1751,7 +1751,10 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
 
     std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
 
+    // The loop below stops once about EVENT_BUFFER_SIZE events are collected. Reserve that up
+    // front so that a burst from a high rate device does not regrow the vector several times.
     std::vector<RawEvent> events;
+    events.reserve(EVENT_BUFFER_SIZE);
     bool awoken = false;
     for (;;) {
         nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
@@ -1911,13 +1914,15 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                     ALOGE("could not get event (wrong size: %d)", readSize);
                 } else {
                     const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
+                    // Every event in the buffer came out of the same read().
+                    const nsecs_t readTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
                     const size_t count = size_t(readSize) / sizeof(struct input_event);
                     for (size_t i = 0; i < count; i++) {
                         struct input_event& iev = readBuffer[i];
                         events.push_back({
                                 .when = processEventTimestamp(iev),
-                                .readTime = systemTime(SYSTEM_TIME_MONOTONIC),
+                                .readTime = readTime,
                                 .deviceId = deviceId,
                                 .type = iev.type,
                                 .code = iev.code,
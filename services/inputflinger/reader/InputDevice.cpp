@@ -140,6 +140,15 @@ void InputDevice::dump(std::string& dump, const std::string& eventHubDevStr) {
         }
     }
 
+    if (mProcessingStats.batchCount > 0) {
+        dump += StringPrintf(INDENT2 "ProcessingTime: batches=%zu, events=%zu, avg=%0.3fms, "
+                                     "max=%0.3fms\n",
+                             mProcessingStats.batchCount, mProcessingStats.eventCount,
+                             mProcessingStats.totalDuration * 0.000001f /
+                                     mProcessingStats.batchCount,
+                             mProcessingStats.maxBatchDuration * 0.000001f);
+    }
+
     for_each_mapper([&dump](InputMapper& mapper) { mapper.dump(dump); });
     if (mController) {
         mController->dump(dump);
@@ -347,6 +356,12 @@ std::list<NotifyArgs> InputDevice::process(const RawEvent* rawEvents, size_t cou
     // have side-effects that must be interleaved.  For example, joystick movement events and
     // gamepad button presses are handled by different mappers but they should be dispatched
     // in the order received.
+    const nsecs_t startTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    const size_t eventCount = count;
+    // The reader hands over events one subdevice at a time, so the mapper lookup is normally
+    // done once per batch rather than once per event.
+    int32_t mappersEventHubId = 0;
+    MapperVector* mappers = nullptr;
     std::list<NotifyArgs> out;
     for (const RawEvent* rawEvent = rawEvents; count != 0; rawEvent++) {
         if (debugRawEvents()) {
@@ -370,12 +385,25 @@ std::list<NotifyArgs> InputDevice::process(const RawEvent* rawEvents, size_t cou
             mDropUntilNextSync = true;
             out += reset(rawEvent->when);
         } else {
-            for_each_mapper_in_subdevice(rawEvent->deviceId, [&](InputMapper& mapper) {
-                out += mapper.process(rawEvent);
-            });
+            if (mappers == nullptr || mappersEventHubId != rawEvent->deviceId) {
+                auto deviceIt = mDevices.find(rawEvent->deviceId);
+                mappersEventHubId = rawEvent->deviceId;
+                mappers = deviceIt != mDevices.end() ? &deviceIt->second.second : nullptr;
+            }
+            if (mappers != nullptr) {
+                for (auto& mapperPtr : *mappers) {
+                    out += mapperPtr->process(rawEvent);
+                }
+            }
         }
         --count;
     }
+
+    const nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - startTime;
+    mProcessingStats.batchCount++;
+    mProcessingStats.eventCount += eventCount;
+    mProcessingStats.totalDuration += duration;
+    mProcessingStats.maxBatchDuration = std::max(mProcessingStats.maxBatchDuration, duration);
     return out;
 }
 
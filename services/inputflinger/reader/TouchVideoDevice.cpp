@@ -202,9 +202,11 @@ std::optional<TouchVideoFrame> TouchVideoDevice::readFrame() {
               static_cast<long long>(buf.timestamp.tv_sec),
               static_cast<long long>(buf.timestamp.tv_usec));
     }
-    std::vector<int16_t> data(mHeight * mWidth);
+    // The mmap'd buffer is handed back to the driver right away so that it never runs out of
+    // buffers to capture into, so this is the only copy of the heatmap. The frame shares it with
+    // every copy made further down the pipeline.
     const int16_t* readFrom = mReadLocations[buf.index];
-    std::copy(readFrom, readFrom + mHeight * mWidth, data.begin());
+    std::vector<int16_t> data(readFrom, readFrom + mHeight * mWidth);
     TouchVideoFrame frame(mHeight, mWidth, std::move(data), buf.timestamp);
 
     result = ioctl(mFd.get(), VIDIOC_QBUF, &buf);
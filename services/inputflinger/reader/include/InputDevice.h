@@ -199,6 +199,16 @@ private:
     bool mHasMic;
     bool mDropUntilNextSync;
 
+    // Time spent in process(), so that a device whose mappers hold up the reader thread (and
+    // with it every other device) shows up in dumpsys.
+    struct ProcessingStats {
+        size_t batchCount = 0;
+        size_t eventCount = 0;
+        nsecs_t totalDuration = 0;
+        nsecs_t maxBatchDuration = 0;
+    };
+    ProcessingStats mProcessingStats;
+
     typedef int32_t (InputMapper::*GetStateFunc)(uint32_t sourceMask, int32_t code);
     int32_t getState(uint32_t sourceMask, int32_t code, GetStateFunc getStateFunc);
 
@@ -318,6 +318,11 @@ void SensorInputMapper::flushSensor(InputDeviceSensorType sensorType) {
     }
     auto& sensor = it->second;
     sensor.lastSampleTimeNs = 0;
+    if (sensor.batchDeadline) {
+        // Deliver the pending batch from the next loop of the reader.
+        sensor.batchDeadline = systemTime(SYSTEM_TIME_MONOTONIC);
+        getContext()->requestTimeoutAtTime(*sensor.batchDeadline);
+    }
     for (size_t i = 0; i < SENSOR_VEC_LEN; i++) {
         int32_t abs = sensor.dataVec[i];
         auto itAxis = mAxes.find(abs);
@@ -403,12 +408,13 @@ std::list<NotifyArgs> SensorInputMapper::sync(nsecs_t when, bool force) {
             // Convert to Android unit
             convertFromLinuxToAndroid(values, sensorType);
             // Notify dispatcher for sensor event
-            out.push_back(NotifySensorArgs(getContext()->getNextId(), when, getDeviceId(),
-                                           AINPUT_SOURCE_SENSOR, sensorType,
-                                           sensor.sensorInfo.accuracy,
-                                           /*accuracyChanged=*/sensor.accuracy !=
-                                                   sensor.sensorInfo.accuracy,
-                                           /*hwTimestamp=*/timestamp, values));
+            out += reportSample(when, sensor,
+                                NotifySensorArgs(getContext()->getNextId(), when, getDeviceId(),
+                                                 AINPUT_SOURCE_SENSOR, sensorType,
+                                                 sensor.sensorInfo.accuracy,
+                                                 /*accuracyChanged=*/sensor.accuracy !=
+                                                         sensor.sensorInfo.accuracy,
+                                                 /*hwTimestamp=*/timestamp, values));
             sensor.lastSampleTimeNs = timestamp;
             sensor.accuracy = sensor.sensorInfo.accuracy;
         }
@@ -416,4 +422,34 @@ std::list<NotifyArgs> SensorInputMapper::sync(nsecs_t when, bool force) {
     return out;
 }
 
+std::list<NotifyArgs> SensorInputMapper::reportSample(nsecs_t when, Sensor& sensor,
+                                                      NotifySensorArgs args) {
+    if (sensor.maxBatchReportLatency.count() <= 0) {
+        return {std::move(args)};
+    }
+    sensor.pendingSamples.push_back(std::move(args));
+    if (!sensor.batchDeadline) {
+        sensor.batchDeadline = when + sensor.maxBatchReportLatency.count();
+        getContext()->requestTimeoutAtTime(*sensor.batchDeadline);
+    }
+    if (when < *sensor.batchDeadline) {
+        return {};
+    }
+    sensor.batchDeadline = std::nullopt;
+    std::list<NotifyArgs> out;
+    out.splice(out.end(), sensor.pendingSamples);
+    return out;
+}
+
+std::list<NotifyArgs> SensorInputMapper::timeoutExpired(nsecs_t when) {
+    std::list<NotifyArgs> out;
+    for (auto& [_, sensor] : mSensors) {
+        if (sensor.batchDeadline && when >= *sensor.batchDeadline) {
+            sensor.batchDeadline = std::nullopt;
+            out.splice(out.end(), sensor.pendingSamples);
+        }
+    }
+    return out;
+}
+
 } // namespace android
@@ -41,6 +41,7 @@ public:
                                                     ConfigurationChanges changes) override;
     [[nodiscard]] std::list<NotifyArgs> reset(nsecs_t when) override;
     [[nodiscard]] std::list<NotifyArgs> process(const RawEvent* rawEvent) override;
+    [[nodiscard]] std::list<NotifyArgs> timeoutExpired(nsecs_t when) override;
     bool enableSensor(InputDeviceSensorType sensorType, std::chrono::microseconds samplingPeriod,
                       std::chrono::microseconds maxBatchReportLatency) override;
     void disableSensor(InputDeviceSensorType sensorType) override;
@@ -99,12 +100,17 @@ private:
         InputDeviceSensorInfo sensorInfo;
         // Sensor X, Y, Z data mapping to abs
         std::array<int32_t, SENSOR_VEC_LEN> dataVec;
+        // Samples held back while batching, until the batch deadline passes.
+        std::list<NotifyArgs> pendingSamples;
+        std::optional<nsecs_t> batchDeadline;
         void resetValue() {
             this->enabled = false;
             this->accuracy = InputDeviceSensorAccuracy::ACCURACY_NONE;
             this->samplingPeriod = std::chrono::nanoseconds(0);
             this->maxBatchReportLatency = std::chrono::nanoseconds(0);
             this->lastSampleTimeNs = std::nullopt;
+            this->pendingSamples.clear();
+            this->batchDeadline = std::nullopt;
         }
     };
 
@@ -128,6 +134,9 @@ private:
     std::unordered_map<InputDeviceSensorType, Sensor> mSensors;
 
     [[nodiscard]] std::list<NotifyArgs> sync(nsecs_t when, bool force);
+    // Holds the sample back if the sensor is batching, and returns the batch once it is due.
+    [[nodiscard]] std::list<NotifyArgs> reportSample(nsecs_t when, Sensor& sensor,
+                                                     NotifySensorArgs args);
 
     void parseSensorConfiguration(InputDeviceSensorType sensorType, int32_t absCode,
                                   int32_t sensorDataIndex, const Axis& axis);
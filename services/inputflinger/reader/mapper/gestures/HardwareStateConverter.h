@@ -16,8 +16,8 @@
 
 #pragma once
 
-#include <optional>
 #include <set>
+#include <vector>
 
 #include <utils/Timers.h>
 
@@ -44,17 +44,23 @@ public:
     HardwareStateConverter(const InputDeviceContext& deviceContext,
                            MultiTouchMotionAccumulator& motionAccumulator);
 
-    std::optional<SelfContainedHardwareState> processRawEvent(const RawEvent* event);
+    // Returns the new HardwareState when the event completes a sync, or nullptr otherwise. The
+    // returned state is owned by the converter and is only valid until the next call.
+    SelfContainedHardwareState* processRawEvent(const RawEvent* event);
     void reset();
 
 private:
-    SelfContainedHardwareState produceHardwareState(nsecs_t when);
+    void produceHardwareState(nsecs_t when);
 
     const InputDeviceContext& mDeviceContext;
     CursorButtonAccumulator mCursorButtonAccumulator;
     MultiTouchMotionAccumulator& mMotionAccumulator;
     TouchButtonAccumulator mTouchButtonAccumulator;
     int32_t mMscTimestamp = 0;
+
+    // Reused for every sync so that the FingerStates are not reallocated at the touchpad's report
+    // rate.
+    SelfContainedHardwareState mState;
 };
 
 } // namespace android
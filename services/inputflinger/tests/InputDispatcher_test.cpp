@@ -3659,6 +3659,43 @@ TEST_F(InputDispatcherTest, TouchDownAfterMouseHover) {
     window->consumeMotionEvent(AllOf(WithMotionAction(ACTION_DOWN), WithDeviceId(touchDeviceId)));
 }
 
+/**
+ * When a window stops reading events, hover moves that could not be sent to it yet should be
+ * replaced by the newer ones instead of piling up. Once the window reads again, it should get the
+ * latest location, and fewer samples than were sent.
+ */
+TEST_F(InputDispatcherTest, QueuedHoverMovesAreReplacedByNewerOnes) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, mDispatcher, "Window", ADISPLAY_ID_DEFAULT);
+    window->setFrame(Rect(0, 0, 1000, 1000));
+
+    mDispatcher->setInputWindows({{ADISPLAY_ID_DEFAULT, {window}}});
+
+    // Send enough moves to fill the socket, so that the rest stay in the outbound queue.
+    constexpr int32_t MOVE_COUNT = 500;
+    for (int32_t i = 0; i < MOVE_COUNT; i++) {
+        NotifyMotionArgs motionArgs =
+                generateMotionArgs(AMOTION_EVENT_ACTION_HOVER_MOVE, AINPUT_SOURCE_MOUSE,
+                                   ADISPLAY_ID_DEFAULT, {PointF{float(i), 50}});
+        motionArgs.xCursorPosition = i;
+        motionArgs.yCursorPosition = 50;
+        mDispatcher->notifyMotion(motionArgs);
+    }
+    ASSERT_TRUE(mDispatcher->waitForIdle());
+
+    size_t sampleCount = 0;
+    float lastX = -1;
+    while (InputEvent* event = window->consume()) {
+        ASSERT_EQ(InputEventType::MOTION, event->getType());
+        const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+        sampleCount += motionEvent.getHistorySize() + 1;
+        lastX = motionEvent.getX(0);
+    }
+    EXPECT_LT(sampleCount, size_t(MOVE_COUNT));
+    EXPECT_EQ(MOVE_COUNT - 1, lastX);
+}
+
 /**
  * Inject a mouse hover event followed by a tap from touchscreen.
  * The tap causes a HOVER_EXIT event to be generated because the current event
@@ -4859,6 +4896,44 @@ TEST_F(InputDispatcherTest, FocusedWindow_ReceivesFocusEventAndKeyEvent) {
     mFakePolicy->assertUserActivityPoked();
 }
 
+TEST_F(InputDispatcherTest, FocusedWindow_ReceivesBatchInjectedKeyEvents) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window = sp<FakeWindowHandle>::make(application, mDispatcher,
+                                                             "Fake Window", ADISPLAY_ID_DEFAULT);
+
+    window->setFocusable(true);
+    mDispatcher->setInputWindows({{ADISPLAY_ID_DEFAULT, {window}}});
+    setFocusedWindow(window);
+
+    window->consumeFocusEvent(true);
+
+    const nsecs_t currentTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    KeyEvent down;
+    down.initialize(InputEvent::nextId(), DEVICE_ID, AINPUT_SOURCE_KEYBOARD, ADISPLAY_ID_NONE,
+                    INVALID_HMAC, AKEY_EVENT_ACTION_DOWN, /*flags=*/0, AKEYCODE_A, KEY_A,
+                    AMETA_NONE, /*repeatCount=*/0, currentTime, currentTime);
+    KeyEvent up;
+    up.initialize(InputEvent::nextId(), DEVICE_ID, AINPUT_SOURCE_KEYBOARD, ADISPLAY_ID_NONE,
+                  INVALID_HMAC, AKEY_EVENT_ACTION_UP, /*flags=*/0, AKEYCODE_A, KEY_A, AMETA_NONE,
+                  /*repeatCount=*/0, currentTime, currentTime);
+    KeyEvent invalid;
+    invalid.initialize(InputEvent::nextId(), DEVICE_ID, AINPUT_SOURCE_KEYBOARD, ADISPLAY_ID_NONE,
+                       INVALID_HMAC, /*action=*/-1, /*flags=*/0, AKEYCODE_A, KEY_A, AMETA_NONE,
+                       /*repeatCount=*/0, currentTime, currentTime);
+
+    // A batch with an invalid event is rejected as a whole.
+    ASSERT_EQ(InputEventInjectionResult::FAILED,
+              mDispatcher->injectInputEvents({&down, &invalid}, /*targetUid=*/{},
+                                             DEFAULT_POLICY_FLAGS));
+    window->assertNoEvents();
+
+    ASSERT_EQ(InputEventInjectionResult::SUCCEEDED,
+              mDispatcher->injectInputEvents({&down, &up}, /*targetUid=*/{},
+                                             DEFAULT_POLICY_FLAGS));
+    window->consumeKeyDown(ADISPLAY_ID_DEFAULT);
+    window->consumeKeyUp(ADISPLAY_ID_DEFAULT);
+}
+
 TEST_F(InputDispatcherTest, FocusedWindow_DisableUserActivity) {
     std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
     sp<FakeWindowHandle> window = sp<FakeWindowHandle>::make(application, mDispatcher,
@@ -2849,6 +2849,39 @@ TEST_F(SensorInputMapperTest, ProcessGyroscopeSensor) {
     mapper.flushSensor(InputDeviceSensorType::GYROSCOPE);
 }
 
+TEST_F(SensorInputMapperTest, BatchesSamplesUntilMaxReportLatency) {
+    setAccelProperties();
+    prepareAccelAxes();
+    SensorInputMapper& mapper = constructAndAddMapper<SensorInputMapper>();
+
+    constexpr nsecs_t SAMPLE_INTERVAL = ms2ns(10);
+    ASSERT_TRUE(mapper.enableSensor(InputDeviceSensorType::ACCELEROMETER,
+                                    std::chrono::microseconds(10000),
+                                    std::chrono::microseconds(25000)));
+    nsecs_t when = ARBITRARY_TIME;
+    for (int i = 0; i < 2; i++) {
+        process(mapper, when, READ_TIME, EV_ABS, ABS_X, 20000 + i);
+        process(mapper, when, READ_TIME, EV_MSC, MSC_TIMESTAMP, 10000 * (i + 1));
+        process(mapper, when, READ_TIME, EV_SYN, SYN_REPORT, 0);
+        when += SAMPLE_INTERVAL;
+    }
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifySensorWasNotCalled());
+    ASSERT_NO_FATAL_FAILURE(
+            mReader->getContext()->assertTimeoutWasRequested(ARBITRARY_TIME + ms2ns(25)));
+
+    // The whole batch is delivered, in order, once the oldest sample has waited long enough.
+    std::list<NotifyArgs> args = handleTimeout(mapper, ARBITRARY_TIME + ms2ns(25));
+    ASSERT_EQ(2u, args.size());
+    NotifySensorArgs first;
+    NotifySensorArgs second;
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifySensorWasCalled(&first));
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifySensorWasCalled(&second));
+    ASSERT_LT(first.hwTimestamp, second.hwTimestamp);
+    ASSERT_EQ(20000.0f / ACCEL_RAW_RESOLUTION * GRAVITY_MS2_UNIT, first.values[0]);
+    ASSERT_EQ(20001.0f / ACCEL_RAW_RESOLUTION * GRAVITY_MS2_UNIT, second.values[0]);
+    ASSERT_TRUE(handleTimeout(mapper, ARBITRARY_TIME + ms2ns(50)).empty());
+}
+
 // --- KeyboardInputMapperTest ---
 
 class KeyboardInputMapperTest : public InputMapperTest {
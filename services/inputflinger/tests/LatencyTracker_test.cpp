@@ -15,6 +15,7 @@
  */
 
 #include "../dispatcher/LatencyTracker.h"
+#include "../dispatcher/LatencyAggregator.h"
 
 #include <android-base/properties.h>
 #include <binder/Binder.h>
@@ -22,6 +23,8 @@
 #include <inttypes.h>
 #include <log/log.h>
 
+#include <numeric>
+
 #define TAG "LatencyTracker_test"
 
 using android::base::HwTimeoutMultiplier;
@@ -295,4 +298,26 @@ TEST_F(LatencyTrackerTest, EventsAreTracked_WhenTrackListenerIsCalledFirst) {
             InputEventTimeline{expected.isDown, expected.eventTime, expected.readTime});
 }
 
+// --- LatencyAggregatorTest ---
+
+TEST(LatencyAggregatorTest, HistogramsCountEveryCompleteTimeline) {
+    LatencyAggregator aggregator;
+    aggregator.processTimeline(getTestTimeline());
+
+    InputEventTimeline slowRead = getTestTimeline();
+    slowRead.readTime = slowRead.eventTime + 3'000'000; // falls in the (2ms, 4ms] bucket
+    slowRead.connectionTimelines.clear();
+    aggregator.processTimeline(slowRead);
+
+    const LatencyAggregator::Histogram& eventToRead =
+            aggregator.getHistogram(SketchIndex::EVENT_TO_READ);
+    EXPECT_EQ(1u, eventToRead[0]);
+    EXPECT_EQ(1u, eventToRead[4]);
+
+    // Only the complete connection timeline contributes to the per-connection stages.
+    const LatencyAggregator::Histogram& endToEnd = aggregator.getHistogram(SketchIndex::END_TO_END);
+    EXPECT_EQ(1u, endToEnd[0]);
+    EXPECT_EQ(1u, std::accumulate(endToEnd.begin(), endToEnd.end(), size_t(0)));
+}
+
 } // namespace android::inputdispatcher
@@ -109,6 +109,11 @@ void TestInputListener::assertNotifySensorWasCalled(NotifySensorArgs* outEventAr
                                            "Expected notifySensor() to have been called."));
 }
 
+void TestInputListener::assertNotifySensorWasNotCalled() {
+    ASSERT_NO_FATAL_FAILURE(
+            assertNotCalled<NotifySensorArgs>("notifySensor() should not be called."));
+}
+
 void TestInputListener::assertNotifyVibratorStateWasCalled(NotifyVibratorStateArgs* outEventArgs) {
     ASSERT_NO_FATAL_FAILURE(assertCalled<NotifyVibratorStateArgs>(outEventArgs,
                                                                   "Expected notifyVibratorState() "
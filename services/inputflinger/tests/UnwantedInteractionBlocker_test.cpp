@@ -1094,4 +1094,66 @@ TEST_F(PalmRejectorFakeFilterTest, CancelTwoPointers) {
     ASSERT_EQ(CANCEL, argsList[0].action);
 }
 
+/**
+ * A PalmDetectionFilter that suppresses all touches, but only once it is released. Until then, it
+ * blocks like a slow model would.
+ */
+class BlockingFilter : public ::ui::PalmDetectionFilter {
+public:
+    explicit BlockingFilter(::ui::SharedPalmDetectionFilterState* state)
+          : ::ui::PalmDetectionFilter(state) {}
+
+    void Filter(const std::vector<::ui::InProgressTouchEvdev>& touches, ::base::TimeTicks time,
+                std::bitset<::ui::kNumTouchEvdevSlots>* slots_to_hold,
+                std::bitset<::ui::kNumTouchEvdevSlots>* slots_to_suppress) override {
+        std::unique_lock lock(mLock);
+        mReleasedCondition.wait(lock, [this] { return mReleased; });
+        for (const ::ui::InProgressTouchEvdev& touch : touches) {
+            slots_to_suppress->set(touch.slot, true);
+        }
+    }
+
+    std::string FilterNameForTesting() const override { return "blocking filter"; }
+
+    void release() {
+        std::scoped_lock lock(mLock);
+        mReleased = true;
+        mReleasedCondition.notify_all();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mReleasedCondition;
+    bool mReleased = false;
+};
+
+/**
+ * In the asynchronous mode, events are sent before the model classifies them. A pointer that is
+ * classified as palm is canceled later, at the latest when it goes up.
+ */
+TEST(AsyncPalmRejectorTest, EventsAreNotDelayedByTheModel) {
+    ::ui::SharedPalmDetectionFilterState sharedPalmState;
+    auto filter = std::make_unique<BlockingFilter>(&sharedPalmState);
+    BlockingFilter& filterRef = *filter;
+    PalmRejector palmRejector(generatePalmFilterDeviceInfo(), std::move(filter),
+                              /*asyncLookahead=*/3);
+
+    constexpr nsecs_t downTime = 0;
+    std::vector<NotifyMotionArgs> argsList =
+            palmRejector.processMotion(generateMotionArgs(downTime, downTime, DOWN, {{1, 2, 3}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(DOWN, argsList[0].action);
+
+    argsList = palmRejector.processMotion(generateMotionArgs(downTime, 1, MOVE, {{4, 5, 6}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(MOVE, argsList[0].action);
+
+    // The pointer is classified as palm before it goes up, so the gesture is canceled.
+    filterRef.release();
+    argsList = palmRejector.processMotion(generateMotionArgs(downTime, 2, UP, {{7, 8, 9}}));
+    ASSERT_EQ(1u, argsList.size());
+    ASSERT_EQ(CANCEL, argsList[0].action);
+    ASSERT_EQ(FLAG_CANCELED, argsList[0].flags);
+}
+
 } // namespace android
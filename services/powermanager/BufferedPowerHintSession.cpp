@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *                        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "BufferedPowerHintSession"
+#include <powermanager/BufferedPowerHintSession.h>
+#include <utils/Log.h>
+
+#include <iterator>
+
+using namespace android::hardware::power;
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+void BufferedPowerHintSession::setSession(sp<IPowerHintSession> session,
+                                          int64_t targetDurationNanos) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSession = std::move(session);
+    mSentTargetDurationNanos = targetDurationNanos;
+}
+
+void BufferedPowerHintSession::addWorkDuration(const WorkDuration& duration) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mWorkDurations.push_back(duration);
+}
+
+void BufferedPowerHintSession::addWorkDuration(int64_t durationNanos, int64_t timeStampNanos) {
+    WorkDuration duration;
+    duration.durationNanos = durationNanos;
+    duration.timeStampNanos = timeStampNanos;
+    addWorkDuration(duration);
+}
+
+void BufferedPowerHintSession::updateTargetWorkDuration(int64_t targetDurationNanos) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTargetDurationNanos = targetDurationNanos;
+}
+
+HalResult<void> BufferedPowerHintSession::flush() {
+    std::lock_guard<std::mutex> flushLock(mFlushMutex);
+
+    sp<IPowerHintSession> session;
+    std::optional<int64_t> targetDurationNanos;
+    std::vector<WorkDuration> workDurations;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mSession == nullptr) {
+            return HalResult<void>::unsupported();
+        }
+        session = mSession;
+        if (mTargetDurationNanos != mSentTargetDurationNanos) {
+            targetDurationNanos = mTargetDurationNanos;
+        }
+        workDurations.swap(mWorkDurations);
+    }
+
+    // The binder calls are made without holding mMutex, so reporting threads never wait for them.
+    if (targetDurationNanos) {
+        auto ret = session->updateTargetWorkDuration(*targetDurationNanos);
+        if (!ret.isOk()) {
+            ALOGW("Failed to set power hint target work duration with error: %s",
+                  ret.exceptionMessage().c_str());
+            restoreWorkDurations(std::move(workDurations));
+            return HalResult<void>::fromStatus(ret);
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSentTargetDurationNanos = targetDurationNanos;
+    }
+
+    if (!workDurations.empty()) {
+        auto ret = session->reportActualWorkDuration(workDurations);
+        if (!ret.isOk()) {
+            ALOGW("Failed to report actual work durations with error: %s",
+                  ret.exceptionMessage().c_str());
+            restoreWorkDurations(std::move(workDurations));
+            return HalResult<void>::fromStatus(ret);
+        }
+    }
+
+    return HalResult<void>::ok();
+}
+
+void BufferedPowerHintSession::restoreWorkDurations(std::vector<WorkDuration>&& workDurations) {
+    // Samples added during the failed flush are newer, so they go after the restored ones.
+    std::lock_guard<std::mutex> lock(mMutex);
+    mWorkDurations.insert(mWorkDurations.begin(), std::make_move_iterator(workDurations.begin()),
+                          std::make_move_iterator(workDurations.end()));
+}
+
+size_t BufferedPowerHintSession::getBufferedWorkDurationCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWorkDurations.size();
+}
+
+} // namespace power
+
+} // namespace android
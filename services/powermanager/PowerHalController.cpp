@@ -22,8 +22,12 @@
 #include <android/hardware/power/Mode.h>
 #include <powermanager/PowerHalController.h>
 #include <powermanager/PowerHalLoader.h>
+#include <pthread.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace android::hardware::power;
 
 namespace android {
@@ -58,6 +62,19 @@ void HalConnector::reset() {
 
 // -------------------------------------------------------------------------------------------------
 
+PowerHalController::~PowerHalController() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(mAsyncMutex);
+        mAsyncStopping = true;
+        thread = std::move(mAsyncThread);
+    }
+    mAsyncCondition.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
 void PowerHalController::init() {
     initHal();
 }
@@ -76,6 +93,11 @@ std::shared_ptr<HalWrapper> PowerHalController::initHal() {
     return mConnectedHal;
 }
 
+uint64_t PowerHalController::getConnectedHalGeneration() {
+    std::lock_guard<std::mutex> lock(mConnectedHalMutex);
+    return mConnectedHalGeneration;
+}
+
 // Check if a call to Power HAL function failed; if so, log the failure and
 // invalidate the current Power HAL handle.
 template <typename T>
@@ -84,7 +106,10 @@ HalResult<T> PowerHalController::processHalResult(HalResult<T> result, const cha
         ALOGE("%s failed: %s", fnName, result.errorMessage());
         std::lock_guard<std::mutex> lock(mConnectedHalMutex);
         // Drop Power HAL handle. This will force future api calls to reconnect.
-        mConnectedHal = nullptr;
+        if (mConnectedHal != nullptr) {
+            mConnectedHal = nullptr;
+            mConnectedHalGeneration++;
+        }
         mHalConnector->reset();
     }
     return result;
@@ -97,6 +122,11 @@ HalResult<void> PowerHalController::setBoost(Boost boost, int32_t durationMs) {
 }
 
 HalResult<void> PowerHalController::setMode(Mode mode, bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(mAsyncMutex);
+        mSentModes.erase(mode);
+        mSyncModeCount++;
+    }
     std::shared_ptr<HalWrapper> handle = initHal();
     auto result = handle->setMode(mode, enabled);
     return processHalResult(result, "setMode");
@@ -115,6 +145,95 @@ HalResult<int64_t> PowerHalController::getHintSessionPreferredRate() {
     return processHalResult(result, "getHintSessionPreferredRate");
 }
 
+void PowerHalController::setBoostAsync(Boost boost, int32_t durationMs) {
+    {
+        std::lock_guard<std::mutex> lock(mAsyncMutex);
+        auto [it, inserted] = mPendingBoosts.try_emplace(boost, durationMs);
+        if (!inserted) {
+            it->second = std::max(it->second, durationMs);
+        }
+        startAsyncThreadLocked();
+    }
+    mAsyncCondition.notify_one();
+}
+
+void PowerHalController::setModeAsync(Mode mode, bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(mAsyncMutex);
+        mPendingModes.insert_or_assign(mode, enabled);
+        startAsyncThreadLocked();
+    }
+    mAsyncCondition.notify_one();
+}
+
+void PowerHalController::flushAsync() {
+    std::unique_lock<std::mutex> lock(mAsyncMutex);
+    mAsyncFlushedCondition.wait(lock, [this]() REQUIRES(mAsyncMutex) {
+        return !mAsyncBusy && mPendingBoosts.empty() && mPendingModes.empty();
+    });
+}
+
+void PowerHalController::startAsyncThreadLocked() {
+    if (!mAsyncThread.joinable()) {
+        mAsyncThread = std::thread(&PowerHalController::asyncThreadMain, this);
+        pthread_setname_np(mAsyncThread.native_handle(), "PowerHalAsync");
+    }
+}
+
+void PowerHalController::asyncThreadMain() {
+    std::unique_lock<std::mutex> lock(mAsyncMutex);
+    while (true) {
+        mAsyncCondition.wait(lock, [this]() REQUIRES(mAsyncMutex) {
+            return mAsyncStopping || !mPendingBoosts.empty() || !mPendingModes.empty();
+        });
+        // Send pending requests before stopping, since callers never learn whether they were.
+        if (mPendingBoosts.empty() && mPendingModes.empty()) {
+            break;
+        }
+
+        auto boosts = std::exchange(mPendingBoosts, {});
+        auto modes = std::exchange(mPendingModes, {});
+        const uint64_t halGeneration = getConnectedHalGeneration();
+        if (mSentModesHalGeneration != halGeneration) {
+            // The modes were sent to a HAL that is gone.
+            mSentModes.clear();
+            mSentModesHalGeneration = halGeneration;
+        }
+        for (auto it = modes.begin(); it != modes.end();) {
+            const auto sent = mSentModes.find(it->first);
+            it = sent != mSentModes.end() && sent->second == it->second ? modes.erase(it)
+                                                                         : std::next(it);
+        }
+        const uint64_t syncModeCount = mSyncModeCount;
+        mAsyncBusy = true;
+        lock.unlock();
+
+        for (const auto& [boost, durationMs] : boosts) {
+            processHalResult(initHal()->setBoost(boost, durationMs), "setBoostAsync");
+        }
+        std::map<Mode, bool> sentModes;
+        for (const auto& [mode, enabled] : modes) {
+            if (processHalResult(initHal()->setMode(mode, enabled), "setModeAsync").isOk()) {
+                sentModes.emplace(mode, enabled);
+            }
+        }
+
+        lock.lock();
+        if (mSyncModeCount != syncModeCount || getConnectedHalGeneration() != halGeneration) {
+            // A concurrent setMode may have overridden any mode, or some were sent to a HAL that
+            // is gone, so forget what was sent.
+            mSentModes.clear();
+        } else {
+            for (const auto& [mode, enabled] : modes) {
+                mSentModes.erase(mode);
+            }
+            mSentModes.merge(sentModes);
+        }
+        mAsyncBusy = false;
+        mAsyncFlushedCondition.notify_all();
+    }
+}
+
 } // namespace power
 
 } // namespace android
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *            http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "BufferedPowerHintSessionTest"
+
+#include <android/hardware/power/IPowerHintSession.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <powermanager/BufferedPowerHintSession.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <thread>
+
+using android::binder::Status;
+using android::hardware::power::IPowerHintSession;
+using android::hardware::power::SessionHint;
+using android::hardware::power::WorkDuration;
+
+using namespace android;
+using namespace android::power;
+using namespace testing;
+
+// -------------------------------------------------------------------------------------------------
+
+class MockIPowerHintSession : public IPowerHintSession {
+public:
+    MOCK_METHOD(IBinder*, onAsBinder, (), (override));
+    MOCK_METHOD(Status, pause, (), (override));
+    MOCK_METHOD(Status, resume, (), (override));
+    MOCK_METHOD(Status, close, (), (override));
+    MOCK_METHOD(int32_t, getInterfaceVersion, (), (override));
+    MOCK_METHOD(std::string, getInterfaceHash, (), (override));
+    MOCK_METHOD(Status, updateTargetWorkDuration, (int64_t), (override));
+    MOCK_METHOD(Status, reportActualWorkDuration, (const std::vector<WorkDuration>&), (override));
+    MOCK_METHOD(Status, sendHint, (SessionHint), (override));
+    MOCK_METHOD(Status, setThreads, (const std::vector<int32_t>&), (override));
+};
+
+// -------------------------------------------------------------------------------------------------
+
+class BufferedPowerHintSessionTest : public Test {
+public:
+    void SetUp() override {
+        mMockSession = sp<StrictMock<MockIPowerHintSession>>::make();
+        mSession.setSession(mMockSession, 16'000'000);
+    }
+
+protected:
+    sp<StrictMock<MockIPowerHintSession>> mMockSession = nullptr;
+    BufferedPowerHintSession mSession;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_F(BufferedPowerHintSessionTest, TestFlushWithoutSessionIsUnsupported) {
+    BufferedPowerHintSession session;
+    session.addWorkDuration(1000, 1);
+    ASSERT_TRUE(session.flush().isUnsupported());
+    EXPECT_EQ(session.getBufferedWorkDurationCount(), 1u);
+}
+
+TEST_F(BufferedPowerHintSessionTest, TestFlushSendsWorkDurationsFromAllThreadsInOneCall) {
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(SizeIs(10)))
+            .Times(Exactly(1))
+            .WillOnce(Return(Status::ok()));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 10; i++) {
+        threads.push_back(std::thread([this, i]() { mSession.addWorkDuration(1000 * i, i); }));
+    }
+    std::for_each(threads.begin(), threads.end(), [](std::thread& t) { t.join(); });
+
+    ASSERT_TRUE(mSession.flush().isOk());
+    EXPECT_EQ(mSession.getBufferedWorkDurationCount(), 0u);
+
+    // Nothing left to send.
+    ASSERT_TRUE(mSession.flush().isOk());
+}
+
+TEST_F(BufferedPowerHintSessionTest, TestFlushSendsLatestTargetOnlyIfChanged) {
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockSession.get(), updateTargetWorkDuration(Eq(8'000'000)))
+                .Times(Exactly(1))
+                .WillOnce(Return(Status::ok()));
+        EXPECT_CALL(*mMockSession.get(),
+                    reportActualWorkDuration(
+                            ElementsAre(Field(&WorkDuration::durationNanos, Eq(5'000'000)))))
+                .Times(Exactly(1))
+                .WillOnce(Return(Status::ok()));
+    }
+
+    // Same as the target the session was created with.
+    mSession.updateTargetWorkDuration(16'000'000);
+    ASSERT_TRUE(mSession.flush().isOk());
+
+    mSession.updateTargetWorkDuration(11'000'000);
+    mSession.updateTargetWorkDuration(8'000'000);
+    mSession.addWorkDuration(5'000'000, 1);
+    ASSERT_TRUE(mSession.flush().isOk());
+
+    mSession.updateTargetWorkDuration(8'000'000);
+    ASSERT_TRUE(mSession.flush().isOk());
+}
+
+TEST_F(BufferedPowerHintSessionTest, TestFailedFlushKeepsWorkDurationsForNextSession) {
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(SizeIs(1)))
+            .Times(Exactly(1))
+            .WillOnce(Return(Status::fromExceptionCode(Status::EX_ILLEGAL_STATE)));
+
+    mSession.addWorkDuration(1000, 1);
+    ASSERT_TRUE(mSession.flush().isFailed());
+    EXPECT_EQ(mSession.getBufferedWorkDurationCount(), 1u);
+
+    auto newSession = sp<StrictMock<MockIPowerHintSession>>::make();
+    EXPECT_CALL(*newSession.get(),
+                reportActualWorkDuration(ElementsAre(Field(&WorkDuration::durationNanos, Eq(1000)),
+                                                     Field(&WorkDuration::durationNanos, Eq(2000)))))
+            .Times(Exactly(1))
+            .WillOnce(Return(Status::ok()));
+
+    mSession.setSession(newSession, 16'000'000);
+    mSession.addWorkDuration(2000, 2);
+    ASSERT_TRUE(mSession.flush().isOk());
+}
@@ -24,6 +24,7 @@
 #include <powermanager/PowerHalController.h>
 #include <utils/Log.h>
 
+#include <future>
 #include <thread>
 
 using android::hardware::power::Boost;
@@ -278,3 +279,102 @@ TEST_F(PowerHalControllerTest, TestMultiThreadWithFailureReconnectIsThreadSafe)
     int powerHalResetCount = mHalConnector->getResetCount();
     EXPECT_THAT(powerHalResetCount, Le(10));
 }
+
+TEST_F(PowerHalControllerTest, TestAsyncApiCallsDelegatedToConnectedPowerHal) {
+    {
+        InSequence seg;
+        EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), Eq(100)))
+                .Times(Exactly(1));
+        EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::LAUNCH), Eq(1))).Times(Exactly(1));
+    }
+
+    mHalController->setBoostAsync(Boost::INTERACTION, 100);
+    mHalController->flushAsync();
+    mHalController->setModeAsync(Mode::LAUNCH, true);
+    mHalController->flushAsync();
+
+    EXPECT_EQ(mHalConnector->getConnectCount(), 1);
+    EXPECT_EQ(mHalConnector->getResetCount(), 0);
+}
+
+TEST_F(PowerHalControllerTest, TestAsyncApiCallsCoalescePendingRequests) {
+    std::promise<void> started;
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+
+    {
+        InSequence seg;
+        EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), Eq(10)))
+                .Times(Exactly(1))
+                .WillOnce([&](PowerHint, int32_t) {
+                    started.set_value();
+                    unblocked.wait();
+                    return hardware::Void();
+                });
+        // Longest duration wins.
+        EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), Eq(50)))
+                .Times(Exactly(1));
+        // Latest state wins.
+        EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::LAUNCH), Eq(1))).Times(Exactly(1));
+    }
+
+    mHalController->setBoostAsync(Boost::INTERACTION, 10);
+    started.get_future().wait();
+
+    // Queued while the thread is blocked in the HAL.
+    mHalController->setBoostAsync(Boost::INTERACTION, 50);
+    mHalController->setBoostAsync(Boost::INTERACTION, 20);
+    mHalController->setModeAsync(Mode::LAUNCH, true);
+    mHalController->setModeAsync(Mode::LAUNCH, false);
+    mHalController->setModeAsync(Mode::LAUNCH, true);
+
+    unblock.set_value();
+    mHalController->flushAsync();
+}
+
+TEST_F(PowerHalControllerTest, TestAsyncApiCallsSkipModeAlreadySent) {
+    // Sent by the first setModeAsync, by setMode, and by the setModeAsync that follows it.
+    EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::VR_MODE), Eq(1))).Times(Exactly(3));
+
+    mHalController->setModeAsync(Mode::VR, true);
+    mHalController->flushAsync();
+    mHalController->setModeAsync(Mode::VR, true);
+    mHalController->flushAsync();
+
+    auto result = mHalController->setMode(Mode::VR, true);
+    ASSERT_TRUE(result.isOk());
+
+    mHalController->setModeAsync(Mode::VR, true);
+    mHalController->flushAsync();
+}
+
+TEST_F(PowerHalControllerTest, TestAsyncApiCallsResendModeAfterReconnect) {
+    ON_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), _))
+            .WillByDefault([](PowerHint, int32_t) {
+                return hardware::Return<void>(hardware::Status::fromExceptionCode(-1));
+            });
+
+    // Sent again after the failed boost, as the reconnected HAL may not have it.
+    EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::VR_MODE), Eq(1))).Times(Exactly(2));
+    EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), _)).Times(Exactly(1));
+
+    mHalController->setModeAsync(Mode::VR, true);
+    mHalController->flushAsync();
+
+    auto result = mHalController->setBoost(Boost::INTERACTION, 100);
+    ASSERT_TRUE(result.isFailed());
+
+    mHalController->setModeAsync(Mode::VR, true);
+    mHalController->flushAsync();
+
+    EXPECT_EQ(mHalConnector->getConnectCount(), 2);
+    EXPECT_EQ(mHalConnector->getResetCount(), 1);
+}
+
+TEST_F(PowerHalControllerTest, TestAsyncApiCallsSentBeforeDestruction) {
+    EXPECT_CALL(*mMockHal.get(), powerHint(Eq(PowerHint::INTERACTION), Eq(100)))
+            .Times(Exactly(1));
+
+    mHalController->setBoostAsync(Boost::INTERACTION, 100);
+    mHalController.reset();
+}
@@ -22,7 +22,9 @@
 #include <aidl/android/hardware/sensors/BnSensorsCallback.h>
 #include <aidlcommonsupport/NativeHandle.h>
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <android/binder_manager.h>
+#include <utils/Timers.h>
 #include <aidl/sensors/convert.h>
 
 using ::aidl::android::hardware::sensors::AdditionalInfo;
@@ -59,6 +61,9 @@ enum EventQueueFlagBitsInternal : uint32_t {
     INTERNAL_WAKE = 1 << 16,
 };
 
+// Default for the sensors.fmq_drain_budget_us property. Zero reads a single batch per poll.
+constexpr int64_t kDefaultDrainBudgetUs = 1000;
+
 } // anonymous namespace
 
 class AidlSensorsCallback : public ::aidl::android::hardware::sensors::BnSensorsCallback {
@@ -92,6 +97,9 @@ private:
 AidlSensorHalWrapper::AidlSensorHalWrapper()
       : mEventQueueFlag(nullptr),
         mWakeLockQueueFlag(nullptr),
+        mDrainBudgetNs(us2ns(base::GetIntProperty<int64_t>("sensors.fmq_drain_budget_us",
+                                                           kDefaultDrainBudgetUs, 0))),
+        mUnwrittenWakeLockCount(0),
         mDeathRecipient(AIBinder_DeathRecipient_new(serviceDied)) {}
 
 bool AidlSensorHalWrapper::supportsPolling() {
@@ -105,6 +113,7 @@ bool AidlSensorHalWrapper::supportsMessageQueues() {
 bool AidlSensorHalWrapper::connect(SensorDeviceCallback *callback) {
     mSensorDeviceCallback = callback;
     mSensors = nullptr;
+    mUnwrittenWakeLockCount = 0;
 
     auto aidlServiceName = std::string() + ISensors::descriptor + "/default";
     if (AServiceManager_isDeclared(aidlServiceName.c_str())) {
@@ -158,7 +167,7 @@ ssize_t AidlSensorHalWrapper::poll(sensors_event_t * /* buffer */, size_t /* cou
 }
 
 ssize_t AidlSensorHalWrapper::pollFmq(sensors_event_t *buffer, size_t maxNumEventsToRead) {
-    ssize_t eventsRead = 0;
+    size_t eventsRead = 0;
     size_t availableEvents = mEventQueue->availableToRead();
 
     if (availableEvents == 0) {
@@ -181,28 +190,54 @@ ssize_t AidlSensorHalWrapper::pollFmq(sensors_event_t *buffer, size_t maxNumEven
         }
     }
 
-    size_t eventsToRead = std::min({availableEvents, maxNumEventsToRead, mEventBuffer.size()});
-    if (eventsToRead > 0) {
-        if (mEventQueue->read(mEventBuffer.data(), eventsToRead)) {
-            // Notify the Sensors HAL that sensor events have been read. This is required to support
-            // the use of writeBlocking by the Sensors HAL.
-            if (mEventQueueFlag != nullptr) {
-                mEventQueueFlag->wake(asBaseType(ISensors::EVENT_QUEUE_FLAG_BITS_EVENTS_READ));
-            }
-
-            for (size_t i = 0; i < eventsToRead; i++) {
-                convertToSensorEvent(mEventBuffer[i], &buffer[i]);
-            }
-            eventsRead = eventsToRead;
-        } else {
+    // A backlog, e.g. after a batching sensor flushed its FIFO, is written by the HAL in several
+    // batches. Keep reading them into the free part of buffer until the queue is empty or the
+    // budget is spent, instead of taking a round-trip through the sensor thread for each.
+    const nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) + mDrainBudgetNs;
+    size_t eventsToRead = std::min(availableEvents, maxNumEventsToRead);
+    while (eventsToRead > 0) {
+        size_t read = readEventsFromFmq(buffer + eventsRead, eventsToRead);
+        if (read == 0) {
             ALOGW("Failed to read %zu events, currently %zu events available", eventsToRead,
-                  availableEvents);
+                  mEventQueue->availableToRead());
+            break;
         }
+        eventsRead += read;
+        if (mDrainBudgetNs == 0 || systemTime(SYSTEM_TIME_MONOTONIC) >= deadline) {
+            break;
+        }
+        eventsToRead = std::min(mEventQueue->availableToRead(), maxNumEventsToRead - eventsRead);
     }
 
     return eventsRead;
 }
 
+size_t AidlSensorHalWrapper::readEventsFromFmq(sensors_event_t *buffer, size_t count) {
+    AidlMessageQueue<Event, SynchronizedReadWrite>::MemTransaction tx;
+    if (!mEventQueue->beginRead(count, &tx)) {
+        return 0;
+    }
+
+    const auto &first = tx.getFirstRegion();
+    const auto &second = tx.getSecondRegion();
+    for (size_t i = 0; i < first.getLength(); i++) {
+        convertToSensorEvent(first.getAddress()[i], &buffer[i]);
+    }
+    for (size_t i = 0; i < second.getLength(); i++) {
+        convertToSensorEvent(second.getAddress()[i], &buffer[first.getLength() + i]);
+    }
+
+    if (!mEventQueue->commitRead(count)) {
+        return 0;
+    }
+    // Notify the Sensors HAL that sensor events have been read. This is required to support
+    // the use of writeBlocking by the Sensors HAL.
+    if (mEventQueueFlag != nullptr) {
+        mEventQueueFlag->wake(asBaseType(ISensors::EVENT_QUEUE_FLAG_BITS_EVENTS_READ));
+    }
+    return count;
+}
+
 std::vector<sensor_t> AidlSensorHalWrapper::getSensorsList() {
     std::vector<sensor_t> sensorsFound;
 
@@ -313,11 +348,15 @@ status_t AidlSensorHalWrapper::configureDirectChannel(int32_t sensorHandle, int3
 }
 
 void AidlSensorHalWrapper::writeWakeLockHandled(uint32_t count) {
-    int signedCount = (int)count;
+    // The HAL only releases its wake lock once every wake up event it wrote was acknowledged, so
+    // a count that could not be written is added to the next write rather than dropped.
+    mUnwrittenWakeLockCount += count;
+    int signedCount = (int)mUnwrittenWakeLockCount;
     if (mWakeLockQueue->write(&signedCount)) {
+        mUnwrittenWakeLockCount = 0;
         mWakeLockQueueFlag->wake(asBaseType(ISensors::WAKE_LOCK_QUEUE_FLAG_BITS_DATA_WRITTEN));
     } else {
-        ALOGW("Failed to write wake lock handled");
+        ALOGW("Failed to write wake lock handled, %u events deferred", mUnwrittenWakeLockCount);
     }
 }
 
@@ -22,6 +22,7 @@
 #include <aidl/android/hardware/sensors/ISensors.h>
 #include <fmq/AidlMessageQueue.h>
 #include <sensor/SensorEventQueue.h>
+#include <utils/Timers.h>
 
 namespace android {
 
@@ -76,6 +77,10 @@ public:
     virtual void writeWakeLockHandled(uint32_t count) override;
 
 private:
+    // Converts count events straight out of the Event FMQ into buffer. Returns the number of
+    // events read, or 0 if they could not be read.
+    size_t readEventsFromFmq(sensors_event_t *buffer, size_t count);
+
     std::shared_ptr<aidl::android::hardware::sensors::ISensors> mSensors;
     std::shared_ptr<::aidl::android::hardware::sensors::ISensorsCallback> mCallback;
     std::unique_ptr<::android::AidlMessageQueue<::aidl::android::hardware::sensors::Event,
@@ -85,9 +90,11 @@ private:
     ::android::hardware::EventFlag *mEventQueueFlag;
     ::android::hardware::EventFlag *mWakeLockQueueFlag;
     SensorDeviceCallback *mSensorDeviceCallback;
-    std::array<::aidl::android::hardware::sensors::Event,
-               ::android::SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT>
-            mEventBuffer;
+    // How long pollFmq keeps reading batches the HAL wrote meanwhile, once events are available.
+    const nsecs_t mDrainBudgetNs;
+    // Handled wake up events that could not be written to the Wake Lock FMQ yet, and are added to
+    // the next write.
+    uint32_t mUnwrittenWakeLockCount;
 
     ndk::ScopedAIBinder_DeathRecipient mDeathRecipient;
 };
@@ -16,6 +16,8 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <utils/Log.h>
 
 #include "Fusion.h"
@@ -317,6 +319,28 @@ void Fusion::handleGyro(const vec3_t& w, float dT) {
     predict(w, dT);
 }
 
+void Fusion::handleGyro(const vec3_t* w, const float* dT, size_t count) {
+    size_t i = 0;
+    // Until there is an estimate, samples go into the initial estimate one by one.
+    for (; i < count && !hasEstimate(); i++) {
+        handleGyro(w[i], dT[i]);
+    }
+
+    // Only update() moves the bias, so the propagation of every sample can be computed ahead of
+    // the sequential part, in a loop without dependencies between samples.
+    Propagation propagations[GYRO_BATCH_SIZE];
+    while (i < count) {
+        const size_t n = std::min(count - i, size_t(GYRO_BATCH_SIZE));
+        for (size_t j = 0; j < n; j++) {
+            getPropagation(w[i + j] - x1, dT[i + j], &propagations[j]);
+        }
+        for (size_t j = 0; j < n; j++) {
+            propagate(propagations[j]);
+        }
+        i += n;
+    }
+}
+
 status_t Fusion::handleAcc(const vec3_t& a, float dT) {
     if (!checkInitComplete(ACC, a, dT))
         return BAD_VALUE;
@@ -428,10 +452,12 @@ mat34_t Fusion::getF(const vec4_t& q) {
 }
 
 void Fusion::predict(const vec3_t& w, float dT) {
-    const vec4_t q  = x0;
-    const vec3_t b  = x1;
-    vec3_t we = w - b;
+    Propagation propagation;
+    getPropagation(w - x1, dT, &propagation);
+    propagate(propagation);
+}
 
+void Fusion::getPropagation(vec3_t we, float dT, Propagation* out) {
     if (length(we) < WVEC_EPS) {
         we = (we[0]>0.f)?WVEC_EPS:-WVEC_EPS;
     }
@@ -473,16 +499,21 @@ void Fusion::predict(const vec3_t& w, float dT) {
     const float k2 = cosf(hlwedT);
     const vec3_t psi(sinf(hlwedT)*ilwe*we);
     const mat33_t O33(crossMatrix(-psi, k2));
-    mat44_t O;
+    mat44_t& O = out->O;
     O[0].xyz = O33[0];  O[0].w = -psi.x;
     O[1].xyz = O33[1];  O[1].w = -psi.y;
     O[2].xyz = O33[2];  O[2].w = -psi.z;
     O[3].xyz = psi;     O[3].w = k2;
 
-    Phi[0][0] = I33 - wx*(k1*ilwe) + wx2*k0;
-    Phi[1][0] = wx*k0 - I33dT - wx2*(ilwe*ilwe*ilwe)*(lwedT-k1);
+    out->Phi00 = I33 - wx*(k1*ilwe) + wx2*k0;
+    out->Phi10 = wx*k0 - I33dT - wx2*(ilwe*ilwe*ilwe)*(lwedT-k1);
+}
+
+void Fusion::propagate(const Propagation& propagation) {
+    Phi[0][0] = propagation.Phi00;
+    Phi[1][0] = propagation.Phi10;
 
-    x0 = O*q;
+    x0 = propagation.O*x0;
 
     if (x0.w < 0)
         x0 = -x0;
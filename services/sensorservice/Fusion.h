@@ -64,6 +64,8 @@ public:
     Fusion();
     void init(int mode = FUSION_9AXIS);
     void handleGyro(const vec3_t& w, float dT);
+    // Same as calling handleGyro(w[i], dT[i]) for each of count consecutive gyro samples.
+    void handleGyro(const vec3_t* w, const float* dT, size_t count);
     status_t handleAcc(const vec3_t& a, float dT);
     status_t handleMag(const vec3_t& m);
     vec4_t getAttitude() const;
@@ -88,10 +90,20 @@ private:
     int mMode;
 
     enum { ACC=0x1, MAG=0x2, GYRO=0x4 };
+    enum { GYRO_BATCH_SIZE = 16 };
+
+    // How one gyro sample moves the attitude and the covariance.
+    struct Propagation {
+        mat44_t O;
+        mat33_t Phi00;
+        mat33_t Phi10;
+    };
     bool checkInitComplete(int, const vec3_t& w, float d = 0);
     void initFusion(const vec4_t& q0, float dT);
     void checkState();
     void predict(const vec3_t& w, float dT);
+    static void getPropagation(vec3_t we, float dT, Propagation* out);
+    void propagate(const Propagation& propagation);
     void update(const vec3_t& z, const vec3_t& Bi, float sigma);
     static mat34_t getF(const vec4_t& p);
     static vec3_t getOrthogonal(const vec3_t &v);
@@ -367,10 +367,14 @@ status_t HidlSensorHalWrapper::configureDirectChannel(int32_t sensorHandle, int3
 }
 
 void HidlSensorHalWrapper::writeWakeLockHandled(uint32_t count) {
-    if (mWakeLockQueue->write(&count)) {
+    // The HAL only releases its wake lock once every wake up event it wrote was acknowledged, so
+    // a count that could not be written is added to the next write rather than dropped.
+    mUnwrittenWakeLockCount += count;
+    if (mWakeLockQueue->write(&mUnwrittenWakeLockCount)) {
+        mUnwrittenWakeLockCount = 0;
         mWakeLockQueueFlag->wake(asBaseType(WakeLockQueueFlagBits::DATA_WRITTEN));
     } else {
-        ALOGW("Failed to write wake lock handled");
+        ALOGW("Failed to write wake lock handled, %u events deferred", mUnwrittenWakeLockCount);
     }
 }
 
@@ -471,6 +475,7 @@ ISensorHalWrapper::HalConnectionStatus HidlSensorHalWrapper::initializeHidlServi
     mWakeLockQueue =
             std::make_unique<WakeLockQueue>(SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT,
                                             true /* configureEventFlagWord */);
+    mUnwrittenWakeLockCount = 0;
 
     hardware::EventFlag::deleteEventFlag(&mEventQueueFlag);
     hardware::EventFlag::createEventFlag(mSensors->getEventQueue()->getEventFlagWord(),
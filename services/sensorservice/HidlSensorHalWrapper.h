@@ -160,6 +160,9 @@ private:
 
     typedef hardware::MessageQueue<uint32_t, hardware::kSynchronizedReadWrite> WakeLockQueue;
     std::unique_ptr<WakeLockQueue> mWakeLockQueue;
+    // Handled wake up events that could not be written to mWakeLockQueue yet, and are added to
+    // the next write.
+    uint32_t mUnwrittenWakeLockCount = 0;
 
     hardware::EventFlag* mEventQueueFlag;
     hardware::EventFlag* mWakeLockQueueFlag;
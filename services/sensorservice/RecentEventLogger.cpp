@@ -23,6 +23,8 @@
 
 #include <inttypes.h>
 
+#include <vector>
+
 namespace android {
 namespace SensorServiceUtil {
 
@@ -40,37 +42,40 @@ RecentEventLogger::RecentEventLogger(int sensorType) :
 }
 
 void RecentEventLogger::addEvent(const sensors_event_t& event) {
-    std::lock_guard<std::mutex> lk(mLock);
-    mRecentEvents.emplace(event);
-    mIsLastEventCurrent = true;
+    mRecentEvents.add(SensorEventLog(event));
+    mIsLastEventCurrent.store(true, std::memory_order_release);
 }
 
 bool RecentEventLogger::isEmpty() const {
-    return mRecentEvents.size() == 0;
+    return mRecentEvents.empty();
 }
 
 void RecentEventLogger::setLastEventStale() {
-    std::lock_guard<std::mutex> lk(mLock);
-    mIsLastEventCurrent = false;
+    mIsLastEventCurrent.store(false, std::memory_order_release);
 }
 
 std::string RecentEventLogger::dump() const {
-    std::lock_guard<std::mutex> lk(mLock);
+    return dump(mMaskData.load(std::memory_order_relaxed));
+}
+
+std::string RecentEventLogger::dump(bool maskData) const {
+    std::vector<SensorEventLog> events;
+    mRecentEvents.snapshot(&events);
 
     //TODO: replace String8 with std::string completely in this function
     String8 buffer;
 
-    buffer.appendFormat("last %zu events\n", mRecentEvents.size());
+    buffer.appendFormat("last %zu events\n", events.size());
     int j = 0;
-    for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
-        const auto& ev = mRecentEvents[i];
+    for (int i = events.size() - 1; i >= 0; --i) {
+        const auto& ev = events[i];
         struct tm * timeinfo = localtime(&(ev.mWallTime.tv_sec));
         buffer.appendFormat("\t%2d (ts=%.9f, wall=%02d:%02d:%02d.%03d) ",
                 ++j, ev.mEvent.timestamp/1e9, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec,
                 (int) ns2ms(ev.mWallTime.tv_nsec));
 
         // data
-        if (!mMaskData) {
+        if (!maskData) {
             if (mSensorType == SENSOR_TYPE_STEP_COUNTER) {
                 buffer.appendFormat("%" PRIu64 ", ", ev.mEvent.u64.step_counter);
             } else {
@@ -95,17 +100,18 @@ std::string RecentEventLogger::dump() const {
  */
 void RecentEventLogger::dump(util::ProtoOutputStream* proto) const {
     using namespace service::SensorEventsProto;
-    std::lock_guard<std::mutex> lk(mLock);
+    std::vector<SensorEventLog> events;
+    mRecentEvents.snapshot(&events);
 
-    proto->write(RecentEventsLog::RECENT_EVENTS_COUNT, int(mRecentEvents.size()));
-    for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
-        const auto& ev = mRecentEvents[i];
+    proto->write(RecentEventsLog::RECENT_EVENTS_COUNT, int(events.size()));
+    for (int i = events.size() - 1; i >= 0; --i) {
+        const auto& ev = events[i];
         const uint64_t token = proto->start(RecentEventsLog::EVENTS);
         proto->write(Event::TIMESTAMP_SEC, float(ev.mEvent.timestamp) / 1e9f);
         proto->write(Event::WALL_TIMESTAMP_MS, ev.mWallTime.tv_sec * 1000LL
                 + ns2ms(ev.mWallTime.tv_nsec));
 
-        if (mMaskData) {
+        if (mMaskData.load(std::memory_order_relaxed)) {
             proto->write(Event::MASKED, true);
         } else {
             if (mSensorType == SENSOR_TYPE_STEP_COUNTER) {
@@ -121,23 +127,19 @@ void RecentEventLogger::dump(util::ProtoOutputStream* proto) const {
 }
 
 void RecentEventLogger::setFormat(std::string format) {
-    if (format == "mask_data" ) {
-        mMaskData = true;
-    } else {
-        mMaskData = false;
-    }
+    mMaskData.store(format == "mask_data", std::memory_order_relaxed);
 }
 
 bool RecentEventLogger::populateLastEventIfCurrent(sensors_event_t *event) const {
-    std::lock_guard<std::mutex> lk(mLock);
-
-    if (mIsLastEventCurrent && mRecentEvents.size()) {
-        // Index 0 contains the latest event emplace()'ed
-        *event = mRecentEvents[0].mEvent;
-        return true;
-    } else {
+    if (!mIsLastEventCurrent.load(std::memory_order_acquire)) {
+        return false;
+    }
+    SensorEventLog last;
+    if (!mRecentEvents.front(&last)) {
         return false;
     }
+    *event = last.mEvent;
+    return true;
 }
 
 
@@ -17,13 +17,13 @@
 #ifndef ANDROID_SENSOR_SERVICE_UTIL_RECENT_EVENT_LOGGER_H
 #define ANDROID_SENSOR_SERVICE_UTIL_RECENT_EVENT_LOGGER_H
 
-#include "RingBuffer.h"
+#include "SeqLockRingBuffer.h"
 #include "SensorServiceUtils.h"
 
 #include <hardware/sensors.h>
 #include <utils/String8.h>
 
-#include <mutex>
+#include <atomic>
 
 namespace android {
 namespace SensorServiceUtil {
@@ -33,6 +33,10 @@ namespace SensorServiceUtil {
 // generated from the sensor are stored in this buffer.  The buffer is NOT cleared when the sensor
 // unregisters and as a result very old data in the dumpsys output can be seen, which is an intended
 // behavior.
+//
+// addEvent() and setLastEventStale() are only called by the sensor thread, or with
+// SensorService::mLock held. Readers copy events out of the buffer without taking a lock, so
+// dumping the logger never holds up the sensor thread.
 class RecentEventLogger : public Dumpable {
 public:
     explicit RecentEventLogger(int sensorType);
@@ -48,11 +52,14 @@ public:
 
     // Dumpable interface
     virtual std::string dump() const override;
+    // Like dump(), masking the data as requested instead of by the format.
+    std::string dump(bool maskData) const;
     virtual void dump(util::ProtoOutputStream* proto) const override;
     virtual void setFormat(std::string format) override;
 
 protected:
     struct SensorEventLog {
+        SensorEventLog() = default;
         explicit SensorEventLog(const sensors_event_t& e);
         timespec mWallTime;
         sensors_event_t mEvent;
@@ -61,11 +68,10 @@ protected:
     const int mSensorType;
     const size_t mEventSize;
 
-    mutable std::mutex mLock;
-    RingBuffer<SensorEventLog> mRecentEvents;
+    SeqLockRingBuffer<SensorEventLog> mRecentEvents;
 
-    bool mMaskData;
-    bool mIsLastEventCurrent;
+    std::atomic<bool> mMaskData;
+    std::atomic<bool> mIsLastEventCurrent;
 
 private:
     static size_t logSizeBySensorType(int sensorType);
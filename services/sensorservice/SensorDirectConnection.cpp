@@ -139,6 +139,11 @@ status_t SensorService::SensorDirectConnection::flush() {
     return INVALID_OPERATION;
 }
 
+sp<SensorEventRing> SensorService::SensorDirectConnection::getSensorEventRing() {
+    // SensorDirectConnection already delivers events through shared memory
+    return nullptr;
+}
+
 int32_t SensorService::SensorDirectConnection::configureChannel(int handle, int rateLevel) {
 
     if (handle == -1 && rateLevel == SENSOR_DIRECT_RATE_STOP) {
@@ -241,7 +241,10 @@ void SensorService::SensorEventConnection::updateLooperRegistrationLocked(
     return; }
 
     int looper_flags = 0;
-    if (mCacheSize > 0) looper_flags |= ALOOPER_EVENT_OUTPUT;
+    // With a ring, the client tells us on the socket when it has made room for the cache.
+    if (mCacheSize > 0) {
+        looper_flags |= mRing != nullptr ? ALOOPER_EVENT_INPUT : ALOOPER_EVENT_OUTPUT;
+    }
     if (mDataInjectionMode) looper_flags |= ALOOPER_EVENT_INPUT;
     for (auto& it : mSensorInfo) {
         const int handle = it.first;
@@ -290,7 +293,8 @@ bool SensorService::SensorEventConnection::incrementPendingFlushCountIfHasAccess
 status_t SensorService::SensorEventConnection::sendEvents(
         sensors_event_t const* buffer, size_t numEvents,
         sensors_event_t* scratch,
-        wp<const SensorEventConnection> const * mapFlushEventsToConnections) {
+        wp<const SensorEventConnection> const * mapFlushEventsToConnections,
+        const std::vector<uint32_t>* eventIndices) {
     // filter out events not for this connection
 
     std::unique_ptr<sensors_event_t[]> sanitizedBuffer;
@@ -298,8 +302,10 @@ status_t SensorService::SensorEventConnection::sendEvents(
     int count = 0;
     Mutex::Autolock _l(mConnectionLock);
     if (scratch) {
-        size_t i=0;
-        while (i<numEvents) {
+        const bool sensorAccess = hasSensorAccess();
+        const size_t candidates = eventIndices != nullptr ? eventIndices->size() : numEvents;
+        for (size_t j = 0; j < candidates; j++) {
+            const size_t i = eventIndices != nullptr ? (*eventIndices)[j] : j;
             int32_t sensor_handle = buffer[i].sensor;
             if (buffer[i].type == SENSOR_TYPE_META_DATA) {
                 ALOGD_IF(DEBUG_CONNECTIONS, "flush complete event sensor==%d ",
@@ -312,50 +318,36 @@ status_t SensorService::SensorEventConnection::sendEvents(
 
             // Check if this connection has registered for this sensor. If not continue to the
             // next sensor_event.
-            if (mSensorInfo.count(sensor_handle) == 0) {
-                ++i;
+            auto it = mSensorInfo.find(sensor_handle);
+            if (it == mSensorInfo.end()) {
                 continue;
             }
 
-            FlushInfo& flushInfo = mSensorInfo[sensor_handle];
+            FlushInfo& flushInfo = it->second;
             // Check if there is a pending flush_complete event for this sensor on this connection.
             if (buffer[i].type == SENSOR_TYPE_META_DATA && flushInfo.mFirstFlushPending == true &&
                     mapFlushEventsToConnections[i] == this) {
                 flushInfo.mFirstFlushPending = false;
                 ALOGD_IF(DEBUG_CONNECTIONS, "First flush event for sensor==%d ",
                         buffer[i].meta_data.sensor);
-                ++i;
                 continue;
             }
 
             // If there is a pending flush complete event for this sensor on this connection,
             // ignore the event and proceed to the next.
             if (flushInfo.mFirstFlushPending) {
-                ++i;
                 continue;
             }
 
-            do {
-                // Keep copying events into the scratch buffer as long as they are regular
-                // sensor_events are from the same sensor_handle OR they are flush_complete_events
-                // from the same sensor_handle AND the current connection is mapped to the
-                // corresponding flush_complete_event.
-                if (buffer[i].type == SENSOR_TYPE_META_DATA) {
-                    if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
-                    }
-                } else {
-                    // Regular sensor event, just copy it to the scratch buffer after checking
-                    // the AppOp.
-                    if (hasSensorAccess() && noteOpIfRequired(buffer[i])) {
-                        scratch[count++] = buffer[i];
-                    }
+            // Copy flush_complete_events only if the current connection is mapped to them, and
+            // regular sensor_events after checking the AppOp.
+            if (buffer[i].type == SENSOR_TYPE_META_DATA) {
+                if (mapFlushEventsToConnections[i] == this) {
+                    scratch[count++] = buffer[i];
                 }
-                i++;
-            } while ((i<numEvents) && ((buffer[i].sensor == sensor_handle &&
-                                        buffer[i].type != SENSOR_TYPE_META_DATA) ||
-                                       (buffer[i].type == SENSOR_TYPE_META_DATA  &&
-                                        buffer[i].meta_data.sensor == sensor_handle)));
+            } else if (sensorAccess && noteOpIfRequired(buffer[i])) {
+                scratch[count++] = buffer[i];
+            }
         }
     } else {
         if (hasSensorAccess()) {
@@ -403,8 +395,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
     }
 
     // NOTE: ASensorEvent and sensors_event_t are the same type.
-    ssize_t size = SensorEventQueue::write(mChannel,
-                                    reinterpret_cast<ASensorEvent const*>(scratch), count);
+    ssize_t size = writeEventsLocked(reinterpret_cast<ASensorEvent const*>(scratch), count);
     if (size < 0) {
         // Write error, copy events to local cache.
         if (index_wake_up_event >= 0) {
@@ -570,7 +561,7 @@ void SensorService::SensorEventConnection::sendPendingFlushEventsLocked() {
                ++mWakeLockRefCount;
                flushCompleteEvent.flags |= WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
             }
-            ssize_t size = SensorEventQueue::write(mChannel, &flushCompleteEvent, 1);
+            ssize_t size = writeEventsLocked(&flushCompleteEvent, 1);
             if (size < 0) {
                 if (wakeUpSensor) --mWakeLockRefCount;
                 return;
@@ -582,6 +573,22 @@ void SensorService::SensorEventConnection::sendPendingFlushEventsLocked() {
     }
 }
 
+ssize_t SensorService::SensorEventConnection::writeEventsLocked(ASensorEvent const* events,
+                                                                size_t count) {
+    if (mRing == nullptr) {
+        return SensorEventQueue::write(mChannel, events, count);
+    }
+
+    bool wakeReader = false;
+    ssize_t size = mRing->write(events, count, &wakeReader);
+    if (wakeReader) {
+        // If the socket is full, the client already has a wakeup pending.
+        SensorEventRing::WakeMessage message = SensorEventRing::kWakeMessage;
+        ::send(mChannel->getSendFd(), &message, sizeof(message), MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    return size;
+}
+
 void SensorService::SensorEventConnection::writeToSocketFromCache() {
     // At a time write at most half the size of the receiver buffer in SensorEventQueue OR
     // half the size of the socket buffer allocated in BitTube whichever is smaller.
@@ -606,9 +613,9 @@ void SensorService::SensorEventConnection::writeToSocketFromCache() {
             }
         }
 
-        ssize_t size = SensorEventQueue::write(mChannel,
-                          reinterpret_cast<ASensorEvent const*>(mEventCache + numEventsSent),
-                          numEventsToWrite);
+        ssize_t size = writeEventsLocked(
+                reinterpret_cast<ASensorEvent const*>(mEventCache + numEventsSent),
+                numEventsToWrite);
         if (size < 0) {
             if (index_wake_up_event >= 0) {
                 // If there was a wake_up sensor_event, reset the flag.
@@ -678,6 +685,27 @@ sp<BitTube> SensorService::SensorEventConnection::getSensorChannel() const
     return mChannel;
 }
 
+sp<SensorEventRing> SensorService::SensorEventConnection::getSensorEventRing() {
+    // Injected events are sent the other way, on the socket.
+    if (mDataInjectionMode) {
+        return nullptr;
+    }
+    Mutex::Autolock _l(mConnectionLock);
+    if (mRing == nullptr) {
+        // At least as large as SensorService's event buffer, so that every write can fit.
+        const size_t capacity =
+                std::max<size_t>(mService->mSocketBufferSize / sizeof(sensors_event_t),
+                                 SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT);
+        sp<SensorEventRing> ring = new SensorEventRing(capacity);
+        if (ring->initCheck() != NO_ERROR) {
+            return nullptr;
+        }
+        mRing = ring;
+        updateLooperRegistrationLocked(mService->getLooper());
+    }
+    return mRing;
+}
+
 status_t SensorService::SensorEventConnection::enableDisable(
         int handle, bool enabled, nsecs_t samplingPeriodNs, nsecs_t maxBatchReportLatencyNs,
         int reservedFlags)
@@ -843,6 +871,11 @@ int SensorService::SensorEventConnection::handleEvent(int fd, int events, void*
     if (events & ALOOPER_EVENT_INPUT) {
         unsigned char buf[sizeof(sensors_event_t)];
         ssize_t numBytesRead = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (numBytesRead == sizeof(SensorEventRing::WakeMessage)) {
+            // The client has made room in the ring: send the events in mEventCache.
+            mService->sendEventsFromCache(this);
+            return 1;
+        }
         {
             Mutex::Autolock _l(mConnectionLock);
             if (numBytesRead == sizeof(sensors_event_t)) {
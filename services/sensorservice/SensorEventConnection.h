@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <unordered_map>
+#include <vector>
 
 #include <utils/Vector.h>
 #include <utils/SortedVector.h>
@@ -35,6 +36,7 @@
 
 #include <sensor/Sensor.h>
 #include <sensor/BitTube.h>
+#include <sensor/SensorEventRing.h>
 #include <sensor/ISensorServer.h>
 #include <sensor/ISensorEventConnection.h>
 
@@ -54,8 +56,12 @@ public:
                           bool isDataInjectionMode, const String16& opPackageName,
                           const String16& attributionTag);
 
+    // If eventIndices is set, only those entries of buffer (in increasing order) are considered
+    // for this connection. They must include every event for the sensors this connection has
+    // registered.
     status_t sendEvents(sensors_event_t const* buffer, size_t count, sensors_event_t* scratch,
-                        wp<const SensorEventConnection> const * mapFlushEventsToConnections = nullptr);
+                        wp<const SensorEventConnection> const * mapFlushEventsToConnections = nullptr,
+                        const std::vector<uint32_t>* eventIndices = nullptr);
     bool hasSensor(int32_t handle) const;
     bool hasAnySensor() const;
     bool hasOneShotSensors() const;
@@ -83,6 +89,7 @@ private:
     virtual status_t setEventRate(int handle, nsecs_t samplingPeriodNs);
     virtual status_t flush();
     virtual int32_t configureChannel(int handle, int rateLevel);
+    virtual sp<SensorEventRing> getSensorEventRing();
     virtual void destroy();
 
     // Count the number of flush complete events which are about to be dropped in the buffer.
@@ -101,6 +108,10 @@ private:
     // emulates the behavior of flush().
     void sendPendingFlushEventsLocked();
 
+    // Writes events to mRing if the client uses one, or else to the socket. All events are written
+    // or the call fails, with -EAGAIN if there is no room.
+    ssize_t writeEventsLocked(ASensorEvent const* events, size_t count);
+
     // Writes events from mEventCache to the socket.
     void writeToSocketFromCache();
 
@@ -148,6 +159,9 @@ private:
     void uncapRates();
     sp<SensorService> const mService;
     sp<BitTube> mChannel;
+    // Set once the client asks for it, after which events are only delivered through it and
+    // mChannel only carries wakeups. Protected by mConnectionLock.
+    sp<SensorEventRing> mRing;
     uid_t mUid;
     mutable Mutex mConnectionLock;
     // Number of events from wake up sensors which are still pending and haven't been delivered to
@@ -71,21 +71,54 @@ SensorFusion::SensorFusion()
     }
 }
 
+bool SensorFusion::getGyroDelta(const sensors_event_t& event, float* dT) {
+    if ( event.timestamp - mGyroTime> 0 &&
+         event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
+
+        *dT = (event.timestamp - mGyroTime) / 1000000000.0f;
+        // here we estimate the gyro rate (useful for debugging)
+        const float freq = 1 / *dT;
+        if (freq >= 100 && freq<1000) { // filter values obviously wrong
+            const float alpha = 1 / (1 + *dT); // 1s time-constant
+            mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
+        }
+        return true;
+    }
+    return false;
+}
+
+void SensorFusion::process(const sensors_event_t* events, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        if (events[i].type != mGyro.getType()) {
+            process(events[i]);
+            i++;
+            continue;
+        }
+
+        mGyroBatch.clear();
+        mGyroBatchDt.clear();
+        for (; i < count && events[i].type == mGyro.getType(); i++) {
+            float dT;
+            if (getGyroDelta(events[i], &dT)) {
+                mGyroBatch.push_back(vec3_t(events[i].data));
+                mGyroBatchDt.push_back(dT);
+            }
+            mGyroTime = events[i].timestamp;
+        }
+        for (int m = 0; m<NUM_FUSION_MODE; ++m) {
+            if (mEnabled[m]) {
+                mFusions[m].handleGyro(mGyroBatch.data(), mGyroBatchDt.data(), mGyroBatch.size());
+            }
+        }
+    }
+}
+
 void SensorFusion::process(const sensors_event_t& event) {
 
     if (event.type == mGyro.getType()) {
         float dT;
-        if ( event.timestamp - mGyroTime> 0 &&
-             event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
-
-            dT = (event.timestamp - mGyroTime) / 1000000000.0f;
-            // here we estimate the gyro rate (useful for debugging)
-            const float freq = 1 / dT;
-            if (freq >= 100 && freq<1000) { // filter values obviously wrong
-                const float alpha = 1 / (1 + dT); // 1s time-constant
-                mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
-            }
-
+        if (getGyroDelta(event, &dT)) {
             const vec3_t gyro(event.data);
             for (int i = 0; i<NUM_FUSION_MODE; ++i) {
                 if (mEnabled[i]) {
@@ -26,6 +26,8 @@
 
 #include <sensor/Sensor.h>
 
+#include <vector>
+
 #include "Fusion.h"
 
 // ---------------------------------------------------------------------------
@@ -58,10 +60,20 @@ class SensorFusion : public Singleton<SensorFusion> {
     nsecs_t mGyroTime;
     nsecs_t mAccTime;
 
+    // Scratch space for the runs of gyro samples gathered by process(events, count).
+    std::vector<vec3_t> mGyroBatch;
+    std::vector<float> mGyroBatchDt;
+
     SensorFusion();
 
+    // Returns false if the gyro event is too close to or too far from the previous one.
+    bool getGyroDelta(const sensors_event_t& event, float* dT);
+
 public:
     void process(const sensors_event_t& event);
+    // Same as calling process() on each event, but propagates each run of consecutive gyro events
+    // as a batch.
+    void process(const sensors_event_t* events, size_t count);
 
     bool isEnabled() const {
         return mEnabled[FUSION_9AXIS] ||
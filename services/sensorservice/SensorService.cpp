@@ -521,7 +521,8 @@ bool SensorService::registerSensor(std::shared_ptr<SensorInterface> s, bool isDe
     const int handle = s->getSensor().getHandle();
     const int type = s->getSensor().getType();
     if (mSensors.add(handle, std::move(s), isDebug, isVirtual, deviceId)) {
-        mRecentEvent.emplace(handle, new SensorServiceUtil::RecentEventLogger(type));
+        mRecentEvent.emplace(handle,
+                             std::make_shared<SensorServiceUtil::RecentEventLogger>(type));
         return true;
     } else {
         LOG_FATAL("Failed to register sensor with handle %d", handle);
@@ -536,11 +537,7 @@ bool SensorService::registerDynamicSensorLocked(std::shared_ptr<SensorInterface>
 bool SensorService::unregisterDynamicSensorLocked(int handle) {
     bool ret = mSensors.remove(handle);
 
-    const auto i = mRecentEvent.find(handle);
-    if (i != mRecentEvent.end()) {
-        delete i->second;
-        mRecentEvent.erase(i);
-    }
+    mRecentEvent.erase(handle);
     return ret;
 }
 
@@ -549,9 +546,6 @@ bool SensorService::registerVirtualSensor(std::shared_ptr<SensorInterface> s, bo
 }
 
 SensorService::~SensorService() {
-    for (auto && entry : mRecentEvent) {
-        delete entry.second;
-    }
     mUidPolicy->unregisterSelf();
     mSensorPrivacyPolicy->unregisterSelf();
     mMicSensorPrivacyPolicy->unregisterSelf();
@@ -565,6 +559,15 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
                 IPCThreadState::self()->getCallingUid());
     } else {
         bool privileged = IPCThreadState::self()->getCallingUid() == 0;
+        // Recent events are formatted after releasing mLock, so that the sensor thread can keep
+        // recording events meanwhile. They are written out at recentEventsOffset in result.
+        struct RecentEventsDump {
+            String8 name;
+            std::shared_ptr<SensorServiceUtil::RecentEventLogger> logger;
+            bool maskData;
+        };
+        std::vector<RecentEventsDump> recentEvents;
+        size_t recentEventsOffset = 0;
         if (args.size() > 2) {
            return INVALID_OPERATION;
         }
@@ -580,116 +583,126 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
             }
         }
 
-        ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
-        // Run the following logic if a transition isn't requested above based on the input
-        // argument parsing.
-        if (args.size() == 1 && args[0] == String16("--proto")) {
-            return dumpProtoLocked(fd, &connLock);
-        } else if (!mSensors.hasAnySensor()) {
-            result.append("No Sensors on the device\n");
-            result.appendFormat("devInitCheck : %d\n", SensorDevice::getInstance().initCheck());
-        } else {
-            // Default dump the sensor list and debugging information.
-            //
-            timespec curTime;
-            clock_gettime(CLOCK_REALTIME, &curTime);
-            struct tm* timeinfo = localtime(&(curTime.tv_sec));
-            result.appendFormat("Captured at: %02d:%02d:%02d.%03d\n", timeinfo->tm_hour,
-                                timeinfo->tm_min, timeinfo->tm_sec, (int)ns2ms(curTime.tv_nsec));
-            result.append("Sensor Device:\n");
-            result.append(SensorDevice::getInstance().dump().c_str());
-
-            result.append("Sensor List:\n");
-            result.append(mSensors.dump().c_str());
-
-            result.append("Fusion States:\n");
-            SensorFusion::getInstance().dump(result);
-
-            result.append("Recent Sensor events:\n");
-            for (auto&& i : mRecentEvent) {
-                std::shared_ptr<SensorInterface> s = getSensorInterfaceFromHandle(i.first);
-                if (!i.second->isEmpty() && s != nullptr) {
-                    if (privileged || s->getSensor().getRequiredPermission().isEmpty()) {
-                        i.second->setFormat("normal");
-                    } else {
-                        i.second->setFormat("mask_data");
+        {
+            ConnectionSafeAutolock connLock = mConnectionHolder.lock(mLock);
+            // Run the following logic if a transition isn't requested above based on the input
+            // argument parsing.
+            if (args.size() == 1 && args[0] == String16("--proto")) {
+                return dumpProtoLocked(fd, &connLock);
+            } else if (!mSensors.hasAnySensor()) {
+                result.append("No Sensors on the device\n");
+                result.appendFormat("devInitCheck : %d\n", SensorDevice::getInstance().initCheck());
+            } else {
+                // Default dump the sensor list and debugging information.
+                //
+                timespec curTime;
+                clock_gettime(CLOCK_REALTIME, &curTime);
+                struct tm* timeinfo = localtime(&(curTime.tv_sec));
+                result.appendFormat("Captured at: %02d:%02d:%02d.%03d\n", timeinfo->tm_hour,
+                                    timeinfo->tm_min, timeinfo->tm_sec,
+                                    (int)ns2ms(curTime.tv_nsec));
+                result.append("Sensor Device:\n");
+                result.append(SensorDevice::getInstance().dump().c_str());
+
+                result.append("Sensor List:\n");
+                result.append(mSensors.dump().c_str());
+
+                result.append("Fusion States:\n");
+                SensorFusion::getInstance().dump(result);
+
+                result.append("Recent Sensor events:\n");
+                recentEventsOffset = result.size();
+                for (auto&& i : mRecentEvent) {
+                    std::shared_ptr<SensorInterface> s = getSensorInterfaceFromHandle(i.first);
+                    if (!i.second->isEmpty() && s != nullptr) {
+                        // mask the data if the sensor needs a special permission.
+                        recentEvents.push_back({s->getSensor().getName(), i.second,
+                                !privileged && !s->getSensor().getRequiredPermission().isEmpty()});
                     }
-                    // if there is events and sensor does not need special permission.
-                    result.appendFormat("%s: ", s->getSensor().getName().string());
-                    result.append(i.second->dump().c_str());
                 }
-            }
 
-            result.append("Active sensors:\n");
-            SensorDevice& dev = SensorDevice::getInstance();
-            for (size_t i=0 ; i<mActiveSensors.size() ; i++) {
-                int handle = mActiveSensors.keyAt(i);
-                if (dev.isSensorActive(handle)) {
-                    result.appendFormat("%s (handle=0x%08x, connections=%zu)\n",
-                            getSensorName(handle).string(),
-                            handle,
-                            mActiveSensors.valueAt(i)->getNumConnections());
+                result.append("Active sensors:\n");
+                SensorDevice& dev = SensorDevice::getInstance();
+                for (size_t i=0 ; i<mActiveSensors.size() ; i++) {
+                    int handle = mActiveSensors.keyAt(i);
+                    if (dev.isSensorActive(handle)) {
+                        result.appendFormat("%s (handle=0x%08x, connections=%zu)\n",
+                                getSensorName(handle).string(),
+                                handle,
+                                mActiveSensors.valueAt(i)->getNumConnections());
+                    }
                 }
-            }
 
-            result.appendFormat("Socket Buffer size = %zd events\n",
-                                mSocketBufferSize/sizeof(sensors_event_t));
-            result.appendFormat("WakeLock Status: %s \n", mWakeLockAcquired ? "acquired" :
-                    "not held");
-            result.appendFormat("Mode :");
-            switch(mCurrentOperatingMode) {
-               case NORMAL:
-                   result.appendFormat(" NORMAL\n");
-                   break;
-               case RESTRICTED:
-                   result.appendFormat(" RESTRICTED : %s\n", mAllowListedPackage.string());
-                   break;
-               case DATA_INJECTION:
-                   result.appendFormat(" DATA_INJECTION : %s\n", mAllowListedPackage.string());
-                   break;
-               case REPLAY_DATA_INJECTION:
-                   result.appendFormat(" REPLAY_DATA_INJECTION : %s\n",
-                            mAllowListedPackage.string());
-                   break;
-               default:
-                   result.appendFormat(" UNKNOWN\n");
-                   break;
-            }
-            result.appendFormat("Sensor Privacy: %s\n",
-                    mSensorPrivacyPolicy->isSensorPrivacyEnabled() ? "enabled" : "disabled");
-
-            const auto& activeConnections = connLock.getActiveConnections();
-            result.appendFormat("%zd active connections\n", activeConnections.size());
-            for (size_t i=0 ; i < activeConnections.size() ; i++) {
-                result.appendFormat("Connection Number: %zu \n", i);
-                activeConnections[i]->dump(result);
-            }
+                result.appendFormat("Socket Buffer size = %zd events\n",
+                                    mSocketBufferSize/sizeof(sensors_event_t));
+                result.appendFormat("WakeLock Status: %s \n", mWakeLockAcquired ? "acquired" :
+                        "not held");
+                result.appendFormat("Mode :");
+                switch(mCurrentOperatingMode) {
+                   case NORMAL:
+                       result.appendFormat(" NORMAL\n");
+                       break;
+                   case RESTRICTED:
+                       result.appendFormat(" RESTRICTED : %s\n", mAllowListedPackage.string());
+                       break;
+                   case DATA_INJECTION:
+                       result.appendFormat(" DATA_INJECTION : %s\n", mAllowListedPackage.string());
+                       break;
+                   case REPLAY_DATA_INJECTION:
+                       result.appendFormat(" REPLAY_DATA_INJECTION : %s\n",
+                                mAllowListedPackage.string());
+                       break;
+                   default:
+                       result.appendFormat(" UNKNOWN\n");
+                       break;
+                }
+                result.appendFormat("Sensor Privacy: %s\n",
+                        mSensorPrivacyPolicy->isSensorPrivacyEnabled() ? "enabled" : "disabled");
+
+                const auto& activeConnections = connLock.getActiveConnections();
+                result.appendFormat("%zd active connections\n", activeConnections.size());
+                for (size_t i=0 ; i < activeConnections.size() ; i++) {
+                    result.appendFormat("Connection Number: %zu \n", i);
+                    activeConnections[i]->dump(result);
+                }
 
-            const auto& directConnections = connLock.getDirectConnections();
-            result.appendFormat("%zd direct connections\n", directConnections.size());
-            for (size_t i = 0 ; i < directConnections.size() ; i++) {
-                result.appendFormat("Direct connection %zu:\n", i);
-                directConnections[i]->dump(result);
-            }
+                const auto& directConnections = connLock.getDirectConnections();
+                result.appendFormat("%zd direct connections\n", directConnections.size());
+                for (size_t i = 0 ; i < directConnections.size() ; i++) {
+                    result.appendFormat("Direct connection %zu:\n", i);
+                    directConnections[i]->dump(result);
+                }
 
-            result.appendFormat("Previous Registrations:\n");
-            // Log in the reverse chronological order.
-            int currentIndex = (mNextSensorRegIndex - 1 + SENSOR_REGISTRATIONS_BUF_SIZE) %
-                SENSOR_REGISTRATIONS_BUF_SIZE;
-            const int startIndex = currentIndex;
-            do {
-                const SensorRegistrationInfo& reg_info = mLastNSensorRegistrations[currentIndex];
-                if (SensorRegistrationInfo::isSentinel(reg_info)) {
-                    // Ignore sentinel, proceed to next item.
+                result.appendFormat("Previous Registrations:\n");
+                // Log in the reverse chronological order.
+                int currentIndex = (mNextSensorRegIndex - 1 + SENSOR_REGISTRATIONS_BUF_SIZE) %
+                    SENSOR_REGISTRATIONS_BUF_SIZE;
+                const int startIndex = currentIndex;
+                do {
+                    const SensorRegistrationInfo& reg_info =
+                            mLastNSensorRegistrations[currentIndex];
+                    if (SensorRegistrationInfo::isSentinel(reg_info)) {
+                        // Ignore sentinel, proceed to next item.
+                        currentIndex = (currentIndex - 1 + SENSOR_REGISTRATIONS_BUF_SIZE) %
+                            SENSOR_REGISTRATIONS_BUF_SIZE;
+                        continue;
+                    }
+                    result.appendFormat("%s\n", reg_info.dump().c_str());
                     currentIndex = (currentIndex - 1 + SENSOR_REGISTRATIONS_BUF_SIZE) %
-                        SENSOR_REGISTRATIONS_BUF_SIZE;
-                    continue;
-                }
-                result.appendFormat("%s\n", reg_info.dump().c_str());
-                currentIndex = (currentIndex - 1 + SENSOR_REGISTRATIONS_BUF_SIZE) %
-                        SENSOR_REGISTRATIONS_BUF_SIZE;
-            } while(startIndex != currentIndex);
+                            SENSOR_REGISTRATIONS_BUF_SIZE;
+                } while(startIndex != currentIndex);
+            }
+        }
+
+        String8 recentEventsResult;
+        for (const RecentEventsDump& recent : recentEvents) {
+            recentEventsResult.appendFormat("%s: ", recent.name.string());
+            recentEventsResult.append(recent.logger->dump(recent.maskData).c_str());
         }
+        write(fd, result.string(), recentEventsOffset);
+        write(fd, recentEventsResult.string(), recentEventsResult.size());
+        write(fd, result.string() + recentEventsOffset, result.size() - recentEventsOffset);
+        return NO_ERROR;
     }
     write(fd, result.string(), result.size());
     return NO_ERROR;
@@ -1017,8 +1030,8 @@ status_t SensorService::printHelp(int out) {
 
 //TODO: move to SensorEventConnection later
 void SensorService::cleanupAutoDisabledSensorLocked(const sp<SensorEventConnection>& connection,
-        sensors_event_t const* buffer, const int count) {
-    for (int i=0 ; i<count ; i++) {
+        sensors_event_t const* buffer, const std::vector<uint32_t>& eventIndices) {
+    for (uint32_t i : eventIndices) {
         int handle = buffer[i].sensor;
         if (buffer[i].type == SENSOR_TYPE_META_DATA) {
             handle = buffer[i].meta_data.sensor;
@@ -1037,6 +1050,35 @@ void SensorService::cleanupAutoDisabledSensorLocked(const sp<SensorEventConnecti
    }
 }
 
+void SensorService::buildEventFanOutLocked(
+        const std::vector<sp<SensorEventConnection>>& connections, sensors_event_t const* buffer,
+        size_t count) {
+    mConnectionEventIndices.resize(connections.size());
+    for (std::vector<uint32_t>& indices : mConnectionEventIndices) {
+        indices.clear();
+    }
+    mHandleSubscribers.clear();
+
+    // A batch usually only holds events from a few sensors, so look up the subscribers of each
+    // handle once and then append each event only to the connections that want it.
+    for (size_t i = 0; i < count; i++) {
+        const int handle = buffer[i].type == SENSOR_TYPE_META_DATA ? buffer[i].meta_data.sensor
+                                                                    : buffer[i].sensor;
+        auto [it, inserted] = mHandleSubscribers.try_emplace(handle);
+        std::vector<uint32_t>& subscribers = it->second;
+        if (inserted) {
+            for (size_t c = 0; c < connections.size(); c++) {
+                if (connections[c]->hasSensor(handle)) {
+                    subscribers.push_back(c);
+                }
+            }
+        }
+        for (uint32_t c : subscribers) {
+            mConnectionEventIndices[c].push_back(i);
+        }
+    }
+}
+
 bool SensorService::threadLoop() {
     ALOGD("nuSensorService thread starting...");
 
@@ -1096,9 +1138,7 @@ bool SensorService::threadLoop() {
                 size_t k = 0;
                 SensorFusion& fusion(SensorFusion::getInstance());
                 if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
-                    }
+                    fusion.process(event, count);
                 }
                 for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
                     for (int handle : mActiveVirtualSensors) {
@@ -1229,17 +1269,21 @@ bool SensorService::threadLoop() {
             }
         }
 
-        // Send our events to clients. Check the state of wake lock for each client and release the
-        // lock if none of the clients need it.
+        // Send our events to clients, each only being handed the events for its own sensors.
+        // Check the state of wake lock for each client and release the lock if none of the
+        // clients need it.
+        buildEventFanOutLocked(activeConnections, mSensorEventBuffer, count);
         bool needsWakeLock = false;
-        for (const sp<SensorEventConnection>& connection : activeConnections) {
+        for (size_t c = 0; c < activeConnections.size(); c++) {
+            const sp<SensorEventConnection>& connection = activeConnections[c];
             connection->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
-                    mMapFlushEventsToConnections);
+                    mMapFlushEventsToConnections, &mConnectionEventIndices[c]);
             needsWakeLock |= connection->needsWakeLock();
             // If the connection has one-shot sensors, it may be cleaned up after first trigger.
             // Early check for one-shot sensors.
             if (connection->hasOneShotSensors()) {
-                cleanupAutoDisabledSensorLocked(connection, mSensorEventBuffer, count);
+                cleanupAutoDisabledSensorLocked(connection, mSensorEventBuffer,
+                                                mConnectionEventIndices[c]);
             }
         }
 
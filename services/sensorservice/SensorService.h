@@ -42,6 +42,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <memory>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -400,7 +401,10 @@ private:
     status_t cleanupWithoutDisable(const sp<SensorEventConnection>& connection, int handle);
     status_t cleanupWithoutDisableLocked(const sp<SensorEventConnection>& connection, int handle);
     void cleanupAutoDisabledSensorLocked(const sp<SensorEventConnection>& connection,
-            sensors_event_t const* buffer, const int count);
+            sensors_event_t const* buffer, const std::vector<uint32_t>& eventIndices);
+    // Fills mConnectionEventIndices with the events in buffer for each of connections.
+    void buildEventFanOutLocked(const std::vector<sp<SensorEventConnection>>& connections,
+            sensors_event_t const* buffer, size_t count);
     bool canAccessSensor(const Sensor& sensor, const char* operation,
             const String16& opPackageName);
     void addSensorIfAccessible(const String16& opPackageName, const Sensor& sensor,
@@ -523,7 +527,13 @@ private:
     // WARNING: these SensorEventConnection instances must not be promoted to sp, except via
     // modification to add support for them in ConnectionSafeAutolock
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
-    std::unordered_map<int, SensorServiceUtil::RecentEventLogger*> mRecentEvent;
+    // Rebuilt by threadLoop for every poll: for each active connection, the indices into
+    // mSensorEventBuffer of the events it registered for, and for each sensor handle in the
+    // current buffer, the active connections registered for it.
+    std::vector<std::vector<uint32_t>> mConnectionEventIndices;
+    std::unordered_map<int, std::vector<uint32_t>> mHandleSubscribers;
+    // Shared so that dump() can format recent events after releasing mLock.
+    std::unordered_map<int, std::shared_ptr<SensorServiceUtil::RecentEventLogger>> mRecentEvent;
     Mode mCurrentOperatingMode;
     std::queue<sensors_event_t> mRuntimeSensorEventQueue;
     std::unordered_map</*deviceId*/int, sp<RuntimeSensorCallback>> mRuntimeSensorCallbacks;
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_SERVICE_UTIL_SEQLOCK_RING_BUFFER_H
+#define ANDROID_SENSOR_SERVICE_UTIL_SEQLOCK_RING_BUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace android {
+namespace SensorServiceUtil {
+
+/**
+ * A fixed size ring of the last N items added by a single writer, which any number of readers can
+ * copy out without ever blocking the writer. Each slot is protected by its own sequence count: the
+ * writer makes it odd while it copies an item in, and a reader retries, or skips the slot, if the
+ * count changed while it was copying the item out.
+ *
+ * Items are stored as relaxed atomic words, so T must be trivially copyable.
+ */
+template <class T>
+class SeqLockRingBuffer final {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+    /**
+     * Construct a SeqLockRingBuffer holding up to the given number of items.
+     */
+    explicit SeqLockRingBuffer(size_t length)
+            : mLength(std::max<size_t>(length, 1)), mSlots(new Slot[mLength]), mAdded(0) {}
+
+    SeqLockRingBuffer(const SeqLockRingBuffer&) = delete;
+    SeqLockRingBuffer& operator=(const SeqLockRingBuffer&) = delete;
+
+    /**
+     * Adds item to the front of this buffer, replacing the oldest item if it is full. Must only be
+     * called from one thread at a time.
+     */
+    void add(const T& item) {
+        const uint64_t index = mAdded.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[index % mLength];
+        const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Words words{};
+        memcpy(words.data(), &item, sizeof(T));
+        for (size_t i = 0; i < words.size(); i++) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        slot.seq.store(seq + 2, std::memory_order_release);
+        mAdded.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * Copies the most recently added item to item. Returns false if nothing was added yet, or if
+     * the writer kept overwriting the item while it was being copied.
+     */
+    bool front(T* item) const {
+        const uint64_t added = mAdded.load(std::memory_order_acquire);
+        return added != 0 && read(added - 1, item);
+    }
+
+    /**
+     * Replaces the contents of items with the items currently in this buffer, the most recently
+     * added one first. Items overwritten while they were being copied are left out.
+     */
+    void snapshot(std::vector<T>* items) const {
+        items->clear();
+        const uint64_t added = mAdded.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(added, mLength);
+        items->reserve(count);
+        T item;
+        for (uint64_t i = 1; i <= count; i++) {
+            if (read(added - i, &item)) {
+                items->push_back(item);
+            }
+        }
+    }
+
+    /**
+     * Return the number of items in this buffer, which may already be stale.
+     */
+    size_t size() const {
+        return std::min<uint64_t>(mAdded.load(std::memory_order_relaxed), mLength);
+    }
+
+    bool empty() const { return mAdded.load(std::memory_order_relaxed) == 0; }
+
+private:
+    // A reader gives up on a slot the writer keeps rewriting rather than spin.
+    static constexpr int kMaxReadAttempts = 4;
+
+    using Words = std::array<uint64_t, (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)>;
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::array<std::atomic<uint64_t>, std::tuple_size<Words>::value> words{};
+    };
+
+    // Reads the item added as the index'th one, if it is still in its slot.
+    bool read(uint64_t index, T* item) const {
+        const Slot& slot = mSlots[index % mLength];
+        // Each write to a slot adds two, so this is the count once the item has been written, and
+        // before the next item in this slot overwrites it.
+        const uint64_t expected = 2 * (index / mLength + 1);
+        for (int attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != expected) {
+                if (seq > expected) {
+                    return false;
+                }
+                continue;
+            }
+            Words words;
+            for (size_t i = 0; i < words.size(); i++) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                memcpy(item, words.data(), sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const size_t mLength;
+    const std::unique_ptr<Slot[]> mSlots;
+    std::atomic<uint64_t> mAdded;
+};
+
+} // namespace SensorServiceUtil
+} // namespace android;
+
+#endif // ANDROID_SENSOR_SERVICE_UTIL_SEQLOCK_RING_BUFFER_H
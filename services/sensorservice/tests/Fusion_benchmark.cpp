@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+
+#include <vector>
+
+#include "../Fusion.h"
+
+namespace android {
+namespace {
+
+enum SampleType { GYRO, ACC, MAG };
+
+vec3_t vec3(float x, float y, float z) {
+    vec3_t v;
+    v.x = x;
+    v.y = y;
+    v.z = z;
+    return v;
+}
+
+struct Sample {
+    SampleType type;
+    vec3_t value;
+    float dT;
+};
+
+// One second of a phone slowly turning on a desk, as the FIFO of a 400Hz gyro, 100Hz
+// accelerometer and 50Hz magnetometer would flush it: the samples of each sensor are
+// interleaved in timestamp order.
+std::vector<Sample> makeLog() {
+    constexpr int kGyroRate = 400;
+    std::vector<Sample> log;
+    for (int i = 0; i < kGyroRate; i++) {
+        const float t = float(i) / kGyroRate;
+        const float angle = 0.5f * t;
+        log.push_back({GYRO, vec3(0.01f, -0.02f, 0.5f), 1.0f / kGyroRate});
+        if (i % 4 == 0) {
+            log.push_back({ACC, vec3(0.05f * sinf(angle), 0.05f * cosf(angle), 9.81f),
+                           4.0f / kGyroRate});
+        }
+        if (i % 8 == 0) {
+            log.push_back({MAG, vec3(20.0f * cosf(angle), -20.0f * sinf(angle), -40.0f), 0});
+        }
+    }
+    return log;
+}
+
+// Brings up the estimate, so that the timed loops only measure steady-state fusion.
+void warmUp(Fusion* fusion, const std::vector<Sample>& log) {
+    fusion->init(FUSION_9AXIS);
+    for (const Sample& sample : log) {
+        switch (sample.type) {
+            case GYRO:
+                fusion->handleGyro(sample.value, sample.dT);
+                break;
+            case ACC:
+                fusion->handleAcc(sample.value, sample.dT);
+                break;
+            case MAG:
+                fusion->handleMag(sample.value);
+                break;
+        }
+    }
+}
+
+void BM_fusionPerSample(benchmark::State& state) {
+    const std::vector<Sample> log = makeLog();
+    Fusion fusion;
+    warmUp(&fusion, log);
+    for (auto _ : state) {
+        for (const Sample& sample : log) {
+            switch (sample.type) {
+                case GYRO:
+                    fusion.handleGyro(sample.value, sample.dT);
+                    break;
+                case ACC:
+                    fusion.handleAcc(sample.value, sample.dT);
+                    break;
+                case MAG:
+                    fusion.handleMag(sample.value);
+                    break;
+            }
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BM_fusionPerSample);
+
+void BM_fusionBatchedGyro(benchmark::State& state) {
+    const std::vector<Sample> log = makeLog();
+    Fusion fusion;
+    warmUp(&fusion, log);
+    std::vector<vec3_t> gyro;
+    std::vector<float> gyroDt;
+    for (auto _ : state) {
+        for (size_t i = 0; i < log.size();) {
+            if (log[i].type != GYRO) {
+                if (log[i].type == ACC) {
+                    fusion.handleAcc(log[i].value, log[i].dT);
+                } else {
+                    fusion.handleMag(log[i].value);
+                }
+                i++;
+                continue;
+            }
+            gyro.clear();
+            gyroDt.clear();
+            for (; i < log.size() && log[i].type == GYRO; i++) {
+                gyro.push_back(log[i].value);
+                gyroDt.push_back(log[i].dT);
+            }
+            fusion.handleGyro(gyro.data(), gyroDt.data(), gyro.size());
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BM_fusionBatchedGyro);
+
+// A FIFO flush of a batched gyro, with no other samples in between.
+void BM_gyroFlushPerSample(benchmark::State& state) {
+    const std::vector<Sample> log = makeLog();
+    Fusion fusion;
+    warmUp(&fusion, log);
+    const vec3_t w = vec3(0.01f, -0.02f, 0.5f);
+    const size_t count = state.range();
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; i++) {
+            fusion.handleGyro(w, 1.0f / 400);
+        }
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_gyroFlushPerSample)->Arg(64)->Arg(1024);
+
+void BM_gyroFlushBatched(benchmark::State& state) {
+    const std::vector<Sample> log = makeLog();
+    Fusion fusion;
+    warmUp(&fusion, log);
+    const std::vector<vec3_t> w(state.range(), vec3(0.01f, -0.02f, 0.5f));
+    const std::vector<float> dT(state.range(), 1.0f / 400);
+    for (auto _ : state) {
+        fusion.handleGyro(w.data(), dT.data(), w.size());
+        benchmark::DoNotOptimize(fusion.getAttitude());
+    }
+    state.SetItemsProcessed(state.iterations() * w.size());
+}
+BENCHMARK(BM_gyroFlushBatched)->Arg(64)->Arg(1024);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "../SeqLockRingBuffer.h"
+
+namespace android {
+namespace SensorServiceUtil {
+namespace {
+
+// Spans several words, so that a read racing with the writer could copy out parts of two items.
+struct Item {
+    uint64_t values[8];
+};
+
+Item makeItem(uint64_t value) {
+    Item item;
+    std::fill(std::begin(item.values), std::end(item.values), value);
+    return item;
+}
+
+bool isTorn(const Item& item) {
+    return !std::all_of(std::begin(item.values), std::end(item.values),
+                        [&item](uint64_t value) { return value == item.values[0]; });
+}
+
+TEST(SeqLockRingBufferTest, Empty) {
+    SeqLockRingBuffer<Item> buffer(4);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(0u, buffer.size());
+
+    Item item;
+    EXPECT_FALSE(buffer.front(&item));
+    std::vector<Item> items{makeItem(1)};
+    buffer.snapshot(&items);
+    EXPECT_TRUE(items.empty());
+}
+
+TEST(SeqLockRingBufferTest, KeepsTheNewestItems) {
+    SeqLockRingBuffer<Item> buffer(3);
+    for (uint64_t i = 1; i <= 5; i++) {
+        buffer.add(makeItem(i));
+    }
+    EXPECT_EQ(3u, buffer.size());
+
+    Item item;
+    ASSERT_TRUE(buffer.front(&item));
+    EXPECT_EQ(5u, item.values[0]);
+
+    std::vector<Item> items;
+    buffer.snapshot(&items);
+    ASSERT_EQ(3u, items.size());
+    EXPECT_EQ(5u, items[0].values[0]);
+    EXPECT_EQ(4u, items[1].values[0]);
+    EXPECT_EQ(3u, items[2].values[0]);
+}
+
+TEST(SeqLockRingBufferTest, ReadsAreNotTornByConcurrentWriter) {
+    // A short buffer, so that the writer keeps overwriting the slots being read.
+    SeqLockRingBuffer<Item> buffer(2);
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        for (uint64_t i = 1; i <= 200000; i++) {
+            buffer.add(makeItem(i));
+        }
+        done = true;
+    });
+
+    size_t tornReads = 0;
+    size_t unorderedReads = 0;
+    uint64_t lastFront = 0;
+    std::vector<Item> items;
+    while (!done) {
+        Item item;
+        if (buffer.front(&item)) {
+            tornReads += isTorn(item);
+            unorderedReads += item.values[0] < lastFront;
+            lastFront = item.values[0];
+        }
+
+        buffer.snapshot(&items);
+        for (size_t i = 0; i < items.size(); i++) {
+            tornReads += isTorn(items[i]);
+            unorderedReads += i > 0 && items[i].values[0] >= items[i - 1].values[0];
+        }
+    }
+    writer.join();
+
+    EXPECT_EQ(0u, tornReads);
+    EXPECT_EQ(0u, unorderedReads);
+}
+
+} // namespace
+} // namespace SensorServiceUtil
+} // namespace android
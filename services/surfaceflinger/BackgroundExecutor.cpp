@@ -19,8 +19,12 @@
 #define LOG_TAG "BackgroundExecutor"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <ftl/enum.h>
+#include <pthread.h>
 #include <utils/Log.h>
+#include <condition_variable>
 #include <mutex>
+#include <string>
 
 #include "BackgroundExecutor.h"
 
@@ -29,49 +33,72 @@ namespace android {
 ANDROID_SINGLETON_STATIC_INSTANCE(BackgroundExecutor);
 
 BackgroundExecutor::BackgroundExecutor() : Singleton<BackgroundExecutor>() {
-    // mSemaphore must be initialized before any calls to
-    // BackgroundExecutor::sendCallbacks. For this reason, we initialize it
-    // within the constructor instead of within mThread.
-    LOG_ALWAYS_FATAL_IF(sem_init(&mSemaphore, 0, 0), "sem_init failed");
-    mThread = std::thread([&]() {
-        while (!mDone) {
-            LOG_ALWAYS_FATAL_IF(sem_wait(&mSemaphore), "sem_wait failed (%d)", errno);
-            auto callbacks = mCallbacksQueue.pop();
-            if (!callbacks) {
-                continue;
-            }
-            for (auto& callback : *callbacks) {
-                callback();
-            }
-        }
-    });
+    for (size_t i = 0; i < mLanes.size(); i++) {
+        Lane& lane = mLanes[i];
+        // The semaphore must be initialized before any calls to
+        // BackgroundExecutor::sendCallbacks. For this reason, we initialize it
+        // within the constructor instead of within the thread.
+        LOG_ALWAYS_FATAL_IF(sem_init(&lane.semaphore, 0, 0), "sem_init failed");
+        lane.thread = std::thread(&BackgroundExecutor::run, this, std::ref(lane));
+
+        const std::string name = "BgExec" + ftl::enum_string(static_cast<Priority>(i));
+        pthread_setname_np(lane.thread.native_handle(), name.c_str());
+    }
 }
 
 BackgroundExecutor::~BackgroundExecutor() {
     mDone = true;
-    LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
-    if (mThread.joinable()) {
-        mThread.join();
-        LOG_ALWAYS_FATAL_IF(sem_destroy(&mSemaphore), "sem_destroy failed");
+    for (Lane& lane : mLanes) {
+        LOG_ALWAYS_FATAL_IF(sem_post(&lane.semaphore), "sem_post failed");
+    }
+    for (Lane& lane : mLanes) {
+        if (lane.thread.joinable()) {
+            lane.thread.join();
+            LOG_ALWAYS_FATAL_IF(sem_destroy(&lane.semaphore), "sem_destroy failed");
+        }
+    }
+}
+
+void BackgroundExecutor::run(Lane& lane) {
+    while (!mDone) {
+        LOG_ALWAYS_FATAL_IF(sem_wait(&lane.semaphore), "sem_wait failed (%d)", errno);
+
+        // Drain until no batch was sent in the meantime. A sender that finds the count at zero
+        // afterwards posts the semaphore again.
+        for (;;) {
+            const size_t count = lane.pendingCount.load();
+            lane.callbacksQueue.drain([](Callbacks&& callbacks) {
+                for (auto& callback : callbacks) {
+                    callback();
+                }
+            });
+            if (lane.pendingCount.fetch_sub(count) == count) break;
+        }
     }
 }
 
-void BackgroundExecutor::sendCallbacks(Callbacks&& tasks) {
-    mCallbacksQueue.push(std::move(tasks));
-    LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
+void BackgroundExecutor::sendCallbacks(Callbacks&& tasks, Priority priority) {
+    Lane& lane = mLanes[ftl::to_underlying(priority)];
+    lane.callbacksQueue.push(std::move(tasks));
+    if (lane.pendingCount.fetch_add(1) == 0) {
+        LOG_ALWAYS_FATAL_IF(sem_post(&lane.semaphore), "sem_post failed");
+    }
 }
 
 void BackgroundExecutor::flushQueue() {
     std::mutex mutex;
     std::condition_variable cv;
-    bool flushComplete = false;
-    sendCallbacks({[&]() {
-        std::scoped_lock lock{mutex};
-        flushComplete = true;
-        cv.notify_one();
-    }});
+    size_t flushCount = 0;
+    for (size_t i = 0; i < mLanes.size(); i++) {
+        sendCallbacks({[&]() {
+                          std::scoped_lock lock{mutex};
+                          flushCount++;
+                          cv.notify_one();
+                      }},
+                      static_cast<Priority>(i));
+    }
     std::unique_lock<std::mutex> lock{mutex};
-    cv.wait(lock, [&]() { return flushComplete; });
+    cv.wait(lock, [&]() { return flushCount == mLanes.size(); });
 }
 
 } // namespace android
@@ -16,9 +16,11 @@
 
 #pragma once
 
+#include <ftl/enum.h>
 #include <ftl/small_vector.h>
 #include <semaphore.h>
 #include <utils/Singleton.h>
+#include <array>
 #include <thread>
 
 #include "LocklessQueue.h"
@@ -26,22 +28,43 @@
 namespace android {
 
 // Executes tasks off the main thread.
+//
+// Tasks are queued onto lanes by priority, each served by its own thread in FIFO order, so that
+// latency-sensitive work does not wait behind slow work on another lane.
 class BackgroundExecutor : public Singleton<BackgroundExecutor> {
 public:
+    enum class Priority {
+        // Work that a client is blocked on, e.g. transaction callbacks releasing buffers.
+        High,
+        // Everything else, e.g. window info broadcasts.
+        Normal,
+        ftl_last = Normal
+    };
+
     BackgroundExecutor();
     ~BackgroundExecutor();
     using Callbacks = ftl::SmallVector<std::function<void()>, 10>;
-    // Queues callbacks onto a work queue to be executed by a background thread.
+    // Queues callbacks onto a work queue to be executed by a background thread. Callbacks sent
+    // with the same priority run in the order they were sent.
     // This is safe to call from multiple threads.
-    void sendCallbacks(Callbacks&& tasks);
+    void sendCallbacks(Callbacks&& tasks, Priority priority = Priority::Normal);
+    // Waits until the callbacks sent to every lane so far have run.
     void flushQueue();
 
 private:
-    sem_t mSemaphore;
-    std::atomic_bool mDone = false;
+    struct Lane {
+        sem_t semaphore;
+        // Batches sent but not yet accounted for by the thread. Only the sender that raises the
+        // count from zero posts the semaphore, so a burst of sends costs a single wakeup.
+        std::atomic<size_t> pendingCount = 0;
+        LocklessQueue<Callbacks> callbacksQueue;
+        std::thread thread;
+    };
 
-    LocklessQueue<Callbacks> mCallbacksQueue;
-    std::thread mThread;
+    void run(Lane&);
+
+    std::atomic_bool mDone = false;
+    std::array<Lane, ftl::enum_size_v<Priority>> mLanes;
 };
 
 } // namespace android
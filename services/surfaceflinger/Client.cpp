@@ -60,6 +60,27 @@ binder::Status Client::createSurface(const std::string& name, int32_t flags,
     return binderStatusFromStatusT(status);
 }
 
+binder::Status Client::createSurfaces(const std::vector<gui::CreateSurfaceArgs>& args,
+                                      std::vector<gui::CreateSurfaceResult>* outResults) {
+    // Creating the layers in one call saves a round trip per layer, and lets them be committed
+    // together since the first layer only schedules the commit.
+    outResults->clear();
+    outResults->reserve(args.size());
+    for (const auto& surfaceArgs : args) {
+        LayerCreationArgs layerArgs(mFlinger.get(), sp<Client>::fromExisting(this), surfaceArgs.name,
+                                    static_cast<uint32_t>(surfaceArgs.flags), surfaceArgs.metadata);
+        layerArgs.parentHandle = surfaceArgs.parent;
+        const status_t status = mFlinger->createLayer(layerArgs, outResults->emplace_back());
+        if (status != NO_ERROR) {
+            // Nothing else holds the handles of the layers created so far, so releasing them
+            // destroys those layers.
+            outResults->clear();
+            return binderStatusFromStatusT(status);
+        }
+    }
+    return binder::Status::ok();
+}
+
 binder::Status Client::clearLayerFrameStats(const sp<IBinder>& handle) {
     status_t status;
     sp<Layer> layer = LayerHandle::getLayer(handle);
@@ -45,6 +45,9 @@ private:
                                  const gui::LayerMetadata& metadata,
                                  gui::CreateSurfaceResult* outResult) override;
 
+    binder::Status createSurfaces(const std::vector<gui::CreateSurfaceArgs>& args,
+                                  std::vector<gui::CreateSurfaceResult>* outResults) override;
+
     binder::Status clearLayerFrameStats(const sp<IBinder>& handle) override;
 
     binder::Status getLayerFrameStats(const sp<IBinder>& handle,
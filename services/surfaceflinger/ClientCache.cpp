@@ -19,11 +19,14 @@
 #define LOG_TAG "ClientCache"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <sys/stat.h>
+
 #include <cinttypes>
 
 #include <android-base/stringprintf.h>
 #include <gui/TraceUtils.h>
 #include <renderengine/impl/ExternalTexture.h>
+#include <ui/PixelFormat.h>
 
 #include "ClientCache.h"
 
@@ -112,10 +115,105 @@ ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer)
                         "Attempted to build the ClientCache before a RenderEngine instance was "
                         "ready!");
 
-    return (processBuffers[id].buffer = std::make_shared<
-                    renderengine::impl::ExternalTexture>(buffer, *mRenderEngine,
-                                                         renderengine::impl::ExternalTexture::
-                                                                 Usage::READABLE));
+    if (auto texture = getSharedTexture(buffer)) {
+        ATRACE_NAME("ClientCache::add - shared texture");
+        return (processBuffers[id].buffer = std::move(texture));
+    }
+
+    std::shared_ptr<renderengine::ExternalTexture> texture = std::make_shared<
+            renderengine::impl::ExternalTexture>(buffer, *mRenderEngine,
+                                                 renderengine::impl::ExternalTexture::Usage::
+                                                         READABLE);
+    if (const auto identity = getBufferIdentity(buffer)) {
+        if (mSharedTextures.size() >= mSharedTexturesPruneSize) {
+            for (auto it = mSharedTextures.begin(); it != mSharedTextures.end();) {
+                it = it->second.texture.expired() ? mSharedTextures.erase(it) : std::next(it);
+            }
+            mSharedTexturesPruneSize =
+                    std::max<size_t>(BUFFER_CACHE_MAX_SIZE, mSharedTextures.size() * 2);
+        }
+        mSharedTextures[buffer->getId()] = {.texture = texture, .identity = *identity};
+    }
+    return (processBuffers[id].buffer = std::move(texture));
+}
+
+std::optional<ClientCache::BufferIdentity> ClientCache::getBufferIdentity(
+        const sp<GraphicBuffer>& buffer) {
+    const native_handle_t* handle = buffer->handle;
+    if (handle == nullptr || handle->numFds < 1) {
+        return std::nullopt;
+    }
+    struct stat st;
+    if (fstat(handle->data[0], &st) != 0) {
+        return std::nullopt;
+    }
+    return BufferIdentity{.device = st.st_dev, .inode = st.st_ino};
+}
+
+std::shared_ptr<renderengine::ExternalTexture> ClientCache::getSharedTexture(
+        const sp<GraphicBuffer>& buffer) {
+    auto it = mSharedTextures.find(buffer->getId());
+    if (it == mSharedTextures.end()) {
+        return nullptr;
+    }
+    auto& sharedTexture = it->second;
+    std::shared_ptr<renderengine::ExternalTexture> texture = sharedTexture.texture.lock();
+    const auto identity = getBufferIdentity(buffer);
+    if (!texture || !identity || !(*identity == sharedTexture.identity)) {
+        return nullptr;
+    }
+    if (sharedTexture.retained) {
+        releaseRetainedTexture(*sharedTexture.retained);
+    }
+    return texture;
+}
+
+void ClientCache::retainTexture(std::shared_ptr<renderengine::ExternalTexture> texture,
+                                const wp<IBinder>& processToken) {
+    auto it = mSharedTextures.find(texture->getId());
+    if (it == mSharedTextures.end() || it->second.retained ||
+        it->second.texture.lock() != texture) {
+        return;
+    }
+
+    const sp<GraphicBuffer>& buffer = texture->getBuffer();
+    const uint32_t bytesPerPixel = android::bytesPerPixel(buffer->getPixelFormat());
+    // Formats without a fixed pixel size are mostly YUV, so this overestimates them.
+    const size_t bytes = static_cast<size_t>(buffer->getStride()) * buffer->getHeight() *
+            (bytesPerPixel > 0 ? bytesPerPixel : 4);
+    if (bytes > kRetainedTexturesBudgetBytes) {
+        return;
+    }
+
+    const nsecs_t now = systemTime();
+    releaseExpiredTexturesLocked(now);
+    mRetainedTextures.push_front({std::move(texture), processToken, bytes, now});
+    mRetainedBytes += bytes;
+    it->second.retained = mRetainedTextures.begin();
+
+    while (mRetainedBytes > kRetainedTexturesBudgetBytes) {
+        releaseRetainedTexture(std::prev(mRetainedTextures.end()));
+    }
+}
+
+void ClientCache::releaseExpiredTextures(nsecs_t now) {
+    std::lock_guard lock(mMutex);
+    releaseExpiredTexturesLocked(now);
+}
+
+void ClientCache::releaseExpiredTexturesLocked(nsecs_t now) {
+    while (!mRetainedTextures.empty() &&
+           now - mRetainedTextures.back().erasedTime >= kRetainedTextureTimeout.count()) {
+        releaseRetainedTexture(std::prev(mRetainedTextures.end()));
+    }
+}
+
+void ClientCache::releaseRetainedTexture(RetainedTextures::iterator it) {
+    if (auto shared = mSharedTextures.find(it->texture->getId()); shared != mSharedTextures.end()) {
+        shared->second.retained.reset();
+    }
+    mRetainedBytes -= it->bytes;
+    mRetainedTextures.erase(it);
 }
 
 sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
@@ -139,6 +237,7 @@ sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
             }
         }
 
+        retainTexture(std::move(buf->buffer), processToken);
         mBuffers[processToken].second.erase(id);
     }
 
@@ -210,6 +309,15 @@ void ClientCache::removeProcess(const wp<IBinder>& processToken) {
             }
         }
         mBuffers.erase(itr);
+
+        // The process is gone, so it will not cache its buffers again.
+        for (auto it = mRetainedTextures.begin(); it != mRetainedTextures.end();) {
+            auto next = std::next(it);
+            if (it->processToken == processToken) {
+                releaseRetainedTexture(it);
+            }
+            it = next;
+        }
     }
 
     for (auto& [recipient, cacheId] : pendingErase) {
@@ -223,6 +331,9 @@ void ClientCache::CacheDeathRecipient::binderDied(const wp<IBinder>& who) {
 
 void ClientCache::dump(std::string& result) {
     std::lock_guard lock(mMutex);
+    base::StringAppendF(&result, " Retained textures: %zu (%zu KiB of %zu KiB)\n",
+                        mRetainedTextures.size(), mRetainedBytes / 1024,
+                        kRetainedTexturesBudgetBytes / 1024);
     for (const auto& [_, cache] : mBuffers) {
         base::StringAppendF(&result, " Cache owner: %p\n", cache.first.get());
 
@@ -23,9 +23,15 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/RefBase.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
 
+#include <sys/types.h>
+
+#include <chrono>
+#include <list>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <unordered_map>
 
@@ -44,6 +50,11 @@ namespace android {
 // both the SurfaceFlinger side of this other cache, as well as Composer HAL's
 // side of the cache.
 //
+// RenderEngine textures are shared between cache entries of the same buffer, e.g. a buffer cached
+// by several processes. Textures of erased entries are retained for a short time within a memory
+// budget, so that a buffer cached again shortly after does not have to be mapped into RenderEngine
+// again.
+//
 class ClientCache : public Singleton<ClientCache> {
 public:
     ClientCache();
@@ -63,6 +74,12 @@ public:
 
     void removeProcess(const wp<IBinder>& processToken);
 
+    // Textures of erased entries are released once they have been retained this long.
+    static constexpr std::chrono::nanoseconds kRetainedTextureTimeout = std::chrono::seconds(1);
+
+    // Releases the textures of entries erased at least kRetainedTextureTimeout before now.
+    void releaseExpiredTextures(nsecs_t now = systemTime());
+
     class ErasedRecipient : public virtual RefBase {
     public:
         virtual void bufferErased(const client_cache_t& clientCacheId) = 0;
@@ -97,6 +114,50 @@ private:
 
     bool getBuffer(const client_cache_t& cacheId, ClientCacheBuffer** outClientCacheBuffer)
             REQUIRES(mMutex);
+
+    // Identifies the memory of a buffer, since buffer ids may be reused by a process that took
+    // over the pid of a dead one.
+    struct BufferIdentity {
+        dev_t device;
+        ino_t inode;
+
+        bool operator==(const BufferIdentity& other) const {
+            return device == other.device && inode == other.inode;
+        }
+    };
+    static std::optional<BufferIdentity> getBufferIdentity(const sp<GraphicBuffer>& buffer);
+
+    struct RetainedTexture {
+        std::shared_ptr<renderengine::ExternalTexture> texture;
+        wp<IBinder> processToken;
+        size_t bytes;
+        nsecs_t erasedTime;
+    };
+    using RetainedTextures = std::list<RetainedTexture>;
+
+    struct SharedTexture {
+        std::weak_ptr<renderengine::ExternalTexture> texture;
+        BufferIdentity identity;
+        // Set while the texture is only kept alive by mRetainedTextures.
+        std::optional<RetainedTextures::iterator> retained;
+    };
+
+    std::shared_ptr<renderengine::ExternalTexture> getSharedTexture(const sp<GraphicBuffer>& buffer)
+            REQUIRES(mMutex);
+    void retainTexture(std::shared_ptr<renderengine::ExternalTexture> texture,
+                       const wp<IBinder>& processToken) REQUIRES(mMutex);
+    void releaseRetainedTexture(RetainedTextures::iterator it) REQUIRES(mMutex);
+    void releaseExpiredTexturesLocked(nsecs_t now) REQUIRES(mMutex);
+
+    static constexpr size_t kRetainedTexturesBudgetBytes = 32 * 1024 * 1024;
+
+    // Textures by buffer id. Expired entries are pruned whenever the map doubles in size.
+    std::unordered_map<uint64_t, SharedTexture> mSharedTextures GUARDED_BY(mMutex);
+    size_t mSharedTexturesPruneSize GUARDED_BY(mMutex) = BUFFER_CACHE_MAX_SIZE;
+
+    // Textures of erased entries, most recently erased first.
+    RetainedTextures mRetainedTextures GUARDED_BY(mMutex);
+    size_t mRetainedBytes GUARDED_BY(mMutex) = 0;
 };
 
 }; // namespace android
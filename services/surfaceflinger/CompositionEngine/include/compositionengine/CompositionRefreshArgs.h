@@ -96,6 +96,16 @@ struct CompositionRefreshArgs {
     std::vector<BorderRenderInfo> borderInfoList;
 
     bool hasTrustedPresentationListener = false;
+
+    // If true, and more than one output is being refreshed, each output is presented on its own
+    // worker thread rather than one after another on the calling thread. present() still does
+    // not return until every output has been presented.
+    bool multithreadedPresent = false;
+
+    // If non-zero, outputs with at least this many layers update the composition state of their
+    // layers in chunks on a shared worker pool rather than one after another. The resulting state
+    // is the same either way.
+    size_t parallelLayerUpdateThreshold = 0;
 };
 
 } // namespace android::compositionengine
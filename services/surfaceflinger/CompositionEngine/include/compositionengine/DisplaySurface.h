@@ -27,6 +27,7 @@ namespace android {
 
 class Fence;
 class IGraphicBufferProducer;
+class Region;
 class String8;
 
 /* QTI_BEGIN */
@@ -51,6 +52,11 @@ public:
     // machine happy without actually queueing a buffer if nothing has changed.
     virtual status_t beginFrame(bool mustRecompose) = 0;
 
+    // Sets the region of the output buffer that changes this frame, in buffer coordinates. A
+    // surface that passes its buffers on to another consumer, e.g. a video encoder, can forward it
+    // as the surface damage of the buffer.
+    virtual void setFrameDamage(const Region& damage);
+
     // prepareFrame is called after the composition configuration is known but
     // before composition takes place. The DisplaySurface can use the
     // composition type to decide how to manage the flow of buffers between
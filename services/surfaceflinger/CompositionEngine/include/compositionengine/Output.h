@@ -273,6 +273,9 @@ public:
     // Enables overriding the 170M trasnfer function as sRGB
     virtual void setTreat170mAsSrgb(bool) = 0;
 
+    // Enables limiting client composition to the damaged region of the client target
+    virtual void setPartialClientComposition(bool) = 0;
+
 protected:
     virtual void setDisplayColorProfile(std::unique_ptr<DisplayColorProfile>) = 0;
     virtual void setRenderSurface(std::unique_ptr<RenderSurface>) = 0;
@@ -295,6 +298,9 @@ protected:
     // Runs prepare frame in another thread while running client composition using
     // the previous frame's composition strategy.
     virtual GpuCompositionResult prepareFrameAsync() = 0;
+    // Runs prepare frame in another thread while dequeuing the client target, for frames whose
+    // composition strategy cannot be predicted but which are likely to use client composition.
+    virtual GpuCompositionResult prepareFrameWithEarlyDequeue() = 0;
     virtual void devOptRepaintFlash(const CompositionRefreshArgs&) = 0;
     virtual void finishFrame(GpuCompositionResult&&) = 0;
     virtual std::optional<base::unique_fd> composeSurfaces(
@@ -318,6 +324,7 @@ protected:
     virtual bool isPowerHintSessionEnabled() = 0;
     virtual void cacheClientCompositionRequests(uint32_t cacheSize) = 0;
     virtual bool canPredictCompositionStrategy(const CompositionRefreshArgs&) = 0;
+    virtual bool canDequeueClientTargetEarly(const CompositionRefreshArgs&) = 0;
 };
 
 } // namespace compositionengine
@@ -19,6 +19,7 @@
 #include <renderengine/ExternalTexture.h>
 #include <ui/Fence.h>
 #include <ui/GraphicTypes.h>
+#include <ui/Region.h>
 #include <ui/Size.h>
 #include <utils/Errors.h>
 #include <utils/StrongPointer.h>
@@ -87,6 +88,10 @@ public:
     // true if the entire frame must be recomposed.
     virtual status_t beginFrame(bool mustRecompose) = 0;
 
+    // Sets the region of the output buffer that changes this frame, in buffer coordinates, for the
+    // display surface to pass along with the buffer.
+    virtual void setFrameDamage(const Region&) = 0;
+
     // Prepares the frame for rendering
     virtual void prepareFrame(bool usesClientComposition, bool usesDeviceComposition) = 0;
 
@@ -98,6 +103,20 @@ public:
     // which will fire when the buffer is ready for consumption.
     virtual void queueBuffer(base::unique_fd readyFence) = 0;
 
+    // Returns a dequeued buffer that turned out not to be needed for the frame, e.g. because it
+    // was dequeued before the composition strategy was known.
+    virtual void cancelBuffer() = 0;
+
+    // Sets the region of the dequeued buffer that differs from the previously queued buffer, in
+    // buffer coordinates. The damage is passed along with the buffer when it is queued. It is
+    // reset to the entire buffer when a buffer is dequeued.
+    virtual void setBufferDamage(const Region&) = 0;
+
+    // Returns the region of the dequeued buffer that needs to be redrawn for its contents to be
+    // up to date, given the damage of the frame relative to the previously queued buffer. An
+    // invalid region means that the entire buffer needs to be redrawn.
+    virtual Region getBufferRepaintRegion(const Region& damage) const = 0;
+
     // Called after the HWC calls are made to present the display
     virtual void onPresentDisplayCompleted() = 0;
 
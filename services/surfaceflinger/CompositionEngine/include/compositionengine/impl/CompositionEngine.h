@@ -17,6 +17,10 @@
 #pragma once
 
 #include <compositionengine/CompositionEngine.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
+
+#include <memory>
+#include <vector>
 
 namespace android::compositionengine::impl {
 
@@ -57,11 +61,18 @@ public:
     void setNeedsAnotherUpdateForTest(bool);
 
 private:
+    void presentOutputs(CompositionRefreshArgs&);
+    void presentOutputsInParallel(CompositionRefreshArgs&);
+
     std::unique_ptr<HWComposer> mHwComposer;
     renderengine::RenderEngine* mRenderEngine;
     std::shared_ptr<TimeStats> mTimeStats;
     bool mNeedsAnotherUpdate = false;
     nsecs_t mRefreshStartTime = 0;
+
+    // Workers used to present all outputs but the first when multithreaded present is enabled.
+    // The pool only grows, so each additional output keeps a stable thread across frames.
+    std::vector<std::unique_ptr<HwcAsyncWorker>> mPresentWorkers;
 };
 
 std::unique_ptr<compositionengine::CompositionEngine> createCompositionEngine();
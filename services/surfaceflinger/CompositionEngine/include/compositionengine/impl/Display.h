@@ -84,6 +84,15 @@ public:
     virtual void applyDisplayRequests(const DisplayRequests&);
     virtual void applyLayerRequestsToLayers(const LayerRequests&);
     virtual void applyClientTargetRequests(const ClientTargetProperty&);
+    virtual size_t getLayerStackGeometryHash() const;
+
+    struct ValidateSkipPredictionStats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+    const ValidateSkipPredictionStats& getValidateSkipPredictionStats() const {
+        return mValidateSkipPredictionStats;
+    }
 
     // Internal
     virtual void setConfiguration(const compositionengine::DisplayCreationArgs&);
@@ -95,12 +104,18 @@ public:
     /* QTI_END */
 
 private:
+    Region getFrameDamage() const;
     bool isPowerHintSessionEnabled() override;
     void setHintSessionGpuFence(std::unique_ptr<FenceTime>&& gpuFence) override;
     DisplayId mId;
     bool mIsDisconnected = false;
     Hwc2::PowerAdvisor* mPowerAdvisor = nullptr;
 
+    // Geometry hash of the last layer stack that the HWC presented without validating or
+    // requesting changes. A frame with the same geometry is predicted to skip validate again.
+    std::optional<size_t> mLastDeviceOnlyStackHash;
+    ValidateSkipPredictionStats mValidateSkipPredictionStats;
+
     /* QTI_BEGIN */
     bool mQtiIsColorModeChanged = false;
     ColorProfile mQtiColorProfile = {ui::ColorMode::NATIVE, ui::Dataspace::UNKNOWN,
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <stack>
 #include <unordered_map>
+#include <vector>
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic push
@@ -92,6 +93,17 @@ public:
     //
     uint32_t uncache(uint64_t graphicBufferId);
 
+    //
+    // Evicts the buffers that have not been sent to HWC for much longer than the layer takes to
+    // cycle through its buffers, so that HWC can drop its references to buffers the client has
+    // moved on from, e.g. after a resize.
+    //
+    // Returns the slot numbers of the evicted buffers, which need to be cleared in HWC. Stale
+    // buffers are only looked for every so often, so that the slots are cleared in batches. This
+    // is cheap to call every time a buffer is sent to HWC.
+    //
+    std::vector<uint32_t> evictStaleBuffers();
+
 private:
     uint32_t cache(const sp<GraphicBuffer>& buffer);
     uint32_t getLeastRecentlyUsedSlot();
@@ -104,10 +116,22 @@ private:
         uint64_t lruCounter;
     };
 
+    // A cache entry is stale once it has not been used for this many times the longest interval at
+    // which the layer recently reused a buffer, and never sooner than kMinStaleBufferAge.
+    static const constexpr uint64_t kStaleBufferAgeFactor = 4;
+    static const constexpr uint64_t kMinStaleBufferAge = 16;
+
     std::unordered_map<uint64_t, Cache> mCacheByBufferId;
     sp<GraphicBuffer> mLastOverrideBuffer;
     std::stack<uint32_t> mFreeSlots;
-    uint64_t mLeastRecentlyUsedCounter;
+    uint64_t mLeastRecentlyUsedCounter = 0;
+
+    // The longest interval, in units of mLeastRecentlyUsedCounter, between two uses of the same
+    // buffer. mMaxReuseInterval decays at every stale buffer check so that a long gap is
+    // eventually forgotten, while mRecentMaxReuseInterval covers the uses since the last check.
+    uint64_t mMaxReuseInterval = 1;
+    uint64_t mRecentMaxReuseInterval = 1;
+    uint64_t mLastStaleBufferCheck = 0;
 };
 
 } // namespace compositionengine::impl
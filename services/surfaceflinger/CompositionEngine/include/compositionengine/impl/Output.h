@@ -106,6 +106,7 @@ public:
     void beginFrame() override;
     void prepareFrame() override;
     GpuCompositionResult prepareFrameAsync() override;
+    GpuCompositionResult prepareFrameWithEarlyDequeue() override;
     void devOptRepaintFlash(const CompositionRefreshArgs&) override;
     void finishFrame(GpuCompositionResult&&) override;
     std::optional<base::unique_fd> composeSurfaces(const Region&,
@@ -115,8 +116,10 @@ public:
     void renderCachedSets(const CompositionRefreshArgs&) override;
     void cacheClientCompositionRequests(uint32_t) override;
     bool canPredictCompositionStrategy(const CompositionRefreshArgs&) override;
+    bool canDequeueClientTargetEarly(const CompositionRefreshArgs&) override;
     void setPredictCompositionStrategy(bool) override;
     void setTreat170mAsSrgb(bool) override;
+    void setPartialClientComposition(bool) override;
 
 #ifndef DISABLE_DEVICE_INTEGRATION
     // Device Integration: for Blackscreen
@@ -178,6 +181,9 @@ private:
     void updateCompositionStateForBorder(const compositionengine::CompositionRefreshArgs&);
     compositionengine::OutputLayer* findLayerRequestingBackgroundComposition() const;
     void finishPrepareFrame();
+    Region updateClientTargetDamage(const Region& debugRegion,
+                                    const renderengine::DisplaySettings&,
+                                    const std::vector<LayerFE::LayerSettings>&);
     ui::Dataspace getBestDataspace(ui::Dataspace*, bool*) const;
     compositionengine::Output::ColorProfile pickColorProfile(
             const compositionengine::CompositionRefreshArgs&) const;
@@ -196,6 +202,66 @@ private:
 
     // Whether the content must be recomposed this frame.
     bool mMustRecompose = false;
+
+    // If true, client composition only redraws the region of the client target buffer that is
+    // out of date, which is derived from the difference between the client composition requests
+    // of consecutive frames.
+    bool mPartialClientComposition = false;
+
+    struct ClientComposition {
+        renderengine::DisplaySettings display;
+        std::vector<LayerFE::LayerSettings> layers;
+    };
+
+    // The client composition of the last queued client target, and of the one being composed.
+    std::optional<ClientComposition> mLastClientComposition;
+    std::optional<ClientComposition> mPendingClientComposition;
+
+    // The output state that the visible regions of layers depend on.
+    struct CoverageOutputState {
+        ui::Transform transform;
+        Rect displayBounds;
+        Rect layerStackContent;
+        ui::LayerFilter layerFilter;
+        bool computeAboveCoveredExcludingOverlays = false;
+    };
+
+    // The inputs and results of the visibility computation for one layer, in front-to-back order.
+    struct LayerCoverage {
+        const LayerFE* layerFE = nullptr;
+
+        // The layer state read by the computation, if the layer had any.
+        bool hasState = false;
+        bool isVisible = false;
+        bool isOpaque = false;
+        bool isDisplayDecoration = false;
+        ui::LayerFilter outputFilter;
+        ui::Transform geomLayerTransform;
+        FloatRect geomLayerBounds;
+        float shadowRadius = 0.f;
+        Region transparentRegionHint;
+
+        // The visible and covered regions, if the layer contributed to the dirty region.
+        bool hasDirtyRegion = false;
+        bool hasOutputLayer = false;
+        Region visibleRegion;
+        Region coveredRegion;
+
+        // The coverage accumulated by this layer and the layers above it.
+        Region aboveCoveredLayers;
+        Region aboveOpaqueLayers;
+        std::optional<Region> aboveCoveredLayersExcludingOverlays;
+    };
+
+    size_t countReusableLayerCoverage(const CompositionRefreshArgs&,
+                                      const compositionengine::Output::CoverageState&,
+                                      std::vector<std::optional<size_t>>& outOutputLayerIndices);
+
+    // The coverage of the last rebuild of the layer stack, which lets the next rebuild skip the
+    // layers above the top-most layer whose geometry changed.
+    CoverageOutputState mLayerCoverageOutputState;
+    std::vector<LayerCoverage> mLayerCoverage;
+    std::vector<LayerCoverage> mPendingLayerCoverage;
 };
 
 // This template factory function standardizes the implementation details of the
@@ -95,6 +95,9 @@ struct OutputCompositionState {
     // by the FE until composition happens, at which point it is cleared.
     Region dirtyRegion;
 
+    // The dirty region of the last presented frame, in the same coordinates as dirtyRegion.
+    Region lastFrameDirtyRegion;
+
     // The logical coordinates for the undefined region for the display.
     // The undefined region is internal to the composition engine. It is
     // updated every time the geometry changes.
@@ -20,6 +20,7 @@
 #include <compositionengine/RenderSurface.h>
 #include <utils/StrongPointer.h>
 
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -63,10 +64,14 @@ public:
     void setDisplaySize(const ui::Size&) override;
     void setProtected(bool useProtected) override;
     status_t beginFrame(bool mustRecompose) override;
+    void setFrameDamage(const Region&) override;
     void prepareFrame(bool usesClientComposition, bool usesDeviceComposition) override;
     std::shared_ptr<renderengine::ExternalTexture> dequeueBuffer(
             base::unique_fd* bufferFence) override;
     void queueBuffer(base::unique_fd readyFence) override;
+    void cancelBuffer() override;
+    void setBufferDamage(const Region&) override;
+    Region getBufferRepaintRegion(const Region& damage) const override;
     void onPresentDisplayCompleted() override;
     bool supportsCompositionStrategyPrediction() const override;
 
@@ -105,6 +110,12 @@ private:
     const size_t mMaxTextureCacheSize;
     bool mProtected{false};
 
+    // The damage of the dequeued buffer, and of the most recently queued buffers, most recent
+    // first. Buffers queued without a damage have an invalid one.
+    static constexpr size_t kDamageHistorySize = 4;
+    Region mBufferDamage = Region::INVALID_REGION;
+    std::deque<Region> mDamageHistory;
+
     /* QTI_BEGIN */
     friend class android::compositionengineextension::QtiRenderSurfaceExtension;
     android::surfaceflingerextension::QtiDisplaySurfaceExtensionIntf* mQtiDSExtnIntf = nullptr;
@@ -21,18 +21,71 @@
 #include <compositionengine/impl/planner/LayerState.h>
 #include <renderengine/RenderEngine.h>
 
+#include <android-base/thread_annotations.h>
 #include <renderengine/ExternalTexture.h>
 #include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
 #include "android-base/macros.h"
 
 namespace android::compositionengine::impl::planner {
 
+class TexturePool;
+
+// A memory budget shared by the texture pools of several displays. Once the textures allocated by
+// the pools exceed the budget, idle textures are evicted from the pools in least recently used
+// order, regardless of the display they belong to. Textures that are borrowed from a pool, e.g. by
+// a cached set, are never evicted, so that long-lived cached sets survive memory pressure. Instead,
+// the pools stop retaining textures returned to them until they are back under budget.
+class TextureBudget {
+public:
+    // A budget of 0 bytes is unbounded, but allocations are still tracked.
+    explicit TextureBudget(size_t budgetBytes) : mBudgetBytes(budgetBytes) {}
+
+    // Returns the budget shared by the texture pools of all displays, which is sized by
+    // debug.sf.layer_caching_texture_budget_kb.
+    static const std::shared_ptr<TextureBudget>& getShared();
+
+    size_t getBudgetBytes() const { return mBudgetBytes; }
+    size_t getAllocatedBytes() const;
+    size_t getEvictionCount() const;
+
+    void dump(std::string& out) const;
+
+private:
+    friend class TexturePool;
+
+    void addPool(TexturePool*);
+    void removePool(TexturePool*);
+
+    // Accounts for a newly allocated texture, and evicts idle textures if over budget. Must not be
+    // called while holding the lock of a pool.
+    void allocate(size_t bytes);
+    void release(size_t bytes);
+
+    // Returns whether a texture that is returned to a pool may be retained by it.
+    bool canRetain() const;
+
+    bool isOverBudgetLocked() const REQUIRES(mMutex) {
+        return mBudgetBytes != 0 && mAllocatedBytes > mBudgetBytes;
+    }
+
+    const size_t mBudgetBytes;
+
+    mutable std::mutex mMutex;
+    size_t mAllocatedBytes GUARDED_BY(mMutex) = 0;
+    size_t mEvictionCount GUARDED_BY(mMutex) = 0;
+    std::vector<TexturePool*> mPools GUARDED_BY(mMutex);
+};
+
 // A pool of textures that only manages textures of a single size.
 // While it is possible to define a texture pool supporting variable-sized textures to save on
 // memory, it is a simpler implementation to only manage screen-sized textures. The texture pool is
 // unbounded - there are a minimum number of textures preallocated. Under heavy system load, new
 // textures may be allocated, but only a maximum number of retained once those textures are no
-// longer necessary.
+// longer necessary. If the pool is given a TextureBudget, the textures it allocates are also
+// accounted against that budget.
 class TexturePool {
 public:
     // RAII class helping with managing textures from the texture pool
@@ -63,10 +116,10 @@ public:
         sp<Fence> mFence;
     };
 
-    TexturePool(renderengine::RenderEngine& renderEngine)
-          : mRenderEngine(renderEngine), mEnabled(false) {}
+    TexturePool(renderengine::RenderEngine& renderEngine,
+                std::shared_ptr<TextureBudget> budget = nullptr);
 
-    virtual ~TexturePool() = default;
+    virtual ~TexturePool();
 
     // Sets the display size for the texture pool.
     // This will trigger a reallocation for all remaining textures in the pool.
@@ -93,19 +146,38 @@ protected:
     struct Entry {
         std::shared_ptr<renderengine::ExternalTexture> texture;
         sp<Fence> fence;
+        // When the texture was last returned to the pool, for least recently used eviction.
+        std::chrono::steady_clock::time_point lastUsed = std::chrono::steady_clock::now();
     };
 
+    // Idle textures, oldest first. Guarded by mMutex, since a TextureBudget shared with other
+    // displays may evict from the pool while those displays are presented on other threads.
     std::deque<Entry> mPool;
 
 private:
+    friend class TextureBudget;
+
     std::shared_ptr<renderengine::ExternalTexture> genTexture();
     // Returns a previously borrowed texture to the pool.
     void returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
                        const sp<Fence>& fence);
+    // Returns whether a texture returned to the pool was added back to the pool.
+    bool retainTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
+                       const sp<Fence>& fence);
     void allocatePool();
+    void clearPool();
+
+    // Used by TextureBudget to evict the least recently used idle textures.
+    std::optional<std::chrono::steady_clock::time_point> getOldestIdleTime() const;
+    // Returns the size in bytes of the evicted texture, or 0 if the pool has no idle textures.
+    size_t evictOldestIdleTexture();
+
     renderengine::RenderEngine& mRenderEngine;
+    const std::shared_ptr<TextureBudget> mBudget;
     ui::Size mSize;
     bool mEnabled;
+
+    mutable std::mutex mMutex;
 };
 
 } // namespace android::compositionengine::impl::planner
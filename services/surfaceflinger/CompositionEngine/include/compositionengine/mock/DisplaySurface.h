@@ -18,6 +18,7 @@
 
 #include <compositionengine/DisplaySurface.h>
 #include <gmock/gmock.h>
+#include <ui/Region.h>
 #include <ui/Size.h>
 #include <utils/String8.h>
 
@@ -29,6 +30,7 @@ public:
     ~DisplaySurface() override;
 
     MOCK_METHOD1(beginFrame, status_t(bool mustRecompose));
+    MOCK_METHOD1(setFrameDamage, void(const Region&));
     MOCK_METHOD1(prepareFrame, status_t(CompositionType compositionType));
     MOCK_METHOD0(advanceFrame, status_t());
     MOCK_METHOD0(onFrameCommitted, void());
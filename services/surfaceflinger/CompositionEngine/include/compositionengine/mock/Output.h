@@ -101,6 +101,7 @@ public:
 
     MOCK_METHOD0(prepareFrame, void());
     MOCK_METHOD0(prepareFrameAsync, GpuCompositionResult());
+    MOCK_METHOD0(prepareFrameWithEarlyDequeue, GpuCompositionResult());
     MOCK_METHOD1(chooseCompositionStrategy,
                  bool(std::optional<android::HWComposer::DeviceRequestedChanges>*));
     MOCK_METHOD1(chooseCompositionStrategyAsync,
@@ -129,8 +130,10 @@ public:
     MOCK_METHOD1(setExpensiveRenderingExpected, void(bool));
     MOCK_METHOD1(cacheClientCompositionRequests, void(uint32_t));
     MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
+    MOCK_METHOD1(canDequeueClientTargetEarly, bool(const CompositionRefreshArgs&));
     MOCK_METHOD1(setPredictCompositionStrategy, void(bool));
     MOCK_METHOD1(setTreat170mAsSrgb, void(bool));
+    MOCK_METHOD1(setPartialClientComposition, void(bool));
     MOCK_METHOD(void, setHintSessionGpuFence, (std::unique_ptr<FenceTime> && gpuFence));
     MOCK_METHOD(bool, isPowerHintSessionEnabled, ());
 };
@@ -105,11 +105,47 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
         }
     }
 
+    if (args.multithreadedPresent && args.outputs.size() > 1) {
+        presentOutputsInParallel(args);
+    } else {
+        presentOutputs(args);
+    }
+}
+
+void CompositionEngine::presentOutputs(CompositionRefreshArgs& args) {
     for (const auto& output : args.outputs) {
         output->present(args);
     }
 }
 
+void CompositionEngine::presentOutputsInParallel(CompositionRefreshArgs& args) {
+    ATRACE_CALL();
+
+    const size_t workerCount = args.outputs.size() - 1;
+    while (mPresentWorkers.size() < workerCount) {
+        mPresentWorkers.push_back(std::make_unique<HwcAsyncWorker>());
+    }
+
+    // The first output is presented on the calling thread, the remaining ones are handed off to
+    // workers so that the slowest output, rather than the sum of all outputs, bounds the frame.
+    std::vector<std::future<bool>> futures;
+    futures.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        const auto& output = args.outputs[i + 1];
+        futures.push_back(mPresentWorkers[i]->send([&output, &args]() {
+            output->present(args);
+            return true;
+        }));
+    }
+
+    args.outputs.front()->present(args);
+
+    ATRACE_NAME("Waiting on present workers");
+    for (auto& future : futures) {
+        future.wait();
+    }
+}
+
 void CompositionEngine::updateCursorAsync(CompositionRefreshArgs& args) {
     std::unordered_map<compositionengine::LayerFE*, compositionengine::LayerFECompositionState*>
             uniqueVisibleLayers;
@@ -32,6 +32,7 @@
 #include <compositionengine/impl/OutputLayer.h>
 #include <compositionengine/impl/RenderSurface.h>
 #include <gui/TraceUtils.h>
+#include <math/HashCombine.h>
 
 #include <utils/Trace.h>
 #include <string>
@@ -177,7 +178,10 @@ void Display::dump(std::string& out) const {
     base::StringAppendF(&out, "Display %s (%s, \"%s\")", to_string(mId).c_str(), type,
                         getName().c_str());
 
-    out.append("\n   Composition Display State:\n");
+    base::StringAppendF(&out, "\n   validate skip predictions: hits=%zu misses=%zu\n",
+                        mValidateSkipPredictionStats.hits, mValidateSkipPredictionStats.misses);
+
+    out.append("   Composition Display State:\n");
     Output::dumpBase(out);
 }
 
@@ -278,9 +282,35 @@ void Display::beginFrame() {
         return;
     }
 
+    // The sink of a virtual display, e.g. a video encoder, may only need to process the damage.
+    if (isVirtual()) {
+        getRenderSurface()->setFrameDamage(getFrameDamage());
+    }
+
     applyDisplayBrightness(false);
 }
 
+Region Display::getFrameDamage() const {
+    const auto& outputState = getState();
+    const Rect bounds = outputState.framebufferSpace.getBoundsAsRect();
+
+    // The whole output is marked dirty in display space rather than layer stack space.
+    if (Region(outputState.displaySpace.getBoundsAsRect())
+                .subtract(outputState.dirtyRegion)
+                .isEmpty()) {
+        return Region(bounds);
+    }
+
+    // Round outwards, so that no changed pixel is left out of the damage.
+    const ui::Transform transform =
+            outputState.layerStackSpace.getTransform(outputState.framebufferSpace);
+    Region damage;
+    for (const Rect& rect : getDirtyRegion()) {
+        damage.orSelf(transform.transform(rect, /*roundOutwards=*/true));
+    }
+    return damage.intersect(bounds);
+}
+
 bool Display::chooseCompositionStrategy(
         std::optional<android::HWComposer::DeviceRequestedChanges>* outChanges) {
     ATRACE_FORMAT("%s for %s", __func__, getNamePlusId().c_str());
@@ -328,6 +358,21 @@ bool Display::chooseCompositionStrategy(
         }
     }
 
+    // Track whether an unchanged geometry predicts that the HWC skips validate, so that the
+    // prediction can be audited before it is relied upon to elide the validate round trip.
+    const size_t geometryHash = getLayerStackGeometryHash();
+    const bool deviceOnly = hwc.getValidateSkipped(*halDisplayId) && !requiresClientComposition &&
+            !outChanges->has_value();
+    if (mLastDeviceOnlyStackHash == geometryHash) {
+        if (deviceOnly) {
+            mValidateSkipPredictionStats.hits++;
+        } else {
+            mValidateSkipPredictionStats.misses++;
+        }
+    }
+    mLastDeviceOnlyStackHash =
+            deviceOnly ? std::make_optional(geometryHash) : std::optional<size_t>();
+
     return true;
 }
 
@@ -355,6 +400,20 @@ bool Display::getSkipColorTransform() const {
     return hwc.hasCapability(Capability::SKIP_CLIENT_COLOR_TRANSFORM);
 }
 
+size_t Display::getLayerStackGeometryHash() const {
+    size_t hash = 0;
+    for (const auto* layer : getOutputLayersOrderedByZ()) {
+        const auto& state = layer->getState();
+        hashCombineSingle(hash, layer->getLayerFE().getSequence());
+        hashCombineSingle(hash, state.displayFrame);
+        hashCombineSingle(hash, state.sourceCrop);
+        if (const auto* layerFEState = layer->getLayerFE().getCompositionState()) {
+            hashCombineSingle(hash, static_cast<int32_t>(layerFEState->compositionType));
+        }
+    }
+    return hash;
+}
+
 bool Display::allLayersRequireClientComposition() const {
     const auto layers = getOutputLayersOrderedByZ();
     return std::all_of(layers.begin(), layers.end(),
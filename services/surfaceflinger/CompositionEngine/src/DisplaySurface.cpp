@@ -20,6 +20,8 @@ namespace android::compositionengine {
 
 DisplaySurface::~DisplaySurface() = default;
 
+void DisplaySurface::setFrameDamage(const Region&) {}
+
 bool DisplaySurface::supportsCompositionStrategyPrediction() const {
     return true;
 }
@@ -60,7 +60,9 @@ void HwcAsyncWorker::run() {
     std::unique_lock<std::mutex> lock(mMutex);
     android::base::ScopedLockAssertion assumeLock(mMutex);
     while (!mDone) {
-        mCv.wait(lock);
+        // A task may be sent before this thread first waits on the condition, so check for it
+        // instead of relying on the notification alone.
+        mCv.wait(lock, [this]() REQUIRES(mMutex) { return mDone || mTaskRequested; });
         if (mTaskRequested && mTask.valid()) {
             mTask();
             mTaskRequested = false;
@@ -19,6 +19,8 @@
 #include <gui/BufferQueue.h>
 #include <ui/GraphicBuffer.h>
 
+#include <algorithm>
+
 namespace android::compositionengine::impl {
 
 HwcBufferCache::HwcBufferCache() {
@@ -30,6 +32,9 @@ HwcBufferCache::HwcBufferCache() {
 HwcSlotAndBuffer HwcBufferCache::getHwcSlotAndBuffer(const sp<GraphicBuffer>& buffer) {
     if (auto i = mCacheByBufferId.find(buffer->getId()); i != mCacheByBufferId.end()) {
         Cache& cache = i->second;
+        const uint64_t reuseInterval = mLeastRecentlyUsedCounter - cache.lruCounter;
+        mRecentMaxReuseInterval = std::max(mRecentMaxReuseInterval, reuseInterval);
+        mMaxReuseInterval = std::max(mMaxReuseInterval, reuseInterval);
         // mark this cache slot as more recently used so it won't get evicted anytime soon
         cache.lruCounter = mLeastRecentlyUsedCounter++;
         return {cache.slot, nullptr};
@@ -59,6 +64,29 @@ uint32_t HwcBufferCache::uncache(uint64_t bufferId) {
     return UINT32_MAX;
 }
 
+std::vector<uint32_t> HwcBufferCache::evictStaleBuffers() {
+    const uint64_t staleBufferAge =
+            std::max(kMinStaleBufferAge, kStaleBufferAgeFactor * mMaxReuseInterval);
+    if (mLeastRecentlyUsedCounter - mLastStaleBufferCheck < staleBufferAge) {
+        return {};
+    }
+    mLastStaleBufferCheck = mLeastRecentlyUsedCounter;
+    mMaxReuseInterval = std::max(mRecentMaxReuseInterval, mMaxReuseInterval / 2);
+    mRecentMaxReuseInterval = 1;
+
+    std::vector<uint32_t> staleSlots;
+    for (auto i = mCacheByBufferId.begin(); i != mCacheByBufferId.end();) {
+        if (mLeastRecentlyUsedCounter - i->second.lruCounter > staleBufferAge) {
+            staleSlots.push_back(i->second.slot);
+            mFreeSlots.push(i->second.slot);
+            i = mCacheByBufferId.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    return staleSlots;
+}
+
 uint32_t HwcBufferCache::cache(const sp<GraphicBuffer>& buffer) {
     Cache cache;
     cache.slot = getLeastRecentlyUsedSlot();
@@ -35,11 +35,16 @@
 #include <compositionengine/impl/OutputLayer.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
 #include <compositionengine/impl/planner/Planner.h>
+#include <ftl/executor.h>
 #include <ftl/future.h>
 #include <gui/TraceUtils.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <optional>
 #include <thread>
+#include <utility>
 
 #include "renderengine/ExternalTexture.h"
 
@@ -95,6 +100,16 @@ Reversed<T> reversed(const T& c) {
     return Reversed<T>(c);
 }
 
+// The number of output layers that a task of a parallel composition state update covers.
+constexpr size_t kLayerUpdateChunkSize = 16;
+
+// Worker pool shared by the parallel composition state updates of all outputs. The calling thread
+// updates a chunk too, so the pool leaves a core for it.
+ftl::Executor& getLayerUpdateExecutor() {
+    static ftl::Executor executor(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return executor;
+}
+
 struct ScaleVector {
     float x;
     float y;
@@ -108,6 +123,39 @@ ScaleVector getScale(const Rect& from, const Rect& to) {
             .y = static_cast<float>(to.height()) / from.height()};
 }
 
+// Returns the bounds in layer stack space of the pixels that drawing a layer may touch, or
+// nullopt if they cannot be easily bounded, e.g. because the layer blurs what is behind it.
+std::optional<Rect> getDrawnBounds(const renderengine::LayerSettings& layer) {
+    if (layer.backgroundBlurRadius > 0 || !layer.blurRegions.empty() || layer.shadow.length > 0.f ||
+        layer.stretchEffect.hasEffect()) {
+        return std::nullopt;
+    }
+
+    const FloatRect& boundaries = layer.geometry.boundaries;
+    FloatRect bounds(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                     std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    for (const auto& [x, y] : {std::pair(boundaries.left, boundaries.top),
+                               std::pair(boundaries.right, boundaries.top),
+                               std::pair(boundaries.left, boundaries.bottom),
+                               std::pair(boundaries.right, boundaries.bottom)}) {
+        const vec4 corner = layer.geometry.positionTransform * vec4(x, y, 0.f, 1.f);
+        bounds.left = std::min(bounds.left, corner.x);
+        bounds.top = std::min(bounds.top, corner.y);
+        bounds.right = std::max(bounds.right, corner.x);
+        bounds.bottom = std::max(bounds.bottom, corner.y);
+    }
+
+    // Leave a pixel of margin for antialiasing and filtering.
+    return Rect(static_cast<int32_t>(std::floor(bounds.left)) - 1,
+                static_cast<int32_t>(std::floor(bounds.top)) - 1,
+                static_cast<int32_t>(std::ceil(bounds.right)) + 1,
+                static_cast<int32_t>(std::ceil(bounds.bottom)) + 1);
+}
+
+bool isInvalidRegion(const Region& region) {
+    return region.isRect() && region.getBounds() == Rect::INVALID_RECT;
+}
+
 } // namespace
 
 std::shared_ptr<Output> createOutput(
@@ -402,6 +450,46 @@ void Output::setRenderSurfaceForTest(std::unique_ptr<compositionengine::RenderSu
     mRenderSurface = std::move(surface);
 }
 
+Region Output::updateClientTargetDamage(const Region& debugRegion,
+                                        const renderengine::DisplaySettings& display,
+                                        const std::vector<LayerFE::LayerSettings>& layers) {
+    const auto& outputState = getState();
+    const Region fullDamage(outputState.framebufferSpace.getBoundsAsRect());
+    mPendingClientComposition = ClientComposition{.display = display, .layers = layers};
+    if (!mLastClientComposition || !debugRegion.isEmpty() ||
+        mLastClientComposition->display != display ||
+        mLastClientComposition->layers.size() != layers.size()) {
+        return fullDamage;
+    }
+
+    // A pixel can only change if a request that may draw it changed, so the damage is bounded by
+    // the old and new bounds of the requests that differ between the two frames.
+    Region damage;
+    for (size_t i = 0; i < layers.size(); i++) {
+        const LayerFE::LayerSettings& previous = mLastClientComposition->layers[i];
+        const LayerFE::LayerSettings& current = layers[i];
+        if (previous == current && previous.bufferId == current.bufferId &&
+            previous.frameNumber == current.frameNumber) {
+            continue;
+        }
+
+        const auto previousBounds = getDrawnBounds(previous);
+        const auto currentBounds = getDrawnBounds(current);
+        if (!previousBounds || !currentBounds) {
+            return fullDamage;
+        }
+        damage.orSelf(*previousBounds);
+        damage.orSelf(*currentBounds);
+    }
+    if (damage.isEmpty()) {
+        return damage;
+    }
+
+    const ui::Transform transform =
+            outputState.layerStackSpace.getTransform(outputState.framebufferSpace);
+    return transform.transform(damage).intersect(outputState.framebufferSpace.getBoundsAsRect());
+}
+
 Region Output::getDirtyRegion() const {
     const auto& outputState = getState();
     return outputState.dirtyRegion.intersect(outputState.layerStackSpace.getContent());
@@ -465,6 +553,8 @@ void Output::present(const compositionengine::CompositionRefreshArgs& refreshArg
     const bool predictCompositionStrategy = canPredictCompositionStrategy(refreshArgs);
     if (predictCompositionStrategy) {
         result = prepareFrameAsync();
+    } else if (canDequeueClientTargetEarly(refreshArgs)) {
+        result = prepareFrameWithEarlyDequeue();
     } else {
         prepareFrame();
     }
@@ -514,22 +604,145 @@ void Output::rebuildLayerStacks(const compositionengine::CompositionRefreshArgs&
 
 void Output::collectVisibleLayers(const compositionengine::CompositionRefreshArgs& refreshArgs,
                                   compositionengine::Output::CoverageState& coverage) {
+    mPendingLayerCoverage.clear();
+
+    // The layers above the top-most layer whose geometry changed since the last rebuild keep their
+    // visible regions, so only their dirty regions need to be accumulated.
+    std::vector<std::optional<size_t>> reusedOutputLayerIndices;
+    const size_t reusedCount =
+            countReusableLayerCoverage(refreshArgs, coverage, reusedOutputLayerIndices);
+
     // Evaluate the layers from front to back to determine what is visible. This
     // also incrementally calculates the coverage information for each layer as
     // well as the entire output.
+    size_t position = 0;
     for (auto layer : reversed(refreshArgs.layers)) {
+        if (position < reusedCount) {
+            const LayerCoverage& entry = mLayerCoverage[position];
+            coverage.latchedLayers.insert(layer);
+
+            if (const auto index = reusedOutputLayerIndices[position]) {
+                ensureOutputLayer(*index, layer);
+            }
+
+            if (entry.hasDirtyRegion) {
+                // The regions are unchanged, so only content changes and previously covered areas
+                // are dirty. A layer without an output layer had no previous regions.
+                if (layer->getCompositionState()->contentDirty) {
+                    coverage.dirtyRegion.orSelf(entry.visibleRegion);
+                } else if (entry.hasOutputLayer) {
+                    coverage.dirtyRegion.orSelf(entry.visibleRegion.intersect(entry.coveredRegion));
+                } else {
+                    coverage.dirtyRegion.orSelf(entry.visibleRegion.subtract(entry.coveredRegion));
+                }
+            }
+
+            if (++position == reusedCount) {
+                coverage.aboveCoveredLayers = entry.aboveCoveredLayers;
+                coverage.aboveOpaqueLayers = entry.aboveOpaqueLayers;
+                coverage.aboveCoveredLayersExcludingOverlays =
+                        entry.aboveCoveredLayersExcludingOverlays;
+            }
+            mPendingLayerCoverage.push_back(entry);
+            continue;
+        }
+
         // Incrementally process the coverage for each layer
         ensureOutputLayerIfVisible(layer, coverage);
 
+        // Record the coverage accumulated so far, if the layer was recorded.
+        if (mPendingLayerCoverage.size() == ++position) {
+            LayerCoverage& entry = mPendingLayerCoverage.back();
+            entry.aboveCoveredLayers = coverage.aboveCoveredLayers;
+            entry.aboveOpaqueLayers = coverage.aboveOpaqueLayers;
+            entry.aboveCoveredLayersExcludingOverlays = coverage.aboveCoveredLayersExcludingOverlays;
+        }
+
         // TODO(b/121291683): Stop early if the output is completely covered and
         // no more layers could even be visible underneath the ones on top.
     }
 
+    const auto& outputState = getState();
+    mLayerCoverageOutputState = {outputState.transform, outputState.displaySpace.getBoundsAsRect(),
+                                 outputState.layerStackSpace.getContent(), outputState.layerFilter,
+                                 coverage.aboveCoveredLayersExcludingOverlays.has_value()};
+    if (mPendingLayerCoverage.size() == position) {
+        mLayerCoverage = std::move(mPendingLayerCoverage);
+    } else {
+        mLayerCoverage.clear();
+    }
+    mPendingLayerCoverage.clear();
+
     setReleasedLayers(refreshArgs);
 
     finalizePendingOutputLayers();
 }
 
+size_t Output::countReusableLayerCoverage(
+        const compositionengine::CompositionRefreshArgs& refreshArgs,
+        const compositionengine::Output::CoverageState& coverage,
+        std::vector<std::optional<size_t>>& outOutputLayerIndices) {
+    if (mLayerCoverage.empty()) {
+        return 0;
+    }
+
+#ifndef DISABLE_DEVICE_INTEGRATION
+    // Device Integration: the black screen layer is filtered by output, not by its state.
+    if (isDisplayForDIS()) {
+        return 0;
+    }
+#endif
+
+    const auto& outputState = getState();
+    const auto& cached = mLayerCoverageOutputState;
+    if (!(cached.transform == outputState.transform) ||
+        cached.displayBounds != outputState.displaySpace.getBoundsAsRect() ||
+        cached.layerStackContent != outputState.layerStackSpace.getContent() ||
+        cached.layerFilter.layerStack != outputState.layerFilter.layerStack ||
+        cached.layerFilter.toInternalDisplay != outputState.layerFilter.toInternalDisplay ||
+        cached.computeAboveCoveredExcludingOverlays !=
+                coverage.aboveCoveredLayersExcludingOverlays.has_value()) {
+        return 0;
+    }
+
+    // Count the layers from the top whose inputs are unchanged, and whose output layers are in the
+    // state left by the last rebuild.
+    size_t count = 0;
+    for (const auto& layer : reversed(refreshArgs.layers)) {
+        if (count == mLayerCoverage.size()) {
+            break;
+        }
+
+        const LayerCoverage& entry = mLayerCoverage[count];
+        const auto* layerFEState = layer->getCompositionState();
+        if (entry.layerFE != layer.get() || !entry.hasState || !layerFEState ||
+            entry.isVisible != layerFEState->isVisible ||
+            entry.isOpaque != layerFEState->isOpaque ||
+            entry.isDisplayDecoration !=
+                    (layerFEState->compositionType == Composition::DISPLAY_DECORATION) ||
+            entry.outputFilter.layerStack != layerFEState->outputFilter.layerStack ||
+            entry.outputFilter.toInternalDisplay != layerFEState->outputFilter.toInternalDisplay ||
+            !(entry.geomLayerTransform == layerFEState->geomLayerTransform) ||
+            !(entry.geomLayerBounds == layerFEState->geomLayerBounds) ||
+            entry.shadowRadius != layerFEState->shadowRadius ||
+            !entry.transparentRegionHint.hasSameRects(layerFEState->transparentRegionHint)) {
+            break;
+        }
+
+        const auto index = findCurrentOutputLayerForLayer(layer);
+        if (index.has_value() != entry.hasOutputLayer ||
+            (index &&
+             !getOutputLayerOrderedByZByIndex(*index)->getState().visibleRegion.hasSameRects(
+                     entry.visibleRegion))) {
+            break;
+        }
+
+        outOutputLayerIndices.push_back(index);
+        count++;
+    }
+    return count;
+}
+
 #ifndef DISABLE_DEVICE_INTEGRATION
 // Device Integration: if input window type is black screen
 bool Output::isBlackScreenLayer(int windowType) const {
@@ -546,6 +759,26 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
         coverage.latchedLayers.insert(layerFE);
     }
 
+    // Record the inputs of the computation, so that the next rebuild can reuse its results.
+    LayerCoverage& entry = mPendingLayerCoverage.emplace_back();
+    entry.layerFE = layerFE.get();
+
+    // Obtain a read-only pointer to the front-end layer state
+    const auto* layerFEState = layerFE->getCompositionState();
+    if (CC_UNLIKELY(!layerFEState)) {
+        return;
+    }
+
+    entry.hasState = true;
+    entry.isVisible = layerFEState->isVisible;
+    entry.isOpaque = layerFEState->isOpaque;
+    entry.isDisplayDecoration = layerFEState->compositionType == Composition::DISPLAY_DECORATION;
+    entry.outputFilter = layerFEState->outputFilter;
+    entry.geomLayerTransform = layerFEState->geomLayerTransform;
+    entry.geomLayerBounds = layerFEState->geomLayerBounds;
+    entry.shadowRadius = layerFEState->shadowRadius;
+    entry.transparentRegionHint = layerFEState->transparentRegionHint;
+
     // Only consider the layers on this output
     if (!includesLayer(layerFE)) {
         return;
@@ -563,12 +796,6 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     }
 #endif
 
-    // Obtain a read-only pointer to the front-end layer state
-    const auto* layerFEState = layerFE->getCompositionState();
-    if (CC_UNLIKELY(!layerFEState)) {
-        return;
-    }
-
     // handle hidden surfaces by setting the visible region to empty
     if (CC_UNLIKELY(!layerFEState->isVisible)) {
         return;
@@ -722,6 +949,10 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     const Region& oldCoveredRegion =
             prevOutputLayer ? prevOutputLayer->getState().coveredRegion : kEmptyRegion;
 
+    entry.hasDirtyRegion = true;
+    entry.visibleRegion = visibleRegion;
+    entry.coveredRegion = coveredRegion;
+
     // compute this layer's dirty region
     Region dirty;
     if (layerFEState->contentDirty) {
@@ -772,6 +1003,7 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     // The layer is visible. Either reuse the existing outputLayer if we have
     // one, or create a new one if we do not.
     auto result = ensureOutputLayer(prevOutputLayerIndex, layerFE);
+    entry.hasOutputLayer = true;
 
     // Store the layer coverage information into the layer state as some of it
     // is useful later.
@@ -806,16 +1038,47 @@ void Output::updateCompositionState(const compositionengine::CompositionRefreshA
     }
 
     mLayerRequestingBackgroundBlur = findLayerRequestingBackgroundComposition();
-    bool forceClientComposition = mLayerRequestingBackgroundBlur != nullptr;
 
-    for (auto* layer : getOutputLayersOrderedByZ()) {
-        layer->updateCompositionState(refreshArgs.updatingGeometryThisFrame,
-                                      refreshArgs.devOptForceClientComposition ||
-                                              forceClientComposition,
-                                      refreshArgs.internalDisplayRotationFlags);
+    // The layers up to and including the one requesting background blur are client composited.
+    const size_t layerCount = getOutputLayerCount();
+    size_t forceClientCompositionCount = 0;
+    for (size_t i = 0; mLayerRequestingBackgroundBlur && i < layerCount; i++) {
+        if (getOutputLayerOrderedByZByIndex(i) == mLayerRequestingBackgroundBlur) {
+            forceClientCompositionCount = i + 1;
+            break;
+        }
+    }
+
+    // Each layer only writes its own state, so the layers can be updated in any order.
+    const auto updateLayers = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            getOutputLayerOrderedByZByIndex(i)
+                    ->updateCompositionState(refreshArgs.updatingGeometryThisFrame,
+                                             refreshArgs.devOptForceClientComposition ||
+                                                     i < forceClientCompositionCount,
+                                             refreshArgs.internalDisplayRotationFlags);
+        }
+    };
+
+    const size_t threshold = refreshArgs.parallelLayerUpdateThreshold;
+    if (threshold == 0 || layerCount < std::max(threshold, kLayerUpdateChunkSize + 1)) {
+        updateLayers(0, layerCount);
+    } else {
+        ATRACE_NAME("parallelUpdateCompositionState");
+        std::vector<ftl::Future<bool>> futures;
+        futures.reserve(layerCount / kLayerUpdateChunkSize);
+        for (size_t begin = kLayerUpdateChunkSize; begin < layerCount;
+             begin += kLayerUpdateChunkSize) {
+            const size_t end = std::min(begin + kLayerUpdateChunkSize, layerCount);
+            futures.push_back(getLayerUpdateExecutor().async([&updateLayers, begin, end] {
+                updateLayers(begin, end);
+                return true;
+            }));
+        }
 
-        if (mLayerRequestingBackgroundBlur == layer) {
-            forceClientComposition = false;
+        updateLayers(0, kLayerUpdateChunkSize);
+        for (auto& future : futures) {
+            future.get();
         }
     }
 
@@ -1202,6 +1465,43 @@ GpuCompositionResult Output::prepareFrameAsync() {
     return compositionResult;
 }
 
+GpuCompositionResult Output::prepareFrameWithEarlyDequeue() {
+    ATRACE_CALL();
+    ALOGV(__FUNCTION__);
+    auto& state = editState();
+    std::optional<android::HWComposer::DeviceRequestedChanges> changes;
+    auto hwcResult = chooseCompositionStrategyAsync(&changes);
+
+    // Dequeue the client target while the HWC validates. Dequeuing may block until the HWC
+    // releases a previously presented client target, so this takes that wait off the critical
+    // path of the frame.
+    GpuCompositionResult compositionResult;
+    {
+        ATRACE_NAME("EarlyDequeueClientTarget");
+        base::unique_fd bufferFence;
+        updateProtectedContentState();
+        compositionResult.buffer = mRenderSurface->dequeueBuffer(&bufferFence);
+        compositionResult.fence = std::move(bufferFence);
+    }
+
+    const bool success = hwcResult.get();
+    resetCompositionStrategy();
+    state.strategyPrediction = CompositionStrategyPredictionState::DISABLED;
+    state.previousDeviceRequestedChanges = changes;
+    state.previousDeviceRequestedSuccess = success;
+    if (success) {
+        applyCompositionStrategy(changes);
+    }
+    finishPrepareFrame();
+
+    if (!state.usesClientComposition && !state.flipClientTarget && compositionResult.buffer) {
+        ATRACE_NAME("EarlyDequeueClientTargetUnused");
+        mRenderSurface->cancelBuffer();
+        compositionResult = {};
+    }
+    return compositionResult;
+}
+
 void Output::devOptRepaintFlash(const compositionengine::CompositionRefreshArgs& refreshArgs) {
     if (CC_LIKELY(!refreshArgs.devOptFlashDirtyRegionsDelay)) {
         return;
@@ -1214,6 +1514,7 @@ void Output::devOptRepaintFlash(const compositionengine::CompositionRefreshArgs&
             updateProtectedContentState();
             dequeueRenderBuffer(&bufferFence, &buffer);
             static_cast<void>(composeSurfaces(dirtyRegion, buffer, bufferFence));
+            mLastClientComposition = std::exchange(mPendingClientComposition, std::nullopt);
             mRenderSurface->queueBuffer(base::unique_fd());
         }
     }
@@ -1262,6 +1563,9 @@ void Output::finishFrame(GpuCompositionResult&& result) {
                 std::make_unique<FenceTime>(sp<Fence>::make(dup(optReadyFence->get()))));
     }
     // swap buffers (presentation)
+    if (outputState.usesClientComposition || outputState.flipClientTarget) {
+        mLastClientComposition = std::exchange(mPendingClientComposition, std::nullopt);
+    }
     mRenderSurface->queueBuffer(std::move(*optReadyFence));
 }
 
@@ -1348,6 +1652,13 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                               clientCompositionLayersFE);
     appendRegionFlashRequests(debugRegion, clientCompositionLayers);
 
+    Region damage = Region::INVALID_REGION;
+    if (mPartialClientComposition) {
+        damage = updateClientTargetDamage(debugRegion, clientCompositionDisplay,
+                                          clientCompositionLayers);
+        mRenderSurface->setBufferDamage(damage);
+    }
+
     OutputCompositionState& outputCompositionState = editState();
     // Check if the client composition requests were rendered into the provided graphic buffer. If
     // so, we can reuse the buffer and avoid client composition.
@@ -1384,6 +1695,21 @@ std::optional<base::unique_fd> Output::composeSurfaces(
         setExpensiveRenderingExpected(true);
     }
 
+    if (mPartialClientComposition) {
+        // Only redraw the region where the buffer is out of date. The scissor is left out of the
+        // cached requests above, as it depends on the history of the buffer rather than on what
+        // ends up in it.
+        const Region repaintRegion = mRenderSurface->getBufferRepaintRegion(damage);
+        const Rect& physicalDisplay = clientCompositionDisplay.physicalDisplay;
+        Rect scissor;
+        if (!isInvalidRegion(repaintRegion) &&
+            repaintRegion.getBounds().intersect(physicalDisplay, &scissor) &&
+            scissor != physicalDisplay) {
+            ATRACE_FORMAT("PartialClientComposition %dx%d", scissor.width(), scissor.height());
+            clientCompositionDisplay.scissor = scissor;
+        }
+    }
+
     std::vector<renderengine::LayerSettings> clientRenderEngineLayers;
     clientRenderEngineLayers.reserve(clientCompositionLayers.size());
     std::transform(clientCompositionLayers.begin(), clientCompositionLayers.end(),
@@ -1406,9 +1732,14 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                            useFramebufferCache, std::move(fd))
                                .get();
 
-    if (mClientCompositionRequestCache && fenceStatus(fenceResult) != NO_ERROR) {
+    if (fenceStatus(fenceResult) != NO_ERROR) {
         // If rendering was not successful, remove the request from the cache.
-        mClientCompositionRequestCache->remove(tex->getBuffer()->getId());
+        if (mClientCompositionRequestCache) {
+            mClientCompositionRequestCache->remove(tex->getBuffer()->getId());
+        }
+        // The contents of the buffer are unknown, so do not derive the damage of the next frame
+        // from this one.
+        mPendingClientComposition.reset();
     }
 
     const auto fence = std::move(fenceResult).value_or(Fence::NO_FENCE);
@@ -1604,6 +1935,7 @@ void Output::postFramebuffer() {
     }
 
     auto& outputState = editState();
+    outputState.lastFrameDirtyRegion = std::move(outputState.dirtyRegion);
     outputState.dirtyRegion.clear();
 
     auto frame = presentAndGetFrameFences();
@@ -1696,6 +2028,12 @@ void Output::setTreat170mAsSrgb(bool enable) {
     editState().treat170mAsSrgb = enable;
 }
 
+void Output::setPartialClientComposition(bool enable) {
+    mPartialClientComposition = enable;
+    mLastClientComposition.reset();
+    mPendingClientComposition.reset();
+}
+
 bool Output::canPredictCompositionStrategy(const CompositionRefreshArgs& refreshArgs) {
     uint64_t lastOutputLayerHash = getState().lastOutputLayerHash;
     uint64_t outputLayerHash = getState().outputLayerHash;
@@ -1736,6 +2074,24 @@ bool Output::canPredictCompositionStrategy(const CompositionRefreshArgs& refresh
     return true;
 }
 
+bool Output::canDequeueClientTargetEarly(const CompositionRefreshArgs& refreshArgs) {
+    if (!getState().isEnabled || !mHwComposerAsyncWorker) {
+        return false;
+    }
+
+    if (!mRenderSurface->supportsCompositionStrategyPrediction()) {
+        return false;
+    }
+
+    if (refreshArgs.devOptFlashDirtyRegionsDelay) {
+        return false;
+    }
+
+    // Only dequeue early if the client target is likely to be used, since an unused buffer is
+    // cancelled after the HWC validates.
+    return anyLayersRequireClientComposition();
+}
+
 bool Output::anyLayersRequireClientComposition() const {
     const auto layers = getOutputLayersOrderedByZ();
     return std::any_of(layers.begin(), layers.end(),
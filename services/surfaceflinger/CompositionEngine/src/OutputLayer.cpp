@@ -405,6 +405,10 @@ void OutputLayer::writeStateToHWC(bool includeGeometry, bool skipLayer, uint32_t
     const bool isOverridden =
             state.overrideInfo.buffer != nullptr || isPeekingThrough || zIsOverridden;
     const bool prevOverridden = state.hwc->stateOverridden;
+    // When the geometry is dirty, every property is sent again, even if it did not change.
+    if (includeGeometry) {
+        hwcLayer->invalidateCachedState();
+    }
     if (isOverridden || prevOverridden || skipLayer || includeGeometry) {
         writeOutputDependentGeometryStateToHWC(hwcLayer.get(), requestedCompositionType, z);
         writeOutputIndependentGeometryStateToHWC(hwcLayer.get(), *outputIndependentState,
@@ -696,6 +700,18 @@ void OutputLayer::writeBufferStateToHWC(HWC2::Layer* hwcLayer,
     {
         // Editing the state only because we update the HWC buffer cache and active buffer.
         auto& state = editState();
+        // Let HWC release the buffers this layer no longer cycles through. This is done before the
+        // new buffer is sent, while the active buffer slot still holds a buffer known to HWC.
+        if (const auto slotsToClear = state.hwc->hwcBufferCache.evictStaleBuffers();
+            !slotsToClear.empty()) {
+            if (auto error = hwcLayer->setBufferSlotsToClear(slotsToClear,
+                                                             state.hwc->activeBufferSlot);
+                error != hal::Error::NONE) {
+                ALOGE("[%s] Failed to clear stale buffer slots: %s (%d)",
+                      getLayerFE().getDebugName(), to_string(error).c_str(),
+                      static_cast<int32_t>(error));
+            }
+        }
         // Override buffers use a special cache slot so that they don't evict client buffers.
         if (state.overrideInfo.buffer != nullptr && !skipLayer) {
             hwcSlotAndBuffer = state.hwc->hwcBufferCache.getOverrideHwcSlotAndBuffer(
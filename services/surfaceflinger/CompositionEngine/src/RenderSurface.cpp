@@ -55,6 +55,23 @@ namespace impl {
 
 constexpr auto DEFAULT_USAGE = GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
 
+namespace {
+
+void setSurfaceDamage(ANativeWindow* window, const Region& damage, int32_t bufferHeight) {
+    // ANativeWindow takes the surface damage with a bottom-left origin.
+    std::vector<android_native_rect_t> rects;
+    rects.reserve(damage.end() - damage.begin());
+    for (const Rect& rect : damage) {
+        rects.push_back({.left = rect.left,
+                         .top = bufferHeight - rect.top,
+                         .right = rect.right,
+                         .bottom = bufferHeight - rect.bottom});
+    }
+    native_window_set_surface_damage(window, rects.data(), rects.size());
+}
+
+} // namespace
+
 std::unique_ptr<compositionengine::RenderSurface> createRenderSurface(
         const compositionengine::CompositionEngine& compositionEngine,
         compositionengine::Display& display,
@@ -137,6 +154,10 @@ status_t RenderSurface::beginFrame(bool mustRecompose) {
     return mDisplaySurface->beginFrame(mustRecompose);
 }
 
+void RenderSurface::setFrameDamage(const Region& damage) {
+    mDisplaySurface->setFrameDamage(damage);
+}
+
 void RenderSurface::prepareFrame(bool usesClientComposition, bool usesDeviceComposition) {
     const auto compositionType = [=] {
         using CompositionType = DisplaySurface::CompositionType;
@@ -203,6 +224,7 @@ std::shared_ptr<renderengine::ExternalTexture> RenderSurface::dequeueBuffer(
         mTextureCache.erase(mTextureCache.begin());
     }
 
+    mBufferDamage = Region::INVALID_REGION;
     *bufferFence = base::unique_fd(fd);
 
     return mTexture;
@@ -235,6 +257,10 @@ void RenderSurface::queueBuffer(base::unique_fd readyFence) {
         if (mTexture == nullptr) {
             ALOGE("No buffer is ready for display [%s]", mDisplay.getName().c_str());
         } else {
+            if (!(mBufferDamage.isRect() && mBufferDamage.getBounds() == Rect::INVALID_RECT)) {
+                setSurfaceDamage(mNativeWindow.get(), mBufferDamage,
+                                 static_cast<int32_t>(mTexture->getBuffer()->getHeight()));
+            }
             status_t result =
                     mNativeWindow->queueBuffer(mNativeWindow.get(),
                                                mTexture->getBuffer()->getNativeBuffer(),
@@ -256,11 +282,17 @@ void RenderSurface::queueBuffer(base::unique_fd readyFence) {
                                                         ? -1
                                                         : /* QTI_END */ dup(readyFence));
                 }
+            } else {
+                mDamageHistory.push_front(std::move(mBufferDamage));
+                if (mDamageHistory.size() > kDamageHistorySize) {
+                    mDamageHistory.pop_back();
+                }
             }
 
             mTexture = nullptr;
         }
     }
+    mBufferDamage = Region::INVALID_REGION;
 
     status_t result = mDisplaySurface->advanceFrame();
     if (result != NO_ERROR) {
@@ -268,6 +300,50 @@ void RenderSurface::queueBuffer(base::unique_fd readyFence) {
     }
 }
 
+void RenderSurface::cancelBuffer() {
+    if (mTexture == nullptr) {
+        return;
+    }
+
+    if (status_t result = mNativeWindow->cancelBuffer(mNativeWindow.get(),
+                                                      mTexture->getBuffer()->getNativeBuffer(), -1);
+        result != NO_ERROR) {
+        ALOGE("Error when cancelling buffer for display [%s]: %d", mDisplay.getName().c_str(),
+              result);
+    }
+    mTexture = nullptr;
+}
+
+void RenderSurface::setBufferDamage(const Region& damage) {
+    mBufferDamage = damage;
+}
+
+Region RenderSurface::getBufferRepaintRegion(const Region& damage) const {
+    const auto isInvalid = [](const Region& region) {
+        return region.isRect() && region.getBounds() == Rect::INVALID_RECT;
+    };
+
+    // The age is N if the buffer holds the contents of the buffer queued N buffers ago, in which
+    // case the damage of the N - 1 buffers queued since must be redrawn as well. The damage of
+    // the frame is only meaningful if the previously queued buffer had one.
+    int age = 0;
+    if (mTexture == nullptr || isInvalid(damage) ||
+        mNativeWindow->query(mNativeWindow.get(), NATIVE_WINDOW_BUFFER_AGE, &age) != NO_ERROR ||
+        age <= 0 || static_cast<size_t>(age) > mDamageHistory.size() ||
+        isInvalid(mDamageHistory.front())) {
+        return Region::INVALID_REGION;
+    }
+
+    Region repaintRegion = damage;
+    for (size_t i = 0; i + 1 < static_cast<size_t>(age); i++) {
+        if (isInvalid(mDamageHistory[i])) {
+            return Region::INVALID_REGION;
+        }
+        repaintRegion.orSelf(mDamageHistory[i]);
+    }
+    return repaintRegion;
+}
+
 void RenderSurface::onPresentDisplayCompleted() {
     mDisplaySurface->onFrameCommitted();
 }
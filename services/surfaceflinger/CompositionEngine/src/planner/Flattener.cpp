@@ -61,7 +61,9 @@ bool isSameStack(const std::vector<const LayerState*>& incomingLayers,
 } // namespace
 
 Flattener::Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables)
-      : mRenderEngine(renderEngine), mTunables(tunables), mTexturePool(mRenderEngine) {}
+      : mRenderEngine(renderEngine),
+        mTunables(tunables),
+        mTexturePool(mRenderEngine, TextureBudget::getShared()) {}
 
 NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& layers,
                                        NonBufferHash hash, time_point now) {
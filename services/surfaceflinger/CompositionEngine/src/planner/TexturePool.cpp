@@ -19,19 +19,145 @@
 #undef LOG_TAG
 #define LOG_TAG "Planner"
 
+#include <android-base/properties.h>
 #include <compositionengine/impl/planner/TexturePool.h>
 #include <renderengine/impl/ExternalTexture.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <utility>
+
 namespace android::compositionengine::impl::planner {
 
+namespace {
+
+size_t getTextureBytes(const renderengine::ExternalTexture& texture) {
+    // Textures are always allocated as RGBA_8888.
+    return static_cast<size_t>(texture.getBuffer()->getWidth()) *
+            static_cast<size_t>(texture.getBuffer()->getHeight()) * 4;
+}
+
+} // namespace
+
+const std::shared_ptr<TextureBudget>& TextureBudget::getShared() {
+    static const auto sBudget = std::make_shared<TextureBudget>(
+            base::GetUintProperty<size_t>(std::string("debug.sf.layer_caching_texture_budget_kb"),
+                                          0) *
+            1024);
+    return sBudget;
+}
+
+size_t TextureBudget::getAllocatedBytes() const {
+    std::scoped_lock lock(mMutex);
+    return mAllocatedBytes;
+}
+
+size_t TextureBudget::getEvictionCount() const {
+    std::scoped_lock lock(mMutex);
+    return mEvictionCount;
+}
+
+void TextureBudget::addPool(TexturePool* pool) {
+    std::scoped_lock lock(mMutex);
+    mPools.push_back(pool);
+}
+
+void TextureBudget::removePool(TexturePool* pool) {
+    std::scoped_lock lock(mMutex);
+    mPools.erase(std::remove(mPools.begin(), mPools.end(), pool), mPools.end());
+}
+
+void TextureBudget::allocate(size_t bytes) {
+    std::scoped_lock lock(mMutex);
+    mAllocatedBytes += bytes;
+
+    while (isOverBudgetLocked()) {
+        TexturePool* leastRecentlyUsedPool = nullptr;
+        std::optional<std::chrono::steady_clock::time_point> oldestIdleTime;
+        for (TexturePool* pool : mPools) {
+            const auto idleTime = pool->getOldestIdleTime();
+            if (idleTime && (!oldestIdleTime || *idleTime < *oldestIdleTime)) {
+                leastRecentlyUsedPool = pool;
+                oldestIdleTime = idleTime;
+            }
+        }
+
+        if (!leastRecentlyUsedPool) {
+            // Every texture is in use, so the budget is exceeded until some are returned.
+            ALOGV("Texture budget exceeded with no idle textures: %zu / %zu bytes",
+                  mAllocatedBytes, mBudgetBytes);
+            return;
+        }
+
+        const size_t evictedBytes = leastRecentlyUsedPool->evictOldestIdleTexture();
+        mAllocatedBytes -= std::min(evictedBytes, mAllocatedBytes);
+        if (evictedBytes != 0) {
+            mEvictionCount++;
+        }
+    }
+}
+
+void TextureBudget::release(size_t bytes) {
+    std::scoped_lock lock(mMutex);
+    mAllocatedBytes -= std::min(bytes, mAllocatedBytes);
+}
+
+bool TextureBudget::canRetain() const {
+    std::scoped_lock lock(mMutex);
+    return !isOverBudgetLocked();
+}
+
+void TextureBudget::dump(std::string& out) const {
+    std::scoped_lock lock(mMutex);
+    if (mBudgetBytes == 0) {
+        base::StringAppendF(&out, "TextureBudget (unbounded) has %zu KiB allocated",
+                            mAllocatedBytes / 1024);
+    } else {
+        base::StringAppendF(&out, "TextureBudget has %zu / %zu KiB allocated",
+                            mAllocatedBytes / 1024, mBudgetBytes / 1024);
+    }
+    base::StringAppendF(&out, " across %zu pools, %zu evictions\n", mPools.size(),
+                        mEvictionCount);
+}
+
+TexturePool::TexturePool(renderengine::RenderEngine& renderEngine,
+                         std::shared_ptr<TextureBudget> budget)
+      : mRenderEngine(renderEngine), mBudget(std::move(budget)), mEnabled(false) {
+    if (mBudget) {
+        mBudget->addPool(this);
+    }
+}
+
+TexturePool::~TexturePool() {
+    if (mBudget) {
+        mBudget->removePool(this);
+    }
+    clearPool();
+}
+
+void TexturePool::clearPool() {
+    std::deque<Entry> pool;
+    {
+        std::scoped_lock lock(mMutex);
+        pool = std::exchange(mPool, {});
+    }
+    if (mBudget) {
+        for (const Entry& entry : pool) {
+            mBudget->release(getTextureBytes(*entry.texture));
+        }
+    }
+}
+
 void TexturePool::allocatePool() {
-    mPool.clear();
+    clearPool();
     if (mEnabled && mSize.isValid()) {
-        mPool.resize(kMinPoolSize);
-        std::generate_n(mPool.begin(), kMinPoolSize, [&]() {
+        std::deque<Entry> pool(kMinPoolSize);
+        std::generate_n(pool.begin(), kMinPoolSize, [&]() {
             return Entry{genTexture(), nullptr};
         });
+
+        std::scoped_lock lock(mMutex);
+        mPool = std::move(pool);
     }
 }
 
@@ -44,20 +170,31 @@ void TexturePool::setDisplaySize(ui::Size size) {
 }
 
 std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
-    if (mPool.empty()) {
-        return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
+    {
+        std::scoped_lock lock(mMutex);
+        if (!mPool.empty()) {
+            const auto entry = mPool.front();
+            mPool.pop_front();
+            return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
+        }
     }
 
-    const auto entry = mPool.front();
-    mPool.pop_front();
-    return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
+    return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
 }
 
 void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
                                 const sp<Fence>& fence) {
+    const size_t bytes = getTextureBytes(*texture);
+    if (!retainTexture(std::move(texture), fence) && mBudget) {
+        mBudget->release(bytes);
+    }
+}
+
+bool TexturePool::retainTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
+                                const sp<Fence>& fence) {
     // Drop the texture on the floor if the pool is not enabled
     if (!mEnabled) {
-        return;
+        return false;
     }
 
     // Or the texture on the floor if the pool is no longer tracking textures of the same size.
@@ -67,22 +204,51 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
               "current: (%dx%d))",
               texture->getBuffer()->getWidth(), texture->getBuffer()->getHeight(), mSize.getWidth(),
               mSize.getHeight());
-        return;
+        return false;
+    }
+
+    // Or if the textures of all displays sharing the budget no longer fit in it.
+    if (mBudget && !mBudget->canRetain()) {
+        ALOGV("Deallocating texture from Planner's pool - texture budget exceeded");
+        return false;
     }
 
+    std::scoped_lock lock(mMutex);
+
     // Also ensure the pool does not grow beyond a maximum size.
     if (mPool.size() == kMaxPoolSize) {
         ALOGD("Deallocating texture from Planner's pool - max size [%" PRIu64 "] reached",
               static_cast<uint64_t>(kMaxPoolSize));
-        return;
+        return false;
     }
 
     mPool.push_back({std::move(texture), fence});
+    return true;
+}
+
+std::optional<std::chrono::steady_clock::time_point> TexturePool::getOldestIdleTime() const {
+    std::scoped_lock lock(mMutex);
+    if (mPool.empty()) {
+        return std::nullopt;
+    }
+    return mPool.front().lastUsed;
+}
+
+size_t TexturePool::evictOldestIdleTexture() {
+    std::scoped_lock lock(mMutex);
+    if (mPool.empty()) {
+        return 0;
+    }
+
+    const size_t bytes = getTextureBytes(*mPool.front().texture);
+    ALOGV("Evicting texture from Planner's pool - texture budget exceeded");
+    mPool.pop_front();
+    return bytes;
 }
 
 std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
     LOG_ALWAYS_FATAL_IF(!mSize.isValid(), "Attempted to generate texture with invalid size");
-    return std::make_shared<
+    auto texture = std::make_shared<
             renderengine::impl::
                     ExternalTexture>(sp<GraphicBuffer>::
                                              make(static_cast<uint32_t>(mSize.getWidth()),
@@ -96,6 +262,10 @@ std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
                                      mRenderEngine,
                                      renderengine::impl::ExternalTexture::Usage::READABLE |
                                              renderengine::impl::ExternalTexture::Usage::WRITEABLE);
+    if (mBudget) {
+        mBudget->allocate(getTextureBytes(*texture));
+    }
+    return texture;
 }
 
 void TexturePool::setEnabled(bool enabled) {
@@ -104,9 +274,17 @@ void TexturePool::setEnabled(bool enabled) {
 }
 
 void TexturePool::dump(std::string& out) const {
-    base::StringAppendF(&out,
-                        "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32 "]\n",
-                        mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width, mSize.height);
+    {
+        std::scoped_lock lock(mMutex);
+        base::StringAppendF(&out,
+                            "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32
+                            "]\n",
+                            mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width,
+                            mSize.height);
+    }
+    if (mBudget) {
+        mBudget->dump(out);
+    }
 }
 
 } // namespace android::compositionengine::impl::planner
\ No newline at end of file
@@ -39,6 +39,7 @@
 #include "MockHWC2.h"
 #include "MockHWComposer.h"
 #include "MockPowerAdvisor.h"
+#include "RegionMatcher.h"
 #include "ftl/future.h"
 
 #include <aidl/android/hardware/graphics/composer3/Composition.h>
@@ -133,6 +134,7 @@ struct DisplayTestCommon : public testing::Test {
         MOCK_METHOD1(applyChangedTypesToLayers, void(const impl::Display::ChangedTypes&));
         MOCK_METHOD1(applyDisplayRequests, void(const impl::Display::DisplayRequests&));
         MOCK_METHOD1(applyLayerRequestsToLayers, void(const impl::Display::LayerRequests&));
+        MOCK_CONST_METHOD0(getLayerStackGeometryHash, size_t());
 
         const compositionengine::CompositionEngine& mCompositionEngine;
         impl::OutputCompositionState mState;
@@ -628,6 +630,9 @@ TEST_F(DisplayChooseCompositionStrategyTest, normalOperation) {
     EXPECT_CALL(*mDisplay, applyLayerRequestsToLayers(mDeviceRequestedChanges.layerRequests))
             .Times(1);
     EXPECT_CALL(*mDisplay, allLayersRequireClientComposition()).WillOnce(Return(false));
+    EXPECT_CALL(*mDisplay, getLayerStackGeometryHash()).WillOnce(Return(0u));
+    EXPECT_CALL(mHwComposer, getValidateSkipped(HalDisplayId(DEFAULT_DISPLAY_ID)))
+            .WillOnce(Return(false));
 
     chooseCompositionStrategy(mDisplay.get());
 
@@ -680,6 +685,9 @@ TEST_F(DisplayChooseCompositionStrategyTest, normalOperationWithChanges) {
     EXPECT_CALL(*mDisplay, applyLayerRequestsToLayers(mDeviceRequestedChanges.layerRequests))
             .Times(1);
     EXPECT_CALL(*mDisplay, allLayersRequireClientComposition()).WillOnce(Return(false));
+    EXPECT_CALL(*mDisplay, getLayerStackGeometryHash()).WillOnce(Return(0u));
+    EXPECT_CALL(mHwComposer, getValidateSkipped(HalDisplayId(DEFAULT_DISPLAY_ID)))
+            .WillOnce(Return(false));
 
     chooseCompositionStrategy(mDisplay.get());
 
@@ -688,6 +696,44 @@ TEST_F(DisplayChooseCompositionStrategyTest, normalOperationWithChanges) {
     EXPECT_TRUE(state.usesDeviceComposition);
 }
 
+TEST_F(DisplayChooseCompositionStrategyTest, predictsValidateSkipForUnchangedGeometry) {
+    constexpr size_t kGeometryHash = 0x1234;
+    constexpr size_t kChangedGeometryHash = 0x5678;
+
+    EXPECT_CALL(*mDisplay, anyLayersRequireClientComposition()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplay, allLayersRequireClientComposition()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mHwComposer,
+                getDeviceCompositionChanges(HalDisplayId(DEFAULT_DISPLAY_ID), false, _, _, _))
+            .WillRepeatedly(Return(NO_ERROR));
+    EXPECT_CALL(mHwComposer, getValidateSkipped(HalDisplayId(DEFAULT_DISPLAY_ID)))
+            .WillOnce(Return(true))
+            .WillOnce(Return(true))
+            .WillOnce(Return(false))
+            .WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay, getLayerStackGeometryHash())
+            .WillOnce(Return(kGeometryHash))
+            .WillOnce(Return(kGeometryHash))
+            .WillOnce(Return(kGeometryHash))
+            .WillOnce(Return(kChangedGeometryHash));
+
+    // The first device-only frame establishes the prediction, and is not counted.
+    chooseCompositionStrategy(mDisplay.get());
+    EXPECT_EQ(0u, mDisplay->getValidateSkipPredictionStats().hits);
+    EXPECT_EQ(0u, mDisplay->getValidateSkipPredictionStats().misses);
+
+    chooseCompositionStrategy(mDisplay.get());
+    EXPECT_EQ(1u, mDisplay->getValidateSkipPredictionStats().hits);
+
+    // The HWC validated despite the unchanged geometry.
+    chooseCompositionStrategy(mDisplay.get());
+    EXPECT_EQ(1u, mDisplay->getValidateSkipPredictionStats().misses);
+
+    // Nothing is predicted after a miss.
+    chooseCompositionStrategy(mDisplay.get());
+    EXPECT_EQ(1u, mDisplay->getValidateSkipPredictionStats().hits);
+    EXPECT_EQ(1u, mDisplay->getValidateSkipPredictionStats().misses);
+}
+
 /*
  * Display::getSkipColorTransform()
  */
@@ -938,6 +984,60 @@ TEST_F(DisplaySetExpensiveRenderingExpectedTest, forwardsToPowerAdvisor) {
     mDisplay->setExpensiveRenderingExpected(false);
 }
 
+/*
+ * Display::beginFrame()
+ */
+
+struct DisplayBeginFrameTest : public DisplayTestCommon {
+    DisplayBeginFrameTest() {
+        mDisplay->setRenderSurfaceForTest(std::unique_ptr<RenderSurface>(mRenderSurface));
+        EXPECT_CALL(*mRenderSurface, beginFrame(true));
+
+        // The layer stack is scaled down by half into the middle of the framebuffer.
+        auto& state = mDisplay->editState();
+        state.layerStackSpace.setBounds(ui::Size(400, 400));
+        state.layerStackSpace.setContent(Rect(0, 0, 400, 400));
+        state.framebufferSpace.setBounds(ui::Size(400, 400));
+        state.framebufferSpace.setContent(Rect(100, 100, 300, 300));
+        state.displaySpace = state.framebufferSpace;
+        state.lastCompositionHadVisibleLayers = true;
+    }
+
+    std::shared_ptr<impl::Display> mDisplay =
+            impl::createDisplay(mCompositionEngine,
+                                DisplayCreationArgsBuilder()
+                                        .setId(HAL_VIRTUAL_DISPLAY_ID)
+                                        .setPixels(DEFAULT_RESOLUTION)
+                                        .setIsSecure(false)
+                                        .setPowerAdvisor(&mPowerAdvisor)
+                                        .build());
+    mock::RenderSurface* mRenderSurface = new StrictMock<mock::RenderSurface>();
+};
+
+TEST_F(DisplayBeginFrameTest, transformsDamageToFramebufferSpace) {
+    mDisplay->editState().dirtyRegion = Region(Rect(40, 60, 120, 200));
+
+    EXPECT_CALL(*mRenderSurface, setFrameDamage(RegionEq(Region(Rect(120, 130, 160, 200)))));
+    mDisplay->beginFrame();
+}
+
+TEST_F(DisplayBeginFrameTest, roundsDamageOutwards) {
+    // Maps to (100.5, 100.5, 102.5, 102.5).
+    mDisplay->editState().dirtyRegion = Region(Rect(1, 1, 5, 5));
+
+    EXPECT_CALL(*mRenderSurface, setFrameDamage(RegionEq(Region(Rect(100, 100, 103, 103)))));
+    mDisplay->beginFrame();
+}
+
+TEST_F(DisplayBeginFrameTest, damagesWholeBufferIfWholeOutputIsDirty) {
+    // As set by Output::dirtyEntireOutput, in display space. The transform alone would only damage
+    // the part of the buffer the layer stack maps to.
+    mDisplay->editState().dirtyRegion = Region(Rect(400, 400));
+
+    EXPECT_CALL(*mRenderSurface, setFrameDamage(RegionEq(Region(Rect(400, 400)))));
+    mDisplay->beginFrame();
+}
+
 /*
  * Display::finishFrame()
  */
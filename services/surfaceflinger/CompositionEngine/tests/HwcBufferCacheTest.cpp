@@ -190,5 +190,61 @@ TEST_F(HwcBufferCacheTest, uncache_whenOverrideUncached_returnsInvalidSlotNumber
     EXPECT_EQ(cache.uncache(mBuffer2->getId()), UINT32_MAX);
 }
 
+TEST_F(HwcBufferCacheTest, evictStaleBuffers_evictsBuffersNoLongerInUse) {
+    HwcBufferCache cache;
+
+    HwcSlotAndBuffer slotAndBufferFor1 = cache.getHwcSlotAndBuffer(mBuffer1);
+    ASSERT_NE(slotAndBufferFor1.slot, UINT32_MAX);
+
+    std::vector<uint32_t> staleSlots;
+    for (int i = 0; i < 100 && staleSlots.empty(); ++i) {
+        cache.getHwcSlotAndBuffer(mBuffer2);
+        staleSlots = cache.evictStaleBuffers();
+    }
+    EXPECT_EQ(staleSlots, std::vector<uint32_t>{slotAndBufferFor1.slot});
+    // the 1st buffer is no longer in the cache because it was evicted
+    EXPECT_EQ(cache.uncache(mBuffer1->getId()), UINT32_MAX);
+    // the 2nd buffer is still in use, so it was not evicted
+    EXPECT_NE(cache.uncache(mBuffer2->getId()), UINT32_MAX);
+}
+
+TEST_F(HwcBufferCacheTest, evictStaleBuffers_keepsBuffersInRotation) {
+    HwcBufferCache cache;
+
+    // a video decoder cycling through a dozen buffers
+    sp<GraphicBuffer> graphicBuffers[12];
+    for (auto& graphicBuffer : graphicBuffers) {
+        graphicBuffer = sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        HwcSlotAndBuffer slotAndBuffer = cache.getHwcSlotAndBuffer(graphicBuffers[i % 12]);
+        // once in the cache, the buffers are never sent again
+        if (i >= 12) {
+            EXPECT_EQ(slotAndBuffer.buffer, nullptr);
+        }
+        EXPECT_TRUE(cache.evictStaleBuffers().empty());
+    }
+}
+
+TEST_F(HwcBufferCacheTest, evictStaleBuffers_reusesEvictedSlots) {
+    HwcBufferCache cache;
+
+    HwcSlotAndBuffer slotAndBufferFor1 = cache.getHwcSlotAndBuffer(mBuffer1);
+    ASSERT_NE(slotAndBufferFor1.slot, UINT32_MAX);
+
+    std::vector<uint32_t> staleSlots;
+    for (int i = 0; i < 100 && staleSlots.empty(); ++i) {
+        cache.getHwcSlotAndBuffer(mBuffer2);
+        staleSlots = cache.evictStaleBuffers();
+    }
+    ASSERT_FALSE(staleSlots.empty());
+
+    // the slot freed by the stale buffer is used for the next new buffer
+    sp<GraphicBuffer> buffer3 = sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+    HwcSlotAndBuffer slotAndBufferFor3 = cache.getHwcSlotAndBuffer(buffer3);
+    EXPECT_EQ(slotAndBufferFor3.slot, slotAndBufferFor1.slot);
+    EXPECT_EQ(slotAndBufferFor3.buffer, buffer3);
+}
+
 } // namespace
 } // namespace android::compositionengine
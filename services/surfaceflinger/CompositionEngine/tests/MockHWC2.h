@@ -77,6 +77,7 @@ public:
                  Error(const std::string&, bool, const std::vector<uint8_t>&));
     MOCK_METHOD1(setBrightness, Error(float));
     MOCK_METHOD1(setBlockingRegion, Error(const android::Region&));
+    MOCK_METHOD0(invalidateCachedState, void());
 };
 
 } // namespace mock
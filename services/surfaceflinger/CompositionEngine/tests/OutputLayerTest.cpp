@@ -41,6 +41,7 @@ namespace {
 namespace hal = android::hardware::graphics::composer::hal;
 
 using testing::_;
+using testing::AnyNumber;
 using testing::InSequence;
 using testing::Mock;
 using testing::NiceMock;
@@ -835,6 +836,7 @@ struct OutputLayerWriteStateToHWCTest : public OutputLayerTest {
                 .WillRepeatedly(Return(&mDisplayColorProfile));
         EXPECT_CALL(mDisplayColorProfile, getSupportedPerFrameMetadata())
                 .WillRepeatedly(Return(kSupportedPerFrameMetadata));
+        EXPECT_CALL(*mHwcLayer, invalidateCachedState()).Times(AnyNumber());
     }
     // Some tests may need to simulate unsupported HWC calls
     enum class SimulateUnsupported { None, ColorTransform };
@@ -1035,6 +1037,30 @@ TEST_F(OutputLayerWriteStateToHWCTest, canSetPerFrameStateForSolidColor) {
                                  /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
 }
 
+TEST_F(OutputLayerWriteStateToHWCTest, invalidatesCachedStateIfGeometryIsDirty) {
+    expectGeometryCommonCalls();
+    expectPerFrameCommonCalls();
+
+    expectNoSetCompositionTypeCall();
+    EXPECT_CALL(mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+    EXPECT_CALL(*mHwcLayer, invalidateCachedState());
+
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ true, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+}
+
+TEST_F(OutputLayerWriteStateToHWCTest, keepsCachedStateIfGeometryIsNotDirty) {
+    mLayerFEState.compositionType = Composition::SIDEBAND;
+
+    expectPerFrameCommonCalls();
+    expectSetSidebandHandleCall();
+    expectSetCompositionTypeCall(Composition::SIDEBAND);
+    EXPECT_CALL(*mHwcLayer, invalidateCachedState()).Times(0);
+
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+}
+
 TEST_F(OutputLayerWriteStateToHWCTest, canSetPerFrameStateForSideband) {
     mLayerFEState.compositionType = Composition::SIDEBAND;
 
@@ -1411,6 +1437,33 @@ TEST_F(OutputLayerUncacheBufferTest, canUncacheAndReuseSlot) {
     Mock::VerifyAndClearExpectations(&mHwcLayer);
 }
 
+TEST_F(OutputLayerUncacheBufferTest, clearsStaleBufferSlotsBeforeSendingBuffer) {
+    // Buffer1 is stored in slot 0
+    mLayerFEState.buffer = kBuffer1;
+    EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 0, kBuffer1, kFence));
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    // Buffer2 is stored in slot 1, and stays the only buffer in use long enough for Buffer1 to
+    // become stale. Slot 0 is cleared once, with Buffer2 left active.
+    mLayerFEState.buffer = kBuffer2;
+    EXPECT_CALL(mHwcLayer, setBufferSlotsToClear(std::vector<uint32_t>{0}, /*activeBufferSlot*/ 1))
+            .Times(1);
+    for (int i = 0; i < 40; i++) {
+        mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                     /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+    }
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+
+    // Buffer1 is sent to HWC again when it comes back.
+    mLayerFEState.buffer = kBuffer1;
+    EXPECT_CALL(mHwcLayer, setBuffer(/*slot*/ 0, kBuffer1, kFence));
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+    Mock::VerifyAndClearExpectations(&mHwcLayer);
+}
+
 /*
  * OutputLayer::writeCursorPositionToHWC()
  */
@@ -33,6 +33,7 @@
 #include <ui/Rect.h>
 #include <ui/Region.h>
 
+#include <array>
 #include <cmath>
 #include <cstdint>
 
@@ -50,6 +51,7 @@ using testing::DoAll;
 using testing::ElementsAre;
 using testing::ElementsAreArray;
 using testing::Eq;
+using testing::Field;
 using testing::InSequence;
 using testing::Invoke;
 using testing::IsEmpty;
@@ -898,6 +900,27 @@ TEST_F(OutputUpdateAndWriteCompositionStateTest, forcesClientCompositionForAllLa
     mOutput->writeCompositionState(args);
 }
 
+TEST_F(OutputUpdateAndWriteCompositionStateTest, updatesLayersInParallel) {
+    constexpr size_t kLayerCount = 50;
+    constexpr size_t kBlurLayerIndex = 30;
+    std::array<InjectedLayer, kLayerCount> layers;
+
+    layers[kBlurLayerIndex].layerFEState.backgroundBlurRadius = 10;
+    for (size_t i = 0; i < kLayerCount; i++) {
+        EXPECT_CALL(*layers[i].outputLayer,
+                    updateCompositionState(true, i <= kBlurLayerIndex, ui::Transform::ROT_90));
+        injectOutputLayer(layers[i]);
+    }
+
+    mOutput->editState().isEnabled = true;
+
+    CompositionRefreshArgs args;
+    args.updatingGeometryThisFrame = true;
+    args.internalDisplayRotationFlags = ui::Transform::ROT_90;
+    args.parallelLayerUpdateThreshold = 1;
+    mOutput->updateCompositionState(args);
+}
+
 TEST_F(OutputUpdateAndWriteCompositionStateTest, peekThroughLayerChangesOrder) {
     renderengine::mock::RenderEngine renderEngine;
     InjectedLayer layer0;
@@ -1164,6 +1187,65 @@ TEST_F(OutputPrepareFrameAsyncTest, predictionMiss) {
     EXPECT_TRUE(result.bufferAvailable());
 }
 
+/*
+ * Output::prepareFrameWithEarlyDequeue()
+ */
+
+using OutputPrepareFrameWithEarlyDequeueTest = OutputPrepareFrameAsyncTest;
+
+TEST_F(OutputPrepareFrameWithEarlyDequeueTest, keepsClientTargetForClientComposition) {
+    mOutput.editState().isEnabled = true;
+    mOutput.editState().usesClientComposition = true;
+    mOutput.editState().usesDeviceComposition = false;
+    std::promise<bool> p;
+    p.set_value(true);
+    std::shared_ptr<renderengine::ExternalTexture> tex =
+            std::make_shared<renderengine::mock::FakeExternalTexture>(1, 1,
+                                                                      HAL_PIXEL_FORMAT_RGBA_8888, 1,
+                                                                      2);
+
+    EXPECT_CALL(mOutput, chooseCompositionStrategyAsync(_)).WillOnce([&] {
+        return p.get_future();
+    });
+    EXPECT_CALL(mOutput, updateProtectedContentState());
+    EXPECT_CALL(*mRenderSurface, dequeueBuffer(_)).WillOnce(Return(tex));
+    EXPECT_CALL(mOutput, resetCompositionStrategy());
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+    EXPECT_CALL(*mRenderSurface, prepareFrame(true, false));
+
+    impl::GpuCompositionResult result = mOutput.prepareFrameWithEarlyDequeue();
+    EXPECT_EQ(mOutput.getState().strategyPrediction, CompositionStrategyPredictionState::DISABLED);
+    EXPECT_TRUE(mOutput.getState().previousDeviceRequestedSuccess);
+    ASSERT_TRUE(result.bufferAvailable());
+    EXPECT_EQ(tex, result.buffer);
+}
+
+TEST_F(OutputPrepareFrameWithEarlyDequeueTest, cancelsUnusedClientTarget) {
+    mOutput.editState().isEnabled = true;
+    mOutput.editState().usesClientComposition = false;
+    mOutput.editState().usesDeviceComposition = true;
+    mOutput.editState().flipClientTarget = false;
+    std::promise<bool> p;
+    p.set_value(true);
+    std::shared_ptr<renderengine::ExternalTexture> tex =
+            std::make_shared<renderengine::mock::FakeExternalTexture>(1, 1,
+                                                                      HAL_PIXEL_FORMAT_RGBA_8888, 1,
+                                                                      2);
+
+    EXPECT_CALL(mOutput, chooseCompositionStrategyAsync(_)).WillOnce([&] {
+        return p.get_future();
+    });
+    EXPECT_CALL(mOutput, updateProtectedContentState());
+    EXPECT_CALL(*mRenderSurface, dequeueBuffer(_)).WillOnce(Return(tex));
+    EXPECT_CALL(mOutput, resetCompositionStrategy());
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+    EXPECT_CALL(*mRenderSurface, prepareFrame(false, true));
+    EXPECT_CALL(*mRenderSurface, cancelBuffer());
+
+    impl::GpuCompositionResult result = mOutput.prepareFrameWithEarlyDequeue();
+    EXPECT_FALSE(result.bufferAvailable());
+}
+
 /*
  * Output::prepare()
  */
@@ -1422,6 +1504,102 @@ TEST_F(OutputCollectVisibleLayersTest, processesCandidateLayersReversedAndSetsOu
     mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
 }
 
+struct OutputCollectVisibleLayersReuseTest : public testing::Test {
+    struct OutputPartialMock : public OutputPartialMockBase {
+        // Sets up the helper functions called by the function under test to use
+        // mock implementations.
+        MOCK_METHOD(bool, includesLayer, (const sp<compositionengine::LayerFE>&),
+                    (const, override));
+    };
+
+    OutputCollectVisibleLayersReuseTest() {
+        EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+        EXPECT_CALL(mOutput, finalizePendingOutputLayers()).WillRepeatedly(Return());
+
+        mOutput.mState.displaySpace.setBounds(ui::Size(200, 300));
+        mOutput.mState.layerStackSpace.setContent(Rect(0, 0, 200, 300));
+        mOutput.mState.transform = ui::Transform(TR_IDENT, 200, 300);
+
+        mLayer1.layerFEState.isVisible = true;
+        mLayer1.layerFEState.isOpaque = true;
+        mLayer1.layerFEState.geomLayerBounds = FloatRect{0, 0, 200, 300};
+        mLayer1.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 200, 300);
+
+        mLayer2.layerFEState.isVisible = true;
+        mLayer2.layerFEState.isOpaque = true;
+        mLayer2.layerFEState.geomLayerBounds = FloatRect{0, 0, 100, 100};
+        mLayer2.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 100, 100);
+
+        mRefreshArgs.layers.push_back(mLayer1.layerFE);
+        mRefreshArgs.layers.push_back(mLayer2.layerFE);
+    }
+
+    void collectVisibleLayers() {
+        LayerFESet geomSnapshots;
+        Output::CoverageState coverageState{geomSnapshots};
+        mOutput.collectVisibleLayers(mRefreshArgs, coverageState);
+        mAboveOpaqueLayers = coverageState.aboveOpaqueLayers;
+    }
+
+    // Runs the first rebuild, which creates the output layers.
+    void collectVisibleLayersWithoutOutputLayers() {
+        EXPECT_CALL(mOutput, ensureOutputLayer(Eq(std::nullopt), Eq(mLayer2.layerFE)))
+                .WillOnce(Return(&mLayer2.outputLayer));
+        EXPECT_CALL(mOutput, ensureOutputLayer(Eq(std::nullopt), Eq(mLayer1.layerFE)))
+                .WillOnce(Return(&mLayer1.outputLayer));
+
+        collectVisibleLayers();
+
+        EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(2u));
+        EXPECT_CALL(mOutput, getOutputLayerOrderedByZByIndex(0u))
+                .WillRepeatedly(Return(&mLayer1.outputLayer));
+        EXPECT_CALL(mOutput, getOutputLayerOrderedByZByIndex(1u))
+                .WillRepeatedly(Return(&mLayer2.outputLayer));
+        EXPECT_CALL(mOutput, ensureOutputLayer(Eq(1u), Eq(mLayer2.layerFE)))
+                .WillOnce(Return(&mLayer2.outputLayer));
+        EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer1.layerFE)))
+                .WillOnce(Return(&mLayer1.outputLayer));
+    }
+
+    StrictMock<OutputPartialMock> mOutput;
+    CompositionRefreshArgs mRefreshArgs;
+    Region mAboveOpaqueLayers;
+    NonInjectedLayer mLayer1;
+    NonInjectedLayer mLayer2;
+};
+
+TEST_F(OutputCollectVisibleLayersReuseTest, reusesCoverageOfLayersAboveChangedLayer) {
+    EXPECT_CALL(mOutput, includesLayer(Eq(mLayer2.layerFE))).Times(1).WillRepeatedly(Return(true));
+    EXPECT_CALL(mOutput, includesLayer(Eq(mLayer1.layerFE))).Times(2).WillRepeatedly(Return(true));
+
+    collectVisibleLayersWithoutOutputLayers();
+
+    mLayer1.layerFEState.geomLayerBounds = FloatRect{0, 0, 200, 200};
+    mLayer1.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 200, 200);
+    collectVisibleLayers();
+
+    EXPECT_THAT(mLayer2.outputLayerState.visibleRegion, RegionEq(Region(Rect(0, 0, 100, 100))));
+    EXPECT_THAT(mLayer1.outputLayerState.visibleRegion,
+                RegionEq(Region(Rect(0, 0, 200, 200)).subtract(Rect(0, 0, 100, 100))));
+    EXPECT_THAT(mAboveOpaqueLayers, RegionEq(Region(Rect(0, 0, 200, 200))));
+}
+
+TEST_F(OutputCollectVisibleLayersReuseTest, recomputesCoverageBelowChangedLayer) {
+    EXPECT_CALL(mOutput, includesLayer(Eq(mLayer2.layerFE))).Times(2).WillRepeatedly(Return(true));
+    EXPECT_CALL(mOutput, includesLayer(Eq(mLayer1.layerFE))).Times(2).WillRepeatedly(Return(true));
+
+    collectVisibleLayersWithoutOutputLayers();
+
+    mLayer2.layerFEState.geomLayerBounds = FloatRect{0, 0, 50, 50};
+    mLayer2.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 50, 50);
+    collectVisibleLayers();
+
+    EXPECT_THAT(mLayer2.outputLayerState.visibleRegion, RegionEq(Region(Rect(0, 0, 50, 50))));
+    EXPECT_THAT(mLayer1.outputLayerState.visibleRegion,
+                RegionEq(Region(Rect(0, 0, 200, 300)).subtract(Rect(0, 0, 50, 50))));
+    EXPECT_THAT(mAboveOpaqueLayers, RegionEq(Region(Rect(0, 0, 200, 300))));
+}
+
 /*
  * Output::ensureOutputLayerIfVisible()
  */
@@ -2021,11 +2199,13 @@ struct OutputPresentTest : public testing::Test {
         MOCK_METHOD0(beginFrame, void());
         MOCK_METHOD0(prepareFrame, void());
         MOCK_METHOD0(prepareFrameAsync, GpuCompositionResult());
+        MOCK_METHOD0(prepareFrameWithEarlyDequeue, GpuCompositionResult());
         MOCK_METHOD1(devOptRepaintFlash, void(const compositionengine::CompositionRefreshArgs&));
         MOCK_METHOD1(finishFrame, void(GpuCompositionResult&&));
         MOCK_METHOD0(postFramebuffer, void());
         MOCK_METHOD1(renderCachedSets, void(const compositionengine::CompositionRefreshArgs&));
         MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
+        MOCK_METHOD1(canDequeueClientTargetEarly, bool(const CompositionRefreshArgs&));
     };
 
     StrictMock<OutputPartialMock> mOutput;
@@ -2042,6 +2222,7 @@ TEST_F(OutputPresentTest, justInvokesChildFunctionsInSequence) {
     EXPECT_CALL(mOutput, setColorTransform(Ref(args)));
     EXPECT_CALL(mOutput, beginFrame());
     EXPECT_CALL(mOutput, canPredictCompositionStrategy(Ref(args))).WillOnce(Return(false));
+    EXPECT_CALL(mOutput, canDequeueClientTargetEarly(Ref(args))).WillOnce(Return(false));
     EXPECT_CALL(mOutput, prepareFrame());
     EXPECT_CALL(mOutput, devOptRepaintFlash(Ref(args)));
     EXPECT_CALL(mOutput, finishFrame(_));
@@ -2071,6 +2252,27 @@ TEST_F(OutputPresentTest, predictingCompositionStrategyInvokesPrepareFrameAsync)
     mOutput.present(args);
 }
 
+TEST_F(OutputPresentTest, likelyClientCompositionInvokesPrepareFrameWithEarlyDequeue) {
+    CompositionRefreshArgs args;
+
+    InSequence seq;
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, setColorTransform(Ref(args)));
+    EXPECT_CALL(mOutput, beginFrame());
+    EXPECT_CALL(mOutput, canPredictCompositionStrategy(Ref(args))).WillOnce(Return(false));
+    EXPECT_CALL(mOutput, canDequeueClientTargetEarly(Ref(args))).WillOnce(Return(true));
+    EXPECT_CALL(mOutput, prepareFrameWithEarlyDequeue());
+    EXPECT_CALL(mOutput, devOptRepaintFlash(Ref(args)));
+    EXPECT_CALL(mOutput, finishFrame(_));
+    EXPECT_CALL(mOutput, postFramebuffer());
+    EXPECT_CALL(mOutput, renderCachedSets(Ref(args)));
+
+    mOutput.present(args);
+}
+
 /*
  * Output::updateColorProfile()
  */
@@ -3197,6 +3399,21 @@ TEST_F(OutputPostFramebufferTest, ifEnabledMustFlipThenPresentThenSendPresentCom
     mOutput.postFramebuffer();
 }
 
+TEST_F(OutputPostFramebufferTest, movesDirtyRegionToLastFrameDirtyRegion) {
+    mOutput.mState.isEnabled = true;
+    mOutput.mState.dirtyRegion = Region(Rect(10, 20, 30, 40));
+
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+    EXPECT_CALL(mOutput, presentAndGetFrameFences())
+            .WillOnce(Return(compositionengine::Output::FrameFences{}));
+    EXPECT_CALL(*mRenderSurface, onPresentDisplayCompleted());
+
+    mOutput.postFramebuffer();
+
+    EXPECT_TRUE(mOutput.mState.dirtyRegion.isEmpty());
+    EXPECT_THAT(mOutput.mState.lastFrameDirtyRegion, RegionEq(Region(Rect(10, 20, 30, 40))));
+}
+
 TEST_F(OutputPostFramebufferTest, releaseFencesAreSentToLayerFE) {
     // Simulate getting release fences from each layer, and ensure they are passed to the
     // front-end layer interface for each layer correctly.
@@ -3569,6 +3786,72 @@ TEST_F(OutputComposeSurfacesTest,
     verify().execute().expectAFenceWasReturned();
 }
 
+TEST_F(OutputComposeSurfacesTest, partialClientCompositionDamagesWholeBufferOnFirstFrame) {
+    const Rect kBufferBounds{100, 100};
+    mOutput.mState.framebufferSpace = ProjectionSpace(ui::Size(100, 100), kBufferBounds);
+    mOutput.mState.layerStackSpace = ProjectionSpace(ui::Size(100, 100), kBufferBounds);
+    mOutput.setPartialClientComposition(true);
+
+    LayerFE::LayerSettings r1;
+    r1.geometry.boundaries = FloatRect{1, 2, 3, 4};
+
+    EXPECT_CALL(mOutput, getSkipColorTransform()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplayColorProfile, hasWideColorGamut()).WillRepeatedly(Return(true));
+    EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mRenderEngine, isProtected()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mOutput, generateClientCompositionRequests(_, kDefaultOutputDataspace, _))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{r1}));
+    EXPECT_CALL(mOutput, appendRegionFlashRequests(RegionEq(Region()), _)).WillOnce(Return());
+
+    EXPECT_CALL(*mRenderSurface, setBufferDamage(RegionEq(Region(kBufferBounds))));
+    EXPECT_CALL(*mRenderSurface, getBufferRepaintRegion(RegionEq(Region(kBufferBounds))))
+            .WillOnce(Return(Region::INVALID_REGION));
+    EXPECT_CALL(mRenderEngine,
+                drawLayers(Field(&renderengine::DisplaySettings::scissor, Rect::INVALID_RECT),
+                           ElementsAre(r1), _, false, _))
+            .WillOnce([&](const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) -> ftl::Future<FenceResult> {
+                return ftl::yield<FenceResult>(Fence::NO_FENCE);
+            });
+
+    base::unique_fd fd;
+    EXPECT_TRUE(mOutput.composeSurfaces(Region(), mOutputBuffer, fd));
+}
+
+TEST_F(OutputComposeSurfacesTest, partialClientCompositionScissorsToBufferRepaintRegion) {
+    const Rect kBufferBounds{100, 100};
+    const Rect kRepaintBounds{10, 20, 30, 40};
+    mOutput.mState.framebufferSpace = ProjectionSpace(ui::Size(100, 100), kBufferBounds);
+    mOutput.mState.layerStackSpace = ProjectionSpace(ui::Size(100, 100), kBufferBounds);
+    mOutput.setPartialClientComposition(true);
+
+    EXPECT_CALL(mOutput, getSkipColorTransform()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplayColorProfile, hasWideColorGamut()).WillRepeatedly(Return(true));
+    EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mRenderEngine, isProtected()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mOutput, generateClientCompositionRequests(_, kDefaultOutputDataspace, _))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{}));
+    EXPECT_CALL(mOutput, appendRegionFlashRequests(RegionEq(Region()), _)).WillOnce(Return());
+
+    EXPECT_CALL(*mRenderSurface, setBufferDamage(_));
+    EXPECT_CALL(*mRenderSurface, getBufferRepaintRegion(_))
+            .WillOnce(Return(Region(kRepaintBounds)));
+    EXPECT_CALL(mRenderEngine,
+                drawLayers(Field(&renderengine::DisplaySettings::scissor, kRepaintBounds),
+                           IsEmpty(), _, false, _))
+            .WillOnce([&](const renderengine::DisplaySettings&,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                          base::unique_fd&&) -> ftl::Future<FenceResult> {
+                return ftl::yield<FenceResult>(Fence::NO_FENCE);
+            });
+
+    base::unique_fd fd;
+    EXPECT_TRUE(mOutput.composeSurfaces(Region(), mOutputBuffer, fd));
+}
+
 TEST_F(OutputComposeSurfacesTest, renderDuplicateClientCompositionRequestsWithoutCache) {
     mOutput.cacheClientCompositionRequests(0);
     LayerFE::LayerSettings r1;
@@ -31,6 +31,8 @@
 #include <renderengine/mock/RenderEngine.h>
 #include <ui/GraphicBuffer.h>
 
+#include "RegionMatcher.h"
+
 namespace android::compositionengine {
 namespace {
 
@@ -42,6 +44,8 @@ const std::string DEFAULT_DISPLAY_NAME = "Mock Display";
 using testing::_;
 using testing::ByMove;
 using testing::DoAll;
+using testing::ElementsAre;
+using testing::FieldsAre;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
@@ -197,6 +201,17 @@ TEST_F(RenderSurfaceTest, beginFrameAppliesChange) {
     EXPECT_EQ(NO_ERROR, mSurface.beginFrame(true));
 }
 
+/*
+ * RenderSurface::setFrameDamage()
+ */
+
+TEST_F(RenderSurfaceTest, setFrameDamagePassesDamageToDisplaySurface) {
+    const Region damage(Rect(10, 20, 30, 40));
+    EXPECT_CALL(*mDisplaySurface, setFrameDamage(RegionEq(damage))).Times(1);
+
+    mSurface.setFrameDamage(damage);
+}
+
 /*
  * RenderSurface::prepareFrame()
  */
@@ -352,6 +367,115 @@ TEST_F(RenderSurfaceTest, queueBufferHandlesNativeWindowQueueBufferFailureOnVirt
     EXPECT_EQ(nullptr, mSurface.mutableTextureForTest().get());
 }
 
+/*
+ * RenderSurface::setBufferDamage()
+ * RenderSurface::getBufferRepaintRegion()
+ */
+
+class RenderSurfaceDamageTest : public RenderSurfaceTest {
+public:
+    static constexpr uint32_t kBufferHeight = 100u;
+
+    RenderSurfaceDamageTest() {
+        mState.usesClientComposition = true;
+        EXPECT_CALL(mDisplay, getState()).WillRepeatedly(ReturnRef(mState));
+        EXPECT_CALL(*mNativeWindow, queueBuffer(_, _)).WillRepeatedly(Return(NO_ERROR));
+        EXPECT_CALL(*mDisplaySurface, advanceFrame()).WillRepeatedly(Return(NO_ERROR));
+    }
+
+    void setBuffer() {
+        const auto buffer = sp<GraphicBuffer>::make(100u, kBufferHeight, HAL_PIXEL_FORMAT_RGBA_8888,
+                                                    1u, GRALLOC_USAGE_HW_RENDER, "buffer");
+        mSurface.mutableTextureForTest() =
+                std::make_shared<renderengine::impl::ExternalTexture>(buffer, mRenderEngine, false);
+    }
+
+    void queueBufferWithDamage(const Region& damage) {
+        setBuffer();
+        mSurface.setBufferDamage(damage);
+        mSurface.queueBuffer(base::unique_fd());
+    }
+
+    void expectBufferAge(int age) {
+        EXPECT_CALL(*mNativeWindow, query(NATIVE_WINDOW_BUFFER_AGE, _))
+                .WillRepeatedly(DoAll(SetArgPointee<1>(age), Return(NO_ERROR)));
+    }
+
+    impl::OutputCompositionState mState;
+};
+
+TEST_F(RenderSurfaceDamageTest, queueBufferPassesDamageWithBottomLeftOrigin) {
+    EXPECT_CALL(*mNativeWindow, setSurfaceDamage(ElementsAre(FieldsAre(10, 80, 30, 60))))
+            .WillOnce(Return(NO_ERROR));
+
+    queueBufferWithDamage(Region(Rect(10, 20, 30, 40)));
+}
+
+TEST_F(RenderSurfaceDamageTest, queueBufferDoesNotPassInvalidDamage) {
+    queueBufferWithDamage(Region::INVALID_REGION);
+}
+
+TEST_F(RenderSurfaceDamageTest, repaintRegionAccumulatesDamageSinceBufferContents) {
+    EXPECT_CALL(*mNativeWindow, setSurfaceDamage(_)).WillRepeatedly(Return(NO_ERROR));
+    queueBufferWithDamage(Region(Rect(0, 0, 10, 10)));
+    queueBufferWithDamage(Region(Rect(20, 20, 30, 30)));
+    queueBufferWithDamage(Region(Rect(40, 40, 50, 50)));
+    setBuffer();
+
+    const Region damage(Rect(60, 60, 70, 70));
+
+    expectBufferAge(1);
+    EXPECT_TRUE(damage.subtract(mSurface.getBufferRepaintRegion(damage)).isEmpty());
+    EXPECT_EQ(Rect(60, 60, 70, 70), mSurface.getBufferRepaintRegion(damage).getBounds());
+
+    expectBufferAge(3);
+    EXPECT_EQ(Rect(20, 20, 70, 70), mSurface.getBufferRepaintRegion(damage).getBounds());
+    EXPECT_FALSE(mSurface.getBufferRepaintRegion(damage).contains(5, 5));
+}
+
+TEST_F(RenderSurfaceDamageTest, repaintRegionIsInvalidWithoutEnoughHistory) {
+    EXPECT_CALL(*mNativeWindow, setSurfaceDamage(_)).WillRepeatedly(Return(NO_ERROR));
+    queueBufferWithDamage(Region(Rect(0, 0, 10, 10)));
+    setBuffer();
+
+    const Region damage(Rect(60, 60, 70, 70));
+
+    expectBufferAge(0);
+    EXPECT_EQ(Rect::INVALID_RECT, mSurface.getBufferRepaintRegion(damage).getBounds());
+
+    expectBufferAge(2);
+    EXPECT_EQ(Rect::INVALID_RECT, mSurface.getBufferRepaintRegion(damage).getBounds());
+
+    expectBufferAge(1);
+    EXPECT_EQ(Rect::INVALID_RECT,
+              mSurface.getBufferRepaintRegion(Region::INVALID_REGION).getBounds());
+}
+
+TEST_F(RenderSurfaceDamageTest, repaintRegionIsInvalidAfterBufferQueuedWithoutDamage) {
+    EXPECT_CALL(*mNativeWindow, setSurfaceDamage(_)).WillRepeatedly(Return(NO_ERROR));
+    queueBufferWithDamage(Region(Rect(0, 0, 10, 10)));
+    queueBufferWithDamage(Region::INVALID_REGION);
+    setBuffer();
+
+    expectBufferAge(1);
+    EXPECT_EQ(Rect::INVALID_RECT,
+              mSurface.getBufferRepaintRegion(Region(Rect(60, 60, 70, 70))).getBounds());
+}
+
+TEST_F(RenderSurfaceDamageTest, dequeueBufferResetsDamage) {
+    mSurface.setBufferDamage(Region(Rect(10, 20, 30, 40)));
+
+    sp<GraphicBuffer> buffer = sp<GraphicBuffer>::make();
+    EXPECT_CALL(*mNativeWindow, dequeueBuffer(_, _))
+            .WillOnce(
+                    DoAll(SetArgPointee<0>(buffer.get()), SetArgPointee<1>(-1), Return(NO_ERROR)));
+    base::unique_fd fence;
+    mSurface.dequeueBuffer(&fence);
+
+    // No surface damage is passed to the native window.
+    mSurface.queueBuffer(base::unique_fd());
+}
+
 /*
  * RenderSurface::onPresentDisplayCompleted()
  */
@@ -27,10 +27,14 @@ namespace {
 
 const ui::Size kDisplaySize(1, 1);
 const ui::Size kDisplaySizeTwo(2, 2);
+// The size of a kDisplaySize texture, which is allocated as RGBA_8888.
+constexpr size_t kTextureBytes = 4;
 
 class TestableTexturePool : public TexturePool {
 public:
-    TestableTexturePool(renderengine::RenderEngine& renderEngine) : TexturePool(renderEngine) {}
+    TestableTexturePool(renderengine::RenderEngine& renderEngine,
+                        std::shared_ptr<TextureBudget> budget = nullptr)
+          : TexturePool(renderEngine, std::move(budget)) {}
 
     size_t getMinPoolSize() const { return kMinPoolSize; }
     size_t getMaxPoolSize() const { return kMaxPoolSize; }
@@ -170,5 +174,67 @@ TEST_F(TexturePoolTest, reallocatesWhenReEnabled) {
     EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
 }
 
+TEST_F(TexturePoolTest, tracksTexturesAgainstBudget) {
+    const auto budget = std::make_shared<TextureBudget>(0);
+    TestableTexturePool texturePool(mRenderEngine, budget);
+    texturePool.setEnabled(true);
+    texturePool.setDisplaySize(kDisplaySize);
+    EXPECT_EQ(texturePool.getMinPoolSize() * kTextureBytes, budget->getAllocatedBytes());
+
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < texturePool.getMaxPoolSize() + 1; i++) {
+        textures.emplace_back(texturePool.borrowTexture());
+    }
+    EXPECT_EQ((texturePool.getMaxPoolSize() + 1) * kTextureBytes, budget->getAllocatedBytes());
+
+    // Only the textures retained by the pool remain allocated.
+    textures.clear();
+    EXPECT_EQ(texturePool.getMaxPoolSize() * kTextureBytes, budget->getAllocatedBytes());
+
+    texturePool.setEnabled(false);
+    EXPECT_EQ(0u, budget->getAllocatedBytes());
+}
+
+TEST_F(TexturePoolTest, stopsRetainingTexturesOverBudget) {
+    const auto budget = std::make_shared<TextureBudget>(3 * kTextureBytes);
+    TestableTexturePool texturePool(mRenderEngine, budget);
+    texturePool.setEnabled(true);
+    texturePool.setDisplaySize(kDisplaySize);
+    ASSERT_EQ(3u, texturePool.getPoolSize());
+
+    // Borrowed textures are never evicted, so the budget may be exceeded while they are in use.
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < 4; i++) {
+        textures.emplace_back(texturePool.borrowTexture());
+    }
+    EXPECT_EQ(4 * kTextureBytes, budget->getAllocatedBytes());
+
+    textures.clear();
+    EXPECT_EQ(3u, texturePool.getPoolSize());
+    EXPECT_EQ(3 * kTextureBytes, budget->getAllocatedBytes());
+}
+
+TEST_F(TexturePoolTest, evictsIdleTexturesFromLeastRecentlyUsedPool) {
+    const auto budget = std::make_shared<TextureBudget>(6 * kTextureBytes);
+    TestableTexturePool firstPool(mRenderEngine, budget);
+    firstPool.setEnabled(true);
+    firstPool.setDisplaySize(kDisplaySize);
+    TestableTexturePool secondPool(mRenderEngine, budget);
+    secondPool.setEnabled(true);
+    secondPool.setDisplaySize(kDisplaySize);
+    ASSERT_EQ(6 * kTextureBytes, budget->getAllocatedBytes());
+
+    // Exhaust the second pool, so that its next texture is allocated over budget.
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < secondPool.getMinPoolSize() + 1; i++) {
+        textures.emplace_back(secondPool.borrowTexture());
+    }
+
+    // The idle texture of the other display is evicted to make room.
+    EXPECT_EQ(firstPool.getMinPoolSize() - 1, firstPool.getPoolSize());
+    EXPECT_EQ(1u, budget->getEvictionCount());
+    EXPECT_EQ(6 * kTextureBytes, budget->getAllocatedBytes());
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
@@ -101,6 +101,9 @@ DisplayDevice::DisplayDevice(DisplayDeviceCreationArgs& args)
 
     mCompositionDisplay->setPredictCompositionStrategy(mFlinger->mPredictCompositionStrategy);
     mCompositionDisplay->setTreat170mAsSrgb(mFlinger->mTreat170mAsSrgb);
+    // Virtual display sinks do not track the age of their buffers.
+    mCompositionDisplay->setPartialClientComposition(mFlinger->mPartialClientComposition &&
+                                                     !mCompositionDisplay->isVirtual());
     mCompositionDisplay->createDisplayColorProfile(
             compositionengine::DisplayColorProfileCreationArgsBuilder()
                     .setHasWideColorGamut(args.hasWideColorGamut)
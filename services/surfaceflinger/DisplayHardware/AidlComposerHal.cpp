@@ -22,6 +22,8 @@
 
 #include <SurfaceFlingerProperties.h>
 #include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android/binder_auto_utils.h>
 #include <android/binder_ibinder_platform.h>
 #include <android/binder_manager.h>
 #include <gui/TraceUtils.h>
@@ -55,6 +57,7 @@ using aidl::android::hardware::graphics::composer3::PowerMode;
 using aidl::android::hardware::graphics::composer3::VirtualDisplay;
 
 using aidl::android::hardware::graphics::composer3::CommandResultPayload;
+using aidl::android::hardware::graphics::composer3::DisplayCommand;
 
 using AidlColorMode = aidl::android::hardware::graphics::composer3::ColorMode;
 using AidlContentType = aidl::android::hardware::graphics::composer3::ContentType;
@@ -340,7 +343,45 @@ std::string AidlComposer::dumpDebugInfo() {
 
     t.join();
     close(pipefds[0]);
-    return str;
+    return dumpCommandStats() + str;
+}
+
+void AidlComposer::recordCommandStats(const std::vector<DisplayCommand>& commands) {
+    std::lock_guard lock(mCommandStatsMutex);
+    const bool sampleSize = mCommandStats.batchCount++ % kCommandSizeSamplePeriod == 0;
+    mCommandStats.displayCommandCount += commands.size();
+    for (const auto& command : commands) {
+        mCommandStats.layerCommandCount += command.layers.size();
+    }
+
+    if (sampleSize) {
+        ndk::ScopedAParcel parcel(AParcel_create());
+        for (const auto& command : commands) {
+            if (command.writeToParcel(parcel.get()) != STATUS_OK) {
+                return;
+            }
+        }
+        mCommandStats.sizeSampleCount++;
+        mCommandStats.sampledBytes += static_cast<uint64_t>(AParcel_getDataSize(parcel.get()));
+    }
+}
+
+std::string AidlComposer::dumpCommandStats() {
+    std::lock_guard lock(mCommandStatsMutex);
+    const auto& stats = mCommandStats;
+    if (stats.batchCount == 0) {
+        return {};
+    }
+    const auto perBatch = [&stats](uint64_t total, uint64_t count) {
+        return count == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(count);
+    };
+    return base::StringPrintf("Composer command batches: %" PRIu64
+                              ", per batch: %.1f display commands, %.1f layer commands,"
+                              " %.0f bytes (over %" PRIu64 " samples)\n",
+                              stats.batchCount, perBatch(stats.displayCommandCount, stats.batchCount),
+                              perBatch(stats.layerCommandCount, stats.batchCount),
+                              perBatch(stats.sampledBytes, stats.sizeSampleCount),
+                              stats.sizeSampleCount);
 }
 
 void AidlComposer::registerCallback(HWC2::ComposerCallback& callback) {
@@ -364,6 +405,11 @@ Error AidlComposer::executeCommands(Display display) {
     return error;
 }
 
+bool AidlComposer::takeLayerCommandFailure(Display display) {
+    std::lock_guard lock(mLayerCommandFailuresMutex);
+    return mLayerCommandFailures.erase(display) > 0;
+}
+
 uint32_t AidlComposer::getMaxVirtualDisplayCount() {
     int32_t count = 0;
     const auto status = mAidlComposerClient->getMaxVirtualDisplayCount(&count);
@@ -1099,6 +1145,8 @@ Error AidlComposer::execute(Display display) {
 #endif
     /* QTI_END */
 
+    recordCommandStats(commands);
+
     { // scope for results
         std::vector<CommandResultPayload> results;
         ::ndk::ScopedAStatus status;
@@ -1115,6 +1163,8 @@ Error AidlComposer::execute(Display display) {
         /* QTI_END */
         if (!status.isOk()) {
             ALOGE("executeCommands failed %s", status.getDescription().c_str());
+            std::lock_guard lock(mLayerCommandFailuresMutex);
+            mLayerCommandFailures.insert(display);
             return static_cast<Error>(status.getServiceSpecificError());
         }
 
@@ -1135,6 +1185,8 @@ Error AidlComposer::execute(Display display) {
         } else {
             ALOGW("command '%s' generated error %" PRId32, command.toString().c_str(),
                   cmdErr.errorCode);
+            std::lock_guard lock(mLayerCommandFailuresMutex);
+            mLayerCommandFailures.insert(display);
         }
     }
 
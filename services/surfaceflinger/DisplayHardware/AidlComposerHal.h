@@ -21,8 +21,10 @@
 #include <ftl/small_map.h>
 
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -87,6 +89,7 @@ public:
 
     // Explicitly flush all pending commands in the command buffer.
     Error executeCommands(Display) override;
+    bool takeLayerCommandFailure(Display) override;
 
     uint32_t getMaxVirtualDisplayCount() override;
     Error createVirtualDisplay(uint32_t width, uint32_t height, PixelFormat* format,
@@ -274,6 +277,12 @@ private:
 
     bool hasMultiThreadedPresentSupport(Display);
 
+    // Accounts for a batch of commands about to be sent to the HAL, for dumpsys.
+    void recordCommandStats(
+            const std::vector<aidl::android::hardware::graphics::composer3::DisplayCommand>&)
+            EXCLUDES(mCommandStatsMutex);
+    std::string dumpCommandStats() EXCLUDES(mCommandStatsMutex);
+
     // 64KiB minus a small space for metadata such as read/write pointers
     static constexpr size_t kWriterInitialSize = 64 * 1024 / sizeof(uint32_t) - 16;
     // Max number of buffers that may be cached for a given layer
@@ -307,6 +316,23 @@ private:
     // Buffer slots for layers are cleared by setting the slot buffer to this buffer.
     sp<GraphicBuffer> mClearSlotBuffer;
 
+    struct CommandStats {
+        uint64_t batchCount = 0;
+        uint64_t displayCommandCount = 0;
+        uint64_t layerCommandCount = 0;
+        // Serializing the commands is not free, so their size is only measured for one in every
+        // kCommandSizeSamplePeriod batches.
+        uint64_t sizeSampleCount = 0;
+        uint64_t sampledBytes = 0;
+    };
+    static constexpr uint64_t kCommandSizeSamplePeriod = 64;
+    std::mutex mCommandStatsMutex;
+    CommandStats mCommandStats GUARDED_BY(mCommandStatsMutex);
+
+    // Displays with a failed layer command, until takeLayerCommandFailure is called for them.
+    std::mutex mLayerCommandFailuresMutex;
+    std::unordered_set<Display> mLayerCommandFailures GUARDED_BY(mLayerCommandFailuresMutex);
+
     // Aidl interface
     using AidlIComposer = aidl::android::hardware::graphics::composer3::IComposer;
     using AidlIComposerClient = aidl::android::hardware::graphics::composer3::IComposerClient;
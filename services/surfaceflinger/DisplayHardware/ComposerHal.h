@@ -113,6 +113,10 @@ public:
     // Explicitly flush all pending commands in the command buffer.
     virtual Error executeCommands(Display) = 0;
 
+    // Returns whether a layer command of the display failed since the last call. Layer commands
+    // are executed in batches, which only report the errors of validate and present commands.
+    virtual bool takeLayerCommandFailure(Display) = 0;
+
     virtual uint32_t getMaxVirtualDisplayCount() = 0;
     virtual Error createVirtualDisplay(uint32_t width, uint32_t height, PixelFormat*,
                                        Display* outDisplay) = 0;
@@ -66,6 +66,19 @@ inline bool hasMetadataKey(const std::set<Hwc2::PerFrameMetadataKey>& keys,
     return keys.find(key) != keys.end();
 }
 
+std::vector<Hwc2::IComposerClient::Rect> convertRegionToHwcRects(const Region& region) {
+    size_t rectCount = 0;
+    Rect const* rectArray = region.getArray(&rectCount);
+
+    std::vector<Hwc2::IComposerClient::Rect> hwcRects;
+    hwcRects.reserve(rectCount);
+    for (size_t rect = 0; rect < rectCount; ++rect) {
+        hwcRects.push_back({rectArray[rect].left, rectArray[rect].top, rectArray[rect].right,
+                            rectArray[rect].bottom});
+    }
+    return hwcRects;
+}
+
 } // namespace anonymous
 
 // Display methods
@@ -396,6 +409,7 @@ Error Display::present(sp<Fence>* outPresentFence)
     int32_t presentFenceFd = -1;
     auto intError = mComposer.presentDisplay(mId, &presentFenceFd);
     auto error = static_cast<Error>(intError);
+    invalidateLayerStateOnFailure(error);
     if (error != Error::NONE) {
         return error;
     }
@@ -438,12 +452,16 @@ Error Display::setActiveConfigWithConstraints(hal::HWConfigId configId,
 }
 
 Error Display::setClientTarget(uint32_t slot, const sp<GraphicBuffer>& target,
-        const sp<Fence>& acquireFence, Dataspace dataspace)
+        const sp<Fence>& acquireFence, Dataspace dataspace, const Region& damage)
 {
-    // TODO: Properly encode client target surface damage
+    // We encode default full-screen damage as INVALID_RECT upstream, but as 0
+    // rects for HWC
+    std::vector<Hwc2::IComposerClient::Rect> hwcRects;
+    if (!(damage.isRect() && damage.getBounds() == Rect::INVALID_RECT)) {
+        hwcRects = convertRegionToHwcRects(damage);
+    }
     int32_t fenceFd = acquireFence->dup();
-    auto intError = mComposer.setClientTarget(mId, slot, target,
-            fenceFd, dataspace, std::vector<Hwc2::IComposerClient::Rect>());
+    auto intError = mComposer.setClientTarget(mId, slot, target, fenceFd, dataspace, hwcRects);
     return static_cast<Error>(intError);
 }
 
@@ -515,6 +533,7 @@ Error Display::validate(nsecs_t expectedPresentTime, uint32_t* outNumTypes,
     uint32_t numRequests = 0;
     auto intError = mComposer.validateDisplay(mId, expectedPresentTime, &numTypes, &numRequests);
     auto error = static_cast<Error>(intError);
+    invalidateLayerStateOnFailure(error);
     if (error != Error::NONE && !hasChangesError(error)) {
         return error;
     }
@@ -533,6 +552,7 @@ Error Display::presentOrValidate(nsecs_t expectedPresentTime, uint32_t* outNumTy
     auto intError = mComposer.presentOrValidateDisplay(mId, expectedPresentTime, &numTypes,
                                                        &numRequests, &presentFenceFd, state);
     auto error = static_cast<Error>(intError);
+    invalidateLayerStateOnFailure(error);
     if (error != Error::NONE && !hasChangesError(error)) {
         return error;
     }
@@ -557,6 +577,18 @@ Error Display::presentOrValidate(nsecs_t expectedPresentTime, uint32_t* outNumTy
     return error;
 }
 
+void Display::invalidateLayerStateOnFailure(Error error) {
+    const bool layerCommandFailed = mComposer.takeLayerCommandFailure(mId);
+    if (!layerCommandFailed && (error == Error::NONE || hasChangesError(error))) {
+        return;
+    }
+    for (const auto& [_, weakLayer] : mLayers) {
+        if (auto layer = weakLayer.lock()) {
+            layer->invalidateCachedState();
+        }
+    }
+}
+
 ftl::Future<Error> Display::setDisplayBrightness(
         float brightness, float brightnessNits,
         const Hwc2::Composer::DisplayBrightnessOptions& options) {
@@ -639,21 +671,6 @@ std::shared_ptr<HWC2::Layer> Display::getLayerById(HWLayerId id) const {
 
 // Layer methods
 
-namespace {
-std::vector<Hwc2::IComposerClient::Rect> convertRegionToHwcRects(const Region& region) {
-    size_t rectCount = 0;
-    Rect const* rectArray = region.getArray(&rectCount);
-
-    std::vector<Hwc2::IComposerClient::Rect> hwcRects;
-    hwcRects.reserve(rectCount);
-    for (size_t rect = 0; rect < rectCount; ++rect) {
-        hwcRects.push_back({rectArray[rect].left, rectArray[rect].top, rectArray[rect].right,
-                            rectArray[rect].bottom});
-    }
-    return hwcRects;
-}
-} // namespace
-
 Layer::~Layer() = default;
 
 namespace impl {
@@ -768,8 +785,17 @@ Error Layer::setBlendMode(BlendMode mode)
         return Error::BAD_DISPLAY;
     }
 
+    if (mode == mBlendMode) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBlendMode(mDisplay->getId(), mId, mode);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mBlendMode = mode;
+    } else {
+        mBlendMode.reset();
+    }
+    return error;
 }
 
 Error Layer::setColor(Color color) {
@@ -777,8 +803,17 @@ Error Layer::setColor(Color color) {
         return Error::BAD_DISPLAY;
     }
 
+    if (color == mColor) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerColor(mDisplay->getId(), mId, color);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mColor = color;
+    } else {
+        mColor.reset();
+    }
+    return error;
 }
 
 Error Layer::setCompositionType(Composition type)
@@ -885,10 +920,19 @@ Error Layer::setDisplayFrame(const Rect& frame)
         return Error::BAD_DISPLAY;
     }
 
+    if (frame == mDisplayFrame) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::Rect hwcRect{frame.left, frame.top,
         frame.right, frame.bottom};
     auto intError = mComposer.setLayerDisplayFrame(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mDisplayFrame = frame;
+    } else {
+        mDisplayFrame.reset();
+    }
+    return error;
 }
 
 Error Layer::setPlaneAlpha(float alpha)
@@ -897,8 +941,17 @@ Error Layer::setPlaneAlpha(float alpha)
         return Error::BAD_DISPLAY;
     }
 
+    if (alpha == mPlaneAlpha) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerPlaneAlpha(mDisplay->getId(), mId, alpha);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mPlaneAlpha = alpha;
+    } else {
+        mPlaneAlpha.reset();
+    }
+    return error;
 }
 
 Error Layer::setSidebandStream(const native_handle_t* stream)
@@ -922,10 +975,19 @@ Error Layer::setSourceCrop(const FloatRect& crop)
         return Error::BAD_DISPLAY;
     }
 
+    if (crop == mSourceCrop) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::FRect hwcRect{
         crop.left, crop.top, crop.right, crop.bottom};
     auto intError = mComposer.setLayerSourceCrop(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mSourceCrop = crop;
+    } else {
+        mSourceCrop.reset();
+    }
+    return error;
 }
 
 Error Layer::setTransform(Transform transform)
@@ -934,9 +996,18 @@ Error Layer::setTransform(Transform transform)
         return Error::BAD_DISPLAY;
     }
 
+    if (transform == mTransform) {
+        return Error::NONE;
+    }
     auto intTransform = static_cast<Hwc2::Transform>(transform);
     auto intError = mComposer.setLayerTransform(mDisplay->getId(), mId, intTransform);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mTransform = transform;
+    } else {
+        mTransform.reset();
+    }
+    return error;
 }
 
 Error Layer::setVisibleRegion(const Region& region)
@@ -961,8 +1032,17 @@ Error Layer::setZOrder(uint32_t z)
         return Error::BAD_DISPLAY;
     }
 
+    if (z == mZOrder) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerZOrder(mDisplay->getId(), mId, z);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mZOrder = z;
+    } else {
+        mZOrder.reset();
+    }
+    return error;
 }
 
 // Composer HAL 2.3
@@ -1001,8 +1081,17 @@ Error Layer::setBrightness(float brightness) {
         return Error::BAD_DISPLAY;
     }
 
+    if (brightness == mBrightness) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBrightness(mDisplay->getId(), mId, brightness);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    if (error == Error::NONE) {
+        mBrightness = brightness;
+    } else {
+        mBrightness.reset();
+    }
+    return error;
 }
 
 Error Layer::setBlockingRegion(const Region& region) {
@@ -1020,6 +1109,17 @@ Error Layer::setBlockingRegion(const Region& region) {
     return static_cast<Error>(intError);
 }
 
+void Layer::invalidateCachedState() {
+    mBlendMode.reset();
+    mColor.reset();
+    mDisplayFrame.reset();
+    mPlaneAlpha.reset();
+    mSourceCrop.reset();
+    mTransform.reset();
+    mZOrder.reset();
+    mBrightness.reset();
+}
+
 } // namespace impl
 } // namespace HWC2
 } // namespace android
@@ -37,6 +37,8 @@
 #include <utils/Errors.h>
 #include <utils/Trace.h>
 
+#include <utility>
+
 #include "../Layer.h" // needed only for debugging
 #include "../SurfaceFlingerProperties.h"
 #include "ComposerHal.h"
@@ -383,19 +385,22 @@ void HWComposer::setVsyncEnabled(PhysicalDisplayId displayId, hal::Vsync enabled
 
 status_t HWComposer::setClientTarget(HalDisplayId displayId, uint32_t slot,
                                      const sp<Fence>& acquireFence, const sp<GraphicBuffer>& target,
-                                     ui::Dataspace dataspace) {
+                                     ui::Dataspace dataspace, const Region& damage) {
     RETURN_IF_INVALID_DISPLAY(displayId, BAD_INDEX);
 
     /* QTI_BEGIN */
     auto& displayData = mDisplayData[displayId];
     if (displayData.validateWasSkipped) {
+        displayData.clientTargetSkipped = true;
         return NO_ERROR;
     }
     /* QTI_END */
 
     ALOGV("%s for display %s", __FUNCTION__, to_string(displayId).c_str());
     auto& hwcDisplay = mDisplayData[displayId].hwcDisplay;
-    auto error = hwcDisplay->setClientTarget(slot, target, acquireFence, dataspace);
+    const bool damageIsValid = !std::exchange(displayData.clientTargetSkipped, false);
+    auto error = hwcDisplay->setClientTarget(slot, target, acquireFence, dataspace,
+                                             damageIsValid ? damage : Region::INVALID_REGION);
     RETURN_IF_HWC_ERROR(error, displayId, BAD_VALUE);
     return NO_ERROR;
 }
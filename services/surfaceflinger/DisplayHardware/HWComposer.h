@@ -158,8 +158,11 @@ public:
             std::optional<std::chrono::steady_clock::time_point> earliestPresentTime,
             nsecs_t expectedPresentTime, std::optional<DeviceRequestedChanges>* outChanges) = 0;
 
+    // The damage is the region of the client target that differs from the previous one. An
+    // invalid region means that the entire client target may have changed.
     virtual status_t setClientTarget(HalDisplayId, uint32_t slot, const sp<Fence>& acquireFence,
-                                     const sp<GraphicBuffer>& target, ui::Dataspace) = 0;
+                                     const sp<GraphicBuffer>& target, ui::Dataspace,
+                                     const Region& damage) = 0;
 
     // Present layers to the display and read releaseFences.
     virtual status_t presentAndGetReleaseFences(
@@ -355,7 +358,8 @@ public:
             std::optional<DeviceRequestedChanges>* outChanges) override;
 
     status_t setClientTarget(HalDisplayId, uint32_t slot, const sp<Fence>& acquireFence,
-                             const sp<GraphicBuffer>& target, ui::Dataspace) override;
+                             const sp<GraphicBuffer>& target, ui::Dataspace,
+                             const Region& damage) override;
 
     // Present layers to the display and read releaseFences.
     status_t presentAndGetReleaseFences(
@@ -507,6 +511,10 @@ private:
         bool validateWasSkipped;
         hal::Error presentError;
 
+        // Whether a client target was not passed to the HWC, so the damage of the next one, which
+        // is relative to the skipped one, cannot be trusted.
+        bool clientTargetSkipped = false;
+
         bool vsyncTraceToggle = false;
 
         std::mutex vsyncEnabledLock;
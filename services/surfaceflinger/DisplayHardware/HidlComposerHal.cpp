@@ -374,6 +374,10 @@ Error HidlComposer::executeCommands(Display) {
     return execute();
 }
 
+bool HidlComposer::takeLayerCommandFailure(Display) {
+    return std::exchange(mLayerCommandFailed, false);
+}
+
 uint32_t HidlComposer::getMaxVirtualDisplayCount() {
     auto ret = mClient->getMaxVirtualDisplayCount();
     return unwrapRet(ret, 0);
@@ -1009,6 +1013,7 @@ Error HidlComposer::execute() {
     // abort() in that case
     if (!ret.isOk()) {
         ALOGE("executeCommands failed because of %s", ret.description().c_str());
+        mLayerCommandFailed = true;
     }
 
     if (error == Error::NONE) {
@@ -1024,6 +1029,7 @@ Error HidlComposer::execute() {
                 error = cmdErr.error;
             } else {
                 ALOGW("command 0x%x generated error %d", command, cmdErr.error);
+                mLayerCommandFailed = true;
             }
         }
     }
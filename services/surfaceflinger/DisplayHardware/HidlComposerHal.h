@@ -195,6 +195,7 @@ public:
 
     // Explicitly flush all pending commands in the command buffer.
     Error executeCommands(Display) override;
+    bool takeLayerCommandFailure(Display) override;
 
     uint32_t getMaxVirtualDisplayCount() override;
     Error createVirtualDisplay(uint32_t width, uint32_t height, PixelFormat* format,
@@ -414,6 +415,10 @@ private:
     static const constexpr uint32_t kMaxLayerBufferCount = BufferQueue::NUM_BUFFER_SLOTS + 1;
     CommandWriter mWriter;
     CommandReader mReader;
+
+    // Whether a layer command failed since the last call to takeLayerCommandFailure. The commands
+    // of all displays go through mWriter, so failures are not tracked per display.
+    bool mLayerCommandFailed = false;
 };
 
 } // namespace android::Hwc2
@@ -28,9 +28,11 @@
 #define LOG_TAG "PowerAdvisor"
 
 #include <unistd.h>
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <optional>
+#include <utility>
 
 #include <android-base/properties.h>
 #include <utils/Log.h>
@@ -82,7 +84,10 @@ void traceExpensiveRendering(bool enabled) {
 } // namespace
 
 PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger)
-      : mPowerHal(std::make_unique<power::PowerHalController>()), mFlinger(flinger) {
+      : mPowerHal(std::make_unique<power::PowerHalController>()),
+        mFlinger(flinger),
+        mUsePredictiveHints(
+                base::GetBoolProperty(std::string("debug.sf.adpf_predictive_hints"), false)) {
     if (getUpdateTimeout() > 0ms) {
         mScreenUpdateTimer.emplace("UpdateImminentTimer", getUpdateTimeout(),
                                    /* resetCallback */ /* QTI_BEGIN */
@@ -218,11 +223,10 @@ void PowerAdvisor::updateTargetWorkDuration(Duration targetDuration) {
         if (ensurePowerHintSessionRunning() && (targetDuration != mLastTargetDurationSent)) {
             ALOGV("Sending target time: %" PRId64 "ns", targetDuration.ns());
             mLastTargetDurationSent = targetDuration;
-            std::lock_guard lock(mHintSessionMutex);
-            auto ret = mHintSession->updateTargetWorkDuration(targetDuration.ns());
-            if (!ret.isOk()) {
-                ALOGW("Failed to set power hint target work duration with error: %s",
-                      ret.exceptionMessage().c_str());
+            // The target is sent along with the actual duration at the end of the frame, unless
+            // actual durations are not reported.
+            mHintSessionBuffer.updateTargetWorkDuration(targetDuration.ns());
+            if (!sUseReportActualDuration && mHintSessionBuffer.flush().isFailed()) {
                 mHintSessionRunning = false;
             }
         }
@@ -242,10 +246,7 @@ void PowerAdvisor::reportActualWorkDuration() {
     }
     actualDuration = std::make_optional(*actualDuration + sTargetSafetyMargin);
     mActualDuration = actualDuration;
-    WorkDuration duration;
-    duration.durationNanos = actualDuration->ns();
-    duration.timeStampNanos = TimePoint::now().ns();
-    mHintSessionQueue.push_back(duration);
+    mHintSessionBuffer.addWorkDuration(actualDuration->ns(), TimePoint::now().ns());
 
     if (sTraceHintSessionData) {
         ATRACE_INT64("Measured duration", actualDuration->ns());
@@ -261,17 +262,39 @@ void PowerAdvisor::reportActualWorkDuration() {
           actualDuration->ns(), mLastTargetDurationSent.ns(),
           Duration{*actualDuration - mLastTargetDurationSent}.ns());
 
-    {
-        std::lock_guard lock(mHintSessionMutex);
-        auto ret = mHintSession->reportActualWorkDuration(mHintSessionQueue);
-        if (!ret.isOk()) {
-            ALOGW("Failed to report actual work durations with error: %s",
-                  ret.exceptionMessage().c_str());
-            mHintSessionRunning = false;
-            return;
-        }
+    // Durations that fail to be sent are kept for the next session.
+    if (mHintSessionBuffer.flush().isFailed()) {
+        mHintSessionRunning = false;
+    }
+}
+
+void PowerAdvisor::hintUpcomingFrameWork(size_t pendingTransactionCount) {
+    if (!mBootFinished || !mUsePredictiveHints || !usePowerHintSession()) {
+        return;
+    }
+
+    // The previous frame's composition and duration are the best estimates available for this
+    // one before it is committed.
+    const bool usedClientComposition =
+            std::any_of(mDisplayTimingData.begin(), mDisplayTimingData.end(),
+                        [](const auto& pair) { return pair.second.usedClientComposition; });
+    const bool missedTarget = mActualDuration && *mActualDuration > mTargetDuration;
+    const bool expectsHeavyFrame = usedClientComposition || missedTarget ||
+            pendingTransactionCount >= sPredictiveHintTransactionCount;
+    if (sTraceHintSessionData) ATRACE_INT("Predicted heavy frame", expectsHeavyFrame);
+
+    const bool expectedHeavyFrame = std::exchange(mExpectsHeavyFrame, expectsHeavyFrame);
+    if (!expectsHeavyFrame || expectedHeavyFrame || !ensurePowerHintSessionRunning()) {
+        return;
+    }
+
+    ATRACE_NAME("CPU_LOAD_UP");
+    std::lock_guard lock(mHintSessionMutex);
+    auto ret = mHintSession->sendHint(SessionHint::CPU_LOAD_UP);
+    if (!ret.isOk()) {
+        ALOGW("Failed to send CPU_LOAD_UP hint with error: %s", ret.exceptionMessage().c_str());
+        mHintSessionRunning = false;
     }
-    mHintSessionQueue.clear();
 }
 
 void PowerAdvisor::enablePowerHintSession(bool enabled) {
@@ -302,6 +325,7 @@ bool PowerAdvisor::startPowerHintSession(const std::vector<int32_t>& threadIds)
         if (ret.isOk()) {
             mHintSessionRunning = true;
             mHintSession = ret.value();
+            mHintSessionBuffer.setSession(mHintSession, mTargetDuration.ns());
         }
     }
     return mHintSessionRunning;
@@ -574,6 +598,10 @@ const Duration PowerAdvisor::sTargetSafetyMargin = std::chrono::microseconds(
 const bool PowerAdvisor::sUseReportActualDuration =
         base::GetBoolProperty(std::string("debug.adpf.use_report_actual_duration"), true);
 
+const size_t PowerAdvisor::sPredictiveHintTransactionCount =
+        base::GetUintProperty<size_t>("debug.sf.adpf_predictive_hint_transactions",
+                                      PowerAdvisor::kDefaultPredictiveHintTransactionCount);
+
 power::PowerHalController& PowerAdvisor::getPowerHal() {
     static std::once_flag halFlag;
     std::call_once(halFlag, [this] { mPowerHal->init(); });
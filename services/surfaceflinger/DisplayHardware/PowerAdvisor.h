@@ -33,6 +33,7 @@
 
 #include <android/hardware/power/IPower.h>
 #include <compositionengine/impl/OutputCompositionState.h>
+#include <powermanager/BufferedPowerHintSession.h>
 #include <powermanager/PowerHalController.h>
 #include <scheduler/Time.h>
 #include <ui/DisplayIdentification.h>
@@ -109,6 +110,9 @@ public:
     virtual void setDisplays(std::vector<DisplayId>& displayIds) = 0;
     // Sets the target duration for the entire pipeline including the gpu
     virtual void setTotalFrameTargetWorkDuration(Duration targetDuration) = 0;
+    // Estimates whether the upcoming frame is heavy from its pending transactions and the previous
+    // frame, and if so, sends an early CPU_LOAD_UP hint before its commit starts
+    virtual void hintUpcomingFrameWork(size_t pendingTransactionCount) = 0;
 };
 
 namespace impl {
@@ -148,6 +152,7 @@ public:
     void setCompositeEnd(TimePoint compositeEndTime) override;
     void setDisplays(std::vector<DisplayId>& displayIds) override;
     void setTotalFrameTargetWorkDuration(Duration targetDuration) override;
+    void hintUpcomingFrameWork(size_t pendingTransactionCount) override;
 
 private:
     friend class PowerAdvisorTest;
@@ -270,8 +275,8 @@ private:
     // Initialize to true so we try to call, to check if it's supported
     bool mHasExpensiveRendering = true;
     bool mHasDisplayUpdateImminent = true;
-    // Queue of actual durations saved to report
-    std::vector<hardware::power::WorkDuration> mHintSessionQueue;
+    // Target and actual durations saved to report, sent together once per frame
+    power::BufferedPowerHintSession mHintSessionBuffer;
     // The latest values we have received for target and actual
     Duration mTargetDuration = kDefaultTargetDuration;
     std::optional<Duration> mActualDuration;
@@ -292,6 +297,15 @@ private:
     // Whether we should send reportActualWorkDuration calls
     static const bool sUseReportActualDuration;
 
+    // Whether we should send CPU_LOAD_UP hints ahead of frames predicted to be heavy
+    bool mUsePredictiveHints;
+    // Whether the last frame was predicted to be heavy, so that a sustained heavy load only sends
+    // a hint when it starts
+    bool mExpectsHeavyFrame = false;
+    // The number of pending transactions from which a frame is predicted to be heavy
+    static const size_t sPredictiveHintTransactionCount;
+    static constexpr const size_t kDefaultPredictiveHintTransactionCount = 8;
+
     // How long we expect hwc to run after the present call until it waits for the fence
     static constexpr const Duration kFenceWaitStartDelayValidated{150us};
     static constexpr const Duration kFenceWaitStartDelaySkippedValidate{250us};
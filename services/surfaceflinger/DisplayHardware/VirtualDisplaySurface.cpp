@@ -160,6 +160,14 @@ status_t VirtualDisplaySurface::beginFrame(bool mustRecompose) {
     return refreshOutputBuffer();
 }
 
+void VirtualDisplaySurface::setFrameDamage(const Region& damage) {
+    if (GpuVirtualDisplayId::tryCast(mDisplayId)) {
+        return;
+    }
+
+    mFrameDamage = damage;
+}
+
 status_t VirtualDisplaySurface::prepareFrame(CompositionType compositionType) {
     if (GpuVirtualDisplayId::tryCast(mDisplayId)) {
         return NO_ERROR;
@@ -259,7 +267,7 @@ status_t VirtualDisplaySurface::advanceFrame() {
         }
         // TODO: Correctly propagate the dataspace from GL composition
         result = mHwc.setClientTarget(*halDisplayId, mFbProducerSlot, mFbFence, hwcBuffer,
-                                      ui::Dataspace::UNKNOWN);
+                                      ui::Dataspace::UNKNOWN, Region::INVALID_REGION);
     }
 
     return result;
@@ -291,14 +299,13 @@ void VirtualDisplaySurface::onFrameCommitted() {
         QueueBufferOutput qbo;
         VDS_LOGV("%s: queue sink sslot=%d", __func__, sslot);
         if (/* QTI_BEGIN */ retireFence->isValid() && /* QTI_END */ mMustRecompose) {
-            status_t result = mSource[SOURCE_SINK]->queueBuffer(sslot,
-                    QueueBufferInput(
-                        systemTime(), false /* isAutoTimestamp */,
-                        HAL_DATASPACE_UNKNOWN,
-                        Rect(mSinkBufferWidth, mSinkBufferHeight),
-                        NATIVE_WINDOW_SCALING_MODE_FREEZE, 0 /* transform */,
-                        retireFence),
-                    &qbo);
+            QueueBufferInput input(systemTime(), false /* isAutoTimestamp */,
+                                   HAL_DATASPACE_UNKNOWN, Rect(mSinkBufferWidth, mSinkBufferHeight),
+                                   NATIVE_WINDOW_SCALING_MODE_FREEZE, 0 /* transform */,
+                                   retireFence);
+            // Let the sink, e.g. a video encoder, skip the parts of the buffer that did not change.
+            input.setSurfaceDamage(mFrameDamage);
+            status_t result = mSource[SOURCE_SINK]->queueBuffer(sslot, input, &qbo);
             if (result == NO_ERROR) {
                 updateQueueBufferOutput(std::move(qbo));
             }
@@ -657,6 +664,7 @@ void VirtualDisplaySurface::resetPerFrameState() {
     mOutputFence = Fence::NO_FENCE;
     mOutputProducerSlot = -1;
     mFbProducerSlot = -1;
+    mFrameDamage = Region::INVALID_REGION;
 }
 
 status_t VirtualDisplaySurface::refreshOutputBuffer() {
@@ -100,6 +100,7 @@ public:
     // DisplaySurface interface
     //
     virtual status_t beginFrame(bool mustRecompose);
+    void setFrameDamage(const Region& damage) override;
     virtual status_t prepareFrame(CompositionType);
     virtual status_t advanceFrame();
     virtual void onFrameCommitted();
@@ -288,6 +289,10 @@ private:
 
     bool mMustRecompose = false;
 
+    // The region of the sink buffer that changes this frame, which is queued to the sink as the
+    // surface damage. The entire buffer is damaged unless set otherwise.
+    Region mFrameDamage = Region::INVALID_REGION;
+
     bool mForceHwcCopy;
 
     /* QTI_BEGIN */
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "FramePhaseProfiler.h"
+
+#include <android-base/stringprintf.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace android {
+
+using base::StringAppendF;
+
+namespace {
+
+const char* traceCounterName(FramePhaseProfiler::Phase phase) {
+    static const auto kNames = [] {
+        std::array<std::string, ftl::enum_size_v<FramePhaseProfiler::Phase>> names;
+        for (const auto phase : ftl::enum_range<FramePhaseProfiler::Phase>()) {
+            names[ftl::to_underlying(phase)] = "FramePhase " + ftl::enum_string(phase);
+        }
+        return names;
+    }();
+    return kNames[ftl::to_underlying(phase)].c_str();
+}
+
+} // namespace
+
+void FramePhaseProfiler::record(Phase phase, nsecs_t duration) {
+    {
+        std::scoped_lock lock(mMutex);
+        Ring& ring = mRings[ftl::to_underlying(phase)];
+        ring.durations[ring.next] = duration;
+        ring.next = (ring.next + 1) % kFrameCount;
+        ring.count = std::min(ring.count + 1, kFrameCount);
+    }
+
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT64(traceCounterName(phase), duration);
+    }
+}
+
+FramePhaseProfiler::Percentiles FramePhaseProfiler::getPercentiles(Phase phase) const {
+    std::vector<nsecs_t> durations;
+    {
+        std::scoped_lock lock(mMutex);
+        const Ring& ring = mRings[ftl::to_underlying(phase)];
+        durations.assign(ring.durations.begin(), ring.durations.begin() + ring.count);
+    }
+    if (durations.empty()) {
+        return {};
+    }
+
+    std::sort(durations.begin(), durations.end());
+    const auto percentile = [&durations](size_t percent) {
+        return durations[(durations.size() - 1) * percent / 100];
+    };
+    return {.count = durations.size(),
+            .p50 = percentile(50),
+            .p90 = percentile(90),
+            .p99 = percentile(99),
+            .max = durations.back()};
+}
+
+void FramePhaseProfiler::dump(std::string& result) const {
+    StringAppendF(&result, "Frame phases over the last %zu frames (us):\n", kFrameCount);
+    StringAppendF(&result, "  %-18s %6s %8s %8s %8s %8s\n", "phase", "frames", "p50", "p90", "p99",
+                  "max");
+    for (const auto phase : ftl::enum_range<Phase>()) {
+        const Percentiles percentiles = getPercentiles(phase);
+        StringAppendF(&result, "  %-18s %6zu %8.1f %8.1f %8.1f %8.1f\n",
+                      ftl::enum_string(phase).c_str(), percentiles.count, percentiles.p50 / 1e3,
+                      percentiles.p90 / 1e3, percentiles.p99 / 1e3, percentiles.max / 1e3);
+    }
+}
+
+void FramePhaseProfiler::clear() {
+    std::scoped_lock lock(mMutex);
+    for (Ring& ring : mRings) {
+        ring.next = 0;
+        ring.count = 0;
+    }
+}
+
+} // namespace android
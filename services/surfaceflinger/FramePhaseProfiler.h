@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <ftl/enum.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace android {
+
+// FramePhaseProfiler keeps the durations of the phases of the most recent frames in a ring, and
+// reports their percentiles. Durations are recorded on the main thread, and may be dumped from
+// any thread.
+class FramePhaseProfiler {
+public:
+    enum class Phase {
+        TransactionFlush,
+        SnapshotUpdate,
+        InputUpdate,
+        Composition,
+        PostComposition,
+        ftl_last = PostComposition
+    };
+
+    // The number of frames kept for each phase.
+    static constexpr size_t kFrameCount = 512;
+
+    struct Percentiles {
+        size_t count = 0;
+        nsecs_t p50 = 0;
+        nsecs_t p90 = 0;
+        nsecs_t p99 = 0;
+        nsecs_t max = 0;
+    };
+
+    // Records the duration of a phase. If tracing is enabled, the duration is also traced as a
+    // counter so that it shows up in Perfetto next to the FrameTimeline tracks.
+    void record(Phase, nsecs_t duration);
+
+    // Records the duration of a phase from construction until destruction.
+    class ScopedPhase {
+    public:
+        ScopedPhase(FramePhaseProfiler& profiler, Phase phase)
+              : mProfiler(profiler), mPhase(phase), mStartTime(systemTime()) {}
+        ~ScopedPhase() { mProfiler.record(mPhase, systemTime() - mStartTime); }
+
+    private:
+        FramePhaseProfiler& mProfiler;
+        const Phase mPhase;
+        const nsecs_t mStartTime;
+    };
+
+    Percentiles getPercentiles(Phase) const;
+
+    void dump(std::string& result) const;
+    void clear();
+
+private:
+    static constexpr size_t kPhaseCount = ftl::enum_size_v<Phase>;
+
+    struct Ring {
+        std::array<nsecs_t, kFrameCount> durations;
+        size_t next = 0;
+        size_t count = 0;
+    };
+
+    mutable std::mutex mMutex;
+    std::array<Ring, kPhaseCount> mRings GUARDED_BY(mMutex);
+};
+
+} // namespace android
@@ -24,10 +24,12 @@
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cinttypes>
 #include <numeric>
 #include <unordered_set>
+#include <vector>
 
 namespace android::frametimeline {
 
@@ -760,9 +762,97 @@ std::optional<TimelineItem> TokenManager::getPredictionsForToken(int64_t token)
     return {};
 }
 
+// Keeps the blocks that allocate_shared() makes for a SurfaceFrame and its control block once the
+// frame is destroyed, and hands them out to the next ones, so that creating a SurfaceFrame for
+// every layer on every frame doesn't go through the heap. SurfaceFrames are destroyed wherever the
+// last reference to them is dropped, hence the lock.
+class FrameTimeline::SurfaceFramePool {
+public:
+    explicit SurfaceFramePool(size_t maxBlocks) : mMaxBlocks(maxBlocks) {}
+
+    ~SurfaceFramePool() {
+        for (void* block : mFreeBlocks) {
+            ::operator delete(block);
+        }
+    }
+
+    void* allocate(size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (size == mBlockSize && !mFreeBlocks.empty()) {
+                void* block = mFreeBlocks.back();
+                mFreeBlocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (mBlockSize == 0) {
+                mBlockSize = size;
+            }
+            if (size == mBlockSize && mFreeBlocks.size() < mMaxBlocks) {
+                mFreeBlocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    void setMaxBlocks(size_t maxBlocks) {
+        std::scoped_lock lock(mMutex);
+        mMaxBlocks = maxBlocks;
+        while (mFreeBlocks.size() > mMaxBlocks) {
+            ::operator delete(mFreeBlocks.back());
+            mFreeBlocks.pop_back();
+        }
+    }
+
+private:
+    std::mutex mMutex;
+    // allocate_shared() always asks for the same size, which is only known once it does.
+    size_t mBlockSize GUARDED_BY(mMutex) = 0;
+    size_t mMaxBlocks GUARDED_BY(mMutex);
+    std::vector<void*> mFreeBlocks GUARDED_BY(mMutex);
+};
+
+template <typename T>
+class FrameTimeline::SurfaceFrameAllocator {
+public:
+    using value_type = T;
+
+    explicit SurfaceFrameAllocator(std::shared_ptr<SurfaceFramePool> pool)
+          : mPool(std::move(pool)) {}
+    template <typename U>
+    SurfaceFrameAllocator(const SurfaceFrameAllocator<U>& other) : mPool(other.mPool) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(mPool->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { mPool->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SurfaceFrameAllocator<U>& other) const {
+        return mPool == other.mPool;
+    }
+    template <typename U>
+    bool operator!=(const SurfaceFrameAllocator<U>& other) const {
+        return mPool != other.mPool;
+    }
+
+private:
+    template <typename U>
+    friend class SurfaceFrameAllocator;
+
+    std::shared_ptr<SurfaceFramePool> mPool;
+};
+
 FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
                              JankClassificationThresholds thresholds, bool useBootTimeClock)
-      : mUseBootTimeClock(useBootTimeClock),
+      : mSurfaceFramePool(std::make_shared<SurfaceFramePool>(kDefaultMaxDisplayFrames *
+                                                             kNumSurfaceFramesInitial)),
+        mUseBootTimeClock(useBootTimeClock),
         mMaxDisplayFrames(kDefaultMaxDisplayFrames),
         mTimeStats(std::move(timeStats)),
         mSurfaceFlingerPid(surfaceFlingerPid),
@@ -788,27 +878,30 @@ std::shared_ptr<SurfaceFrame> FrameTimeline::createSurfaceFrameForToken(
         const FrameTimelineInfo& frameTimelineInfo, pid_t ownerPid, uid_t ownerUid, int32_t layerId,
         std::string layerName, std::string debugName, bool isBuffer, GameMode gameMode) {
     ATRACE_CALL();
+    const SurfaceFrameAllocator<SurfaceFrame> allocator(mSurfaceFramePool);
     if (frameTimelineInfo.vsyncId == FrameTimelineInfo::INVALID_VSYNC_ID) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::None, TimelineItem(), mTimeStats,
-                                              mJankClassificationThresholds, &mTraceCookieCounter,
-                                              isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::None,
+                                                  TimelineItem(), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
     }
     std::optional<TimelineItem> predictions =
             mTokenManager.getPredictionsForToken(frameTimelineInfo.vsyncId);
     if (predictions) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::Valid, std::move(*predictions),
-                                              mTimeStats, mJankClassificationThresholds,
-                                              &mTraceCookieCounter, isBuffer, gameMode);
-    }
-    return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                          std::move(layerName), std::move(debugName),
-                                          PredictionState::Expired, TimelineItem(), mTimeStats,
-                                          mJankClassificationThresholds, &mTraceCookieCounter,
-                                          isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::Valid,
+                                                  std::move(*predictions), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
+    }
+    return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                              layerId, std::move(layerName), std::move(debugName),
+                                              PredictionState::Expired, TimelineItem(), mTimeStats,
+                                              mJankClassificationThresholds, &mTraceCookieCounter,
+                                              isBuffer, gameMode);
 }
 
 FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
@@ -842,6 +935,7 @@ void FrameTimeline::setSfPresent(nsecs_t sfPresentTime,
     std::scoped_lock lock(mMutex);
     mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
     mCurrentDisplayFrame->setGpuFence(gpuFence);
+    mCurrentDisplayFrame->setSequence(mNextDisplayFrameSequence++);
     mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
     flushPendingPresentFences();
     finalizeCurrentDisplayFrame();
@@ -851,6 +945,20 @@ void FrameTimeline::DisplayFrame::addSurfaceFrame(std::shared_ptr<SurfaceFrame>
     mSurfaceFrames.push_back(surfaceFrame);
 }
 
+void FrameTimeline::DisplayFrame::reset() {
+    mToken = FrameTimelineInfo::INVALID_VSYNC_ID;
+    mSurfaceFlingerPredictions = TimelineItem();
+    mSurfaceFlingerActuals = TimelineItem();
+    mSurfaceFrames.clear();
+    mPredictionState = PredictionState::None;
+    mJankType = JankType::None;
+    mGpuFence = FenceTime::NO_FENCE;
+    mFramePresentMetadata = FramePresentMetadata::UnknownPresent;
+    mFrameReadyMetadata = FrameReadyMetadata::UnknownFinish;
+    mFrameStartMetadata = FrameStartMetadata::UnknownStart;
+    mRefreshRate = Fps();
+}
+
 void FrameTimeline::DisplayFrame::onSfWakeUp(int64_t token, Fps refreshRate,
                                              std::optional<TimelineItem> predictions,
                                              nsecs_t wakeUpTime) {
@@ -1126,46 +1234,63 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
         return 0.0f;
     }
 
-    std::vector<nsecs_t> presentTimes;
+    std::vector<int32_t> sortedLayerIds(layerIds.begin(), layerIds.end());
+    std::sort(sortedLayerIds.begin(), sortedLayerIds.end());
+
+    size_t presentCount;
+    nsecs_t totalPresentToPresentWalls;
     {
         std::scoped_lock lock(mMutex);
-        presentTimes.reserve(mDisplayFrames.size());
-        for (size_t i = 0; i < mDisplayFrames.size(); i++) {
-            const auto& displayFrame = mDisplayFrames[i];
-            if (displayFrame->getActuals().presentTime <= 0) {
-                continue;
+        const nsecs_t now = systemTime();
+        for (auto it = mFpsTrackers.begin(); it != mFpsTrackers.end();) {
+            if (now - it->second.lastQueryTime > kFpsTrackerIdleTimeout) {
+                it = mFpsTrackers.erase(it);
+            } else {
+                ++it;
             }
-            for (const auto& surfaceFrame : displayFrame->getSurfaceFrames()) {
-                if (surfaceFrame->getPresentState() == SurfaceFrame::PresentState::Presented &&
-                    layerIds.count(surfaceFrame->getLayerId()) > 0) {
-                    // We're looking for DisplayFrames that presents at least one layer from
-                    // layerIds, so push the present time and skip looking through the rest of the
-                    // SurfaceFrames.
-                    presentTimes.push_back(displayFrame->getActuals().presentTime);
-                    break;
+        }
+
+        auto [it, inserted] = mFpsTrackers.try_emplace(std::move(sortedLayerIds));
+        const auto& trackedLayerIds = it->first;
+        auto& tracker = it->second;
+        tracker.lastQueryTime = now;
+
+        if (inserted) {
+            // Seed the tracker with the DisplayFrames that were presented before it was created.
+            for (const auto& displayFrame : mDisplayFrames) {
+                const nsecs_t presentTime = displayFrame->getActuals().presentTime;
+                if (presentTime <= 0) {
+                    continue;
+                }
+                for (const auto& surfaceFrame : displayFrame->getSurfaceFrames()) {
+                    if (surfaceFrame->getPresentState() == SurfaceFrame::PresentState::Presented &&
+                        std::binary_search(trackedLayerIds.begin(), trackedLayerIds.end(),
+                                           surfaceFrame->getLayerId())) {
+                        tracker.presentTimes.emplace_back(displayFrame->getSequence(),
+                                                          presentTime);
+                        break;
+                    }
                 }
             }
+        } else {
+            const uint64_t firstSequence = mNextDisplayFrameSequence - mDisplayFrames.size();
+            while (!tracker.presentTimes.empty() &&
+                   tracker.presentTimes.front().first < firstSequence) {
+                tracker.presentTimes.pop_front();
+            }
         }
+
+        presentCount = tracker.presentTimes.size();
+        totalPresentToPresentWalls = presentCount > 1
+                ? tracker.presentTimes.back().second - tracker.presentTimes.front().second
+                : 0;
     }
 
     // FPS can't be computed when there's fewer than 2 presented frames.
-    if (presentTimes.size() <= 1) {
+    if (presentCount <= 1) {
         return 0.0f;
     }
 
-    nsecs_t priorPresentTime = -1;
-    nsecs_t totalPresentToPresentWalls = 0;
-
-    for (const nsecs_t presentTime : presentTimes) {
-        if (priorPresentTime == -1) {
-            priorPresentTime = presentTime;
-            continue;
-        }
-
-        totalPresentToPresentWalls += (presentTime - priorPresentTime);
-        priorPresentTime = presentTime;
-    }
-
     if (CC_UNLIKELY(totalPresentToPresentWalls <= 0)) {
         ALOGW("Invalid total present-to-present duration when computing fps: %" PRId64,
               totalPresentToPresentWalls);
@@ -1176,10 +1301,40 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
             std::chrono::duration_cast<std::chrono::nanoseconds>(1s).count();
     // (10^9 nanoseconds / second) * (N present deltas) / (total nanoseconds in N present deltas) =
     // M frames / second
-    return kOneSecond * static_cast<nsecs_t>((presentTimes.size() - 1)) /
+    return kOneSecond * static_cast<nsecs_t>((presentCount - 1)) /
             static_cast<float>(totalPresentToPresentWalls);
 }
 
+void FrameTimeline::updateFpsTrackers(const DisplayFrame& displayFrame) {
+    const nsecs_t presentTime = displayFrame.getActuals().presentTime;
+    if (mFpsTrackers.empty() || presentTime <= 0) {
+        return;
+    }
+
+    // The DisplayFrame may be presented before it is added to the sliding window, so the window
+    // is measured from the next sequence.
+    const uint64_t firstSequence = mNextDisplayFrameSequence > mMaxDisplayFrames
+            ? mNextDisplayFrameSequence - mMaxDisplayFrames
+            : 0;
+    for (auto& [trackedLayerIds, tracker] : mFpsTrackers) {
+        while (!tracker.presentTimes.empty() &&
+               tracker.presentTimes.front().first < firstSequence) {
+            tracker.presentTimes.pop_front();
+        }
+        if (displayFrame.getSequence() < firstSequence) {
+            continue;
+        }
+        for (const auto& surfaceFrame : displayFrame.getSurfaceFrames()) {
+            if (surfaceFrame->getPresentState() == SurfaceFrame::PresentState::Presented &&
+                std::binary_search(trackedLayerIds.begin(), trackedLayerIds.end(),
+                                   surfaceFrame->getLayerId())) {
+                tracker.presentTimes.emplace_back(displayFrame.getSequence(), presentTime);
+                break;
+            }
+        }
+    }
+}
+
 std::optional<size_t> FrameTimeline::getFirstSignalFenceIndex() const {
     for (size_t i = 0; i < mPendingPresentFences.size(); i++) {
         const auto& [fence, _] = mPendingPresentFences[i];
@@ -1227,6 +1382,7 @@ void FrameTimeline::flushPendingPresentFences() {
         auto& displayFrame = pendingPresentFence.second;
         displayFrame->onPresent(signalTime, mPreviousPresentTime);
         displayFrame->trace(mSurfaceFlingerPid, monoBootOffset);
+        updateFpsTrackers(*displayFrame);
         mPreviousPresentTime = signalTime;
 
         mPendingPresentFences.erase(mPendingPresentFences.begin() + static_cast<int>(i));
@@ -1235,14 +1391,25 @@ void FrameTimeline::flushPendingPresentFences() {
 }
 
 void FrameTimeline::finalizeCurrentDisplayFrame() {
+    std::shared_ptr<DisplayFrame> recycledDisplayFrame;
     while (mDisplayFrames.size() >= mMaxDisplayFrames) {
-        // We maintain only a fixed number of frames' data. Pop older frames
+        // We maintain only a fixed number of frames' data. Pop older frames, and reuse one of them
+        // for the next frame unless it is still waiting for its present fence.
+        if (mDisplayFrames.front().use_count() == 1) {
+            recycledDisplayFrame = std::move(mDisplayFrames.front());
+        }
         mDisplayFrames.pop_front();
     }
     mDisplayFrames.push_back(mCurrentDisplayFrame);
     mCurrentDisplayFrame.reset();
-    mCurrentDisplayFrame = std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
-                                                          &mTraceCookieCounter);
+    if (recycledDisplayFrame) {
+        recycledDisplayFrame->reset();
+        mCurrentDisplayFrame = std::move(recycledDisplayFrame);
+    } else {
+        mCurrentDisplayFrame =
+                std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
+                                               &mTraceCookieCounter);
+    }
 }
 
 nsecs_t FrameTimeline::DisplayFrame::getBaseTime() const {
@@ -1350,7 +1517,9 @@ void FrameTimeline::setMaxDisplayFrames(uint32_t size) {
     // The size can either increase or decrease, clear everything, to be consistent
     mDisplayFrames.clear();
     mPendingPresentFences.clear();
+    mFpsTrackers.clear();
     mMaxDisplayFrames = size;
+    mSurfaceFramePool->setMaxBlocks(size * kNumSurfaceFramesInitial);
 }
 
 void FrameTimeline::reset() {
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <chrono>
 #include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -380,11 +381,18 @@ public:
         void onPresent(nsecs_t signalTime, nsecs_t previousPresentTime);
         // Adds the provided SurfaceFrame to the current display frame.
         void addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame);
+        // Clears all the data of a DisplayFrame that dropped out of the sliding window, so that it
+        // can be reused for the next frame. Keeps the capacity of mSurfaceFrames.
+        void reset();
 
         void setPredictions(PredictionState predictionState, TimelineItem predictions);
         void setActualStartTime(nsecs_t actualStartTime);
         void setActualEndTime(nsecs_t actualEndTime);
         void setGpuFence(const std::shared_ptr<FenceTime>& gpuFence);
+        // Sets the position of the DisplayFrame in the sequence of all DisplayFrames, which
+        // tells whether it is still within the sliding window.
+        void setSequence(uint64_t sequence) { mSequence = sequence; }
+        uint64_t getSequence() const { return mSequence; }
 
         // BaseTime is the smallest timestamp in a DisplayFrame.
         // Used for dumping all timestamps relative to the oldest, making it easy to read.
@@ -409,6 +417,7 @@ public:
                           nsecs_t previousPresentTime);
 
         int64_t mToken = FrameTimelineInfo::INVALID_VSYNC_ID;
+        uint64_t mSequence = 0;
 
         /* Usage of TimelineItem w.r.t SurfaceFlinger
          * startTime    Time when SurfaceFlinger wakes up to handle transactions and buffer updates
@@ -476,14 +485,23 @@ private:
     void flushPendingPresentFences() REQUIRES(mMutex);
     std::optional<size_t> getFirstSignalFenceIndex() const REQUIRES(mMutex);
     void finalizeCurrentDisplayFrame() REQUIRES(mMutex);
+    // Records the present time of a DisplayFrame in the FpsTrackers of the layers it presented.
+    void updateFpsTrackers(const DisplayFrame&) REQUIRES(mMutex);
     void dumpAll(std::string& result);
     void dumpJank(std::string& result);
 
+    // Recycles the memory of SurfaceFrames, see FrameTimeline.cpp.
+    class SurfaceFramePool;
+    template <typename T>
+    class SurfaceFrameAllocator;
+
     // Sliding window of display frames. TODO(b/168072834): compare perf with fixed size array
     std::deque<std::shared_ptr<DisplayFrame>> mDisplayFrames GUARDED_BY(mMutex);
     std::vector<std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>>
             mPendingPresentFences GUARDED_BY(mMutex);
     std::shared_ptr<DisplayFrame> mCurrentDisplayFrame GUARDED_BY(mMutex);
+    // Shared with the allocator of every SurfaceFrame, which can outlive FrameTimeline.
+    const std::shared_ptr<SurfaceFramePool> mSurfaceFramePool;
     TokenManager mTokenManager;
     TraceCookieCounter mTraceCookieCounter;
     mutable std::mutex mMutex;
@@ -492,6 +510,19 @@ private:
     std::shared_ptr<TimeStats> mTimeStats;
     const pid_t mSurfaceFlingerPid;
     nsecs_t mPreviousPresentTime = 0;
+    uint64_t mNextDisplayFrameSequence GUARDED_BY(mMutex) = 0;
+
+    // The present times of the DisplayFrames in the sliding window that presented at least one of
+    // a set of layers, kept up to date as DisplayFrames are presented so that computeFps does not
+    // have to scan the window. Trackers are created by computeFps, keyed by the sorted layer ids,
+    // and dropped once they have not been queried for kFpsTrackerIdleTimeout.
+    struct FpsTracker {
+        std::deque<std::pair<uint64_t /* sequence */, nsecs_t /* presentTime */>> presentTimes;
+        nsecs_t lastQueryTime = 0;
+    };
+    std::map<std::vector<int32_t>, FpsTracker> mFpsTrackers GUARDED_BY(mMutex);
+    static constexpr nsecs_t kFpsTrackerIdleTimeout = s2ns(5);
+
     const JankClassificationThresholds mJankClassificationThresholds;
     static constexpr uint32_t kDefaultMaxDisplayFrames = 64;
     // The initial container size for the vector<SurfaceFrames> inside display frame. Although
@@ -174,10 +174,9 @@ bool LayerHierarchy::hasRelZLoop(uint32_t& outInvalidRelativeRoot) const {
 LayerHierarchyBuilder::LayerHierarchyBuilder(
         const std::vector<std::unique_ptr<RequestedLayerState>>& layers) {
     mHierarchies.reserve(layers.size());
-    mLayerIdToHierarchy.reserve(layers.size());
     for (auto& layer : layers) {
         mHierarchies.emplace_back(std::make_unique<LayerHierarchy>(layer.get()));
-        mLayerIdToHierarchy[layer->id] = mHierarchies.back().get();
+        mLayerIdToHierarchy.emplace_or_replace(layer->id, mHierarchies.back().get());
     }
     for (const auto& layer : layers) {
         onLayerAdded(layer.get());
@@ -320,7 +319,7 @@ void LayerHierarchyBuilder::update(
     for (auto& layer : layers) {
         if (layer->changes.test(RequestedLayerState::Changes::Created)) {
             mHierarchies.emplace_back(std::make_unique<LayerHierarchy>(layer.get()));
-            mLayerIdToHierarchy[layer->id] = mHierarchies.back().get();
+            mLayerIdToHierarchy.emplace_or_replace(layer->id, mHierarchies.back().get());
         }
     }
 
@@ -373,10 +372,10 @@ const LayerHierarchy& LayerHierarchyBuilder::getOffscreenHierarchy() const {
 std::string LayerHierarchyBuilder::getDebugString(uint32_t layerId, uint32_t depth) const {
     if (depth > 10) return "too deep, loop?";
     if (layerId == UNASSIGNED_LAYER_ID) return "";
-    auto it = mLayerIdToHierarchy.find(layerId);
-    if (it == mLayerIdToHierarchy.end()) return "not found";
+    LayerHierarchy* const* hierarchyPtr = mLayerIdToHierarchy.get(layerId);
+    if (!hierarchyPtr) return "not found";
 
-    LayerHierarchy* hierarchy = it->second;
+    LayerHierarchy* hierarchy = *hierarchyPtr;
     if (!hierarchy->mLayer) return "none";
 
     std::string debug =
@@ -392,23 +391,23 @@ std::string LayerHierarchyBuilder::getDebugString(uint32_t layerId, uint32_t dep
 
 LayerHierarchy LayerHierarchyBuilder::getPartialHierarchy(uint32_t layerId,
                                                           bool childrenOnly) const {
-    auto it = mLayerIdToHierarchy.find(layerId);
-    if (it == mLayerIdToHierarchy.end()) return {nullptr};
+    LayerHierarchy* const* hierarchyPtr = mLayerIdToHierarchy.get(layerId);
+    if (!hierarchyPtr) return {nullptr};
 
-    LayerHierarchy hierarchy(*it->second, childrenOnly);
+    LayerHierarchy hierarchy(**hierarchyPtr, childrenOnly);
     return hierarchy;
 }
 
 LayerHierarchy* LayerHierarchyBuilder::getHierarchyFromId(uint32_t layerId, bool crashOnFailure) {
-    auto it = mLayerIdToHierarchy.find(layerId);
-    if (it == mLayerIdToHierarchy.end()) {
+    LayerHierarchy** hierarchyPtr = mLayerIdToHierarchy.get(layerId);
+    if (!hierarchyPtr) {
         if (crashOnFailure) {
             LOG_ALWAYS_FATAL("Could not find hierarchy for layer id %d", layerId);
         }
         return nullptr;
     };
 
-    return it->second;
+    return *hierarchyPtr;
 }
 
 const LayerHierarchy::TraversalPath LayerHierarchy::TraversalPath::ROOT =
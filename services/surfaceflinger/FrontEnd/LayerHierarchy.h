@@ -17,6 +17,7 @@
 #pragma once
 
 #include "FrontEnd/LayerCreationArgs.h"
+#include "FrontEnd/LayerIdTable.h"
 #include "RequestedLayerState.h"
 #include "ftl/small_vector.h"
 
@@ -203,7 +204,7 @@ private:
     void onLayerDestroyed(RequestedLayerState* layer);
     void updateMirrorLayer(RequestedLayerState* layer);
     LayerHierarchy* getHierarchyFromId(uint32_t layerId, bool crashOnFailure = true);
-    std::unordered_map<uint32_t, LayerHierarchy*> mLayerIdToHierarchy;
+    LayerIdTable<LayerHierarchy*> mLayerIdToHierarchy;
     std::vector<std::unique_ptr<LayerHierarchy>> mHierarchies;
     LayerHierarchy mRoot{nullptr};
     LayerHierarchy mOffscreenRoot{nullptr};
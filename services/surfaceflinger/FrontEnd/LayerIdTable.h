@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "LayerCreationArgs.h"
+
+namespace android::surfaceflinger::frontend {
+
+// Map from layer id to T, indexed directly by id instead of hashing it. Layer ids are allocated
+// sequentially, separately for client and internal layers, so each kind gets a table of pages that
+// are allocated when the first id in their range is added and freed when the last one is erased.
+// The memory of short-lived layers is reclaimed, but a single long-lived layer keeps its whole page
+// alive, and the table of pages keeps a pointer for every page below the highest live id. Memory
+// is therefore bounded by the pages that hold a live layer, plus a pointer per kPageSize ids up to
+// the highest live id, rather than by the number of live layers.
+template <typename T>
+class LayerIdTable {
+public:
+    static constexpr size_t kPageSize = 256;
+
+    T* get(uint32_t id) {
+        if (id == UNASSIGNED_LAYER_ID) return nullptr;
+
+        const auto& pages = pagesFor(id);
+        const auto [pageIndex, slotIndex] = indicesFor(id);
+        if (pageIndex >= pages.size() || !pages[pageIndex]) return nullptr;
+
+        auto& slot = pages[pageIndex]->slots[slotIndex];
+        return slot ? &*slot : nullptr;
+    }
+
+    const T* get(uint32_t id) const { return const_cast<LayerIdTable*>(this)->get(id); }
+
+    // Inserts a value unless one exists for the id. Returns a pointer to the inserted or existing
+    // value, and whether the value was inserted.
+    template <typename... Args>
+    std::pair<T*, bool> try_emplace(uint32_t id, Args&&... args) {
+        auto [page, slot] = pageAndSlotFor(id);
+        if (slot) return {&*slot, false};
+
+        slot.emplace(std::forward<Args>(args)...);
+        page.count++;
+        return {&*slot, true};
+    }
+
+    // Inserts a value, or replaces the existing one for the id. Returns whether it was inserted.
+    template <typename... Args>
+    bool emplace_or_replace(uint32_t id, Args&&... args) {
+        auto [page, slot] = pageAndSlotFor(id);
+        const bool inserted = !slot;
+
+        slot.emplace(std::forward<Args>(args)...);
+        if (inserted) page.count++;
+        return inserted;
+    }
+
+    // Removes the value for the id if it exists, and returns whether it did.
+    bool erase(uint32_t id) {
+        if (id == UNASSIGNED_LAYER_ID) return false;
+
+        auto& pages = pagesFor(id);
+        const auto [pageIndex, slotIndex] = indicesFor(id);
+        if (pageIndex >= pages.size() || !pages[pageIndex]) return false;
+
+        auto& page = pages[pageIndex];
+        auto& slot = page->slots[slotIndex];
+        if (!slot) return false;
+
+        slot.reset();
+        if (--page->count == 0) {
+            page.reset();
+            while (!pages.empty() && !pages.back()) {
+                pages.pop_back();
+            }
+        }
+        return true;
+    }
+
+    // Returns the number of pages currently allocated.
+    size_t pageCount() const {
+        size_t count = 0;
+        for (const Pages* pages : {&mClientPages, &mInternalPages}) {
+            for (const auto& page : *pages) {
+                if (page) count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Page {
+        std::array<std::optional<T>, kPageSize> slots;
+        size_t count = 0;
+    };
+
+    using Pages = std::vector<std::unique_ptr<Page>>;
+
+    Pages& pagesFor(uint32_t id) {
+        return (id & INTERNAL_LAYER_PREFIX) ? mInternalPages : mClientPages;
+    }
+
+    // Returns the page and slot for the id, allocating the page if needed.
+    std::pair<Page&, std::optional<T>&> pageAndSlotFor(uint32_t id) {
+        auto& pages = pagesFor(id);
+        const auto [pageIndex, slotIndex] = indicesFor(id);
+        if (pageIndex >= pages.size()) {
+            pages.resize(pageIndex + 1);
+        }
+
+        auto& page = pages[pageIndex];
+        if (!page) {
+            page = std::make_unique<Page>();
+        }
+        return {*page, page->slots[slotIndex]};
+    }
+
+    static std::pair<size_t, size_t> indicesFor(uint32_t id) {
+        const uint32_t index = id & ~INTERNAL_LAYER_PREFIX;
+        return {index / kPageSize, index % kPageSize};
+    }
+
+    Pages mClientPages;
+    Pages mInternalPages;
+};
+
+} // namespace android::surfaceflinger::frontend
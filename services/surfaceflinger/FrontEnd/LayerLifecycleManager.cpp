@@ -36,11 +36,11 @@ void LayerLifecycleManager::addLayers(std::vector<std::unique_ptr<RequestedLayer
     mGlobalChanges |= RequestedLayerState::Changes::Hierarchy;
     for (auto& newLayer : newLayers) {
         RequestedLayerState& layer = *newLayer.get();
-        auto [it, inserted] = mIdToLayer.try_emplace(layer.id, References{.owner = layer});
+        auto [references, inserted] = mIdToLayer.try_emplace(layer.id, References{.owner = layer});
         if (!inserted) {
             LOG_ALWAYS_FATAL("Duplicate layer id found. New layer: %s Existing layer: %s",
                              layer.getDebugString().c_str(),
-                             it->second.owner.getDebugString().c_str());
+                             references->owner.getDebugString().c_str());
         }
         mAddedLayers.push_back(newLayer.get());
         layer.parentId = linkLayer(layer.parentId, layer.id);
@@ -76,13 +76,13 @@ void LayerLifecycleManager::onHandlesDestroyed(const std::vector<uint32_t>& dest
                                                bool ignoreUnknownHandles) {
     std::vector<uint32_t> layersToBeDestroyed;
     for (const auto& layerId : destroyedHandles) {
-        auto it = mIdToLayer.find(layerId);
-        if (it == mIdToLayer.end()) {
+        RequestedLayerState* layerPtr = getLayerFromId(layerId);
+        if (!layerPtr) {
             LOG_ALWAYS_FATAL_IF(!ignoreUnknownHandles, "%s Layerid not found %d", __func__,
                                 layerId);
             continue;
         }
-        RequestedLayerState& layer = it->second.owner;
+        RequestedLayerState& layer = *layerPtr;
         LLOGV(layer.id, "%s", layer.getDebugString().c_str());
         layer.handleAlive = false;
         if (!layer.canBeDestroyed()) {
@@ -99,13 +99,13 @@ void LayerLifecycleManager::onHandlesDestroyed(const std::vector<uint32_t>& dest
     mGlobalChanges |= RequestedLayerState::Changes::Hierarchy;
     for (size_t i = 0; i < layersToBeDestroyed.size(); i++) {
         uint32_t layerId = layersToBeDestroyed[i];
-        auto it = mIdToLayer.find(layerId);
-        if (it == mIdToLayer.end()) {
+        References* layerReferences = mIdToLayer.get(layerId);
+        if (!layerReferences) {
             LOG_ALWAYS_FATAL("%s Layer with id %d not found", __func__, layerId);
             continue;
         }
 
-        RequestedLayerState& layer = it->second.owner;
+        RequestedLayerState& layer = layerReferences->owner;
 
         layer.parentId = unlinkLayer(layer.parentId, layer.id);
         layer.relativeParentId = unlinkLayer(layer.relativeParentId, layer.id);
@@ -119,7 +119,7 @@ void LayerLifecycleManager::onHandlesDestroyed(const std::vector<uint32_t>& dest
 
         layer.touchCropId = unlinkLayer(layer.touchCropId, layer.id);
 
-        auto& references = it->second.references;
+        auto& references = layerReferences->references;
         for (uint32_t linkedLayerId : references) {
             RequestedLayerState* linkedLayer = getLayerFromId(linkedLayerId);
             if (!linkedLayer) {
@@ -144,7 +144,7 @@ void LayerLifecycleManager::onHandlesDestroyed(const std::vector<uint32_t>& dest
                 linkedLayer->touchCropId = UNASSIGNED_LAYER_ID;
             }
         }
-        mIdToLayer.erase(it);
+        mIdToLayer.erase(layerId);
     }
 
     auto it = mLayers.begin();
@@ -306,22 +306,22 @@ RequestedLayerState* LayerLifecycleManager::getLayerFromId(uint32_t id) {
     if (id == UNASSIGNED_LAYER_ID) {
         return nullptr;
     }
-    auto it = mIdToLayer.find(id);
-    if (it == mIdToLayer.end()) {
+    References* references = mIdToLayer.get(id);
+    if (!references) {
         return nullptr;
     }
-    return &it->second.owner;
+    return &references->owner;
 }
 
 std::vector<uint32_t>* LayerLifecycleManager::getLinkedLayersFromId(uint32_t id) {
     if (id == UNASSIGNED_LAYER_ID) {
         return nullptr;
     }
-    auto it = mIdToLayer.find(id);
-    if (it == mIdToLayer.end()) {
+    References* references = mIdToLayer.get(id);
+    if (!references) {
         return nullptr;
     }
-    return &it->second.references;
+    return &references->references;
 }
 
 uint32_t LayerLifecycleManager::linkLayer(uint32_t layerId, uint32_t layerToLink) {
@@ -366,11 +366,11 @@ std::string LayerLifecycleManager::References::getDebugString() const {
 }
 
 void LayerLifecycleManager::fixRelativeZLoop(uint32_t relativeRootId) {
-    auto it = mIdToLayer.find(relativeRootId);
-    if (it == mIdToLayer.end()) {
+    RequestedLayerState* layerPtr = getLayerFromId(relativeRootId);
+    if (!layerPtr) {
         return;
     }
-    RequestedLayerState& layer = it->second.owner;
+    RequestedLayerState& layer = *layerPtr;
     layer.relativeParentId = unlinkLayer(layer.relativeParentId, layer.id);
     layer.changes |=
             RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::RelativeParent;
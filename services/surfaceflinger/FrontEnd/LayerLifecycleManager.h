@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "LayerIdTable.h"
 #include "RequestedLayerState.h"
 #include "TransactionState.h"
 
@@ -97,7 +98,7 @@ private:
         std::vector<uint32_t> references;
         std::string getDebugString() const;
     };
-    std::unordered_map<uint32_t, References> mIdToLayer;
+    LayerIdTable<References> mIdToLayer;
     // Listeners are invoked once changes are committed.
     std::vector<std::shared_ptr<ILifecycleListener>> mListeners;
     // Layers that mirror a display stack (see updateDisplayMirrorLayers)
@@ -20,6 +20,7 @@
 #define LOG_TAG "LayerSnapshotBuilder"
 
 #include "LayerSnapshotBuilder.h"
+#include <android-base/stringprintf.h>
 #include <gui/TraceUtils.h>
 #include <ui/FloatRect.h>
 
@@ -418,6 +419,8 @@ bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
 
 void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     ATRACE_NAME("UpdateSnapshots");
+    mVisitedSnapshotCount = 0;
+    mDirtySubtrees.clear();
     if (args.parentCrop) {
         mRootSnapshot.geomLayerBounds = *args.parentCrop;
     } else if (args.forceUpdate == ForceUpdateFlags::ALL || args.displayChanges) {
@@ -451,6 +454,15 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     // cropped by any other layer and it requires both snapshots to be updated.
     updateTouchableRegionCrop(args);
 
+    const size_t visitedSnapshotCount = mVisitedSnapshotCount;
+    mSkippedSnapshotCount =
+            mSnapshots.size() > visitedSnapshotCount ? mSnapshots.size() - visitedSnapshotCount : 0;
+    ATRACE_INT("SnapshotsSkipped", static_cast<int32_t>(mSkippedSnapshotCount));
+
+    const bool resorted = mResortSnapshots || args.forceUpdate != ForceUpdateFlags::NONE ||
+            args.layerLifecycleManager.getGlobalChanges().any(
+                    RequestedLayerState::Changes::Hierarchy |
+                    RequestedLayerState::Changes::Visibility);
     const bool hasUnreachableSnapshots = sortSnapshotsByZ(args);
     clearChanges(mRootSnapshot);
 
@@ -458,6 +470,7 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     // layers if the layer have been destroyed.
     // TODO(b/238781169) consider making clone layer ids stable as well
     if (!hasUnreachableSnapshots && args.layerLifecycleManager.getDestroyedLayers().empty()) {
+        updateHotState(/*rebuild=*/resorted);
         return;
     }
 
@@ -481,6 +494,7 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         std::iter_swap(it, mSnapshots.end() - 1);
         mSnapshots.erase(mSnapshots.end() - 1);
     }
+    updateHotState(/*rebuild=*/true);
 }
 
 void LayerSnapshotBuilder::update(const Args& args) {
@@ -489,16 +503,43 @@ void LayerSnapshotBuilder::update(const Args& args) {
     }
 
     if (tryFastUpdate(args)) {
+        updateHotState(/*rebuild=*/false);
         return;
     }
     updateSnapshots(args);
 }
 
+void LayerSnapshotBuilder::HotState::resize(size_t size) {
+    isVisible.resize(size);
+    hasInputInfo.resize(size);
+}
+
+void LayerSnapshotBuilder::HotState::set(size_t index, const LayerSnapshot& snapshot) {
+    isVisible[index] = snapshot.isVisible;
+    hasInputInfo[index] = snapshot.hasInputInfo();
+}
+
+void LayerSnapshotBuilder::updateHotState(bool rebuild) {
+    const size_t size = static_cast<size_t>(mNumInterestingSnapshots);
+    rebuild |= mHotState.size() != size;
+    mHotState.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        const LayerSnapshot& snapshot = *mSnapshots[i];
+        if (rebuild || snapshot.changes.get() != 0) {
+            mHotState.set(i, snapshot);
+        }
+    }
+}
+
 const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         const Args& args, const LayerHierarchy& hierarchy,
         LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot) {
     const RequestedLayerState* layer = hierarchy.getLayer();
     LayerSnapshot* snapshot = getSnapshot(traversalPath);
+    if (canSkipSubtree(args, hierarchy, snapshot, parentSnapshot, traversalPath)) {
+        return *snapshot;
+    }
+    mVisitedSnapshotCount++;
     const bool newSnapshot = snapshot == nullptr;
     if (newSnapshot) {
         snapshot = createSnapshot(traversalPath, *layer, parentSnapshot);
@@ -529,6 +570,51 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
     return *snapshot;
 }
 
+bool LayerSnapshotBuilder::isSubtreeDirty(const LayerHierarchy& hierarchy) {
+    if (auto it = mDirtySubtrees.find(&hierarchy); it != mDirtySubtrees.end()) {
+        return it->second;
+    }
+
+    // Layers whose touchable region is cropped by another layer are updated whenever input
+    // changes anywhere, so always visit them.
+    const RequestedLayerState* layer = hierarchy.getLayer();
+    bool dirty = layer->changes.get() != 0 || layer->what != 0 || layer->autoRefresh ||
+            layer->touchCropId != UNASSIGNED_LAYER_ID;
+    for (auto it = hierarchy.mChildren.begin(); !dirty && it != hierarchy.mChildren.end(); it++) {
+        const auto& [childHierarchy, variant] = *it;
+        dirty = variant == LayerHierarchy::Variant::Relative || isSubtreeDirty(*childHierarchy);
+    }
+    mDirtySubtrees[&hierarchy] = dirty;
+    return dirty;
+}
+
+bool LayerSnapshotBuilder::canSkipSubtree(const Args& args, const LayerHierarchy& hierarchy,
+                                          const LayerSnapshot* snapshot,
+                                          const LayerSnapshot& parentSnapshot,
+                                          const LayerHierarchy::TraversalPath& traversalPath) {
+    if (!args.skipCleanSubtrees || args.forceUpdate != ForceUpdateFlags::NONE ||
+        args.displayChanges || !snapshot || traversalPath.isRelative() ||
+        traversalPath.isClone()) {
+        return false;
+    }
+
+    // A snapshot that already has changes was updated earlier in this pass, for example as the
+    // relative child of another layer, and its children need to pick them up.
+    if (snapshot->changes.get() != 0) {
+        return false;
+    }
+
+    if (parentSnapshot.changes.any(
+                RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
+                RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
+                RequestedLayerState::Changes::AffectsChildren |
+                RequestedLayerState::Changes::FrameRate)) {
+        return false;
+    }
+
+    return !isSubtreeDirty(hierarchy);
+}
+
 LayerSnapshot* LayerSnapshotBuilder::getSnapshot(uint32_t layerId) const {
     if (layerId == UNASSIGNED_LAYER_ID) {
         return nullptr;
@@ -1084,10 +1170,9 @@ std::vector<std::unique_ptr<LayerSnapshot>>& LayerSnapshotBuilder::getSnapshots(
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor) const {
-    for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
-        if (!snapshot.isVisible) continue;
-        visitor(snapshot);
+    for (size_t i = 0; i < mHotState.size(); i++) {
+        if (!mHotState.isVisible[i]) continue;
+        visitor(*mSnapshots[i]);
     }
 }
 
@@ -1106,21 +1191,24 @@ void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor,
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const Visitor& visitor) {
-    for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        std::unique_ptr<LayerSnapshot>& snapshot = mSnapshots.at((size_t)i);
-        if (!snapshot->isVisible) continue;
-        visitor(snapshot);
+    for (size_t i = 0; i < mHotState.size(); i++) {
+        if (!mHotState.isVisible[i]) continue;
+        visitor(mSnapshots.at(i));
     }
 }
 
 void LayerSnapshotBuilder::forEachInputSnapshot(const ConstVisitor& visitor) const {
-    for (int i = mNumInterestingSnapshots - 1; i >= 0; i--) {
-        LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
-        if (!snapshot.hasInputInfo()) continue;
-        visitor(snapshot);
+    for (size_t i = mHotState.size(); i-- > 0;) {
+        if (!mHotState.hasInputInfo[i]) continue;
+        visitor(*mSnapshots[i]);
     }
 }
 
+void LayerSnapshotBuilder::dump(std::string& out) const {
+    base::StringAppendF(&out, "  snapshots visited/skipped : %zu/%zu\n",
+                        mVisitedSnapshotCount.load(), mSkippedSnapshotCount.load());
+}
+
 void LayerSnapshotBuilder::updateTouchableRegionCrop(const Args& args) {
     if (mNeedsTouchableRegionCrop.empty()) {
         return;
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "Display/DisplayMap.h"
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerLifecycleManager.h"
@@ -55,7 +57,23 @@ public:
         std::unordered_set<uint32_t> excludeLayerIds;
         const std::unordered_map<std::string, bool>& supportedLayerGenericMetadata;
         const std::unordered_map<std::string, uint32_t>& genericLayerMetadataKeyMap;
+        // If true, subtrees with no layer changes whose parent snapshot did not change are not
+        // walked. See isSubtreeDirty().
+        bool skipCleanSubtrees = false;
+    };
+    // Copies of the flags that forEachVisibleSnapshot and forEachInputSnapshot filter on, stored
+    // as parallel arrays indexed by globalZ, so that they scan these contiguously instead of
+    // dereferencing every snapshot. Only the snapshots that are visible or have input info,
+    // which are sorted to the front of the snapshot list, are tracked.
+    struct HotState {
+        std::vector<uint8_t> isVisible;
+        std::vector<uint8_t> hasInputInfo;
+
+        size_t size() const { return isVisible.size(); }
+        void resize(size_t size);
+        void set(size_t index, const LayerSnapshot&);
     };
+
     LayerSnapshotBuilder();
 
     // Rebuild the snapshots from scratch.
@@ -85,6 +103,15 @@ public:
     // Visit each snapshot interesting to input reverse z-order
     void forEachInputSnapshot(const ConstVisitor& visitor) const;
 
+    // Snapshot fields indexed by globalZ, valid until the next update.
+    const HotState& getHotState() const { return mHotState; }
+
+    // Number of snapshots updated and skipped by the last update that walked the hierarchy.
+    size_t getVisitedSnapshotCount() const { return mVisitedSnapshotCount; }
+    size_t getSkippedSnapshotCount() const { return mSkippedSnapshotCount; }
+
+    void dump(std::string& out) const;
+
 private:
     friend class LayerSnapshotTest;
     static LayerSnapshot getRootSnapshot();
@@ -121,6 +148,18 @@ private:
                           const Args& args);
     void updateTouchableRegionCrop(const Args& args);
 
+    // Returns true if the layer or any layer reachable from it in the hierarchy has changes to
+    // apply this update. Subtrees reached through relative parents are always considered dirty
+    // since their snapshots may also be modified while visiting their real parents. Clones are
+    // never skipped since their input is cropped by the mirror root.
+    bool isSubtreeDirty(const LayerHierarchy& hierarchy);
+    // Refreshes mHotState from the snapshots. If rebuild is false, only snapshots with changes
+    // are copied.
+    void updateHotState(bool rebuild);
+    bool canSkipSubtree(const Args&, const LayerHierarchy&, const LayerSnapshot* snapshot,
+                        const LayerSnapshot& parentSnapshot,
+                        const LayerHierarchy::TraversalPath&);
+
     std::unordered_map<LayerHierarchy::TraversalPath, LayerSnapshot*,
                        LayerHierarchy::TraversalPathHash>
             mIdToSnapshot;
@@ -131,6 +170,13 @@ private:
     LayerSnapshot mRootSnapshot;
     bool mResortSnapshots = false;
     int mNumInterestingSnapshots = 0;
+    HotState mHotState;
+
+    // Memoized results of isSubtreeDirty, only valid during a single update.
+    std::unordered_map<const LayerHierarchy*, bool> mDirtySubtrees;
+    // Accessed by dumpsys off the main thread.
+    std::atomic<size_t> mVisitedSnapshotCount = 0;
+    std::atomic<size_t> mSkippedSnapshotCount = 0;
 };
 
 } // namespace android::surfaceflinger::frontend
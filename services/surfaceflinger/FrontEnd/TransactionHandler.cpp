@@ -19,10 +19,18 @@
 #define LOG_TAG "TransactionHandler"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <android-base/stringprintf.h>
 #include <cutils/trace.h>
+#include <ftl/enum.h>
+#include <gui/ISurfaceComposer.h>
+#include <poll.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <map>
+#include <tuple>
+
 #include "TransactionHandler.h"
 
 namespace android::surfaceflinger::frontend {
@@ -34,19 +42,30 @@ void TransactionHandler::queueTransaction(TransactionState&& state) {
 }
 
 std::vector<TransactionState> TransactionHandler::flushTransactions() {
-    while (!mLocklessTransactionQueue.isEmpty()) {
-        auto maybeTransaction = mLocklessTransactionQueue.pop();
-        if (!maybeTransaction.has_value()) {
-            break;
-        }
-        auto transaction = maybeTransaction.value();
-        mPendingTransactionQueues[transaction.applyToken].emplace(std::move(transaction));
-    }
+    mFrame++;
+    std::vector<TransactionState> transactions;
+    flushTransactions(transactions);
+    return transactions;
+}
+
+void TransactionHandler::flushTransactions(std::vector<TransactionState>& transactions) {
+    const size_t previousTransactionCount = transactions.size();
+    mFencesBlockingTransactions.clear();
+    mLocklessTransactionQueue.drain([this](TransactionState&& transaction) {
+        transaction.queuedFrame = mFrame;
+        auto& queue = mPendingTransactionQueues[transaction.applyToken];
+        queue.emplace(std::move(transaction));
+    });
 
     // Collect transaction that are ready to be applied.
-    std::vector<TransactionState> transactions;
     TransactionFlushState flushState;
+    flushState.firstTransaction = transactions.empty();
     flushState.queueProcessTime = systemTime();
+    // The layers of transactions that are already ready have a buffer to present this frame, so
+    // later buffers for them are held back as if they were flushed together.
+    for (const auto& transaction : transactions) {
+        trackBufferLayersReadyToPresent(transaction, flushState);
+    }
     // Transactions with a buffer pending on a barrier may be on a different applyToken
     // than the transaction which satisfies our barrier. In fact this is the exact use case
     // that the primitive is designed for. This means we may first process
@@ -67,9 +86,8 @@ std::vector<TransactionState> TransactionHandler::flushTransactions() {
 
     applyUnsignaledBufferTransaction(transactions, flushState);
 
-    mPendingTransactionCount.fetch_sub(transactions.size());
+    mPendingTransactionCount.fetch_sub(transactions.size() - previousTransactionCount);
     ATRACE_INT("TransactionQueue", static_cast<int>(mPendingTransactionCount.load()));
-    return transactions;
 }
 
 void TransactionHandler::applyUnsignaledBufferTransaction(
@@ -102,11 +120,24 @@ void TransactionHandler::popTransactionFromPending(std::vector<TransactionState>
     // Transaction is ready move it from the pending queue.
     flushState.firstTransaction = false;
     removeFromStalledTransactions(transaction.id);
+    {
+        const size_t framesWaited = static_cast<size_t>(mFrame - transaction.queuedFrame);
+        std::scoped_lock lock(mClientWaitStatsMutex);
+        ClientWaitStats& stats = mClientWaitStats[transaction.originUid];
+        stats.lane = getLane(transaction);
+        stats.transactionCount++;
+        stats.totalFramesWaited += framesWaited;
+        stats.maxFramesWaited = std::max(stats.maxFramesWaited, framesWaited);
+    }
     transactions.emplace_back(std::move(transaction));
     queue.pop();
 
-    auto& readyToApplyTransaction = transactions.back();
-    readyToApplyTransaction.traverseStatesWithBuffers([&](const layer_state_t& state) {
+    trackBufferLayersReadyToPresent(transactions.back(), flushState);
+}
+
+void TransactionHandler::trackBufferLayersReadyToPresent(const TransactionState& transaction,
+                                                         TransactionFlushState& flushState) {
+    transaction.traverseStatesWithBuffers([&](const layer_state_t& state) {
         const bool frameNumberChanged =
                 state.bufferData->flags.test(BufferData::BufferDataChange::frameNumberChanged);
         if (frameNumberChanged) {
@@ -143,11 +174,37 @@ TransactionHandler::TransactionReadiness TransactionHandler::applyFilters(
     return ready;
 }
 
+auto TransactionHandler::getLane(const TransactionState& transaction) const -> Lane {
+    if (transaction.flags & ISurfaceComposer::eEarlyWakeupStart ||
+        mPriorityUids.count(transaction.originUid)) {
+        return Lane::Priority;
+    }
+    return Lane::Normal;
+}
+
 int TransactionHandler::flushPendingTransactionQueues(std::vector<TransactionState>& transactions,
                                                       TransactionFlushState& flushState) {
+    // Order the queues by the lane and deadline of the transaction at their front. Erasing a
+    // queue does not invalidate the iterators to the others.
+    struct OrderedQueue {
+        Lane lane;
+        nsecs_t deadline;
+        PendingTransactionQueues::iterator it;
+    };
+    ftl::SmallVector<OrderedQueue, 16> orderedQueues;
+    for (auto it = mPendingTransactionQueues.begin(); it != mPendingTransactionQueues.end(); ++it) {
+        const TransactionState& front = it->second.front();
+        orderedQueues.push_back(
+                {getLane(front), front.isAutoTimestamp ? front.postTime : front.desiredPresentTime,
+                 it});
+    }
+    std::sort(orderedQueues.begin(), orderedQueues.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.lane, lhs.deadline) < std::tie(rhs.lane, rhs.deadline);
+    });
+
     int transactionsPendingBarrier = 0;
-    auto it = mPendingTransactionQueues.begin();
-    while (it != mPendingTransactionQueues.end()) {
+    for (const auto& orderedQueue : orderedQueues) {
+        const auto it = orderedQueue.it;
         auto& [applyToken, queue] = *it;
         while (!queue.empty()) {
             auto& transaction = queue.front();
@@ -169,9 +226,7 @@ int TransactionHandler::flushPendingTransactionQueues(std::vector<TransactionSta
         }
 
         if (queue.empty()) {
-            it = mPendingTransactionQueues.erase(it);
-        } else {
-            it = std::next(it, 1);
+            mPendingTransactionQueues.erase(it);
         }
     }
     return transactionsPendingBarrier;
@@ -181,6 +236,100 @@ void TransactionHandler::addTransactionReadyFilter(TransactionFilter&& filter) {
     mTransactionReadyFilters.emplace_back(std::move(filter));
 }
 
+void TransactionHandler::onTransactionWaitingOnFence(const sp<Fence>& fence) {
+    if (fence && fence->isValid()) {
+        mFencesBlockingTransactions.push_back(fence);
+    }
+}
+
+bool TransactionHandler::waitForPendingAcquireFences(std::chrono::nanoseconds timeout) {
+    if (mFencesBlockingTransactions.empty() || timeout <= std::chrono::nanoseconds::zero()) {
+        return false;
+    }
+    ATRACE_CALL();
+
+    ftl::SmallVector<pollfd, 4> fds;
+    for (const auto& fence : mFencesBlockingTransactions) {
+        fds.push_back({.fd = fence->get(), .events = POLLIN, .revents = 0});
+    }
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec timeoutSpec{.tv_sec = static_cast<time_t>(seconds.count()),
+                               .tv_nsec = static_cast<long>((timeout - seconds).count())};
+    const int ret = ppoll(fds.data(), fds.size(), &timeoutSpec, nullptr);
+    if (ret < 0) {
+        ALOGW("%s: ppoll failed: %s", __func__, strerror(errno));
+        return false;
+    }
+    ATRACE_INT("FencesSignaledWhileWaiting", ret);
+    return ret > 0;
+}
+
+void TransactionHandler::setPriorityUids(std::unordered_set<int> uids) {
+    mPriorityUids = std::move(uids);
+}
+
+auto TransactionHandler::getClientWaitStats() const
+        -> std::unordered_map<int /* uid */, ClientWaitStats> {
+    std::scoped_lock lock(mClientWaitStatsMutex);
+    return mClientWaitStats;
+}
+
+void TransactionHandler::recordTransactionParcelSize(size_t bytes) {
+    size_t bucket = 0;
+    for (size_t limit = kParcelSizeHistogramMinBytes;
+         bytes >= limit && bucket < kParcelSizeHistogramBuckets - 1; limit *= 2) {
+        bucket++;
+    }
+    mParcelSizeHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto TransactionHandler::getTransactionParcelSizeHistogram() const -> ParcelSizeHistogram {
+    ParcelSizeHistogram histogram;
+    for (size_t i = 0; i < kParcelSizeHistogramBuckets; i++) {
+        histogram[i] = mParcelSizeHistogram[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+void TransactionHandler::clearClientWaitStats() {
+    {
+        std::scoped_lock lock(mClientWaitStatsMutex);
+        mClientWaitStats.clear();
+    }
+    for (auto& count : mParcelSizeHistogram) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TransactionHandler::dump(std::string& result) const {
+    // Sort by uid for readability.
+    const auto stats = getClientWaitStats();
+    const std::map<int, ClientWaitStats> sortedStats(stats.begin(), stats.end());
+
+    result.append("Frames waited by transactions before being applied:\n");
+    base::StringAppendF(&result, "  %-8s %-8s %12s %8s %8s\n", "uid", "lane", "transactions",
+                        "avg", "max");
+    for (const auto& [uid, clientStats] : sortedStats) {
+        base::StringAppendF(&result, "  %-8d %-8s %12zu %8.2f %8zu\n", uid,
+                            ftl::enum_string(clientStats.lane).c_str(),
+                            clientStats.transactionCount,
+                            static_cast<float>(clientStats.totalFramesWaited) /
+                                    static_cast<float>(clientStats.transactionCount),
+                            clientStats.maxFramesWaited);
+    }
+
+    result.append("Transaction parcel sizes:\n");
+    const auto histogram = getTransactionParcelSizeHistogram();
+    size_t limit = kParcelSizeHistogramMinBytes;
+    for (size_t i = 0; i < kParcelSizeHistogramBuckets; i++, limit *= 2) {
+        if (i < kParcelSizeHistogramBuckets - 1) {
+            base::StringAppendF(&result, "  < %6zu B: %zu\n", limit, histogram[i]);
+        } else {
+            base::StringAppendF(&result, "  >= %5zu B: %zu\n", limit / 2, histogram[i]);
+        }
+    }
+}
+
 bool TransactionHandler::hasPendingTransactions() {
     return !mPendingTransactionQueues.empty() || !mLocklessTransactionQueue.isEmpty();
 }
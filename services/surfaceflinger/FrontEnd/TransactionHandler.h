@@ -17,7 +17,14 @@
 #pragma once
 
 #include <semaphore.h>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <LocklessQueue.h>
@@ -57,14 +64,62 @@ public:
     };
     using TransactionFilter = std::function<TransactionReadiness(const TransactionFlushState&)>;
 
+    // Queues are flushed lane by lane, and in order of deadline within a lane, so that
+    // transactions of latency-critical clients are applied before those of other clients.
+    enum class Lane {
+        // Transactions from priority uids, or that request an early wakeup.
+        Priority,
+        Normal,
+        ftl_last = Normal
+    };
+
+    // How long the transactions of a client waited between being queued and being applied.
+    struct ClientWaitStats {
+        Lane lane = Lane::Normal;
+        size_t transactionCount = 0;
+        // Frames are counted by flushTransactions(), i.e. a transaction applied in the first
+        // frame after being queued waited zero frames.
+        size_t totalFramesWaited = 0;
+        size_t maxFramesWaited = 0;
+    };
+
+    // Sets the uids whose transactions are flushed in the priority lane.
+    void setPriorityUids(std::unordered_set<int> uids);
+
     bool hasPendingTransactions();
+    // The number of transactions queued but not yet flushed.
+    size_t getPendingTransactionCount() const { return mPendingTransactionCount.load(); }
     std::vector<TransactionState> flushTransactions();
+    // Appends ready transactions to an existing list. Transactions already in the list count
+    // as ready for the purpose of latching unsignaled buffers.
+    void flushTransactions(std::vector<TransactionState>& transactions);
     void addTransactionReadyFilter(TransactionFilter&&);
     void queueTransaction(TransactionState&&);
     void onTransactionQueueStalled(uint64_t transactionId, sp<ITransactionCompletedListener>&,
                                    const std::string& reason);
     void removeFromStalledTransactions(uint64_t transactionId);
 
+    // Called by transaction ready filters when a transaction is held back only because the
+    // given acquire fence has not signaled. The fences are forgotten on the next flush.
+    void onTransactionWaitingOnFence(const sp<Fence>&);
+    // Waits up to timeout for any fence reported through onTransactionWaitingOnFence since the
+    // last flush to signal. Returns true if one did, in which case flushing again may return
+    // more transactions.
+    bool waitForPendingAcquireFences(std::chrono::nanoseconds timeout);
+
+    // Incoming SET_TRANSACTION_STATE parcels, bucketed by size in powers of two from
+    // kParcelSizeHistogramMinBytes. The last bucket also counts anything larger.
+    static constexpr size_t kParcelSizeHistogramMinBytes = 512;
+    static constexpr size_t kParcelSizeHistogramBuckets = 9;
+    using ParcelSizeHistogram = std::array<size_t, kParcelSizeHistogramBuckets>;
+
+    // May be called from any thread.
+    void recordTransactionParcelSize(size_t bytes);
+    ParcelSizeHistogram getTransactionParcelSizeHistogram() const;
+    std::unordered_map<int /* uid */, ClientWaitStats> getClientWaitStats() const;
+    void dump(std::string& result) const;
+    void clearClientWaitStats();
+
 private:
     // For unit tests
     friend class ::android::TestableSurfaceFlinger;
@@ -73,13 +128,26 @@ private:
     void applyUnsignaledBufferTransaction(std::vector<TransactionState>&, TransactionFlushState&);
     void popTransactionFromPending(std::vector<TransactionState>&, TransactionFlushState&,
                                    std::queue<TransactionState>&);
+    void trackBufferLayersReadyToPresent(const TransactionState&, TransactionFlushState&);
     TransactionReadiness applyFilters(TransactionFlushState&);
-    std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>
-            mPendingTransactionQueues;
+    Lane getLane(const TransactionState&) const;
+
+    using PendingTransactionQueues =
+            std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>;
+    PendingTransactionQueues mPendingTransactionQueues;
     LocklessQueue<TransactionState> mLocklessTransactionQueue;
     std::atomic<size_t> mPendingTransactionCount = 0;
     ftl::SmallVector<TransactionFilter, 2> mTransactionReadyFilters;
     std::vector<uint64_t> mStalledTransactions;
+    ftl::SmallVector<sp<Fence>, 4> mFencesBlockingTransactions;
+    std::unordered_set<int> mPriorityUids;
+
+    // Incremented by every flushTransactions() that starts a new frame.
+    uint64_t mFrame = 0;
+
+    mutable std::mutex mClientWaitStatsMutex;
+    std::unordered_map<int, ClientWaitStats> mClientWaitStats GUARDED_BY(mClientWaitStatsMutex);
+    std::array<std::atomic<size_t>, kParcelSizeHistogramBuckets> mParcelSizeHistogram{};
 };
 } // namespace surfaceflinger::frontend
 } // namespace android
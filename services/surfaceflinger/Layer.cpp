@@ -255,10 +255,14 @@ Layer::~Layer() {
     // one of the layers, in this case the original layer, needs to handle the deletion. The
     // original layer and the clone should be removed at the same time so there shouldn't be any
     // issue with the clone layer trying to use the texture.
-    if (mBufferInfo.mBuffer != nullptr) {
-        callReleaseBufferCallback(mDrawingState.releaseBufferListener,
-                                  mBufferInfo.mBuffer->getBuffer(), mBufferInfo.mFrameNumber,
-                                  mBufferInfo.mFence);
+    if (const auto& listener = mDrawingState.releaseBufferListener;
+        listener && mBufferInfo.mBuffer != nullptr) {
+        // Sent right away rather than queued, as there may be no frame to send it with.
+        listener->onReleaseBuffer({mBufferInfo.mBuffer->getBuffer()->getId(),
+                                   mBufferInfo.mFrameNumber},
+                                  mBufferInfo.mFence ? mBufferInfo.mFence : Fence::NO_FENCE,
+                                  mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(
+                                          mOwnerUid));
     }
     if (!isClone()) {
         // The original layer and the clone layer share the same texture. Therefore, only one of
@@ -2839,9 +2843,13 @@ void Layer::callReleaseBufferCallback(const sp<ITransactionCompletedListener>& l
     ATRACE_FORMAT_INSTANT("callReleaseBufferCallback %s - %" PRIu64, getDebugName(), framenumber);
     uint32_t currentMaxAcquiredBufferCount =
             mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(mOwnerUid);
-    listener->onReleaseBuffer({buffer->getId(), framenumber},
-                              releaseFence ? releaseFence : Fence::NO_FENCE,
-                              currentMaxAcquiredBufferCount);
+    // Releases happen while transactions are committed, so they are delivered along with the
+    // transaction callbacks sent at the end of the commit.
+    mFlinger->getTransactionCallbackInvoker()
+            .addReleasedBuffer(IInterface::asBinder(listener),
+                               {{buffer->getId(), framenumber},
+                                releaseFence ? releaseFence : Fence::NO_FENCE,
+                                currentMaxAcquiredBufferCount});
 }
 
 void Layer::onLayerDisplayed(ftl::SharedFuture<FenceResult> futureFenceResult,
@@ -4171,6 +4179,10 @@ sp<GraphicBuffer> Layer::getBuffer() const {
     return mBufferInfo.mBuffer ? mBufferInfo.mBuffer->getBuffer() : nullptr;
 }
 
+bool Layer::isPresentingBuffer(uint64_t bufferId, uint64_t frameNumber) const {
+    return getCurrentBufferId() == bufferId && mBufferInfo.mFrameNumber == frameNumber;
+}
+
 void Layer::setTransformHintLegacy(ui::Transform::RotationFlags displayTransformHint) {
     mTransformHintLegacy = getFixedTransformHint();
     if (mTransformHintLegacy == ui::Transform::ROT_INVALID) {
@@ -486,6 +486,8 @@ public:
     uint32_t getBufferTransform() const;
 
     sp<GraphicBuffer> getBuffer() const;
+    // Returns whether the given buffer and frame are the ones currently latched.
+    bool isPresentingBuffer(uint64_t bufferId, uint64_t frameNumber) const;
     const std::shared_ptr<renderengine::ExternalTexture>& getExternalTexture() const;
 
     /*
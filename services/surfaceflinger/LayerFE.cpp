@@ -83,7 +83,10 @@ const compositionengine::LayerFECompositionState* LayerFE::getCompositionState()
 }
 
 bool LayerFE::onPreComposition(nsecs_t refreshStartTime, bool) {
-    mCompositionResult.refreshStartTime = refreshStartTime;
+    {
+        std::scoped_lock lock(mCompositionResultMutex);
+        mCompositionResult.refreshStartTime = refreshStartTime;
+    }
     return mSnapshot->hasReadyFrame;
 }
 
@@ -248,6 +251,7 @@ void LayerFE::prepareBufferStateClientComposition(
     layerSettings.source.buffer.maxLuminanceNits = maxLuminance;
     layerSettings.frameNumber = mSnapshot->frameNumber;
     layerSettings.bufferId = mSnapshot->externalTexture->getId();
+    layerSettings.source.buffer.frameNumber = mSnapshot->frameNumber;
 
     // Query the texture matrix given our current filtering mode.
     float textureMatrix[16];
@@ -327,10 +331,12 @@ void LayerFE::prepareShadowClientComposition(LayerFE::LayerSettings& caster,
 
 void LayerFE::onLayerDisplayed(ftl::SharedFuture<FenceResult> futureFenceResult,
                                ui::LayerStack layerStack) {
+    std::scoped_lock lock(mCompositionResultMutex);
     mCompositionResult.releaseFences.emplace_back(std::move(futureFenceResult), layerStack);
 }
 
 CompositionResult&& LayerFE::stealCompositionResult() {
+    std::scoped_lock lock(mCompositionResultMutex);
     return std::move(mCompositionResult);
 }
 
@@ -355,6 +361,7 @@ bool LayerFE::hasRoundedCorners() const {
 }
 
 void LayerFE::setWasClientComposed(const sp<Fence>& fence) {
+    std::scoped_lock lock(mCompositionResultMutex);
     mCompositionResult.lastClientCompositionFence = fence;
 }
 
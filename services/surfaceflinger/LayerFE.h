@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
 #include <android/gui/CachingHint.h>
 #include <gui/LayerMetadata.h>
 #include "FrontEnd/LayerSnapshot.h"
@@ -23,6 +24,8 @@
 #include "compositionengine/LayerFECompositionState.h"
 #include "renderengine/LayerSettings.h"
 
+#include <mutex>
+
 namespace android {
 
 struct CompositionResult {
@@ -77,7 +80,10 @@ private:
 
     const sp<GraphicBuffer> getBuffer() const;
 
-    CompositionResult mCompositionResult;
+    // Outputs may be presented concurrently, and a layer visible on several of them is notified by
+    // each, so the result is guarded until it is stolen after composition.
+    mutable std::mutex mCompositionResultMutex;
+    CompositionResult mCompositionResult GUARDED_BY(mCompositionResultMutex);
     std::string mName;
 };
 
@@ -36,20 +36,23 @@ template <typename T>
 // then store the list and pop one element.
 //
 // If we already had something in the pop list we just pop directly.
+//
+// drain pops every available entry at once. It uses the same exchange as pop to take the push
+// list, so a burst of pushes is handed to the consumer with a single atomic operation.
 class LocklessQueue {
 public:
     class Entry {
     public:
         T mValue;
         std::atomic<Entry*> mNext;
-        Entry(T value) : mValue(value) {}
+        Entry(T value) : mValue(std::move(value)) {}
     };
     std::atomic<Entry*> mPush = nullptr;
     std::atomic<Entry*> mPop = nullptr;
     bool isEmpty() { return (mPush.load() == nullptr) && (mPop.load() == nullptr); }
 
     void push(T value) {
-        Entry* entry = new Entry(value);
+        Entry* entry = new Entry(std::move(value));
         Entry* previousHead = mPush.load(/*std::memory_order_relaxed*/);
         do {
             entry->mNext = previousHead;
@@ -60,7 +63,7 @@ public:
         if (popped) {
             // Single consumer so this is fine
             mPop.store(popped->mNext /* , std::memory_order_release */);
-            auto value = popped->mValue;
+            auto value = std::move(popped->mValue);
             delete popped;
             return std::move(value);
         } else {
@@ -74,9 +77,43 @@ public:
                 grabbedList = next;
             }
             mPop.store(popped /* , std::memory_order_release */);
-            auto value = grabbedList->mValue;
+            auto value = std::move(grabbedList->mValue);
             delete grabbedList;
             return std::move(value);
         }
     }
+
+    // Invokes visitor(T&&) for each entry in the order they were pushed and returns the number
+    // of entries visited. Single consumer only, like pop.
+    template <typename Visitor>
+    size_t drain(Visitor&& visitor) {
+        // Entries left in the pop list by a previous pop are older than anything in the push list.
+        size_t count = visitList(mPop.exchange(nullptr /* , std::memory_order_acquire */), visitor);
+
+        Entry* grabbedList = mPush.exchange(nullptr /* , std::memory_order_acquire */);
+        // Reverse the list
+        Entry* ordered = nullptr;
+        while (grabbedList) {
+            Entry* next = grabbedList->mNext;
+            grabbedList->mNext = ordered;
+            ordered = grabbedList;
+            grabbedList = next;
+        }
+        count += visitList(ordered, visitor);
+        return count;
+    }
+
+private:
+    template <typename Visitor>
+    static size_t visitList(Entry* entry, Visitor& visitor) {
+        size_t count = 0;
+        while (entry) {
+            Entry* next = entry->mNext;
+            visitor(std::move(entry->mValue));
+            delete entry;
+            entry = next;
+            count++;
+        }
+        return count;
+    }
 };
@@ -36,6 +36,8 @@
 #include <ui/DisplayStatInfo.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 
 #include "DisplayDevice.h"
@@ -84,6 +86,12 @@ RegionSamplingThread::EnvironmentTimingTunables::EnvironmentTimingTunables() {
                  toNsString(defaultRegionSamplingTimerTimeout).c_str());
     int const samplingTimerTimeoutNsRaw = atoi(value);
 
+    property_get("debug.sf.region_sampling_downscale", value, "1");
+    mDownscaleFactor = std::max(1, atoi(value));
+
+    property_get("debug.sf.region_sampling_skip_unchanged", value, "0");
+    mSkipUnchangedSamples = atoi(value) != 0;
+
     if ((samplingPeriodNsRaw < 0) || (samplingTimerTimeoutNsRaw < 0)) {
         ALOGW("User-specified sampling tuning options nonsensical. Using defaults");
         mSamplingDuration = defaultRegionSamplingWorkDuration;
@@ -136,11 +144,23 @@ void RegionSamplingThread::addListener(const Rect& samplingArea, uint32_t stopLa
     asBinder->linkToDeath(sp<DeathRecipient>::fromExisting(this));
     std::lock_guard lock(mSamplingMutex);
     mDescriptors.emplace(wp<IBinder>(asBinder), Descriptor{samplingArea, stopLayerId, listener});
+    updateSampledAreas();
 }
 
 void RegionSamplingThread::removeListener(const sp<IRegionSamplingListener>& listener) {
     std::lock_guard lock(mSamplingMutex);
     mDescriptors.erase(wp<IBinder>(IInterface::asBinder(listener)));
+    updateSampledAreas();
+}
+
+void RegionSamplingThread::updateSampledAreas() {
+    std::lock_guard lock(mThreadControlMutex);
+    mSampledAreas.clear();
+    for (const auto& [_, descriptor] : mDescriptors) {
+        mSampledAreas.push_back(descriptor.area);
+    }
+    // A new listener needs a sample even if the content is unchanged.
+    mSampledContentChanged = true;
 }
 
 void RegionSamplingThread::checkForStaleLuma() {
@@ -154,13 +174,31 @@ void RegionSamplingThread::checkForStaleLuma() {
 }
 
 void RegionSamplingThread::onCompositionComplete(
-        std::optional<std::chrono::steady_clock::time_point> samplingDeadline) {
-    doSample(samplingDeadline);
+        std::optional<std::chrono::steady_clock::time_point> samplingDeadline,
+        const Region& dirtyRegion) {
+    doSample(samplingDeadline, dirtyRegion);
 }
 
 void RegionSamplingThread::doSample(
-        std::optional<std::chrono::steady_clock::time_point> samplingDeadline) {
+        std::optional<std::chrono::steady_clock::time_point> samplingDeadline,
+        const Region& dirtyRegion) {
     std::lock_guard lock(mThreadControlMutex);
+    if (mTunables.mSkipUnchangedSamples) {
+        for (const Rect& dirty : dirtyRegion) {
+            Rect ignore;
+            if (std::any_of(mSampledAreas.begin(), mSampledAreas.end(),
+                            [&](const Rect& area) { return dirty.intersect(area, &ignore); })) {
+                mSampledContentChanged = true;
+                break;
+            }
+        }
+        if (!mSampledContentChanged) {
+            // The last luma reported to each listener is still accurate.
+            ATRACE_INT(lumaSamplingStepTag, static_cast<int>(samplingStep::noWorkNeeded));
+            return;
+        }
+    }
+
     const auto now = std::chrono::steady_clock::now();
     if (mLastSampleTime + mTunables.mSamplingPeriod > now) {
         // content changed, but we sampled not too long ago, so we need to sample some time in the
@@ -184,6 +222,7 @@ void RegionSamplingThread::doSample(
 
     mSampleRequestTime.reset();
     mLastSampleTime = now;
+    mSampledContentChanged = false;
 
     mIdleTimer.reset();
 
@@ -194,6 +233,7 @@ void RegionSamplingThread::doSample(
 void RegionSamplingThread::binderDied(const wp<IBinder>& who) {
     std::lock_guard lock(mSamplingMutex);
     mDescriptors.erase(who);
+    updateSampledAreas();
 }
 
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
@@ -224,8 +264,26 @@ float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t st
     return accumulatedLuma / (255.0f * pixelCount);
 }
 
+Rect scaleSampleArea(const Rect& area, const Rect& sampledBounds, const ui::Size& bufferSize) {
+    const float scaleX = static_cast<float>(bufferSize.width) / sampledBounds.getWidth();
+    const float scaleY = static_cast<float>(bufferSize.height) / sampledBounds.getHeight();
+    const Rect offsetArea = area - sampledBounds.leftTop();
+
+    // Round outwards so that the area never shrinks to nothing, then clamp to the buffer.
+    Rect scaled;
+    scaled.left = std::clamp(static_cast<int32_t>(std::floor(offsetArea.left * scaleX)), 0,
+                             bufferSize.width - 1);
+    scaled.top = std::clamp(static_cast<int32_t>(std::floor(offsetArea.top * scaleY)), 0,
+                            bufferSize.height - 1);
+    scaled.right = std::clamp(static_cast<int32_t>(std::ceil(offsetArea.right * scaleX)),
+                              scaled.left + 1, bufferSize.width);
+    scaled.bottom = std::clamp(static_cast<int32_t>(std::ceil(offsetArea.bottom * scaleY)),
+                               scaled.top + 1, bufferSize.height);
+    return scaled;
+}
+
 std::vector<float> RegionSamplingThread::sampleBuffer(
-        const sp<GraphicBuffer>& buffer, const Point& leftTop,
+        const sp<GraphicBuffer>& buffer, const Rect& sampledBounds,
         const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation) {
     void* data_raw = nullptr;
     buffer->lock(GRALLOC_USAGE_SW_READ_OFTEN, &data_raw);
@@ -240,7 +298,8 @@ std::vector<float> RegionSamplingThread::sampleBuffer(
     std::transform(descriptors.begin(), descriptors.end(), lumas.begin(),
                    [&](auto const& descriptor) {
                        return sampleArea(data.get(), width, height, stride, orientation,
-                                         descriptor.area - leftTop);
+                                         scaleSampleArea(descriptor.area, sampledBounds,
+                                                         ui::Size(width, height)));
                    });
     return lumas;
 }
@@ -276,11 +335,16 @@ void RegionSamplingThread::captureSample() {
     }
 
     const Rect sampledBounds = sampleRegion.bounds();
+    // All listeners share one readback of their combined area, downscaled to reduce the cost of
+    // rendering and reading it back.
+    const ui::Size sampledSize(std::max(1, sampledBounds.getWidth() / mTunables.mDownscaleFactor),
+                               std::max(1,
+                                        sampledBounds.getHeight() / mTunables.mDownscaleFactor));
     constexpr bool kUseIdentityTransform = false;
     constexpr bool kHintForSeamlessTransition = false;
 
     SurfaceFlinger::RenderAreaFuture renderAreaFuture = ftl::defer([=] {
-        return DisplayRenderArea::create(displayWeak, sampledBounds, sampledBounds.getSize(),
+        return DisplayRenderArea::create(displayWeak, sampledBounds, sampledSize,
                                          ui::Dataspace::V0_SRGB, kUseIdentityTransform,
                                          kHintForSeamlessTransition);
     });
@@ -356,14 +420,14 @@ void RegionSamplingThread::captureSample() {
     }
 
     std::shared_ptr<renderengine::ExternalTexture> buffer = nullptr;
-    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledBounds.getWidth() &&
-        mCachedBuffer->getBuffer()->getHeight() == sampledBounds.getHeight()) {
+    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledSize.width &&
+        mCachedBuffer->getBuffer()->getHeight() == sampledSize.height) {
         buffer = mCachedBuffer;
     } else {
         const uint32_t usage =
                 GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
         sp<GraphicBuffer> graphicBuffer =
-                sp<GraphicBuffer>::make(sampledBounds.getWidth(), sampledBounds.getHeight(),
+                sp<GraphicBuffer>::make(sampledSize.width, sampledSize.height,
                                         PIXEL_FORMAT_RGBA_8888, 1, usage, "RegionSamplingThread");
         const status_t bufferStatus = graphicBuffer->initCheck();
         LOG_ALWAYS_FATAL_IF(bufferStatus != OK, "captureSample: Buffer failed to allocate: %d",
@@ -376,10 +440,11 @@ void RegionSamplingThread::captureSample() {
 
     constexpr bool kRegionSampling = true;
     constexpr bool kGrayscale = false;
+    constexpr bool kOffMainThread = false;
 
     if (const auto fenceResult =
                 mFlinger.captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, buffer,
-                                             kRegionSampling, kGrayscale, nullptr)
+                                             kRegionSampling, kGrayscale, kOffMainThread, nullptr)
                         .get();
         fenceResult.ok()) {
         fenceResult.value()->waitForever(LOG_TAG);
@@ -393,8 +458,8 @@ void RegionSamplingThread::captureSample() {
     }
 
     ALOGV("Sampling %zu descriptors", activeDescriptors.size());
-    std::vector<float> lumas = sampleBuffer(buffer->getBuffer(), sampledBounds.leftTop(),
-                                            activeDescriptors, orientation);
+    std::vector<float> lumas =
+            sampleBuffer(buffer->getBuffer(), sampledBounds, activeDescriptors, orientation);
     if (lumas.size() != activeDescriptors.size()) {
         ALOGW("collected %zu median luma values for %zu descriptors", lumas.size(),
               activeDescriptors.size());
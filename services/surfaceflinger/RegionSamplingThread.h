@@ -22,6 +22,8 @@
 #include <renderengine/ExternalTexture.h>
 #include <ui/GraphicBuffer.h>
 #include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Size.h>
 #include <utils/StrongPointer.h>
 
 #include <chrono>
@@ -45,6 +47,10 @@ using gui::IRegionSamplingListener;
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
                  uint32_t orientation, const Rect& area);
 
+// Maps a sampling area to the area of a sample buffer of bufferSize that holds sampledBounds,
+// possibly downscaled. The returned area covers at least one pixel of the buffer.
+Rect scaleSampleArea(const Rect& area, const Rect& sampledBounds, const ui::Size& bufferSize);
+
 class RegionSamplingThread : public IBinder::DeathRecipient {
 public:
     struct TimingTunables {
@@ -62,6 +68,14 @@ public:
         // This is the interval at which the luma sampling system will check that the luma clients
         // have up to date information. It defaults to the mSamplingPeriod.
         std::chrono::nanoseconds mSamplingTimerTimeout;
+        // debug.sf.region_sampling_downscale
+        // Factor by which the union of all sampling areas is downscaled when it is rendered for a
+        // sample. Every listener's luma is computed from that one shared readback.
+        int32_t mDownscaleFactor = 1;
+        // debug.sf.region_sampling_skip_unchanged
+        // If true, no sample is taken until composition reports a change to the content of a
+        // sampling area.
+        bool mSkipUnchangedSamples = false;
     };
     struct EnvironmentTimingTunables : TimingTunables {
         EnvironmentTimingTunables();
@@ -81,8 +95,10 @@ public:
     // Notifies sampling engine that composition is done and new content is
     // available, and the deadline for the sampling work on the main thread to
     // be completed without eating the budget of another frame.
+    // dirtyRegion is the region of the display that changed in the composited frame.
     void onCompositionComplete(
-            std::optional<std::chrono::steady_clock::time_point> samplingDeadline);
+            std::optional<std::chrono::steady_clock::time_point> samplingDeadline,
+            const Region& dirtyRegion);
 
 private:
     struct Descriptor {
@@ -92,10 +108,12 @@ private:
     };
 
     std::vector<float> sampleBuffer(
-            const sp<GraphicBuffer>& buffer, const Point& leftTop,
+            const sp<GraphicBuffer>& buffer, const Rect& sampledBounds,
             const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation);
 
-    void doSample(std::optional<std::chrono::steady_clock::time_point> samplingDeadline);
+    void doSample(std::optional<std::chrono::steady_clock::time_point> samplingDeadline,
+                  const Region& dirtyRegion);
+    void updateSampledAreas() REQUIRES(mSamplingMutex);
     void binderDied(const wp<IBinder>& who) override;
     void checkForStaleLuma();
 
@@ -115,6 +133,10 @@ private:
     std::optional<std::chrono::steady_clock::time_point> mSampleRequestTime
             GUARDED_BY(mThreadControlMutex);
     std::chrono::steady_clock::time_point mLastSampleTime GUARDED_BY(mThreadControlMutex);
+    // The sampling areas of all listeners, and whether the content of any of them changed since
+    // the last sample was taken.
+    std::vector<Rect> mSampledAreas GUARDED_BY(mThreadControlMutex);
+    bool mSampledContentChanged GUARDED_BY(mThreadControlMutex) = true;
 
     std::mutex mSamplingMutex;
     std::unordered_map<wp<IBinder>, Descriptor, WpHash> mDescriptors GUARDED_BY(mSamplingMutex);
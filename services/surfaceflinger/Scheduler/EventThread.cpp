@@ -36,6 +36,7 @@
 
 #include <cutils/compiler.h>
 #include <cutils/sched_policy.h>
+#include <ftl/small_map.h>
 
 #include <gui/DisplayEventReceiver.h>
 
@@ -657,14 +658,24 @@ void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
     /* QTI_BEGIN */
     const uint8_t num_attempts = 3;
     /* QTI_END */
+    // Consumers with the same frame interval get the same frame timelines, so generate them, and
+    // their prediction tokens, once per frame interval rather than once per consumer.
+    ftl::SmallMap<int64_t, VsyncEventData, 2> vsyncDataByFrameInterval;
+
     for (const auto& consumer : consumers) {
         DisplayEventReceiver::Event copy = event;
         if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
             const int64_t frameInterval = mGetVsyncPeriodFunction(consumer->mOwnerUid);
-            copy.vsync.vsyncData.frameInterval = frameInterval;
-            generateFrameTimeline(copy.vsync.vsyncData, frameInterval, copy.header.timestamp,
-                                  event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                  event.vsync.vsyncData.preferredDeadlineTimestamp());
+            const auto [it, inserted] =
+                    vsyncDataByFrameInterval.try_emplace(frameInterval, event.vsync.vsyncData);
+            auto& vsyncData = it->second;
+            if (inserted) {
+                vsyncData.frameInterval = frameInterval;
+                generateFrameTimeline(vsyncData, frameInterval, copy.header.timestamp,
+                                      event.vsync.vsyncData.preferredExpectedPresentationTime(),
+                                      event.vsync.vsyncData.preferredDeadlineTimestamp());
+            }
+            copy.vsync.vsyncData = vsyncData;
         }
         /* QTI_BEGIN */
         bool qtiNeedsRetry = true;
@@ -317,6 +317,28 @@ float LayerHistory::getLayerFramerate(nsecs_t now, int32_t id) const {
     return 0.f;
 }
 
+bool LayerHistory::hasOnlyInfrequentUpdates(nsecs_t now) const {
+    std::lock_guard lock(mLock);
+    const nsecs_t threshold = getActiveLayerThreshold(now);
+
+    // The partitioning may be out of date, so look at both maps.
+    bool hasActiveLayers = false;
+    for (const LayerInfos* infos : {&mActiveLayerInfos, &mInactiveLayerInfos}) {
+        for (const auto& [key, value] : *infos) {
+            const auto& info = value.second;
+            if (!isLayerActive(*info, threshold)) {
+                continue;
+            }
+            if (info->getSetFrameRateVote().rate.isValid() || info->isAnimating(now) ||
+                info->isFrequent(now).isFrequent) {
+                return false;
+            }
+            hasActiveLayers = true;
+        }
+    }
+    return hasActiveLayers;
+}
+
 void LayerHistory::attachChoreographer(int32_t layerId,
                                        const sp<EventThreadConnection>& choreographerConnection) {
     std::lock_guard lock(mLock);
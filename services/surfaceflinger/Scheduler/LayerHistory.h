@@ -84,6 +84,11 @@ public:
     // return the frames per second of the layer with the given sequence id.
     float getLayerFramerate(nsecs_t now, int32_t id) const;
 
+    // Returns whether there are active layers, and all of them update at a low cadence, e.g. a
+    // clock ticking every second or a blinking cursor. Such content does not need more than the
+    // idle refresh rate.
+    bool hasOnlyInfrequentUpdates(nsecs_t now) const;
+
     void attachChoreographer(int32_t layerId,
                              const sp<EventThreadConnection>& choreographerConnection);
 
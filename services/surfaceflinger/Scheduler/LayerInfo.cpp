@@ -68,6 +68,7 @@ void LayerInfo::setLastPresentTime(nsecs_t lastPresentTime, nsecs_t now, LayerUp
             if (mFrameTimes.size() > HISTORY_SIZE) {
                 mFrameTimes.pop_front();
             }
+            mAverageFrameTime.reset();
             break;
     }
 }
@@ -172,6 +173,14 @@ bool LayerInfo::hasEnoughDataForHeuristic() const {
 }
 
 std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
+    const bool hasReportedRefreshRate = mLastRefreshRate.reported.isValid();
+    if (!mAverageFrameTime || mAverageFrameTime->hasReportedRefreshRate != hasReportedRefreshRate) {
+        mAverageFrameTime = {hasReportedRefreshRate, computeAverageFrameTime()};
+    }
+    return mAverageFrameTime->value;
+}
+
+std::optional<nsecs_t> LayerInfo::computeAverageFrameTime() const {
     // Ignore frames captured during a mode change
     const bool isDuringModeChange =
             std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
@@ -187,6 +187,7 @@ public:
     void clearHistory(nsecs_t now) {
         onLayerInactive(now);
         mFrameTimes.clear();
+        mAverageFrameTime.reset();
     }
 
 private:
@@ -264,7 +265,10 @@ private:
     bool isAnimating(nsecs_t now) const;
     bool hasEnoughDataForHeuristic() const;
     std::optional<Fps> calculateRefreshRateIfPossible(const RefreshRateSelector&, nsecs_t now);
+    // Returns the average frame time of mFrameTimes, which is only recomputed once new frame
+    // times are recorded.
     std::optional<nsecs_t> calculateAverageFrameTime() const;
+    std::optional<nsecs_t> computeAverageFrameTime() const;
     bool isFrameTimeValid(const FrameTimeData&) const;
 
     const std::string mName;
@@ -288,6 +292,15 @@ private:
     RefreshRateHeuristicData mLastRefreshRate;
 
     std::deque<FrameTimeData> mFrameTimes;
+
+    // The last result of computeAverageFrameTime, which also depends on whether a refresh rate
+    // was reported when present times are missing. Reset whenever mFrameTimes changes.
+    struct AverageFrameTime {
+        bool hasReportedRefreshRate;
+        std::optional<nsecs_t> value;
+    };
+    mutable std::optional<AverageFrameTime> mAverageFrameTime;
+
     std::chrono::time_point<std::chrono::steady_clock> mFrameTimeValidSince =
             std::chrono::steady_clock::now();
     static constexpr size_t HISTORY_SIZE = RefreshRateHistory::HISTORY_SIZE;
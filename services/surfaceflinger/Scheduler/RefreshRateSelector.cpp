@@ -396,9 +396,11 @@ auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement
 
     if (mGetRankedFrameRatesCache &&
         mGetRankedFrameRatesCache->arguments == std::make_pair(layers, signals)) {
+        mRankedFrameRatesCacheStats.hits++;
         return mGetRankedFrameRatesCache->result;
     }
 
+    mRankedFrameRatesCacheStats.misses++;
     const auto result = getRankedFrameRatesLocked(layers, signals);
     mGetRankedFrameRatesCache = GetRankedFrameRatesCache{{layers, signals}, result};
     return result;
@@ -1063,6 +1065,7 @@ void RefreshRateSelector::updateDisplayModes(DisplayModes modes, DisplayModeId a
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
     mGetRankedFrameRatesCache.reset();
+    mRankedFrameRatesCacheStats = {};
 
     mDisplayModes = std::move(modes);
     const auto activeModeOpt = mDisplayModes.get(activeModeId);
@@ -1340,6 +1343,7 @@ void RefreshRateSelector::dump(utils::Dumper& dumper) const {
     }
 
     dumper.dump("frameRateOverrideConfig"sv, *ftl::enum_name(mFrameRateOverrideConfig));
+    dumper.dump("rankedFrameRatesCache"sv, mRankedFrameRatesCacheStats.toString());
 
     dumper.dump("idleTimer"sv);
     {
@@ -1352,6 +1356,17 @@ void RefreshRateSelector::dump(utils::Dumper& dumper) const {
     }
 }
 
+std::string RefreshRateSelector::RankedFrameRatesCacheStats::toString() const {
+    const size_t total = hits + misses;
+    return base::StringPrintf("hits=%zu misses=%zu hitRate=%.1f%%", hits, misses,
+                              total ? 100.f * hits / total : 0.f);
+}
+
+auto RefreshRateSelector::getRankedFrameRatesCacheStats() const -> RankedFrameRatesCacheStats {
+    std::lock_guard lock(mLock);
+    return mRankedFrameRatesCacheStats;
+}
+
 std::chrono::milliseconds RefreshRateSelector::getIdleTimerTimeout() {
     return mConfig.idleTimerTimeout;
 }
@@ -393,6 +393,17 @@ public:
 
     void dump(utils::Dumper&) const EXCLUDES(mLock);
 
+    // How often getRankedFrameRates was answered from its cache since the display modes were last
+    // updated.
+    struct RankedFrameRatesCacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+
+        std::string toString() const;
+    };
+
+    RankedFrameRatesCacheStats getRankedFrameRatesCacheStats() const EXCLUDES(mLock);
+
     std::chrono::milliseconds getIdleTimerTimeout();
 
 private:
@@ -507,6 +518,7 @@ private:
         RankedFrameRates result;
     };
     mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
+    mutable RankedFrameRatesCacheStats mRankedFrameRatesCacheStats GUARDED_BY(mLock);
 
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
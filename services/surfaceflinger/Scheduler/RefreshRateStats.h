@@ -69,10 +69,14 @@ public:
             return;
         }
         mTimeStats.incrementRefreshRateSwitches();
+        mSwitchCount++;
         flushTime();
         mCurrentRefreshRate = currRefreshRate;
     }
 
+    // Returns the number of refresh rate switches since construction.
+    size_t getSwitchCount() const { return mSwitchCount; }
+
     // Maps stringified refresh rate to total time spent in that mode.
     using TotalTimes = ftl::SmallMap<std::string, std::chrono::milliseconds, 3>;
 
@@ -109,6 +113,7 @@ public:
         for (const auto& [name, time] : const_cast<RefreshRateStats*>(this)->getTotalTimes()) {
             stream << name << ": " << getDateFormatFromMs(time) << '\n';
         }
+        stream << "+  Refresh rate switches: " << mSwitchCount << '\n';
         result.append(stream.str());
     }
 
@@ -161,6 +166,7 @@ private:
 
     ftl::SmallMap<Fps, std::chrono::milliseconds, 2, FpsApproxEqual> mFpsTotalTimes;
     std::chrono::milliseconds mScreenOffTime = std::chrono::milliseconds::zero();
+    size_t mSwitchCount = 0;
 
     nsecs_t mPreviousRecordedTime = systemTime();
 };
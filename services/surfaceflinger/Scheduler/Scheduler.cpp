@@ -545,7 +545,14 @@ void Scheduler::chooseRefreshRateForContent() {
 
     ATRACE_CALL();
 
-    LayerHistory::Summary summary = mLayerHistory.summarize(*selectorPtr, systemTime());
+    const nsecs_t now = systemTime();
+    LayerHistory::Summary summary = mLayerHistory.summarize(*selectorPtr, now);
+
+    if (mIdleTimerResetSuppressed && !mLayerHistory.hasOnlyInfrequentUpdates(now) &&
+        mIdleTimerResetSuppressed.exchange(false)) {
+        ATRACE_INT("SuppressedIdleTimerReset", 0);
+        applyPolicy(&Policy::idleTimer, TimerState::Reset);
+    }
     applyPolicy(&Policy::contentRequirements, std::move(summary));
 }
 
@@ -640,6 +647,20 @@ void Scheduler::kernelIdleTimerCallback(TimerState state) {
 }
 
 void Scheduler::idleTimerCallback(TimerState state) {
+    if (mFeatures.test(Feature::kAdaptiveIdleTimer)) {
+        if (state == TimerState::Reset && mLayerHistory.hasOnlyInfrequentUpdates(systemTime())) {
+            // Content updating at a low cadence would otherwise switch to a higher refresh rate
+            // and back on every update. Stay idle until chooseRefreshRateForContent sees frequent
+            // updates, or until the timer expires again.
+            mIdleTimerResetSuppressed = true;
+            mSuppressedIdleTimerResets++;
+            ATRACE_INT("SuppressedIdleTimerReset", 1);
+            return;
+        }
+        mIdleTimerResetSuppressed = false;
+        ATRACE_INT("SuppressedIdleTimerReset", 0);
+    }
+
     applyPolicy(&Policy::idleTimer, state);
     ATRACE_INT("ExpiredIdleTimer", static_cast<int>(state));
 }
@@ -681,9 +702,22 @@ void Scheduler::dump(utils::Dumper& dumper) const {
             dumper.dump("pacesetterDisplayId"sv, mPacesetterDisplayId);
         }
         dumper.dump("layerHistory"sv, mLayerHistory.dump());
+        if (mFeatures.test(Feature::kAdaptiveIdleTimer)) {
+            dumper.dump("suppressedIdleTimerResets"sv, mSuppressedIdleTimerResets.load());
+        }
         dumper.dump("touchTimer"sv, mTouchTimer.transform(&OneShotTimer::interval));
         dumper.dump("displayPowerTimer"sv, mDisplayPowerTimer.transform(&OneShotTimer::interval));
     }
+    {
+        utils::Dumper::Section section(dumper, "RankedFrameRatesCache"sv);
+
+        std::scoped_lock lock(mDisplayLock);
+        ftl::FakeGuard guard(kMainThreadContext);
+        for (const auto& [id, display] : mDisplays) {
+            dumper.dump(to_string(id),
+                        display.selectorPtr->getRankedFrameRatesCacheStats().toString());
+        }
+    }
 
     mFrameRateOverrideMappings.dump(dumper);
     dumper.eol();
@@ -424,6 +424,11 @@ private:
     // Used to choose refresh rate if content detection is enabled.
     LayerHistory mLayerHistory;
 
+    // With Feature::kAdaptiveIdleTimer, whether the last reset of the idle timer was not applied
+    // to the policy, because the content only had infrequent updates.
+    std::atomic_bool mIdleTimerResetSuppressed = false;
+    std::atomic<size_t> mSuppressedIdleTimerResets = 0;
+
     // Timer used to monitor touch events.
     ftl::Optional<OneShotTimer> mTouchTimer;
     // Timer used to monitor display power mode.
@@ -256,11 +256,16 @@ void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
     std::optional<nsecs_t> min;
     std::optional<nsecs_t> targetVsync;
     std::optional<std::string_view> nextWakeupName;
-    for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
+    for (auto tokenIt = mScheduledCallbacks.begin(); tokenIt != mScheduledCallbacks.end();) {
+        const auto it = mCallbacks.find(*tokenIt);
+        LOG_ALWAYS_FATAL_IF(it == mCallbacks.end(), "Scheduled callback was unregistered");
+
         auto& callback = it->second;
         if (!callback->wakeupTime() && !callback->hasPendingWorkloadUpdate()) {
+            tokenIt = mScheduledCallbacks.erase(tokenIt);
             continue;
         }
+        tokenIt++;
 
         if (it != skipUpdateIt) {
             callback->update(*mTracker, now);
@@ -298,8 +303,8 @@ void VSyncDispatchTimerQueue::timerCallback() {
         std::lock_guard lock(mMutex);
         auto const now = mTimeKeeper->now();
         mLastTimerCallback = now;
-        for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
-            auto& callback = it->second;
+        for (const auto token : mScheduledCallbacks) {
+            auto& callback = mCallbacks.at(token);
             auto const wakeupTime = callback->wakeupTime();
             if (!wakeupTime) {
                 continue;
@@ -345,6 +350,7 @@ void VSyncDispatchTimerQueue::unregisterCallback(CallbackToken token) {
         if (it != mCallbacks.end()) {
             entry = it->second;
             mCallbacks.erase(it);
+            mScheduledCallbacks.erase(token);
         }
     }
 
@@ -367,6 +373,7 @@ ScheduleResult VSyncDispatchTimerQueue::scheduleLocked(CallbackToken token,
     }
     auto& callback = it->second;
     auto const now = mTimeKeeper->now();
+    mScheduledCallbacks.insert(token);
 
     /* If the timer thread will run soon, we'll apply this work update via the callback
      * timer recalculation to avoid cancelling a callback that is about to fire. */
@@ -22,6 +22,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <android-base/thread_annotations.h>
 
@@ -156,6 +157,11 @@ private:
     size_t mCallbackToken GUARDED_BY(mMutex) = 0;
 
     CallbackMap mCallbacks GUARDED_BY(mMutex);
+
+    // The callbacks that were scheduled since they last fired, and so may be armed or have a
+    // pending workload update. Only these need to be visited when the timer fires or is rearmed.
+    // Entries that were cancelled or have fired are pruned lazily on the next rearm.
+    std::unordered_set<CallbackToken> mScheduledCallbacks GUARDED_BY(mMutex);
     nsecs_t mIntendedWakeupTime GUARDED_BY(mMutex) = kInvalidTime;
 
     // For debugging purposes
@@ -33,6 +33,7 @@
 #include <cutils/properties.h>
 #include <ftl/concat.h>
 #include <gui/TraceUtils.h>
+#include <scheduler/VsyncModel.h>
 #include <utils/Log.h>
 
 #include "RefreshRateSelector.h"
@@ -153,8 +154,6 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     //
     // intercept = mean(Y) - slope * mean(X)
     //
-    std::vector<nsecs_t> vsyncTS(numSamples);
-    std::vector<nsecs_t> ordinals(numSamples);
 
     // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
     const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
@@ -165,44 +164,16 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     // fixed-point arithmetic.
     constexpr int64_t kScalingFactor = 1000;
 
-    nsecs_t meanTS = 0;
-    nsecs_t meanOrdinal = 0;
-
-    for (size_t i = 0; i < numSamples; i++) {
-        const auto timestamp = mTimestamps[i] - oldestTS;
-        vsyncTS[i] = timestamp;
-        meanTS += timestamp;
-
-        const auto ordinal = currentPeriod == 0
-                ? 0
-                : (vsyncTS[i] + currentPeriod / 2) / currentPeriod * kScalingFactor;
-        ordinals[i] = ordinal;
-        meanOrdinal += ordinal;
-    }
-
-    meanTS /= numSamples;
-    meanOrdinal /= numSamples;
-
-    for (size_t i = 0; i < numSamples; i++) {
-        vsyncTS[i] -= meanTS;
-        ordinals[i] -= meanOrdinal;
-    }
-
-    nsecs_t top = 0;
-    nsecs_t bottom = 0;
-    for (size_t i = 0; i < numSamples; i++) {
-        top += vsyncTS[i] * ordinals[i];
-        bottom += ordinals[i] * ordinals[i];
-    }
-
-    if (CC_UNLIKELY(bottom == 0)) {
+    const auto fit =
+            fitVsyncModel(mTimestamps.data(), numSamples, oldestTS, currentPeriod, kScalingFactor);
+    if (CC_UNLIKELY(!fit)) {
         it->second = {mIdealPeriod, 0};
         clearTimestamps();
         return false;
     }
 
-    nsecs_t const anticipatedPeriod = top * kScalingFactor / bottom;
-    nsecs_t const intercept = meanTS - (anticipatedPeriod * meanOrdinal / kScalingFactor);
+    nsecs_t const anticipatedPeriod = fit->slope;
+    nsecs_t const intercept = fit->intercept;
 
     auto const percent = std::abs(anticipatedPeriod - mIdealPeriod) * kMaxPercent / mIdealPeriod;
     if (percent >= kOutlierTolerancePercent) {
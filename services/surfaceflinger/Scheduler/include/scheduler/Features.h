@@ -27,6 +27,7 @@ enum class Feature : std::uint8_t {
     kKernelIdleTimer = 0b10,
     kContentDetection = 0b100,
     kTracePredictedVsync = 0b1000,
+    kAdaptiveIdleTimer = 0b10000,
 };
 
 using FeatureFlags = ftl::Flags<Feature>;
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <utils/Timers.h>
+
+namespace android::scheduler {
+
+// The result of a simple linear regression of vsync timestamps over their ordinals, with the
+// intercept relative to the origin passed to fitVsyncModel.
+struct VsyncModelFit {
+    nsecs_t slope;
+    nsecs_t intercept;
+};
+
+// Fits the vsync timestamps to their ordinals, i.e. their distance from the origin snapped to the
+// given period. The ordinals are scaled up by ordinalScale for fixed-point precision of their mean.
+//
+// The fit is computed in a single pass over the timestamps from running sums, without allocating,
+// and matches the integer arithmetic of the textbook two-pass formulation exactly. Returns nullopt
+// if the ordinals are degenerate, e.g. all timestamps snap to the same vsync.
+std::optional<VsyncModelFit> fitVsyncModel(const nsecs_t* timestamps, size_t count, nsecs_t origin,
+                                           nsecs_t period, int64_t ordinalScale);
+
+} // namespace android::scheduler
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <scheduler/VsyncModel.h>
+
+namespace android::scheduler {
+
+std::optional<VsyncModelFit> fitVsyncModel(const nsecs_t* timestamps, size_t count, nsecs_t origin,
+                                           nsecs_t period, int64_t ordinalScale) {
+    if (count == 0) {
+        return std::nullopt;
+    }
+
+    // Accumulate the raw sums in one pass. The loop body has no dependency between iterations
+    // other than the accumulators, so the compiler is free to unroll and vectorize it.
+    int64_t sumY = 0;
+    int64_t sumX = 0;
+    int64_t sumXY = 0;
+    int64_t sumXX = 0;
+    const nsecs_t halfPeriod = period / 2;
+    for (size_t i = 0; i < count; i++) {
+        const int64_t y = timestamps[i] - origin;
+        const int64_t x = period == 0 ? 0 : (y + halfPeriod) / period * ordinalScale;
+        sumY += y;
+        sumX += x;
+        sumXY += x * y;
+        sumXX += x * x;
+    }
+
+    // The means are truncated to match the fixed-point arithmetic of the two-pass formulation:
+    //
+    //   Sigma_i (X_i - mean(X)) * (Y_i - mean(Y))
+    //       = Sigma(XY) - mean(X) * Sigma(Y) - mean(Y) * Sigma(X) + n * mean(X) * mean(Y)
+    //
+    //   Sigma_i (X_i - mean(X)) ^ 2
+    //       = Sigma(XX) - 2 * mean(X) * Sigma(X) + n * mean(X) ^ 2
+    //
+    const auto n = static_cast<int64_t>(count);
+    const int64_t meanY = sumY / n;
+    const int64_t meanX = sumX / n;
+
+    const int64_t top = sumXY - meanX * sumY - meanY * sumX + n * meanX * meanY;
+    const int64_t bottom = sumXX - 2 * meanX * sumX + n * meanX * meanX;
+    if (bottom == 0) {
+        return std::nullopt;
+    }
+
+    const nsecs_t slope = top * ordinalScale / bottom;
+    const nsecs_t intercept = meanY - (slope * meanX / ordinalScale);
+    return VsyncModelFit{slope, intercept};
+}
+
+} // namespace android::scheduler
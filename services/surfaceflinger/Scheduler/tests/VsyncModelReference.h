@@ -0,0 +1,81 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <scheduler/VsyncModel.h>
+
+namespace android::scheduler::test {
+
+// The two-pass formulation of the vsync model fit that VSyncPredictor used before fitVsyncModel,
+// kept as a reference for tests and benchmarks.
+inline std::optional<VsyncModelFit> fitVsyncModelTwoPass(const nsecs_t* timestamps, size_t count,
+                                                         nsecs_t origin, nsecs_t period,
+                                                         int64_t ordinalScale) {
+    std::vector<nsecs_t> vsyncTS(count);
+    std::vector<nsecs_t> ordinals(count);
+
+    nsecs_t meanTS = 0;
+    nsecs_t meanOrdinal = 0;
+    for (size_t i = 0; i < count; i++) {
+        vsyncTS[i] = timestamps[i] - origin;
+        meanTS += vsyncTS[i];
+
+        ordinals[i] = period == 0 ? 0 : (vsyncTS[i] + period / 2) / period * ordinalScale;
+        meanOrdinal += ordinals[i];
+    }
+
+    meanTS /= static_cast<nsecs_t>(count);
+    meanOrdinal /= static_cast<nsecs_t>(count);
+
+    nsecs_t top = 0;
+    nsecs_t bottom = 0;
+    for (size_t i = 0; i < count; i++) {
+        const nsecs_t y = vsyncTS[i] - meanTS;
+        const nsecs_t x = ordinals[i] - meanOrdinal;
+        top += y * x;
+        bottom += x * x;
+    }
+
+    if (bottom == 0) {
+        return std::nullopt;
+    }
+
+    const nsecs_t slope = top * ordinalScale / bottom;
+    return VsyncModelFit{slope, meanTS - (slope * meanOrdinal / ordinalScale)};
+}
+
+// Generates vsync timestamps at the given period, with a deterministic jitter of up to
+// +/- maxJitter.
+inline std::vector<nsecs_t> generateVsyncTimestamps(size_t count, nsecs_t period,
+                                                    nsecs_t maxJitter) {
+    std::vector<nsecs_t> timestamps(count);
+    uint32_t state = 0x2545F491;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const nsecs_t jitter =
+                maxJitter == 0 ? 0 : static_cast<nsecs_t>(state % (2 * maxJitter + 1)) - maxJitter;
+        timestamps[i] = 1'000'000'000 + static_cast<nsecs_t>(i) * period + jitter;
+    }
+    return timestamps;
+}
+
+} // namespace android::scheduler::test
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <gtest/gtest.h>
+
+#include <scheduler/VsyncModel.h>
+
+#include "VsyncModelReference.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr int64_t kOrdinalScale = 1000;
+constexpr nsecs_t kPeriod = 8'333'333;
+
+TEST(VsyncModelTest, fitsPerfectLine) {
+    const auto timestamps = test::generateVsyncTimestamps(20, kPeriod, 0);
+    const auto fit = fitVsyncModel(timestamps.data(), timestamps.size(), timestamps.front(),
+                                   kPeriod, kOrdinalScale);
+    ASSERT_TRUE(fit);
+    EXPECT_EQ(kPeriod, fit->slope);
+    EXPECT_EQ(0, fit->intercept);
+}
+
+TEST(VsyncModelTest, degenerateOrdinals) {
+    const nsecs_t timestamps[] = {1000, 1001, 1002};
+    EXPECT_FALSE(fitVsyncModel(timestamps, std::size(timestamps), 1000, kPeriod, kOrdinalScale));
+    EXPECT_FALSE(fitVsyncModel(timestamps, std::size(timestamps), 1000, 0, kOrdinalScale));
+    EXPECT_FALSE(fitVsyncModel(timestamps, 0, 1000, kPeriod, kOrdinalScale));
+}
+
+TEST(VsyncModelTest, matchesTwoPassFit) {
+    for (const size_t count : {2u, 6u, 20u, 64u, 256u}) {
+        for (const nsecs_t jitter : {0, 1000, 500'000}) {
+            const auto timestamps = test::generateVsyncTimestamps(count, kPeriod, jitter);
+            const nsecs_t origin = *std::min_element(timestamps.begin(), timestamps.end());
+
+            const auto expected = test::fitVsyncModelTwoPass(timestamps.data(), count, origin,
+                                                             kPeriod, kOrdinalScale);
+            const auto actual =
+                    fitVsyncModel(timestamps.data(), count, origin, kPeriod, kOrdinalScale);
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (expected) {
+                EXPECT_EQ(expected->slope, actual->slope) << count << " " << jitter;
+                EXPECT_EQ(expected->intercept, actual->intercept) << count << " " << jitter;
+            }
+        }
+    }
+}
+
+} // namespace
+} // namespace android::scheduler
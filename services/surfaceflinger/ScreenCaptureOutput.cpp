@@ -76,6 +76,8 @@ renderengine::DisplaySettings ScreenCaptureOutput::generateClientCompositionDisp
     auto clientCompositionDisplay =
             compositionengine::impl::Output::generateClientCompositionDisplaySettings();
     clientCompositionDisplay.clip = mRenderArea.getSourceCrop();
+    // Let the frames being composited go ahead of the capture.
+    clientCompositionDisplay.lowPriority = true;
     return clientCompositionDisplay;
 }
 
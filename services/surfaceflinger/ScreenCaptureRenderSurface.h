@@ -41,6 +41,12 @@ public:
         mRenderFence = sp<Fence>::make(readyFence.release());
     }
 
+    void cancelBuffer() override {}
+
+    void setBufferDamage(const Region&) override {}
+
+    Region getBufferRepaintRegion(const Region&) const override { return Region::INVALID_REGION; }
+
     const sp<Fence>& getClientTargetAcquireFence() const override { return mRenderFence; }
 
     bool supportsCompositionStrategyPrediction() const override { return false; }
@@ -63,6 +69,8 @@ public:
 
     status_t beginFrame(bool /* mustRecompose */) override { return OK; }
 
+    void setFrameDamage(const Region&) override {}
+
     void prepareFrame(bool /* usesClientComposition */, bool /* usesDeviceComposition */) override {
     }
 
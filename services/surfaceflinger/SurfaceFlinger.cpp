@@ -108,6 +108,7 @@
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -458,6 +459,30 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     property_get("debug.sf.predict_hwc_composition_strategy", value, "1");
     mPredictCompositionStrategy = atoi(value);
 
+    mPartialClientComposition =
+            base::GetBoolProperty("debug.sf.enable_partial_client_composition"s, false);
+
+    mMultithreadedPresent = base::GetBoolProperty("debug.sf.multithreaded_present"s, false);
+    mParallelLayerUpdateThreshold = static_cast<size_t>(
+            base::GetUintProperty<uint32_t>("debug.sf.parallel_layer_update_threshold"s, 0));
+    mSkipCleanLayerSubtrees =
+            base::GetBoolProperty("debug.sf.skip_clean_layer_subtrees"s, false);
+    mAcquireFenceWaitTimeout = std::chrono::microseconds(
+            base::GetIntProperty("debug.sf.acquire_fence_wait_us"s, 0));
+    mOffMainThreadScreenshots =
+            base::GetBoolProperty("debug.sf.off_main_thread_screenshots"s, false);
+    mSkipRedundantFollowerFrames =
+            base::GetBoolProperty("debug.sf.skip_redundant_follower_frames"s, false);
+
+    std::unordered_set<int> transactionPriorityUids;
+    for (const auto& uid :
+         base::Split(base::GetProperty("debug.sf.transaction_priority_uids"s, ""), ",")) {
+        if (int value; base::ParseInt(uid, &value)) {
+            transactionPriorityUids.insert(value);
+        }
+    }
+    mTransactionHandler.setPriorityUids(std::move(transactionPriorityUids));
+
     property_get("debug.sf.treat_170m_as_sRGB", value, "0");
     mTreat170mAsSrgb = atoi(value);
 
@@ -827,6 +852,20 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
     addTransactionReadyFilters();
     Mutex::Autolock lock(mStateLock);
 
+    const TimePoint initStart = TimePoint::now();
+    const auto logInitStage = [](const char* stage, TimePoint start) {
+        ALOGI("%s took %.2f ms", stage, ticks<std::milli, float>(TimePoint::now() - start));
+    };
+
+    // Connecting to the HWC service does not depend on RenderEngine, so it runs on another thread
+    // while RenderEngine is created on this one. The HWC callback is only set once joined.
+    auto hwComposerFuture = std::async(std::launch::async, [this, logInitStage] {
+        const TimePoint start = TimePoint::now();
+        auto hwComposer = getFactory().createHWComposer(mHwcServiceName);
+        logInitStage("Connecting to HWC", start);
+        return hwComposer;
+    });
+
     // Get a RenderEngine for the given display / config (can't fail)
     // TODO(b/77156734): We need to stop casting and use HAL types when possible.
     // Sending maxFrameBufferAcquiredBuffers as the cache size is tightly tuned to single-display.
@@ -840,14 +879,19 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
                            .setContextPriority(
                                    useContextPriority
                                            ? renderengine::RenderEngine::ContextPriority::REALTIME
-                                           : renderengine::RenderEngine::ContextPriority::MEDIUM);
+                                           : renderengine::RenderEngine::ContextPriority::MEDIUM)
+                           .setShaderCachePath(
+                                   base::GetProperty("debug.sf.renderengine_shader_cache_path"s,
+                                                     ""s));
     if (auto type = chooseRenderEngineTypeViaSysProp()) {
         builder.setRenderEngineType(type.value());
     }
+    TimePoint stageStart = TimePoint::now();
     mRenderEngine = renderengine::RenderEngine::create(builder.build());
     mCompositionEngine->setRenderEngine(mRenderEngine.get());
     mMaxRenderTargetSize =
             std::min(getRenderEngine().getMaxTextureSize(), getRenderEngine().getMaxViewportDims());
+    logInitStage("Creating RenderEngine", stageStart);
 
     // Set SF main policy after initializing RenderEngine which has its own policy.
     if (!SetTaskProfiles(0, {"SFMainPolicy"})) {
@@ -855,17 +899,20 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
     }
 
     mCompositionEngine->setTimeStats(mTimeStats);
-    mCompositionEngine->setHwComposer(getFactory().createHWComposer(mHwcServiceName));
+    mCompositionEngine->setHwComposer(hwComposerFuture.get());
     mCompositionEngine->getHwComposer().setCallback(*this);
     ClientCache::getInstance().setRenderEngine(&getRenderEngine());
 
     enableLatchUnsignaledConfig = getLatchUnsignaledConfig();
 
     // Process hotplug for displays connected at boot.
+    stageStart = TimePoint::now();
     LOG_ALWAYS_FATAL_IF(!configureLocked(),
                         "Initial display configuration failed: HWC did not hotplug");
+    logInitStage("Configuring displays", stageStart);
 
     // Commit primary display.
+    stageStart = TimePoint::now();
     sp<const DisplayDevice> display;
     if (const auto indexOpt = mCurrentState.getDisplayIndex(getPrimaryDisplayIdLocked())) {
         const auto& displays = mCurrentState.displays;
@@ -891,6 +938,7 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
 
     // Commit secondary display(s).
     processDisplayChangesLocked();
+    logInitStage("Committing displays", stageStart);
 
     // initialize our drawing state
     mDrawingState = mCurrentState;
@@ -941,7 +989,7 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
 
     mQtiSFExtnIntf->qtiStartUnifiedDraw();
     /* QTI_END */
-    ALOGV("Done initializing");
+    logInitStage("Initializing SurfaceFlinger", initStart);
 }
 
 void SurfaceFlinger::readPersistentProperties() {
@@ -2340,7 +2388,8 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, frontend::Update& upd
                      .forceFullDamage = mForceFullDamage,
                      .supportedLayerGenericMetadata =
                              getHwComposer().getSupportedLayerGenericMetadata(),
-                     .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap()};
+                     .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap(),
+                     .skipCleanSubtrees = mSkipCleanLayerSubtrees};
         mLayerSnapshotBuilder.update(args);
     }
 
@@ -2355,6 +2404,14 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, frontend::Update& upd
     outTransactionsAreEmpty = mLayerLifecycleManager.getGlobalChanges().get() == 0;
     mustComposite |= mLayerLifecycleManager.getGlobalChanges().get() != 0;
 
+    if (mOffMainThreadScreenshots &&
+        (mLayerLifecycleManager.getGlobalChanges().get() != 0 || mFrontEndDisplayInfosChanged)) {
+        publishLayerSnapshotsForScreenshots();
+    }
+    if (mLayerLifecycleManager.getGlobalChanges().get() != 0 || mFrontEndDisplayInfosChanged) {
+        publishLayerDumpState();
+    }
+
     bool newDataLatched = false;
     if (!mLegacyFrontEndEnabled) {
         ATRACE_NAME("DisplayCallbackAndStatsUpdates");
@@ -2542,6 +2599,7 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
     mPowerHintSessionEnabled = mPowerAdvisor->usePowerHintSession() && activeDisplay &&
             activeDisplay->getPowerMode() == hal::PowerMode::ON;
     if (mPowerHintSessionEnabled) {
+        mPowerAdvisor->hintUpcomingFrameWork(mTransactionHandler.getPendingTransactionCount());
         mPowerAdvisor->setCommitStart(frameTime);
         mPowerAdvisor->setExpectedPresentTime(mExpectedPresentTime);
 
@@ -2574,7 +2632,11 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
         const bool flushTransactions = clearTransactionFlags(eTransactionFlushNeeded);
         frontend::Update updates;
         if (flushTransactions) {
-            updates = flushLifecycleUpdates();
+            {
+                FramePhaseProfiler::ScopedPhase phase(mFramePhaseProfiler,
+                                                      FramePhaseProfiler::Phase::TransactionFlush);
+                updates = flushLifecycleUpdates();
+            }
             if (mTransactionTracing) {
                 mTransactionTracing->addCommittedTransactions(vsyncId.value, frameTime.ns(),
                                                               updates, mFrontEndDisplayInfos,
@@ -2582,13 +2644,17 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
             }
         }
         bool transactionsAreEmpty;
-        if (mLegacyFrontEndEnabled) {
-            mustComposite |= updateLayerSnapshotsLegacy(vsyncId, updates, flushTransactions,
-                                                        transactionsAreEmpty);
-        }
-        if (mLayerLifecycleManagerEnabled) {
-            mustComposite |=
-                    updateLayerSnapshots(vsyncId, updates, flushTransactions, transactionsAreEmpty);
+        {
+            FramePhaseProfiler::ScopedPhase phase(mFramePhaseProfiler,
+                                                  FramePhaseProfiler::Phase::SnapshotUpdate);
+            if (mLegacyFrontEndEnabled) {
+                mustComposite |= updateLayerSnapshotsLegacy(vsyncId, updates, flushTransactions,
+                                                            transactionsAreEmpty);
+            }
+            if (mLayerLifecycleManagerEnabled) {
+                mustComposite |= updateLayerSnapshots(vsyncId, updates, flushTransactions,
+                                                      transactionsAreEmpty);
+            }
         }
 
         if (transactionFlushNeeded()) {
@@ -2617,7 +2683,11 @@ bool SurfaceFlinger::commit(TimePoint frameTime, VsyncId vsyncId, TimePoint expe
     }
 
     updateCursorAsync();
-    updateInputFlinger(vsyncId, frameTime);
+    {
+        FramePhaseProfiler::ScopedPhase phase(mFramePhaseProfiler,
+                                              FramePhaseProfiler::Phase::InputUpdate);
+        updateInputFlinger(vsyncId, frameTime);
+    }
 
     if (mLayerTracingEnabled && !mLayerTracing.flagIsSet(LayerTracing::TRACE_COMPOSITION)) {
         // This will block and tracing should only be enabled for debugging.
@@ -2641,13 +2711,16 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     compositionengine::CompositionRefreshArgs refreshArgs;
     const auto& displays = FTL_FAKE_GUARD(mStateLock, mDisplays);
     refreshArgs.outputs.reserve(displays.size());
-    std::vector<DisplayId> displayIds;
+    auto& displayIds = mCompositeDisplayIds;
+    displayIds.clear();
     for (const auto& [_, display] : displays) {
         bool dropFrame = false;
         if (display->isVirtual()) {
             Fps refreshRate = display->getAdjustedRefreshRate();
             using fps_approx_ops::operator>;
             dropFrame = (refreshRate > 0_Hz) && !mScheduler->isVsyncInPhase(frameTime, refreshRate);
+        } else if (mSkipRedundantFollowerFrames) {
+            dropFrame = isRedundantFollowerFrame(*display);
         }
         if (!dropFrame) {
             refreshArgs.outputs.push_back(display->getCompositionDisplay());
@@ -2723,6 +2796,8 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     refreshArgs.scheduledFrameTime = mScheduler->getScheduledFrameTime();
     refreshArgs.expectedPresentTime = mExpectedPresentTime.ns();
     refreshArgs.hasTrustedPresentationListener = mNumTrustedPresentationListeners > 0;
+    refreshArgs.multithreadedPresent = mMultithreadedPresent;
+    refreshArgs.parallelLayerUpdateThreshold = mParallelLayerUpdateThreshold;
 
     // Store the present time just before calling to the composition engine so we could notify
     // the scheduler.
@@ -2739,7 +2814,11 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     mQtiSFExtnIntf->qtiDumpDrawCycle(true);
     /* QTI_END */
 
-    mCompositionEngine->present(refreshArgs);
+    {
+        FramePhaseProfiler::ScopedPhase phase(mFramePhaseProfiler,
+                                              FramePhaseProfiler::Phase::Composition);
+        mCompositionEngine->present(refreshArgs);
+    }
     moveSnapshotsFromCompositionArgs(refreshArgs, layers);
 
     for (auto [layer, layerFE] : layers) {
@@ -2773,7 +2852,11 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
         scheduleComposite(FrameHint::kNone);
     }
 
-    postComposition(presentTime);
+    {
+        FramePhaseProfiler::ScopedPhase phase(mFramePhaseProfiler,
+                                              FramePhaseProfiler::Phase::PostComposition);
+        postComposition(presentTime);
+    }
 
     const bool hadGpuComposited = mCompositionCoverage.test(CompositionCoverage::Gpu);
     mCompositionCoverage.clear();
@@ -2831,6 +2914,36 @@ void SurfaceFlinger::composite(TimePoint frameTime, VsyncId vsyncId)
     }
 }
 
+bool SurfaceFlinger::isRedundantFollowerFrame(const DisplayDevice& display) {
+    const auto displayId = display.getPhysicalId();
+    if (displayId == FTL_FAKE_GUARD(mStateLock, mActiveDisplayId)) {
+        return false;
+    }
+
+    const auto schedule = mScheduler->getVsyncSchedule(displayId);
+    if (!schedule) {
+        return false;
+    }
+
+    // A follower running slower than the pacesetter would present frames composited on
+    // consecutive pacesetter vsyncs on the same follower vsync, so only the last one is shown.
+    const auto vsyncTarget = TimePoint::fromNs(
+            schedule->getTracker().nextAnticipatedVSyncTimeFrom(mExpectedPresentTime.ns()));
+    const Duration halfPeriod = schedule->period() / 2;
+    if (const auto lastTargetOpt = mFollowerVsyncTargets.get(displayId)) {
+        const Duration distance = vsyncTarget - lastTargetOpt->get();
+        if (distance < halfPeriod && distance > -halfPeriod) {
+            ATRACE_FORMAT_INSTANT("Skipping follower %s", to_string(displayId).c_str());
+            // Make sure this frame's updates reach the follower on its next vsync.
+            scheduleComposite(FrameHint::kNone);
+            return true;
+        }
+    }
+
+    mFollowerVsyncTargets.emplace_or_replace(displayId, vsyncTarget);
+    return false;
+}
+
 void SurfaceFlinger::updateLayerGeometry() {
     ATRACE_CALL();
 
@@ -3063,8 +3176,16 @@ void SurfaceFlinger::postComposition(nsecs_t callTime) {
     mTransactionCallbackInvoker.sendCallbacks(false /* onCommitOnly */);
     mTransactionCallbackInvoker.clearCompletedTransactions();
 
-    mTimeStats->incrementTotalFrames();
-    mTimeStats->setPresentFenceGlobal(presentFenceTime);
+    // TimeStats only records the frame, so it does not need to hold up the main thread.
+    const size_t sfConnections = mScheduler->getEventThreadConnectionCount(mSfConnectionHandle);
+    const size_t appConnections = mScheduler->getEventThreadConnectionCount(mAppConnectionHandle);
+    BackgroundExecutor::getInstance().sendCallbacks(
+            {[timeStats = mTimeStats, presentFenceTime,
+              connectionCount = static_cast<int32_t>(sfConnections + appConnections)] {
+                timeStats->incrementTotalFrames();
+                timeStats->setPresentFenceGlobal(presentFenceTime);
+                timeStats->recordDisplayEventConnectionCount(connectionCount);
+            }});
 
     {
         ftl::FakeGuard guard(mStateLock);
@@ -3094,10 +3215,6 @@ void SurfaceFlinger::postComposition(nsecs_t callTime) {
     mQtiSFExtnIntf->qtiDumpDrawCycle(false);
     /* QTI_END */
 
-    const size_t sfConnections = mScheduler->getEventThreadConnectionCount(mSfConnectionHandle);
-    const size_t appConnections = mScheduler->getEventThreadConnectionCount(mAppConnectionHandle);
-    mTimeStats->recordDisplayEventConnectionCount(sfConnections + appConnections);
-
     /* QTI_BEGIN */
     mQtiSFExtnIntf->qtiUpdateSmomoState();
     /* QTI_END */
@@ -3153,8 +3270,11 @@ void SurfaceFlinger::postComposition(nsecs_t callTime) {
     // Even though ATRACE_INT64 already checks if tracing is enabled, it doesn't prevent the
     // side-effect of getTotalSize(), so we check that again here
     if (ATRACE_ENABLED()) {
-        // getTotalSize returns the total number of buffers that were allocated by SurfaceFlinger
-        ATRACE_INT64("Total Buffer Size", GraphicBufferAllocator::get().getTotalSize());
+        // getTotalSize returns the total number of buffers that were allocated by SurfaceFlinger.
+        // It takes the allocator lock, which buffer allocations on binder threads contend for.
+        BackgroundExecutor::getInstance().sendCallbacks({[] {
+            ATRACE_INT64("Total Buffer Size", GraphicBufferAllocator::get().getTotalSize());
+        }});
     }
 
     logFrameStats(presentTime);
@@ -3654,6 +3774,7 @@ void SurfaceFlinger::processDisplayRemoved(const wp<IBinder>& displayToken) {
         } else {
             dispatchDisplayHotplugEvent(display->getPhysicalId(), false);
             mScheduler->unregisterDisplay(display->getPhysicalId());
+            mFollowerVsyncTargets.erase(display->getPhysicalId());
         }
         /* QTI_BEGIN */
         mQtiSFExtnIntf->qtiDestroySmomoInstance(display);
@@ -4158,6 +4279,9 @@ void SurfaceFlinger::initScheduler(const sp<const DisplayDevice>& display) {
     if (base::GetBoolProperty("debug.sf.show_predicted_vsync"s, false)) {
         features |= Feature::kTracePredictedVsync;
     }
+    if (base::GetBoolProperty("debug.sf.adaptive_idle_timer"s, false)) {
+        features |= Feature::kAdaptiveIdleTimer;
+    }
     if (!base::GetBoolProperty("debug.sf.vsync_reactor_ignore_present_fences"s, false) &&
         !getHwComposer().hasCapability(Capability::PRESENT_FENCE_IS_NOT_RELIABLE)) {
         features |= Feature::kPresentFences;
@@ -4630,6 +4754,7 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
                 ready = TransactionReadiness::NotReadyUnsignaled;
             } else {
                 ready = TransactionReadiness::NotReady;
+                mTransactionHandler.onTransactionWaitingOnFence(s.bufferData->acquireFence);
                 auto& listener = s.bufferData->releaseBufferListener;
                 if (listener &&
                     (flushState.queueProcessTime - transaction.postTime) >
@@ -4818,6 +4943,12 @@ status_t SurfaceFlinger::setTransactionState(
             uncacheBufferIds.push_back(buffer->getId());
         }
     }
+    if (!uncacheBufferIds.empty()) {
+        // Release the textures retained by the erased entries, unless they are cached again.
+        static_cast<void>(mScheduler->scheduleDelayed(
+                [] { ClientCache::getInstance().releaseExpiredTextures(); },
+                ClientCache::kRetainedTextureTimeout.count()));
+    }
 
     std::vector<ResolvedComposerState> resolvedStates;
     resolvedStates.reserve(states.size());
@@ -5929,6 +6060,7 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
                 {"--displays"s, dumper(&SurfaceFlinger::dumpDisplays)},
                 {"--edid"s, argsDumper(&SurfaceFlinger::dumpRawDisplayIdentificationData)},
                 {"--events"s, dumper(&SurfaceFlinger::dumpEvents)},
+                {"--frame-phases"s, argsDumper(&SurfaceFlinger::dumpFramePhases)},
                 {"--frametimeline"s, argsDumper(&SurfaceFlinger::dumpFrameTimeline)},
                 {"--hwclayers"s, dumper(&SurfaceFlinger::dumpHwcLayersMinidumpLocked)},
                 {"--latency"s, argsDumper(&SurfaceFlinger::dumpStatsLocked)},
@@ -5937,17 +6069,33 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
                 {"--planner"s, argsDumper(&SurfaceFlinger::dumpPlannerInfo)},
                 {"--scheduler"s, dumper(&SurfaceFlinger::dumpScheduler)},
                 {"--timestats"s, protoDumper(&SurfaceFlinger::dumpTimeStats)},
+                {"--transaction-queues"s, argsDumper(&SurfaceFlinger::dumpTransactionQueues)},
                 {"--vsync"s, dumper(&SurfaceFlinger::dumpVsync)},
                 {"--wide-color"s, dumper(&SurfaceFlinger::dumpWideColorInfo)},
         };
 
         const auto flag = args.empty() ? ""s : std::string(String8(args[0]));
 
+        mLastDumpRequestTime = systemTime();
+        if (!asProto && dumpFromPublishedState(flag, args, result)) {
+            write(fd, result.c_str(), result.size());
+            return NO_ERROR;
+        }
+
         // Traversal of drawing state must happen on the main thread.
         // Otherwise, SortedVector may have shared ownership during concurrent
         // traversals, which can result in use-after-frees.
         std::string compositionLayers;
-        if (flag.size() == 0 && !asProto) {
+        const auto layerDumpState =
+                flag.size() == 0 && !asProto ? getPublishedLayerDumpState() : nullptr;
+        if (layerDumpState) {
+            StringAppendF(&compositionLayers, "Composition layers\n");
+            for (const auto& [layer, snapshot] : layerDumpState->visibleSnapshots) {
+                StringAppendF(&compositionLayers, "* Layer %p (%s)\n", layer,
+                              snapshot.name.c_str());
+                snapshot.dump(compositionLayers);
+            }
+        } else if (flag.size() == 0 && !asProto) {
             mScheduler
                 ->schedule([&] {
                     StringAppendF(&compositionLayers, "Composition layers\n");
@@ -6051,6 +6199,38 @@ void SurfaceFlinger::dumpStatsLocked(const DumpArgs& args, std::string& result)
     });
 }
 
+bool SurfaceFlinger::dumpFromPublishedState(const std::string& flag, const DumpArgs& args,
+                                            std::string& result) const {
+    if (flag != "--list" && flag != "--latency") {
+        return false;
+    }
+    const auto layerDumpState = getPublishedLayerDumpState();
+    if (!layerDumpState) {
+        return false;
+    }
+
+    if (flag == "--list") {
+        for (const auto& entry : layerDumpState->layers) {
+            StringAppendF(&result, "%s\n", entry.name.c_str());
+        }
+        return true;
+    }
+
+    // Only look up the display under the lock, since querying HWC may block.
+    const auto display = getDefaultDisplayDevice();
+    StringAppendF(&result, "%" PRId64 "\n", display ? display->getVsyncPeriodFromHWC() : 0);
+    if (args.size() < 2) return true;
+
+    const auto name = String8(args[1]);
+    for (const auto& entry : layerDumpState->layers) {
+        if (entry.name != name.c_str()) continue;
+        if (const auto layer = entry.layer.promote()) {
+            layer->dumpFrameStats(result);
+        }
+    }
+    return true;
+}
+
 void SurfaceFlinger::clearStatsLocked(const DumpArgs& args, std::string&) {
     const bool clearAll = args.size() < 2;
     const auto name = clearAll ? String8() : String8(args[1]);
@@ -6070,6 +6250,24 @@ void SurfaceFlinger::dumpFrameTimeline(const DumpArgs& args, std::string& result
     mFrameTimeline->parseArgs(args, result);
 }
 
+void SurfaceFlinger::dumpFramePhases(const DumpArgs& args, std::string& result) {
+    if (args.size() > 1 && args[1] == String16("-clear")) {
+        mFramePhaseProfiler.clear();
+        result.append("Frame phases cleared\n");
+        return;
+    }
+    mFramePhaseProfiler.dump(result);
+}
+
+void SurfaceFlinger::dumpTransactionQueues(const DumpArgs& args, std::string& result) {
+    if (args.size() > 1 && args[1] == String16("-clear")) {
+        mTransactionHandler.clearClientWaitStats();
+        result.append("Transaction queue stats cleared\n");
+        return;
+    }
+    mTransactionHandler.dump(result);
+}
+
 void SurfaceFlinger::logFrameStats(TimePoint now) {
     static TimePoint sTimestamp = now;
     if (now - sTimestamp < 30min) return;
@@ -6440,6 +6638,9 @@ void SurfaceFlinger::dumpAllLocked(const DumpArgs& args, const std::string& comp
     }
 
     StringAppendF(&result, "  transaction time: %f us\n", inTransactionDuration / 1000.0);
+    if (mLayerLifecycleManagerEnabled) {
+        mLayerSnapshotBuilder.dump(result);
+    }
 
     /*
      * Tracing state
@@ -6650,6 +6851,10 @@ status_t SurfaceFlinger::onTransact(uint32_t code, const Parcel& data, Parcel* r
         return error;
     }
 
+    if (code == SET_TRANSACTION_STATE) {
+        mTransactionHandler.recordTransactionParcelSize(data.dataSize());
+    }
+
     status_t err = BnSurfaceComposer::onTransact(code, data, reply, flags);
     if (err == UNKNOWN_TRANSACTION || err == PERMISSION_DENIED) {
         CHECK_INTERFACE(ISurfaceComposer, data, reply);
@@ -7450,17 +7655,40 @@ status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
         }
     }
 
-    RenderAreaFuture renderAreaFuture = ftl::defer([=] {
+    auto createRenderArea = [=] {
         return DisplayRenderArea::create(displayWeak, args.sourceCrop, reqSize, args.dataspace,
                                          args.useIdentityTransform, args.hintForSeamlessTransition,
                                          args.captureSecureLayers);
-    });
+    };
 
+    // Captures that don't exclude layers can be taken from the published layer snapshots, which
+    // keeps clients that capture continuously from taking time on the main thread every frame.
     GetLayerSnapshotsFunction getLayerSnapshots;
-    if (mLayerLifecycleManagerEnabled) {
+    bool offMainThread = false;
+    if (mOffMainThreadScreenshots && mLayerLifecycleManagerEnabled && excludeLayerIds.empty() &&
+        isRenderEngineThreaded()) {
+        mLastScreenshotRequestTime = systemTime();
+        getLayerSnapshots = getPublishedLayerSnapshotsForScreenshots(layerStack, args.uid);
+        offMainThread = getLayerSnapshots != nullptr;
+        if (!offMainThread) {
+            // Start publishing snapshots for the captures that follow.
+            static_cast<void>(mScheduler->schedule([this]() FTL_FAKE_GUARD(kMainThreadContext) {
+                publishLayerSnapshotsForScreenshots();
+            }));
+        }
+    }
+
+    RenderAreaFuture renderAreaFuture = offMainThread
+            ? ftl::defer([this, createRenderArea] {
+                  Mutex::Autolock lock(mStateLock);
+                  return createRenderArea();
+              })
+            : ftl::defer(createRenderArea);
+
+    if (!offMainThread && mLayerLifecycleManagerEnabled) {
         getLayerSnapshots =
                 getLayerSnapshotsForScreenshots(layerStack, args.uid, std::move(excludeLayerIds));
-    } else {
+    } else if (!offMainThread) {
         auto traverseLayers = [this, args, excludeLayerIds,
                                layerStack](const LayerVector::Visitor& visitor) {
             traverseLayersInLayerStack(layerStack, args.uid, std::move(excludeLayerIds), visitor);
@@ -7470,7 +7698,7 @@ status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
 
     auto future = captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, reqSize,
                                       args.pixelFormat, args.allowProtected, args.grayscale,
-                                      captureListener);
+                                      args.captureBuffer, offMainThread, captureListener);
     return fenceStatus(future.get());
 }
 
@@ -7517,10 +7745,11 @@ status_t SurfaceFlinger::captureDisplay(DisplayId displayId,
 
     constexpr bool kAllowProtected = false;
     constexpr bool kGrayscale = false;
+    constexpr bool kOffMainThread = false;
 
     auto future = captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, size,
                                       ui::PixelFormat::RGBA_8888, kAllowProtected, kGrayscale,
-                                      captureListener);
+                                      /*captureBuffer=*/nullptr, kOffMainThread, captureListener);
     return fenceStatus(future.get());
 }
 
@@ -7656,15 +7885,17 @@ status_t SurfaceFlinger::captureLayers(const LayerCaptureArgs& args,
         return BAD_VALUE;
     }
 
+    constexpr bool kOffMainThread = false;
     auto future = captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, reqSize,
                                       args.pixelFormat, args.allowProtected, args.grayscale,
-                                      captureListener);
+                                      args.captureBuffer, kOffMainThread, captureListener);
     return fenceStatus(future.get());
 }
 
 ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
         RenderAreaFuture renderAreaFuture, GetLayerSnapshotsFunction getLayerSnapshots,
         ui::Size bufferSize, ui::PixelFormat reqPixelFormat, bool allowProtected, bool grayscale,
+        const sp<GraphicBuffer>& captureBuffer, bool offMainThread,
         const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
 
@@ -7682,36 +7913,53 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
     const bool supportsProtected = getRenderEngine().supportsProtectedContent();
     bool hasProtectedLayer = false;
     if (allowProtected && supportsProtected) {
-        hasProtectedLayer = mScheduler
-                                    ->schedule([=]() {
-                                        bool protectedLayerFound = false;
-                                        auto layers = getLayerSnapshots();
-                                        for (auto& [layer, layerFe] : layers) {
-                                            protectedLayerFound |=
-                                                    (layerFe->mSnapshot->isVisible &&
-                                                     layerFe->mSnapshot->hasProtectedContent &&
-                       /* QTI_BEGIN */ !mQtiSFExtnIntf->qtiIsSecureCamera(layer->getBuffer()) &&
-                                       !mQtiSFExtnIntf->qtiIsSecureDisplay(layer->getBuffer())
-                                                                                 /* QTI_END */);
-                                        }
-                                        return protectedLayerFound;
-                                    })
-                                    .get();
+        auto findProtectedLayer = [=]() {
+            bool protectedLayerFound = false;
+            auto layers = getLayerSnapshots();
+            for (auto& [layer, layerFe] : layers) {
+                /* QTI_BEGIN */
+                const auto& externalTexture = layerFe->mSnapshot->externalTexture;
+                const sp<GraphicBuffer> layerBuffer = layer ? layer->getBuffer()
+                        : externalTexture                   ? externalTexture->getBuffer()
+                                                            : nullptr;
+                /* QTI_END */
+                protectedLayerFound |=
+                        (layerFe->mSnapshot->isVisible && layerFe->mSnapshot->hasProtectedContent &&
+                         /* QTI_BEGIN */ !mQtiSFExtnIntf->qtiIsSecureCamera(layerBuffer) &&
+                         !mQtiSFExtnIntf->qtiIsSecureDisplay(layerBuffer) /* QTI_END */);
+            }
+            return protectedLayerFound;
+        };
+        hasProtectedLayer = offMainThread ? findProtectedLayer()
+                                          : mScheduler->schedule(std::move(findProtectedLayer)).get();
     }
 
     /* QTI_BEGIN */
     mQtiSFExtnIntf->qtiHasProtectedLayer(&hasProtectedLayer);
     /* QTI_END */
 
+    const bool captureProtected = hasProtectedLayer && allowProtected && supportsProtected;
     const uint32_t usage = GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_RENDER |
             GRALLOC_USAGE_HW_TEXTURE |
-            (hasProtectedLayer && allowProtected && supportsProtected
-                     ? GRALLOC_USAGE_PROTECTED
-                     : GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
-    sp<GraphicBuffer> buffer =
-            getFactory().createGraphicBuffer(bufferSize.getWidth(), bufferSize.getHeight(),
-                                             static_cast<android_pixel_format>(reqPixelFormat),
-                                             1 /* layerCount */, usage, "screenshot");
+            (captureProtected ? GRALLOC_USAGE_PROTECTED
+                              : GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
+
+    // Render into the buffer provided by the client if it fits the capture.
+    const uint64_t requiredUsage =
+            GRALLOC_USAGE_HW_RENDER | (captureProtected ? GRALLOC_USAGE_PROTECTED : 0);
+    sp<GraphicBuffer> buffer;
+    if (captureBuffer && captureBuffer->getWidth() == static_cast<uint32_t>(bufferSize.width) &&
+        captureBuffer->getHeight() == static_cast<uint32_t>(bufferSize.height) &&
+        captureBuffer->getPixelFormat() == static_cast<PixelFormat>(reqPixelFormat) &&
+        (captureBuffer->getUsage() & requiredUsage) == requiredUsage) {
+        buffer = captureBuffer;
+    } else {
+        ALOGW_IF(captureBuffer, "%s: Capture buffer does not match the capture, allocating",
+                 __func__);
+        buffer = getFactory().createGraphicBuffer(bufferSize.getWidth(), bufferSize.getHeight(),
+                                                  static_cast<android_pixel_format>(reqPixelFormat),
+                                                  1 /* layerCount */, usage, "screenshot");
+    }
 
     const status_t bufferStatus = buffer->initCheck();
     if (bufferStatus != OK) {
@@ -7726,51 +7974,66 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
                                                  renderengine::impl::ExternalTexture::Usage::
                                                          WRITEABLE);
     return captureScreenCommon(std::move(renderAreaFuture), getLayerSnapshots, texture,
-                               false /* regionSampling */, grayscale, captureListener);
+                               false /* regionSampling */, grayscale, offMainThread,
+                               captureListener);
 }
 
 ftl::SharedFuture<FenceResult> SurfaceFlinger::captureScreenCommon(
         RenderAreaFuture renderAreaFuture, GetLayerSnapshotsFunction getLayerSnapshots,
         const std::shared_ptr<renderengine::ExternalTexture>& buffer, bool regionSampling,
-        bool grayscale, const sp<IScreenCaptureListener>& captureListener) {
+        bool grayscale, bool offMainThread, const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
 
     bool canCaptureBlackoutContent = hasCaptureBlackoutContentPermission();
 
-    auto future = mScheduler->schedule(
-            [=, renderAreaFuture = std::move(renderAreaFuture)]() FTL_FAKE_GUARD(
-                    kMainThreadContext) mutable -> ftl::SharedFuture<FenceResult> {
-                ScreenCaptureResults captureResults;
-                std::shared_ptr<RenderArea> renderArea = renderAreaFuture.get();
-                if (!renderArea) {
-                    ALOGW("Skipping screen capture because of invalid render area.");
-                    if (captureListener) {
-                        captureResults.fenceResult = base::unexpected(NO_MEMORY);
+    auto capture = [=, renderAreaFuture = std::move(renderAreaFuture)]() mutable
+            -> ftl::SharedFuture<FenceResult> {
+        ScreenCaptureResults captureResults;
+        std::shared_ptr<RenderArea> renderArea = renderAreaFuture.get();
+        if (!renderArea) {
+            ALOGW("Skipping screen capture because of invalid render area.");
+            if (captureListener) {
+                captureResults.fenceResult = base::unexpected(NO_MEMORY);
+                captureListener->onScreenCaptureCompleted(captureResults);
+            }
+            return ftl::yield<FenceResult>(base::unexpected(NO_ERROR)).share();
+        }
+
+        ftl::SharedFuture<FenceResult> renderFuture;
+        if (offMainThread) {
+            renderArea->render([&] {
+                renderFuture = renderScreenImplOffMainThread(renderArea, getLayerSnapshots, buffer,
+                                                             canCaptureBlackoutContent, grayscale,
+                                                             captureResults);
+            });
+        } else {
+            // Scheduled on the main thread below.
+            renderArea->render([&]() FTL_FAKE_GUARD(kMainThreadContext) {
+                renderFuture = renderScreenImpl(renderArea, getLayerSnapshots, buffer,
+                                                canCaptureBlackoutContent, regionSampling,
+                                                grayscale, captureResults);
+            });
+        }
+
+        if (captureListener) {
+            // Defer blocking on renderFuture back to the Binder thread.
+            return ftl::Future(std::move(renderFuture))
+                    .then([captureListener, captureResults = std::move(captureResults)](
+                                  FenceResult fenceResult) mutable -> FenceResult {
+                        captureResults.fenceResult = std::move(fenceResult);
                         captureListener->onScreenCaptureCompleted(captureResults);
-                    }
-                    return ftl::yield<FenceResult>(base::unexpected(NO_ERROR)).share();
-                }
+                        return base::unexpected(NO_ERROR);
+                    })
+                    .share();
+        }
+        return renderFuture;
+    };
 
-                ftl::SharedFuture<FenceResult> renderFuture;
-                renderArea->render([&]() FTL_FAKE_GUARD(kMainThreadContext) {
-                    renderFuture = renderScreenImpl(renderArea, getLayerSnapshots, buffer,
-                                                    canCaptureBlackoutContent, regionSampling,
-                                                    grayscale, captureResults);
-                });
+    if (offMainThread) {
+        return capture();
+    }
 
-                if (captureListener) {
-                    // Defer blocking on renderFuture back to the Binder thread.
-                    return ftl::Future(std::move(renderFuture))
-                            .then([captureListener, captureResults = std::move(captureResults)](
-                                          FenceResult fenceResult) mutable -> FenceResult {
-                                captureResults.fenceResult = std::move(fenceResult);
-                                captureListener->onScreenCaptureCompleted(captureResults);
-                                return base::unexpected(NO_ERROR);
-                            })
-                            .share();
-                }
-                return renderFuture;
-            });
+    auto future = mScheduler->schedule(std::move(capture));
 
     // Flatten nested futures.
     auto chain = ftl::Future(std::move(future)).then([](ftl::SharedFuture<FenceResult> future) {
@@ -7788,6 +8051,86 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenImpl(
     ATRACE_CALL();
 
     auto layers = getLayerSnapshots();
+    auto presentFuture = renderScreenLayers(std::move(renderArea), layers, buffer,
+                                            canCaptureBlackoutContent, regionSampling, grayscale,
+                                            captureResults);
+
+    for (auto& [layer, layerFE] : layers) {
+        layer->onLayerDisplayed(getCaptureReleaseFence(presentFuture, std::move(layerFE)),
+                                ui::INVALID_LAYER_STACK);
+    }
+
+    return presentFuture;
+}
+
+ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenImplOffMainThread(
+        std::shared_ptr<const RenderArea> renderArea, GetLayerSnapshotsFunction getLayerSnapshots,
+        const std::shared_ptr<renderengine::ExternalTexture>& buffer,
+        bool canCaptureBlackoutContent, bool grayscale, ScreenCaptureResults& captureResults) {
+    ATRACE_CALL();
+
+    auto layers = getLayerSnapshots();
+    auto presentFuture = renderScreenLayers(std::move(renderArea), layers, buffer,
+                                            canCaptureBlackoutContent, false /* regionSampling */,
+                                            grayscale, captureResults);
+    if (layers.empty()) {
+        return presentFuture;
+    }
+
+    // The snapshots may be a frame behind the main thread, so the release fences are only
+    // attached to the layers that still present the captured buffers. The others have already
+    // released them.
+    struct CapturedLayer {
+        int32_t sequence;
+        uint64_t bufferId;
+        uint64_t frameNumber;
+        ftl::SharedFuture<FenceResult> releaseFence;
+    };
+    std::vector<CapturedLayer> capturedLayers;
+    capturedLayers.reserve(layers.size());
+    for (auto& [_, layerFE] : layers) {
+        const auto& snapshot = *layerFE->mSnapshot;
+        if (!snapshot.externalTexture) continue;
+
+        capturedLayers.push_back({.sequence = snapshot.sequence,
+                                  .bufferId = snapshot.externalTexture->getId(),
+                                  .frameNumber = snapshot.frameNumber,
+                                  .releaseFence =
+                                          getCaptureReleaseFence(presentFuture,
+                                                                 std::move(layerFE))});
+    }
+
+    static_cast<void>(mScheduler->schedule(
+            [this, capturedLayers = std::move(capturedLayers)]() FTL_FAKE_GUARD(
+                    kMainThreadContext) {
+                for (const auto& captured : capturedLayers) {
+                    const auto it = mLegacyLayers.find(captured.sequence);
+                    if (it == mLegacyLayers.end() ||
+                        !it->second->isPresentingBuffer(captured.bufferId, captured.frameNumber)) {
+                        continue;
+                    }
+                    it->second->onLayerDisplayed(captured.releaseFence, ui::INVALID_LAYER_STACK);
+                }
+            }));
+
+    return presentFuture;
+}
+
+ftl::SharedFuture<FenceResult> SurfaceFlinger::getCaptureReleaseFence(
+        const ftl::SharedFuture<FenceResult>& presentFuture, sp<LayerFE> layerFE) {
+    return ftl::Future(presentFuture)
+            .then([layerFE = std::move(layerFE)](FenceResult) {
+                return layerFE->stealCompositionResult().releaseFences.back().first.get();
+            })
+            .share();
+}
+
+ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenLayers(
+        std::shared_ptr<const RenderArea> renderArea,
+        std::vector<std::pair<Layer*, sp<LayerFE>>>& layers,
+        const std::shared_ptr<renderengine::ExternalTexture>& buffer,
+        bool canCaptureBlackoutContent, bool regionSampling, bool grayscale,
+        ScreenCaptureResults& captureResults) {
     for (auto& [_, layerFE] : layers) {
         frontend::LayerSnapshot* snapshot = layerFE->mSnapshot.get();
         captureResults.capturedSecureLayers |= (snapshot->isVisible && snapshot->isSecure);
@@ -7803,6 +8146,8 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenImpl(
     // the impetus on WindowManager to not persist them.
     if (captureResults.capturedSecureLayers && !canCaptureBlackoutContent) {
         ALOGW("FB is protected: PERMISSION_DENIED");
+        // Nothing was rendered, so there are no release fences to attach.
+        layers.clear();
         return ftl::yield<FenceResult>(base::unexpected(PERMISSION_DENIED)).share();
     }
 
@@ -7923,26 +8268,97 @@ ftl::SharedFuture<FenceResult> SurfaceFlinger::renderScreenImpl(
     //
     // TODO(b/196334700) Once we use RenderEngineThreaded everywhere we can always defer the call
     // to CompositionEngine::present.
-    const bool renderEngineIsThreaded = [&]() {
-        using Type = renderengine::RenderEngine::RenderEngineType;
-        const auto type = mRenderEngine->getRenderEngineType();
-        return type == Type::THREADED || type == Type::SKIA_GL_THREADED;
-    }();
-    auto presentFuture = renderEngineIsThreaded ? ftl::defer(std::move(present)).share()
-                                                : ftl::yield(present()).share();
+    return isRenderEngineThreaded() ? ftl::defer(std::move(present)).share()
+                                    : ftl::yield(present()).share();
+}
 
-    for (auto& [layer, layerFE] : layers) {
-        layer->onLayerDisplayed(ftl::Future(presentFuture)
-                                        .then([layerFE = std::move(layerFE)](FenceResult) {
-                                            return layerFE->stealCompositionResult()
-                                                    .releaseFences.back()
-                                                    .first.get();
-                                        })
-                                        .share(),
-                                ui::INVALID_LAYER_STACK);
+bool SurfaceFlinger::isRenderEngineThreaded() const {
+    using Type = renderengine::RenderEngine::RenderEngineType;
+    const auto type = mRenderEngine->getRenderEngineType();
+    return type == Type::THREADED || type == Type::SKIA_GL_THREADED;
+}
+
+SurfaceFlinger::GetLayerSnapshotsFunction SurfaceFlinger::getPublishedLayerSnapshotsForScreenshots(
+        ui::LayerStack layerStack, uint32_t uid) {
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> snapshots;
+    {
+        std::scoped_lock lock(mScreenshotSnapshotsMutex);
+        snapshots = mScreenshotSnapshots;
+    }
+    if (!snapshots) {
+        return nullptr;
     }
 
-    return presentFuture;
+    return [this, snapshots = std::move(snapshots), layerStack, uid]() {
+        std::vector<std::pair<Layer*, sp<LayerFE>>> layers;
+        for (const auto& snapshot : *snapshots) {
+            if (snapshot.outputFilter.layerStack != layerStack) {
+                continue;
+            }
+            if (uid != CaptureArgs::UNSET_UID && snapshot.uid != uid) {
+                continue;
+            }
+            sp<LayerFE> layerFE = getFactory().createLayerFE(snapshot.name);
+            layerFE->mSnapshot = std::make_unique<frontend::LayerSnapshot>(snapshot);
+            layers.emplace_back(nullptr, std::move(layerFE));
+        }
+        return layers;
+    };
+}
+
+void SurfaceFlinger::publishLayerSnapshotsForScreenshots() {
+    // Only keep the copy up to date while display captures keep coming in, so that devices that
+    // aren't capturing continuously don't pay for it.
+    constexpr nsecs_t kScreenshotIdleTimeout = ms2ns(1000);
+
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> snapshots;
+    if (systemTime() - mLastScreenshotRequestTime < kScreenshotIdleTimeout) {
+        ATRACE_NAME("publishLayerSnapshotsForScreenshots");
+        auto copy = std::make_shared<std::vector<frontend::LayerSnapshot>>();
+        mLayerSnapshotBuilder.forEachVisibleSnapshot([&](const frontend::LayerSnapshot& snapshot) {
+            if (snapshot.hasSomethingToDraw()) {
+                copy->push_back(snapshot);
+            }
+        });
+        snapshots = std::move(copy);
+    }
+
+    // Swap rather than assign so that the previous copy is destroyed outside of the lock.
+    std::scoped_lock lock(mScreenshotSnapshotsMutex);
+    std::swap(mScreenshotSnapshots, snapshots);
+}
+
+std::shared_ptr<const SurfaceFlinger::LayerDumpState> SurfaceFlinger::getPublishedLayerDumpState()
+        const {
+    std::scoped_lock lock(mLayerDumpStateMutex);
+    return mLayerDumpState;
+}
+
+void SurfaceFlinger::publishLayerDumpState() {
+    // Long enough to span the interval at which monitoring tools poll dumpsys.
+    constexpr nsecs_t kDumpIdleTimeout = s2ns(10);
+
+    std::shared_ptr<const LayerDumpState> state;
+    if (systemTime() - mLastDumpRequestTime < kDumpIdleTimeout) {
+        ATRACE_NAME("publishLayerDumpState");
+        auto copy = std::make_shared<LayerDumpState>();
+        for (const auto& snapshot : mLayerSnapshotBuilder.getSnapshots()) {
+            if (snapshot->path.isClone()) continue;
+            const auto it = mLegacyLayers.find(static_cast<uint32_t>(snapshot->sequence));
+            if (it == mLegacyLayers.end()) continue;
+            copy->layers.push_back({it->second->getName(), it->second});
+        }
+        mLayerSnapshotBuilder.forEachVisibleSnapshot([&](const frontend::LayerSnapshot& snapshot) {
+            const auto it = mLegacyLayers.find(static_cast<uint32_t>(snapshot.sequence));
+            const Layer* layer = it == mLegacyLayers.end() ? nullptr : it->second.get();
+            copy->visibleSnapshots.emplace_back(layer, snapshot);
+        });
+        state = std::move(copy);
+    }
+
+    // Swap rather than assign so that the previous copy is destroyed outside of the lock.
+    std::scoped_lock lock(mLayerDumpStateMutex);
+    std::swap(mLayerDumpState, state);
 }
 
 void SurfaceFlinger::traverseLegacyLayers(const LayerVector::Visitor& visitor) const {
@@ -8385,7 +8801,15 @@ void SurfaceFlinger::sample() {
         return;
     }
 
-    mRegionSamplingThread->onCompositionComplete(mScheduler->getScheduledFrameTime());
+    const auto* display = FTL_FAKE_GUARD(mStateLock, getDefaultDisplayDeviceLocked()).get();
+    if (!display) {
+        return;
+    }
+
+    mRegionSamplingThread->onCompositionComplete(mScheduler->getScheduledFrameTime(),
+                                                 display->getCompositionDisplay()
+                                                         ->getState()
+                                                         .lastFrameDirtyRegion);
 }
 
 void SurfaceFlinger::onActiveDisplaySizeChanged(const DisplayDevice& activeDisplay) {
@@ -8427,8 +8851,10 @@ void SurfaceFlinger::onActiveDisplayChangedLocked(const DisplayDevice* inactiveD
 }
 
 status_t SurfaceFlinger::addWindowInfosListener(const sp<IWindowInfosListener>& windowInfosListener,
+                                                bool supportsDeltaUpdates,
                                                 gui::WindowInfosListenerInfo* outInfo) {
-    mWindowInfosListenerInvoker->addWindowInfosListener(windowInfosListener, outInfo);
+    mWindowInfosListenerInvoker->addWindowInfosListener(windowInfosListener, outInfo,
+                                                        supportsDeltaUpdates);
     setTransactionFlags(eInputInfoUpdateNeeded);
     return NO_ERROR;
 }
@@ -8592,6 +9018,11 @@ std::vector<std::pair<Layer*, LayerFE*>> SurfaceFlinger::moveSnapshotsToComposit
         compositionengine::CompositionRefreshArgs& refreshArgs, bool cursorOnly, int64_t vsyncId) {
     std::vector<std::pair<Layer*, LayerFE*>> layers;
     if (mLayerLifecycleManagerEnabled) {
+        // Reserve for every snapshot that may be visible so the vectors are allocated at most
+        // once per frame.
+        const size_t maxLayerCount = mLayerSnapshotBuilder.getHotState().size();
+        layers.reserve(maxLayerCount);
+        refreshArgs.layers.reserve(maxLayerCount);
         nsecs_t currentTime = systemTime();
         mLayerSnapshotBuilder.forEachVisibleSnapshot(
                 [&](std::unique_ptr<frontend::LayerSnapshot>& snapshot) {
@@ -8774,6 +9205,11 @@ frontend::Update SurfaceFlinger::flushLifecycleUpdates() {
     // transactions with layers still in the createdLayer queue, flush the transactions
     // before committing the created layers.
     update.transactions = mTransactionHandler.flushTransactions();
+    // Give acquire fences that are about to signal a chance to do so, rather than holding their
+    // transactions back for a full frame.
+    if (mTransactionHandler.waitForPendingAcquireFences(mAcquireFenceWaitTimeout)) {
+        mTransactionHandler.flushTransactions(update.transactions);
+    }
     {
         // TODO(b/238781169) lockless queue this and keep order.
         std::scoped_lock<std::mutex> lock(mCreatedLayersLock);
@@ -9512,7 +9948,7 @@ binder::Status SurfaceComposerAIDL::getMaxAcquiredBufferCount(int32_t* buffers)
 }
 
 binder::Status SurfaceComposerAIDL::addWindowInfosListener(
-        const sp<gui::IWindowInfosListener>& windowInfosListener,
+        const sp<gui::IWindowInfosListener>& windowInfosListener, bool supportsDeltaUpdates,
         gui::WindowInfosListenerInfo* outInfo) {
     status_t status;
     const int pid = IPCThreadState::self()->getCallingPid();
@@ -9521,7 +9957,8 @@ binder::Status SurfaceComposerAIDL::addWindowInfosListener(
     // WindowInfosListeners
     if (uid == AID_SYSTEM || uid == AID_GRAPHICS ||
         checkPermission(sAccessSurfaceFlinger, pid, uid)) {
-        status = mFlinger->addWindowInfosListener(windowInfosListener, outInfo);
+        status = mFlinger->addWindowInfosListener(windowInfosListener, supportsDeltaUpdates,
+                                                  outInfo);
     } else {
         status = PERMISSION_DENIED;
     }
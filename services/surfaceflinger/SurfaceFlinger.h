@@ -76,6 +76,7 @@
 #include "DisplayIdGenerator.h"
 #include "Effects/Daltonizer.h"
 #include "FlagManager.h"
+#include "FramePhaseProfiler.h"
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerCreationArgs.h"
 #include "FrontEnd/LayerLifecycleManager.h"
@@ -330,6 +331,39 @@ public:
     // run parallel to the hwc validateDisplay call and re-run if the predition is incorrect.
     bool mPredictCompositionStrategy = false;
 
+    // If true, client composition only redraws the region of the client target that changed
+    // since the contents of the dequeued buffer, and passes that damage on to the HWC.
+    bool mPartialClientComposition = false;
+
+    // If true, the outputs of multiple displays are presented in parallel rather than serially.
+    bool mMultithreadedPresent = false;
+
+    // If non-zero, outputs with at least this many layers update their layers' composition state
+    // in parallel.
+    size_t mParallelLayerUpdateThreshold = 0;
+
+    // If true, LayerSnapshotBuilder does not walk layer subtrees that have no changes.
+    bool mSkipCleanLayerSubtrees = false;
+
+    // Reused across frames by composite to avoid reallocating on every frame.
+    std::vector<DisplayId> mCompositeDisplayIds;
+
+    // How long commit may wait for an unsignaled acquire fence holding back a transaction to
+    // signal before latching without it. Zero disables waiting.
+    std::chrono::nanoseconds mAcquireFenceWaitTimeout = std::chrono::nanoseconds::zero();
+
+    // If true, display captures are taken from a copy of the last committed layer snapshots
+    // without scheduling work on the main thread.
+    bool mOffMainThreadScreenshots = false;
+
+    // If true, follower displays are not composited on pacesetter frames that would present on
+    // the same follower vsync as the previous frame composited for them.
+    bool mSkipRedundantFollowerFrames = false;
+
+    // The follower vsync targeted by the last frame composited for each follower display.
+    display::PhysicalDisplayMap<PhysicalDisplayId, TimePoint> mFollowerVsyncTargets
+            GUARDED_BY(kMainThreadContext);
+
     // If true, then any layer with a SMPTE 170M transfer function is decoded using the sRGB
     // transfer instead. This is mainly to preserve legacy behavior, where implementations treated
     // SMPTE 170M as sRGB prior to color management being implemented, and now implementations rely
@@ -637,6 +671,7 @@ private:
     status_t getMaxAcquiredBufferCount(int* buffers) const;
 
     status_t addWindowInfosListener(const sp<gui::IWindowInfosListener>& windowInfosListener,
+                                    bool supportsDeltaUpdates,
                                     gui::WindowInfosListenerInfo* outResult);
     status_t removeWindowInfosListener(
             const sp<gui::IWindowInfosListener>& windowInfosListener) const;
@@ -733,6 +768,9 @@ private:
     bool latchBuffers();
 
     void updateLayerGeometry();
+    // Whether composite should skip a follower display whose next frame would present on the same
+    // vsync as the previous one composited for it.
+    bool isRedundantFollowerFrame(const DisplayDevice&) REQUIRES(kMainThreadContext);
     void updateLayerMetadataSnapshot();
     std::vector<std::pair<Layer*, LayerFE*>> moveSnapshotsToCompositionArgs(
             compositionengine::CompositionRefreshArgs& refreshArgs, bool cursorOnly,
@@ -849,19 +887,38 @@ private:
     // Boot animation, on/off animations and screen capture
     void startBootAnim();
 
+    // If offMainThread is true, the capture runs on the calling thread and GetLayerSnapshotsFunction
+    // must not access main thread state.
     ftl::SharedFuture<FenceResult> captureScreenCommon(RenderAreaFuture, GetLayerSnapshotsFunction,
                                                        ui::Size bufferSize, ui::PixelFormat,
                                                        bool allowProtected, bool grayscale,
+                                                       const sp<GraphicBuffer>& captureBuffer,
+                                                       bool offMainThread,
                                                        const sp<IScreenCaptureListener>&);
     ftl::SharedFuture<FenceResult> captureScreenCommon(
             RenderAreaFuture, GetLayerSnapshotsFunction,
             const std::shared_ptr<renderengine::ExternalTexture>&, bool regionSampling,
-            bool grayscale, const sp<IScreenCaptureListener>&);
+            bool grayscale, bool offMainThread, const sp<IScreenCaptureListener>&);
     ftl::SharedFuture<FenceResult> renderScreenImpl(
             std::shared_ptr<const RenderArea>, GetLayerSnapshotsFunction,
             const std::shared_ptr<renderengine::ExternalTexture>&, bool canCaptureBlackoutContent,
             bool regionSampling, bool grayscale, ScreenCaptureResults&) EXCLUDES(mStateLock)
             REQUIRES(kMainThreadContext);
+    // Renders a display capture from the published layer snapshots on the calling thread. The
+    // release fences are attached on the main thread, to the layers that still present the
+    // captured buffers.
+    ftl::SharedFuture<FenceResult> renderScreenImplOffMainThread(
+            std::shared_ptr<const RenderArea>, GetLayerSnapshotsFunction,
+            const std::shared_ptr<renderengine::ExternalTexture>&, bool canCaptureBlackoutContent,
+            bool grayscale, ScreenCaptureResults&) EXCLUDES(mStateLock);
+    // Renders the layers, and clears them if nothing was rendered.
+    ftl::SharedFuture<FenceResult> renderScreenLayers(
+            std::shared_ptr<const RenderArea>, std::vector<std::pair<Layer*, sp<LayerFE>>>& layers,
+            const std::shared_ptr<renderengine::ExternalTexture>&, bool canCaptureBlackoutContent,
+            bool regionSampling, bool grayscale, ScreenCaptureResults&) EXCLUDES(mStateLock);
+    static ftl::SharedFuture<FenceResult> getCaptureReleaseFence(
+            const ftl::SharedFuture<FenceResult>& presentFuture, sp<LayerFE>);
+    bool isRenderEngineThreaded() const;
 
     // If the uid provided is not UNSET_UID, the traverse will skip any layers that don't have a
     // matching ownerUid
@@ -1094,9 +1151,16 @@ private:
     void appendSfConfigString(std::string& result) const;
     void listLayersLocked(std::string& result) const;
     void dumpStatsLocked(const DumpArgs& args, std::string& result) const REQUIRES(mStateLock);
+    // Serves the dumps that only need layer state from the published LayerDumpState, without
+    // taking mStateLock or scheduling work on the main thread. Returns false if the flag is not
+    // one of those dumps or no state is published.
+    bool dumpFromPublishedState(const std::string& flag, const DumpArgs& args,
+                                std::string& result) const EXCLUDES(mStateLock);
     void clearStatsLocked(const DumpArgs& args, std::string& result);
     void dumpTimeStats(const DumpArgs& args, bool asProto, std::string& result) const;
     void dumpFrameTimeline(const DumpArgs& args, std::string& result) const;
+    void dumpFramePhases(const DumpArgs& args, std::string& result);
+    void dumpTransactionQueues(const DumpArgs& args, std::string& result);
     void logFrameStats(TimePoint now) REQUIRES(kMainThreadContext);
 
     void dumpScheduler(std::string& result) const REQUIRES(mStateLock);
@@ -1443,6 +1507,47 @@ private:
             uint32_t rootLayerId, uint32_t uid, std::unordered_set<uint32_t> excludeLayerIds,
             bool childrenOnly, const std::optional<FloatRect>& optionalParentCrop);
 
+    // Returns the layers of layerStack from the snapshots published for off main thread
+    // screenshots, or nullptr if they are out of date. Safe to call from any thread.
+    GetLayerSnapshotsFunction getPublishedLayerSnapshotsForScreenshots(ui::LayerStack layerStack,
+                                                                       uint32_t uid);
+    // Publishes a copy of the visible layer snapshots for off main thread screenshots if display
+    // captures were requested recently, and otherwise invalidates the published copy.
+    void publishLayerSnapshotsForScreenshots() REQUIRES(kMainThreadContext);
+
+    // An immutable copy of the visible layer snapshots of the last commit, or nullptr if no copy
+    // is being kept up to date.
+    std::mutex mScreenshotSnapshotsMutex;
+    std::shared_ptr<const std::vector<frontend::LayerSnapshot>> mScreenshotSnapshots
+            GUARDED_BY(mScreenshotSnapshotsMutex);
+    // When the last display capture that could run off the main thread was requested.
+    std::atomic<nsecs_t> mLastScreenshotRequestTime = 0;
+
+    // An immutable copy of the layer state read by dumpsys, published after each commit while
+    // dumps keep coming in, so that periodic dumps don't stall the main thread.
+    struct LayerDumpState {
+        struct Entry {
+            std::string name;
+            wp<Layer> layer;
+        };
+        // Every layer in z-order, excluding mirrors.
+        std::vector<Entry> layers;
+        // The snapshots of visible layers in z-order, and the layers they belong to.
+        std::vector<std::pair<const Layer*, frontend::LayerSnapshot>> visibleSnapshots;
+    };
+
+    // Returns the published layer state, or nullptr if it is out of date. Safe to call from any
+    // thread.
+    std::shared_ptr<const LayerDumpState> getPublishedLayerDumpState() const;
+    // Publishes a copy of the layer state if dumps were requested recently, and otherwise
+    // invalidates the published copy.
+    void publishLayerDumpState() REQUIRES(kMainThreadContext);
+
+    mutable std::mutex mLayerDumpStateMutex;
+    std::shared_ptr<const LayerDumpState> mLayerDumpState GUARDED_BY(mLayerDumpStateMutex);
+    // When the last dump was requested.
+    std::atomic<nsecs_t> mLastDumpRequestTime = 0;
+
     const sp<WindowInfosListenerInvoker> mWindowInfosListenerInvoker;
 
     FlagManager mFlagManager;
@@ -1474,6 +1579,7 @@ private:
     /* QTI_END */
 
     TransactionHandler mTransactionHandler;
+    FramePhaseProfiler mFramePhaseProfiler;
     display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mFrontEndDisplayInfos;
     bool mFrontEndDisplayInfosChanged = false;
 
@@ -1589,6 +1695,7 @@ public:
     binder::Status getGpuContextPriority(int32_t* outPriority) override;
     binder::Status getMaxAcquiredBufferCount(int32_t* buffers) override;
     binder::Status addWindowInfosListener(const sp<gui::IWindowInfosListener>& windowInfosListener,
+                                          bool supportsDeltaUpdates,
                                           gui::WindowInfosListenerInfo* outInfo) override;
     binder::Status removeWindowInfosListener(
             const sp<gui::IWindowInfosListener>& windowInfosListener) override;
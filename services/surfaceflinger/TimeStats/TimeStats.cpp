@@ -145,6 +145,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
 
 bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    aggregateReadyFramesLocked();
 
     std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
     uint32_t numLayers = 0;
@@ -308,7 +309,7 @@ std::string TimeStats::miniDump() {
     std::string result = "TimeStats miniDump:\n";
     std::lock_guard<std::mutex> lock(mMutex);
     android::base::StringAppendF(&result, "Number of layers currently being tracked is %zu\n",
-                                 mTimeStatsTracker.size());
+                                 mNumLayerRecords.load());
     android::base::StringAppendF(&result, "Number of layers in the stats pool is %zu\n",
                                  mTimeStats.stats.size());
     return result;
@@ -450,14 +451,17 @@ static int32_t clampToNearestBucket(Fps fps, size_t bucketWidth) {
     return std::round(fps.getValue() / bucketWidth) * bucketWidth;
 }
 
-void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
-                                                   std::optional<Fps> renderRate,
-                                                   SetFrameRateVote frameRateVote,
-                                                   GameMode gameMode) {
+TimeStats::LayerShard& TimeStats::shardFor(int32_t layerId) {
+    return mLayerShards[static_cast<uint32_t>(layerId) % NUM_LAYER_SHARDS];
+}
+
+bool TimeStats::flushAvailableRecordsLocked(LayerShard& shard, int32_t layerId,
+                                            Fps displayRefreshRate, std::optional<Fps> renderRate,
+                                            SetFrameRateVote frameRateVote, GameMode gameMode) {
     ATRACE_CALL();
-    ALOGV("[%d]-flushAvailableRecordsToStatsLocked", layerId);
+    ALOGV("[%d]-flushAvailableRecordsLocked", layerId);
 
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerRecord& layerRecord = shard.records[layerId];
     TimeRecord& prevTimeRecord = layerRecord.prevTimeRecord;
     std::optional<int32_t>& prevPresentToPresentMs = layerRecord.prevPresentToPresentMs;
     std::deque<TimeRecord>& timeRecords = layerRecord.timeRecords;
@@ -472,82 +476,130 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
               timeRecords[0].frameTime.frameNumber, timeRecords[0].frameTime.presentTime);
 
         if (prevTimeRecord.ready) {
-            uid_t uid = layerRecord.uid;
-            const std::string& layerName = layerRecord.layerName;
-            TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
-            if (!mTimeStats.stats.count(timelineKey)) {
-                mTimeStats.stats[timelineKey].key = timelineKey;
-            }
-
-            TimeStatsHelper::TimelineStats& displayStats = mTimeStats.stats[timelineKey];
-
-            TimeStatsHelper::LayerStatsKey layerKey = {uid, layerName, gameMode};
-            if (!displayStats.stats.count(layerKey)) {
-                displayStats.stats[layerKey].displayRefreshRateBucket = refreshRateBucket;
-                displayStats.stats[layerKey].renderRateBucket = renderRateBucket;
-                displayStats.stats[layerKey].uid = uid;
-                displayStats.stats[layerKey].layerName = layerName;
-                displayStats.stats[layerKey].gameMode = gameMode;
-            }
-            if (frameRateVote.frameRate > 0.0f) {
-                displayStats.stats[layerKey].setFrameRateVote = frameRateVote;
-            }
-            TimeStatsHelper::TimeStatsLayer& timeStatsLayer = displayStats.stats[layerKey];
-            timeStatsLayer.totalFrames++;
-            timeStatsLayer.droppedFrames += layerRecord.droppedFrames;
-            timeStatsLayer.lateAcquireFrames += layerRecord.lateAcquireFrames;
-            timeStatsLayer.badDesiredPresentFrames += layerRecord.badDesiredPresentFrames;
-
+            ReadyFrame frame = {
+                    .timelineKey = {refreshRateBucket, renderRateBucket},
+                    .gameMode = gameMode,
+                    .frameRateVote = frameRateVote,
+                    .droppedFrames = layerRecord.droppedFrames,
+                    .lateAcquireFrames = layerRecord.lateAcquireFrames,
+                    .badDesiredPresentFrames = layerRecord.badDesiredPresentFrames,
+            };
             layerRecord.droppedFrames = 0;
             layerRecord.lateAcquireFrames = 0;
             layerRecord.badDesiredPresentFrames = 0;
 
-            const int32_t postToAcquireMs = msBetween(timeRecords[0].frameTime.postTime,
-                                                      timeRecords[0].frameTime.acquireTime);
+            frame.postToAcquireMs = msBetween(timeRecords[0].frameTime.postTime,
+                                              timeRecords[0].frameTime.acquireTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2acquire[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, postToAcquireMs);
-            timeStatsLayer.deltas["post2acquire"].insert(postToAcquireMs);
+                  timeRecords[0].frameTime.frameNumber, frame.postToAcquireMs);
 
-            const int32_t postToPresentMs = msBetween(timeRecords[0].frameTime.postTime,
-                                                      timeRecords[0].frameTime.presentTime);
+            frame.postToPresentMs = msBetween(timeRecords[0].frameTime.postTime,
+                                              timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-post2present[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, postToPresentMs);
-            timeStatsLayer.deltas["post2present"].insert(postToPresentMs);
+                  timeRecords[0].frameTime.frameNumber, frame.postToPresentMs);
 
-            const int32_t acquireToPresentMs = msBetween(timeRecords[0].frameTime.acquireTime,
-                                                         timeRecords[0].frameTime.presentTime);
+            frame.acquireToPresentMs = msBetween(timeRecords[0].frameTime.acquireTime,
+                                                 timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-acquire2present[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, acquireToPresentMs);
-            timeStatsLayer.deltas["acquire2present"].insert(acquireToPresentMs);
+                  timeRecords[0].frameTime.frameNumber, frame.acquireToPresentMs);
 
-            const int32_t latchToPresentMs = msBetween(timeRecords[0].frameTime.latchTime,
-                                                       timeRecords[0].frameTime.presentTime);
+            frame.latchToPresentMs = msBetween(timeRecords[0].frameTime.latchTime,
+                                               timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-latch2present[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, latchToPresentMs);
-            timeStatsLayer.deltas["latch2present"].insert(latchToPresentMs);
+                  timeRecords[0].frameTime.frameNumber, frame.latchToPresentMs);
 
-            const int32_t desiredToPresentMs = msBetween(timeRecords[0].frameTime.desiredTime,
-                                                         timeRecords[0].frameTime.presentTime);
+            frame.desiredToPresentMs = msBetween(timeRecords[0].frameTime.desiredTime,
+                                                 timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-desired2present[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, desiredToPresentMs);
-            timeStatsLayer.deltas["desired2present"].insert(desiredToPresentMs);
+                  timeRecords[0].frameTime.frameNumber, frame.desiredToPresentMs);
 
-            const int32_t presentToPresentMs = msBetween(prevTimeRecord.frameTime.presentTime,
-                                                         timeRecords[0].frameTime.presentTime);
+            frame.presentToPresentMs = msBetween(prevTimeRecord.frameTime.presentTime,
+                                                 timeRecords[0].frameTime.presentTime);
             ALOGV("[%d]-[%" PRIu64 "]-present2present[%d]", layerId,
-                  timeRecords[0].frameTime.frameNumber, presentToPresentMs);
-            timeStatsLayer.deltas["present2present"].insert(presentToPresentMs);
+                  timeRecords[0].frameTime.frameNumber, frame.presentToPresentMs);
             if (prevPresentToPresentMs) {
-                const int32_t presentToPresentDeltaMs =
-                        std::abs(presentToPresentMs - *prevPresentToPresentMs);
-                timeStatsLayer.deltas["present2presentDelta"].insert(presentToPresentDeltaMs);
+                frame.presentToPresentDeltaMs =
+                        std::abs(frame.presentToPresentMs - *prevPresentToPresentMs);
             }
-            prevPresentToPresentMs = presentToPresentMs;
+            prevPresentToPresentMs = frame.presentToPresentMs;
+            layerRecord.readyFrames.push_back(frame);
+            shard.readyFrames++;
         }
         prevTimeRecord = timeRecords[0];
         timeRecords.pop_front();
         layerRecord.waitData--;
     }
+    return shard.readyFrames.load() >= MAX_NUM_READY_FRAMES;
+}
+
+void TimeStats::aggregateReadyFramesLocked() {
+    ATRACE_CALL();
+    for (LayerShard& shard : mLayerShards) {
+        if (shard.readyFrames.load() == 0) continue;
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        for (auto& [layerId, layerRecord] : shard.records) {
+            aggregateReadyFramesLocked(layerRecord);
+        }
+        shard.readyFrames = 0;
+    }
+}
+
+void TimeStats::aggregateReadyFramesLocked(LayerRecord& layerRecord) {
+    const uid_t uid = layerRecord.uid;
+    const std::string& layerName = layerRecord.layerName;
+    for (const ReadyFrame& frame : layerRecord.readyFrames) {
+        TimeStatsHelper::LayerStatsKey layerKey = {uid, layerName, frame.gameMode};
+        if (!canAddNewAggregatedStats(uid, layerName, frame.gameMode)) {
+            continue;
+        }
+
+        const TimeStatsHelper::TimelineStatsKey& timelineKey = frame.timelineKey;
+        if (!mTimeStats.stats.count(timelineKey)) {
+            mTimeStats.stats[timelineKey].key = timelineKey;
+        }
+
+        TimeStatsHelper::TimelineStats& displayStats = mTimeStats.stats[timelineKey];
+
+        if (!displayStats.stats.count(layerKey)) {
+            displayStats.stats[layerKey].displayRefreshRateBucket =
+                    timelineKey.displayRefreshRateBucket;
+            displayStats.stats[layerKey].renderRateBucket = timelineKey.renderRateBucket;
+            displayStats.stats[layerKey].uid = uid;
+            displayStats.stats[layerKey].layerName = layerName;
+            displayStats.stats[layerKey].gameMode = frame.gameMode;
+        }
+        if (frame.frameRateVote.frameRate > 0.0f) {
+            displayStats.stats[layerKey].setFrameRateVote = frame.frameRateVote;
+        }
+        TimeStatsHelper::TimeStatsLayer& timeStatsLayer = displayStats.stats[layerKey];
+        timeStatsLayer.totalFrames++;
+        timeStatsLayer.droppedFrames += frame.droppedFrames;
+        timeStatsLayer.lateAcquireFrames += frame.lateAcquireFrames;
+        timeStatsLayer.badDesiredPresentFrames += frame.badDesiredPresentFrames;
+
+        timeStatsLayer.deltas["post2acquire"].insert(frame.postToAcquireMs);
+        timeStatsLayer.deltas["post2present"].insert(frame.postToPresentMs);
+        timeStatsLayer.deltas["acquire2present"].insert(frame.acquireToPresentMs);
+        timeStatsLayer.deltas["latch2present"].insert(frame.latchToPresentMs);
+        timeStatsLayer.deltas["desired2present"].insert(frame.desiredToPresentMs);
+        timeStatsLayer.deltas["present2present"].insert(frame.presentToPresentMs);
+        if (frame.presentToPresentDeltaMs) {
+            timeStatsLayer.deltas["present2presentDelta"].insert(*frame.presentToPresentDeltaMs);
+        }
+    }
+    layerRecord.readyFrames.clear();
+}
+
+void TimeStats::aggregateAndEraseLayerRecord(int32_t layerId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> shardLock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    shard.readyFrames -= it->second.readyFrames.size();
+    aggregateReadyFramesLocked(it->second);
+    shard.records.erase(it);
+    mNumLayerRecords--;
 }
 
 static constexpr const char* kPopupWindowPrefix = "PopupWindow";
@@ -581,22 +633,28 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     ALOGV("[%d]-[%" PRIu64 "]-[%s]-PostTime[%" PRId64 "]", layerId, frameNumber, layerName.c_str(),
           postTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
-        return;
-    }
-    if (!mTimeStatsTracker.count(layerId) && mTimeStatsTracker.size() < MAX_NUM_LAYER_RECORDS &&
-        layerNameIsValid(layerName)) {
-        mTimeStatsTracker[layerId].uid = uid;
-        mTimeStatsTracker[layerId].layerName = layerName;
-        mTimeStatsTracker[layerId].gameMode = gameMode;
+    // Whether the layer still fits in the aggregated stats is only checked once its frames are
+    // aggregated, so that this doesn't need mMutex.
+    LayerShard& shard = shardFor(layerId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) {
+        if (!layerNameIsValid(layerName)) return;
+        if (mNumLayerRecords.fetch_add(1) >= MAX_NUM_LAYER_RECORDS) {
+            mNumLayerRecords--;
+            return;
+        }
+        it = shard.records.try_emplace(layerId).first;
+        it->second.uid = uid;
+        it->second.layerName = layerName;
+        it->second.gameMode = gameMode;
     }
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.timeRecords.size() == MAX_NUM_TIME_RECORDS) {
         ALOGE("[%d]-[%s]-timeRecords is at its maximum size[%zu]. Ignore this when unittesting.",
               layerId, layerRecord.layerName.c_str(), MAX_NUM_TIME_RECORDS);
-        mTimeStatsTracker.erase(layerId);
+        lock.unlock();
+        aggregateAndEraseLayerRecord(layerId);
         return;
     }
     // For most media content, the acquireFence is invalid because the buffer is
@@ -624,9 +682,11 @@ void TimeStats::setLatchTime(int32_t layerId, uint64_t frameNumber, nsecs_t latc
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-LatchTime[%" PRId64 "]", layerId, frameNumber, latchTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -643,9 +703,11 @@ void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
     ALOGV("[%d]-LatchSkipped-Reason[%d]", layerId,
           static_cast<std::underlying_type<LatchSkipReason>::type>(reason));
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
 
     switch (reason) {
         case LatchSkipReason::LateAcquire:
@@ -660,9 +722,11 @@ void TimeStats::incrementBadDesiredPresent(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-BadDesiredPresent", layerId);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     layerRecord.badDesiredPresentFrames++;
 }
 
@@ -672,9 +736,11 @@ void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t de
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-DesiredTime[%" PRId64 "]", layerId, frameNumber, desiredTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -690,9 +756,11 @@ void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t ac
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-AcquireTime[%" PRId64 "]", layerId, frameNumber, acquireTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -710,9 +778,11 @@ void TimeStats::setAcquireFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-AcquireFenceTime[%" PRId64 "]", layerId, frameNumber,
           acquireFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -730,9 +800,11 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-PresentTime[%" PRId64 "]", layerId, frameNumber, presentTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -743,8 +815,12 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    if (flushAvailableRecordsLocked(shard, layerId, displayRefreshRate, renderRate, frameRateVote,
+                                    gameMode)) {
+        lock.unlock();
+        std::lock_guard<std::mutex> statsLock(mMutex);
+        aggregateReadyFramesLocked();
+    }
 }
 
 void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
@@ -757,9 +833,11 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-PresentFenceTime[%" PRId64 "]", layerId, frameNumber,
           presentFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -770,8 +848,12 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    if (flushAvailableRecordsLocked(shard, layerId, displayRefreshRate, renderRate, frameRateVote,
+                                    gameMode)) {
+        lock.unlock();
+        std::lock_guard<std::mutex> statsLock(mMutex);
+        aggregateReadyFramesLocked();
+    }
 }
 
 static const constexpr int32_t kValidJankyReason = JankType::DisplayHAL |
@@ -816,6 +898,8 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
 
     ATRACE_CALL();
     std::lock_guard<std::mutex> lock(mMutex);
+    // The first frames of a layer must be aggregated before its jank, see below.
+    aggregateReadyFramesLocked();
 
     // Only update layer stats if we're already tracking the layer in TimeStats.
     // Otherwise, continue tracking the statistic but use a default layer name instead.
@@ -872,8 +956,7 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
 void TimeStats::onDestroy(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-onDestroy", layerId);
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStatsTracker.erase(layerId);
+    aggregateAndEraseLayerRecord(layerId);
 }
 
 void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
@@ -882,9 +965,11 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-removeTimeRecord", layerId, frameNumber);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = shardFor(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     size_t removeAt = 0;
     for (const TimeRecord& record : layerRecord.timeRecords) {
         if (record.frameTime.frameNumber == frameNumber) break;
@@ -1090,7 +1175,12 @@ void TimeStats::clearGlobalLocked() {
 void TimeStats::clearLayersLocked() {
     ATRACE_CALL();
 
-    mTimeStatsTracker.clear();
+    for (LayerShard& shard : mLayerShards) {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        mNumLayerRecords -= shard.records.size();
+        shard.records.clear();
+        shard.readyFrames = 0;
+    }
 
     for (auto& globalRecord : mTimeStats.stats) {
         globalRecord.second.stats.clear();
@@ -1110,6 +1200,7 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
         return;
     }
 
+    aggregateReadyFramesLocked();
     mTimeStats.statsEndLegacy = static_cast<int64_t>(std::time(0));
 
     flushPowerTimeLocked();
@@ -16,12 +16,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include <android/hardware/graphics/composer/2.4/IComposerClient.h>
 #include <gui/JankInfo.h>
@@ -207,6 +210,23 @@ class TimeStats : public android::TimeStats {
         std::shared_ptr<FenceTime> presentFence;
     };
 
+    // A frame whose deltas are known, waiting to be added to the aggregated stats.
+    struct ReadyFrame {
+        TimeStatsHelper::TimelineStatsKey timelineKey;
+        GameMode gameMode = GameMode::Unsupported;
+        SetFrameRateVote frameRateVote;
+        uint32_t droppedFrames = 0;
+        uint32_t lateAcquireFrames = 0;
+        uint32_t badDesiredPresentFrames = 0;
+        int32_t postToAcquireMs = 0;
+        int32_t postToPresentMs = 0;
+        int32_t acquireToPresentMs = 0;
+        int32_t latchToPresentMs = 0;
+        int32_t desiredToPresentMs = 0;
+        int32_t presentToPresentMs = 0;
+        std::optional<int32_t> presentToPresentDeltaMs;
+    };
+
     struct LayerRecord {
         uid_t uid;
         std::string layerName;
@@ -221,6 +241,16 @@ class TimeStats : public android::TimeStats {
         TimeRecord prevTimeRecord;
         std::optional<int32_t> prevPresentToPresentMs;
         std::deque<TimeRecord> timeRecords;
+        std::vector<ReadyFrame> readyFrames;
+    };
+
+    // The layer records are split by layer id, each part with its own lock, so that the per-frame
+    // calls for different layers don't contend with each other or with the global stats.
+    struct LayerShard {
+        std::mutex mutex;
+        // Hashmap for LayerRecord with layerId as the hash key
+        std::unordered_map<int32_t, LayerRecord> records;
+        std::atomic<size_t> readyFrames = 0;
     };
 
     struct PowerTime {
@@ -295,10 +325,16 @@ public:
 private:
     bool populateGlobalAtom(std::vector<uint8_t>* pulledData);
     bool populateLayerAtom(std::vector<uint8_t>* pulledData);
+    LayerShard& shardFor(int32_t layerId);
     bool recordReadyLocked(int32_t layerId, TimeRecord* timeRecord);
-    void flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
-                                            std::optional<Fps> renderRate, SetFrameRateVote,
-                                            GameMode);
+    // Returns true once enough ready frames are waiting that they should be aggregated.
+    bool flushAvailableRecordsLocked(LayerShard& shard, int32_t layerId, Fps displayRefreshRate,
+                                     std::optional<Fps> renderRate, SetFrameRateVote, GameMode);
+    // Moves the ready frames of all layers into mTimeStats. Must be called with mMutex held, and
+    // none of the shard locks.
+    void aggregateReadyFramesLocked();
+    void aggregateReadyFramesLocked(LayerRecord& layerRecord);
+    void aggregateAndEraseLayerRecord(int32_t layerId);
     void flushPowerTimeLocked();
     void flushAvailableGlobalRecordsToStatsLocked();
     bool canAddNewAggregatedStats(uid_t uid, const std::string& layerName, GameMode);
@@ -310,16 +346,20 @@ private:
     void clearLayersLocked();
     void dump(bool asProto, std::optional<uint32_t> maxLayers, std::string& result);
 
+    static const size_t MAX_NUM_LAYER_RECORDS = 200;
+    static const size_t NUM_LAYER_SHARDS = 8;
+    // Ready frames are aggregated at the latest once a shard holds this many.
+    static const size_t MAX_NUM_READY_FRAMES = 64;
+
     std::atomic<bool> mEnabled = false;
+    // Guards the aggregated and global stats. Taken before any shard lock.
     std::mutex mMutex;
     TimeStatsHelper::TimeStatsGlobal mTimeStats;
-    // Hashmap for LayerRecord with layerId as the hash key
-    std::unordered_map<int32_t, LayerRecord> mTimeStatsTracker;
+    std::array<LayerShard, NUM_LAYER_SHARDS> mLayerShards;
+    std::atomic<size_t> mNumLayerRecords = 0;
     PowerTime mPowerTime;
     GlobalRecord mGlobalRecord;
 
-    static const size_t MAX_NUM_LAYER_RECORDS = 200;
-
     static const size_t REFRESH_RATE_BUCKET_WIDTH = 30;
     static const size_t RENDER_RATE_BUCKET_WIDTH = REFRESH_RATE_BUCKET_WIDTH;
     static const size_t MAX_NUM_LAYER_STATS = 200;
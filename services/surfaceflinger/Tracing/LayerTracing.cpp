@@ -19,6 +19,7 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <filesystem>
+#include <unordered_set>
 
 #include <SurfaceFlinger.h>
 #include <android-base/stringprintf.h>
@@ -32,9 +33,20 @@
 namespace android {
 
 LayerTracing::LayerTracing()
-      : mBuffer(std::make_unique<RingBuffer<LayersTraceFileProto, LayersTraceProto>>()) {}
+      : mBuffer(std::make_unique<RingBuffer<LayersTraceFileProto, LayersTraceProto>>()) {
+    mThread = std::thread(&LayerTracing::loop, this);
+}
 
-LayerTracing::~LayerTracing() = default;
+LayerTracing::~LayerTracing() {
+    {
+        std::scoped_lock lock(mPendingLock);
+        mDone = true;
+        mPendingCv.notify_all();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
 
 bool LayerTracing::enable() {
     std::scoped_lock lock(mTraceLock);
@@ -42,11 +54,15 @@ bool LayerTracing::enable() {
         return false;
     }
     mBuffer->setSize(mBufferSizeInBytes);
+    mPreviousLayers.clear();
+    mPreviousLayerOrder.clear();
+    mEntriesSinceKeyframe = 0;
     mEnabled = true;
     return true;
 }
 
 bool LayerTracing::disable(std::string filename, bool writeToFile) {
+    flush();
     std::scoped_lock lock(mTraceLock);
     if (!mEnabled) {
         return false;
@@ -54,17 +70,26 @@ bool LayerTracing::disable(std::string filename, bool writeToFile) {
     mEnabled = false;
     if (writeToFile) {
         LayersTraceFileProto fileProto = createTraceFileProto();
-        mBuffer->writeToFile(fileProto, filename);
+        writeToProtoLocked(fileProto);
+        RingBuffer<LayersTraceFileProto, LayersTraceProto>::writeProtoToFile(fileProto, filename);
     }
     mBuffer->reset();
+    mPreviousLayers.clear();
+    mPreviousLayerOrder.clear();
     return true;
 }
 
 void LayerTracing::appendToStream(std::ofstream& out) {
+    flush();
     std::scoped_lock lock(mTraceLock);
     LayersTraceFileProto fileProto = createTraceFileProto();
-    mBuffer->appendToStream(fileProto, out);
+    writeToProtoLocked(fileProto);
+    RingBuffer<LayersTraceFileProto, LayersTraceProto>::appendProtoToStream(fileProto, out);
     mBuffer->reset();
+    // The next entry must not be a delta against entries which are gone.
+    mPreviousLayers.clear();
+    mPreviousLayerOrder.clear();
+    mEntriesSinceKeyframe = 0;
 }
 
 bool LayerTracing::isEnabled() const {
@@ -73,12 +98,15 @@ bool LayerTracing::isEnabled() const {
 }
 
 status_t LayerTracing::writeToFile(std::string filename) {
+    flush();
     std::scoped_lock lock(mTraceLock);
     if (!mEnabled) {
         return STATUS_OK;
     }
     LayersTraceFileProto fileProto = createTraceFileProto();
-    return mBuffer->writeToFile(fileProto, filename);
+    writeToProtoLocked(fileProto);
+    return RingBuffer<LayersTraceFileProto, LayersTraceProto>::writeProtoToFile(fileProto,
+                                                                                filename);
 }
 
 void LayerTracing::setTraceFlags(uint32_t flags) {
@@ -141,7 +169,146 @@ void LayerTracing::notify(bool visibleRegionDirty, int64_t time, int64_t vsyncId
     }
     entry.mutable_displays()->Swap(displays);
     entry.set_vsync_id(vsyncId);
+
+    // Diffing and serializing the layers is left to the tracing thread.
+    std::scoped_lock pendingLock(mPendingLock);
+    mPendingEntries.emplace_back(std::move(entry));
+    mPendingCv.notify_one();
+}
+
+void LayerTracing::loop() {
+    while (true) {
+        std::vector<LayersTraceProto> entries;
+        {
+            std::unique_lock<std::mutex> lock(mPendingLock);
+            base::ScopedLockAssertion assumeLocked(mPendingLock);
+            mPendingCv.wait(lock, [&]() REQUIRES(mPendingLock) {
+                return mDone || !mPendingEntries.empty();
+            });
+            if (mDone) {
+                mPendingEntries.clear();
+                break;
+            }
+            entries = std::move(mPendingEntries);
+            mPendingEntries.clear();
+            mAddingEntries = true;
+        } // unlock mPendingLock
+
+        {
+            std::scoped_lock lock(mTraceLock);
+            if (mEnabled) {
+                for (LayersTraceProto& entry : entries) {
+                    addEntryLocked(entry);
+                }
+            }
+        }
+
+        std::scoped_lock lock(mPendingLock);
+        mAddingEntries = false;
+        mPendingDrainedCv.notify_all();
+    }
+}
+
+void LayerTracing::flush() {
+    std::unique_lock<std::mutex> lock(mPendingLock);
+    base::ScopedLockAssertion assumeLocked(mPendingLock);
+    mPendingDrainedCv.wait(lock, [&]() REQUIRES(mPendingLock) {
+        return mDone || (mPendingEntries.empty() && !mAddingEntries);
+    });
+}
+
+void LayerTracing::addEntryLocked(LayersTraceProto& entry) {
+    ATRACE_CALL();
+    std::unordered_map<int32_t, std::string> layers;
+    std::vector<int32_t> layerOrder;
+    layers.reserve(static_cast<size_t>(entry.layers().layers_size()));
+    layerOrder.reserve(static_cast<size_t>(entry.layers().layers_size()));
+    bool hasDuplicateIds = false;
+    for (const LayerProto& layer : entry.layers().layers()) {
+        hasDuplicateIds |= !layers.emplace(layer.id(), layer.SerializeAsString()).second;
+        layerOrder.push_back(layer.id());
+    }
+
+    // Deltas are applied by layer id, so neither this entry nor the next one can be a delta if
+    // ids are duplicated.
+    if (mEntriesSinceKeyframe != 0 && !hasDuplicateIds) {
+        LayersProto changedLayers;
+        for (LayerProto& layer : *entry.mutable_layers()->mutable_layers()) {
+            auto it = mPreviousLayers.find(layer.id());
+            if (it == mPreviousLayers.end() || it->second != layers[layer.id()]) {
+                changedLayers.add_layers()->Swap(&layer);
+            }
+        }
+        // Added, removed and reordered layers all change the order, which is then recorded in
+        // full so that the entry is expanded back to the same order.
+        if (layerOrder != mPreviousLayerOrder) {
+            entry.mutable_layer_order()->Add(layerOrder.begin(), layerOrder.end());
+        }
+        entry.mutable_layers()->Swap(&changedLayers);
+        entry.set_is_delta(true);
+    }
+    mPreviousLayers = std::move(layers);
+    mPreviousLayerOrder = std::move(layerOrder);
+    mEntriesSinceKeyframe =
+            hasDuplicateIds ? 0 : (mEntriesSinceKeyframe + 1) % KEYFRAME_INTERVAL;
     mBuffer->emplace(std::move(entry));
 }
 
+void LayerTracing::writeToProtoLocked(LayersTraceFileProto& fileProto) {
+    mBuffer->writeToProto(fileProto);
+    expandDeltas(fileProto);
+}
+
+void LayerTracing::expandDeltas(LayersTraceFileProto& fileProto) {
+    google::protobuf::RepeatedPtrField<LayersTraceProto> entries;
+    entries.Swap(fileProto.mutable_entry());
+    fileProto.mutable_entry()->Reserve(entries.size());
+
+    std::unordered_map<int32_t, LayerProto> layers;
+    std::vector<int32_t> layerOrder;
+    bool hasKeyframe = false;
+    for (LayersTraceProto& entry : entries) {
+        if (!entry.is_delta()) {
+            layers.clear();
+            layerOrder.clear();
+            for (const LayerProto& layer : entry.layers().layers()) {
+                layers[layer.id()] = layer;
+                layerOrder.push_back(layer.id());
+            }
+            hasKeyframe = true;
+            fileProto.add_entry()->Swap(&entry);
+            continue;
+        }
+        if (!hasKeyframe) {
+            // The keyframe this delta applies to was pushed out of the buffer.
+            continue;
+        }
+
+        for (LayerProto& layer : *entry.mutable_layers()->mutable_layers()) {
+            layers[layer.id()].Swap(&layer);
+        }
+        if (entry.layer_order_size() > 0) {
+            layerOrder.assign(entry.layer_order().begin(), entry.layer_order().end());
+            std::unordered_set<int32_t> ids(layerOrder.begin(), layerOrder.end());
+            for (auto it = layers.begin(); it != layers.end();) {
+                if (ids.count(it->first) == 0) {
+                    it = layers.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+
+        entry.clear_is_delta();
+        entry.clear_layer_order();
+        auto* entryLayers = entry.mutable_layers()->mutable_layers();
+        entryLayers->Clear();
+        entryLayers->Reserve(static_cast<int32_t>(layerOrder.size()));
+        for (int32_t id : layerOrder) {
+            *entryLayers->Add() = layers[id];
+        }
+        fileProto.add_entry()->Swap(&entry);
+    }
+}
+
 } // namespace android
@@ -22,8 +22,13 @@
 #include <utils/StrongPointer.h>
 #include <utils/Timers.h>
 
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace android::surfaceflinger;
 
@@ -37,6 +42,10 @@ class SurfaceFlinger;
 /*
  * LayerTracing records layer states during surface flinging. Manages tracing state and
  * configuration.
+ *
+ * Entries are handed to a tracing thread, which stores them in the ring buffer as deltas that
+ * only hold the layers which changed since the previous entry, with a full keyframe every
+ * KEYFRAME_INTERVAL entries. Deltas are expanded back to full entries when the trace is written.
  */
 class LayerTracing {
 public:
@@ -68,12 +77,35 @@ public:
 
 private:
     static constexpr auto FILE_NAME = "/data/misc/wmtrace/layers_trace.winscope";
+    // Bounds how many deltas at the start of the buffer are dropped on write once their keyframe
+    // was pushed out.
+    static constexpr uint32_t KEYFRAME_INTERVAL = 64;
+
+    void loop();
+    // Waits until the tracing thread added all the entries notified so far to the buffer.
+    void flush();
+    void addEntryLocked(LayersTraceProto& entry) REQUIRES(mTraceLock);
+    void writeToProtoLocked(LayersTraceFileProto& fileProto) REQUIRES(mTraceLock);
+    static void expandDeltas(LayersTraceFileProto& fileProto);
+
     uint32_t mFlags = TRACE_INPUT;
     mutable std::mutex mTraceLock;
     bool mEnabled GUARDED_BY(mTraceLock) = false;
     std::unique_ptr<RingBuffer<LayersTraceFileProto, LayersTraceProto>> mBuffer
             GUARDED_BY(mTraceLock);
     size_t mBufferSizeInBytes GUARDED_BY(mTraceLock) = 20 * 1024 * 1024;
+    // Serialized layers of the previous entry, by layer id, and their ids in order.
+    std::unordered_map<int32_t, std::string> mPreviousLayers GUARDED_BY(mTraceLock);
+    std::vector<int32_t> mPreviousLayerOrder GUARDED_BY(mTraceLock);
+    uint32_t mEntriesSinceKeyframe GUARDED_BY(mTraceLock) = 0;
+
+    std::mutex mPendingLock;
+    std::condition_variable mPendingCv;
+    std::condition_variable mPendingDrainedCv;
+    std::vector<LayersTraceProto> mPendingEntries GUARDED_BY(mPendingLock);
+    bool mAddingEntries GUARDED_BY(mPendingLock) = false;
+    bool mDone GUARDED_BY(mPendingLock) = false;
+    std::thread mThread;
 };
 
 } // namespace android
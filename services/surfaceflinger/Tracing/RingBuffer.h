@@ -59,6 +59,16 @@ public:
     status_t writeToFile(FileProto& fileProto, std::string filename) {
         ATRACE_CALL();
         writeToProto(fileProto);
+        return writeProtoToFile(fileProto, filename);
+    }
+
+    status_t appendToStream(FileProto& fileProto, std::ofstream& out) {
+        ATRACE_CALL();
+        writeToProto(fileProto);
+        return appendProtoToStream(fileProto, out);
+    }
+
+    static status_t writeProtoToFile(const FileProto& fileProto, const std::string& filename) {
         std::string output;
         if (!fileProto.SerializeToString(&output)) {
             ALOGE("Could not serialize proto.");
@@ -74,9 +84,7 @@ public:
         return NO_ERROR;
     }
 
-    status_t appendToStream(FileProto& fileProto, std::ofstream& out) {
-        ATRACE_CALL();
-        writeToProto(fileProto);
+    static status_t appendProtoToStream(const FileProto& fileProto, std::ofstream& out) {
         std::string output;
         if (!fileProto.SerializeToString(&output)) {
             ALOGE("Could not serialize proto.");
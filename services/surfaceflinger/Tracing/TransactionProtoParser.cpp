@@ -79,6 +79,55 @@ proto::TransactionState TransactionProtoParser::toProto(const TransactionState&
     return proto;
 }
 
+TransactionState TransactionProtoParser::copyForProto(const TransactionState& t) {
+    TransactionState copy;
+    copy.originPid = t.originPid;
+    copy.originUid = t.originUid;
+    copy.frameTimelineInfo = t.frameTimelineInfo;
+    copy.postTime = t.postTime;
+    copy.id = t.id;
+    copy.displays = t.displays;
+    copy.mergedTransactionIds = t.mergedTransactionIds;
+
+    copy.states.reserve(t.states.size());
+    for (const ResolvedComposerState& source : t.states) {
+        ResolvedComposerState& state = copy.states.emplace_back();
+        state.state = source.state;
+        state.layerId = source.layerId;
+        state.parentId = source.parentId;
+        state.relativeParentId = source.relativeParentId;
+        state.touchCropId = source.touchCropId;
+
+        layer_state_t& layer = state.state;
+        layer.surface = nullptr;
+        layer.relativeLayerSurfaceControl = nullptr;
+        layer.parentSurfaceControlForChild = nullptr;
+        layer.listeners.clear();
+        if (!(layer.what & layer_state_t::eBufferChanged) || !source.state.bufferData) {
+            layer.bufferData = nullptr;
+            continue;
+        }
+        const BufferData& bufferData = *source.state.bufferData;
+        if (source.externalTexture) {
+            const renderengine::ExternalTexture& texture = *source.externalTexture;
+            state.externalTexture =
+                    std::make_shared<FakeExternalTexture>(texture.getWidth(), texture.getHeight(),
+                                                          texture.getId(),
+                                                          texture.getPixelFormat(),
+                                                          texture.getUsage());
+        }
+        layer.bufferData =
+                std::make_shared<fake::BufferData>(bufferData.getId(), bufferData.getWidth(),
+                                                   bufferData.getHeight(),
+                                                   bufferData.getPixelFormat(),
+                                                   bufferData.getUsage());
+        layer.bufferData->frameNumber = bufferData.frameNumber;
+        layer.bufferData->flags = bufferData.flags;
+        layer.bufferData->cachedBuffer.id = bufferData.cachedBuffer.id;
+    }
+    return copy;
+}
+
 proto::TransactionState TransactionProtoParser::toProto(
         const std::map<uint32_t /* layerId */, TracingLayerState>& states) {
     proto::TransactionState proto;
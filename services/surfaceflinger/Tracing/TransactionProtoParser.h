@@ -46,6 +46,10 @@ public:
           : mMapper(std::move(provider)) {}
 
     proto::TransactionState toProto(const TransactionState&);
+    // Returns a copy of the transaction with only what toProto reads, so that it can be encoded
+    // later on another thread. Buffers are replaced by their properties and callbacks, fences and
+    // surface controls are dropped, so the copy doesn't keep them alive.
+    static TransactionState copyForProto(const TransactionState&);
     proto::TransactionState toProto(const std::map<uint32_t /* layerId */, TracingLayerState>&);
     proto::LayerCreationArgs toProto(const LayerCreationArgs& args);
     proto::LayerState toProto(const ResolvedComposerState&);
@@ -53,6 +53,9 @@ TransactionTracing::~TransactionTracing() {
         thread.join();
     }
 
+    while (TransactionState* transaction = mTransactionQueue.pop()) {
+        delete transaction;
+    }
     writeToFile();
 }
 
@@ -88,8 +91,8 @@ void TransactionTracing::dump(std::string& result) const {
 }
 
 void TransactionTracing::addQueuedTransaction(const TransactionState& transaction) {
-    proto::TransactionState* state = new proto::TransactionState(mProtoParser.toProto(transaction));
-    mTransactionQueue.push(state);
+    // Encoding happens on the tracing thread, so the binder thread only pays for the copy.
+    mTransactionQueue.push(new TransactionState(TransactionProtoParser::copyForProto(transaction)));
 }
 
 void TransactionTracing::addCommittedTransactions(
@@ -145,18 +148,33 @@ void TransactionTracing::loop() {
     }
 }
 
+void TransactionTracing::drainTransactionQueue() {
+    std::vector<proto::TransactionState> transactions;
+    while (TransactionState* transaction = mTransactionQueue.pop()) {
+        transactions.emplace_back(mProtoParser.toProto(*transaction));
+        delete transaction;
+    }
+    if (transactions.empty()) {
+        return;
+    }
+
+    std::scoped_lock lock(mTraceLock);
+    for (proto::TransactionState& transaction : transactions) {
+        const uint64_t id = transaction.transaction_id();
+        mQueuedTransactions[id] = std::move(transaction);
+    }
+}
+
 void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committedUpdates,
                                   const std::vector<uint32_t>& destroyedLayers) {
     ATRACE_CALL();
+    // Encode the queued transactions before taking the lock, so that dump and writeToFile don't
+    // wait for it.
+    drainTransactionQueue();
+
     std::scoped_lock lock(mTraceLock);
     std::vector<std::string> removedEntries;
     proto::TransactionTraceEntry entryProto;
-
-    while (auto incomingTransaction = mTransactionQueue.pop()) {
-        auto transaction = *incomingTransaction;
-        mQueuedTransactions[incomingTransaction->transaction_id()] = transaction;
-        delete incomingTransaction;
-    }
     for (const CommittedUpdates& update : committedUpdates) {
         entryProto.set_elapsed_realtime_nanos(update.timestamp);
         entryProto.set_vsync_id(update.vsyncId);
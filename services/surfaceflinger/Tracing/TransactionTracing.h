@@ -43,11 +43,12 @@ class TransactionTracingTest;
 /*
  * Records all committed transactions into a ring bufffer.
  *
- * Transactions come in via the binder thread. They are serialized to proto
- * and stored in a map using the transaction id as key. Main thread will
- * pass the list of transaction ids that are committed every vsync and notify
- * the tracing thread. The tracing thread will then wake up and add the
- * committed transactions to the ring buffer.
+ * Transactions come in via the binder thread. A copy of the parts that are
+ * traced is queued without taking a lock, and the tracing thread serializes
+ * them to proto and stores them in a map using the transaction id as key.
+ * Main thread will pass the list of transaction ids that are committed every
+ * vsync and notify the tracing thread. The tracing thread will then wake up
+ * and add the committed transactions to the ring buffer.
  *
  * When generating SF dump state, we will flush the buffer to a file which
  * will then be included in the bugreport.
@@ -84,7 +85,7 @@ private:
     size_t mBufferSizeInBytes GUARDED_BY(mTraceLock) = CONTINUOUS_TRACING_BUFFER_SIZE;
     std::unordered_map<uint64_t, proto::TransactionState> mQueuedTransactions
             GUARDED_BY(mTraceLock);
-    LocklessStack<proto::TransactionState> mTransactionQueue;
+    LocklessStack<TransactionState> mTransactionQueue;
     nsecs_t mStartingTimestamp GUARDED_BY(mTraceLock);
     std::unordered_map<int, proto::LayerCreationArgs> mCreatedLayers GUARDED_BY(mTraceLock);
     std::map<uint32_t /* layerId */, TracingLayerState> mStartingStates GUARDED_BY(mTraceLock);
@@ -118,6 +119,7 @@ private:
 
     proto::TransactionTraceFile createTraceFileProto() const;
     void loop();
+    void drainTransactionQueue();
     void addEntry(const std::vector<CommittedUpdates>& committedTransactions,
                   const std::vector<uint32_t>& removedLayers) EXCLUDES(mTraceLock);
     int32_t getLayerIdLocked(const sp<IBinder>& layerHandle) REQUIRES(mTraceLock);
@@ -19,10 +19,14 @@
 //#define LOG_NDEBUG 0
 
 #include <Tracing/TransactionProtoParser.h>
+#include <android-base/stringprintf.h>
 #include <gui/LayerState.h>
 #include <log/log.h>
 #include <renderengine/ExternalTexture.h>
 #include <utils/String16.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <ios>
@@ -30,6 +34,7 @@
 #include <vector>
 #include "FrontEnd/LayerCreationArgs.h"
 #include "FrontEnd/RequestedLayerState.h"
+#include "FrontEnd/TransactionHandler.h"
 #include "LayerProtoHelper.h"
 #include "Tracing/LayerTracing.h"
 #include "TransactionState.h"
@@ -40,6 +45,38 @@
 namespace android {
 using namespace ftl::flag_operators;
 
+namespace {
+
+std::vector<TransactionState> parseTransactions(TransactionProtoParser& parser,
+                                                const proto::TransactionTraceEntry& entry) {
+    std::vector<TransactionState> transactions;
+    transactions.reserve((size_t)entry.transactions_size());
+    for (int j = 0; j < entry.transactions_size(); j++) {
+        // apply transactions
+        TransactionState transaction = parser.fromProto(entry.transactions(j));
+        for (auto& resolvedComposerState : transaction.states) {
+            if (resolvedComposerState.state.what & layer_state_t::eInputInfoChanged) {
+                if (!resolvedComposerState.state.windowInfoHandle->getInfo()->inputConfig.test(
+                            gui::WindowInfo::InputConfig::NO_INPUT_CHANNEL)) {
+                    // create a fake token since the FE expects a valid token
+                    resolvedComposerState.state.windowInfoHandle->editInfo()->token =
+                            sp<BBinder>::make();
+                }
+            }
+        }
+        transactions.emplace_back(std::move(transaction));
+    }
+    return transactions;
+}
+
+bool supportsBackgroundBlur() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.surface_flinger.supports_background_blur", value, "0");
+    return atoi(value);
+}
+
+} // namespace
+
 bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
                                    const char* outputLayersTracePath) {
     if (traceFile.entry_size() == 0) {
@@ -56,9 +93,7 @@ bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
     display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> displayInfos;
 
     renderengine::ShadowSettings globalShadowSettings{.ambientColor = {1, 1, 1, 1}};
-    char value[PROPERTY_VALUE_MAX];
-    property_get("ro.surface_flinger.supports_background_blur", value, "0");
-    bool supportsBlur = atoi(value);
+    bool supportsBlur = supportsBackgroundBlur();
 
     LayerTracing layerTracing;
     layerTracing.setTraceFlags(LayerTracing::TRACE_INPUT | LayerTracing::TRACE_BUFFERS);
@@ -87,23 +122,7 @@ bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
             addedLayers.emplace_back(std::make_unique<frontend::RequestedLayerState>(args));
         }
 
-        std::vector<TransactionState> transactions;
-        transactions.reserve((size_t)entry.transactions_size());
-        for (int j = 0; j < entry.transactions_size(); j++) {
-            // apply transactions
-            TransactionState transaction = parser.fromProto(entry.transactions(j));
-            for (auto& resolvedComposerState : transaction.states) {
-                if (resolvedComposerState.state.what & layer_state_t::eInputInfoChanged) {
-                    if (!resolvedComposerState.state.windowInfoHandle->getInfo()->inputConfig.test(
-                                gui::WindowInfo::InputConfig::NO_INPUT_CHANNEL)) {
-                        // create a fake token since the FE expects a valid token
-                        resolvedComposerState.state.windowInfoHandle->editInfo()->token =
-                                sp<BBinder>::make();
-                    }
-                }
-            }
-            transactions.emplace_back(std::move(transaction));
-        }
+        std::vector<TransactionState> transactions = parseTransactions(parser, entry);
 
         for (int j = 0; j < entry.destroyed_layers_size(); j++) {
             ALOGV("       destroyedHandles=%d", entry.destroyed_layers(j));
@@ -168,4 +187,166 @@ bool LayerTraceGenerator::generate(const proto::TransactionTraceFile& traceFile,
     return true;
 }
 
+namespace {
+
+// The stages of the FrontEnd that SurfaceFlinger runs on every commit, in order.
+enum class Stage {
+    Parse,
+    TransactionHandler,
+    Lifecycle,
+    Hierarchy,
+    Snapshots,
+    WindowInfos,
+    Commit,
+};
+constexpr size_t kStageCount = static_cast<size_t>(Stage::Commit) + 1;
+constexpr std::array<const char*, kStageCount> kStageNames = {
+        "parse",     "transactionHandler", "lifecycle", "hierarchy",
+        "snapshots", "windowInfos",        "commit",
+};
+
+std::chrono::nanoseconds percentile(const std::vector<std::chrono::nanoseconds>& sorted,
+                                    size_t percent) {
+    if (sorted.empty()) {
+        return std::chrono::nanoseconds(0);
+    }
+    return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+} // namespace
+
+bool LayerTraceGenerator::benchmark(const proto::TransactionTraceFile& traceFile, int iterations,
+                                    std::string& result) {
+    using base::StringAppendF;
+    using Clock = std::chrono::steady_clock;
+
+    if (traceFile.entry_size() == 0) {
+        ALOGD("Trace file is empty");
+        return false;
+    }
+
+    renderengine::ShadowSettings globalShadowSettings{.ambientColor = {1, 1, 1, 1}};
+    const bool supportsBlur = supportsBackgroundBlur();
+
+    // The time each stage took for every entry, across all iterations.
+    std::array<std::vector<std::chrono::nanoseconds>, kStageCount> durations;
+    for (auto& stageDurations : durations) {
+        stageDurations.reserve(static_cast<size_t>(iterations * traceFile.entry_size()));
+    }
+
+    std::vector<gui::WindowInfo> windowInfos;
+    std::vector<gui::DisplayInfo> windowDisplayInfos;
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        // Each iteration replays the trace from scratch.
+        TransactionProtoParser parser(
+                std::make_unique<TransactionProtoParser::FlingerDataMapper>());
+        frontend::TransactionHandler transactionHandler;
+        frontend::LayerLifecycleManager lifecycleManager;
+        frontend::LayerHierarchyBuilder hierarchyBuilder{{}};
+        frontend::LayerSnapshotBuilder snapshotBuilder;
+        display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> displayInfos;
+
+        for (int i = 0; i < traceFile.entry_size(); i++) {
+            const proto::TransactionTraceEntry& entry = traceFile.entry(i);
+            Clock::time_point start = Clock::now();
+            const auto endStage = [&](Stage stage) {
+                const Clock::time_point end = Clock::now();
+                durations[static_cast<size_t>(stage)].push_back(end - start);
+                start = end;
+            };
+
+            std::vector<std::unique_ptr<frontend::RequestedLayerState>> addedLayers;
+            addedLayers.reserve((size_t)entry.added_layers_size());
+            for (int j = 0; j < entry.added_layers_size(); j++) {
+                LayerCreationArgs args;
+                parser.fromProto(entry.added_layers(j), args);
+                addedLayers.emplace_back(std::make_unique<frontend::RequestedLayerState>(args));
+            }
+            std::vector<TransactionState> parsedTransactions = parseTransactions(parser, entry);
+            std::vector<uint32_t> destroyedHandles(entry.destroyed_layer_handles().begin(),
+                                                   entry.destroyed_layer_handles().end());
+            const bool displayChanged = entry.displays_changed();
+            if (displayChanged) {
+                parser.fromProto(entry.displays(), displayInfos);
+            }
+            endStage(Stage::Parse);
+
+            // There are no ready filters, so the transactions of every entry are applied in the
+            // frame they were traced in, ordered the same way SurfaceFlinger orders them.
+            for (auto& transaction : parsedTransactions) {
+                transactionHandler.queueTransaction(std::move(transaction));
+            }
+            std::vector<TransactionState> transactions = transactionHandler.flushTransactions();
+            endStage(Stage::TransactionHandler);
+
+            lifecycleManager.addLayers(std::move(addedLayers));
+            lifecycleManager.applyTransactions(transactions, /*ignoreUnknownHandles=*/true);
+            lifecycleManager.onHandlesDestroyed(destroyedHandles, /*ignoreUnknownHandles=*/true);
+            endStage(Stage::Lifecycle);
+
+            if (lifecycleManager.getGlobalChanges().test(
+                        frontend::RequestedLayerState::Changes::Hierarchy)) {
+                hierarchyBuilder.update(lifecycleManager.getLayers(),
+                                        lifecycleManager.getDestroyedLayers());
+            }
+            endStage(Stage::Hierarchy);
+
+            frontend::LayerSnapshotBuilder::Args args{.root = hierarchyBuilder.getHierarchy(),
+                                                      .layerLifecycleManager = lifecycleManager,
+                                                      .displays = displayInfos,
+                                                      .displayChanges = displayChanged,
+                                                      .globalShadowSettings =
+                                                              globalShadowSettings,
+                                                      .supportsBlur = supportsBlur,
+                                                      .forceFullDamage = false,
+                                                      .supportedLayerGenericMetadata = {},
+                                                      .genericLayerMetadataKeyMap = {}};
+            snapshotBuilder.update(args);
+            endStage(Stage::Snapshots);
+
+            // Same as SurfaceFlinger::buildWindowInfos.
+            const size_t numWindowInfos = windowInfos.size();
+            windowInfos.clear();
+            windowInfos.reserve(numWindowInfos);
+            snapshotBuilder.forEachInputSnapshot(
+                    [&windowInfos](const frontend::LayerSnapshot& snapshot) {
+                        windowInfos.push_back(snapshot.inputInfo);
+                    });
+            windowDisplayInfos.clear();
+            windowDisplayInfos.reserve(displayInfos.size());
+            for (const auto& [_, info] : displayInfos) {
+                windowDisplayInfos.push_back(info.info);
+            }
+            endStage(Stage::WindowInfos);
+
+            lifecycleManager.commitChanges();
+            endStage(Stage::Commit);
+        }
+    }
+
+    StringAppendF(&result, "Replayed %d entries %d times\n", traceFile.entry_size(), iterations);
+    StringAppendF(&result, "%-20s %12s %10s %10s %10s %10s\n", "stage", "total(ms)", "mean(us)",
+                  "p50(us)", "p99(us)", "max(us)");
+    using std::chrono::duration;
+    std::chrono::nanoseconds total(0);
+    for (size_t i = 0; i < kStageCount; i++) {
+        std::vector<std::chrono::nanoseconds>& stageDurations = durations[i];
+        std::sort(stageDurations.begin(), stageDurations.end());
+        std::chrono::nanoseconds stageTotal(0);
+        for (const auto& d : stageDurations) {
+            stageTotal += d;
+        }
+        total += stageTotal;
+        StringAppendF(&result, "%-20s %12.3f %10.2f %10.2f %10.2f %10.2f\n", kStageNames[i],
+                      duration<double, std::milli>(stageTotal).count(),
+                      duration<double, std::micro>(stageTotal).count() /
+                              static_cast<double>(std::max<size_t>(stageDurations.size(), 1)),
+                      duration<double, std::micro>(percentile(stageDurations, 50)).count(),
+                      duration<double, std::micro>(percentile(stageDurations, 99)).count(),
+                      duration<double, std::micro>(percentile(stageDurations, 100)).count());
+    }
+    StringAppendF(&result, "%-20s %12.3f\n", "total", duration<double, std::milli>(total).count());
+    return true;
+}
+
 } // namespace android
@@ -22,5 +22,8 @@ namespace android {
 class LayerTraceGenerator {
 public:
     bool generate(const proto::TransactionTraceFile&, const char* outputLayersTracePath);
+    // Replays the trace through the FrontEnd iterations times, without generating layer traces,
+    // and appends the time each FrontEnd stage took per entry to result.
+    bool benchmark(const proto::TransactionTraceFile&, int iterations, std::string& result);
 };
 } // namespace android
\ No newline at end of file
@@ -17,6 +17,9 @@
 #undef LOG_TAG
 #define LOG_TAG "LayerTraceGenerator"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -25,25 +28,75 @@
 
 using namespace android;
 
-int main(int argc, char** argv) {
-    if (argc > 3) {
-        std::cout << "Usage: " << argv[0]
-                  << " [transaction-trace-path] [output-layers-trace-path]\n";
-        return -1;
-    }
+namespace {
 
-    const char* transactionTracePath =
-            (argc > 1) ? argv[1] : "/data/misc/wmtrace/transactions_trace.winscope";
+constexpr const char* kDefaultTransactionTracePath =
+        "/data/misc/wmtrace/transactions_trace.winscope";
+constexpr int kDefaultBenchmarkIterations = 10;
+
+void printUsage(const char* name) {
+    std::cout << "Usage: " << name << " [transaction-trace-path] [output-layers-trace-path]\n"
+              << "       " << name << " --benchmark [transaction-trace-path] [iterations]\n";
+}
+
+bool parseTraceFile(const char* transactionTracePath,
+                    proto::TransactionTraceFile& transactionTraceFile) {
     std::cout << "Parsing " << transactionTracePath << "\n";
     std::fstream input(transactionTracePath, std::ios::in | std::ios::binary);
     if (!input) {
         std::cout << "Error: Could not open " << transactionTracePath;
-        return -1;
+        return false;
     }
 
-    proto::TransactionTraceFile transactionTraceFile;
     if (!transactionTraceFile.ParseFromIstream(&input)) {
         std::cout << "Error: Failed to parse " << transactionTracePath;
+        return false;
+    }
+    return true;
+}
+
+int runBenchmark(int argc, char** argv) {
+    if (argc > 4) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    const char* transactionTracePath = (argc > 2) ? argv[2] : kDefaultTransactionTracePath;
+    const int iterations = (argc > 3) ? atoi(argv[3]) : kDefaultBenchmarkIterations;
+    if (iterations <= 0) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    proto::TransactionTraceFile transactionTraceFile;
+    if (!parseTraceFile(transactionTracePath, transactionTraceFile)) {
+        return -1;
+    }
+
+    std::string result;
+    if (!LayerTraceGenerator().benchmark(transactionTraceFile, iterations, result)) {
+        std::cout << "Error: Failed to replay " << transactionTracePath;
+        return -1;
+    }
+    std::cout << result;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        return runBenchmark(argc, argv);
+    }
+
+    if (argc > 3) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    const char* transactionTracePath = (argc > 1) ? argv[1] : kDefaultTransactionTracePath;
+    proto::TransactionTraceFile transactionTraceFile;
+    if (!parseTraceFile(transactionTracePath, transactionTraceFile)) {
         return -1;
     }
 
@@ -58,4 +111,4 @@ int main(int argc, char** argv) {
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
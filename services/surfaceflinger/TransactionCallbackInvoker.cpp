@@ -176,7 +176,29 @@ void TransactionCallbackInvoker::addPresentFence(sp<Fence> presentFence) {
     mPresentFence = std::move(presentFence);
 }
 
+void TransactionCallbackInvoker::addReleasedBuffer(const sp<IBinder>& listener,
+                                                   ReleasedBufferStats releasedBuffer) {
+    mReleasedBuffers[listener].push_back(std::move(releasedBuffer));
+}
+
 void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
+    const auto sendListenerStats = [](BackgroundExecutor::Callbacks& callbacks,
+                                      ListenerStats&& listenerStats) {
+        // If the listener is still alive
+        if (listenerStats.listener->isBinderAlive()) {
+            // Send callback.  The listener stored in listenerStats
+            // comes from the cross-process setTransactionState call to
+            // SF.  This MUST be an ITransactionCompletedListener.  We
+            // keep it as an IBinder due to consistency reasons: if we
+            // interface_cast at the IPC boundary when reading a Parcel,
+            // we get pointers that compare unequal in the SF process.
+            callbacks.emplace_back([stats = std::move(listenerStats)]() {
+                interface_cast<ITransactionCompletedListener>(stats.listener)
+                        ->onTransactionCompleted(stats);
+            });
+        }
+    };
+
     // For each listener
     auto completedTransactionsItr = mCompletedTransactions.begin();
     BackgroundExecutor::Callbacks callbacks;
@@ -184,6 +206,14 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
         auto& [listener, transactionStatsDeque] = *completedTransactionsItr;
         ListenerStats listenerStats;
         listenerStats.listener = listener;
+        listenerStats.transactionStats.reserve(transactionStatsDeque.size());
+
+        // Releases are not tied to a frame, so they go out with commit callbacks too.
+        if (auto releasedBuffersItr = mReleasedBuffers.find(listener);
+            releasedBuffersItr != mReleasedBuffers.end()) {
+            listenerStats.releasedBuffers = std::move(releasedBuffersItr->second);
+            mReleasedBuffers.erase(releasedBuffersItr);
+        }
 
         // For each transaction
         auto transactionStatsItr = transactionStatsDeque.begin();
@@ -204,30 +234,29 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
             listenerStats.transactionStats.push_back(std::move(transactionStats));
             transactionStatsItr = transactionStatsDeque.erase(transactionStatsItr);
         }
-        // If the listener has completed transactions
-        if (!listenerStats.transactionStats.empty()) {
-            // If the listener is still alive
-            if (listener->isBinderAlive()) {
-                // Send callback.  The listener stored in listenerStats
-                // comes from the cross-process setTransactionState call to
-                // SF.  This MUST be an ITransactionCompletedListener.  We
-                // keep it as an IBinder due to consistency reasons: if we
-                // interface_cast at the IPC boundary when reading a Parcel,
-                // we get pointers that compare unequal in the SF process.
-                callbacks.emplace_back([stats = std::move(listenerStats)]() {
-                    interface_cast<ITransactionCompletedListener>(stats.listener)
-                            ->onTransactionCompleted(stats);
-                });
-            }
+        // If the listener has completed transactions or released buffers
+        if (!listenerStats.transactionStats.empty() || !listenerStats.releasedBuffers.empty()) {
+            sendListenerStats(callbacks, std::move(listenerStats));
         }
         completedTransactionsItr++;
     }
 
+    // Listeners with released buffers but no completed transactions
+    for (auto& [listener, releasedBuffers] : mReleasedBuffers) {
+        ListenerStats listenerStats;
+        listenerStats.listener = listener;
+        listenerStats.releasedBuffers = std::move(releasedBuffers);
+        sendListenerStats(callbacks, std::move(listenerStats));
+    }
+    mReleasedBuffers.clear();
+
     if (mPresentFence) {
         mPresentFence.clear();
     }
 
-    BackgroundExecutor::getInstance().sendCallbacks(std::move(callbacks));
+    // Clients may be blocked on buffers released by these callbacks.
+    BackgroundExecutor::getInstance().sendCallbacks(std::move(callbacks),
+                                                    BackgroundExecutor::Priority::High);
 }
 
 // -----------------------------------------------------------------------
@@ -70,6 +70,10 @@ public:
 
     void addPresentFence(sp<Fence>);
 
+    // Queues a buffer release for the next sendCallbacks, so that the listener gets it in the same
+    // binder call as its transaction callbacks rather than in a call of its own.
+    void addReleasedBuffer(const sp<IBinder>& listener, ReleasedBufferStats releasedBuffer);
+
     void sendCallbacks(bool onCommitOnly);
     void clearCompletedTransactions() {
         mCompletedTransactions.clear();
@@ -87,6 +91,9 @@ private:
     std::unordered_map<sp<IBinder>, std::deque<TransactionStats>, IListenerHash>
         mCompletedTransactions;
 
+    std::unordered_map<sp<IBinder>, std::vector<ReleasedBufferStats>, IListenerHash>
+            mReleasedBuffers;
+
     sp<Fence> mPresentFence;
 };
 
@@ -134,6 +134,8 @@ struct TransactionState {
     uint64_t id;
     bool sentFenceTimeoutWarning = false;
     std::vector<uint64_t> mergedTransactionIds;
+    // The TransactionHandler frame in which the transaction was first considered for flushing.
+    uint64_t queuedFrame = 0;
 };
 
 } // namespace android
@@ -14,9 +14,14 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <limits>
+
+#include <android/gui/BnWindowInfosListener.h>
 #include <android/gui/BnWindowInfosPublisher.h>
 #include <android/gui/IWindowInfosPublisher.h>
 #include <android/gui/WindowInfosListenerInfo.h>
+#include <binder/BpBinder.h>
 #include <gui/ISurfaceComposer.h>
 #include <gui/TraceUtils.h>
 #include <gui/WindowInfosUpdate.h>
@@ -35,18 +40,22 @@ using gui::IWindowInfosListener;
 using gui::WindowInfo;
 
 void WindowInfosListenerInvoker::addWindowInfosListener(sp<IWindowInfosListener> listener,
-                                                        gui::WindowInfosListenerInfo* outInfo) {
+                                                        gui::WindowInfosListenerInfo* outInfo,
+                                                        bool supportsDeltaUpdates) {
     int64_t listenerId = mNextListenerId++;
     outInfo->listenerId = listenerId;
     outInfo->windowInfosPublisher = sp<gui::IWindowInfosPublisher>::fromExisting(this);
 
     BackgroundExecutor::getInstance().sendCallbacks(
-            {[this, listener = std::move(listener), listenerId]() {
+            {[this, listener = std::move(listener), listenerId, supportsDeltaUpdates]() {
                 ATRACE_NAME("WindowInfosListenerInvoker::addWindowInfosListener");
                 sp<IBinder> asBinder = IInterface::asBinder(listener);
                 asBinder->linkToDeath(sp<DeathRecipient>::fromExisting(this));
                 mWindowInfosListeners.try_emplace(asBinder,
-                                                  std::make_pair(listenerId, std::move(listener)));
+                                                  Listener{.id = listenerId,
+                                                           .listener = std::move(listener),
+                                                           .supportsDeltaUpdates =
+                                                                   supportsDeltaUpdates});
             }});
 }
 
@@ -64,20 +73,13 @@ void WindowInfosListenerInvoker::binderDied(const wp<IBinder>& who) {
     BackgroundExecutor::getInstance().sendCallbacks({[this, who]() {
         ATRACE_NAME("WindowInfosListenerInvoker::binderDied");
         auto it = mWindowInfosListeners.find(who);
-        int64_t listenerId = it->second.first;
-        mWindowInfosListeners.erase(who);
-
-        std::vector<int64_t> vsyncIds;
-        for (auto& [vsyncId, state] : mUnackedState) {
-            if (std::find(state.unackedListenerIds.begin(), state.unackedListenerIds.end(),
-                          listenerId) != state.unackedListenerIds.end()) {
-                vsyncIds.push_back(vsyncId);
-            }
+        if (it == mWindowInfosListeners.end()) {
+            return;
         }
+        int64_t listenerId = it->second.id;
+        mWindowInfosListeners.erase(who);
 
-        for (int64_t vsyncId : vsyncIds) {
-            ackWindowInfosReceived(vsyncId, listenerId);
-        }
+        ackUpToVsyncId(std::numeric_limits<int64_t>::max(), listenerId);
     }});
 }
 
@@ -91,24 +93,9 @@ void WindowInfosListenerInvoker::windowInfosChanged(
         };
     }
 
-    // If there are unacked messages and this isn't a forced call, then return immediately.
-    // If a forced window infos change doesn't happen first, the update will be sent after
-    // the WindowInfosReportedListeners are called. If a forced window infos change happens or
-    // if there are subsequent delayed messages before this update is sent, then this message
-    // will be dropped and the listeners will only be called with the latest info. This is done
-    // to reduce the amount of binder memory used.
-    if (!mUnackedState.empty() && !forceImmediateCall) {
-        mDelayedUpdate = std::move(update);
-        mReportedListeners.merge(reportedListeners);
-        return;
-    }
-
-    if (mDelayedUpdate) {
-        mDelayedUpdate.reset();
-    }
-
     if (CC_UNLIKELY(mWindowInfosListeners.empty())) {
         mReportedListeners.merge(reportedListeners);
+        mLatestUpdate.reset();
         mDelayInfo.reset();
         return;
     }
@@ -116,27 +103,114 @@ void WindowInfosListenerInvoker::windowInfosChanged(
     reportedListeners.merge(mReportedListeners);
     mReportedListeners.clear();
 
-    // Update mUnackedState to include the message we're about to send
-    auto [it, _] = mUnackedState.try_emplace(update.vsyncId,
-                                             UnackedState{.reportedListeners =
-                                                                  std::move(reportedListeners)});
-    auto& unackedState = it->second;
-    for (auto& pair : mWindowInfosListeners) {
-        int64_t listenerId = pair.second.first;
-        unackedState.unackedListenerIds.push_back(listenerId);
+    // Earlier updates that no listener is processing were coalesced into this one, so its acks
+    // cover them. Merge their state into this update's, so that a listener that does not ack only
+    // holds back one entry per update it was sent.
+    ftl::SmallVector<int64_t, kStaticCapacity> coalescedVsyncIds;
+    for (const auto& [vsyncId, state] : mUnackedState) {
+        const bool isUnacked =
+                std::any_of(mWindowInfosListeners.begin(), mWindowInfosListeners.end(),
+                            [vsyncId = vsyncId](const auto& pair) {
+                                return pair.second.unackedVsyncId == vsyncId;
+                            });
+        if (!isUnacked && vsyncId != update.vsyncId) {
+            coalescedVsyncIds.push_back(vsyncId);
+        }
+    }
+    for (int64_t vsyncId : coalescedVsyncIds) {
+        reportedListeners.merge(mUnackedState.find(vsyncId)->second.reportedListeners);
+        mUnackedState.erase(vsyncId);
+    }
+
+    // Every listener has to ack this update, or a later update that it is coalesced into.
+    auto& unackedState = mUnackedState.try_emplace(update.vsyncId).first->second;
+    unackedState.reportedListeners.merge(reportedListeners);
+    for (const auto& [_, listener] : mWindowInfosListeners) {
+        auto& listenerIds = unackedState.unackedListenerIds;
+        if (std::find(listenerIds.begin(), listenerIds.end(), listener.id) == listenerIds.end()) {
+            listenerIds.push_back(listener.id);
+        }
+    }
+
+    // Send a delta to listeners that support it and received the previous update, unless it is
+    // time for a complete update.
+    const bool sendDeltas = mLatestUpdate && mConsecutiveDeltaUpdates < kMaxConsecutiveDeltaUpdates;
+    mConsecutiveDeltaUpdates = sendDeltas ? mConsecutiveDeltaUpdates + 1 : 0;
+    std::optional<gui::WindowInfosUpdate> delta;
+    if (sendDeltas) {
+        const int64_t baseVsyncId = mLatestUpdate->update.vsyncId;
+        const bool needsDelta =
+                std::any_of(mWindowInfosListeners.begin(), mWindowInfosListeners.end(),
+                            [baseVsyncId](const auto& pair) {
+                                return pair.second.supportsDeltaUpdates &&
+                                        pair.second.lastSentVsyncId == baseVsyncId;
+                            });
+        if (needsDelta) {
+            ATRACE_NAME("WindowInfosListenerInvoker::createDelta");
+            delta = gui::WindowInfosUpdate::createDelta(mLatestUpdate->update.windowInfos,
+                                                        baseVsyncId, update);
+        }
     }
 
-    mDelayInfo.reset();
-    updateMaxSendDelay();
+    auto& latestUpdate = mLatestUpdate.emplace();
+    latestUpdate.update = std::move(update);
+    latestUpdate.delta = std::move(delta);
 
-    // Call the listeners
-    for (auto& pair : mWindowInfosListeners) {
-        auto& [listenerId, listener] = pair.second;
-        auto status = listener->onWindowInfosChanged(update);
-        if (!status.isOk()) {
-            ackWindowInfosReceived(update.vsyncId, listenerId);
+    // Listeners still processing an earlier update receive this one once they ack, unless a newer
+    // update replaces it first. A forced update is sent to every listener right away.
+    bool hasPendingUpdates = false;
+    for (auto& [_, listener] : mWindowInfosListeners) {
+        if (listener.unackedVsyncId && !forceImmediateCall) {
+            listener.hasPendingUpdate = true;
+            hasPendingUpdates = true;
+        } else {
+            sendLatestUpdate(listener);
         }
     }
+
+    if (!hasPendingUpdates) {
+        mDelayInfo.reset();
+    }
+}
+
+void WindowInfosListenerInvoker::sendLatestUpdate(Listener& listener) {
+    auto& latestUpdate = *mLatestUpdate;
+    const bool sendDelta = latestUpdate.delta && listener.supportsDeltaUpdates &&
+            listener.lastSentVsyncId == latestUpdate.delta->baseVsyncId;
+    const gui::WindowInfosUpdate& update = sendDelta ? *latestUpdate.delta : latestUpdate.update;
+    Parcel& parcel = sendDelta ? latestUpdate.deltaParcel : latestUpdate.parcel;
+
+    listener.hasPendingUpdate = false;
+    listener.unackedVsyncId = update.vsyncId;
+
+    // The update is parceled the way the generated proxy does, but only once for all listeners.
+    // RPC binders need a parcel of their own, so they go through the proxy.
+    status_t status;
+    sp<IBinder> asBinder = IInterface::asBinder(listener.listener);
+    BpBinder* remote = asBinder->remoteBinder();
+    if (remote && remote->isRpcBinder()) {
+        status = listener.listener->onWindowInfosChanged(update).transactionError();
+    } else {
+        status = OK;
+        if (parcel.dataSize() == 0) {
+            ATRACE_NAME("WindowInfosListenerInvoker::writeUpdate");
+            parcel.writeInterfaceToken(gui::IWindowInfosListener::descriptor);
+            status = parcel.writeParcelable(update);
+        }
+        if (status == OK) {
+            status = asBinder->transact(gui::BnWindowInfosListener::TRANSACTION_onWindowInfosChanged,
+                                        parcel, nullptr, IBinder::FLAG_ONEWAY);
+        }
+    }
+
+    // A listener that failed to receive this update can't apply the next delta to it.
+    if (status == OK) {
+        listener.lastSentVsyncId = update.vsyncId;
+    } else {
+        listener.lastSentVsyncId.reset();
+        listener.unackedVsyncId.reset();
+        ackUpToVsyncId(update.vsyncId, listener.id);
+    }
 }
 
 WindowInfosListenerInvoker::DebugInfo WindowInfosListenerInvoker::getDebugInfo() {
@@ -166,21 +240,59 @@ binder::Status WindowInfosListenerInvoker::ackWindowInfosReceived(int64_t vsyncI
                                                                   int64_t listenerId) {
     BackgroundExecutor::getInstance().sendCallbacks({[this, vsyncId, listenerId]() {
         ATRACE_NAME("WindowInfosListenerInvoker::ackWindowInfosReceived");
-        auto it = mUnackedState.find(vsyncId);
-        if (it == mUnackedState.end()) {
+        ackUpToVsyncId(vsyncId, listenerId);
+
+        auto it = std::find_if(mWindowInfosListeners.begin(), mWindowInfosListeners.end(),
+                               [listenerId](const auto& pair) {
+                                   return pair.second.id == listenerId;
+                               });
+        if (it == mWindowInfosListeners.end()) {
             return;
         }
 
-        auto& state = it->second;
-        state.unackedListenerIds.unstable_erase(std::find(state.unackedListenerIds.begin(),
-                                                          state.unackedListenerIds.end(),
-                                                          listenerId));
-        if (!state.unackedListenerIds.empty()) {
+        // An ack for an update that a forced update was sent after does not free the listener.
+        auto& listener = it->second;
+        if (!listener.unackedVsyncId || vsyncId < *listener.unackedVsyncId) {
+            return;
+        }
+        listener.unackedVsyncId.reset();
+        if (!listener.hasPendingUpdate || !mLatestUpdate) {
             return;
         }
 
-        WindowInfosReportedListenerSet reportedListeners{std::move(state.reportedListeners)};
-        mUnackedState.erase(vsyncId);
+        sendLatestUpdate(listener);
+
+        const bool hasPendingUpdates =
+                std::any_of(mWindowInfosListeners.begin(), mWindowInfosListeners.end(),
+                            [](const auto& pair) { return pair.second.hasPendingUpdate; });
+        if (!hasPendingUpdates) {
+            updateMaxSendDelay();
+            mDelayInfo.reset();
+        }
+    }});
+    return binder::Status::ok();
+}
+
+void WindowInfosListenerInvoker::ackUpToVsyncId(int64_t vsyncId, int64_t listenerId) {
+    std::vector<int64_t> ackedVsyncIds;
+    for (auto& [unackedVsyncId, state] : mUnackedState) {
+        if (unackedVsyncId > vsyncId) {
+            continue;
+        }
+        auto& listenerIds = state.unackedListenerIds;
+        auto it = std::find(listenerIds.begin(), listenerIds.end(), listenerId);
+        if (it != listenerIds.end()) {
+            listenerIds.unstable_erase(it);
+        }
+        if (listenerIds.empty()) {
+            ackedVsyncIds.push_back(unackedVsyncId);
+        }
+    }
+
+    for (int64_t ackedVsyncId : ackedVsyncIds) {
+        WindowInfosReportedListenerSet reportedListeners{
+                std::move(mUnackedState.find(ackedVsyncId)->second.reportedListeners)};
+        mUnackedState.erase(ackedVsyncId);
 
         for (const auto& reportedListener : reportedListeners) {
             sp<IBinder> asBinder = IInterface::asBinder(reportedListener);
@@ -188,15 +300,7 @@ binder::Status WindowInfosListenerInvoker::ackWindowInfosReceived(int64_t vsyncI
                 reportedListener->onWindowInfosReported();
             }
         }
-
-        if (!mDelayedUpdate || !mUnackedState.empty()) {
-            return;
-        }
-        gui::WindowInfosUpdate update{std::move(*mDelayedUpdate)};
-        mDelayedUpdate.reset();
-        windowInfosChanged(std::move(update), {}, false);
-    }});
-    return binder::Status::ok();
+    }
 }
 
 } // namespace android
@@ -23,6 +23,7 @@
 #include <android/gui/IWindowInfosListener.h>
 #include <android/gui/IWindowInfosReportedListener.h>
 #include <binder/IBinder.h>
+#include <binder/Parcel.h>
 #include <ftl/small_map.h>
 #include <ftl/small_vector.h>
 #include <gui/SpHash.h>
@@ -39,7 +40,10 @@ using WindowInfosReportedListenerSet =
 class WindowInfosListenerInvoker : public gui::BnWindowInfosPublisher,
                                    public IBinder::DeathRecipient {
 public:
-    void addWindowInfosListener(sp<gui::IWindowInfosListener>, gui::WindowInfosListenerInfo*);
+    // If supportsDeltaUpdates is true, the listener may receive updates that only contain the
+    // windows that changed since the previous update. See gui::WindowInfosUpdate::isDelta.
+    void addWindowInfosListener(sp<gui::IWindowInfosListener>, gui::WindowInfosListenerInfo*,
+                                bool supportsDeltaUpdates = false);
     void removeWindowInfosListener(const sp<gui::IWindowInfosListener>& windowInfosListener);
 
     void windowInfosChanged(gui::WindowInfosUpdate update,
@@ -60,20 +64,54 @@ protected:
 
 private:
     static constexpr size_t kStaticCapacity = 3;
+    // Every listener receives a complete update at least once per this many updates so that a
+    // listener that missed a delta recovers.
+    static constexpr size_t kMaxConsecutiveDeltaUpdates = 100;
+
     std::atomic<int64_t> mNextListenerId{0};
-    ftl::SmallMap<wp<IBinder>, const std::pair<int64_t, sp<gui::IWindowInfosListener>>,
-                  kStaticCapacity>
-            mWindowInfosListeners;
+    struct Listener {
+        int64_t id;
+        sp<gui::IWindowInfosListener> listener;
+        bool supportsDeltaUpdates;
+        // The vsync id of the last update the listener received, which a delta update must be
+        // based on. Unset until the listener has received a complete update.
+        std::optional<int64_t> lastSentVsyncId;
+        // The vsync id of the update sent to the listener that has yet to be acked. Updates are
+        // delivered to each listener one at a time, so that a slow listener does not hold back
+        // the others.
+        std::optional<int64_t> unackedVsyncId;
+        // Whether the latest update is waiting for the unacked update to be acked. Later updates
+        // replace it, so only the newest update is delivered.
+        bool hasPendingUpdate = false;
+    };
+    ftl::SmallMap<wp<IBinder>, Listener, kStaticCapacity> mWindowInfosListeners;
+
+    // The latest update, parceled once and shared by every listener it is sent to. The delta is
+    // based on the update before it, and only sent to listeners that received that update.
+    struct LatestUpdate {
+        gui::WindowInfosUpdate update;
+        Parcel parcel;
+        std::optional<gui::WindowInfosUpdate> delta;
+        Parcel deltaParcel;
+    };
+    std::optional<LatestUpdate> mLatestUpdate;
+    size_t mConsecutiveDeltaUpdates = 0;
+
+    void sendLatestUpdate(Listener&);
 
-    std::optional<gui::WindowInfosUpdate> mDelayedUpdate;
     WindowInfosReportedListenerSet mReportedListeners;
 
+    // Listeners ack the updates they receive, and an ack also covers the updates that were
+    // coalesced into the acked update. The WindowInfosReportedListeners of an update are called
+    // once every listener has acked it.
     struct UnackedState {
         ftl::SmallVector<int64_t, kStaticCapacity> unackedListenerIds;
         WindowInfosReportedListenerSet reportedListeners;
     };
     ftl::SmallMap<int64_t /* vsyncId */, UnackedState, 5> mUnackedState;
 
+    void ackUpToVsyncId(int64_t vsyncId, int64_t listenerId);
+
     DebugInfo mDebugInfo;
     struct DelayInfo {
         int64_t vsyncId;
@@ -18,6 +18,7 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
 
+#include <gui/LayerDebugInfo.h>
 #include <thread>
 #include "LayerTransactionTest.h"
 
@@ -37,6 +38,52 @@ TEST_F(LayerTransactionTest, SetTransformToDisplayInverse_BufferState) {
     Transaction().setTransformToDisplayInverse(layer, true).apply();
 }
 
+TEST_F(LayerTransactionTest, CreateSurfacesCreatesAllInOrder) {
+    std::vector<SurfaceComposerClient::SurfaceCreationArgs> args(3);
+    for (size_t i = 0; i < args.size(); i++) {
+        args[i].name = String8::format("CreateSurfaces %zu", i);
+        args[i].w = args[i].h = 32;
+        args[i].format = PIXEL_FORMAT_RGBA_8888;
+        args[i].flags = ISurfaceComposerClient::eFXSurfaceBufferState;
+    }
+
+    std::vector<sp<SurfaceControl>> surfaces;
+    ASSERT_EQ(NO_ERROR, mClient->createSurfacesChecked(args, &surfaces));
+    ASSERT_EQ(args.size(), surfaces.size());
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        ASSERT_TRUE(SurfaceControl::isValid(surfaces[i]));
+        EXPECT_NE(std::string::npos, surfaces[i]->getName().find(args[i].name.string()));
+        if (i > 0) {
+            EXPECT_LT(surfaces[i - 1]->getLayerId(), surfaces[i]->getLayerId());
+        }
+    }
+}
+
+TEST_F(LayerTransactionTest, CreateSurfacesCreatesNoneOnFailure) {
+    std::vector<SurfaceComposerClient::SurfaceCreationArgs> args(2);
+    args[0].name = String8("CreateSurfacesRollback");
+    args[0].w = args[0].h = 32;
+    args[0].format = PIXEL_FORMAT_RGBA_8888;
+    args[0].flags = ISurfaceComposerClient::eFXSurfaceBufferState;
+    // Not a surface type.
+    args[1].name = String8("CreateSurfacesInvalid");
+    args[1].flags = ISurfaceComposerClient::eFXSurfaceMask;
+
+    std::vector<sp<SurfaceControl>> surfaces;
+    EXPECT_NE(NO_ERROR, mClient->createSurfacesChecked(args, &surfaces));
+    EXPECT_TRUE(surfaces.empty());
+
+    // The layer created before the failure goes away once its handle is destroyed.
+    Transaction().apply(true /* synchronous */);
+    Transaction().apply(true /* synchronous */);
+    std::vector<gui::LayerDebugInfo> layers;
+    sp<gui::ISurfaceComposer> sf(ComposerServiceAIDL::getComposerService());
+    ASSERT_EQ(NO_ERROR, statusTFromBinderStatus(sf->getLayerDebugInfo(&layers)));
+    for (const auto& layer : layers) {
+        EXPECT_EQ(std::string::npos, layer.mName.find("CreateSurfacesRollback"));
+    }
+}
+
 TEST_F(LayerTransactionTest, SetSidebandStreamNull_BufferState) {
     sp<SurfaceControl> layer;
     ASSERT_NO_FATAL_FAILURE(
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SchedulerBenchmarks"
+
+#include <benchmark/benchmark.h>
+
+#include <Layer.h>
+#include <scheduler/TimeKeeper.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Scheduler/LayerHistory.h"
+#include "Scheduler/LayerInfo.h"
+#include "Scheduler/RefreshRateSelector.h"
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "Scheduler/VSyncPredictor.h"
+#include "TestableScheduler.h"
+#include "TestableSurfaceFlinger.h"
+#include "VsyncTraces.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+#include "mock/MockLayer.h"
+#include "mock/MockSchedulerCallback.h"
+
+namespace android::scheduler {
+namespace {
+
+using android::mock::createDisplayMode;
+using traces::jitteredVsync;
+using traces::kLayerFrameRates;
+
+constexpr PhysicalDisplayId kDisplayId = PhysicalDisplayId::fromPort(0);
+constexpr nsecs_t kPeriod = (120_Hz).getPeriodNsecs();
+
+// Same tuning as VsyncSchedule::createTracker.
+constexpr size_t kHistorySize = 20;
+constexpr size_t kMinSamplesForPrediction = 6;
+constexpr uint32_t kDiscardOutlierPercent = 20;
+
+std::shared_ptr<VSyncPredictor> createTrainedPredictor(size_t& vsyncIndex) {
+    auto predictor = std::make_shared<VSyncPredictor>(kDisplayId, kPeriod, kHistorySize,
+                                                      kMinSamplesForPrediction,
+                                                      kDiscardOutlierPercent);
+    for (; vsyncIndex < kHistorySize; vsyncIndex++) {
+        predictor->addVsyncTimestamp(jitteredVsync(kPeriod, vsyncIndex));
+    }
+    return predictor;
+}
+
+void BM_VSyncPredictor_addVsyncTimestamp(benchmark::State& state) {
+    size_t vsyncIndex = 0;
+    const auto predictor = createTrainedPredictor(vsyncIndex);
+
+    for (auto _ : state) {
+        const nsecs_t timestamp = jitteredVsync(kPeriod, vsyncIndex++);
+        benchmark::DoNotOptimize(predictor->addVsyncTimestamp(timestamp));
+    }
+}
+BENCHMARK(BM_VSyncPredictor_addVsyncTimestamp);
+
+void BM_VSyncPredictor_nextAnticipatedVSyncTimeFrom(benchmark::State& state) {
+    size_t vsyncIndex = 0;
+    const auto predictor = createTrainedPredictor(vsyncIndex);
+    const nsecs_t lastVsync = jitteredVsync(kPeriod, vsyncIndex - 1);
+
+    nsecs_t timePoint = lastVsync;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(predictor->nextAnticipatedVSyncTimeFrom(timePoint));
+        timePoint += kPeriod / 3;
+        if (timePoint > lastVsync + 4 * kPeriod) {
+            timePoint = lastVsync;
+        }
+    }
+}
+BENCHMARK(BM_VSyncPredictor_nextAnticipatedVSyncTimeFrom);
+
+// Single-shot timer whose clock only moves when the benchmark fires the armed alarm.
+class FakeTimeKeeper : public TimeKeeper {
+public:
+    nsecs_t now() const final { return mNow; }
+
+    void alarmAt(std::function<void()> callback, nsecs_t time) final {
+        mCallback = std::move(callback);
+        mAlarmTime = time;
+    }
+
+    void alarmCancel() final { mCallback = nullptr; }
+    void dump(std::string&) const final {}
+
+    // Returns false if no alarm was armed.
+    bool fireAlarm() {
+        if (!mCallback) {
+            return false;
+        }
+        mNow = std::max(mNow, mAlarmTime);
+        const auto callback = std::move(mCallback);
+        mCallback = nullptr;
+        callback();
+        return true;
+    }
+
+private:
+    std::function<void()> mCallback;
+    nsecs_t mAlarmTime = 0;
+    nsecs_t mNow = 0;
+};
+
+// Schedules a population of callbacks with staggered work durations (like app, appSf and sf) on
+// every frame, and fires the timer until all of them are dispatched.
+void BM_VSyncDispatchTimerQueue_scheduleAndDispatch(benchmark::State& state) {
+    const auto callbackCount = static_cast<size_t>(state.range(0));
+
+    size_t vsyncIndex = 0;
+    auto predictor = createTrainedPredictor(vsyncIndex);
+
+    auto timeKeeperPtr = std::make_unique<FakeTimeKeeper>();
+    auto& timeKeeper = *timeKeeperPtr;
+
+    constexpr nsecs_t kGroupDispatchWithin = 500'000;
+    constexpr nsecs_t kSnapToSameVsyncWithin = 3'000'000;
+    VSyncDispatchTimerQueue dispatch(std::move(timeKeeperPtr), predictor, kGroupDispatchWithin,
+                                     kSnapToSameVsyncWithin);
+
+    size_t dispatchCount = 0;
+    std::vector<VSyncDispatch::CallbackToken> tokens;
+    for (size_t i = 0; i < callbackCount; i++) {
+        tokens.push_back(dispatch.registerCallback([&dispatchCount](nsecs_t, nsecs_t,
+                                                                    nsecs_t) { dispatchCount++; },
+                                                   "callback" + std::to_string(i)));
+    }
+
+    for (auto _ : state) {
+        const nsecs_t now = timeKeeper.now();
+        for (size_t i = 0; i < tokens.size(); i++) {
+            const nsecs_t workDuration = kPeriod / 4 + static_cast<nsecs_t>(i % 4) * kPeriod / 8;
+            dispatch.schedule(tokens[i],
+                              {.workDuration = workDuration,
+                               .readyDuration = 0,
+                               .earliestVsync = now + workDuration + kPeriod});
+        }
+        while (timeKeeper.fireAlarm()) {
+        }
+
+        // Feed the HW vsync that the dispatched callbacks targeted.
+        predictor->addVsyncTimestamp(jitteredVsync(kPeriod, vsyncIndex++));
+    }
+
+    for (const auto token : tokens) {
+        dispatch.unregisterCallback(token);
+    }
+    state.counters["dispatches"] = benchmark::Counter(static_cast<double>(dispatchCount),
+                                                      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_VSyncDispatchTimerQueue_scheduleAndDispatch)->Arg(1)->Arg(4)->Arg(16);
+
+std::shared_ptr<RefreshRateSelector> createSelector() {
+    return std::make_shared<RefreshRateSelector>(makeModes(createDisplayMode(DisplayModeId(0),
+                                                                             60_Hz),
+                                                           createDisplayMode(DisplayModeId(1),
+                                                                             90_Hz),
+                                                           createDisplayMode(DisplayModeId(2),
+                                                                             120_Hz)),
+                                                 DisplayModeId(2));
+}
+
+std::vector<RefreshRateSelector::LayerRequirement> createLayerRequirements(size_t layerCount) {
+    constexpr RefreshRateSelector::LayerVoteType kVotes[] = {
+            RefreshRateSelector::LayerVoteType::Heuristic,
+            RefreshRateSelector::LayerVoteType::ExplicitDefault,
+            RefreshRateSelector::LayerVoteType::ExplicitExactOrMultiple,
+            RefreshRateSelector::LayerVoteType::Heuristic,
+    };
+
+    std::vector<RefreshRateSelector::LayerRequirement> layers;
+    layers.reserve(layerCount);
+    for (size_t i = 0; i < layerCount; i++) {
+        layers.push_back({.name = "layer" + std::to_string(i),
+                          .vote = kVotes[i % std::size(kVotes)],
+                          .desiredRefreshRate = kLayerFrameRates[i % kLayerFrameRates.size()],
+                          .weight = 1.f / static_cast<float>(1 + i % 10)});
+    }
+    return layers;
+}
+
+// Alternates between two layer populations, so that every call misses the cache and ranks the
+// frame rates from scratch.
+void BM_RefreshRateSelector_getRankedFrameRates(benchmark::State& state) {
+    const auto layerCount = static_cast<size_t>(state.range(0));
+    const auto selector = createSelector();
+
+    const std::vector<RefreshRateSelector::LayerRequirement> layers[] = {
+            createLayerRequirements(layerCount), createLayerRequirements(layerCount + 1)};
+
+    size_t frame = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(selector->getRankedFrameRates(layers[frame++ % 2], {}));
+    }
+}
+BENCHMARK(BM_RefreshRateSelector_getRankedFrameRates)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_RefreshRateSelector_getRankedFrameRatesCached(benchmark::State& state) {
+    const auto selector = createSelector();
+    const auto layers = createLayerRequirements(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(selector->getRankedFrameRates(layers, {}));
+    }
+}
+BENCHMARK(BM_RefreshRateSelector_getRankedFrameRatesCached)->Arg(10)->Arg(100)->Arg(1000);
+
+// Owns a SurfaceFlinger whose Scheduler tracks the history of a population of layers.
+class LayerHistoryHarness {
+public:
+    explicit LayerHistoryHarness(size_t layerCount) {
+        mFlinger.resetScheduler(mScheduler);
+        history().setDisplayArea(1920 * 1080);
+
+        mLayers.reserve(layerCount);
+        for (size_t i = 0; i < layerCount; i++) {
+            mLayers.push_back(
+                    sp<android::mock::MockLayer>::make(mFlinger.flinger(),
+                                                       "layer" + std::to_string(i)));
+        }
+    }
+
+    LayerHistory& history() { return mScheduler->mutableLayerHistory(); }
+    const RefreshRateSelector& selector() const { return *mSelector; }
+
+    // Records a buffer for each layer whose frame is due at the given vsync.
+    void recordFrames(size_t vsyncIndex, nsecs_t now) {
+        const LayerProps props = {.visible = true, .bounds = FloatRect(0, 0, 480, 270)};
+        for (size_t i = 0; i < mLayers.size(); i++) {
+            const Fps frameRate = kLayerFrameRates[i % kLayerFrameRates.size()];
+            const auto framesPerVsync =
+                    static_cast<size_t>((120_Hz).getValue() / frameRate.getValue());
+            if ((vsyncIndex + i) % framesPerVsync == 0) {
+                history().record(mLayers[i]->getSequence(), props, now, now,
+                                 LayerHistory::LayerUpdateType::Buffer);
+            }
+        }
+    }
+
+private:
+    const std::shared_ptr<RefreshRateSelector> mSelector = createSelector();
+    mock::NoOpSchedulerCallback mSchedulerCallback;
+    TestableScheduler* const mScheduler = new TestableScheduler(mSelector, mSchedulerCallback);
+    TestableSurfaceFlinger mFlinger;
+
+    // Destroyed before the flinger, since layers deregister from its Scheduler.
+    std::vector<sp<android::mock::MockLayer>> mLayers;
+};
+
+// Records the frames of a mixed-rate layer population and summarizes the history once per vsync,
+// as SurfaceFlinger does on every commit.
+void BM_LayerHistory_summarize(benchmark::State& state) {
+    LayerHistoryHarness harness(static_cast<size_t>(state.range(0)));
+
+    size_t vsyncIndex = 0;
+    const nsecs_t start = systemTime();
+    const auto vsyncTime = [&] { return start + jitteredVsync(kPeriod, vsyncIndex); };
+
+    // Fill a second of history for every layer before measuring.
+    constexpr size_t kWarmUpVsyncs = 120;
+    for (; vsyncIndex < kWarmUpVsyncs; vsyncIndex++) {
+        harness.recordFrames(vsyncIndex, vsyncTime());
+    }
+
+    for (auto _ : state) {
+        const nsecs_t now = vsyncTime();
+        harness.recordFrames(vsyncIndex++, now);
+        benchmark::DoNotOptimize(harness.history().summarize(harness.selector(), now));
+    }
+}
+BENCHMARK(BM_LayerHistory_summarize)->Arg(10)->Arg(100)->Arg(1000);
+
+} // namespace
+} // namespace android::scheduler
+
+BENCHMARK_MAIN();
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <scheduler/VsyncModel.h>
+
+#include "VsyncModelReference.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr int64_t kOrdinalScale = 1000;
+constexpr nsecs_t kPeriod = 8'333'333;
+constexpr nsecs_t kJitter = 100'000;
+
+void BM_fitVsyncModelTwoPass(benchmark::State& state) {
+    const auto timestamps =
+            test::generateVsyncTimestamps(static_cast<size_t>(state.range(0)), kPeriod, kJitter);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(test::fitVsyncModelTwoPass(timestamps.data(), timestamps.size(),
+                                                            timestamps.front(), kPeriod,
+                                                            kOrdinalScale));
+    }
+}
+BENCHMARK(BM_fitVsyncModelTwoPass)->Arg(20)->Arg(64)->Arg(256);
+
+void BM_fitVsyncModel(benchmark::State& state) {
+    const auto timestamps =
+            test::generateVsyncTimestamps(static_cast<size_t>(state.range(0)), kPeriod, kJitter);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fitVsyncModel(timestamps.data(), timestamps.size(),
+                                               timestamps.front(), kPeriod, kOrdinalScale));
+    }
+}
+BENCHMARK(BM_fitVsyncModel)->Arg(20)->Arg(64)->Arg(256);
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <scheduler/Fps.h>
+#include <utils/Timers.h>
+
+namespace android::scheduler::traces {
+
+// Deviation in nanoseconds of HW vsync timestamps from an ideal 120 Hz grid. The shape follows
+// what panels report in the field: most samples land within a few tens of microseconds, with an
+// occasional late sample when the vsync interrupt is delayed, and rare outliers that the
+// predictor is expected to reject. The table is fixed so that runs are comparable.
+constexpr std::array<nsecs_t, 64> kVsyncJitter = {
+        12'400,  -8'100,  3'900,   -21'700, 17'300,  -2'600,  9'800,   -14'200,
+        26'900,  -5'300,  1'100,   -31'400, 7'700,   19'200,  -11'900, 4'500,
+        -3'800,  142'600, -27'300, 8'900,   -16'400, 2'300,   22'100,  -9'700,
+        5'600,   -19'800, 13'700,  -1'200,  -37'600, 10'400,  -6'900,  15'800,
+        -24'300, 3'100,   -12'600, 29'400,  -4'400,  6'200,   -158'900, 18'700,
+        -7'500,  1'900,   -15'100, 11'200,  -28'800, 9'300,   -2'100,  24'600,
+        -10'700, 4'800,   -22'900, 14'300,  411'500, -13'400, 7'100,   -5'900,
+        20'800,  -17'200, 2'700,   -8'600,  16'500,  -25'100, 6'800,   -3'300,
+};
+
+inline nsecs_t jitteredVsync(nsecs_t period, size_t index) {
+    return static_cast<nsecs_t>(index) * period + kVsyncJitter[index % kVsyncJitter.size()];
+}
+
+// Frame rates of the layers in a typical population: mostly UI at the display rate, with video,
+// games and idle-ish layers mixed in. Layer i of a population posts at kLayerFrameRates[i % N].
+constexpr std::array<Fps, 8> kLayerFrameRates = {
+        120_Hz, 60_Hz, 120_Hz, 30_Hz, 24_Hz, 60_Hz, 40_Hz, 10_Hz,
+};
+
+} // namespace android::scheduler::traces
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <chrono>
 #include <condition_variable>
+#include <future>
+#include <vector>
 
 #include "BackgroundExecutor.h"
 
@@ -52,6 +55,39 @@ TEST_F(BackgroundExecutorTest, multipleProducers) {
     ASSERT_EQ(backgroundTaskCount, backgroundTaskCompleteCount);
 }
 
+TEST_F(BackgroundExecutorTest, highPriorityDoesNotWaitForNormalPriority) {
+    std::promise<void> unblockNormal;
+    std::promise<void> highComplete;
+
+    BackgroundExecutor::getInstance().sendCallbacks(
+            {[future = unblockNormal.get_future().share()]() { future.wait(); }},
+            BackgroundExecutor::Priority::Normal);
+    BackgroundExecutor::getInstance().sendCallbacks({[&highComplete]() {
+                                                        highComplete.set_value();
+                                                    }},
+                                                    BackgroundExecutor::Priority::High);
+
+    EXPECT_EQ(std::future_status::ready,
+              highComplete.get_future().wait_for(std::chrono::seconds(5)));
+
+    unblockNormal.set_value();
+    BackgroundExecutor::getInstance().flushQueue();
+}
+
+TEST_F(BackgroundExecutorTest, samePriorityRunsInOrder) {
+    std::vector<int> order;
+    for (int i = 0; i < 100; i++) {
+        BackgroundExecutor::getInstance().sendCallbacks({[&order, i]() { order.push_back(i); }},
+                                                        BackgroundExecutor::Priority::High);
+    }
+    BackgroundExecutor::getInstance().flushQueue();
+
+    ASSERT_EQ(100u, order.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i, order[i]);
+    }
+}
+
 } // namespace
 
 } // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "ClientCacheTest"
+
+#include <binder/Binder.h>
+#include <gtest/gtest.h>
+#include <renderengine/mock/RenderEngine.h>
+#include <ui/GraphicBuffer.h>
+
+#include "ClientCache.h"
+
+namespace android {
+namespace {
+
+class ClientCacheTest : public testing::Test {
+protected:
+    ClientCacheTest() { mCache.setRenderEngine(&mRenderEngine); }
+
+    client_cache_t cacheId(uint64_t id) const { return {mProcessToken, id}; }
+
+    std::shared_ptr<renderengine::ExternalTexture> add(uint64_t id) {
+        auto result = mCache.add(cacheId(id), mBuffer);
+        return result.has_value() ? *result : nullptr;
+    }
+
+    renderengine::mock::RenderEngine mRenderEngine;
+    ClientCache mCache;
+    sp<IBinder> mProcessToken = sp<BBinder>::make();
+    sp<GraphicBuffer> mBuffer =
+            sp<GraphicBuffer>::make(1u, 1u, PIXEL_FORMAT_RGBA_8888, 1u,
+                                    GraphicBuffer::USAGE_HW_TEXTURE, "ClientCacheTest");
+};
+
+TEST_F(ClientCacheTest, sharesTextureBetweenEntries) {
+    const auto texture = add(1);
+    ASSERT_NE(nullptr, texture);
+    EXPECT_EQ(texture, add(2));
+}
+
+TEST_F(ClientCacheTest, reusesTextureOfErasedEntry) {
+    std::weak_ptr<renderengine::ExternalTexture> texture = add(1);
+    ASSERT_NE(nullptr, mCache.erase(cacheId(1)));
+    ASSERT_FALSE(texture.expired());
+
+    mCache.releaseExpiredTextures(systemTime());
+    EXPECT_EQ(texture.lock(), add(1));
+}
+
+TEST_F(ClientCacheTest, releasesRetainedTextureAfterTimeout) {
+    std::weak_ptr<renderengine::ExternalTexture> texture = add(1);
+    ASSERT_NE(nullptr, mCache.erase(cacheId(1)));
+
+    mCache.releaseExpiredTextures(systemTime() + ClientCache::kRetainedTextureTimeout.count());
+    EXPECT_TRUE(texture.expired());
+    EXPECT_NE(nullptr, add(1));
+}
+
+TEST_F(ClientCacheTest, releasesRetainedTexturesOfRemovedProcess) {
+    std::weak_ptr<renderengine::ExternalTexture> texture = add(1);
+    ASSERT_NE(nullptr, mCache.erase(cacheId(1)));
+
+    mCache.removeProcess(mProcessToken);
+    EXPECT_TRUE(texture.expired());
+}
+
+} // namespace
+} // namespace android
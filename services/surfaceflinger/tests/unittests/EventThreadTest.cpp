@@ -427,6 +427,35 @@ TEST_F(EventThreadTest, requestNextVsyncEventFrameTimelinesCorrect) {
     expectVsyncEventFrameTimelinesCorrect(123, {-1, 789, 456});
 }
 
+TEST_F(EventThreadTest, connectionsWithSameFrameIntervalShareFrameTimelines) {
+    setupEventThread(VSYNC_PERIOD);
+
+    ConnectionEventRecorder secondConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> secondConnection =
+            createConnection(secondConnectionEventRecorder);
+
+    mThread->requestNextVsync(mConnection);
+    mThread->requestNextVsync(secondConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    onVSyncEvent(123, 456, 789);
+
+    auto args = mConnectionEventCallRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    auto secondArgs = secondConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(secondArgs.has_value());
+
+    const auto& vsyncData = std::get<0>(args.value()).vsync.vsyncData;
+    const auto& secondVsyncData = std::get<0>(secondArgs.value()).vsync.vsyncData;
+    ASSERT_EQ(vsyncData.frameTimelinesLength, secondVsyncData.frameTimelinesLength);
+    EXPECT_EQ(vsyncData.preferredFrameTimelineIndex, secondVsyncData.preferredFrameTimelineIndex);
+    for (int i = 0; i < vsyncData.frameTimelinesLength; i++) {
+        EXPECT_EQ(vsyncData.frameTimelines[i].vsyncId, secondVsyncData.frameTimelines[i].vsyncId);
+        EXPECT_EQ(vsyncData.frameTimelines[i].deadlineTimestamp,
+                  secondVsyncData.frameTimelines[i].deadlineTimestamp);
+    }
+}
+
 TEST_F(EventThreadTest, requestNextVsyncEventFrameTimelinesValidLength) {
     // The VsyncEventData should not have kFrameTimelinesCapacity amount of valid frame timelines,
     // due to longer vsync period and kEarlyLatchMaxThreshold. Use length-2 to avoid decimal
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FramePhaseProfiler.h"
+
+namespace android {
+namespace {
+
+using Phase = FramePhaseProfiler::Phase;
+
+TEST(FramePhaseProfilerTest, emptyPhaseHasNoPercentiles) {
+    FramePhaseProfiler profiler;
+    const auto percentiles = profiler.getPercentiles(Phase::Composition);
+    EXPECT_EQ(0u, percentiles.count);
+    EXPECT_EQ(0, percentiles.max);
+}
+
+TEST(FramePhaseProfilerTest, computesPercentiles) {
+    FramePhaseProfiler profiler;
+    for (nsecs_t duration = 100; duration >= 1; duration--) {
+        profiler.record(Phase::Composition, duration);
+    }
+    profiler.record(Phase::InputUpdate, 7);
+
+    const auto percentiles = profiler.getPercentiles(Phase::Composition);
+    EXPECT_EQ(100u, percentiles.count);
+    EXPECT_EQ(50, percentiles.p50);
+    EXPECT_EQ(90, percentiles.p90);
+    EXPECT_EQ(99, percentiles.p99);
+    EXPECT_EQ(100, percentiles.max);
+
+    EXPECT_EQ(1u, profiler.getPercentiles(Phase::InputUpdate).count);
+    EXPECT_EQ(7, profiler.getPercentiles(Phase::InputUpdate).p99);
+}
+
+TEST(FramePhaseProfilerTest, keepsOnlyTheMostRecentFrames) {
+    FramePhaseProfiler profiler;
+    for (size_t i = 0; i < FramePhaseProfiler::kFrameCount; i++) {
+        profiler.record(Phase::PostComposition, 1000);
+    }
+    for (size_t i = 0; i < FramePhaseProfiler::kFrameCount; i++) {
+        profiler.record(Phase::PostComposition, 1);
+    }
+
+    const auto percentiles = profiler.getPercentiles(Phase::PostComposition);
+    EXPECT_EQ(FramePhaseProfiler::kFrameCount, percentiles.count);
+    EXPECT_EQ(1, percentiles.max);
+}
+
+TEST(FramePhaseProfilerTest, clearDropsAllFrames) {
+    FramePhaseProfiler profiler;
+    profiler.record(Phase::TransactionFlush, 10);
+    profiler.clear();
+    EXPECT_EQ(0u, profiler.getPercentiles(Phase::TransactionFlush).count);
+
+    std::string dump;
+    profiler.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("TransactionFlush"));
+}
+
+} // namespace
+} // namespace android
@@ -149,6 +149,11 @@ public:
         return mFrameTimeline->mDisplayFrames[idx];
     }
 
+    std::shared_ptr<impl::FrameTimeline::DisplayFrame> getCurrentDisplayFrame() {
+        std::lock_guard<std::mutex> lock(mFrameTimeline->mMutex);
+        return mFrameTimeline->mCurrentDisplayFrame;
+    }
+
     static bool compareTimelineItems(const TimelineItem& a, const TimelineItem& b) {
         return a.startTime == b.startTime && a.endTime == b.endTime &&
                 a.presentTime == b.presentTime;
@@ -391,6 +396,36 @@ TEST_F(FrameTimelineTest, displayFramesSlidingWindowMovesAfterLimit) {
     EXPECT_EQ(compareTimelineItems(displayFrame0->getActuals(), TimelineItem(52, 57, 62)), true);
 }
 
+TEST_F(FrameTimelineTest, displayFramesSlidingWindowReusesOldestFrame) {
+    auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    presentFence->signalForTest(32);
+
+    const auto addDisplayFrame = [&]() {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
+                                                           sLayerNameOne, sLayerNameOne,
+                                                           /*isBuffer*/ true, sGameMode);
+        int64_t sfToken = mTokenManager->generateTokenForPredictions({22, 26, 30});
+        mFrameTimeline->setSfWakeUp(sfToken, 22, Fps::fromPeriodNsecs(11));
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        mFrameTimeline->setSfPresent(27, presentFence);
+    };
+    for (size_t i = 0; i < *maxDisplayFrames; i++) {
+        addDisplayFrame();
+    }
+    const impl::FrameTimeline::DisplayFrame* oldestDisplayFrame = getDisplayFrame(0).get();
+
+    // The DisplayFrame that drops out of the window should be cleared and used for the next frame
+    addDisplayFrame();
+    auto currentDisplayFrame = getCurrentDisplayFrame();
+    EXPECT_EQ(currentDisplayFrame.get(), oldestDisplayFrame);
+    EXPECT_TRUE(currentDisplayFrame->getSurfaceFrames().empty());
+    EXPECT_EQ(currentDisplayFrame->getJankType(), JankType::None);
+    EXPECT_TRUE(compareTimelineItems(currentDisplayFrame->getActuals(), TimelineItem()));
+    EXPECT_EQ(getNumberOfDisplayFrames(), *maxDisplayFrames);
+}
+
 TEST_F(FrameTimelineTest, surfaceFrameEndTimeAcquireFenceAfterQueue) {
     auto surfaceFrame = mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, 0, sLayerIdOne,
                                                                    "acquireFenceAfterQueue",
@@ -2445,6 +2480,33 @@ TEST_F(FrameTimelineTest, computeFps_averagesOverMultipleFrames) {
     EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 5.0f);
 }
 
+TEST_F(FrameTimelineTest, computeFps_updatesAsFramesArePresented) {
+    mFrameTimeline->setMaxDisplayFrames(2);
+    const auto present = [&](nsecs_t presentTime) {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken(FrameTimelineInfo(), sPidOne, sUidOne,
+                                                           sLayerIdOne, sLayerNameOne,
+                                                           sLayerNameOne, /*isBuffer*/ true,
+                                                           sGameMode);
+        auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        presentFence->signalForTest(presentTime);
+        mFrameTimeline->setSfPresent(presentTime, presentFence);
+    };
+
+    present(std::chrono::nanoseconds(100ms).count());
+    EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 0.0f);
+
+    present(std::chrono::nanoseconds(200ms).count());
+    EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 10.0f);
+
+    // The first frame drops out of the sliding window.
+    present(std::chrono::nanoseconds(250ms).count());
+    EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdOne}), 20.0f);
+    EXPECT_EQ(mFrameTimeline->computeFps({sLayerIdTwo}), 0.0f);
+}
+
 TEST_F(FrameTimelineTest, getMinTime) {
     // Use SurfaceFrame::getBaseTime to test the getMinTime.
     FrameTimelineInfo ftInfo;
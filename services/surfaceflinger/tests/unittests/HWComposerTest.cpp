@@ -271,5 +271,120 @@ TEST_F(HWComposerLayerGenericMetadataTest, forwardsSupportedMetadata) {
     EXPECT_EQ(hal::Error::UNSUPPORTED, result);
 }
 
+struct HWComposerLayerPropertiesTest : public HWComposerLayerTest {
+    HWComposerLayerPropertiesTest() : HWComposerLayerTest({}) {}
+};
+
+TEST_F(HWComposerLayerPropertiesTest, sendsOnlyChangedProperties) {
+    const Rect frame{1, 2, 3, 4};
+    const Hwc2::IComposerClient::Rect hwcFrame{1, 2, 3, 4};
+    EXPECT_CALL(*mHal, setLayerDisplayFrame(kDisplayId, kLayerId, hwcFrame))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 0.5f))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerBrightness(kDisplayId, kLayerId, 0.25f))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+        EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+        EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+        EXPECT_EQ(hal::Error::NONE, mLayer.setBrightness(0.25f));
+    }
+    testing::Mock::VerifyAndClearExpectations(mHal.get());
+
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 1.f))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(1.f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(1.f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+}
+
+TEST_F(HWComposerLayerPropertiesTest, resendsPropertyAfterError) {
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::BAD_LAYER))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::BAD_LAYER, mLayer.setZOrder(7u));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+}
+
+TEST_F(HWComposerLayerPropertiesTest, resendsPropertiesAfterInvalidatingCachedState) {
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .Times(2)
+            .WillRepeatedly(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+    mLayer.invalidateCachedState();
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(7u));
+}
+
+struct HWComposerDisplayLayerStateTest : public testing::Test {
+    static constexpr hal::HWDisplayId kDisplayId = static_cast<hal::HWDisplayId>(1001);
+    static constexpr hal::HWLayerId kLayerId = static_cast<hal::HWLayerId>(1002);
+
+    std::shared_ptr<HWC2::Layer> createLayer() {
+        EXPECT_CALL(*mHal, createLayer(kDisplayId, _))
+                .WillOnce(DoAll(SetArgPointee<1>(kLayerId),
+                                Return(hardware::graphics::composer::V2_4::Error::NONE)));
+        EXPECT_CALL(*mHal, destroyLayer(kDisplayId, kLayerId));
+        auto layer = mDisplay.createLayer();
+        return layer.has_value() ? *layer : nullptr;
+    }
+
+    void validate(hardware::graphics::composer::V2_4::Error error, bool layerCommandFailed) {
+        EXPECT_CALL(*mHal, validateDisplay(kDisplayId, _, _, _)).WillOnce(Return(error));
+        EXPECT_CALL(*mHal, takeLayerCommandFailure(kDisplayId))
+                .WillOnce(Return(layerCommandFailed));
+        uint32_t numTypes = 0;
+        uint32_t numRequests = 0;
+        static_cast<void>(mDisplay.validate(0, &numTypes, &numRequests));
+    }
+
+    std::unique_ptr<Hwc2::mock::Composer> mHal{new StrictMock<Hwc2::mock::Composer>()};
+    const std::unordered_set<aidl::Capability> mCapabilities;
+    HWC2::impl::Display mDisplay{*mHal, mCapabilities, kDisplayId, hal::DisplayType::PHYSICAL};
+};
+
+TEST_F(HWComposerDisplayLayerStateTest, keepsLayerStateAfterSuccessfulBatch) {
+    const auto layer = createLayer();
+    ASSERT_NE(nullptr, layer);
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+    validate(hardware::graphics::composer::V2_4::Error::NONE, /*layerCommandFailed*/ false);
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+}
+
+TEST_F(HWComposerDisplayLayerStateTest, resendsLayerStateAfterFailedLayerCommand) {
+    const auto layer = createLayer();
+    ASSERT_NE(nullptr, layer);
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .Times(2)
+            .WillRepeatedly(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+    validate(hardware::graphics::composer::V2_4::Error::NONE, /*layerCommandFailed*/ true);
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+}
+
+TEST_F(HWComposerDisplayLayerStateTest, resendsLayerStateAfterFailedValidate) {
+    const auto layer = createLayer();
+    ASSERT_NE(nullptr, layer);
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 7u))
+            .Times(2)
+            .WillRepeatedly(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+    validate(hardware::graphics::composer::V2_4::Error::NO_RESOURCES,
+             /*layerCommandFailed*/ false);
+    EXPECT_EQ(hal::Error::NONE, layer->setZOrder(7u));
+}
+
 } // namespace
 } // namespace android
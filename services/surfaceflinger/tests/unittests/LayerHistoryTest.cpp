@@ -741,6 +741,38 @@ TEST_F(LayerHistoryTest, infrequentAnimatingLayer) {
     EXPECT_EQ(1, animatingLayerCount(time));
 }
 
+TEST_F(LayerHistoryTest, hasOnlyInfrequentUpdates) {
+    auto layer = createLayer();
+
+    EXPECT_CALL(*layer, isVisible()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*layer, getFrameRateForLayerTree()).WillRepeatedly(Return(Layer::FrameRate()));
+
+    nsecs_t time = systemTime();
+
+    // No active layers.
+    EXPECT_FALSE(history().hasOnlyInfrequentUpdates(time));
+
+    // A layer ticking slower than the frequent layer threshold, like a clock.
+    for (int i = 0; i < PRESENT_TIME_HISTORY_SIZE; i++) {
+        history().record(layer->getSequence(), layer->getLayerProps(), time, time,
+                         LayerHistory::LayerUpdateType::Buffer);
+        time += MAX_FREQUENT_LAYER_PERIOD_NS.count();
+    }
+    EXPECT_TRUE(history().hasOnlyInfrequentUpdates(time));
+
+    // The layer starts animating.
+    for (int i = 0; i < FREQUENT_LAYER_WINDOW_SIZE; i++) {
+        history().record(layer->getSequence(), layer->getLayerProps(), time, time,
+                         LayerHistory::LayerUpdateType::Buffer);
+        time += HI_FPS_PERIOD;
+    }
+    EXPECT_FALSE(history().hasOnlyInfrequentUpdates(time));
+
+    // The layer stops updating.
+    time += MAX_ACTIVE_LAYER_PERIOD_NS.count();
+    EXPECT_FALSE(history().hasOnlyInfrequentUpdates(time));
+}
+
 TEST_F(LayerHistoryTest, frequentLayerBecomingInfrequentAndBack) {
     auto layer = createLayer();
 
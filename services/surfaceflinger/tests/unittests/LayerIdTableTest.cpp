@@ -0,0 +1,108 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FrontEnd/LayerIdTable.h"
+
+namespace android::surfaceflinger::frontend {
+
+using Table = LayerIdTable<int>;
+constexpr uint32_t kPageSize = Table::kPageSize;
+
+TEST(LayerIdTableTest, insertGetErase) {
+    Table table;
+    EXPECT_EQ(nullptr, table.get(1));
+
+    auto [value, inserted] = table.try_emplace(1, 10);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(10, *value);
+    EXPECT_EQ(value, table.get(1));
+
+    std::tie(value, inserted) = table.try_emplace(1, 20);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(10, *value);
+
+    EXPECT_FALSE(table.emplace_or_replace(1, 30));
+    EXPECT_EQ(30, *table.get(1));
+    EXPECT_TRUE(table.emplace_or_replace(2, 40));
+    EXPECT_EQ(40, *table.get(2));
+
+    EXPECT_TRUE(table.erase(1));
+    EXPECT_FALSE(table.erase(1));
+    EXPECT_EQ(nullptr, table.get(1));
+    EXPECT_EQ(40, *table.get(2));
+}
+
+TEST(LayerIdTableTest, unassignedId) {
+    Table table;
+    EXPECT_EQ(nullptr, table.get(UNASSIGNED_LAYER_ID));
+    EXPECT_FALSE(table.erase(UNASSIGNED_LAYER_ID));
+    EXPECT_EQ(0u, table.pageCount());
+}
+
+TEST(LayerIdTableTest, clientAndInternalIdsAreSeparate) {
+    Table table;
+    table.try_emplace(5, 1);
+    table.try_emplace(5 | INTERNAL_LAYER_PREFIX, 2);
+    EXPECT_EQ(1, *table.get(5));
+    EXPECT_EQ(2, *table.get(5 | INTERNAL_LAYER_PREFIX));
+    EXPECT_EQ(2u, table.pageCount());
+
+    EXPECT_TRUE(table.erase(5));
+    EXPECT_EQ(nullptr, table.get(5));
+    EXPECT_EQ(2, *table.get(5 | INTERNAL_LAYER_PREFIX));
+    EXPECT_EQ(1u, table.pageCount());
+}
+
+TEST(LayerIdTableTest, pagesAllocatedAndFreedWithTheirIds) {
+    Table table;
+    table.try_emplace(0, 0);
+    table.try_emplace(kPageSize - 1, 1);
+    EXPECT_EQ(1u, table.pageCount());
+
+    table.try_emplace(kPageSize, 2);
+    table.try_emplace(5 * kPageSize, 3);
+    EXPECT_EQ(3u, table.pageCount());
+
+    // A page stays as long as any of its ids does.
+    table.erase(0);
+    EXPECT_EQ(3u, table.pageCount());
+    table.erase(kPageSize - 1);
+    EXPECT_EQ(2u, table.pageCount());
+
+    table.erase(5 * kPageSize);
+    table.erase(kPageSize);
+    EXPECT_EQ(0u, table.pageCount());
+
+    // Freed pages are allocated again when needed.
+    table.try_emplace(kPageSize + 1, 4);
+    EXPECT_EQ(4, *table.get(kPageSize + 1));
+    EXPECT_EQ(nullptr, table.get(kPageSize));
+    EXPECT_EQ(1u, table.pageCount());
+}
+
+TEST(LayerIdTableTest, valuesStayInPlace) {
+    Table table;
+    int* first = table.try_emplace(1, 1).first;
+    for (uint32_t id = 2; id < 4 * kPageSize; id++) {
+        table.try_emplace(id, static_cast<int>(id));
+    }
+    EXPECT_EQ(first, table.get(1));
+    EXPECT_EQ(1, *first);
+}
+
+} // namespace android::surfaceflinger::frontend
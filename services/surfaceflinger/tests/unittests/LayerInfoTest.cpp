@@ -33,6 +33,7 @@ protected:
 
     void setFrameTimes(const std::deque<FrameTimeData>& frameTimes) {
         layerInfo.mFrameTimes = frameTimes;
+        layerInfo.mAverageFrameTime.reset();
     }
 
     void setLastRefreshRate(Fps fps) {
@@ -118,6 +119,23 @@ TEST_F(LayerInfoTest, returnsNulloptIfThereWasConfigChange) {
     }
 }
 
+TEST_F(LayerInfoTest, recomputesAverageFrameTimeForNewFrames) {
+    using LayerUpdateType = LayerHistory::LayerUpdateType;
+    constexpr auto kPeriod = (60_Hz).getPeriodNsecs();
+    for (int i = 1; i <= 10; i++) {
+        layerInfo.setLastPresentTime(kPeriod * i, kPeriod * i, LayerUpdateType::Buffer,
+                                     /*pendingModeChange=*/false, LayerProps{});
+    }
+    auto averageFrameTime = calculateAverageFrameTime();
+    ASSERT_TRUE(averageFrameTime.has_value());
+    EXPECT_EQ(60_Hz, Fps::fromPeriodNsecs(*averageFrameTime));
+
+    // A frame during a mode change invalidates the average until it leaves the history.
+    layerInfo.setLastPresentTime(kPeriod * 11, kPeriod * 11, LayerUpdateType::Buffer,
+                                 /*pendingModeChange=*/true, LayerProps{});
+    EXPECT_FALSE(calculateAverageFrameTime().has_value());
+}
+
 // A frame can be recorded twice with very close presentation or queue times.
 // Make sure that this doesn't influence the calculated average FPS.
 TEST_F(LayerInfoTest, ignoresSmallPeriods) {
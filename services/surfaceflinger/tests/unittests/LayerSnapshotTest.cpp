@@ -17,6 +17,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <allocationcounter/AllocationCounter.h>
 #include "FrontEnd/LayerHierarchy.h"
 #include "FrontEnd/LayerLifecycleManager.h"
 #include "FrontEnd/LayerSnapshotBuilder.h"
@@ -81,7 +82,8 @@ protected:
                                         .globalShadowSettings = globalShadowSettings,
                                         .supportsBlur = true,
                                         .supportedLayerGenericMetadata = {},
-                                        .genericLayerMetadataKeyMap = {}};
+                                        .genericLayerMetadataKeyMap = {},
+                                        .skipCleanSubtrees = mSkipCleanSubtrees};
         actualBuilder.update(args);
 
         // rebuild layer snapshots from scratch and verify that it matches the updated state.
@@ -107,6 +109,7 @@ protected:
     LayerSnapshotBuilder mSnapshotBuilder;
     display::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mFrontEndDisplayInfos;
     renderengine::ShadowSettings globalShadowSettings;
+    bool mSkipCleanSubtrees = false;
     static const std::vector<uint32_t> STARTING_ZORDER;
 };
 const std::vector<uint32_t> LayerSnapshotTest::STARTING_ZORDER = {1,   11,   111, 12, 121,
@@ -254,6 +257,63 @@ TEST_F(LayerSnapshotTest, FastPathClearsPreviousChangeStates) {
     EXPECT_TRUE(getSnapshot(11)->changes.get() == 0);
 }
 
+TEST_F(LayerSnapshotTest, SkipsCleanSubtrees) {
+    mSkipCleanSubtrees = true;
+    setCrop(122, Rect(1, 2, 3, 4));
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    // Only 122, its child and its ancestors are visited.
+    EXPECT_EQ(mSnapshotBuilder.getVisitedSnapshotCount(), 4u);
+    EXPECT_EQ(mSnapshotBuilder.getSkippedSnapshotCount(), 5u);
+    EXPECT_TRUE(getSnapshot(122)->changes.test(RequestedLayerState::Changes::Geometry));
+    EXPECT_TRUE(getSnapshot(1221)->changes.test(RequestedLayerState::Changes::Geometry));
+    EXPECT_EQ(getSnapshot(1221)->geomLayerBounds, Rect(1, 2, 3, 4).toFloatRect());
+    EXPECT_TRUE(getSnapshot(11)->changes.get() == 0);
+
+    setCrop(1, Rect(1, 2, 3, 4));
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    // Geometry changes on the parent must propagate to every child.
+    EXPECT_EQ(mSnapshotBuilder.getVisitedSnapshotCount(), 8u);
+    EXPECT_EQ(mSnapshotBuilder.getSkippedSnapshotCount(), 1u);
+    EXPECT_TRUE(getSnapshot(111)->changes.test(RequestedLayerState::Changes::Geometry));
+    EXPECT_TRUE(getSnapshot(2)->changes.get() == 0);
+}
+
+TEST_F(LayerSnapshotTest, HotStateMatchesSnapshots) {
+    hideLayer(13);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 2});
+    hideLayer(122);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 2});
+
+    const auto& hotState = mSnapshotBuilder.getHotState();
+    const auto& snapshots = mSnapshotBuilder.getSnapshots();
+    ASSERT_GE(hotState.size(), 6u);
+    for (size_t i = 0; i < hotState.size(); i++) {
+        const LayerSnapshot& snapshot = *snapshots[i];
+        SCOPED_TRACE(snapshot.getDebugString());
+        EXPECT_EQ(static_cast<bool>(hotState.isVisible[i]), snapshot.isVisible);
+        EXPECT_EQ(static_cast<bool>(hotState.hasInputInfo[i]), snapshot.hasInputInfo());
+    }
+}
+
+TEST_F(LayerSnapshotTest, SteadyStateUpdateDoesNotAllocate) {
+    LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                    .layerLifecycleManager = mLifecycleManager,
+                                    .includeMetadata = false,
+                                    .displays = mFrontEndDisplayInfos,
+                                    .globalShadowSettings = globalShadowSettings,
+                                    .supportedLayerGenericMetadata = {},
+                                    .genericLayerMetadataKeyMap = {}};
+    mSnapshotBuilder.update(args);
+
+    size_t allocations = 0;
+    {
+        ScopedAllocationCounter counter;
+        mSnapshotBuilder.update(args);
+        allocations = counter.count();
+    }
+    EXPECT_EQ(allocations, 0u);
+}
+
 TEST_F(LayerSnapshotTest, FastPathSetsChangeFlagToContent) {
     setColor(1, {1._hf, 0._hf, 0._hf});
     UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "LocklessQueue.h"
+
+namespace android {
+namespace {
+
+TEST(LocklessQueueTest, popReturnsEntriesInOrder) {
+    LocklessQueue<int> queue;
+    EXPECT_TRUE(queue.isEmpty());
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    EXPECT_EQ(queue.pop(), 1);
+    queue.push(4);
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_EQ(queue.pop(), 3);
+    EXPECT_EQ(queue.pop(), 4);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(LocklessQueueTest, drainVisitsEntriesInOrder) {
+    LocklessQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    // Leave entries in the pop list to make sure they are visited before newer pushes.
+    EXPECT_EQ(queue.pop(), 1);
+    queue.push(4);
+    queue.push(5);
+
+    std::vector<int> values;
+    EXPECT_EQ(queue.drain([&](int&& value) { values.push_back(value); }), 4u);
+    EXPECT_EQ(values, (std::vector<int>{2, 3, 4, 5}));
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(queue.drain([](int&&) { FAIL(); }), 0u);
+}
+
+TEST(LocklessQueueTest, supportsMoveOnlyTypes) {
+    LocklessQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+    EXPECT_EQ(*queue.pop().value(), 1);
+
+    std::vector<std::unique_ptr<int>> values;
+    queue.drain([&](std::unique_ptr<int>&& value) { values.push_back(std::move(value)); });
+    ASSERT_EQ(values.size(), 1u);
+    EXPECT_EQ(*values[0], 2);
+}
+
+TEST(LocklessQueueTest, drainWithMultipleProducers) {
+    constexpr int kProducers = 4;
+    constexpr int kValuesPerProducer = 1000;
+    LocklessQueue<int> queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push(p * kValuesPerProducer + i);
+            }
+        });
+    }
+
+    std::vector<int> lastValueByProducer(kProducers, -1);
+    size_t count = 0;
+    const auto visitor = [&](int&& value) {
+        // Values from the same producer must be drained in the order they were pushed.
+        const int producer = value / kValuesPerProducer;
+        EXPECT_LT(lastValueByProducer[producer], value);
+        lastValueByProducer[producer] = value;
+    };
+    while (count < static_cast<size_t>(kProducers * kValuesPerProducer)) {
+        count += queue.drain(visitor);
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+} // namespace
+} // namespace android
@@ -218,5 +218,23 @@ TEST_F(PowerAdvisorTest, hintSessionUsingSecondaryVirtualDisplays) {
     mPowerAdvisor->reportActualWorkDuration();
 }
 
+TEST_F(PowerAdvisorTest, hintsCpuLoadUpBeforeHeavyFrames) {
+    mPowerAdvisor->onBootFinished();
+    startPowerHintSession();
+    mPowerAdvisor->mUsePredictiveHints = true;
+
+    const size_t heavyTransactionCount = PowerAdvisor::sPredictiveHintTransactionCount;
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP)).Times(2);
+
+    mPowerAdvisor->hintUpcomingFrameWork(0);
+    mPowerAdvisor->hintUpcomingFrameWork(heavyTransactionCount);
+
+    // A sustained heavy load is only hinted when it starts.
+    mPowerAdvisor->hintUpcomingFrameWork(heavyTransactionCount);
+
+    mPowerAdvisor->hintUpcomingFrameWork(0);
+    mPowerAdvisor->hintUpcomingFrameWork(heavyTransactionCount);
+}
+
 } // namespace
 } // namespace android::Hwc2::impl
@@ -2298,6 +2298,21 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     EXPECT_EQ(cache->result, result);
 }
 
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_CountsCacheHits) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    std::vector<LayerRequirement> layers = {{.weight = 1.f}, {.weight = 0.5f}};
+    selector.getRankedFrameRates(layers, {.touch = true});
+    selector.getRankedFrameRates(layers, {.touch = true});
+    selector.getRankedFrameRates(layers, {.touch = true});
+    selector.getRankedFrameRates(layers, {});
+
+    const auto stats = selector.getRankedFrameRatesCacheStats();
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ("hits=2 misses=2 hitRate=50.0%", stats.toString());
+}
+
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
     auto selector = createSelector(kModes_60_120, kModeId60);
 
@@ -183,5 +183,23 @@ TEST_F(RefreshRateStatsTest, twoModes) {
     EXPECT_EQ(sixty, times.get("60.00 Hz")->get());
 }
 
+TEST_F(RefreshRateStatsTest, countsSwitches) {
+    resetStats(90_Hz);
+    EXPECT_CALL(mTimeStats, incrementRefreshRateSwitches()).Times(2);
+
+    EXPECT_EQ(0u, mRefreshRateStats->getSwitchCount());
+
+    mRefreshRateStats->setRefreshRate(90_Hz);
+    EXPECT_EQ(0u, mRefreshRateStats->getSwitchCount());
+
+    mRefreshRateStats->setRefreshRate(60_Hz);
+    mRefreshRateStats->setRefreshRate(90_Hz);
+    EXPECT_EQ(2u, mRefreshRateStats->getSwitchCount());
+
+    std::string result;
+    mRefreshRateStats->dump(result);
+    EXPECT_NE(std::string::npos, result.find("Refresh rate switches: 2"));
+}
+
 } // namespace
 } // namespace android::scheduler
@@ -106,6 +106,26 @@ TEST_F(RegionSamplingTest, bounds_checking) {
                 testing::Eq(0.0));
 }
 
+TEST_F(RegionSamplingTest, scale_sample_area) {
+    const Rect sampledBounds{100, 200, 500, 400};
+
+    // Without downscaling, areas are only offset to the sampled bounds.
+    EXPECT_EQ(Rect(0, 0, 400, 200),
+              scaleSampleArea(sampledBounds, sampledBounds, sampledBounds.getSize()));
+    EXPECT_EQ(Rect(10, 20, 30, 40),
+              scaleSampleArea(Rect{110, 220, 130, 240}, sampledBounds, sampledBounds.getSize()));
+
+    // Downscaled areas are rounded outwards.
+    const ui::Size quarterSize{100, 50};
+    EXPECT_EQ(Rect(0, 0, 100, 50), scaleSampleArea(sampledBounds, sampledBounds, quarterSize));
+    EXPECT_EQ(Rect(2, 5, 8, 10),
+              scaleSampleArea(Rect{110, 220, 130, 240}, sampledBounds, quarterSize));
+
+    // Tiny areas still cover a pixel.
+    EXPECT_EQ(Rect(99, 49, 100, 50),
+              scaleSampleArea(Rect{499, 399, 500, 400}, sampledBounds, quarterSize));
+}
+
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -1088,6 +1088,117 @@ TEST(TransactionHandlerTest, QueueTransaction) {
     EXPECT_EQ(transactionsReadyToBeApplied.front().id, 42u);
 }
 
+namespace {
+
+TransactionState createTransaction(int uid, nsecs_t postTime) {
+    TransactionState transaction;
+    transaction.applyToken = sp<BBinder>::make();
+    transaction.id = static_cast<uint64_t>(postTime);
+    transaction.flags = 0;
+    transaction.isAutoTimestamp = true;
+    transaction.desiredPresentTime = 0;
+    transaction.postTime = postTime;
+    transaction.originUid = uid;
+    return transaction;
+}
+
+} // namespace
+
+TEST(TransactionHandlerTest, FlushesPriorityLaneFirst) {
+    constexpr int kBackgroundUid = 10001;
+    constexpr int kForegroundUid = 10002;
+
+    TransactionHandler handler;
+    handler.setPriorityUids({kForegroundUid});
+    handler.queueTransaction(createTransaction(kBackgroundUid, 100));
+    handler.queueTransaction(createTransaction(kForegroundUid, 200));
+
+    auto earlyWakeup = createTransaction(kBackgroundUid, 300);
+    earlyWakeup.flags = ISurfaceComposer::eEarlyWakeupStart;
+    handler.queueTransaction(std::move(earlyWakeup));
+
+    const auto transactions = handler.flushTransactions();
+    ASSERT_EQ(3u, transactions.size());
+    EXPECT_EQ(200u, transactions[0].id);
+    EXPECT_EQ(300u, transactions[1].id);
+    EXPECT_EQ(100u, transactions[2].id);
+}
+
+TEST(TransactionHandlerTest, FlushesLaneInDeadlineOrder) {
+    TransactionHandler handler;
+    handler.queueTransaction(createTransaction(10001, 300));
+    handler.queueTransaction(createTransaction(10002, 100));
+
+    auto timed = createTransaction(10003, 400);
+    timed.isAutoTimestamp = false;
+    timed.desiredPresentTime = 200;
+    handler.queueTransaction(std::move(timed));
+
+    const auto transactions = handler.flushTransactions();
+    ASSERT_EQ(3u, transactions.size());
+    EXPECT_EQ(100u, transactions[0].id);
+    EXPECT_EQ(400u, transactions[1].id);
+    EXPECT_EQ(300u, transactions[2].id);
+}
+
+TEST(TransactionHandlerTest, CountsFramesWaitedPerClient) {
+    constexpr int kBlockedUid = 10001;
+    constexpr int kUid = 10002;
+
+    TransactionHandler handler;
+    handler.setPriorityUids({kUid});
+
+    int blockedFrames = 2;
+    handler.addTransactionReadyFilter([&](const TransactionHandler::TransactionFlushState& state) {
+        return state.transaction->originUid == kBlockedUid && blockedFrames > 0
+                ? TransactionHandler::TransactionReadiness::NotReady
+                : TransactionHandler::TransactionReadiness::Ready;
+    });
+
+    handler.queueTransaction(createTransaction(kBlockedUid, 100));
+    handler.queueTransaction(createTransaction(kUid, 200));
+    for (; blockedFrames >= 0; blockedFrames--) {
+        handler.flushTransactions();
+    }
+
+    const auto stats = handler.getClientWaitStats();
+    ASSERT_EQ(2u, stats.size());
+
+    const auto& blockedStats = stats.at(kBlockedUid);
+    EXPECT_EQ(TransactionHandler::Lane::Normal, blockedStats.lane);
+    EXPECT_EQ(1u, blockedStats.transactionCount);
+    EXPECT_EQ(2u, blockedStats.maxFramesWaited);
+
+    const auto& priorityStats = stats.at(kUid);
+    EXPECT_EQ(TransactionHandler::Lane::Priority, priorityStats.lane);
+    EXPECT_EQ(1u, priorityStats.transactionCount);
+    EXPECT_EQ(0u, priorityStats.maxFramesWaited);
+
+    handler.clearClientWaitStats();
+    EXPECT_TRUE(handler.getClientWaitStats().empty());
+}
+
+TEST(TransactionHandlerTest, BucketsTransactionParcelSizes) {
+    TransactionHandler handler;
+    handler.recordTransactionParcelSize(0);
+    handler.recordTransactionParcelSize(511);
+    handler.recordTransactionParcelSize(512);
+    handler.recordTransactionParcelSize(1500);
+    handler.recordTransactionParcelSize(1 << 20);
+
+    auto histogram = handler.getTransactionParcelSizeHistogram();
+    EXPECT_EQ(2u, histogram[0]);
+    EXPECT_EQ(1u, histogram[1]);
+    EXPECT_EQ(1u, histogram[2]);
+    EXPECT_EQ(1u, histogram.back());
+
+    handler.clearClientWaitStats();
+    histogram = handler.getTransactionParcelSizeHistogram();
+    for (size_t count : histogram) {
+        EXPECT_EQ(0u, count);
+    }
+}
+
 TEST(TransactionHandlerTest, TransactionsKeepTrackOfDirectMerges) {
     SurfaceComposerClient::Transaction transaction1, transaction2, transaction3, transaction4;
 
@@ -1222,3 +1333,58 @@ TEST(TransactionHandlerTest, CanAddTransactionWithFullMergedIds) {
 }
 
 } // namespace android
+
+namespace {
+
+TransactionState createBufferTransaction(const sp<IBinder>& surface, uint64_t frameNumber,
+                                         nsecs_t postTime) {
+    ResolvedComposerState state;
+    state.state.what = layer_state_t::eBufferChanged;
+    state.state.surface = surface;
+    state.state.bufferData =
+            std::make_shared<fake::BufferData>(/* bufferId */ frameNumber, /* width */ 1,
+                                               /* height */ 2, /* pixelFormat */ 0,
+                                               /* outUsage */ 0);
+    state.state.bufferData->frameNumber = frameNumber;
+    state.state.bufferData->flags = BufferData::BufferDataChange::frameNumberChanged;
+    state.externalTexture = std::make_shared<FakeExternalTexture>(*state.state.bufferData);
+
+    TransactionState transaction = createTransaction(10001, postTime);
+    transaction.states.push_back(std::move(state));
+    return transaction;
+}
+
+} // namespace
+
+TEST(TransactionHandlerTest, HoldsBackSecondBufferForLayerInAppendedFlush) {
+    TransactionHandler handler;
+    // Holds back buffers for layers that already have one to present, like SurfaceFlinger does
+    // for layers with backpressure.
+    handler.addTransactionReadyFilter([](const TransactionHandler::TransactionFlushState& state) {
+        auto ready = TransactionHandler::TransactionReadiness::Ready;
+        state.transaction->traverseStatesWithBuffers([&](const layer_state_t& layerState) {
+            if (state.bufferLayersReadyToPresent.contains(layerState.surface.get())) {
+                ready = TransactionHandler::TransactionReadiness::NotReady;
+            }
+        });
+        return ready;
+    });
+
+    const sp<IBinder> surface = sp<BBinder>::make();
+    handler.queueTransaction(createBufferTransaction(surface, 1, 100));
+    std::vector<TransactionState> transactions;
+    handler.flushTransactions(transactions);
+    ASSERT_EQ(1u, transactions.size());
+
+    // A second buffer for the layer that arrives before the frame is committed must not be
+    // appended to the same frame...
+    handler.queueTransaction(createBufferTransaction(surface, 2, 200));
+    handler.flushTransactions(transactions);
+    ASSERT_EQ(1u, transactions.size());
+    EXPECT_EQ(1u, transactions.front().states.front().state.bufferData->frameNumber);
+
+    // ...but is applied on the next one.
+    const auto nextTransactions = handler.flushTransactions();
+    ASSERT_EQ(1u, nextTransactions.size());
+    EXPECT_EQ(2u, nextTransactions.front().states.front().state.bufferData->frameNumber);
+}
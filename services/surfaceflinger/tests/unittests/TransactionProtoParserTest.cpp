@@ -19,6 +19,7 @@
 #include <limits> // std::numeric_limits
 
 #include <gui/SurfaceComposerClient.h>
+#include <renderengine/mock/FakeExternalTexture.h>
 #include <ui/Rotation.h>
 #include "LayerProtoHelper.h"
 
@@ -148,4 +149,40 @@ TEST(TransactionProtoParserTest, parseDisplayInfo) {
     EXPECT_EQ(d1.transformHint, d2.transformHint);
 }
 
+
+TEST(TransactionProtoParserTest, copyForProto) {
+    TransactionState t1;
+    t1.originPid = 1;
+    t1.originUid = 2;
+    t1.frameTimelineInfo.vsyncId = 3;
+    t1.postTime = 5;
+    t1.id = 6;
+    t1.mergedTransactionIds = {7, 8};
+
+    ResolvedComposerState s;
+    s.layerId = 9;
+    s.state.what = layer_state_t::eBufferChanged | layer_state_t::ePositionChanged;
+    s.state.x = 10;
+    s.state.surface = sp<BBinder>::make();
+    s.state.bufferData = std::make_shared<BufferData>();
+    s.state.bufferData->buffer = sp<GraphicBuffer>::make();
+    s.state.bufferData->frameNumber = 11;
+    s.state.bufferData->cachedBuffer.id = 12;
+    s.externalTexture =
+            std::make_shared<renderengine::mock::FakeExternalTexture>(1U /*width*/, 2U /*height*/,
+                                                                      13U /*id*/,
+                                                                      HAL_PIXEL_FORMAT_RGBA_8888,
+                                                                      0U /*usage*/);
+    t1.states.emplace_back(s);
+
+    TransactionProtoParser parser(std::make_unique<TransactionProtoParser::FlingerDataMapper>());
+    TransactionState t2 = TransactionProtoParser::copyForProto(t1);
+
+    ASSERT_EQ(t2.states.size(), 1u);
+    EXPECT_EQ(t2.states[0].state.surface, nullptr);
+    EXPECT_EQ(t2.states[0].state.bufferData->buffer, nullptr);
+    EXPECT_NE(t2.states[0].externalTexture, t1.states[0].externalTexture);
+    EXPECT_EQ(parser.toProto(t1).SerializeAsString(), parser.toProto(t2).SerializeAsString());
+}
+
 } // namespace android
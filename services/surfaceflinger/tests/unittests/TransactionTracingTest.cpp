@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -334,4 +335,86 @@ TEST(LayerTraceTest, canStreamLayersTrace) {
     // magic?
     EXPECT_EQ(outProto.entry().size(), 3);
 }
+
+// Verify the deltas kept in the buffer are written out as full entries.
+TEST(LayerTraceTest, writesDeltasAsFullEntries) {
+    LayerTracing tracing;
+    tracing.enable();
+
+    auto notify = [&](int64_t vsyncId, const std::vector<std::pair<int32_t, std::string>>& ids) {
+        LayersProto layers;
+        for (const auto& [id, name] : ids) {
+            LayerProto* layer = layers.add_layers();
+            layer->set_id(id);
+            layer->set_name(name);
+        }
+        google::protobuf::RepeatedPtrField<DisplayProto> displays;
+        tracing.notify(/* visibleRegionDirty */ true, vsyncId, vsyncId, &layers, "", &displays);
+    };
+    notify(1, {{1, "a"}, {2, "b"}});
+    notify(2, {{1, "a"}, {2, "c"}});
+    notify(3, {{2, "c"}, {3, "d"}});
+
+    TemporaryFile file;
+    ASSERT_EQ(tracing.writeToFile(file.path), NO_ERROR);
+    std::string output;
+    ASSERT_TRUE(base::ReadFileToString(file.path, &output));
+    LayersTraceFileProto proto;
+    ASSERT_TRUE(proto.ParseFromString(output));
+
+    ASSERT_EQ(proto.entry().size(), 3);
+    for (const LayersTraceProto& entry : proto.entry()) {
+        EXPECT_FALSE(entry.is_delta());
+        EXPECT_EQ(entry.layer_order().size(), 0);
+        ASSERT_EQ(entry.layers().layers().size(), 2);
+    }
+    EXPECT_EQ(proto.entry(1).layers().layers(0).name(), "a");
+    EXPECT_EQ(proto.entry(1).layers().layers(1).name(), "c");
+    EXPECT_EQ(proto.entry(2).layers().layers(0).id(), 2);
+    EXPECT_EQ(proto.entry(2).layers().layers(1).id(), 3);
+    EXPECT_EQ(proto.entry(2).layers().layers(1).name(), "d");
+    tracing.disable("", /* writeToFile */ false);
+}
+
+// Verify layers added, removed and moved by deltas are written out in the notified order.
+TEST(LayerTraceTest, writesDeltasInLayerOrder) {
+    LayerTracing tracing;
+    tracing.enable();
+
+    auto notify = [&](int64_t vsyncId, const std::vector<int32_t>& ids) {
+        LayersProto layers;
+        for (int32_t id : ids) {
+            layers.add_layers()->set_id(id);
+        }
+        google::protobuf::RepeatedPtrField<DisplayProto> displays;
+        tracing.notify(/* visibleRegionDirty */ true, vsyncId, vsyncId, &layers, "", &displays);
+    };
+    const std::vector<std::vector<int32_t>> expectedIds = {
+            {1, 2, 3},
+            {3, 1, 2},    // moved, unchanged layers
+            {3, 4, 1, 2}, // added in the middle
+            {4, 2},       // removed
+            {2, 4},       // swapped
+    };
+    for (size_t i = 0; i < expectedIds.size(); i++) {
+        notify(static_cast<int64_t>(i), expectedIds[i]);
+    }
+
+    TemporaryFile file;
+    ASSERT_EQ(tracing.writeToFile(file.path), NO_ERROR);
+    std::string output;
+    ASSERT_TRUE(base::ReadFileToString(file.path, &output));
+    LayersTraceFileProto proto;
+    ASSERT_TRUE(proto.ParseFromString(output));
+
+    ASSERT_EQ(static_cast<size_t>(proto.entry().size()), expectedIds.size());
+    for (size_t i = 0; i < expectedIds.size(); i++) {
+        std::vector<int32_t> ids;
+        for (const LayerProto& layer : proto.entry(static_cast<int>(i)).layers().layers()) {
+            ids.push_back(layer.id());
+        }
+        EXPECT_EQ(ids, expectedIds[i]) << "entry " << i;
+    }
+    tracing.disable("", /* writeToFile */ false);
+}
 } // namespace android
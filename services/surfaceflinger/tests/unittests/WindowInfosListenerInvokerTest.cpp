@@ -214,6 +214,100 @@ TEST_F(WindowInfosListenerInvokerTest, skipsDelayedMessage) {
     EXPECT_EQ(lastUpdateId, 3);
 }
 
+// Test that WindowInfosListenerInvoker#windowInfosChanged keeps sending messages to a listener that
+// acks them while another listener has yet to ack.
+TEST_F(WindowInfosListenerInvokerTest, slowListenerDoesNotDelayOthers) {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    int64_t fastLastUpdateId = -1;
+    int64_t slowLastUpdateId = -1;
+
+    gui::WindowInfosListenerInfo fastListenerInfo;
+    mInvoker->addWindowInfosListener(sp<Listener>::make([&](const gui::WindowInfosUpdate& update) {
+                                         std::scoped_lock lock{mutex};
+                                         fastLastUpdateId = update.vsyncId;
+                                         cv.notify_one();
+
+                                         fastListenerInfo.windowInfosPublisher
+                                                 ->ackWindowInfosReceived(update.vsyncId,
+                                                                          fastListenerInfo
+                                                                                  .listenerId);
+                                     }),
+                                     &fastListenerInfo);
+
+    // Simulate a slow ack by not calling IWindowInfosPublisher.ackWindowInfosReceived
+    gui::WindowInfosListenerInfo slowListenerInfo;
+    mInvoker->addWindowInfosListener(sp<Listener>::make([&](const gui::WindowInfosUpdate& update) {
+                                         std::scoped_lock lock{mutex};
+                                         slowLastUpdateId = update.vsyncId;
+                                         cv.notify_one();
+                                     }),
+                                     &slowListenerInfo);
+
+    for (int64_t vsyncId = 1; vsyncId <= 3; vsyncId++) {
+        BackgroundExecutor::getInstance().sendCallbacks({[&, vsyncId]() {
+            mInvoker->windowInfosChanged({{}, {}, vsyncId, 0}, {}, false);
+        }});
+
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return fastLastUpdateId == vsyncId; });
+    }
+    BackgroundExecutor::getInstance().flushQueue();
+
+    {
+        std::scoped_lock lock{mutex};
+        EXPECT_EQ(fastLastUpdateId, 3);
+        EXPECT_EQ(slowLastUpdateId, 1);
+    }
+
+    // Ack the first message. Only the latest update should be sent to the slow listener.
+    slowListenerInfo.windowInfosPublisher->ackWindowInfosReceived(1, slowListenerInfo.listenerId);
+
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return slowLastUpdateId == 3; });
+    }
+    EXPECT_EQ(slowLastUpdateId, 3);
+}
+
+// Test that the updates coalesced while a listener does not ack are tracked as one pending message.
+TEST_F(WindowInfosListenerInvokerTest, coalescesUnackedState) {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    int64_t lastUpdateId = -1;
+
+    // Simulate a listener that never acks by not calling
+    // IWindowInfosPublisher.ackWindowInfosReceived
+    gui::WindowInfosListenerInfo listenerInfo;
+    mInvoker->addWindowInfosListener(sp<Listener>::make([&](const gui::WindowInfosUpdate& update) {
+                                         std::scoped_lock lock{mutex};
+                                         lastUpdateId = update.vsyncId;
+                                         cv.notify_one();
+                                     }),
+                                     &listenerInfo);
+
+    BackgroundExecutor::getInstance().sendCallbacks({[&]() {
+        for (int64_t vsyncId = 1; vsyncId <= 10; vsyncId++) {
+            mInvoker->windowInfosChanged({{}, {}, vsyncId, 0}, {}, false);
+        }
+    }});
+
+    // The update that was sent, and the latest update that the others were coalesced into.
+    EXPECT_EQ(mInvoker->getDebugInfo().pendingMessageCount, 2u);
+
+    listenerInfo.windowInfosPublisher->ackWindowInfosReceived(1, listenerInfo.listenerId);
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return lastUpdateId == 10; });
+    }
+    EXPECT_EQ(mInvoker->getDebugInfo().pendingMessageCount, 1u);
+
+    listenerInfo.windowInfosPublisher->ackWindowInfosReceived(10, listenerInfo.listenerId);
+    EXPECT_EQ(mInvoker->getDebugInfo().pendingMessageCount, 0u);
+}
+
 // Test that WindowInfosListenerInvoker#windowInfosChanged immediately calls listener after a call
 // where no listeners were configured.
 TEST_F(WindowInfosListenerInvokerTest, noListeners) {
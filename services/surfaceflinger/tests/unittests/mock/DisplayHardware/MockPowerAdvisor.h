@@ -61,6 +61,7 @@ public:
     MOCK_METHOD(void, setCompositeEnd, (TimePoint compositeEndTime), (override));
     MOCK_METHOD(void, setDisplays, (std::vector<DisplayId> & displayIds), (override));
     MOCK_METHOD(void, setTotalFrameTargetWorkDuration, (Duration targetDuration), (override));
+    MOCK_METHOD(void, hintUpcomingFrameWork, (size_t pendingTransactionCount), (override));
 };
 
 } // namespace android::Hwc2::mock
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -64,31 +65,74 @@ void CallbackScheduler::schedule(std::function<void()> callback, std::chrono::mi
         if (mCallbackThread == nullptr) {
             mCallbackThread = std::make_unique<std::thread>(&CallbackScheduler::loop, this);
         }
-        mQueue.emplace(DelayedCallback(callback, delay));
+        DelayedCallback delayedCallback(callback, delay);
+        // Round up so the callback never runs before its expiration, and never into a past tick.
+        int64_t tick = std::chrono::ceil<std::chrono::milliseconds>(
+                               delayedCallback.getExpiration() - mStart)
+                               .count();
+        tick = std::max(tick, mCurrentTick + 1);
+        mWheel[tick % kWheelSize].push_back({tick, std::move(delayedCallback)});
+        mPendingCount++;
     }
     mCondition.notify_all();
 }
 
+void CallbackScheduler::collectExpiredLocked(std::vector<DelayedCallback>* expired) {
+    int64_t nowTick = std::chrono::floor<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - mStart)
+                              .count();
+    if (nowTick <= mCurrentTick) {
+        return;
+    }
+    // Visit each slot at most once, even if the thread fell behind by more than one turn.
+    int64_t firstTick = std::max(mCurrentTick + 1, nowTick - kWheelSize + 1);
+    for (int64_t tick = firstTick; tick <= nowTick && mPendingCount > 0; tick++) {
+        auto& slot = mWheel[tick % kWheelSize];
+        auto it = std::partition(slot.begin(), slot.end(),
+                                 [&](const WheelEntry& entry) { return entry.tick > nowTick; });
+        for (auto expiredIt = it; expiredIt != slot.end(); expiredIt++) {
+            expired->push_back(std::move(expiredIt->callback));
+        }
+        mPendingCount -= std::distance(it, slot.end());
+        slot.erase(it, slot.end());
+    }
+    mCurrentTick = nowTick;
+}
+
+DelayedCallback::Timestamp CallbackScheduler::getNextWakeupLocked() {
+    for (int64_t tick = mCurrentTick + 1; tick <= mCurrentTick + kWheelSize; tick++) {
+        if (!mWheel[tick % kWheelSize].empty()) {
+            return mStart + std::chrono::milliseconds(tick);
+        }
+    }
+    return mStart + std::chrono::milliseconds(mCurrentTick + kWheelSize);
+}
+
 void CallbackScheduler::loop() {
+    std::vector<DelayedCallback> expired;
     while (true) {
         std::unique_lock<std::mutex> lock(mMutex);
         if (mFinished) {
             // Destructor was called, so let the callback thread die.
             break;
         }
-        while (!mQueue.empty() && mQueue.top().isExpired()) {
-            DelayedCallback callback = mQueue.top();
-            mQueue.pop();
+        collectExpiredLocked(&expired);
+        if (!expired.empty()) {
             lock.unlock();
-            callback.run();
-            lock.lock();
+            // Callbacks sharing a tick, or collected after a late wakeup, run in expiration order.
+            std::stable_sort(expired.begin(), expired.end());
+            for (const auto& callback : expired) {
+                callback.run();
+            }
+            expired.clear();
+            continue;
         }
-        if (mQueue.empty()) {
+        if (mPendingCount == 0) {
             // Wait until a new callback is scheduled.
             mCondition.wait(mMutex);
         } else {
-            // Wait until next callback expires, or a new one is scheduled.
-            mCondition.wait_until(mMutex, mQueue.top().getExpiration());
+            // Wait until the next non-empty tick, or a new callback is scheduled.
+            mCondition.wait_until(mMutex, getNextWakeupLocked());
         }
     }
 }
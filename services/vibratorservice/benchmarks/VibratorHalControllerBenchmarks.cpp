@@ -17,8 +17,12 @@
 #define LOG_TAG "VibratorHalControllerBenchmarks"
 
 #include <benchmark/benchmark.h>
+#include <vibratorservice/VibratorCallbackScheduler.h>
 #include <vibratorservice/VibratorHalController.h>
 
+#include <condition_variable>
+#include <mutex>
+
 using ::android::enum_range;
 using ::android::hardware::vibrator::CompositeEffect;
 using ::android::hardware::vibrator::CompositePrimitive;
@@ -468,4 +472,83 @@ BENCHMARK_WRAPPER(VibratorPrimitivesBench, performComposedEffect, {
     }
 });
 
+class VibratorCallbackSchedulerBench : public Fixture {
+public:
+    void SetUp(State& /*state*/) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCallbackCount = 0;
+    }
+
+    static void DefaultConfig(Benchmark* b) { b->Unit(kMicrosecond); }
+
+    static void DefaultArgs(Benchmark* b) {
+        b->ArgNames({"DelayMs"});
+        b->Args({0});
+        b->Args({1});
+        b->Args({10});
+        b->Args({100});
+    }
+
+protected:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int32_t mCallbackCount = 0;
+
+    auto getDelay(const State& state) const { return std::chrono::milliseconds(state.range(0)); }
+
+    std::function<void()> createCallback() {
+        return [this]() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mCallbackCount++;
+            }
+            mCondition.notify_all();
+        };
+    }
+
+    void waitForCallbacks(int32_t count) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [&]() { return mCallbackCount >= count; });
+    }
+};
+
+// Measures the time from scheduling a callback until it runs, reporting how late it ran.
+BENCHMARK_WRAPPER(VibratorCallbackSchedulerBench, scheduleLatency, {
+    vibrator::CallbackScheduler scheduler;
+    auto delay = getDelay(state);
+    double lateUs = 0;
+    int32_t count = 0;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        scheduler.schedule(createCallback(), delay);
+        waitForCallbacks(++count);
+        lateUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                            start - delay)
+                          .count();
+    }
+
+    state.counters["LateUs"] = Counter(lateUs, Counter::kAvgIterations);
+});
+
+// Measures the cost of scheduling many pending callbacks with spread delays.
+BENCHMARK_WRAPPER(VibratorCallbackSchedulerBench, scheduleMany, {
+    constexpr int32_t kCallbackCount = 1000;
+    vibrator::CallbackScheduler scheduler;
+    auto delay = getDelay(state);
+    int32_t count = 0;
+
+    for (auto _ : state) {
+        for (int32_t i = 0; i < kCallbackCount; i++) {
+            scheduler.schedule(createCallback(), delay + std::chrono::milliseconds(i % 50));
+        }
+        state.PauseTiming();
+        count += kCallbackCount;
+        waitForCallbacks(count);
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kCallbackCount);
+});
+
 BENCHMARK_MAIN();
\ No newline at end of file
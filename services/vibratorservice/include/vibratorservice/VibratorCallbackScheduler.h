@@ -18,10 +18,12 @@
 #define ANDROID_VIBRATOR_CALLBACK_SCHEDULER_H
 
 #include <android-base/thread_annotations.h>
+#include <array>
 #include <chrono>
 #include <condition_variable>
-#include <queue>
+#include <functional>
 #include <thread>
+#include <vector>
 
 namespace android {
 
@@ -50,14 +52,30 @@ private:
 };
 
 // Schedules callbacks to be executed after a delay.
+//
+// Callbacks are kept in a hashed timer wheel with one slot per millisecond tick, so scheduling is
+// constant time regardless of how many callbacks are pending. Callbacks due more than one turn of
+// the wheel ahead share a slot with earlier ones, and stay there until their own tick is reached.
 class CallbackScheduler {
 public:
-    CallbackScheduler() : mCallbackThread(nullptr), mFinished(false) {}
+    CallbackScheduler()
+          : mCallbackThread(nullptr),
+            mFinished(false),
+            mStart(std::chrono::steady_clock::now()),
+            mCurrentTick(0),
+            mPendingCount(0) {}
     virtual ~CallbackScheduler();
 
     virtual void schedule(std::function<void()> callback, std::chrono::milliseconds delay);
 
 private:
+    static constexpr int64_t kWheelSize = 64;
+
+    struct WheelEntry {
+        int64_t tick;
+        DelayedCallback callback;
+    };
+
     std::condition_variable_any mCondition;
     std::mutex mMutex;
 
@@ -67,12 +85,22 @@ private:
     // Used to quit the callback thread when this instance is being destroyed.
     bool mFinished GUARDED_BY(mMutex);
 
-    // Priority queue with reverse comparator, so tasks that expire first will be on top.
-    std::priority_queue<DelayedCallback, std::vector<DelayedCallback>,
-                        std::greater<DelayedCallback>>
-            mQueue GUARDED_BY(mMutex);
+    // Time of tick zero.
+    const DelayedCallback::Timestamp mStart;
+
+    // Last tick processed by the callback thread.
+    int64_t mCurrentTick GUARDED_BY(mMutex);
+
+    size_t mPendingCount GUARDED_BY(mMutex);
+    std::array<std::vector<WheelEntry>, kWheelSize> mWheel GUARDED_BY(mMutex);
 
     void loop();
+
+    // Moves callbacks up to the current tick out of the wheel, and advances the current tick.
+    void collectExpiredLocked(std::vector<DelayedCallback>* expired) REQUIRES(mMutex);
+
+    // Returns the time of the next tick with a non-empty slot. Must only be called when pending.
+    DelayedCallback::Timestamp getNextWakeupLocked() REQUIRES(mMutex);
 };
 
 }; // namespace vibrator
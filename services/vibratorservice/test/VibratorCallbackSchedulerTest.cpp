@@ -114,6 +114,20 @@ TEST_F(VibratorCallbackSchedulerTest, TestScheduleInParallelRunsInDelayOrder) {
     ASSERT_THAT(getExpiredCallbacks(), ElementsAre(0, 1, 2, 3, 4));
 }
 
+TEST_F(VibratorCallbackSchedulerTest, TestScheduleBeyondOneWheelTurnRunsOnlyAfterDelay) {
+    // Delays that map to the same slot of the timer wheel.
+    mScheduler->schedule(createCallback(1), 134ms);
+    mScheduler->schedule(createCallback(2), 70ms);
+    mScheduler->schedule(createCallback(3), 6ms);
+
+    ASSERT_TRUE(waitForCallbacks(1, 20ms));
+    ASSERT_THAT(getExpiredCallbacks(), ElementsAre(3));
+
+    ASSERT_FALSE(waitForCallbacks(2, 40ms));
+    ASSERT_TRUE(waitForCallbacks(3, 100ms));
+    ASSERT_THAT(getExpiredCallbacks(), ElementsAre(3, 2, 1));
+}
+
 TEST_F(VibratorCallbackSchedulerTest, TestDestructorDropsPendingCallbacksAndKillsThread) {
     mScheduler->schedule(createCallback(1), 5ms);
     mScheduler.reset(nullptr);
@@ -671,6 +671,45 @@ TEST_F(VibratorHalWrapperAidlTest, TestPerformComposedCachesPrimitiveDurationsAn
     ASSERT_EQ(3, *callbackCounter.get());
 }
 
+TEST_F(VibratorHalWrapperAidlTest, TestPerformComposedEffectComputesDurationPerComposition) {
+    std::vector<CompositePrimitive> supportedPrimitives = {CompositePrimitive::CLICK};
+    std::vector<CompositeEffect> shortEffects, longEffects;
+    shortEffects.push_back(
+            vibrator::TestFactory::createCompositeEffect(CompositePrimitive::CLICK, 10ms, 0.5f));
+    longEffects.push_back(
+            vibrator::TestFactory::createCompositeEffect(CompositePrimitive::CLICK, 20ms, 0.5f));
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockHal.get(), getSupportedPrimitives(_))
+                .Times(Exactly(1))
+                .WillRepeatedly(DoAll(SetArgPointee<0>(supportedPrimitives), Return(Status())));
+        EXPECT_CALL(*mMockHal.get(), getPrimitiveDuration(Eq(CompositePrimitive::CLICK), _))
+                .Times(Exactly(1))
+                .WillRepeatedly(DoAll(SetArgPointee<1>(5), Return(Status())));
+    }
+    EXPECT_CALL(*mMockHal.get(), compose(Eq(shortEffects), _))
+            .Times(Exactly(2))
+            .WillRepeatedly(DoAll(TriggerCallbackInArg1(), Return(Status())));
+    EXPECT_CALL(*mMockHal.get(), compose(Eq(longEffects), _))
+            .Times(Exactly(2))
+            .WillRepeatedly(DoAll(TriggerCallbackInArg1(), Return(Status())));
+
+    std::unique_ptr<int32_t> callbackCounter = std::make_unique<int32_t>();
+    auto callback = vibrator::TestFactory::createCountingCallback(callbackCounter.get());
+
+    for (int i = 0; i < 2; i++) {
+        auto result = mWrapper->performComposedEffect(shortEffects, callback);
+        ASSERT_TRUE(result.isOk());
+        ASSERT_EQ(15ms, result.value());
+
+        result = mWrapper->performComposedEffect(longEffects, callback);
+        ASSERT_TRUE(result.isOk());
+        ASSERT_EQ(25ms, result.value());
+    }
+    ASSERT_EQ(4, *callbackCounter.get());
+}
+
 TEST_F(VibratorHalWrapperAidlTest, TestPerformPwleEffect) {
     std::vector<PrimitivePwle> emptyPrimitives, multiplePrimitives;
     multiplePrimitives.push_back(vibrator::TestFactory::createActivePwle(0, 1, 0, 1, 10ms));
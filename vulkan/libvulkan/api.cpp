@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <new>
 #include <string>
@@ -1477,5 +1478,105 @@ VkResult EnumerateInstanceVersion(uint32_t* pApiVersion) {
     return VK_SUCCESS;
 }
 
+namespace {
+
+const VkPipelineCreationFeedbackCreateInfo* FindPipelineCreationFeedback(
+    const void* next) {
+    for (auto* base = static_cast<const VkBaseInStructure*>(next); base;
+         base = base->pNext) {
+        if (base->sType ==
+            VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO) {
+            return reinterpret_cast<const VkPipelineCreationFeedbackCreateInfo*>(
+                base);
+        }
+    }
+    return nullptr;
+}
+
+// Reports pipeline creation to GpuStats. Whether a pipeline was found in its
+// pipeline cache is only known when the app asked for creation feedback.
+template <typename CreateInfo>
+void ReportPipelineCreation(const CreateInfo* create_infos,
+                            uint32_t create_info_count,
+                            std::chrono::steady_clock::time_point start) {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    for (uint32_t i = 0; i < create_info_count; i++) {
+        const VkPipelineCreationFeedbackCreateInfo* feedback =
+            FindPipelineCreationFeedback(create_infos[i].pNext);
+        if (!feedback || !feedback->pPipelineCreationFeedback ||
+            !(feedback->pPipelineCreationFeedback->flags &
+              VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+            continue;
+        }
+        if (feedback->pPipelineCreationFeedback->flags &
+            VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) {
+            hits++;
+        } else {
+            misses++;
+        }
+    }
+
+    android::GraphicsEnv& graphics_env = android::GraphicsEnv::getInstance();
+    graphics_env.addShaderCacheStats(
+        android::GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_HITS, hits);
+    graphics_env.addShaderCacheStats(
+        android::GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_MISSES, misses);
+    graphics_env.addShaderCacheStats(
+        android::GpuStatsInfo::Stats::VULKAN_PIPELINE_COMPILE_TIME,
+        static_cast<uint64_t>(duration.count()));
+}
+
+}  // anonymous namespace
+
+VkResult CreatePipelineCache(VkDevice device,
+                             const VkPipelineCacheCreateInfo* pCreateInfo,
+                             const VkAllocationCallbacks* pAllocator,
+                             VkPipelineCache* pPipelineCache) {
+    VkResult result = GetData(device).dispatch.CreatePipelineCache(
+        device, pCreateInfo, pAllocator, pPipelineCache);
+    if (result == VK_SUCCESS) {
+        android::GraphicsEnv::getInstance().addShaderCacheStats(
+            android::GpuStatsInfo::Stats::VULKAN_PIPELINE_CACHE_LOADED_BYTES,
+            pCreateInfo->initialDataSize);
+    }
+    return result;
+}
+
+VkResult CreateGraphicsPipelines(
+    VkDevice device,
+    VkPipelineCache pipelineCache,
+    uint32_t createInfoCount,
+    const VkGraphicsPipelineCreateInfo* pCreateInfos,
+    const VkAllocationCallbacks* pAllocator,
+    VkPipeline* pPipelines) {
+    ATRACE_CALL();
+
+    const auto start = std::chrono::steady_clock::now();
+    VkResult result = GetData(device).dispatch.CreateGraphicsPipelines(
+        device, pipelineCache, createInfoCount, pCreateInfos, pAllocator,
+        pPipelines);
+    ReportPipelineCreation(pCreateInfos, createInfoCount, start);
+    return result;
+}
+
+VkResult CreateComputePipelines(VkDevice device,
+                                VkPipelineCache pipelineCache,
+                                uint32_t createInfoCount,
+                                const VkComputePipelineCreateInfo* pCreateInfos,
+                                const VkAllocationCallbacks* pAllocator,
+                                VkPipeline* pPipelines) {
+    ATRACE_CALL();
+
+    const auto start = std::chrono::steady_clock::now();
+    VkResult result = GetData(device).dispatch.CreateComputePipelines(
+        device, pipelineCache, createInfoCount, pCreateInfos, pAllocator,
+        pPipelines);
+    ReportPipelineCreation(pCreateInfos, createInfoCount, start);
+    return result;
+}
+
 }  // namespace api
 }  // namespace vulkan
@@ -52,6 +52,25 @@ EnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice,
                                    uint32_t* pPropertyCount,
                                    VkExtensionProperties* pProperties);
 VKAPI_ATTR VkResult EnumerateInstanceVersion(uint32_t* pApiVersion);
+VKAPI_ATTR VkResult
+CreatePipelineCache(VkDevice device,
+                    const VkPipelineCacheCreateInfo* pCreateInfo,
+                    const VkAllocationCallbacks* pAllocator,
+                    VkPipelineCache* pPipelineCache);
+VKAPI_ATTR VkResult
+CreateGraphicsPipelines(VkDevice device,
+                        VkPipelineCache pipelineCache,
+                        uint32_t createInfoCount,
+                        const VkGraphicsPipelineCreateInfo* pCreateInfos,
+                        const VkAllocationCallbacks* pAllocator,
+                        VkPipeline* pPipelines);
+VKAPI_ATTR VkResult
+CreateComputePipelines(VkDevice device,
+                       VkPipelineCache pipelineCache,
+                       uint32_t createInfoCount,
+                       const VkComputePipelineCreateInfo* pCreateInfos,
+                       const VkAllocationCallbacks* pAllocator,
+                       VkPipeline* pPipelines);
 
 inline InstanceData& GetData(VkInstance instance) {
     return driver::GetData(instance).opaque_api_data;
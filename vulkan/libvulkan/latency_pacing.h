@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBVULKAN_LATENCY_PACING_H
+#define LIBVULKAN_LATENCY_PACING_H 1
+
+#include <utils/Timers.h>
+
+#include <algorithm>
+
+namespace vulkan {
+namespace driver {
+
+// Folds the render duration of another frame into the average. It averages
+// over a few frames, so that a single slow frame doesn't throw the pacing off.
+inline nsecs_t AverageLatencyPacingRenderDuration(nsecs_t average,
+                                                  nsecs_t render_duration) {
+    return average == 0 ? render_duration
+                        : (average * 3 + render_duration) / 4;
+}
+
+// Returns how long to wait at now before acquiring an image, so that a frame
+// taking render_duration is ready just before the next composite deadline it
+// can make. The deadlines are composite_interval apart. The delay is never
+// longer than max_delay, unless max_delay is negative.
+inline nsecs_t GetLatencyPacingDelay(nsecs_t now,
+                                     nsecs_t render_duration,
+                                     nsecs_t composite_deadline,
+                                     nsecs_t composite_interval,
+                                     nsecs_t max_delay) {
+    if (render_duration <= 0 || composite_interval <= 0 || max_delay == 0) {
+        return 0;
+    }
+    // Leave some slack for frames that take longer than average.
+    const nsecs_t ready_time =
+        now + render_duration + composite_interval / 8;
+    if (composite_deadline < ready_time) {
+        composite_deadline +=
+            (ready_time - composite_deadline + composite_interval - 1) /
+            composite_interval * composite_interval;
+    }
+    const nsecs_t delay = composite_deadline - ready_time;
+    if (delay <= 0 || delay >= composite_interval) {
+        return 0;
+    }
+    return max_delay > 0 ? std::min(delay, max_delay) : delay;
+}
+
+}  // namespace driver
+}  // namespace vulkan
+
+#endif  // LIBVULKAN_LATENCY_PACING_H
@@ -17,6 +17,7 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <android/hardware/graphics/common/1.0/types.h>
+#include <cutils/properties.h>
 #include <grallocusage/GrallocUsageConversion.h>
 #include <graphicsenv/GraphicsEnv.h>
 #include <hardware/gralloc.h>
@@ -32,10 +33,13 @@
 #include <utils/Trace.h>
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "driver.h"
+#include "latency_pacing.h"
 
 using android::hardware::graphics::common::V1_0::BufferUsage;
 
@@ -252,6 +256,21 @@ bool IsSharedPresentMode(VkPresentModeKHR mode) {
         mode == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR;
 }
 
+// Latency pacing delays vkAcquireNextImageKHR so that each frame starts as
+// late as it can while still finishing before a composite deadline, instead of
+// as soon as a buffer is free. Input sampled after acquire then reaches the
+// display sooner. It is opt-in, and only applies to FIFO swapchains, since
+// other modes don't hold frames back for the display.
+bool IsLatencyPacingEnabled(VkPresentModeKHR mode) {
+    if (mode != VK_PRESENT_MODE_FIFO_KHR &&
+        mode != VK_PRESENT_MODE_FIFO_RELAXED_KHR) {
+        return false;
+    }
+    return property_get_bool(
+        "debug.vulkan.swapchain.latency_pacing",
+        property_get_bool("ro.vulkan.swapchain.latency_pacing", false));
+}
+
 struct Swapchain {
     Swapchain(Surface& surface_,
               uint32_t num_images_,
@@ -265,7 +284,11 @@ struct Swapchain {
           frame_timestamps_enabled(false),
           refresh_duration(refresh_duration_),
           acquire_next_image_timeout(-1),
-          shared(IsSharedPresentMode(present_mode)) {
+          shared(IsSharedPresentMode(present_mode)),
+          latency_pacing(IsLatencyPacingEnabled(present_mode)),
+          pacing_render_duration(0),
+          recyclable(false),
+          dequeued_unknown_buffer(false) {
     }
 
     VkResult get_refresh_duration(uint64_t& outRefreshDuration)
@@ -291,13 +314,31 @@ struct Swapchain {
     int64_t refresh_duration;
     nsecs_t acquire_next_image_timeout;
     bool shared;
+    bool latency_pacing;
+    // Average time from acquiring an image until the GPU finished rendering
+    // to it, over recent frames. Only tracked with latency pacing.
+    nsecs_t pacing_render_duration;
+
+    // What the images were created with, to tell whether a swapchain
+    // replacing this one can take them over, see CanRecycleSwapchainImages.
+    bool recyclable;
+    VkSwapchainCreateFlagsKHR create_flags;
+    VkPresentModeKHR present_mode;
+    uint32_t min_image_count;
+    VkFormat image_format;
+    VkExtent2D image_extent;
+    VkImageUsageFlags image_usage;
+    // Set once the window returned a buffer that isn't one of the images,
+    // which means they no longer match the buffers of the window.
+    bool dequeued_unknown_buffer;
 
     struct Image {
         Image()
             : image(VK_NULL_HANDLE),
               dequeue_fence(-1),
               release_fence(-1),
-              dequeued(false) {}
+              dequeued(false),
+              acquire_time(0) {}
         VkImage image;
         // If the image is bound to memory, an sp to the underlying gralloc buffer.
         // Otherwise, nullptr; the image will be bound to memory as part of
@@ -313,9 +354,20 @@ struct Swapchain {
         // ensure it is closed upon re-presenting or releasing the image.
         int release_fence;
         bool dequeued;
+        // When the app last acquired the image. Only tracked with latency
+        // pacing.
+        nsecs_t acquire_time;
     } images[android::BufferQueueDefs::NUM_BUFFER_SLOTS];
 
     std::vector<TimingInfo> timing;
+
+    // Frames presented with latency pacing whose timestamps haven't been
+    // looked at yet.
+    struct PacingFrame {
+        uint64_t native_frame_id;
+        nsecs_t acquire_time;
+    };
+    std::vector<PacingFrame> pacing_frames;
 };
 
 VkSwapchainKHR HandleFromSwapchain(Swapchain* swapchain) {
@@ -398,17 +450,62 @@ void ReleaseSwapchainImage(VkDevice device,
     image.buffer.clear();
 }
 
-void OrphanSwapchain(VkDevice device, Swapchain* swapchain) {
+// Whether the swapchain created with create_info can take over the images of
+// old_swapchain, rather than reconnecting to the window and reallocating all
+// of its buffers. That needs everything the buffers and images are created
+// from to match. The transform, color space and composite alpha only apply
+// when queueing, so recreating for a rotation keeps the images. The image
+// count is derived from the present mode and minImageCount only. The new
+// swapchain must also be one that CreateSwapchainKHR marks recyclable.
+bool CanRecycleSwapchainImages(Swapchain& old_swapchain,
+                               const VkSwapchainCreateInfoKHR* create_info) {
+    if (!old_swapchain.recyclable || old_swapchain.dequeued_unknown_buffer ||
+        old_swapchain.surface.swapchain_handle !=
+            HandleFromSwapchain(&old_swapchain)) {
+        return false;
+    }
+    if (create_info->imageSharingMode != VK_SHARING_MODE_EXCLUSIVE) {
+        return false;
+    }
+    for (auto* info = reinterpret_cast<const VkBaseInStructure*>(
+             create_info->pNext);
+         info; info = info->pNext) {
+        if (info->sType == VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT) {
+            return false;
+        }
+    }
+    if (create_info->flags != old_swapchain.create_flags ||
+        create_info->presentMode != old_swapchain.present_mode ||
+        create_info->minImageCount != old_swapchain.min_image_count ||
+        create_info->imageFormat != old_swapchain.image_format ||
+        create_info->imageExtent.width != old_swapchain.image_extent.width ||
+        create_info->imageExtent.height != old_swapchain.image_extent.height ||
+        create_info->imageUsage != old_swapchain.image_usage) {
+        return false;
+    }
+    // The app may still hold images it acquired from the old swapchain, which
+    // would then be shared between both.
+    for (uint32_t i = 0; i < old_swapchain.num_images; i++) {
+        const Swapchain::Image& img = old_swapchain.images[i];
+        if (img.dequeued || !img.buffer) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OrphanSwapchain(VkDevice device, Swapchain* swapchain, bool keep_images) {
     if (swapchain->surface.swapchain_handle != HandleFromSwapchain(swapchain))
         return;
     for (uint32_t i = 0; i < swapchain->num_images; i++) {
-        if (!swapchain->images[i].dequeued) {
+        if (!keep_images && !swapchain->images[i].dequeued) {
             ReleaseSwapchainImage(device, swapchain->shared, nullptr, -1,
                                   swapchain->images[i], true);
         }
     }
     swapchain->surface.swapchain_handle = VK_NULL_HANDLE;
     swapchain->timing.clear();
+    swapchain->pacing_frames.clear();
 }
 
 uint32_t get_num_ready_timings(Swapchain& swapchain) {
@@ -1392,8 +1489,17 @@ VkResult CreateSwapchainKHR(VkDevice device,
               reinterpret_cast<uint64_t>(create_info->oldSwapchain));
         return VK_ERROR_NATIVE_WINDOW_IN_USE_KHR;
     }
-    if (create_info->oldSwapchain != VK_NULL_HANDLE)
-        OrphanSwapchain(device, SwapchainFromHandle(create_info->oldSwapchain));
+    // If the old swapchain's images fit, they move over to the new swapchain
+    // once it is allocated. Until then they stay with the old one, which
+    // destroys them if creating the new swapchain fails.
+    Swapchain* recycled_swapchain = nullptr;
+    if (create_info->oldSwapchain != VK_NULL_HANDLE) {
+        Swapchain* old_swapchain = SwapchainFromHandle(create_info->oldSwapchain);
+        if (CanRecycleSwapchainImages(*old_swapchain, create_info)) {
+            recycled_swapchain = old_swapchain;
+        }
+        OrphanSwapchain(device, old_swapchain, recycled_swapchain != nullptr);
+    }
 
     // -- Reset the native window --
     // The native window might have been used previously, and had its properties
@@ -1407,11 +1513,10 @@ VkResult CreateSwapchainKHR(VkDevice device,
     // orphans the previous buffers, getting us back to the state where we can
     // dequeue all buffers.
     //
-    // This is not necessary if the surface was never used previously.
-    //
-    // TODO(http://b/134186185) recycle swapchain images more efficiently
+    // This is not necessary if the surface was never used previously, or if
+    // the new swapchain keeps using the buffers of the old one.
     ANativeWindow* window = surface.window.get();
-    if (surface.used_by_swapchain) {
+    if (surface.used_by_swapchain && !recycled_swapchain) {
         err = native_window_api_disconnect(window, NATIVE_WINDOW_API_EGL);
         ALOGW_IF(err != android::OK,
                  "native_window_api_disconnect failed: %s (%d)", strerror(-err),
@@ -1668,6 +1773,18 @@ VkResult CreateSwapchainKHR(VkDevice device,
         Swapchain(surface, num_images, create_info->presentMode,
                   TranslateVulkanToNativeTransform(create_info->preTransform),
                   refresh_duration);
+    swapchain->recyclable =
+        !swapchain->shared &&
+        !(create_info->flags &
+          VK_SWAPCHAIN_CREATE_DEFERRED_MEMORY_ALLOCATION_BIT_EXT) &&
+        create_info->imageSharingMode == VK_SHARING_MODE_EXCLUSIVE &&
+        !usage_info_pNext;
+    swapchain->create_flags = create_info->flags;
+    swapchain->present_mode = create_info->presentMode;
+    swapchain->min_image_count = create_info->minImageCount;
+    swapchain->image_format = create_info->imageFormat;
+    swapchain->image_extent = create_info->imageExtent;
+    swapchain->image_usage = create_info->imageUsage;
     VkSwapchainImageCreateInfoANDROID swapchain_image_create = {
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wold-style-cast"
@@ -1705,10 +1822,35 @@ VkResult CreateSwapchainKHR(VkDevice device,
         .pQueueFamilyIndices = create_info->pQueueFamilyIndices,
     };
 
-    // Note: don't do deferred allocation for shared present modes. There's only one buffer
-    // involved so very little benefit.
-    if ((create_info->flags & VK_SWAPCHAIN_CREATE_DEFERRED_MEMORY_ALLOCATION_BIT_EXT) &&
+    if (recycled_swapchain && (!swapchain->recyclable ||
+                               recycled_swapchain->num_images != num_images)) {
+        // CanRecycleSwapchainImages should rule this out. The window wasn't
+        // reconnected and still holds the old buffers, so it can't be used
+        // for a swapchain anymore.
+        ALOGE("Can't recycle images of swapchain 0x%" PRIx64,
+              reinterpret_cast<uint64_t>(create_info->oldSwapchain));
+        result = VK_ERROR_SURFACE_LOST_KHR;
+    } else if (recycled_swapchain) {
+        // -- Take over the images of the old swapchain --
+        // They are all queued or free in the window, the same buffers that it
+        // hands out after this.
+        ATRACE_NAME("RecycleImages");
+        for (uint32_t i = 0; i < num_images; i++) {
+            Swapchain::Image& old_img = recycled_swapchain->images[i];
+            Swapchain::Image& img = swapchain->images[i];
+            img.image = old_img.image;
+            img.buffer = std::move(old_img.buffer);
+            img.release_fence = old_img.release_fence;
+            old_img.image = VK_NULL_HANDLE;
+            old_img.release_fence = -1;
+        }
+        // The window wasn't reconnected, so they are still enabled.
+        swapchain->frame_timestamps_enabled =
+            recycled_swapchain->frame_timestamps_enabled;
+    } else if ((create_info->flags & VK_SWAPCHAIN_CREATE_DEFERRED_MEMORY_ALLOCATION_BIT_EXT) &&
             !IsSharedPresentMode(create_info->presentMode)) {
+        // Note: don't do deferred allocation for shared present modes. There's only one buffer
+        // involved so very little benefit.
         // Don't want to touch the underlying gralloc buffers yet;
         // instead just create unbound VkImages which will later be bound to memory inside
         // AcquireNextImage.
@@ -1806,6 +1948,12 @@ VkResult CreateSwapchainKHR(VkDevice device,
     android::GraphicsEnv::getInstance().setTargetStats(
         android::GpuStatsInfo::Stats::CREATED_VULKAN_SWAPCHAIN);
 
+    if (swapchain->latency_pacing) {
+        // Latency pacing relies on frame timestamps and compositor timing.
+        native_window_enable_frame_timestamps(window, true);
+        swapchain->frame_timestamps_enabled = true;
+    }
+
     surface.used_by_swapchain = true;
     surface.swapchain_handle = HandleFromSwapchain(swapchain);
     *swapchain_handle = surface.swapchain_handle;
@@ -1849,6 +1997,93 @@ VkResult GetSwapchainImagesKHR(VkDevice,
     return result;
 }
 
+// Folds the timestamps SurfaceFlinger reported for recently presented frames
+// into the estimate of how long a frame takes from acquire until the GPU is
+// done with it, and traces how long it took from acquire until the frame was
+// on screen. Like get_num_ready_timings, it only asks about frames at least
+// MIN_NUM_FRAMES_AGO old, to avoid synchronous requests to SurfaceFlinger.
+static void UpdateLatencyPacing(Swapchain& swapchain) {
+    if (swapchain.pacing_frames.size() < MIN_NUM_FRAMES_AGO) {
+        return;
+    }
+    const size_t num_frames =
+        swapchain.pacing_frames.size() - MIN_NUM_FRAMES_AGO + 1;
+    size_t num_done = 0;
+    for (size_t i = 0; i < num_frames; i++) {
+        const Swapchain::PacingFrame& frame = swapchain.pacing_frames[i];
+        int64_t render_complete_time = 0;
+        int64_t actual_present_time = 0;
+        int err = native_window_get_frame_timestamps(
+            swapchain.surface.window.get(), frame.native_frame_id,
+            nullptr,  //&desired_present_time,
+            &render_complete_time,
+            nullptr,  //&composition_latch_time,
+            nullptr,  //&first_composition_start_time,
+            nullptr,  //&last_composition_start_time,
+            nullptr,  //&composition_finish_time,
+            &actual_present_time,
+            nullptr,  //&dequeue_ready_time,
+            nullptr /*&reads_done_time*/);
+        if (err == android::OK &&
+            (render_complete_time == NATIVE_WINDOW_TIMESTAMP_PENDING ||
+             actual_present_time == NATIVE_WINDOW_TIMESTAMP_PENDING)) {
+            break;
+        }
+        num_done = i + 1;
+        if (err != android::OK) {
+            continue;
+        }
+
+        if (render_complete_time > frame.acquire_time) {
+            // Average over a few frames, so that a single slow frame doesn't
+            // throw the pacing off.
+            swapchain.pacing_render_duration = AverageLatencyPacingRenderDuration(
+                swapchain.pacing_render_duration,
+                render_complete_time - frame.acquire_time);
+        }
+        if (actual_present_time > frame.acquire_time) {
+            ATRACE_INT64("vkAcquireToPresentLatency",
+                         actual_present_time - frame.acquire_time);
+            ALOGV("Frame %" PRIu64 " latency %" PRId64 "ns",
+                  frame.native_frame_id,
+                  actual_present_time - frame.acquire_time);
+        }
+    }
+    swapchain.pacing_frames.erase(swapchain.pacing_frames.begin(),
+                                  swapchain.pacing_frames.begin() + num_done);
+}
+
+// Sleeps until the latest time at which a frame, acquired then, is still
+// expected to be rendered before a composite deadline, but no longer than
+// timeout unless it is negative. Returns how long it slept.
+static nsecs_t WaitForLatencyPacing(Swapchain& swapchain, nsecs_t timeout) {
+    ATRACE_CALL();
+
+    UpdateLatencyPacing(swapchain);
+    if (swapchain.pacing_render_duration <= 0 || timeout == 0) {
+        return 0;
+    }
+
+    int64_t composite_deadline = 0;
+    int64_t composite_interval = 0;
+    int64_t composite_to_present_latency = 0;
+    int err = native_window_get_compositor_timing(
+        swapchain.surface.window.get(), &composite_deadline,
+        &composite_interval, &composite_to_present_latency);
+    if (err != android::OK) {
+        return 0;
+    }
+
+    const nsecs_t sleep_duration = GetLatencyPacingDelay(
+        systemTime(), swapchain.pacing_render_duration, composite_deadline,
+        composite_interval, timeout);
+    if (sleep_duration > 0) {
+        ATRACE_INT64("vkAcquirePacingDelay", sleep_duration);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_duration));
+    }
+    return sleep_duration;
+}
+
 VKAPI_ATTR
 VkResult AcquireNextImageKHR(VkDevice device,
                              VkSwapchainKHR swapchain_handle,
@@ -1876,8 +2111,17 @@ VkResult AcquireNextImageKHR(VkDevice device,
         return result;
     }
 
-    const nsecs_t acquire_next_image_timeout =
+    nsecs_t acquire_next_image_timeout =
         timeout > (uint64_t)std::numeric_limits<nsecs_t>::max() ? -1 : timeout;
+    if (swapchain.latency_pacing) {
+        // The pacing delay counts against the timeout, so dequeueBuffer gets
+        // what is left of it.
+        const nsecs_t delay =
+            WaitForLatencyPacing(swapchain, acquire_next_image_timeout);
+        if (acquire_next_image_timeout > 0) {
+            acquire_next_image_timeout -= delay;
+        }
+    }
     if (acquire_next_image_timeout != swapchain.acquire_next_image_timeout) {
         // Cache the timeout to avoid the duplicate binder cost.
         err = window->perform(window, NATIVE_WINDOW_SET_DEQUEUE_TIMEOUT,
@@ -1969,6 +2213,7 @@ VkResult AcquireNextImageKHR(VkDevice device,
     // happens, just declare the swapchain to be broken and the app will recreate it.
     if (idx == swapchain.num_images) {
         ALOGE("dequeueBuffer returned unrecognized buffer");
+        swapchain.dequeued_unknown_buffer = true;
         window->cancelBuffer(window, buffer, fence_fd);
         return VK_ERROR_OUT_OF_DATE_KHR;
     }
@@ -1999,6 +2244,9 @@ VkResult AcquireNextImageKHR(VkDevice device,
         return result;
     }
 
+    if (swapchain.latency_pacing) {
+        swapchain.images[idx].acquire_time = systemTime();
+    }
     *image_index = idx;
     return VK_SUCCESS;
 }
@@ -2170,6 +2418,18 @@ static VkResult PresentOneSwapchain(
             if (pTime) {
                 SetSwapchainFrameTimestamp(swapchain, pTime);
             }
+            if (swapchain.latency_pacing) {
+                uint64_t native_frame_id = 0;
+                if (native_window_get_next_frame_id(
+                        window, &native_frame_id) == android::OK) {
+                    swapchain.pacing_frames.push_back(
+                        {native_frame_id, img.acquire_time});
+                    if (swapchain.pacing_frames.size() > MAX_TIMING_INFOS) {
+                        swapchain.pacing_frames.erase(
+                            swapchain.pacing_frames.begin());
+                    }
+                }
+            }
             if (pPresentMode) {
                 if (!SetSwapchainPresentMode(window, *pPresentMode))
                     swapchain_result = WorstPresentResult(swapchain_result,
@@ -2213,7 +2473,7 @@ static VkResult PresentOneSwapchain(
             }
         }
         if (swapchain_result != VK_SUCCESS) {
-            OrphanSwapchain(device, &swapchain);
+            OrphanSwapchain(device, &swapchain, false);
         }
         // Android will only return VK_SUBOPTIMAL_KHR for vkQueuePresentKHR,
         // and only when the window's transform/rotation changes.  Extent
@@ -27,6 +27,9 @@ _INTERCEPTED_COMMANDS = [
     'vkDestroyInstance',
     'vkEnumerateDeviceExtensionProperties',
     'vkEnumerateDeviceLayerProperties',
+    'vkCreatePipelineCache',
+    'vkCreateGraphicsPipelines',
+    'vkCreateComputePipelines',
 ]
 
 
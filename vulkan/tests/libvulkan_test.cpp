@@ -0,0 +1,234 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/native_window.h>
+#include <gtest/gtest.h>
+#include <gui/BufferItemConsumer.h>
+#include <gui/BufferQueue.h>
+#include <gui/Surface.h>
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "latency_pacing.h"
+
+namespace vulkan {
+namespace driver {
+namespace {
+
+constexpr nsecs_t kInterval = ms2ns(16);
+
+TEST(LatencyPacingTest, AveragesRenderDuration) {
+    EXPECT_EQ(ms2ns(8), AverageLatencyPacingRenderDuration(0, ms2ns(8)));
+    EXPECT_EQ(ms2ns(9), AverageLatencyPacingRenderDuration(ms2ns(8), ms2ns(12)));
+}
+
+TEST(LatencyPacingTest, WaitsUntilFrameJustMakesDeadline) {
+    // The frame is ready 4ms + 2ms of slack after now, 10ms before the deadline.
+    EXPECT_EQ(ms2ns(10), GetLatencyPacingDelay(0, ms2ns(4), kInterval, kInterval, -1));
+}
+
+TEST(LatencyPacingTest, TargetsNextDeadlineWhenTooLate) {
+    // Ready at 14ms, past the deadline at 10ms, so aim for the one at 26ms.
+    EXPECT_EQ(ms2ns(12), GetLatencyPacingDelay(0, ms2ns(12), ms2ns(10), kInterval, -1));
+    // A deadline long gone is moved forward by whole intervals.
+    EXPECT_EQ(ms2ns(12),
+              GetLatencyPacingDelay(ms2ns(160), ms2ns(12), ms2ns(10), kInterval, -1));
+}
+
+TEST(LatencyPacingTest, HonorsTimeout) {
+    EXPECT_EQ(ms2ns(3), GetLatencyPacingDelay(0, ms2ns(4), kInterval, kInterval, ms2ns(3)));
+    EXPECT_EQ(0, GetLatencyPacingDelay(0, ms2ns(4), kInterval, kInterval, 0));
+}
+
+TEST(LatencyPacingTest, NoDelayWithoutEstimates) {
+    EXPECT_EQ(0, GetLatencyPacingDelay(0, 0, kInterval, kInterval, -1));
+    EXPECT_EQ(0, GetLatencyPacingDelay(0, ms2ns(4), kInterval, 0, -1));
+}
+
+// Creates swapchains on a window whose buffers go to a local consumer.
+class SwapchainTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const VkApplicationInfo app_info = {
+                .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+                .apiVersion = VK_API_VERSION_1_1,
+        };
+        const char* instance_extensions[] = {VK_KHR_SURFACE_EXTENSION_NAME,
+                                             VK_KHR_ANDROID_SURFACE_EXTENSION_NAME};
+        const VkInstanceCreateInfo instance_info = {
+                .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+                .pApplicationInfo = &app_info,
+                .enabledExtensionCount = std::size(instance_extensions),
+                .ppEnabledExtensionNames = instance_extensions,
+        };
+        if (vkCreateInstance(&instance_info, nullptr, &mInstance) != VK_SUCCESS) {
+            GTEST_SKIP() << "Vulkan is not supported";
+        }
+        uint32_t count = 1;
+        vkEnumeratePhysicalDevices(mInstance, &count, &mPhysicalDevice);
+        if (count == 0) {
+            GTEST_SKIP() << "No Vulkan device";
+        }
+
+        android::sp<android::IGraphicBufferProducer> producer;
+        android::sp<android::IGraphicBufferConsumer> consumer;
+        android::BufferQueue::createBufferQueue(&producer, &consumer);
+        mConsumer = android::sp<android::BufferItemConsumer>::make(consumer,
+                                                                   GRALLOC_USAGE_HW_TEXTURE);
+        mConsumer->setDefaultBufferSize(64, 64);
+        mWindow = android::sp<android::Surface>::make(producer);
+
+        const VkAndroidSurfaceCreateInfoKHR surface_info = {
+                .sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR,
+                .window = mWindow.get(),
+        };
+        ASSERT_EQ(VK_SUCCESS,
+                  vkCreateAndroidSurfaceKHR(mInstance, &surface_info, nullptr, &mSurface));
+
+        uint32_t family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(mPhysicalDevice, &family_count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(mPhysicalDevice, &family_count, families.data());
+        uint32_t family = 0;
+        while (family < family_count && !(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            family++;
+        }
+        ASSERT_LT(family, family_count);
+        mQueueFamilyCount = family_count;
+
+        const float priority = 1.0f;
+        const VkDeviceQueueCreateInfo queue_info = {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = family,
+                .queueCount = 1,
+                .pQueuePriorities = &priority,
+        };
+        const char* device_extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        const VkDeviceCreateInfo device_info = {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .queueCreateInfoCount = 1,
+                .pQueueCreateInfos = &queue_info,
+                .enabledExtensionCount = std::size(device_extensions),
+                .ppEnabledExtensionNames = device_extensions,
+        };
+        ASSERT_EQ(VK_SUCCESS, vkCreateDevice(mPhysicalDevice, &device_info, nullptr, &mDevice));
+
+        VkSurfaceCapabilitiesKHR capabilities;
+        ASSERT_EQ(VK_SUCCESS,
+                  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface,
+                                                            &capabilities));
+        mSwapchainInfo = {
+                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                .surface = mSurface,
+                .minImageCount = capabilities.minImageCount,
+                .imageFormat = VK_FORMAT_R8G8B8A8_UNORM,
+                .imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,
+                .imageExtent = {64, 64},
+                .imageArrayLayers = 1,
+                .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .preTransform = capabilities.currentTransform,
+                .compositeAlpha = VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+                .presentMode = VK_PRESENT_MODE_FIFO_KHR,
+                .clipped = VK_FALSE,
+        };
+    }
+
+    void TearDown() override {
+        for (VkSwapchainKHR swapchain : mSwapchains) {
+            vkDestroySwapchainKHR(mDevice, swapchain, nullptr);
+        }
+        if (mDevice != VK_NULL_HANDLE) vkDestroyDevice(mDevice, nullptr);
+        if (mSurface != VK_NULL_HANDLE) vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+        if (mInstance != VK_NULL_HANDLE) vkDestroyInstance(mInstance, nullptr);
+    }
+
+    VkResult createSwapchain(VkSwapchainKHR old_swapchain, VkSwapchainKHR* swapchain) {
+        VkSwapchainCreateInfoKHR info = mSwapchainInfo;
+        info.oldSwapchain = old_swapchain;
+        const VkResult result = vkCreateSwapchainKHR(mDevice, &info, nullptr, swapchain);
+        if (result == VK_SUCCESS) mSwapchains.push_back(*swapchain);
+        return result;
+    }
+
+    std::vector<VkImage> getImages(VkSwapchainKHR swapchain) {
+        uint32_t count = 0;
+        vkGetSwapchainImagesKHR(mDevice, swapchain, &count, nullptr);
+        std::vector<VkImage> images(count);
+        vkGetSwapchainImagesKHR(mDevice, swapchain, &count, images.data());
+        return images;
+    }
+
+    VkInstance mInstance = VK_NULL_HANDLE;
+    VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+    VkSurfaceKHR mSurface = VK_NULL_HANDLE;
+    VkDevice mDevice = VK_NULL_HANDLE;
+    uint32_t mQueueFamilyCount = 0;
+    VkSwapchainCreateInfoKHR mSwapchainInfo = {};
+    std::vector<VkSwapchainKHR> mSwapchains;
+    android::sp<android::BufferItemConsumer> mConsumer;
+    android::sp<android::Surface> mWindow;
+};
+
+TEST_F(SwapchainTest, RecreateTakesOverImages) {
+    VkSwapchainKHR old_swapchain;
+    ASSERT_EQ(VK_SUCCESS, createSwapchain(VK_NULL_HANDLE, &old_swapchain));
+    const std::vector<VkImage> old_images = getImages(old_swapchain);
+
+    VkSwapchainKHR swapchain;
+    ASSERT_EQ(VK_SUCCESS, createSwapchain(old_swapchain, &swapchain));
+    EXPECT_EQ(old_images, getImages(swapchain));
+}
+
+TEST_F(SwapchainTest, RecreateWhileImageAcquired) {
+    VkSwapchainKHR old_swapchain;
+    ASSERT_EQ(VK_SUCCESS, createSwapchain(VK_NULL_HANDLE, &old_swapchain));
+    const VkFenceCreateInfo fence_info = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    VkFence fence;
+    ASSERT_EQ(VK_SUCCESS, vkCreateFence(mDevice, &fence_info, nullptr, &fence));
+    uint32_t index;
+    EXPECT_EQ(VK_SUCCESS,
+              vkAcquireNextImageKHR(mDevice, old_swapchain, UINT64_MAX, VK_NULL_HANDLE, fence,
+                                    &index));
+    vkWaitForFences(mDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+    vkDestroyFence(mDevice, fence, nullptr);
+
+    // The app still holds an image of the old swapchain, so the new one gets its own images.
+    VkSwapchainKHR swapchain;
+    ASSERT_EQ(VK_SUCCESS, createSwapchain(old_swapchain, &swapchain));
+    EXPECT_FALSE(getImages(swapchain).empty());
+}
+
+TEST_F(SwapchainTest, RecreateWithOtherSharingMode) {
+    if (mQueueFamilyCount < 2) {
+        GTEST_SKIP() << "Concurrent sharing needs two queue families";
+    }
+    VkSwapchainKHR old_swapchain;
+    ASSERT_EQ(VK_SUCCESS, createSwapchain(VK_NULL_HANDLE, &old_swapchain));
+
+    // Images can't be taken over for a concurrent swapchain, but it can still be created.
+    const uint32_t families[] = {0, 1};
+    mSwapchainInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+    mSwapchainInfo.queueFamilyIndexCount = std::size(families);
+    mSwapchainInfo.pQueueFamilyIndices = families;
+    VkSwapchainKHR swapchain;
+    EXPECT_EQ(VK_SUCCESS, createSwapchain(old_swapchain, &swapchain));
+}
+
+} // namespace
+} // namespace driver
+} // namespace vulkan